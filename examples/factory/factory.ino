@@ -18,6 +18,9 @@
 #include <Fonts/FreeMonoBold9pt7b.h>
 #include "factory.h"
 #include "peripheral.h"
+#include "audio_service.h"
+#include "audio_prompt.h"
+#include "sd_manager.h"
 
 TinyGsm modem(SerialAT);
 TaskHandle_t a7682_handle;
@@ -248,21 +251,27 @@ static bool bq27220_init(void)
     return ret;
 }
 
+static void sd_card_attach(void)
+{
+    peri_init_st[E_PERI_SD] = true;
+}
+
+static void sd_card_detach(void)
+{
+    peri_init_st[E_PERI_SD] = false;
+}
+
 static bool sd_care_init(void)
 {
-    if(!SD.begin(BOARD_SD_CS)){
+    // Mounts at the fastest clock the card holds and follows it in and out of the slot
+    sd_manager_add_client("factory", sd_card_attach, sd_card_detach);
+    if(!sd_manager_begin()){
         Serial.println("[SD CARD] Card Mount Failed");
         return false;
     }
 
     uint64_t cardSize = SD.cardSize() / (1024 * 1024);
     Serial.printf("SD Card Size: %lluMB\n", cardSize);
-
-    uint64_t totalSize = SD.totalBytes() / (1024 * 1024);
-    Serial.printf("SD Card Total: %lluMB\n", totalSize);
-
-    uint64_t usedSize = SD.usedBytes() / (1024 * 1024);
-    Serial.printf("SD Card Used: %lluMB\n", usedSize);
     return true;
 }
 
@@ -326,19 +335,16 @@ static bool A7682E_init(void)
 
 static bool pcm5102a_init(void)
 {
-    bool ret = audio.setPinout(BOARD_I2S_BCLK, BOARD_I2S_LRC, BOARD_I2S_DOUT);
+    // Decodes on its own task; loop() no longer pumps audio.loop()
+    bool ret = audio_service_begin();
 
     if (ret == false) 
         Serial.printf("[%d] Execution error\n", __LINE__);
 
-    audio.setVolume(21); // 0...21
+    // audio_service_play(SD, "/voice_time/BBIBBI.mp3");
+    if (ret) audio_prompt_begin();
 
-    pinMode(BOARD_6609_EN, OUTPUT);
-    digitalWrite(BOARD_6609_EN, HIGH);
-
-    // audio_paly_flag = audio.connecttoFS(SD, "/voice_time/BBIBBI.mp3");
-
-    return true;
+    return ret;
 }
 
 static void listDir(fs::FS &fs, const char * dirname, uint8_t levels){
@@ -471,12 +477,6 @@ void loop()
 {
     lv_task_handler();
     keypad_loop();
-
-    if(peri_init_st[E_PERI_PCM5102A] == true) 
-    {
-        audio.loop();
-    }
-    
     delay(1);
 }
 
@@ -7,7 +7,7 @@
 
 static SX1262 radio = new Module(BOARD_LORA_CS, BOARD_LORA_INT, BOARD_LORA_RST, BOARD_LORA_BUSY);
 static int lora_mode = LORA_MODE_SEND;
-static String lora_recv_data;
+static char lora_recv_data[RADIOLIB_SX126X_MAX_PACKET_LENGTH + 1];   // Reused for every packet
 static bool lora_recv_success = false;
 static int lora_recv_rssi = 0;
 
@@ -15,7 +15,7 @@ static int lora_recv_rssi = 0;
 static int transmissionState = RADIOLIB_ERR_NONE;
 static volatile bool transmittedFlag = false;
 
-static void set_transmit_flag(void){
+static void IRAM_ATTR set_transmit_flag(void){
     transmittedFlag = true;
 }
 
@@ -23,7 +23,7 @@ static void set_transmit_flag(void){
 static int receivedState = RADIOLIB_ERR_NONE;
 static volatile bool receivedFlag = false;
 
-static void set_receive_flag(void){
+static void IRAM_ATTR set_receive_flag(void){
     receivedFlag = true;
 }
 
@@ -154,14 +154,16 @@ void lora_receive_loop(void)
 
         lora_recv_success = true;
 
-        // String str;
-        receivedState = radio.readData(lora_recv_data);
+        size_t len = radio.getPacketLength();
+        if(len > RADIOLIB_SX126X_MAX_PACKET_LENGTH)
+            len = RADIOLIB_SX126X_MAX_PACKET_LENGTH;
+        receivedState = radio.readData((uint8_t *)lora_recv_data, len);
+        lora_recv_data[(receivedState == RADIOLIB_ERR_NONE) ? len : 0] = '\0';
         if(receivedState == RADIOLIB_ERR_NONE){
             Serial.println(F("[SX1262] Received packet!"));
 
             Serial.print(F("[SX1262] Data:\t\t"));
-            Serial.println(lora_recv_data.c_str());
-            // Serial.println("%d", (int)lora_recv_data.toInt());
+            Serial.println(lora_recv_data);
 
             Serial.print(F("[SX1262] RSSI:\t\t"));
             Serial.print(radio.getRSSI());
@@ -193,7 +195,7 @@ void lora_transmit(const char *str)
 
 bool lora_get_recv(const char **str, int *rssi)
 {
-    *str = lora_recv_data.c_str();
+    *str = lora_recv_data;
     *rssi = lora_recv_rssi;
     return lora_recv_success;
 }
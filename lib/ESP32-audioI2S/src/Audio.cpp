@@ -2865,8 +2865,19 @@ void Audio::processLocalFile() {
            }
     }
     //----------------------------------------------------------------------------------------------------
-
-    bytesAddedToBuffer = audiofile.read(InBuff.getWritePtr(), bytesCanBeWritten);
+    // read-ahead: wait until a whole chunk fits, unless the space runs up to the buffer end (the rest is
+    // past the wrap) or the file ends within it
+    if(m_readAheadSize && bytesCanBeWritten) {
+        uint32_t pos  = audiofile.position();
+        uint32_t want = m_readAheadSize - ((pos + m_readAheadSize) % AUDIO_SECTOR_SIZE);
+        bool tail = InBuff.freeSpace() > bytesCanBeWritten;
+        bool last = audiofile.available() <= (int)bytesCanBeWritten ||
+                    (m_contentlength > 0 && pos + bytesCanBeWritten >= m_contentlength);
+        if(bytesCanBeWritten >= want)  bytesCanBeWritten = want;
+        else if(!tail && !last)        bytesCanBeWritten = 0;
+    }
+
+    bytesAddedToBuffer = bytesCanBeWritten ? readLocalFile(InBuff.getWritePtr(), bytesCanBeWritten) : 0;
     if(bytesAddedToBuffer > 0) {
         InBuff.bytesWritten(bytesAddedToBuffer);
     }
@@ -3728,11 +3739,17 @@ int Audio::sendBytes(uint8_t* data, size_t len) {
         if(getBitsPerSample() == 8 ) m_validSamples = len / 2;
         bytesLeft = 0;
     }
+    uint32_t ccount = ESP.getCycleCount();
     if(m_codec == CODEC_MP3)      ret = MP3Decode(data, &bytesLeft, m_outBuff, 0);
     if(m_codec == CODEC_AAC)      ret = AACDecode(data, &bytesLeft, m_outBuff);
     if(m_codec == CODEC_M4A)      ret = AACDecode(data, &bytesLeft, m_outBuff);
     if(m_codec == CODEC_FLAC)     ret = FLACDecode(data, &bytesLeft, m_outBuff);
     if(m_codec == CODEC_OGG_FLAC) ret = FLACDecode(data, &bytesLeft, m_outBuff); // FLAC webstream wrapped in OGG
+    ccount = ESP.getCycleCount() - ccount;
+    if(m_codec != CODEC_WAV) {
+        m_decodeStats.cycles += ccount;
+        if(ccount > m_decodeStats.maxCycles) m_decodeStats.maxCycles = ccount;
+    }
 
     bytesDecoded = len - bytesLeft;
     if(bytesDecoded == 0 && ret == 0){ // unlikely framesize
@@ -3789,6 +3806,12 @@ int Audio::sendBytes(uint8_t* data, size_t len) {
         if((m_codec == CODEC_FLAC) || (m_codec == CODEC_OGG_FLAC)){
             m_validSamples = FLACGetOutputSamps() / getChannels();
         }
+        if(m_validSamples && m_codec != CODEC_WAV) {
+            m_decodeStats.frames++;
+            m_decodeStats.samples += m_validSamples;
+            m_decodeStats.sampleRate = getSampleRate();
+            m_decodeStats.codecName = codecname[m_codec];
+        }
     }
     compute_audioCurrentTime(bytesDecoded);
 
@@ -4131,6 +4154,58 @@ void Audio::setI2SCommFMT_LSB(bool commFMT) {
     i2s_driver_install  ((i2s_port_t)m_i2s_num, &m_i2s_config, 0, NULL);
 }
 //---------------------------------------------------------------------------------------------------------------------
+bool Audio::setI2SDmaBuffers(uint8_t count, uint16_t len, QueueHandle_t* events) {
+    // count * len frames is how long the DMA plays on without a refill
+    // events: optional queue for i2s_event_t, I2S_EVENT_TX_Q_OVF means the DMA ran dry
+    if(m_f_running) {
+        log_e("Audio::setI2SDmaBuffers must not be called while playing");
+        return false;
+    }
+    if(count < 2 || count > 128 || len < 8 || len > 1024) {
+        log_e("I2S DMA buffers out of range: %u x %u", count, len);
+        return false;
+    }
+    m_i2s_config.dma_buf_count = count;
+    m_i2s_config.dma_buf_len   = len;
+    i2s_driver_uninstall((i2s_port_t)m_i2s_num);
+    esp_err_t err = i2s_driver_install((i2s_port_t)m_i2s_num, &m_i2s_config, events ? count : 0, events);
+    if(err != ESP_OK) {
+        log_e("ESP32 Errorcode %i", err);
+        return false;
+    }
+    i2s_zero_dma_buffer((i2s_port_t) m_i2s_num);
+    return true;
+}
+//---------------------------------------------------------------------------------------------------------------------
+void Audio::setReadAhead(uint32_t chunk, audio_read_gate_t gate) {
+    // Local files are read in few large pieces instead of whatever fits on every loop(). Each read ends on a
+    // sector boundary, so the next starts on one and the file system reads whole sectors straight into InBuff.
+    // gate(true) / gate(false) wrap every piece of AUDIO_READ_PIECE bytes; between pieces other users of a
+    // shared bus get their turn
+    m_readAheadSize = chunk ? (chunk + AUDIO_SECTOR_SIZE - 1) & ~(AUDIO_SECTOR_SIZE - 1) : 0;
+    m_readGate = gate;
+}
+//---------------------------------------------------------------------------------------------------------------------
+#ifndef AUDIO_NO_SD_FS
+int32_t Audio::readLocalFile(uint8_t* buf, uint32_t len) {
+    if(!m_readGate) return audiofile.read(buf, len);
+
+    uint32_t done = 0;
+    while(done < len) {
+        uint32_t pos = audiofile.position();
+        uint32_t piece = AUDIO_READ_PIECE - (pos % AUDIO_READ_PIECE); // pieces on absolute file offsets
+        if(piece > len - done) piece = len - done;
+        m_readGate(true);
+        int32_t n = audiofile.read(buf + done, piece);
+        m_readGate(false);
+        if(n <= 0) return done ? done : n;
+        done += n;
+        if((uint32_t)n < piece) break; // eof
+    }
+    return done;
+}
+#endif                                           // AUDIO_NO_SD_FS
+//---------------------------------------------------------------------------------------------------------------------
 bool Audio::playSample(int16_t sample[2]) {
 
     if (getBitsPerSample() == 8) { // Upsample from unsigned 8 bits to signed 16 bits
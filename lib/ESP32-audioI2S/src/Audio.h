@@ -151,6 +151,20 @@ protected:
 };
 //----------------------------------------------------------------------------------------------------------------------
 
+#define AUDIO_SECTOR_SIZE   512     // read-ahead alignment
+#define AUDIO_READ_PIECE    4096    // bytes per gated read, see setReadAhead()
+
+typedef void (*audio_read_gate_t)(bool acquire);
+
+typedef struct {                // CPU cycles spent in the codec, see getDecodeStats()
+    uint32_t frames;            // decoded frames that produced samples
+    uint32_t maxCycles;         // longest single decode call
+    uint64_t cycles;            // all decode calls, failed ones included
+    uint64_t samples;           // per channel
+    uint32_t sampleRate;        // kept after the file ends, unlike getSampleRate()
+    const char* codecName;      // and getCodecname()
+} audio_decode_stats_t;
+
 class Audio : private AudioBuffer{
 
     AudioBuffer InBuff; // instance of input buffer
@@ -198,6 +212,10 @@ public:
     uint32_t inBufferFree();   // returns the number of free bytes in the inputbuffer
     void setTone(int8_t gainLowPass, int8_t gainBandPass, int8_t gainHighPass);
     void setI2SCommFMT_LSB(bool commFMT);
+    bool setI2SDmaBuffers(uint8_t count, uint16_t len, QueueHandle_t* events = NULL); // call before setPinout()
+    void setReadAhead(uint32_t chunk, audio_read_gate_t gate = NULL); // local files, 0 = read whatever fits
+    void getDecodeStats(audio_decode_stats_t* stats) {*stats = m_decodeStats;}
+    void resetDecodeStats() {memset(&m_decodeStats, 0, sizeof(m_decodeStats));}
     int getCodec() {return m_codec;}
     const char *getCodecname() {return codecname[m_codec];}
     enum : int { CODEC_NONE, CODEC_WAV, CODEC_MP3, CODEC_AAC, CODEC_M4A, CODEC_FLAC, CODEC_OGG,
@@ -211,6 +229,7 @@ private:
     void initInBuff();
 #ifndef AUDIO_NO_SD_FS
     void processLocalFile();
+    int32_t readLocalFile(uint8_t* buf, uint32_t len);
 #endif // AUDIO_NO_SD_FS
     void processWebStream();
     void processPlayListData();
@@ -457,6 +476,9 @@ private:
     uint32_t        m_contentlength = 0;            // Stores the length if the stream comes from fileserver
     uint32_t        m_bytesNotDecoded = 0;          // pictures or something else that comes with the stream
     uint32_t        m_PlayingStartTime = 0;         // Stores the milliseconds after the start of the audio
+    audio_decode_stats_t m_decodeStats = {};        // codec cycles, a benchmark for every file played
+    uint32_t        m_readAheadSize = 0;            // local file reads in chunks of this size, sector aligned
+    audio_read_gate_t m_readGate = NULL;            // called around every read piece, e.g. a shared bus lock
     uint32_t        m_resumeFilePos = 0;            // the return value from stopSong() can be entered here
     bool            m_f_swm = true;                 // Stream without metadata
     bool            m_f_unsync = false;             // set within ID3 tag but not used
@@ -901,7 +901,7 @@ const int log2Tab[65] PROGMEM = {
     0x60000000
 };
 
-const HuffInfo_t huffTabSpecInfo[11] PROGMEM = {
+const HuffInfo_t huffTabSpecInfo[11] AUDIO_DSP_DATA = {
     /* table 0 not used */
     {11, {  1,  0,  0,  0,  8,  0, 24,  0, 24,  8, 16,  0,  0,  0,  0,  0,  0,  0,  0,  0},   0},
     { 9, {  0,  0,  1,  1,  7, 24, 15, 19, 14,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0},  81},
@@ -916,7 +916,7 @@ const HuffInfo_t huffTabSpecInfo[11] PROGMEM = {
     {12, {  0,  0,  0,  2,  6,  7, 16, 59, 55, 95, 43,  6,  0,  0,  0,  0,  0,  0,  0,  0}, 952},
 };
 
-const short huffTabSpec[1241] PROGMEM = {
+const short huffTabSpec[1241] AUDIO_DSP_DATA = {
     /* spectrum table 1 [81] (signed) */
     0x0000, 0x0200, 0x0e00, 0x0007, 0x0040, 0x0001, 0x0038, 0x0008, 0x01c0, 0x03c0, 0x0e40, 0x0039, 0x0078, 0x01c8, 0x000f, 0x0240,
     0x003f, 0x0fc0, 0x01f8, 0x0238, 0x0047, 0x0e08, 0x0009, 0x0208, 0x01c1, 0x0048, 0x0041, 0x0e38, 0x0201, 0x0e07, 0x0207, 0x0e01,
@@ -1087,11 +1087,11 @@ const uint32_t cTabS[640] PROGMEM = {
     0x0050b177, 0xfe70b8d1, 0x09299ead, 0xd3337b3d, 0x6d41d963, 0x2faa221c, 0x08d3e41b, 0x01d78bfc, 0x005b5371, 0xffede50f,
 };
 
-const HuffInfo_t huffTabScaleFactInfo PROGMEM =
+const HuffInfo_t huffTabScaleFactInfo AUDIO_DSP_DATA =
     {19, { 1,  0,  1,  3,  2,  4,  3,  5,  4,  6,  6,  6,  5,  8,  4,  7,  3,  7, 46,  0},   0};
 
 /* note - includes offset of -60 (4.6.2.3 in spec) */
-const short huffTabScaleFact[121] PROGMEM = { /* scale factor table [121] */
+const short huffTabScaleFact[121] AUDIO_DSP_DATA = { /* scale factor table [121] */
        0,   -1,    1,   -2,    2,   -3,    3,   -4,    4,   -5,    5,    6,   -6,    7,   -7,    8,
       -8,    9,   -9,   10,  -10,  -11,   11,   12,  -12,   13,  -13,   14,  -14,   16,   15,   17,
       18,  -15,  -17,  -16,   19,  -18,  -19,   20,  -20,   21,  -21,   22,  -22,   23,  -23,  -25,
@@ -2622,7 +2622,7 @@ int DecodeNextElement(uint8_t **buf, int *bitOffset, int *bitsAvail)
  *              normalization by -1/N is rolled into tables here (see trigtabs.c)
  *              uses 3-mul, 3-add butterflies instead of 4-mul, 2-add
  **********************************************************************************************************************/
-void PreMultiply(int tabidx, int *zbuf1)
+void AUDIO_DSP_CODE PreMultiply(int tabidx, int *zbuf1)
 {
     int i, nmdct, ar1, ai1, ar2, ai2, z1, z2;
     int t, cms2, cps2a, sin2a, cps2b, sin2b;
@@ -2682,7 +2682,7 @@ void PreMultiply(int tabidx, int *zbuf1)
  * Notes:       minimum 1 GB in, 2 GB out - gains 2 int bits
  *              uses 3-mul, 3-add butterflies instead of 4-mul, 2-add
  **********************************************************************************************************************/
-void PostMultiply(int tabidx, int *fft1)
+void AUDIO_DSP_CODE PostMultiply(int tabidx, int *fft1)
 {
     int i, nmdct, ar1, ai1, ar2, ai2, skipFactor;
     int t, cms2, cps2, sin2;
@@ -2904,7 +2904,7 @@ void DCT4(int tabidx, int *coef, int gb)
  *
  * Return:      none
  **********************************************************************************************************************/
-void BitReverse(int *inout, int tabidx)
+void AUDIO_DSP_CODE BitReverse(int *inout, int tabidx)
 {
     int *part0, *part1;
     int a,b, t;
@@ -2953,7 +2953,7 @@ void BitReverse(int *inout, int tabidx)
  * Notes:       assumes 2 guard bits, gains no integer bits,
  *                guard bits out = guard bits in - 2
  **********************************************************************************************************************/
-void R4FirstPass(int *x, int bg)
+void AUDIO_DSP_CODE R4FirstPass(int *x, int bg)
 {
     int ar, ai, br, bi, cr, ci, dr, di;
 
@@ -2999,7 +2999,7 @@ void R4FirstPass(int *x, int bg)
  *                or guard bits in - 2 (if inputs bounded to +/- sqrt(2)/2)
  *              see scaling comments in code
  **********************************************************************************************************************/
-void R8FirstPass(int *x, int bg)
+void AUDIO_DSP_CODE R8FirstPass(int *x, int bg)
 {
     int ar, ai, br, bi, cr, ci, dr, di;
     int sr, si, tr, ti, ur, ui, vr, vi;
@@ -3104,7 +3104,7 @@ void R8FirstPass(int *x, int bg)
  *              gbOut = gbIn - 1 (short block) or gbIn - 2 (long block)
  *              uses 3-mul, 3-add butterflies instead of 4-mul, 2-add
  **********************************************************************************************************************/
-void R4Core(int *x, int bg, int gp, int *wtab)
+void AUDIO_DSP_CODE R4Core(int *x, int bg, int gp, int *wtab)
 {
     int ar, ai, br, bi, cr, ci, dr, di, tr, ti;
     int wd, ws, wi;
@@ -3277,7 +3277,7 @@ void UnpackZeros(int nVals, int *coef)
  * Notes:       assumes nVals is always a multiple of 4 because all scalefactor bands
  *                are a multiple of 4 coefficients long
  **********************************************************************************************************************/
-void UnpackQuads(int cb, int nVals, int *coef)
+void AUDIO_DSP_CODE UnpackQuads(int cb, int nVals, int *coef)
 {
     int w, x, y, z, maxBits, nCodeBits, nSignBits, val;
     uint32_t bitBuf;
@@ -3324,7 +3324,7 @@ void UnpackQuads(int cb, int nVals, int *coef)
  * Notes:       assumes nVals is always a multiple of 2 because all scalefactor bands
  *                are a multiple of 4 coefficients long
  **********************************************************************************************************************/
-void UnpackPairsNoEsc(int cb, int nVals, int *coef)
+void AUDIO_DSP_CODE UnpackPairsNoEsc(int cb, int nVals, int *coef)
 {
     int y, z, maxBits, nCodeBits, nSignBits, val;
     uint32_t bitBuf;
@@ -3366,7 +3366,7 @@ void UnpackPairsNoEsc(int cb, int nVals, int *coef)
  * Notes:       assumes nVals is always a multiple of 2 because all scalefactor bands
  *                are a multiple of 4 coefficients long
  **********************************************************************************************************************/
-void UnpackPairsEsc(int cb, int nVals, int *coef)
+void AUDIO_DSP_CODE UnpackPairsEsc(int cb, int nVals, int *coef)
 {
     int y, z, maxBits, nCodeBits, nSignBits, n, val;
     uint32_t bitBuf;
@@ -3558,7 +3558,7 @@ void DecodeSpectrumShort(int ch)
  *              this should fit in registers on ARM
  *
  **********************************************************************************************************************/
-void DecWindowOverlap(int *buf0, int *over0, short *pcm0, int nChans, int winTypeCurr, int winTypePrev)
+void AUDIO_DSP_CODE DecWindowOverlap(int *buf0, int *over0, short *pcm0, int nChans, int winTypeCurr, int winTypePrev)
 {
     int in, w0, w1, f0, f1;
     int *buf1, *over1;
@@ -3642,7 +3642,7 @@ void DecWindowOverlap(int *buf0, int *over0, short *pcm0, int nChans, int winTyp
  *                the output buffer (pcm) for stereo interleaving
  *              this should fit in registers on ARM
  **********************************************************************************************************************/
-void DecWindowOverlapLongStart(int *buf0, int *over0, short *pcm0, int nChans, int winTypeCurr, int winTypePrev)
+void AUDIO_DSP_CODE DecWindowOverlapLongStart(int *buf0, int *over0, short *pcm0, int nChans, int winTypeCurr, int winTypePrev)
 {
     int i,  in, w0, w1, f0, f1;
     int *buf1, *over1;
@@ -3726,7 +3726,7 @@ void DecWindowOverlapLongStart(int *buf0, int *over0, short *pcm0, int nChans, i
  *                the output buffer (pcm) for stereo interleaving
  *              this should fit in registers on ARM
  **********************************************************************************************************************/
-void DecWindowOverlapLongStop(int *buf0, int *over0, short *pcm0, int nChans, int winTypeCurr, int winTypePrev)
+void AUDIO_DSP_CODE DecWindowOverlapLongStop(int *buf0, int *over0, short *pcm0, int nChans, int winTypeCurr, int winTypePrev)
 {
     int i, in, w0, w1, f0, f1;
     int *buf1, *over1;
@@ -3810,7 +3810,7 @@ void DecWindowOverlapLongStop(int *buf0, int *over0, short *pcm0, int nChans, in
  *                the output buffer (pcm) for stereo interleaving
  *              this should fit in registers on ARM
  **********************************************************************************************************************/
-void DecWindowOverlapShort(int *buf0, int *over0, short *pcm0, int nChans, int winTypeCurr, int winTypePrev)
+void AUDIO_DSP_CODE DecWindowOverlapShort(int *buf0, int *over0, short *pcm0, int nChans, int winTypeCurr, int winTypePrev)
 {
     int i, in, w0, w1, f0, f1;
     int *buf1, *over1;
@@ -4488,7 +4488,7 @@ int DecodeNoiselessData(uint8_t **buf, int *bitOffset, int *bitsAvail, int ch)
  *                if there are no codes at nBits, then we just keep << 1 each time
  *                  (since count[nBits] = 0)
  **********************************************************************************************************************/
-int DecodeHuffmanScalar(const signed short *huffTab, const HuffInfo_t *huffTabInfo, uint32_t bitBuf, int32_t *val)
+int AUDIO_DSP_CODE DecodeHuffmanScalar(const signed short *huffTab, const HuffInfo_t *huffTabInfo, uint32_t bitBuf, int32_t *val)
 {
     uint32_t count, start, shift, t;
     const uint8_t *countPtr;
@@ -4909,7 +4909,7 @@ int PrepareRawBlock()
  *              clips outputs to Q(FBITS_OUT_DQ_OFF)
  *              output has no minimum number of guard bits
  **********************************************************************************************************************/
-int DequantBlock(int *inbuf, int nSamps, int scale)
+int AUDIO_DSP_CODE DequantBlock(int *inbuf, int nSamps, int scale)
 {
     int iSamp, scalef, scalei, x, y, gbMask, shift, tab4[4];
     const uint32_t *tab16, *coef;
@@ -8500,7 +8500,7 @@ void GenerateHighFreq(SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrChan, int
  *                if there are no codes at nBits, then we just keep << 1 each time
  *                  (since count[nBits] = 0)
  **********************************************************************************************************************/
-int DecodeHuffmanScalar(const signed int *huffTab, const HuffInfo_t *huffTabInfo, unsigned int bitBuf,
+int AUDIO_DSP_CODE DecodeHuffmanScalar(const signed int *huffTab, const HuffInfo_t *huffTabInfo, unsigned int bitBuf,
         signed int *val) {
 
     unsigned int count, start, shift, t;
@@ -9434,7 +9434,7 @@ void PostMultiply64(int *fft1, int nSampsOut) {
  * Notes:       this is carefully written to be efficient on ARM
  *              use the assembly code version in sbrqmfak.s when building for ARM!
  **********************************************************************************************************************/
-void QMFAnalysisConv(int *cTab, int *delay, int dIdx, int *uBuf) {
+void AUDIO_DSP_CODE QMFAnalysisConv(int *cTab, int *delay, int dIdx, int *uBuf) {
 
     int k, dOff;
     int *cPtr0, *cPtr1;
@@ -9592,7 +9592,7 @@ int QMFAnalysis(int *inbuf, int *delay, int *XBuf, int fBitsIn, int *delayIdx, i
  * Notes:       this is carefully written to be efficient on ARM
  *              use the assembly code version in sbrqmfsk.s when building for ARM!
  **********************************************************************************************************************/
-void QMFSynthesisConv(int *cPtr, int *delay, int dIdx, short *outbuf, int nChans) {
+void AUDIO_DSP_CODE QMFSynthesisConv(int *cPtr, int *delay, int dIdx, short *outbuf, int nChans) {
 
     int k, dOff0, dOff1;
     U64 sum64;
@@ -4,6 +4,7 @@
 //#pragma GCC diagnostic ignored "-Wnarrowing"
 
 #include "Arduino.h"
+#include "../audio_dsp.h"
 
 #define AAC_ENABLE_MPEG4
 
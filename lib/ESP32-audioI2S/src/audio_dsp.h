@@ -0,0 +1,23 @@
+/*
+ * audio_dsp.h
+ *
+ * Placement of the decoders' per-sample kernels and Huffman tables.
+ * Flash code and constants are read through the same cache as the PSRAM
+ * input buffer, so while a stream is buffering the inner loops miss and
+ * stall on flash. AUDIO_DSP_CODE puts a function in IRAM, AUDIO_DSP_DATA a
+ * table in DRAM (IRAM only allows 32 bit loads).
+ *
+ * Roughly 20 KB of code and 12 KB of tables; define AUDIO_DSP_IN_FLASH to
+ * leave everything in flash.
+ */
+#pragma once
+
+#include "Arduino.h"
+
+#ifndef AUDIO_DSP_IN_FLASH
+#define AUDIO_DSP_CODE IRAM_ATTR
+#define AUDIO_DSP_DATA DRAM_ATTR
+#else
+#define AUDIO_DSP_CODE
+#define AUDIO_DSP_DATA PROGMEM
+#endif
@@ -73,14 +73,18 @@ void FLACDecoder_FreeBuffers(){
 //----------------------------------------------------------------------------------------------------------------------
 //            B I T R E A D E R
 //----------------------------------------------------------------------------------------------------------------------
-uint32_t readUint(uint8_t nBits){
+inline void pullByte(){
+    uint8_t temp = *(m_inptr + m_rIndex);
+    m_rIndex++;
+    m_bytesAvail--;
+    if(m_bytesAvail < 0) { log_i("error in bitreader"); }
+    m_bitBuffer = (m_bitBuffer << 8) | temp;
+    m_bitBufferLen += 8;
+}
+
+uint32_t AUDIO_DSP_CODE readUint(uint8_t nBits){
     while (m_bitBufferLen < nBits){
-        uint8_t temp = *(m_inptr + m_rIndex);
-        m_rIndex++;
-        m_bytesAvail--;
-        if(m_bytesAvail < 0) { log_i("error in bitreader"); }
-        m_bitBuffer = (m_bitBuffer << 8) | temp;
-        m_bitBufferLen += 8;
+        pullByte();
     }
     m_bitBufferLen -= nBits;
     uint32_t result = m_bitBuffer >> m_bitBufferLen;
@@ -95,10 +99,22 @@ int32_t readSignedInt(int nBits){
     return temp;
 }
 
-int64_t readRiceSignedInt(uint8_t param){
+int64_t AUDIO_DSP_CODE readRiceSignedInt(uint8_t param){
+    // unary quotient: count the zeros of all buffered bits at once with NSAU
     long val = 0;
-    while (readUint(1) == 0)
-        val++;
+    while (true) {
+        if (m_bitBufferLen == 0) pullByte();
+        uint32_t window = (uint32_t)((m_bitBuffer << (64 - m_bitBufferLen)) >> 32); // next bits, msb first
+        uint8_t avail = m_bitBufferLen < 32 ? m_bitBufferLen : 32;
+        uint8_t zeros = window ? __builtin_clz(window) : 32;
+        if (zeros < avail) {
+            val += zeros;
+            m_bitBufferLen -= zeros + 1; // and the terminating one
+            break;
+        }
+        val += avail;
+        m_bitBufferLen -= avail;
+    }
     val = (val << param) | readUint(param);
     return (val >> 1) ^ -(val & 1);
 }
@@ -509,7 +525,7 @@ int8_t decodeLinearPredictiveCodingSubframe(int lpcOrder, int sampleDepth, uint8
     return ERR_FLAC_NONE;
 }
 //----------------------------------------------------------------------------------------------------------------------
-int8_t decodeResiduals(uint8_t warmup, uint8_t ch) {
+int8_t AUDIO_DSP_CODE decodeResiduals(uint8_t warmup, uint8_t ch) {
 
     int method = readUint(2);
     if (method >= 2)
@@ -542,7 +558,7 @@ int8_t decodeResiduals(uint8_t warmup, uint8_t ch) {
     return ERR_FLAC_NONE;
 }
 //----------------------------------------------------------------------------------------------------------------------
-void restoreLinearPrediction(uint8_t ch, uint8_t shift) {
+void AUDIO_DSP_CODE restoreLinearPrediction(uint8_t ch, uint8_t shift) {
 
     for (int i = coefs.size(); i < m_blockSize; i++) {
         int32_t sum = 0;
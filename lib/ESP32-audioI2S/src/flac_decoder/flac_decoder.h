@@ -17,6 +17,7 @@
 #pragma GCC optimize ("Ofast")
 
 #include "Arduino.h"
+#include "../audio_dsp.h"
 
 #define MAX_CHANNELS 2
 #define MAX_BLOCKSIZE 8192
@@ -53,7 +53,7 @@ ScaleFactorJS_t *m_ScaleFactorJS;
 SubbandInfo_t *m_SubbandInfo;
 MP3DecInfo_t *m_MP3DecInfo;
 
-const unsigned short huffTable[4242] PROGMEM = {
+const unsigned short huffTable[4242] AUDIO_DSP_DATA = {
     /* huffTable01[9] */
     0xf003, 0x3112, 0x3101, 0x2011, 0x2011, 0x1000, 0x1000, 0x1000, 0x1000,
     /* huffTable02[65] */
@@ -462,7 +462,7 @@ const int pow43[48] PROGMEM = {
     0x70416360, 0x72d7e8b0, 0x75722ef9, 0x78102b85, 0x7ab1d3ec, 0x7d571e09,
 };
 
-const uint32_t polyCoef[264] PROGMEM = {
+const uint32_t polyCoef[264] AUDIO_DSP_DATA = {
     /* shuffled vs. original from 0, 1, ... 15 to 0, 15, 2, 13, ... 14, 1 */
     0x00000000, 0x00000074, 0x00000354, 0x0000072c, 0x00001fd4, 0x00005084, 0x000066b8, 0x000249c4,
     0x00049478, 0xfffdb63c, 0x000066b8, 0xffffaf7c, 0x00001fd4, 0xfffff8d4, 0x00000354, 0xffffff8c,
@@ -534,7 +534,7 @@ const uint32_t fastWin36[18] PROGMEM = {
  *  A = length of codeword
  *  B = codeword
  */
-const unsigned char quadTable[64+16] PROGMEM = {
+const unsigned char quadTable[64+16] AUDIO_DSP_DATA = {
     /* table A */
     0x6b, 0x6f, 0x6d, 0x6e, 0x67, 0x65, 0x59, 0x59, 0x56, 0x56, 0x53, 0x53, 0x5a, 0x5a, 0x5c, 0x5c,
     0x42, 0x42, 0x42, 0x42, 0x41, 0x41, 0x41, 0x41, 0x44, 0x44, 0x44, 0x44, 0x48, 0x48, 0x48, 0x48,
@@ -1613,7 +1613,7 @@ void MP3Decoder_FreeBuffers()
  *                necessarily all linBits outputs for x,y > 15)
  **********************************************************************************************************************/
 // no improvement with section=data
-int DecodeHuffmanPairs(int *xy, int nVals, int tabIdx, int bitsLeft, unsigned char *buf, int bitOffset){
+int AUDIO_DSP_CODE DecodeHuffmanPairs(int *xy, int nVals, int tabIdx, int bitsLeft, unsigned char *buf, int bitOffset){
     int i, x, y;
     int cachedBits, padBits, len, startBits, linBits, maxBits, minBits;
     HuffTabType_t tabType;
@@ -1851,7 +1851,7 @@ int DecodeHuffmanPairs(int *xy, int nVals, int tabIdx, int bitsLeft, unsigned ch
  * Notes:        si_huff.bit tests every vwxy output in both quad tables
  **********************************************************************************************************************/
 // no improvement with section=data
-int DecodeHuffmanQuads(int *vwxy, int nVals, int tabIdx, int bitsLeft, unsigned char *buf, int bitOffset){
+int AUDIO_DSP_CODE DecodeHuffmanQuads(int *vwxy, int nVals, int tabIdx, int bitsLeft, unsigned char *buf, int bitOffset){
     int i, v, w, x, y;
     int len, maxBits, cachedBits, padBits;
     unsigned int cache;
@@ -2152,7 +2152,7 @@ int MP3Dequantize(int gr){
  *
  * Return:      bitwise-OR of the unsigned outputs (for guard bit calculations)
  **********************************************************************************************************************/
-int DequantBlock(int *inbuf, int *outbuf, int num, int scale){
+int AUDIO_DSP_CODE DequantBlock(int *inbuf, int *outbuf, int num, int scale){
     int tab4[4];
     int scalef, scalei, shift;
     int sx, x, y;
@@ -2686,7 +2686,7 @@ void IntensityProcMPEG2(int x[m_MAX_NCHAN][m_MAX_NSAMP], int nSamps,
  **********************************************************************************************************************/
 // a little bit faster in RAM (< 1 ms per block)
 /* __attribute__ ((section (".data"))) */
-void AntiAlias(int *x, int nBfly){
+void AUDIO_DSP_CODE AntiAlias(int *x, int nBfly){
     int k, a0, b0, c0, c1;
     const uint32_t *c;
 
@@ -2785,7 +2785,7 @@ void AntiAlias(int *x, int nBfly){
  *                sign bit, short blocks can have one addition but max gain < 1.0)
  **********************************************************************************************************************/
 
-void WinPrevious(int *xPrev, int *xPrevWin, int btPrev){
+void AUDIO_DSP_CODE WinPrevious(int *xPrev, int *xPrevWin, int btPrev){
     int i, x, *xp, *xpwLo, *xpwHi, wLo, wHi;
     const uint32_t *wpLo, *wpHi;
 
@@ -2847,7 +2847,7 @@ void WinPrevious(int *xPrev, int *xPrevWin, int btPrev){
  * Return:      updated mOut (from new outputs y)
  **********************************************************************************************************************/
 
-int FreqInvertRescale(int *y, int *xPrev, int blockIdx, int es) {
+int AUDIO_DSP_CODE FreqInvertRescale(int *y, int *xPrev, int blockIdx, int es) {
 
 	if (es == 0) {
 		/* fast case - frequency invert only (no rescaling) */
@@ -2883,7 +2883,7 @@ int FreqInvertRescale(int *y, int *xPrev, int blockIdx, int es) {
 
 
 /* require at least 3 guard bits in x[] to ensure no overflow */
-void idct9(int *x) {
+void AUDIO_DSP_CODE idct9(int *x) {
     int a1, a2, a3, a4, a5, a6, a7, a8, a9;
     int a10, a11, a12, a13, a14, a15, a16, a17, a18;
     int a19, a20, a21, a22, a23, a24, a25, a26, a27;
@@ -2995,7 +2995,7 @@ void idct9(int *x) {
  **********************************************************************************************************************/
 // barely faster in RAM
 
-int IMDCT36(int *xCurr, int *xPrev, int *y, int btCurr, int btPrev, int blockIdx, int gb){
+int AUDIO_DSP_CODE IMDCT36(int *xCurr, int *xPrev, int *y, int btCurr, int btPrev, int blockIdx, int gb){
     int i, es, xBuf[18], xPrevWin[18];
     int acc1, acc2, s, d, t, mOut;
     int xo, xe, c, *xp, yLo, yHi;
@@ -3098,7 +3098,7 @@ int IMDCT36(int *xCurr, int *xPrev, int *y, int btCurr, int btPrev, int blockIdx
 /* 12-point inverse DCT, used in IMDCT12x3()
  * 4 input guard bits will ensure no overflow
  */
-void imdct12(int *x, int *out) {
+void AUDIO_DSP_CODE imdct12(int *x, int *out) {
     int a0, a1, a2;
     int x0, x1, x2, x3, x4, x5;
 
@@ -3175,7 +3175,7 @@ void imdct12(int *x, int *out) {
  * Return:      mOut (OR of abs(y) for all y calculated here)
  **********************************************************************************************************************/
 // barely faster in RAM
-int IMDCT12x3(int *xCurr, int *xPrev, int *y, int btPrev, int blockIdx, int gb){
+int AUDIO_DSP_CODE IMDCT12x3(int *xCurr, int *xPrev, int *y, int btPrev, int blockIdx, int gb){
     int i, es, mOut, yLo, xBuf[18], xPrevWin[18]; /* need temp buffer for reordering short blocks */
     const uint32_t *wp;
     es = 0;
@@ -3505,7 +3505,7 @@ int Subband( short *pcmBuf) {
 
 static const uint8_t FDCT32s1s2[16] = {5,3,3,2,2,1,1,1, 1,1,1,1,1,2,2,4};
 
-void FDCT32(int *buf, int *dest, int offset, int oddBlock, int gb) {
+void AUDIO_DSP_CODE FDCT32(int *buf, int *dest, int offset, int oddBlock, int gb) {
     int i, s, tmp, es;
     const int *cptr = (const int*)m_dcttab;
     int a0, a1, a2, a3, a4, a5, a6, a7;
@@ -3676,7 +3676,7 @@ short ClipToShort(int x, int fracBits){
  *
  * Return:      none
  **********************************************************************************************************************/
-void PolyphaseMono(short *pcm, int *vbuf, const uint32_t *coefBase){
+void AUDIO_DSP_CODE PolyphaseMono(short *pcm, int *vbuf, const uint32_t *coefBase){
     int i;
     const uint32_t *coef;
     int *vb1;
@@ -3741,7 +3741,7 @@ void PolyphaseMono(short *pcm, int *vbuf, const uint32_t *coefBase){
  *
  * Notes:       interleaves PCM samples LRLRLR...
  **********************************************************************************************************************/
-void PolyphaseStereo(short *pcm, int *vbuf, const uint32_t *coefBase){
+void AUDIO_DSP_CODE PolyphaseStereo(short *pcm, int *vbuf, const uint32_t *coefBase){
     int i;
     const uint32_t *coef;
     int *vb1;
@@ -2,6 +2,7 @@
 #pragma once
 
 #include "Arduino.h"
+#include "../audio_dsp.h"
 #include "assert.h"
 
 static const uint8_t  m_HUFF_PAIRTABS          =32;
@@ -506,8 +507,9 @@ void imdct12(int *x, int *out);
 int IMDCT12x3(int *xCurr, int *xPrev, int *y, int btPrev, int blockIdx, int gb);
 int HybridTransform(int *xCurr, int *xPrev, int y[m_BLOCK_SIZE][m_NBANDS], SideInfoSub_t *sis, BlockCount_t *bc);
 inline uint64_t SAR64(uint64_t x, int n) {return x >> n;}
-inline int MULSHIFT32(int x, int y) { int z; z = (uint64_t) x * (uint64_t) y >> 32; return z;}
-inline uint64_t MADD64(uint64_t sum64, int x, int y) {sum64 += (uint64_t) x * (uint64_t) y; return sum64;}/* returns 64-bit value in [edx:eax] */
+// Signed 32x32 products, so Xtensa does MULSH (and MULL) instead of a 64x64 multiply
+inline int MULSHIFT32(int x, int y) { int z; z = (int64_t) x * (int64_t) y >> 32; return z;}
+inline uint64_t MADD64(uint64_t sum64, int x, int y) {sum64 += (uint64_t)((int64_t) x * (int64_t) y); return sum64;}/* returns 64-bit value in [edx:eax] */
 inline uint64_t xSAR64(uint64_t x, int n){return x >> n;}
 inline int FASTABS(int x){ return __builtin_abs(x);} //xtensa has a fast abs instruction //fb
 #define CLZ(x) __builtin_clz(x) //fb
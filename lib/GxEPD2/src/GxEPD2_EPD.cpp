@@ -32,6 +32,8 @@ GxEPD2_EPD::GxEPD2_EPD(int16_t cs, int16_t dc, int16_t rst, int16_t busy, int16_
   _reset_duration = 10;
   _busy_callback = 0;
   _busy_callback_parameter = 0;
+  _transfer_callback = 0;
+  _transfer_callback_parameter = 0;
 }
 
 void GxEPD2_EPD::init(uint32_t serial_diag_bitrate)
@@ -100,6 +102,12 @@ void GxEPD2_EPD::setBusyCallback(void (*busyCallback)(const void*), const void*
   _busy_callback_parameter = busy_callback_parameter;
 }
 
+void GxEPD2_EPD::setTransferCallback(void (*transferCallback)(const void*), const void* transfer_callback_parameter)
+{
+  _transfer_callback = transferCallback;
+  _transfer_callback_parameter = transfer_callback_parameter;
+}
+
 void GxEPD2_EPD::selectSPI(SPIClass& spi, SPISettings spi_settings)
 {
   _pSPIx = &spi;
@@ -281,8 +289,28 @@ void GxEPD2_EPD::_transfer(uint8_t value)
   _pSPIx->transfer(value);
 }
 
+void GxEPD2_EPD::_transfer(const uint8_t* data, uint16_t n)
+{
+#if defined(ESP32)
+  _pSPIx->writeBytes(data, n); // fills the SPI FIFO in blocks, no per-byte round trip
+#else
+  for (uint16_t i = 0; i < n; i++)
+  {
+    _pSPIx->transfer(data[i]);
+  }
+#endif
+}
+
 void GxEPD2_EPD::_endTransfer()
 {
   if (_cs >= 0) digitalWrite(_cs, HIGH);
   _pSPIx->endTransaction();
 }
+
+void GxEPD2_EPD::_transferBreak()
+{
+  if (!_transfer_callback) return;
+  _endTransfer();
+  _transfer_callback(_transfer_callback_parameter);
+  _startTransfer();
+}
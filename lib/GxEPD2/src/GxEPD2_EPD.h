@@ -89,6 +89,9 @@ class GxEPD2_EPD
     virtual void setPaged() {}; // for GxEPD2_154c paged workaround
     // register a callback function to be called during _waitWhileBusy continuously.
     void setBusyCallback(void (*busyCallback)(const void*), const void* busy_callback_parameter = 0);
+    // register a callback function to be called between chunks of a bulk data write, with CS released
+    // (another device may use the SPI bus meanwhile; the controller continues the same data stream)
+    void setTransferCallback(void (*transferCallback)(const void*), const void* transfer_callback_parameter = 0);
     static inline uint16_t gx_uint16_min(uint16_t a, uint16_t b)
     {
       return (a < b ? a : b);
@@ -110,7 +113,9 @@ class GxEPD2_EPD
     void _writeCommandDataPGM(const uint8_t* pCommandData, uint8_t datalen);
     void _startTransfer();
     void _transfer(uint8_t value);
+    void _transfer(const uint8_t* data, uint16_t n); // bulk write within _startTransfer/_endTransfer
     void _endTransfer();
+    void _transferBreak(); // between chunks of one data stream: runs the transfer callback with CS released
   protected:
     int16_t _cs, _dc, _rst, _busy, _busy_level;
     uint32_t _busy_timeout;
@@ -123,6 +128,8 @@ class GxEPD2_EPD
     uint16_t _reset_duration;
     void (*_busy_callback)(const void*); 
     const void* _busy_callback_parameter;
+    void (*_transfer_callback)(const void*);
+    const void* _transfer_callback_parameter;
 };
 
 #endif
@@ -13,9 +13,56 @@
 
 #include "GxEPD2_310_GDEQ031T10.h"
 
+// bitmaps may live in PSRAM or flash; rows are staged here and sent in bulk
+static uint8_t _transfer_buffer[GxEPD2_310_GDEQ031T10::transfer_buffer_size];
+
+// forced temperature (TSSET) per ambient band, 0 = use the internal sensor
+// the fast OTP waveforms degrade in the cold, so low bands fall back to the sensor
+struct _WaveformBand
+{
+  int8_t min_celsius;
+  uint8_t text;
+  uint8_t full;
+};
+
+static const _WaveformBand _waveform_table[] =
+{
+  {  10, 0x79, 0x5A }, // 121 for fast partial, 90 for fast full (1015000us)
+  {   0, 0x79, 0x00 }, // fast partial still usable, full uses the sensor waveform
+  { -128, 0x00, 0x00 } // sensor waveforms only
+};
+
 GxEPD2_310_GDEQ031T10::GxEPD2_310_GDEQ031T10(int16_t cs, int16_t dc, int16_t rst, int16_t busy) :
   GxEPD2_EPD(cs, dc, rst, busy, LOW, 10000000, WIDTH, HEIGHT, panel, hasColor, hasPartialUpdate, hasFastPartialUpdate)
 {
+  _update_class = UPDATE_TEXT;
+  _ambient_celsius = 25;
+  _keep_init = false;
+  _power_tsset = 0;
+}
+
+void GxEPD2_310_GDEQ031T10::setUpdateClass(UpdateClass update_class)
+{
+  _update_class = update_class;
+}
+
+void GxEPD2_310_GDEQ031T10::setKeepInit(bool keep)
+{
+  _keep_init = keep;
+}
+
+void GxEPD2_310_GDEQ031T10::setAmbientTemperature(int8_t celsius)
+{
+  _ambient_celsius = celsius;
+}
+
+uint8_t GxEPD2_310_GDEQ031T10::_forcedTemperature(bool full_update)
+{
+  const _WaveformBand* band = &_waveform_table[0];
+  while (_ambient_celsius < band->min_celsius) band++; // last band matches everything
+  if (full_update) return useFastFullUpdate ? band->full : 0;
+  if (!hasFastPartialUpdate || (_update_class != UPDATE_TEXT)) return 0;
+  return band->text;
 }
 
 void GxEPD2_310_GDEQ031T10::clearScreen(uint8_t value)
@@ -44,13 +91,28 @@ void GxEPD2_310_GDEQ031T10::_writeScreenBuffer(uint8_t command, uint8_t value)
   if (!_init_display_done) _InitDisplay();
   _writeCommand(command);
   _startTransfer();
-  for (uint32_t i = 0; i < uint32_t(WIDTH) * uint32_t(HEIGHT) / 8; i++)
+  memset(_transfer_buffer, value, sizeof(_transfer_buffer));
+  for (uint32_t remaining = uint32_t(WIDTH) * uint32_t(HEIGHT) / 8; remaining > 0;)
   {
-    _transfer(value);
+    uint16_t n = remaining < sizeof(_transfer_buffer) ? remaining : sizeof(_transfer_buffer);
+    _transfer(_transfer_buffer, n);
+    remaining -= n;
+    if (remaining > 0) _transferBreak();
   }
   _endTransfer();
 }
 
+void GxEPD2_310_GDEQ031T10::_flushTransferBuffer(uint16_t& n)
+{
+  if (n == 0) return;
+  _transfer(_transfer_buffer, n);
+  n = 0;
+  if (_transfer_callback) _transferBreak(); // let other devices use the bus between chunks
+#if defined(ESP8266) || defined(ESP32)
+  else yield(); // let other tasks run between chunks
+#endif
+}
+
 void GxEPD2_310_GDEQ031T10::writeImage(const uint8_t bitmap[], int16_t x, int16_t y, int16_t w, int16_t h, bool invert, bool mirror_y, bool pgm)
 {
   _writeImage(0x13, bitmap, x, y, w, h, invert, mirror_y, pgm);
@@ -89,8 +151,10 @@ void GxEPD2_310_GDEQ031T10::_writeImage(uint8_t command, const uint8_t bitmap[],
   _setPartialRamArea(x1, y1, w1, h1);
   _writeCommand(command);
   _startTransfer();
+  uint16_t n = 0;
   for (int16_t i = 0; i < h1; i++)
   {
+    if (n + w1 / 8 > sizeof(_transfer_buffer)) _flushTransferBuffer(n);
     for (int16_t j = 0; j < w1 / 8; j++)
     {
       uint8_t data;
@@ -109,9 +173,10 @@ void GxEPD2_310_GDEQ031T10::_writeImage(uint8_t command, const uint8_t bitmap[],
         data = bitmap[idx];
       }
       if (invert) data = ~data;
-      _transfer(data);
+      _transfer_buffer[n++] = data;
     }
   }
+  _flushTransferBuffer(n);
   _endTransfer();
   _writeCommand(0x92); // partial out
   delay(1); // yield() to avoid WDT on ESP8266 and ESP32
@@ -158,8 +223,10 @@ void GxEPD2_310_GDEQ031T10::_writeImagePart(uint8_t command, const uint8_t bitma
   _setPartialRamArea(x1, y1, w1, h1);
   _writeCommand(command);
   _startTransfer();
+  uint16_t n = 0;
   for (int16_t i = 0; i < h1; i++)
   {
+    if (n + w1 / 8 > sizeof(_transfer_buffer)) _flushTransferBuffer(n);
     for (int16_t j = 0; j < w1 / 8; j++)
     {
       uint8_t data;
@@ -178,9 +245,10 @@ void GxEPD2_310_GDEQ031T10::_writeImagePart(uint8_t command, const uint8_t bitma
         data = bitmap[idx];
       }
       if (invert) data = ~data;
-      _transfer(data);
+      _transfer_buffer[n++] = data;
     }
   }
+  _flushTransferBuffer(n);
   _endTransfer();
   _writeCommand(0x92); // partial out
   delay(1); // yield() to avoid WDT on ESP8266 and ESP32
@@ -287,6 +355,12 @@ void GxEPD2_310_GDEQ031T10::powerOff(void)
   _PowerOff();
 }
 
+void GxEPD2_310_GDEQ031T10::powerOn(void)
+{
+  if (!_init_display_done) _InitDisplay();
+  _PowerOn();
+}
+
 void GxEPD2_310_GDEQ031T10::hibernate()
 {
   _PowerOff();
@@ -353,35 +427,40 @@ void GxEPD2_310_GDEQ031T10::_InitDisplay()
 
 void GxEPD2_310_GDEQ031T10::_Update_Full()
 {
-  if (useFastFullUpdate)
+  uint8_t tsset = _forcedTemperature(true);
+  _writeCommand(0xE0); // Cascade Setting (CCSET)
+  _writeData(tsset ? 0x02 : 0x00); // TSFIX or internal sensor
+  if (tsset)
   {
-    _writeCommand(0xE0); // Cascade Setting (CCSET)
-    _writeData(0x02);    // TSFIX
     _writeCommand(0xE5); // Force Temperature (TSSET)
-    _writeData(0x5A);    // 90, 1015000us
-    //_writeData(0x6E);    // 110, 1542001
+    _writeData(tsset);   // 90, 1015000us; 110, 1542001
   }
   _writeCommand(0x50);
   _writeData(0x97);
+  if (_power_tsset != tsset) _PowerOff(); // the OTP waveform is picked at power on
   _PowerOn();
+  _power_tsset = tsset;
   _writeCommand(0x12); //display refresh
   _waitWhileBusy("_Update_Full", full_refresh_time);
-  _init_display_done = false; // needed, reason unknown
+  if (!_keep_init) _init_display_done = false; // needed, reason unknown
 }
 
 void GxEPD2_310_GDEQ031T10::_Update_Part()
 {
-  if (hasFastPartialUpdate)
+  uint8_t tsset = _forcedTemperature(false);
+  _writeCommand(0xE0); // Cascade Setting (CCSET)
+  _writeData(tsset ? 0x02 : 0x00); // TSFIX or internal sensor
+  if (tsset)
   {
-    _writeCommand(0xE0); // Cascade Setting (CCSET)
-    _writeData(0x02);    // TSFIX
     _writeCommand(0xE5); // Force Temperature (TSSET)
-    _writeData(0x79);    // 121
+    _writeData(tsset);   // 121
   }
   _writeCommand(0x50);
   _writeData(0xD7);
+  if (_power_tsset != tsset) _PowerOff(); // the OTP waveform is picked at power on
   _PowerOn();
+  _power_tsset = tsset;
   _writeCommand(0x12); //display refresh
   _waitWhileBusy("_Update_Part", partial_refresh_time);
-  _init_display_done = false; // needed, reason unknown
+  if (!_keep_init) _init_display_done = false; // needed, reason unknown
 }
@@ -33,6 +33,14 @@ class GxEPD2_310_GDEQ031T10 : public GxEPD2_EPD
     static const uint16_t power_off_time = 50; // ms, e.g. 45000us
     static const uint16_t full_refresh_time = 1100; // ms, e.g. 1015000us
     static const uint16_t partial_refresh_time = 700; // ms, e.g. 650000us
+    static const uint16_t transfer_buffer_size = 1024; // bytes staged in internal RAM per bulk SPI write
+    // waveform selection per update; the fast waveforms live in OTP and are picked by forcing the temperature (TSSET)
+    enum UpdateClass
+    {
+      UPDATE_TEXT,        // small areas, fastest partial waveform, e.g. typing echo
+      UPDATE_ICON,        // larger areas, partial waveform for the actual temperature, better contrast
+      UPDATE_FULL_SCREEN  // full waveform, fast variant when the temperature allows it
+    };
     // constructor
     GxEPD2_310_GDEQ031T10(int16_t cs, int16_t dc, int16_t rst, int16_t busy);
     // methods (virtual)
@@ -67,12 +75,26 @@ class GxEPD2_310_GDEQ031T10 : public GxEPD2_EPD
     void refresh(int16_t x, int16_t y, int16_t w, int16_t h); // screen refresh from controller memory, partial screen
     void powerOff(); // turns off generation of panel driving voltages, avoids screen fading over time
     void hibernate(); // turns powerOff() and sets controller to deep sleep for minimum power use, ONLY if wakeable by RST (rst >= 0)
+    void powerOn(); // starts the panel driving voltages ahead of an update, so the refresh need not wait for them
+    bool isPoweredOn() { return _power_is_on; }
+    // keep the panel setting across refreshes and powerOff(); updates then skip the soft reset and, while the
+    // driving voltages are still on, the power on. Only init() and hibernate() start the controller over
+    void setKeepInit(bool keep);
+    void setUpdateClass(UpdateClass update_class); // waveform class used by following refreshes
+    UpdateClass getUpdateClass() { return _update_class; }
+    void setAmbientTemperature(int8_t celsius); // selects the row of the waveform table, default 25
   private:
+    uint8_t _forcedTemperature(bool full_update);
+    UpdateClass _update_class;
+    int8_t _ambient_celsius;
+    bool _keep_init;
+    uint8_t _power_tsset; // forced temperature in effect since the last power on
     void _writeScreenBuffer(uint8_t command, uint8_t value);
     void _writeImage(uint8_t command, const uint8_t bitmap[], int16_t x, int16_t y, int16_t w, int16_t h, bool invert = false, bool mirror_y = false, bool pgm = false);
     void _writeImagePart(uint8_t command, const uint8_t bitmap[], int16_t x_part, int16_t y_part, int16_t w_bitmap, int16_t h_bitmap,
                          int16_t x, int16_t y, int16_t w, int16_t h, bool invert = false, bool mirror_y = false, bool pgm = false);
     void _setPartialRamArea(uint16_t x, uint16_t y, uint16_t w, uint16_t h);
+    void _flushTransferBuffer(uint16_t& n);
     void _PowerOn();
     void _PowerOff();
     void _InitDisplay();
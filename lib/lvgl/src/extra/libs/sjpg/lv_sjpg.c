@@ -784,6 +784,14 @@ static lv_res_t decoder_read_line(lv_img_decoder_t * decoder, lv_img_decoder_dsc
             col_8bit |= (*cache++ & 0xe0) >> 5;
             buf[offset++] = col_8bit;
         }
+#elif  LV_COLOR_DEPTH == 1
+
+        for(int i = 0; i < len; i++) {
+            uint16_t luma = (uint16_t)(*cache++ * 77);
+            luma += *cache++ * 150;
+            luma += *cache++ * 29;
+            buf[offset++] = (luma >> 8) >= 0x80 ? 1 : 0;
+        }
 #else
 #error Unsupported LV_COLOR_DEPTH
 
@@ -849,6 +857,14 @@ static lv_res_t decoder_read_line(lv_img_decoder_t * decoder, lv_img_decoder_dsc
             buf[offset++] = col_8bit;
         }
 
+#elif  LV_COLOR_DEPTH == 1
+
+        for(int i = 0; i < len; i++) {
+            uint16_t luma = (uint16_t)(*cache++ * 77);
+            luma += *cache++ * 150;
+            luma += *cache++ * 29;
+            buf[offset++] = (luma >> 8) >= 0x80 ? 1 : 0;
+        }
 #else
 #error Unsupported LV_COLOR_DEPTH
 
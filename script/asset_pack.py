@@ -0,0 +1,238 @@
+"""
+Build the asset pack (src/asset_store.h) from the fonts and images in
+src/src, plus any data files given with --blob.
+
+Fonts are the lv_font_conv sources src/src/Font_*.c: their glyph
+descriptors go in as LVGL stores them (LV_FONT_FMT_TXT_LARGE 0), their
+bitmaps and cmap lists as they are, so the device only builds a small
+descriptor around the mapping. Kerning is not carried. Images are the
+1bpp conversions of script/img_1bpp.py: the icon atlas, one image per
+cell named icon_<ICON_* index> sharing its data, and the larger images
+as <name>_1bpp.
+
+The pack goes to one asset slot with esptool, or to the spare slot of a
+running device as an OTA patch (script/ota_diff.py --assets).
+
+Usage: python script/asset_pack.py -o assets.bin [--blob cjk16.tdf=fonts/cjk16.tdf ...]
+"""
+
+import argparse
+import glob
+import os
+import re
+import struct
+import sys
+import time
+import zlib
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import img_1bpp  # noqa: E402
+
+PROJECT_DIR = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+ASSET_DIR = os.path.join(PROJECT_DIR, "src", "src")
+
+MAGIC = 0x50414454          # "TDAP"
+VERSION = 1
+HEADER_FMT = "<IB3xIIII8x"
+ENTRY_FMT = "<24sB3xII"
+FONT_FMT = "<BBbbBBBBIIIII"
+CMAP_FMT = "<IHHIIHBx"
+IMAGE_FMT = "<BxHHxxII"
+NAME_MAX = 24
+ASSET_FONT, ASSET_IMAGE, ASSET_BLOB = 1, 2, 3
+IMG_1BPP_CF = 24            # LV_IMG_CF_USER_ENCODED_0
+CMAP_TYPES = {
+    "LV_FONT_FMT_TXT_CMAP_FORMAT0_FULL": 0,
+    "LV_FONT_FMT_TXT_CMAP_SPARSE_FULL": 1,
+    "LV_FONT_FMT_TXT_CMAP_FORMAT0_TINY": 2,
+    "LV_FONT_FMT_TXT_CMAP_SPARSE_TINY": 3,
+}
+# Offsets a partition of the default table starts at, for the esptool hint
+SLOT_OFFSETS = {"assets0": 0x8f0000, "assets1": 0x970000}
+
+COMMENT_RE = re.compile(r"/\*.*?\*/|//[^\n]*", re.S)
+ARRAY_RE = r"(?:uint8_t|uint16_t)\s+{}\[\]\s*=\s*\{{(.*?)\}};"
+GLYPH_RE = re.compile(r"\{\s*\.bitmap_index\s*=\s*(\d+),\s*\.adv_w\s*=\s*(\d+),\s*\.box_w\s*=\s*(\d+),"
+                      r"\s*\.box_h\s*=\s*(\d+),\s*\.ofs_x\s*=\s*(-?\d+),\s*\.ofs_y\s*=\s*(-?\d+)\s*\}")
+CMAP_RE = re.compile(r"\{\s*\.range_start\s*=\s*(\d+),\s*\.range_length\s*=\s*(\d+),\s*\.glyph_id_start\s*=\s*(\d+),"
+                     r"\s*\.unicode_list\s*=\s*(\w+),\s*\.glyph_id_ofs_list\s*=\s*(\w+),"
+                     r"\s*\.list_length\s*=\s*(\d+),\s*\.type\s*=\s*(\w+)\s*\}")
+
+
+def field(text, name):
+    match = re.search(r"\.%s\s*=\s*(-?\w+)" % name, text)
+    if not match:
+        raise ValueError("no .%s" % name)
+    return match.group(1)
+
+
+def numbers(body):
+    return [int(v, 0) for v in re.findall(r"-?0x[0-9a-fA-F]+|-?\d+", body)]
+
+
+def named_array(text, name):
+    match = re.search(ARRAY_RE.format(re.escape(name)), text, re.S)
+    if not match:
+        raise ValueError("no array %s" % name)
+    width = 2 if "uint16_t " + name in text else 1
+    return struct.pack("<%d%s" % (len(numbers(match.group(1))), "H" if width == 2 else "B"),
+                       *numbers(match.group(1)))
+
+
+def parse_font(path):
+    text = COMMENT_RE.sub("", open(path).read())
+    bitmap = bytes(numbers(re.search(r"glyph_bitmap\[\]\s*=\s*\{(.*?)\};", text, re.S).group(1)))
+    glyph_body = re.search(r"glyph_dsc\[\]\s*=\s*\{(.*?)\};", text, re.S).group(1)
+    glyphs = b"".join(struct.pack("<IBBbb", int(i) | int(adv) << 20, int(w), int(h), int(x), int(y))
+                      for i, adv, w, h, x, y in GLYPH_RE.findall(glyph_body))
+    dsc = re.search(r"lv_font_fmt_txt_dsc_t\s+font_dsc\s*=\s*\{(.*?)\};", text, re.S).group(1)
+    if field(dsc, "kern_dsc") != "NULL":
+        raise ValueError("kerning is not supported")
+    cmaps = []
+    for start, length, first, ulist, olist, count, kind in CMAP_RE.findall(text):
+        cmaps.append((int(start), int(length), int(first),
+                      None if ulist == "NULL" else named_array(text, ulist),
+                      None if olist == "NULL" else named_array(text, olist),
+                      int(count), CMAP_TYPES[kind]))
+    font = re.search(r"lv_font_t\s+\w+\s*=\s*\{(.*?)\};", text, re.S).group(1)
+    return {
+        "line_height": int(field(font, "line_height")),
+        "base_line": int(field(font, "base_line")),
+        "underline_position": int(field(font, "underline_position")),
+        "underline_thickness": int(field(font, "underline_thickness")),
+        "bpp": int(field(dsc, "bpp")),
+        "bitmap_format": int(field(dsc, "bitmap_format")),
+        "glyphs": glyphs,
+        "bitmap": bitmap,
+        "cmaps": cmaps,
+    }
+
+
+class Pack:
+    def __init__(self):
+        self.entries = []       # (name, type, offset, size)
+        self.data = bytearray()
+        self.fixups = []        # Positions of offsets into data
+
+    def align(self):
+        self.data += bytes(-len(self.data) % 4)
+
+    def put(self, blob):
+        # Offsets are fixed up once the entry table's size is known
+        self.align()
+        offset = len(self.data)
+        self.data += blob
+        return offset
+
+    def add(self, name, kind, build):
+        if len(name) >= NAME_MAX:
+            sys.exit("asset name too long: %s" % name)
+        self.align()
+        start = len(self.data)
+        build(self)
+        self.entries.append((name, kind, start, len(self.data) - start))
+
+    def finish(self, stamp):
+        base = struct.calcsize(HEADER_FMT) + struct.calcsize(ENTRY_FMT) * len(self.entries)
+        base += -base % 4
+        body = bytearray()
+        for name, kind, offset, size in self.entries:
+            body += struct.pack(ENTRY_FMT, name.encode(), kind, base + offset, size)
+        body += bytes(base - struct.calcsize(HEADER_FMT) - len(body))
+        body += relocate(self.data, self.fixups, base)
+        size = struct.calcsize(HEADER_FMT) + len(body)
+        return struct.pack(HEADER_FMT, MAGIC, VERSION, size, zlib.crc32(body) & 0xffffffff,
+                           len(self.entries), stamp) + bytes(body)
+
+
+def relocate(data, fixups, base):
+    # Records are written with offsets relative to the data area
+    out = bytearray(data)
+    for pos in fixups:
+        struct.pack_into("<I", out, pos, struct.unpack_from("<I", out, pos)[0] + base)
+    return out
+
+
+def add_font(pack, name, font):
+    def build(p):
+        record = len(p.data)
+        p.data += bytes(struct.calcsize(FONT_FMT))
+        glyph_dsc = p.put(font["glyphs"])
+        glyph_bitmap = p.put(font["bitmap"])
+        lists = []
+        for cmap in font["cmaps"]:
+            lists.append([None if blob is None else p.put(blob) for blob in cmap[3:5]])
+        cmaps = p.put(b"")
+        for (start, length, first, _, _, count, kind), (ulist, olist) in zip(font["cmaps"], lists):
+            # A missing list stays 0
+            p.fixups += [len(p.data) + pos for pos, at in ((8, ulist), (12, olist)) if at is not None]
+            p.data += struct.pack(CMAP_FMT, start, length, first, ulist or 0, olist or 0, count, kind)
+        struct.pack_into(FONT_FMT, p.data, record, font["line_height"], font["base_line"],
+                         font["underline_position"], font["underline_thickness"], font["bpp"],
+                         font["bitmap_format"], len(font["cmaps"]), 0, len(font["glyphs"]) // 8,
+                         glyph_dsc, glyph_bitmap, len(font["bitmap"]), cmaps)
+        p.fixups += [record + 12, record + 16, record + 24]
+    pack.add(name, ASSET_FONT, build)
+
+
+def add_image(pack, name, width, height, data_offset, data_size):
+    def build(p):
+        p.fixups.append(len(p.data) + 12)
+        p.data += struct.pack(IMAGE_FMT, IMG_1BPP_CF, width, height, data_size, data_offset)
+    pack.add(name, ASSET_IMAGE, build)
+
+
+def add_images(pack):
+    cell = img_1bpp.icon_size()
+    sources = sorted(p for p in glob.glob(os.path.join(ASSET_DIR, "img_*.c")) if p != img_1bpp.OUTPUT)
+    converted = [img for img in (img_1bpp.convert(p) for p in sources) if img]
+    icons = [img for img in converted if img[1] <= cell and img[2] <= cell]
+    images = [img for img in converted if img not in icons]
+
+    # Same order as icon_atlas.h, so icon_<n> is ICON_* n
+    cell_bytes = cell // 8 * cell
+    atlas = pack.put(b"".join(img_1bpp.place(icon, cell) for icon in icons))
+    add_image(pack, "img_icon_atlas_1bpp", cell, cell * len(icons), atlas, cell_bytes * len(icons))
+    for i in range(len(icons)):
+        add_image(pack, "icon_%d" % i, cell, cell, atlas + i * cell_bytes, cell_bytes)
+    for name, width, height, bits in images:
+        add_image(pack, name + "_1bpp", width, height, pack.put(bits), len(bits))
+    return len(icons), len(images)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0].strip())
+    parser.add_argument("-o", "--output", required=True, help="pack file")
+    parser.add_argument("--blob", action="append", default=[], metavar="NAME=PATH",
+                        help="add a file as a blob, e.g. cjk16.tdf=fonts/cjk16.tdf")
+    parser.add_argument("--size", type=lambda v: int(v, 0), default=0x80000, help="asset slot size")
+    args = parser.parse_args()
+
+    pack = Pack()
+    fonts = sorted(glob.glob(os.path.join(ASSET_DIR, "Font_*.c")))
+    for path in fonts:
+        try:
+            add_font(pack, os.path.splitext(os.path.basename(path))[0], parse_font(path))
+        except (ValueError, AttributeError, KeyError) as e:
+            sys.exit("%s: %s" % (os.path.relpath(path, PROJECT_DIR), e))
+    icons, images = add_images(pack)
+    for spec in args.blob:
+        name, _, path = spec.partition("=")
+        if not path:
+            sys.exit("--blob wants NAME=PATH")
+        with open(path, "rb") as f:
+            data = f.read()
+        pack.add(name, ASSET_BLOB, lambda p, data=data: p.data.extend(data))
+
+    out = pack.finish(int(os.environ.get("SOURCE_DATE_EPOCH", time.time())))
+    if len(out) > args.size:
+        sys.exit("pack is %d bytes, the slot only %d" % (len(out), args.size))
+    with open(args.output, "wb") as f:
+        f.write(out)
+    print("%s: %d bytes, %d fonts, %d icons, %d images, %d blobs (%.0f%% of a slot)" % (
+        args.output, len(out), len(fonts), icons, images, len(args.blob), 100.0 * len(out) / args.size))
+    print("  esptool.py write_flash 0x%x %s" % (SLOT_OFFSETS["assets0"], args.output))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,267 @@
+"""
+Host side of the framed USB console (src/usb_console.h).
+
+Frames are COBS coded and end in 0x00: channel byte, payload, CRC-16/X-25
+of both. The tool says hello with the channels it wants and repeats it while
+it runs; the firmware falls back to its text log once it stops. Log records
+are decoded with script/log_decode.py and metrics snapshots against the
+lists in src/metrics.h, so no tables are generated on either side. Use the
+sources of the build on the device.
+
+Usage: python script/console.py PORT monitor [--metrics]
+       python script/console.py PORT rpc tasks
+       python script/console.py PORT gps [--tcp 2947]
+       python script/console.py PORT modem
+"""
+
+import argparse
+import os
+import re
+import select
+import socket
+import struct
+import sys
+import threading
+import time
+
+import serial
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import log_decode  # noqa: E402
+
+PROJECT_DIR = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+CH_CTRL, CH_RPC, CH_LOG, CH_METRICS, CH_GPS, CH_MODEM, CH_MIRROR = range(7)
+RPC_OK, RPC_MORE, RPC_UNKNOWN = range(3)
+HELLO_EVERY_S = 2.0         # Under USB_CONSOLE_IDLE_MS
+
+
+def crc16_x25(data):
+    crc = 0xFFFF
+    for b in data:
+        crc ^= b
+        for _ in range(8):
+            crc = (crc >> 1) ^ 0x8408 if crc & 1 else crc >> 1
+    return crc ^ 0xFFFF
+
+
+def cobs_encode(data):
+    out = bytearray([0])
+    code_at = 0
+    for b in data:
+        if b:
+            out.append(b)
+        if not b or len(out) - code_at == 0xFF:
+            out[code_at] = len(out) - code_at
+            code_at = len(out)
+            out.append(0)
+    out[code_at] = len(out) - code_at
+    return bytes(out)
+
+
+def cobs_decode(data):
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        if not code or i + code > len(data):
+            return None
+        out += data[i + 1:i + code]
+        i += code
+        if code < 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+class Console:
+    def __init__(self, port, channels):
+        self.port = serial.Serial(port, 115200, timeout=0.1)
+        self.mask = (1 << CH_CTRL) | (1 << CH_RPC)
+        for ch in channels:
+            self.mask |= 1 << ch
+        self.lock = threading.Lock()
+        self.rx = bytearray()
+        self.rejected = 0
+        self.next_hello = 0
+
+    def send(self, channel, payload):
+        body = bytes([channel]) + payload
+        frame = b"\0" + cobs_encode(body + struct.pack("<H", crc16_x25(body))) + b"\0"
+        with self.lock:
+            self.port.write(frame)
+
+    def hello(self):
+        if time.monotonic() >= self.next_hello:
+            self.send(CH_CTRL, b"H" + struct.pack("<H", self.mask))
+            self.next_hello = time.monotonic() + HELLO_EVERY_S
+
+    def bye(self):
+        self.send(CH_CTRL, b"B")
+
+    def frames(self):
+        """Yields (channel, payload) as they arrive, keeping the hello going."""
+        while True:
+            self.hello()
+            self.rx += self.port.read(self.port.in_waiting or 1)
+            while True:
+                end = self.rx.find(b"\0")
+                if end < 0:
+                    break
+                raw, self.rx = bytes(self.rx[:end]), self.rx[end + 1:]
+                if not raw:
+                    continue
+                body = cobs_decode(raw)
+                # Plain text on the port decodes as garbage and fails here
+                if not body or len(body) < 3 or crc16_x25(body[:-2]) != struct.unpack("<H", body[-2:])[0]:
+                    self.rejected += 1
+                    continue
+                yield body[0], body[1:-2]
+
+
+def load_metrics_layout(src_dir):
+    """Counter, gauge and histogram names in declaration order, and the bucket count."""
+    with open(os.path.join(src_dir, "metrics.h"), encoding="utf-8") as f:
+        text = f.read()
+    lists = {}
+    for kind in ("COUNTERS", "GAUGES", "HISTOGRAMS"):
+        m = re.search(r"#define METRICS_%s\(X\)(.*?)\n\n" % kind, text, re.S)
+        lists[kind] = re.findall(r'X\(\w+,\s*"([^"]+)"\)', m.group(1))
+    buckets = int(re.search(r"#define METRICS_HIST_BUCKETS\s+(\d+)", text).group(1))
+    return lists, buckets
+
+
+def decode_metrics(payload, layout):
+    lists, buckets = layout
+    values = struct.unpack_from("<I", payload, 0)
+    off = 4
+    out = ["ms=%d" % values[0]]
+    for name in lists["COUNTERS"]:
+        out.append("%s=%d" % (name, struct.unpack_from("<I", payload, off)[0]))
+        off += 4
+    for name in lists["GAUGES"]:
+        out.append("%s=%d" % (name, struct.unpack_from("<i", payload, off)[0]))
+        off += 4
+    for name in lists["HISTOGRAMS"]:
+        count = struct.unpack_from("<I", payload, off)[0]
+        hmax = struct.unpack_from("<I", payload, off + 4 + 4 * buckets)[0]
+        out.append("%s=%d/max%d" % (name, count, hmax))
+        off += 4 + 4 * buckets + 4
+    return " ".join(out)
+
+
+def run_monitor(con, args):
+    dictionary = log_decode.build_dictionary(args.src)
+    layout = load_metrics_layout(args.src)
+    for channel, payload in con.frames():
+        if channel == CH_LOG:
+            log_decode.decode(payload, dictionary, sys.stdout)
+        elif channel == CH_METRICS:
+            print("[metrics] " + decode_metrics(payload, layout))
+        elif channel == CH_CTRL and payload[:1] == b"H":
+            print("--- console v%d, %d channels, frames up to %d bytes ---" %
+                  (payload[1], payload[2], struct.unpack_from("<H", payload, 3)[0]))
+        sys.stdout.flush()
+
+
+def run_rpc(con, args):
+    con.send(CH_RPC, bytes([1]) + " ".join(args.command).encode())
+    deadline = time.monotonic() + args.timeout
+    for channel, payload in con.frames():
+        if time.monotonic() > deadline:
+            sys.exit("console: no answer")
+        if channel != CH_RPC or len(payload) < 2 or payload[0] != 1:
+            continue
+        sys.stdout.write(payload[2:].decode("utf-8", errors="replace"))
+        if payload[1] == RPC_UNKNOWN:
+            sys.exit("console: unknown command, try 'help'")
+        if payload[1] != RPC_MORE:
+            return
+
+
+def run_gps(con, args):
+    peer = None
+    server = None
+    if args.tcp:
+        server = socket.socket()
+        server.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+        server.bind(("127.0.0.1", args.tcp))
+        server.listen(1)
+        print("console: GPS on tcp://127.0.0.1:%d" % args.tcp, file=sys.stderr)
+
+    def pump():
+        nonlocal peer
+        while True:
+            ready = [server] + ([peer] if peer else []) if server else [sys.stdin]
+            readable, _, _ = select.select(ready, [], [])
+            for r in readable:
+                if r is server:
+                    peer, _ = server.accept()
+                    continue
+                data = r.recv(256) if r is peer else os.read(sys.stdin.fileno(), 256)
+                if not data:
+                    if r is peer:
+                        peer = None
+                        continue
+                    return
+                con.send(CH_GPS, data)
+
+    threading.Thread(target=pump, daemon=True).start()
+    for channel, payload in con.frames():
+        if channel != CH_GPS:
+            continue
+        if server:
+            if peer:
+                peer.sendall(payload)
+        else:
+            sys.stdout.buffer.write(payload)
+            sys.stdout.buffer.flush()
+
+
+def run_modem(con, args):
+    def pump():
+        for line in sys.stdin:
+            line = line.strip()
+            if line:
+                con.send(CH_MODEM, line.encode())
+
+    threading.Thread(target=pump, daemon=True).start()
+    for channel, payload in con.frames():
+        if channel == CH_MODEM:
+            print(payload.decode("utf-8", errors="replace"))
+            sys.stdout.flush()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("port", help="serial port, e.g. /dev/ttyACM0")
+    parser.add_argument("--src", default=os.path.join(PROJECT_DIR, "src"), help="source tree of the firmware on the device")
+    sub = parser.add_subparsers(dest="mode", required=True)
+    p = sub.add_parser("monitor", help="decoded log, optionally metrics")
+    p.add_argument("--metrics", action="store_true", help="also the periodic metrics snapshots")
+    p = sub.add_parser("rpc", help="run a command and print its answer")
+    p.add_argument("command", nargs="+")
+    p.add_argument("--timeout", type=float, default=5.0)
+    p = sub.add_parser("gps", help="raw receiver stream, e.g. for u-center")
+    p.add_argument("--tcp", type=int, help="serve it on this local TCP port instead of stdio")
+    sub.add_parser("modem", help="AT commands from stdin, every modem line out")
+    args = parser.parse_args()
+
+    channels = {
+        "monitor": [CH_LOG] + ([CH_METRICS] if getattr(args, "metrics", False) else []),
+        "rpc": [],
+        "gps": [CH_GPS],
+        "modem": [CH_MODEM],
+    }[args.mode]
+    con = Console(args.port, channels)
+    try:
+        {"monitor": run_monitor, "rpc": run_rpc, "gps": run_gps, "modem": run_modem}[args.mode](con, args)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        con.bye()
+        if con.rejected:
+            sys.stderr.write("console: %d frames failed their check\n" % con.rejected)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,139 @@
+"""
+Turn the CPU profiler's serial report (cpu_profiler_print() in
+src/cpu_profiler.cpp) into a flat profile by function.
+
+The report lists raw sampled PCs; they are resolved here with addr2line
+against the firmware.elf of the build that produced them. With several
+reports in the log the last complete one is used, or all of them summed
+with --all.
+
+Usage: python script/cpu_prof.py monitor.log [--elf PATH] [--env NAME] [--all] [--top N]
+       pio device monitor | tee monitor.log
+"""
+
+import argparse
+import glob
+import os
+import re
+import shutil
+import subprocess
+import sys
+from collections import defaultdict
+
+PROJECT_DIR = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+DEFAULT_ENV = "T-Deck-Pro-Integrated"
+ADDR2LINE = "xtensa-esp32s3-elf-addr2line"
+
+FIELD_RE = re.compile(r"(\w+)=(\S+)")
+
+
+def fields(line):
+    return dict(FIELD_RE.findall(line))
+
+
+def parse_reports(lines):
+    """Yields (header, tasks, pcs) per complete CPU_PROF ... CPU_PROF_END block."""
+    report = None
+    for line in lines:
+        line = line.strip()
+        start = line.find("CPU_")
+        if start < 0:
+            continue
+        line = line[start:]
+        if line.startswith("CPU_PROF_END"):
+            if report:
+                yield report
+            report = None
+        elif line.startswith("CPU_PROF "):
+            report = (fields(line), [], {})
+        elif report and line.startswith("CPU_TASK "):
+            report[1].append(fields(line))
+        elif report and line.startswith("CPU_PC "):
+            f = fields(line)
+            report[2][int(f["pc"], 16)] = int(f["n"])
+
+
+def find_addr2line(explicit):
+    if explicit:
+        return explicit
+    found = shutil.which(ADDR2LINE)
+    if found:
+        return found
+    pattern = os.path.expanduser("~/.platformio/packages/toolchain-xtensa-esp32s3/bin/" + ADDR2LINE)
+    matches = glob.glob(pattern)
+    return matches[0] if matches else None
+
+
+def symbolize(addr2line, elf, pcs):
+    """Maps each PC to (function, file:line); unresolved PCs keep their address."""
+    names = {pc: ("0x%08x" % pc, "??") for pc in pcs}
+    if not addr2line or not pcs:
+        return names
+    ordered = sorted(pcs)
+    out = subprocess.run([addr2line, "-f", "-C", "-e", elf] + ["0x%08x" % pc for pc in ordered],
+                         capture_output=True, text=True, check=True).stdout.splitlines()
+    for i, pc in enumerate(ordered):
+        if 2 * i + 1 < len(out) and out[2 * i] != "??":
+            names[pc] = (out[2 * i], os.path.relpath(out[2 * i + 1], PROJECT_DIR) if out[2 * i + 1].startswith("/") else out[2 * i + 1])
+    return names
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0].strip())
+    parser.add_argument("log", nargs="?", help="serial log, stdin when omitted")
+    parser.add_argument("--elf", help="firmware.elf (default .pio/build/ENV/firmware.elf)")
+    parser.add_argument("--env", default=DEFAULT_ENV, help="PlatformIO env the firmware was built with")
+    parser.add_argument("--addr2line", help="addr2line binary for the ESP32-S3 toolchain")
+    parser.add_argument("--all", action="store_true", help="sum every report in the log")
+    parser.add_argument("--top", type=int, default=30, help="functions to list")
+    args = parser.parse_args()
+
+    with (open(args.log, errors="replace") if args.log else sys.stdin) as f:
+        reports = list(parse_reports(f))
+    if not reports:
+        sys.exit("No complete CPU_PROF report in the log")
+    if not args.all:
+        reports = reports[-1:]
+
+    pcs = defaultdict(int)
+    tasks = defaultdict(lambda: [0, 0])
+    samples = [0, 0]
+    for header, task_rows, pc_rows in reports:
+        core = [int(n) for n in header.get("samples", "0,0").split(",")]
+        samples = [samples[0] + core[0], samples[1] + core[1]]
+        for t in task_rows:
+            tasks[t["name"]][0] += int(t["core0"])
+            tasks[t["name"]][1] += int(t["core1"])
+        for pc, n in pc_rows.items():
+            pcs[pc] += n
+
+    print("Tasks, share of each core (%d + %d samples)" % (samples[0], samples[1]))
+    print("%-16s %8s %8s" % ("task", "core0", "core1"))
+    for name, (c0, c1) in sorted(tasks.items(), key=lambda kv: -(kv[1][0] + kv[1][1])):
+        print("%-16s %7.1f%% %7.1f%%" % (name, 100.0 * c0 / max(samples[0], 1), 100.0 * c1 / max(samples[1], 1)))
+
+    elf = args.elf or os.path.join(PROJECT_DIR, ".pio", "build", args.env, "firmware.elf")
+    addr2line = find_addr2line(args.addr2line)
+    if not os.path.exists(elf) or not addr2line:
+        print("\nNo %s; PCs are left unresolved" % ("addr2line" if os.path.exists(elf) else elf), file=sys.stderr)
+        addr2line = None
+    names = symbolize(addr2line, elf, list(pcs))
+
+    functions = defaultdict(int)
+    where = {}
+    for pc, n in pcs.items():
+        function, location = names[pc]
+        functions[function] += n
+        where.setdefault(function, location.split(" ")[0])
+    total = sum(functions.values())
+
+    print("\nFlat profile, %d sampled PCs" % total)
+    print("%7s %7s %8s  %s" % ("self%", "cum%", "samples", "function"))
+    cumulative = 0
+    for function, n in sorted(functions.items(), key=lambda kv: -kv[1])[:args.top]:
+        cumulative += n
+        print("%6.1f%% %6.1f%% %8d  %s  %s" % (100.0 * n / total, 100.0 * cumulative / total, n, function, where[function]))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,149 @@
+"""
+Put a crash upload (src/crash_dump.h) back together: core.bin for
+espcoredump.py and the RTC context, printed as the last trace events and
+the metrics at the time of the panic.
+
+The messages are read as hex, one per line, the way mosquitto_sub prints
+them with -F %x. Offsets in the 'D' messages order them, so a QoS 1
+redelivery or a reordered log does no harm; a gap is an error.
+
+Usage: python script/crash_unpack.py crash.hex [-o DIR]
+       mosquitto_sub -h BROKER -t 'tdeckpro/<id>/crash' -F %x > crash.hex
+       pip install heatshrink2
+       espcoredump.py info_corefile -t raw -c DIR/core.bin .pio/build/<env>/firmware.elf
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+import zlib
+
+PROJECT_DIR = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+MAGIC = 0x52434454          # "TDCR"
+VERSION = 1
+HEADER_FMT = "<IBBBBII32s"
+TRACE_EVENTS = 32
+TRACE_FMT = "<IHBBI"
+TRACE_TAGS = ["boot", "event", "watch", "user"]
+WATCH_ALERTS = ["overrun", "starved", "stack"]
+
+
+def metric_names(kind):
+    """Names in declaration order from a METRICS_<kind>(X) list in src/metrics.h."""
+    with open(os.path.join(PROJECT_DIR, "src", "metrics.h")) as f:
+        text = f.read()
+    block = re.search(r"#define METRICS_%s\(X\)(.*?)(?:\n\n|\n#)" % kind, text, re.S)
+    return re.findall(r'X\(\w+,\s*"([^"]+)"\)', block.group(1)) if block else []
+
+
+def read_messages(path):
+    header = None
+    chunks = {}
+    end = None
+    with open(path) as f:
+        for line in f:
+            line = line.strip()
+            if not line:
+                continue
+            msg = bytes.fromhex(line)
+            kind = msg[:1]
+            if kind == b"H":
+                header = struct.unpack_from(HEADER_FMT, msg, 1)
+            elif kind == b"D":
+                chunks[struct.unpack_from("<I", msg, 1)[0]] = msg[5:]
+            elif kind == b"E":
+                end = struct.unpack_from("<II", msg, 1)
+    return header, chunks, end
+
+
+def join(chunks, length):
+    data = bytearray()
+    for offset in sorted(chunks):
+        if offset > len(data):
+            sys.exit("Missing bytes %d..%d" % (len(data), offset))
+        data += chunks[offset][len(data) - offset:]
+    if length is not None and len(data) < length:
+        sys.exit("Missing bytes %d..%d" % (len(data), length))
+    return bytes(data if length is None else data[:length])
+
+
+def print_context(ctx):
+    magic, size, panicked, _, trace_next = struct.unpack_from("<IHBBI", ctx, 0)
+    if magic != MAGIC:
+        print("No context: the reset left nothing in RTC memory")
+        return
+    print("Context, %d trace events%s" % (min(trace_next, TRACE_EVENTS), ", panic hook ran" if panicked else ""))
+    pos = struct.calcsize("<IHBBI")
+    trace = [struct.unpack_from(TRACE_FMT, ctx, pos + i * struct.calcsize(TRACE_FMT)) for i in range(TRACE_EVENTS)]
+    pos += TRACE_EVENTS * struct.calcsize(TRACE_FMT)
+
+    first = trace_next - min(trace_next, TRACE_EVENTS)
+    for n in range(first, trace_next):
+        ms, tag, core, _, value = trace[n % TRACE_EVENTS]
+        name = TRACE_TAGS[tag] if tag < len(TRACE_TAGS) else str(tag)
+        if name == "event":
+            detail = "type=%d source=%d" % (value >> 16, value & 0xffff)
+        elif name == "watch":
+            alert = value >> 24
+            detail = "%s value=%d" % (WATCH_ALERTS[alert] if alert < len(WATCH_ALERTS) else alert, value & 0xffffff)
+        else:
+            detail = "value=%d" % value
+        print("  %10d ms  core%d  %-6s %s" % (ms, core, name, detail))
+
+    if not panicked:
+        return
+    counters = metric_names("COUNTERS")
+    gauges = metric_names("GAUGES")
+    if pos + 4 * (len(counters) + len(gauges)) != len(ctx):
+        print("Metrics lists in src/metrics.h differ from the build that crashed; not decoded")
+        return
+    print("Metrics at the panic")
+    for name in counters:
+        print("  %-24s %d" % (name, struct.unpack_from("<I", ctx, pos)[0]))
+        pos += 4
+    for name in gauges:
+        print("  %-24s %d" % (name, struct.unpack_from("<i", ctx, pos)[0]))
+        pos += 4
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    parser.add_argument("input", help="hex messages, one per line")
+    parser.add_argument("-o", "--out", default=".", help="directory for core.bin and context.bin")
+    args = parser.parse_args()
+
+    header, chunks, end = read_messages(args.input)
+    if not header:
+        sys.exit("No 'H' message")
+    magic, version, reason, window, lookahead, context_size, core_size, sha = header
+    if magic != MAGIC or version != VERSION:
+        sys.exit("Not a version %d crash upload" % VERSION)
+    if not end:
+        print("No 'E' message: the upload did not finish, decoding what is there", file=sys.stderr)
+
+    packed = join(chunks, end[0] if end else None)
+    if end and zlib.crc32(packed) != end[1]:
+        sys.exit("CRC mismatch")
+
+    import heatshrink2
+    data = heatshrink2.decompress(packed, window_sz2=window, lookahead_sz2=lookahead)
+    print("Reset reason %d, running build %s" % (reason, sha.hex()))
+
+    os.makedirs(args.out, exist_ok=True)
+    context = data[:context_size]
+    with open(os.path.join(args.out, "context.bin"), "wb") as f:
+        f.write(context)
+    if len(context) == context_size:
+        print_context(context)
+
+    core = data[context_size:context_size + core_size]
+    if core_size:
+        with open(os.path.join(args.out, "core.bin"), "wb") as f:
+            f.write(core)
+        print("core.bin, %d of %d bytes" % (len(core), core_size))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,149 @@
+"""
+Build the word-completion dictionary (src/predict.h) as an asset pack blob.
+
+Words come from a list of "word count" lines (--words), or are counted in
+script/lora_corpus.txt. Each gets a rank from 1 to 15, the log of its
+count scaled to the most frequent word, and goes into a trie over
+lowercase letters and the apostrophe. Identical subtrees, same letters
+and same ranks below, are stored once, which turns the trie into a DAWG:
+the shared endings (-ing, -ed, -tion) cost one copy.
+
+Blob layout, little-endian:
+    header  magic "TDWD", version, longest word, 2 reserved, nodes, words
+    node    flags (bit 7 word ends here, bits 0-5 edges), rank (0 if not
+            a word), then per edge: letter, best rank below, 24-bit node
+            offset from the start of the blob
+The root follows the header. Edges are in letter order, and carry the
+best rank of their subtree so the device skips subtrees that cannot make
+the top candidates without reading them.
+
+Usage: python script/dict_pack.py -o words.tdd [--words wordlist.txt]
+       python script/asset_pack.py -o assets.bin --blob words.tdd=words.tdd
+"""
+
+import argparse
+import math
+import os
+import re
+import struct
+import sys
+
+PROJECT_DIR = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+CORPUS = os.path.join(PROJECT_DIR, "script", "lora_corpus.txt")
+
+MAGIC = 0x44574454          # "TDWD"
+VERSION = 1
+HEADER_FMT = "<IBBHII"
+WORD_MIN = 2                # Single letters are not worth completing
+WORD_MAX = 23               # PREDICT_WORD_MAX - 1
+RANK_MAX = 15
+EDGES_MAX = 32              # PREDICT_EDGES_MAX
+OFFSET_MAX = 1 << 24
+WORD_RE = re.compile(r"[a-z']+")
+
+
+def load_counts(path):
+    counts = {}
+    if path:
+        with open(path, encoding="utf-8") as f:
+            for line in f:
+                parts = line.split()
+                if not parts or parts[0].startswith("#"):
+                    continue
+                word = parts[0].lower()
+                counts[word] = counts.get(word, 0) + (int(parts[1]) if len(parts) > 1 else 1)
+    else:
+        with open(CORPUS, encoding="utf-8") as f:
+            for line in f:
+                if line.startswith("#"):
+                    continue
+                for word in WORD_RE.findall(line.lower()):
+                    counts[word] = counts.get(word, 0) + 1
+    return {w: c for w, c in counts.items()
+            if WORD_MIN <= len(w) <= WORD_MAX and WORD_RE.fullmatch(w) and c > 0}
+
+
+def ranks(counts):
+    top = math.log(max(counts.values()) + 1)
+    return {w: 1 + int((RANK_MAX - 1) * math.log(c + 1) / top) for w, c in counts.items()}
+
+
+class Node:
+    __slots__ = ("rank", "edges", "best")
+
+    def __init__(self):
+        self.rank = 0
+        self.edges = {}
+        self.best = 0
+
+
+def build(word_ranks):
+    root = Node()
+    for word, rank in word_ranks.items():
+        node = root
+        for ch in word:
+            node = node.edges.setdefault(ch, Node())
+        node.rank = rank
+    return root
+
+
+def minimize(root):
+    """Replace each subtree by the first identical one seen; returns unique nodes, root first."""
+    registry = {}
+    unique = []
+
+    def visit(node):
+        for ch in node.edges:
+            node.edges[ch] = visit(node.edges[ch])
+        node.best = max([node.rank] + [c.best for c in node.edges.values()])
+        key = (node.rank, tuple((ch, id(c)) for ch, c in sorted(node.edges.items())))
+        if key not in registry:
+            registry[key] = node
+            unique.append(node)
+        return registry[key]
+
+    root = visit(root)
+    unique.remove(root)
+    return [root] + unique
+
+
+def serialize(nodes, longest, words):
+    offsets = {}
+    pos = struct.calcsize(HEADER_FMT)
+    for node in nodes:
+        if len(node.edges) > EDGES_MAX:
+            sys.exit("a node has %d edges, at most %d" % (len(node.edges), EDGES_MAX))
+        offsets[id(node)] = pos
+        pos += 2 + 5 * len(node.edges)
+    if pos > OFFSET_MAX:
+        sys.exit("dictionary is %d bytes, offsets reach %d" % (pos, OFFSET_MAX))
+
+    out = bytearray(struct.pack(HEADER_FMT, MAGIC, VERSION, longest, 0, len(nodes), words))
+    for node in nodes:
+        out += struct.pack("<BB", (0x80 if node.rank else 0) | len(node.edges), node.rank)
+        for ch, child in sorted(node.edges.items()):
+            out += struct.pack("<BB", ord(ch), child.best) + offsets[id(child)].to_bytes(3, "little")
+    return bytes(out)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0].strip())
+    parser.add_argument("-o", "--output", required=True, help="blob file")
+    parser.add_argument("--words", help='"word count" per line; default: counted in the LoRa corpus')
+    args = parser.parse_args()
+
+    counts = load_counts(args.words)
+    if not counts:
+        sys.exit("no words")
+    word_ranks = ranks(counts)
+    nodes = minimize(build(word_ranks))
+    out = serialize(nodes, max(len(w) for w in word_ranks), len(word_ranks))
+    with open(args.output, "wb") as f:
+        f.write(out)
+    trie_chars = sum(len(w) for w in word_ranks)
+    print("%s: %d words, %d nodes (%d letters in the plain words), %d bytes, %.1f bytes per word" % (
+        args.output, len(word_ranks), len(nodes), trie_chars, len(out), len(out) / len(word_ranks)))
+
+
+if __name__ == "__main__":
+    main()
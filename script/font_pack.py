@@ -0,0 +1,129 @@
+"""
+Pack a BDF bitmap font into the paged font format of src/font_pager.h,
+for the CJK glyphs the firmware does not carry.
+
+Only Basic Multilingual Plane codepoints are kept, and with --range only
+those in the given ranges (the default is the CJK blocks and full-width
+punctuation). Bitmaps are 1bpp, cropped to the glyph's box and packed
+without row padding. Identical bitmaps are stored once.
+
+Put the output on the SD card as /fonts/cjk16.tdf, or write it to a
+"fonts" data partition (subtype 0x41) with esptool write_flash.
+
+Usage: python script/font_pack.py wenquanyi_12pt.bdf -o cjk16.tdf [--range 4E00-9FFF ...]
+"""
+
+import argparse
+import struct
+import sys
+
+MAGIC = 0x50464454          # "TDFP"
+VERSION = 1
+HEADER_FMT = "<IBBBBIIIB11x"
+GLYPH_FMT = "<HBBBbbxI"
+DEFAULT_RANGES = ["3000-303F", "3400-4DBF", "4E00-9FFF", "FF00-FFEF"]
+
+
+def parse_ranges(ranges):
+    out = []
+    for r in ranges:
+        lo, _, hi = r.partition("-")
+        out.append((int(lo, 16), int(hi or lo, 16)))
+    return out
+
+
+def read_bdf(path):
+    """(codepoint, adv_w, box_w, box_h, ofs_x, ofs_y, rows) per glyph, ascent, descent, pixel size."""
+    glyphs = []
+    ascent = descent = 0
+    size = 0
+    with open(path, encoding="latin-1") as f:
+        lines = iter(f.read().splitlines())
+    for line in lines:
+        key, _, rest = line.partition(" ")
+        if key == "FONT_ASCENT":
+            ascent = int(rest)
+        elif key == "FONT_DESCENT":
+            descent = int(rest)
+        elif key == "PIXEL_SIZE":
+            size = int(rest)
+        elif key == "STARTCHAR":
+            cp = adv = None
+            bbx = (0, 0, 0, 0)
+            for line in lines:
+                key, _, rest = line.partition(" ")
+                if key == "ENCODING":
+                    cp = int(rest.split()[0])
+                elif key == "DWIDTH":
+                    adv = int(rest.split()[0])
+                elif key == "BBX":
+                    bbx = tuple(int(v) for v in rest.split())
+                elif key == "BITMAP":
+                    rows = []
+                    for line in lines:
+                        if line.startswith("ENDCHAR"):
+                            break
+                        rows.append(int(line, 16) if line else 0)
+                    w, h, x, y = bbx
+                    row_bits = ((w + 7) // 8) * 8
+                    # Rows are left aligned to whole bytes
+                    glyphs.append((cp, adv if adv is not None else w, w, h, x, y,
+                                   [r >> (row_bits - w) for r in rows]))
+                    break
+    return glyphs, ascent, descent, size or ascent + descent
+
+
+def pack_bitmap(w, h, rows):
+    bits = 0
+    n = 0
+    out = bytearray()
+    for row in rows[:h]:
+        for x in range(w):
+            bits = (bits << 1) | ((row >> (w - 1 - x)) & 1)
+            n += 1
+            if n == 8:
+                out.append(bits)
+                bits = n = 0
+    if n:
+        out.append(bits << (8 - n))
+    return bytes(out)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    parser.add_argument("bdf")
+    parser.add_argument("-o", "--out", required=True)
+    parser.add_argument("--range", action="append", help="codepoint range in hex, e.g. 4E00-9FFF")
+    args = parser.parse_args()
+
+    ranges = parse_ranges(args.range or DEFAULT_RANGES)
+    glyphs, ascent, descent, size = read_bdf(args.bdf)
+    glyphs = sorted((g for g in glyphs if g[0] is not None and g[0] <= 0xFFFF
+                     and any(lo <= g[0] <= hi for lo, hi in ranges)), key=lambda g: g[0])
+    if not glyphs:
+        sys.exit("No glyphs in range")
+
+    index = bytearray()
+    bitmaps = bytearray()
+    seen = {}
+    for cp, adv, w, h, x, y, rows in glyphs:
+        if w > 255 or h > 255 or adv > 255:
+            sys.exit("U+%04X too large" % cp)
+        bitmap = pack_bitmap(w, h, rows)
+        offset = seen.get(bitmap)
+        if offset is None:
+            offset = seen[bitmap] = len(bitmaps)
+            bitmaps += bitmap
+        index += struct.pack(GLYPH_FMT, cp, adv, w, h, x, y, offset)
+
+    header_size = struct.calcsize(HEADER_FMT)
+    # LVGL's base_line is measured up from the bottom of the line
+    header = struct.pack(HEADER_FMT, MAGIC, VERSION, 1, ascent + descent, descent, len(glyphs),
+                         header_size, header_size + len(index), size)
+    with open(args.out, "wb") as f:
+        f.write(header + index + bitmaps)
+    print("%d glyphs, %d bytes index, %d bytes bitmaps" % (len(glyphs), len(index), len(bitmaps)))
+
+
+if __name__ == "__main__":
+    main()
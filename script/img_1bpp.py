@@ -0,0 +1,212 @@
+"""
+Convert the LVGL image sources in src/src/img_*.c into byte-aligned 1bpp
+bitmaps in src/src/img_1bpp.c.
+
+Images that fit in APP_ICON_SIZE (src/config/os_config.h) are centred in
+square cells of that size and stacked into one atlas, img_icon_atlas_1bpp,
+with a descriptor per cell in img_icons_1bpp[] and their indexes in the
+generated src/src/icon_atlas.h. Larger images get a bitmap of their own.
+
+Rows are MSB-first with a set bit meaning white, the same layout as the
+LVGL framebuffer and the GDEQ031T10 RAM, so img_1bpp_decoder only has to
+expand bits to lv_color_t. Transparent pixels are composited over white.
+
+Runs as a PlatformIO pre-build script (extra_scripts = pre:script/img_1bpp.py)
+and regenerates only when an img_*.c is newer than the output. It can also
+be run directly: python script/img_1bpp.py
+"""
+
+import glob
+import os
+import re
+
+try:
+    Import("env")  # noqa: F821 - provided by PlatformIO
+    PROJECT_DIR = env.subst("$PROJECT_DIR")  # noqa: F821
+    RUN_BY_PLATFORMIO = True
+except NameError:
+    PROJECT_DIR = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+    RUN_BY_PLATFORMIO = False
+
+SCRIPT = os.path.join(PROJECT_DIR, "script", "img_1bpp.py")
+ASSET_DIR = os.path.join(PROJECT_DIR, "src", "src")
+OUTPUT = os.path.join(ASSET_DIR, "img_1bpp.c")
+ATLAS_HEADER = os.path.join(ASSET_DIR, "icon_atlas.h")
+OS_CONFIG = os.path.join(PROJECT_DIR, "src", "config", "os_config.h")
+
+MAP_RE = re.compile(r"uint8_t\s+(\w+)_map\[\]\s*=\s*\{(.*?)\n\};", re.S)
+DEPTH8_RE = re.compile(r"#if LV_COLOR_DEPTH == 1 \|\| LV_COLOR_DEPTH == 8(.*?)#endif", re.S)
+HEX_RE = re.compile(r"0x([0-9a-fA-F]{2})")
+FIELD_RE = r"\.header\.{}\s*=\s*(\d+)"
+
+
+def luminance_332(color):
+    # RGB332 as stored by the LVGL converter for 8-bit colour
+    r = (color >> 5) & 0x07
+    g = (color >> 2) & 0x07
+    b = color & 0x03
+    return (r * 255 // 7) * 0.299 + (g * 255 // 7) * 0.587 + (b * 255 // 3) * 0.114
+
+
+def convert(path):
+    text = open(path).read()
+    match = MAP_RE.search(text)
+    if not match or "LV_IMG_CF_TRUE_COLOR_ALPHA" not in text:
+        return None
+
+    name = match.group(1)
+    width = int(re.search(FIELD_RE.format("w"), text).group(1))
+    height = int(re.search(FIELD_RE.format("h"), text).group(1))
+    depth8 = DEPTH8_RE.search(match.group(2))
+    data = [int(v, 16) for v in HEX_RE.findall(depth8.group(1))]
+    if len(data) < width * height * 2:
+        return None
+
+    stride = (width + 7) // 8
+    out = bytearray(stride * height)
+    for y in range(height):
+        for x in range(width):
+            i = (y * width + x) * 2
+            color, alpha = data[i], data[i + 1]
+            # Composite over the white e-paper background
+            value = (luminance_332(color) * alpha + 255 * (255 - alpha)) / 255
+            if value >= 128:
+                out[y * stride + (x >> 3)] |= 0x80 >> (x & 7)
+
+    return name, width, height, bytes(out)
+
+
+def icon_size():
+    match = re.search(r"#define\s+APP_ICON_SIZE\s+(\d+)", open(OS_CONFIG).read())
+    return int(match.group(1))
+
+
+def icon_id(name):
+    return "ICON_" + re.sub(r"^img_", "", name).upper()
+
+
+def place(image, cell):
+    # Centre an image in a cell x cell square of white
+    name, width, height, bits = image
+    stride = (width + 7) // 8
+    cell_stride = cell // 8
+    ox, oy = (cell - width) // 2, (cell - height) // 2
+    out = bytearray(b"\xff" * (cell_stride * cell))
+    for y in range(height):
+        for x in range(width):
+            if not bits[y * stride + (x >> 3)] & (0x80 >> (x & 7)):
+                cx, cy = ox + x, oy + y
+                out[cy * cell_stride + (cx >> 3)] &= ~(0x80 >> (cx & 7)) & 0xff
+    return bytes(out)
+
+
+def emit_atlas(icons, cell):
+    stride = cell // 8
+    cell_bytes = stride * cell
+    lines = ["static const uint8_t img_icon_atlas_map[] = {"]
+    for icon in icons:
+        lines.append("  /* %s */" % icon_id(icon[0]))
+        bits = place(icon, cell)
+        for row in range(cell):
+            chunk = bits[row * stride:(row + 1) * stride]
+            lines.append("  " + ", ".join("0x%02x" % b for b in chunk) + ",")
+    lines.append("};")
+    lines.append("")
+    lines.append("const lv_img_dsc_t img_icon_atlas_1bpp = {")
+    lines.append("  .header.cf = IMG_1BPP_CF,")
+    lines.append("  .header.always_zero = 0,")
+    lines.append("  .header.reserved = 0,")
+    lines.append("  .header.w = %d," % cell)
+    lines.append("  .header.h = %d," % (cell * len(icons)))
+    lines.append("  .data_size = %d," % (cell_bytes * len(icons)))
+    lines.append("  .data = img_icon_atlas_map,")
+    lines.append("};")
+    lines.append("")
+    # A cell's rows are contiguous in the strip, so each one is a plain image
+    lines.append("const lv_img_dsc_t img_icons_1bpp[ICON_ATLAS_COUNT] = {")
+    for i, (name, _, _, _) in enumerate(icons):
+        lines.append("  { .header.cf = IMG_1BPP_CF, .header.w = %d, .header.h = %d, "
+                     ".data_size = %d, .data = img_icon_atlas_map + %d },  /* %s */"
+                     % (cell, cell, cell_bytes, i * cell_bytes, icon_id(name)))
+    lines.append("};")
+    lines.append("")
+    return lines
+
+
+def emit_header(icons, cell):
+    lines = [
+        "/* Generated by script/img_1bpp.py from src/src/img_*.c, do not edit */",
+        "",
+        "#ifndef ICON_ATLAS_H",
+        "#define ICON_ATLAS_H",
+        "",
+        "#define ICON_ATLAS_SIZE %d" % cell,
+        "#define ICON_ATLAS_COUNT %d" % len(icons),
+        "",
+        "enum {",
+    ]
+    for i, (name, _, _, _) in enumerate(icons):
+        lines.append("    %s = %d," % (icon_id(name), i))
+    lines += [
+        "};",
+        "",
+        "#endif /* ICON_ATLAS_H */",
+        "",
+    ]
+    return "\n".join(lines)
+
+
+def emit(images, icons, cell):
+    lines = [
+        "/* Generated by script/img_1bpp.py from src/src/img_*.c, do not edit */",
+        "",
+        "#include \"lvgl.h\"",
+        "#include \"assets.h\"",
+        "",
+    ]
+    if icons:
+        lines += emit_atlas(icons, cell)
+    for name, width, height, bits in images:
+        stride = (width + 7) // 8
+        lines.append("static const uint8_t %s_1bpp_map[] = {" % name)
+        for row in range(height):
+            chunk = bits[row * stride:(row + 1) * stride]
+            lines.append("  " + ", ".join("0x%02x" % b for b in chunk) + ",")
+        lines.append("};")
+        lines.append("")
+        lines.append("const lv_img_dsc_t %s_1bpp = {" % name)
+        lines.append("  .header.cf = IMG_1BPP_CF,")
+        lines.append("  .header.always_zero = 0,")
+        lines.append("  .header.reserved = 0,")
+        lines.append("  .header.w = %d," % width)
+        lines.append("  .header.h = %d," % height)
+        lines.append("  .data_size = %d," % len(bits))
+        lines.append("  .data = %s_1bpp_map," % name)
+        lines.append("};")
+        lines.append("")
+    return "\n".join(lines)
+
+
+def generate(force=False):
+    sources = sorted(p for p in glob.glob(os.path.join(ASSET_DIR, "img_*.c")) if p != OUTPUT)
+    if not force and os.path.exists(OUTPUT) and os.path.exists(ATLAS_HEADER):
+        newest = max(os.path.getmtime(p) for p in sources + [SCRIPT, OS_CONFIG] if os.path.exists(p))
+        if min(os.path.getmtime(OUTPUT), os.path.getmtime(ATLAS_HEADER)) >= newest:
+            return
+
+    cell = icon_size()
+    converted = [img for img in (convert(p) for p in sources) if img]
+    icons = [img for img in converted if img[1] <= cell and img[2] <= cell]
+    images = [img for img in converted if img not in icons]
+    with open(ATLAS_HEADER, "w") as f:
+        f.write(emit_header(icons, cell))
+    with open(OUTPUT, "w") as f:
+        f.write(emit(images, icons, cell))
+    print("img_1bpp: wrote %d icons and %d images to %s" % (len(icons), len(images),
+                                                           os.path.relpath(OUTPUT, PROJECT_DIR)))
+
+
+if RUN_BY_PLATFORMIO:
+    generate()
+elif __name__ == "__main__":
+    generate(force=True)
@@ -0,0 +1,219 @@
+"""
+Decode binary SD logs written by SimpleLogger::enableBinarySD() into text.
+
+Records hold a 32-bit format ID instead of the message. The ID is FNV-1a over
+the component, a NUL and the format literal (slog_id() in simple_logger.h),
+so the dictionary is rebuilt here from the LOG_* call sites in src/ and the
+firmware needs no generated tables. Decode with the sources of the build that
+wrote the log; records whose ID is unknown are printed with their raw
+arguments.
+
+Usage: python script/log_decode.py /path/to/system.blog [--src DIR] [--dict]
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+
+PROJECT_DIR = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+SLOG_SYNC = 0xA5
+SLOG_HEADER_SIZE = 11
+SLOG_FLAG_TRUNCATED = 0x80
+SLOG_LEVEL_SESSION = 0x7F
+SLOG_FORMAT_TEXT = 0
+
+LEVELS = {0: "DEBUG", 1: "INFO", 2: "WARN", 3: "ERROR"}
+
+# Matches simple_logger.cpp writeToSerial()/writeToSD()
+LINE_FORMAT = "[{ts}] [{level}] {component}: {message}"
+
+C_STRING = r'"(?:[^"\\]|\\.)*"'
+CALL_RE = re.compile(r"\bLOG_(DEBUG|INFO|WARN|ERROR)(F?)\s*\(\s*(" + C_STRING + r")\s*,\s*((?:" + C_STRING + r"\s*)+)")
+LITERAL_RE = re.compile(C_STRING)
+SPEC_RE = re.compile(r"%([-+ #0]*)(\*|\d+)?(?:\.(\*|\d*))?(hh|h|ll|l|z|j|t|L)?([diuoxXcsfFeEgGp%])")
+ESCAPES = {"n": "\n", "t": "\t", "r": "\r", "0": "\0", "\\": "\\", '"': '"', "'": "'", "a": "\a", "b": "\b", "f": "\f", "v": "\v"}
+
+ARG_SIZES = {"i": 4, "u": 4, "q": 8, "Q": 8, "d": 8, "p": 4}
+ARG_FORMATS = {"i": "<i", "u": "<I", "q": "<q", "Q": "<Q", "d": "<d", "p": "<I"}
+
+
+def unescape(literal):
+    # Adjacent literals concatenate, as in C
+    out = []
+    for part in LITERAL_RE.findall(literal):
+        body = part[1:-1]
+        i = 0
+        while i < len(body):
+            c = body[i]
+            if c == "\\" and i + 1 < len(body):
+                n = body[i + 1]
+                if n == "x":
+                    m = re.match(r"[0-9a-fA-F]+", body[i + 2:])
+                    out.append(chr(int(m.group(0), 16)))
+                    i += 2 + len(m.group(0))
+                    continue
+                out.append(ESCAPES.get(n, n))
+                i += 2
+                continue
+            out.append(c)
+            i += 1
+    return "".join(out)
+
+
+def fnv1a(data, h=2166136261):
+    for b in data:
+        h = ((h ^ b) * 16777619) & 0xFFFFFFFF
+    return h
+
+
+def format_id(component, fmt):
+    h = (fnv1a(component.encode()) * 16777619) & 0xFFFFFFFF
+    return fnv1a(fmt.encode(), h)
+
+
+def build_dictionary(src_dir):
+    # ID -> (component, format, is_printf)
+    dictionary = {}
+    for root, _, files in os.walk(src_dir):
+        for name in files:
+            if not name.endswith((".c", ".cpp", ".h", ".hpp")):
+                continue
+            with open(os.path.join(root, name), encoding="utf-8", errors="replace") as f:
+                text = f.read()
+            for m in CALL_RE.finditer(text):
+                component = unescape(m.group(3))
+                fmt = unescape(m.group(4))
+                entry = (component, fmt, m.group(2) == "F")
+                # The same literal through LOG_X and LOG_XF: keep the printf reading
+                old = dictionary.get(format_id(component, fmt))
+                if old is None or (entry[2] and not old[2]):
+                    dictionary[format_id(component, fmt)] = entry
+    return dictionary
+
+
+def parse_args(data):
+    args = []
+    i = 0
+    while i < len(data):
+        tag = chr(data[i])
+        i += 1
+        if tag == "s":
+            n = data[i]
+            args.append(data[i + 1:i + 1 + n].decode("utf-8", errors="replace"))
+            i += 1 + n
+        elif tag in ARG_SIZES:
+            (value,) = struct.unpack_from(ARG_FORMATS[tag], data, i)
+            args.append(value)
+            i += ARG_SIZES[tag]
+        else:
+            raise ValueError("bad argument tag 0x%02x" % data[i - 1])
+    return args
+
+
+def c_format(fmt, args):
+    # printf semantics over the decoded arguments, missing ones shown as ?
+    args = list(args)
+
+    def take():
+        return args.pop(0) if args else None
+
+    def repl(m):
+        flags, width, prec, length, conv = m.groups()
+        if conv == "%":
+            return "%"
+        if width == "*":
+            width = str(take())
+        if prec == "*":
+            prec = str(take())
+        value = take()
+        if value is None:
+            return "?"
+        spec = "%" + flags + (width or "") + ("." + prec if prec is not None else "")
+        if conv in "di":
+            return (spec + "d") % (int(value) if not isinstance(value, str) else 0)
+        if conv == "u":
+            bits = 64 if length == "ll" else 32
+            return (spec + "d") % (int(value) & ((1 << bits) - 1))
+        if conv == "p":
+            return "0x%08x" % int(value)
+        if conv == "c":
+            return chr(int(value) & 0xFF)
+        if conv == "s":
+            return (spec + "s") % value
+        if conv in "oxX":
+            bits = 64 if length == "ll" else 32
+            return (spec + conv) % (int(value) & ((1 << bits) - 1))
+        return (spec + conv) % float(value)
+
+    return SPEC_RE.sub(repl, fmt)
+
+
+def decode(data, dictionary, out):
+    i = 0
+    skipped = 0
+    while i + SLOG_HEADER_SIZE <= len(data):
+        length = data[i + 1]
+        if data[i] != SLOG_SYNC or length < SLOG_HEADER_SIZE or i + length > len(data):
+            # Torn write or corruption: resynchronise on the next sync byte
+            i += 1
+            skipped += 1
+            continue
+
+        level_byte = data[i + 2]
+        ts, fid = struct.unpack_from("<II", data, i + 3)
+        try:
+            args = parse_args(data[i + SLOG_HEADER_SIZE:i + length])
+        except (ValueError, IndexError, struct.error):
+            i += 1
+            skipped += 1
+            continue
+        i += length
+
+        level = level_byte & ~SLOG_FLAG_TRUNCATED
+        if level == SLOG_LEVEL_SESSION:
+            out.write("--- log session ---\n")
+            continue
+
+        entry = dictionary.get(fid)
+        if fid == SLOG_FORMAT_TEXT and len(args) == 2:
+            # Logged through Logger->info() and friends: the text is in the record
+            component, message = args
+        elif entry is None:
+            component, message = "?", "<unknown format %08x> %r" % (fid, args)
+        else:
+            component, fmt, is_printf = entry
+            message = c_format(fmt, args) if is_printf else fmt
+        if level_byte & SLOG_FLAG_TRUNCATED:
+            message += " <truncated>"
+
+        out.write(LINE_FORMAT.format(ts=ts, level=LEVELS.get(level, "UNKNOWN"),
+                                     component=component, message=message) + "\n")
+
+    if skipped:
+        sys.stderr.write("log_decode: skipped %d corrupt bytes\n" % skipped)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("log", nargs="?", help="binary log file (system.blog)")
+    parser.add_argument("--src", default=os.path.join(PROJECT_DIR, "src"), help="source tree of the firmware that wrote the log")
+    parser.add_argument("--dict", action="store_true", help="print the format dictionary and exit")
+    args = parser.parse_args()
+
+    dictionary = build_dictionary(args.src)
+    if args.dict:
+        for fid, (component, fmt, _) in sorted(dictionary.items()):
+            print("%08x %s: %r" % (fid, component, fmt))
+        return
+    if not args.log:
+        parser.error("a log file is required unless --dict is given")
+
+    with open(args.log, "rb") as f:
+        decode(f.read(), dictionary, sys.stdout)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,299 @@
+"""
+Train the LoRa short-message codec (src/lora_codec.h) on
+script/lora_corpus.txt and write its tables to src/lora_dict.h.
+
+The codec replaces the longest dictionary entry at each position (greedy,
+the same walk the device does) and codes the resulting symbols - the 256
+byte values, the dictionary entries and an end marker - with one static
+canonical Huffman code. Entries are 2 to MAX_ENTRY bytes, picked by the
+bytes they actually save on the training messages over a few rounds of
+tokenizing. Every byte value keeps a code, so any packet can be coded;
+the device only sends the coded form when it is shorter.
+
+Every HOLD_OUT-th corpus message is left out of training and written to
+the header as the benchmark set (bench_suite, sim --bench codec).
+
+Runs as a PlatformIO pre-build script (extra_scripts = pre:script/lora_dict.py)
+and regenerates only when the corpus or this script is newer than the
+output. Run directly, it regenerates and prints the ratios:
+python script/lora_dict.py
+"""
+
+import collections
+import heapq
+import os
+
+try:
+    Import("env")  # noqa: F821 - provided by PlatformIO
+    PROJECT_DIR = env.subst("$PROJECT_DIR")  # noqa: F821
+    RUN_BY_PLATFORMIO = True
+except NameError:
+    PROJECT_DIR = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+    RUN_BY_PLATFORMIO = False
+
+SCRIPT = os.path.join(PROJECT_DIR, "script", "lora_dict.py")
+CORPUS = os.path.join(PROJECT_DIR, "script", "lora_corpus.txt")
+OUTPUT = os.path.join(PROJECT_DIR, "src", "lora_dict.h")
+
+DICT_SIZE = 192             # Entries; symbols are 256 + DICT_SIZE + 1
+MAX_ENTRY = 8               # Bytes per entry
+MIN_COUNT = 3               # Occurrences before a substring is considered
+MAX_CODE = 15               # Longest code; lora_codec decodes bit by bit
+ROUNDS = 4
+HOLD_OUT = 8
+
+
+def load():
+    train, held = [], []
+    with open(CORPUS, encoding="utf-8") as f:
+        lines = [l.rstrip("\n").encode("utf-8") for l in f if l.strip() and not l.startswith("#")]
+    for i, line in enumerate(lines):
+        (held if i % HOLD_OUT == HOLD_OUT - 1 else train).append(line)
+    return train, held
+
+
+def index(entries):
+    """Entries by first byte, longest first: the first match is the longest."""
+    by_first = collections.defaultdict(list)
+    for n, e in enumerate(entries):
+        by_first[e[0]].append(n)
+    for ids in by_first.values():
+        ids.sort(key=lambda n: (-len(entries[n]), entries[n]))
+    return by_first
+
+
+def tokenize(msg, entries, by_first):
+    out = []
+    i = 0
+    while i < len(msg):
+        for n in by_first.get(msg[i], ()):
+            if msg.startswith(entries[n], i):
+                out.append(256 + n)
+                i += len(entries[n])
+                break
+        else:
+            out.append(msg[i])
+            i += 1
+    return out
+
+
+def choose(train):
+    counts = collections.Counter()
+    for msg in train:
+        for i in range(len(msg)):
+            for n in range(2, MAX_ENTRY + 1):
+                if i + n <= len(msg):
+                    counts[msg[i:i + n]] += 1
+    pool = [s for s, c in counts.items() if c >= MIN_COUNT]
+    pool.sort(key=lambda s: (-(len(s) - 1) * counts[s], s))
+    entries = pool[:DICT_SIZE * 2]
+
+    # Keep what the greedy walk really uses, refill from the pool, repeat
+    for _ in range(ROUNDS):
+        by_first = index(entries)
+        used = collections.Counter()
+        for msg in train:
+            for sym in tokenize(msg, entries, by_first):
+                if sym >= 256:
+                    used[entries[sym - 256]] += 1
+        ranked = sorted(entries, key=lambda e: (-(len(e) - 1) * used[e], e))
+        keep = [e for e in ranked[:DICT_SIZE] if used[e]]
+        spare = [s for s in pool if s not in set(keep)]
+        entries = keep + spare[:DICT_SIZE * 2 - len(keep)]
+    by_first = index(entries)
+    used = collections.Counter()
+    for msg in train:
+        for sym in tokenize(msg, entries, by_first):
+            if sym >= 256:
+                used[entries[sym - 256]] += 1
+    entries = sorted(entries, key=lambda e: (-(len(e) - 1) * used[e], e))[:DICT_SIZE]
+    return sorted(entries, key=lambda e: (e[0], -len(e), e))
+
+
+def code_lengths(freq):
+    while True:
+        heap = [(f, n, (n,)) for n, f in enumerate(freq)]
+        heapq.heapify(heap)
+        depth = [0] * len(freq)
+        tie = len(freq)
+        while len(heap) > 1:
+            fa, _, a = heapq.heappop(heap)
+            fb, _, b = heapq.heappop(heap)
+            for n in a + b:
+                depth[n] += 1
+            heapq.heappush(heap, (fa + fb, tie, a + b))
+            tie += 1
+        if max(depth) <= MAX_CODE:
+            return depth
+        freq = [max(1, f // 2) for f in freq]
+
+
+def canonical(lengths):
+    order = sorted(range(len(lengths)), key=lambda n: (lengths[n], n))
+    codes = [0] * len(lengths)
+    code = 0
+    prev = 0
+    for n in order:
+        code <<= lengths[n] - prev
+        prev = lengths[n]
+        codes[n] = code
+        code += 1
+    count = [0] * (MAX_CODE + 1)
+    for l in lengths:
+        count[l] += 1
+    return codes, order, count
+
+
+def train_codec():
+    train, held = load()
+    entries = choose(train)
+    by_first = index(entries)
+    symbols = 256 + len(entries) + 1
+    eof = symbols - 1
+    freq = [1] * symbols
+    for msg in train:
+        for sym in tokenize(msg, entries, by_first):
+            freq[sym] += 1
+        freq[eof] += 1
+    lengths = code_lengths(freq)
+    return entries, lengths, held, train
+
+
+def packed_size(msg, entries, lengths):
+    bits = sum(lengths[s] for s in tokenize(msg, entries, index(entries))) + lengths[-1]
+    return 1 + (bits + 7) // 8     # Marker byte, then the bits
+
+
+def c_bytes(data, per_line=16, indent="    "):
+    return [indent + ", ".join("0x%02x" % b for b in data[i:i + per_line]) + ","
+            for i in range(0, len(data), per_line)]
+
+
+def c_words(data, per_line=12, indent="    "):
+    return [indent + ", ".join("%d" % w for w in data[i:i + per_line]) + ","
+            for i in range(0, len(data), per_line)]
+
+
+def c_string(msg):
+    out = []
+    for b in msg:
+        c = chr(b)
+        if c in "\\\"":
+            out.append("\\" + c)
+        elif 32 <= b < 127:
+            out.append(c)
+        else:
+            out.append("\\x%02x\"\"" % b)
+    return "\"" + "".join(out) + "\""
+
+
+def emit(entries, lengths, held):
+    codes, order, count = canonical(lengths)
+    text = b"".join(entries)
+    offsets = [0]
+    for e in entries:
+        offsets.append(offsets[-1] + len(e))
+    first = [0] * 257
+    for b in range(256):
+        first[b + 1] = first[b] + sum(1 for e in entries if e[0] == b)
+    base = [0] * (MAX_CODE + 2)     # First code of each length
+    start = [0] * (MAX_CODE + 2)    # Its index in the sorted symbols
+    code = 0
+    idx = 0
+    for l in range(1, MAX_CODE + 1):
+        code = (code + (count[l - 1] if l > 1 else 0)) << 1
+        base[l] = code
+        start[l] = idx
+        idx += count[l]
+
+    lines = [
+        "/* Generated by script/lora_dict.py from script/lora_corpus.txt, do not edit */",
+        "",
+        "#ifndef LORA_DICT_H",
+        "#define LORA_DICT_H",
+        "",
+        "#include <stdint.h>",
+        "",
+        "#define LORA_DICT_ENTRIES %d" % len(entries),
+        "#define LORA_DICT_SYMBOLS %d" % len(lengths),
+        "#define LORA_DICT_EOF %d" % (len(lengths) - 1),
+        "#define LORA_DICT_MAX_CODE %d" % MAX_CODE,
+        "#define LORA_DICT_SAMPLES %d" % len(held),
+        "",
+        "// Entry n is lora_dict_text[lora_dict_offset[n] .. lora_dict_offset[n + 1])",
+        "static constexpr uint8_t lora_dict_text[] = {",
+    ] + c_bytes(text) + [
+        "};",
+        "",
+        "static constexpr uint16_t lora_dict_offset[LORA_DICT_ENTRIES + 1] = {",
+    ] + c_words(offsets) + [
+        "};",
+        "",
+        "// Entries starting with byte b: [lora_dict_first[b], lora_dict_first[b + 1]), longest first",
+        "static constexpr uint16_t lora_dict_first[257] = {",
+    ] + c_words(first) + [
+        "};",
+        "",
+        "// Symbol s: byte s below 256, else entry s - 256, and LORA_DICT_EOF",
+        "static constexpr uint16_t lora_code_bits[LORA_DICT_SYMBOLS] = {",
+    ] + c_words(codes) + [
+        "};",
+        "",
+        "static constexpr uint8_t lora_code_len[LORA_DICT_SYMBOLS] = {",
+    ] + c_words(lengths, 24) + [
+        "};",
+        "",
+        "// Canonical decode: codes of length l are lora_code_base[l] onwards,",
+        "// lora_code_count[l] of them, symbols from lora_code_symbols[lora_code_start[l]]",
+        "static constexpr uint16_t lora_code_base[LORA_DICT_MAX_CODE + 1] = {",
+    ] + c_words(base[:MAX_CODE + 1], 16) + [
+        "};",
+        "",
+        "static constexpr uint16_t lora_code_count[LORA_DICT_MAX_CODE + 1] = {",
+    ] + c_words(count, 16) + [
+        "};",
+        "",
+        "static constexpr uint16_t lora_code_start[LORA_DICT_MAX_CODE + 1] = {",
+    ] + c_words(start[:MAX_CODE + 1], 16) + [
+        "};",
+        "",
+        "static constexpr uint16_t lora_code_symbols[LORA_DICT_SYMBOLS] = {",
+    ] + c_words(order) + [
+        "};",
+        "",
+        "// Held out of training, for the benchmarks",
+        "static constexpr const char *lora_dict_samples[LORA_DICT_SAMPLES] = {",
+    ] + ["    %s," % c_string(m) for m in held] + [
+        "};",
+        "",
+        "#endif /* LORA_DICT_H */",
+        "",
+    ]
+    return "\n".join(lines)
+
+
+def report(name, msgs, entries, lengths):
+    raw = sum(len(m) for m in msgs)
+    # As sent: coded only when that is shorter
+    sent = sum(min(len(m), packed_size(m, entries, lengths)) for m in msgs)
+    print("lora_dict: %-9s %4d messages %6d -> %6d bytes, ratio %.2f" % (name, len(msgs), raw, sent, raw / sent))
+
+
+def generate(force=False):
+    if not force and os.path.exists(OUTPUT):
+        newest = max(os.path.getmtime(p) for p in (SCRIPT, CORPUS))
+        if os.path.getmtime(OUTPUT) >= newest:
+            return
+    entries, lengths, held, train = train_codec()
+    with open(OUTPUT, "w") as f:
+        f.write(emit(entries, lengths, held))
+    print("lora_dict: wrote %d entries to %s" % (len(entries), os.path.relpath(OUTPUT, PROJECT_DIR)))
+    if not RUN_BY_PLATFORMIO:
+        report("training", train, entries, lengths)
+        report("held out", held, entries, lengths)
+
+
+if RUN_BY_PLATFORMIO:
+    generate()
+elif __name__ == "__main__":
+    generate(force=True)
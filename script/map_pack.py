@@ -0,0 +1,332 @@
+"""
+Pack GeoJSON into the offline map format of src/map_tiles.h.
+
+Features are sorted into map kinds by a "kind" property (a MapKind name
+such as road_major) or, failing that, by their OSM tags, so the output of
+osmium export or ogr2ogr can be fed in as is. Each zoom level gets its
+own tiles: geometry is simplified to half a pixel, clipped to the tile
+plus MAP_TILE_BUFFER and quantised to MAP_TILE_EXTENT units per side.
+Polygons keep their outer ring only.
+
+Put the output on the SD card as /maps/map.tdm.
+
+Usage: python script/map_pack.py city.geojson -o map.tdm [--zoom 10-16]
+"""
+
+import argparse
+import json
+import math
+import struct
+import sys
+
+MAGIC = 0x504D4454          # "TDMP"
+VERSION = 1
+HEADER_FMT = "<IBBBxIIIii4x"
+TILE_FMT = "<HHBxHII"
+TILE_PX = 128
+EXTENT = 4096
+BUFFER = 256
+ZOOM_MAX = 16
+POINTS_MAX = 1024
+TILE_DATA_MAX = 32768
+
+# MapKind order is draw order; (name, is_area, first zoom shown)
+KINDS = [
+    ("water", True, 8),
+    ("park", True, 12),
+    ("building", True, 15),
+    ("border", False, 6),
+    ("path", False, 15),
+    ("rail", False, 12),
+    ("road_minor", False, 13),
+    ("road_major", False, 8),
+]
+KIND_INDEX = {name: i for i, (name, _, _) in enumerate(KINDS)}
+
+MAJOR_ROADS = {"motorway", "trunk", "primary", "secondary", "motorway_link", "trunk_link",
+               "primary_link", "secondary_link"}
+PATHS = {"footway", "path", "cycleway", "track", "steps", "bridleway", "pedestrian"}
+PARKS = {"park", "grass", "forest", "wood", "meadow", "recreation_ground", "garden", "cemetery"}
+
+
+def classify(props):
+    kind = props.get("kind")
+    if kind in KIND_INDEX:
+        return KIND_INDEX[kind]
+    highway = props.get("highway")
+    if highway:
+        if highway in MAJOR_ROADS:
+            return KIND_INDEX["road_major"]
+        return KIND_INDEX["path" if highway in PATHS else "road_minor"]
+    if props.get("railway") == "rail":
+        return KIND_INDEX["rail"]
+    if props.get("building"):
+        return KIND_INDEX["building"]
+    if props.get("natural") == "water" or props.get("water") or props.get("landuse") == "reservoir":
+        return KIND_INDEX["water"]
+    if props.get("leisure") in PARKS or props.get("landuse") in PARKS or props.get("natural") in PARKS:
+        return KIND_INDEX["park"]
+    if props.get("boundary") == "administrative":
+        return KIND_INDEX["border"]
+    return None
+
+
+def project(lng, lat):
+    """Web mercator, 0..1 both ways."""
+    lat = max(min(lat, 85.0511), -85.0511)
+    s = math.sin(math.radians(lat))
+    return (lng + 180.0) / 360.0, 0.5 - math.log((1 + s) / (1 - s)) / (4 * math.pi)
+
+
+def read_features(path):
+    """(kind, is_area, [(x, y) 0..1]) per line or outer ring, with the lat/lng bounds."""
+    with open(path, encoding="utf-8") as f:
+        data = json.load(f)
+    out = []
+    bounds = [180.0, 90.0, -180.0, -90.0]
+    for feat in data.get("features", []):
+        geom = feat.get("geometry") or {}
+        kind = classify(feat.get("properties") or {})
+        if kind is None:
+            continue
+        area = KINDS[kind][1]
+        gtype = geom.get("type")
+        coords = geom.get("coordinates")
+        if gtype == "LineString" and not area:
+            parts = [coords]
+        elif gtype == "MultiLineString" and not area:
+            parts = coords
+        elif gtype == "Polygon":
+            parts = coords[:1]
+        elif gtype == "MultiPolygon":
+            parts = [p[0] for p in coords if p]
+        else:
+            continue
+        for part in parts:
+            if len(part) < 2:
+                continue
+            for lng, lat in (c[:2] for c in part):
+                bounds = [min(bounds[0], lng), min(bounds[1], lat), max(bounds[2], lng), max(bounds[3], lat)]
+            pts = [project(c[0], c[1]) for c in part]
+            if area and pts[0] == pts[-1]:
+                pts.pop()
+            out.append((kind, area, pts))
+    return out, bounds
+
+
+def simplify(pts, tol):
+    """Douglas-Peucker, iterative."""
+    if len(pts) < 3:
+        return pts
+    keep = [False] * len(pts)
+    keep[0] = keep[-1] = True
+    stack = [(0, len(pts) - 1)]
+    tol2 = tol * tol
+    while stack:
+        a, b = stack.pop()
+        ax, ay = pts[a]
+        bx, by = pts[b]
+        dx, dy = bx - ax, by - ay
+        d2 = dx * dx + dy * dy
+        best, idx = 0.0, -1
+        for i in range(a + 1, b):
+            px, py = pts[i]
+            if d2 == 0:
+                dist = (px - ax) ** 2 + (py - ay) ** 2
+            else:
+                t = ((px - ax) * dx + (py - ay) * dy) / d2
+                t = max(0.0, min(1.0, t))
+                dist = (px - ax - t * dx) ** 2 + (py - ay - t * dy) ** 2
+            if dist > best:
+                best, idx = dist, i
+        if best > tol2:
+            keep[idx] = True
+            stack.append((a, idx))
+            stack.append((idx, b))
+    return [p for p, k in zip(pts, keep) if k]
+
+
+def clip_polygon(pts, lo, hi):
+    """Sutherland-Hodgman against the square lo..hi."""
+    def clip(pts, axis, bound, keep_above):
+        out = []
+        for i, cur in enumerate(pts):
+            prev = pts[i - 1]
+            cin = (cur[axis] >= bound) if keep_above else (cur[axis] <= bound)
+            pin = (prev[axis] >= bound) if keep_above else (prev[axis] <= bound)
+            if cin != pin:
+                t = (bound - prev[axis]) / (cur[axis] - prev[axis])
+                out.append((prev[0] + t * (cur[0] - prev[0]), prev[1] + t * (cur[1] - prev[1])))
+            if cin:
+                out.append(cur)
+        return out
+    for axis in (0, 1):
+        pts = clip(pts, axis, lo, True)
+        if pts:
+            pts = clip(pts, axis, hi, False)
+        if not pts:
+            return []
+    return pts
+
+
+def clip_line(pts, lo, hi):
+    """Liang-Barsky per segment; runs that leave the square become separate parts."""
+    parts = []
+    cur = []
+    for (x0, y0), (x1, y1) in zip(pts, pts[1:]):
+        t0, t1 = 0.0, 1.0
+        dx, dy = x1 - x0, y1 - y0
+        ok = True
+        for p, q in ((-dx, x0 - lo), (dx, hi - x0), (-dy, y0 - lo), (dy, hi - y0)):
+            if p == 0:
+                if q < 0:
+                    ok = False
+                    break
+            else:
+                t = q / p
+                if p < 0:
+                    t0 = max(t0, t)
+                else:
+                    t1 = min(t1, t)
+        if not ok or t0 > t1:
+            if cur:
+                parts.append(cur)
+                cur = []
+            continue
+        a = (x0 + t0 * dx, y0 + t0 * dy)
+        b = (x0 + t1 * dx, y0 + t1 * dy)
+        if not cur:
+            cur = [a]
+        elif cur[-1] != a:
+            parts.append(cur)
+            cur = [a]
+        cur.append(b)
+        if t1 < 1.0:
+            parts.append(cur)
+            cur = []
+    if cur:
+        parts.append(cur)
+    return parts
+
+
+def zigzag(v):
+    return (v << 1) ^ (v >> 31)
+
+
+def put_varint(out, v):
+    while v >= 0x80:
+        out.append((v & 0x7F) | 0x80)
+        v >>= 7
+    out.append(v)
+
+
+def encode(kind, pts):
+    out = bytearray([kind])
+    put_varint(out, len(pts))
+    px = py = 0
+    for x, y in pts:
+        put_varint(out, zigzag(x - px))
+        put_varint(out, zigzag(y - py))
+        px, py = x, y
+    return out
+
+
+def quantise(pts, ox, oy):
+    out = []
+    for x, y in pts:
+        q = (int(round(x - ox)), int(round(y - oy)))
+        if not out or out[-1] != q:
+            out.append(q)
+    return out
+
+
+def build_zoom(features, z):
+    """{(x, y): [(kind, points)]} for zoom z."""
+    scale = (1 << z) * EXTENT
+    tol = EXTENT / TILE_PX / 2
+    tiles = {}
+    for kind, area, norm in features:
+        if z < KINDS[kind][2]:
+            continue
+        pts = simplify([(x * scale, y * scale) for x, y in norm], tol)
+        if len(pts) < (3 if area else 2):
+            continue
+        xs = [p[0] for p in pts]
+        ys = [p[1] for p in pts]
+        tx0 = max(int((min(xs) - BUFFER) // EXTENT), 0)
+        tx1 = min(int((max(xs) + BUFFER) // EXTENT), (1 << z) - 1)
+        ty0 = max(int((min(ys) - BUFFER) // EXTENT), 0)
+        ty1 = min(int((max(ys) + BUFFER) // EXTENT), (1 << z) - 1)
+        for ty in range(ty0, ty1 + 1):
+            for tx in range(tx0, tx1 + 1):
+                ox, oy = tx * EXTENT, ty * EXTENT
+                local = [(x - ox, y - oy) for x, y in pts]
+                if area:
+                    parts = [clip_polygon(local, -BUFFER, EXTENT + BUFFER)]
+                else:
+                    parts = clip_line(local, -BUFFER, EXTENT + BUFFER)
+                for part in parts:
+                    q = quantise(part, 0, 0)
+                    if len(q) < (3 if area else 2):
+                        continue
+                    if area:
+                        # A ring too long for the decoder keeps every n-th point
+                        step = -(-len(q) // POINTS_MAX)
+                        chunks = [q[::step]]
+                    else:
+                        chunks = [q[i:i + POINTS_MAX] for i in range(0, len(q) - 1, POINTS_MAX - 1)]
+                    for c in chunks:
+                        tiles.setdefault((tx, ty), []).append((kind, c))
+    return tiles
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    parser.add_argument("geojson", nargs="+")
+    parser.add_argument("-o", "--out", required=True)
+    parser.add_argument("--zoom", default="10-16", help="zoom range, e.g. 10-16")
+    args = parser.parse_args()
+
+    zlo, _, zhi = args.zoom.partition("-")
+    zoom_min, zoom_max = int(zlo), int(zhi or zlo)
+    if not 0 <= zoom_min <= zoom_max <= ZOOM_MAX:
+        sys.exit("Zoom must be within 0-%d" % ZOOM_MAX)
+
+    features = []
+    bounds = [180.0, 90.0, -180.0, -90.0]
+    for path in args.geojson:
+        f, b = read_features(path)
+        features += f
+        bounds = [min(bounds[0], b[0]), min(bounds[1], b[1]), max(bounds[2], b[2]), max(bounds[3], b[3])]
+    if not features:
+        sys.exit("No map features found")
+
+    index = []
+    data = bytearray()
+    for z in range(zoom_min, zoom_max + 1):
+        tiles = build_zoom(features, z)
+        for (x, y), feats in sorted(tiles.items(), key=lambda t: (t[0][1], t[0][0])):
+            blob = bytearray()
+            feats.sort(key=lambda f: f[0])
+            for kind, pts in feats:
+                blob += encode(kind, pts)
+            if len(blob) > TILE_DATA_MAX:
+                print("Tile %d/%d/%d is %d bytes, cut to %d" % (z, x, y, len(blob), TILE_DATA_MAX),
+                      file=sys.stderr)
+            index.append(struct.pack(TILE_FMT, x, y, z, len(feats), len(data), len(blob)))
+            data += blob
+        print("zoom %d: %d tiles" % (z, len(tiles)))
+
+    header_size = struct.calcsize(HEADER_FMT)
+    index_size = len(index) * struct.calcsize(TILE_FMT)
+    center_lat = int(round((bounds[1] + bounds[3]) / 2 * 1e7))
+    center_lng = int(round((bounds[0] + bounds[2]) / 2 * 1e7))
+    header = struct.pack(HEADER_FMT, MAGIC, VERSION, zoom_min, zoom_max, len(index), header_size,
+                         header_size + index_size, center_lat, center_lng)
+    with open(args.out, "wb") as f:
+        f.write(header + b"".join(index) + data)
+    print("%d tiles, %d bytes index, %d bytes data" % (len(index), index_size, len(data)))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,103 @@
+"""
+Build a delta OTA patch (src/ota_patch.h) that turns one firmware.bin
+into another.
+
+The diff is bsdiff's: each step adds diff bytes to the old image, copies
+extra bytes as they are and moves the read position by seek. Steps are
+written as a 12-byte little-endian control triple followed by their
+bytes, and the whole stream is compressed with heatshrink (window 2^10,
+lookahead 2^4) so the device can expand it with 1 KB of RAM.
+
+With --key (the fleet key, 64 hex digits, the same as config ota.key)
+the header carries an HMAC-SHA256; without it the patch is unsigned and
+only devices with ota.allow_unsigned take it. --full leaves the old image
+out and sends the new one whole, for devices on an unknown build.
+--assets marks the patch as one between two asset packs
+(script/asset_pack.py), which devices write to their spare asset slot.
+
+Usage: python script/ota_diff.py old.bin new.bin -o update.tdp [--key HEX] [--full] [--assets]
+       pip install bsdiff4 heatshrink2
+"""
+
+import argparse
+import hashlib
+import hmac
+import struct
+import sys
+
+MAGIC = 0x44504454          # "TDPD"
+VERSION = 1
+WINDOW_BITS = 10
+LOOKAHEAD_BITS = 4
+HEADER_FMT = "<IBBBBIII32s32s"   # Everything the MAC covers
+MAC_SIZE = 32
+FLAG_ASSETS = 0x01
+
+
+def steps(old, new):
+    """Yields the (diff, extra, seek) triples and their bytes."""
+    if old is None:
+        yield (0, len(new), 0), b"", new
+        return
+    import bsdiff4.core
+    control, diff, extra = bsdiff4.core.diff(old, new)
+    d = e = 0
+    for x, y, z in control:
+        yield (x, y, z), diff[d:d + x], extra[e:e + y]
+        d += x
+        e += y
+
+
+def build(old, new, key, flags=0):
+    body = bytearray()
+    for (x, y, z), diff, extra in steps(old, new):
+        body += struct.pack("<IIi", x, y, z)
+        body += diff
+        body += extra
+
+    import heatshrink2
+    packed = heatshrink2.compress(bytes(body), window_sz2=WINDOW_BITS, lookahead_sz2=LOOKAHEAD_BITS)
+
+    source = old or b""
+    header = struct.pack(HEADER_FMT, MAGIC, VERSION, WINDOW_BITS, LOOKAHEAD_BITS, flags,
+                         len(source), len(new), len(packed),
+                         hashlib.sha256(source).digest() if old is not None else bytes(32),
+                         hashlib.sha256(new).digest())
+    mac = hmac.new(key, header, hashlib.sha256).digest() if key else bytes(MAC_SIZE)
+    return header + mac + packed, len(body)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0].strip())
+    parser.add_argument("old", help="firmware.bin the devices run now")
+    parser.add_argument("new", help="firmware.bin to update them to")
+    parser.add_argument("-o", "--output", required=True, help="patch file")
+    parser.add_argument("--key", help="fleet key, 64 hex digits")
+    parser.add_argument("--full", action="store_true", help="ignore old and send new whole")
+    parser.add_argument("--assets", action="store_true", help="old and new are asset packs")
+    args = parser.parse_args()
+
+    key = None
+    if args.key:
+        try:
+            key = bytes.fromhex(args.key)
+        except ValueError:
+            key = b""
+        if len(key) != 32:
+            sys.exit("--key wants 64 hex digits")
+
+    with open(args.old, "rb") as f:
+        old = None if args.full else f.read()
+    with open(args.new, "rb") as f:
+        new = f.read()
+
+    patch, steps_size = build(old, new, key, FLAG_ASSETS if args.assets else 0)
+    with open(args.output, "wb") as f:
+        f.write(patch)
+    print("%s: %d bytes (%.1f%% of the image), %d before compression, %s" % (
+        args.output, len(patch), 100.0 * len(patch) / max(len(new), 1), steps_size,
+        "signed" if key else "unsigned"))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,109 @@
+/**
+ * @file      FS.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Arduino file system API on a host directory
+ */
+
+#ifndef SIM_FS_H
+#define SIM_FS_H
+
+#include <Arduino.h>
+#include <memory>
+#include <string>
+#include <time.h>
+
+/**
+ * Each mounted file system is a directory under the sim root (sim_fs_root(),
+ * "sim_data" unless --data says otherwise): /sd for SD, /littlefs for
+ * LittleFS. Paths keep their device form, "/config/system.json", and are
+ * joined to the mount's directory. Directories are created on demand so a
+ * fresh checkout runs without setup.
+ */
+
+#define FILE_READ           "r"
+#define FILE_WRITE          "w"
+#define FILE_APPEND         "a"
+
+namespace fs {
+
+enum SeekMode {
+    SeekSet = 0,
+    SeekCur = 1,
+    SeekEnd = 2,
+};
+
+struct FileImpl;
+
+class File : public Stream {
+private:
+    std::shared_ptr<FileImpl> impl;
+
+public:
+    File() {}
+    explicit File(std::shared_ptr<FileImpl> p) : impl(p) {}
+
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buf, size_t len) override;
+    using Print::write;
+    int available() override;
+    int read() override;
+    int peek() override;
+    void flush() override;
+    size_t read(uint8_t* buf, size_t len);
+    size_t readBytes(char* buf, size_t len) override { return read((uint8_t*)buf, len); }
+
+    bool seek(uint32_t pos, SeekMode mode = SeekSet);
+    size_t position() const;
+    size_t size() const;
+    void close();
+    operator bool() const;
+    time_t getLastWrite();
+    const char* path() const;
+    const char* name() const;
+    bool isDirectory() const;
+    File openNextFile(const char* mode = FILE_READ);
+    void rewindDirectory();
+};
+
+class FS {
+protected:
+    std::string mount;              // Directory under the sim root
+
+public:
+    explicit FS(const char* mount_dir) : mount(mount_dir) {}
+
+    File open(const char* path, const char* mode = FILE_READ, bool create = false);
+    File open(const String& path, const char* mode = FILE_READ, bool create = false) {
+        return open(path.c_str(), mode, create);
+    }
+    bool exists(const char* path);
+    bool exists(const String& path) { return exists(path.c_str()); }
+    bool remove(const char* path);
+    bool remove(const String& path) { return remove(path.c_str()); }
+    bool rename(const char* from, const char* to);
+    bool rename(const String& from, const String& to) { return rename(from.c_str(), to.c_str()); }
+    bool mkdir(const char* path);
+    bool mkdir(const String& path) { return mkdir(path.c_str()); }
+    bool rmdir(const char* path);
+    bool rmdir(const String& path) { return rmdir(path.c_str()); }
+
+    std::string hostPath(const char* path) const;
+    uint64_t usedBytes();
+};
+
+} // namespace fs
+
+using fs::FS;
+using fs::File;
+using fs::SeekMode;
+using fs::SeekSet;
+using fs::SeekCur;
+using fs::SeekEnd;
+
+const char* sim_fs_root();
+void sim_fs_set_root(const char* dir);
+
+#endif // SIM_FS_H
@@ -0,0 +1,31 @@
+/**
+ * @file      GxEPD2_BW.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Panel driver types for headers that name them; the simulator draws through sim_display
+ */
+
+#ifndef SIM_GXEPD2_BW_H
+#define SIM_GXEPD2_BW_H
+
+#include <Arduino.h>
+
+#define GxEPD_BLACK         0x0000
+#define GxEPD_WHITE         0xFFFF
+
+class GxEPD2_310_GDEQ031T10 {
+public:
+    static const uint16_t WIDTH = 240;
+    static const uint16_t HEIGHT = 320;
+};
+
+template <typename Driver, uint16_t PageHeight>
+class GxEPD2_BW : public Print {
+public:
+    Driver epd2;
+    size_t write(uint8_t c) override { return 1; }
+};
+
+#endif // SIM_GXEPD2_BW_H
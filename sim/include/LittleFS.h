@@ -0,0 +1,32 @@
+/**
+ * @file      LittleFS.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     LittleFS as the "littlefs" directory under the sim root
+ */
+
+#ifndef SIM_LITTLEFS_H
+#define SIM_LITTLEFS_H
+
+#include "FS.h"
+
+#define SIM_LITTLEFS_SIZE   (1536 * 1024)
+
+class LittleFSFS : public fs::FS {
+public:
+    LittleFSFS() : fs::FS("littlefs") {}
+    bool begin(bool format_on_fail = false, const char* base_path = "/littlefs", uint8_t max_open = 10,
+               const char* label = "spiffs") {
+        return true;
+    }
+    void end() {}
+    bool format();
+    size_t totalBytes() { return SIM_LITTLEFS_SIZE; }
+    size_t usedBytes() { return fs::FS::usedBytes(); }
+};
+
+extern LittleFSFS LittleFS;
+
+#endif // SIM_LITTLEFS_H
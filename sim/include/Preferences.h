@@ -0,0 +1,80 @@
+/**
+ * @file      Preferences.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     NVS key-value store, in memory for the life of the process
+ */
+
+#ifndef SIM_PREFERENCES_H
+#define SIM_PREFERENCES_H
+
+#include <Arduino.h>
+#include <string>
+
+/**
+ * Namespaces are kept in process memory, so every simulator run starts
+ * from a blank NVS as a freshly erased device would; benchmarks depend on
+ * that to be repeatable.
+ */
+
+class Preferences {
+private:
+    std::string ns;
+    bool opened;
+    bool read_only;
+
+    bool putRaw(const char* key, const void* value, size_t len);
+    size_t getRaw(const char* key, void* value, size_t len) const;
+
+public:
+    Preferences() : opened(false), read_only(false) {}
+
+    bool begin(const char* name, bool readOnly = false, const char* partition = NULL);
+    void end();
+    bool clear();
+    bool remove(const char* key);
+    bool isKey(const char* key);
+    size_t freeEntries();
+
+    size_t putBool(const char* key, bool value) { return putRaw(key, &value, sizeof(value)) ? sizeof(value) : 0; }
+    size_t putUChar(const char* key, uint8_t value) { return putRaw(key, &value, sizeof(value)) ? sizeof(value) : 0; }
+    size_t putUShort(const char* key, uint16_t value) { return putRaw(key, &value, sizeof(value)) ? sizeof(value) : 0; }
+    size_t putShort(const char* key, int16_t value) { return putRaw(key, &value, sizeof(value)) ? sizeof(value) : 0; }
+    size_t putInt(const char* key, int32_t value) { return putRaw(key, &value, sizeof(value)) ? sizeof(value) : 0; }
+    size_t putUInt(const char* key, uint32_t value) { return putRaw(key, &value, sizeof(value)) ? sizeof(value) : 0; }
+    size_t putLong(const char* key, int32_t value) { return putInt(key, value); }
+    size_t putULong(const char* key, uint32_t value) { return putUInt(key, value); }
+    size_t putLong64(const char* key, int64_t value) { return putRaw(key, &value, sizeof(value)) ? sizeof(value) : 0; }
+    size_t putULong64(const char* key, uint64_t value) { return putRaw(key, &value, sizeof(value)) ? sizeof(value) : 0; }
+    size_t putFloat(const char* key, float value) { return putRaw(key, &value, sizeof(value)) ? sizeof(value) : 0; }
+    size_t putDouble(const char* key, double value) { return putRaw(key, &value, sizeof(value)) ? sizeof(value) : 0; }
+    size_t putString(const char* key, const char* value) { return putRaw(key, value, strlen(value) + 1) ? strlen(value) : 0; }
+    size_t putString(const char* key, const String& value) { return putString(key, value.c_str()); }
+    size_t putBytes(const char* key, const void* value, size_t len) { return putRaw(key, value, len) ? len : 0; }
+
+    template <typename T>
+    T getScalar(const char* key, T default_value) const {
+        T value;
+        return getRaw(key, &value, sizeof(value)) == sizeof(value) ? value : default_value;
+    }
+    bool getBool(const char* key, bool default_value = false) { return getScalar(key, default_value); }
+    uint8_t getUChar(const char* key, uint8_t default_value = 0) { return getScalar(key, default_value); }
+    uint16_t getUShort(const char* key, uint16_t default_value = 0) { return getScalar(key, default_value); }
+    int16_t getShort(const char* key, int16_t default_value = 0) { return getScalar(key, default_value); }
+    int32_t getInt(const char* key, int32_t default_value = 0) { return getScalar(key, default_value); }
+    uint32_t getUInt(const char* key, uint32_t default_value = 0) { return getScalar(key, default_value); }
+    int32_t getLong(const char* key, int32_t default_value = 0) { return getInt(key, default_value); }
+    uint32_t getULong(const char* key, uint32_t default_value = 0) { return getUInt(key, default_value); }
+    int64_t getLong64(const char* key, int64_t default_value = 0) { return getScalar(key, default_value); }
+    uint64_t getULong64(const char* key, uint64_t default_value = 0) { return getScalar(key, default_value); }
+    float getFloat(const char* key, float default_value = NAN) { return getScalar(key, default_value); }
+    double getDouble(const char* key, double default_value = NAN) { return getScalar(key, default_value); }
+    String getString(const char* key, const String& default_value = String());
+    size_t getString(const char* key, char* value, size_t max_len);
+    size_t getBytesLength(const char* key);
+    size_t getBytes(const char* key, void* buf, size_t max_len) { return getRaw(key, buf, max_len); }
+};
+
+#endif // SIM_PREFERENCES_H
@@ -0,0 +1,46 @@
+/**
+ * @file      SD.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     SD card as the "sd" directory under the sim root
+ */
+
+#ifndef SIM_SD_H
+#define SIM_SD_H
+
+#include "FS.h"
+#include "SPI.h"
+
+typedef enum {
+    CARD_NONE,
+    CARD_MMC,
+    CARD_SD,
+    CARD_SDHC,
+    CARD_UNKNOWN,
+} sdcard_type_t;
+
+#define SIM_SD_CARD_SIZE    (16ULL * 1024 * 1024 * 1024)
+
+class SDFS : public fs::FS {
+private:
+    bool mounted;
+
+public:
+    SDFS() : fs::FS("sd"), mounted(false) {}
+    bool begin(uint8_t ss = 0, SPIClass& spi = SPI, uint32_t frequency = 4000000, const char* mountpoint = "/sd",
+               uint8_t max_files = 5, bool format_if_empty = false) {
+        mounted = true;
+        return true;
+    }
+    void end() { mounted = false; }
+    sdcard_type_t cardType() { return mounted ? CARD_SDHC : CARD_NONE; }
+    uint64_t cardSize() { return mounted ? SIM_SD_CARD_SIZE : 0; }
+    uint64_t totalBytes() { return cardSize(); }
+    uint64_t usedBytes() { return mounted ? fs::FS::usedBytes() : 0; }
+};
+
+extern SDFS SD;
+
+#endif // SIM_SD_H
@@ -0,0 +1,42 @@
+/**
+ * @file      SPI.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     SPI bus stand-in; nothing is attached in the simulator
+ */
+
+#ifndef SIM_SPI_H
+#define SIM_SPI_H
+
+#include <Arduino.h>
+
+#define SPI_MODE0           0
+#define SPI_MODE1           1
+#define SPI_MODE2           2
+#define SPI_MODE3           3
+#define MSBFIRST            1
+#define LSBFIRST            0
+
+class SPISettings {
+public:
+    SPISettings() {}
+    SPISettings(uint32_t clock, uint8_t bit_order, uint8_t data_mode) {}
+};
+
+class SPIClass {
+public:
+    void begin(int8_t sck = -1, int8_t miso = -1, int8_t mosi = -1, int8_t ss = -1) {}
+    void end() {}
+    void beginTransaction(SPISettings settings) {}
+    void endTransaction() {}
+    uint8_t transfer(uint8_t data) { return 0xFF; }
+    void transfer(void* data, uint32_t size) { memset(data, 0xFF, size); }
+    void writeBytes(const uint8_t* data, uint32_t size) {}
+    void setFrequency(uint32_t freq) {}
+};
+
+extern SPIClass SPI;
+
+#endif // SIM_SPI_H
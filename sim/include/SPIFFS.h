@@ -0,0 +1,17 @@
+/**
+ * @file      SPIFFS.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     SPIFFS shares the LittleFS directory in the simulator
+ */
+
+#ifndef SIM_SPIFFS_H
+#define SIM_SPIFFS_H
+
+#include "LittleFS.h"
+
+#define SPIFFS LittleFS
+
+#endif // SIM_SPIFFS_H
@@ -0,0 +1,55 @@
+/**
+ * @file      Stream.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Arduino Stream for the simulator
+ */
+
+#ifndef SIM_STREAM_H
+#define SIM_STREAM_H
+
+#include "Print.h"
+
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+
+    void setTimeout(unsigned long ms) {}
+
+    virtual size_t readBytes(char* buf, size_t len) {
+        size_t n = 0;
+        while (n < len) {
+            int c = read();
+            if (c < 0) {
+                break;
+            }
+            buf[n++] = (char)c;
+        }
+        return n;
+    }
+    size_t readBytes(uint8_t* buf, size_t len) { return readBytes((char*)buf, len); }
+
+    String readStringUntil(char terminator) {
+        String out;
+        int c;
+        while ((c = read()) >= 0 && c != terminator) {
+            out += (char)c;
+        }
+        return out;
+    }
+
+    String readString() {
+        String out;
+        int c;
+        while ((c = read()) >= 0) {
+            out += (char)c;
+        }
+        return out;
+    }
+};
+
+#endif // SIM_STREAM_H
@@ -0,0 +1,21 @@
+/**
+ * @file      TouchDrvCSTXXX.hpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Touch controller type for headers that name it; input comes from sim_display
+ */
+
+#ifndef SIM_TOUCHDRVCSTXXX_HPP
+#define SIM_TOUCHDRVCSTXXX_HPP
+
+#include <Arduino.h>
+
+class TouchDrvCSTXXX {
+public:
+    uint8_t getPoint(int16_t* x, int16_t* y, uint8_t max = 1) { return 0; }
+    bool isPressed() { return false; }
+};
+
+#endif // SIM_TOUCHDRVCSTXXX_HPP
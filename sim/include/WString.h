@@ -0,0 +1,159 @@
+/**
+ * @file      WString.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Arduino String for the simulator, on std::string
+ */
+
+#ifndef SIM_WSTRING_H
+#define SIM_WSTRING_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <string>
+
+class String {
+private:
+    std::string s;
+
+    static std::string fmt(const char* f, double v) {
+        char buf[64];
+        snprintf(buf, sizeof(buf), f, v);
+        return buf;
+    }
+
+public:
+    String() {}
+    String(const char* c) : s(c ? c : "") {}
+    String(const char* c, size_t n) : s(c, n) {}
+    String(const std::string& str) : s(str) {}
+    String(char c) : s(1, c) {}
+    String(int v, unsigned char base = 10) : s(base == 10 ? std::to_string(v) : toBase((unsigned long)v, base)) {}
+    String(unsigned int v, unsigned char base = 10) : s(toBase(v, base)) {}
+    String(long v, unsigned char base = 10) : s(base == 10 ? std::to_string(v) : toBase((unsigned long)v, base)) {}
+    String(unsigned long v, unsigned char base = 10) : s(toBase(v, base)) {}
+    String(long long v) : s(std::to_string(v)) {}
+    String(unsigned long long v) : s(std::to_string(v)) {}
+    String(float v, unsigned int decimals = 2) : s(fmt(("%." + std::to_string(decimals) + "f").c_str(), v)) {}
+    String(double v, unsigned int decimals = 2) : s(fmt(("%." + std::to_string(decimals) + "f").c_str(), v)) {}
+
+    static std::string toBase(unsigned long v, unsigned char base) {
+        if (v == 0) {
+            return "0";
+        }
+        std::string out;
+        while (v) {
+            int d = v % base;
+            out.insert(out.begin(), (char)(d < 10 ? '0' + d : 'a' + d - 10));
+            v /= base;
+        }
+        return out;
+    }
+
+    const char* c_str() const { return s.c_str(); }
+    unsigned int length() const { return s.length(); }
+    bool isEmpty() const { return s.empty(); }
+    bool reserve(unsigned int n) { s.reserve(n); return true; }
+    char charAt(unsigned int i) const { return i < s.length() ? s[i] : 0; }
+    void setCharAt(unsigned int i, char c) { if (i < s.length()) s[i] = c; }
+    char operator[](unsigned int i) const { return charAt(i); }
+    char& operator[](unsigned int i) { return s[i]; }
+
+    String& operator=(const char* c) { s = c ? c : ""; return *this; }
+    String& operator+=(const String& o) { s += o.s; return *this; }
+    String& operator+=(const char* c) { if (c) s += c; return *this; }
+    String& operator+=(char c) { s += c; return *this; }
+    String& operator+=(int v) { s += std::to_string(v); return *this; }
+    String& operator+=(unsigned int v) { s += std::to_string(v); return *this; }
+    String& operator+=(long v) { s += std::to_string(v); return *this; }
+    String& operator+=(unsigned long v) { s += std::to_string(v); return *this; }
+    String& operator+=(float v) { s += String(v).s; return *this; }
+    String& operator+=(double v) { s += String(v).s; return *this; }
+    bool concat(const String& o) { s += o.s; return true; }
+    bool concat(const char* c) { if (c) s += c; return true; }
+    bool concat(const char* c, size_t n) { s.append(c, n); return true; }
+    bool concat(char c) { s += c; return true; }
+    bool concat(int v) { s += std::to_string(v); return true; }
+    bool concat(unsigned int v) { s += std::to_string(v); return true; }
+    bool concat(long v) { s += std::to_string(v); return true; }
+    bool concat(unsigned long v) { s += std::to_string(v); return true; }
+    bool concat(float v) { s += String(v).s; return true; }
+    bool concat(double v) { s += String(v).s; return true; }
+
+    friend String operator+(const String& a, const String& b) { return String(a.s + b.s); }
+    friend String operator+(const String& a, const char* b) { return String(a.s + (b ? b : "")); }
+    friend String operator+(const char* a, const String& b) { return String((a ? a : "") + b.s); }
+    friend String operator+(const String& a, char b) { return String(a.s + b); }
+    friend String operator+(const String& a, int b) { return String(a.s + std::to_string(b)); }
+    friend String operator+(const String& a, unsigned int b) { return String(a.s + std::to_string(b)); }
+    friend String operator+(const String& a, long b) { return String(a.s + std::to_string(b)); }
+    friend String operator+(const String& a, unsigned long b) { return String(a.s + std::to_string(b)); }
+    friend String operator+(const String& a, float b) { return String(a.s + String(b).s); }
+    friend String operator+(const String& a, double b) { return String(a.s + String(b).s); }
+
+    int compareTo(const String& o) const { return s.compare(o.s); }
+    bool equals(const String& o) const { return s == o.s; }
+    bool equals(const char* c) const { return s == (c ? c : ""); }
+    bool equalsIgnoreCase(const String& o) const { return strcasecmp(s.c_str(), o.s.c_str()) == 0; }
+    bool operator==(const String& o) const { return s == o.s; }
+    bool operator==(const char* c) const { return equals(c); }
+    bool operator!=(const String& o) const { return s != o.s; }
+    bool operator!=(const char* c) const { return !equals(c); }
+    bool operator<(const String& o) const { return s < o.s; }
+    bool operator>(const String& o) const { return s > o.s; }
+    bool startsWith(const String& p) const { return s.compare(0, p.s.length(), p.s) == 0; }
+    bool startsWith(const String& p, unsigned int off) const { return off <= s.length() && s.compare(off, p.s.length(), p.s) == 0; }
+    bool endsWith(const String& p) const {
+        return s.length() >= p.s.length() && s.compare(s.length() - p.s.length(), p.s.length(), p.s) == 0;
+    }
+
+    int indexOf(char c, unsigned int from = 0) const { size_t i = s.find(c, from); return i == std::string::npos ? -1 : (int)i; }
+    int indexOf(const String& o, unsigned int from = 0) const { size_t i = s.find(o.s, from); return i == std::string::npos ? -1 : (int)i; }
+    int lastIndexOf(char c) const { size_t i = s.rfind(c); return i == std::string::npos ? -1 : (int)i; }
+    int lastIndexOf(const String& o) const { size_t i = s.rfind(o.s); return i == std::string::npos ? -1 : (int)i; }
+    String substring(unsigned int from) const { return from >= s.length() ? String() : String(s.substr(from)); }
+    String substring(unsigned int from, unsigned int to) const {
+        if (from > to) std::swap(from, to);
+        if (from >= s.length()) return String();
+        return String(s.substr(from, to - from));
+    }
+
+    void replace(const String& a, const String& b) {
+        if (a.s.empty()) return;
+        size_t pos = 0;
+        while ((pos = s.find(a.s, pos)) != std::string::npos) {
+            s.replace(pos, a.s.length(), b.s);
+            pos += b.s.length();
+        }
+    }
+    void replace(char a, char b) { for (auto& c : s) if (c == a) c = b; }
+    void remove(unsigned int index) { if (index < s.length()) s.erase(index); }
+    void remove(unsigned int index, unsigned int count) { if (index < s.length()) s.erase(index, count); }
+    void toLowerCase() { for (auto& c : s) c = tolower((unsigned char)c); }
+    void toUpperCase() { for (auto& c : s) c = toupper((unsigned char)c); }
+    void trim() {
+        size_t b = s.find_first_not_of(" \t\r\n");
+        size_t e = s.find_last_not_of(" \t\r\n");
+        s = (b == std::string::npos) ? std::string() : s.substr(b, e - b + 1);
+    }
+
+    long toInt() const { return atol(s.c_str()); }
+    float toFloat() const { return atof(s.c_str()); }
+    double toDouble() const { return atof(s.c_str()); }
+    void toCharArray(char* buf, unsigned int size, unsigned int index = 0) const {
+        if (!size) return;
+        strncpy(buf, index < s.length() ? s.c_str() + index : "", size - 1);
+        buf[size - 1] = 0;
+    }
+    void getBytes(unsigned char* buf, unsigned int size, unsigned int index = 0) const {
+        toCharArray((char*)buf, size, index);
+    }
+};
+
+#endif // SIM_WSTRING_H
@@ -0,0 +1,66 @@
+/**
+ * @file      WiFi.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     WiFi station state, set by the simulator instead of a radio
+ */
+
+#ifndef SIM_WIFI_H
+#define SIM_WIFI_H
+
+#include <Arduino.h>
+
+typedef enum {
+    WL_NO_SHIELD = 255,
+    WL_IDLE_STATUS = 0,
+    WL_NO_SSID_AVAIL,
+    WL_SCAN_COMPLETED,
+    WL_CONNECTED,
+    WL_CONNECT_FAILED,
+    WL_CONNECTION_LOST,
+    WL_DISCONNECTED,
+} wl_status_t;
+
+typedef enum {
+    WIFI_OFF = 0,
+    WIFI_STA,
+    WIFI_AP,
+    WIFI_AP_STA,
+} wifi_mode_t;
+
+typedef enum {
+    WIFI_AUTH_OPEN = 0,
+    WIFI_AUTH_WEP,
+    WIFI_AUTH_WPA_PSK,
+    WIFI_AUTH_WPA2_PSK,
+    WIFI_AUTH_WPA_WPA2_PSK,
+    WIFI_AUTH_WPA2_ENTERPRISE,
+    WIFI_AUTH_WPA3_PSK,
+    WIFI_AUTH_WPA2_WPA3_PSK,
+} wifi_auth_mode_t;
+
+class WiFiClass {
+private:
+    wl_status_t state;
+    int8_t rssi;
+
+public:
+    WiFiClass() : state(WL_DISCONNECTED), rssi(-60) {}
+
+    wl_status_t status() { return state; }
+    bool isConnected() { return state == WL_CONNECTED; }
+    int8_t RSSI() { return state == WL_CONNECTED ? rssi : 0; }
+    bool mode(wifi_mode_t m) { return true; }
+    wl_status_t begin(const char* ssid, const char* pass = NULL) { return state; }
+    bool disconnect(bool wifioff = false) { state = WL_DISCONNECTED; return true; }
+    String SSID() { return state == WL_CONNECTED ? String("sim") : String(); }
+
+    // Simulator control
+    void simSetState(wl_status_t s, int8_t r = -60) { state = s; rssi = r; }
+};
+
+extern WiFiClass WiFi;
+
+#endif // SIM_WIFI_H
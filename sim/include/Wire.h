@@ -0,0 +1,32 @@
+/**
+ * @file      Wire.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     I2C bus stand-in; every device NACKs
+ */
+
+#ifndef SIM_WIRE_H
+#define SIM_WIRE_H
+
+#include <Arduino.h>
+
+class TwoWire : public Stream {
+public:
+    bool begin(int sda = -1, int scl = -1, uint32_t frequency = 0) { return true; }
+    bool end() { return true; }
+    void setClock(uint32_t frequency) {}
+    void beginTransmission(uint16_t address) {}
+    uint8_t endTransmission(bool send_stop = true) { return 2; }
+    uint8_t requestFrom(uint16_t address, uint8_t size, bool send_stop = true) { return 0; }
+    size_t write(uint8_t c) override { return 1; }
+    size_t write(const uint8_t* buf, size_t len) override { return len; }
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+};
+
+extern TwoWire Wire;
+
+#endif // SIM_WIRE_H
@@ -0,0 +1,23 @@
+/**
+ * @file      esp_attr.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Section attributes, empty on the host
+ */
+
+#ifndef SIM_ESP_ATTR_H
+#define SIM_ESP_ATTR_H
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define EXT_RAM_ATTR
+#define RTC_DATA_ATTR
+#define RTC_NOINIT_ATTR
+#define RTC_IRAM_ATTR
+#define RTC_FAST_ATTR
+#define RTC_SLOW_ATTR
+#define NOINLINE_ATTR __attribute__((noinline))
+
+#endif // SIM_ESP_ATTR_H
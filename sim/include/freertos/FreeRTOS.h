@@ -0,0 +1,86 @@
+/**
+ * @file      FreeRTOS.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     FreeRTOS types and critical sections on POSIX threads
+ */
+
+#ifndef SIM_FREERTOS_H
+#define SIM_FREERTOS_H
+
+/**
+ * Tasks are threads and ticks are milliseconds of the sim clock. Core
+ * affinity and priorities are recorded but the host scheduler decides;
+ * the simulator is for counting work and finding regressions, not for
+ * reproducing the device's timing. A portMUX is a recursive mutex, so a
+ * critical section blocks other tasks but not interrupts, of which there
+ * are none.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+typedef uint32_t StackType_t;
+
+#define pdFALSE                     ((BaseType_t)0)
+#define pdTRUE                      ((BaseType_t)1)
+#define pdPASS                      pdTRUE
+#define pdFAIL                      pdFALSE
+#define errQUEUE_EMPTY              ((BaseType_t)0)
+#define errQUEUE_FULL               ((BaseType_t)0)
+
+#define configTICK_RATE_HZ          1000
+#define configMAX_PRIORITIES        25
+#define configMAX_TASK_NAME_LEN     16
+#define configMINIMAL_STACK_SIZE    768
+#define portNUM_PROCESSORS          2
+#define portMAX_DELAY               ((TickType_t)0xffffffffUL)
+#define portTICK_PERIOD_MS          ((TickType_t)1000 / configTICK_RATE_HZ)
+#define portTICK_RATE_MS            portTICK_PERIOD_MS
+#define pdMS_TO_TICKS(ms)           ((TickType_t)(((TickType_t)(ms) * (TickType_t)configTICK_RATE_HZ) / (TickType_t)1000U))
+#define tskIDLE_PRIORITY            ((UBaseType_t)0U)
+#define tskNO_AFFINITY              0x7FFFFFFF
+
+typedef struct {
+    pthread_mutex_t lock;
+} portMUX_TYPE;
+
+#ifdef PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP
+#define portMUX_INITIALIZER_UNLOCKED { PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP }
+#else
+#define portMUX_INITIALIZER_UNLOCKED { PTHREAD_RECURSIVE_MUTEX_INITIALIZER }
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void vPortCPUInitializeMutex(portMUX_TYPE* mux);
+BaseType_t xPortInIsrContext(void);
+BaseType_t xPortGetCoreID(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#define portMUX_INITIALIZE(mux)         vPortCPUInitializeMutex(mux)
+#define portENTER_CRITICAL(mux)         pthread_mutex_lock(&(mux)->lock)
+#define portEXIT_CRITICAL(mux)          pthread_mutex_unlock(&(mux)->lock)
+#define portENTER_CRITICAL_ISR(mux)     portENTER_CRITICAL(mux)
+#define portEXIT_CRITICAL_ISR(mux)      portEXIT_CRITICAL(mux)
+#define portENTER_CRITICAL_SAFE(mux)    portENTER_CRITICAL(mux)
+#define portEXIT_CRITICAL_SAFE(mux)     portEXIT_CRITICAL(mux)
+#define taskENTER_CRITICAL(mux)         portENTER_CRITICAL(mux)
+#define taskEXIT_CRITICAL(mux)          portEXIT_CRITICAL(mux)
+#define taskENTER_CRITICAL_ISR(mux)     portENTER_CRITICAL(mux)
+#define taskEXIT_CRITICAL_ISR(mux)      portEXIT_CRITICAL(mux)
+#define portYIELD_FROM_ISR(...)         do { } while (0)
+#define portYIELD()                     taskYIELD()
+
+#endif // SIM_FREERTOS_H
@@ -0,0 +1,44 @@
+/**
+ * @file      queue.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     FreeRTOS queues as copied-item rings under a mutex
+ */
+
+#ifndef SIM_FREERTOS_QUEUE_H
+#define SIM_FREERTOS_QUEUE_H
+
+#include "FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct SimQueue* QueueHandle_t;
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size);
+void vQueueDelete(QueueHandle_t queue);
+BaseType_t xQueueGenericSend(QueueHandle_t queue, const void* item, TickType_t ticks, BaseType_t front);
+BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t ticks);
+BaseType_t xQueuePeek(QueueHandle_t queue, void* item, TickType_t ticks);
+BaseType_t xQueueOverwrite(QueueHandle_t queue, const void* item);
+BaseType_t xQueueReset(QueueHandle_t queue);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue);
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t queue);
+
+#define xQueueSend(q, item, ticks)                  xQueueGenericSend((q), (item), (ticks), pdFALSE)
+#define xQueueSendToBack(q, item, ticks)            xQueueGenericSend((q), (item), (ticks), pdFALSE)
+#define xQueueSendToFront(q, item, ticks)           xQueueGenericSend((q), (item), (ticks), pdTRUE)
+#define xQueueSendFromISR(q, item, woken)           xQueueGenericSend((q), (item), 0, pdFALSE)
+#define xQueueSendToBackFromISR(q, item, woken)     xQueueGenericSend((q), (item), 0, pdFALSE)
+#define xQueueOverwriteFromISR(q, item, woken)      xQueueOverwrite((q), (item))
+#define xQueueReceiveFromISR(q, item, woken)        xQueueReceive((q), (item), 0)
+#define uxQueueMessagesWaitingFromISR(q)            uxQueueMessagesWaiting(q)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SIM_FREERTOS_QUEUE_H
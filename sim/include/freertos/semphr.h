@@ -0,0 +1,41 @@
+/**
+ * @file      semphr.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     FreeRTOS semaphores and mutexes on the simulated queues
+ */
+
+#ifndef SIM_FREERTOS_SEMPHR_H
+#define SIM_FREERTOS_SEMPHR_H
+
+#include "queue.h"
+#include "task.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef QueueHandle_t SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max, UBaseType_t initial);
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex(void);
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem);
+BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t sem, TickType_t ticks);
+BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t sem);
+UBaseType_t uxSemaphoreGetCount(SemaphoreHandle_t sem);
+TaskHandle_t xSemaphoreGetMutexHolder(SemaphoreHandle_t sem);
+
+#define xSemaphoreCreateBinary()                    xSemaphoreCreateCounting(1, 0)
+#define xSemaphoreGiveFromISR(sem, woken)           xSemaphoreGive(sem)
+#define xSemaphoreTakeFromISR(sem, woken)           xSemaphoreTake((sem), 0)
+#define vSemaphoreDelete(sem)                       vQueueDelete(sem)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SIM_FREERTOS_SEMPHR_H
@@ -0,0 +1,36 @@
+/**
+ * @file      multi_heap.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     IDF multi_heap API over a caller's buffer, first fit with coalescing
+ */
+
+#ifndef SIM_MULTI_HEAP_H
+#define SIM_MULTI_HEAP_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_heap_caps.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct multi_heap_info* multi_heap_handle_t;
+
+multi_heap_handle_t multi_heap_register(void* start, size_t size);
+void* multi_heap_malloc(multi_heap_handle_t heap, size_t size);
+void* multi_heap_realloc(multi_heap_handle_t heap, void* ptr, size_t size);
+void multi_heap_free(multi_heap_handle_t heap, void* ptr);
+size_t multi_heap_get_allocated_size(multi_heap_handle_t heap, void* ptr);
+size_t multi_heap_free_size(multi_heap_handle_t heap);
+size_t multi_heap_minimum_free_size(multi_heap_handle_t heap);
+void multi_heap_get_info(multi_heap_handle_t heap, multi_heap_info_t* info);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SIM_MULTI_HEAP_H
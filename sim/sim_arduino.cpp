@@ -0,0 +1,213 @@
+/**
+ * @file      sim_arduino.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Arduino core, clock and ESP-IDF system calls for the simulator
+ */
+
+#include <Arduino.h>
+#include <esp_timer.h>
+#include <esp_rom_crc.h>
+#include <SPI.h>
+#include <Wire.h>
+#include <WiFi.h>
+#include "sim_clock.h"
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <random>
+#include <thread>
+
+HardwareSerial Serial;
+EspClass ESP;
+SPIClass SPI;
+TwoWire Wire;
+WiFiClass WiFi;
+
+// ===== Clock =====
+
+static const auto host_start = std::chrono::steady_clock::now();
+static std::atomic<bool> clock_manual(false);
+static std::atomic<uint64_t> manual_us(0);
+static std::atomic<int64_t> host_offset_us(0);      // Added to host time while not manual
+
+uint64_t sim_host_us() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - host_start).count();
+}
+
+uint64_t sim_clock_us() {
+    if (clock_manual.load(std::memory_order_acquire)) {
+        return manual_us.load(std::memory_order_relaxed);
+    }
+    return sim_host_us() + host_offset_us.load(std::memory_order_relaxed);
+}
+
+void sim_clock_set_manual(bool manual) {
+    if (manual == clock_manual.load()) {
+        return;
+    }
+    if (manual) {
+        manual_us.store(sim_clock_us());
+        clock_manual.store(true, std::memory_order_release);
+    } else {
+        host_offset_us.store((int64_t)manual_us.load() - (int64_t)sim_host_us());
+        clock_manual.store(false, std::memory_order_release);
+    }
+}
+
+bool sim_clock_is_manual() {
+    return clock_manual.load();
+}
+
+void sim_clock_advance(uint32_t ms) {
+    manual_us.fetch_add((uint64_t)ms * 1000);
+}
+
+extern "C" unsigned long millis(void) {
+    return (unsigned long)(uint32_t)(sim_clock_us() / 1000);
+}
+
+extern "C" unsigned long micros(void) {
+    return (unsigned long)(uint32_t)sim_clock_us();
+}
+
+extern "C" int64_t esp_timer_get_time(void) {
+    return (int64_t)sim_clock_us();
+}
+
+extern "C" void delay(uint32_t ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+extern "C" void delayMicroseconds(uint32_t us) {
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+extern "C" void yield(void) {
+    std::this_thread::yield();
+}
+
+extern "C" bool getLocalTime(struct tm* info, uint32_t ms) {
+    // No SNTP in the simulator, so the clock is never set
+    return false;
+}
+
+extern "C" uint32_t getCpuFrequencyMhz(void) {
+    return 240;
+}
+
+// ===== GPIO: nothing is wired =====
+
+extern "C" void pinMode(uint8_t pin, uint8_t mode) {}
+extern "C" void digitalWrite(uint8_t pin, uint8_t val) {}
+extern "C" int digitalRead(uint8_t pin) { return HIGH; }
+extern "C" int analogRead(uint8_t pin) { return 0; }
+extern "C" void attachInterrupt(uint8_t pin, void (*isr)(void), int mode) {}
+extern "C" void detachInterrupt(uint8_t pin) {}
+
+// ===== Random, seeded so runs repeat =====
+
+static std::mt19937 rng(0x7DEC);
+static std::mutex rng_mutex;
+
+extern "C" uint32_t esp_random(void) {
+    std::lock_guard<std::mutex> lock(rng_mutex);
+    return rng();
+}
+
+extern "C" void esp_fill_random(void* buf, size_t len) {
+    uint8_t* p = (uint8_t*)buf;
+    while (len--) {
+        *p++ = (uint8_t)esp_random();
+    }
+}
+
+long random(long max) {
+    return max > 0 ? esp_random() % max : 0;
+}
+
+long random(long min, long max) {
+    return max > min ? min + random(max - min) : min;
+}
+
+void randomSeed(unsigned long seed) {
+    std::lock_guard<std::mutex> lock(rng_mutex);
+    rng.seed(seed);
+}
+
+long map(long x, long in_min, long in_max, long out_min, long out_max) {
+    return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+
+// ===== System =====
+
+extern "C" const char* esp_err_to_name(esp_err_t code) {
+    switch (code) {
+        case ESP_OK:                return "ESP_OK";
+        case ESP_ERR_NO_MEM:        return "ESP_ERR_NO_MEM";
+        case ESP_ERR_INVALID_ARG:   return "ESP_ERR_INVALID_ARG";
+        case ESP_ERR_INVALID_STATE: return "ESP_ERR_INVALID_STATE";
+        case ESP_ERR_NOT_FOUND:     return "ESP_ERR_NOT_FOUND";
+        case ESP_ERR_TIMEOUT:       return "ESP_ERR_TIMEOUT";
+        default:                    return "ESP_FAIL";
+    }
+}
+
+extern "C" void esp_restart(void) {
+    fprintf(stderr, "[sim] esp_restart()\n");
+    exit(0);
+}
+
+extern "C" uint32_t esp_get_free_heap_size(void) {
+    return heap_caps_get_free_size(MALLOC_CAP_8BIT);
+}
+
+extern "C" uint32_t esp_get_minimum_free_heap_size(void) {
+    return heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+}
+
+uint32_t EspClass::getFreeHeap() { return heap_caps_get_free_size(MALLOC_CAP_INTERNAL); }
+uint32_t EspClass::getMinFreeHeap() { return heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL); }
+uint32_t EspClass::getMaxAllocHeap() { return heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL); }
+uint32_t EspClass::getHeapSize() { return heap_caps_get_total_size(MALLOC_CAP_INTERNAL); }
+uint32_t EspClass::getPsramSize() { return heap_caps_get_total_size(MALLOC_CAP_SPIRAM); }
+uint32_t EspClass::getFreePsram() { return heap_caps_get_free_size(MALLOC_CAP_SPIRAM); }
+uint32_t EspClass::getCycleCount() { return (uint32_t)(sim_host_us() * getCpuFrequencyMhz()); }
+void EspClass::restart() { esp_restart(); }
+
+// ===== ROM CRC, same polynomials and conventions as the ESP32-S3 ROM =====
+
+extern "C" uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t* buf, uint32_t len) {
+    crc = ~crc;
+    while (len--) {
+        crc ^= *buf++;
+        for (int k = 0; k < 8; k++) {
+            crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+extern "C" uint16_t esp_rom_crc16_le(uint16_t crc, const uint8_t* buf, uint32_t len) {
+    crc = ~crc;
+    while (len--) {
+        crc ^= *buf++;
+        for (int k = 0; k < 8; k++) {
+            crc = (crc >> 1) ^ (0x8408 & (0 - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+extern "C" uint8_t esp_rom_crc8_le(uint8_t crc, const uint8_t* buf, uint32_t len) {
+    crc = ~crc;
+    while (len--) {
+        crc ^= *buf++;
+        for (int k = 0; k < 8; k++) {
+            crc = (crc >> 1) ^ (0x8C & (0 - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
@@ -0,0 +1,214 @@
+/**
+ * @file      sim_bench.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     UI action and event throughput benchmarks
+ */
+
+#include "sim_bench.h"
+#include "sim_clock.h"
+#include "sim_display.h"
+#include "ui_deckpro.h"
+#include "integration/event_bridge.h"
+
+enum SimActionOp {
+    SIM_PUSH,
+    SIM_POP,
+    SIM_REDRAW,
+};
+
+struct SimAction {
+    const char* name;
+    SimActionOp op;
+    int id;
+};
+
+// Every launcher entry in and out, and the two list screens one level down
+static const SimAction ui_script[] = {
+    {"redraw menu",     SIM_REDRAW, 0},
+    {"open lora",       SIM_PUSH,   SCREEN1_ID},
+    {"back",            SIM_POP,    0},
+    {"open settings",   SIM_PUSH,   SCREEN2_ID},
+    {"open about",      SIM_PUSH,   SCREEN2_1_ID},
+    {"back",            SIM_POP,    0},
+    {"back",            SIM_POP,    0},
+    {"open gps",        SIM_PUSH,   SCREEN3_ID},
+    {"back",            SIM_POP,    0},
+    {"open wifi",       SIM_PUSH,   SCREEN4_ID},
+    {"open wifi scan",  SIM_PUSH,   SCREEN4_2_ID},
+    {"back",            SIM_POP,    0},
+    {"back",            SIM_POP,    0},
+    {"open test",       SIM_PUSH,   SCREEN5_ID},
+    {"back",            SIM_POP,    0},
+    {"open battery",    SIM_PUSH,   SCREEN6_ID},
+    {"open bq27220",    SIM_PUSH,   SCREEN6_2_ID},
+    {"back",            SIM_POP,    0},
+    {"back",            SIM_POP,    0},
+    {"open input",      SIM_PUSH,   SCREEN7_ID},
+    {"back",            SIM_POP,    0},
+    {"open a7682e",     SIM_PUSH,   SCREEN8_ID},
+    {"back",            SIM_POP,    0},
+    {"open pcm5102",    SIM_PUSH,   SCREEN10_ID},
+    {"back",            SIM_POP,    0},
+};
+
+struct SimBenchEvent {
+    uint32_t seq;
+    uint32_t a;
+    uint32_t b;
+    uint32_t c;
+};
+
+static uint32_t events_delivered = 0;
+static uint16_t events_last_size = 0;
+
+static void bench_event_handler(const Event& event, void* context) {
+    events_delivered++;
+    events_last_size = event.getPayloadSize();
+}
+
+bool sim_bench_ui_begin() {
+    if (!sim_display_begin()) {
+        return false;
+    }
+    ui_deckpro_entry();
+    sim_display_settle();
+    return true;
+}
+
+static void run_action(const SimAction& action) {
+    switch (action.op) {
+        case SIM_PUSH:   scr_mgr_push(action.id, true); break;
+        case SIM_POP:    scr_mgr_pop(true); break;
+        case SIM_REDRAW: lv_obj_invalidate(lv_scr_act()); break;
+    }
+}
+
+bool sim_bench_ui(Print& out, const char* frames_dir) {
+    bool manual = sim_clock_is_manual();
+    sim_clock_set_manual(true);
+
+    const char* passes[] = {"cold", "warm"};
+    SimDisplayStats total;
+    uint32_t total_ms = 0;
+
+    for (int pass = 0; pass < 2; pass++) {
+        out.printf("\nUI actions, %s\n", passes[pass]);
+        out.printf("%-16s %7s %8s %10s %8s %10s\n", "action", "frames", "flushes", "pixels", "sim ms", "render us");
+        memset(&total, 0, sizeof(total));
+        total_ms = 0;
+
+        for (size_t i = 0; i < sizeof(ui_script) / sizeof(ui_script[0]); i++) {
+            SimDisplayStats stats;
+            sim_display_reset_stats();
+            run_action(ui_script[i]);
+            uint32_t ms = sim_display_settle();
+            sim_display_get_stats(&stats);
+
+            out.printf("%-16s %7lu %8lu %10llu %8lu %10llu\n", ui_script[i].name, (unsigned long)stats.frames,
+                       (unsigned long)stats.flushes, (unsigned long long)stats.pixels, (unsigned long)ms,
+                       (unsigned long long)stats.render_us);
+            total.frames += stats.frames;
+            total.flushes += stats.flushes;
+            total.pixels += stats.pixels;
+            total.render_us += stats.render_us;
+            total_ms += ms;
+
+            if (frames_dir) {
+                char path[256];
+                snprintf(path, sizeof(path), "%s/%s_%02u.pbm", frames_dir, passes[pass], (unsigned)i);
+                sim_display_save_pbm(path);
+            }
+        }
+        out.printf("%-16s %7lu %8lu %10llu %8lu %10llu\n", "total", (unsigned long)total.frames,
+                   (unsigned long)total.flushes, (unsigned long long)total.pixels, (unsigned long)total_ms,
+                   (unsigned long long)total.render_us);
+    }
+
+    sim_clock_set_manual(manual);
+    return true;
+}
+
+// One publish-and-dispatch run; typed carries a 16 byte payload through the slab pool
+static bool bench_event_run(Print& out, const char* name, bool typed) {
+    EventBridge bridge;
+    if (!bridge.initialize()) {
+        return false;
+    }
+    bridge.subscribe("bench", EventType::USER_INPUT, bench_event_handler);
+    events_delivered = 0;
+
+    uint32_t rejected = 0;
+    uint64_t start = sim_host_us();
+    for (uint32_t i = 0; i < SIM_BENCH_EVENTS; i++) {
+        SimBenchEvent payload = {i, i * 3, i * 5, i * 7};
+        bool ok = typed ? bridge.publishTypedEvent(EventType::USER_INPUT, "bench", payload)
+                        : bridge.tryPublish(EventType::USER_INPUT, "bench", i);
+        if (!ok) {
+            rejected++;
+            bridge.processEvents();
+        }
+        if (i % SIM_BENCH_EVENT_BATCH == SIM_BENCH_EVENT_BATCH - 1) {
+            bridge.processEvents();
+        }
+    }
+    while (bridge.getQueueSize() > 0) {
+        bridge.processEvents();
+    }
+    uint64_t us = sim_host_us() - start;
+    bridge.shutdown();
+
+    uint64_t ns = us * 1000 / SIM_BENCH_EVENTS;
+    out.printf("%-12s %9lu %9lu %9lu %8llu %12llu\n", name, (unsigned long)SIM_BENCH_EVENTS,
+               (unsigned long)events_delivered, (unsigned long)rejected, (unsigned long long)ns,
+               (unsigned long long)(us ? (uint64_t)SIM_BENCH_EVENTS * 1000000 / us : 0));
+    return events_delivered + rejected >= SIM_BENCH_EVENTS;
+}
+
+// A LATEST event queued with a slab payload, then a raw payload too big for
+// the slab from the same source: it must be dropped, not copied over it
+static bool check_event_latest_oversize(Print& out) {
+    EventBridge bridge;
+    if (!bridge.initialize()) {
+        return false;
+    }
+    bridge.subscribe("bench", EventType::USER_INPUT, bench_event_handler);
+    bridge.setDeliveryPolicy(EventType::USER_INPUT, EventDeliveryPolicy::LATEST);
+    events_delivered = 0;
+    events_last_size = 0;
+
+    static uint8_t payload[EVENT_SLAB_BLOCK_SIZE + 64];
+    memset(payload, 0xA5, sizeof(payload));
+    uint16_t source = EventBridge::internSource("bench");
+    bool queued = bridge.publishPayload(EventType::USER_INPUT, source, EventPriority::NORMAL, nullptr,
+                                        payload, EVENT_INLINE_PAYLOAD * 2);
+    bool oversize = bridge.publishPayload(EventType::USER_INPUT, source, EventPriority::NORMAL, nullptr,
+                                          payload, sizeof(payload));
+    while (bridge.getQueueSize() > 0) {
+        bridge.processEvents();
+    }
+    uint32_t coalesced = bridge.getEventsCoalesced();
+    bridge.shutdown();
+
+    bool ok = queued && !oversize && coalesced == 0 && events_delivered == 1 &&
+              events_last_size == EVENT_INLINE_PAYLOAD * 2;
+    out.printf("%-12s %s\n", "latest >slab", ok ? "dropped" : "FAILED");
+    return ok;
+}
+
+bool sim_bench_events(Print& out) {
+    bool manual = sim_clock_is_manual();
+    // A frozen clock keeps the dispatch budget from cutting passes short
+    sim_clock_set_manual(true);
+
+    out.printf("\nEventBridge, publish and dispatch\n");
+    out.printf("%-12s %9s %9s %9s %8s %12s\n", "payload", "published", "delivered", "rejected", "ns/event", "events/s");
+    bool ok = bench_event_run(out, "uint32", false);
+    ok = bench_event_run(out, "typed 16 B", true) && ok;
+    ok = check_event_latest_oversize(out) && ok;
+
+    sim_clock_set_manual(manual);
+    return ok;
+}
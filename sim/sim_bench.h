@@ -0,0 +1,56 @@
+/**
+ * @file      sim_bench.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Host benchmark suite: UI actions, event throughput, config and service startup
+ */
+
+#ifndef SIM_BENCH_H
+#define SIM_BENCH_H
+
+#include <Arduino.h>
+
+/**
+ * UI actions run on the manual clock, so frames, flushes, pixels and sim ms
+ * are the same on every run and are what to diff between commits; render
+ * time is host CPU and only comparable on one machine. The event, config,
+ * service and codec numbers are host time throughout. A replayed trace is
+ * the same on the manual clock too, so two builds can be set side by side
+ * under the load a device recorded.
+ */
+
+#define SIM_BENCH_EVENTS            100000  // Published per event run
+#define SIM_BENCH_EVENT_BATCH       32      // Published between processEvents() calls
+#define SIM_BENCH_CONFIG_LOADS      50
+#define SIM_BENCH_CONFIG_SECTIONS   16
+#define SIM_BENCH_CONFIG_KEYS       16      // Per section
+#define SIM_BENCH_CODEC_ROUNDS      1000    // Per corpus message
+
+/**
+ * @brief Bring up the UI on the sim display; call once before the UI bench
+ */
+bool sim_bench_ui_begin();
+
+/**
+ * @brief Run the action script twice: cold, building every screen, then warm
+ *        from the screen cache. frames_dir gets a PBM per action, or nullptr
+ */
+bool sim_bench_ui(Print& out, const char* frames_dir);
+bool sim_bench_events(Print& out);
+bool sim_bench_config(Print& out);
+bool sim_bench_services(Print& out);
+bool sim_bench_codec(Print& out);
+
+/**
+ * @brief Play an input trace recorded on the device (event_replay.h) into
+ *        the UI on the manual clock; speed in percent, 0 for a step per
+ *        input. Needs sim_bench_ui_begin()
+ */
+bool sim_bench_replay(Print& out, const char* path, uint16_t speed);
+
+// Replayed LoRa packets reach the UI through the port, sim_port.cpp
+void sim_lora_receive(const uint8_t* data, size_t len, int rssi);
+
+#endif // SIM_BENCH_H
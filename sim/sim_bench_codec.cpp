@@ -0,0 +1,64 @@
+/**
+ * @file      sim_bench_codec.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     LoRa payload codec benchmark on the held-out corpus messages
+ */
+
+#include "sim_bench.h"
+#include "sim_clock.h"
+#include "lora_codec.h"
+#include "lora_dict.h"
+
+bool sim_bench_codec(Print& out) {
+    uint8_t packed[255];
+    uint8_t plain[255];
+    size_t bytes_in = 0;
+    size_t bytes_out = 0;
+    int n_packed = 0;
+    int mismatches = 0;
+    uint64_t encode_us = 0;
+    uint64_t decode_us = 0;
+
+    for (int i = 0; i < LORA_DICT_SAMPLES; i++) {
+        const uint8_t* msg = (const uint8_t*)lora_dict_samples[i];
+        size_t len = strlen(lora_dict_samples[i]);
+        size_t packed_len = 0;
+        uint64_t start = sim_host_us();
+        for (int r = 0; r < SIM_BENCH_CODEC_ROUNDS; r++) {
+            packed_len = lora_codec_encode(msg, len, packed, sizeof(packed));
+        }
+        encode_us += sim_host_us() - start;
+        bytes_in += len;
+        bytes_out += packed_len ? packed_len : len;
+        if (!packed_len) {
+            continue;
+        }
+        n_packed++;
+        int plain_len = -1;
+        start = sim_host_us();
+        for (int r = 0; r < SIM_BENCH_CODEC_ROUNDS; r++) {
+            plain_len = lora_codec_decode(packed, packed_len, plain, sizeof(plain));
+        }
+        decode_us += sim_host_us() - start;
+        if (plain_len != (int)len || memcmp(plain, msg, len) != 0) {
+            mismatches++;
+        }
+    }
+
+    uint64_t runs = (uint64_t)LORA_DICT_SAMPLES * SIM_BENCH_CODEC_ROUNDS;
+    out.printf("\nLoRa codec, %d held-out messages, %d packed\n", LORA_DICT_SAMPLES, n_packed);
+    out.printf("%-20s %10u -> %u bytes, ratio %.2f\n", "size", (unsigned)bytes_in, (unsigned)bytes_out,
+               bytes_out ? (double)bytes_in / bytes_out : 0.0);
+    out.printf("%-20s %10llu ns\n", "encode (mean)", (unsigned long long)(encode_us * 1000 / runs));
+    if (n_packed) {
+        out.printf("%-20s %10llu ns\n", "decode (mean)",
+                   (unsigned long long)(decode_us * 1000 / ((uint64_t)n_packed * SIM_BENCH_CODEC_ROUNDS)));
+    }
+    if (mismatches) {
+        out.printf("%d messages did not round-trip\n", mismatches);
+    }
+    return mismatches == 0;
+}
@@ -0,0 +1,133 @@
+/**
+ * @file      sim_bench_replay.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Replay of a device input trace (event_replay.h) into the sim UI
+ */
+
+#include "sim_bench.h"
+#include "sim_clock.h"
+#include "sim_display.h"
+#include "event_replay.h"
+#include "peripheral.h"
+
+static const char* replay_source_names[REPLAY_SRC_COUNT] = {"key", "touch", "lora", "gps", "gap"};
+
+// Keys go in as LVGL sees them from the keypad driver's character
+static uint32_t replay_key(char val) {
+    switch (val) {
+        case '\n':
+        case '\r': return LV_KEY_ENTER;
+        case '\b': return LV_KEY_BACKSPACE;
+        default:   return (uint8_t)val;
+    }
+}
+
+bool sim_bench_replay(Print& out, const char* path, uint16_t speed) {
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        out.printf("\nReplay: cannot open %s\n", path);
+        return false;
+    }
+    EventReplayHeader header;
+    if (fread(&header, sizeof(header), 1, f) != 1 || header.magic != EVENT_REPLAY_MAGIC ||
+        header.version != EVENT_REPLAY_VERSION || header.header_size < sizeof(header)) {
+        out.printf("\nReplay: %s is not a trace\n", path);
+        fclose(f);
+        return false;
+    }
+    fseek(f, header.header_size, SEEK_SET);
+
+    bool manual = sim_clock_is_manual();
+    sim_clock_set_manual(true);
+    sim_display_reset_stats();
+    uint64_t start_us = sim_clock_us();
+
+    uint32_t records[REPLAY_SRC_COUNT] = {0};
+    uint32_t lost = 0;
+    bool truncated = false;
+    uint8_t payload[256];
+    EventReplayRecord rec;
+    while (fread(&rec, sizeof(rec), 1, f) == 1) {
+        if (rec.source >= REPLAY_SRC_COUNT || rec.len > sizeof(payload) ||
+            fread(payload, 1, rec.len, f) != rec.len) {
+            truncated = true;
+            break;
+        }
+        if (speed) {
+            uint64_t due = start_us + (uint64_t)rec.t_us * 100 / speed;
+            while (sim_clock_us() < due) {
+                sim_display_step();
+            }
+        }
+        records[rec.source]++;
+
+        switch (rec.source) {
+            case REPLAY_SRC_KEY: {
+                const EventReplayKey* key = (const EventReplayKey*)payload;
+                if (rec.len >= sizeof(*key) && key->state == KEYPAD_PRESS && key->val) {
+                    sim_input_key(replay_key(key->val));
+                    sim_display_step();
+                }
+                break;
+            }
+            case REPLAY_SRC_TOUCH: {
+                const EventReplayTouch* touch = (const EventReplayTouch*)payload;
+                if (rec.len < sizeof(*touch)) {
+                    break;
+                }
+                if (touch->pressed) {
+                    sim_input_press(touch->x, touch->y);
+                } else {
+                    sim_input_release();
+                }
+                if (!speed) {
+                    sim_display_step();
+                }
+                break;
+            }
+            case REPLAY_SRC_LORA: {
+                const EventReplayLora* lora = (const EventReplayLora*)payload;
+                if (rec.len >= sizeof(*lora)) {
+                    sim_lora_receive(payload + sizeof(*lora), rec.len - sizeof(*lora), lora->rssi_x2 / 2);
+                }
+                break;
+            }
+            case REPLAY_SRC_GAP:
+                if (rec.len >= sizeof(uint32_t)) {
+                    lost += *(const uint32_t*)payload;
+                }
+                break;
+            default:
+                // GPS bytes have no parser in the sim; counted only
+                break;
+        }
+    }
+    fclose(f);
+    sim_input_release();
+    uint32_t settle_ms = sim_display_settle();
+
+    SimDisplayStats stats;
+    sim_display_get_stats(&stats);
+    uint32_t sim_ms = (uint32_t)((sim_clock_us() - start_us) / 1000);
+    sim_clock_set_manual(manual);
+
+    out.printf("\nReplay %s, speed %u%%\n", path, (unsigned)speed);
+    for (int i = 0; i < REPLAY_SRC_COUNT; i++) {
+        out.printf("%-20s %10u\n", replay_source_names[i], (unsigned)records[i]);
+    }
+    if (lost) {
+        out.printf("%-20s %10u\n", "lost on device", (unsigned)lost);
+    }
+    out.printf("%-20s %10u\n", "frames", (unsigned)stats.frames);
+    out.printf("%-20s %10u\n", "flushes", (unsigned)stats.flushes);
+    out.printf("%-20s %10llu\n", "pixels", (unsigned long long)stats.pixels);
+    out.printf("%-20s %10u ms (settle %u)\n", "sim time", (unsigned)sim_ms, (unsigned)settle_ms);
+    out.printf("%-20s %10llu us\n", "render", (unsigned long long)stats.render_us);
+    if (truncated) {
+        out.printf("trace ends mid-record\n");
+    }
+    return !truncated;
+}
@@ -0,0 +1,103 @@
+/**
+ * @file      sim_bench_services.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     ConfigManager load and ServiceManager startup benchmarks
+ */
+
+#include "sim_bench.h"
+#include "sim_clock.h"
+#include <LittleFS.h>
+#include "integration/config_manager.h"
+#include "integration/service_container.h"
+#include "integration/service_manager.h"
+
+bool sim_bench_config(Print& out) {
+    LittleFS.begin(true);
+    LittleFS.format();
+
+    ConfigManager config(ConfigStorage::LITTLEFS);
+    uint64_t start = sim_host_us();
+    if (!config.initialize()) {
+        return false;
+    }
+    uint64_t init_us = sim_host_us() - start;
+
+    char section[16];
+    char key[16];
+    for (int s = 0; s < SIM_BENCH_CONFIG_SECTIONS; s++) {
+        snprintf(section, sizeof(section), "bench%02d", s);
+        for (int k = 0; k < SIM_BENCH_CONFIG_KEYS; k++) {
+            snprintf(key, sizeof(key), "key%02d", k);
+            if (k % 2) {
+                config.setInteger(section, key, s * 100 + k);
+            } else {
+                config.setString(section, key, key);
+            }
+        }
+    }
+    start = sim_host_us();
+    bool saved = config.saveConfig();
+    uint64_t save_us = sim_host_us() - start;
+
+    uint64_t load_us = 0;
+    bool loaded = true;
+    for (int i = 0; i < SIM_BENCH_CONFIG_LOADS; i++) {
+        start = sim_host_us();
+        loaded = config.loadConfig() && loaded;
+        load_us += sim_host_us() - start;
+    }
+
+    File file = LittleFS.open(config.getConfigFilePath().c_str(), FILE_READ);
+    size_t bytes = file ? file.size() : 0;
+    file.close();
+    config.shutdown();
+
+    out.printf("\nConfigManager, %d sections x %d keys, %u byte file\n", SIM_BENCH_CONFIG_SECTIONS,
+               SIM_BENCH_CONFIG_KEYS, (unsigned)bytes);
+    out.printf("%-20s %10llu us\n", "initialize (fresh)", (unsigned long long)init_us);
+    out.printf("%-20s %10llu us\n", "save", (unsigned long long)save_us);
+    out.printf("%-20s %10llu us\n", "load (mean)", (unsigned long long)(load_us / SIM_BENCH_CONFIG_LOADS));
+    return saved && loaded;
+}
+
+bool sim_bench_services(Print& out) {
+    // Startup timeouts are measured with millis(), so this one runs on host time
+    bool manual = sim_clock_is_manual();
+    sim_clock_set_manual(false);
+
+    auto container = std::make_shared<ServiceContainer>();
+    auto bridge = std::make_shared<EventBridge>();
+    auto config = std::make_shared<ConfigManager>(ConfigStorage::LITTLEFS);
+    bool ok = container->initialize() && bridge->initialize() && config->initialize();
+
+    ServiceManager manager;
+    manager.setServiceContainer(container);
+    manager.setEventBridge(bridge);
+    manager.setConfigManager(config);
+
+    uint64_t start = sim_host_us();
+    ok = ok && manager.initialize();
+    uint64_t init_us = sim_host_us() - start;
+
+    start = sim_host_us();
+    bool started = ok && manager.startAllServices();
+    uint64_t start_us = sim_host_us() - start;
+
+    start = sim_host_us();
+    manager.stopAllServices();
+    uint64_t stop_us = sim_host_us() - start;
+    manager.shutdown();
+    config->shutdown();
+    bridge->shutdown();
+
+    out.printf("\nServiceManager%s\n", started ? "" : ", some services failed to start");
+    out.printf("%-20s %10llu us\n", "initialize", (unsigned long long)init_us);
+    out.printf("%-20s %10llu us\n", "start all", (unsigned long long)start_us);
+    out.printf("%-20s %10llu us\n", "stop all", (unsigned long long)stop_us);
+
+    sim_clock_set_manual(manual);
+    return ok;
+}
@@ -0,0 +1,34 @@
+/**
+ * @file      sim_clock.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Simulator time: the host clock, or a manual clock for repeatable runs
+ */
+
+#ifndef SIM_CLOCK_H
+#define SIM_CLOCK_H
+
+#include <stdint.h>
+
+/**
+ * millis(), micros(), esp_timer_get_time() and the FreeRTOS tick count all
+ * read this clock. It follows the host's monotonic clock until a benchmark
+ * switches it to manual; from then on it only moves by sim_clock_advance(),
+ * so LVGL timers, animations and refresh deadlines fire at the same points
+ * on every run and every machine. Time never goes backwards across a switch.
+ *
+ * Blocking waits (vTaskDelay, queue timeouts) always use host time, so
+ * worker tasks keep running while the driving thread holds the clock.
+ */
+
+void sim_clock_set_manual(bool manual);
+bool sim_clock_is_manual();
+void sim_clock_advance(uint32_t ms);
+uint64_t sim_clock_us();
+
+// Host time, for measuring how long the simulated work took
+uint64_t sim_host_us();
+
+#endif // SIM_CLOCK_H
@@ -0,0 +1,199 @@
+/**
+ * @file      sim_display.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Headless LVGL display and scripted input for the simulator
+ */
+
+#include "sim_display.h"
+#include "sim_clock.h"
+#include "lvgl_integration.h"
+#include "lvgl_draw_1bpp.h"
+#include "lvgl_layers.h"
+#include "ui_anim_policy.h"
+#include "img_1bpp_decoder.h"
+#include "simple_logger.h"
+
+// Same band and draw path as LVGLIntegration, so the render work matches the device
+static lv_disp_draw_buf_t draw_buf;
+static lv_color_t band[LVGL_BUFFER_SIZE];
+static uint8_t framebuffer[SIM_DISPLAY_STRIDE * SIM_DISPLAY_HEIGHT];
+static lv_disp_t* display = nullptr;
+static lv_indev_t* pointer_indev = nullptr;
+static lv_indev_t* keypad_indev = nullptr;
+
+static SimDisplayStats stats;
+static bool frame_flushed = false;
+
+static bool touch_down = false;
+static int touch_x = 0;
+static int touch_y = 0;
+static uint32_t key_pending = 0;
+static bool key_released = true;
+static char last_key = 0;
+static bool last_key_new = false;
+
+static void flush_cb(lv_disp_drv_t* drv, const lv_area_t* area, lv_color_t* color_p) {
+    stats.flushes++;
+    stats.pixels += (uint64_t)lv_area_get_width(area) * lv_area_get_height(area);
+    frame_flushed = true;
+    if (lv_disp_flush_is_last(drv)) {
+        lvgl_layers_frame_done(display);
+    }
+    lv_disp_flush_ready(drv);
+}
+
+static void pointer_read_cb(lv_indev_drv_t* drv, lv_indev_data_t* data) {
+    data->point.x = touch_x;
+    data->point.y = touch_y;
+    data->state = touch_down ? LV_INDEV_STATE_PRESSED : LV_INDEV_STATE_RELEASED;
+}
+
+static void rounder_cb(lv_disp_drv_t* drv, lv_area_t* area) {
+    lvgl_layers_trim(display, area);
+}
+
+// A key is pressed for one read and released on the next, like a tap
+static void keypad_read_cb(lv_indev_drv_t* drv, lv_indev_data_t* data) {
+    if (key_pending && key_released) {
+        data->key = key_pending;
+        data->state = LV_INDEV_STATE_PRESSED;
+        key_released = false;
+        return;
+    }
+    data->key = key_pending;
+    data->state = LV_INDEV_STATE_RELEASED;
+    key_pending = 0;
+    key_released = true;
+}
+
+bool sim_display_begin() {
+    lv_init();
+    img_1bpp_decoder_init();
+    ui_anim_policy_set(LVGL_ANIM_POLICY);
+    memset(framebuffer, 0xFF, sizeof(framebuffer));
+    lv_disp_draw_buf_init(&draw_buf, band, NULL, LVGL_BUFFER_SIZE);
+
+    static lv_disp_drv_t disp_drv;
+    lv_disp_drv_init(&disp_drv);
+    disp_drv.hor_res = SIM_DISPLAY_WIDTH;
+    disp_drv.ver_res = SIM_DISPLAY_HEIGHT;
+    disp_drv.flush_cb = flush_cb;
+    disp_drv.rounder_cb = rounder_cb;
+    disp_drv.draw_buf = &draw_buf;
+    disp_drv.draw_ctx_init = lvgl_draw_1bpp_ctx_init;
+    disp_drv.draw_ctx_deinit = lvgl_draw_1bpp_ctx_deinit;
+    disp_drv.draw_ctx_size = sizeof(LVGLDraw1bppCtx);
+    display = lv_disp_drv_register(&disp_drv);
+    if (!display) {
+        LOG_ERROR("Sim", "Failed to register display driver");
+        return false;
+    }
+    lvgl_draw_1bpp_set_target(display, framebuffer, SIM_DISPLAY_STRIDE);
+
+    static lv_indev_drv_t pointer_drv;
+    lv_indev_drv_init(&pointer_drv);
+    pointer_drv.type = LV_INDEV_TYPE_POINTER;
+    pointer_drv.read_cb = pointer_read_cb;
+    pointer_indev = lv_indev_drv_register(&pointer_drv);
+
+    static lv_indev_drv_t keypad_drv;
+    lv_indev_drv_init(&keypad_drv);
+    keypad_drv.type = LV_INDEV_TYPE_KEYPAD;
+    keypad_drv.read_cb = keypad_read_cb;
+    keypad_indev = lv_indev_drv_register(&keypad_drv);
+
+    lv_group_t* group = lv_group_create();
+    lv_group_set_default(group);
+    lv_indev_set_group(keypad_indev, group);
+
+    LOG_INFOF("Sim", "Display %dx%d, band %d rows", SIM_DISPLAY_WIDTH, SIM_DISPLAY_HEIGHT, LVGL_BAND_ROWS);
+    return pointer_indev && keypad_indev;
+}
+
+void sim_display_step() {
+    sim_clock_advance(SIM_FRAME_STEP_MS);
+    frame_flushed = false;
+    uint64_t start = sim_host_us();
+    lv_timer_handler();
+    stats.render_us += sim_host_us() - start;
+    stats.handler_calls++;
+    if (frame_flushed) {
+        stats.frames++;
+    }
+}
+
+uint32_t sim_display_settle() {
+    uint32_t elapsed = 0;
+    uint32_t quiet = 0;
+    while (elapsed < SIM_SETTLE_MAX_MS) {
+        sim_display_step();
+        elapsed += SIM_FRAME_STEP_MS;
+        bool busy = frame_flushed || display->inv_p > 0 || lv_anim_count_running() > 0;
+        quiet = busy ? 0 : quiet + SIM_FRAME_STEP_MS;
+        if (quiet > LV_DISP_DEF_REFR_PERIOD) {
+            break;
+        }
+    }
+    return elapsed;
+}
+
+void sim_display_full_refr() {
+    stats.full_refreshes++;
+}
+
+void sim_display_get_stats(SimDisplayStats* out) {
+    *out = stats;
+}
+
+void sim_display_reset_stats() {
+    memset(&stats, 0, sizeof(stats));
+}
+
+bool sim_display_save_pbm(const char* path) {
+    FILE* f = fopen(path, "wb");
+    if (!f) {
+        return false;
+    }
+    fprintf(f, "P4\n%d %d\n", SIM_DISPLAY_WIDTH, SIM_DISPLAY_HEIGHT);
+    for (size_t i = 0; i < sizeof(framebuffer); i++) {
+        fputc(~framebuffer[i] & 0xFF, f);    // PBM has 1 = black
+    }
+    fclose(f);
+    return true;
+}
+
+void sim_input_press(int x, int y) {
+    touch_x = x;
+    touch_y = y;
+    touch_down = true;
+}
+
+void sim_input_release() {
+    touch_down = false;
+}
+
+void sim_input_key(uint32_t key) {
+    key_pending = key;
+    if (key >= 0x20 && key < 0x7F) {
+        last_key = (char)key;
+        last_key_new = true;
+    }
+}
+
+int sim_input_get_point(int* x, int* y) {
+    *x = touch_x;
+    *y = touch_y;
+    return touch_down ? 1 : 0;
+}
+
+int sim_input_get_key(char* c) {
+    if (!last_key_new) {
+        return 0;
+    }
+    *c = last_key;
+    last_key_new = false;
+    return 1;
+}
@@ -0,0 +1,70 @@
+/**
+ * @file      sim_display.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Headless LVGL display and scripted input for the simulator
+ */
+
+#ifndef SIM_DISPLAY_H
+#define SIM_DISPLAY_H
+
+#include <Arduino.h>
+#include <lvgl.h>
+
+/**
+ * The panel is a 1 bpp framebuffer in memory, the same 240x320 the e-paper
+ * driver exposes to LVGL. Flushes are counted, not shown; a frame can be
+ * written out as a PBM to look at or diff. Touch and keys come from the
+ * benchmark script through sim_input_*, read by LVGL like the real drivers.
+ */
+
+#define SIM_DISPLAY_WIDTH           240
+#define SIM_DISPLAY_HEIGHT          320
+#define SIM_DISPLAY_STRIDE          (SIM_DISPLAY_WIDTH / 8)
+#define SIM_FRAME_STEP_MS           10      // Sim time per lv_timer_handler() call
+#define SIM_SETTLE_MAX_MS           3000    // Give up waiting for a screen to go idle
+
+struct SimDisplayStats {
+    uint32_t frames;                // Refresh cycles that flushed anything
+    uint32_t flushes;               // flush_cb calls, one per band
+    uint64_t pixels;                // Pixels flushed
+    uint32_t full_refreshes;        // ui_disp_full_refr() requests
+    uint64_t render_us;             // Host time inside lv_timer_handler()
+    uint32_t handler_calls;
+};
+
+/**
+ * @brief lv_init() and register the display and both input devices
+ */
+bool sim_display_begin();
+
+/**
+ * @brief Advance the sim clock one step and run LVGL once
+ */
+void sim_display_step();
+
+/**
+ * @brief Step until nothing is invalid, no animation runs and a refresh
+ *        period has passed quietly; returns the sim ms it took
+ */
+uint32_t sim_display_settle();
+
+void sim_display_full_refr();
+void sim_display_get_stats(SimDisplayStats* stats);
+void sim_display_reset_stats();
+
+/**
+ * @brief Write the current frame as a binary PBM (black is 1)
+ */
+bool sim_display_save_pbm(const char* path);
+
+// Scripted input, consumed by the next indev read
+void sim_input_press(int x, int y);
+void sim_input_release();
+void sim_input_key(uint32_t key);
+int sim_input_get_point(int* x, int* y);
+int sim_input_get_key(char* c);
+
+#endif // SIM_DISPLAY_H
@@ -0,0 +1,419 @@
+/**
+ * @file      sim_fs.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     SD, LittleFS and Preferences for the simulator
+ */
+
+#include <Arduino.h>
+#include <FS.h>
+#include <SD.h>
+#include <LittleFS.h>
+#include <Preferences.h>
+#include <dirent.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#define SIM_NVS_ENTRIES     630     // A 20 KB NVS partition holds about this many
+
+SDFS SD;
+LittleFSFS LittleFS;
+
+static std::string fs_root = "sim_data";
+
+const char* sim_fs_root() {
+    return fs_root.c_str();
+}
+
+void sim_fs_set_root(const char* dir) {
+    fs_root = dir;
+}
+
+static void mkdir_p(const std::string& dir) {
+    for (size_t i = 1; i <= dir.size(); i++) {
+        if (i == dir.size() || dir[i] == '/') {
+            ::mkdir(dir.substr(0, i).c_str(), 0755);
+        }
+    }
+}
+
+static std::string parent_of(const std::string& path) {
+    size_t slash = path.rfind('/');
+    return slash == std::string::npos ? std::string() : path.substr(0, slash);
+}
+
+static uint64_t tree_bytes(const std::string& dir) {
+    DIR* d = opendir(dir.c_str());
+    if (!d) {
+        return 0;
+    }
+    uint64_t total = 0;
+    while (struct dirent* e = readdir(d)) {
+        if (!strcmp(e->d_name, ".") || !strcmp(e->d_name, "..")) {
+            continue;
+        }
+        std::string child = dir + "/" + e->d_name;
+        struct stat st;
+        if (stat(child.c_str(), &st) != 0) {
+            continue;
+        }
+        total += S_ISDIR(st.st_mode) ? tree_bytes(child) : (uint64_t)st.st_size;
+    }
+    closedir(d);
+    return total;
+}
+
+namespace fs {
+
+struct FileImpl {
+    std::string path;               // Device path, "/config/system.json"
+    std::string host;               // Where it really is
+    FILE* fp;
+    DIR* dir;
+
+    FileImpl() : fp(nullptr), dir(nullptr) {}
+    ~FileImpl() {
+        if (fp) {
+            fclose(fp);
+        }
+        if (dir) {
+            closedir(dir);
+        }
+    }
+};
+
+static File open_host(const std::string& path, const std::string& host, const char* mode) {
+    struct stat st;
+    bool exists = stat(host.c_str(), &st) == 0;
+    auto impl = std::make_shared<FileImpl>();
+    impl->path = path;
+    impl->host = host;
+
+    if (exists && S_ISDIR(st.st_mode)) {
+        impl->dir = opendir(host.c_str());
+        return impl->dir ? File(impl) : File();
+    }
+    if (mode[0] == 'r') {
+        if (!exists) {
+            return File();
+        }
+        impl->fp = fopen(host.c_str(), "rb");
+    } else {
+        mkdir_p(parent_of(host));
+        impl->fp = fopen(host.c_str(), mode[0] == 'a' ? "ab" : "wb");
+    }
+    return impl->fp ? File(impl) : File();
+}
+
+size_t File::write(uint8_t c) {
+    return write(&c, 1);
+}
+
+size_t File::write(const uint8_t* buf, size_t len) {
+    return impl && impl->fp ? fwrite(buf, 1, len, impl->fp) : 0;
+}
+
+int File::available() {
+    if (!impl || !impl->fp) {
+        return 0;
+    }
+    return (int)(size() - position());
+}
+
+int File::read() {
+    if (!impl || !impl->fp) {
+        return -1;
+    }
+    int c = fgetc(impl->fp);
+    return c == EOF ? -1 : c;
+}
+
+int File::peek() {
+    if (!impl || !impl->fp) {
+        return -1;
+    }
+    int c = fgetc(impl->fp);
+    if (c == EOF) {
+        return -1;
+    }
+    ungetc(c, impl->fp);
+    return c;
+}
+
+void File::flush() {
+    if (impl && impl->fp) {
+        fflush(impl->fp);
+    }
+}
+
+size_t File::read(uint8_t* buf, size_t len) {
+    return impl && impl->fp ? fread(buf, 1, len, impl->fp) : 0;
+}
+
+bool File::seek(uint32_t pos, SeekMode mode) {
+    if (!impl || !impl->fp) {
+        return false;
+    }
+    int whence = mode == SeekCur ? SEEK_CUR : (mode == SeekEnd ? SEEK_END : SEEK_SET);
+    return fseek(impl->fp, pos, whence) == 0;
+}
+
+size_t File::position() const {
+    return impl && impl->fp ? (size_t)ftell(impl->fp) : 0;
+}
+
+size_t File::size() const {
+    if (!impl || !impl->fp) {
+        return 0;
+    }
+    fflush(impl->fp);
+    struct stat st;
+    return fstat(fileno(impl->fp), &st) == 0 ? (size_t)st.st_size : 0;
+}
+
+void File::close() {
+    impl.reset();
+}
+
+File::operator bool() const {
+    return impl && (impl->fp || impl->dir);
+}
+
+time_t File::getLastWrite() {
+    struct stat st;
+    return impl && stat(impl->host.c_str(), &st) == 0 ? st.st_mtime : 0;
+}
+
+const char* File::path() const {
+    return impl ? impl->path.c_str() : "";
+}
+
+const char* File::name() const {
+    if (!impl) {
+        return "";
+    }
+    size_t slash = impl->path.rfind('/');
+    return impl->path.c_str() + (slash == std::string::npos ? 0 : slash + 1);
+}
+
+bool File::isDirectory() const {
+    return impl && impl->dir;
+}
+
+File File::openNextFile(const char* mode) {
+    if (!impl || !impl->dir) {
+        return File();
+    }
+    while (struct dirent* e = readdir(impl->dir)) {
+        if (!strcmp(e->d_name, ".") || !strcmp(e->d_name, "..")) {
+            continue;
+        }
+        std::string base = impl->path == "/" ? std::string() : impl->path;
+        return open_host(base + "/" + e->d_name, impl->host + "/" + e->d_name, mode);
+    }
+    return File();
+}
+
+void File::rewindDirectory() {
+    if (impl && impl->dir) {
+        rewinddir(impl->dir);
+    }
+}
+
+std::string FS::hostPath(const char* path) const {
+    std::string host = fs_root + "/" + mount;
+    if (path && path[0] && path[0] != '/') {
+        host += "/";
+    }
+    host += path ? path : "";
+    while (host.size() > 1 && host.back() == '/') {
+        host.pop_back();
+    }
+    return host;
+}
+
+File FS::open(const char* path, const char* mode, bool create) {
+    mkdir_p(hostPath("/"));
+    return open_host(path, hostPath(path), mode);
+}
+
+bool FS::exists(const char* path) {
+    struct stat st;
+    return stat(hostPath(path).c_str(), &st) == 0;
+}
+
+bool FS::remove(const char* path) {
+    return unlink(hostPath(path).c_str()) == 0;
+}
+
+bool FS::rename(const char* from, const char* to) {
+    return ::rename(hostPath(from).c_str(), hostPath(to).c_str()) == 0;
+}
+
+bool FS::mkdir(const char* path) {
+    std::string host = hostPath(path);
+    mkdir_p(host);
+    struct stat st;
+    return stat(host.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+bool FS::rmdir(const char* path) {
+    return ::rmdir(hostPath(path).c_str()) == 0;
+}
+
+uint64_t FS::usedBytes() {
+    return tree_bytes(hostPath("/"));
+}
+
+} // namespace fs
+
+static void remove_tree(const std::string& dir) {
+    DIR* d = opendir(dir.c_str());
+    if (!d) {
+        return;
+    }
+    while (struct dirent* e = readdir(d)) {
+        if (!strcmp(e->d_name, ".") || !strcmp(e->d_name, "..")) {
+            continue;
+        }
+        std::string child = dir + "/" + e->d_name;
+        struct stat st;
+        if (stat(child.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+            remove_tree(child);
+            ::rmdir(child.c_str());
+        } else {
+            unlink(child.c_str());
+        }
+    }
+    closedir(d);
+}
+
+bool LittleFSFS::format() {
+    remove_tree(hostPath("/"));
+    return true;
+}
+
+// ===== Preferences =====
+
+static std::mutex nvs_mutex;
+static std::map<std::string, std::map<std::string, std::vector<uint8_t>>> nvs;
+
+static size_t nvs_entries() {
+    size_t n = 0;
+    for (auto& ns : nvs) {
+        n += ns.second.size();
+    }
+    return n;
+}
+
+bool Preferences::begin(const char* name, bool readOnly, const char* partition) {
+    if (!name || strlen(name) > 15) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(nvs_mutex);
+    ns = name;
+    read_only = readOnly;
+    opened = true;
+    if (!read_only) {
+        nvs[ns];
+    }
+    return true;
+}
+
+void Preferences::end() {
+    opened = false;
+}
+
+bool Preferences::clear() {
+    if (!opened || read_only) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(nvs_mutex);
+    nvs[ns].clear();
+    return true;
+}
+
+bool Preferences::remove(const char* key) {
+    if (!opened || read_only) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(nvs_mutex);
+    return nvs[ns].erase(key) > 0;
+}
+
+bool Preferences::isKey(const char* key) {
+    if (!opened) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(nvs_mutex);
+    auto it = nvs.find(ns);
+    return it != nvs.end() && it->second.count(key);
+}
+
+size_t Preferences::freeEntries() {
+    std::lock_guard<std::mutex> lock(nvs_mutex);
+    size_t used = nvs_entries();
+    return used >= SIM_NVS_ENTRIES ? 0 : SIM_NVS_ENTRIES - used;
+}
+
+bool Preferences::putRaw(const char* key, const void* value, size_t len) {
+    if (!opened || read_only || !key || strlen(key) > 15) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(nvs_mutex);
+    const uint8_t* p = (const uint8_t*)value;
+    nvs[ns][key].assign(p, p + len);
+    return true;
+}
+
+// Like nvs_get_blob: nothing is copied unless the whole value fits
+size_t Preferences::getRaw(const char* key, void* value, size_t len) const {
+    if (!opened || !key) {
+        return 0;
+    }
+    std::lock_guard<std::mutex> lock(nvs_mutex);
+    auto ns_it = nvs.find(ns);
+    if (ns_it == nvs.end()) {
+        return 0;
+    }
+    auto it = ns_it->second.find(key);
+    if (it == ns_it->second.end() || it->second.size() > len) {
+        return 0;
+    }
+    memcpy(value, it->second.data(), it->second.size());
+    return it->second.size();
+}
+
+String Preferences::getString(const char* key, const String& default_value) {
+    size_t len = getBytesLength(key);
+    if (!len) {
+        return default_value;
+    }
+    std::vector<char> buf(len);
+    getRaw(key, buf.data(), len);
+    return String(buf.data());
+}
+
+size_t Preferences::getString(const char* key, char* value, size_t max_len) {
+    size_t len = getRaw(key, value, max_len);
+    return len;
+}
+
+size_t Preferences::getBytesLength(const char* key) {
+    if (!opened || !key) {
+        return 0;
+    }
+    std::lock_guard<std::mutex> lock(nvs_mutex);
+    auto ns_it = nvs.find(ns);
+    if (ns_it == nvs.end()) {
+        return 0;
+    }
+    auto it = ns_it->second.find(key);
+    return it == ns_it->second.end() ? 0 : it->second.size();
+}
@@ -0,0 +1,304 @@
+/**
+ * @file      sim_heap.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     heap_caps and multi_heap for the simulator, with per-region accounting
+ */
+
+#include <Arduino.h>
+#include <multi_heap.h>
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+
+/**
+ * Blocks come straight from the host heap, because device code frees
+ * ps_malloc() memory with plain free() as ESP-IDF allows. A side table
+ * remembers each block's size and whether PSRAM was asked for, so the
+ * internal and PSRAM figures the UI and benchmarks print move as they would
+ * on the device. A block released with free() stays counted until its
+ * address is handed out again. Nothing is refused: the simulator is not a
+ * memory-pressure test.
+ */
+
+struct SimBlock {
+    size_t size;
+    int region;                     // 0 internal, 1 PSRAM
+};
+
+static std::mutex blocks_mutex;
+static std::unordered_map<void*, SimBlock> blocks;
+static std::atomic<size_t> used[2];
+static std::atomic<size_t> peak[2];
+static const size_t region_size[2] = {SIM_HEAP_INTERNAL_SIZE, SIM_HEAP_PSRAM_SIZE};
+
+static int caps_region(uint32_t caps) {
+    return (caps & MALLOC_CAP_SPIRAM) ? 1 : 0;
+}
+
+static void note(int region, ptrdiff_t delta) {
+    size_t now = used[region].fetch_add(delta) + delta;
+    size_t old = peak[region].load();
+    while (now > old && !peak[region].compare_exchange_weak(old, now)) {
+    }
+}
+
+static void track(void* ptr, size_t size, int region) {
+    std::lock_guard<std::mutex> lock(blocks_mutex);
+    auto it = blocks.find(ptr);
+    if (it != blocks.end()) {
+        note(it->second.region, -(ptrdiff_t)it->second.size);     // Went out through free()
+    }
+    blocks[ptr] = {size, region};
+    note(region, size);
+}
+
+static bool untrack(void* ptr, SimBlock* out) {
+    std::lock_guard<std::mutex> lock(blocks_mutex);
+    auto it = blocks.find(ptr);
+    if (it == blocks.end()) {
+        return false;
+    }
+    *out = it->second;
+    note(it->second.region, -(ptrdiff_t)it->second.size);
+    blocks.erase(it);
+    return true;
+}
+
+extern "C" void* heap_caps_malloc(size_t size, uint32_t caps) {
+    void* p = malloc(size ? size : 1);
+    if (p) {
+        track(p, size, caps_region(caps));
+    }
+    return p;
+}
+
+extern "C" void* heap_caps_calloc(size_t n, size_t size, uint32_t caps) {
+    void* p = heap_caps_malloc(n * size, caps);
+    if (p) {
+        memset(p, 0, n * size);
+    }
+    return p;
+}
+
+extern "C" void heap_caps_free(void* ptr) {
+    if (!ptr) {
+        return;
+    }
+    SimBlock b;
+    untrack(ptr, &b);
+    free(ptr);
+}
+
+extern "C" void* heap_caps_realloc(void* ptr, size_t size, uint32_t caps) {
+    if (!ptr) {
+        return heap_caps_malloc(size, caps);
+    }
+    if (size == 0) {
+        heap_caps_free(ptr);
+        return NULL;
+    }
+    SimBlock b;
+    untrack(ptr, &b);
+    void* p = realloc(ptr, size);
+    track(p ? p : ptr, p ? size : b.size, caps_region(caps));
+    return p;
+}
+
+extern "C" void* heap_caps_aligned_alloc(size_t alignment, size_t size, uint32_t caps) {
+    void* p = NULL;
+    if (posix_memalign(&p, alignment < sizeof(void*) ? sizeof(void*) : alignment, size ? size : 1) != 0) {
+        return NULL;
+    }
+    track(p, size, caps_region(caps));
+    return p;
+}
+
+extern "C" size_t heap_caps_get_total_size(uint32_t caps) {
+    return region_size[caps_region(caps)];
+}
+
+extern "C" size_t heap_caps_get_free_size(uint32_t caps) {
+    int r = caps_region(caps);
+    size_t u = used[r].load();
+    return u < region_size[r] ? region_size[r] - u : 0;
+}
+
+extern "C" size_t heap_caps_get_minimum_free_size(uint32_t caps) {
+    int r = caps_region(caps);
+    size_t p = peak[r].load();
+    return p < region_size[r] ? region_size[r] - p : 0;
+}
+
+extern "C" size_t heap_caps_get_largest_free_block(uint32_t caps) {
+    return heap_caps_get_free_size(caps);
+}
+
+extern "C" void heap_caps_get_info(multi_heap_info_t* info, uint32_t caps) {
+    memset(info, 0, sizeof(*info));
+    info->total_free_bytes = heap_caps_get_free_size(caps);
+    info->total_allocated_bytes = used[caps_region(caps)].load();
+    info->largest_free_block = info->total_free_bytes;
+    info->minimum_free_bytes = heap_caps_get_minimum_free_size(caps);
+}
+
+extern "C" void* ps_malloc(size_t size) {
+    return heap_caps_malloc(size, MALLOC_CAP_SPIRAM);
+}
+
+extern "C" void* ps_calloc(size_t n, size_t size) {
+    return heap_caps_calloc(n, size, MALLOC_CAP_SPIRAM);
+}
+
+extern "C" void* ps_realloc(void* ptr, size_t size) {
+    return heap_caps_realloc(ptr, size, MALLOC_CAP_SPIRAM);
+}
+
+// ===== multi_heap: first fit over the caller's buffer =====
+
+struct PoolBlock {
+    uint32_t size;                  // Payload bytes
+    uint32_t free;
+};
+
+struct multi_heap_info {
+    uint8_t* start;
+    size_t size;
+    size_t free_bytes;
+    size_t min_free;
+    size_t blocks;
+};
+
+#define POOL_ALIGN                  8
+#define POOL_HEADER                 sizeof(PoolBlock)
+
+// One lock for every pool, as the IDF heaps are safe to share between tasks
+static std::recursive_mutex pool_mutex;
+
+static PoolBlock* pool_next(multi_heap_handle_t h, PoolBlock* b) {
+    uint8_t* n = (uint8_t*)b + POOL_HEADER + b->size;
+    return n < h->start + h->size ? (PoolBlock*)n : NULL;
+}
+
+extern "C" multi_heap_handle_t multi_heap_register(void* start, size_t size) {
+    uint8_t* p = (uint8_t*)(((uintptr_t)start + POOL_ALIGN - 1) & ~(uintptr_t)(POOL_ALIGN - 1));
+    size -= p - (uint8_t*)start;
+    if (size < sizeof(multi_heap_info) + POOL_HEADER + POOL_ALIGN) {
+        return NULL;
+    }
+    multi_heap_handle_t h = (multi_heap_handle_t)p;
+    h->start = p + ((sizeof(multi_heap_info) + POOL_ALIGN - 1) & ~(POOL_ALIGN - 1));
+    h->size = (size - (h->start - p)) & ~(size_t)(POOL_ALIGN - 1);
+    PoolBlock* first = (PoolBlock*)h->start;
+    first->size = h->size - POOL_HEADER;
+    first->free = 1;
+    h->free_bytes = first->size;
+    h->min_free = h->free_bytes;
+    h->blocks = 0;
+    return h;
+}
+
+extern "C" void* multi_heap_malloc(multi_heap_handle_t h, size_t size) {
+    std::lock_guard<std::recursive_mutex> lock(pool_mutex);
+    if (!h || size == 0) {
+        return NULL;
+    }
+    size = (size + POOL_ALIGN - 1) & ~(size_t)(POOL_ALIGN - 1);
+    for (PoolBlock* b = (PoolBlock*)h->start; b; b = pool_next(h, b)) {
+        if (!b->free || b->size < size) {
+            continue;
+        }
+        if (b->size >= size + POOL_HEADER + POOL_ALIGN) {
+            PoolBlock* rest = (PoolBlock*)((uint8_t*)b + POOL_HEADER + size);
+            rest->size = b->size - size - POOL_HEADER;
+            rest->free = 1;
+            b->size = size;
+            h->free_bytes -= POOL_HEADER;
+        }
+        b->free = 0;
+        h->free_bytes -= b->size;
+        h->blocks++;
+        if (h->free_bytes < h->min_free) {
+            h->min_free = h->free_bytes;
+        }
+        return (uint8_t*)b + POOL_HEADER;
+    }
+    return NULL;
+}
+
+extern "C" void multi_heap_free(multi_heap_handle_t h, void* ptr) {
+    std::lock_guard<std::recursive_mutex> lock(pool_mutex);
+    if (!h || !ptr) {
+        return;
+    }
+    PoolBlock* b = (PoolBlock*)((uint8_t*)ptr - POOL_HEADER);
+    b->free = 1;
+    h->free_bytes += b->size;
+    h->blocks--;
+
+    // Merge every run of free blocks; the pool is small enough to walk
+    for (PoolBlock* p = (PoolBlock*)h->start; p; p = pool_next(h, p)) {
+        PoolBlock* n;
+        while (p->free && (n = pool_next(h, p)) && n->free) {
+            p->size += POOL_HEADER + n->size;
+            h->free_bytes += POOL_HEADER;
+        }
+    }
+}
+
+extern "C" size_t multi_heap_get_allocated_size(multi_heap_handle_t h, void* ptr) {
+    return ptr ? ((PoolBlock*)((uint8_t*)ptr - POOL_HEADER))->size : 0;
+}
+
+extern "C" void* multi_heap_realloc(multi_heap_handle_t h, void* ptr, size_t size) {
+    std::lock_guard<std::recursive_mutex> lock(pool_mutex);
+    if (!ptr) {
+        return multi_heap_malloc(h, size);
+    }
+    if (size == 0) {
+        multi_heap_free(h, ptr);
+        return NULL;
+    }
+    size_t old = multi_heap_get_allocated_size(h, ptr);
+    if (size <= old) {
+        return ptr;
+    }
+    void* p = multi_heap_malloc(h, size);
+    if (p) {
+        memcpy(p, ptr, old);
+        multi_heap_free(h, ptr);
+    }
+    return p;
+}
+
+extern "C" size_t multi_heap_free_size(multi_heap_handle_t h) {
+    return h ? h->free_bytes : 0;
+}
+
+extern "C" size_t multi_heap_minimum_free_size(multi_heap_handle_t h) {
+    return h ? h->min_free : 0;
+}
+
+extern "C" void multi_heap_get_info(multi_heap_handle_t h, multi_heap_info_t* info) {
+    std::lock_guard<std::recursive_mutex> lock(pool_mutex);
+    memset(info, 0, sizeof(*info));
+    if (!h) {
+        return;
+    }
+    info->total_free_bytes = h->free_bytes;
+    info->minimum_free_bytes = h->min_free;
+    info->allocated_blocks = h->blocks;
+    for (PoolBlock* b = (PoolBlock*)h->start; b; b = pool_next(h, b)) {
+        info->total_blocks++;
+        if (b->free) {
+            info->free_blocks++;
+            if (b->size > info->largest_free_block) {
+                info->largest_free_block = b->size;
+            }
+        } else {
+            info->total_allocated_bytes += b->size;
+        }
+    }
+}
@@ -0,0 +1,114 @@
+/**
+ * @file      sim_main.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Simulator entry point: bring up the logger and run the benchmarks
+ *
+ *   pio run -e native && .pio/build/native/program [options]
+ *
+ *   --bench LIST    comma separated, from ui, events, config, services, codec (all)
+ *   --data DIR      root of the simulated SD card and LittleFS (sim_data)
+ *   --frames DIR    write a PBM of the panel after each UI action
+ *   --log LEVEL     debug, info, warn or error (warn)
+ *   --replay FILE   play an input trace recorded on the device into the UI
+ *   --speed PCT     its pace in percent of the recorded one, 0 unpaced (100)
+ *
+ * Exits non-zero if a benchmark could not run, so CI can call it.
+ */
+
+#include <Arduino.h>
+#include <FS.h>
+#include <SD.h>
+#include <LittleFS.h>
+#include <sys/stat.h>
+#include "sim_bench.h"
+#include "simple_logger.h"
+
+static bool wanted(const char* list, const char* name) {
+    if (!list) {
+        return true;
+    }
+    size_t len = strlen(name);
+    for (const char* p = list; (p = strstr(p, name)) != nullptr; p += len) {
+        bool starts = p == list || p[-1] == ',';
+        bool ends = p[len] == 0 || p[len] == ',';
+        if (starts && ends) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static LogLevel parse_level(const char* s) {
+    if (!strcmp(s, "debug")) return LOG_DEBUG;
+    if (!strcmp(s, "info"))  return LOG_INFO;
+    if (!strcmp(s, "error")) return LOG_ERROR;
+    return LOG_WARN;
+}
+
+int main(int argc, char** argv) {
+    const char* bench = nullptr;
+    const char* frames = nullptr;
+    const char* replay = nullptr;
+    uint16_t speed = 100;
+    LogLevel level = LOG_WARN;
+
+    for (int i = 1; i < argc; i++) {
+        bool has_value = i + 1 < argc;
+        if (!strcmp(argv[i], "--bench") && has_value) {
+            bench = argv[++i];
+        } else if (!strcmp(argv[i], "--data") && has_value) {
+            sim_fs_set_root(argv[++i]);
+        } else if (!strcmp(argv[i], "--frames") && has_value) {
+            frames = argv[++i];
+            mkdir(frames, 0755);
+        } else if (!strcmp(argv[i], "--log") && has_value) {
+            level = parse_level(argv[++i]);
+        } else if (!strcmp(argv[i], "--replay") && has_value) {
+            replay = argv[++i];
+        } else if (!strcmp(argv[i], "--speed") && has_value) {
+            speed = (uint16_t)atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "usage: %s [--bench ui,events,config,services,codec] [--data DIR] [--frames DIR] [--log LEVEL]"
+                    " [--replay FILE [--speed PCT]]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    SimpleLogger* logger = SimpleLogger::getInstance();
+    if (!logger || !logger->init(level)) {
+        fprintf(stderr, "Failed to initialize logger\n");
+        return 1;
+    }
+
+    // Both always mount; the directories appear under the data root on first write
+    SD.begin();
+    LittleFS.begin(true);
+
+    bool ok = true;
+    bool ui_up = false;
+    if (wanted(bench, "ui")) {
+        ui_up = sim_bench_ui_begin();
+        ok = ui_up && sim_bench_ui(Serial, frames) && ok;
+    }
+    if (wanted(bench, "events")) {
+        ok = sim_bench_events(Serial) && ok;
+    }
+    if (wanted(bench, "config")) {
+        ok = sim_bench_config(Serial) && ok;
+    }
+    if (wanted(bench, "services")) {
+        ok = sim_bench_services(Serial) && ok;
+    }
+    if (wanted(bench, "codec")) {
+        ok = sim_bench_codec(Serial) && ok;
+    }
+    if (replay) {
+        ui_up = ui_up || sim_bench_ui_begin();
+        ok = ui_up && sim_bench_replay(Serial, replay, speed) && ok;
+    }
+    Serial.flush();
+    return ok ? 0 : 1;
+}
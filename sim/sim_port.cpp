@@ -0,0 +1,355 @@
+/**
+ * @file      sim_port.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Simulated peripherals behind the UI port, plugins, metrics, MQTT and the SPI bus
+ */
+
+#include <Arduino.h>
+#include <SD.h>
+#include "sim_display.h"
+#include "simple_logger.h"
+#include "ui_deckpro_port.h"
+#include "plugin_runtime.h"
+#include "resume_state.h"
+#include "crash_dump.h"
+#include "time_service.h"
+#include "lvgl_integration.h"
+#include "spi_bus.h"
+#include "mqtt_client.h"
+#include "metrics.h"
+
+/**
+ * Every reading is a fixed value or a slow function of millis(), so a run
+ * on the manual clock redraws the same labels at the same frames each time.
+ * There is no LVGLIntegration: the UI checks LVGL before using it, and the
+ * sim display (sim_display.cpp) stands in for the panel.
+ */
+
+LVGLIntegration* LVGL = nullptr;
+
+#define SIM_WIFI_NETWORKS   12
+
+static int sim_language = DEFAULT_LANGUAGE_EN;
+static bool sim_keypad_light = false;
+static bool sim_motor = false;
+static bool sim_gps = true;
+static bool sim_lora = true;
+static bool sim_gyro = true;
+static bool sim_a7682 = true;
+static int sim_lora_mode = 0;
+static bool sim_lora_recv_pending = false;
+static char sim_lora_last[64];
+static int sim_lora_rssi = -87;
+static uint32_t mqtt_loops = 0;
+
+void ui_disp_full_refr(void)
+{
+    if(scr_mgr_restoring()) return;
+    sim_display_full_refr();
+}
+
+//************************************[ screen 1 ]****************************************** lora
+float ui_lora_get_freq(void) { return 868.0f; }
+int ui_lora_get_mode(void) { return sim_lora_mode; }
+void ui_lora_set_mode(int mode) { sim_lora_mode = mode; }
+
+void ui_lora_send(const char *str)
+{
+    // Loop back, as if a neighbour echoed it
+    snprintf(sim_lora_last, sizeof(sim_lora_last), "echo: %s", str);
+    sim_lora_rssi = -87;
+    sim_lora_recv_pending = true;
+}
+
+// No asset pack: no dictionary to complete from
+int ui_lora_predict(const char *word, char (*out)[UI_PREDICT_WORD_LEN], int max)
+{
+    return 0;
+}
+
+// A replayed packet, see sim_bench_replay(); cut to what the screen shows
+void sim_lora_receive(const uint8_t *data, size_t len, int rssi)
+{
+    if(len >= sizeof(sim_lora_last)) len = sizeof(sim_lora_last) - 1;
+    memcpy(sim_lora_last, data, len);
+    sim_lora_last[len] = '\0';
+    sim_lora_rssi = rssi;
+    sim_lora_recv_pending = true;
+}
+
+bool ui_lora_get_recv(const char **str, int *rssi)
+{
+    if(!sim_lora_recv_pending) return false;
+    *str = sim_lora_last;
+    *rssi = sim_lora_rssi;
+    return true;
+}
+
+void ui_lora_set_recv_flag(void) { sim_lora_recv_pending = false; }
+
+void ui_lora_get_stats(char *buf, size_t len)
+{
+    snprintf(buf, len, "TX 0  RX 0  SNR --");
+}
+int ui_lora_history(int max, void (*cb)(const char *text, int rssi, bool sent))
+{
+    return 0;
+}
+
+//************************************[ screen 2 ]****************************************** setting
+void ui_setting_set_language(int language) { sim_language = language; }
+void ui_setting_set_keypad_light(bool on) { sim_keypad_light = on; }
+void ui_setting_set_motor_status(bool on) { sim_motor = on; }
+void ui_setting_set_gps_status(bool on) { sim_gps = on; }
+void ui_setting_set_lora_status(bool on) { sim_lora = on; }
+void ui_setting_set_gyro_status(bool on) { sim_gyro = on; }
+void ui_setting_set_a7682_status(bool on) { sim_a7682 = on; }
+
+int ui_setting_get_language(void) { return sim_language; }
+bool ui_setting_get_keypad_light(void) { return sim_keypad_light; }
+bool ui_setting_get_motor_status(void) { return sim_motor; }
+bool ui_setting_get_gps_status(void) { return sim_gps; }
+bool ui_setting_get_lora_status(void) { return sim_lora; }
+bool ui_setting_get_gyro_status(void) { return sim_gyro; }
+bool ui_setting_get_a7682_status(void) { return sim_a7682; }
+
+const char *ui_setting_get_sf_ver(void) { return "sim"; }
+const char *ui_setting_get_hd_ver(void) { return "host"; }
+
+bool ui_setting_get_sd_capacity(uint64_t *total, uint64_t *used)
+{
+    *total = SD.totalBytes();
+    *used = SD.usedBytes();
+    return true;
+}
+
+// No sampler on the host; the screen shows its "off" state
+int ui_cpu_prof_task_count(void) { return 0; }
+bool ui_cpu_prof_task_get(int idx, const char **name, float *core0, float *core1) { return false; }
+bool ui_cpu_prof_pc_get(int idx, uint32_t *pc, float *percent) { return false; }
+
+//************************************[ screen 3 ]****************************************** GPS
+void ui_gps_task_suspend(void) { }
+void ui_gps_task_resume(void) { }
+
+void ui_gps_get_coord(double *lat, double *lng)
+{
+    // Walks north-east at a steady pace so the labels change every second
+    double t = millis() / 1000 * 0.00001;
+    *lat = 22.5431 + t;
+    *lng = 114.0579 + t;
+}
+
+void ui_gps_get_data(uint16_t *year, uint8_t *month, uint8_t *day)
+{
+    *year = 2025;
+    *month = 1;
+    *day = 11;
+}
+
+void ui_gps_get_time(uint8_t *hour, uint8_t *minute, uint8_t *second)
+{
+    uint32_t s = millis() / 1000;
+    *hour = (s / 3600) % 24;
+    *minute = (s / 60) % 60;
+    *second = s % 60;
+}
+
+void ui_gps_get_satellites(uint32_t *vsat) { *vsat = 7; }
+void ui_gps_get_speed(double *speed) { *speed = 1.2; }
+
+bool ui_gps_get_track(uint32_t *points, uint32_t *bytes)
+{
+    *points = 0;
+    *bytes = 0;
+    return false;
+}
+
+// No SD card: the map screen says there is no map
+bool ui_map_open(uint8_t *zoom_min, uint8_t *zoom_max, double *lat, double *lng) { return false; }
+const uint8_t *ui_map_get_tile(uint8_t z, uint32_t x, uint32_t y, bool render) { return NULL; }
+
+//************************************[ screen 4 ]****************************************** Wifi Scan
+int ui_wifi_get_scan_info(ui_wifi_scan_info_t *list, int list_len, uint32_t *version)
+{
+    // One scan, taken once; the UI rebuilds its list only when the version moves
+    const uint32_t latest = 1;
+    if(latest == *version) return -1;
+    *version = latest;
+
+    memset(list, 0, sizeof(*list) * list_len);
+    int cnt = 0;
+    for(int i = 0; i < SIM_WIFI_NETWORKS && cnt < list_len; i++, cnt++) {
+        snprintf(list[cnt].name, sizeof(list[cnt].name), "sim-net-%02d", i);
+        list[cnt].rssi = -40 - i * 4;
+    }
+    return cnt;
+}
+
+//************************************[ screen 5 ]****************************************** State
+bool ui_test_get(int peri_id) { return true; }
+bool ui_test_sd_card(void) { return true; }
+bool ui_test_a7682e(void) { return false; }
+bool ui_test_pcm5102(void) { return false; }
+
+//************************************[ screen 6 ]****************************************** Battery
+bool ui_battery_25896_is_vbus_in(void) { return false; }
+bool ui_batt_25896_is_chg(void) { return false; }
+float ui_batt_25896_get_vbus(void) { return 0.0f; }
+float ui_batt_25896_get_vsys(void) { return 3.9f; }
+float ui_batt_25896_get_vbat(void) { return 3.9f; }
+float ui_batt_25896_get_volt_targ(void) { return 4.208f; }
+float ui_batt_25896_get_chg_curr(void) { return 0.0f; }
+float ui_batt_25896_get_pre_curr(void) { return 0.0f; }
+const char * ui_batt_25896_get_chg_st(void) { return "Not charging"; }
+const char * ui_batt_25896_get_vbus_st(void) { return "No input"; }
+const char * ui_batt_25896_get_ntc_st(void) { return "Normal"; }
+
+bool ui_battery_27220_is_vaild(void) { return true; }
+bool ui_battery_27220_get_input(void) { return false; }
+bool ui_battery_27220_get_charge_finish(void) { return false; }
+uint16_t ui_battery_27220_get_status(void) { return 0; }
+uint16_t ui_battery_27220_get_voltage(void) { return 3900; }
+int16_t ui_battery_27220_get_current(void) { return -85; }
+uint16_t ui_battery_27220_get_temperature(void) { return 2982; }   // 0.1 K
+uint16_t ui_battery_27220_get_full_capacity(void) { return 1400; }
+uint16_t ui_battery_27220_get_design_capacity(void) { return 1400; }
+uint16_t ui_battery_27220_get_remain_capacity(void) { return 1400 * ui_battery_27220_get_percent() / 100; }
+
+uint16_t ui_battery_27220_get_percent(void)
+{
+    // One percent a minute, so the taskbar changes during long runs
+    return 100 - (millis() / 60000) % 100;
+}
+
+uint16_t ui_battery_27220_get_health(void) { return 100; }
+int ui_battery_energy_count(void) { return 0; }
+bool ui_battery_energy_get(int idx, const char **name, float *mah, float *ma) { return false; }
+int ui_battery_runtime_min(void) { return -1; }
+int ui_battery_history(int16_t *pct, int count, uint32_t span_s) { return 0; }
+
+const char * ui_battert_27220_get_percent_level(void)
+{
+    int percent = ui_battery_27220_get_percent();
+    if(percent < 20) return LV_SYMBOL_BATTERY_EMPTY;
+    if(percent < 40) return LV_SYMBOL_BATTERY_1;
+    if(percent < 60) return LV_SYMBOL_BATTERY_2;
+    if(percent < 80) return LV_SYMBOL_BATTERY_3;
+    return LV_SYMBOL_BATTERY_FULL;
+}
+
+//************************************[ screen 7 ]****************************************** Input
+int ui_input_get_touch_coord(int *x, int *y)
+{
+    return sim_input_get_point(x, y);
+}
+
+int ui_input_get_keypay_val(char *v)
+{
+    return sim_input_get_key(v);
+}
+
+void ui_input_set_keypay_flag(void) { }
+
+int ui_other_get_LTR(int *ch0, int *ch1, int *ps)
+{
+    if(ch0) *ch0 = 120;
+    if(ch1) *ch1 = 40;
+    if(ps) *ps = 0;
+    return 0;
+}
+
+int ui_other_get_gyro(float *gyro_x, float *gyro_y, float *gyro_z)
+{
+    *gyro_x = 0.0f;
+    *gyro_y = 0.0f;
+    *gyro_z = 9.81f;
+    return 0;
+}
+
+//************************************[ screen 8 ]****************************************** A7682E
+bool ui_a7682_at_cb(const char *at_cmd) { return false; }
+void ui_a7682_call(const char *number) { }
+void ui_a7682_hang_up(void) { }
+void ui_a7682_loop_resume(void) { }
+void ui_a7682_loop_suspend(void) { }
+int ui_a7682_console_read(char *buf, int len) { return 0; }
+
+void ui_shutdown_on(void)
+{
+    LOG_INFO("Sim", "Shutdown requested from the UI");
+}
+
+//************************************[ screen 10 ]****************************************** PCM5102
+bool ui_pcm5102_cb(const char *at_cmd) { return false; }
+void ui_pcm5102_stop(void) { }
+
+//************************************[ screen 11 ]***************************************** search
+int ui_search(const char *query, int max, void (*cb)(const char *line), uint32_t *elapsed_ms)
+{
+    *elapsed_ms = 0;
+    return 0;
+}
+
+//************************************[ screen 12 ]***************************************** files
+// No SD card: the file manager says so
+int ui_files_open(const char *path, int sort, bool *building)
+{
+    *building = false;
+    return -1;
+}
+bool ui_files_get(uint32_t index, char *line, size_t len, char *name, size_t name_len, bool *is_dir) { return false; }
+int ui_files_poll(bool *building)
+{
+    *building = false;
+    return -1;
+}
+void ui_files_rebuild(void) { }
+void ui_files_close(void) { }
+bool ui_doc_open(const char *path, const lv_font_t *font, lv_coord_t w, lv_coord_t h) { return false; }
+uint32_t ui_doc_pages(bool *done)
+{
+    *done = true;
+    return 0;
+}
+bool ui_doc_render(uint32_t page, uint8_t *bits) { return false; }
+void ui_doc_close(void) { }
+
+// ===== No plugins, no deep sleep record =====
+
+int plugin_count() { return 0; }
+bool plugin_info(int index, plugin_info_t *info) { return false; }
+uint32_t plugin_generation() { return 0; }
+bool plugin_launch(const char *name) { return false; }
+void resume_state_restore_ui() { }
+
+// ===== No crash record to trace into =====
+
+void crash_trace(CrashTraceTag tag, uint32_t value) { }
+
+// ===== No wall clock: log stamps stay in uptime =====
+
+bool time_valid() { return false; }
+int64_t time_from_millis(uint32_t ms) { return (int64_t)ms * 1000; }
+size_t time_format_iso(int64_t utc_us, char *buf, size_t len) { return 0; }
+
+// ===== Metrics: recorded into the cells, never exported =====
+
+uint32_t metrics_counter_cells[portNUM_PROCESSORS][METRIC_COUNTER_COUNT];
+int32_t metrics_gauge_cells[METRIC_GAUGE_COUNT];
+MetricsHistCell metrics_hist_cells[portNUM_PROCESSORS][METRIC_HISTOGRAM_COUNT];
+
+// ===== One caller at a time, nothing to arbitrate =====
+
+bool spi_bus_acquire(int client, uint32_t timeout_ms) { return true; }
+void spi_bus_release(int client) { }
+
+// ===== MQTT: a client that never reaches a broker but keeps its loop alive =====
+
+bool mqtt_begin(const char *host, uint16_t port) { return true; }
+void mqtt_end() { }
+uint32_t mqtt_heartbeat() { return ++mqtt_loops; }
+void mqtt_suspend(bool suspend) { }
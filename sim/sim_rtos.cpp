@@ -0,0 +1,478 @@
+/**
+ * @file      sim_rtos.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     FreeRTOS tasks, queues and semaphores on std::thread
+ */
+
+#include <Arduino.h>
+#include "sim_clock.h"
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct SimTask {
+    std::string name;
+    TaskFunction_t fn;
+    void* param;
+    UBaseType_t priority;
+    BaseType_t core;
+    bool deleted;
+
+    std::mutex m;
+    std::condition_variable cv;
+    uint32_t notify_value;
+    bool notify_pending;
+    bool suspended;
+};
+
+enum SimQueueKind {
+    SIM_QUEUE,
+    SIM_SEMAPHORE,
+    SIM_MUTEX,
+    SIM_RECURSIVE_MUTEX,
+};
+
+struct SimQueue {
+    SimQueueKind kind;
+    size_t length;
+    size_t item_size;
+    std::vector<uint8_t> buf;
+    size_t head;
+    size_t count;                   // Items, or the semaphore count
+    TaskHandle_t holder;            // Mutexes
+    uint32_t recursion;
+
+    std::mutex m;
+    std::condition_variable cv;
+};
+
+static std::mutex tasks_mutex;
+static std::vector<SimTask*> tasks;
+static thread_local SimTask* current_task = nullptr;
+static const std::thread::id main_thread = std::this_thread::get_id();    // Static init runs on main
+
+static SimTask* new_task(const char* name, TaskFunction_t fn, void* param, UBaseType_t priority, BaseType_t core) {
+    SimTask* t = new SimTask();
+    t->name = name ? name : "";
+    if (t->name.size() >= configMAX_TASK_NAME_LEN) {
+        t->name.resize(configMAX_TASK_NAME_LEN - 1);
+    }
+    t->fn = fn;
+    t->param = param;
+    t->priority = priority;
+    t->core = core;
+    t->deleted = false;
+    t->notify_value = 0;
+    t->notify_pending = false;
+    t->suspended = false;
+    std::lock_guard<std::mutex> lock(tasks_mutex);
+    tasks.push_back(t);
+    return t;
+}
+
+static void forget_task(SimTask* t) {
+    std::lock_guard<std::mutex> lock(tasks_mutex);
+    for (size_t i = 0; i < tasks.size(); i++) {
+        if (tasks[i] == t) {
+            tasks.erase(tasks.begin() + i);
+            break;
+        }
+    }
+    t->deleted = true;
+}
+
+// Threads that did not come from xTaskCreate (main, LVGL's caller) get a handle on first use
+static SimTask* self() {
+    if (!current_task) {
+        current_task = new_task(std::this_thread::get_id() == main_thread ? "main" : "host", nullptr, nullptr, 1, 1);
+    }
+    return current_task;
+}
+
+static bool wait_until(std::unique_lock<std::mutex>& lock, std::condition_variable& cv, TickType_t ticks,
+                       const std::function<bool()>& ready) {
+    if (ticks == portMAX_DELAY) {
+        cv.wait(lock, ready);
+        return true;
+    }
+    return cv.wait_for(lock, std::chrono::milliseconds(ticks), ready);
+}
+
+// ===== Port =====
+
+extern "C" void vPortCPUInitializeMutex(portMUX_TYPE* mux) {
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&mux->lock, &attr);
+    pthread_mutexattr_destroy(&attr);
+}
+
+extern "C" BaseType_t xPortInIsrContext(void) {
+    return pdFALSE;
+}
+
+extern "C" BaseType_t xPortGetCoreID(void) {
+    SimTask* t = self();
+    return t->core == tskNO_AFFINITY ? 0 : t->core;
+}
+
+// ===== Tasks =====
+
+extern "C" BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char* name, uint32_t stack_depth, void* param,
+                                              UBaseType_t priority, TaskHandle_t* created, BaseType_t core) {
+    SimTask* t = new_task(name, fn, param, priority, core);
+    if (created) {
+        *created = t;
+    }
+    std::thread([t] {
+        current_task = t;
+        t->fn(t->param);
+        // A FreeRTOS task must not return; treat it as deleting itself
+        forget_task(t);
+    }).detach();
+    return pdPASS;
+}
+
+extern "C" BaseType_t xTaskCreate(TaskFunction_t fn, const char* name, uint32_t stack_depth, void* param,
+                                  UBaseType_t priority, TaskHandle_t* created) {
+    return xTaskCreatePinnedToCore(fn, name, stack_depth, param, priority, created, tskNO_AFFINITY);
+}
+
+extern "C" void vTaskDelete(TaskHandle_t task) {
+    SimTask* t = task ? task : self();
+    forget_task(t);
+    if (t == current_task) {
+        pthread_exit(nullptr);
+    }
+    // Another thread cannot be stopped from outside; it is only forgotten
+}
+
+extern "C" void vTaskDelay(TickType_t ticks) {
+    if (ticks == 0) {
+        std::this_thread::yield();
+        return;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+}
+
+extern "C" BaseType_t xTaskDelayUntil(TickType_t* previous, TickType_t increment) {
+    TickType_t wake = *previous + increment;
+    TickType_t now = xTaskGetTickCount();
+    *previous = wake;
+    if ((int32_t)(wake - now) <= 0) {
+        return pdFALSE;
+    }
+    vTaskDelay(wake - now);
+    return pdTRUE;
+}
+
+extern "C" void vTaskDelayUntil(TickType_t* previous, TickType_t increment) {
+    xTaskDelayUntil(previous, increment);
+}
+
+extern "C" TickType_t xTaskGetTickCount(void) {
+    return (TickType_t)(sim_clock_us() / 1000);
+}
+
+extern "C" TickType_t xTaskGetTickCountFromISR(void) {
+    return xTaskGetTickCount();
+}
+
+extern "C" TaskHandle_t xTaskGetCurrentTaskHandle(void) {
+    return self();
+}
+
+extern "C" char* pcTaskGetName(TaskHandle_t task) {
+    SimTask* t = task ? task : self();
+    return (char*)t->name.c_str();
+}
+
+extern "C" UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task) {
+    // Host threads have megabytes; report a healthy margin rather than a number to tune against
+    return 4096;
+}
+
+extern "C" UBaseType_t uxTaskPriorityGet(TaskHandle_t task) {
+    return (task ? task : self())->priority;
+}
+
+extern "C" void vTaskPrioritySet(TaskHandle_t task, UBaseType_t priority) {
+    (task ? task : self())->priority = priority;
+}
+
+extern "C" void vTaskSuspend(TaskHandle_t task) {
+    SimTask* t = task ? task : self();
+    std::unique_lock<std::mutex> lock(t->m);
+    t->suspended = true;
+    // Only a task suspending itself can actually stop
+    if (t == current_task) {
+        t->cv.wait(lock, [t] { return !t->suspended; });
+    }
+}
+
+extern "C" void vTaskResume(TaskHandle_t task) {
+    if (!task) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(task->m);
+    task->suspended = false;
+    task->cv.notify_all();
+}
+
+extern "C" eTaskState eTaskGetState(TaskHandle_t task) {
+    if (!task) {
+        return eInvalid;
+    }
+    if (task->deleted) {
+        return eDeleted;
+    }
+    return task->suspended ? eSuspended : (task == current_task ? eRunning : eBlocked);
+}
+
+extern "C" UBaseType_t uxTaskGetNumberOfTasks(void) {
+    std::lock_guard<std::mutex> lock(tasks_mutex);
+    return tasks.size();
+}
+
+extern "C" void taskYIELD(void) {
+    std::this_thread::yield();
+}
+
+// ===== Notifications =====
+
+extern "C" BaseType_t xTaskGenericNotify(TaskHandle_t task, uint32_t value, eNotifyAction action, uint32_t* previous) {
+    if (!task) {
+        return pdFAIL;
+    }
+    std::lock_guard<std::mutex> lock(task->m);
+    if (previous) {
+        *previous = task->notify_value;
+    }
+    switch (action) {
+        case eSetBits:                  task->notify_value |= value; break;
+        case eIncrement:                task->notify_value++; break;
+        case eSetValueWithOverwrite:    task->notify_value = value; break;
+        case eSetValueWithoutOverwrite:
+            if (task->notify_pending) {
+                return pdFAIL;
+            }
+            task->notify_value = value;
+            break;
+        default: break;
+    }
+    task->notify_pending = true;
+    task->cv.notify_all();
+    return pdPASS;
+}
+
+extern "C" BaseType_t xTaskNotifyWait(uint32_t clear_on_entry, uint32_t clear_on_exit, uint32_t* value, TickType_t ticks) {
+    SimTask* t = self();
+    std::unique_lock<std::mutex> lock(t->m);
+    if (!t->notify_pending) {
+        t->notify_value &= ~clear_on_entry;
+    }
+    if (!wait_until(lock, t->cv, ticks, [t] { return t->notify_pending; })) {
+        if (value) {
+            *value = t->notify_value;
+        }
+        return pdFALSE;
+    }
+    if (value) {
+        *value = t->notify_value;
+    }
+    t->notify_value &= ~clear_on_exit;
+    t->notify_pending = false;
+    return pdTRUE;
+}
+
+extern "C" uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks) {
+    SimTask* t = self();
+    std::unique_lock<std::mutex> lock(t->m);
+    wait_until(lock, t->cv, ticks, [t] { return t->notify_value != 0; });
+    uint32_t value = t->notify_value;
+    if (value) {
+        t->notify_value = clear_on_exit ? 0 : value - 1;
+    }
+    t->notify_pending = false;
+    return value;
+}
+
+// ===== Queues =====
+
+static SimQueue* new_queue(SimQueueKind kind, size_t length, size_t item_size, size_t initial) {
+    SimQueue* q = new SimQueue();
+    q->kind = kind;
+    q->length = length;
+    q->item_size = item_size;
+    q->buf.resize(length * item_size);
+    q->head = 0;
+    q->count = initial;
+    q->holder = nullptr;
+    q->recursion = 0;
+    return q;
+}
+
+extern "C" QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size) {
+    return length ? new_queue(SIM_QUEUE, length, item_size, 0) : nullptr;
+}
+
+extern "C" void vQueueDelete(QueueHandle_t queue) {
+    delete queue;
+}
+
+extern "C" BaseType_t xQueueGenericSend(QueueHandle_t q, const void* item, TickType_t ticks, BaseType_t front) {
+    std::unique_lock<std::mutex> lock(q->m);
+    if (!wait_until(lock, q->cv, ticks, [q] { return q->count < q->length; })) {
+        return errQUEUE_FULL;
+    }
+    size_t slot;
+    if (front) {
+        q->head = (q->head + q->length - 1) % q->length;
+        slot = q->head;
+    } else {
+        slot = (q->head + q->count) % q->length;
+    }
+    if (q->item_size) {
+        memcpy(&q->buf[slot * q->item_size], item, q->item_size);
+    }
+    q->count++;
+    q->cv.notify_all();
+    return pdPASS;
+}
+
+extern "C" BaseType_t xQueueOverwrite(QueueHandle_t q, const void* item) {
+    std::lock_guard<std::mutex> lock(q->m);
+    if (q->count == q->length) {
+        q->head = (q->head + 1) % q->length;
+        q->count--;
+    }
+    memcpy(&q->buf[((q->head + q->count) % q->length) * q->item_size], item, q->item_size);
+    q->count++;
+    q->cv.notify_all();
+    return pdPASS;
+}
+
+static BaseType_t take(QueueHandle_t q, void* item, TickType_t ticks, bool remove) {
+    std::unique_lock<std::mutex> lock(q->m);
+    if (!wait_until(lock, q->cv, ticks, [q] { return q->count > 0; })) {
+        return pdFALSE;
+    }
+    if (q->item_size && item) {
+        memcpy(item, &q->buf[q->head * q->item_size], q->item_size);
+    }
+    if (remove) {
+        if (q->kind == SIM_QUEUE) {
+            q->head = (q->head + 1) % q->length;
+        }
+        q->count--;
+        q->cv.notify_all();
+    }
+    return pdTRUE;
+}
+
+extern "C" BaseType_t xQueueReceive(QueueHandle_t q, void* item, TickType_t ticks) {
+    return take(q, item, ticks, true);
+}
+
+extern "C" BaseType_t xQueuePeek(QueueHandle_t q, void* item, TickType_t ticks) {
+    return take(q, item, ticks, false);
+}
+
+extern "C" BaseType_t xQueueReset(QueueHandle_t q) {
+    std::lock_guard<std::mutex> lock(q->m);
+    q->head = 0;
+    q->count = 0;
+    q->cv.notify_all();
+    return pdPASS;
+}
+
+extern "C" UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q) {
+    std::lock_guard<std::mutex> lock(q->m);
+    return q->count;
+}
+
+extern "C" UBaseType_t uxQueueSpacesAvailable(QueueHandle_t q) {
+    std::lock_guard<std::mutex> lock(q->m);
+    return q->length - q->count;
+}
+
+// ===== Semaphores and mutexes =====
+
+extern "C" SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max, UBaseType_t initial) {
+    return new_queue(SIM_SEMAPHORE, max, 0, initial);
+}
+
+extern "C" SemaphoreHandle_t xSemaphoreCreateMutex(void) {
+    return new_queue(SIM_MUTEX, 1, 0, 1);
+}
+
+extern "C" SemaphoreHandle_t xSemaphoreCreateRecursiveMutex(void) {
+    return new_queue(SIM_RECURSIVE_MUTEX, 1, 0, 1);
+}
+
+extern "C" BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks) {
+    if (!take(sem, nullptr, ticks, true)) {
+        return pdFALSE;
+    }
+    if (sem->kind != SIM_SEMAPHORE) {
+        sem->holder = self();
+    }
+    return pdTRUE;
+}
+
+extern "C" BaseType_t xSemaphoreGive(SemaphoreHandle_t sem) {
+    std::lock_guard<std::mutex> lock(sem->m);
+    if (sem->count >= sem->length) {
+        return pdFALSE;
+    }
+    sem->holder = nullptr;
+    sem->count++;
+    sem->cv.notify_all();
+    return pdTRUE;
+}
+
+extern "C" BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t sem, TickType_t ticks) {
+    TaskHandle_t me = self();
+    {
+        std::lock_guard<std::mutex> lock(sem->m);
+        if (sem->holder == me) {
+            sem->recursion++;
+            return pdTRUE;
+        }
+    }
+    if (!xSemaphoreTake(sem, ticks)) {
+        return pdFALSE;
+    }
+    sem->recursion = 1;
+    return pdTRUE;
+}
+
+extern "C" BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t sem) {
+    {
+        std::lock_guard<std::mutex> lock(sem->m);
+        if (sem->holder != self()) {
+            return pdFALSE;
+        }
+        if (--sem->recursion > 0) {
+            return pdTRUE;
+        }
+    }
+    return xSemaphoreGive(sem);
+}
+
+extern "C" UBaseType_t uxSemaphoreGetCount(SemaphoreHandle_t sem) {
+    return uxQueueMessagesWaiting(sem);
+}
+
+extern "C" TaskHandle_t xSemaphoreGetMutexHolder(SemaphoreHandle_t sem) {
+    std::lock_guard<std::mutex> lock(sem->m);
+    return sem->holder;
+}
@@ -0,0 +1,129 @@
+/**
+ * @file      ambient_service.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Keypad backlight from ambient light and in-call blanking from proximity
+ */
+
+#include "ambient_service.h"
+#include "simple_logger.h"
+#include "peripheral.h"
+#include "utilities.h"
+#include "modem_at.h"
+#include "lvgl_integration.h"
+#ifdef INTEGRATION_LAYER_ENABLED
+#include "integration/config_manager.h"
+#endif
+
+#define AMBIENT_BLANK_NONE  -1
+
+// Sensor task and modem task write, the UI task takes the blank change
+static volatile bool auto_backlight = true;
+static volatile bool call_blank = true;
+static volatile bool in_call = false;
+static volatile bool is_near = false;
+static volatile bool blanked = false;
+static volatile int8_t pending_blank = AMBIENT_BLANK_NONE;
+static portMUX_TYPE ambient_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// Blank only while a call is up and something covers the sensor
+static void update_blank() {
+    portENTER_CRITICAL(&ambient_mux);
+    bool blank = call_blank && in_call && is_near;
+    bool changed = blank != blanked;
+    if (changed) {
+        blanked = blank;
+        pending_blank = blank;
+    }
+    portEXIT_CRITICAL(&ambient_mux);
+
+    if (changed && LVGL) {
+        LVGL->wake();
+    }
+}
+
+static void on_sensor(int event, uint16_t value) {
+    switch (event) {
+        case LTR553_EVT_DARK:
+        case LTR553_EVT_BRIGHT:
+            if (auto_backlight) {
+                digitalWrite(BOARD_KEYBOARD_LED, event == LTR553_EVT_DARK);
+            }
+            break;
+        case LTR553_EVT_NEAR:
+        case LTR553_EVT_FAR:
+            is_near = event == LTR553_EVT_NEAR;
+            update_blank();
+            break;
+    }
+}
+
+// "VOICE CALL: BEGIN" / "VOICE CALL: END: 0:12"
+static void on_voice_call(const char *line, void *ctx) {
+    ambient_set_call(strstr(line, "BEGIN") != NULL);
+}
+
+static void on_no_carrier(const char *line, void *ctx) {
+    ambient_set_call(false);
+}
+
+bool ambient_begin() {
+#ifdef INTEGRATION_LAYER_ENABLED
+    auto_backlight = GET_CONFIG_BOOL("ambient", "auto_backlight", true);
+    call_blank = GET_CONFIG_BOOL("ambient", "call_blank", true);
+#endif
+    if (!auto_backlight && !call_blank) {
+        LOG_INFO("Ambient", "Backlight and call blanking disabled in config");
+        return false;
+    }
+    if (!peri_init_ensure(E_PERI_LTR_553ALS) && !LTR553_init()) {
+        LOG_WARN("Ambient", "No LTR553, keypad light and call blanking unavailable");
+        return false;
+    }
+
+    pinMode(BOARD_KEYBOARD_LED, OUTPUT);
+    LTR553_set_event_cb(on_sensor);
+    modem_at_on_urc("VOICE CALL:", on_voice_call);
+    modem_at_on_urc("NO CARRIER", on_no_carrier);
+
+    LOG_INFOF("Ambient", "Running on LTR553 INT: backlight %s, call blanking %s",
+              auto_backlight ? "auto" : "manual", call_blank ? "on" : "off");
+    return true;
+}
+
+void ambient_set_call(bool active) {
+    if (active == in_call) {
+        return;
+    }
+    in_call = active;
+    LOG_INFOF("Ambient", "Voice call %s", active ? "up" : "down");
+    update_blank();
+}
+
+bool ambient_in_call() {
+    return in_call;
+}
+
+void ambient_set_auto_backlight(bool enable) {
+    auto_backlight = enable;
+    if (enable) {
+        ltr553_stats_t stats;
+        LTR553_get_stats(&stats);
+        digitalWrite(BOARD_KEYBOARD_LED, stats.dark);
+    }
+}
+
+bool ambient_take_blank(bool *blank) {
+    portENTER_CRITICAL(&ambient_mux);
+    int8_t pending = pending_blank;
+    pending_blank = AMBIENT_BLANK_NONE;
+    portEXIT_CRITICAL(&ambient_mux);
+
+    if (pending == AMBIENT_BLANK_NONE) {
+        return false;
+    }
+    *blank = pending;
+    return true;
+}
@@ -0,0 +1,46 @@
+/**
+ * @file      ambient_service.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Keypad backlight from ambient light and in-call blanking from proximity
+ */
+
+#ifndef AMBIENT_SERVICE_H
+#define AMBIENT_SERVICE_H
+
+#include <Arduino.h>
+
+/**
+ * Runs off LTR553 interrupts only. A dark/bright crossing switches the
+ * keypad light (BOARD_KEYBOARD_LED); while an A7682E voice call is up, a
+ * near reading blanks the display and touch and a far one brings them back.
+ * Call state comes from the modem's "VOICE CALL:" and "NO CARRIER" URCs, or
+ * from a dialer through ambient_set_call()
+ */
+
+/**
+ * @brief Bring up the sensor if needed and hook its events and the modem
+ *        URCs. Reads ambient.auto_backlight and ambient.call_blank. UI task
+ */
+bool ambient_begin();
+
+/**
+ * @brief Call up or down, for code that knows before the modem says so
+ */
+void ambient_set_call(bool active);
+bool ambient_in_call();
+
+/**
+ * @brief Let the light sensor drive the keypad light; off leaves it as set
+ */
+void ambient_set_auto_backlight(bool enable);
+
+/**
+ * @brief A change of the blanked state, once. The UI loop applies it with
+ *        LVGLIntegration::setBlanked()
+ */
+bool ambient_take_blank(bool *blank);
+
+#endif // AMBIENT_SERVICE_H
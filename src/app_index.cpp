@@ -0,0 +1,147 @@
+/**
+ * @file      app_index.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Launcher entries for the built-in screens and installed plugins, kept in NVS
+ */
+
+#include "app_index.h"
+#include "plugin_runtime.h"
+#include "simple_logger.h"
+#include <Preferences.h>
+#include <esp_rom_crc.h>
+
+struct AppIndexRecord {
+    uint32_t magic;
+    uint32_t generation;            // plugin_generation() it was built for
+    uint32_t builtin_crc;
+    uint16_t count;
+    uint16_t reserved;
+    app_entry_t entries[APP_INDEX_MAX_ENTRIES];
+    uint32_t crc;
+};
+
+static app_entry_t builtins[APP_INDEX_MAX_ENTRIES];
+static int builtin_count = 0;
+static AppIndexRecord app_index;
+static app_index_stats_t app_stats;
+
+static uint32_t record_crc(const AppIndexRecord *r) {
+    return esp_rom_crc32_le(0, (const uint8_t *)r, offsetof(AppIndexRecord, crc));
+}
+
+static uint32_t builtin_crc() {
+    return esp_rom_crc32_le(0, (const uint8_t *)builtins, builtin_count * sizeof(app_entry_t));
+}
+
+static bool load_record(AppIndexRecord *r) {
+    Preferences prefs;
+    if (!prefs.begin(APP_INDEX_NVS_NAMESPACE, true)) {
+        return false;
+    }
+    bool ok = prefs.getBytes("index", r, sizeof(*r)) == sizeof(*r) &&
+              r->magic == APP_INDEX_MAGIC && r->crc == record_crc(r) && r->count <= APP_INDEX_MAX_ENTRIES;
+    prefs.end();
+    return ok;
+}
+
+static void store_record(const AppIndexRecord *r) {
+    Preferences prefs;
+    if (prefs.begin(APP_INDEX_NVS_NAMESPACE, false)) {
+        prefs.putBytes("index", r, sizeof(*r));
+        prefs.end();
+    }
+}
+
+// Stable, so each folder keeps the built-in order with plugins after it
+static void sort_by_folder(app_entry_t *e, int n) {
+    for (int i = 1; i < n; i++) {
+        app_entry_t tmp = e[i];
+        int j = i;
+        while (j > 0 && e[j - 1].folder > tmp.folder) {
+            e[j] = e[j - 1];
+            j--;
+        }
+        e[j] = tmp;
+    }
+}
+
+static void rebuild() {
+    uint32_t start = millis();
+    memset(&app_index, 0, sizeof(app_index));
+    app_index.magic = APP_INDEX_MAGIC;
+    app_index.generation = plugin_generation();
+    app_index.builtin_crc = builtin_crc();
+
+    int n = builtin_count;
+    memcpy(app_index.entries, builtins, n * sizeof(app_entry_t));
+    int plugins = plugin_count();
+    for (int i = 0; i < plugins && n < APP_INDEX_MAX_ENTRIES; i++) {
+        plugin_info_t info;
+        if (!plugin_info(i, &info)) {
+            break;
+        }
+        app_entry_t *e = &app_index.entries[n++];
+        e->kind = APP_KIND_PLUGIN;
+        e->icon = APP_INDEX_PLUGIN_ICON;
+        e->folder = 0;
+        e->target = -1;
+        strncpy(e->name, info.name, sizeof(e->name) - 1);
+    }
+    if (n < builtin_count + plugins) {
+        LOG_WARNF("Apps", "Index full, %d plugins not shown", builtin_count + plugins - n);
+    }
+    sort_by_folder(app_index.entries, n);
+    app_index.count = n;
+    app_index.crc = record_crc(&app_index);
+    store_record(&app_index);
+
+    app_stats.rebuilds++;
+    LOG_INFOF("Apps", "Index rebuilt, %d entries in %lu ms", n, (unsigned long)(millis() - start));
+}
+
+bool app_index_begin(const app_entry_t *builtin, int count) {
+    builtin_count = MIN(count, APP_INDEX_MAX_ENTRIES);
+    memset(builtins, 0, sizeof(builtins));
+    memcpy(builtins, builtin, builtin_count * sizeof(app_entry_t));
+
+    if (load_record(&app_index) && app_index.generation == plugin_generation() &&
+        app_index.builtin_crc == builtin_crc()) {
+        app_stats.loaded = true;
+    } else {
+        app_stats.loaded = false;
+        rebuild();
+    }
+    return true;
+}
+
+bool app_index_refresh() {
+    if (app_index.magic == APP_INDEX_MAGIC && app_index.generation == plugin_generation()) {
+        return false;
+    }
+    rebuild();
+    return true;
+}
+
+int app_index_folder(int folder, const app_entry_t **entries) {
+    int first = -1, n = 0;
+    for (int i = 0; i < app_index.count; i++) {
+        if (app_index.entries[i].folder == folder) {
+            if (first < 0) {
+                first = i;
+            }
+            n++;
+        } else if (first >= 0) {
+            break;
+        }
+    }
+    *entries = first >= 0 ? &app_index.entries[first] : NULL;
+    return n;
+}
+
+void app_index_get_stats(app_index_stats_t *stats) {
+    *stats = app_stats;
+    stats->entries = app_index.count;
+}
@@ -0,0 +1,73 @@
+/**
+ * @file      app_index.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Launcher entries for the built-in screens and installed plugins, kept in NVS
+ */
+
+#ifndef APP_INDEX_H
+#define APP_INDEX_H
+
+#include <Arduino.h>
+#include "config/os_config.h"
+#include "src/icon_atlas.h"
+
+/**
+ * What the launcher shows: a name, an icon cell of the atlas and what to
+ * open, for the firmware's screens and folders and for each installed
+ * plugin. The list is kept in NVS sorted by folder, so a folder is one
+ * contiguous run and a page of the grid is a slice of it.
+ *
+ * It is only rebuilt when the plugins installed or the built-in table
+ * changed, which a generation number and a CRC of the table tell at boot
+ * without reading any plugin header. All calls are from the LVGL task.
+ */
+
+#define APP_INDEX_MAX_ENTRIES       32
+#define APP_INDEX_MAGIC             0x58444941UL  // "AIDX"
+#define APP_INDEX_NVS_NAMESPACE     "appidx"
+#define APP_INDEX_PLUGIN_ICON       ICON_SD       // Plugins carry no icon; they came from the card
+
+enum AppKind {
+    APP_KIND_SCREEN = 0,
+    APP_KIND_FOLDER,
+    APP_KIND_PLUGIN,
+};
+
+typedef struct {
+    uint8_t kind;                   // AppKind
+    uint8_t icon;                   // ICON_* cell of img_icons_1bpp
+    int16_t folder;                 // Folder it is shown in, 0 for the top level
+    int16_t target;                 // Screen or folder id; unused for plugins
+    char name[APP_NAME_MAX_LENGTH]; // For plugins, what plugin_launch() takes
+} app_entry_t;
+
+typedef struct {
+    uint16_t entries;
+    uint32_t rebuilds;
+    bool loaded;                    // The stored index was current at boot
+} app_index_stats_t;
+
+/**
+ * @brief Load the stored index, or build and store it if it is stale.
+ *        The built-in table is copied; call again if it changes
+ */
+bool app_index_begin(const app_entry_t *builtin, int count);
+
+/**
+ * @brief Rebuild if plugins were installed or removed since the last build
+ * @return true if the entries changed
+ */
+bool app_index_refresh();
+
+/**
+ * @brief The entries shown in a folder, in order
+ * @return how many; *entries points at the first
+ */
+int app_index_folder(int folder, const app_entry_t **entries);
+
+void app_index_get_stats(app_index_stats_t *stats);
+
+#endif // APP_INDEX_H
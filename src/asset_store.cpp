@@ -0,0 +1,387 @@
+/**
+ * @file      asset_store.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Asset pack mapping and the LVGL descriptors that point into it
+ */
+
+#include "asset_store.h"
+#include "simple_logger.h"
+#include "glyph_cache.h"
+#include "usb_console.h"
+#include "src/assets.h"
+#include <Preferences.h>
+#include <esp_rom_crc.h>
+
+static_assert(sizeof(AssetPackHeader) == 32, "Pack header layout");
+static_assert(sizeof(AssetPackEntry) == 36, "Pack entry layout");
+static_assert(sizeof(AssetFontRecord) == 28, "Font record layout");
+static_assert(sizeof(AssetFontCmap) == 20, "Cmap layout");
+static_assert(sizeof(AssetImageRecord) == 16, "Image record layout");
+#if LV_FONT_FMT_TXT_LARGE
+#error "Asset packs store glyph descriptors in the LV_FONT_FMT_TXT_LARGE 0 layout"
+#endif
+static_assert(sizeof(lv_font_fmt_txt_glyph_dsc_t) == 8, "Glyph descriptor layout");
+
+struct AssetFont {
+    const char *name;               // In the mapping
+    lv_font_t font;
+    lv_font_fmt_txt_dsc_t dsc;
+    lv_font_fmt_txt_glyph_cache_t cache;
+    lv_font_fmt_txt_cmap_t *cmaps;
+};
+
+struct AssetImage {
+    const char *name;
+    lv_img_dsc_t img;
+};
+
+static const esp_partition_t *asset_part = nullptr;
+static spi_flash_mmap_handle_t asset_map;
+static const uint8_t *asset_base = nullptr;
+static const AssetPackHeader *asset_header = nullptr;
+static const AssetPackEntry *asset_entries = nullptr;
+
+static AssetFont asset_fonts[ASSET_FONTS_MAX];
+static AssetImage asset_images[ASSET_IMAGES_MAX];
+static AssetStoreStats asset_stats;
+
+#ifdef ASSETS_PARTITION
+// The app's own asset symbols (src/src/assets.h), filled in from the pack
+lv_font_t Font_Mono_Bold_14;
+lv_font_t Font_Mono_Bold_15;
+lv_font_t Font_Mono_Bold_16;
+lv_font_t Font_Mono_Bold_17;
+lv_font_t Font_Mono_Bold_18;
+lv_font_t Font_Mono_Bold_19;
+lv_font_t Font_Mono_Bold_20;
+lv_img_dsc_t img_icon_atlas_1bpp;
+lv_img_dsc_t img_icons_1bpp[ICON_ATLAS_COUNT];
+lv_img_dsc_t img_start_1bpp;
+
+static const struct {
+    const char *name;
+    lv_font_t *font;
+} bound_fonts[] = {
+    { "Font_Mono_Bold_14", &Font_Mono_Bold_14 },
+    { "Font_Mono_Bold_15", &Font_Mono_Bold_15 },
+    { "Font_Mono_Bold_16", &Font_Mono_Bold_16 },
+    { "Font_Mono_Bold_17", &Font_Mono_Bold_17 },
+    { "Font_Mono_Bold_18", &Font_Mono_Bold_18 },
+    { "Font_Mono_Bold_19", &Font_Mono_Bold_19 },
+    { "Font_Mono_Bold_20", &Font_Mono_Bold_20 },
+};
+
+static const struct {
+    const char *name;
+    lv_img_dsc_t *img;
+} bound_images[] = {
+    { "img_icon_atlas_1bpp", &img_icon_atlas_1bpp },
+    { "img_start_1bpp", &img_start_1bpp },
+};
+#endif
+
+// ===== Slots =====
+
+static const esp_partition_t *slot_partition(int i) {
+    return esp_partition_find_first(ESP_PARTITION_TYPE_DATA, (esp_partition_subtype_t)ASSET_PARTITION_SUBTYPE,
+                                    i ? ASSET_PARTITION_LABEL_1 : ASSET_PARTITION_LABEL_0);
+}
+
+static int slot_index(const esp_partition_t *part) {
+    return part && !strcmp(part->label, ASSET_PARTITION_LABEL_1) ? 1 : 0;
+}
+
+// Header sane and the CRC of the rest matching, for a pack at base
+static bool pack_valid(const uint8_t *base, uint32_t part_size) {
+    const AssetPackHeader *h = (const AssetPackHeader *)base;
+    if (h->magic != ASSET_PACK_MAGIC || h->version != ASSET_PACK_VERSION || h->size > part_size ||
+        h->size < sizeof(*h) + (uint64_t)h->count * sizeof(AssetPackEntry)) {
+        return false;
+    }
+    return esp_rom_crc32_le(0, base + sizeof(*h), h->size - sizeof(*h)) == h->crc32;
+}
+
+static bool slot_map(const esp_partition_t *part) {
+    const void *p;
+    spi_flash_mmap_handle_t handle;
+    if (!part || esp_partition_mmap(part, 0, part->size, SPI_FLASH_MMAP_DATA, &p, &handle) != ESP_OK) {
+        return false;
+    }
+    if (!pack_valid((const uint8_t *)p, part->size)) {
+        spi_flash_munmap(handle);
+        return false;
+    }
+    asset_part = part;
+    asset_map = handle;
+    asset_base = (const uint8_t *)p;
+    asset_header = (const AssetPackHeader *)p;
+    asset_entries = (const AssetPackEntry *)(asset_base + sizeof(AssetPackHeader));
+    return true;
+}
+
+// ===== Records =====
+
+static inline bool in_pack(uint32_t offset, uint64_t len) {
+    return offset % 4 == 0 && offset + len <= asset_header->size;
+}
+
+static bool load_font(const AssetPackEntry *e, AssetFont *f) {
+    const AssetFontRecord *r = (const AssetFontRecord *)(asset_base + e->offset);
+    if (e->size < sizeof(*r) || !in_pack(r->glyph_dsc, (uint64_t)r->glyph_count * sizeof(lv_font_fmt_txt_glyph_dsc_t)) ||
+        !in_pack(r->glyph_bitmap, r->bitmap_size) || !in_pack(r->cmaps, (uint64_t)r->cmap_num * sizeof(AssetFontCmap)) ||
+        !r->cmap_num) {
+        return false;
+    }
+    const AssetFontCmap *src = (const AssetFontCmap *)(asset_base + r->cmaps);
+    for (uint8_t i = 0; i < r->cmap_num; i++) {
+        // FORMAT0_FULL is indexed by the codepoint's offset into the range
+        uint32_t ofs_len = src[i].type == LV_FONT_FMT_TXT_CMAP_FORMAT0_FULL ? src[i].range_length
+                         : src[i].type == LV_FONT_FMT_TXT_CMAP_SPARSE_FULL ? src[i].list_length * 2UL
+                         : src[i].list_length;
+        if ((src[i].unicode_list && !in_pack(src[i].unicode_list, src[i].list_length * 2UL)) ||
+            (src[i].glyph_id_ofs_list && !in_pack(src[i].glyph_id_ofs_list, ofs_len))) {
+            return false;
+        }
+    }
+
+    // The cmaps hold pointers, so they are the one part rebuilt in RAM
+    f->cmaps = (lv_font_fmt_txt_cmap_t *)calloc(r->cmap_num, sizeof(lv_font_fmt_txt_cmap_t));
+    if (!f->cmaps) {
+        return false;
+    }
+    for (uint8_t i = 0; i < r->cmap_num; i++) {
+        lv_font_fmt_txt_cmap_t *c = &f->cmaps[i];
+        c->range_start = src[i].range_start;
+        c->range_length = src[i].range_length;
+        c->glyph_id_start = src[i].glyph_id_start;
+        c->unicode_list = src[i].unicode_list ? (const uint16_t *)(asset_base + src[i].unicode_list) : NULL;
+        c->glyph_id_ofs_list = src[i].glyph_id_ofs_list ? asset_base + src[i].glyph_id_ofs_list : NULL;
+        c->list_length = src[i].list_length;
+        c->type = (lv_font_fmt_txt_cmap_type_t)src[i].type;
+    }
+
+    f->name = e->name;
+    memset(&f->dsc, 0, sizeof(f->dsc));
+    f->dsc.glyph_bitmap = asset_base + r->glyph_bitmap;
+    f->dsc.glyph_dsc = (const lv_font_fmt_txt_glyph_dsc_t *)(asset_base + r->glyph_dsc);
+    f->dsc.cmaps = f->cmaps;
+    f->dsc.cmap_num = r->cmap_num;
+    f->dsc.bpp = r->bpp;
+    f->dsc.bitmap_format = r->bitmap_format;
+    f->dsc.cache = &f->cache;
+
+    memset(&f->font, 0, sizeof(f->font));
+    f->font.get_glyph_dsc = lv_font_get_glyph_dsc_fmt_txt;
+    f->font.get_glyph_bitmap = lv_font_get_bitmap_fmt_txt;
+    f->font.line_height = r->line_height;
+    f->font.base_line = r->base_line;
+    f->font.subpx = r->subpx;
+    f->font.underline_position = r->underline_position;
+    f->font.underline_thickness = r->underline_thickness;
+    f->font.dsc = &f->dsc;
+    return true;
+}
+
+static bool load_image(const AssetPackEntry *e, AssetImage *img) {
+    const AssetImageRecord *r = (const AssetImageRecord *)(asset_base + e->offset);
+    if (e->size < sizeof(*r) || r->data + (uint64_t)r->data_size > asset_header->size) {
+        return false;
+    }
+    img->name = e->name;
+    memset(&img->img, 0, sizeof(img->img));
+    img->img.header.cf = r->cf;
+    img->img.header.w = r->w;
+    img->img.header.h = r->h;
+    img->img.data_size = r->data_size;
+    img->img.data = asset_base + r->data;
+    return true;
+}
+
+static void load_entries() {
+    for (uint32_t i = 0; i < asset_header->count; i++) {
+        const AssetPackEntry *e = &asset_entries[i];
+        bool ok = e->name[ASSET_NAME_MAX - 1] == '\0' && in_pack(e->offset, e->size);
+        if (ok && e->type == ASSET_FONT) {
+            ok = asset_stats.fonts < ASSET_FONTS_MAX && load_font(e, &asset_fonts[asset_stats.fonts]);
+            asset_stats.fonts += ok;
+        } else if (ok && e->type == ASSET_IMAGE) {
+            ok = asset_stats.images < ASSET_IMAGES_MAX && load_image(e, &asset_images[asset_stats.images]);
+            asset_stats.images += ok;
+        } else if (ok && e->type == ASSET_BLOB) {
+            asset_stats.blobs++;
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            asset_stats.rejected++;
+            LOG_WARNF("Assets", "Entry %lu (%.*s) rejected", (unsigned long)i, ASSET_NAME_MAX, e->name);
+        }
+    }
+}
+
+#ifdef ASSETS_PARTITION
+static void bind_app_assets() {
+    for (size_t i = 0; i < sizeof(bound_fonts) / sizeof(bound_fonts[0]); i++) {
+        const lv_font_t *font = asset_store_font(bound_fonts[i].name);
+        if (!font) {
+            LOG_ERRORF("Assets", "No %s in the pack, using the default font", bound_fonts[i].name);
+            font = LV_FONT_DEFAULT;
+        }
+        *bound_fonts[i].font = *font;
+    }
+    for (size_t i = 0; i < sizeof(bound_images) / sizeof(bound_images[0]); i++) {
+        const lv_img_dsc_t *img = asset_store_image(bound_images[i].name);
+        if (img) {
+            *bound_images[i].img = *img;
+        } else {
+            LOG_ERRORF("Assets", "No %s in the pack", bound_images[i].name);
+        }
+    }
+    // Icons are cells of the atlas, named by their ICON_* index
+    for (int i = 0; i < ICON_ATLAS_COUNT; i++) {
+        char name[ASSET_NAME_MAX];
+        snprintf(name, sizeof(name), "icon_%d", i);
+        const lv_img_dsc_t *img = asset_store_image(name);
+        if (img) {
+            img_icons_1bpp[i] = *img;
+        }
+    }
+    // The cached wrappers copied the fonts before they were filled in
+    glyph_cache_rebind();
+}
+#endif
+
+// ===== Console =====
+
+static const char *type_name(uint8_t type) {
+    switch (type) {
+        case ASSET_FONT:  return "font";
+        case ASSET_IMAGE: return "image";
+        case ASSET_BLOB:  return "blob";
+        default:          return "?";
+    }
+}
+
+static void rpc_assets(Print &out, const char *args) {
+    if (!asset_header) {
+        out.println("no asset pack");
+        return;
+    }
+    out.printf("%s: %lu bytes, build %lu, %u fonts, %u images, %u blobs, %u rejected\n", asset_stats.slot,
+               (unsigned long)asset_stats.size, (unsigned long)asset_stats.build, asset_stats.fonts,
+               asset_stats.images, asset_stats.blobs, asset_stats.rejected);
+    for (uint32_t i = 0; i < asset_header->count; i++) {
+        const AssetPackEntry *e = &asset_entries[i];
+        out.printf("%-24.*s %-6s %8lu\n", ASSET_NAME_MAX, e->name, type_name(e->type), (unsigned long)e->size);
+    }
+}
+
+// ===== API =====
+
+bool asset_store_begin() {
+    if (asset_header) {
+        return true;
+    }
+    usb_console_rpc("assets", rpc_assets);
+
+    // The slot an update last made bootable, else the other one
+    int first = 0;
+    Preferences prefs;
+    if (prefs.begin(ASSET_NVS_NAMESPACE, true)) {
+        first = prefs.getUChar("slot", 0) ? 1 : 0;
+        prefs.end();
+    }
+    if (!slot_map(slot_partition(first)) && !slot_map(slot_partition(!first))) {
+#ifdef ASSETS_PARTITION
+        LOG_ERROR("Assets", "No valid asset pack, UI fonts fall back to the default");
+        bind_app_assets();
+#else
+        LOG_INFO("Assets", "No asset pack");
+#endif
+        return true;
+    }
+
+    asset_stats.mapped = true;
+    strlcpy(asset_stats.slot, asset_part->label, sizeof(asset_stats.slot));
+    asset_stats.size = asset_header->size;
+    asset_stats.build = asset_header->build;
+    load_entries();
+#ifdef ASSETS_PARTITION
+    bind_app_assets();
+#endif
+    LOG_INFOF("Assets", "Pack %lu from %s: %lu bytes, %u fonts, %u images, %u blobs", (unsigned long)asset_header->build,
+              asset_part->label, (unsigned long)asset_header->size, asset_stats.fonts, asset_stats.images,
+              asset_stats.blobs);
+    return true;
+}
+
+const lv_font_t *asset_store_font(const char *name) {
+    for (uint16_t i = 0; i < asset_stats.fonts; i++) {
+        if (!strcmp(asset_fonts[i].name, name)) {
+            return &asset_fonts[i].font;
+        }
+    }
+    return NULL;
+}
+
+const lv_img_dsc_t *asset_store_image(const char *name) {
+    for (uint16_t i = 0; i < asset_stats.images; i++) {
+        if (!strcmp(asset_images[i].name, name)) {
+            return &asset_images[i].img;
+        }
+    }
+    return NULL;
+}
+
+const uint8_t *asset_store_blob(const char *name, uint32_t *size) {
+    if (!asset_header) {
+        return NULL;
+    }
+    for (uint32_t i = 0; i < asset_header->count; i++) {
+        const AssetPackEntry *e = &asset_entries[i];
+        if (e->type == ASSET_BLOB && !strncmp(e->name, name, ASSET_NAME_MAX) && in_pack(e->offset, e->size)) {
+            *size = e->size;
+            return asset_base + e->offset;
+        }
+    }
+    return NULL;
+}
+
+const esp_partition_t *asset_store_partition() {
+    return asset_part;
+}
+
+const esp_partition_t *asset_store_spare() {
+    return slot_partition(asset_part ? !slot_index(asset_part) : 0);
+}
+
+bool asset_store_set_boot(const esp_partition_t *part) {
+    // Mapped on its own for the check; the running pack stays where it is
+    const void *p;
+    spi_flash_mmap_handle_t handle;
+    if (!part || part == asset_part ||
+        esp_partition_mmap(part, 0, part->size, SPI_FLASH_MMAP_DATA, &p, &handle) != ESP_OK) {
+        return false;
+    }
+    bool ok = pack_valid((const uint8_t *)p, part->size);
+    spi_flash_munmap(handle);
+    if (!ok) {
+        LOG_ERRORF("Assets", "No valid pack in %s", part->label);
+        return false;
+    }
+
+    Preferences prefs;
+    if (!prefs.begin(ASSET_NVS_NAMESPACE, false)) {
+        return false;
+    }
+    prefs.putUChar("slot", slot_index(part));
+    prefs.end();
+    return true;
+}
+
+void asset_store_get_stats(AssetStoreStats *out) {
+    *out = asset_stats;
+}
@@ -0,0 +1,159 @@
+/**
+ * @file      asset_store.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Read-only asset pack in a memory-mapped flash partition: fonts, images, blobs
+ */
+
+#ifndef ASSET_STORE_H
+#define ASSET_STORE_H
+
+#include <Arduino.h>
+#include <lvgl.h>
+#include <esp_partition.h>
+
+/**
+ * Fonts, images and data files built into one pack by script/asset_pack.py
+ * and written to one of two flash slots (partitions assets0 and assets1,
+ * subtype ASSET_PARTITION_SUBTYPE). At boot the slot recorded in NVS, or
+ * failing that the other one, is mapped into the data address space and
+ * its CRC checked; nothing is copied. Each font gets a small LVGL
+ * descriptor in RAM whose glyph descriptors and bitmaps point straight
+ * into the mapping, each image an lv_img_dsc_t whose data does the same.
+ *
+ * Built with ASSETS_PARTITION (env T-Deck-Pro-Assets) the app carries no
+ * Mono fonts or 1bpp images of its own: the symbols in src/src/assets.h
+ * become RAM descriptors filled in from the pack before LVGL starts, and
+ * a font the pack lacks falls back to LV_FONT_DEFAULT. Without it the
+ * built-in copies stay and the pack only adds what the app does not carry,
+ * such as the CJK font (blob FONT_PAGER_ASSET, see font_pager.h).
+ *
+ * Updates go through ota_patch with OTA_PATCH_FLAG_ASSETS: the mapped
+ * slot is the diff source, the other one the target, and a verified pack
+ * there is used from the next reset. A slot that fails its check is never
+ * mapped, so a cut-off update leaves the old pack in use.
+ *
+ * Pack layout, little endian, every record 4-byte aligned: AssetPackHeader,
+ * count AssetPackEntry, then the records. All offsets are from the start
+ * of the pack.
+ */
+
+#define ASSET_PACK_MAGIC            0x50414454  // "TDAP"
+#define ASSET_PACK_VERSION          1
+#define ASSET_PARTITION_SUBTYPE     0x42        // Next to the font pager's 0x41
+#define ASSET_PARTITION_LABEL_0     "assets0"
+#define ASSET_PARTITION_LABEL_1     "assets1"
+#define ASSET_NVS_NAMESPACE         "assets"
+#define ASSET_NAME_MAX              24          // NUL included
+#define ASSET_FONTS_MAX             12          // RAM descriptors
+#define ASSET_IMAGES_MAX            24
+
+struct AssetPackHeader {
+    uint32_t magic;
+    uint8_t version;
+    uint8_t reserved[3];
+    uint32_t size;                  // Whole pack, header included
+    uint32_t crc32;                 // Of everything after the header
+    uint32_t count;                 // Entries
+    uint32_t build;                 // Packer's time stamp, for the log
+    uint8_t reserved2[8];
+};
+
+enum AssetType : uint8_t {
+    ASSET_FONT = 1,                 // AssetFontRecord
+    ASSET_IMAGE,                    // AssetImageRecord
+    ASSET_BLOB,                     // Raw bytes
+};
+
+struct AssetPackEntry {
+    char name[ASSET_NAME_MAX];      // NUL padded
+    uint8_t type;                   // AssetType
+    uint8_t reserved[3];
+    uint32_t offset;
+    uint32_t size;
+};
+
+// lv_font_fmt_txt font; no kerning
+struct AssetFontRecord {
+    uint8_t line_height;
+    uint8_t base_line;
+    int8_t underline_position;
+    int8_t underline_thickness;
+    uint8_t bpp;
+    uint8_t bitmap_format;
+    uint8_t cmap_num;
+    uint8_t subpx;
+    uint32_t glyph_count;
+    uint32_t glyph_dsc;             // lv_font_fmt_txt_glyph_dsc_t[glyph_count], LV_FONT_FMT_TXT_LARGE 0
+    uint32_t glyph_bitmap;
+    uint32_t bitmap_size;
+    uint32_t cmaps;                 // AssetFontCmap[cmap_num]
+};
+
+struct AssetFontCmap {
+    uint32_t range_start;
+    uint16_t range_length;
+    uint16_t glyph_id_start;
+    uint32_t unicode_list;          // uint16_t[list_length], 0 for none
+    uint32_t glyph_id_ofs_list;     // uint8_t or uint16_t[list_length] by type, 0 for none
+    uint16_t list_length;
+    uint8_t type;                   // LV_FONT_FMT_TXT_CMAP_*
+    uint8_t reserved;
+};
+
+// Images may share data, e.g. the icon cells of one atlas
+struct AssetImageRecord {
+    uint8_t cf;                     // lv_img_cf_t
+    uint8_t reserved;
+    uint16_t w;
+    uint16_t h;
+    uint16_t reserved2;
+    uint32_t data_size;
+    uint32_t data;
+};
+
+struct AssetStoreStats {
+    bool mapped;
+    char slot[8];                   // Partition label
+    uint32_t size;
+    uint32_t build;
+    uint16_t fonts;
+    uint16_t images;
+    uint16_t blobs;
+    uint16_t rejected;              // Entries whose records point outside the pack
+};
+
+/**
+ * @brief Map the newest valid pack and build the descriptors; before LVGL.
+ *        Also registers the "assets" console command
+ */
+bool asset_store_begin();
+
+/**
+ * @brief Font or image by pack name, NULL when the pack has none
+ */
+const lv_font_t *asset_store_font(const char *name);
+const lv_img_dsc_t *asset_store_image(const char *name);
+
+/**
+ * @brief Blob bytes in the mapping, NULL when the pack has none
+ */
+const uint8_t *asset_store_blob(const char *name, uint32_t *size);
+
+/**
+ * @brief Slot the running pack came from (NULL without one), and the slot
+ *        an update goes to
+ */
+const esp_partition_t *asset_store_partition();
+const esp_partition_t *asset_store_spare();
+
+/**
+ * @brief Check the pack in part and use it from the next reset
+ */
+bool asset_store_set_boot(const esp_partition_t *part);
+
+void asset_store_get_stats(AssetStoreStats *out);
+
+#endif // ASSET_STORE_H
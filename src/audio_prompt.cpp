@@ -0,0 +1,323 @@
+/**
+ * @file      audio_prompt.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Notification sounds from a PCM cache in PSRAM, mixed over playback
+ */
+
+#include "audio_prompt.h"
+#include "audio_service.h"
+#include "simple_logger.h"
+#include "factory.h"
+#include "spi_bus.h"
+#include <driver/i2s.h>
+#ifdef INTEGRATION_LAYER_ENABLED
+#include "integration/config_manager.h"
+#endif
+
+typedef struct {
+    int16_t *pcm;               // Mono at AUDIO_PROMPT_RATE, PSRAM
+    uint32_t frames;
+} prompt_t;
+
+#ifdef INTEGRATION_LAYER_ENABLED
+static const struct {
+    const char *path;
+    EventType event;
+} prompt_defaults[] = {
+    {"/prompt_message.wav", EventType::LORA_MESSAGE_RECEIVED},
+    {"/prompt_battery.wav", EventType::BATTERY_LOW},
+};
+#endif
+
+static prompt_t prompts[AUDIO_PROMPT_MAX];
+static uint8_t prompt_count = 0;
+static int32_t prompt_gain = AUDIO_PROMPT_GAIN;
+
+// The playing prompt; play() from any task, the audio task advances it
+static int8_t cur_id = -1;
+static uint32_t cur_pos = 0;
+static uint32_t cur_frac = 0;           // 16.16 phase over music at another rate
+static uint32_t cur_gen = 0;            // Bumped by play(), so a restart wins
+static uint32_t play_us = 0;
+static bool start_pending = false;
+static bool own_clock = false;          // Audio task only
+static audio_prompt_stats_t prompt_stats;
+static portMUX_TYPE prompt_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static inline int16_t clip16(int32_t v) {
+    return v > INT16_MAX ? INT16_MAX : v < INT16_MIN ? INT16_MIN : v;
+}
+
+static uint32_t read_le(const uint8_t *p, int bytes) {
+    uint32_t v = 0;
+    for (int i = bytes - 1; i >= 0; i--) {
+        v = (v << 8) | p[i];
+    }
+    return v;
+}
+
+// RIFF header up to the start of the data chunk
+static bool parse_wav(File &f, uint16_t *channels, uint32_t *rate, uint32_t *data_len) {
+    uint8_t hdr[16];
+    if (f.read(hdr, 12) != 12 || memcmp(hdr, "RIFF", 4) || memcmp(hdr + 8, "WAVE", 4)) {
+        return false;
+    }
+    uint16_t format = 0, bits = 0;
+    while (f.read(hdr, 8) == 8) {
+        uint32_t size = read_le(hdr + 4, 4);
+        if (!memcmp(hdr, "fmt ", 4) && size >= 16) {
+            if (f.read(hdr, 16) != 16) {
+                return false;
+            }
+            format = read_le(hdr, 2);
+            *channels = read_le(hdr + 2, 2);
+            *rate = read_le(hdr + 4, 4);
+            bits = read_le(hdr + 14, 2);
+            size -= 16;
+        } else if (!memcmp(hdr, "data", 4)) {
+            *data_len = size;
+            return format == 1 && bits == 16 && *channels >= 1 && *channels <= 2 &&
+                   *rate >= 8000 && *rate <= 48000;
+        }
+        f.seek(f.position() + size + (size & 1));
+    }
+    return false;
+}
+
+static int load_wav(fs::FS &fs, const char *path) {
+    File f = fs.open(path, "r");
+    if (!f) {
+        return -1;
+    }
+    uint16_t channels = 0;
+    uint32_t rate = 0, data_len = 0;
+    if (!parse_wav(f, &channels, &rate, &data_len)) {
+        LOG_WARNF("Prompt", "%s is not 16 bit PCM WAV", path);
+        return -1;
+    }
+
+    uint32_t src_frames = data_len / (2 * channels);
+    uint32_t max_frames = rate * AUDIO_PROMPT_MAX_MS / 1000;
+    if (src_frames > max_frames) {
+        src_frames = max_frames;
+    }
+    int16_t *src = (int16_t *)ps_malloc(src_frames * sizeof(int16_t));
+    if (!src || !src_frames) {
+        free(src);
+        return -1;
+    }
+
+    // Down to mono as it is read
+    int16_t block[AUDIO_PROMPT_BLOCK * 2];
+    uint32_t got = 0;
+    while (got < src_frames) {
+        uint32_t n = src_frames - got;
+        if (n > AUDIO_PROMPT_BLOCK) {
+            n = AUDIO_PROMPT_BLOCK;
+        }
+        if (f.read((uint8_t *)block, n * 2 * channels) != n * 2 * channels) {
+            break;
+        }
+        for (uint32_t i = 0; i < n; i++) {
+            src[got + i] = channels == 2 ? (block[2 * i] + block[2 * i + 1]) / 2 : block[i];
+        }
+        got += n;
+    }
+    src_frames = got;
+
+    // Then to the cache rate, linearly interpolated
+    int16_t *pcm = src;
+    uint32_t frames = src_frames;
+    if (rate != AUDIO_PROMPT_RATE && src_frames > 1) {
+        frames = (uint64_t)(src_frames - 1) * AUDIO_PROMPT_RATE / rate;
+        pcm = (int16_t *)ps_malloc(frames * sizeof(int16_t));
+        if (!pcm) {
+            free(src);
+            return -1;
+        }
+        uint32_t step = ((uint64_t)rate << 16) / AUDIO_PROMPT_RATE;
+        uint64_t phase = 0;
+        for (uint32_t i = 0; i < frames; i++, phase += step) {
+            uint32_t k = phase >> 16;
+            int32_t frac = phase & 0xFFFF;
+            pcm[i] = src[k] + (((src[k + 1] - src[k]) * frac) >> 16);
+        }
+        free(src);
+    }
+
+    int id = prompt_count++;
+    prompts[id].pcm = pcm;
+    prompts[id].frames = frames;
+    prompt_stats.loaded = prompt_count;
+    prompt_stats.cache_bytes += frames * sizeof(int16_t);
+    LOG_INFOF("Prompt", "%d: %s, %lu ms", id, path, (unsigned long)(frames * 1000 / AUDIO_PROMPT_RATE));
+    return id;
+}
+
+int audio_prompt_load(fs::FS &fs, const char *path) {
+    if (prompt_count >= AUDIO_PROMPT_MAX) {
+        return -1;
+    }
+    bool on_sd = &fs == &SD;
+    if (on_sd) {
+        spi_bus_acquire(SPI_CLIENT_SD);
+    }
+    int id = load_wav(fs, path);
+    if (on_sd) {
+        spi_bus_release(SPI_CLIENT_SD);
+    }
+    return id;
+}
+
+#ifdef INTEGRATION_LAYER_ENABLED
+static void on_prompt_event(const Event &event, void *context) {
+    audio_prompt_play((int)(intptr_t)context);
+}
+
+bool audio_prompt_bind(EventType type, int id) {
+    if (!GlobalEventBridge || id < 0 || id >= prompt_count) {
+        return false;
+    }
+    return GlobalEventBridge->subscribe("Prompt", type, on_prompt_event, (void *)(intptr_t)id);
+}
+#endif
+
+bool audio_prompt_begin() {
+#ifdef INTEGRATION_LAYER_ENABLED
+    prompt_gain = constrain(GET_CONFIG_INT("audio", "prompt_gain", AUDIO_PROMPT_GAIN), 0, 256);
+    for (size_t i = 0; i < sizeof(prompt_defaults) / sizeof(prompt_defaults[0]); i++) {
+        if (!SPIFFS.exists(prompt_defaults[i].path)) {
+            continue;
+        }
+        audio_prompt_bind(prompt_defaults[i].event, audio_prompt_load(SPIFFS, prompt_defaults[i].path));
+    }
+#endif
+    LOG_INFOF("Prompt", "%u prompts cached, %lu bytes", prompt_count, (unsigned long)prompt_stats.cache_bytes);
+    return prompt_count > 0;
+}
+
+bool audio_prompt_play(int id) {
+    if (id < 0 || id >= prompt_count) {
+        return false;
+    }
+    portENTER_CRITICAL(&prompt_mux);
+    cur_id = id;
+    cur_pos = 0;
+    cur_frac = 0;
+    cur_gen++;
+    play_us = micros();
+    start_pending = true;
+    prompt_stats.plays++;
+    portEXIT_CRITICAL(&prompt_mux);
+    audio_service_wake();
+    return true;
+}
+
+void audio_prompt_stop() {
+    portENTER_CRITICAL(&prompt_mux);
+    cur_id = -1;
+    cur_gen++;
+    portEXIT_CRITICAL(&prompt_mux);
+}
+
+bool audio_prompt_active() {
+    return cur_id >= 0;
+}
+
+// Commit what the audio task used, unless play() or stop() came in between
+static void advance(uint32_t gen, uint32_t pos, uint32_t frac, bool mixed) {
+    uint32_t now = micros();
+    portENTER_CRITICAL(&prompt_mux);
+    if (gen == cur_gen && cur_id >= 0) {
+        cur_pos = pos;
+        cur_frac = frac;
+        if (pos >= prompts[cur_id].frames) {
+            cur_id = -1;
+        }
+        if (start_pending) {
+            start_pending = false;
+            prompt_stats.start_last_us = now - play_us;
+            if (prompt_stats.start_last_us > prompt_stats.start_max_us) {
+                prompt_stats.start_max_us = prompt_stats.start_last_us;
+            }
+            if (mixed) {
+                prompt_stats.mixed++;
+            }
+        }
+    }
+    portEXIT_CRITICAL(&prompt_mux);
+}
+
+void audio_prompt_pump(uint8_t i2s_port) {
+    portENTER_CRITICAL(&prompt_mux);
+    int id = cur_id;
+    uint32_t pos = cur_pos;
+    uint32_t gen = cur_gen;
+    portEXIT_CRITICAL(&prompt_mux);
+    if (id < 0) {
+        return;
+    }
+
+    // The last file may have left the clock at its own rate
+    if (!own_clock) {
+        i2s_set_sample_rates((i2s_port_t)i2s_port, AUDIO_PROMPT_RATE);
+        own_clock = true;
+    }
+
+    const prompt_t *p = &prompts[id];
+    uint32_t n = p->frames - pos;
+    if (n > AUDIO_PROMPT_BLOCK) {
+        n = AUDIO_PROMPT_BLOCK;
+    }
+    int16_t block[AUDIO_PROMPT_BLOCK * 2];
+    for (uint32_t i = 0; i < n; i++) {
+        // Half scale like Audio::playSample(), which leaves 6 dB for its filters
+        int16_t s = (p->pcm[pos + i] * prompt_gain) >> 9;
+        block[2 * i] = s;
+        block[2 * i + 1] = s;
+    }
+    size_t written = 0;
+    i2s_write((i2s_port_t)i2s_port, block, n * 4, &written, portMAX_DELAY);
+    advance(gen, pos + written / 4, 0, false);
+}
+
+// Audio's hook for every decoded frame, in the audio task: add the prompt,
+// stepping through it at the file's rate
+void audio_process_extern(int16_t *buff, uint16_t len, bool *continueI2S) {
+    *continueI2S = true;
+    own_clock = false;
+
+    portENTER_CRITICAL(&prompt_mux);
+    int id = cur_id;
+    uint32_t pos = cur_pos;
+    uint32_t frac = cur_frac;
+    uint32_t gen = cur_gen;
+    portEXIT_CRITICAL(&prompt_mux);
+    if (id < 0 || audio.getBitsPerSample() != 16) {
+        return;
+    }
+
+    const prompt_t *p = &prompts[id];
+    uint8_t channels = audio.getChannels();
+    uint32_t rate = audio.getSampleRate();
+    uint32_t step = rate ? ((uint64_t)AUDIO_PROMPT_RATE << 16) / rate : 1 << 16;
+    for (uint16_t i = 0; i < len && pos < p->frames; i++) {
+        int32_t s = (p->pcm[pos] * prompt_gain) >> 8;
+        for (uint8_t c = 0; c < channels; c++) {
+            buff[i * channels + c] = clip16(buff[i * channels + c] + s);
+        }
+        frac += step;
+        pos += frac >> 16;
+        frac &= 0xFFFF;
+    }
+    advance(gen, pos, frac, true);
+}
+
+void audio_prompt_get_stats(audio_prompt_stats_t *stats) {
+    portENTER_CRITICAL(&prompt_mux);
+    *stats = prompt_stats;
+    portEXIT_CRITICAL(&prompt_mux);
+}
@@ -0,0 +1,75 @@
+/**
+ * @file      audio_prompt.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Notification sounds from a PCM cache in PSRAM, mixed over playback
+ */
+
+#ifndef AUDIO_PROMPT_H
+#define AUDIO_PROMPT_H
+
+#include <Arduino.h>
+#include <FS.h>
+#ifdef INTEGRATION_LAYER_ENABLED
+#include "integration/event_bridge.h"
+#endif
+
+/**
+ * Prompts are 16 bit PCM WAV files, loaded once, mixed down to mono and
+ * resampled to AUDIO_PROMPT_RATE into PSRAM, so an alert costs no decode
+ * and no file access. While nothing plays the audio task writes the prompt
+ * straight to I2S a DMA descriptor at a time (256 frames, 5.8 ms); over
+ * music it is added to each decoded frame, after the audio already queued
+ * in the DMA. Prompts stay MP3-free: the Helix decoder keeps global state
+ * that the player is using.
+ */
+
+#define AUDIO_PROMPT_MAX            8
+#define AUDIO_PROMPT_RATE           44100
+#define AUDIO_PROMPT_MAX_MS         3000
+#define AUDIO_PROMPT_BLOCK          256     // Frames per write, AUDIO_DMA_BUF_LEN
+#define AUDIO_PROMPT_GAIN           192     // Out of 256
+
+typedef struct {
+    uint8_t loaded;
+    uint32_t cache_bytes;
+    uint32_t plays;
+    uint32_t mixed;             // Plays that overlaid music
+    uint32_t start_last_us;     // audio_prompt_play() to the first block queued
+    uint32_t start_max_us;
+} audio_prompt_stats_t;
+
+/**
+ * @brief Load the default prompts from SPIFFS and bind them to their
+ *        events. After audio_service_begin()
+ */
+bool audio_prompt_begin();
+
+/**
+ * @brief Cache a WAV file. UI task, at start-up
+ * @return prompt id, -1 on failure
+ */
+int audio_prompt_load(fs::FS &fs, const char *path);
+
+/**
+ * @brief Start a prompt, replacing one in progress. Any task
+ */
+bool audio_prompt_play(int id);
+void audio_prompt_stop();
+bool audio_prompt_active();
+
+#ifdef INTEGRATION_LAYER_ENABLED
+bool audio_prompt_bind(EventType type, int id);
+#endif
+
+/**
+ * @brief Audio task, under the service lock, while no file plays: queue the
+ *        next block of the prompt
+ */
+void audio_prompt_pump(uint8_t i2s_port);
+
+void audio_prompt_get_stats(audio_prompt_stats_t *stats);
+
+#endif // AUDIO_PROMPT_H
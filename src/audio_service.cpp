@@ -0,0 +1,276 @@
+/**
+ * @file      audio_service.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     PCM5102A playback on its own task, off the UI loop
+ */
+
+#include "audio_service.h"
+#include "audio_prompt.h"
+#include "simple_logger.h"
+#include "factory.h"
+#include "utilities.h"
+#include "power_governor.h"
+#include "spi_bus.h"
+#include "power_domain.h"
+#ifdef INTEGRATION_LAYER_ENABLED
+#include "integration/config_manager.h"
+#endif
+
+static TaskHandle_t audio_task_handle = NULL;
+static SemaphoreHandle_t audio_lock = NULL;     // Guards the Audio object
+static QueueHandle_t i2s_events = NULL;
+static volatile bool playing = false;
+static uint32_t play_start_ms = 0;
+static bool was_starved = false;
+static audio_stats_t audio_stats;
+static portMUX_TYPE audio_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// Decoding ahead of the I2S DMA needs the clock while the input buffer is under half full
+static uint32_t audio_work(void) {
+    return playing && audio.inBufferFilled() < audio.inBufferFree() ? 1 : 0;
+}
+
+// Audio's read-ahead pieces from SD
+static void sd_read_gate(bool acquire) {
+    if (acquire) {
+        spi_bus_acquire(SPI_CLIENT_SD);
+    } else {
+        spi_bus_release(SPI_CLIENT_SD);
+    }
+}
+
+// I2S_EVENT_TX_Q_OVF: a descriptor finished with every other one already
+// played out, so the DMA is sending the auto-cleared silence
+static void count_underruns(bool primed) {
+    i2s_event_t ev;
+    uint32_t dry = 0;
+    while (xQueueReceive(i2s_events, &ev, 0) == pdTRUE) {
+        if (ev.type == I2S_EVENT_TX_Q_OVF) {
+            dry++;
+        }
+    }
+    if (dry && primed) {
+        portENTER_CRITICAL(&audio_mux);
+        audio_stats.underruns++;
+        portEXIT_CRITICAL(&audio_mux);
+    }
+}
+
+// Under audio_lock
+static void read_decode_stats(audio_stats_t *stats) {
+    audio_decode_stats_t d;
+    audio.getDecodeStats(&d);
+    uint32_t rate = d.sampleRate;
+    stats->codec = d.codecName ? d.codecName : "none";
+    stats->decode_frames = d.frames;
+    stats->decode_cycles_avg = d.frames ? d.cycles / d.frames : 0;
+    stats->decode_cycles_max = d.maxCycles;
+    // cycles per second of audio, in 100 kHz
+    stats->decode_mhz_x10 = d.samples && rate ? d.cycles * rate / d.samples / 100000 : 0;
+}
+
+static void log_decode(const audio_stats_t *s) {
+    LOG_INFOF("Audio", "%s: %lu frames, %lu cycles/frame avg, %lu max, needs %lu.%lu MHz",
+              s->codec, (unsigned long)s->decode_frames, (unsigned long)s->decode_cycles_avg,
+              (unsigned long)s->decode_cycles_max, (unsigned long)(s->decode_mhz_x10 / 10),
+              (unsigned long)(s->decode_mhz_x10 % 10));
+}
+
+static void audio_task(void *param) {
+    while (1) {
+        if (!playing) {
+            if (!audio_prompt_active()) {
+                ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+                continue;
+            }
+            // Alone on I2S: blocks while the DMA is full, like a file
+            xSemaphoreTake(audio_lock, portMAX_DELAY);
+            audio_prompt_pump(audio.getI2sPort());
+            xSemaphoreGive(audio_lock);
+            if (i2s_events) {
+                count_underruns(false);
+            }
+            continue;
+        }
+
+        xSemaphoreTake(audio_lock, portMAX_DELAY);
+        uint32_t start = micros();
+        audio.loop();
+        uint32_t took = micros() - start;
+        bool running = audio.isRunning();
+        uint32_t filled = audio.inBufferFilled();
+        audio_stats_t bench;
+        if (!running) {
+            playing = false;        // End of file; a play() in between would have the lock
+            read_decode_stats(&bench);
+        }
+        xSemaphoreGive(audio_lock);
+
+        bool primed = running && millis() - play_start_ms >= AUDIO_PRIME_MS;
+        if (i2s_events) {
+            count_underruns(primed);
+        }
+
+        portENTER_CRITICAL(&audio_mux);
+        if (took > audio_stats.loop_max_us) {
+            audio_stats.loop_max_us = took;
+        }
+        if (primed) {
+            if (filled < audio_stats.in_buffer_min) {
+                audio_stats.in_buffer_min = filled;
+            }
+            if (!filled && !was_starved) {
+                audio_stats.starved++;
+            }
+            was_starved = !filled;
+        }
+        portEXIT_CRITICAL(&audio_mux);
+
+        if (!running) {
+            LOG_INFO("Audio", "Playback finished");
+            log_decode(&bench);
+        }
+        // i2s_write() blocks while the DMA is full; this only lets the
+        // lower priorities on this core in when decoding runs ahead
+        vTaskDelay(1);
+    }
+}
+
+bool audio_service_begin() {
+    if (audio_task_handle) {
+        return true;
+    }
+
+    int volume = AUDIO_DEFAULT_VOLUME;
+#ifdef INTEGRATION_LAYER_ENABLED
+    volume = GET_CONFIG_INT("audio", "volume", AUDIO_DEFAULT_VOLUME);
+#endif
+
+    audio.setBufsize(AUDIO_RAM_BUF_SIZE, AUDIO_PSRAM_BUF_SIZE);
+    if (!audio.setI2SDmaBuffers(AUDIO_DMA_BUF_COUNT, AUDIO_DMA_BUF_LEN, &i2s_events)) {
+        LOG_WARN("Audio", "Keeping the default I2S DMA buffers, underruns not counted");
+        i2s_events = NULL;
+    }
+    if (!audio.setPinout(BOARD_I2S_BCLK, BOARD_I2S_LRC, BOARD_I2S_DOUT)) {
+        LOG_ERROR("Audio", "I2S pinout failed");
+        return false;
+    }
+    audio.setVolume(constrain(volume, 0, 21));
+
+    // Shared with the modem, which no longer takes the DAC down when it is switched off
+    power_domain_acquire(power_domain_user(PWR_DOMAIN_6609, "pcm5102"));
+    power_domain_wait(PWR_DOMAIN_6609);
+
+    audio_lock = xSemaphoreCreateMutex();
+    if (!audio_lock) {
+        return false;
+    }
+    if (xTaskCreatePinnedToCore(audio_task, "audio", AUDIO_TASK_STACK, NULL, AUDIO_TASK_PRIORITY,
+                                &audio_task_handle, AUDIO_TASK_CORE) != pdPASS) {
+        LOG_ERROR("Audio", "Task create failed");
+        return false;
+    }
+    power_governor_add_source("audio", audio_work);
+
+    LOG_INFOF("Audio", "Task on core %d, DMA %d x %d frames, input buffer %d bytes",
+              AUDIO_TASK_CORE, AUDIO_DMA_BUF_COUNT, AUDIO_DMA_BUF_LEN, AUDIO_PSRAM_BUF_SIZE);
+    return true;
+}
+
+bool audio_service_play(fs::FS &fs, const char *path) {
+    if (!audio_task_handle) {
+        return false;
+    }
+
+    bool on_sd = &fs == &SD;
+    xSemaphoreTake(audio_lock, portMAX_DELAY);
+    audio.resetDecodeStats();
+    audio.setReadAhead(on_sd ? AUDIO_READ_AHEAD : 0, on_sd ? sd_read_gate : NULL);
+    if (on_sd) {
+        spi_bus_acquire(SPI_CLIENT_SD);    // Open and header reads
+    }
+    bool ok = audio.connecttoFS(fs, path);
+    if (on_sd) {
+        spi_bus_release(SPI_CLIENT_SD);
+    }
+    if (ok) {
+        play_start_ms = millis();
+        portENTER_CRITICAL(&audio_mux);
+        audio_stats.songs++;
+        audio_stats.in_buffer_size = audio.inBufferFilled() + audio.inBufferFree();
+        audio_stats.in_buffer_min = audio_stats.in_buffer_size;
+        was_starved = false;
+        portEXIT_CRITICAL(&audio_mux);
+    }
+    playing = ok;
+    xSemaphoreGive(audio_lock);
+
+    if (!ok) {
+        LOG_WARNF("Audio", "Cannot play %s", path);
+        return false;
+    }
+    xTaskNotifyGive(audio_task_handle);
+    return true;
+}
+
+void audio_service_stop() {
+    if (!audio_task_handle) {
+        return;
+    }
+    xSemaphoreTake(audio_lock, portMAX_DELAY);
+    audio.stopSong();
+    playing = false;
+    xSemaphoreGive(audio_lock);
+}
+
+void audio_service_wake() {
+    if (audio_task_handle) {
+        xTaskNotifyGive(audio_task_handle);
+    }
+}
+
+bool audio_service_playing() {
+    return playing;
+}
+
+void audio_service_set_volume(uint8_t volume) {
+    if (!audio_task_handle) {
+        return;
+    }
+    xSemaphoreTake(audio_lock, portMAX_DELAY);
+    audio.setVolume(volume > 21 ? 21 : volume);
+    xSemaphoreGive(audio_lock);
+}
+
+void audio_service_get_stats(audio_stats_t *stats) {
+    portENTER_CRITICAL(&audio_mux);
+    *stats = audio_stats;
+    portEXIT_CRITICAL(&audio_mux);
+    if (audio_lock) {
+        xSemaphoreTake(audio_lock, portMAX_DELAY);
+        read_decode_stats(stats);
+        xSemaphoreGive(audio_lock);
+    }
+}
+
+void audio_service_print_stats() {
+    audio_stats_t s;
+    audio_service_get_stats(&s);
+    LOG_INFOF("Audio", "%lu songs, %lu underruns, %lu starved, input low %lu/%lu, loop max %lu us",
+              (unsigned long)s.songs, (unsigned long)s.underruns, (unsigned long)s.starved,
+              (unsigned long)s.in_buffer_min, (unsigned long)s.in_buffer_size,
+              (unsigned long)s.loop_max_us);
+    if (s.decode_frames) {
+        log_decode(&s);
+    }
+    audio_prompt_stats_t p;
+    audio_prompt_get_stats(&p);
+    if (p.loaded) {
+        LOG_INFOF("Audio", "%u prompts (%lu bytes), %lu played, %lu over music, start %lu us (max %lu)",
+                  p.loaded, (unsigned long)p.cache_bytes, (unsigned long)p.plays, (unsigned long)p.mixed,
+                  (unsigned long)p.start_last_us, (unsigned long)p.start_max_us);
+    }
+}
@@ -0,0 +1,89 @@
+/**
+ * @file      audio_service.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     PCM5102A playback on its own task, off the UI loop
+ */
+
+#ifndef AUDIO_SERVICE_H
+#define AUDIO_SERVICE_H
+
+#include <Arduino.h>
+#include <FS.h>
+
+/**
+ * The decoder used to run from loop() between lv_task_handler() calls, so a
+ * long render or a panel refresh starved the I2S DMA and the speaker
+ * clicked. Here it runs on a task pinned to core 0, away from LVGL and the
+ * Arduino loop on core 1, above everything on that core but the radios. The
+ * task blocks in i2s_write() while the DMA is full and sleeps when nothing
+ * plays. The input buffer sits in PSRAM, large enough to ride out a slow
+ * file system, and the DMA holds AUDIO_DMA_BUF_COUNT * AUDIO_DMA_BUF_LEN
+ * frames, about 280 ms at 44.1 kHz.
+ *
+ * Files on SD are read ahead AUDIO_READ_AHEAD bytes at a time, ending on
+ * a sector so FatFs reads straight into the buffer, in AUDIO_READ_PIECE
+ * pieces under spi_bus as its SD client, so LoRa and the panel get the bus
+ * between pieces. The buffer holds seconds of audio, so a chunk waiting on
+ * the bus does not reach the DMA.
+ *
+ * The global `audio` object is only touched under the service lock, so use
+ * these calls instead of its own while the service runs
+ */
+
+#define AUDIO_TASK_PRIORITY         (configMAX_PRIORITIES - 3)  // Below GPS and LoRa, above the flush task
+#define AUDIO_TASK_CORE             0
+#define AUDIO_TASK_STACK            (1024 * 6)
+#define AUDIO_DMA_BUF_COUNT         48
+#define AUDIO_DMA_BUF_LEN           256     // Frames per descriptor: 5.8 ms, a prompt's start latency
+#define AUDIO_RAM_BUF_SIZE          (1600 * 5)
+#define AUDIO_PSRAM_BUF_SIZE        (1024 * 384)
+#define AUDIO_DEFAULT_VOLUME        21      // 0...21
+#define AUDIO_PRIME_MS              500     // After a start the DMA is still filling
+#define AUDIO_READ_AHEAD            (32 * 1024)     // SD files
+
+typedef struct {
+    uint32_t songs;
+    uint32_t underruns;         // DMA ran dry while playing: the DAC got silence
+    uint32_t starved;           // Input buffer ran empty while playing
+    uint32_t in_buffer_size;
+    uint32_t in_buffer_min;     // Lowest fill while playing, since the last song started
+    uint32_t loop_max_us;       // Longest decode pass, DMA waits included
+    // Decode benchmark of the current or last file: cycles per frame and
+    // the clock it needs to keep up in real time
+    const char *codec;
+    uint32_t decode_frames;
+    uint32_t decode_cycles_avg;
+    uint32_t decode_cycles_max;
+    uint32_t decode_mhz_x10;
+} audio_stats_t;
+
+/**
+ * @brief Size the buffers, set up I2S and the amplifier enable, start the
+ *        task. Reads audio.volume. Call once, before anything plays
+ */
+bool audio_service_begin();
+
+/**
+ * @brief Start a file, stopping whatever plays. Any task
+ */
+bool audio_service_play(fs::FS &fs, const char *path);
+void audio_service_stop();
+bool audio_service_playing();
+void audio_service_set_volume(uint8_t volume);
+
+/**
+ * @brief Have the task look for work, e.g. a prompt to play. Any task
+ */
+void audio_service_wake();
+
+/**
+ * @brief Play one file per codec and read the decode figures here or from
+ *        the log line at its end to benchmark the decoders
+ */
+void audio_service_get_stats(audio_stats_t *stats);
+void audio_service_print_stats();
+
+#endif // AUDIO_SERVICE_H
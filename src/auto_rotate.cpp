@@ -0,0 +1,127 @@
+/**
+ * @file      auto_rotate.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Display rotation that follows the device, from the BHI260AP game rotation vector
+ */
+
+#include "auto_rotate.h"
+#include "simple_logger.h"
+#include "peripheral.h"
+#include "lvgl_integration.h"
+#include <math.h>
+#ifdef INTEGRATION_LAYER_ENABLED
+#include "integration/config_manager.h"
+#endif
+
+#define AUTO_ROTATE_NONE    0xFF
+
+// Quadrants name the edge facing up: 0 top, 1 right, 2 bottom, 3 left.
+// Written on the hub task, pending read once by the UI task
+static volatile bool enabled = false;
+static bool paused = false;
+static volatile uint8_t pending = AUTO_ROTATE_NONE;
+static uint8_t quadrant = AUTO_ROTATE_MOUNT & 3;    // Whatever leaves the panel unrotated
+static uint8_t candidate = AUTO_ROTATE_MOUNT & 3;
+static uint32_t candidate_since = 0;
+
+// The content's top goes to the raised edge: ROT_90 puts it on the panel's
+// left edge (see lv_indev.c), so a raised right edge wants ROT_270
+static uint8_t rotation_for(uint8_t q) {
+    return (4 - q + AUTO_ROTATE_MOUNT) & 3;
+}
+
+static void on_rotation(float w, float x, float y, float z) {
+    if (!enabled) {
+        return;
+    }
+
+    // World up in device axes, the third row of the rotation matrix; the
+    // game vector has no heading, which tilt does not need
+    float gx = 2.0f * (x * z - w * y);
+    float gy = 2.0f * (y * z + w * x);
+    uint8_t q = quadrant;
+
+    // Lying flat says nothing about which way the user holds it
+    if (gx * gx + gy * gy >= AUTO_ROTATE_MIN_TILT * AUTO_ROTATE_MIN_TILT) {
+        float angle = atan2f(gx, gy) * 180.0f / (float)M_PI;
+        float from_current = fabsf(remainderf(angle - quadrant * 90.0f, 360.0f));
+        if (from_current > 45.0f + AUTO_ROTATE_HYSTERESIS_DEG) {
+            q = (uint8_t)(((int)lroundf(angle / 90.0f) + 4) & 3);
+        }
+    }
+
+    uint32_t now = millis();
+    if (q != candidate) {
+        candidate = q;
+        candidate_since = now;
+        return;
+    }
+    if (q != quadrant && now - candidate_since >= AUTO_ROTATE_DEBOUNCE_MS) {
+        quadrant = q;
+        pending = rotation_for(q);
+        if (LVGL) {
+            LVGL->wake();
+        }
+    }
+}
+
+void auto_rotate_enable(bool enable) {
+    if (enable == enabled) {
+        return;
+    }
+    if (enable) {
+        candidate = quadrant;
+        enabled = BHI260AP_set_rotation_cb(on_rotation, AUTO_ROTATE_RATE_HZ, AUTO_ROTATE_LATENCY_MS);
+        if (!enabled) {
+            return;
+        }
+    } else {
+        enabled = false;
+        paused = false;
+        BHI260AP_set_rotation_cb(NULL, 0, 0);
+        quadrant = AUTO_ROTATE_MOUNT & 3;
+        pending = 0;    // LV_DISP_ROT_NONE
+    }
+    LOG_INFOF("Rotate", "Auto rotation %s", enable ? "on" : "off");
+}
+
+void auto_rotate_pause(bool pause) {
+    if (!enabled || pause == paused) {
+        return;
+    }
+    paused = pause;
+    candidate = quadrant;
+    if (pause) {
+        BHI260AP_set_rotation_cb(NULL, 0, 0);
+    } else {
+        BHI260AP_set_rotation_cb(on_rotation, AUTO_ROTATE_RATE_HZ, AUTO_ROTATE_LATENCY_MS);
+    }
+}
+
+bool auto_rotate_begin() {
+#ifdef INTEGRATION_LAYER_ENABLED
+    if (!GET_CONFIG_BOOL("display", "auto_rotate", true)) {
+        LOG_INFO("Rotate", "Auto rotation disabled in config");
+        return false;
+    }
+#endif
+    if (!peri_init_ensure(E_PERI_BHI260AP) && !BHI260AP_init()) {
+        LOG_WARN("Rotate", "No BHI260AP, display stays in portrait");
+        return false;
+    }
+    auto_rotate_enable(true);
+    return enabled;
+}
+
+bool auto_rotate_take(uint8_t *rotation) {
+    uint8_t r = pending;
+    if (r == AUTO_ROTATE_NONE) {
+        return false;
+    }
+    pending = AUTO_ROTATE_NONE;
+    *rotation = r;
+    return true;
+}
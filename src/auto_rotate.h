@@ -0,0 +1,46 @@
+/**
+ * @file      auto_rotate.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Display rotation that follows the device, from the BHI260AP game rotation vector
+ */
+
+#ifndef AUTO_ROTATE_H
+#define AUTO_ROTATE_H
+
+#include <Arduino.h>
+
+#define AUTO_ROTATE_RATE_HZ         5       // Fusion output rate; the hub rounds to its own steps
+#define AUTO_ROTATE_LATENCY_MS      400     // Batched with the other hub samples up to this long
+#define AUTO_ROTATE_DEBOUNCE_MS     800     // A new orientation must hold this long
+#define AUTO_ROTATE_HYSTERESIS_DEG  15      // Past the 45 degree boundary before it counts
+#define AUTO_ROTATE_MIN_TILT        0.5f    // Gravity in the screen plane, in g; flatter keeps the rotation
+#define AUTO_ROTATE_MOUNT           0       // Quarter turns between the sensor axes and the panel
+
+/**
+ * @brief Bring up the sensor hub if needed and start the game rotation
+ *        vector, unless display.auto_rotate is off. UI task
+ */
+bool auto_rotate_begin();
+
+/**
+ * @brief Start or stop following the device; stopping goes back to portrait
+ *        on the next auto_rotate_take()
+ */
+void auto_rotate_enable(bool enable);
+
+/**
+ * @brief Stop the rotation vector but keep the current rotation, for a
+ *        device lying still; resuming picks up from where it was
+ */
+void auto_rotate_pause(bool pause);
+
+/**
+ * @brief A debounced orientation change for the display, once, as an
+ *        lv_disp_rot_t value. The UI loop applies it with LVGLIntegration::setRotation()
+ */
+bool auto_rotate_take(uint8_t *rotation);
+
+#endif // AUTO_ROTATE_H
@@ -0,0 +1,386 @@
+/**
+ * @file      batt_forecast.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Battery runtime forecast: incremental per-mode averages over the energy profiler
+ */
+
+#include "batt_forecast.h"
+#include <esp_heap_caps.h>
+#include <math.h>
+#include "simple_logger.h"
+#include "simple_power.h"
+#include "peripheral.h"
+#include "sensor_sampler.h"
+#include "factory.h"
+#include "tsdb.h"
+#include "time_service.h"
+#include "timer_wheel.h"
+#include "usb_console.h"
+#ifdef INTEGRATION_LAYER_ENABLED
+#include "integration/config_manager.h"
+#endif
+
+// Model, timer task only
+static float mode_ma[BATT_FORECAST_MODES];
+static float mode_sub[BATT_FORECAST_MODES];
+static uint32_t mode_learned_s[BATT_FORECAST_MODES];
+static float share[BATT_FORECAST_MODES];
+static float sub_ma[ENERGY_SUBSYSTEMS];
+static uint32_t pattern_age_s = 0;        // Seeded and live time behind share and sub_ma
+static EnergyStats last;
+static bool have_last = false;
+static uint32_t last_ms = 0;
+static WheelTimer fc_timer;
+static bool fc_running = false;
+static bool seeded = false;
+static volatile bool reset_pending = false;    // From the console, applied by the next tick
+
+// Published at each tick, and the policy's state
+static portMUX_TYPE fc_mux = portMUX_INITIALIZER_UNLOCKED;
+static BattForecastStats fc;
+static int8_t user_mode = -1;
+static int8_t policy_mode = -1;            // Imposed by the target
+static uint32_t policy_switches = 0;
+
+static int current_mode() {
+    return Power ? (int)Power->getPowerMode() : (int)POWER_BALANCED;
+}
+
+// Weight of a new sample dt_s long in an average over tau_s; plain mean while younger than tau_s
+static float weight(uint32_t dt_s, uint32_t age_s, uint32_t tau_s) {
+    float w = 1.0f - expf(-(float)dt_s / tau_s);
+    float mean = (float)dt_s / (age_s + dt_s);
+    return mean > w ? mean : w;
+}
+
+static void learn_mode(int m, float own_ma, float subsystems_ma, uint32_t dt_s) {
+    float w = weight(dt_s, mode_learned_s[m], BATT_FORECAST_MODE_TAU_S);
+    mode_ma[m] += w * (own_ma - mode_ma[m]);
+    mode_sub[m] += w * (subsystems_ma - mode_sub[m]);
+    mode_learned_s[m] += dt_s;
+}
+
+static void learn_share(int m, uint32_t dt_s) {
+    float w = weight(dt_s, pattern_age_s, BATT_FORECAST_PATTERN_S);
+    for (int i = 0; i < BATT_FORECAST_MODES; i++) {
+        share[i] += w * ((i == m ? 1.0f : 0.0f) - share[i]);
+    }
+}
+
+// A mode's own draw, or the nearest less saving one's, then the nearest more saving one's
+static bool mode_draw(int m, float *ma) {
+    for (int i = m; i >= 0; i--) {
+        if (mode_learned_s[i] >= BATT_FORECAST_LEARNED_S) {
+            *ma = mode_ma[i];
+            return true;
+        }
+    }
+    for (int i = m + 1; i < BATT_FORECAST_MODES; i++) {
+        if (mode_learned_s[i] >= BATT_FORECAST_LEARNED_S) {
+            *ma = mode_ma[i];
+            return true;
+        }
+    }
+    return false;
+}
+
+static int32_t runtime_of(uint16_t remaining_mah, float ma) {
+    return ma > 0.5f ? (int32_t)(remaining_mah * 60.0f / ma) : -1;
+}
+
+static bool read_remaining(uint16_t *mah) {
+    SensorGauge g;
+    if (!sensor_get_gauge(&g)) {
+        return false;
+    }
+    *mah = g.remain_mah;
+    return true;
+}
+
+// Projections from the model as it stands, into the published copy
+static void publish(uint16_t remaining_mah, bool charging) {
+    float subsystems = 0;
+    for (int i = 0; i < ENERGY_SUBSYSTEMS; i++) {
+        subsystems += sub_ma[i];
+    }
+
+    BattForecastMode modes[BATT_FORECAST_MODES];
+    float pattern = 0, known_share = 0;
+    for (int m = 0; m < BATT_FORECAST_MODES; m++) {
+        float draw;
+        bool known = mode_draw(m, &draw);
+        modes[m].ma = mode_learned_s[m] ? mode_ma[m] : 0;
+        modes[m].sub_ma = mode_sub[m];
+        modes[m].learned_s = mode_learned_s[m];
+        modes[m].share_pct = (uint8_t)lroundf(share[m] * 100);
+        modes[m].runtime_min = known && !charging ? runtime_of(remaining_mah, draw + subsystems) : -1;
+        if (known) {
+            pattern += share[m] * draw;
+            known_share += share[m];
+        }
+    }
+    pattern = known_share > 0 ? pattern / known_share + subsystems : 0;
+
+    portENTER_CRITICAL(&fc_mux);
+    memcpy(fc.mode, modes, sizeof(modes));
+    memcpy(fc.sub_ma, sub_ma, sizeof(sub_ma));
+    fc.pattern_ma = pattern;
+    fc.remaining_mah = remaining_mah;
+    fc.runtime_min = charging ? -1 : runtime_of(remaining_mah, pattern);
+    fc.charging = charging;
+    portEXIT_CRITICAL(&fc_mux);
+}
+
+static void model_reset() {
+    memset(mode_ma, 0, sizeof(mode_ma));
+    memset(mode_sub, 0, sizeof(mode_sub));
+    memset(mode_learned_s, 0, sizeof(mode_learned_s));
+    memset(share, 0, sizeof(share));
+    memset(sub_ma, 0, sizeof(sub_ma));
+    pattern_age_s = 0;
+    have_last = false;
+    portENTER_CRITICAL(&fc_mux);
+    memset(fc.mode, 0, sizeof(fc.mode));
+    for (int m = 0; m < BATT_FORECAST_MODES; m++) {
+        fc.mode[m].runtime_min = -1;
+    }
+    fc.pattern_ma = 0;
+    fc.runtime_min = -1;
+    fc.ticks = 0;
+    fc.seeded_buckets = 0;
+    portEXIT_CRITICAL(&fc_mux);
+}
+
+// Whole-device current per bucket spent in one mode, oldest first
+static void seed() {
+    const size_t n = BATT_FORECAST_SEED_S / BATT_FORECAST_SEED_STEP_S;
+    const uint32_t step = BATT_FORECAST_SEED_STEP_S;
+    if (!time_valid()) {
+        return;
+    }
+    seeded = true;
+    TsdbBucket *ma = (TsdbBucket *)heap_caps_malloc(2 * n * sizeof(TsdbBucket), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!ma) {
+        return;
+    }
+    TsdbBucket *md = ma + n;
+    uint32_t from = time_now_s() / step * step - step * (n - 1);
+    size_t got = tsdb_rollup(TSDB_BATTERY_MA, from, step, ma, n);
+    if (got && tsdb_rollup(TSDB_POWER_MODE, from, step, md, n)) {
+        for (size_t i = 0; i < n; i++) {
+            if (!md[i].count) {
+                continue;
+            }
+            int m = (int)lroundf(md[i].avg);
+            if (m < 0 || m >= BATT_FORECAST_MODES) {
+                continue;
+            }
+            learn_share(m, step);
+            pattern_age_s += step;
+            if (ma[i].count && md[i].min == md[i].max && ma[i].max < 0) {
+                learn_mode(m, -ma[i].avg, 0, step);
+                fc.seeded_buckets++;
+            }
+        }
+    }
+    heap_caps_free(ma);
+}
+
+static void fc_tick(WheelTimer *timer) {
+    EnergyStats s;
+    uint32_t now = millis();
+    if (reset_pending) {
+        reset_pending = false;
+        model_reset();
+    }
+    if (!energy_profiler_stats(&s)) {
+        return;
+    }
+    // A profiler reset restarts its counters; start over from them
+    if (!have_last || s.since_ms != last.since_ms || s.discharged_mah < last.discharged_mah) {
+        last = s;
+        last_ms = now;
+        have_last = true;
+        return;
+    }
+    uint32_t dt_s = (now - last_ms) / 1000;
+    if (dt_s == 0) {
+        return;
+    }
+    // Only ahead of live data, which is newer than any history
+    if (!seeded && !fc.ticks) {
+        seed();
+    }
+    int m = current_mode();
+    if (time_valid()) {
+        tsdb_record(TSDB_POWER_MODE, m);
+    }
+
+    bool charging = s.charged_mah > last.charged_mah || s.current_ma >= 0;
+    if (!charging) {
+        double to_ma = 3600.0 / dt_s;
+        float w = weight(dt_s, pattern_age_s, BATT_FORECAST_PATTERN_S);
+        float subsystems = 0;
+        for (int i = 0; i < ENERGY_SUBSYSTEMS; i++) {
+            float ma = (s.bucket[i].mah - last.bucket[i].mah) * to_ma;
+            sub_ma[i] += w * (ma - sub_ma[i]);
+            subsystems += ma;
+        }
+        float total = (s.discharged_mah - last.discharged_mah) * to_ma;
+        learn_mode(m, total - subsystems, subsystems, dt_s);
+        learn_share(m, dt_s);
+        pattern_age_s += dt_s;
+    }
+    last = s;
+    last_ms = now;
+
+    uint16_t remaining = fc.remaining_mah;
+    read_remaining(&remaining);
+    fc.ticks++;
+    publish(remaining, charging);
+}
+
+int32_t batt_forecast_runtime_min() {
+    portENTER_CRITICAL(&fc_mux);
+    int32_t r = fc.runtime_min;
+    portEXIT_CRITICAL(&fc_mux);
+    return r;
+}
+
+int batt_forecast_policy_mode(int mode) {
+    int want;
+    bool switched = false;
+    uint32_t target;
+    portENTER_CRITICAL(&fc_mux);
+    target = fc.target_min;
+    // Any change the policy did not make is the user's new choice
+    if (mode != policy_mode) {
+        user_mode = mode;
+    }
+    want = user_mode;
+    if (fc.target_min && !fc.charging && fc.runtime_min >= 0) {
+        want = BATT_FORECAST_MODES - 1;
+        for (int m = user_mode; m < BATT_FORECAST_MODES; m++) {
+            uint32_t need = m < mode ? fc.target_min * (100 + BATT_FORECAST_HYST_PCT) / 100 : fc.target_min;
+            if (fc.mode[m].runtime_min >= (int32_t)need) {
+                want = m;
+                break;
+            }
+        }
+    } else if (fc.target_min && policy_mode >= 0 && !fc.charging) {
+        // No projection yet: hold what the policy chose
+        want = policy_mode;
+    }
+    int8_t chosen = want == user_mode ? -1 : want;
+    if (chosen != policy_mode) {
+        policy_mode = chosen;
+        switched = want != mode;
+        policy_switches += switched;
+    }
+    portEXIT_CRITICAL(&fc_mux);
+
+    if (switched) {
+        LOG_INFOF("Forecast", "Runtime target %lu min: power mode %d -> %d", (unsigned long)target, mode, want);
+    }
+    return want;
+}
+
+void batt_forecast_set_target(uint32_t minutes) {
+    portENTER_CRITICAL(&fc_mux);
+    fc.target_min = minutes;
+    portEXIT_CRITICAL(&fc_mux);
+}
+
+void batt_forecast_reset() {
+    if (fc_running) {
+        reset_pending = true;
+    } else {
+        model_reset();
+    }
+}
+
+void batt_forecast_get_stats(BattForecastStats *out) {
+    portENTER_CRITICAL(&fc_mux);
+    *out = fc;
+    out->policy_mode = policy_mode;
+    out->policy_switches = policy_switches;
+    portEXIT_CRITICAL(&fc_mux);
+}
+
+static void print_runtime(Print &out, int32_t min) {
+    if (min < 0) {
+        out.print("--");
+    } else {
+        out.printf("%ldh%02ldm", (long)(min / 60), (long)(min % 60));
+    }
+}
+
+static void rpc_forecast(Print &out, const char *args) {
+    if (!strcmp(args, "reset")) {
+        batt_forecast_reset();
+        out.println("ok");
+        return;
+    }
+    if (!strncmp(args, "target", 6)) {
+        batt_forecast_set_target((uint32_t)(atof(args + 6) * 60));
+        out.println("ok");
+        return;
+    }
+    if (args[0]) {
+        out.println("usage: forecast [target <h> | reset]");
+        return;
+    }
+    BattForecastStats s;
+    batt_forecast_get_stats(&s);
+    out.printf("remaining %u mAh, pattern %.1f mA, runtime ", s.remaining_mah, s.pattern_ma);
+    print_runtime(out, s.runtime_min);
+    out.printf("%s\n", s.charging ? " (charging)" : "");
+    for (int m = 0; m < BATT_FORECAST_MODES; m++) {
+        out.printf("mode %d: own %.1f mA, subsystems %.1f mA, %lu s learned, %u%% of use, runtime ", m,
+                   s.mode[m].ma, s.mode[m].sub_ma, (unsigned long)s.mode[m].learned_s, s.mode[m].share_pct);
+        print_runtime(out, s.mode[m].runtime_min);
+        out.println();
+    }
+    for (int i = 0; i < ENERGY_SUBSYSTEMS; i++) {
+        out.printf("%-8s %.1f mA\n", energy_subsystem_name(i), s.sub_ma[i]);
+    }
+    out.printf("target %lu min, policy mode %d, %lu switches; %lu ticks, %lu seeded buckets\n",
+               (unsigned long)s.target_min, s.policy_mode, (unsigned long)s.policy_switches,
+               (unsigned long)s.ticks, (unsigned long)s.seeded_buckets);
+}
+
+bool batt_forecast_begin() {
+    if (fc_running) {
+        return true;
+    }
+    uint32_t target_h = 0;
+#ifdef INTEGRATION_LAYER_ENABLED
+    if (!GET_CONFIG_BOOL("forecast", "enabled", true)) {
+        LOG_INFO("Forecast", "Runtime forecast disabled by config");
+        return false;
+    }
+    target_h = GET_CONFIG_INT("forecast", "target_h", 0);
+#endif
+    if (!energy_profiler_running()) {
+        LOG_WARN("Forecast", "Energy profiler not running");
+        return false;
+    }
+    model_reset();
+    batt_forecast_set_target(target_h * 60);
+    seed();
+
+    uint16_t remaining = 0;
+    read_remaining(&remaining);
+    publish(remaining, false);
+
+    fc_running = true;
+    timer_wheel_init(&fc_timer, "forecast", fc_tick);
+    timer_wheel_arm(&fc_timer, BATT_FORECAST_TICK_S * 1000UL, BATT_FORECAST_TICK_S * 1000UL);
+    usb_console_rpc("forecast", rpc_forecast);
+    LOG_INFOF("Forecast", "Seeded from %lu history buckets, target %lu h", (unsigned long)fc.seeded_buckets,
+              (unsigned long)target_h);
+    return true;
+}
@@ -0,0 +1,105 @@
+/**
+ * @file      batt_forecast.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Battery runtime forecast learned from per-mode current and subsystem use
+ */
+
+#ifndef BATT_FORECAST_H
+#define BATT_FORECAST_H
+
+#include <Arduino.h>
+#include "energy_profiler.h"
+
+/**
+ * Every BATT_FORECAST_TICK_S the energy profiler's counters are read
+ * against the last tick's. That gives the discharge over the tick and
+ * the share of it attributed to each subsystem. Both are folded into
+ * running averages for the power mode the device was in. What remains
+ * after the subsystems is the mode's own draw: clock, services, panel
+ * idle. Nothing is rescanned; a tick costs a few dozen multiplies and
+ * one gauge read.
+ *
+ * The usage pattern is the time share of each mode and the draw of
+ * each subsystem, averaged over the last BATT_FORECAST_PATTERN_S. The
+ * projection is the gauge's RemainingCapacity over the pattern's
+ * current. The same pattern with every hour spent in one mode gives
+ * that mode's runtime.
+ *
+ * At begin, or the first tick if the clock was not set yet, the mode
+ * averages are seeded once from the time-series store: the last day of
+ * TSDB_BATTERY_MA in BATT_FORECAST_SEED_STEP_S buckets, taking the
+ * buckets spent wholly in one TSDB_POWER_MODE. That
+ * history is whole-device current, so a seeded mode carries its
+ * subsystems until live ticks replace it. A mode never seen borrows the
+ * draw of the nearest less saving mode that has been.
+ *
+ * Policy: with forecast.target_h set, SimplePower::update() (auto power
+ * management) asks batt_forecast_policy_mode() each pass. The answer is
+ * the least saving mode, starting from the one the user chose, whose
+ * projection meets the target. If none does, it is the most saving
+ * mode. Going back toward the user's mode needs BATT_FORECAST_HYST_PCT
+ * of headroom. On external power the user's mode stands.
+ *
+ * Console: "forecast" for the model and the projections, "forecast
+ * target <h>" sets the target until reboot, "forecast reset" forgets
+ * the averages.
+ * Config section "forecast": enabled (true), target_h (0, off).
+ */
+
+#define BATT_FORECAST_TICK_S        60
+#define BATT_FORECAST_MODE_TAU_S    7200    // Averaging time of a mode's draw, counted in that mode
+#define BATT_FORECAST_PATTERN_S     10800   // Averaging time of the usage pattern
+#define BATT_FORECAST_SEED_S        86400   // History read at begin
+#define BATT_FORECAST_SEED_STEP_S   600
+#define BATT_FORECAST_LEARNED_S     600     // In a mode before its own draw is trusted
+#define BATT_FORECAST_HYST_PCT      10
+#define BATT_FORECAST_MODES         4       // PowerMode
+
+struct BattForecastMode {
+    float ma;                       // Own draw, subsystems excluded; 0 until learned
+    float sub_ma;                   // Subsystem draw seen while in this mode
+    uint32_t learned_s;             // Seeded and live time behind ma
+    uint8_t share_pct;              // Of the usage pattern
+    int32_t runtime_min;            // The pattern spent wholly in this mode, -1 unknown
+};
+
+struct BattForecastStats {
+    BattForecastMode mode[BATT_FORECAST_MODES];
+    float sub_ma[ENERGY_SUBSYSTEMS];    // Pattern draw per subsystem
+    float pattern_ma;
+    uint16_t remaining_mah;
+    int32_t runtime_min;            // -1 unknown, e.g. while charging
+    bool charging;
+    uint32_t ticks;
+    uint32_t seeded_buckets;
+    uint32_t target_min;            // 0 off
+    int8_t policy_mode;             // Imposed by the target, -1 none
+    uint32_t policy_switches;
+};
+
+/**
+ * @brief Seed from the time-series store and start the tick. Needs the
+ *        energy profiler running
+ */
+bool batt_forecast_begin();
+
+/**
+ * @brief Projected runtime of the current usage pattern, -1 unknown. Any task
+ */
+int32_t batt_forecast_runtime_min();
+
+/**
+ * @brief The PowerMode to be in, given the current one; the user's own
+ *        choice without a target or on external power. Loop task
+ */
+int batt_forecast_policy_mode(int mode);
+
+void batt_forecast_set_target(uint32_t minutes);
+void batt_forecast_reset();
+
+void batt_forecast_get_stats(BattForecastStats *out);
+
+#endif // BATT_FORECAST_H
@@ -0,0 +1,659 @@
+/**
+ * @file      bench_suite.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     On-device microbenchmarks with warmup and repetitions, reported over serial
+ */
+
+#include "bench_suite.h"
+#include <SD.h>
+#include "peripheral.h"
+#include "lora_codec.h"
+#include "lora_dict.h"
+#include "i2c_bus.h"
+#include "spi_bus.h"
+#include "sd_manager.h"
+#include "fs_layout.h"
+#include "simple_logger.h"
+#include "lvgl_integration.h"
+#include "integration/event_bridge.h"
+#include "integration/config_manager.h"
+
+void bench_summarize(uint32_t *samples, uint16_t n, BenchResult *out) {
+    memset(out, 0, sizeof(*out));
+    if (n == 0) {
+        return;
+    }
+    // Insertion sort, n is small
+    for (uint16_t i = 1; i < n; i++) {
+        uint32_t v = samples[i];
+        int j = i - 1;
+        while (j >= 0 && samples[j] > v) {
+            samples[j + 1] = samples[j];
+            j--;
+        }
+        samples[j + 1] = v;
+    }
+    uint64_t sum = 0;
+    for (uint16_t i = 0; i < n; i++) {
+        sum += samples[i];
+    }
+    out->n = n;
+    out->min = samples[0];
+    out->max = samples[n - 1];
+    out->median = n & 1 ? samples[n / 2] : (samples[n / 2 - 1] + samples[n / 2]) / 2;
+    out->mean = (uint32_t)(sum / n);
+}
+
+void bench_measure(bench_fn fn, void *ctx, uint16_t warmup, uint16_t reps, BenchResult *out) {
+    uint32_t samples[BENCH_REPS_MAX];
+    if (reps > BENCH_REPS_MAX) {
+        reps = BENCH_REPS_MAX;
+    }
+    for (uint16_t i = 0; i < warmup; i++) {
+        fn(ctx);
+    }
+    for (uint16_t i = 0; i < reps; i++) {
+        uint32_t start = micros();
+        fn(ctx);
+        samples[i] = micros() - start;
+    }
+    bench_summarize(samples, reps, out);
+}
+
+void bench_report(Print &out, const char *name, const char *unit, const BenchResult &r, const char *extra) {
+    out.printf("BENCH %s unit=%s n=%u min=%lu med=%lu mean=%lu max=%lu%s%s\n", name, unit, r.n,
+               (unsigned long)r.min, (unsigned long)r.median, (unsigned long)r.mean, (unsigned long)r.max,
+               extra ? " " : "", extra ? extra : "");
+}
+
+void bench_skip(Print &out, const char *name, const char *reason) {
+    out.printf("BENCH_SKIP %s %s\n", name, reason);
+}
+
+// ---------------------------------------------------------------------------
+// Display: 1bpp pack and partial refresh
+// ---------------------------------------------------------------------------
+
+static void flush_pack_once(void *ctx) {
+    ((LVGLIntegration *)ctx)->benchmarkFlush(1);
+}
+
+static bool bench_flush_pack(Print &out) {
+    LVGLIntegration *lvgl = LVGLIntegration::getInstance();
+    if (!lvgl->isInitialized()) {
+        bench_skip(out, "display.pack", "no_lvgl");
+        return false;
+    }
+    // benchmarkFlush() logs each call; keep that out of the results
+    SimpleLogger::getInstance()->setComponentLevel("LVGL", LOG_WARN);
+    BenchResult r;
+    bench_measure(flush_pack_once, lvgl, BENCH_WARMUP, BENCH_FLUSH_REPS, &r);
+    SimpleLogger::getInstance()->clearComponentLevel("LVGL");
+    bench_report(out, "display.pack", "us", r);
+    return true;
+}
+
+// A one-line label changing each time: render, diff and a partial panel
+// update of one small rectangle, until the flush task is idle again
+static bool bench_partial_refresh(Print &out) {
+    LVGLIntegration *lvgl = LVGLIntegration::getInstance();
+    if (!lvgl->isInitialized()) {
+        bench_skip(out, "display.partial", "no_lvgl");
+        return false;
+    }
+    lvgl->waitFlushIdle();
+    lv_obj_t *label = lv_label_create(lv_scr_act());
+    lv_obj_align(label, LV_ALIGN_TOP_LEFT, 8, 8);
+    lv_label_set_text(label, "bench");
+    lv_refr_now(NULL);
+    lvgl->waitFlushIdle();
+
+    uint32_t samples[BENCH_REPS_MAX];
+    uint32_t partial = lvgl->getPartialUpdates();
+    uint32_t full = lvgl->getFullUpdates();
+    for (uint16_t i = 0; i < BENCH_REFRESH_REPS + BENCH_WARMUP; i++) {
+        uint32_t start = micros();
+        lv_label_set_text_fmt(label, "bench %u", i);
+        lv_refr_now(NULL);
+        lvgl->waitFlushIdle();
+        if (i >= BENCH_WARMUP) {
+            samples[i - BENCH_WARMUP] = micros() - start;
+        }
+    }
+    lv_obj_del(label);
+
+    BenchResult r;
+    char extra[48];
+    bench_summarize(samples, BENCH_REFRESH_REPS, &r);
+    snprintf(extra, sizeof(extra), "partial=%lu full=%lu", (unsigned long)(lvgl->getPartialUpdates() - partial),
+             (unsigned long)(lvgl->getFullUpdates() - full));
+    bench_report(out, "display.partial", "us", r, extra);
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// EventBridge publish and dispatch
+// ---------------------------------------------------------------------------
+
+static uint32_t bench_events_seen = 0;
+
+static void bench_event_handler(const Event &event, void *context) {
+    bench_events_seen++;
+}
+
+static bool bench_events(Print &out) {
+    EventBridge bridge;
+    if (!bridge.initialize()) {
+        bench_skip(out, "events.publish", "init_failed");
+        return false;
+    }
+    bridge.subscribe("bench", EventType::USER_INPUT, bench_event_handler);
+    bench_events_seen = 0;
+
+    uint32_t publish[BENCH_REPS_MAX];
+    uint32_t dispatch[BENCH_REPS_MAX];
+    uint32_t rejected = 0;
+    for (uint16_t i = 0; i < BENCH_EVENT_REPS + BENCH_WARMUP; i++) {
+        uint32_t start = micros();
+        for (uint32_t e = 0; e < BENCH_EVENT_BATCH; e++) {
+            if (!bridge.tryPublish(EventType::USER_INPUT, "bench", e)) {
+                rejected++;
+            }
+        }
+        uint32_t mid = micros();
+        while (bridge.getQueueSize() > 0) {
+            bridge.processEvents();
+        }
+        uint32_t end = micros();
+        if (i >= BENCH_WARMUP) {
+            publish[i - BENCH_WARMUP] = (mid - start) * 1000 / BENCH_EVENT_BATCH;
+            dispatch[i - BENCH_WARMUP] = (end - mid) * 1000 / BENCH_EVENT_BATCH;
+        }
+    }
+    bridge.shutdown();
+
+    BenchResult r;
+    char extra[48];
+    snprintf(extra, sizeof(extra), "batch=%d rejected=%lu", BENCH_EVENT_BATCH, (unsigned long)rejected);
+    bench_summarize(publish, BENCH_EVENT_REPS, &r);
+    bench_report(out, "events.publish", "ns/event", r, extra);
+    snprintf(extra, sizeof(extra), "batch=%d delivered=%lu", BENCH_EVENT_BATCH, (unsigned long)bench_events_seen);
+    bench_summarize(dispatch, BENCH_EVENT_REPS, &r);
+    bench_report(out, "events.dispatch", "ns/event", r, extra);
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Logger
+// ---------------------------------------------------------------------------
+
+static uint32_t bench_log_seq = 0;
+
+static void log_line_once(void *ctx) {
+    LOG_INFOF("Bench", "log throughput line %lu value %d", (unsigned long)bench_log_seq++, 42);
+}
+
+static void log_filtered_once(void *ctx) {
+    LOG_DEBUGF("Bench", "filtered line %lu value %d", (unsigned long)bench_log_seq++, 42);
+}
+
+// Serial (and SD, if the logger has it on) for an emitted line; the cost of
+// a call below the level, which is what most LOG_DEBUG sites pay
+static bool bench_logger(Print &out) {
+    SimpleLogger *logger = SimpleLogger::getInstance();
+    BenchResult r;
+
+    logger->setComponentLevel("Bench", LOG_INFO);
+    bench_measure(log_line_once, nullptr, BENCH_WARMUP, BENCH_LOG_REPS, &r);
+    logger->flush();
+    bench_report(out, "log.emit", "us", r);
+
+    bench_measure(log_filtered_once, nullptr, BENCH_WARMUP, BENCH_LOG_REPS, &r);
+    logger->clearComponentLevel("Bench");
+    bench_report(out, "log.filtered", "us", r);
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// ConfigManager load and save
+// ---------------------------------------------------------------------------
+
+static bool bench_config(Print &out) {
+    ConfigManager config(ConfigStorage::LITTLEFS);
+    config.setConfigFilePath(BENCH_CONFIG_PATH);
+    config.setAutoSave(false);
+    if (!config.initialize()) {
+        bench_skip(out, "config.save", "init_failed");
+        return false;
+    }
+
+    char section[16];
+    char key[16];
+    for (int s = 0; s < BENCH_CONFIG_SECTIONS; s++) {
+        snprintf(section, sizeof(section), "bench%02d", s);
+        for (int k = 0; k < BENCH_CONFIG_KEYS; k++) {
+            snprintf(key, sizeof(key), "key%02d", k);
+            if (k % 2) {
+                config.setInteger(section, key, s * 100 + k);
+            } else {
+                config.setString(section, key, key);
+            }
+        }
+    }
+
+    uint32_t save[BENCH_REPS_MAX];
+    uint32_t load[BENCH_REPS_MAX];
+    bool ok = true;
+    for (uint16_t i = 0; i < BENCH_CONFIG_REPS + BENCH_WARMUP; i++) {
+        uint32_t start = micros();
+        ok = config.saveConfig() && ok;
+        uint32_t mid = micros();
+        ok = config.loadConfig() && ok;
+        uint32_t end = micros();
+        if (i >= BENCH_WARMUP) {
+            save[i - BENCH_WARMUP] = mid - start;
+            load[i - BENCH_WARMUP] = end - mid;
+        }
+    }
+
+    fs::FS &fs = *fs_for(FS_WL_CONFIG);
+    File file = fs.open(BENCH_CONFIG_PATH, FILE_READ);
+    size_t bytes = file ? file.size() : 0;
+    file.close();
+    config.shutdown();
+    fs.remove(BENCH_CONFIG_PATH);
+
+    BenchResult r;
+    char extra[48];
+    snprintf(extra, sizeof(extra), "bytes=%u ok=%d", (unsigned)bytes, ok);
+    bench_summarize(save, BENCH_CONFIG_REPS, &r);
+    bench_report(out, "config.save", "us", r, extra);
+    bench_summarize(load, BENCH_CONFIG_REPS, &r);
+    bench_report(out, "config.load", "us", r, extra);
+    return ok;
+}
+
+// ---------------------------------------------------------------------------
+// LittleFS volumes: the small-file operations config and indices make
+// ---------------------------------------------------------------------------
+
+struct FsBenchCtx {
+    fs::FS *fs;
+    uint8_t buf[BENCH_FS_REWRITE];
+    bool ok;
+};
+
+static void fs_open_once(void *ctx) {
+    FsBenchCtx *c = (FsBenchCtx *)ctx;
+    File file = c->fs->open(BENCH_FS_PATH, FILE_READ);
+    c->ok = file && c->ok;
+    file.close();
+}
+
+static void fs_stat_once(void *ctx) {
+    FsBenchCtx *c = (FsBenchCtx *)ctx;
+    c->ok = c->fs->exists(BENCH_FS_PATH) && c->ok;
+}
+
+static void fs_append_once(void *ctx) {
+    FsBenchCtx *c = (FsBenchCtx *)ctx;
+    File file = c->fs->open(BENCH_FS_PATH, FILE_APPEND);
+    c->ok = file && file.write(c->buf, BENCH_FS_APPEND) == BENCH_FS_APPEND && c->ok;
+    file.close();
+}
+
+// Written aside and renamed over the old copy, as the config snapshot is
+static void fs_rename_once(void *ctx) {
+    FsBenchCtx *c = (FsBenchCtx *)ctx;
+    File file = c->fs->open(BENCH_FS_TMP_PATH, FILE_WRITE);
+    bool ok = file && file.write(c->buf, BENCH_FS_REWRITE) == BENCH_FS_REWRITE;
+    file.close();
+    c->fs->remove(BENCH_FS_PATH);
+    c->ok = ok && c->fs->rename(BENCH_FS_TMP_PATH, BENCH_FS_PATH) && c->ok;
+}
+
+static bool bench_fs(Print &out) {
+    static const struct {
+        const char *op;
+        bench_fn fn;
+    } ops[] = {
+        {"rename", fs_rename_once},     // First: leaves the file the others use
+        {"open", fs_open_once},
+        {"stat", fs_stat_once},
+        {"append", fs_append_once},
+    };
+    if (!fs_layout_begin()) {
+        bench_skip(out, "fs.bulk.open", "not_mounted");
+        return false;
+    }
+    FsBenchCtx *ctx = (FsBenchCtx *)malloc(sizeof(FsBenchCtx));
+    if (!ctx) {
+        bench_skip(out, "fs.bulk.open", "no_memory");
+        return false;
+    }
+    for (uint32_t i = 0; i < sizeof(ctx->buf); i++) {
+        ctx->buf[i] = (uint8_t)i;
+    }
+
+    bool ok = true;
+    char name[32];
+    for (int v = 0; v < FS_VOL_COUNT; v++) {
+        FsVolumeInfo vol;
+        fs_volume_info((FsVolume)v, &vol);
+        ctx->fs = fs_volume((FsVolume)v);
+        if (!ctx->fs) {
+            snprintf(name, sizeof(name), "fs.%s.open", vol.name);
+            bench_skip(out, name, vol.fallback ? "no_partition" : "not_mounted");
+            continue;
+        }
+        ctx->ok = true;
+        for (size_t i = 0; i < sizeof(ops) / sizeof(ops[0]); i++) {
+            BenchResult r;
+            char extra[64];
+            bench_measure(ops[i].fn, ctx, BENCH_WARMUP, BENCH_FS_REPS, &r);
+            snprintf(name, sizeof(name), "fs.%s.%s", vol.name, ops[i].op);
+            snprintf(extra, sizeof(extra), "used_kb=%lu total_kb=%lu ok=%d",
+                     (unsigned long)(vol.used_bytes / 1024), (unsigned long)(vol.total_bytes / 1024), ctx->ok);
+            bench_report(out, name, "us", r, extra);
+        }
+        ctx->fs->remove(BENCH_FS_PATH);
+        ok = ctx->ok && ok;
+    }
+    free(ctx);
+    return ok;
+}
+
+// ---------------------------------------------------------------------------
+// SD sequential write and read
+// ---------------------------------------------------------------------------
+
+// KB/s for one pass over the file, 0 on an I/O error. The bus is held per
+// chunk, as the file service does, so the panel and radio can get in
+static uint32_t sd_pass(bool write, uint8_t *buf) {
+    uint32_t start = micros();
+    File file;
+    {
+        SpiBusHold hold(SPI_CLIENT_SD);
+        file = SD.open(BENCH_SD_PATH, write ? FILE_WRITE : FILE_READ);
+    }
+    if (!file) {
+        return 0;
+    }
+    bool ok = true;
+    for (uint32_t done = 0; done < BENCH_SD_FILE_SIZE && ok; done += BENCH_SD_CHUNK) {
+        SpiBusHold hold(SPI_CLIENT_SD);
+        ok = (write ? file.write(buf, BENCH_SD_CHUNK) : file.read(buf, BENCH_SD_CHUNK)) == BENCH_SD_CHUNK;
+    }
+    {
+        SpiBusHold hold(SPI_CLIENT_SD);
+        file.close();           // Includes the final flush for writes
+    }
+    uint32_t us = micros() - start;
+    return ok && us ? (uint32_t)((uint64_t)BENCH_SD_FILE_SIZE * 1000000 / 1024 / us) : 0;
+}
+
+static bool bench_sd(Print &out) {
+    if (!sd_manager_mounted()) {
+        bench_skip(out, "sd.write", "not_mounted");
+        return false;
+    }
+    uint8_t *buf = (uint8_t *)malloc(BENCH_SD_CHUNK);
+    if (!buf) {
+        bench_skip(out, "sd.write", "no_memory");
+        return false;
+    }
+    for (uint32_t i = 0; i < BENCH_SD_CHUNK; i++) {
+        buf[i] = (uint8_t)i;
+    }
+
+    uint32_t wr[BENCH_REPS_MAX];
+    uint32_t rd[BENCH_REPS_MAX];
+    for (uint16_t i = 0; i < BENCH_SD_REPS; i++) {
+        wr[i] = sd_pass(true, buf);
+        rd[i] = sd_pass(false, buf);
+    }
+    free(buf);
+    {
+        SpiBusHold hold(SPI_CLIENT_SD);
+        SD.remove(BENCH_SD_PATH);
+    }
+
+    BenchResult r;
+    char extra[48];
+    snprintf(extra, sizeof(extra), "bytes=%d chunk=%d", BENCH_SD_FILE_SIZE, BENCH_SD_CHUNK);
+    bench_summarize(wr, BENCH_SD_REPS, &r);
+    bench_report(out, "sd.write", "KB/s", r, extra);
+    bench_summarize(rd, BENCH_SD_REPS, &r);
+    bench_report(out, "sd.read", "KB/s", r, extra);
+    return r.min > 0;
+}
+
+// ---------------------------------------------------------------------------
+// LoRa time on air, computed against measured
+// ---------------------------------------------------------------------------
+
+// Enqueue to TX done as the queue sees it: the modem's time on air plus
+// the wake-up of the LoRa task and the DIO1 interrupt. LBT is off, so a
+// channel scan does not add to it
+static bool bench_lora(Print &out) {
+    static const uint16_t lengths[] = {16, 64, LORA_PACKET_MAX};
+    if (!peri_init_ready(E_PERI_LORA) && !lora_init()) {
+        bench_skip(out, "lora.tx", "no_radio");
+        return false;
+    }
+    bool lbt = lora_get_lbt();
+    lora_set_lbt(false);
+    lora_set_mode(LORA_MODE_SEND);
+
+    uint8_t packet[LORA_PACKET_MAX];
+    for (size_t i = 0; i < sizeof(packet); i++) {
+        packet[i] = (uint8_t)i;
+    }
+
+    const lora_profile_t *profile = lora_get_profile();
+    for (size_t l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l++) {
+        char name[24];
+        char extra[64];
+        uint32_t toa_us = lora_profile_time_on_air_us(profile, lengths[l]);
+        snprintf(name, sizeof(name), "lora.tx.%u", lengths[l]);
+
+        uint32_t samples[BENCH_LORA_REPS];
+        uint16_t n = 0;
+        for (uint16_t i = 0; i < BENCH_LORA_REPS; i++) {
+            if (lora_tx_airtime_left_ms() * 1000 < toa_us) {
+                break;
+            }
+            lora_counters_t before;
+            lora_counters_t after;
+            lora_get_counters(&before);
+            uint32_t start = micros();
+            if (!lora_tx_enqueue(packet, lengths[l], LORA_TX_PRIO_HIGH, 0)) {
+                break;
+            }
+            do {
+                vTaskDelay(1);
+                lora_get_counters(&after);
+            } while (after.tx_sent == before.tx_sent && after.tx_failed == before.tx_failed &&
+                     micros() - start < BENCH_LORA_TIMEOUT_MS * 1000UL);
+            if (after.tx_sent == before.tx_sent) {
+                break;
+            }
+            samples[n++] = micros() - start;
+        }
+        if (n == 0) {
+            bench_skip(out, name, "tx_failed_or_no_airtime");
+            continue;
+        }
+
+        BenchResult r;
+        bench_summarize(samples, n, &r);
+        snprintf(extra, sizeof(extra), "toa_us=%lu sf=%u bw=%.0f over_us=%ld", (unsigned long)toa_us, profile->sf,
+                 profile->bw, (long)r.median - (long)toa_us);
+        bench_report(out, name, "us", r, extra);
+    }
+
+    lora_set_lbt(lbt);
+    lora_set_mode(LORA_MODE_RECV);
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// LoRa payload codec on the held-out corpus messages
+// ---------------------------------------------------------------------------
+
+// One sample per message, the fastest of a few runs, in CPU cycles; the
+// ratio counts a message that does not pack at its own length, as sent
+static bool bench_lora_codec(Print &out) {
+    static_assert(LORA_DICT_SAMPLES <= BENCH_REPS_MAX, "Too many codec samples for one summary");
+    uint32_t encode[LORA_DICT_SAMPLES];
+    uint32_t decode[LORA_DICT_SAMPLES];
+    uint8_t packed[LORA_PACKET_MAX];
+    uint8_t plain[LORA_PACKET_MAX];
+    uint32_t bytes_in = 0;
+    uint32_t bytes_out = 0;
+    uint16_t n_packed = 0;
+    uint16_t mismatches = 0;
+
+    for (uint16_t i = 0; i < LORA_DICT_SAMPLES; i++) {
+        const uint8_t *msg = (const uint8_t *)lora_dict_samples[i];
+        size_t len = strlen(lora_dict_samples[i]);
+        size_t packed_len = 0;
+        encode[i] = UINT32_MAX;
+        decode[i] = 0;
+        for (uint16_t r = 0; r < BENCH_CODEC_REPS; r++) {
+            uint32_t start = ESP.getCycleCount();
+            packed_len = lora_codec_encode(msg, len, packed, sizeof(packed));
+            uint32_t cycles = ESP.getCycleCount() - start;
+            encode[i] = cycles < encode[i] ? cycles : encode[i];
+        }
+        bytes_in += len;
+        bytes_out += packed_len ? packed_len : len;
+        if (!packed_len) {
+            continue;
+        }
+        n_packed++;
+        int plain_len = -1;
+        decode[i] = UINT32_MAX;
+        for (uint16_t r = 0; r < BENCH_CODEC_REPS; r++) {
+            uint32_t start = ESP.getCycleCount();
+            plain_len = lora_codec_decode(packed, packed_len, plain, sizeof(plain));
+            uint32_t cycles = ESP.getCycleCount() - start;
+            decode[i] = cycles < decode[i] ? cycles : decode[i];
+        }
+        if (plain_len != (int)len || memcmp(plain, msg, len) != 0) {
+            mismatches++;
+        }
+    }
+
+    // Messages that did not pack were never decoded
+    uint16_t d = 0;
+    for (uint16_t i = 0; i < LORA_DICT_SAMPLES; i++) {
+        if (decode[i]) {
+            decode[d++] = decode[i];
+        }
+    }
+
+    BenchResult r;
+    char extra[96];
+    bench_summarize(encode, LORA_DICT_SAMPLES, &r);
+    snprintf(extra, sizeof(extra), "bytes_in=%lu bytes_out=%lu ratio=%.2f packed=%u", (unsigned long)bytes_in,
+             (unsigned long)bytes_out, bytes_out ? (float)bytes_in / bytes_out : 0.0f, n_packed);
+    bench_report(out, "lora.codec.encode", "cycles", r, extra);
+    if (d) {
+        bench_summarize(decode, d, &r);
+        snprintf(extra, sizeof(extra), "mismatches=%u", mismatches);
+        bench_report(out, "lora.codec.decode", "cycles", r, extra);
+    }
+    return mismatches == 0;
+}
+
+// ---------------------------------------------------------------------------
+// I2C transaction latency
+// ---------------------------------------------------------------------------
+
+struct I2cBenchTarget {
+    const char *name;
+    int dev;
+    uint8_t reg;
+    uint8_t len;
+};
+
+// Registers that are safe to read at any time: fuel gauge voltage, keypad config
+static const I2cBenchTarget i2c_targets[] = {
+    {"i2c.bq27220", I2C_DEV_BQ27220, 0x08, 2},
+    {"i2c.keypad",  I2C_DEV_KEYPAD,  0x01, 1},
+};
+
+struct I2cBenchCtx {
+    const I2cBenchTarget *target;
+    uint8_t buf[4];
+    uint32_t errors;
+};
+
+static void i2c_read_once(void *ctx) {
+    I2cBenchCtx *c = (I2cBenchCtx *)ctx;
+    if (!i2c_bus_read_reg(c->target->dev, c->target->reg, c->buf, c->target->len)) {
+        c->errors++;
+    }
+}
+
+// Acquire, one write-read transfer and release on the calling task; hold_us
+// is the bus's own view of the transfer alone
+static bool bench_i2c(Print &out) {
+    for (size_t i = 0; i < sizeof(i2c_targets) / sizeof(i2c_targets[0]); i++) {
+        I2cBenchCtx ctx = {&i2c_targets[i], {0}, 0};
+        i2c_bus_stats_t before;
+        i2c_bus_stats_t after;
+        i2c_bus_get_stats(ctx.target->dev, &before);
+
+        BenchResult r;
+        bench_measure(i2c_read_once, &ctx, BENCH_WARMUP, BENCH_I2C_REPS, &r);
+        i2c_bus_get_stats(ctx.target->dev, &after);
+        if (ctx.errors >= BENCH_I2C_REPS) {
+            bench_skip(out, ctx.target->name, "no_ack");
+            continue;
+        }
+
+        uint32_t holds = after.transactions - before.transactions;
+        char extra[64];
+        snprintf(extra, sizeof(extra), "bytes=%u errors=%lu hold_us=%lu", ctx.target->len, (unsigned long)ctx.errors,
+                 holds ? (unsigned long)((after.hold_us - before.hold_us) / holds) : 0UL);
+        bench_report(out, ctx.target->name, "us", r, extra);
+    }
+    return true;
+}
+
+int bench_suite_run(Print &out) {
+    typedef bool (*bench_group_fn)(Print &out);
+    static const bench_group_fn groups[] = {
+        bench_flush_pack,
+        bench_partial_refresh,
+        bench_events,
+        bench_logger,
+        bench_config,
+        bench_fs,
+        bench_sd,
+        bench_lora,
+        bench_lora_codec,
+        bench_i2c,
+    };
+
+    out.printf("BENCH_BEGIN build=\"%s %s\" cpu_mhz=%lu heap=%lu psram=%lu\n", __DATE__, __TIME__,
+               (unsigned long)getCpuFrequencyMhz(), (unsigned long)ESP.getFreeHeap(),
+               (unsigned long)ESP.getFreePsram());
+    int ran = 0;
+    int failed = 0;
+    uint32_t start = millis();
+    for (size_t i = 0; i < sizeof(groups) / sizeof(groups[0]); i++) {
+        if (groups[i](out)) {
+            ran++;
+        } else {
+            failed++;
+        }
+    }
+    out.printf("BENCH_END ran=%d failed=%d ms=%lu\n", ran, failed, (unsigned long)(millis() - start));
+    return ran;
+}
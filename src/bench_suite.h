@@ -0,0 +1,91 @@
+/**
+ * @file      bench_suite.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     On-device microbenchmarks with warmup and repetitions, reported over serial
+ */
+
+#ifndef BENCH_SUITE_H
+#define BENCH_SUITE_H
+
+#include <Arduino.h>
+
+/**
+ * One line per benchmark, for scripts that track results across builds:
+ *
+ *   BENCH <name> unit=<unit> n=<reps> min=<> med=<> mean=<> max=<> [key=value ...]
+ *
+ * framed by BENCH_BEGIN (build, clock, heap) and BENCH_END (counts). Names
+ * are dotted and stable; anything that is not a BENCH line is log output.
+ * A benchmark whose hardware is missing prints BENCH_SKIP <name> <reason>.
+ */
+
+#define BENCH_REPS_MAX              64      // Samples kept per benchmark, for the median
+#define BENCH_WARMUP                2       // Untimed runs before the samples
+
+// Workloads
+#define BENCH_FLUSH_REPS            16      // Whole-frame packs
+#define BENCH_REFRESH_REPS          8       // Partial refreshes, about half a second each
+#define BENCH_EVENT_BATCH           32      // Events published per sample, then dispatched
+#define BENCH_EVENT_REPS            64
+#define BENCH_LOG_REPS              64
+#define BENCH_CONFIG_REPS           8
+#define BENCH_CONFIG_SECTIONS       8
+#define BENCH_CONFIG_KEYS           16      // Per section
+#define BENCH_CONFIG_PATH           "/bench_config.json"    // Kept apart from the real config
+#define BENCH_FS_REPS               16      // Per operation and volume
+#define BENCH_FS_PATH               "/bench_fs.dat"
+#define BENCH_FS_TMP_PATH           "/bench_fs.tmp"
+#define BENCH_FS_APPEND             32      // Bytes per append, a journal record
+#define BENCH_FS_REWRITE            256     // Bytes per transactional rewrite
+#define BENCH_SD_PATH               "/bench.bin"
+#define BENCH_SD_FILE_SIZE          (256 * 1024)
+#define BENCH_SD_CHUNK              4096
+#define BENCH_SD_REPS               3
+#define BENCH_LORA_REPS             3       // Per packet length, within the duty-cycle budget
+#define BENCH_LORA_TIMEOUT_MS       10000
+#define BENCH_CODEC_REPS            8       // Per corpus message, the fastest counts
+#define BENCH_I2C_REPS              64
+
+typedef void (*bench_fn)(void *ctx);
+
+struct BenchResult {
+    uint16_t n;
+    uint32_t min;
+    uint32_t median;
+    uint32_t mean;
+    uint32_t max;
+};
+
+/**
+ * @brief Reduce samples to min, median, mean and max. Sorts samples in place
+ */
+void bench_summarize(uint32_t *samples, uint16_t n, BenchResult *out);
+
+/**
+ * @brief Run fn warmup times untimed, then reps times (at most
+ *        BENCH_REPS_MAX) timed in microseconds
+ */
+void bench_measure(bench_fn fn, void *ctx, uint16_t warmup, uint16_t reps, BenchResult *out);
+
+/**
+ * @brief Print one BENCH line; extra is appended as is (key=value pairs) or nullptr
+ */
+void bench_report(Print &out, const char *name, const char *unit, const BenchResult &r,
+                  const char *extra = nullptr);
+void bench_skip(Print &out, const char *name, const char *reason);
+
+/**
+ * @brief Run every benchmark once, in the order of the request: framebuffer
+ *        pack, partial refresh, EventBridge, logger, config, LittleFS
+ *        volumes, SD, LoRa,
+ *        LoRa payload codec, I2C.
+ *        Expects SimpleHardware (display, LVGL, SD, I2C) to be up; brings
+ *        up the radio itself
+ * @return Number of benchmarks that ran
+ */
+int bench_suite_run(Print &out);
+
+#endif // BENCH_SUITE_H
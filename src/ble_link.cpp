@@ -0,0 +1,752 @@
+/**
+ * @file      ble_link.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     BLE companion link: NimBLE GATT server, record ring, Meshtastic phone API subset
+ */
+
+#include "ble_link.h"
+#include <NimBLEDevice.h>
+#include <time.h>
+#include "config/os_config.h"
+#include "factory.h"
+#include "msg_store.h"
+#include "net_manager.h"
+#include "peripheral.h"
+#include "sensor_sampler.h"
+#include "simple_logger.h"
+#ifdef INTEGRATION_LAYER_ENABLED
+#include "integration/config_manager.h"
+#endif
+
+#define BLE_EVT_CMD         0x01
+#define BLE_EVT_KICK        0x02    // Subscribed, connected or disconnected
+
+#define MESH_SERVICE_UUID   "6ba1b218-15a8-461f-9fa8-5dcae273eafd"
+#define MESH_TORADIO_UUID   "f75c76d2-129e-4dad-a1dd-7866124401e7"
+#define MESH_FROMRADIO_UUID "2c55e69e-4993-11ed-b878-0242ac120002"
+#define MESH_FROMNUM_UUID   "ed9da18c-a800-4f66-a670-aa7547e34453"
+
+struct BleCmd {
+    bool mesh;                      // A Meshtastic ToRadio
+    uint16_t len;
+    uint8_t data[BLE_LINK_CMD_MAX];
+};
+
+struct BleMeshFrame {
+    uint16_t len;
+    uint8_t data[BLE_MESH_FRAME_MAX];
+};
+
+static TaskHandle_t ble_task_handle = NULL;
+static QueueHandle_t ble_cmd_queue = NULL;
+static QueueHandle_t ble_mesh_queue = NULL;
+static NimBLEServer *ble_server = NULL;
+static NimBLECharacteristic *ble_data_chr = NULL;
+static NimBLECharacteristic *ble_status_chr = NULL;
+static NimBLECharacteristic *ble_fromnum_chr = NULL;
+static uint32_t ble_node = 0;
+
+// Set on the host task
+static volatile uint16_t ble_conn = BLE_HS_CONN_HANDLE_NONE;
+static volatile uint16_t ble_mtu = 23;
+static volatile bool ble_subscribed = false;
+static volatile bool ble_sub_wanted = false;      // Subscribed before pairing finished
+static volatile bool ble_phy_2m = false;
+static uint32_t ble_passkey = 0;                  // Fixed from config, else drawn per pairing
+
+// The rest belongs to the link task
+static uint8_t *ble_ring = NULL;
+static uint32_t ble_ring_head = 0;              // Written
+static uint32_t ble_ring_tail = 0;              // Handed to the host
+static uint8_t ble_tx_buf[BLE_LINK_MTU];
+
+// Store cursor: records at or past it have not been sent
+static bool ble_cursor_valid = false;
+static uint16_t ble_cursor_seg = 0;
+static uint16_t ble_cursor_off = 0;
+static bool ble_catching_up = false;            // Segments left before the cursor is at the end
+static bool ble_sync_requested = false;         // A SYNC_DONE record is owed
+static uint32_t ble_sync_since = 0;
+static uint32_t ble_sync_count = 0;
+static uint32_t ble_sync_started = 0;
+static bool ble_sync_draining = false;
+static uint32_t ble_store_appended = 0;
+static uint32_t ble_next_status = 0;
+
+static bool ble_mesh_active = false;
+static uint32_t ble_mesh_since = 0;
+static uint32_t ble_mesh_id = 0;
+
+static portMUX_TYPE ble_mux = portMUX_INITIALIZER_UNLOCKED;
+static BleLinkStats ble_stats;
+
+static inline void stat_add(uint32_t *field, uint32_t n) {
+    portENTER_CRITICAL(&ble_mux);
+    *field += n;
+    portEXIT_CRITICAL(&ble_mux);
+}
+
+// ===== Record ring =====
+
+static inline uint32_t ring_used() {
+    return ble_ring_head - ble_ring_tail;
+}
+
+static inline uint32_t ring_free() {
+    return BLE_LINK_RING_SIZE - ring_used();
+}
+
+static void ring_write(const void *data, size_t len) {
+    const uint8_t *p = (const uint8_t *)data;
+    uint32_t at = ble_ring_head % BLE_LINK_RING_SIZE;
+    size_t first = len < BLE_LINK_RING_SIZE - at ? len : BLE_LINK_RING_SIZE - at;
+    memcpy(ble_ring + at, p, first);
+    memcpy(ble_ring, p + first, len - first);
+    ble_ring_head += len;
+}
+
+static bool ring_record(uint8_t type, const void *body, uint16_t len,
+                        const void *extra1 = NULL, uint16_t len1 = 0,
+                        const void *extra2 = NULL, uint16_t len2 = 0) {
+    BleRecordHeader h = {type, (uint16_t)(len + len1 + len2)};
+    if (ring_free() < sizeof(h) + h.len) {
+        return false;
+    }
+    ring_write(&h, sizeof(h));
+    ring_write(body, len);
+    ring_write(extra1, len1);
+    ring_write(extra2, len2);
+    return true;
+}
+
+// Hand the ring to the host in MTU-sized notifications until it runs out of buffers
+static void ring_pump() {
+    uint16_t conn = ble_conn;
+    size_t chunk = ble_mtu - 3;
+    while (ring_used() && conn != BLE_HS_CONN_HANDLE_NONE && ble_subscribed) {
+        size_t len = ring_used() < chunk ? ring_used() : chunk;
+        uint32_t at = ble_ring_tail % BLE_LINK_RING_SIZE;
+        size_t first = len < BLE_LINK_RING_SIZE - at ? len : BLE_LINK_RING_SIZE - at;
+        memcpy(ble_tx_buf, ble_ring + at, first);
+        memcpy(ble_tx_buf + first, ble_ring, len - first);
+
+        struct os_mbuf *om = ble_hs_mbuf_from_flat(ble_tx_buf, len);
+        if (!om || ble_gattc_notify_custom(conn, ble_data_chr->getHandle(), om) != 0) {
+            // The host frees the buffer on failure; a tick lets the controller drain
+            stat_add(&ble_stats.stalls, 1);
+            vTaskDelay(1);
+            return;
+        }
+        ble_ring_tail += len;
+        portENTER_CRITICAL(&ble_mux);
+        ble_stats.notifications++;
+        ble_stats.bytes_sent += len;
+        portEXIT_CRITICAL(&ble_mux);
+    }
+    if (ble_sync_draining && !ring_used()) {
+        ble_sync_draining = false;
+        portENTER_CRITICAL(&ble_mux);
+        ble_stats.last_sync_ms = millis() - ble_sync_started;
+        ble_stats.last_sync_messages = ble_sync_count;
+        portEXIT_CRITICAL(&ble_mux);
+        LOG_INFOF("BLE", "Synced %lu messages in %lu ms", (unsigned long)ble_sync_count,
+                  (unsigned long)ble_stats.last_sync_ms);
+    }
+}
+
+// ===== Status =====
+
+static void status_fill(BleStatus *s) {
+    memset(s, 0, sizeof(*s));
+    s->uptime_s = millis() / 1000;
+    SensorGauge g;
+    if (sensor_get_gauge(&g)) {
+        s->battery_mv = g.mv;
+        s->battery_pct = g.soc;
+    }
+    if (peri_init_ready(E_PERI_GPS)) {
+        gps_fix_t fix;
+        gps_get_fix(&fix);
+        s->gps_valid = fix.valid;
+        if (fix.valid) {
+            s->lat_e7 = (int32_t)(fix.lat * 1e7);
+            s->lng_e7 = (int32_t)(fix.lng * 1e7);
+            s->alt_cm = (int32_t)(fix.altitude * 100);
+            s->sats = fix.vsat;
+            uint32_t age = (millis() - fix.time_ms) / 1000;
+            s->fix_age_s = age > 0xFFFF ? 0xFFFF : age;
+        }
+    }
+    MsgStoreStats ms;
+    msg_store_get_stats(&ms);
+    s->messages = ms.messages;
+}
+
+// The STATUS value is refreshed here rather than on read, which would hold
+// the host task on the I2C bus
+static void status_push() {
+    BleStatus s;
+    status_fill(&s);
+    ble_status_chr->setValue((const uint8_t *)&s, sizeof(s));
+    if (ble_subscribed) {
+        ring_record(BLE_REC_STATUS, &s, sizeof(s));
+    }
+    ble_next_status = millis() + BLE_LINK_STATUS_MS;
+}
+
+// ===== Meshtastic phone API =====
+
+#if FEATURE_MESHTASTIC_ENABLED
+// Protobuf, just the wire types these few messages use
+static uint8_t *pb_varint(uint8_t *p, uint64_t v) {
+    while (v >= 0x80) {
+        *p++ = (uint8_t)v | 0x80;
+        v >>= 7;
+    }
+    *p++ = (uint8_t)v;
+    return p;
+}
+
+static uint8_t *pb_uint(uint8_t *p, uint8_t field, uint64_t v) {
+    p = pb_varint(p, field << 3);
+    return pb_varint(p, v);
+}
+
+static uint8_t *pb_fixed32(uint8_t *p, uint8_t field, uint32_t v) {
+    p = pb_varint(p, field << 3 | 5);
+    memcpy(p, &v, 4);
+    return p + 4;
+}
+
+static uint8_t *pb_bytes(uint8_t *p, uint8_t field, const void *data, size_t len) {
+    p = pb_varint(p, field << 3 | 2);
+    p = pb_varint(p, len);
+    memcpy(p, data, len);
+    return p + len;
+}
+
+struct PbField {
+    uint8_t field;
+    uint8_t wire;
+    uint64_t value;                 // Varint and fixed
+    const uint8_t *data;            // Length-delimited
+    size_t len;
+};
+
+static bool pb_read_varint(const uint8_t **p, const uint8_t *end, uint64_t *v) {
+    *v = 0;
+    for (int shift = 0; *p < end && shift < 64; shift += 7) {
+        uint8_t b = *(*p)++;
+        *v |= (uint64_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool pb_next(const uint8_t **p, const uint8_t *end, PbField *f) {
+    uint64_t key;
+    if (!pb_read_varint(p, end, &key)) {
+        return false;
+    }
+    f->field = key >> 3;
+    f->wire = key & 7;
+    f->value = 0;
+    switch (f->wire) {
+    case 0:
+        return pb_read_varint(p, end, &f->value);
+    case 1:
+    case 5: {
+        size_t n = f->wire == 1 ? 8 : 4;
+        if ((size_t)(end - *p) < n) {
+            return false;
+        }
+        memcpy(&f->value, *p, n);
+        *p += n;
+        return true;
+    }
+    case 2: {
+        uint64_t n;
+        if (!pb_read_varint(p, end, &n) || n > (uint64_t)(end - *p)) {
+            return false;
+        }
+        f->data = *p;
+        f->len = n;
+        *p += n;
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+static void mesh_push(const uint8_t *payload, size_t len) {
+    // FromRadio { id = 1, <payload> }
+    BleMeshFrame frame;
+    uint8_t *p = pb_uint(frame.data, 1, ++ble_mesh_id);
+    memcpy(p, payload, len);
+    frame.len = p + len - frame.data;
+    if (xQueueSend(ble_mesh_queue, &frame, 0) != pdTRUE) {
+        return;
+    }
+    stat_add(&ble_stats.mesh_packets, 1);
+    uint32_t num = ble_mesh_id;
+    ble_fromnum_chr->setValue((const uint8_t *)&num, sizeof(num));
+    ble_fromnum_chr->notify();
+}
+
+static void mesh_want_config(uint32_t id) {
+    uint8_t inner[96], outer[128];
+    char user_id[12], long_name[24], short_name[5];
+    snprintf(user_id, sizeof(user_id), "!%08lx", (unsigned long)ble_node);
+    snprintf(long_name, sizeof(long_name), "T-Deck-Pro %04lx", (unsigned long)(ble_node & 0xFFFF));
+    snprintf(short_name, sizeof(short_name), "%04lx", (unsigned long)(ble_node & 0xFFFF));
+
+    // my_info = 3 { my_node_num = 1 }
+    uint8_t *p = pb_uint(inner, 1, ble_node);
+    mesh_push(outer, pb_bytes(outer, 3, inner, p - inner) - outer);
+
+    // node_info = 4 { num = 1, user = 2 { id = 1, long_name = 2, short_name = 3 } }
+    uint8_t user[64];
+    uint8_t *u = pb_bytes(user, 1, user_id, strlen(user_id));
+    u = pb_bytes(u, 2, long_name, strlen(long_name));
+    u = pb_bytes(u, 3, short_name, strlen(short_name));
+    p = pb_uint(inner, 1, ble_node);
+    p = pb_bytes(p, 2, user, u - user);
+    mesh_push(outer, pb_bytes(outer, 4, inner, p - inner) - outer);
+
+    // config_complete_id = 7
+    mesh_push(outer, pb_uint(outer, 7, id) - outer);
+
+    ble_mesh_active = true;
+    ble_mesh_since = time(NULL);
+}
+
+static void mesh_text_in(const MsgStoreRecord *head, const char *text) {
+    uint8_t data[BLE_MESH_TEXT_MAX + 8], packet[BLE_MESH_TEXT_MAX + 48], frame[BLE_MESH_TEXT_MAX + 56];
+    size_t len = head->text_len < BLE_MESH_TEXT_MAX ? head->text_len : BLE_MESH_TEXT_MAX;
+
+    // packet = 2 { from = 1, to = 2, decoded = 4 { portnum = 1, payload = 2 }, id = 6, rx_time = 7, rx_rssi = 12 }
+    uint8_t *d = pb_uint(data, 1, 1);       // TEXT_MESSAGE_APP
+    d = pb_bytes(d, 2, text, len);
+    uint8_t *p = pb_fixed32(packet, 1, BLE_MESH_LORA_NODE);
+    p = pb_fixed32(p, 2, NET_PEER_BROADCAST);
+    p = pb_bytes(p, 4, data, d - data);
+    p = pb_fixed32(p, 6, head->crc);
+    p = pb_fixed32(p, 7, head->time);
+    p = pb_uint(p, 12, (uint64_t)(int64_t)head->rssi);
+    mesh_push(frame, pb_bytes(frame, 2, packet, p - packet) - frame);
+}
+
+static void send_text(uint32_t to, const uint8_t *text, size_t len);
+
+static void mesh_to_radio(const uint8_t *buf, size_t len) {
+    const uint8_t *p = buf, *end = buf + len;
+    PbField f;
+    while (p < end && pb_next(&p, end, &f)) {
+        if (f.field == 3 && f.wire == 0) {
+            mesh_want_config(f.value);
+        } else if (f.field == 1 && f.wire == 2) {
+            // MeshPacket: to = 2, decoded = 4 { portnum = 1, payload = 2 }
+            const uint8_t *q = f.data, *qend = f.data + f.len;
+            uint32_t to = NET_PEER_BROADCAST;
+            PbField g;
+            while (q < qend && pb_next(&q, qend, &g)) {
+                if (g.field == 2 && g.wire == 5) {
+                    to = g.value;
+                } else if (g.field == 4 && g.wire == 2) {
+                    const uint8_t *r = g.data, *rend = g.data + g.len;
+                    uint64_t port = 0;
+                    const uint8_t *payload = NULL;
+                    size_t payload_len = 0;
+                    PbField h;
+                    while (r < rend && pb_next(&r, rend, &h)) {
+                        if (h.field == 1 && h.wire == 0) {
+                            port = h.value;
+                        } else if (h.field == 2 && h.wire == 2) {
+                            payload = h.data;
+                            payload_len = h.len;
+                        }
+                    }
+                    if (port == 1 && payload) {
+                        send_text(to, payload, payload_len);
+                        stat_add(&ble_stats.mesh_packets, 1);
+                    }
+                }
+            }
+        }
+    }
+}
+#endif // FEATURE_MESHTASTIC_ENABLED
+
+// ===== Store sync =====
+
+struct ScanCtx {
+    uint16_t seg;
+    bool emit;                      // False while only finding the end
+    uint16_t next_off;              // Past the last record seen
+};
+
+static void scan_record(uint16_t seg, uint16_t off, const MsgStoreRecord *head,
+                        const char *body, void *ctx) {
+    ScanCtx *c = (ScanCtx *)ctx;
+    if (off < ble_cursor_off && seg == ble_cursor_seg) {
+        return;
+    }
+    if ((uint16_t)(off + 1) > c->next_off) {
+        c->next_off = off + 1;
+    }
+    if (!c->emit) {
+        return;
+    }
+    const char *text = body + head->peer_len;
+    if (ble_subscribed && head->time >= ble_sync_since) {
+        BleMessageRecord r = {head->time, head->channel, head->flags, head->rssi,
+                              head->peer_len, head->text_len};
+        if (ring_record(BLE_REC_MESSAGE, &r, sizeof(r), body, head->peer_len, text, head->text_len)) {
+            ble_sync_count++;
+            stat_add(&ble_stats.messages_sent, 1);
+        }
+    }
+#if FEATURE_MESHTASTIC_ENABLED
+    if (ble_mesh_active && head->channel == MSG_CHANNEL_LORA && !(head->flags & MSG_FLAG_OUT) &&
+        head->time >= ble_mesh_since) {
+        mesh_text_in(head, text);
+    }
+#endif
+}
+
+// One segment at the cursor; the store stays locked while it is read
+static void sync_step() {
+    uint16_t first, last;
+    if (!msg_store_segments(&first, &last)) {
+        ble_catching_up = false;
+        return;
+    }
+    if (!ble_cursor_valid) {
+        // Just connected: only what is stored from now on
+        ble_cursor_seg = last;
+        ble_cursor_off = 0;
+        ScanCtx c = {last, false, 0};
+        msg_store_scan_segment(last, scan_record, &c);
+        ble_cursor_off = c.next_off;
+        ble_cursor_valid = true;
+    }
+    if ((int16_t)(ble_cursor_seg - first) < 0) {
+        ble_cursor_seg = first;                 // Dropped meanwhile
+        ble_cursor_off = 0;
+    }
+    ScanCtx c = {ble_cursor_seg, true, ble_cursor_off};
+    msg_store_scan_segment(ble_cursor_seg, scan_record, &c);
+    if (ble_cursor_seg != last) {
+        ble_cursor_seg++;
+        ble_cursor_off = 0;
+        return;
+    }
+    ble_cursor_off = c.next_off;
+    ble_catching_up = false;
+    if (ble_sync_requested) {
+        BleSyncDone done = {ble_sync_count};
+        ring_record(BLE_REC_SYNC_DONE, &done, sizeof(done));
+        ble_sync_requested = false;
+        ble_sync_draining = true;
+    }
+}
+
+// ===== Commands =====
+
+static void send_text(uint32_t to, const uint8_t *text, size_t len) {
+    if (!net_manager_send(to, text, len)) {
+        LOG_WARN("BLE", "No transport took the message");
+        return;
+    }
+    msg_store_append(MSG_CHANNEL_LORA, "lora", (const char *)text, len, MSG_FLAG_OUT);
+}
+
+static void command(const BleCmd *cmd) {
+#if FEATURE_MESHTASTIC_ENABLED
+    if (cmd->mesh) {
+        mesh_to_radio(cmd->data, cmd->len);
+        return;
+    }
+#endif
+    if (cmd->len == 0) {
+        return;
+    }
+    switch (cmd->data[0]) {
+    case BLE_CMD_SYNC:
+        if (cmd->len >= 5) {
+            memcpy(&ble_sync_since, cmd->data + 1, 4);
+            uint16_t first, last;
+            if (msg_store_segments(&first, &last)) {
+                ble_cursor_seg = first;
+                ble_cursor_off = 0;
+                ble_cursor_valid = true;
+            }
+            ble_catching_up = true;
+            ble_sync_requested = true;
+            ble_sync_count = 0;
+            ble_sync_started = millis();
+        }
+        break;
+    case BLE_CMD_SEND:
+        if (cmd->len > 1) {
+            send_text(NET_PEER_BROADCAST, cmd->data + 1, cmd->len - 1);
+        }
+        break;
+    case BLE_CMD_STATUS:
+        status_push();
+        break;
+    }
+}
+
+// ===== GATT callbacks, on the host task =====
+
+// The store and the radio are only for a phone that paired with the passkey
+// and bonded; the ENC/AUTHEN properties make NimBLE refuse the rest too
+static bool peer_trusted(const ble_gap_conn_desc *desc) {
+    return desc->sec_state.encrypted && desc->sec_state.authenticated && desc->sec_state.bonded;
+}
+
+class BleServerCallbacks : public NimBLEServerCallbacks {
+    void onConnect(NimBLEServer *server, ble_gap_conn_desc *desc) override {
+        uint16_t conn = desc->conn_handle;
+        // The fastest the phone allows: 2M PHY, full-size LL packets, a short interval
+        ble_gap_set_prefered_le_phy(conn, BLE_GAP_LE_PHY_2M_MASK, BLE_GAP_LE_PHY_2M_MASK, BLE_GAP_LE_PHY_CODED_ANY);
+        server->setDataLen(conn, BLE_LINK_DATA_LEN);
+        server->updateConnParams(conn, 6, 12, 0, 400);
+        ble_conn = conn;
+        stat_add(&ble_stats.connections, 1);
+        // A bonded phone re-encrypts with its stored keys, a new one pairs
+        NimBLEDevice::startSecurity(conn);
+        xTaskNotify(ble_task_handle, BLE_EVT_KICK, eSetBits);
+    }
+
+    void onDisconnect(NimBLEServer *server, ble_gap_conn_desc *desc) override {
+        ble_conn = BLE_HS_CONN_HANDLE_NONE;
+        ble_subscribed = false;
+        ble_sub_wanted = false;
+        ble_mtu = 23;
+        xTaskNotify(ble_task_handle, BLE_EVT_KICK, eSetBits);
+    }
+
+    void onMTUChange(uint16_t mtu, ble_gap_conn_desc *desc) override {
+        ble_mtu = mtu > BLE_LINK_MTU ? BLE_LINK_MTU : mtu;
+    }
+
+    uint32_t onPassKeyRequest() override {
+        uint32_t key = ble_passkey ? ble_passkey : esp_random() % 1000000;
+        LOG_INFOF("BLE", "Pairing passkey %06lu", (unsigned long)key);
+        return key;
+    }
+
+    void onAuthenticationComplete(ble_gap_conn_desc *desc) override {
+        if (!peer_trusted(desc)) {
+            LOG_WARN("BLE", "Peer did not bond with the passkey, disconnecting");
+            stat_add(&ble_stats.rejected, 1);
+            ble_server->disconnect(desc->conn_handle);
+            return;
+        }
+        ble_subscribed = ble_sub_wanted;
+        xTaskNotify(ble_task_handle, BLE_EVT_KICK, eSetBits);
+    }
+};
+
+class BleDataCallbacks : public NimBLECharacteristicCallbacks {
+    void onSubscribe(NimBLECharacteristic *chr, ble_gap_conn_desc *desc, uint16_t sub) override {
+        // Before pairing finishes, onAuthenticationComplete() takes it up
+        ble_sub_wanted = sub & 1;
+        ble_subscribed = ble_sub_wanted && peer_trusted(desc);
+        uint8_t tx_phy = 0, rx_phy = 0;
+        if (ble_gap_read_le_phy(desc->conn_handle, &tx_phy, &rx_phy) == 0) {
+            ble_phy_2m = tx_phy == BLE_GAP_LE_PHY_2M;
+        }
+        xTaskNotify(ble_task_handle, BLE_EVT_KICK, eSetBits);
+    }
+};
+
+class BleCmdCallbacks : public NimBLECharacteristicCallbacks {
+public:
+    explicit BleCmdCallbacks(bool mesh) : mesh(mesh) {}
+
+    void onWrite(NimBLECharacteristic *chr, ble_gap_conn_desc *desc) override {
+        if (!peer_trusted(desc)) {
+            stat_add(&ble_stats.rejected, 1);
+            return;
+        }
+        BleCmd cmd;
+        auto value = chr->getValue();
+        cmd.mesh = mesh;
+        cmd.len = value.size() < sizeof(cmd.data) ? value.size() : sizeof(cmd.data);
+        memcpy(cmd.data, value.data(), cmd.len);
+        if (xQueueSend(ble_cmd_queue, &cmd, 0) == pdTRUE) {
+            xTaskNotify(ble_task_handle, BLE_EVT_CMD, eSetBits);
+        }
+    }
+
+private:
+    bool mesh;
+};
+
+#if FEATURE_MESHTASTIC_ENABLED
+class BleFromRadioCallbacks : public NimBLECharacteristicCallbacks {
+    void onRead(NimBLECharacteristic *chr, ble_gap_conn_desc *desc) override {
+        // One packet per read, empty once the app has them all
+        BleMeshFrame frame;
+        if (!peer_trusted(desc)) {
+            stat_add(&ble_stats.rejected, 1);
+            chr->setValue((const uint8_t *)"", 0);
+        } else if (xQueueReceive(ble_mesh_queue, &frame, 0) == pdTRUE) {
+            chr->setValue(frame.data, frame.len);
+        } else {
+            chr->setValue((const uint8_t *)"", 0);
+        }
+    }
+};
+#endif
+
+// ===== Task =====
+
+static void ble_task(void *param) {
+    BleCmd cmd;
+    bool was_connected = false;
+    while (1) {
+        bool live = ble_conn != BLE_HS_CONN_HANDLE_NONE && (ble_subscribed || ble_mesh_active);
+        bool busy = live && (ring_used() || ble_catching_up);
+        uint32_t bits = 0;
+        // Connected, the store's appended count is polled once a second
+        xTaskNotifyWait(0, UINT32_MAX, &bits, busy ? 0 : pdMS_TO_TICKS(live ? 1000 : BLE_LINK_STATUS_MS));
+
+        if (ble_conn == BLE_HS_CONN_HANDLE_NONE) {
+            if (was_connected) {
+                // The next phone starts from scratch
+                ble_ring_head = ble_ring_tail = 0;
+                ble_cursor_valid = ble_catching_up = ble_sync_requested = ble_sync_draining = false;
+                ble_mesh_active = false;
+                ble_sync_since = 0;
+                xQueueReset(ble_mesh_queue);
+                was_connected = false;
+            }
+            continue;
+        }
+        was_connected = true;
+
+        while (xQueueReceive(ble_cmd_queue, &cmd, 0) == pdTRUE) {
+            command(&cmd);
+        }
+        if ((int32_t)(millis() - ble_next_status) >= 0) {
+            status_push();
+        }
+        if (!ble_subscribed && !ble_mesh_active) {
+            continue;
+        }
+        // New messages are followed by the appended count
+        MsgStoreStats ms;
+        msg_store_get_stats(&ms);
+        if (ms.appended != ble_store_appended) {
+            ble_store_appended = ms.appended;
+            ble_catching_up = true;
+        }
+        if (ble_catching_up && ring_free() >= MSG_STORE_SEGMENT_SIZE) {
+            sync_step();
+        }
+        ring_pump();
+    }
+}
+
+// ===== API =====
+
+bool ble_link_begin() {
+    if (ble_task_handle) {
+        return true;
+    }
+    String name = "T-Deck-Pro";
+#ifdef INTEGRATION_LAYER_ENABLED
+    if (!GET_CONFIG_BOOL("ble", "enabled", false)) {
+        return false;
+    }
+    name = GET_CONFIG_STRING("ble", "name", name);
+    ble_passkey = (uint32_t)GET_CONFIG_INT("ble", "passkey", 0) % 1000000;
+#endif
+    ble_node = (uint32_t)(ESP.getEfuseMac() >> 16);     // As lora_crypt and espnow_link
+
+    ble_ring = (uint8_t *)heap_caps_malloc(BLE_LINK_RING_SIZE, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    ble_cmd_queue = xQueueCreate(BLE_LINK_CMD_DEPTH, sizeof(BleCmd));
+    ble_mesh_queue = xQueueCreate(BLE_MESH_DEPTH, sizeof(BleMeshFrame));
+    if (!ble_ring || !ble_cmd_queue || !ble_mesh_queue) {
+        LOG_ERROR("BLE", "Out of memory");
+        return false;
+    }
+    if (xTaskCreate(ble_task, "ble", BLE_LINK_TASK_STACK, NULL, BLE_LINK_TASK_PRIORITY,
+                    &ble_task_handle) != pdPASS) {
+        LOG_ERROR("BLE", "Failed to start the BLE task");
+        return false;
+    }
+
+    NimBLEDevice::init(name.c_str());
+    NimBLEDevice::setMTU(BLE_LINK_MTU);
+    // Bonding, MITM protection and LE Secure Connections; the phone types
+    // the passkey this side logs
+    NimBLEDevice::setSecurityAuth(true, true, true);
+    NimBLEDevice::setSecurityIOCap(BLE_HS_IO_DISPLAY_ONLY);
+    ble_server = NimBLEDevice::createServer();
+    ble_server->setCallbacks(new BleServerCallbacks());
+
+    NimBLEService *svc = ble_server->createService(BLE_LINK_SERVICE_UUID);
+    ble_data_chr = svc->createCharacteristic(BLE_LINK_DATA_UUID, NIMBLE_PROPERTY::NOTIFY |
+                                             NIMBLE_PROPERTY::READ_ENC | NIMBLE_PROPERTY::READ_AUTHEN);
+    ble_data_chr->setCallbacks(new BleDataCallbacks());
+    NimBLECharacteristic *cmd = svc->createCharacteristic(BLE_LINK_CMD_UUID,
+                                                          NIMBLE_PROPERTY::WRITE | NIMBLE_PROPERTY::WRITE_NR |
+                                                          NIMBLE_PROPERTY::WRITE_ENC | NIMBLE_PROPERTY::WRITE_AUTHEN);
+    cmd->setCallbacks(new BleCmdCallbacks(false));
+    ble_status_chr = svc->createCharacteristic(BLE_LINK_STATUS_UUID, NIMBLE_PROPERTY::READ |
+                                               NIMBLE_PROPERTY::READ_ENC | NIMBLE_PROPERTY::READ_AUTHEN);
+    svc->start();
+
+    NimBLEAdvertisementData adv, rsp;
+    adv.setFlags(BLE_HS_ADV_F_DISC_GEN | BLE_HS_ADV_F_BREDR_UNSUP);
+    rsp.setName(name.c_str());
+#if FEATURE_MESHTASTIC_ENABLED
+    NimBLEService *mesh = ble_server->createService(MESH_SERVICE_UUID);
+    NimBLECharacteristic *to_radio = mesh->createCharacteristic(MESH_TORADIO_UUID, NIMBLE_PROPERTY::WRITE |
+                                                                NIMBLE_PROPERTY::WRITE_ENC | NIMBLE_PROPERTY::WRITE_AUTHEN);
+    to_radio->setCallbacks(new BleCmdCallbacks(true));
+    NimBLECharacteristic *from_radio = mesh->createCharacteristic(MESH_FROMRADIO_UUID, NIMBLE_PROPERTY::READ |
+                                                                  NIMBLE_PROPERTY::READ_ENC | NIMBLE_PROPERTY::READ_AUTHEN);
+    from_radio->setCallbacks(new BleFromRadioCallbacks());
+    ble_fromnum_chr = mesh->createCharacteristic(MESH_FROMNUM_UUID,
+                                                 NIMBLE_PROPERTY::READ | NIMBLE_PROPERTY::NOTIFY |
+                                                 NIMBLE_PROPERTY::READ_ENC | NIMBLE_PROPERTY::READ_AUTHEN);
+    mesh->start();
+    // Meshtastic apps scan for their service; ours goes in the scan response
+    adv.setCompleteServices(NimBLEUUID(MESH_SERVICE_UUID));
+    rsp.setCompleteServices(NimBLEUUID(BLE_LINK_SERVICE_UUID));
+#else
+    adv.setCompleteServices(NimBLEUUID(BLE_LINK_SERVICE_UUID));
+#endif
+    NimBLEAdvertising *advertising = NimBLEDevice::getAdvertising();
+    advertising->setAdvertisementData(adv);
+    advertising->setScanResponseData(rsp);
+    advertising->start();
+
+    LOG_INFOF("BLE", "Advertising as %s", name.c_str());
+    return true;
+}
+
+bool ble_link_connected() {
+    return ble_conn != BLE_HS_CONN_HANDLE_NONE;
+}
+
+void ble_link_get_stats(BleLinkStats *out) {
+    portENTER_CRITICAL(&ble_mux);
+    *out = ble_stats;
+    portEXIT_CRITICAL(&ble_mux);
+    out->connected = ble_conn != BLE_HS_CONN_HANDLE_NONE;
+    out->phy_2m = ble_phy_2m;
+    out->mtu = ble_mtu;
+}
@@ -0,0 +1,137 @@
+/**
+ * @file      ble_link.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     BLE companion link: message store sync, GPS and status over NimBLE GATT
+ */
+
+#ifndef BLE_LINK_H
+#define BLE_LINK_H
+
+#include <Arduino.h>
+
+/**
+ * One phone at a time. The companion service has three characteristics:
+ *
+ *   DATA    notify   A byte stream of records (BleRecordHeader, then the
+ *                    body), cut into notifications of MTU - 3 bytes with
+ *                    no regard for record boundaries
+ *   CMD     write    A BleCommand byte, then its argument
+ *   STATUS  read     BleStatus, also streamed as a record every
+ *                    BLE_LINK_STATUS_MS while DATA is subscribed
+ *
+ * BLE_CMD_SYNC with a UTC time replays every stored message from then on,
+ * ends with a BLE_REC_SYNC_DONE record and then follows new messages as
+ * they are stored. Compaction rewrites old messages into new segments, so
+ * a phone can see a message twice and should key them on time, channel,
+ * peer and text.
+ *
+ * Throughput: on connect the link asks for 2M PHY, 251-byte data length
+ * and a 7.5-15 ms interval, and accepts an MTU up to BLE_LINK_MTU. Records
+ * go through a PSRAM ring big enough for a whole store segment, so the
+ * store is locked once per segment, and notifications are queued straight
+ * to the host until it runs out of buffers. A thousand short messages
+ * are about 80 KB, a few seconds on a phone that grants 2M PHY.
+ *
+ * With FEATURE_MESHTASTIC_ENABLED the Meshtastic phone API service is
+ * there as well: want_config gets this node's my_info and node_info, text
+ * packets from the app are sent as LoRa messages, and LoRa messages that
+ * arrive are handed to the app as text packets. Nothing else of that API
+ * (channels, radio config, position) is implemented.
+ *
+ * Every characteristic needs an encrypted, authenticated link. A phone
+ * pairs once with LE Secure Connections and a six-digit passkey that this
+ * side logs, then bonds; a peer that does not is disconnected, and its
+ * commands and reads are dropped until then.
+ *
+ * Config section "ble": enabled (false), name ("T-Deck-Pro"), passkey
+ * (0: a new random one for each pairing).
+ */
+
+#define BLE_LINK_SERVICE_UUID       "5e1d0001-7f3c-4b6e-9a52-3c8d0b7f2a10"
+#define BLE_LINK_DATA_UUID          "5e1d0002-7f3c-4b6e-9a52-3c8d0b7f2a10"
+#define BLE_LINK_CMD_UUID           "5e1d0003-7f3c-4b6e-9a52-3c8d0b7f2a10"
+#define BLE_LINK_STATUS_UUID        "5e1d0004-7f3c-4b6e-9a52-3c8d0b7f2a10"
+
+#define BLE_LINK_MTU                517     // ATT maximum
+#define BLE_LINK_DATA_LEN           251     // LL payload with data length extension
+#define BLE_LINK_RING_SIZE          (96 * 1024)     // PSRAM, more than one store segment
+#define BLE_LINK_CMD_MAX            256
+#define BLE_LINK_CMD_DEPTH          4
+#define BLE_LINK_STATUS_MS          10000
+#define BLE_LINK_TASK_STACK         (1024 * 4)
+#define BLE_LINK_TASK_PRIORITY      (tskIDLE_PRIORITY + 2)
+
+#define BLE_MESH_DEPTH              16      // FromRadio packets waiting for the app
+#define BLE_MESH_FRAME_MAX          256
+#define BLE_MESH_TEXT_MAX           200     // Meshtastic's payload limit, with headroom
+#define BLE_MESH_LORA_NODE          0x4C6F5261UL    // "LoRa": sender of plain LoRa messages
+
+enum BleRecordType {
+    BLE_REC_MESSAGE = 1,            // BleMessageRecord, peer, text
+    BLE_REC_SYNC_DONE,              // BleSyncDone
+    BLE_REC_STATUS,                 // BleStatus
+};
+
+enum BleCommand {
+    BLE_CMD_SYNC = 1,               // uint32_t since, UTC seconds
+    BLE_CMD_SEND,                   // Text, sent as a LoRa message
+    BLE_CMD_STATUS,                 // A status record now
+};
+
+struct BleRecordHeader {
+    uint8_t type;
+    uint16_t len;                   // Body
+} __attribute__((packed));
+
+struct BleMessageRecord {
+    uint32_t time;
+    uint8_t channel;                // MsgChannel
+    uint8_t flags;                  // MSG_FLAG_*
+    int8_t rssi;
+    uint8_t peer_len;
+    uint16_t text_len;
+} __attribute__((packed));
+
+struct BleSyncDone {
+    uint32_t messages;
+} __attribute__((packed));
+
+struct BleStatus {
+    uint32_t uptime_s;
+    uint16_t battery_mv;            // 0 without the fuel gauge
+    uint8_t battery_pct;
+    uint8_t gps_valid;
+    int32_t lat_e7;
+    int32_t lng_e7;
+    int32_t alt_cm;
+    uint8_t sats;
+    uint16_t fix_age_s;
+    uint32_t messages;              // In the store
+} __attribute__((packed));
+
+struct BleLinkStats {
+    bool connected;
+    bool phy_2m;
+    uint16_t mtu;
+    uint32_t connections;
+    uint32_t notifications;
+    uint32_t bytes_sent;
+    uint32_t stalls;                // Host out of buffers
+    uint32_t messages_sent;
+    uint32_t last_sync_messages;
+    uint32_t last_sync_ms;          // SYNC to the last byte handed to the host
+    uint32_t mesh_packets;          // Meshtastic FromRadio, either way
+    uint32_t rejected;              // Writes, reads and pairings from a peer that is not bonded
+};
+
+/**
+ * @brief Start NimBLE, the services and advertising
+ */
+bool ble_link_begin();
+bool ble_link_connected();
+void ble_link_get_stats(BleLinkStats *out);
+
+#endif // BLE_LINK_H
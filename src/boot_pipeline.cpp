@@ -0,0 +1,258 @@
+/**
+ * @file      boot_pipeline.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Staged boot: dependency-ordered init steps on worker tasks
+ */
+
+#include "boot_pipeline.h"
+#include "boot_trace.h"
+#include "simple_logger.h"
+#include "config/os_config.h"
+#ifdef INTEGRATION_LAYER_ENABLED
+#include "integration/config_manager.h"
+#endif
+
+static const BootStage* boot_stages = nullptr;
+static size_t boot_stage_count = 0;
+
+// A bit per step that has ended, set by the workers; the scheduler waits
+// on the semaphore for the next one. An event group would hold only 24
+static SemaphoreHandle_t boot_progress = nullptr;
+static portMUX_TYPE boot_mux = portMUX_INITIALIZER_UNLOCKED;
+static BootMask boot_done = 0;
+static BootMask boot_ok = 0;            // Steps that succeeded
+static BootMask boot_deferred = 0;      // For the background task, set before it starts
+static volatile bool boot_finished = false;
+
+static bool boot_splash_up = false;
+static uint32_t boot_splash_ms = 0;
+
+static BootMask boot_ok_mask() {
+    portENTER_CRITICAL(&boot_mux);
+    BootMask ok = boot_ok;
+    portEXIT_CRITICAL(&boot_mux);
+    return ok;
+}
+
+static BootMask boot_done_mask() {
+    portENTER_CRITICAL(&boot_mux);
+    BootMask done = boot_done;
+    portEXIT_CRITICAL(&boot_mux);
+    return done;
+}
+
+static bool boot_stage_enabled(const BootStage& stage) {
+    if (stage.flags & BOOT_STAGE_REQUIRED) {
+        return true;
+    }
+#ifdef INTEGRATION_LAYER_ENABLED
+    return GET_CONFIG_BOOL("boot", stage.name, true);
+#else
+    return true;
+#endif
+}
+
+static void boot_stage_ended(size_t i, bool ok) {
+    portENTER_CRITICAL(&boot_mux);
+    if (ok) {
+        boot_ok |= BOOT_AFTER(i);
+    }
+    boot_done |= BOOT_AFTER(i);
+    portEXIT_CRITICAL(&boot_mux);
+    xSemaphoreGive(boot_progress);
+}
+
+static void boot_stage_run(size_t i) {
+    const BootStage& stage = boot_stages[i];
+    uint32_t start = millis();
+
+    uint8_t span = boot_trace_begin(stage.name);
+    bool ok = stage.fn();
+    boot_trace_end(span);
+
+    if (!ok) {
+        if (stage.flags & BOOT_STAGE_REQUIRED) {
+            LOG_ERRORF("Boot", "%s failed after %lums", stage.name, millis() - start);
+        } else {
+            LOG_WARNF("Boot", "%s failed after %lums", stage.name, millis() - start);
+        }
+    }
+    boot_stage_ended(i, ok);
+}
+
+static void boot_stage_task(void* param) {
+    boot_stage_run((size_t)param);
+    vTaskDelete(NULL);
+}
+
+/**
+ * Runs the steps in pending, each as soon as everything it waits for has
+ * ended, at most BOOT_PIPELINE_WORKERS of them on workers at a time.
+ * Returns when all of them have ended.
+ */
+static void boot_run_set(BootMask pending) {
+    BootMask running = 0;
+
+    while (pending || running) {
+        BootMask done = boot_done_mask();
+        running &= ~done;
+        bool progressed = false;
+
+        for (size_t i = 0; i < boot_stage_count; i++) {
+            BootMask bit = BOOT_AFTER(i);
+            const BootStage& stage = boot_stages[i];
+            if (!(pending & bit) || (stage.after & ~done)) {
+                continue;
+            }
+
+            if ((stage.after & ~boot_ok_mask()) || !boot_stage_enabled(stage)) {
+                LOG_INFOF("Boot", "%s skipped", stage.name);
+                pending &= ~bit;
+                boot_stage_ended(i, false);
+                progressed = true;
+                continue;
+            }
+
+            if (stage.flags & BOOT_STAGE_MAIN) {
+                pending &= ~bit;
+                boot_stage_run(i);
+                progressed = true;
+                continue;
+            }
+
+            if (__builtin_popcountll(running) >= BOOT_PIPELINE_WORKERS) {
+                continue;
+            }
+            pending &= ~bit;
+            progressed = true;
+            if (xTaskCreate(boot_stage_task, stage.name, BOOT_PIPELINE_STAGE_STACK, (void*)i,
+                            BOOT_PIPELINE_PRIORITY, NULL) == pdPASS) {
+                running |= bit;
+            } else {
+                // Out of memory for a stack: the step still runs, just not alongside
+                boot_stage_run(i);
+            }
+        }
+
+        // Main-task steps may have unblocked others; otherwise wait for a
+        // worker. A give left over from a step already seen only costs a pass
+        if (!progressed && running) {
+            xSemaphoreTake(boot_progress, portMAX_DELAY);
+        } else if (!progressed) {
+            break;
+        }
+    }
+}
+
+static void boot_finish() {
+    boot_trace_finish();
+
+    // A previous boot that never finished shows where it hung
+    const BootTraceRecord* previous = boot_trace_record(true);
+    if (previous && !previous->finished_us) {
+        boot_trace_print(Serial, true);
+    }
+    boot_trace_print(Serial);
+
+    boot_finished = true;
+}
+
+static void boot_deferred_task(void* param) {
+    boot_run_set(boot_deferred);
+    LOG_INFOF("Boot", "Background steps done at %lums", millis());
+    boot_finish();
+    vTaskDelete(NULL);
+}
+
+bool boot_pipeline_run(const BootStage* stages, size_t count) {
+    if (count > BOOT_PIPELINE_MAX_STAGES) {
+        LOG_ERRORF("Boot", "%u steps, at most %u", (unsigned)count, (unsigned)BOOT_PIPELINE_MAX_STAGES);
+        return false;
+    }
+
+    BootMask foreground = 0;
+    BootMask deferred = 0;
+    for (size_t i = 0; i < count; i++) {
+        const BootStage& stage = stages[i];
+        bool is_deferred = stage.flags & BOOT_STAGE_DEFERRED;
+        // Waiting on a later step, or a foreground step on a deferred one, never ends
+        if ((stage.after >> i) || (!is_deferred && (stage.after & deferred)) ||
+            (is_deferred && (stage.flags & BOOT_STAGE_MAIN))) {
+            LOG_ERRORF("Boot", "Step %s has bad dependencies or flags", stage.name);
+            return false;
+        }
+        if (is_deferred) {
+            deferred |= BOOT_AFTER(i);
+        } else {
+            foreground |= BOOT_AFTER(i);
+        }
+    }
+
+    boot_progress = xSemaphoreCreateBinary();
+    if (!boot_progress) {
+        LOG_ERROR("Boot", "Failed to create semaphore");
+        return false;
+    }
+    boot_stages = stages;
+    boot_stage_count = count;
+    boot_deferred = deferred;
+
+    boot_run_set(foreground);
+
+    bool ok = true;
+    for (size_t i = 0; i < count; i++) {
+        if ((stages[i].flags & BOOT_STAGE_REQUIRED) && !(boot_ok_mask() & BOOT_AFTER(i))) {
+            ok = false;
+        }
+    }
+
+    uint32_t menu_ms = millis();
+    if (menu_ms > BOOT_MENU_BUDGET_MS) {
+        LOG_WARNF("Boot", "Menu up at %lums, budget %ums", menu_ms, (unsigned)BOOT_MENU_BUDGET_MS);
+    } else {
+        LOG_INFOF("Boot", "Menu up at %lums", menu_ms);
+    }
+
+    // A failed boot stops here; what ran is still in the trace
+    if (!ok || !deferred ||
+        xTaskCreate(boot_deferred_task, "boot_defer", 1024 * 4, NULL,
+                    BOOT_PIPELINE_PRIORITY, NULL) != pdPASS) {
+        if (ok && deferred) {
+            boot_run_set(deferred);
+        }
+        boot_finish();
+    }
+    return ok;
+}
+
+bool boot_pipeline_finished() {
+    return boot_finished;
+}
+
+bool boot_pipeline_succeeded(size_t stage) {
+    return stage < boot_stage_count && (boot_ok_mask() & BOOT_AFTER(stage));
+}
+
+void boot_pipeline_splash_shown() {
+    boot_splash_ms = millis();
+    boot_splash_up = true;
+}
+
+void boot_pipeline_splash_wait() {
+    if (!boot_splash_up) {
+        return;
+    }
+
+    int32_t hold = BOOT_SPLASH_DURATION;
+#ifdef INTEGRATION_LAYER_ENABLED
+    hold = GET_CONFIG_INT("boot", "splash_ms", hold);
+#endif
+    uint32_t shown = millis() - boot_splash_ms;
+    if (hold > 0 && shown < (uint32_t)hold) {
+        delay(hold - shown);
+    }
+    boot_splash_up = false;
+}
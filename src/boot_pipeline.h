@@ -0,0 +1,83 @@
+/**
+ * @file      boot_pipeline.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Staged boot: a table of init steps run by dependency, in parallel where independent
+ */
+
+#ifndef BOOT_PIPELINE_H
+#define BOOT_PIPELINE_H
+
+#include <Arduino.h>
+
+/**
+ * The entry point lists its init steps once, each with the steps it waits
+ * for. boot_pipeline_run() starts every step whose dependencies are done,
+ * on a worker task of its own unless it has to stay on the setup task,
+ * and returns when the foreground steps are through: the menu is up.
+ * Deferred steps (radios, network, services) carry on in the background
+ * and close the boot trace when the last one ends.
+ *
+ * Every step is a boot_trace span under its own name. A failed step skips
+ * the steps that wait for it; a failed required step fails the boot.
+ *
+ * Config section "boot": splash_ms (BOOT_SPLASH_DURATION), and one bool
+ * per step name to leave an optional step out, e.g. "mqtt": false.
+ */
+
+#define BOOT_PIPELINE_MAX_STAGES    64      // Bits of BootMask
+#define BOOT_PIPELINE_WORKERS       3       // Steps running at once besides the setup task
+#define BOOT_PIPELINE_STAGE_STACK   (1024 * 8)
+#define BOOT_PIPELINE_PRIORITY      (tskIDLE_PRIORITY + 2)
+#define BOOT_MENU_BUDGET_MS         1500    // Reset to menu; longer boots log a warning
+
+#define BOOT_AFTER(stage)           ((BootMask)1 << (stage))
+
+enum BootStageFlags {
+    BOOT_STAGE_REQUIRED = 1 << 0,   // Failure fails the boot
+    BOOT_STAGE_MAIN     = 1 << 1,   // Runs on the setup task (LVGL and other loop-owned state)
+    BOOT_STAGE_DEFERRED = 1 << 2,   // Runs after the menu is up, in the background
+};
+
+typedef uint64_t BootMask;         // A bit per step
+typedef bool (*BootStageFn)();
+
+struct BootStage {
+    const char* name;               // Trace span and config key
+    BootStageFn fn;
+    BootMask after;                 // BOOT_AFTER() of each step it waits for
+    uint8_t flags;
+};
+
+/**
+ * @brief Run the foreground steps, start the deferred ones. The table must
+ *        stay valid until boot_pipeline_finished(); dependencies point at
+ *        earlier entries. Deferred steps may not be BOOT_STAGE_MAIN
+ * @return false if a required step failed or was skipped
+ */
+bool boot_pipeline_run(const BootStage* stages, size_t count);
+
+/**
+ * @brief All steps, deferred ones included, have ended
+ */
+bool boot_pipeline_finished();
+
+/**
+ * @brief Whether a step ran and succeeded
+ */
+bool boot_pipeline_succeeded(size_t stage);
+
+/**
+ * @brief The splash is on the panel: its minimum time starts counting
+ */
+void boot_pipeline_splash_shown();
+
+/**
+ * @brief Block for what is left of the splash time. Returns at once when no
+ *        splash was shown, e.g. resuming from deep sleep
+ */
+void boot_pipeline_splash_wait();
+
+#endif // BOOT_PIPELINE_H
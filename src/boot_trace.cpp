@@ -0,0 +1,157 @@
+/**
+ * @file      boot_trace.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Boot timeline recorder implementation
+ */
+
+#include "boot_trace.h"
+#include <esp_timer.h>
+#include <esp_attr.h>
+
+// Survives resets other than power loss; the magic tells whether it holds data
+RTC_NOINIT_ATTR static BootTraceRecord rtc_current;
+RTC_NOINIT_ATTR static BootTraceRecord rtc_previous;
+
+static portMUX_TYPE trace_mux = portMUX_INITIALIZER_UNLOCKED;
+static bool trace_started = false;
+static bool trace_finished = false;
+
+static uint32_t now_us() {
+    // Never 0, which marks a running span
+    uint32_t t = (uint32_t)esp_timer_get_time();
+    return t ? t : 1;
+}
+
+// Called with trace_mux held, on the first span of this boot
+static void start_trace() {
+    bool had_previous = rtc_current.magic == BOOT_TRACE_MAGIC && rtc_current.span_count <= BOOT_TRACE_MAX_SPANS;
+    uint32_t boot_count = 0;
+    if (had_previous) {
+        rtc_previous = rtc_current;
+        boot_count = rtc_current.boot_count + 1;
+    } else {
+        rtc_previous.magic = 0;
+    }
+    
+    memset(&rtc_current, 0, sizeof(rtc_current));
+    rtc_current.magic = BOOT_TRACE_MAGIC;
+    rtc_current.boot_count = boot_count;
+    trace_started = true;
+}
+
+uint8_t boot_trace_begin(const char* name) {
+    uint32_t t = now_us();
+    uint8_t span = BOOT_TRACE_INVALID;
+    
+    portENTER_CRITICAL(&trace_mux);
+    if (!trace_started) {
+        start_trace();
+    }
+    if (!trace_finished) {
+        if (rtc_current.span_count < BOOT_TRACE_MAX_SPANS) {
+            span = rtc_current.span_count++;
+            BootSpan& s = rtc_current.spans[span];
+            strncpy(s.name, name, BOOT_TRACE_NAME_LEN - 1);
+            s.name[BOOT_TRACE_NAME_LEN - 1] = '\0';
+            s.start_us = t;
+            s.end_us = 0;
+        } else if (rtc_current.dropped < UINT8_MAX) {
+            rtc_current.dropped++;
+        }
+    }
+    portEXIT_CRITICAL(&trace_mux);
+    return span;
+}
+
+void boot_trace_end(uint8_t span) {
+    if (span >= BOOT_TRACE_MAX_SPANS) {
+        return;
+    }
+    uint32_t t = now_us();
+    portENTER_CRITICAL(&trace_mux);
+    if (span < rtc_current.span_count && rtc_current.spans[span].end_us == 0) {
+        rtc_current.spans[span].end_us = t;
+    }
+    portEXIT_CRITICAL(&trace_mux);
+}
+
+void boot_trace_finish() {
+    uint32_t t = now_us();
+    portENTER_CRITICAL(&trace_mux);
+    if (!trace_started) {
+        start_trace();
+    }
+    trace_finished = true;
+    rtc_current.finished_us = t;
+    portEXIT_CRITICAL(&trace_mux);
+}
+
+const BootTraceRecord* boot_trace_record(bool previous) {
+    const BootTraceRecord* record = previous ? &rtc_previous : &rtc_current;
+    return record->magic == BOOT_TRACE_MAGIC ? record : nullptr;
+}
+
+void boot_trace_print(Print& out, bool previous) {
+    const BootTraceRecord* record = boot_trace_record(previous);
+    if (!record || record->span_count == 0) {
+        out.println(previous ? "Boot trace: no previous boot recorded" : "Boot trace: empty");
+        return;
+    }
+    
+    // Timeline from the first span to the finish (or the latest end seen)
+    uint32_t origin = UINT32_MAX;
+    uint32_t last = record->finished_us;
+    for (uint8_t i = 0; i < record->span_count; i++) {
+        const BootSpan& s = record->spans[i];
+        origin = s.start_us < origin ? s.start_us : origin;
+        uint32_t end = s.end_us ? s.end_us : s.start_us;
+        last = end > last ? end : last;
+    }
+    uint32_t total = last > origin ? last - origin : 1;
+    
+    char line[BOOT_TRACE_NAME_LEN + 32 + BOOT_TRACE_CHART_WIDTH];
+    snprintf(line, sizeof(line), "Boot trace #%lu: %lu.%03lu ms, %u spans%s",
+             (unsigned long)record->boot_count, (unsigned long)(total / 1000), (unsigned long)(total % 1000),
+             record->span_count, record->finished_us ? "" : ", did not finish");
+    out.println(line);
+    if (record->dropped) {
+        snprintf(line, sizeof(line), "  (%u spans dropped, table full)", record->dropped);
+        out.println(line);
+    }
+    snprintf(line, sizeof(line), "  %-*s %9s %9s", BOOT_TRACE_NAME_LEN - 1, "step", "start ms", "took ms");
+    out.println(line);
+    
+    for (uint8_t i = 0; i < record->span_count; i++) {
+        const BootSpan& s = record->spans[i];
+        bool running = s.end_us == 0;
+        uint32_t start = s.start_us - origin;
+        uint32_t end = (running ? last : s.end_us) - origin;
+        
+        int col_start = (int)((uint64_t)start * BOOT_TRACE_CHART_WIDTH / total);
+        int col_end = (int)((uint64_t)end * BOOT_TRACE_CHART_WIDTH / total);
+        if (col_end <= col_start) {
+            col_end = col_start + 1;  // Keep short steps visible
+        }
+        if (col_end > BOOT_TRACE_CHART_WIDTH) {
+            col_end = BOOT_TRACE_CHART_WIDTH;
+            col_start = col_start < col_end ? col_start : col_end - 1;
+        }
+        
+        int n = snprintf(line, sizeof(line), "  %-*s %7lu.%lu %7lu.%lu |", BOOT_TRACE_NAME_LEN - 1, s.name,
+                         (unsigned long)(start / 1000), (unsigned long)(start % 1000 / 100),
+                         (unsigned long)((end - start) / 1000), (unsigned long)((end - start) % 1000 / 100));
+        int bar = n;
+        for (int c = 0; c < BOOT_TRACE_CHART_WIDTH && n < (int)sizeof(line) - 2; c++) {
+            line[n++] = c < col_start ? ' ' : (c < col_end ? '#' : ' ');
+        }
+        if (running && bar + col_end - 1 < n) {
+            line[bar + col_end - 1] = '>';
+        }
+        line[n++] = '|';
+        line[n] = '\0';
+        out.println(line);
+    }
+}
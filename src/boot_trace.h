@@ -0,0 +1,78 @@
+/**
+ * @file      boot_trace.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Boot timeline spans kept in RTC memory, printed as a Gantt chart
+ */
+
+#ifndef BOOT_TRACE_H
+#define BOOT_TRACE_H
+
+#include <Arduino.h>
+
+// One record for this boot and one for the previous, in RTC slow memory
+#define BOOT_TRACE_MAX_SPANS        40
+#define BOOT_TRACE_NAME_LEN         16    // Longer names are truncated
+#define BOOT_TRACE_MAGIC            0x42545243UL  // "BTRC"
+#define BOOT_TRACE_CHART_WIDTH      48    // Columns of the Gantt bar area
+#define BOOT_TRACE_INVALID          0xFF
+
+struct BootSpan {
+    char name[BOOT_TRACE_NAME_LEN];
+    uint32_t start_us;              // esp_timer_get_time()
+    uint32_t end_us;                // 0 while the step is running
+};
+
+struct BootTraceRecord {
+    uint32_t magic;
+    uint32_t boot_count;
+    uint32_t finished_us;           // boot_trace_finish(), 0 if the boot never got there
+    uint8_t span_count;
+    uint8_t dropped;                // Spans that found the table full
+    BootSpan spans[BOOT_TRACE_MAX_SPANS];
+};
+
+/**
+ * @brief Open a span, safe from any task. Returns BOOT_TRACE_INVALID when
+ *        the table is full or the trace is finished
+ */
+uint8_t boot_trace_begin(const char* name);
+void boot_trace_end(uint8_t span);
+
+/**
+ * @brief Close the boot: later spans are ignored and the record is final
+ */
+void boot_trace_finish();
+
+/**
+ * @brief This boot's record, or the previous boot's (nullptr if none survived)
+ */
+const BootTraceRecord* boot_trace_record(bool previous = false);
+
+/**
+ * @brief One line per span: name, start and duration in ms, then a bar
+ *        scaled to the whole boot. Unfinished spans end in '>'
+ */
+void boot_trace_print(Print& out, bool previous = false);
+
+/**
+ * @brief Span covering a C++ scope
+ */
+class BootTraceScope {
+private:
+    uint8_t span;
+
+public:
+    explicit BootTraceScope(const char* name) : span(boot_trace_begin(name)) {}
+    ~BootTraceScope() { boot_trace_end(span); }
+    BootTraceScope(const BootTraceScope&) = delete;
+    BootTraceScope& operator=(const BootTraceScope&) = delete;
+};
+
+#define BOOT_TRACE_CONCAT_(a, b) a##b
+#define BOOT_TRACE_CONCAT(a, b) BOOT_TRACE_CONCAT_(a, b)
+#define BOOT_TRACE_SCOPE(name) BootTraceScope BOOT_TRACE_CONCAT(boot_trace_scope_, __LINE__)(name)
+
+#endif // BOOT_TRACE_H
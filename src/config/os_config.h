@@ -58,13 +58,18 @@
 #define MAIN_LOOP_INTERVAL 100    // Main system loop interval (ms)
 #define HEARTBEAT_INTERVAL 30000  // System heartbeat interval (ms)
 #define DISPLAY_UPDATE_INTERVAL 1000  // Display refresh interval (ms)
-#define PLUGIN_SCAN_INTERVAL 5000     // Plugin scan interval (ms)
+
+// ===== PERIPHERAL STARTUP =====
+#define HW_LAZY_INIT 1                // Defer GPS/LoRa/4G/sensors/audio to first use
+#define HW_WARMUP_IDLE_MS 2000        // Idle time before each deferred init (0 = no warmup)
 
 // ===== MEMORY CONFIGURATION =====
 #define MAX_LOG_MESSAGES 100
 #define MAX_PLUGINS 10
 #define MAX_MQTT_MESSAGE_SIZE 512
-#define PLUGIN_STACK_SIZE 8192
+#define PLUGIN_STACK_SIZE 8192       // Per plugin, PSRAM; an image may ask for more
+#define PLUGIN_HEAP_SIZE 65536        // Default per-plugin arena, PSRAM
+#define PLUGIN_HEAP_MAX (512 * 1024)  // Largest arena an image may ask for
 
 // ===== NETWORK CONFIGURATION =====
 #define WIFI_CONNECT_TIMEOUT 30000  // WiFi connection timeout (ms)
@@ -76,6 +81,8 @@
 #define MQTT_TOPIC_STATUS "tdeckpro/%s/status"
 #define MQTT_TOPIC_LAUNCH "tdeckpro/%s/launch"
 #define MQTT_TOPIC_TELEMETRY "tdeckpro/%s/telemetry"
+#define MQTT_TOPIC_GATEWAY_UP "tdeckpro/%s/gateway/up"
+#define MQTT_TOPIC_GATEWAY_DOWN "tdeckpro/%s/gateway/down"
 
 // ===== APPLICATION CONFIGURATION =====
 #define APP_GRID_COLS 3
@@ -89,7 +96,7 @@
 #define SD_LOGS_PATH "/logs"
 
 // ===== BOOT CONFIGURATION =====
-#define BOOT_SPLASH_DURATION 2000   // Boot splash screen duration (ms)
+#define BOOT_SPLASH_DURATION 500    // Least time the splash stays up (ms), init runs under it
 #define BOOT_TIMEOUT 30000          // Maximum boot time (ms)
 #define EMERGENCY_MODE_ACTIVATION_TIME 5000 // Emergency mode activation time (ms)
 
@@ -108,7 +115,7 @@
 
 // ===== FEATURE FLAGS =====
 #define FEATURE_MQTT_ENABLED true
-#define FEATURE_WIREGUARD_ENABLED false  // WireGuard VPN support
+#define FEATURE_WIREGUARD_ENABLED true   // WireGuard VPN support
 #define FEATURE_MESHTASTIC_ENABLED true
 #define FEATURE_FILE_MANAGER_ENABLED true
 #define FEATURE_SETTINGS_ENABLED true
@@ -173,15 +180,4 @@ enum class SystemState {
     SHUTDOWN
 };
 
-// ===== BOOT STAGE ENUM =====
-enum class BootStage {
-    HARDWARE_INIT,
-    DISPLAY_INIT,
-    STORAGE_INIT,
-    NETWORK_INIT,
-    PLUGIN_SCAN,
-    LAUNCHER_START,
-    COMPLETE
-};
-
 #endif // OS_CONFIG_H
@@ -9,13 +9,26 @@
 
 #include "logger.h"
 #include "../drivers/hardware_manager.h"
+#include "../time_service.h"
+#include "../fs_lz4.h"
 #include <SD.h>
 #include <SPIFFS.h>
 #include <time.h>
+#include <unistd.h>
+#include <algorithm>
+
+static_assert((LOG_STAGING_SLOTS & (LOG_STAGING_SLOTS - 1)) == 0, "LOG_STAGING_SLOTS must be a power of two");
+static_assert((LOG_STAGING_RINGS & (LOG_STAGING_RINGS - 1)) == 0, "LOG_STAGING_RINGS must be a power of two");
 
 // Global logger instance
 Logger& Log = Logger::getInstance();
 
+// Component table, ID 0 is shared by names that did not fit
+char Logger::component_names[LOG_COMPONENT_MAX][LOG_COMPONENT_LEN] = { "other" };
+uint8_t Logger::component_levels[LOG_COMPONENT_MAX] = { 0 };
+uint8_t Logger::component_count = 1;
+std::mutex Logger::component_mutex;
+
 // === LOGGER MAIN CLASS ===
 
 Logger& Logger::getInstance() {
@@ -28,16 +41,30 @@ bool Logger::init() {
         return true;
     }
 
-    std::lock_guard<std::mutex> lock(log_mutex);
+    {
+        std::lock_guard<std::mutex> lock(log_mutex);
 
-    // Initialize default output handlers
-    initializeDefaultHandlers();
+        // Initialize default output handlers
+        initializeDefaultHandlers();
+        message_history.reserve(max_history_size);
 
-    // Initialize all enabled output handlers
-    for (auto& handler : output_handlers) {
-        if (handler) {
-            handler->init();
+        // Initialize all enabled output handlers
+        for (auto& handler : output_handlers) {
+            if (handler) {
+                handler->init();
+            }
         }
+
+        resetStaging();
+    }
+
+    // Without a drain task logv() writes the records out itself
+    drain_running = true;
+    TaskHandle_t task = nullptr;
+    if (xTaskCreate(drainTaskFn, "log_drain", LOG_DRAIN_STACK, this, LOG_DRAIN_PRIORITY, &task) == pdPASS) {
+        drain_task = task;
+    } else {
+        drain_running = false;
     }
 
     initialized = true;
@@ -53,9 +80,20 @@ void Logger::shutdown() {
         return;
     }
 
-    std::lock_guard<std::mutex> lock(log_mutex);
-
     info("Logger", "Shutting down logging system");
+
+    // Let the drain task finish its pass and exit
+    drain_running = false;
+    TaskHandle_t task = drain_task;
+    if (task) {
+        xTaskNotifyGive(task);
+        for (int wait = 0; wait < 50 && drain_task; wait++) {
+            vTaskDelay(pdMS_TO_TICKS(10));
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(log_mutex);
+    drainStaging();
     
     // Flush all handlers
     for (auto& handler : output_handlers) {
@@ -84,23 +122,178 @@ void Logger::logv(LogLevel level, const char* component, const char* format, va_
         return;
     }
 
-    std::lock_guard<std::mutex> lock(log_mutex);
+    stage(level, component, format, args);
+}
+
+void Logger::logFiltered(LogLevel level, const char* component, const char* format, ...) {
+    if (!initialized) {
+        return;
+    }
+
+    va_list args;
+    va_start(args, format);
+    stage(level, component, format, args);
+    va_end(args);
+}
+
+uint8_t Logger::internComponent(const char* component) {
+    if (!component || !component[0]) {
+        return 0;
+    }
+
+    std::lock_guard<std::mutex> lock(component_mutex);
+    for (uint8_t i = 1; i < component_count; i++) {
+        if (strncmp(component_names[i], component, LOG_COMPONENT_LEN - 1) == 0) {
+            return i;
+        }
+    }
+    if (component_count >= LOG_COMPONENT_MAX) {
+        return 0;
+    }
+
+    strncpy(component_names[component_count], component, LOG_COMPONENT_LEN - 1);
+    component_names[component_count][LOG_COMPONENT_LEN - 1] = 0;
+    return component_count++;
+}
+
+void Logger::setComponentLevel(const char* component, LogLevel level) {
+    component_levels[internComponent(component)] = (uint8_t)level + 1;
+}
+
+void Logger::clearComponentLevel(const char* component) {
+    component_levels[internComponent(component)] = 0;
+}
+
+void Logger::stage(LogLevel level, const char* component, const char* format, va_list args) {
+    // Claim a slot on this core's ring; a full ring drops the record rather than block
+    LogStagingRing& ring = staging[xPortGetCoreID() & (LOG_STAGING_RINGS - 1)];
+    uint32_t pos = ring.enqueue_pos.load(std::memory_order_relaxed);
+    LogRecord* record;
+    while (true) {
+        record = &ring.slots[pos & (LOG_STAGING_SLOTS - 1)];
+        int32_t diff = (int32_t)(record->sequence.load(std::memory_order_acquire) - pos);
+
+        if (diff == 0) {
+            if (ring.enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            staging_dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        } else {
+            pos = ring.enqueue_pos.load(std::memory_order_relaxed);
+        }
+    }
+
+    record->timestamp = millis();
+    record->level = level;
+    strncpy(record->component, component ? component : "", LOG_COMPONENT_LEN - 1);
+    record->component[LOG_COMPONENT_LEN - 1] = 0;
+    vsnprintf(record->text, sizeof(record->text), format, args);
+    record->sequence.store(pos + 1, std::memory_order_release);
+
+    // FATAL goes out before returning, in case it is the last thing we do;
+    // without a drain task everything does. The drain task itself may log
+    // from a handler, and those records wait for its next pass.
+    TaskHandle_t task = drain_task;
+    if (task == nullptr || level == LogLevel::FATAL) {
+        if (task != xTaskGetCurrentTaskHandle() && log_mutex.try_lock()) {
+            drainStaging();
+            if (level == LogLevel::FATAL) {
+                for (auto& handler : output_handlers) {
+                    if (handler) {
+                        handler->flush();
+                    }
+                }
+            }
+            log_mutex.unlock();
+            return;
+        }
+    }
+
+    // Warnings and errors are written promptly, the rest in timed batches
+    if (task && (level >= LogLevel::WARN ||
+                 ring.enqueue_pos.load(std::memory_order_relaxed) - ring.dequeue_pos >= LOG_STAGING_SLOTS / 2)) {
+        xTaskNotifyGive(task);
+    }
+}
+
+void Logger::resetStaging() {
+    for (LogStagingRing& ring : staging) {
+        for (uint32_t i = 0; i < LOG_STAGING_SLOTS; i++) {
+            ring.slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        ring.enqueue_pos.store(0, std::memory_order_relaxed);
+        ring.dequeue_pos = 0;
+    }
+    staging_dropped.store(0, std::memory_order_relaxed);
+}
+
+size_t Logger::drainStaging() {
+    size_t drained = 0;
+
+    while (true) {
+        // Merge the rings by timestamp so cross-core output stays in order
+        LogStagingRing* next = nullptr;
+        LogRecord* head = nullptr;
+        for (LogStagingRing& ring : staging) {
+            LogRecord& record = ring.slots[ring.dequeue_pos & (LOG_STAGING_SLOTS - 1)];
+            if ((int32_t)(record.sequence.load(std::memory_order_acquire) - (ring.dequeue_pos + 1)) < 0) {
+                continue;  // Empty, or the next producer has not finished formatting
+            }
+            if (!head || (int32_t)(record.timestamp - head->timestamp) < 0) {
+                next = &ring;
+                head = &record;
+            }
+        }
+        if (!head) {
+            break;
+        }
+
+        LogMessage message;
+        message.timestamp = head->timestamp;
+        message.level = head->level;
+        message.component = head->component;
+        message.message = head->text;
+
+        // Hand the slot back before the (slow) output handlers run
+        head->sequence.store(next->dequeue_pos + LOG_STAGING_SLOTS, std::memory_order_release);
+        next->dequeue_pos++;
+
+        dispatchMessage(message);
+        drained++;
+    }
+
+    return drained;
+}
+
+void Logger::drainTaskFn(void* param) {
+    Logger* logger = (Logger*)param;
+
+    while (logger->drain_running) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(LOG_DRAIN_INTERVAL_MS));
+
+        std::lock_guard<std::mutex> lock(logger->log_mutex);
+        logger->drainStaging();
+
+        uint32_t now = millis();
+        for (auto& handler : logger->output_handlers) {
+            if (handler) {
+                handler->poll(now);
+            }
+        }
+    }
 
-    // Create log message
-    LogMessage message;
-    message.timestamp = millis();
-    message.level = level;
-    message.component = String(component);
+    logger->drain_task = nullptr;
+    vTaskDelete(nullptr);
+}
 
-    // Format message
-    char buffer[512];
-    vsnprintf(buffer, sizeof(buffer), format, args);
-    message.message = String(buffer);
-    message.formatted_message = formatMessage(message);
+void Logger::dispatchMessage(LogMessage& message) {
+    formatMessage(message);
 
     // Update statistics
     stats.total_messages++;
-    switch (level) {
+    switch (message.level) {
         case LogLevel::DEBUG: stats.debug_count++; break;
         case LogLevel::INFO:  stats.info_count++; break;
         case LogLevel::WARN:  stats.warn_count++; break;
@@ -201,7 +394,9 @@ void Logger::flush() {
         return;
     }
 
+    // Staged records first, so a flush before sleep really empties everything
     std::lock_guard<std::mutex> lock(log_mutex);
+    drainStaging();
     
     for (auto& handler : output_handlers) {
         if (handler) {
@@ -213,24 +408,28 @@ void Logger::flush() {
 std::vector<LogMessage> Logger::getRecentMessages(size_t count) {
     std::lock_guard<std::mutex> lock(log_mutex);
     
-    if (count >= message_history.size()) {
-        return message_history;
-    }
+    size_t n = message_history.size();
+    count = std::min(count, n);
     
-    return std::vector<LogMessage>(
-        message_history.end() - count,
-        message_history.end()
-    );
+    std::vector<LogMessage> recent;
+    recent.reserve(count);
+    for (size_t i = n - count; i < n; i++) {
+        recent.push_back(message_history[(history_head + i) % n]);
+    }
+    return recent;
 }
 
 void Logger::clearHistory() {
     std::lock_guard<std::mutex> lock(log_mutex);
     message_history.clear();
+    history_head = 0;
 }
 
 Logger::LogStats Logger::getStatistics() {
     std::lock_guard<std::mutex> lock(log_mutex);
-    return stats;
+    LogStats result = stats;
+    result.dropped_messages += staging_dropped.load(std::memory_order_relaxed);
+    return result;
 }
 
 // === PRIVATE METHODS ===
@@ -245,22 +444,24 @@ void Logger::writeToOutputs(const LogMessage& message) {
     }
 }
 
-String Logger::formatMessage(const LogMessage& message) {
-    char timestamp_str[32];
+void Logger::formatMessage(LogMessage& message) {
+    // Stamped in millis at the call; UTC is worked out here, once the clock is set
+    char stamp[32];
+    if (time_valid() && time_format_iso(time_from_millis(message.timestamp), stamp, sizeof(stamp))) {
+        message.formatted_message.format("[%s] [%s] [%s] ", stamp, levelToString(message.level),
+                                         message.component.c_str());
+        message.formatted_message += message.message;
+        return;
+    }
     uint32_t seconds = message.timestamp / 1000;
     uint32_t milliseconds = message.timestamp % 1000;
     
-    snprintf(timestamp_str, sizeof(timestamp_str), "%lu.%03lu", seconds, milliseconds);
-    
-    String formatted = "[" + String(timestamp_str) + "] ";
-    formatted += "[" + levelToString(message.level) + "] ";
-    formatted += "[" + message.component + "] ";
-    formatted += message.message;
-    
-    return formatted;
+    message.formatted_message.format("[%lu.%03lu] [%s] [%s] ", (unsigned long)seconds, (unsigned long)milliseconds,
+                                     levelToString(message.level), message.component.c_str());
+    message.formatted_message += message.message;
 }
 
-String Logger::levelToString(LogLevel level) {
+const char* Logger::levelToString(LogLevel level) {
     switch (level) {
         case LogLevel::DEBUG: return "DEBUG";
         case LogLevel::INFO:  return "INFO ";
@@ -272,11 +473,12 @@ String Logger::levelToString(LogLevel level) {
 }
 
 void Logger::addToHistory(const LogMessage& message) {
-    message_history.push_back(message);
-    
-    // Limit history size
-    if (message_history.size() > max_history_size) {
-        message_history.erase(message_history.begin());
+    // Overwrite the oldest entry in place once full
+    if (message_history.size() < max_history_size) {
+        message_history.push_back(message);
+    } else if (max_history_size > 0) {
+        message_history[history_head] = message;
+        history_head = (history_head + 1) % max_history_size;
     }
 }
 
@@ -288,6 +490,7 @@ void Logger::initializeDefaultHandlers() {
     // Add SD handler if enabled
     if (output_enabled[(int)LogOutput::SD_CARD]) {
         auto sd_handler = std::make_unique<SDLogHandler>();
+        sd_handler->setCompression(SD_LOG_COMPRESS);
         output_handlers.push_back(std::move(sd_handler));
     }
 
@@ -325,7 +528,7 @@ bool SerialLogHandler::write(const LogMessage& message) {
         return false;
     }
 
-    Serial.println(message.formatted_message);
+    Serial.println(message.formatted_message.c_str());
     return true;
 }
 
@@ -346,7 +549,8 @@ SDLogHandler::SDLogHandler(const char* log_file_path)
 }
 
 SDLogHandler::~SDLogHandler() {
-    flush();
+    closeLogFile();
+    free(buffer);
 }
 
 bool SDLogHandler::init() {
@@ -365,43 +569,181 @@ bool SDLogHandler::init() {
         SD.mkdir(dir_path);
     }
 
+    if (!buffer) {
+        buffer = (uint8_t*)ps_malloc(SD_LOG_BUFFER_SIZE);
+        if (!buffer) {
+            buffer = (uint8_t*)malloc(SD_LOG_BUFFER_SIZE);
+        }
+        if (!buffer) {
+            return false;
+        }
+    }
+
+    if (!openLogFile()) {
+        return false;
+    }
+
+    last_flush = millis();
     initialized = true;
     return true;
 }
 
-bool SDLogHandler::write(const LogMessage& message) {
-    if (!initialized) {
-        return false;
+bool SDLogHandler::openLogFile() {
+    buffer_used = 0;
+    buffer_base = 0;
+
+    // A new frame every time: one left by a crash is readable as it is
+    if (compress) {
+        if (SD.exists(log_file_path + SD_LOG_LZ4_EXT)) {
+            rotateLogFiles();
+        }
+        lz4 = fs_lz4_open(SD, (log_file_path + SD_LOG_LZ4_EXT).c_str());
+        return lz4 != nullptr;
     }
 
-    // Check file size and rotate if necessary
+    // A file left at its reserved size was never closed (crash or power
+    // loss); its end is unknown, so retire it rather than append to it
+    size_t existing = 0;
     if (SD.exists(log_file_path)) {
         File file = SD.open(log_file_path, FILE_READ);
-        if (file && file.size() > max_file_size) {
-            file.close();
+        existing = file ? file.size() : 0;
+        file.close();
+        if (existing >= max_file_size) {
             rotateLogFiles();
-        } else if (file) {
-            file.close();
+            existing = 0;
         }
     }
 
-    // Write to log file
-    File file = SD.open(log_file_path, FILE_APPEND);
-    if (file) {
-        file.println(message.formatted_message);
-        file.close();
+    if (existing > 0) {
+        log_file = SD.open(log_file_path, "r+");
+        if (!log_file) {
+            return false;
+        }
+
+        // Resume on the sector holding the end, keeping its head in the buffer
+        buffer_base = existing - (existing % SD_LOG_SECTOR_SIZE);
+        log_file.seek(buffer_base);
+        buffer_used = log_file.read(buffer, existing - buffer_base);
+    } else {
+        log_file = SD.open(log_file_path, FILE_WRITE);
+        if (!log_file) {
+            return false;
+        }
+    }
+
+    // Extending with one byte at the end allocates the clusters in one go,
+    // contiguous while the card has the space; rotation never grows a file
+    log_file.seek(max_file_size - 1);
+    log_file.write((uint8_t)0);
+    log_file.flush();
+    return true;
+}
+
+void SDLogHandler::closeLogFile() {
+    if (lz4) {
+        fs_lz4_close(lz4);
+        lz4 = nullptr;
+        return;
+    }
+    if (!log_file) {
+        return;
+    }
+
+    flushBuffer();
+    size_t length = buffer_base + buffer_used;
+    log_file.close();
+
+    // Give the unused reservation back so readers see only records
+    String path = String(SD_LOG_MOUNT_POINT) + log_file_path;
+    truncate(path.c_str(), length);
+}
+
+bool SDLogHandler::write(const LogMessage& message) {
+    if (!initialized || (!log_file && !lz4)) {
+        return false;
+    }
+
+    size_t length = message.formatted_message.length();
+    if (length + 1 > SD_LOG_BUFFER_SIZE) {
+        length = SD_LOG_BUFFER_SIZE - 1;
+    }
+
+    if (compress) {
+        if (fs_lz4_size(lz4) + length + 1 > max_file_size) {
+            closeLogFile();
+            rotateLogFiles();
+            if (!openLogFile()) {
+                return false;
+            }
+        }
+        dirty = true;
+        return fs_lz4_write(lz4, message.formatted_message.c_str(), length) && fs_lz4_write(lz4, "\n", 1);
+    }
+
+    // Rotation happens between records, when a flush would cross the limit
+    if (buffer_base + buffer_used + length + 1 > max_file_size) {
+        closeLogFile();
+        rotateLogFiles();
+        if (!openLogFile()) {
+            return false;
+        }
+    }
+
+    if (buffer_used + length + 1 > SD_LOG_BUFFER_SIZE && !flushBuffer()) {
+        return false;
+    }
+
+    memcpy(buffer + buffer_used, message.formatted_message.c_str(), length);
+    buffer[buffer_used + length] = '\n';
+    buffer_used += length + 1;
+    dirty = true;
+
+    if (buffer_used == SD_LOG_BUFFER_SIZE) {
+        return flushBuffer();
+    }
+    return true;
+}
+
+bool SDLogHandler::flushBuffer() {
+    if (lz4 && dirty) {
+        fs_lz4_flush(lz4);
+        last_flush = millis();
+        flush_count++;
+        dirty = false;
+        return true;
+    }
+    if (!log_file || !dirty) {
         return true;
     }
 
-    return false;
+    // Every write starts on a sector; a partial last sector is written now
+    // and again, completed, by the next flush
+    log_file.seek(buffer_base);
+    bool ok = log_file.write(buffer, buffer_used) == buffer_used;
+    log_file.flush();
+    last_flush = millis();
+    flush_count++;
+    dirty = false;
+
+    size_t whole = buffer_used - (buffer_used % SD_LOG_SECTOR_SIZE);
+    memmove(buffer, buffer + whole, buffer_used - whole);
+    buffer_base += whole;
+    buffer_used -= whole;
+    return ok;
 }
 
 void SDLogHandler::flush() {
-    // SD card writes are synchronous, no buffering needed
+    flushBuffer();
+}
+
+void SDLogHandler::poll(uint32_t now) {
+    if (dirty && now - last_flush >= (lz4 ? SD_LOG_LZ4_FLUSH_MS : SD_LOG_FLUSH_INTERVAL_MS)) {
+        flushBuffer();
+    }
 }
 
 bool SDLogHandler::isAvailable() {
-    return initialized && SD.begin();
+    return initialized && (log_file || lz4);
 }
 
 void SDLogHandler::setMaxFileSize(size_t max_size) {
@@ -412,20 +754,36 @@ void SDLogHandler::setMaxFiles(uint8_t max_files) {
     this->max_files = max_files;
 }
 
+void SDLogHandler::setCompression(bool enabled) {
+    if (!initialized) {
+        compress = enabled;
+    }
+}
+
 void SDLogHandler::rotateLogFiles() {
+    if (compress) {
+        // system.log.lz4 -> system.log.1.lz4, its index alongside
+        rotateFiles(SD_LOG_LZ4_EXT);
+        rotateFiles(SD_LOG_LZ4_EXT FS_LZ4_INDEX_EXT);
+    } else {
+        rotateFiles("");
+    }
+}
+
+void SDLogHandler::rotateFiles(const String& ext) {
     // Rotate log files: system.log -> system.log.1 -> system.log.2 -> ... -> system.log.N
     String base_path = log_file_path;
 
     // Remove oldest file
-    String oldest_file = base_path + "." + String(max_files);
+    String oldest_file = base_path + "." + String(max_files) + ext;
     if (SD.exists(oldest_file)) {
         SD.remove(oldest_file);
     }
 
     // Rotate existing files
     for (int i = max_files - 1; i >= 1; i--) {
-        String old_file = base_path + "." + String(i);
-        String new_file = base_path + "." + String(i + 1);
+        String old_file = base_path + "." + String(i) + ext;
+        String new_file = base_path + "." + String(i + 1) + ext;
 
         if (SD.exists(old_file)) {
             SD.rename(old_file, new_file);
@@ -433,9 +791,9 @@ void SDLogHandler::rotateLogFiles() {
     }
 
     // Move current log to .1
-    if (SD.exists(base_path)) {
-        String backup_file = base_path + ".1";
-        SD.rename(base_path, backup_file);
+    if (SD.exists(base_path + ext)) {
+        String backup_file = base_path + ".1" + ext;
+        SD.rename(base_path + ext, backup_file);
     }
 }
 
@@ -460,7 +818,8 @@ bool MQTTLogHandler::write(const LogMessage& message) {
     }
 
     // Create topic based on log level
-    String topic = topic_prefix + "/" + message.component.c_str();
+    FixedString<LOG_COMPONENT_LEN + 32> topic;
+    topic.format("%s/%s", topic_prefix.c_str(), message.component.c_str());
     topic.toLowerCase();
 
     // For now, we'll just return true since MQTT client integration
@@ -502,7 +861,7 @@ bool DisplayLogHandler::write(const LogMessage& message) {
     }
 
     // Add to display buffer
-    display_buffer.push_back(message.formatted_message);
+    display_buffer.push_back(message.formatted_message.c_str());
 
     // Limit buffer size
     if (display_buffer.size() > max_lines) {
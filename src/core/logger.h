@@ -10,13 +10,49 @@
 #pragma once
 
 #include <Arduino.h>
+#include <FS.h>
 #include <vector>
 #include <functional>
 #include <memory>
 #include <mutex>
+#include <atomic>
+#include "fixed_string.h"
+
+// Levels below this are compiled out of the LOG_* macros, arguments and
+// strings included: 0 DEBUG, 1 INFO, 2 WARN, 3 ERROR, 4 FATAL
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL       0
+#endif
+
+// Per-component runtime thresholds, indexed by interned component ID
+#define LOG_COMPONENT_MAX       32      // ID 0 collects names past the table
+
+// Staging rings between logging tasks and the drain task, one per core
+#define LOG_STAGING_RINGS       2
+#define LOG_STAGING_SLOTS       16      // Per ring, power of two
+#define LOG_RECORD_TEXT         256     // Longer messages are truncated
+#define LOG_COMPONENT_LEN       24
+#define LOG_FORMATTED_SIZE      (LOG_RECORD_TEXT + LOG_COMPONENT_LEN + 32)  // Time, level and tags added
+#define LOG_DRAIN_INTERVAL_MS   50      // Batch period for records below WARN
+#define LOG_DRAIN_STACK         4096
+#define LOG_DRAIN_PRIORITY      1
+
+// SD writer: records collect in RAM and reach the card a sector multiple at a time
+#define SD_LOG_SECTOR_SIZE      512
+#define SD_LOG_BUFFER_SIZE      8192    // Sector multiple, 4-16 KB
+#define SD_LOG_FLUSH_INTERVAL_MS 5000   // Longest a record waits in the buffer
+#define SD_LOG_MOUNT_POINT      "/sd"   // SD.begin() default, for truncate()
+
+// Compressed, the log is an LZ4 frame at <path>.lz4 with its block index (fs_lz4.h)
+#ifndef SD_LOG_COMPRESS
+#define SD_LOG_COMPRESS         0
+#endif
+#define SD_LOG_LZ4_EXT          ".lz4"
+#define SD_LOG_LZ4_FLUSH_MS     30000   // Closes a block this often; a crash loses at most this much
 
 // Forward declarations
 class HardwareManager;
+struct FsLz4Stream;
 
 /**
  * @brief Log levels in order of severity
@@ -41,13 +77,36 @@ enum class LogOutput {
 
 /**
  * @brief Log message structure
+ * 
+ * Held inline so the drain task, the handlers and the history never touch
+ * the heap per message.
  */
 struct LogMessage {
     uint32_t timestamp;
     LogLevel level;
-    String component;
-    String message;
-    String formatted_message;
+    FixedString<LOG_COMPONENT_LEN> component;
+    FixedString<LOG_RECORD_TEXT> message;
+    FixedString<LOG_FORMATTED_SIZE> formatted_message;
+};
+
+/**
+ * @brief Staged log record, formatted by the caller and published to the drain task
+ */
+struct LogRecord {
+    std::atomic<uint32_t> sequence;     // Slot state, as in EventBridge's queue
+    uint32_t timestamp;
+    LogLevel level;
+    char component[LOG_COMPONENT_LEN];
+    char text[LOG_RECORD_TEXT];
+};
+
+/**
+ * @brief Multi-producer ring, single consumer (the drain task)
+ */
+struct LogStagingRing {
+    LogRecord slots[LOG_STAGING_SLOTS];
+    std::atomic<uint32_t> enqueue_pos;
+    uint32_t dequeue_pos;               // Drain side only, under log_mutex
 };
 
 /**
@@ -60,6 +119,7 @@ public:
     virtual bool write(const LogMessage& message) = 0;
     virtual void flush() = 0;
     virtual bool isAvailable() = 0;
+    virtual void poll(uint32_t now) {}  // Called on every drain pass, for timed flushes
 };
 
 /**
@@ -88,9 +148,12 @@ public:
     bool write(const LogMessage& message) override;
     void flush() override;
     bool isAvailable() override;
+    void poll(uint32_t now) override;
     
     void setMaxFileSize(size_t max_size);
     void setMaxFiles(uint8_t max_files);
+    void setCompression(bool enabled);  // Before init(); max_file_size then counts uncompressed bytes
+    uint32_t getFlushCount() const { return flush_count; }
 
 private:
     String log_file_path;
@@ -98,7 +161,25 @@ private:
     uint8_t max_files = 5; // Keep 5 log files
     bool initialized = false;
     
+    // The file stays open at its full size (clusters allocated up front) and
+    // is written in place; buffer[0] always maps to a sector boundary
+    File log_file;
+    uint8_t* buffer = nullptr;
+    size_t buffer_used = 0;
+    size_t buffer_base = 0;             // File offset of buffer[0]
+    uint32_t last_flush = 0;
+    uint32_t flush_count = 0;
+    bool dirty = false;                 // Buffer holds bytes the card has not seen
+
+    // Compressed: records go straight into the stream's blocks instead
+    bool compress = false;
+    FsLz4Stream* lz4 = nullptr;
+    
+    bool openLogFile();
+    void closeLogFile();
+    bool flushBuffer();
     void rotateLogFiles();
+    void rotateFiles(const String& ext);
     String getCurrentLogFileName();
 };
 
@@ -146,7 +227,9 @@ private:
 /**
  * @brief Main Logger Class
  * 
- * Thread-safe logging system with multiple output destinations
+ * Thread-safe logging system with multiple output destinations.
+ * Callers format into a lock-free staging ring for their core and return;
+ * a low-priority drain task writes the records to the output handlers.
  */
 class Logger {
 public:
@@ -184,6 +267,29 @@ public:
      */
     void logv(LogLevel level, const char* component, const char* format, va_list args);
 
+    /**
+     * @brief Log without a level check, for callers that already tested isEnabled()
+     * @param level Log level
+     * @param component Component name
+     * @param format Printf-style format string
+     * @param ... Format arguments
+     */
+    void logFiltered(LogLevel level, const char* component, const char* format, ...);
+
+    /**
+     * @brief Per-component filter
+     *
+     * Components are interned once per LOG_* call site; isEnabled() is then an
+     * array lookup against the component's threshold, or min_level if unset.
+     */
+    static uint8_t internComponent(const char* component);
+    void setComponentLevel(const char* component, LogLevel level);
+    void clearComponentLevel(const char* component);
+    bool isEnabled(LogLevel level, uint8_t component_id) const {
+        uint8_t threshold = component_levels[component_id < LOG_COMPONENT_MAX ? component_id : 0];
+        return level >= (threshold ? (LogLevel)(threshold - 1) : min_level);
+    }
+
     /**
      * @brief Convenience logging methods
      */
@@ -261,28 +367,46 @@ private:
     LogLevel min_level = LogLevel::INFO;
     bool initialized = false;
 
+    // Component table; a level of 0 follows min_level, otherwise level + 1
+    static char component_names[LOG_COMPONENT_MAX][LOG_COMPONENT_LEN];
+    static uint8_t component_levels[LOG_COMPONENT_MAX];
+    static uint8_t component_count;
+    static std::mutex component_mutex;
+
     // Output handlers
     std::vector<std::unique_ptr<LogOutputHandler>> output_handlers;
     bool output_enabled[4] = {true, false, false, false}; // Serial, SD, MQTT, Display
 
-    // Message history
+    // Message history, a ring reserved in init(); history_head is the oldest once full
     std::vector<LogMessage> message_history;
     size_t max_history_size = 100;
+    size_t history_head = 0;
 
     // Statistics
     LogStats stats;
 
-    // Thread safety
+    // Thread safety: log_mutex guards handlers, history and stats, never the staging rings
     std::mutex log_mutex;
 
+    // Staging and drain task
+    LogStagingRing staging[LOG_STAGING_RINGS];
+    std::atomic<uint32_t> staging_dropped{0};
+    TaskHandle_t volatile drain_task = nullptr;
+    volatile bool drain_running = false;
+
     // Hardware references
     HardwareManager* hardware_manager = nullptr;
     void* mqtt_client = nullptr;
 
     // Internal methods
+    void stage(LogLevel level, const char* component, const char* format, va_list args);
+    void resetStaging();
+    size_t drainStaging();
+    void dispatchMessage(LogMessage& message);
+    static void drainTaskFn(void* param);
     void writeToOutputs(const LogMessage& message);
-    String formatMessage(const LogMessage& message);
-    String levelToString(LogLevel level);
+    void formatMessage(LogMessage& message);
+    static const char* levelToString(LogLevel level);
     void addToHistory(const LogMessage& message);
     void initializeDefaultHandlers();
 };
@@ -290,17 +414,28 @@ private:
 // Global logger instance
 extern Logger& Log;
 
+// Compile-time level test, then the component threshold, then the call
+#define LOG_AT(level, component, ...) \
+    do { \
+        if (LOG_COMPILE_LEVEL <= (int)(level)) { \
+            static const uint8_t log_component = Logger::internComponent(component); \
+            if (Log.isEnabled(level, log_component)) { \
+                Log.logFiltered(level, component, __VA_ARGS__); \
+            } \
+        } \
+    } while(0)
+
 // Convenience macros
-#define LOG_DEBUG(component, ...) Log.debug(component, __VA_ARGS__)
-#define LOG_INFO(component, ...)  Log.info(component, __VA_ARGS__)
-#define LOG_WARN(component, ...)  Log.warn(component, __VA_ARGS__)
-#define LOG_ERROR(component, ...) Log.error(component, __VA_ARGS__)
-#define LOG_FATAL(component, ...) Log.fatal(component, __VA_ARGS__)
+#define LOG_DEBUG(component, ...) LOG_AT(LogLevel::DEBUG, component, __VA_ARGS__)
+#define LOG_INFO(component, ...)  LOG_AT(LogLevel::INFO, component, __VA_ARGS__)
+#define LOG_WARN(component, ...)  LOG_AT(LogLevel::WARN, component, __VA_ARGS__)
+#define LOG_ERROR(component, ...) LOG_AT(LogLevel::ERROR, component, __VA_ARGS__)
+#define LOG_FATAL(component, ...) LOG_AT(LogLevel::FATAL, component, __VA_ARGS__)
 
 // Conditional logging macros (only compile in debug builds)
 #ifdef DEBUG
 #define LOG_DEBUG_IF(condition, component, ...) \
-    do { if (condition) Log.debug(component, __VA_ARGS__); } while(0)
+    do { if (condition) LOG_DEBUG(component, __VA_ARGS__); } while(0)
 #else
 #define LOG_DEBUG_IF(condition, component, ...) do {} while(0)
 #endif
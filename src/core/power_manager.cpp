@@ -171,6 +171,11 @@ bool PowerManager::enterLightSleep(uint32_t duration_ms) {
         sleep_callback(SleepMode::LIGHT_SLEEP, duration_ms);
     }
 
+    // Buffered log records go to the card first; deep sleep would lose them
+    if (logger) {
+        logger->flush();
+    }
+
     // Enter light sleep
     uint32_t sleep_start = millis();
     esp_light_sleep_start();
@@ -208,6 +213,11 @@ bool PowerManager::enterDeepSleep(uint32_t duration_ms) {
         sleep_callback(SleepMode::DEEP_SLEEP, duration_ms);
     }
 
+    // Buffered log records go to the card first; deep sleep would lose them
+    if (logger) {
+        logger->flush();
+    }
+
     // Prepare for deep sleep
     if (hardware_manager) {
         // Shutdown non-essential hardware
@@ -238,6 +248,11 @@ bool PowerManager::enterHibernation(uint32_t duration_ms) {
         sleep_callback(SleepMode::HIBERNATION, duration_ms);
     }
 
+    // Buffered log records go to the card first; deep sleep would lose them
+    if (logger) {
+        logger->flush();
+    }
+
     // Disable all peripherals for maximum power saving
     esp_wifi_stop();
     esp_bt_controller_disable();
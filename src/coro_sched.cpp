@@ -0,0 +1,154 @@
+/**
+ * @file      coro_sched.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Stackless coroutine scheduler: one task per core, signal and deadline wake-ups
+ */
+
+#include "coro_sched.h"
+#include "simple_logger.h"
+
+struct CoroSched {
+    TaskHandle_t task;
+    Coro *head;
+};
+
+static CoroSched coro_scheds[portNUM_PROCESSORS];
+static portMUX_TYPE coro_mux = portMUX_INITIALIZER_UNLOCKED;
+
+void coro_arm(Coro *co, uint32_t mask, uint32_t ms) {
+    co->wait_mask = mask;
+    co->timed = ms != CORO_FOREVER;
+    co->deadline = millis() + ms;
+}
+
+static bool resume(CoroSched *s, Coro *co) {
+    uint32_t start = micros();
+    CoroStatus status = co->fn(co);
+    uint32_t us = micros() - start;
+    co->resumes++;
+    co->run_us += us;
+    if (us > co->run_us_max) {
+        co->run_us_max = us;
+    }
+    if (status != CORO_DONE) {
+        return true;
+    }
+    portENTER_CRITICAL(&coro_mux);
+    for (Coro **link = &s->head; *link; link = &(*link)->next) {
+        if (*link == co) {
+            *link = co->next;
+            break;
+        }
+    }
+    co->running = false;
+    portEXIT_CRITICAL(&coro_mux);
+    return false;
+}
+
+static void coro_sched_task(void *param) {
+    CoroSched *s = (CoroSched *)param;
+    while (1) {
+        uint32_t now = millis();
+        uint32_t wait = CORO_FOREVER;
+
+        portENTER_CRITICAL(&coro_mux);
+        Coro *co = s->head;
+        portEXIT_CRITICAL(&coro_mux);
+        while (co) {
+            portENTER_CRITICAL(&coro_mux);
+            Coro *next = co->next;          // Spawns go in at the head, never after co
+            portEXIT_CRITICAL(&coro_mux);
+
+            uint32_t raised = co->signals & co->wait_mask;
+            bool due = co->timed && (int32_t)(now - co->deadline) >= 0;
+            bool alive = true;
+            if (raised || due) {
+                __atomic_fetch_and(&co->signals, ~raised, __ATOMIC_SEQ_CST);
+                co->fired = raised;
+                alive = resume(s, co);
+                now = millis();
+            }
+            if (alive) {
+                if (co->signals & co->wait_mask) {
+                    wait = 0;
+                } else if (co->timed) {
+                    int32_t left = (int32_t)(co->deadline - now);
+                    left = left > 0 ? left : 0;
+                    wait = (uint32_t)left < wait ? left : wait;
+                }
+            }
+            co = next;
+        }
+        if (wait) {
+            xTaskNotifyWait(0, UINT32_MAX, NULL, wait == CORO_FOREVER ? portMAX_DELAY : pdMS_TO_TICKS(wait));
+        }
+    }
+}
+
+bool coro_spawn(Coro *co, const char *name, coro_fn fn, void *ctx, uint8_t core) {
+    if (co->running || core >= portNUM_PROCESSORS) {
+        return false;
+    }
+    CoroSched *s = &coro_scheds[core];
+    if (!s->task) {
+        char task_name[8];
+        snprintf(task_name, sizeof(task_name), "coro%u", core);
+        if (xTaskCreatePinnedToCore(coro_sched_task, task_name, CORO_SCHED_STACK, s, CORO_SCHED_PRIORITY,
+                                    &s->task, core) != pdPASS) {
+            LOG_ERROR("Coro", "Failed to start the scheduler task");
+            return false;
+        }
+    }
+    co->name = name;
+    co->fn = fn;
+    co->ctx = ctx;
+    co->line = 0;
+    co->signals = 0;
+    co->fired = 0;
+    co->core = core;
+    coro_arm(co, 0, 0);             // First run straight away
+
+    portENTER_CRITICAL(&coro_mux);
+    co->running = true;
+    co->next = s->head;
+    s->head = co;
+    portEXIT_CRITICAL(&coro_mux);
+    xTaskNotifyGive(s->task);
+    return true;
+}
+
+bool coro_running(const Coro *co) {
+    return co->running;
+}
+
+void coro_signal(Coro *co, uint32_t bits) {
+    __atomic_fetch_or(&co->signals, bits, __ATOMIC_SEQ_CST);
+    TaskHandle_t task = coro_scheds[co->core].task;
+    if (co->running && task) {
+        xTaskNotifyGive(task);
+    }
+}
+
+void IRAM_ATTR coro_signal_from_isr(Coro *co, uint32_t bits, BaseType_t *woken) {
+    __atomic_fetch_or(&co->signals, bits, __ATOMIC_SEQ_CST);
+    TaskHandle_t task = coro_scheds[co->core].task;
+    if (co->running && task) {
+        vTaskNotifyGiveFromISR(task, woken);
+    }
+}
+
+void coro_print(Print &out) {
+    out.printf("%-16s %4s %10s %10s %8s\n", "coroutine", "core", "resumes", "run_us", "max_us");
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        portENTER_CRITICAL(&coro_mux);
+        Coro *co = coro_scheds[core].head;
+        portEXIT_CRITICAL(&coro_mux);
+        for (; co; co = co->next) {
+            out.printf("%-16s %4u %10lu %10lu %8lu\n", co->name, co->core, (unsigned long)co->resumes,
+                       (unsigned long)co->run_us, (unsigned long)co->run_us_max);
+        }
+    }
+}
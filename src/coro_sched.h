@@ -0,0 +1,110 @@
+/**
+ * @file      coro_sched.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Stackless coroutines for low-rate services, one scheduler task per core
+ */
+
+#ifndef CORO_SCHED_H
+#define CORO_SCHED_H
+
+#include <Arduino.h>
+
+/**
+ * A service that spends its life waiting (for an interrupt, a fix, a
+ * timer) does not need a task and a stack of its own. As a coroutine it
+ * is a function that returns whenever it waits and is re-entered where it
+ * left off, Duff's device style, on the scheduler task of its core.
+ *
+ *   static CoroStatus blink(Coro *co) {
+ *       CORO_BEGIN(co);
+ *       while (running) {
+ *           CORO_AWAIT(co, SIG_WAKE, 500);       // Signal or 500 ms
+ *           if (CORO_TIMED_OUT(co)) { ... }
+ *       }
+ *       CORO_END(co);
+ *   }
+ *
+ * Locals do not survive a wait: state lives in statics or in ctx. A wait
+ * ends when one of its signal bits is raised (coro_signal() from a task,
+ * coro_signal_from_isr(), an I/O completion callback) or at its timeout;
+ * the scheduler sleeps until the earliest of those, so wake-ups are exact
+ * and nothing polls. Bits raised outside the wait mask stay pending for a
+ * later wait.
+ *
+ * The body runs on a shared task: it must not block for long. Short bus
+ * transactions and SD writes are fine; anything longer belongs in a task
+ * of its own. The scheduler task's stack is sized for the deepest body.
+ */
+
+#define CORO_SCHED_STACK            (1024 * 4)
+#define CORO_SCHED_PRIORITY         (tskIDLE_PRIORITY + 3)
+#define CORO_FOREVER                UINT32_MAX
+
+enum CoroStatus {
+    CORO_WAITING = 0,
+    CORO_DONE,
+};
+
+struct Coro;
+typedef CoroStatus (*coro_fn)(Coro *co);
+
+struct Coro {
+    const char *name;
+    coro_fn fn;
+    void *ctx;
+
+    // Scheduler state
+    uint32_t line;                  // Resume point, 0 at the start
+    uint32_t wait_mask;
+    uint32_t deadline;              // millis()
+    bool timed;
+    volatile uint32_t signals;      // Raised and not yet consumed
+    uint32_t fired;                 // Signals that ended the last wait, 0 on timeout
+    uint8_t core;
+    volatile bool running;
+    Coro *next;
+
+    uint32_t resumes;
+    uint32_t run_us;
+    uint32_t run_us_max;
+};
+
+#define CORO_BEGIN(co)      switch ((co)->line) { case 0:
+#define CORO_END(co)        } (co)->line = 0; return CORO_DONE
+
+// Until one of mask is raised or ms passes (CORO_FOREVER: no timeout)
+#define CORO_AWAIT(co, mask, ms)                                    \
+    do {                                                            \
+        coro_arm((co), (mask), (ms));                               \
+        (co)->line = __LINE__;                                      \
+        return CORO_WAITING;                                        \
+        case __LINE__:;                                             \
+    } while (0)
+
+#define CORO_SLEEP(co, ms)  CORO_AWAIT(co, 0, ms)
+#define CORO_YIELD(co)      CORO_AWAIT(co, 0, 0)
+#define CORO_TIMED_OUT(co)  ((co)->fired == 0)
+
+/**
+ * @brief Start co on the given core's scheduler, starting that if needed.
+ *        co must stay valid until it returns CORO_DONE
+ * @return false if co is already running or the scheduler failed to start
+ */
+bool coro_spawn(Coro *co, const char *name, coro_fn fn, void *ctx = NULL, uint8_t core = 0);
+bool coro_running(const Coro *co);
+
+/**
+ * @brief Raise signal bits; safe from any task
+ */
+void coro_signal(Coro *co, uint32_t bits);
+void coro_signal_from_isr(Coro *co, uint32_t bits, BaseType_t *woken);
+
+// For CORO_AWAIT
+void coro_arm(Coro *co, uint32_t mask, uint32_t ms);
+
+void coro_print(Print &out);
+
+#endif // CORO_SCHED_H
@@ -0,0 +1,368 @@
+/**
+ * @file      cpu_profiler.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Sampling CPU profiler: timer interrupts per core, task table and PC histogram
+ */
+
+#include "cpu_profiler.h"
+#include <freertos/xtensa_context.h>
+#include "simple_logger.h"
+#include "placement.h"
+#include "task_stack.h"
+#ifdef INTEGRATION_LAYER_ENABLED
+#include "integration/config_manager.h"
+#endif
+
+struct ProfTaskSlot {
+    TaskHandle_t handle;
+    char name[16];
+    uint32_t samples[2];
+};
+
+struct ProfPcSlot {
+    uint32_t pc;                    // 0 marks a free slot
+    uint32_t samples;
+};
+
+// Written by the timer interrupts on both cores, read under the same lock
+static portMUX_TYPE prof_mux = portMUX_INITIALIZER_UNLOCKED;
+static ProfTaskSlot prof_tasks[CPU_PROF_TASKS];
+static uint8_t prof_task_count = 0;
+static PLACE_BULK ProfPcSlot prof_pcs[CPU_PROF_PCS];
+static uint32_t prof_distinct = 0;
+static uint32_t prof_samples[2] = {0, 0};
+static uint32_t prof_dropped_tasks = 0;
+static uint32_t prof_dropped_pcs = 0;
+static uint32_t prof_since_ms = 0;
+
+static hw_timer_t *prof_timers[2] = {NULL, NULL};
+static bool prof_running = false;
+static uint32_t prof_rate_hz = CPU_PROF_RATE_HZ;
+static uint32_t prof_report_s = 0;
+static TaskHandle_t prof_report_task = NULL;
+
+static_assert((CPU_PROF_PCS & (CPU_PROF_PCS - 1)) == 0, "CPU_PROF_PCS must be a power of two");
+
+// The interrupt entry stored the interrupted task's stack pointer in its
+// TCB's first word, pxTopOfStack, and that points at the exception frame
+static void prof_sample(int core) {
+    TaskHandle_t task = xTaskGetCurrentTaskHandleForCPU(core);
+    if (!task) {
+        return;
+    }
+    const XtExcFrame *frame = *(const XtExcFrame *const *)task;
+    uint32_t pc = frame ? (uint32_t)frame->pc : 0;
+
+    portENTER_CRITICAL_ISR(&prof_mux);
+    prof_samples[core]++;
+
+    int t = 0;
+    while (t < prof_task_count && prof_tasks[t].handle != task) {
+        t++;
+    }
+    if (t == prof_task_count && t < CPU_PROF_TASKS) {
+        prof_tasks[t].handle = task;
+        strlcpy(prof_tasks[t].name, pcTaskGetName(task), sizeof(prof_tasks[t].name));
+        prof_tasks[t].samples[0] = 0;
+        prof_tasks[t].samples[1] = 0;
+        prof_task_count++;
+    }
+    if (t < CPU_PROF_TASKS) {
+        prof_tasks[t].samples[core]++;
+    } else {
+        prof_dropped_tasks++;
+    }
+
+    if (pc) {
+        uint32_t slot = (pc * 2654435761u) >> 16;
+        bool counted = false;
+        for (int i = 0; i < CPU_PROF_PROBE && !counted; i++, slot++) {
+            ProfPcSlot *s = &prof_pcs[slot & (CPU_PROF_PCS - 1)];
+            if (s->pc == pc) {
+                s->samples++;
+                counted = true;
+            } else if (s->pc == 0) {
+                s->pc = pc;
+                s->samples = 1;
+                prof_distinct++;
+                counted = true;
+            }
+        }
+        if (!counted) {
+            prof_dropped_pcs++;
+        }
+    }
+    portEXIT_CRITICAL_ISR(&prof_mux);
+}
+
+static void prof_isr_core0() {
+    prof_sample(0);
+}
+
+static void prof_isr_core1() {
+    prof_sample(1);
+}
+
+struct ProfCoreJob {
+    int core;
+    bool enable;
+    bool ok;
+    SemaphoreHandle_t done;
+};
+
+// An interrupt is allocated on, and must be freed from, the core that asks
+static void prof_core_job_fn(void *arg) {
+    ProfCoreJob *job = (ProfCoreJob *)arg;
+    hw_timer_t *&timer = prof_timers[job->core];
+
+    if (job->enable && !timer) {
+        timer = timerBegin(CPU_PROF_TIMER_BASE + job->core, 80, true);     // 1 MHz from the 80 MHz APB
+        if (timer) {
+            timerAttachInterrupt(timer, job->core ? prof_isr_core1 : prof_isr_core0, true);
+            timerAlarmWrite(timer, 1000000 / prof_rate_hz, true);
+            timerAlarmEnable(timer);
+        }
+    } else if (!job->enable && timer) {
+        timerAlarmDisable(timer);
+        timerDetachInterrupt(timer);
+        timerEnd(timer);
+        timer = NULL;
+    }
+    job->ok = (timer != NULL) == job->enable;
+    xSemaphoreGive(job->done);
+    vTaskDelete(NULL);
+}
+
+static bool prof_run_on_core(int core, bool enable) {
+    ProfCoreJob job = {core, enable, false, xSemaphoreCreateBinary()};
+    if (!job.done) {
+        return false;
+    }
+    if (xTaskCreatePinnedToCore(prof_core_job_fn, "cpu_prof_cfg", CPU_PROF_TASK_STACK, &job,
+                                configMAX_PRIORITIES - 1, NULL, core) != pdPASS) {
+        vSemaphoreDelete(job.done);
+        return false;
+    }
+    xSemaphoreTake(job.done, portMAX_DELAY);
+    vSemaphoreDelete(job.done);
+    return job.ok;
+}
+
+static void prof_report_fn(void *arg) {
+    while (prof_running && prof_report_s) {
+        if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(prof_report_s * 1000UL))) {
+            continue;               // Woken to re-read the period or stop
+        }
+        cpu_profiler_print(Serial);
+    }
+    prof_report_task = NULL;
+    task_exit();
+}
+
+static void prof_update_report_task() {
+    if (prof_report_task) {
+        xTaskNotifyGive(prof_report_task);
+    } else if (prof_running && prof_report_s) {
+        task_spawn(prof_report_fn, "cpu_prof", CPU_PROF_TASK_STACK, NULL, CPU_PROF_TASK_PRIORITY,
+                   &prof_report_task, tskNO_AFFINITY, TASK_STACK_PSRAM_OK);
+    }
+}
+
+bool cpu_profiler_set_enabled(bool enable) {
+    if (enable == prof_running) {
+        return true;
+    }
+    if (enable) {
+        cpu_profiler_reset();
+    }
+    bool ok = true;
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        ok = prof_run_on_core(core, enable) && ok;
+    }
+    if (enable && !ok) {
+        for (int core = 0; core < portNUM_PROCESSORS; core++) {
+            prof_run_on_core(core, false);
+        }
+        LOG_ERROR("CpuProf", "No hardware timer for the sampler");
+        return false;
+    }
+    prof_running = enable;
+    prof_update_report_task();
+    LOG_INFOF("CpuProf", "Sampling %s at %lu Hz per core", enable ? "started" : "stopped",
+              (unsigned long)prof_rate_hz);
+    return true;
+}
+
+#ifdef INTEGRATION_LAYER_ENABLED
+static void prof_config_changed(const ConfigChange *changes, size_t count, void *context) {
+    bool enable = prof_running;
+    uint32_t rate = prof_rate_hz;
+    for (size_t i = 0; i < count; i++) {
+        if (strcmp(changes[i].key, "enabled") == 0) {
+            enable = changes[i].value.asBoolean();
+        } else if (strcmp(changes[i].key, "rate_hz") == 0) {
+            rate = constrain(changes[i].value.asInteger(), 1, CPU_PROF_RATE_MAX_HZ);
+        } else if (strcmp(changes[i].key, "report_s") == 0) {
+            int32_t report_s = changes[i].value.asInteger();
+            prof_report_s = report_s > 0 ? report_s : 0;
+            prof_update_report_task();
+        }
+    }
+    // A new rate needs the timers set up again
+    if (rate != prof_rate_hz) {
+        cpu_profiler_set_enabled(false);
+        prof_rate_hz = rate;
+    }
+    cpu_profiler_set_enabled(enable);
+}
+#endif
+
+bool cpu_profiler_begin() {
+    bool enable = false;
+#ifdef INTEGRATION_LAYER_ENABLED
+    enable = GET_CONFIG_BOOL("profiler", "enabled", false);
+    prof_rate_hz = constrain(GET_CONFIG_INT("profiler", "rate_hz", CPU_PROF_RATE_HZ), 1, CPU_PROF_RATE_MAX_HZ);
+    int32_t report_s = GET_CONFIG_INT("profiler", "report_s", 0);
+    prof_report_s = report_s > 0 ? report_s : 0;
+    static bool watching = false;
+    if (GlobalConfigManager && !watching) {
+        watching = GlobalConfigManager->watch("profiler", "", prof_config_changed) != 0;
+    }
+#endif
+    return enable ? cpu_profiler_set_enabled(true) : true;
+}
+
+bool cpu_profiler_running() {
+    return prof_running;
+}
+
+void cpu_profiler_reset() {
+    portENTER_CRITICAL(&prof_mux);
+    memset(prof_tasks, 0, sizeof(prof_tasks));
+    memset(prof_pcs, 0, sizeof(prof_pcs));
+    prof_task_count = 0;
+    prof_distinct = 0;
+    prof_samples[0] = prof_samples[1] = 0;
+    prof_dropped_tasks = 0;
+    prof_dropped_pcs = 0;
+    prof_since_ms = millis();
+    portEXIT_CRITICAL(&prof_mux);
+}
+
+void cpu_profiler_stats(CpuProfStats *out) {
+    portENTER_CRITICAL(&prof_mux);
+    out->samples[0] = prof_samples[0];
+    out->samples[1] = prof_samples[1];
+    out->dropped_tasks = prof_dropped_tasks;
+    out->dropped_pcs = prof_dropped_pcs;
+    out->distinct_pcs = prof_distinct;
+    out->since_ms = prof_since_ms;
+    portEXIT_CRITICAL(&prof_mux);
+    out->running = prof_running;
+    out->rate_hz = prof_rate_hz;
+}
+
+// FreeRTOS's own accounting, matched to the sampled tasks by name
+static void prof_fill_runtime(CpuProfTask *tasks, size_t count) {
+#if configGENERATE_RUN_TIME_STATS
+    UBaseType_t n = uxTaskGetNumberOfTasks();
+    TaskStatus_t *status = (TaskStatus_t *)malloc(n * sizeof(TaskStatus_t));
+    if (!status) {
+        return;
+    }
+    uint32_t total = 0;
+    n = uxTaskGetSystemState(status, n, &total);
+    for (size_t t = 0; t < count && total; t++) {
+        for (UBaseType_t i = 0; i < n; i++) {
+            if (strncmp(tasks[t].name, status[i].pcTaskName, sizeof(tasks[t].name) - 1) == 0) {
+                tasks[t].runtime_permille = (uint32_t)((uint64_t)status[i].ulRunTimeCounter * 1000 / total);
+                break;
+            }
+        }
+    }
+    free(status);
+#endif
+}
+
+size_t cpu_profiler_tasks(CpuProfTask *out, size_t max) {
+    CpuProfTask all[CPU_PROF_TASKS];
+    size_t count = 0;
+    portENTER_CRITICAL(&prof_mux);
+    for (int t = 0; t < prof_task_count; t++) {
+        memcpy(all[t].name, prof_tasks[t].name, sizeof(all[t].name));
+        all[t].samples[0] = prof_tasks[t].samples[0];
+        all[t].samples[1] = prof_tasks[t].samples[1];
+        all[t].runtime_permille = 0;
+    }
+    count = prof_task_count;
+    portEXIT_CRITICAL(&prof_mux);
+
+    for (size_t i = 1; i < count; i++) {
+        CpuProfTask entry = all[i];
+        uint32_t total = entry.samples[0] + entry.samples[1];
+        size_t j = i;
+        while (j > 0 && all[j - 1].samples[0] + all[j - 1].samples[1] < total) {
+            all[j] = all[j - 1];
+            j--;
+        }
+        all[j] = entry;
+    }
+    count = count < max ? count : max;
+    memcpy(out, all, count * sizeof(CpuProfTask));
+    prof_fill_runtime(out, count);
+    return count;
+}
+
+size_t cpu_profiler_top_pcs(CpuProfPc *out, size_t max) {
+    size_t count = 0;
+    portENTER_CRITICAL(&prof_mux);
+    for (int i = 0; i < CPU_PROF_PCS; i++) {
+        const ProfPcSlot *s = &prof_pcs[i];
+        if (s->pc == 0 || (count == max && out[max - 1].samples >= s->samples)) {
+            continue;
+        }
+        size_t pos = count < max ? count++ : max - 1;
+        while (pos > 0 && out[pos - 1].samples < s->samples) {
+            out[pos] = out[pos - 1];
+            pos--;
+        }
+        out[pos].pc = s->pc;
+        out[pos].samples = s->samples;
+    }
+    portEXIT_CRITICAL(&prof_mux);
+    return count;
+}
+
+void cpu_profiler_print(Print &out) {
+    CpuProfStats stats;
+    cpu_profiler_stats(&stats);
+    out.printf("CPU_PROF rate_hz=%lu ms=%lu samples=%lu,%lu dropped_tasks=%lu dropped_pcs=%lu pcs=%lu\n",
+               (unsigned long)stats.rate_hz, (unsigned long)(millis() - stats.since_ms),
+               (unsigned long)stats.samples[0], (unsigned long)stats.samples[1],
+               (unsigned long)stats.dropped_tasks, (unsigned long)stats.dropped_pcs,
+               (unsigned long)stats.distinct_pcs);
+
+    CpuProfTask tasks[CPU_PROF_TASKS];
+    size_t count = cpu_profiler_tasks(tasks, CPU_PROF_TASKS);
+    for (size_t t = 0; t < count; t++) {
+        out.printf("CPU_TASK name=%s core0=%lu core1=%lu pct0=%.1f pct1=%.1f runtime_pm=%lu\n", tasks[t].name,
+                   (unsigned long)tasks[t].samples[0], (unsigned long)tasks[t].samples[1],
+                   stats.samples[0] ? tasks[t].samples[0] * 100.0f / stats.samples[0] : 0.0f,
+                   stats.samples[1] ? tasks[t].samples[1] * 100.0f / stats.samples[1] : 0.0f,
+                   (unsigned long)tasks[t].runtime_permille);
+    }
+
+    // Slot by slot, so the lock is never held across a serial write
+    for (int i = 0; i < CPU_PROF_PCS; i++) {
+        portENTER_CRITICAL(&prof_mux);
+        ProfPcSlot s = prof_pcs[i];
+        portEXIT_CRITICAL(&prof_mux);
+        if (s.pc) {
+            out.printf("CPU_PC pc=0x%08lx n=%lu\n", (unsigned long)s.pc, (unsigned long)s.samples);
+        }
+    }
+    out.printf("CPU_PROF_END\n");
+}
@@ -0,0 +1,93 @@
+/**
+ * @file      cpu_profiler.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Sampling CPU profiler: per-task and per-core load and a flat PC histogram
+ */
+
+#ifndef CPU_PROFILER_H
+#define CPU_PROFILER_H
+
+#include <Arduino.h>
+
+/**
+ * A hardware timer interrupt on each core records the task it interrupted
+ * and that task's PC, read from the exception frame the interrupt entry
+ * saved. Idle shows up as IDLE0/IDLE1, so the task table is the whole
+ * story of where each core's time goes. Time inside critical sections and
+ * other interrupts is charged to the code that runs right after them.
+ *
+ * The device has no symbol table, so PCs are exported raw and
+ * script/cpu_prof.py resolves them against firmware.elf into a flat
+ * profile by function. When the SDK is built with run-time stats, the
+ * FreeRTOS counters are printed next to the sampled shares.
+ *
+ * Config section "profiler": enabled (false), rate_hz, report_s (0, no
+ * periodic report). Changes apply at once, so field units can be switched
+ * on remotely and read from the diagnostics screen or the serial port.
+ */
+
+#define CPU_PROF_RATE_HZ            997     // Prime, so sampling does not lock to the 1 kHz tick
+#define CPU_PROF_RATE_MAX_HZ        10000
+#define CPU_PROF_TASKS              32      // Distinct tasks tracked, the rest count as dropped
+#define CPU_PROF_PCS                1024    // PC histogram slots, power of two
+#define CPU_PROF_PROBE              8       // Slots tried before a PC counts as dropped
+#define CPU_PROF_TIMER_BASE         0       // Hardware timers CPU_PROF_TIMER_BASE + core
+#define CPU_PROF_TASK_STACK         (1024 * 3)
+#define CPU_PROF_TASK_PRIORITY      (tskIDLE_PRIORITY + 1)
+
+struct CpuProfTask {
+    char name[16];
+    uint32_t samples[2];            // Per core
+    uint32_t runtime_permille;      // FreeRTOS run-time counter share, when built with it
+};
+
+struct CpuProfPc {
+    uint32_t pc;
+    uint32_t samples;
+};
+
+struct CpuProfStats {
+    bool running;
+    uint32_t rate_hz;
+    uint32_t samples[2];            // Per core
+    uint32_t dropped_tasks;         // Task table full
+    uint32_t dropped_pcs;           // Histogram probe run exhausted
+    uint32_t distinct_pcs;
+    uint32_t since_ms;
+};
+
+/**
+ * @brief Read the "profiler" section, watch it, and start sampling if enabled
+ */
+bool cpu_profiler_begin();
+
+/**
+ * @brief Start or stop the timers. Blocks briefly: each core's timer is set
+ *        up from a task pinned to it
+ */
+bool cpu_profiler_set_enabled(bool enable);
+bool cpu_profiler_running();
+void cpu_profiler_reset();
+
+void cpu_profiler_stats(CpuProfStats *out);
+
+/**
+ * @brief Tasks by total samples, most first
+ * @return Entries written
+ */
+size_t cpu_profiler_tasks(CpuProfTask *out, size_t max);
+
+/**
+ * @brief The max most sampled PCs, most first
+ */
+size_t cpu_profiler_top_pcs(CpuProfPc *out, size_t max);
+
+/**
+ * @brief Task table and the whole histogram as CPU_* lines for script/cpu_prof.py
+ */
+void cpu_profiler_print(Print &out);
+
+#endif // CPU_PROFILER_H
@@ -0,0 +1,440 @@
+/**
+ * @file      crash_dump.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Crash capture: RTC context, panic hook, streaming LZSS upload of context and core dump
+ */
+
+#include "crash_dump.h"
+#include "simple_logger.h"
+#include "timer_wheel.h"
+#include "job_pool.h"
+#include "metrics.h"
+#include "config/os_config.h"
+#include <esp_attr.h>
+#include <esp_system.h>
+#include <esp_timer.h>
+#include <esp_partition.h>
+#include <esp_ota_ops.h>
+#include <esp_rom_crc.h>
+#if FEATURE_MQTT_ENABLED
+#include "mqtt_client.h"
+#endif
+#ifdef CONFIG_ESP_COREDUMP_ENABLE_TO_FLASH
+#include <esp_core_dump.h>
+#endif
+#ifdef INTEGRATION_LAYER_ENABLED
+#include "integration/config_manager.h"
+#endif
+
+#define LZ_WINDOW       (1 << CRASH_LZ_WINDOW_BITS)
+#define LZ_LOOKAHEAD    (1 << CRASH_LZ_LOOKAHEAD_BITS)
+#define LZ_RING         2048        // Window, lookahead and one read
+#define LZ_READ         512
+#define LZ_HASH         256
+#define LZ_CHAIN        16          // Candidates tried per position
+#define LZ_MIN_MATCH    3
+
+static_assert(LZ_WINDOW + LZ_LOOKAHEAD + LZ_READ <= LZ_RING, "LZ ring too small");
+
+// Everything that outlives the crash; no CRC, the trace writes it all the time
+struct CrashContext {
+    uint32_t magic;
+    uint16_t size;
+    uint8_t panicked;               // The panic hook ran
+    uint8_t reserved;
+    uint32_t trace_next;            // Free running
+    CrashTraceEntry trace[CRASH_TRACE_EVENTS];
+    uint32_t counters[METRIC_COUNTER_COUNT];
+    int32_t gauges[METRIC_GAUGE_COUNT];
+};
+
+RTC_NOINIT_ATTR static CrashContext rtc_crash;
+
+static CrashContext saved;          // The previous crash, out of RTC memory
+static bool crashed = false;
+static uint8_t reset_reason = 0;
+static WheelTimer upload_timer;
+
+// ===== Flight recorder =====
+
+void IRAM_ATTR crash_trace(CrashTraceTag tag, uint32_t value) {
+    uint32_t i = __atomic_fetch_add(&rtc_crash.trace_next, 1, __ATOMIC_RELAXED) % CRASH_TRACE_EVENTS;
+    CrashTraceEntry *e = &rtc_crash.trace[i];
+    e->ms = (uint32_t)(esp_timer_get_time() / 1000);
+    e->tag = tag;
+    e->core = xPortGetCoreID();
+    e->value = value;
+}
+
+#ifdef CRASH_DUMP_PANIC_HOOK
+// Linked in with -Wl,--wrap=esp_panic_handler. Cache may be off: DRAM and
+// IRAM only, so plain loops rather than memcpy
+extern "C" void __real_esp_panic_handler(void *info);
+
+extern "C" void IRAM_ATTR __wrap_esp_panic_handler(void *info) {
+    for (int i = 0; i < METRIC_COUNTER_COUNT; i++) {
+        uint32_t sum = 0;
+        for (int core = 0; core < portNUM_PROCESSORS; core++) {
+            sum += metrics_counter_cells[core][i];
+        }
+        rtc_crash.counters[i] = sum;
+    }
+    for (int i = 0; i < METRIC_GAUGE_COUNT; i++) {
+        rtc_crash.gauges[i] = metrics_gauge_cells[i];
+    }
+    rtc_crash.panicked = 1;
+    __real_esp_panic_handler(info);
+}
+#endif
+
+// ===== Upload =====
+
+enum UploadPhase {
+    UPLOAD_IDLE = 0,
+    UPLOAD_HEADER,
+    UPLOAD_DATA,
+    UPLOAD_END,
+    UPLOAD_DONE,
+};
+
+// heatshrink-format LZSS encoder over context then core dump
+struct CrashDeflate {
+    uint8_t ring[LZ_RING];
+    int32_t prev[LZ_RING];          // Earlier position with the same hash
+    int32_t head[LZ_HASH];
+    uint32_t pos;                   // Next byte to encode
+    uint32_t fill;                  // Bytes read into the ring
+    uint8_t acc;                    // Bits waiting for a whole byte
+    uint8_t acc_bits;
+};
+
+struct CrashUpload {
+    uint8_t phase;                  // UploadPhase
+    bool started;
+    const esp_partition_t *part;
+    uint32_t core_offset;           // In the partition
+    uint32_t core_size;
+    uint32_t total;
+    uint32_t sent;
+    uint32_t crc;
+    CrashDeflate *lz;
+    Job job;
+};
+
+static CrashUpload up;
+
+static bool source_read(uint32_t from, uint8_t *dst, uint32_t len) {
+    while (len && from < sizeof(saved)) {
+        uint32_t n = sizeof(saved) - from < len ? sizeof(saved) - from : len;
+        memcpy(dst, (const uint8_t *)&saved + from, n);
+        from += n;
+        dst += n;
+        len -= n;
+    }
+    if (!len) {
+        return true;
+    }
+    return esp_partition_read(up.part, up.core_offset + from - sizeof(saved), dst, len) == ESP_OK;
+}
+
+// Keeps a full lookahead in the ring, reading a block at a time
+static bool lz_load() {
+    CrashDeflate *lz = up.lz;
+    while (lz->fill < up.total && lz->fill - lz->pos < LZ_LOOKAHEAD) {
+        uint32_t slot = lz->fill & (LZ_RING - 1);
+        uint32_t n = LZ_READ;
+        n = n < LZ_RING - slot ? n : LZ_RING - slot;
+        n = n < up.total - lz->fill ? n : up.total - lz->fill;
+        if (!source_read(lz->fill, lz->ring + slot, n)) {
+            return false;
+        }
+        lz->fill += n;
+    }
+    return true;
+}
+
+static inline uint8_t lz_at(uint32_t p) {
+    return up.lz->ring[p & (LZ_RING - 1)];
+}
+
+static inline uint32_t lz_hash(uint32_t p) {
+    return ((lz_at(p) << 5) ^ (lz_at(p + 1) << 2) ^ lz_at(p + 2)) & (LZ_HASH - 1);
+}
+
+static void lz_insert(uint32_t p) {
+    CrashDeflate *lz = up.lz;
+    if (p + LZ_MIN_MATCH > lz->fill) {
+        return;
+    }
+    uint32_t h = lz_hash(p);
+    lz->prev[p & (LZ_RING - 1)] = lz->head[h];
+    lz->head[h] = p;
+}
+
+// Longest match within the window; 0 if under LZ_MIN_MATCH
+static uint32_t lz_match(uint32_t *distance) {
+    CrashDeflate *lz = up.lz;
+    uint32_t avail = lz->fill - lz->pos;
+    uint32_t limit = avail < LZ_LOOKAHEAD ? avail : LZ_LOOKAHEAD;
+    if (limit < LZ_MIN_MATCH) {
+        return 0;
+    }
+    uint32_t best = 0;
+    int32_t cand = lz->head[lz_hash(lz->pos)];
+    for (int tries = 0; tries < LZ_CHAIN && cand >= 0; tries++) {
+        if ((uint32_t)cand >= lz->pos || lz->pos - cand > LZ_WINDOW) {
+            break;
+        }
+        uint32_t len = 0;
+        while (len < limit && lz_at(cand + len) == lz_at(lz->pos + len)) {
+            len++;
+        }
+        if (len > best) {
+            best = len;
+            *distance = lz->pos - cand;
+            if (len == limit) {
+                break;
+            }
+        }
+        int32_t next = lz->prev[cand & (LZ_RING - 1)];
+        if (next >= cand) {
+            break;
+        }
+        cand = next;
+    }
+    return best >= LZ_MIN_MATCH ? best : 0;
+}
+
+static size_t lz_bits(uint8_t *out, size_t len, uint32_t value, uint8_t count) {
+    CrashDeflate *lz = up.lz;
+    while (count--) {
+        lz->acc = (lz->acc << 1) | ((value >> count) & 1);
+        if (++lz->acc_bits == 8) {
+            out[len++] = lz->acc;
+            lz->acc = 0;
+            lz->acc_bits = 0;
+        }
+    }
+    return len;
+}
+
+// Encodes until out is nearly full or the input ends; the partial byte
+// carries over to the next message
+static size_t lz_run(uint8_t *out, size_t capacity, bool *eof) {
+    CrashDeflate *lz = up.lz;
+    size_t len = 0;
+    *eof = false;
+    // A symbol is at most 15 bits on top of 7 waiting
+    while (capacity - len >= 3) {
+        if (!lz_load()) {
+            break;
+        }
+        if (lz->pos >= up.total) {
+            if (lz->acc_bits) {
+                out[len++] = lz->acc << (8 - lz->acc_bits);
+                lz->acc_bits = 0;
+            }
+            *eof = true;
+            break;
+        }
+        uint32_t distance = 0;
+        uint32_t match = lz_match(&distance);
+        if (match) {
+            len = lz_bits(out, len, 0, 1);
+            len = lz_bits(out, len, distance - 1, CRASH_LZ_WINDOW_BITS);
+            len = lz_bits(out, len, match - 1, CRASH_LZ_LOOKAHEAD_BITS);
+        } else {
+            match = 1;
+            len = lz_bits(out, len, 1, 1);
+            len = lz_bits(out, len, lz_at(lz->pos), 8);
+        }
+        while (match--) {
+            lz_insert(lz->pos++);
+        }
+    }
+    return len;
+}
+
+static void put_le32(uint8_t *p, uint32_t v) {
+    p[0] = v;
+    p[1] = v >> 8;
+    p[2] = v >> 16;
+    p[3] = v >> 24;
+}
+
+static void erase_core_dump() {
+    if (up.part && esp_partition_erase_range(up.part, 0, up.part->size) != ESP_OK) {
+        LOG_WARN("Crash", "Core dump erase failed");
+    }
+}
+
+static void upload_finish() {
+    free(up.lz);
+    up.lz = NULL;
+    up.phase = UPLOAD_DONE;
+}
+
+#if FEATURE_MQTT_ENABLED
+// One message per run, on the job pool
+static void upload_step(Job *job) {
+    char topic[64];
+    snprintf(topic, sizeof(topic), CRASH_TOPIC, mqtt_device_id());
+    MqttBuffer *buf = mqtt_buffer_acquire(topic, 1);
+    if (!buf) {
+        return;
+    }
+    size_t capacity;
+    uint8_t *payload = mqtt_buffer_payload(buf, &capacity);
+
+    if (up.phase == UPLOAD_HEADER) {
+        CrashBundleHeader header = {};
+        header.magic = CRASH_MAGIC;
+        header.version = CRASH_VERSION;
+        header.reset_reason = reset_reason;
+        header.window_bits = CRASH_LZ_WINDOW_BITS;
+        header.lookahead_bits = CRASH_LZ_LOOKAHEAD_BITS;
+        header.context_size = sizeof(saved);
+        header.core_size = up.core_size;
+        memcpy(header.elf_sha256, esp_ota_get_app_description()->app_elf_sha256, sizeof(header.elf_sha256));
+        payload[0] = 'H';
+        memcpy(payload + 1, &header, sizeof(header));
+        if (mqtt_publish_buffer(buf, 1 + sizeof(header))) {
+            up.phase = UPLOAD_DATA;
+        }
+        return;
+    }
+
+    if (up.phase == UPLOAD_END) {
+        payload[0] = 'E';
+        put_le32(payload + 1, up.sent);
+        put_le32(payload + 5, up.crc);
+        if (mqtt_publish_buffer(buf, 9)) {
+            erase_core_dump();
+            LOG_INFOF("Crash", "Uploaded, %lu bytes compressed from %lu", (unsigned long)up.sent,
+                      (unsigned long)up.total);
+            upload_finish();
+        }
+        return;
+    }
+
+    // The encoder has moved on once bytes are out, so a refused publish
+    // cannot be retried: give up and keep the core dump for the next boot
+    bool eof;
+    size_t n = lz_run(payload + 5, capacity - 5, &eof);
+    if (!n && !eof) {
+        mqtt_buffer_release(buf);
+        LOG_WARN("Crash", "Core dump read failed");
+        upload_finish();
+        return;
+    }
+    payload[0] = 'D';
+    put_le32(payload + 1, up.sent);
+    if (!mqtt_publish_buffer(buf, 5 + n)) {
+        LOG_WARN("Crash", "Publish refused, upload abandoned");
+        upload_finish();
+        return;
+    }
+    up.crc = esp_rom_crc32_le(up.crc, payload + 5, n);
+    up.sent += n;
+    if (eof) {
+        up.phase = UPLOAD_END;
+    }
+}
+#endif
+
+// Everything slow happens here, CRASH_UPLOAD_DELAY_MS after boot
+static bool upload_start() {
+    bool enabled = true;
+#ifdef INTEGRATION_LAYER_ENABLED
+    enabled = GET_CONFIG_BOOL("crash", "upload", true);
+#endif
+#ifdef CONFIG_ESP_COREDUMP_ENABLE_TO_FLASH
+    size_t addr = 0;
+    size_t size = 0;
+    if (esp_core_dump_image_get(&addr, &size) == ESP_OK && size) {
+        up.part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_COREDUMP, NULL);
+        if (up.part && addr >= up.part->address && addr + size <= up.part->address + up.part->size) {
+            up.core_offset = addr - up.part->address;
+            up.core_size = size;
+        }
+    }
+#endif
+    if (!crashed && !up.core_size) {
+        return false;
+    }
+    LOG_WARNF("Crash", "Last reset %d, context %s, core dump %lu bytes", reset_reason,
+              crashed ? "kept" : "lost", (unsigned long)up.core_size);
+#if FEATURE_MQTT_ENABLED
+    if (!enabled) {
+        return false;
+    }
+    up.lz = (CrashDeflate *)malloc(sizeof(CrashDeflate));
+    if (!up.lz) {
+        LOG_WARN("Crash", "No memory for the upload");
+        return false;
+    }
+    memset(up.lz, 0, sizeof(CrashDeflate));
+    memset(up.lz->head, 0xff, sizeof(up.lz->head));
+    up.total = sizeof(saved) + up.core_size;
+    up.phase = UPLOAD_HEADER;
+    return true;
+#else
+    (void)enabled;
+    return false;
+#endif
+}
+
+static void upload_tick(WheelTimer *timer) {
+    if (!up.started) {
+        up.started = true;
+        if (!upload_start()) {
+            timer_wheel_cancel(timer);
+            return;
+        }
+    }
+    if (up.phase == UPLOAD_DONE) {
+        timer_wheel_cancel(timer);
+        return;
+    }
+#if FEATURE_MQTT_ENABLED
+    // A step in flight or no link: try again next tick
+    if (mqtt_connected() && up.job.state != JOB_QUEUED && up.job.state != JOB_RUNNING) {
+        job_submit(&up.job, upload_step, NULL, JOB_PRIO_LOW);
+    }
+#endif
+}
+
+// ===== API =====
+
+bool crash_dump_begin() {
+    esp_reset_reason_t reason = esp_reset_reason();
+    reset_reason = reason;
+    bool fault = reason == ESP_RST_PANIC || reason == ESP_RST_INT_WDT || reason == ESP_RST_TASK_WDT ||
+                 reason == ESP_RST_WDT;
+    crashed = fault && rtc_crash.magic == CRASH_MAGIC && rtc_crash.size == sizeof(CrashContext);
+    if (crashed) {
+        memcpy(&saved, &rtc_crash, sizeof(saved));
+    }
+
+    memset(&rtc_crash, 0, sizeof(rtc_crash));
+    rtc_crash.magic = CRASH_MAGIC;
+    rtc_crash.size = sizeof(CrashContext);
+    crash_trace(CRASH_TRACE_BOOT, reason);
+
+    // A core dump can be left from any earlier crash, so always look once
+    timer_wheel_init(&upload_timer, "crash", upload_tick);
+    timer_wheel_arm(&upload_timer, CRASH_UPLOAD_DELAY_MS, CRASH_UPLOAD_STEP_MS);
+    return crashed;
+}
+
+void crash_dump_status(CrashDumpStatus *out) {
+    out->crashed = crashed;
+    out->core_dump = up.core_size > 0 && up.phase != UPLOAD_DONE;
+    out->uploading = up.phase >= UPLOAD_HEADER && up.phase <= UPLOAD_END;
+    out->sent = up.sent;
+    out->consumed = up.lz ? up.lz->pos : 0;
+    out->total = up.total;
+}
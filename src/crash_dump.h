@@ -0,0 +1,95 @@
+/**
+ * @file      crash_dump.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Crash capture: RTC flight recorder, core dump pick-up and deferred compressed upload
+ */
+
+#ifndef CRASH_DUMP_H
+#define CRASH_DUMP_H
+
+#include <Arduino.h>
+
+/**
+ * On a panic or watchdog reset the SDK writes an ELF core dump to the
+ * coredump partition. Next to it this keeps a crash context in RTC
+ * memory, which survives the reset: the last CRASH_TRACE_EVENTS trace
+ * events (crash_trace(), fed by the EventBridge and the task watch), and,
+ * in builds with CRASH_DUMP_PANIC_HOOK, the raw metrics cells copied by
+ * the panic handler itself.
+ *
+ * crash_dump_begin() runs first thing in setup() and only copies the
+ * context out of RTC memory. The upload starts CRASH_UPLOAD_DELAY_MS
+ * later, as low-priority job pool steps paced by a wheel timer: each step
+ * compresses just enough of context and core dump (heatshrink-format
+ * LZSS, as the OTA patches) to fill one MQTT buffer and publishes it at
+ * QoS 1 on tdeckpro/<id>/crash, over whichever bearer the net manager
+ * has up, WiFi or 4G. The core dump is erased once the last message is
+ * queued. script/crash_unpack.py puts the messages back together into
+ * the raw core dump and a readable context.
+ *
+ * Messages start with a kind byte: 'H' then CrashBundleHeader, 'D' then
+ * the compressed stream offset (u32) and bytes, 'E' then the compressed
+ * length and its CRC-32 (u32 each). Config: crash.upload (true).
+ */
+
+#define CRASH_MAGIC                 0x52434454  // "TDCR"
+#define CRASH_VERSION               1
+#define CRASH_TRACE_EVENTS          32
+#define CRASH_UPLOAD_DELAY_MS       30000   // Well after boot has settled
+#define CRASH_UPLOAD_STEP_MS        250
+#define CRASH_TOPIC                 "tdeckpro/%s/crash"
+#define CRASH_LZ_WINDOW_BITS        10      // Same stream parameters as OTA patches
+#define CRASH_LZ_LOOKAHEAD_BITS     4
+
+enum CrashTraceTag {
+    CRASH_TRACE_BOOT = 0,           // value: reset reason
+    CRASH_TRACE_EVENT,              // value: EventType << 16 | source id
+    CRASH_TRACE_WATCH,              // value: task watch alert << 24 | value
+    CRASH_TRACE_USER,
+};
+
+struct CrashTraceEntry {
+    uint32_t ms;
+    uint16_t tag;                   // CrashTraceTag
+    uint8_t core;
+    uint8_t reserved;
+    uint32_t value;
+};
+
+struct CrashBundleHeader {
+    uint32_t magic;
+    uint8_t version;
+    uint8_t reset_reason;           // esp_reset_reason_t
+    uint8_t window_bits;
+    uint8_t lookahead_bits;
+    uint32_t context_size;          // Uncompressed, first in the stream
+    uint32_t core_size;             // Uncompressed, after the context
+    uint8_t elf_sha256[32];         // Running build; the core dump names the one that crashed
+};
+
+struct CrashDumpStatus {
+    bool crashed;                   // Last reset was a panic or watchdog with a context
+    bool core_dump;                 // An image is waiting in the partition
+    bool uploading;
+    uint32_t sent;                  // Compressed bytes published
+    uint32_t consumed;              // Uncompressed bytes read
+    uint32_t total;
+};
+
+/**
+ * @brief Pick up the previous crash, if any, and restart the trace. Call
+ *        before anything traces; cheap, no flash access
+ */
+bool crash_dump_begin();
+
+/**
+ * @brief Flight recorder entry; ISR and IRAM safe
+ */
+void crash_trace(CrashTraceTag tag, uint32_t value);
+
+void crash_dump_status(CrashDumpStatus *out);
+
+#endif // CRASH_DUMP_H
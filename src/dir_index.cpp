@@ -0,0 +1,649 @@
+/**
+ * @file      dir_index.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Directory index files: background rebuild, stale marking and paged reads
+ */
+
+#include "dir_index.h"
+#include "simple_logger.h"
+#include "sd_manager.h"
+#include "spi_bus.h"
+#include "job_pool.h"
+#include "usb_console.h"
+#include <SD.h>
+#include <esp_heap_caps.h>
+#include <esp_rom_crc.h>
+
+static_assert(sizeof(DirIndexHeader) == 40, "Header is part of the file format");
+static_assert(sizeof(DirIndexRecord) == 16, "Record is part of the file format");
+
+struct StaleSlot {
+    uint32_t crc;
+    uint32_t seq;                   // Touches since it went stale
+    bool used;
+};
+
+// One entry while building; the name points into the name pool
+struct BuildEntry {
+    DirIndexRecord rec;
+    const char *name;
+};
+
+static portMUX_TYPE idx_mux = portMUX_INITIALIZER_UNLOCKED;
+static StaleSlot stale_slots[DIR_INDEX_STALE_SLOTS];
+static uint8_t stale_next = 0;
+
+static char rebuild_queue[DIR_INDEX_QUEUE][DIR_INDEX_PATH_MAX];
+static uint8_t rebuild_queued = 0;
+static bool rebuild_active = false;
+static Job rebuild_jobs[2];         // The one finishing may still be marked running
+static volatile uint32_t rebuild_seq = 0;
+
+static DirIndexStats idx_stats;
+
+// ===== Paths =====
+
+// No trailing slash, "/" for the root
+static bool normalize(const char *path, char *out) {
+    size_t len = strlen(path);
+    while (len > 1 && path[len - 1] == '/') {
+        len--;
+    }
+    if (!len || path[0] != '/' || len >= DIR_INDEX_PATH_MAX) {
+        return false;
+    }
+    memcpy(out, path, len);
+    out[len] = '\0';
+    return true;
+}
+
+static bool parent_of(const char *path, char *out) {
+    if (!normalize(path, out)) {
+        return false;
+    }
+    char *slash = strrchr(out, '/');
+    if (slash == out) {
+        out[1] = '\0';
+    } else {
+        *slash = '\0';
+    }
+    return true;
+}
+
+static inline uint32_t path_crc(const char *dir) {
+    return esp_rom_crc32_le(0, (const uint8_t *)dir, strlen(dir));
+}
+
+static void index_file(uint32_t crc, const char *ext, char *out, size_t len) {
+    snprintf(out, len, DIR_INDEX_DIR "/%08lx.%s", (unsigned long)crc, ext);
+}
+
+// ===== Stale directories =====
+
+static StaleSlot *stale_find(uint32_t crc) {
+    for (int i = 0; i < DIR_INDEX_STALE_SLOTS; i++) {
+        if (stale_slots[i].used && stale_slots[i].crc == crc) {
+            return &stale_slots[i];
+        }
+    }
+    return NULL;
+}
+
+// Round robin; a directory pushed out is only marked again, which is harmless
+static void stale_add(uint32_t crc) {
+    StaleSlot *s = &stale_slots[stale_next];
+    stale_next = (stale_next + 1) % DIR_INDEX_STALE_SLOTS;
+    s->crc = crc;
+    s->seq = 1;
+    s->used = true;
+}
+
+static uint32_t stale_seq(uint32_t crc) {
+    portENTER_CRITICAL(&idx_mux);
+    StaleSlot *s = stale_find(crc);
+    uint32_t seq = s ? s->seq : 0;
+    portEXIT_CRITICAL(&idx_mux);
+    return seq;
+}
+
+// The stale byte, written in place; the caller holds the card
+static void mark_file_stale(uint32_t crc) {
+    char p[32];
+    index_file(crc, "idx", p, sizeof(p));
+    if (!SD.exists(p)) {
+        return;
+    }
+    File f = SD.open(p, "r+");
+    uint8_t one = 1;
+    if (f && f.seek(offsetof(DirIndexHeader, stale)) && f.write(&one, 1) == 1) {
+        idx_stats.touches++;
+    }
+}
+
+static void touch_dir(const char *dir) {
+    // The index files are written by the rebuild itself
+    if (!strcmp(dir, DIR_INDEX_DIR)) {
+        return;
+    }
+    uint32_t crc = path_crc(dir);
+    portENTER_CRITICAL(&idx_mux);
+    StaleSlot *s = stale_find(crc);
+    if (s) {
+        s->seq++;
+    } else {
+        stale_add(crc);
+    }
+    portEXIT_CRITICAL(&idx_mux);
+    if (!s) {
+        mark_file_stale(crc);
+    }
+}
+
+// ===== Reading =====
+
+static bool header_valid(const DirIndexHeader *h, uint32_t crc) {
+    return h->magic == DIR_INDEX_MAGIC && h->version == DIR_INDEX_VERSION && h->path_crc == crc &&
+           h->count <= DIR_INDEX_MAX && h->names_size <= DIR_INDEX_NAMES_MAX;
+}
+
+static bool read_header(File &f, uint32_t crc, DirIndexHeader *h) {
+    return f && f.read((uint8_t *)h, sizeof(*h)) == sizeof(*h) && header_valid(h, crc);
+}
+
+static bool same_index(const DirIndexHeader *a, const DirIndexHeader *b) {
+    return a->built == b->built && a->count == b->count && a->names_size == b->names_size;
+}
+
+static void fill_entry(DirIndexEntry *e, const DirIndexRecord *r, const char *name) {
+    size_t len = min((size_t)r->name_len, (size_t)DIR_INDEX_NAME_MAX - 1);
+    memcpy(e->name, name, len);
+    e->name[len] = '\0';
+    e->size = r->size;
+    e->mtime = r->mtime;
+    e->is_dir = r->flags & DIR_INDEX_FLAG_DIR;
+}
+
+// Name order reads the records and their names in one go each; the
+// other orders go through the permutation, a record at a time
+static bool load_page(DirIndexView *view, uint32_t first) {
+    uint32_t n = min((uint32_t)DIR_INDEX_PAGE, view->header.count - first);
+    char p[32];
+    index_file(view->path_crc, "idx", p, sizeof(p));
+
+    SpiBusHold bus(SPI_CLIENT_SD);
+    if (!sd_manager_mounted()) {
+        return false;
+    }
+    File f = SD.open(p, FILE_READ);
+    DirIndexHeader h;
+    // Swapped for a rebuild since the view opened: dir_index_poll reopens it
+    if (!read_header(f, view->path_crc, &h) || !same_index(&h, &view->header)) {
+        return false;
+    }
+
+    DirIndexRecord recs[DIR_INDEX_PAGE];
+    bool ok = true;
+    if (view->sort == DIR_INDEX_SORT_NAME) {
+        ok = f.seek(h.records + first * sizeof(DirIndexRecord)) &&
+             f.read((uint8_t *)recs, n * sizeof(DirIndexRecord)) == n * sizeof(DirIndexRecord);
+        uint32_t from = recs[0].name;
+        uint32_t to = recs[n - 1].name + recs[n - 1].name_len;
+        char *names = ok && to >= from && to <= h.names_size ? (char *)malloc(to - from + 1) : NULL;
+        ok = names && f.seek(h.names + from) && f.read((uint8_t *)names, to - from) == to - from;
+        for (uint32_t i = 0; ok && i < n; i++) {
+            fill_entry(&view->page[i], &recs[i], names + (recs[i].name - from));
+        }
+        free(names);
+    } else {
+        uint32_t order[DIR_INDEX_PAGE];
+        ok = f.seek(h.orders[view->sort - 1] + first * sizeof(uint32_t)) &&
+             f.read((uint8_t *)order, n * sizeof(uint32_t)) == n * sizeof(uint32_t);
+        char name[DIR_INDEX_NAME_MAX];
+        for (uint32_t i = 0; ok && i < n; i++) {
+            DirIndexRecord *r = &recs[i];
+            ok = order[i] < h.count && f.seek(h.records + order[i] * sizeof(DirIndexRecord)) &&
+                 f.read((uint8_t *)r, sizeof(*r)) == sizeof(*r);
+            size_t len = min((size_t)r->name_len, sizeof(name) - 1);
+            ok = ok && r->name + len <= h.names_size && f.seek(h.names + r->name) &&
+                 f.read((uint8_t *)name, len) == len;
+            if (ok) {
+                fill_entry(&view->page[i], r, name);
+            }
+        }
+    }
+    if (!ok) {
+        return false;
+    }
+    view->page_first = first;
+    view->page_count = n;
+    idx_stats.pages++;
+    return true;
+}
+
+// ===== Building =====
+
+static int cmp_name(const void *a, const void *b) {
+    const BuildEntry *x = (const BuildEntry *)a;
+    const BuildEntry *y = (const BuildEntry *)b;
+    bool xd = x->rec.flags & DIR_INDEX_FLAG_DIR;
+    bool yd = y->rec.flags & DIR_INDEX_FLAG_DIR;
+    if (xd != yd) {
+        return xd ? -1 : 1;
+    }
+    int r = strcasecmp(x->name, y->name);
+    return r ? r : strcmp(x->name, y->name);
+}
+
+// qsort has no context; only one build runs at a time
+static const BuildEntry *sort_entries;
+
+static int cmp_newest(const void *a, const void *b) {
+    uint32_t x = sort_entries[*(const uint32_t *)a].rec.mtime;
+    uint32_t y = sort_entries[*(const uint32_t *)b].rec.mtime;
+    return x != y ? (x > y ? -1 : 1) : (int)(*(const uint32_t *)a - *(const uint32_t *)b);
+}
+
+static int cmp_largest(const void *a, const void *b) {
+    uint32_t x = sort_entries[*(const uint32_t *)a].rec.size;
+    uint32_t y = sort_entries[*(const uint32_t *)b].rec.size;
+    return x != y ? (x > y ? -1 : 1) : (int)(*(const uint32_t *)a - *(const uint32_t *)b);
+}
+
+// Walks the directory a batch at a time so other SD users get in between
+static bool walk(const char *path, BuildEntry *ents, char *pool, uint32_t *count, uint32_t *pool_used,
+                 bool *truncated) {
+    File dir;
+    {
+        SpiBusHold bus(SPI_CLIENT_SD);
+        if (!sd_manager_mounted()) {
+            return false;
+        }
+        dir = SD.open(path);
+        if (!dir || !dir.isDirectory()) {
+            return false;
+        }
+    }
+    bool root = !strcmp(path, "/");
+    bool done = false;
+    while (!done) {
+        SpiBusHold bus(SPI_CLIENT_SD);
+        if (!sd_manager_mounted()) {
+            return false;
+        }
+        for (int i = 0; i < DIR_INDEX_BATCH && !done; i++) {
+            File f = dir.openNextFile();
+            if (!f) {
+                done = true;
+                break;
+            }
+            const char *name = strrchr(f.name(), '/');
+            name = name ? name + 1 : f.name();
+            size_t len = strlen(name);
+            if (root && !strcmp(name, DIR_INDEX_DIR + 1)) {
+                continue;
+            }
+            if (*count >= DIR_INDEX_MAX || len > UINT8_MAX || *pool_used + len + 1 > DIR_INDEX_NAMES_MAX) {
+                *truncated = true;
+                done = true;
+                break;
+            }
+            BuildEntry *e = &ents[(*count)++];
+            memset(&e->rec, 0, sizeof(e->rec));
+            e->rec.flags = f.isDirectory() ? DIR_INDEX_FLAG_DIR : 0;
+            e->rec.size = e->rec.flags ? 0 : f.size();
+            e->rec.mtime = (uint32_t)f.getLastWrite();
+            e->rec.name_len = len;
+            e->name = pool + *pool_used;
+            memcpy(pool + *pool_used, name, len + 1);
+            *pool_used += len + 1;
+        }
+        if (done) {
+            dir.close();
+        }
+    }
+    return true;
+}
+
+static bool write_chunked(File &f, const void *data, size_t len) {
+    const uint8_t *p = (const uint8_t *)data;
+    while (len) {
+        size_t n = min(len, (size_t)4096);
+        SpiBusHold bus(SPI_CLIENT_SD);
+        if (f.write(p, n) != n) {
+            return false;
+        }
+        p += n;
+        len -= n;
+    }
+    return true;
+}
+
+static bool write_index(const char *tmp, DirIndexHeader *h, const BuildEntry *ents, uint32_t *const orders[],
+                        uint32_t n) {
+    File f;
+    {
+        SpiBusHold bus(SPI_CLIENT_SD);
+        if (!sd_manager_mounted()) {
+            return false;
+        }
+        SD.mkdir(DIR_INDEX_DIR);
+        f = SD.open(tmp, FILE_WRITE);
+    }
+    bool ok = f && write_chunked(f, h, sizeof(*h));
+    DirIndexRecord recs[DIR_INDEX_BATCH];
+    for (uint32_t i = 0; ok && i < n; i += DIR_INDEX_BATCH) {
+        uint32_t k = min((uint32_t)DIR_INDEX_BATCH, n - i);
+        for (uint32_t j = 0; j < k; j++) {
+            recs[j] = ents[i + j].rec;
+        }
+        ok = write_chunked(f, recs, k * sizeof(DirIndexRecord));
+    }
+    for (int s = 0; ok && s < DIR_INDEX_SORT_COUNT - 1; s++) {
+        ok = write_chunked(f, orders[s], n * sizeof(uint32_t));
+    }
+    // Names in name order, each without its NUL
+    for (uint32_t i = 0; ok && i < n; i++) {
+        SpiBusHold bus(SPI_CLIENT_SD);
+        ok = f.write((const uint8_t *)ents[i].name, ents[i].rec.name_len) == ents[i].rec.name_len;
+    }
+    SpiBusHold bus(SPI_CLIENT_SD);
+    if (f) {
+        f.close();
+    }
+    if (!ok) {
+        SD.remove(tmp);
+    }
+    return ok;
+}
+
+static bool build(const char *path) {
+    uint32_t start = millis();
+    uint32_t crc = path_crc(path);
+    uint32_t seq = stale_seq(crc);
+
+    BuildEntry *ents = (BuildEntry *)heap_caps_malloc(DIR_INDEX_MAX * sizeof(BuildEntry),
+                                                      MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    char *pool = (char *)heap_caps_malloc(DIR_INDEX_NAMES_MAX, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    uint32_t *orders[DIR_INDEX_SORT_COUNT - 1] = {};
+    uint32_t n = 0;
+    uint32_t pool_used = 0;
+    bool truncated = false;
+    bool ok = ents && pool && walk(path, ents, pool, &n, &pool_used, &truncated);
+
+    if (ok) {
+        qsort(ents, n, sizeof(BuildEntry), cmp_name);
+        sort_entries = ents;
+        for (int s = 0; ok && s < DIR_INDEX_SORT_COUNT - 1; s++) {
+            orders[s] = (uint32_t *)heap_caps_malloc(max(n, 1U) * sizeof(uint32_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+            ok = orders[s] != NULL;
+            for (uint32_t i = 0; ok && i < n; i++) {
+                orders[s][i] = i;
+            }
+            if (ok) {
+                qsort(orders[s], n, sizeof(uint32_t), s + 1 == DIR_INDEX_SORT_NEWEST ? cmp_newest : cmp_largest);
+            }
+        }
+    }
+
+    DirIndexHeader h;
+    memset(&h, 0, sizeof(h));
+    if (ok) {
+        uint32_t names = 0;
+        for (uint32_t i = 0; i < n; i++) {
+            ents[i].rec.name = names;
+            names += ents[i].rec.name_len;
+        }
+        h.magic = DIR_INDEX_MAGIC;
+        h.version = DIR_INDEX_VERSION;
+        h.truncated = truncated;
+        h.path_crc = crc;
+        h.count = n;
+        h.records = sizeof(h);
+        for (int s = 0; s < DIR_INDEX_SORT_COUNT - 1; s++) {
+            h.orders[s] = h.records + n * sizeof(DirIndexRecord) + s * n * sizeof(uint32_t);
+        }
+        h.names = h.records + n * (sizeof(DirIndexRecord) + (DIR_INDEX_SORT_COUNT - 1) * sizeof(uint32_t));
+        h.names_size = names;
+        time_t now = time(NULL);
+        h.built = now > 1700000000 ? (uint32_t)now : 0;
+
+        char tmp[32];
+        char final[32];
+        index_file(crc, "tmp", tmp, sizeof(tmp));
+        index_file(crc, "idx", final, sizeof(final));
+        ok = write_index(tmp, &h, ents, orders, n);
+        if (ok) {
+            SpiBusHold bus(SPI_CLIENT_SD);
+            SD.remove(final);
+            ok = SD.rename(tmp, final);
+        }
+    }
+
+    for (int s = 0; s < DIR_INDEX_SORT_COUNT - 1; s++) {
+        heap_caps_free(orders[s]);
+    }
+    heap_caps_free(ents);
+    heap_caps_free(pool);
+
+    uint32_t ms = millis() - start;
+    if (!ok) {
+        idx_stats.rebuild_errors++;
+        LOG_WARNF("DirIdx", "Rebuild of %s failed", path);
+        return false;
+    }
+
+    // Touched while it was walked: the new index is already behind
+    portENTER_CRITICAL(&idx_mux);
+    StaleSlot *s = stale_find(crc);
+    bool behind = s && s->seq != seq;
+    if (s && !behind) {
+        s->used = false;
+    }
+    portEXIT_CRITICAL(&idx_mux);
+    if (behind) {
+        SpiBusHold bus(SPI_CLIENT_SD);
+        mark_file_stale(crc);
+    }
+
+    idx_stats.rebuilds++;
+    idx_stats.rebuild_max_ms = max(idx_stats.rebuild_max_ms, ms);
+    idx_stats.rebuild_max_entries = max(idx_stats.rebuild_max_entries, n);
+    rebuild_seq++;
+    LOG_INFOF("DirIdx", "%s: %lu entries%s in %lu ms", path, (unsigned long)n, truncated ? " (truncated)" : "",
+              (unsigned long)ms);
+    return true;
+}
+
+static void rebuild_job(Job *job) {
+    char path[DIR_INDEX_PATH_MAX];
+    while (true) {
+        portENTER_CRITICAL(&idx_mux);
+        if (!rebuild_queued) {
+            rebuild_active = false;
+            portEXIT_CRITICAL(&idx_mux);
+            return;
+        }
+        strcpy(path, rebuild_queue[0]);
+        memmove(rebuild_queue[0], rebuild_queue[1], (rebuild_queued - 1) * DIR_INDEX_PATH_MAX);
+        rebuild_queued--;
+        portEXIT_CRITICAL(&idx_mux);
+        build(path);
+    }
+}
+
+// ===== Console =====
+
+static void rpc_dirindex(Print &out, const char *args) {
+    if (args[0]) {
+        out.println(dir_index_rebuild(args) ? "queued" : "bad path or queue full");
+        return;
+    }
+    DirIndexStats s;
+    dir_index_get_stats(&s);
+    out.printf("opens %lu (stale %lu, missing %lu), pages %lu, touches %lu\n", (unsigned long)s.opens,
+               (unsigned long)s.opens_stale, (unsigned long)s.opens_missing, (unsigned long)s.pages,
+               (unsigned long)s.touches);
+    out.printf("rebuilds %lu (errors %lu), longest %lu ms, most entries %lu%s\n", (unsigned long)s.rebuilds,
+               (unsigned long)s.rebuild_errors, (unsigned long)s.rebuild_max_ms,
+               (unsigned long)s.rebuild_max_entries, dir_index_busy() ? ", busy" : "");
+}
+
+// ===== API =====
+
+bool dir_index_begin() {
+    usb_console_rpc("dirindex", rpc_dirindex);
+    SpiBusHold bus(SPI_CLIENT_SD);
+    if (sd_manager_mounted()) {
+        SD.mkdir(DIR_INDEX_DIR);
+    }
+    return true;
+}
+
+bool dir_index_open(DirIndexView *view, const char *path, DirIndexSort sort) {
+    char dir[DIR_INDEX_PATH_MAX];
+    if (!normalize(path, dir)) {
+        return false;
+    }
+    if (!view->page) {
+        view->page = (DirIndexEntry *)heap_caps_malloc(DIR_INDEX_PAGE * sizeof(DirIndexEntry),
+                                                       MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (!view->page) {
+            return false;
+        }
+    }
+    strcpy(view->path, dir);
+    view->path_crc = path_crc(dir);
+    view->sort = sort < DIR_INDEX_SORT_COUNT ? sort : DIR_INDEX_SORT_NAME;
+    view->built_seq = rebuild_seq;
+    view->page_first = UINT32_MAX;
+    view->page_count = 0;
+    view->open = false;
+    memset(&view->header, 0, sizeof(view->header));
+
+    char p[32];
+    index_file(view->path_crc, "idx", p, sizeof(p));
+    bool found = false;
+    {
+        SpiBusHold bus(SPI_CLIENT_SD);
+        if (!sd_manager_mounted()) {
+            return false;
+        }
+        if (SD.exists(p)) {
+            File f = SD.open(p, FILE_READ);
+            found = read_header(f, view->path_crc, &view->header);
+        }
+    }
+    idx_stats.opens++;
+    if (!found) {
+        memset(&view->header, 0, sizeof(view->header));
+        idx_stats.opens_missing++;
+    } else if (view->header.stale || stale_seq(view->path_crc)) {
+        idx_stats.opens_stale++;
+    }
+    view->stale = !found || view->header.stale || stale_seq(view->path_crc);
+    if (view->stale) {
+        dir_index_rebuild(dir);
+    }
+    view->open = true;
+    return true;
+}
+
+void dir_index_close(DirIndexView *view) {
+    heap_caps_free(view->page);
+    view->page = NULL;
+    view->open = false;
+}
+
+bool dir_index_get(DirIndexView *view, uint32_t i, DirIndexEntry *out) {
+    if (!view->open || i >= view->header.count) {
+        return false;
+    }
+    if (i < view->page_first || i >= view->page_first + view->page_count) {
+        if (!load_page(view, i - i % DIR_INDEX_PAGE)) {
+            return false;
+        }
+    }
+    *out = view->page[i - view->page_first];
+    return true;
+}
+
+bool dir_index_poll(DirIndexView *view) {
+    if (!view->open) {
+        return false;
+    }
+    // Changed while on screen
+    if (!view->stale && stale_seq(view->path_crc)) {
+        view->stale = true;
+        dir_index_rebuild(view->path);
+    }
+    if (view->built_seq == rebuild_seq) {
+        return false;
+    }
+    DirIndexHeader old = view->header;
+    char path[DIR_INDEX_PATH_MAX];
+    strcpy(path, view->path);
+    if (!dir_index_open(view, path, (DirIndexSort)view->sort)) {
+        return false;
+    }
+    return !same_index(&old, &view->header) || view->stale != (bool)old.stale;
+}
+
+bool dir_index_rebuild(const char *path) {
+    char dir[DIR_INDEX_PATH_MAX];
+    if (!normalize(path, dir)) {
+        return false;
+    }
+    portENTER_CRITICAL(&idx_mux);
+    for (uint8_t i = 0; i < rebuild_queued; i++) {
+        if (!strcmp(rebuild_queue[i], dir)) {
+            portEXIT_CRITICAL(&idx_mux);
+            return true;
+        }
+    }
+    if (rebuild_queued >= DIR_INDEX_QUEUE) {
+        portEXIT_CRITICAL(&idx_mux);
+        return false;
+    }
+    strcpy(rebuild_queue[rebuild_queued++], dir);
+    bool start = !rebuild_active;
+    rebuild_active = true;
+    portEXIT_CRITICAL(&idx_mux);
+    if (!start) {
+        return true;
+    }
+
+    Job *job = &rebuild_jobs[0];
+    if (job->state == JOB_QUEUED || job->state == JOB_RUNNING) {
+        job = &rebuild_jobs[1];
+    }
+    if (!job_submit(job, rebuild_job, NULL, JOB_PRIO_LOW)) {
+        portENTER_CRITICAL(&idx_mux);
+        rebuild_active = false;
+        rebuild_queued = 0;
+        portEXIT_CRITICAL(&idx_mux);
+        return false;
+    }
+    return true;
+}
+
+void dir_index_touch(const char *path) {
+    char dir[DIR_INDEX_PATH_MAX];
+    if (parent_of(path, dir)) {
+        touch_dir(dir);
+    }
+    // A directory removed or renamed takes its own index with it
+    if (normalize(path, dir)) {
+        touch_dir(dir);
+    }
+}
+
+bool dir_index_busy() {
+    return rebuild_active;
+}
+
+void dir_index_get_stats(DirIndexStats *out) {
+    *out = idx_stats;
+}
@@ -0,0 +1,159 @@
+/**
+ * @file      dir_index.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Per-directory index files on SD for the file manager: names, sizes, mtimes, sort orders
+ */
+
+#ifndef DIR_INDEX_H
+#define DIR_INDEX_H
+
+#include <Arduino.h>
+
+/**
+ * Walking a FAT directory with openNextFile opens every entry, so a
+ * directory of a few thousand logs or captures takes seconds, every time.
+ * Instead each directory the file manager visits gets one index file under
+ * DIR_INDEX_DIR, named by the CRC of its path: every entry's name, size,
+ * mtime and kind, sorted by name with directories first, plus the
+ * permutations for the other DirIndexSort keys. Opening a directory reads
+ * the header; rows are read a page at a time as the list shows them.
+ *
+ * Writes that go through fs_service mark the index of the directory they
+ * touch stale, with one byte written in place the first time; code that
+ * writes SD itself can call dir_index_touch(). A stale or missing index is
+ * rebuilt on the job pool, the walk holding the card DIR_INDEX_BATCH
+ * entries at a time, then swapped in by rename. A stale index is still
+ * shown meanwhile, so a directory always opens at once after its first
+ * visit.
+ *
+ * File layout, little endian: DirIndexHeader, count DirIndexRecord in name
+ * order, a uint32_t record number per entry for each other sort key, then
+ * the names in name order, not terminated.
+ *
+ * Console: "dirindex" for the counters, "dirindex <path>" to rebuild one.
+ */
+
+#define DIR_INDEX_DIR               "/.dirindex"
+#define DIR_INDEX_MAGIC             0x58494454  // "TDIX"
+#define DIR_INDEX_VERSION           1
+#define DIR_INDEX_MAX               8192        // Entries indexed per directory
+#define DIR_INDEX_NAMES_MAX         (256 * 1024) // Name bytes per directory (PSRAM while building)
+#define DIR_INDEX_NAME_MAX          96          // NUL included; longer names are cut in rows
+#define DIR_INDEX_PATH_MAX          64          // As FS_PATH_MAX
+#define DIR_INDEX_PAGE              32          // Rows read at once
+#define DIR_INDEX_BATCH             64          // Entries walked per hold of the card
+#define DIR_INDEX_STALE_SLOTS       16          // Directories known stale, so a touch costs nothing
+#define DIR_INDEX_QUEUE             4           // Rebuilds waiting
+
+enum DirIndexSort {
+    DIR_INDEX_SORT_NAME = 0,        // Directories first, case-insensitive
+    DIR_INDEX_SORT_NEWEST,
+    DIR_INDEX_SORT_LARGEST,
+    DIR_INDEX_SORT_COUNT,
+};
+
+struct DirIndexHeader {
+    uint32_t magic;
+    uint8_t version;
+    uint8_t stale;                  // Set in place when the directory changed
+    uint8_t truncated;              // More than DIR_INDEX_MAX entries or DIR_INDEX_NAMES_MAX bytes
+    uint8_t reserved;
+    uint32_t path_crc;
+    uint32_t count;
+    uint32_t records;               // File offset of the DirIndexRecords
+    uint32_t orders[DIR_INDEX_SORT_COUNT - 1];  // Of the permutations, SORT_NEWEST onwards
+    uint32_t names;
+    uint32_t names_size;
+    uint32_t built;                 // Unix time, 0 without a clock
+};
+
+#define DIR_INDEX_FLAG_DIR          0x01
+
+struct DirIndexRecord {
+    uint32_t name;                  // Offset into the names
+    uint32_t size;
+    uint32_t mtime;                 // Unix time
+    uint8_t name_len;
+    uint8_t flags;                  // DIR_INDEX_FLAG_*
+    uint16_t reserved;
+};
+
+struct DirIndexEntry {
+    char name[DIR_INDEX_NAME_MAX];
+    uint32_t size;
+    uint32_t mtime;
+    bool is_dir;
+};
+
+// One open directory; the page cache is allocated on open
+struct DirIndexView {
+    char path[DIR_INDEX_PATH_MAX];
+    uint32_t path_crc;
+    uint8_t sort;
+    bool open;
+    bool stale;                     // Shown from an old index, a rebuild is on its way
+    DirIndexHeader header;
+    uint32_t built_seq;             // dir_index rebuild count when opened
+    uint32_t page_first;            // First row in the cache, UINT32_MAX for none
+    uint32_t page_count;
+    DirIndexEntry *page;            // DIR_INDEX_PAGE rows
+};
+
+struct DirIndexStats {
+    uint32_t opens;
+    uint32_t opens_stale;           // Served from an index marked stale
+    uint32_t opens_missing;         // Nothing to show until the rebuild
+    uint32_t pages;                 // Page reads
+    uint32_t touches;               // Index files marked stale
+    uint32_t rebuilds;
+    uint32_t rebuild_errors;
+    uint32_t rebuild_max_ms;
+    uint32_t rebuild_max_entries;
+};
+
+/**
+ * @brief Console command and the index directory; run after the card
+ */
+bool dir_index_begin();
+
+/**
+ * @brief Open path from its index. The count is in view->header.count at
+ *        once; without an index it is 0 and a rebuild is queued
+ * @return false without a card or for a path too long
+ */
+bool dir_index_open(DirIndexView *view, const char *path, DirIndexSort sort = DIR_INDEX_SORT_NAME);
+void dir_index_close(DirIndexView *view);
+
+/**
+ * @brief Row i in the view's sort order, from the page cache or the card
+ */
+bool dir_index_get(DirIndexView *view, uint32_t i, DirIndexEntry *out);
+
+/**
+ * @brief A rebuild of the view's directory finished: reopen it
+ * @return true when the view changed and the list wants rebinding
+ */
+bool dir_index_poll(DirIndexView *view);
+
+/**
+ * @brief Rebuild path in the background whatever state its index is in
+ */
+bool dir_index_rebuild(const char *path);
+
+/**
+ * @brief Something under the directory holding path changed. Called by
+ *        fs_service for its writes; cheap after the first call per directory
+ */
+void dir_index_touch(const char *path);
+
+/**
+ * @brief True while a rebuild is queued or running
+ */
+bool dir_index_busy();
+
+void dir_index_get_stats(DirIndexStats *out);
+
+#endif // DIR_INDEX_H
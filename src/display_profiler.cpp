@@ -0,0 +1,209 @@
+/**
+ * @file      display_profiler.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Display pipeline profiler implementation
+ */
+
+#include "display_profiler.h"
+#include "simple_logger.h"
+#include "input_trace.h"
+#include "ui_label.h"
+
+// Histogram bucket upper edges in milliseconds; the last bucket is open
+static const uint32_t bucket_edges_ms[PROFILER_BUCKET_COUNT - 1] = {10, 50, 100, 200, 500, 1000, 2000};
+static const char* stage_names[PROFILER_STAGE_COUNT] = {"render", "queue", "spi", "busy", "total"};
+
+DisplayProfiler::DisplayProfiler() {
+    memset(&building, 0, sizeof(building));
+    memset(&active, 0, sizeof(active));
+    memset(ring, 0, sizeof(ring));
+    ring_head = 0;
+    ring_count = 0;
+    frames_recorded = 0;
+    ring_lock = portMUX_INITIALIZER_UNLOCKED;
+    enabled = false;
+    overlay = nullptr;
+    last_overlay_ms = 0;
+    last_overlay_frame = 0;
+}
+
+void DisplayProfiler::markInvalidate() {
+    // Only the first invalidation of a frame counts
+    if (enabled && building.invalidate_us == 0) {
+        building.invalidate_us = micros();
+    }
+}
+
+void DisplayProfiler::markRenderStart() {
+    if (!enabled) {
+        return;
+    }
+    building.render_start_us = micros();
+    if (building.invalidate_us == 0) {
+        building.invalidate_us = building.render_start_us;
+    }
+}
+
+void DisplayProfiler::markFlushDone() {
+    if (enabled) {
+        building.flush_done_us = micros();
+    }
+}
+
+void DisplayProfiler::markSubmit(uint8_t job_type, uint8_t rects) {
+    if (!enabled) {
+        return;
+    }
+    // Called while the flush task is idle, so the hand-over needs no lock
+    active = building;
+    active.job_type = job_type;
+    active.rects = rects;
+    active.panel_start_us = micros();
+    memset(&building, 0, sizeof(building));
+}
+
+void DisplayProfiler::discardFrame() {
+    // Frame never reached the panel (identical pixels)
+    memset(&building, 0, sizeof(building));
+}
+
+void DisplayProfiler::beginPanel() {
+    if (enabled) {
+        active.panel_start_us = micros();
+        active.spi_us = 0;
+        active.busy_us = 0;
+    }
+}
+
+void DisplayProfiler::endPanel() {
+    if (!enabled) {
+        return;
+    }
+    active.panel_done_us = micros();
+    uint32_t panel_us = active.panel_done_us - active.panel_start_us;
+    active.spi_us = panel_us > active.busy_us ? panel_us - active.busy_us : 0;
+    
+    portENTER_CRITICAL(&ring_lock);
+    ring[ring_head] = active;
+    ring_head = (ring_head + 1) % PROFILER_RING_SIZE;
+    if (ring_count < PROFILER_RING_SIZE) {
+        ring_count++;
+    }
+    frames_recorded++;
+    portEXIT_CRITICAL(&ring_lock);
+}
+
+uint32_t DisplayProfiler::stageTime(const FrameProfile& frame, ProfilerStage stage) {
+    switch (stage) {
+        case PROFILER_STAGE_RENDER:
+            return frame.flush_done_us - frame.render_start_us;
+        case PROFILER_STAGE_QUEUE:
+            return frame.panel_start_us - frame.flush_done_us;
+        case PROFILER_STAGE_SPI:
+            return frame.spi_us;
+        case PROFILER_STAGE_BUSY:
+            return frame.busy_us;
+        case PROFILER_STAGE_TOTAL:
+            return frame.panel_done_us - frame.invalidate_us;
+        default:
+            return 0;
+    }
+}
+
+bool DisplayProfiler::getLastFrame(FrameProfile* frame) {
+    portENTER_CRITICAL(&ring_lock);
+    bool found = ring_count > 0;
+    if (found) {
+        *frame = ring[(ring_head + PROFILER_RING_SIZE - 1) % PROFILER_RING_SIZE];
+    }
+    portEXIT_CRITICAL(&ring_lock);
+    return found;
+}
+
+void DisplayProfiler::showOverlay(bool show) {
+    if (show && !overlay) {
+        overlay = lv_label_create(lv_layer_top());
+        lv_obj_set_style_bg_color(overlay, lv_color_white(), 0);
+        lv_obj_set_style_bg_opa(overlay, LV_OPA_COVER, 0);
+        lv_obj_align(overlay, LV_ALIGN_TOP_RIGHT, 0, 0);
+        lv_label_set_text(overlay, "prof");
+        last_overlay_ms = millis();
+    } else if (!show && overlay) {
+        lv_obj_del(overlay);
+        overlay = nullptr;
+    }
+}
+
+void DisplayProfiler::updateOverlay() {
+    if (!overlay || frames_recorded == last_overlay_frame ||
+        millis() - last_overlay_ms < PROFILER_OVERLAY_PERIOD_MS) {
+        return;
+    }
+    
+    FrameProfile frame;
+    if (!getLastFrame(&frame)) {
+        return;
+    }
+    
+    // I: the last traced input, INT to glass
+    input_trace_stats_t input;
+    input_trace_get_stats(&input);
+    ui_label_set_fmt(overlay, "R%lu S%lu B%lu T%lu I%lu",
+                     stageTime(frame, PROFILER_STAGE_RENDER) / 1000,
+                     stageTime(frame, PROFILER_STAGE_SPI) / 1000,
+                     stageTime(frame, PROFILER_STAGE_BUSY) / 1000,
+                     stageTime(frame, PROFILER_STAGE_TOTAL) / 1000,
+                     input.last_us[INPUT_STAGE_TOTAL] / 1000);
+    last_overlay_ms = millis();
+    // The overlay's own refresh shows up as the next frame; don't chase it
+    last_overlay_frame = frames_recorded + 1;
+}
+
+void DisplayProfiler::printHistogram() {
+    FrameProfile frames[PROFILER_RING_SIZE];
+    uint16_t count;
+    
+    portENTER_CRITICAL(&ring_lock);
+    count = ring_count;
+    memcpy(frames, ring, sizeof(frames));
+    portEXIT_CRITICAL(&ring_lock);
+    
+    LOG_INFOF("Profiler", "=== Display Pipeline (%u of %lu frames) ===", count, frames_recorded);
+    if (count == 0) {
+        return;
+    }
+    
+    LOG_INFO("Profiler", "stage   <10 <50 <100 <200 <500 <1k <2k >=2k  avg ms");
+    for (int stage = 0; stage < PROFILER_STAGE_COUNT; stage++) {
+        uint16_t buckets[PROFILER_BUCKET_COUNT] = {0};
+        uint32_t total_us = 0;
+        
+        for (uint16_t i = 0; i < count; i++) {
+            uint32_t us = stageTime(frames[i], (ProfilerStage)stage);
+            uint32_t ms = us / 1000;
+            uint8_t b = 0;
+            while (b < PROFILER_BUCKET_COUNT - 1 && ms >= bucket_edges_ms[b]) {
+                b++;
+            }
+            buckets[b]++;
+            total_us += us;
+        }
+        
+        LOG_INFOF("Profiler", "%-7s %3u %3u %4u %4u %4u %3u %3u %4u  %lu",
+                  stage_names[stage], buckets[0], buckets[1], buckets[2], buckets[3],
+                  buckets[4], buckets[5], buckets[6], buckets[7], total_us / count / 1000);
+    }
+}
+
+void DisplayProfiler::reset() {
+    portENTER_CRITICAL(&ring_lock);
+    ring_head = 0;
+    ring_count = 0;
+    frames_recorded = 0;
+    portEXIT_CRITICAL(&ring_lock);
+    memset(&building, 0, sizeof(building));
+    last_overlay_frame = 0;
+}
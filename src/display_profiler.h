@@ -0,0 +1,94 @@
+/**
+ * @file      display_profiler.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Per-frame timing of the LVGL render and e-paper refresh pipeline
+ */
+
+#ifndef DISPLAY_PROFILER_H
+#define DISPLAY_PROFILER_H
+
+#include <Arduino.h>
+#include <lvgl.h>
+
+// Profiler configuration
+#define PROFILER_RING_SIZE          32    // Frames kept for the histogram
+#define PROFILER_BUCKET_COUNT       8
+#define PROFILER_OVERLAY_PERIOD_MS  5000  // Overlay updates cause refreshes, keep them rare
+
+// Pipeline stages measured for every frame that reaches the panel
+enum ProfilerStage {
+    PROFILER_STAGE_RENDER,    // Render start to last band packed
+    PROFILER_STAGE_QUEUE,     // Frame complete to panel work starting
+    PROFILER_STAGE_SPI,       // Controller I/O outside BUSY waits (RAM writes, commands)
+    PROFILER_STAGE_BUSY,      // Waiting on the BUSY line
+    PROFILER_STAGE_TOTAL,     // First invalidation to panel idle
+    PROFILER_STAGE_COUNT
+};
+
+struct FrameProfile {
+    uint32_t invalidate_us;   // First invalidation seen by update()
+    uint32_t render_start_us;
+    uint32_t flush_done_us;
+    uint32_t panel_start_us;
+    uint32_t panel_done_us;
+    uint32_t spi_us;
+    uint32_t busy_us;
+    uint8_t job_type;         // FlushJobType of the panel update
+    uint8_t rects;
+};
+
+/**
+ * @brief Display Profiler Class
+ * 
+ * Collects timestamps from LVGLIntegration and its flush task into a
+ * ring buffer, prints stage histograms and can show an overlay label
+ */
+class DisplayProfiler {
+private:
+    FrameProfile building;        // Frame being rendered (LVGL thread)
+    FrameProfile active;          // Frame on the panel (flush task)
+    FrameProfile ring[PROFILER_RING_SIZE];
+    uint16_t ring_head;
+    uint16_t ring_count;
+    uint32_t frames_recorded;
+    portMUX_TYPE ring_lock;
+    
+    bool enabled;
+    lv_obj_t* overlay;
+    uint32_t last_overlay_ms;
+    uint32_t last_overlay_frame;
+    
+    static uint32_t stageTime(const FrameProfile& frame, ProfilerStage stage);
+
+public:
+    DisplayProfiler();
+    
+    // LVGL thread
+    void markInvalidate();
+    void markRenderStart();
+    void markFlushDone();
+    void markSubmit(uint8_t job_type, uint8_t rects);
+    void discardFrame();
+    
+    // Flush task
+    void beginPanel();
+    void addBusyTime(uint32_t us) { active.busy_us += us; }
+    void endPanel();
+    
+    // Control
+    void enable(bool on) { enabled = on; }
+    bool isEnabled() { return enabled; }
+    void showOverlay(bool show);
+    void updateOverlay();
+    
+    // Reporting
+    bool getLastFrame(FrameProfile* frame);
+    uint32_t getFramesRecorded() { return frames_recorded; }
+    void printHistogram();
+    void reset();
+};
+
+#endif // DISPLAY_PROFILER_H
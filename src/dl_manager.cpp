@@ -0,0 +1,762 @@
+/**
+ * @file      dl_manager.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Resumable HTTP downloads to files: kept-alive connections, ranges, shaping by bearer
+ */
+
+#include "dl_manager.h"
+#include <HTTPClient.h>
+#include <SD.h>
+#include <esp_heap_caps.h>
+#include "tls_client.h"
+#include "net_manager.h"
+#include "metrics.h"
+#include "usb_console.h"
+#include "simple_logger.h"
+#ifdef INTEGRATION_LAYER_ENABLED
+#include "integration/config_manager.h"
+#include "integration/event_bridge.h"
+#endif
+
+// fetch() outcomes besides DlResult
+#define FETCH_MORE      1           // Got cut off; try again after a pause
+#define FETCH_AGAIN     2           // Ask again at once, e.g. as HTTP/1.0
+
+// "<path>.dlm": what the part was fetched against
+struct DlMeta {
+    uint32_t magic;
+    uint32_t total;
+    char validator[DL_ETAG_MAX];    // ETag, or Last-Modified without one
+};
+
+struct DlTransfer {
+    DlStatus st;
+    DlMeta meta;
+    uint8_t flags;
+    bool opened;                    // Part and meta read
+    volatile bool cancel;
+    uint32_t not_before;            // Backoff after a try that got nowhere
+    fs::FS *fs;
+    dl_done_cb cb;
+    void *ctx;
+};
+
+// A kept-alive connection, per scheme, host and port
+struct DlConn {
+    char host[DL_HOST_MAX];
+    uint16_t port;
+    bool tls;
+    bool http10;                    // The host answered chunked; HTTP/1.0 gets a plain body
+    uint32_t last_ms;
+    WiFiClient tcp;
+    TlsClient *tls_client;
+    HTTPClient http;
+};
+
+struct DlBuf {
+    uint8_t *data;
+    size_t fill;
+    volatile bool out;              // With fs_service
+};
+
+static portMUX_TYPE dl_mux = portMUX_INITIALIZER_UNLOCKED;
+static DlTransfer dl_queue[DL_QUEUE_MAX];
+static uint32_t dl_next_id = 1;
+static DlStats dl_stats;
+static TaskHandle_t dl_task = NULL;
+static SemaphoreHandle_t dl_fs_done = NULL;
+
+// Worker task only
+static DlConn dl_pool[DL_POOL_SLOTS];
+static DlBuf dl_bufs[2];
+static volatile bool dl_write_failed = false;
+static FsResult dl_fs_res;
+
+static uint32_t dl_wifi_bps = 0;
+static uint32_t dl_cell_bps = DL_CELL_BPS;
+static String dl_ca;
+
+static bool terminal(uint8_t state) {
+    return state == DL_DONE || state == DL_FAILED || state == DL_CANCELLED;
+}
+
+static void set_state(DlTransfer *t, uint8_t state) {
+    portENTER_CRITICAL(&dl_mux);
+    t->st.state = state;
+    portEXIT_CRITICAL(&dl_mux);
+}
+
+static void publish(DlTransfer *t, bool final) {
+#ifdef INTEGRATION_LAYER_ENABLED
+    if (!GlobalEventBridge) {
+        return;
+    }
+    DlProgressEvent ev = {t->st.id, t->st.state, t->st.result, t->st.received, t->st.total, t->st.bytes_per_s};
+    GlobalEventBridge->publishTypedEvent(EventType::DOWNLOAD_PROGRESS, "Download", ev,
+                                         final ? EventPriority::EVENT_HIGH : EventPriority::NORMAL);
+#endif
+}
+
+// ===== Files =====
+
+static void fs_sync_done(const FsResult *res, void *ctx) {
+    dl_fs_res = *res;
+    xSemaphoreGive(dl_fs_done);
+}
+
+// Waits out a request queued with fs_sync_done
+static bool fs_sync(uint32_t id, FsResult *res = NULL) {
+    if (!id) {
+        return false;
+    }
+    xSemaphoreTake(dl_fs_done, portMAX_DELAY);
+    if (res) {
+        *res = dl_fs_res;
+    }
+    return dl_fs_res.ok;
+}
+
+static void side_path(const DlTransfer *t, const char *ext, char *out) {
+    snprintf(out, FS_PATH_MAX, "%s%s", t->st.path, ext);
+}
+
+static void write_done(const FsResult *res, void *ctx) {
+    if (!res->ok) {
+        dl_write_failed = true;
+    }
+    dl_bufs[(intptr_t)ctx].out = false;
+    xTaskNotifyGive(dl_task);
+}
+
+static bool wait_buf(DlBuf *b) {
+    while (b->out) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(100));
+    }
+    return !dl_write_failed;
+}
+
+// The first write of a part started over replaces the file, even with nothing in it
+static bool flush_buf(DlTransfer *t, int i, bool *replace) {
+    DlBuf *b = &dl_bufs[i];
+    if (!b->fill && !*replace) {
+        return true;
+    }
+    char part[FS_PATH_MAX];
+    side_path(t, ".part", part);
+    b->out = true;
+    uint32_t id = *replace ? fs_write(*t->fs, part, b->data, b->fill, write_done, (void *)(intptr_t)i)
+                           : fs_append(*t->fs, part, b->data, b->fill, write_done, (void *)(intptr_t)i);
+    if (!id) {
+        b->out = false;
+        return false;
+    }
+    b->fill = 0;
+    *replace = false;
+    return true;
+}
+
+// Where an earlier transfer to the same path left off
+static void open_part(DlTransfer *t) {
+    char path[FS_PATH_MAX];
+    FsResult res;
+    side_path(t, ".part", path);
+    t->st.received = fs_sync(fs_stat(*t->fs, path, fs_sync_done), &res) ? res.size : 0;
+    side_path(t, ".dlm", path);
+    // A part without its meta is not known to be the same file
+    if (t->st.received && (!fs_sync(fs_read(*t->fs, path, 0, &t->meta, sizeof(t->meta), fs_sync_done), &res) ||
+                           res.size != sizeof(t->meta) || t->meta.magic != DL_META_MAGIC)) {
+        t->st.received = 0;
+    }
+    if (!t->st.received) {
+        memset(&t->meta, 0, sizeof(t->meta));
+    }
+    t->st.total = t->meta.total;
+    t->opened = true;
+}
+
+static bool save_meta(DlTransfer *t) {
+    char path[FS_PATH_MAX];
+    side_path(t, ".dlm", path);
+    t->meta.magic = DL_META_MAGIC;
+    return fs_sync(fs_write(*t->fs, path, &t->meta, sizeof(t->meta), fs_sync_done));
+}
+
+static int finish_file(DlTransfer *t) {
+    char part[FS_PATH_MAX], meta[FS_PATH_MAX];
+    side_path(t, ".part", part);
+    side_path(t, ".dlm", meta);
+    fs_sync(fs_remove(*t->fs, t->st.path, fs_sync_done));
+    if (!fs_sync(fs_rename(*t->fs, part, t->st.path, fs_sync_done))) {
+        return DL_ERR_FS;
+    }
+    fs_sync(fs_remove(*t->fs, meta, fs_sync_done));
+    return DL_OK;
+}
+
+// ===== Connections =====
+
+static WiFiClient *conn_client(DlConn *c) {
+    return c->tls ? c->tls_client : &c->tcp;
+}
+
+static bool parse_url(const char *url, bool *tls, char *host, uint16_t *port) {
+    size_t skip;
+    if (!strncmp(url, "http://", 7)) {
+        *tls = false;
+        skip = 7;
+    } else if (!strncmp(url, "https://", 8)) {
+        *tls = true;
+        skip = 8;
+    } else {
+        return false;
+    }
+    url += skip;
+    size_t n = strcspn(url, ":/");
+    if (!n || n >= DL_HOST_MAX) {
+        return false;
+    }
+    memcpy(host, url, n);
+    host[n] = '\0';
+    *port = *tls ? 443 : 80;
+    if (url[n] == ':') {
+        *port = (uint16_t)atoi(url + n + 1);
+    }
+    return *port != 0;
+}
+
+// The pooled connection for url, taking over the least recently used one
+static DlConn *conn_for(const char *url) {
+    bool tls;
+    char host[DL_HOST_MAX];
+    uint16_t port;
+    if (!parse_url(url, &tls, host, &port)) {
+        return NULL;
+    }
+    DlConn *lru = &dl_pool[0];
+    for (int i = 0; i < DL_POOL_SLOTS; i++) {
+        DlConn *c = &dl_pool[i];
+        if (c->tls == tls && c->port == port && !strcmp(c->host, host)) {
+            return c;
+        }
+        if (!c->host[0] || (lru->host[0] && c->last_ms < lru->last_ms)) {
+            lru = c;
+        }
+    }
+    if (lru->host[0]) {
+        conn_client(lru)->stop();
+    }
+    if (tls && !lru->tls_client) {
+        lru->tls_client = new TlsClient();
+        if (!lru->tls_client) {
+            return NULL;
+        }
+        if (!dl_ca.length() || !lru->tls_client->setCACertFile(dl_ca.c_str())) {
+            lru->tls_client->setInsecure();
+        }
+    }
+    strlcpy(lru->host, host, sizeof(lru->host));
+    lru->port = port;
+    lru->tls = tls;
+    lru->http10 = false;
+    lru->http.setReuse(true);
+    lru->http.setTimeout(DL_HTTP_TIMEOUT_MS);
+    lru->http.setConnectTimeout(DL_HTTP_TIMEOUT_MS);
+    return lru;
+}
+
+static bool conn_open_to(const char *url) {
+    bool tls;
+    char host[DL_HOST_MAX];
+    uint16_t port;
+    if (!parse_url(url, &tls, host, &port)) {
+        return false;
+    }
+    for (int i = 0; i < DL_POOL_SLOTS; i++) {
+        DlConn *c = &dl_pool[i];
+        if (c->tls == tls && c->port == port && !strcmp(c->host, host) && conn_client(c)->connected()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void close_idle() {
+    uint32_t now = millis();
+    for (int i = 0; i < DL_POOL_SLOTS; i++) {
+        DlConn *c = &dl_pool[i];
+        if (c->host[0] && now - c->last_ms >= DL_KEEPALIVE_MS && conn_client(c)->connected()) {
+            conn_client(c)->stop();
+        }
+    }
+}
+
+// ===== Transfer =====
+
+static bool route_ok(const DlTransfer *t) {
+    int route = net_manager_route();
+    return route == NET_BEARER_WIFI || (route == NET_BEARER_CELL && !(t->flags & DL_WIFI_ONLY));
+}
+
+// Bytes so far may not outrun the route's cap over the time so far
+static void shape(const DlTransfer *t, uint32_t got, uint32_t start_ms) {
+    if (t->flags & DL_UNSHAPED) {
+        return;
+    }
+    int route = net_manager_route();
+    uint32_t bps = route == NET_BEARER_CELL ? dl_cell_bps : route == NET_BEARER_WIFI ? dl_wifi_bps : 0;
+    if (!bps) {
+        return;
+    }
+    uint32_t due = (uint64_t)got * 1000 / bps;
+    uint32_t spent = millis() - start_ms;
+    if (due > spent) {
+        vTaskDelay(pdMS_TO_TICKS(due - spent));
+        dl_stats.shaped_ms += due - spent;
+    }
+}
+
+/**
+ * One GET from what the part already holds. DL_OK once the file is whole,
+ * FETCH_MORE when the connection gave out first, FETCH_AGAIN to ask again
+ * at once, or an error. The connection stays open when the response was
+ * read to its end and the server keeps it alive
+ */
+static int fetch(DlTransfer *t, DlConn *c) {
+    static const char *keep[] = {"ETag", "Last-Modified", "Content-Range", "Transfer-Encoding"};
+    DlStatus *st = &t->st;
+    HTTPClient &http = c->http;
+    WiFiClient *client = conn_client(c);
+    c->last_ms = millis();
+    if (!client->connected()) {
+        dl_stats.connections++;
+    }
+    if (!http.begin(*client, st->url)) {
+        return FETCH_MORE;
+    }
+    http.useHTTP10(c->http10);
+    http.collectHeaders(keep, sizeof(keep) / sizeof(keep[0]));
+    char range[32];
+    if (st->received) {
+        snprintf(range, sizeof(range), "bytes=%lu-", (unsigned long)st->received);
+        http.addHeader("Range", range);
+        if (t->meta.validator[0]) {
+            http.addHeader("If-Range", t->meta.validator);
+        }
+        dl_stats.resumes++;
+        metrics_count(METRIC_DL_RESUMES);
+    }
+    st->resumed_at = st->received;
+    int code = http.GET();
+    dl_stats.requests++;
+    st->http_code = code;
+
+    // HTTPClient hands over the raw stream, so a chunked body is asked for again as HTTP/1.0
+    if ((code == HTTP_CODE_OK || code == HTTP_CODE_PARTIAL_CONTENT) &&
+        http.header("Transfer-Encoding").equalsIgnoreCase("chunked") && !c->http10) {
+        c->http10 = true;
+        client->stop();
+        http.end();
+        return FETCH_AGAIN;
+    }
+
+    bool replace = false;
+    if (code == HTTP_CODE_PARTIAL_CONTENT) {
+        unsigned long first = 0, total = 0;
+        String cr = http.header("Content-Range");
+        int fields = sscanf(cr.c_str(), "bytes %lu-%*u/%lu", &first, &total);
+        if (fields < 1 || first != st->received) {
+            client->stop();
+            http.end();
+            st->received = 0;       // Not the range asked for; start over
+            dl_stats.restarts++;
+            return FETCH_AGAIN;
+        }
+        if (fields == 2 && total != t->meta.total) {
+            t->meta.total = total;
+            save_meta(t);
+        }
+    } else if (code == HTTP_CODE_OK) {
+        if (st->received) {
+            dl_stats.restarts++;
+            LOG_INFOF("Download", "#%lu changed on the server or has no ranges, starting over", (unsigned long)st->id);
+        }
+        st->received = 0;
+        replace = true;
+        String validator = http.header("ETag");
+        if (!validator.length()) {
+            validator = http.header("Last-Modified");
+        }
+        strlcpy(t->meta.validator, validator.c_str(), sizeof(t->meta.validator));
+        t->meta.total = http.getSize() > 0 ? http.getSize() : 0;
+        if (!save_meta(t)) {
+            client->stop();
+            http.end();
+            return DL_ERR_FS;
+        }
+    } else {
+        client->stop();
+        http.end();
+        if (code == HTTP_CODE_RANGE_NOT_SATISFIABLE && st->received) {
+            if (st->received == t->meta.total) {
+                return DL_OK;       // The part was whole already
+            }
+            st->received = 0;
+            return FETCH_AGAIN;
+        }
+        LOG_WARNF("Download", "HTTP %d for #%lu", code, (unsigned long)st->id);
+        return code >= 400 && code < 500 ? DL_ERR_HTTP : FETCH_MORE;
+    }
+    st->total = t->meta.total;
+
+    int size = http.getSize();      // Of this response, -1 until the server closes
+    uint32_t want = size >= 0 ? (uint32_t)size : UINT32_MAX;
+    WiFiClient *stream = http.getStreamPtr();
+    uint32_t start = millis();
+    uint32_t last_progress = start;
+    uint32_t got = 0;
+    int cur = 0;
+    size_t boundary = DL_BUF_SIZE - st->received % DL_BUF_SIZE;
+    int r = FETCH_MORE;
+    dl_write_failed = false;
+    while (got < want) {
+        if (t->cancel) {
+            r = DL_ERR_CANCELLED;
+            break;
+        }
+        DlBuf *b = &dl_bufs[cur];
+        size_t n = stream->readBytes(b->data + b->fill, min((uint32_t)min(boundary - b->fill, (size_t)DL_READ_CHUNK), want - got));
+        if (!n) {
+            break;                  // Timed out, or the server closed
+        }
+        b->fill += n;
+        got += n;
+        st->received += n;
+        dl_stats.bytes += n;
+        metrics_count(METRIC_DL_BYTES, n);
+        if (b->fill == boundary) {
+            cur ^= 1;
+            boundary = DL_BUF_SIZE;
+            if (!flush_buf(t, cur ^ 1, &replace) || !wait_buf(&dl_bufs[cur])) {
+                r = DL_ERR_FS;
+                break;
+            }
+        }
+        shape(t, got, start);
+        uint32_t now = millis();
+        if (now - last_progress >= DL_PROGRESS_MS) {
+            last_progress = now;
+            st->bytes_per_s = now > start ? (uint64_t)got * 1000 / (now - start) : 0;
+            publish(t, false);
+        }
+    }
+    uint32_t ms = millis() - start;
+    st->bytes_per_s = ms ? (uint64_t)got * 1000 / ms : 0;
+
+    // The part has to hold what was counted, so a resume asks for the right range
+    if (!flush_buf(t, cur, &replace) || !wait_buf(&dl_bufs[0]) || !wait_buf(&dl_bufs[1])) {
+        r = DL_ERR_FS;
+    }
+    bool whole = size >= 0 ? got == want : !stream->connected();
+    if (r == FETCH_MORE && whole) {
+        r = DL_OK;
+    }
+    // Anything left of the body would be read as the next response
+    if (r != DL_OK || size < 0) {
+        client->stop();
+    }
+    http.end();
+    c->last_ms = millis();
+    return r;
+}
+
+static void complete(DlTransfer *t, int result) {
+    portENTER_CRITICAL(&dl_mux);
+    t->st.result = result;
+    t->st.state = result == DL_OK ? DL_DONE : result == DL_ERR_CANCELLED ? DL_CANCELLED : DL_FAILED;
+    portEXIT_CRITICAL(&dl_mux);
+    if (result == DL_OK) {
+        dl_stats.done++;
+        metrics_observe(METRIC_DL_KIB_PER_S, t->st.bytes_per_s / 1024);
+        LOG_INFOF("Download", "#%lu done, %lu bytes into %s", (unsigned long)t->st.id,
+                  (unsigned long)t->st.received, t->st.path);
+    } else if (result != DL_ERR_CANCELLED) {
+        dl_stats.failed++;
+        metrics_count(METRIC_DL_FAILED);
+        LOG_WARNF("Download", "#%lu failed (%d), part kept", (unsigned long)t->st.id, result);
+    }
+    publish(t, true);
+    if (t->cb) {
+        t->cb(t->st.id, result, t->ctx);
+    }
+}
+
+// One try. Leaves the transfer queued with a backoff when it got cut off
+static void attempt(DlTransfer *t) {
+    if (!t->opened) {
+        open_part(t);
+    }
+    DlConn *c = conn_for(t->st.url);
+    if (!c) {
+        complete(t, DL_ERR_HTTP);
+        return;
+    }
+    set_state(t, DL_RUNNING);
+    uint32_t before = t->st.received;
+    int r;
+    do {
+        r = fetch(t, c);
+    } while (r == FETCH_AGAIN && !t->cancel);
+    if (r == FETCH_AGAIN) {
+        r = DL_ERR_CANCELLED;
+    }
+    if (r == DL_OK) {
+        r = finish_file(t);
+    }
+    if (r != FETCH_MORE) {
+        complete(t, r);
+        return;
+    }
+    t->st.tries = t->st.received > before ? 0 : t->st.tries + 1;
+    if (t->st.tries >= DL_RETRIES) {
+        complete(t, DL_ERR_LINK);
+        return;
+    }
+    t->not_before = millis() + min(1000UL << t->st.tries, 60000UL);
+    set_state(t, DL_WAITING);
+    publish(t, false);
+}
+
+/**
+ * Highest priority first; among equals one whose host has a connection
+ * open, then the oldest. Cancelled ones still waiting are finished here
+ */
+static DlTransfer *pick() {
+    DlTransfer *best = NULL;
+    bool best_open = false;
+    uint32_t now = millis();
+    for (int i = 0; i < DL_QUEUE_MAX; i++) {
+        DlTransfer *t = &dl_queue[i];
+        if (!t->st.id || terminal(t->st.state)) {
+            continue;
+        }
+        if (t->cancel) {
+            complete(t, DL_ERR_CANCELLED);
+            continue;
+        }
+        if ((int32_t)(now - t->not_before) < 0 || !route_ok(t)) {
+            if (t->st.state != DL_WAITING) {
+                set_state(t, DL_WAITING);
+            }
+            continue;
+        }
+        bool open = conn_open_to(t->st.url);
+        if (!best || t->st.prio > best->st.prio ||
+            (t->st.prio == best->st.prio && (open > best_open || (open == best_open && t->st.id < best->st.id)))) {
+            best = t;
+            best_open = open;
+        }
+    }
+    return best;
+}
+
+static bool any_pending() {
+    for (int i = 0; i < DL_QUEUE_MAX; i++) {
+        if (dl_queue[i].st.id && !terminal(dl_queue[i].st.state)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void dl_worker(void *param) {
+    while (1) {
+        DlTransfer *t = pick();
+        if (t) {
+            attempt(t);
+            continue;
+        }
+        close_idle();
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(any_pending() ? DL_WAIT_MS : DL_KEEPALIVE_MS));
+    }
+}
+
+// ===== Console =====
+
+static const char *state_name(uint8_t state) {
+    static const char *names[] = {"queued", "running", "waiting", "done", "failed", "cancelled"};
+    return state < sizeof(names) / sizeof(names[0]) ? names[state] : "?";
+}
+
+static void rpc_dl(Print &out, const char *args) {
+    if (!strncmp(args, "get ", 4)) {
+        char url[DL_URL_MAX + 1];
+        const char *path = strchr(args + 4, ' ');
+        if (!path || path - (args + 4) > DL_URL_MAX) {
+            out.println("usage: dl get <url> <sd path>");
+            return;
+        }
+        memcpy(url, args + 4, path - (args + 4));
+        url[path - (args + 4)] = '\0';
+        uint32_t id = dl_start(url, SD, path + 1);
+        if (id) {
+            out.printf("#%lu queued\n", (unsigned long)id);
+        } else {
+            out.println("queue full, path too long or not running");
+        }
+        return;
+    }
+    if (!strncmp(args, "cancel ", 7)) {
+        out.println(dl_cancel(strtoul(args + 7, NULL, 10)) ? "cancelling" : "no such transfer");
+        return;
+    }
+    if (args[0]) {
+        out.println("usage: dl [get <url> <sd path>|cancel <id>]");
+        return;
+    }
+    DlStats s;
+    dl_get_stats(&s);
+    out.printf("%lu started, %lu done, %lu failed; %lu requests on %lu connections, %lu resumes, %lu restarts\n",
+               (unsigned long)s.started, (unsigned long)s.done, (unsigned long)s.failed, (unsigned long)s.requests,
+               (unsigned long)s.connections, (unsigned long)s.resumes, (unsigned long)s.restarts);
+    out.printf("%lu bytes, held back %lu ms; cap wifi %lu B/s, cell %lu B/s (0 none)\n", (unsigned long)s.bytes,
+               (unsigned long)s.shaped_ms, (unsigned long)dl_wifi_bps, (unsigned long)dl_cell_bps);
+    DlStatus list[DL_QUEUE_MAX];
+    size_t n = dl_list(list, DL_QUEUE_MAX);
+    for (size_t i = 0; i < n; i++) {
+        DlStatus *d = &list[i];
+        out.printf("#%lu %s p%u %lu/%lu B %lu B/s HTTP %d, %s <- %s\n", (unsigned long)d->id, state_name(d->state),
+                   d->prio, (unsigned long)d->received, (unsigned long)d->total, (unsigned long)d->bytes_per_s,
+                   d->http_code, d->path, d->url);
+    }
+}
+
+// ===== API =====
+
+bool dl_manager_begin() {
+    if (dl_task) {
+        return true;
+    }
+#ifdef INTEGRATION_LAYER_ENABLED
+    dl_wifi_bps = GET_CONFIG_INT("dl", "wifi_bps", 0);
+    dl_cell_bps = GET_CONFIG_INT("dl", "cell_bps", DL_CELL_BPS);
+    dl_ca = GET_CONFIG_STRING("dl", "ca", String(""));
+#endif
+    for (int i = 0; i < 2; i++) {
+        if (!dl_bufs[i].data) {
+            dl_bufs[i].data = (uint8_t *)heap_caps_malloc(DL_BUF_SIZE, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        }
+        if (!dl_bufs[i].data) {
+            dl_bufs[i].data = (uint8_t *)malloc(DL_BUF_SIZE);
+        }
+        if (!dl_bufs[i].data) {
+            LOG_ERROR("Download", "No memory for write buffers");
+            return false;
+        }
+    }
+    if (!dl_fs_done) {
+        dl_fs_done = xSemaphoreCreateBinary();
+    }
+    if (!dl_fs_done || !fs_service_begin()) {
+        return false;
+    }
+    if (xTaskCreate(dl_worker, "dl_manager", DL_TASK_STACK, NULL, DL_TASK_PRIORITY, &dl_task) != pdPASS) {
+        LOG_ERROR("Download", "Failed to start the worker");
+        return false;
+    }
+    usb_console_rpc("dl", rpc_dl);
+    return true;
+}
+
+uint32_t dl_start(const char *url, fs::FS &fs, const char *path, uint8_t prio, uint8_t flags, dl_done_cb cb, void *ctx) {
+    if (!dl_task || !url || !path || strlen(url) > DL_URL_MAX || strlen(path) + 5 >= FS_PATH_MAX) {
+        return 0;
+    }
+    uint32_t id = 0;
+    portENTER_CRITICAL(&dl_mux);
+    // A free slot, or the oldest finished one
+    DlTransfer *slot = NULL;
+    for (int i = 0; i < DL_QUEUE_MAX; i++) {
+        DlTransfer *t = &dl_queue[i];
+        if (!t->st.id) {
+            slot = t;
+            break;
+        }
+        if (terminal(t->st.state) && (!slot || t->st.id < slot->st.id)) {
+            slot = t;
+        }
+    }
+    if (slot) {
+        id = dl_next_id++;
+        memset(&slot->st, 0, sizeof(slot->st));
+        slot->st.id = id;
+        slot->st.prio = prio;
+        slot->st.state = DL_QUEUED;
+        strlcpy(slot->st.url, url, sizeof(slot->st.url));
+        strlcpy(slot->st.path, path, sizeof(slot->st.path));
+        slot->flags = flags;
+        slot->opened = false;
+        slot->cancel = false;
+        slot->not_before = 0;
+        slot->fs = &fs;
+        slot->cb = cb;
+        slot->ctx = ctx;
+        dl_stats.started++;
+    }
+    portEXIT_CRITICAL(&dl_mux);
+    if (id) {
+        xTaskNotifyGive(dl_task);
+    }
+    return id;
+}
+
+bool dl_cancel(uint32_t id) {
+    bool found = false;
+    portENTER_CRITICAL(&dl_mux);
+    for (int i = 0; i < DL_QUEUE_MAX; i++) {
+        DlTransfer *t = &dl_queue[i];
+        if (id && t->st.id == id && !terminal(t->st.state)) {
+            t->cancel = true;
+            found = true;
+        }
+    }
+    portEXIT_CRITICAL(&dl_mux);
+    if (found) {
+        xTaskNotifyGive(dl_task);
+    }
+    return found;
+}
+
+bool dl_get(uint32_t id, DlStatus *out) {
+    bool found = false;
+    portENTER_CRITICAL(&dl_mux);
+    for (int i = 0; i < DL_QUEUE_MAX; i++) {
+        if (id && dl_queue[i].st.id == id) {
+            *out = dl_queue[i].st;
+            found = true;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&dl_mux);
+    return found;
+}
+
+size_t dl_list(DlStatus *out, size_t max) {
+    size_t n = 0;
+    portENTER_CRITICAL(&dl_mux);
+    for (int i = 0; i < DL_QUEUE_MAX && n < max; i++) {
+        if (dl_queue[i].st.id && !terminal(dl_queue[i].st.state)) {
+            out[n++] = dl_queue[i].st;
+        }
+    }
+    portEXIT_CRITICAL(&dl_mux);
+    return n;
+}
+
+void dl_get_stats(DlStats *out) {
+    portENTER_CRITICAL(&dl_mux);
+    *out = dl_stats;
+    portEXIT_CRITICAL(&dl_mux);
+}
@@ -0,0 +1,165 @@
+/**
+ * @file      dl_manager.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Resumable HTTP downloads to files: kept-alive connections, ranges, shaping by bearer
+ */
+
+#ifndef DL_MANAGER_H
+#define DL_MANAGER_H
+
+#include <Arduino.h>
+#include <FS.h>
+#include "fs_service.h"
+
+/**
+ * One worker task runs the queued transfers one at a time, highest
+ * priority first, and among equals one whose host already has an open
+ * connection. Connections are kept alive in a pool of DL_POOL_SLOTS per
+ * scheme, host and port, and closed after DL_KEEPALIVE_MS idle, so a run
+ * of small files from one server (tiles, asset parts) costs one TCP and
+ * TLS handshake instead of one each.
+ *
+ * A transfer writes "<path>.part", with the server's ETag or
+ * Last-Modified and the total length in "<path>.dlm". After a link loss
+ * or a reboot it asks for the rest with Range and If-Range; a server
+ * that answers 200 instead has a new file or no ranges, and the part is
+ * started over. The finished part is renamed onto path.
+ *
+ * The body goes to the file through fs_service in DL_BUF_SIZE appends
+ * from two buffers, one filling while the other is written. The first
+ * append after a resume tops the file up to a DL_BUF_SIZE boundary, so
+ * every later append starts on a sector.
+ *
+ * Shaping: the rate is capped per bearer from the route net_manager
+ * picks, dl.cell_bps on 4G and dl.wifi_bps on WiFi (0 uncapped).
+ * DL_WIFI_ONLY transfers wait off WiFi; nothing runs without an IP
+ * route. A transfer that stops getting anywhere is tried again with a
+ * growing delay, DL_RETRIES times in a row.
+ *
+ * Progress goes out as DOWNLOAD_PROGRESS events (DlProgressEvent) every
+ * DL_PROGRESS_MS and once at the end; the completion callback runs on the
+ * worker. Metrics: dl.bytes, dl.resumes, dl.failed, and dl.kib_per_s per
+ * finished transfer.
+ *
+ * Console: "dl" for the queue, "dl get <url> <sd path>", "dl cancel <id>".
+ * Config section "dl": wifi_bps (0), cell_bps (32768), ca (PEM bundle on
+ * LittleFS for https; servers are not checked without one).
+ */
+
+#define DL_QUEUE_MAX                8
+#define DL_URL_MAX                  200
+#define DL_HOST_MAX                 64
+#define DL_ETAG_MAX                 64
+#define DL_POOL_SLOTS               2
+#define DL_KEEPALIVE_MS             30000
+#define DL_BUF_SIZE                 4096    // Eight sectors per append
+#define DL_READ_CHUNK               1024
+#define DL_HTTP_TIMEOUT_MS          15000
+#define DL_RETRIES                  8
+#define DL_WAIT_MS                  2000    // Polling the route while nothing can run
+#define DL_PROGRESS_MS              1000
+#define DL_CELL_BPS                 32768
+#define DL_META_MAGIC               0x4D4C4444UL    // "DDLM"
+#define DL_TASK_STACK               (1024 * 8)      // Room for a TLS handshake
+#define DL_TASK_PRIORITY            (tskIDLE_PRIORITY + 1)
+
+enum DlState {
+    DL_QUEUED = 0,
+    DL_RUNNING,
+    DL_WAITING,                     // For a route, or between tries
+    DL_DONE,
+    DL_FAILED,
+    DL_CANCELLED,
+};
+
+enum DlPriority {
+    DL_PRIO_LOW = 0,                // Prefetch: tiles, asset packs
+    DL_PRIO_NORMAL,
+    DL_PRIO_HIGH,                   // Someone is waiting: OTA, AGNSS
+};
+
+enum DlFlags {
+    DL_WIFI_ONLY = 0x01,
+    DL_UNSHAPED = 0x02,             // Not held to the bearer's cap
+};
+
+enum DlResult {
+    DL_OK = 0,
+    DL_ERR_HTTP = -1,               // A status that will not change on retry
+    DL_ERR_FS = -2,
+    DL_ERR_LINK = -3,               // DL_RETRIES tries in a row without progress
+    DL_ERR_CANCELLED = -4,
+};
+
+// EventBridge payload for DOWNLOAD_PROGRESS
+struct DlProgressEvent {
+    uint32_t id;
+    uint8_t state;                  // DlState
+    int8_t result;                  // DlResult once DL_DONE or DL_FAILED
+    uint32_t received;              // Bytes in the file, resumed part included
+    uint32_t total;                 // 0 unknown
+    uint32_t bytes_per_s;           // This connection's
+};
+
+struct DlStatus {
+    uint32_t id;
+    uint8_t state;
+    uint8_t prio;
+    int8_t result;
+    int16_t http_code;              // Last response
+    uint32_t received;
+    uint32_t total;
+    uint32_t resumed_at;            // Offset the last request asked from
+    uint32_t bytes_per_s;
+    uint8_t tries;                  // Without progress, in a row
+    char url[DL_URL_MAX + 1];
+    char path[FS_PATH_MAX];
+};
+
+struct DlStats {
+    uint32_t started;
+    uint32_t done;
+    uint32_t failed;
+    uint32_t resumes;               // Requests that asked for a range
+    uint32_t restarts;              // Parts thrown away: validator changed, no ranges
+    uint32_t connections;           // Opened; requests minus these went out kept alive
+    uint32_t requests;
+    uint32_t bytes;
+    uint32_t shaped_ms;             // Held back by the cap
+};
+
+typedef void (*dl_done_cb)(uint32_t id, int result, void *ctx);
+
+/**
+ * @brief Read the config and start the worker
+ */
+bool dl_manager_begin();
+
+/**
+ * @brief Queue url into path on fs. A part left by an earlier transfer to
+ *        the same path is resumed
+ * @param flags DlFlags
+ * @return transfer id, 0 when the queue is full or the path leaves no room
+ *         for ".part" in FS_PATH_MAX
+ */
+uint32_t dl_start(const char *url, fs::FS &fs, const char *path, uint8_t prio = DL_PRIO_NORMAL,
+                  uint8_t flags = 0, dl_done_cb cb = NULL, void *ctx = NULL);
+
+/**
+ * @brief Stop a transfer. Its part stays for a later dl_start to resume
+ */
+bool dl_cancel(uint32_t id);
+
+bool dl_get(uint32_t id, DlStatus *out);
+
+/**
+ * @brief Transfers still queued or running, at most max
+ */
+size_t dl_list(DlStatus *out, size_t max);
+
+void dl_get_stats(DlStats *out);
+
+#endif // DL_MANAGER_H
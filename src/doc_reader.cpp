@@ -0,0 +1,468 @@
+/**
+ * @file      doc_reader.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Document pagination on the job pool, page index files and 1bpp page rendering
+ */
+
+#include "doc_reader.h"
+#include "simple_logger.h"
+#include "sd_manager.h"
+#include "spi_bus.h"
+#include "job_pool.h"
+#include "dir_index.h"
+#include <SD.h>
+#include <esp_heap_caps.h>
+
+static_assert(sizeof(DocIndexHeader) == 32, "Header is part of the file format");
+
+// Most bytes one line can take: a heading marker, cols four-byte
+// characters and a CRLF. Pagination and rendering both look at no more
+// than this from a line's start, so they always break it the same way
+#define DOC_LINE_MAX                (8 + DOC_READER_COLS_MAX * 4 + 8)
+
+struct DocLine {
+    uint16_t start;                 // Shown bytes, from the line's start
+    uint16_t len;
+    uint16_t next;                  // Bytes taken, the break included
+    bool newline;                   // Ended at '\n': the next line starts a paragraph
+};
+
+struct Doc {
+    bool open;
+    char path[DOC_READER_PATH_MAX];
+    const lv_font_t *font;
+    uint16_t w;
+    uint16_t h;
+    uint8_t cols;
+    uint8_t rows;
+    uint8_t flags;
+    lv_coord_t cell_w;
+    lv_coord_t cell_h;
+    uint32_t file_size;
+    uint32_t file_mtime;
+    uint32_t *offsets;              // Page starts, PSRAM
+    volatile uint32_t pages;        // Offsets filled in so far
+    volatile bool done;
+    char *page_buf;                 // rows * DOC_LINE_MAX, PSRAM
+    Job job;
+};
+
+static Doc doc;
+static DocReaderStats doc_stats;
+
+// ===== Layout =====
+
+static inline uint8_t utf8_len(uint8_t c) {
+    return c < 0xC0 ? 1 : c < 0xE0 ? 2 : c < 0xF0 ? 3 : 4;
+}
+
+static uint32_t utf8_decode(const char *p, uint8_t n) {
+    const uint8_t *s = (const uint8_t *)p;
+    switch (n) {
+    case 2: return (s[0] & 0x1F) << 6 | (s[1] & 0x3F);
+    case 3: return (s[0] & 0x0F) << 12 | (s[1] & 0x3F) << 6 | (s[2] & 0x3F);
+    case 4: return (s[0] & 0x07) << 18 | (s[1] & 0x3F) << 12 | (s[2] & 0x3F) << 6 | (s[3] & 0x3F);
+    default: return s[0];
+    }
+}
+
+static inline bool is_space(char c) {
+    return c == ' ' || c == '\t';
+}
+
+// One line of at most cols characters from p; avail is what is left of
+// the document, cut to DOC_LINE_MAX. heading: p starts a source line of
+// a markdown document. '\r' takes no column
+static void layout_line(const char *p, size_t avail, uint8_t cols, bool heading, DocLine *out) {
+    size_t i = 0;
+    out->newline = false;
+    if (heading) {
+        size_t h = 0;
+        while (h < avail && h < 6 && p[h] == '#') {
+            h++;
+        }
+        if (h && h < avail && p[h] == ' ') {
+            i = h + 1;
+        }
+    }
+    out->start = i;
+
+    size_t space = 0;               // Past the last space, 0 for none
+    uint8_t n = 0;
+    while (i < avail) {
+        char c = p[i];
+        if (c == '\n') {
+            out->len = i - out->start;
+            out->next = i + 1;
+            out->newline = true;
+            return;
+        }
+        if (c == '\r') {
+            i++;
+            continue;
+        }
+        if (n == cols) {
+            break;
+        }
+        if (is_space(c)) {
+            space = i + 1;
+        }
+        i += min((size_t)utf8_len(c), avail - i);
+        n++;
+    }
+    if (i >= avail) {
+        out->len = i - out->start;
+        out->next = i;
+        return;
+    }
+
+    // Full: break at the spaces that follow, after the last space, or hard
+    if (is_space(p[i])) {
+        out->len = i - out->start;
+        while (i < avail && (is_space(p[i]) || p[i] == '\r')) {
+            i++;
+        }
+        if (i < avail && p[i] == '\n') {
+            i++;
+            out->newline = true;
+        }
+        out->next = i;
+    } else if (space > out->start) {
+        out->len = space - 1 - out->start;
+        out->next = space;
+    } else {
+        out->len = i - out->start;
+        out->next = i;
+    }
+}
+
+// ===== Pagination =====
+
+static void index_name(const char *path, const char *ext, char *out, size_t len) {
+    snprintf(out, len, "%s%s", path, ext);
+}
+
+static void write_index() {
+    char tmp[DOC_READER_PATH_MAX + 8];
+    char final[DOC_READER_PATH_MAX + 8];
+    index_name(doc.path, ".pgt", tmp, sizeof(tmp));
+    index_name(doc.path, DOC_INDEX_EXT, final, sizeof(final));
+
+    DocIndexHeader h;
+    memset(&h, 0, sizeof(h));
+    h.magic = DOC_INDEX_MAGIC;
+    h.version = DOC_INDEX_VERSION;
+    h.cols = doc.cols;
+    h.rows = doc.rows;
+    h.flags = doc.flags;
+    h.file_size = doc.file_size;
+    h.file_mtime = doc.file_mtime;
+    h.pages = doc.pages;
+
+    SpiBusHold bus(SPI_CLIENT_SD);
+    if (!sd_manager_mounted()) {
+        return;
+    }
+    File f = SD.open(tmp, FILE_WRITE);
+    size_t bytes = h.pages * sizeof(uint32_t);
+    bool ok = f && f.write((const uint8_t *)&h, sizeof(h)) == sizeof(h) &&
+              f.write((const uint8_t *)doc.offsets, bytes) == bytes;
+    if (f) {
+        f.close();
+    }
+    if (ok) {
+        SD.remove(final);
+        ok = SD.rename(tmp, final);
+        dir_index_touch(final);
+    }
+    if (!ok) {
+        SD.remove(tmp);
+        LOG_WARNF("Doc", "Could not write %s", final);
+    }
+}
+
+// Fills doc.offsets as it goes, so the first pages can be read at once
+static void paginate_job(Job *job) {
+    uint32_t start = millis();
+    char *buf = (char *)heap_caps_malloc(DOC_READER_CHUNK, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    File f;
+    {
+        SpiBusHold bus(SPI_CLIENT_SD);
+        if (buf && sd_manager_mounted()) {
+            f = SD.open(doc.path, FILE_READ);
+        }
+    }
+    if (!f) {
+        heap_caps_free(buf);
+        doc.done = true;
+        return;
+    }
+
+    uint32_t base = 0;              // Document offset of buf[0]
+    size_t len = 0;
+    size_t pos = 0;
+    bool eof = false;
+    uint8_t row = 0;
+    bool truncated = false;
+    bool markdown = doc.flags & DOC_READER_FLAG_MARKDOWN;
+    bool para = true;
+    while (true) {
+        if (!eof && len - pos < DOC_LINE_MAX) {
+            if (job_cancelled(job)) {
+                break;
+            }
+            memmove(buf, buf + pos, len - pos);
+            base += pos;
+            len -= pos;
+            pos = 0;
+            SpiBusHold bus(SPI_CLIENT_SD);
+            int n = sd_manager_mounted() ? f.read((uint8_t *)buf + len, DOC_READER_CHUNK - len) : 0;
+            if (n <= 0) {
+                eof = true;
+            } else {
+                len += n;
+            }
+        }
+        if (pos >= len) {
+            break;
+        }
+        if (row == doc.rows) {
+            if (doc.pages >= DOC_READER_PAGES_MAX) {
+                truncated = true;
+                break;
+            }
+            doc.offsets[doc.pages] = base + pos;
+            doc.pages = doc.pages + 1;
+            row = 0;
+        }
+        DocLine l;
+        layout_line(buf + pos, min(len - pos, (size_t)DOC_LINE_MAX), doc.cols, markdown && para, &l);
+        pos += l.next;
+        para = l.newline;
+        row++;
+    }
+    bool complete = eof && pos >= len;
+    {
+        SpiBusHold bus(SPI_CLIENT_SD);
+        f.close();
+    }
+    heap_caps_free(buf);
+
+    if (complete || truncated) {
+        write_index();
+        uint32_t ms = millis() - start;
+        doc_stats.paginations++;
+        doc_stats.paginate_max_ms = max(doc_stats.paginate_max_ms, ms);
+        LOG_INFOF("Doc", "%s: %lu pages%s in %lu ms", doc.path, (unsigned long)doc.pages,
+                  truncated ? " (truncated)" : "", (unsigned long)ms);
+    }
+    doc.done = true;
+}
+
+static bool load_index() {
+    char p[DOC_READER_PATH_MAX + 8];
+    index_name(doc.path, DOC_INDEX_EXT, p, sizeof(p));
+    if (!SD.exists(p)) {
+        return false;
+    }
+    File f = SD.open(p, FILE_READ);
+    DocIndexHeader h;
+    if (!f || f.read((uint8_t *)&h, sizeof(h)) != sizeof(h)) {
+        return false;
+    }
+    if (h.magic != DOC_INDEX_MAGIC || h.version != DOC_INDEX_VERSION || h.cols != doc.cols ||
+        h.rows != doc.rows || h.flags != doc.flags || h.file_size != doc.file_size ||
+        h.file_mtime != doc.file_mtime || !h.pages || h.pages > DOC_READER_PAGES_MAX) {
+        return false;
+    }
+    size_t bytes = h.pages * sizeof(uint32_t);
+    if (f.read((uint8_t *)doc.offsets, bytes) != bytes) {
+        return false;
+    }
+    doc.pages = h.pages;
+    return true;
+}
+
+// ===== Rendering =====
+
+static void draw_glyph(uint8_t *bits, lv_coord_t x, lv_coord_t y, uint32_t letter) {
+    lv_font_glyph_dsc_t g;
+    if (!lv_font_get_glyph_dsc(doc.font, &g, letter, 0) || !g.box_w || !g.box_h) {
+        return;
+    }
+    // Cached Mono glyphs are 1bpp already; others are cut at half coverage
+    if (g.bpp != 1 && g.bpp != 2 && g.bpp != 4 && g.bpp != 8) {
+        return;
+    }
+    const uint8_t *src = lv_font_get_glyph_bitmap(g.resolved_font, letter);
+    if (!src) {
+        return;
+    }
+    lv_coord_t top = doc.font->line_height - doc.font->base_line;
+    lv_coord_t gx = x + g.ofs_x;
+    lv_coord_t gy = y + top - g.box_h - g.ofs_y;
+    uint8_t mask = (1 << g.bpp) - 1;
+    uint8_t half = 1 << (g.bpp - 1);
+    uint16_t stride = doc.w / 8;
+    for (uint16_t r = 0; r < g.box_h; r++) {
+        lv_coord_t py = gy + r;
+        if (py < 0 || py >= doc.h) {
+            continue;
+        }
+        uint32_t bit = (uint32_t)r * g.box_w * g.bpp;
+        for (uint16_t c = 0; c < g.box_w; c++, bit += g.bpp) {
+            lv_coord_t px = gx + c;
+            uint8_t v = (src[bit >> 3] >> (8 - g.bpp - (bit & 7))) & mask;
+            if (v >= half && px >= 0 && px < doc.w) {
+                bits[py * stride + (px >> 3)] |= 0x80 >> (px & 7);
+            }
+        }
+    }
+}
+
+static void draw_line(uint8_t *bits, uint8_t row, const char *p, size_t len) {
+    lv_coord_t y = row * doc.cell_h;
+    uint8_t col = 0;
+    for (size_t i = 0; i < len;) {
+        uint8_t n = min((size_t)utf8_len(p[i]), len - i);
+        uint32_t letter = utf8_decode(p + i, n);
+        i += n;
+        if (letter == '\r') {
+            continue;
+        }
+        if (letter > ' ' && letter != 0x7F) {
+            draw_glyph(bits, col * doc.cell_w, y, letter);
+        }
+        col++;
+    }
+}
+
+// ===== API =====
+
+bool doc_reader_open(const char *path, const lv_font_t *font, uint16_t w, uint16_t h) {
+    doc_reader_close();
+    if (strlen(path) + strlen(DOC_INDEX_EXT) >= DOC_READER_PATH_MAX) {
+        return false;
+    }
+
+    memset(&doc, 0, sizeof(doc));
+    strcpy(doc.path, path);
+    doc.font = font;
+    doc.w = w & ~7;
+    doc.h = h;
+    doc.cell_w = max((lv_coord_t)lv_font_get_glyph_width(font, '0', '0'), (lv_coord_t)1);
+    doc.cell_h = max(lv_font_get_line_height(font), (lv_coord_t)1);
+    doc.cols = constrain(doc.w / doc.cell_w, 1, DOC_READER_COLS_MAX);
+    doc.rows = constrain(doc.h / doc.cell_h, 1, DOC_READER_ROWS_MAX);
+    const char *dot = strrchr(path, '.');
+    doc.flags = dot && !strcasecmp(dot, ".md") ? DOC_READER_FLAG_MARKDOWN : 0;
+
+    doc.offsets = (uint32_t *)heap_caps_malloc(DOC_READER_PAGES_MAX * sizeof(uint32_t),
+                                               MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    doc.page_buf = (char *)heap_caps_malloc(doc.rows * DOC_LINE_MAX, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!doc.offsets || !doc.page_buf) {
+        doc.open = true;
+        doc_reader_close();
+        return false;
+    }
+
+    bool indexed = false;
+    {
+        SpiBusHold bus(SPI_CLIENT_SD);
+        File f;
+        if (sd_manager_mounted()) {
+            f = SD.open(path, FILE_READ);
+        }
+        if (!f || f.isDirectory()) {
+            doc.open = true;
+            doc_reader_close();
+            return false;
+        }
+        doc.file_size = f.size();
+        doc.file_mtime = (uint32_t)f.getLastWrite();
+        f.close();
+        indexed = load_index();
+    }
+    doc.open = true;
+    doc_stats.opens++;
+    if (indexed) {
+        doc.done = true;
+        doc_stats.index_hits++;
+        return true;
+    }
+
+    doc.offsets[0] = 0;
+    doc.pages = 1;
+    if (!job_submit(&doc.job, paginate_job, NULL, JOB_PRIO_LOW)) {
+        paginate_job(&doc.job);
+    }
+    return true;
+}
+
+void doc_reader_close() {
+    if (!doc.open) {
+        return;
+    }
+    // The pagination writes into doc.offsets: let it see the cancel first
+    if (!job_cancel(&doc.job)) {
+        while (doc.job.state == JOB_RUNNING) {
+            delay(1);
+        }
+    }
+    heap_caps_free(doc.offsets);
+    heap_caps_free(doc.page_buf);
+    doc.offsets = NULL;
+    doc.page_buf = NULL;
+    doc.open = false;
+}
+
+uint32_t doc_reader_pages(bool *done) {
+    *done = !doc.open || doc.done;
+    return doc.open ? doc.pages : 0;
+}
+
+bool doc_reader_render(uint32_t page, uint8_t *bits) {
+    if (!doc.open || page >= doc.pages) {
+        return false;
+    }
+    uint32_t start = micros();
+    uint32_t at = doc.offsets[page];
+    size_t len = 0;
+    char prev = '\n';
+    {
+        SpiBusHold bus(SPI_CLIENT_SD);
+        if (!sd_manager_mounted()) {
+            return false;
+        }
+        // The byte before tells whether the page starts a source line
+        File f = SD.open(doc.path, FILE_READ);
+        if (!f || !f.seek(at ? at - 1 : 0) || (at && f.read((uint8_t *)&prev, 1) != 1)) {
+            return false;
+        }
+        len = f.read((uint8_t *)doc.page_buf, doc.rows * DOC_LINE_MAX);
+    }
+
+    memset(bits, 0, (doc.w / 8) * doc.h);
+    bool markdown = doc.flags & DOC_READER_FLAG_MARKDOWN;
+    bool para = prev == '\n';
+    size_t pos = 0;
+    for (uint8_t row = 0; row < doc.rows && pos < len; row++) {
+        DocLine l;
+        layout_line(doc.page_buf + pos, min(len - pos, (size_t)DOC_LINE_MAX), doc.cols, markdown && para, &l);
+        draw_line(bits, row, doc.page_buf + pos + l.start, l.len);
+        pos += l.next;
+        para = l.newline;
+    }
+
+    uint32_t us = micros() - start;
+    doc_stats.renders++;
+    doc_stats.render_max_us = max(doc_stats.render_max_us, us);
+    return true;
+}
+
+void doc_reader_get_stats(DocReaderStats *out) {
+    *out = doc_stats;
+}
@@ -0,0 +1,90 @@
+/**
+ * @file      doc_reader.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Text and markdown documents from SD: background page index, pages rendered to 1bpp
+ */
+
+#ifndef DOC_READER_H
+#define DOC_READER_H
+
+#include <Arduino.h>
+#include <lvgl.h>
+
+/**
+ * One document at a time, streamed from the card. The font is a Mono
+ * font, so a page break depends only on the grid of columns and rows the
+ * page holds: lines wrap at the last space that fits, or hard at the
+ * column limit. The byte offset of every page start is worked out on the
+ * job pool, a DOC_READER_CHUNK read at a time, and kept next to the file
+ * as <file>.pgx for that grid, so opening the document again with the
+ * same grid needs no layout at all. Pages are readable as soon as the
+ * pagination reaches them.
+ *
+ * doc_reader_render() lays out one page and draws its glyphs into a
+ * packed 1bpp bitmap, 1 = ink, rows of w / 8 bytes; ui_reader keeps the
+ * neighbouring pages rendered ahead of the page turns.
+ *
+ * Markdown (.md) is shown as its text with the '#' markers of headings
+ * left out. Tabs and other control characters show as a space.
+ *
+ * Index layout, little endian: DocIndexHeader, then pages uint32_t offsets.
+ * Open, render and close from the LVGL task only.
+ */
+
+#define DOC_INDEX_MAGIC             0x47504454  // "TDPG"
+#define DOC_INDEX_VERSION           1
+#define DOC_INDEX_EXT               ".pgx"
+#define DOC_READER_PATH_MAX         64          // As FS_PATH_MAX, the index name included
+#define DOC_READER_PAGES_MAX        16384       // Offsets in PSRAM; later text is not reachable
+#define DOC_READER_COLS_MAX         64
+#define DOC_READER_ROWS_MAX         40
+#define DOC_READER_CHUNK            4096        // Bytes read per hold of the card
+
+#define DOC_READER_FLAG_MARKDOWN    0x01
+
+struct DocIndexHeader {
+    uint32_t magic;
+    uint8_t version;
+    uint8_t cols;
+    uint8_t rows;
+    uint8_t flags;                  // DOC_READER_FLAG_*
+    uint32_t file_size;             // Of the document when indexed
+    uint32_t file_mtime;
+    uint32_t pages;
+    uint8_t reserved[12];
+};
+
+struct DocReaderStats {
+    uint32_t opens;
+    uint32_t index_hits;            // Opened from a valid .pgx
+    uint32_t paginations;
+    uint32_t paginate_max_ms;
+    uint32_t renders;
+    uint32_t render_max_us;
+};
+
+/**
+ * @brief Open path for a w x h pixel page of font; w is rounded down to
+ *        a multiple of 8. Closes the open document first
+ * @return false without a card, for a missing file or a path too long
+ */
+bool doc_reader_open(const char *path, const lv_font_t *font, uint16_t w, uint16_t h);
+void doc_reader_close();
+
+/**
+ * @brief Pages known so far; done once the pagination reached the end
+ */
+uint32_t doc_reader_pages(bool *done);
+
+/**
+ * @brief Draw page into bits, (w / 8) * h bytes
+ * @return false for a page not known yet or a failed read
+ */
+bool doc_reader_render(uint32_t page, uint8_t *bits);
+
+void doc_reader_get_stats(DocReaderStats *out);
+
+#endif // DOC_READER_H
@@ -9,6 +9,8 @@
 
 #include "hardware_manager.h"
 #include "../core/logger.h"
+#include "../power_domain.h"
+#include "../energy_profiler.h"
 #include <SPIFFS.h>
 #include <SD.h>
 #include <algorithm>
@@ -16,6 +18,11 @@
 // Global hardware manager instance
 HardwareManager& Hardware = HardwareManager::getInstance();
 
+static const char* const component_names[] = {
+    "Display", "Touch", "Keyboard", "LoRa", "GPS", "4G", "WiFi",
+    "SD Card", "Battery", "Gyroscope", "Light Sensor", "Audio", "Power Mgmt"
+};
+
 HardwareManager& HardwareManager::getInstance() {
     static HardwareManager instance;
     return instance;
@@ -58,16 +65,17 @@ bool HardwareManager::init() {
     success &= initKeyboard();
     success &= initSDCard();
     success &= initBattery();
-    success &= initGPS();
-    success &= initGyroscope();
-    success &= initLightSensor();
+    success &= initOrDefer(HardwareComponent::GPS, &HardwareManager::initGPS);
+    success &= initOrDefer(HardwareComponent::GYROSCOPE, &HardwareManager::initGyroscope);
+    success &= initOrDefer(HardwareComponent::LIGHT_SENSOR, &HardwareManager::initLightSensor);
     success &= initWiFi();
-    success &= initLoRa();
-    success &= init4G();
-    success &= initAudio();
+    success &= initOrDefer(HardwareComponent::LORA, &HardwareManager::initLoRa);
+    success &= initOrDefer(HardwareComponent::CELLULAR_4G, &HardwareManager::init4G);
+    success &= initOrDefer(HardwareComponent::AUDIO, &HardwareManager::initAudio);
 
     if (success) {
         initialized = true;
+        last_activity = millis();
         logInfo("HardwareManager", "Hardware initialization completed successfully");
     } else {
         logError("HardwareManager", "Hardware initialization failed");
@@ -76,11 +84,64 @@ bool HardwareManager::init() {
     return success;
 }
 
+void HardwareManager::setLazyInit(bool enabled) {
+    lazy_init = enabled;
+}
+
+void HardwareManager::setIdleWarmup(bool enabled, uint32_t idle_ms) {
+    idle_warmup = enabled;
+    warmup_idle_ms = idle_ms;
+}
+
+bool HardwareManager::initOrDefer(HardwareComponent component, InitThunk thunk) {
+    if (!lazy_init) {
+        return (this->*thunk)();
+    }
+
+    // Registered only; the first access or an idle warmup step runs it
+    init_thunks[(int)component] = thunk;
+    return true;
+}
+
+bool HardwareManager::ensureComponent(HardwareComponent component) {
+    int index = (int)component;
+    InitThunk thunk = init_thunks[index];
+    if (thunk) {
+        // One attempt: a failed component stays ERROR instead of retrying on every access
+        init_thunks[index] = nullptr;
+        uint32_t start = millis();
+        bool ok = (this->*thunk)();
+        logInfof("HardwareManager", "Deferred init of %s %s (%lums)", component_names[index],
+                 ok ? "done" : "failed", millis() - start);
+        last_activity = millis();
+    }
+    return component_status[index] == HardwareStatus::READY;
+}
+
+void HardwareManager::warmupDeferred(uint32_t now) {
+    if (!idle_warmup || now - last_activity < warmup_idle_ms) {
+        return;
+    }
+
+    // One component per idle period keeps each stall short
+    for (int i = 0; i < 13; i++) {
+        if (init_thunks[i]) {
+            ensureComponent((HardwareComponent)i);
+            return;
+        }
+    }
+    idle_warmup = false;
+}
+
 void HardwareManager::shutdown() {
     if (!initialized) {
         return;
     }
 
+    for (int i = 0; i < 13; i++) {
+        init_thunks[i] = nullptr;
+    }
+
     logInfo("HardwareManager", "Shutting down hardware...");
 
     // Shutdown components in reverse order
@@ -132,6 +193,8 @@ void HardwareManager::update() {
             // GPS data updated
         }
     }
+
+    warmupDeferred(now);
 }
 
 // === DISPLAY MANAGEMENT ===
@@ -194,13 +257,17 @@ bool HardwareManager::refreshDisplay(DisplayRefreshMode mode) {
 
     switch (mode) {
         case DisplayRefreshMode::FULL:
+            display_driver->epd2.setUpdateClass(GxEPD2_310_GDEQ031T10::UPDATE_FULL_SCREEN);
             display_driver->refresh();
             break;
         case DisplayRefreshMode::PARTIAL:
+            // Partial waveform for the actual temperature, cleaner on larger areas
+            display_driver->epd2.setUpdateClass(GxEPD2_310_GDEQ031T10::UPDATE_ICON);
             display_driver->refresh(true);
             break;
         case DisplayRefreshMode::FAST:
-            // Fast refresh implementation
+            // Fastest partial waveform, meant for text echo
+            display_driver->epd2.setUpdateClass(GxEPD2_310_GDEQ031T10::UPDATE_TEXT);
             display_driver->refresh(true);
             break;
     }
@@ -256,6 +323,7 @@ TouchEvent HardwareManager::getTouchEvent() {
         event.x = point.x;
         event.y = point.y;
         event.pressed = true;
+        last_activity = millis();
     }
 
     return event;
@@ -289,7 +357,7 @@ BatteryInfo HardwareManager::getBatteryInfo() {
 GPSData HardwareManager::getGPSData() {
     GPSData data;
     
-    if (!gps_parser || component_status[(int)HardwareComponent::GPS] != HardwareStatus::READY) {
+    if (!ensureComponent(HardwareComponent::GPS) || !gps_parser) {
         return data;
     }
 
@@ -326,6 +394,9 @@ GPSData HardwareManager::getGPSData() {
 SensorData HardwareManager::getSensorData() {
     SensorData data;
     
+    ensureComponent(HardwareComponent::GYROSCOPE);
+    ensureComponent(HardwareComponent::LIGHT_SENSOR);
+    
     // Implementation will be added when sensor drivers are integrated
     return data;
 }
@@ -335,15 +406,11 @@ SensorData HardwareManager::getSensorData() {
 bool HardwareManager::initPowerManagement() {
     component_status[(int)HardwareComponent::POWER_MANAGEMENT] = HardwareStatus::INITIALIZING;
     
-    // Enable power for various components
-    pinMode(BOARD_GPS_EN, OUTPUT);
-    pinMode(BOARD_1V8_EN, OUTPUT);
-    pinMode(BOARD_6609_EN, OUTPUT);
-    pinMode(BOARD_LORA_EN, OUTPUT);
+    // Rails are switched through the power domains, shared with the other drivers
+    power_domain_begin();
 
     // Enable 1.8V rail for gyroscope
-    digitalWrite(BOARD_1V8_EN, HIGH);
-    delay(100);
+    setComponentPower(HardwareComponent::GYROSCOPE, true);
 
     component_status[(int)HardwareComponent::POWER_MANAGEMENT] = HardwareStatus::READY;
     logInfo("PowerMgmt", "Power management initialized");
@@ -436,8 +503,7 @@ bool HardwareManager::initGPS() {
     component_status[(int)HardwareComponent::GPS] = HardwareStatus::INITIALIZING;
 
     // Enable GPS power
-    digitalWrite(BOARD_GPS_EN, HIGH);
-    delay(100);
+    setComponentPower(HardwareComponent::GPS, true);
 
     try {
         gps_parser = new TinyGPSPlus();
@@ -802,8 +868,7 @@ bool HardwareManager::initLoRa() {
     component_status[(int)HardwareComponent::LORA] = HardwareStatus::INITIALIZING;
 
     // Enable LoRa power
-    digitalWrite(BOARD_LORA_EN, HIGH);
-    delay(100);
+    setComponentPower(HardwareComponent::LORA, true);
 
     try {
         lora_radio = new SX1262(new Module(BOARD_LORA_CS, BOARD_LORA_INT, BOARD_LORA_RST, BOARD_LORA_BUSY));
@@ -834,7 +899,7 @@ bool HardwareManager::initLoRa() {
 }
 
 bool HardwareManager::sendLoRaMessage(const uint8_t* message, size_t length) {
-    if (!lora_radio || component_status[(int)HardwareComponent::LORA] != HardwareStatus::READY) {
+    if (!ensureComponent(HardwareComponent::LORA) || !lora_radio) {
         return false;
     }
 
@@ -843,7 +908,7 @@ bool HardwareManager::sendLoRaMessage(const uint8_t* message, size_t length) {
 }
 
 size_t HardwareManager::receiveLoRaMessage(uint8_t* buffer, size_t max_length) {
-    if (!lora_radio || component_status[(int)HardwareComponent::LORA] != HardwareStatus::READY) {
+    if (!ensureComponent(HardwareComponent::LORA) || !lora_radio) {
         return 0;
     }
 
@@ -858,8 +923,7 @@ bool HardwareManager::init4G() {
     component_status[(int)HardwareComponent::CELLULAR_4G] = HardwareStatus::INITIALIZING;
 
     // Enable 4G modem power
-    digitalWrite(BOARD_6609_EN, HIGH);
-    delay(100);
+    setComponentPower(HardwareComponent::CELLULAR_4G, true);
 
     // Initialize power key pin
     pinMode(BOARD_A7682E_PWRKEY, OUTPUT);
@@ -889,7 +953,7 @@ bool HardwareManager::init4G() {
 }
 
 bool HardwareManager::is4GConnected() {
-    if (component_status[(int)HardwareComponent::CELLULAR_4G] != HardwareStatus::READY) {
+    if (!ensureComponent(HardwareComponent::CELLULAR_4G)) {
         return false;
     }
 
@@ -937,25 +1001,28 @@ uint64_t HardwareManager::getSDCardSize() {
 // === POWER MANAGEMENT ===
 
 void HardwareManager::setComponentPower(HardwareComponent component, bool enabled) {
+    // The same rail users as the peri_* drivers, so neither side cuts the other's part
+    int user = -1;
     switch (component) {
         case HardwareComponent::GPS:
-            digitalWrite(BOARD_GPS_EN, enabled ? HIGH : LOW);
+            user = power_domain_user(PWR_DOMAIN_GPS, "gps");
             break;
         case HardwareComponent::LORA:
-            digitalWrite(BOARD_LORA_EN, enabled ? HIGH : LOW);
+            user = power_domain_user(PWR_DOMAIN_LORA, "lora");
             break;
         case HardwareComponent::CELLULAR_4G:
-            digitalWrite(BOARD_6609_EN, enabled ? HIGH : LOW);
+            user = power_domain_user(PWR_DOMAIN_6609, "a7682e", ENERGY_CELL);
             break;
         case HardwareComponent::GYROSCOPE:
-            digitalWrite(BOARD_1V8_EN, enabled ? HIGH : LOW);
+            user = power_domain_user(PWR_DOMAIN_1V8, "gyro");
             break;
         default:
-            break;
+            return;
     }
 
-    if (enabled) {
-        delay(100); // Allow component to power up
+    uint32_t settle_ms = power_domain_set(user, enabled);
+    if (settle_ms) {
+        delay(settle_ms); // Allow component to power up
     }
 }
 
@@ -995,11 +1062,6 @@ bool HardwareManager::runDiagnostics() {
     bool all_passed = true;
 
     // Check each component
-    const char* component_names[] = {
-        "Display", "Touch", "Keyboard", "LoRa", "GPS", "4G", "WiFi",
-        "SD Card", "Battery", "Gyroscope", "Light Sensor", "Audio", "Power Mgmt"
-    };
-
     for (int i = 0; i < 13; i++) {
         HardwareStatus status = component_status[i];
         const char* status_str = "UNKNOWN";
@@ -1016,6 +1078,10 @@ bool HardwareManager::runDiagnostics() {
                 status_str = "POWER_OFF";
                 break;
             case HardwareStatus::NOT_INITIALIZED:
+                if (init_thunks[i]) {
+                    status_str = "DEFERRED";  // Not used yet, not a failure
+                    break;
+                }
                 status_str = "NOT_INIT";
                 all_passed = false;
                 break;
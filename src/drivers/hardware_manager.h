@@ -158,6 +158,27 @@ public:
      */
     bool init();
 
+    /**
+     * @brief Defer slow peripherals (GPS, LoRa, 4G, gyroscope, light sensor,
+     *        audio) until first use. Call before init()
+     * @param enabled true to register init thunks instead of running them at boot
+     */
+    void setLazyInit(bool enabled);
+
+    /**
+     * @brief Run a deferred component's init thunk if it has not run yet
+     * @param component Hardware component
+     * @return true if the component is ready
+     */
+    bool ensureComponent(HardwareComponent component);
+
+    /**
+     * @brief Bring up deferred components from update() while the device is idle
+     * @param enabled true to enable warmup
+     * @param idle_ms Time without input before each warmup step
+     */
+    void setIdleWarmup(bool enabled, uint32_t idle_ms = 2000);
+
     /**
      * @brief Shutdown all hardware components
      */
@@ -431,6 +452,14 @@ private:
     // Internal state
     bool initialized = false;
     uint32_t last_update = 0;
+
+    // Deferred initialization
+    typedef bool (HardwareManager::*InitThunk)();
+    InitThunk init_thunks[13] = {};
+    bool lazy_init = false;
+    bool idle_warmup = false;
+    uint32_t warmup_idle_ms = 2000;
+    uint32_t last_activity = 0;
     
     // Private initialization methods
     bool initPowerManagement();
@@ -441,6 +470,8 @@ private:
     bool initGyroscope();
     bool initLightSensor();
     bool initAudio();
+    bool initOrDefer(HardwareComponent component, InitThunk thunk);
+    void warmupDeferred(uint32_t now);
     
     // Private utility methods
     void logError(const char* component, const char* message);
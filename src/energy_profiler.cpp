@@ -0,0 +1,355 @@
+/**
+ * @file      energy_profiler.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Energy profiler: a running least-squares fit of gauge current on subsystem duty
+ */
+
+#include "energy_profiler.h"
+#include "simple_logger.h"
+#include "peripheral.h"
+#include "factory.h"
+#include "telemetry_schema.h"
+#include "i2c_bus.h"
+#include "task_stack.h"
+#ifdef INTEGRATION_LAYER_ENABLED
+#include "integration/event_bridge.h"
+#include "integration/config_manager.h"
+#endif
+
+#define ENERGY_MARK_ON      0x100   // SUBSYSTEM_POWER payload: subsystem | ENERGY_MARK_ON
+#define ENERGY_MV_MAX       5000    // A gauge read above this, or zero, failed on the bus
+
+static const char *const energy_names[ENERGY_BUCKETS] = {
+    "display", "lora_tx", "gps", "wifi", "cell", "base",
+};
+
+// Subsystem state, written by energy_apply() from any task
+static portMUX_TYPE energy_mux = portMUX_INITIALIZER_UNLOCKED;
+static bool energy_on[ENERGY_SUBSYSTEMS];
+static uint32_t energy_on_since[ENERGY_SUBSYSTEMS];
+static uint32_t energy_window_on[ENERGY_SUBSYSTEMS];   // On time inside the current sample window
+static uint32_t energy_window_start = 0;
+static EnergyStats energy_stat;
+
+// Fit state, sampling task only. theta[i] is the current drawn while subsystem i is on,
+// theta[ENERGY_BASE] the rest; P the inverse information matrix of recursive least squares
+static float energy_theta[ENERGY_BUCKETS];
+static float energy_p[ENERGY_BUCKETS][ENERGY_BUCKETS];
+
+static TaskHandle_t energy_task_handle = NULL;
+static volatile bool energy_running = false;
+static bool energy_subscribed = false;
+static uint32_t energy_sample_ms = ENERGY_SAMPLE_MS;
+static uint32_t energy_report_ms = ENERGY_REPORT_S * 1000UL;
+
+static inline uint32_t later(uint32_t a, uint32_t b) {
+    return (int32_t)(a - b) > 0 ? a : b;
+}
+
+static void energy_apply(uint32_t value, uint32_t time_ms) {
+    int i = value & 0xFF;
+    bool on = value & ENERGY_MARK_ON;
+    if (i >= ENERGY_SUBSYSTEMS) {
+        return;
+    }
+    
+    portENTER_CRITICAL(&energy_mux);
+    if (on && !energy_on[i]) {
+        energy_on[i] = true;
+        energy_on_since[i] = time_ms;
+        energy_stat.bucket[i].switches++;
+    } else if (!on && energy_on[i]) {
+        // A late off for a window already closed was credited to it in full
+        uint32_t from = later(energy_on_since[i], energy_window_start);
+        if ((int32_t)(time_ms - from) > 0) {
+            energy_window_on[i] += time_ms - from;
+        }
+        energy_on[i] = false;
+    }
+    portEXIT_CRITICAL(&energy_mux);
+}
+
+void energy_mark(EnergySubsystem subsystem, bool on) {
+    uint32_t value = (uint32_t)subsystem | (on ? ENERGY_MARK_ON : 0);
+#ifdef INTEGRATION_LAYER_ENABLED
+    if (energy_subscribed && GlobalEventBridge &&
+        GlobalEventBridge->tryPublish(EventType::SUBSYSTEM_POWER, energy_names[subsystem], value)) {
+        return;
+    }
+#endif
+    energy_apply(value, millis());
+}
+
+const char *energy_subsystem_name(int bucket) {
+    return bucket >= 0 && bucket < ENERGY_BUCKETS ? energy_names[bucket] : "?";
+}
+
+#ifdef INTEGRATION_LAYER_ENABLED
+static void on_subsystem_power(const Event& event, void* context) {
+    const uint32_t *value = event.getPayload<uint32_t>();
+    if (value) {
+        energy_apply(*value, event.getTimestamp());
+    }
+}
+
+static void on_wifi(const Event& event, void* context) {
+    bool up = event.getType() == EventType::WIFI_CONNECTED;
+    energy_apply(ENERGY_WIFI | (up ? ENERGY_MARK_ON : 0), event.getTimestamp());
+}
+#endif
+
+static void fit_reset() {
+    memset(energy_theta, 0, sizeof(energy_theta));
+    memset(energy_p, 0, sizeof(energy_p));
+    for (int i = 0; i < ENERGY_BUCKETS; i++) {
+        energy_p[i][i] = ENERGY_P_INIT;
+    }
+}
+
+// One recursive least-squares step with forgetting; x[ENERGY_BASE] is 1
+static void fit_update(const float *x, float y) {
+    float px[ENERGY_BUCKETS];
+    float denom = ENERGY_FORGET;
+    float err = y;
+    for (int i = 0; i < ENERGY_BUCKETS; i++) {
+        px[i] = 0;
+        for (int j = 0; j < ENERGY_BUCKETS; j++) {
+            px[i] += energy_p[i][j] * x[j];
+        }
+        denom += x[i] * px[i];
+        err -= energy_theta[i] * x[i];
+    }
+    
+    float trace = 0;
+    for (int i = 0; i < ENERGY_BUCKETS; i++) {
+        energy_theta[i] += px[i] / denom * err;
+        for (int j = 0; j < ENERGY_BUCKETS; j++) {
+            energy_p[i][j] = (energy_p[i][j] - px[i] * px[j] / denom) / ENERGY_FORGET;
+        }
+        trace += energy_p[i][i];
+    }
+    
+    // A subsystem that never switches leaves its direction unexcited; forgetting
+    // would grow it without bound and the next switch would swing the fit wildly
+    if (trace > ENERGY_BUCKETS * ENERGY_P_INIT) {
+        float scale = ENERGY_BUCKETS * ENERGY_P_INIT / trace;
+        for (int i = 0; i < ENERGY_BUCKETS; i++) {
+            for (int j = 0; j < ENERGY_BUCKETS; j++) {
+                energy_p[i][j] *= scale;
+            }
+        }
+    }
+}
+
+static void energy_sample() {
+    if (!peri_init_ready(E_PERI_BQ27220)) {
+        return;
+    }
+    // Queued together so the bus merges them into one burst from Voltage to AverageCurrent
+    uint8_t v[2] = {0}, c[2] = {0}, a[2] = {0};
+    const i2c_bus_op_t ops[] = {
+        { CommandVoltage, 2, v },
+        { CommandCurrent, 2, c },
+        { CommandAverageCurrent, 2, a },
+    };
+    if (!i2c_bus_read(I2C_DEV_BQ27220, ops, 3)) {
+        energy_stat.read_errors++;
+        return;
+    }
+    uint16_t mv = v[0] | (v[1] << 8);
+    int16_t ma = (int16_t)(c[0] | (c[1] << 8));
+    int16_t avg = (int16_t)(a[0] | (a[1] << 8));
+    uint32_t now = millis();
+    
+    float x[ENERGY_BUCKETS];
+    uint32_t dt;
+    portENTER_CRITICAL(&energy_mux);
+    dt = now - energy_window_start;
+    for (int i = 0; i < ENERGY_SUBSYSTEMS; i++) {
+        uint32_t on_ms = energy_window_on[i];
+        if (energy_on[i]) {
+            on_ms += now - later(energy_on_since[i], energy_window_start);
+        }
+        on_ms = on_ms > dt ? dt : on_ms;
+        x[i] = dt ? (float)on_ms / dt : 0;
+        energy_stat.bucket[i].on_ms += on_ms;
+        energy_window_on[i] = 0;
+    }
+    energy_window_start = now;
+    portEXIT_CRITICAL(&energy_mux);
+    x[ENERGY_BASE] = 1;
+    
+    if (mv == 0 || mv > ENERGY_MV_MAX) {
+        energy_stat.read_errors++;
+        return;
+    }
+    if (dt == 0) {
+        return;
+    }
+    
+    double hours = dt / 3600000.0;
+    double part[ENERGY_BUCKETS] = {0};
+    double charged = 0;
+    // On input power the charger feeds the load around the battery, so a
+    // small discharge there is not the load either
+    bq25896_snapshot_t chg;
+    bool external = BQ25896_get_snapshot(&chg) && chg.power_good;
+    if (ma >= 0 || external) {
+        // Charging hides the load, so neither the fit nor the buckets move
+        charged = ma > 0 ? ma * hours : 0;
+    } else {
+        float load = -ma;
+        fit_update(x, load);
+    
+        // Subsystems take their fitted share, the base gets what is left, so the
+        // buckets always add up to what the gauge measured
+        double total = load * hours;
+        double sum = 0;
+        for (int i = 0; i < ENERGY_SUBSYSTEMS; i++) {
+            part[i] = (energy_theta[i] > 0 ? energy_theta[i] : 0) * x[i] * hours;
+            sum += part[i];
+        }
+        if (sum > total) {
+            for (int i = 0; i < ENERGY_SUBSYSTEMS; i++) {
+                part[i] *= total / sum;
+            }
+            sum = total;
+        }
+        part[ENERGY_BASE] = total - sum;
+    }
+    
+    portENTER_CRITICAL(&energy_mux);
+    for (int i = 0; i < ENERGY_BUCKETS; i++) {
+        energy_stat.bucket[i].mah += part[i];
+        energy_stat.discharged_mah += part[i];
+        energy_stat.bucket[i].ma = energy_theta[i] > 0 ? energy_theta[i] : 0;
+    }
+    energy_stat.charged_mah += charged;
+    energy_stat.current_ma = ma;
+    energy_stat.avg_current_ma = avg;
+    energy_stat.samples++;
+    portEXIT_CRITICAL(&energy_mux);
+}
+
+static void energy_task(void *param) {
+    uint32_t next = millis() + energy_sample_ms;
+    uint32_t last_report = millis();
+    
+    while (energy_running) {
+        int32_t wait = (int32_t)(next - millis());
+        if (wait > 0) {
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(wait));
+        } else if (wait < -(int32_t)energy_sample_ms) {
+            next = millis();        // Fell behind; the window just gets longer
+        }
+        if (!energy_running) {
+            break;
+        }
+        next += energy_sample_ms;
+        energy_sample();
+    
+        uint32_t now = millis();
+        if (energy_report_ms && now - last_report >= energy_report_ms) {
+            last_report = now;
+            TelemetryEnergy sample;
+            telemetry_sample_energy(&sample);
+            telemetry_publish_mqtt(&telemetry_energy_schema, &sample);
+        }
+    }
+    energy_task_handle = NULL;
+    task_exit();
+}
+
+bool energy_profiler_begin() {
+    if (energy_running) {
+        return true;
+    }
+    
+    uint32_t report_s = ENERGY_REPORT_S;
+#ifdef INTEGRATION_LAYER_ENABLED
+    if (!GET_CONFIG_BOOL("energy", "enabled", true)) {
+        LOG_INFO("Energy", "Profiler disabled by config");
+        return false;
+    }
+    energy_sample_ms = GET_CONFIG_INT("energy", "sample_ms", ENERGY_SAMPLE_MS);
+    report_s = GET_CONFIG_INT("energy", "report_s", ENERGY_REPORT_S);
+#endif
+    energy_sample_ms = energy_sample_ms < 100 ? 100 : energy_sample_ms;
+    energy_report_ms = report_s * 1000UL;
+    
+    energy_profiler_reset();
+    // The modem has no switch event of its own at boot; start from whether it came up
+    energy_apply(ENERGY_CELL | (peri_init_ready(E_PERI_A7682E) ? ENERGY_MARK_ON : 0), millis());
+
+#ifdef INTEGRATION_LAYER_ENABLED
+    if (GlobalEventBridge && !energy_subscribed) {
+        energy_subscribed = GlobalEventBridge->subscribe("Energy", EventType::SUBSYSTEM_POWER, on_subsystem_power);
+        GlobalEventBridge->subscribe("Energy", EventType::WIFI_CONNECTED, on_wifi);
+        GlobalEventBridge->subscribe("Energy", EventType::WIFI_DISCONNECTED, on_wifi);
+    }
+#endif
+
+    energy_running = true;
+    // Samples over I2C and queues MQTT publishes: no flash, so a PSRAM stack
+    if (task_spawn(energy_task, "energy", ENERGY_TASK_STACK, NULL, ENERGY_TASK_PRIORITY,
+                   &energy_task_handle, tskNO_AFFINITY, TASK_STACK_PSRAM_OK) != pdPASS) {
+        energy_running = false;
+        energy_task_handle = NULL;
+        LOG_ERROR("Energy", "Failed to create the sampling task");
+        return false;
+    }
+    
+    LOG_INFOF("Energy", "Sampling the gauge every %lu ms, report every %lu s",
+              (unsigned long)energy_sample_ms, (unsigned long)report_s);
+    return true;
+}
+
+void energy_profiler_end() {
+    if (!energy_running) {
+        return;
+    }
+    energy_running = false;
+    xTaskNotifyGive(energy_task_handle);
+    while (energy_task_handle) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+#ifdef INTEGRATION_LAYER_ENABLED
+    if (GlobalEventBridge && energy_subscribed) {
+        GlobalEventBridge->unsubscribeAll(EventBridge::internSource("Energy"));
+        energy_subscribed = false;
+    }
+#endif
+}
+
+bool energy_profiler_running() {
+    return energy_running;
+}
+
+bool energy_profiler_stats(EnergyStats *out) {
+    if (!out) {
+        return false;
+    }
+    portENTER_CRITICAL(&energy_mux);
+    *out = energy_stat;
+    portEXIT_CRITICAL(&energy_mux);
+    return out->samples > 0;
+}
+
+void energy_profiler_reset() {
+    portENTER_CRITICAL(&energy_mux);
+    uint32_t now = millis();
+    memset(&energy_stat, 0, sizeof(energy_stat));
+    memset(energy_window_on, 0, sizeof(energy_window_on));
+    energy_window_start = now;
+    energy_stat.since_ms = now;
+    portEXIT_CRITICAL(&energy_mux);
+    
+    // Only safe while the sampler is parked; a live reset keeps the fit, which is
+    // about the hardware rather than the counters
+    if (!energy_running) {
+        fit_reset();
+    }
+}
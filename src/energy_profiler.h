@@ -0,0 +1,73 @@
+/**
+ * @file      energy_profiler.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Per-subsystem energy accounting from BQ27220 current samples
+ */
+
+#ifndef ENERGY_PROFILER_H
+#define ENERGY_PROFILER_H
+
+#include <Arduino.h>
+
+#define ENERGY_SAMPLE_MS            1000    // The gauge updates Current() once a second
+#define ENERGY_REPORT_S             300     // Telemetry period, energy.report_s
+#define ENERGY_FORGET               0.998f  // Per sample; the fit follows ~8 min of history
+#define ENERGY_P_INIT               1000.0f // Initial covariance, also the wind-up cap
+#define ENERGY_TASK_PRIORITY        (tskIDLE_PRIORITY + 1)
+#define ENERGY_TASK_STACK           (1024 * 3)
+
+// Subsystems that switch on and off; everything else is the base load
+enum EnergySubsystem {
+    ENERGY_DISPLAY,                 // e-paper refresh in flight
+    ENERGY_LORA_TX,
+    ENERGY_GPS,                     // Acquiring or tracking
+    ENERGY_WIFI,                    // Associated
+    ENERGY_CELL,                    // Modem powered
+    ENERGY_SUBSYSTEMS,
+    ENERGY_BASE = ENERGY_SUBSYSTEMS,
+    ENERGY_BUCKETS,
+};
+
+struct EnergyBucket {
+    double mah;                     // Attributed charge since begin or reset
+    float ma;                       // Fitted current while on; the base load for ENERGY_BASE
+    uint32_t on_ms;
+    uint32_t switches;
+};
+
+struct EnergyStats {
+    EnergyBucket bucket[ENERGY_BUCKETS];
+    double discharged_mah;          // Sum of the buckets
+    double charged_mah;             // Not attributed
+    int16_t current_ma;             // Last sample, positive charging
+    int16_t avg_current_ma;         // Gauge AverageCurrent()
+    uint32_t samples;
+    uint32_t read_errors;
+    uint32_t since_ms;
+};
+
+/**
+ * @brief Start sampling the gauge and listen for SUBSYSTEM_POWER. Reads the "energy" section
+ */
+bool energy_profiler_begin();
+void energy_profiler_end();
+bool energy_profiler_running();
+
+/**
+ * @brief A subsystem switched on or off. Safe from any task; goes through the
+ *        EventBridge as SUBSYSTEM_POWER, or straight in when the bridge is down
+ */
+void energy_mark(EnergySubsystem subsystem, bool on);
+
+const char *energy_subsystem_name(int bucket);
+
+/**
+ * @brief Copy of the accounting; false before the first sample
+ */
+bool energy_profiler_stats(EnergyStats *out);
+void energy_profiler_reset();
+
+#endif // ENERGY_PROFILER_H
@@ -0,0 +1,438 @@
+/**
+ * @file      espnow_link.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     ESP-NOW peer transport: beacons, per-destination batches, LoRa fallback
+ */
+
+#include "espnow_link.h"
+#include <WiFi.h>
+#include <esp_now.h>
+#include <esp_wifi.h>
+#include "net_manager.h"
+#include "peripheral.h"
+#include "simple_logger.h"
+#ifdef INTEGRATION_LAYER_ENABLED
+#include "integration/config_manager.h"
+#endif
+
+#define ESPNOW_EVT_RX       0x01
+#define ESPNOW_EVT_SEND     0x02
+
+struct EspNowBatch {
+    bool used;
+    bool full;                      // Send without waiting out ESPNOW_BATCH_MS
+    uint32_t node;
+    uint8_t mac[6];
+    uint32_t opened;                // millis() of the first payload
+    uint8_t count;
+    uint16_t len;
+    uint8_t frame[ESPNOW_FRAME_MAX];
+};
+
+struct EspNowRxFrame {
+    uint8_t mac[6];
+    uint8_t len;
+    uint8_t data[ESPNOW_FRAME_MAX];
+};
+
+static const uint8_t espnow_broadcast_mac[6] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+
+static TaskHandle_t espnow_task_handle = NULL;
+static QueueHandle_t espnow_rx_queue = NULL;
+static SemaphoreHandle_t espnow_sent_sem = NULL;
+static volatile bool espnow_sent_ok = false;
+static uint32_t espnow_node = 0;
+static uint16_t espnow_seq = 0;
+static uint32_t espnow_next_beacon = 0;
+
+// Shared with the senders' tasks
+static portMUX_TYPE espnow_mux = portMUX_INITIALIZER_UNLOCKED;
+static EspNowPeer espnow_peers[ESPNOW_PEERS];
+static EspNowBatch espnow_batches[ESPNOW_BATCH_SLOTS];
+static EspNowStats espnow_stats;
+
+static inline bool peer_fresh(const EspNowPeer *p, uint32_t now) {
+    return p->last_heard && now - p->last_heard < ESPNOW_PEER_FRESH_MS;
+}
+
+// ===== Radio callbacks, on the WiFi task =====
+
+static void espnow_on_recv(const uint8_t *mac, const uint8_t *data, int len) {
+    if (len < ESPNOW_HEADER_SIZE || len > ESPNOW_FRAME_MAX || data[0] != ESPNOW_LINK_MAGIC) {
+        return;
+    }
+    EspNowRxFrame rx;
+    memcpy(rx.mac, mac, sizeof(rx.mac));
+    rx.len = len;
+    memcpy(rx.data, data, len);
+    if (xQueueSend(espnow_rx_queue, &rx, 0) == pdTRUE) {
+        xTaskNotify(espnow_task_handle, ESPNOW_EVT_RX, eSetBits);
+    }
+}
+
+static void espnow_on_sent(const uint8_t *mac, esp_now_send_status_t status) {
+    espnow_sent_ok = status == ESP_NOW_SEND_SUCCESS;
+    xSemaphoreGive(espnow_sent_sem);
+}
+
+// ===== Peers =====
+
+// Returns true for a neighbour that was unknown or gone quiet; a displaced
+// one's MAC goes to evicted so its ESP-NOW registration can be dropped
+static bool peer_heard(uint32_t node, const uint8_t *mac, uint8_t *evicted, bool *did_evict) {
+    uint32_t now = millis() | 1;
+    *did_evict = false;
+    portENTER_CRITICAL(&espnow_mux);
+    EspNowPeer *slot = NULL;
+    for (int i = 0; i < ESPNOW_PEERS; i++) {
+        EspNowPeer *p = &espnow_peers[i];
+        if (p->node == node && (p->last_heard || p->frames)) {
+            slot = p;
+            break;
+        }
+        if (!slot || p->last_heard < slot->last_heard) {
+            slot = p;
+        }
+    }
+    bool fresh = slot->node != node || !peer_fresh(slot, now);
+    if (slot->node != node) {
+        if (slot->frames) {
+            memcpy(evicted, slot->mac, sizeof(slot->mac));
+            *did_evict = true;
+        }
+        memset(slot, 0, sizeof(*slot));
+        slot->node = node;
+    }
+    memcpy(slot->mac, mac, sizeof(slot->mac));
+    slot->last_heard = now;
+    slot->frames++;
+    portEXIT_CRITICAL(&espnow_mux);
+    return fresh;
+}
+
+static void peer_failed(uint32_t node) {
+    portENTER_CRITICAL(&espnow_mux);
+    for (int i = 0; i < ESPNOW_PEERS; i++) {
+        if (espnow_peers[i].node == node) {
+            espnow_peers[i].last_heard = 0;
+        }
+    }
+    portEXIT_CRITICAL(&espnow_mux);
+}
+
+static bool peer_register(const uint8_t *mac) {
+    if (esp_now_is_peer_exist(mac)) {
+        return true;
+    }
+    esp_now_peer_info_t info = {};
+    memcpy(info.peer_addr, mac, sizeof(info.peer_addr));
+    info.channel = 0;               // Whatever the radio is on
+    info.ifidx = WIFI_IF_STA;
+    info.encrypt = false;
+    return esp_now_add_peer(&info) == ESP_OK;
+}
+
+// ===== Sending =====
+
+static bool send_frame(const uint8_t *mac, uint8_t *frame, size_t len) {
+    EspNowHeader *h = (EspNowHeader *)frame;
+    h->seq = espnow_seq++;
+    if (!peer_register(mac)) {
+        return false;
+    }
+    xSemaphoreTake(espnow_sent_sem, 0);
+    uint32_t start = micros();
+    bool ok = esp_now_send(mac, frame, len) == ESP_OK &&
+              xSemaphoreTake(espnow_sent_sem, pdMS_TO_TICKS(ESPNOW_SEND_TIMEOUT_MS)) == pdTRUE && espnow_sent_ok;
+    uint32_t us = micros() - start;
+
+    portENTER_CRITICAL(&espnow_mux);
+    if (ok) {
+        espnow_stats.frames_sent++;
+        espnow_stats.ack_us_last = us;
+    } else {
+        espnow_stats.frames_failed++;
+    }
+    portEXIT_CRITICAL(&espnow_mux);
+    return ok;
+}
+
+static void send_beacon() {
+    uint8_t frame[ESPNOW_HEADER_SIZE];
+    EspNowHeader *h = (EspNowHeader *)frame;
+    h->magic = ESPNOW_LINK_MAGIC;
+    h->type = ESPNOW_BEACON;
+    h->src = espnow_node;
+    send_frame(espnow_broadcast_mac, frame, sizeof(frame));
+    espnow_stats.beacons++;
+    espnow_next_beacon = millis() + ESPNOW_BEACON_MS;
+}
+
+// The peer did not answer: its payloads go out over LoRa instead
+static void fall_back(const EspNowBatch *b) {
+    peer_failed(b->node);
+    LOG_DEBUGF("ESPNow", "%08lx did not ACK, %u payloads to LoRa", (unsigned long)b->node, b->count);
+    for (uint16_t pos = ESPNOW_HEADER_SIZE; pos < b->len; pos += 1 + b->frame[pos]) {
+        if (peri_init_ready(E_PERI_LORA) &&
+            lora_tx_enqueue(b->frame + pos + 1, b->frame[pos], LORA_TX_PRIO_NORMAL, LORA_TX_RETRIES)) {
+            portENTER_CRITICAL(&espnow_mux);
+            espnow_stats.fallbacks++;
+            portEXIT_CRITICAL(&espnow_mux);
+        }
+    }
+}
+
+// Send every batch that is full or has waited ESPNOW_BATCH_MS
+static void flush_batches(uint32_t now) {
+    EspNowBatch b;
+    for (;;) {
+        bool found = false;
+        portENTER_CRITICAL(&espnow_mux);
+        for (int i = 0; i < ESPNOW_BATCH_SLOTS; i++) {
+            EspNowBatch *slot = &espnow_batches[i];
+            if (slot->used && (slot->full || now - slot->opened >= ESPNOW_BATCH_MS)) {
+                b = *slot;
+                slot->used = false;
+                found = true;
+                break;
+            }
+        }
+        portEXIT_CRITICAL(&espnow_mux);
+        if (!found) {
+            return;
+        }
+
+        bool broadcast = b.node == NET_PEER_BROADCAST;
+        bool ok = send_frame(b.mac, b.frame, b.len);
+        portENTER_CRITICAL(&espnow_mux);
+        espnow_stats.payloads_sent += b.count;
+        if (b.count > 1) {
+            espnow_stats.payloads_batched += b.count;
+        }
+        portEXIT_CRITICAL(&espnow_mux);
+        // A broadcast also went out over LoRa (net_manager_send)
+        if (!ok && !broadcast) {
+            fall_back(&b);
+        }
+    }
+}
+
+// ===== Receiving =====
+
+static void on_frame(const EspNowRxFrame *rx) {
+    EspNowHeader h;
+    memcpy(&h, rx->data, sizeof(h));
+    if (h.src == espnow_node) {
+        return;
+    }
+    uint8_t evicted[6];
+    bool did_evict;
+    bool fresh = peer_heard(h.src, rx->mac, evicted, &did_evict);
+    if (did_evict && memcmp(evicted, rx->mac, sizeof(evicted)) != 0) {
+        esp_now_del_peer(evicted);
+    }
+    espnow_stats.frames_received++;
+
+    if (h.type == ESPNOW_BEACON) {
+        // Answer a newcomer now rather than at the next beacon
+        if (fresh) {
+            espnow_next_beacon = millis();
+        }
+        return;
+    }
+    if (h.type != ESPNOW_DATA) {
+        return;
+    }
+    for (uint16_t pos = ESPNOW_HEADER_SIZE; pos < rx->len;) {
+        uint8_t len = rx->data[pos++];
+        if (len == 0 || pos + len > rx->len) {
+            break;
+        }
+        if (lora_rx_inject(rx->data + pos, len, 0)) {
+            espnow_stats.payloads_received++;
+        }
+        pos += len;
+    }
+}
+
+// ===== Task =====
+
+static uint32_t wait_ms(uint32_t now) {
+    int32_t wait = (int32_t)(espnow_next_beacon - now);
+    portENTER_CRITICAL(&espnow_mux);
+    for (int i = 0; i < ESPNOW_BATCH_SLOTS; i++) {
+        const EspNowBatch *b = &espnow_batches[i];
+        if (b->used) {
+            int32_t due = b->full ? 0 : (int32_t)(b->opened + ESPNOW_BATCH_MS - now);
+            if (due < wait) {
+                wait = due;
+            }
+        }
+    }
+    portEXIT_CRITICAL(&espnow_mux);
+    return wait > 0 ? wait : 0;
+}
+
+static void espnow_task(void *param) {
+    EspNowRxFrame rx;
+    while (1) {
+        uint32_t bits = 0;
+        xTaskNotifyWait(0, UINT32_MAX, &bits, pdMS_TO_TICKS(wait_ms(millis())));
+        while (xQueueReceive(espnow_rx_queue, &rx, 0) == pdTRUE) {
+            on_frame(&rx);
+        }
+        uint32_t now = millis();
+        flush_batches(now);
+        if ((int32_t)(now - espnow_next_beacon) >= 0) {
+            send_beacon();
+        }
+    }
+}
+
+static const NetPeerTransport espnow_transport = {"ESP-NOW", espnow_link_reaches, espnow_link_send};
+
+// ===== API =====
+
+bool espnow_link_begin() {
+    if (espnow_task_handle) {
+        return true;
+    }
+    uint8_t channel = ESPNOW_DEFAULT_CHANNEL;
+#ifdef INTEGRATION_LAYER_ENABLED
+    if (!GET_CONFIG_BOOL("espnow", "enabled", false)) {
+        return false;
+    }
+    if (GET_CONFIG(LORA_ENCRYPT)) {
+        LOG_WARN("ESPNow", "Frames are not encrypted, staying off while lora.encrypt is on");
+        return false;
+    }
+    channel = GET_CONFIG_INT("espnow", "channel", channel);
+#else
+    return false;
+#endif
+    espnow_node = (uint32_t)(ESP.getEfuseMac() >> 16);     // As lora_crypt
+
+    if (WiFi.getMode() == WIFI_OFF) {
+        WiFi.mode(WIFI_STA);
+    }
+    // Associated, the radio follows the AP and every peer has to as well
+    if (WiFi.status() != WL_CONNECTED) {
+        esp_wifi_set_channel(channel, WIFI_SECOND_CHAN_NONE);
+    }
+    if (esp_now_init() != ESP_OK) {
+        LOG_ERROR("ESPNow", "esp_now_init failed");
+        return false;
+    }
+    espnow_rx_queue = xQueueCreate(ESPNOW_RX_DEPTH, sizeof(EspNowRxFrame));
+    espnow_sent_sem = xSemaphoreCreateBinary();
+    if (!espnow_rx_queue || !espnow_sent_sem) {
+        LOG_ERROR("ESPNow", "Out of memory");
+        return false;
+    }
+    esp_now_register_recv_cb(espnow_on_recv);
+    esp_now_register_send_cb(espnow_on_sent);
+
+    espnow_next_beacon = millis();
+    if (xTaskCreate(espnow_task, "espnow", ESPNOW_TASK_STACK, NULL, ESPNOW_TASK_PRIORITY,
+                    &espnow_task_handle) != pdPASS) {
+        LOG_ERROR("ESPNow", "Failed to start the ESP-NOW task");
+        return false;
+    }
+    net_manager_add_transport(&espnow_transport);
+    LOG_INFOF("ESPNow", "Node %08lx on channel %u", (unsigned long)espnow_node, WiFi.channel());
+    return true;
+}
+
+uint32_t espnow_link_node_id() {
+    return espnow_node;
+}
+
+bool espnow_link_reaches(uint32_t node) {
+    uint32_t now = millis();
+    bool found = false;
+    portENTER_CRITICAL(&espnow_mux);
+    for (int i = 0; i < ESPNOW_PEERS && !found; i++) {
+        const EspNowPeer *p = &espnow_peers[i];
+        found = peer_fresh(p, now) && (node == NET_PEER_BROADCAST || p->node == node);
+    }
+    portEXIT_CRITICAL(&espnow_mux);
+    return found;
+}
+
+bool espnow_link_send(uint32_t node, const uint8_t *data, size_t len) {
+    if (!espnow_task_handle || len == 0 || len > ESPNOW_PAYLOAD_MAX) {
+        return false;
+    }
+    uint32_t now = millis();
+    bool queued = false;
+    portENTER_CRITICAL(&espnow_mux);
+    const uint8_t *mac = node == NET_PEER_BROADCAST ? espnow_broadcast_mac : NULL;
+    for (int i = 0; i < ESPNOW_PEERS && !mac; i++) {
+        if (espnow_peers[i].node == node && peer_fresh(&espnow_peers[i], now)) {
+            mac = espnow_peers[i].mac;
+        }
+    }
+
+    // Into the open frame for this destination, or a new one once it is full
+    EspNowBatch *batch = NULL;
+    EspNowBatch *free_slot = NULL;
+    for (int i = 0; i < ESPNOW_BATCH_SLOTS && mac; i++) {
+        EspNowBatch *b = &espnow_batches[i];
+        if (!b->used) {
+            free_slot = free_slot ? free_slot : b;
+        } else if (b->node == node && !b->full) {
+            if (b->len + 1 + len <= ESPNOW_FRAME_MAX) {
+                batch = b;
+            } else {
+                b->full = true;
+            }
+        }
+    }
+    if (mac && !batch && free_slot) {
+        batch = free_slot;
+        memset(batch, 0, offsetof(EspNowBatch, frame));
+        batch->used = true;
+        batch->node = node;
+        memcpy(batch->mac, mac, sizeof(batch->mac));
+        batch->opened = now;
+        EspNowHeader *h = (EspNowHeader *)batch->frame;
+        h->magic = ESPNOW_LINK_MAGIC;
+        h->type = ESPNOW_DATA;
+        h->src = espnow_node;
+        batch->len = ESPNOW_HEADER_SIZE;
+    }
+    if (batch) {
+        batch->frame[batch->len++] = len;
+        memcpy(batch->frame + batch->len, data, len);
+        batch->len += len;
+        batch->count++;
+        queued = true;
+    }
+    portEXIT_CRITICAL(&espnow_mux);
+
+    if (queued) {
+        xTaskNotify(espnow_task_handle, ESPNOW_EVT_SEND, eSetBits);
+    }
+    return queued;
+}
+
+size_t espnow_link_peers(EspNowPeer *out, size_t max) {
+    size_t n = 0;
+    portENTER_CRITICAL(&espnow_mux);
+    for (int i = 0; i < ESPNOW_PEERS && n < max; i++) {
+        if (espnow_peers[i].frames) {
+            out[n++] = espnow_peers[i];
+        }
+    }
+    portEXIT_CRITICAL(&espnow_mux);
+    return n;
+}
+
+void espnow_link_get_stats(EspNowStats *out) {
+    portENTER_CRITICAL(&espnow_mux);
+    *out = espnow_stats;
+    portEXIT_CRITICAL(&espnow_mux);
+}
@@ -0,0 +1,107 @@
+/**
+ * @file      espnow_link.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     ESP-NOW peer transport: discovery, batching, fall-through to LoRa
+ */
+
+#ifndef ESPNOW_LINK_H
+#define ESPNOW_LINK_H
+
+#include <Arduino.h>
+
+/**
+ * Carries the same payloads as LoRa packets between devices in WiFi range,
+ * in milliseconds and without airtime. Registered with the network
+ * manager as a peer transport, so net_manager_send() picks it for a peer
+ * it has heard from; received payloads go through lora_rx_inject() into
+ * the message store, the link layers and the UI like radio packets.
+ *
+ * Discovery: every device broadcasts a beacon with its node id (the one
+ * lora_crypt uses) every ESPNOW_BEACON_MS and answers a new neighbour's
+ * beacon with its own, so two devices find each other within one round
+ * trip. A neighbour counts as reachable for ESPNOW_PEER_FRESH_MS.
+ *
+ * Batching: payloads for one destination queued within ESPNOW_BATCH_MS
+ * share a frame, one length byte each. A unicast frame the peer does not
+ * acknowledge at the MAC layer is resent over LoRa, payload by payload,
+ * and the peer stops counting as reachable until it is heard again.
+ *
+ * All devices have to be on one WiFi channel: the AP's while associated,
+ * espnow.channel otherwise. Frames are not encrypted, so the link stays
+ * off while lora.encrypt is on.
+ *
+ * Config section "espnow": enabled (false), channel (1).
+ */
+
+#define ESPNOW_LINK_MAGIC           0xD9    // Next to OTA's 0xD8
+#define ESPNOW_FRAME_MAX            250     // ESP_NOW_MAX_DATA_LEN
+#define ESPNOW_HEADER_SIZE          8       // magic, type, src(4), seq(2)
+#define ESPNOW_PAYLOAD_MAX          (ESPNOW_FRAME_MAX - ESPNOW_HEADER_SIZE - 1)
+#define ESPNOW_DEFAULT_CHANNEL      1
+#define ESPNOW_PEERS                16      // Neighbours tracked; ESP-NOW registers at most 20
+#define ESPNOW_BEACON_MS            15000
+#define ESPNOW_PEER_FRESH_MS        45000   // Three beacons
+#define ESPNOW_BATCH_MS             5
+#define ESPNOW_BATCH_SLOTS          4       // Frames being filled at once
+#define ESPNOW_RX_DEPTH             8
+#define ESPNOW_SEND_TIMEOUT_MS      100     // For the MAC-level ACK
+#define ESPNOW_TASK_STACK           (1024 * 3)
+#define ESPNOW_TASK_PRIORITY        (tskIDLE_PRIORITY + 2)
+
+enum EspNowFrameType {
+    ESPNOW_BEACON = 1,              // Header only
+    ESPNOW_DATA,                    // Then length-prefixed payloads
+};
+
+struct EspNowHeader {
+    uint8_t magic;
+    uint8_t type;
+    uint32_t src;                   // Node id
+    uint16_t seq;
+} __attribute__((packed));
+
+struct EspNowPeer {
+    uint32_t node;
+    uint8_t mac[6];
+    uint32_t last_heard;            // millis(), 0 after a failed send
+    uint32_t frames;
+};
+
+struct EspNowStats {
+    uint32_t frames_sent;
+    uint32_t frames_failed;         // No MAC-level ACK
+    uint32_t frames_received;
+    uint32_t payloads_sent;
+    uint32_t payloads_batched;      // Sent in a frame with others
+    uint32_t payloads_received;
+    uint32_t fallbacks;             // Payloads resent over LoRa
+    uint32_t beacons;
+    uint32_t ack_us_last;           // Send to MAC-level ACK
+};
+
+/**
+ * @brief Bring up ESP-NOW (and WiFi in station mode if it is off) and
+ *        register with the network manager
+ */
+bool espnow_link_begin();
+uint32_t espnow_link_node_id();
+
+/**
+ * @brief A neighbour with this node id was heard recently; for
+ *        NET_PEER_BROADCAST, any neighbour at all
+ */
+bool espnow_link_reaches(uint32_t node);
+
+/**
+ * @brief Queue a payload for a neighbour or all of them
+ * @return false when it is too long, there is no room or the peer is unknown
+ */
+bool espnow_link_send(uint32_t node, const uint8_t *data, size_t len);
+
+size_t espnow_link_peers(EspNowPeer *out, size_t max);
+void espnow_link_get_stats(EspNowStats *out);
+
+#endif // ESPNOW_LINK_H
@@ -0,0 +1,675 @@
+/**
+ * @file      event_replay.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Input record and replay: the same touches, keys, packets and sentences, run after run
+ */
+
+#include "event_replay.h"
+#include "simple_logger.h"
+#include "peripheral.h"
+#include "sd_manager.h"
+#include "spi_bus.h"
+#include "fs_service.h"
+#include "input_trace.h"
+#include "metrics.h"
+#include "lvgl_integration.h"
+#include "usb_console.h"
+#include "task_stack.h"
+#include <SD.h>
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+
+#ifdef INTEGRATION_LAYER_ENABLED
+#include "integration/config_manager.h"
+#include "integration/event_bridge.h"
+#endif
+
+static_assert(sizeof(EventReplayHeader) == 16, "Header is part of the file format");
+static_assert(sizeof(EventReplayRecord) == 8, "Record header is part of the file format");
+static_assert((EVENT_REPLAY_RING & (EVENT_REPLAY_RING - 1)) == 0, "EVENT_REPLAY_RING must be a power of two");
+static_assert((EVENT_REPLAY_TOUCH_QUEUE & (EVENT_REPLAY_TOUCH_QUEUE - 1)) == 0,
+              "EVENT_REPLAY_TOUCH_QUEUE must be a power of two");
+
+#define REPLAY_SIG_FLUSH        0x01    // Ring half full
+#define REPLAY_SIG_PLAY         0x02
+#define REPLAY_SIG_STOP         0x04
+
+#define REPLAY_PAYLOAD_MAX      512     // Largest record read back; a LoRa packet is 259
+#define REPLAY_MAX_US           0xF0000000UL    // Stamps are 32-bit; a recording ends before they wrap
+#define REPLAY_WAIT_SLICE_MS    100     // Long waits check for a stop this often
+#define REPLAY_RETRY_MS         1000    // A full queue downstream is waited on this long
+#define REPLAY_STOP_WAIT_MS     3000
+#define REPLAY_SETTLE_MS        5000    // After the last input, for it to reach the glass
+#define REPLAY_BOOT_DELAY_MS    5000    // Configured replay: the services it feeds come up first
+
+static TaskHandle_t replay_task = NULL;
+static SemaphoreHandle_t replay_mode_lock = NULL;   // Start and stop
+static volatile uint8_t replay_mode = REPLAY_IDLE;
+static volatile bool replay_stop_req = false;
+static bool replay_sd_client = false;
+static EventReplayStats replay_stats;
+static EventReplayReport replay_report;
+static bool replay_have_report = false;
+static char replay_path[sizeof(EVENT_REPLAY_DIR) + EVENT_REPLAY_NAME_MAX + 8];
+static uint16_t replay_speed = 100;
+static File replay_file;
+static char boot_play[EVENT_REPLAY_NAME_MAX] = "";     // From the config, started by the task
+
+// Recording ring, free-running positions; producers append under the lock,
+// the task alone moves the tail
+static uint8_t *rec_ring = NULL;
+static uint32_t rec_head = 0;
+static uint32_t rec_tail = 0;
+static uint32_t rec_gap = 0;            // Records lost since the last one stored
+static uint32_t rec_start_us = 0;
+static bool rec_kicked = false;         // Flush already requested
+static portMUX_TYPE rec_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// Replay read buffer and the touch queue the UI task drains
+static uint8_t *play_buf = NULL;
+static size_t play_len = 0;
+static size_t play_pos = 0;
+
+typedef struct {
+    int16_t x;
+    int16_t y;
+    bool pressed;
+    uint32_t inject_us;
+} replay_touch_t;
+
+static replay_touch_t touch_queue[EVENT_REPLAY_TOUCH_QUEUE];
+static uint16_t touch_head = 0;
+static uint16_t touch_tail = 0;
+static portMUX_TYPE touch_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static const char *const source_names[REPLAY_SRC_COUNT] = { "key", "touch", "lora", "gps", "gap" };
+
+static bool valid_name(const char *name) {
+    size_t len = strlen(name);
+    if (len == 0 || len >= EVENT_REPLAY_NAME_MAX) {
+        return false;
+    }
+    for (size_t i = 0; i < len; i++) {
+        if (!isalnum((unsigned char)name[i]) && name[i] != '_' && name[i] != '-') {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void set_name(const char *name) {
+    strlcpy(replay_stats.name, name, sizeof(replay_stats.name));
+    snprintf(replay_path, sizeof(replay_path), EVENT_REPLAY_DIR "/%s.trc", name);
+}
+
+// ===== Recording =====
+
+static void ring_put(const void *data, size_t len) {
+    const uint8_t *p = (const uint8_t *)data;
+    for (size_t done = 0; done < len;) {
+        uint32_t off = rec_head & (EVENT_REPLAY_RING - 1);
+        size_t run = min(len - done, (size_t)(EVENT_REPLAY_RING - off));
+        memcpy(rec_ring + off, p + done, run);
+        rec_head += run;
+        done += run;
+    }
+}
+
+void event_replay_record(uint8_t source, const void *a, size_t alen, const void *b, size_t blen) {
+    if (replay_mode != REPLAY_RECORDING || source >= REPLAY_SRC_COUNT) {
+        return;
+    }
+    EventReplayRecord rec = { (uint32_t)micros() - rec_start_us, source, 0, (uint16_t)(alen + blen) };
+    size_t total = sizeof(rec) + alen + blen;
+    bool kick = false;
+
+    portENTER_CRITICAL(&rec_mux);
+    // A gap record goes in first, so the room for it is needed too
+    size_t gap_size = rec_gap ? sizeof(rec) + sizeof(rec_gap) : 0;
+    uint32_t used = rec_head - rec_tail;
+    if (replay_mode != REPLAY_RECORDING) {
+        // Ended since the check above: the last flush has been taken
+    } else if (used + gap_size + total > EVENT_REPLAY_RING) {
+        rec_gap++;
+        replay_stats.dropped++;
+    } else {
+        if (rec_gap) {
+            EventReplayRecord gap = { rec.t_us, REPLAY_SRC_GAP, 0, sizeof(rec_gap) };
+            ring_put(&gap, sizeof(gap));
+            ring_put(&rec_gap, sizeof(rec_gap));
+            replay_stats.records[REPLAY_SRC_GAP]++;
+            rec_gap = 0;
+        }
+        ring_put(&rec, sizeof(rec));
+        ring_put(a, alen);
+        if (blen) {
+            ring_put(b, blen);
+        }
+        replay_stats.records[source]++;
+        used = rec_head - rec_tail;
+        if (used > replay_stats.ring_peak) {
+            replay_stats.ring_peak = used;
+        }
+        kick = used >= EVENT_REPLAY_RING / 2 && !rec_kicked;
+        rec_kicked |= kick;
+    }
+    portEXIT_CRITICAL(&rec_mux);
+
+    if (kick) {
+        xTaskNotify(replay_task, REPLAY_SIG_FLUSH, eSetBits);
+    }
+}
+
+bool event_replay_recording() {
+    return replay_mode == REPLAY_RECORDING;
+}
+
+// Task: everything in the ring to the card, in contiguous runs
+static bool rec_flush() {
+    portENTER_CRITICAL(&rec_mux);
+    uint32_t head = rec_head;
+    uint32_t tail = rec_tail;
+    rec_kicked = false;
+    portEXIT_CRITICAL(&rec_mux);
+
+    if (head == tail) {
+        return true;
+    }
+    SpiBusHold bus(SPI_CLIENT_SD);
+    while (tail != head) {
+        uint32_t off = tail & (EVENT_REPLAY_RING - 1);
+        size_t run = min((size_t)(head - tail), (size_t)(EVENT_REPLAY_RING - off));
+        if (replay_file.write(rec_ring + off, run) != run) {
+            replay_stats.write_errors++;
+            return false;
+        }
+        tail += run;
+        replay_stats.bytes += run;
+        portENTER_CRITICAL(&rec_mux);
+        rec_tail = tail;
+        portEXIT_CRITICAL(&rec_mux);
+    }
+    replay_file.flush();
+    return true;
+}
+
+static void rec_finish() {
+    // Under the lock, so nothing lands in the ring after the last flush
+    portENTER_CRITICAL(&rec_mux);
+    replay_mode = REPLAY_IDLE;
+    portEXIT_CRITICAL(&rec_mux);
+    rec_flush();
+    {
+        SpiBusHold bus(SPI_CLIENT_SD);
+        replay_file.close();
+    }
+    fs_invalidate_usage();
+    LOG_INFOF("Replay", "Recorded %s: %lu keys, %lu touches, %lu packets, %lu GPS chunks, %lu bytes, %lu lost",
+              replay_stats.name, (unsigned long)replay_stats.records[REPLAY_SRC_KEY],
+              (unsigned long)replay_stats.records[REPLAY_SRC_TOUCH],
+              (unsigned long)replay_stats.records[REPLAY_SRC_LORA],
+              (unsigned long)replay_stats.records[REPLAY_SRC_GPS],
+              (unsigned long)replay_stats.bytes, (unsigned long)replay_stats.dropped);
+}
+
+// ===== Replay =====
+
+static bool play_read(void *dst, size_t len) {
+    uint8_t *out = (uint8_t *)dst;
+    while (len) {
+        if (play_pos == play_len) {
+            SpiBusHold bus(SPI_CLIENT_SD);
+            int n = replay_file.read(play_buf, EVENT_REPLAY_READ_CHUNK);
+            if (n <= 0) {
+                return false;
+            }
+            play_len = n;
+            play_pos = 0;
+            replay_stats.bytes += n;
+        }
+        size_t run = min(len, play_len - play_pos);
+        memcpy(out, play_buf + play_pos, run);
+        play_pos += run;
+        out += run;
+        len -= run;
+    }
+    return true;
+}
+
+static bool push_touch(const EventReplayTouch *t) {
+    bool ok = false;
+    portENTER_CRITICAL(&touch_mux);
+    if ((uint16_t)(touch_head - touch_tail) < EVENT_REPLAY_TOUCH_QUEUE) {
+        touch_queue[touch_head++ & (EVENT_REPLAY_TOUCH_QUEUE - 1)] = { t->x, t->y, t->pressed != 0, (uint32_t)micros() };
+        ok = true;
+    }
+    portEXIT_CRITICAL(&touch_mux);
+    if (ok && LVGL) {
+        LVGL->wake();
+    }
+    return ok;
+}
+
+// Where the driver would have handed the input on; false while that queue is full
+static bool inject(const EventReplayRecord *rec, const uint8_t *payload) {
+    switch (rec->source) {
+        case REPLAY_SRC_KEY: {
+            EventReplayKey key;
+            if (rec->len < sizeof(key)) {
+                return true;
+            }
+            memcpy(&key, payload, sizeof(key));
+            return keypad_inject(key.code, key.state);
+        }
+        case REPLAY_SRC_TOUCH: {
+            EventReplayTouch touch;
+            if (rec->len < sizeof(touch)) {
+                return true;
+            }
+            memcpy(&touch, payload, sizeof(touch));
+            return push_touch(&touch);
+        }
+        case REPLAY_SRC_LORA: {
+            EventReplayLora lora;
+            if (rec->len <= sizeof(lora)) {
+                return true;
+            }
+            memcpy(&lora, payload, sizeof(lora));
+            return lora_rx_replay(payload + sizeof(lora), rec->len - sizeof(lora),
+                                  lora.rssi_x2 / 2.0f, lora.snr_x4 / 4.0f);
+        }
+        case REPLAY_SRC_GPS:
+            return gps_replay_feed(payload, rec->len);
+        default:
+            return true;    // Gaps, and sources from a later version
+    }
+}
+
+static uint32_t event_queue_depth() {
+#ifdef INTEGRATION_LAYER_ENABLED
+    return GlobalEventBridge ? GlobalEventBridge->getQueueSize() : 0;
+#else
+    return 0;
+#endif
+}
+
+static uint32_t events_dropped() {
+#ifdef INTEGRATION_LAYER_ENABLED
+    return GlobalEventBridge ? GlobalEventBridge->getEventsDropped() : 0;
+#else
+    return 0;
+#endif
+}
+
+static uint32_t panel_frames() {
+    return LVGL ? LVGL->getProfiler()->getFramesRecorded() : 0;
+}
+
+static void write_results(const EventReplayReport *r) {
+    SpiBusHold bus(SPI_CLIENT_SD);
+    bool fresh = !SD.exists(EVENT_REPLAY_RESULTS);
+    File f = SD.open(EVENT_REPLAY_RESULTS, FILE_APPEND);
+    if (!f) {
+        replay_stats.write_errors++;
+        return;
+    }
+    if (fresh) {
+        f.println("trace,speed,events,duration_ms,lag_max_us,inputs,input_avg_us,input_max_us,"
+                  "frames,queue_max,events_dropped,dispatch_p99_us,refused");
+    }
+    f.printf("%s,%u,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu\n", replay_stats.name, r->speed,
+             (unsigned long)r->events, (unsigned long)r->duration_ms, (unsigned long)r->lag_max_us,
+             (unsigned long)r->inputs, (unsigned long)r->input_avg_us, (unsigned long)r->input_max_us,
+             (unsigned long)r->frames, (unsigned long)r->queue_max, (unsigned long)r->events_dropped,
+             (unsigned long)r->dispatch_p99_us, (unsigned long)replay_stats.dropped);
+    f.close();
+    fs_invalidate_usage();
+}
+
+static void play_run() {
+    static MetricsSnapshot before;
+    static MetricsSnapshot after;
+    static uint8_t payload[REPLAY_PAYLOAD_MAX];
+    EventReplayReport report = {};
+    report.speed = replay_speed;
+
+    input_trace_reset();
+    metrics_snapshot(&before);
+    uint32_t frames_before = panel_frames();
+    uint32_t dropped_before = events_dropped();
+    int64_t start = esp_timer_get_time();
+
+    EventReplayRecord rec;
+    bool corrupt = false;
+    while (!replay_stop_req && play_read(&rec, sizeof(rec))) {
+        if (rec.len > sizeof(payload) || !play_read(payload, rec.len)) {
+            corrupt = true;
+            break;
+        }
+
+        // Paced: sleep towards the due time, a slice at a time
+        int64_t due = replay_speed ? start + (int64_t)rec.t_us * 100 / replay_speed : esp_timer_get_time();
+        int64_t wait;
+        while (!replay_stop_req && (wait = due - esp_timer_get_time()) >= 1000) {
+            vTaskDelay(pdMS_TO_TICKS(min((int64_t)REPLAY_WAIT_SLICE_MS, wait / 1000)));
+        }
+        int64_t late = esp_timer_get_time() - due;
+        if (late > (int64_t)report.lag_max_us) {
+            report.lag_max_us = late;
+        }
+
+        // The pipeline sets the pace when it falls behind, as it would with the real inputs
+        bool ok = inject(&rec, payload);
+        for (int i = 0; !ok && !replay_stop_req && i < REPLAY_RETRY_MS; i++) {
+            vTaskDelay(1);
+            ok = inject(&rec, payload);
+        }
+        if (!ok) {
+            replay_stats.dropped++;
+            continue;
+        }
+        if (rec.source < REPLAY_SRC_COUNT) {
+            replay_stats.records[rec.source]++;
+        }
+        if (rec.source != REPLAY_SRC_GAP) {
+            report.events++;
+        }
+        uint32_t depth = event_queue_depth();
+        if (depth > report.queue_max) {
+            report.queue_max = depth;
+        }
+    }
+
+    // The last inputs reach the glass before the numbers are taken
+    if (!replay_stop_req) {
+        vTaskDelay(pdMS_TO_TICKS(REPLAY_SETTLE_MS));
+    }
+    report.duration_ms = (esp_timer_get_time() - start) / 1000;
+
+    input_trace_stats_t trace;
+    input_trace_get_stats(&trace);
+    for (int i = 0; i < INPUT_SRC_COUNT; i++) {
+        report.inputs += trace.traces[i];
+    }
+    if (report.inputs) {
+        report.input_avg_us = trace.sum_us[INPUT_STAGE_TOTAL] / report.inputs;
+        report.input_max_us = trace.max_us[INPUT_STAGE_TOTAL];
+    }
+    report.frames = panel_frames() - frames_before;
+    report.events_dropped = events_dropped() - dropped_before;
+
+    metrics_snapshot(&after);
+    MetricsHistSnapshot dispatch = after.histograms[METRIC_EVENT_DISPATCH_US];
+    const MetricsHistSnapshot &was = before.histograms[METRIC_EVENT_DISPATCH_US];
+    dispatch.count -= was.count;
+    for (int i = 0; i < METRICS_HIST_BUCKETS; i++) {
+        dispatch.buckets[i] -= was.buckets[i];
+    }
+    report.dispatch_p99_us = metrics_percentile(&dispatch, 99);
+
+    {
+        SpiBusHold bus(SPI_CLIENT_SD);
+        replay_file.close();
+    }
+    replay_report = report;
+    replay_have_report = true;
+    replay_mode = REPLAY_IDLE;
+
+    if (corrupt) {
+        LOG_WARNF("Replay", "%s: record cut short, the rest of the trace is skipped", replay_stats.name);
+    }
+    LOG_INFOF("Replay", "%s at %u%%: %lu events in %lu ms, lag max %lu ms, %lu refused",
+              replay_stats.name, report.speed, (unsigned long)report.events, (unsigned long)report.duration_ms,
+              (unsigned long)(report.lag_max_us / 1000), (unsigned long)replay_stats.dropped);
+    LOG_INFOF("Replay", "Input to glass avg %lu ms, max %lu ms over %lu; %lu frames; event queue max %lu, "
+              "%lu dropped; dispatch p99 %lu us",
+              (unsigned long)(report.input_avg_us / 1000), (unsigned long)(report.input_max_us / 1000),
+              (unsigned long)report.inputs, (unsigned long)report.frames, (unsigned long)report.queue_max,
+              (unsigned long)report.events_dropped, (unsigned long)report.dispatch_p99_us);
+    write_results(&report);
+}
+
+bool event_replay_take_touch(int16_t *x, int16_t *y, bool *pressed, uint32_t *inject_us) {
+    bool got = false;
+    portENTER_CRITICAL(&touch_mux);
+    if (touch_tail != touch_head) {
+        const replay_touch_t *t = &touch_queue[touch_tail++ & (EVENT_REPLAY_TOUCH_QUEUE - 1)];
+        *x = t->x;
+        *y = t->y;
+        *pressed = t->pressed;
+        *inject_us = t->inject_us;
+        got = true;
+    }
+    portEXIT_CRITICAL(&touch_mux);
+    return got;
+}
+
+// ===== Task =====
+
+static void replay_task_fn(void *param) {
+    if (boot_play[0]) {
+        vTaskDelay(pdMS_TO_TICKS(REPLAY_BOOT_DELAY_MS));
+        event_replay_play(boot_play, replay_speed);
+    }
+    while (true) {
+        uint32_t sig = 0;
+        TickType_t wait = replay_mode == REPLAY_RECORDING ? pdMS_TO_TICKS(EVENT_REPLAY_FLUSH_MS) : portMAX_DELAY;
+        xTaskNotifyWait(0, UINT32_MAX, &sig, wait);
+
+        if (replay_mode == REPLAY_RECORDING) {
+            bool ok = rec_flush();
+            if (!ok || replay_stop_req || (uint32_t)micros() - rec_start_us > REPLAY_MAX_US) {
+                if (!ok) {
+                    LOG_ERROR("Replay", "Trace write failed, recording stopped");
+                }
+                rec_finish();
+            }
+        } else if (replay_mode == REPLAY_PLAYING && (sig & REPLAY_SIG_PLAY)) {
+            play_run();
+        }
+    }
+}
+
+// Eject: a recording is written out, a replay ends, before the unmount
+static void replay_detach() {
+    event_replay_stop();
+}
+
+// ===== API =====
+
+static bool open_dir() {
+    if (!sd_manager_mounted()) {
+        LOG_WARN("Replay", "No SD card");
+        return false;
+    }
+    if (!replay_sd_client) {
+        replay_sd_client = sd_manager_add_client("Replay", NULL, replay_detach);
+    }
+    SpiBusHold bus(SPI_CLIENT_SD);
+    return SD.exists(EVENT_REPLAY_DIR) || SD.mkdir(EVENT_REPLAY_DIR);
+}
+
+bool event_replay_record_start(const char *name) {
+    if (!replay_task || !valid_name(name)) {
+        return false;
+    }
+    if (!rec_ring) {
+        rec_ring = (uint8_t *)heap_caps_malloc(EVENT_REPLAY_RING, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (!rec_ring) {
+            LOG_ERROR("Replay", "No memory for the recording ring");
+            return false;
+        }
+    }
+    xSemaphoreTake(replay_mode_lock, portMAX_DELAY);
+    bool ok = replay_mode == REPLAY_IDLE && open_dir();
+    if (ok) {
+        memset(&replay_stats, 0, sizeof(replay_stats));
+        set_name(name);
+        SpiBusHold bus(SPI_CLIENT_SD);
+        replay_file = SD.open(replay_path, FILE_WRITE);
+        EventReplayHeader header = { EVENT_REPLAY_MAGIC, EVENT_REPLAY_VERSION, sizeof(EventReplayHeader),
+                                     millis(), 0 };
+        ok = replay_file && replay_file.write((const uint8_t *)&header, sizeof(header)) == sizeof(header);
+        if (!ok && replay_file) {
+            replay_file.close();
+        }
+    }
+    if (ok) {
+        replay_stats.bytes = sizeof(EventReplayHeader);
+        rec_head = rec_tail = 0;
+        rec_gap = 0;
+        rec_kicked = false;
+        replay_stop_req = false;
+        rec_start_us = micros();
+        replay_stats.mode = REPLAY_RECORDING;
+        replay_mode = REPLAY_RECORDING;
+        xTaskNotify(replay_task, REPLAY_SIG_FLUSH, eSetBits);   // Starts the flush timeout
+        LOG_INFOF("Replay", "Recording inputs to %s", replay_path);
+    }
+    xSemaphoreGive(replay_mode_lock);
+    return ok;
+}
+
+bool event_replay_play(const char *name, uint16_t speed) {
+    if (!replay_task || !valid_name(name)) {
+        return false;
+    }
+    if (!play_buf) {
+        play_buf = (uint8_t *)heap_caps_malloc(EVENT_REPLAY_READ_CHUNK, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (!play_buf) {
+            LOG_ERROR("Replay", "No memory for the read buffer");
+            return false;
+        }
+    }
+    xSemaphoreTake(replay_mode_lock, portMAX_DELAY);
+    bool ok = replay_mode == REPLAY_IDLE && open_dir();
+    if (ok) {
+        memset(&replay_stats, 0, sizeof(replay_stats));
+        set_name(name);
+        SpiBusHold bus(SPI_CLIENT_SD);
+        replay_file = SD.open(replay_path, FILE_READ);
+        EventReplayHeader header;
+        ok = replay_file && replay_file.read((uint8_t *)&header, sizeof(header)) == sizeof(header) &&
+             header.magic == EVENT_REPLAY_MAGIC && header.version == EVENT_REPLAY_VERSION &&
+             header.header_size >= sizeof(header) && replay_file.seek(header.header_size);
+        if (!ok) {
+            LOG_WARNF("Replay", "%s is missing or not a trace", replay_path);
+            if (replay_file) {
+                replay_file.close();
+            }
+        }
+    }
+    if (ok) {
+        play_len = play_pos = 0;
+        replay_speed = speed;
+        replay_stop_req = false;
+        replay_stats.mode = REPLAY_PLAYING;
+        replay_mode = REPLAY_PLAYING;
+        xTaskNotify(replay_task, REPLAY_SIG_PLAY, eSetBits);
+        LOG_INFOF("Replay", "Replaying %s at %u%%", replay_path, speed);
+    }
+    xSemaphoreGive(replay_mode_lock);
+    return ok;
+}
+
+void event_replay_stop() {
+    if (!replay_task) {
+        return;
+    }
+    xSemaphoreTake(replay_mode_lock, portMAX_DELAY);
+    if (replay_mode != REPLAY_IDLE) {
+        replay_stop_req = true;
+        xTaskNotify(replay_task, REPLAY_SIG_STOP, eSetBits);
+        // The task writes out or reports; from the task itself that happens on return
+        for (int i = 0; xTaskGetCurrentTaskHandle() != replay_task && replay_mode != REPLAY_IDLE &&
+                        i < REPLAY_STOP_WAIT_MS / 10; i++) {
+            vTaskDelay(pdMS_TO_TICKS(10));
+        }
+    }
+    xSemaphoreGive(replay_mode_lock);
+}
+
+uint8_t event_replay_mode() {
+    return replay_mode;
+}
+
+void event_replay_get_stats(EventReplayStats *stats) {
+    portENTER_CRITICAL(&rec_mux);
+    *stats = replay_stats;
+    portEXIT_CRITICAL(&rec_mux);
+    stats->mode = replay_mode;
+}
+
+bool event_replay_last_report(EventReplayReport *report) {
+    if (replay_have_report) {
+        *report = replay_report;
+    }
+    return replay_have_report;
+}
+
+static void rpc_replay(Print &out, const char *args) {
+    char verb[8] = "";
+    char name[EVENT_REPLAY_NAME_MAX] = "";
+    unsigned speed = 100;
+    sscanf(args, "%7s %23s %u", verb, name, &speed);
+
+    bool ok;
+    if (!strcmp(verb, "rec")) {
+        ok = event_replay_record_start(name);
+    } else if (!strcmp(verb, "play")) {
+        ok = event_replay_play(name, speed);
+    } else if (!strcmp(verb, "stop")) {
+        event_replay_stop();
+        ok = true;
+    } else if (!verb[0]) {
+        EventReplayStats s;
+        event_replay_get_stats(&s);
+        static const char *const modes[] = { "idle", "recording", "replaying" };
+        out.printf("%s %s, %lu bytes, %lu lost or refused\n", modes[s.mode], s.name,
+                   (unsigned long)s.bytes, (unsigned long)s.dropped);
+        for (int i = 0; i < REPLAY_SRC_COUNT; i++) {
+            out.printf("  %-5s %lu\n", source_names[i], (unsigned long)s.records[i]);
+        }
+        EventReplayReport r;
+        if (event_replay_last_report(&r)) {
+            out.printf("last run: %lu events, %lu ms, input avg %lu us max %lu us, %lu frames, queue max %lu\n",
+                       (unsigned long)r.events, (unsigned long)r.duration_ms, (unsigned long)r.input_avg_us,
+                       (unsigned long)r.input_max_us, (unsigned long)r.frames, (unsigned long)r.queue_max);
+        }
+        return;
+    } else {
+        ok = false;
+    }
+    out.println(ok ? "ok" : "usage: replay [rec NAME | play NAME [SPEED%] | stop]");
+}
+
+bool event_replay_begin() {
+    if (replay_task) {
+        return true;
+    }
+    replay_mode_lock = xSemaphoreCreateMutex();
+    if (!replay_mode_lock) {
+        LOG_ERROR("Replay", "Failed to create the lock");
+        return false;
+    }
+#ifdef INTEGRATION_LAYER_ENABLED
+    String play = GET_CONFIG_STRING("replay", "play", String(""));
+    if (play.length() && valid_name(play.c_str())) {
+        strlcpy(boot_play, play.c_str(), sizeof(boot_play));
+        replay_speed = GET_CONFIG(REPLAY_SPEED);
+    }
+#endif
+    if (task_spawn(replay_task_fn, "replay", EVENT_REPLAY_TASK_STACK, NULL, EVENT_REPLAY_TASK_PRIORITY,
+                   &replay_task, tskNO_AFFINITY, TASK_STACK_PSRAM_OK) != pdPASS) {
+        LOG_ERROR("Replay", "Failed to start the task");
+        return false;
+    }
+    usb_console_rpc("replay", rpc_replay);
+    if (boot_play[0]) {
+        LOG_INFOF("Replay", "Replaying %s once the system is up", boot_play);
+    }
+    return true;
+}
@@ -0,0 +1,168 @@
+/**
+ * @file      event_replay.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Input record and replay: the same touches, keys, packets and sentences, run after run
+ */
+
+#ifndef EVENT_REPLAY_H
+#define EVENT_REPLAY_H
+
+#include <Arduino.h>
+
+/**
+ * Recording takes inputs where the drivers hand them on: keypad codes as
+ * the TCA8418 FIFO gives them, touch samples as the controller reads them,
+ * LoRa packets once opened and unpacked, raw GPS bytes off the UART. Each
+ * is stamped in us from the start and appended to a ring in PSRAM that a
+ * task writes to /replay/<name>.trc once a second. A producer never waits
+ * on the card; records the ring has no room for are counted and leave a
+ * gap record in the trace.
+ *
+ * Replaying feeds them back at the same points (keypad_inject, the touch
+ * queue LVGLIntegration::update() takes from, lora_rx_replay,
+ * gps_replay_feed), at the recorded pace or scaled by speed (percent; 0 is
+ * as fast as the pipeline takes them), so everything above the drivers,
+ * EventBridge included, does the same work each run. The run's report
+ * (input to glass, frames, EventBridge queue depth and drops, replay lag)
+ * is logged and appended to /replay/results.csv, one line per run, to set
+ * builds side by side. Events published by the drivers are regenerated by
+ * the replay, so EventBridge itself is not recorded.
+ *
+ * Recording and replaying exclude each other. The simulator plays the same
+ * files against the sim display, see sim_bench_replay().
+ *
+ * Config section "replay": play names a trace to start once booted, speed
+ * its pace (100).
+ */
+
+#define EVENT_REPLAY_MAGIC          0x50524454UL    // "TDRP"
+#define EVENT_REPLAY_VERSION        1
+#define EVENT_REPLAY_DIR            "/replay"
+#define EVENT_REPLAY_RESULTS        "/replay/results.csv"
+#define EVENT_REPLAY_NAME_MAX       24
+#define EVENT_REPLAY_RING           (32 * 1024)     // Recording, PSRAM, power of two
+#define EVENT_REPLAY_FLUSH_MS       1000
+#define EVENT_REPLAY_READ_CHUNK     4096            // Replay file reads
+#define EVENT_REPLAY_TOUCH_QUEUE    16              // Power of two
+#define EVENT_REPLAY_GPS_BUFFER     1024            // Bytes waiting for gps_task
+#define EVENT_REPLAY_TASK_STACK     (1024 * 4)
+#define EVENT_REPLAY_TASK_PRIORITY  (tskIDLE_PRIORITY + 2)  // Above the UI's inputs it stands in for
+
+enum EventReplaySource {
+    REPLAY_SRC_KEY = 0,             // EventReplayKey
+    REPLAY_SRC_TOUCH,               // EventReplayTouch
+    REPLAY_SRC_LORA,                // EventReplayLora, then the payload
+    REPLAY_SRC_GPS,                 // UART bytes
+    REPLAY_SRC_GAP,                 // uint32_t records lost to a full ring before this one
+    REPLAY_SRC_COUNT
+};
+
+enum EventReplayMode {
+    REPLAY_IDLE = 0,
+    REPLAY_RECORDING,
+    REPLAY_PLAYING,
+};
+
+// File layout, little-endian: the header, then records back to back
+struct EventReplayHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t header_size;           // sizeof(EventReplayHeader), records start here
+    uint32_t start_ms;              // millis() on the recording device, for reference
+    uint32_t reserved;
+};
+
+struct EventReplayRecord {
+    uint32_t t_us;                  // Since the recording started
+    uint8_t source;                 // EventReplaySource
+    uint8_t flags;
+    uint16_t len;                   // Payload bytes that follow
+};
+
+struct EventReplayKey {
+    uint8_t code;                   // TCA8418 key number, see keymap.h
+    uint8_t state;                  // KEYPAD_PRESS or KEYPAD_RELEASE
+    char val;                       // Base layer character, for readers without the keymap
+    uint8_t reserved;
+};
+
+struct EventReplayTouch {
+    int16_t x;
+    int16_t y;
+    uint8_t pressed;
+    uint8_t reserved[3];
+};
+
+struct EventReplayLora {
+    int16_t rssi_x2;                // dBm * 2
+    int8_t snr_x4;                  // dB * 4
+    uint8_t reserved;
+};
+
+struct EventReplayStats {
+    uint8_t mode;                   // EventReplayMode
+    char name[EVENT_REPLAY_NAME_MAX];
+    uint32_t records[REPLAY_SRC_COUNT];     // Recorded, or replayed
+    uint32_t bytes;                 // Written to, or read from, the trace
+    uint32_t dropped;               // Ring full while recording, injection refused while replaying
+    uint32_t write_errors;
+    uint16_t ring_peak;             // Most bytes waiting for the card
+};
+
+// One replay run, as appended to EVENT_REPLAY_RESULTS
+struct EventReplayReport {
+    uint32_t events;
+    uint32_t duration_ms;
+    uint16_t speed;                 // Percent, 0 = unpaced
+    uint32_t lag_max_us;            // Latest an injection came after its due time
+    uint32_t inputs;                // Traced from injection to glass, see input_trace.h
+    uint32_t input_avg_us;
+    uint32_t input_max_us;
+    uint32_t frames;                // Panel updates
+    uint32_t queue_max;             // EventBridge queue depth, sampled at each injection
+    uint32_t events_dropped;        // EventBridge
+    uint32_t dispatch_p99_us;
+};
+
+/**
+ * @brief Register the console command and read the config; starts the
+ *        configured replay
+ */
+bool event_replay_begin();
+
+/**
+ * @brief Record the inputs to /replay/<name>.trc until stopped
+ */
+bool event_replay_record_start(const char *name);
+
+/**
+ * @brief Play /replay/<name>.trc; speed in percent of the recorded pace,
+ *        0 for as fast as it goes
+ */
+bool event_replay_play(const char *name, uint16_t speed);
+
+/**
+ * @brief End a recording (written out) or a replay (reported)
+ */
+void event_replay_stop();
+
+/**
+ * @brief Drivers: one input, a and b concatenated as its payload. Returns
+ *        at once when not recording
+ */
+void event_replay_record(uint8_t source, const void *a, size_t alen, const void *b = NULL, size_t blen = 0);
+bool event_replay_recording();
+
+/**
+ * @brief UI task: a replayed touch sample, with the time it was injected
+ */
+bool event_replay_take_touch(int16_t *x, int16_t *y, bool *pressed, uint32_t *inject_us);
+
+uint8_t event_replay_mode();
+void event_replay_get_stats(EventReplayStats *stats);
+bool event_replay_last_report(EventReplayReport *report);
+
+#endif // EVENT_REPLAY_H
@@ -0,0 +1,127 @@
+/**
+ * @file      fb_rotate.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Quarter-turn rotation of packed 1bpp framebuffers
+ */
+
+#include "fb_rotate.h"
+#include "placement.h"
+#include "job_pool.h"
+#include <string.h>
+
+// 8x8 bit matrix transpose in two 32-bit registers (Hacker's Delight 7-3):
+// out[c] holds column c of the eight input rows, row 0 in the high bit
+static inline void transpose8(const uint8_t* in[8], uint8_t out[8]) {
+    uint32_t x = ((uint32_t)*in[0] << 24) | ((uint32_t)*in[1] << 16) | ((uint32_t)*in[2] << 8) | *in[3];
+    uint32_t y = ((uint32_t)*in[4] << 24) | ((uint32_t)*in[5] << 16) | ((uint32_t)*in[6] << 8) | *in[7];
+    uint32_t t;
+
+    t = (x ^ (x >> 7)) & 0x00AA00AAUL;
+    x = x ^ t ^ (t << 7);
+    t = (y ^ (y >> 7)) & 0x00AA00AAUL;
+    y = y ^ t ^ (t << 7);
+
+    t = (x ^ (x >> 14)) & 0x0000CCCCUL;
+    x = x ^ t ^ (t << 14);
+    t = (y ^ (y >> 14)) & 0x0000CCCCUL;
+    y = y ^ t ^ (t << 14);
+
+    t = (x & 0xF0F0F0F0UL) | ((y >> 4) & 0x0F0F0F0FUL);
+    y = ((x << 4) & 0xF0F0F0F0UL) | (y & 0x0F0F0F0FUL);
+    x = t;
+
+    out[0] = x >> 24; out[1] = x >> 16; out[2] = x >> 8; out[3] = x;
+    out[4] = y >> 24; out[5] = y >> 16; out[6] = y >> 8; out[7] = y;
+}
+
+// Reverse the bit order inside each byte of a word
+static inline uint32_t reverse_bits_in_bytes(uint32_t v) {
+    v = ((v >> 4) & 0x0F0F0F0FUL) | ((v & 0x0F0F0F0FUL) << 4);
+    v = ((v >> 2) & 0x33333333UL) | ((v & 0x33333333UL) << 2);
+    v = ((v >> 1) & 0x55555555UL) | ((v & 0x55555555UL) << 1);
+    return v;
+}
+
+// 180: each row reversed end to end, rows in reverse order; four bytes at a
+// time while they last
+static void PLACE_HOT rotate_180(uint8_t* dst, const uint8_t* src, uint16_t stride, uint16_t height,
+                                 uint16_t y_from, uint16_t y_to) {
+    for (uint16_t y = y_from; y < y_to; y++) {
+        const uint8_t* s = src + (uint32_t)y * stride;
+        uint8_t* d = dst + (uint32_t)(height - 1 - y) * stride + stride;
+        uint16_t b = 0;
+        for (; b + 4 <= stride; b += 4) {
+            uint32_t w;
+            memcpy(&w, s + b, sizeof(w));
+            w = __builtin_bswap32(reverse_bits_in_bytes(w));
+            memcpy(d - b - 4, &w, sizeof(w));
+        }
+        for (; b < stride; b++) {
+            *(d - b - 1) = (uint8_t)reverse_bits_in_bytes(s[b]);
+        }
+    }
+}
+
+// 90 and 270: source block (bx, by) becomes destination rows 8bx..8bx+7 at
+// byte column by, with the block's rows or its output rows taken in reverse
+static void PLACE_HOT rotate_quarter(uint8_t* dst, const uint8_t* src, uint16_t width, uint16_t height, uint8_t turns,
+                                     uint16_t by_from, uint16_t by_to) {
+    const bool first = turns == 1;
+    const uint16_t src_stride = width / 8;
+    const uint16_t dst_stride = height / 8;
+    const uint8_t* in[8];
+    uint8_t out[8];
+
+    for (uint16_t by = by_from; by < by_to; by++) {
+        for (uint8_t r = 0; r < 8; r++) {
+            // Bottom-up for 270 so the block's last row lands in the high bit
+            uint16_t row = by * 8 + (first ? r : 7 - r);
+            in[r] = src + (uint32_t)row * src_stride;
+        }
+        uint16_t col = first ? by : dst_stride - 1 - by;
+
+        for (uint16_t bx = 0; bx < src_stride; bx++) {
+            transpose8(in, out);
+            for (uint8_t r = 0; r < 8; r++) {
+                in[r]++;
+            }
+            for (uint8_t c = 0; c < 8; c++) {
+                uint16_t row = first ? width - 1 - (bx * 8 + c) : bx * 8 + c;
+                dst[(uint32_t)row * dst_stride + col] = out[c];
+            }
+        }
+    }
+}
+
+struct RotateJob {
+    uint8_t* dst;
+    const uint8_t* src;
+    uint16_t width;
+    uint16_t height;
+    uint8_t turns;
+};
+
+// Bands of source rows (180) or of 8-row blocks (90, 270) write disjoint parts of dst
+static void rotate_band(void* ctx, uint32_t from, uint32_t to) {
+    RotateJob* r = (RotateJob*)ctx;
+    if (r->turns == 2) {
+        rotate_180(r->dst, r->src, r->width / 8, r->height, from, to);
+    } else {
+        rotate_quarter(r->dst, r->src, r->width, r->height, r->turns, from, to);
+    }
+}
+
+void fb_rotate(uint8_t* dst, const uint8_t* src, uint16_t width, uint16_t height, uint8_t turns) {
+    turns &= 3;
+    if (turns == 0) {
+        memcpy(dst, src, (uint32_t)width / 8 * height);
+        return;
+    }
+    RotateJob r = { dst, src, width, height, turns };
+    uint32_t rows = turns == 2 ? height : height / 8;
+    uint32_t grain = turns == 2 ? FB_ROTATE_SPLIT_ROWS : FB_ROTATE_SPLIT_ROWS / 8;
+    job_parallel_for(0, rows, grain, rotate_band, &r);
+}
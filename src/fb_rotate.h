@@ -0,0 +1,30 @@
+/**
+ * @file      fb_rotate.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Quarter-turn rotation of packed 1bpp framebuffers
+ */
+
+#ifndef FB_ROTATE_H
+#define FB_ROTATE_H
+
+#include <stdint.h>
+
+#define FB_ROTATE_SPLIT_ROWS    128     // Smallest band handed to the job pool
+
+/**
+ * @brief Rotate a packed frame (MSB first) into the panel's portrait layout.
+ *
+ * turns follows lv_disp_rot_t: the frame was laid out by LVGL for a display
+ * turned that many quarter turns, and lands in dst the way the unrotated
+ * panel expects it. Width and height are the source's and must be multiples
+ * of 8; dst is height x width for odd turns. 90 and 270 move whole 8x8
+ * blocks through a register transpose rather than one pixel at a time.
+ * Frames taller than FB_ROTATE_SPLIT_ROWS are cut into bands that the job
+ * pool rotates on both cores.
+ */
+void fb_rotate(uint8_t* dst, const uint8_t* src, uint16_t width, uint16_t height, uint8_t turns);
+
+#endif // FB_ROTATE_H
@@ -0,0 +1,164 @@
+/**
+ * @file      fixed_string.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Inline fixed-capacity strings and string views for allocation-free hot paths
+ */
+
+#ifndef FIXED_STRING_H
+#define FIXED_STRING_H
+
+#include <Arduino.h>
+#include <ctype.h>
+#include <stdarg.h>
+#include <string.h>
+
+/**
+ * A StrView borrows a NUL-terminated string from a literal, a char array,
+ * an Arduino String or a FixedString, so functions taking names and keys
+ * accept all of them without building a String. It does not own the text:
+ * keep it to the call, and intern or copy what has to outlive it.
+ *
+ * A FixedString<N> holds up to N - 1 characters inline and never touches
+ * the heap; longer text is cut and the cut is remembered in truncated().
+ * Copying one is a memcpy, so they can sit in queues, records and tables.
+ *
+ * Names that are compared often are interned instead, to a pointer or a
+ * small ID (ConfigSection::internKey(), EventBridge::internSource(),
+ * Logger::internComponent()), and compared by that.
+ */
+
+class StrView {
+private:
+    const char* ptr;
+    size_t len;
+
+public:
+    StrView() : ptr(""), len(0) {}
+    StrView(const char* s) : ptr(s ? s : ""), len(s ? strlen(s) : 0) {}
+    StrView(const String& s) : ptr(s.c_str()), len(s.length()) {}
+    StrView(const char* s, size_t n) : ptr(s), len(n) {}   // s[n] must be NUL
+
+    const char* c_str() const { return ptr; }
+    size_t length() const { return len; }
+    bool isEmpty() const { return len == 0; }
+    char operator[](size_t i) const { return ptr[i]; }
+
+    bool equals(StrView other) const { return len == other.len && memcmp(ptr, other.ptr, len) == 0; }
+    int compare(StrView other) const { return strcmp(ptr, other.ptr); }
+    bool startsWith(StrView prefix) const { return len >= prefix.len && memcmp(ptr, prefix.ptr, prefix.len) == 0; }
+
+    bool operator==(StrView other) const { return equals(other); }
+    bool operator!=(StrView other) const { return !equals(other); }
+    bool operator<(StrView other) const { return compare(other) < 0; }
+};
+
+// Ordering for maps keyed by String, so find() takes a StrView without
+// building a String: std::map<String, T, StrViewLess>
+struct StrViewLess {
+    using is_transparent = void;
+    bool operator()(StrView a, StrView b) const { return a < b; }
+};
+
+template <size_t N>
+class FixedString {
+    static_assert(N > 1 && N <= 65535, "FixedString capacity out of range");
+
+private:
+    uint16_t len;
+    bool cut;
+    char buf[N];
+
+public:
+    FixedString() : len(0), cut(false) { buf[0] = 0; }
+    FixedString(StrView s) { assign(s.c_str(), s.length()); }
+    FixedString(const char* s) { assign(s, s ? strlen(s) : 0); }
+
+    FixedString& operator=(StrView s) { assign(s.c_str(), s.length()); return *this; }
+    FixedString& operator=(const char* s) { assign(s, s ? strlen(s) : 0); return *this; }
+
+    void assign(const char* s, size_t n) {
+        len = 0;
+        cut = false;
+        buf[0] = 0;
+        append(s, n);
+    }
+
+    void clear() { len = 0; cut = false; buf[0] = 0; }
+
+    FixedString& append(const char* s, size_t n) {
+        size_t room = N - 1 - len;
+        if (n > room) {
+            n = room;
+            cut = true;
+        }
+        if (n > 0) {
+            memcpy(buf + len, s, n);
+            len += n;
+        }
+        buf[len] = 0;
+        return *this;
+    }
+    FixedString& append(StrView s) { return append(s.c_str(), s.length()); }
+    FixedString& append(char c) { return append(&c, 1); }
+    FixedString& operator+=(StrView s) { return append(s); }
+    FixedString& operator+=(const char* s) { return append(StrView(s)); }
+    FixedString& operator+=(char c) { return append(c); }
+
+    // printf into the free space; returns the characters added
+    size_t appendf(const char* fmt, ...) __attribute__((format(printf, 2, 3))) {
+        va_list args;
+        va_start(args, fmt);
+        size_t added = vappendf(fmt, args);
+        va_end(args);
+        return added;
+    }
+
+    size_t vappendf(const char* fmt, va_list args) {
+        size_t room = N - len;
+        int n = vsnprintf(buf + len, room, fmt, args);
+        if (n < 0) {
+            buf[len] = 0;
+            return 0;
+        }
+        if ((size_t)n >= room) {
+            n = room - 1;
+            cut = true;
+        }
+        len += n;
+        return n;
+    }
+
+    size_t format(const char* fmt, ...) __attribute__((format(printf, 2, 3))) {
+        clear();
+        va_list args;
+        va_start(args, fmt);
+        size_t added = vappendf(fmt, args);
+        va_end(args);
+        return added;
+    }
+
+    void toLowerCase() {
+        for (uint16_t i = 0; i < len; i++) {
+            buf[i] = tolower((unsigned char)buf[i]);
+        }
+    }
+
+    const char* c_str() const { return buf; }
+    size_t length() const { return len; }
+    static constexpr size_t capacity() { return N - 1; }
+    bool isEmpty() const { return len == 0; }
+    bool truncated() const { return cut; }
+    char operator[](size_t i) const { return buf[i]; }
+
+    StrView view() const { return StrView(buf, len); }
+    operator StrView() const { return view(); }
+
+    bool operator==(StrView other) const { return view().equals(other); }
+    bool operator!=(StrView other) const { return !view().equals(other); }
+    bool operator<(StrView other) const { return strcmp(buf, other.c_str()) < 0; }
+};
+
+#endif // FIXED_STRING_H
@@ -0,0 +1,358 @@
+/**
+ * @file      font_pager.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Paged CJK font: index lookup, bitmap reads and the LRU slot cache
+ */
+
+#include "font_pager.h"
+#include "glyph_cache.h"
+#include "simple_logger.h"
+#include "asset_store.h"
+#include <esp_heap_caps.h>
+#include <esp_partition.h>
+#include <SD.h>
+
+#define PAGER_NONE  (-1)
+
+static_assert(sizeof(FontPackHeader) == 32, "Header is part of the file format");
+static_assert(sizeof(FontPackGlyph) == 12, "Index entry is part of the file format");
+
+struct PagerSlot {
+    uint16_t codepoint;             // Valid while linked into a bucket
+    int16_t next;                   // Bucket chain
+    int16_t newer;                  // LRU list, most recent at lru_head
+    int16_t older;
+    uint8_t bitmap[FONT_PAGER_SLOT_BYTES];
+};
+
+static const uint8_t *font_mapped = NULL;   // Blob in the asset pack
+static uint32_t font_mapped_size = 0;
+static const esp_partition_t *font_part = NULL;
+static File font_file;
+static FontPackHeader header;
+static FontPackGlyph *glyphs = NULL;        // The resident index, PSRAM
+static PagerSlot *slots = NULL;             // PSRAM
+static int16_t buckets[FONT_PAGER_BUCKETS];
+static int16_t lru_head = PAGER_NONE;       // Most recently used
+static int16_t lru_tail = PAGER_NONE;
+static uint16_t slots_used = 0;
+static uint8_t *bypass = NULL;              // One oversized glyph, valid until the next
+static uint32_t bypass_len = 0;
+static volatile bool ready = false;
+
+static uint32_t hits = 0;
+static uint32_t misses = 0;
+static uint32_t evictions = 0;
+static uint32_t bypassed = 0;
+static uint32_t read_errors = 0;
+
+static bool paged_get_glyph_dsc(const lv_font_t *font, lv_font_glyph_dsc_t *dsc_out, uint32_t letter,
+                                uint32_t letter_next);
+static const uint8_t *paged_get_glyph_bitmap(const lv_font_t *font, uint32_t letter);
+
+static lv_font_t paged_font = {};
+
+// ===== Source =====
+
+static bool source_read(uint32_t offset, void *dst, uint32_t len) {
+    if (font_mapped) {
+        if ((uint64_t)offset + len > font_mapped_size) {
+            return false;
+        }
+        memcpy(dst, font_mapped + offset, len);
+        return true;
+    }
+    if (font_part) {
+        return esp_partition_read(font_part, offset, dst, len) == ESP_OK;
+    }
+    return font_file && font_file.seek(offset) && font_file.read((uint8_t *)dst, len) == len;
+}
+
+static bool source_open() {
+    font_mapped = asset_store_blob(FONT_PAGER_ASSET, &font_mapped_size);
+    if (font_mapped) {
+        return true;
+    }
+    font_part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                         (esp_partition_subtype_t)FONT_PAGER_PARTITION_SUBTYPE,
+                                         FONT_PAGER_PARTITION_LABEL);
+    if (font_part) {
+        return true;
+    }
+    if (SD.cardType() == CARD_NONE) {
+        return false;
+    }
+    font_file = SD.open(FONT_PAGER_SD_FILE, FILE_READ);
+    return (bool)font_file;
+}
+
+// ===== Index =====
+
+static const FontPackGlyph *find_glyph(uint32_t letter) {
+    if (letter > 0xFFFF) {
+        return NULL;
+    }
+    uint32_t lo = 0;
+    uint32_t hi = header.glyph_count;
+    while (lo < hi) {
+        uint32_t mid = (lo + hi) / 2;
+        if (glyphs[mid].codepoint < letter) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo < header.glyph_count && glyphs[lo].codepoint == letter ? &glyphs[lo] : NULL;
+}
+
+static inline uint32_t bitmap_bytes(const FontPackGlyph *g) {
+    return ((uint32_t)g->box_w * g->box_h + 7) / 8;
+}
+
+// ===== LRU =====
+
+static inline uint32_t bucket_of(uint16_t codepoint) {
+    return (codepoint * 2654435761UL) >> 24 & (FONT_PAGER_BUCKETS - 1);
+}
+
+static void lru_unlink(int16_t i) {
+    PagerSlot *s = &slots[i];
+    if (s->newer != PAGER_NONE) {
+        slots[s->newer].older = s->older;
+    } else {
+        lru_head = s->older;
+    }
+    if (s->older != PAGER_NONE) {
+        slots[s->older].newer = s->newer;
+    } else {
+        lru_tail = s->newer;
+    }
+}
+
+static void lru_push(int16_t i) {
+    slots[i].newer = PAGER_NONE;
+    slots[i].older = lru_head;
+    if (lru_head != PAGER_NONE) {
+        slots[lru_head].newer = i;
+    }
+    lru_head = i;
+    if (lru_tail == PAGER_NONE) {
+        lru_tail = i;
+    }
+}
+
+static void lru_append(int16_t i) {
+    slots[i].older = PAGER_NONE;
+    slots[i].newer = lru_tail;
+    if (lru_tail != PAGER_NONE) {
+        slots[lru_tail].older = i;
+    }
+    lru_tail = i;
+    if (lru_head == PAGER_NONE) {
+        lru_head = i;
+    }
+}
+
+static int16_t lookup(uint16_t codepoint) {
+    for (int16_t i = buckets[bucket_of(codepoint)]; i != PAGER_NONE; i = slots[i].next) {
+        if (slots[i].codepoint == codepoint) {
+            return i;
+        }
+    }
+    return PAGER_NONE;
+}
+
+static void bucket_remove(int16_t index) {
+    int16_t *link = &buckets[bucket_of(slots[index].codepoint)];
+    while (*link != PAGER_NONE) {
+        if (*link == index) {
+            *link = slots[index].next;
+            return;
+        }
+        link = &slots[*link].next;
+    }
+}
+
+static int16_t claim(uint16_t codepoint) {
+    int16_t index;
+    if (slots_used < FONT_PAGER_CACHE_GLYPHS) {
+        index = slots_used++;
+    } else {
+        index = lru_tail;
+        lru_unlink(index);
+        bucket_remove(index);
+        evictions++;
+    }
+    uint32_t bucket = bucket_of(codepoint);
+    slots[index].codepoint = codepoint;
+    slots[index].next = buckets[bucket];
+    buckets[bucket] = index;
+    lru_push(index);
+    return index;
+}
+
+// ===== LVGL font =====
+
+static bool paged_get_glyph_dsc(const lv_font_t *font, lv_font_glyph_dsc_t *dsc_out, uint32_t letter,
+                                uint32_t letter_next) {
+    const FontPackGlyph *g = find_glyph(letter);
+    if (!g) {
+        return false;
+    }
+    dsc_out->adv_w = g->adv_w;
+    dsc_out->box_w = g->box_w;
+    dsc_out->box_h = g->box_h;
+    dsc_out->ofs_x = g->ofs_x;
+    dsc_out->ofs_y = g->ofs_y;
+    dsc_out->bpp = 1;
+    dsc_out->is_placeholder = 0;
+    return true;
+}
+
+static const uint8_t *paged_get_glyph_bitmap(const lv_font_t *font, uint32_t letter) {
+    const FontPackGlyph *g = find_glyph(letter);
+    if (!g) {
+        return NULL;
+    }
+    uint32_t len = bitmap_bytes(g);
+    uint32_t offset = header.bitmap_offset + g->offset;
+
+    if (len > FONT_PAGER_SLOT_BYTES) {
+        bypassed++;
+        if (len > bypass_len) {
+            heap_caps_free(bypass);
+            bypass = (uint8_t *)heap_caps_malloc(len, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+            bypass_len = bypass ? len : 0;
+        }
+        if (!bypass || !source_read(offset, bypass, len)) {
+            read_errors++;
+            return NULL;
+        }
+        return bypass;
+    }
+
+    int16_t index = lookup(g->codepoint);
+    if (index != PAGER_NONE) {
+        hits++;
+        lru_unlink(index);
+        lru_push(index);
+        return slots[index].bitmap;
+    }
+
+    misses++;
+    index = claim(g->codepoint);
+    if (!source_read(offset, slots[index].bitmap, len)) {
+        // Out of every bucket and first in line for the next miss
+        bucket_remove(index);
+        slots[index].codepoint = 0;
+        lru_unlink(index);
+        lru_append(index);
+        read_errors++;
+        return NULL;
+    }
+    return slots[index].bitmap;
+}
+
+// ===== API =====
+
+static void release() {
+    heap_caps_free(glyphs);
+    heap_caps_free(slots);
+    glyphs = NULL;
+    slots = NULL;
+    if (font_file) {
+        font_file.close();
+    }
+    font_mapped = NULL;
+    font_part = NULL;
+}
+
+bool font_pager_begin() {
+    if (ready) {
+        return true;
+    }
+    if (!source_open()) {
+        LOG_INFO("FONT", "No CJK font in flash or on SD");
+        return false;
+    }
+    if (!source_read(0, &header, sizeof(header)) || header.magic != FONT_PACK_MAGIC ||
+        header.version != FONT_PACK_VERSION || header.bpp != 1 || !header.glyph_count) {
+        LOG_WARN("FONT", "CJK font is not a version 1, 1bpp font pack");
+        release();
+        return false;
+    }
+
+    size_t index_len = header.glyph_count * sizeof(FontPackGlyph);
+    glyphs = (FontPackGlyph *)heap_caps_malloc(index_len, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    slots = (PagerSlot *)heap_caps_malloc(sizeof(PagerSlot) * FONT_PAGER_CACHE_GLYPHS,
+                                          MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!glyphs || !slots || !source_read(header.index_offset, glyphs, index_len)) {
+        LOG_WARN("FONT", "CJK font index not loaded");
+        release();
+        return false;
+    }
+
+    for (int i = 0; i < FONT_PAGER_BUCKETS; i++) {
+        buckets[i] = PAGER_NONE;
+    }
+    lru_head = lru_tail = PAGER_NONE;
+    slots_used = 0;
+
+    paged_font.get_glyph_dsc = paged_get_glyph_dsc;
+    paged_font.get_glyph_bitmap = paged_get_glyph_bitmap;
+    paged_font.line_height = header.line_height;
+    paged_font.base_line = header.base_line;
+    paged_font.subpx = LV_FONT_SUBPX_NONE;
+    paged_font.underline_position = -1;
+    paged_font.underline_thickness = 1;
+    ready = true;
+
+    // Published last: LVGL may be drawing, and only looks past a font for a missing glyph
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    lv_font_t *mono[] = { &Font_Mono_Bold_14_cached, &Font_Mono_Bold_15_cached, &Font_Mono_Bold_16_cached,
+                          &Font_Mono_Bold_17_cached, &Font_Mono_Bold_18_cached, &Font_Mono_Bold_19_cached,
+                          &Font_Mono_Bold_20_cached };
+    for (lv_font_t *f : mono) {
+        f->fallback = &paged_font;
+    }
+
+    LOG_INFOF("FONT", "CJK %upx font from %s: %lu glyphs, %u bytes index, %u bytes cache", header.size_px,
+              font_mapped ? "asset pack" : font_part ? "flash" : "SD", (unsigned long)header.glyph_count, (unsigned)index_len,
+              (unsigned)(sizeof(PagerSlot) * FONT_PAGER_CACHE_GLYPHS));
+    return true;
+}
+
+bool font_pager_ready() {
+    return ready;
+}
+
+const lv_font_t *font_pager_font() {
+    return ready ? &paged_font : NULL;
+}
+
+bool font_pager_covers(const char *utf8) {
+    uint32_t i = 0;
+    while (utf8[i]) {
+        uint32_t letter = _lv_txt_encoded_next(utf8, &i);
+        if (letter >= 0x80 && !(ready && find_glyph(letter))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void font_pager_get_stats(FontPagerStats *stats) {
+    if (!stats) {
+        return;
+    }
+    stats->glyphs = ready ? header.glyph_count : 0;
+    stats->hits = hits;
+    stats->misses = misses;
+    stats->evictions = evictions;
+    stats->bypassed = bypassed;
+    stats->read_errors = read_errors;
+    stats->cached = slots_used;
+}
@@ -0,0 +1,102 @@
+/**
+ * @file      font_pager.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     CJK font paged from flash or SD: resident index, PSRAM LRU cache of glyph bitmaps
+ */
+
+#ifndef FONT_PAGER_H
+#define FONT_PAGER_H
+
+#include <Arduino.h>
+#include <lvgl.h>
+
+/**
+ * A full CJK bitmap font is several hundred KB, too much for the firmware
+ * image. It is kept as a packed font file (script/font_pack.py) in a data
+ * partition, or on the SD card when there is none. Only the index, 12
+ * bytes per glyph, is loaded into PSRAM; bitmaps are read on first use
+ * into an LRU cache of FONT_PAGER_CACHE_GLYPHS slots, so memory stays
+ * bounded however much Chinese text is on screen.
+ *
+ * font_pager_begin() hangs the paged font behind the Mono fonts as their
+ * LVGL fallback, so any label shows CJK text without a font change.
+ *
+ * File layout, little endian: FontPackHeader, then glyph_count
+ * FontPackGlyph sorted by codepoint, then the 1bpp bitmaps, rows packed
+ * without padding the way LVGL draws them.
+ *
+ * To keep it in flash instead, add a data partition of subtype
+ * FONT_PAGER_PARTITION_SUBTYPE, e.g. "fonts, data, 0x41, , 0xc0000", and
+ * write the file there with esptool, or put it in the asset pack as blob
+ * FONT_PAGER_ASSET (asset_store.h), where reads are copies out of the
+ * mapping. The asset pack is tried first.
+ */
+
+#define FONT_PACK_MAGIC                 0x50464454  // "TDFP"
+#define FONT_PACK_VERSION               1
+#define FONT_PAGER_PARTITION_SUBTYPE    0x41
+#define FONT_PAGER_PARTITION_LABEL      "fonts"
+#define FONT_PAGER_SD_FILE              "/fonts/cjk16.tdf"
+#define FONT_PAGER_ASSET                "cjk16.tdf"
+#define FONT_PAGER_CACHE_GLYPHS         512
+#define FONT_PAGER_SLOT_BYTES           128     // 1bpp bitmap up to 32x32; larger glyphs bypass the cache
+#define FONT_PAGER_BUCKETS              256     // Power of two
+
+struct FontPackHeader {
+    uint32_t magic;
+    uint8_t version;
+    uint8_t bpp;                    // 1
+    uint8_t line_height;
+    uint8_t base_line;
+    uint32_t glyph_count;
+    uint32_t index_offset;
+    uint32_t bitmap_offset;
+    uint8_t size_px;
+    uint8_t reserved[11];
+};
+
+struct FontPackGlyph {
+    uint16_t codepoint;             // Basic Multilingual Plane only
+    uint8_t adv_w;
+    uint8_t box_w;
+    uint8_t box_h;
+    int8_t ofs_x;
+    int8_t ofs_y;
+    uint8_t reserved;
+    uint32_t offset;                // From bitmap_offset
+};
+
+struct FontPagerStats {
+    uint32_t glyphs;                // In the font
+    uint32_t hits;
+    uint32_t misses;                // Read from flash or SD
+    uint32_t evictions;
+    uint32_t bypassed;              // Too large for a slot
+    uint32_t read_errors;
+    uint16_t cached;
+};
+
+/**
+ * @brief Find the font, load its index and make it the Mono fonts' fallback
+ * @return false when there is no font; the UI stays Latin only
+ */
+bool font_pager_begin();
+
+bool font_pager_ready();
+
+/**
+ * @brief The paged font itself, for a label that should use it directly
+ */
+const lv_font_t *font_pager_font();
+
+/**
+ * @brief Whether every character of a UTF-8 string can be drawn
+ */
+bool font_pager_covers(const char *utf8);
+
+void font_pager_get_stats(FontPagerStats *stats);
+
+#endif // FONT_PAGER_H
@@ -0,0 +1,108 @@
+/**
+ * @file      fs_layout.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Internal flash split into a hot LittleFS volume for small files and a bulk one
+ */
+
+#include "fs_layout.h"
+#include <LittleFS.h>
+#include "simple_logger.h"
+
+struct FsMountProfile {
+    const char *name;
+    const char *label;              // Partition
+    const char *base_path;          // VFS mount point
+    uint8_t max_open;
+    bool format_on_fail;
+};
+
+static const FsMountProfile profiles[FS_VOL_COUNT] = {
+    {"bulk", FS_BULK_LABEL, FS_BULK_PATH, FS_BULK_MAX_OPEN, true},
+    {"hot",  FS_HOT_LABEL,  FS_HOT_PATH,  FS_HOT_MAX_OPEN,  true},
+};
+
+static const FsVolume workload_volume[FS_WL_COUNT] = {
+    FS_VOL_HOT,                     // FS_WL_CONFIG
+    FS_VOL_HOT,                     // FS_WL_INDEX
+    FS_VOL_BULK,                    // FS_WL_BULK
+};
+
+// The bulk volume is the LittleFS object everything else already uses
+static LittleFSFS hot_fs;
+static LittleFSFS *const volumes[FS_VOL_COUNT] = {&LittleFS, &hot_fs};
+
+static FsVolumeInfo info[FS_VOL_COUNT];
+static bool layout_ready = false;
+
+static bool mount_volume(FsVolume v) {
+    const FsMountProfile &p = profiles[v];
+    FsVolumeInfo &st = info[v];
+    uint32_t start = millis();
+
+    st.name = p.name;
+    st.mounted = volumes[v]->begin(false, p.base_path, p.max_open, p.label);
+    if (!st.mounted && p.format_on_fail) {
+        LOG_WARNF("FsLayout", "%s volume mount failed, formatting \"%s\"", p.name, p.label);
+        st.mounted = volumes[v]->begin(true, p.base_path, p.max_open, p.label);
+        st.formatted = st.mounted;
+    }
+    st.mount_ms = millis() - start;
+    if (!st.mounted) {
+        return false;
+    }
+    st.total_bytes = volumes[v]->totalBytes();
+    st.used_bytes = volumes[v]->usedBytes();
+    LOG_INFOF("FsLayout", "%s volume \"%s\" at %s: %lu of %lu KB used, %lu ms%s", p.name, p.label,
+              p.base_path, (unsigned long)(st.used_bytes / 1024), (unsigned long)(st.total_bytes / 1024),
+              (unsigned long)st.mount_ms, st.formatted ? ", formatted" : "");
+    return true;
+}
+
+bool fs_layout_begin() {
+    if (layout_ready) {
+        return true;
+    }
+    memset(info, 0, sizeof(info));
+    if (!mount_volume(FS_VOL_BULK)) {
+        LOG_ERROR("FsLayout", "Failed to mount or format the bulk volume");
+        return false;
+    }
+    // No partition on the old table: begin(true) fails too and the bulk volume stands in
+    if (!mount_volume(FS_VOL_HOT)) {
+        info[FS_VOL_HOT].fallback = true;
+        LOG_WARN("FsLayout", "No \"" FS_HOT_LABEL "\" partition, hot files stay on the bulk volume");
+    }
+    layout_ready = true;
+    return true;
+}
+
+FsVolume fs_volume_of(FsWorkload workload) {
+    FsVolume v = workload < FS_WL_COUNT ? workload_volume[workload] : FS_VOL_BULK;
+    return info[v].mounted ? v : FS_VOL_BULK;
+}
+
+fs::FS *fs_for(FsWorkload workload) {
+    return fs_volume(fs_volume_of(workload));
+}
+
+fs::FS *fs_volume(FsVolume volume) {
+    if (!layout_ready || volume >= FS_VOL_COUNT || !info[volume].mounted) {
+        return NULL;
+    }
+    return volumes[volume];
+}
+
+bool fs_volume_info(FsVolume volume, FsVolumeInfo *out) {
+    if (volume >= FS_VOL_COUNT) {
+        return false;
+    }
+    *out = info[volume];
+    if (info[volume].mounted) {
+        out->used_bytes = volumes[volume]->usedBytes();
+    }
+    out->name = profiles[volume].name;
+    return true;
+}
@@ -0,0 +1,97 @@
+/**
+ * @file      fs_layout.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Internal flash split into a hot LittleFS volume for small files and a bulk one
+ */
+
+#ifndef FS_LAYOUT_H
+#define FS_LAYOUT_H
+
+#include <Arduino.h>
+#include <FS.h>
+
+/**
+ * Two LittleFS volumes on the internal flash (partitions_apps.csv). "hot"
+ * is a small partition for files rewritten often and read at boot: the
+ * configuration with its snapshot and journal, and small indices. The
+ * bulk volume is the "spiffs" partition behind the LittleFS object the
+ * rest of the tree uses, for messages, dictionaries, downloads and the
+ * rest.
+ *
+ * Kept apart, a config save or journal append commits to a directory of
+ * a handful of entries on a volume of a few dozen blocks. It no longer
+ * compacts the bulk root's metadata or scans the bulk allocator, and a
+ * full bulk volume cannot block it. A small file stays inline in its
+ * directory's metadata, so open, stat and append touch one metadata pair.
+ *
+ * Callers name a workload, not a volume: fs_for() maps it through the
+ * table in fs_layout.cpp, and each volume is mounted with its own options
+ * (mount point, open file limit, format on a failed mount). On a device
+ * flashed with the old partition table there is no "hot" partition, and
+ * its workloads fall back to the bulk volume.
+ *
+ * The Arduino core's LittleFS is the prebuilt esp_littlefs component. Its
+ * cache and lookahead sizes come from the core's sdkconfig and cannot be
+ * set at mount time, so the layout is the tuning knob here.
+ *
+ * bench_suite measures open, stat, small append and transactional rename
+ * on each volume ("fs.<volume>.<op>").
+ */
+
+#define FS_BULK_LABEL               "spiffs"
+#define FS_BULK_PATH                "/littlefs"
+#define FS_BULK_MAX_OPEN            10
+#define FS_HOT_LABEL                "hot"
+#define FS_HOT_PATH                 "/hot"
+#define FS_HOT_MAX_OPEN             4       // Config, journal, snapshot and one index
+
+enum FsVolume {
+    FS_VOL_BULK = 0,
+    FS_VOL_HOT,
+    FS_VOL_COUNT,
+};
+
+enum FsWorkload {
+    FS_WL_CONFIG = 0,               // Configuration, snapshot and journal
+    FS_WL_INDEX,                    // Small indices rewritten by rename
+    FS_WL_BULK,                     // Everything else
+    FS_WL_COUNT,
+};
+
+struct FsVolumeInfo {
+    const char *name;
+    bool mounted;
+    bool formatted;                 // Mount failed and the volume was formatted
+    bool fallback;                  // Not mounted; its workloads use the bulk volume
+    uint32_t mount_ms;
+    uint32_t total_bytes;
+    uint32_t used_bytes;
+};
+
+/**
+ * @brief Mount both volumes. Safe to call again
+ * @return false if the bulk volume could not be mounted or formatted
+ */
+bool fs_layout_begin();
+
+/**
+ * @brief The file system for a workload; NULL before a successful begin
+ */
+fs::FS *fs_for(FsWorkload workload);
+
+/**
+ * @brief The volume a workload lands on after any fallback
+ */
+FsVolume fs_volume_of(FsWorkload workload);
+
+/**
+ * @return NULL while the volume is not mounted
+ */
+fs::FS *fs_volume(FsVolume volume);
+
+bool fs_volume_info(FsVolume volume, FsVolumeInfo *out);
+
+#endif // FS_LAYOUT_H
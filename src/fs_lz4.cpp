@@ -0,0 +1,788 @@
+/**
+ * @file      fs_lz4.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Streaming LZ4 frame writer on the FS service, with a block index for seeking
+ */
+
+#include "fs_lz4.h"
+#include "fs_service.h"
+#include "job_pool.h"
+#include "spi_bus.h"
+#include "simple_logger.h"
+#include "usb_console.h"
+#include <SD.h>
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+
+static_assert(FS_LZ4_BLOCK_SIZE <= 65536, "Block offsets are 16 bits in the match table");
+static_assert(sizeof(FsLz4IndexEntry) == 8, "Index entry layout");
+
+// Frame descriptor: version 01, independent blocks, no checksums, 64 KB maximum
+#define LZ4_FLG                 0x60
+#define LZ4_FLG_INDEPENDENT     0x20
+#define LZ4_FLG_BLOCK_CHECKSUM  0x10
+#define LZ4_FLG_CONTENT_SIZE    0x08
+#define LZ4_FLG_DICT_ID         0x01
+#define LZ4_BD                  0x40
+#define LZ4_BLOCK_MAX           65536
+
+// Block format limits
+#define LZ4_MIN_MATCH           4
+#define LZ4_LAST_LITERALS       5       // The last five bytes are always literals
+#define LZ4_MFLIMIT             12      // No match starts in the last twelve
+#define LZ4_MAX_OFFSET          65535
+#define LZ4_SKIP_TRIGGER        6       // Step up through data that does not match
+
+#define LZ4_OUT_SIZE            (4 + FS_LZ4_BLOCK_SIZE)     // Block size field and the worst case, stored
+#define LZ4_TABLE_SIZE          ((size_t)sizeof(uint16_t) << FS_LZ4_HASH_BITS)
+#define LZ4_ZCAT_DEFAULT        1024
+#define LZ4_ZCAT_MAX            4096
+
+enum {
+    LZB_FREE = 0,
+    LZB_FILLING,
+    LZB_SEALED,                 // Waiting in sealed[] for the compress job
+    LZB_OUT,                    // With the FS service
+};
+
+struct FsLz4Block {
+    FsLz4Stream *stream;
+    uint8_t *raw;
+    uint8_t *out;               // Block size field and data
+    uint32_t len;
+    uint32_t raw_offset;
+    FsLz4IndexEntry entry;
+    uint8_t state;
+    uint8_t pending;            // Appends still with the FS service
+};
+
+struct FsLz4Stream {
+    bool in_use;
+    fs::FS *fs;
+    char path[FS_PATH_MAX];
+    char index_path[FS_PATH_MAX];
+    uint8_t *mem;               // Blocks and match table, one PSRAM allocation
+    uint16_t *table;
+    FsLz4Block blocks[FS_LZ4_BUFS];
+    uint8_t sealed[FS_LZ4_BUFS];    // In seal order
+    uint8_t sealed_head;
+    uint8_t sealed_tail;
+    int8_t cur;                 // Writer side: the block being filled
+    uint32_t raw_size;          // Raw bytes in sealed blocks
+    uint32_t file_size;         // Job side: where the next block lands
+    bool busy;                  // A compress job is queued or running
+    bool closing;
+    bool end_queued;
+    bool ended;                 // End mark written, or given up on
+    bool waiting;               // fs_lz4_close() waits and releases the stream itself
+    bool released;
+    uint8_t header[FS_LZ4_FRAME_HEADER];
+    uint8_t end_mark[4];
+    Job jobs[2];                // Outlive the stream: the one finishing may still be marked running
+};
+
+// Slots rather than heap objects, so a job can release its stream and return
+static FsLz4Stream lz4_streams[FS_LZ4_STREAMS];
+static FsLz4Stats lz4_stats;
+static portMUX_TYPE lz4_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static inline void put32(uint8_t *p, uint32_t v) {
+    p[0] = v;
+    p[1] = v >> 8;
+    p[2] = v >> 16;
+    p[3] = v >> 24;
+}
+
+static inline uint32_t get32(const uint8_t *p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline uint32_t read32(const uint8_t *p) {
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+// xxHash32, seed 0, for the few bytes of a frame descriptor
+static uint32_t xxh32_short(const uint8_t *p, size_t len) {
+    const uint32_t P1 = 2654435761U, P2 = 2246822519U, P3 = 3266489917U, P4 = 668265263U, P5 = 374761393U;
+    uint32_t h = P5 + len;
+    for (; len >= 4; p += 4, len -= 4) {
+        h += get32(p) * P3;
+        h = ((h << 17) | (h >> 15)) * P4;
+    }
+    for (; len; p++, len--) {
+        h += *p * P5;
+        h = ((h << 11) | (h >> 21)) * P1;
+    }
+    h ^= h >> 15;
+    h *= P2;
+    h ^= h >> 13;
+    h *= P3;
+    h ^= h >> 16;
+    return h;
+}
+
+// ===== Block format =====
+
+static inline uint32_t lz4_hash(uint32_t seq) {
+    return (seq * 2654435761U) >> (32 - FS_LZ4_HASH_BITS);
+}
+
+// Token, literal run and, for a match, offset and length extension
+static uint8_t *emit(uint8_t *op, const uint8_t *lit, size_t lit_len, size_t offset, size_t match_len) {
+    uint8_t *token = op++;
+    if (lit_len >= 15) {
+        *token = 15 << 4;
+        size_t l = lit_len - 15;
+        for (; l >= 255; l -= 255) {
+            *op++ = 255;
+        }
+        *op++ = l;
+    } else {
+        *token = lit_len << 4;
+    }
+    memcpy(op, lit, lit_len);
+    op += lit_len;
+    if (!offset) {
+        return op;
+    }
+    *op++ = offset;
+    *op++ = offset >> 8;
+    if (match_len >= 15) {
+        *token |= 15;
+        size_t l = match_len - 15;
+        for (; l >= 255; l -= 255) {
+            *op++ = 255;
+        }
+        *op++ = l;
+    } else {
+        *token |= match_len;
+    }
+    return op;
+}
+
+// Worst case for one sequence
+static inline size_t emit_max(size_t lit_len, size_t match_len) {
+    return 1 + lit_len / 255 + 1 + lit_len + 2 + match_len / 255 + 1;
+}
+
+size_t fs_lz4_compress(const uint8_t *src, size_t len, uint8_t *dst, size_t cap, uint16_t *table) {
+    const uint8_t *ip = src;
+    const uint8_t *anchor = src;
+    const uint8_t *iend = src + len;
+    uint8_t *op = dst;
+    uint8_t *oend = dst + cap;
+
+    if (len > LZ4_MFLIMIT) {
+        const uint8_t *mflimit = iend - LZ4_MFLIMIT;
+        const uint8_t *matchlimit = iend - LZ4_LAST_LITERALS;
+        memset(table, 0, LZ4_TABLE_SIZE);
+        uint32_t misses = 1 << LZ4_SKIP_TRIGGER;
+        ip++;
+        while (ip < mflimit) {
+            uint32_t seq = read32(ip);
+            uint32_t h = lz4_hash(seq);
+            const uint8_t *ref = src + table[h];
+            table[h] = ip - src;
+            if (ref >= ip || ip - ref > LZ4_MAX_OFFSET || read32(ref) != seq) {
+                ip += misses++ >> LZ4_SKIP_TRIGGER;
+                continue;
+            }
+            misses = 1 << LZ4_SKIP_TRIGGER;
+
+            while (ip > anchor && ref > src && ip[-1] == ref[-1]) {
+                ip--;
+                ref--;
+            }
+            const uint8_t *mp = ip + LZ4_MIN_MATCH;
+            const uint8_t *rp = ref + LZ4_MIN_MATCH;
+            while (mp < matchlimit && *mp == *rp) {
+                mp++;
+                rp++;
+            }
+            size_t lit_len = ip - anchor;
+            size_t match_len = mp - ip - LZ4_MIN_MATCH;
+            if (op + emit_max(lit_len, match_len) > oend) {
+                return 0;
+            }
+            op = emit(op, anchor, lit_len, ip - ref, match_len);
+            ip = anchor = mp;
+            if (ip < mflimit) {
+                table[lz4_hash(read32(ip - 2))] = ip - 2 - src;
+            }
+        }
+    }
+
+    size_t lit_len = iend - anchor;
+    if (op + emit_max(lit_len, 0) > oend) {
+        return 0;
+    }
+    op = emit(op, anchor, lit_len, 0, 0);
+    return op - dst;
+}
+
+int fs_lz4_decompress(const uint8_t *src, size_t len, uint8_t *dst, size_t cap) {
+    const uint8_t *ip = src;
+    const uint8_t *iend = src + len;
+    uint8_t *op = dst;
+    uint8_t *oend = dst + cap;
+
+    while (ip < iend) {
+        uint8_t token = *ip++;
+        size_t lit_len = token >> 4;
+        if (lit_len == 15) {
+            uint8_t b;
+            do {
+                if (ip >= iend) {
+                    return -1;
+                }
+                b = *ip++;
+                lit_len += b;
+            } while (b == 255);
+        }
+        if (lit_len > (size_t)(iend - ip) || lit_len > (size_t)(oend - op)) {
+            return -1;
+        }
+        memcpy(op, ip, lit_len);
+        op += lit_len;
+        ip += lit_len;
+        if (ip == iend) {
+            break;              // The last sequence has no match
+        }
+
+        if (iend - ip < 2) {
+            return -1;
+        }
+        size_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (!offset || offset > (size_t)(op - dst)) {
+            return -1;
+        }
+        size_t match_len = token & 15;
+        if (match_len == 15) {
+            uint8_t b;
+            do {
+                if (ip >= iend) {
+                    return -1;
+                }
+                b = *ip++;
+                match_len += b;
+            } while (b == 255);
+        }
+        match_len += LZ4_MIN_MATCH;
+        if (match_len > (size_t)(oend - op)) {
+            return -1;
+        }
+        // Byte by byte: a match may overlap what it is copying
+        const uint8_t *ref = op - offset;
+        while (match_len--) {
+            *op++ = *ref++;
+        }
+    }
+    return op - dst;
+}
+
+// ===== Stream =====
+
+// Under lz4_mux: a closed stream with nothing left on the job pool or the
+// FS service and nobody waiting on it, claimed for release()
+static bool release_due(FsLz4Stream *s) {
+    if (!s->closing || s->waiting || s->released || s->busy || !s->ended) {
+        return false;
+    }
+    for (int i = 0; i < FS_LZ4_BUFS; i++) {
+        if (s->blocks[i].state >= LZB_SEALED) {
+            return false;
+        }
+    }
+    s->released = true;
+    return true;
+}
+
+static void release(FsLz4Stream *s) {
+    heap_caps_free(s->mem);
+    s->mem = NULL;
+    portENTER_CRITICAL(&lz4_mux);
+    s->in_use = false;
+    lz4_stats.streams--;
+    portEXIT_CRITICAL(&lz4_mux);
+}
+
+static void block_done(const FsResult *res, void *ctx) {
+    FsLz4Block *b = (FsLz4Block *)ctx;
+    FsLz4Stream *s = b->stream;
+    portENTER_CRITICAL(&lz4_mux);
+    lz4_stats.write_errors += !res->ok;
+    if (!--b->pending) {
+        b->state = LZB_FREE;
+    }
+    bool go = release_due(s);
+    portEXIT_CRITICAL(&lz4_mux);
+    if (go) {
+        release(s);
+    }
+}
+
+static void end_done(const FsResult *res, void *ctx) {
+    FsLz4Stream *s = (FsLz4Stream *)ctx;
+    portENTER_CRITICAL(&lz4_mux);
+    if (res->ok) {
+        lz4_stats.file_bytes += sizeof(s->end_mark);
+    } else {
+        lz4_stats.write_errors++;
+    }
+    s->ended = true;
+    bool go = release_due(s);
+    portEXIT_CRITICAL(&lz4_mux);
+    if (go) {
+        release(s);
+    }
+}
+
+static void header_done(const FsResult *res, void *ctx) {
+    portENTER_CRITICAL(&lz4_mux);
+    if (res->ok) {
+        lz4_stats.file_bytes += FS_LZ4_FRAME_HEADER;
+    } else {
+        lz4_stats.write_errors++;
+    }
+    portEXIT_CRITICAL(&lz4_mux);
+}
+
+static void ignore_done(const FsResult *res, void *ctx) {
+}
+
+// A full FS queue is waited out a little; a refusal completes as a failure
+static void append(FsLz4Stream *s, const char *path, const void *buf, size_t len, fs_done_cb cb, void *ctx) {
+    for (int i = 0; i <= FS_LZ4_QUEUE_RETRIES; i++) {
+        if (fs_append(*s->fs, path, buf, len, cb, ctx)) {
+            return;
+        }
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    FsResult res;
+    memset(&res, 0, sizeof(res));
+    res.op = FS_OP_APPEND;
+    res.ctx = ctx;
+    cb(&res, ctx);
+}
+
+// Compress job: a block and its index entry, both in one go so they queue together
+static void write_block(FsLz4Stream *s, FsLz4Block *b) {
+    int64_t start = esp_timer_get_time();
+    size_t n = fs_lz4_compress(b->raw, b->len, b->out + 4, b->len - 1, s->table);
+    bool stored = !n;
+    if (stored) {
+        memcpy(b->out + 4, b->raw, b->len);
+        n = b->len;
+    }
+    put32(b->out, n | (stored ? FS_LZ4_BLOCK_STORED : 0));
+    uint32_t us = esp_timer_get_time() - start;
+
+    b->entry.raw_offset = b->raw_offset;
+    b->entry.file_offset = s->file_size;
+    s->file_size += 4 + n;
+
+    portENTER_CRITICAL(&lz4_mux);
+    lz4_stats.blocks++;
+    lz4_stats.stored += stored;
+    lz4_stats.raw_bytes += b->len;
+    lz4_stats.file_bytes += 4 + n;
+    if (us > lz4_stats.compress_max_us) {
+        lz4_stats.compress_max_us = us;
+    }
+    b->state = LZB_OUT;
+    b->pending = 2;
+    portEXIT_CRITICAL(&lz4_mux);
+
+    append(s, s->path, b->out, 4 + n, block_done, b);
+    append(s, s->index_path, &b->entry, sizeof(b->entry), block_done, b);
+}
+
+// Sealed blocks oldest first, then the end mark once the stream is closing
+static void drain(FsLz4Stream *s) {
+    while (true) {
+        int i = -1;
+        bool end = false;
+        bool go = false;
+        portENTER_CRITICAL(&lz4_mux);
+        if (s->sealed_tail != s->sealed_head) {
+            i = s->sealed[s->sealed_tail++ % FS_LZ4_BUFS];
+        } else if (s->closing && !s->end_queued) {
+            s->end_queued = true;
+            end = true;
+        } else {
+            s->busy = false;
+            go = release_due(s);
+        }
+        portEXIT_CRITICAL(&lz4_mux);
+
+        if (i >= 0) {
+            write_block(s, &s->blocks[i]);
+        } else if (end) {
+            put32(s->end_mark, 0);
+            append(s, s->path, s->end_mark, sizeof(s->end_mark), end_done, s);
+        } else {
+            if (go) {
+                release(s);
+            }
+            return;
+        }
+    }
+}
+
+static void compress_job(Job *job) {
+    drain((FsLz4Stream *)job->ctx);
+}
+
+static void kick(FsLz4Stream *s) {
+    portENTER_CRITICAL(&lz4_mux);
+    if (s->busy) {
+        portEXIT_CRITICAL(&lz4_mux);
+        return;
+    }
+    s->busy = true;
+    portEXIT_CRITICAL(&lz4_mux);
+
+    Job *job = &s->jobs[0];
+    if (job->state == JOB_QUEUED || job->state == JOB_RUNNING) {
+        job = &s->jobs[1];
+    }
+    if (!job_submit(job, compress_job, s, JOB_PRIO_LOW)) {
+        drain(s);
+    }
+}
+
+// Writer side: hand the current block to the compress job
+static void seal(FsLz4Stream *s) {
+    if (s->cur < 0 || !s->blocks[s->cur].len) {
+        return;
+    }
+    portENTER_CRITICAL(&lz4_mux);
+    FsLz4Block *b = &s->blocks[s->cur];
+    b->state = LZB_SEALED;
+    s->sealed[s->sealed_head++ % FS_LZ4_BUFS] = s->cur;
+    s->raw_size += b->len;
+    portEXIT_CRITICAL(&lz4_mux);
+    s->cur = -1;
+    kick(s);
+}
+
+static bool open_block(FsLz4Stream *s) {
+    portENTER_CRITICAL(&lz4_mux);
+    for (int i = 0; i < FS_LZ4_BUFS; i++) {
+        FsLz4Block *b = &s->blocks[i];
+        if (b->state == LZB_FREE) {
+            b->state = LZB_FILLING;
+            b->len = 0;
+            b->raw_offset = s->raw_size;
+            s->cur = i;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&lz4_mux);
+    return s->cur >= 0;
+}
+
+FsLz4Stream *fs_lz4_open(fs::FS &fs, const char *path) {
+    if (strlen(path) + strlen(FS_LZ4_INDEX_EXT) >= FS_PATH_MAX || !fs_service_begin()) {
+        return NULL;
+    }
+    FsLz4Stream *s = NULL;
+    portENTER_CRITICAL(&lz4_mux);
+    for (int i = 0; i < FS_LZ4_STREAMS; i++) {
+        if (!lz4_streams[i].in_use) {
+            s = &lz4_streams[i];
+            s->in_use = true;
+            lz4_stats.streams++;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&lz4_mux);
+    if (!s) {
+        LOG_WARN("LZ4", "No free stream");
+        return NULL;
+    }
+
+    s->mem = (uint8_t *)heap_caps_malloc(FS_LZ4_BUFS * (FS_LZ4_BLOCK_SIZE + LZ4_OUT_SIZE) + LZ4_TABLE_SIZE,
+                                         MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!s->mem) {
+        LOG_ERROR("LZ4", "Failed to allocate the blocks");
+        release(s);
+        return NULL;
+    }
+    s->fs = &fs;
+    strcpy(s->path, path);
+    snprintf(s->index_path, sizeof(s->index_path), "%s" FS_LZ4_INDEX_EXT, path);
+    uint8_t *p = s->mem;
+    for (int i = 0; i < FS_LZ4_BUFS; i++) {
+        FsLz4Block *b = &s->blocks[i];
+        memset(b, 0, sizeof(*b));
+        b->stream = s;
+        b->raw = p;
+        b->out = p + FS_LZ4_BLOCK_SIZE;
+        p += FS_LZ4_BLOCK_SIZE + LZ4_OUT_SIZE;
+    }
+    s->table = (uint16_t *)p;
+    s->sealed_head = s->sealed_tail = 0;
+    s->cur = -1;
+    s->raw_size = 0;
+    s->file_size = FS_LZ4_FRAME_HEADER;
+    s->busy = s->closing = s->end_queued = s->ended = s->waiting = s->released = false;
+
+    put32(s->header, FS_LZ4_FRAME_MAGIC);
+    s->header[4] = LZ4_FLG;
+    s->header[5] = LZ4_BD;
+    s->header[6] = xxh32_short(s->header + 4, 2) >> 8;
+
+    // In queue order: the old index goes before the first entry lands
+    if (!fs_write(fs, path, s->header, sizeof(s->header), header_done, s)) {
+        LOG_WARN("LZ4", "FS queue full");
+        release(s);
+        return NULL;
+    }
+    fs_remove(fs, s->index_path, ignore_done);
+    return s;
+}
+
+bool fs_lz4_write(FsLz4Stream *s, const void *data, size_t len) {
+    const uint8_t *p = (const uint8_t *)data;
+    while (len) {
+        if (s->cur < 0 && !open_block(s)) {
+            portENTER_CRITICAL(&lz4_mux);
+            lz4_stats.dropped += len;
+            portEXIT_CRITICAL(&lz4_mux);
+            return false;
+        }
+        FsLz4Block *b = &s->blocks[s->cur];
+        size_t n = min(len, (size_t)(FS_LZ4_BLOCK_SIZE - b->len));
+        memcpy(b->raw + b->len, p, n);
+        b->len += n;
+        p += n;
+        len -= n;
+        if (b->len == FS_LZ4_BLOCK_SIZE) {
+            seal(s);
+        }
+    }
+    return true;
+}
+
+void fs_lz4_flush(FsLz4Stream *s) {
+    seal(s);
+}
+
+uint32_t fs_lz4_size(const FsLz4Stream *s) {
+    return s->raw_size + (s->cur >= 0 ? s->blocks[s->cur].len : 0);
+}
+
+bool fs_lz4_close(FsLz4Stream *s, uint32_t wait_ms) {
+    seal(s);
+    if (s->cur >= 0) {
+        s->blocks[s->cur].state = LZB_FREE;     // Opened and left empty
+        s->cur = -1;
+    }
+    portENTER_CRITICAL(&lz4_mux);
+    s->closing = true;
+    s->waiting = wait_ms > 0;
+    portEXIT_CRITICAL(&lz4_mux);
+    kick(s);
+
+    bool done = false;
+    uint32_t start = millis();
+    while (s->waiting) {
+        portENTER_CRITICAL(&lz4_mux);
+        done = !s->busy && s->ended;
+        for (int i = 0; i < FS_LZ4_BUFS; i++) {
+            done &= s->blocks[i].state < LZB_SEALED;
+        }
+        portEXIT_CRITICAL(&lz4_mux);
+        if (done || millis() - start >= wait_ms) {
+            break;
+        }
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+
+    if (wait_ms && !done) {
+        LOG_WARNF("LZ4", "%s still being written after %lu ms", s->path, (unsigned long)wait_ms);
+    }
+
+    // Past the wait, the last write to complete releases it
+    portENTER_CRITICAL(&lz4_mux);
+    s->waiting = false;
+    bool go = release_due(s);
+    portEXIT_CRITICAL(&lz4_mux);
+    if (go) {
+        release(s);
+    }
+    return done;
+}
+
+// ===== Reading =====
+
+// -2 when the index led to a bad block
+static int read_frame(fs::FS &fs, const char *path, uint32_t offset, uint8_t *out, size_t len, bool indexed) {
+    File f = fs.open(path, FILE_READ);
+    if (!f) {
+        return -1;
+    }
+    uint8_t hdr[FS_LZ4_FRAME_HEADER];
+    if (f.read(hdr, sizeof(hdr)) != sizeof(hdr) || get32(hdr) != FS_LZ4_FRAME_MAGIC ||
+        !(hdr[4] & LZ4_FLG_INDEPENDENT) || (hdr[5] >> 4) > 4) {
+        f.close();
+        return -1;
+    }
+    uint32_t first = FS_LZ4_FRAME_HEADER + ((hdr[4] & LZ4_FLG_CONTENT_SIZE) ? 8 : 0) +
+                     ((hdr[4] & LZ4_FLG_DICT_ID) ? 4 : 0);
+    uint32_t checksum = (hdr[4] & LZ4_FLG_BLOCK_CHECKSUM) ? 4 : 0;
+
+    // The last entry at or before offset
+    uint32_t raw = 0;
+    uint32_t pos = first;
+    char index_path[FS_PATH_MAX];
+    snprintf(index_path, sizeof(index_path), "%s" FS_LZ4_INDEX_EXT, path);
+    File ix = indexed && fs.exists(index_path) ? fs.open(index_path, FILE_READ) : File();
+    if (ix) {
+        uint32_t lo = 0;
+        uint32_t hi = ix.size() / sizeof(FsLz4IndexEntry);
+        FsLz4IndexEntry e;
+        while (lo < hi) {
+            uint32_t mid = (lo + hi) / 2;
+            ix.seek(mid * sizeof(e));
+            if (ix.read((uint8_t *)&e, sizeof(e)) != sizeof(e)) {
+                break;
+            }
+            if (e.raw_offset <= offset) {
+                raw = e.raw_offset;
+                pos = e.file_offset;
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        ix.close();
+    }
+
+    uint8_t *cbuf = (uint8_t *)heap_caps_malloc(2 * LZ4_BLOCK_MAX, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!cbuf) {
+        f.close();
+        return -1;
+    }
+    uint8_t *rbuf = cbuf + LZ4_BLOCK_MAX;
+    size_t done = 0;
+    bool bad = false;
+    while (done < len) {
+        uint8_t size_field[4];
+        f.seek(pos);
+        if (f.read(size_field, 4) != 4) {
+            break;              // Cut short: a crash before the end mark
+        }
+        uint32_t size = get32(size_field);
+        if (!size) {
+            break;              // End mark
+        }
+        bool stored = size & FS_LZ4_BLOCK_STORED;
+        size &= ~FS_LZ4_BLOCK_STORED;
+        if (size > LZ4_BLOCK_MAX) {
+            bad = true;
+            break;
+        }
+        if (f.read(cbuf, size) != size) {
+            break;              // Torn last block
+        }
+        int n = size;
+        if (stored) {
+            memcpy(rbuf, cbuf, size);
+        } else {
+            n = fs_lz4_decompress(cbuf, size, rbuf, LZ4_BLOCK_MAX);
+            if (n < 0) {
+                bad = true;
+                break;
+            }
+        }
+        if (raw + n > offset + done) {
+            size_t from = offset + done - raw;
+            size_t take = min(len - done, (size_t)n - from);
+            memcpy(out + done, rbuf + from, take);
+            done += take;
+        }
+        raw += n;
+        pos += 4 + size + checksum;
+    }
+    heap_caps_free(cbuf);
+    f.close();
+
+    // An entry after a block whose append failed points at the wrong place
+    if (bad && indexed) {
+        return -2;
+    }
+    return bad ? -1 : done;
+}
+
+int fs_lz4_read(fs::FS &fs, const char *path, uint32_t offset, uint8_t *out, size_t len) {
+    bool sd = &fs == &SD;
+    if (sd) {
+        spi_bus_acquire(SPI_CLIENT_SD);
+    }
+    int n = read_frame(fs, path, offset, out, len, true);
+    if (n == -2) {
+        n = read_frame(fs, path, offset, out, len, false);
+    }
+    if (sd) {
+        spi_bus_release(SPI_CLIENT_SD);
+    }
+    return n;
+}
+
+// ===== Console =====
+
+static void rpc_zcat(Print &out, const char *args) {
+    char path[FS_PATH_MAX];
+    unsigned long offset = 0;
+    unsigned long len = LZ4_ZCAT_DEFAULT;
+    if (sscanf(args, "%63s %lu %lu", path, &offset, &len) < 1 || path[0] != '/') {
+        out.println("usage: zcat <path> [offset] [len]");
+        return;
+    }
+    len = min(len, (unsigned long)LZ4_ZCAT_MAX);
+    uint8_t *buf = (uint8_t *)malloc(len);
+    if (!buf) {
+        out.println("out of memory");
+        return;
+    }
+    int n = fs_lz4_read(SD, path, offset, buf, len);
+    if (n < 0) {
+        out.println("not an LZ4 frame, or corrupt");
+    } else {
+        out.write(buf, n);
+        if (n && buf[n - 1] != '\n') {
+            out.println();
+        }
+    }
+    free(buf);
+}
+
+static void rpc_lz4(Print &out, const char *args) {
+    FsLz4Stats s;
+    fs_lz4_get_stats(&s);
+    uint32_t pct = s.raw_bytes ? (uint32_t)((uint64_t)s.file_bytes * 100 / s.raw_bytes) : 0;
+    out.printf("streams %lu/%u, blocks %lu (stored %lu), slowest %lu us\n", (unsigned long)s.streams,
+               FS_LZ4_STREAMS, (unsigned long)s.blocks, (unsigned long)s.stored, (unsigned long)s.compress_max_us);
+    out.printf("%lu bytes in, %lu out, %lu%%\n", (unsigned long)s.raw_bytes, (unsigned long)s.file_bytes,
+               (unsigned long)pct);
+    out.printf("dropped %lu bytes, write errors %lu\n", (unsigned long)s.dropped, (unsigned long)s.write_errors);
+}
+
+void fs_lz4_begin() {
+    usb_console_rpc("zcat", rpc_zcat);
+    usb_console_rpc("lz4", rpc_lz4);
+}
+
+void fs_lz4_get_stats(FsLz4Stats *out) {
+    portENTER_CRITICAL(&lz4_mux);
+    *out = lz4_stats;
+    portEXIT_CRITICAL(&lz4_mux);
+}
@@ -0,0 +1,126 @@
+/**
+ * @file      fs_lz4.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Streaming LZ4 frame writer on the FS service, with a block index for seeking
+ */
+
+#ifndef FS_LZ4_H
+#define FS_LZ4_H
+
+#include <Arduino.h>
+#include <FS.h>
+
+/**
+ * For files that are written far more than read: logs, traces, captures.
+ * The writer copies into a fixed-size raw block and returns; a full block,
+ * or one closed by fs_lz4_flush(), is compressed on the job pool and goes
+ * out as one fs_append(), so neither the producer nor the card waits on
+ * the compressor. Blocks are compressed and appended in the order they
+ * were closed. With every block out, writes are counted as dropped rather
+ * than waited for.
+ *
+ * The file is a standard LZ4 frame, so "lz4 -d" on a PC reads it:
+ * independent blocks of up to 64 KB, no checksums. Each block decodes on
+ * its own, so after a crash or power loss everything up to the last block
+ * appended is readable; the end mark is only written on close and readers
+ * stop at the end of the file without it. A block that does not shrink is
+ * stored as is.
+ *
+ * Next to it, path + ".idx" gets one FsLz4IndexEntry per block, appended
+ * after the block, so fs_lz4_read() seeks to the block holding an offset
+ * instead of decompressing from the start. Without the index it scans the
+ * block headers.
+ *
+ * Console: "zcat <path> [offset] [len]" prints part of a compressed file,
+ * "lz4" the counters and the ratio across all streams.
+ */
+
+#define FS_LZ4_BLOCK_SIZE           (16 * 1024)     // Raw bytes per block
+#define FS_LZ4_BUFS                 3               // Blocks per stream, PSRAM
+#define FS_LZ4_STREAMS              4               // Open at once
+#define FS_LZ4_HASH_BITS            12              // Match finder, 2 bytes per entry
+#define FS_LZ4_QUEUE_RETRIES        50              // 10 ms apart, while the FS queue is full
+#define FS_LZ4_CLOSE_WAIT_MS        5000
+#define FS_LZ4_INDEX_EXT            ".idx"
+#define FS_LZ4_FRAME_MAGIC          0x184D2204UL
+#define FS_LZ4_FRAME_HEADER         7               // Magic, FLG, BD, HC
+#define FS_LZ4_BLOCK_STORED         0x80000000UL    // Block size flag: not compressed
+
+// Little-endian on the card
+struct FsLz4IndexEntry {
+    uint32_t raw_offset;            // Uncompressed offset of the block's first byte
+    uint32_t file_offset;           // Its block size field in the file
+};
+
+struct FsLz4Stats {
+    uint32_t streams;               // Open now
+    uint32_t blocks;
+    uint32_t stored;                // Blocks that did not compress
+    uint32_t raw_bytes;
+    uint32_t file_bytes;            // Block sizes and data, frame headers included
+    uint32_t dropped;               // Bytes refused with every block out
+    uint32_t write_errors;          // Appends that failed or were refused
+    uint32_t compress_max_us;       // Slowest block
+};
+
+struct FsLz4Stream;
+
+/**
+ * @brief Start a new frame at path, replacing the file and its index
+ * @return NULL without memory or with a path too long for the FS service
+ */
+FsLz4Stream *fs_lz4_open(fs::FS &fs, const char *path);
+
+/**
+ * @brief Copy len bytes into the stream. One writer task per stream
+ * @return false if some were dropped
+ */
+bool fs_lz4_write(FsLz4Stream *s, const void *data, size_t len);
+
+/**
+ * @brief Close the current block early, so what was written reaches the card
+ */
+void fs_lz4_flush(FsLz4Stream *s);
+
+/**
+ * @brief Flush, end the frame and release the stream once its writes are done.
+ *        Waits up to wait_ms for them; s is gone either way
+ * @return true if everything reached the card within wait_ms
+ */
+bool fs_lz4_close(FsLz4Stream *s, uint32_t wait_ms = FS_LZ4_CLOSE_WAIT_MS);
+
+/**
+ * @brief Uncompressed bytes written to the stream so far, dropped ones aside
+ */
+uint32_t fs_lz4_size(const FsLz4Stream *s);
+
+/**
+ * @brief Read len uncompressed bytes at offset from a compressed file.
+ *        Synchronous, on the caller's task
+ * @return bytes read, short at the end of the data, -1 on a bad file
+ */
+int fs_lz4_read(fs::FS &fs, const char *path, uint32_t offset, uint8_t *out, size_t len);
+
+/**
+ * @brief One LZ4 block. table holds 1 << FS_LZ4_HASH_BITS entries; src at
+ *        most 64 KB
+ * @return compressed size, 0 if it does not fit in cap
+ */
+size_t fs_lz4_compress(const uint8_t *src, size_t len, uint8_t *dst, size_t cap, uint16_t *table);
+
+/**
+ * @return decompressed size, -1 on a corrupt block or one larger than cap
+ */
+int fs_lz4_decompress(const uint8_t *src, size_t len, uint8_t *dst, size_t cap);
+
+/**
+ * @brief Console commands. Called by fs_service_begin()
+ */
+void fs_lz4_begin();
+
+void fs_lz4_get_stats(FsLz4Stats *out);
+
+#endif // FS_LZ4_H
@@ -0,0 +1,350 @@
+/**
+ * @file      fs_service.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     File system requests run on a worker task, completed by callback or event
+ */
+
+#include "fs_service.h"
+#include "simple_logger.h"
+#include <SD.h>
+#include "spi_bus.h"
+#include "fs_lz4.h"
+#include "sd_manager.h"
+#include "dir_index.h"
+#ifdef INTEGRATION_LAYER_ENABLED
+#include "integration/event_bridge.h"
+#endif
+
+typedef struct {
+    uint32_t id;
+    uint8_t op;
+    fs::FS *fs;
+    char path[FS_PATH_MAX];
+    char path2[FS_PATH_MAX];
+    uint8_t *buf;
+    size_t len;
+    uint32_t offset;
+    fs_done_cb cb;
+    void *ctx;
+} fs_request_t;
+
+static TaskHandle_t fs_task_handle = NULL;
+static QueueHandle_t fs_queue = NULL;
+static uint32_t fs_next_id = 1;
+static fs_stats_t fs_stats;
+static portMUX_TYPE fs_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// Capacity cache, in bytes
+static uint64_t cap_total = 0;
+static uint64_t cap_used = 0;
+static bool cap_valid = false;
+static bool cap_stale = true;
+static bool cap_queued = false;
+
+static bool list_dir(fs::FS &fs, const char *path, char *buf, size_t len, uint32_t *size) {
+    File dir = fs.open(path);
+    if (!dir || !dir.isDirectory()) {
+        return false;
+    }
+    size_t pos = 0;
+    bool fits = true;
+    File f = dir.openNextFile();
+    while (f) {
+        const char *name = strrchr(f.name(), '/');
+        name = name ? name + 1 : f.name();
+        size_t n = strlen(name) + (f.isDirectory() ? 2 : 1);
+        if (pos + n >= len) {
+            fits = false;
+            break;
+        }
+        pos += snprintf(buf + pos, len - pos, f.isDirectory() ? "%s/\n" : "%s\n", name);
+        f = dir.openNextFile();
+    }
+    if (len) {
+        buf[pos] = '\0';
+    }
+    *size = pos;
+    return fits;
+}
+
+static void run(const fs_request_t *req, FsResult *res) {
+    fs::FS &fs = *req->fs;
+    File f;
+    switch (req->op) {
+    case FS_OP_READ:
+        f = fs.open(req->path, FILE_READ);
+        if (f && f.seek(req->offset)) {
+            res->size = f.read(req->buf, req->len);
+            res->ok = true;
+        }
+        break;
+    case FS_OP_WRITE:
+    case FS_OP_APPEND:
+        f = fs.open(req->path, req->op == FS_OP_WRITE ? FILE_WRITE : FILE_APPEND);
+        if (f) {
+            res->size = f.write(req->buf, req->len);
+            res->ok = res->size == req->len;
+        }
+        break;
+    case FS_OP_STAT:
+        f = fs.open(req->path, FILE_READ);
+        if (f) {
+            res->is_dir = f.isDirectory();
+            res->size = res->is_dir ? 0 : f.size();
+            res->ok = true;
+        }
+        break;
+    case FS_OP_LIST:
+        res->ok = list_dir(fs, req->path, (char *)req->buf, req->len, &res->size);
+        break;
+    case FS_OP_REMOVE:
+        res->ok = fs.remove(req->path) || fs.rmdir(req->path);
+        break;
+    case FS_OP_MKDIR:
+        res->ok = fs.exists(req->path) || fs.mkdir(req->path);
+        break;
+    case FS_OP_RENAME:
+        res->ok = fs.rename(req->path, req->path2);
+        break;
+    case FS_OP_CAPACITY:
+        // The first usedBytes() walks the FAT; FatFs keeps the free count after that
+        if (SD.cardType() != CARD_NONE) {
+            res->total = SD.totalBytes();
+            res->used = SD.usedBytes();
+            res->ok = true;
+        }
+        break;
+    }
+    if (f) {
+        f.close();
+    }
+    // Still under the bus hold; marks the directory's index stale
+    if (res->ok && req->fs == &SD) {
+        switch (req->op) {
+        case FS_OP_WRITE:
+        case FS_OP_APPEND:
+        case FS_OP_REMOVE:
+        case FS_OP_MKDIR:
+            dir_index_touch(req->path);
+            break;
+        case FS_OP_RENAME:
+            dir_index_touch(req->path);
+            dir_index_touch(req->path2);
+            break;
+        }
+    }
+}
+
+static void complete(const fs_request_t *req, FsResult *res, uint32_t ms) {
+    portENTER_CRITICAL(&fs_mux);
+    if (res->ok) {
+        fs_stats.done++;
+    } else {
+        fs_stats.failed++;
+    }
+    if (ms > fs_stats.busy_max_ms) {
+        fs_stats.busy_max_ms = ms;
+    }
+    switch (req->op) {
+    case FS_OP_CAPACITY:
+        cap_queued = false;
+        fs_stats.capacity_ms = ms;
+        if (res->ok) {
+            cap_total = res->total;
+            cap_used = res->used;
+            cap_valid = true;
+        }
+        break;
+    case FS_OP_WRITE:
+    case FS_OP_APPEND:
+    case FS_OP_REMOVE:
+    case FS_OP_RENAME:
+        if (req->fs == &SD) {
+            cap_stale = true;
+        }
+        break;
+    }
+    portEXIT_CRITICAL(&fs_mux);
+
+    if (req->cb) {
+        req->cb(res, req->ctx);
+        return;
+    }
+#ifdef INTEGRATION_LAYER_ENABLED
+    if (GlobalEventBridge && req->op != FS_OP_CAPACITY) {
+        GlobalEventBridge->publishTypedEvent(EventType::FS_COMPLETE, "FS", *res);
+    }
+#endif
+}
+
+static void fs_task(void *param) {
+    fs_request_t req;
+    while (1) {
+        if (xQueueReceive(fs_queue, &req, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        FsResult res;
+        memset(&res, 0, sizeof(res));
+        res.id = req.id;
+        res.op = req.op;
+        res.ctx = req.ctx;
+
+        uint32_t start = millis();
+        if (req.fs == &SD) {
+            // Not while the card is lent out or gone: the volume can still
+            // be mounted underneath
+            if (sd_manager_mounted()) {
+                SpiBusHold bus(SPI_CLIENT_SD);
+                run(&req, &res);
+            }
+        } else {
+            run(&req, &res);
+        }
+        complete(&req, &res, millis() - start);
+    }
+}
+
+bool fs_service_begin() {
+    if (fs_task_handle) {
+        return true;
+    }
+    fs_queue = xQueueCreate(FS_QUEUE_DEPTH, sizeof(fs_request_t));
+    if (!fs_queue) {
+        LOG_ERROR("FS", "Failed to create the request queue");
+        return false;
+    }
+    if (xTaskCreate(fs_task, "fs", FS_TASK_STACK, NULL, FS_TASK_PRIORITY, &fs_task_handle) != pdPASS) {
+        LOG_ERROR("FS", "Failed to start the worker");
+        vQueueDelete(fs_queue);
+        fs_queue = NULL;
+        return false;
+    }
+    fs_lz4_begin();
+    LOG_INFO("FS", "Worker started");
+    return true;
+}
+
+static uint32_t submit(uint8_t op, fs::FS &fs, const char *path, const char *path2,
+                       const void *buf, size_t len, uint32_t offset, fs_done_cb cb, void *ctx) {
+    if (!fs_queue || (path && strlen(path) >= FS_PATH_MAX) || (path2 && strlen(path2) >= FS_PATH_MAX)) {
+        return 0;
+    }
+    fs_request_t req;
+    memset(&req, 0, sizeof(req));
+    req.op = op;
+    req.fs = &fs;
+    if (path) {
+        strcpy(req.path, path);
+    }
+    if (path2) {
+        strcpy(req.path2, path2);
+    }
+    req.buf = (uint8_t *)buf;
+    req.len = len;
+    req.offset = offset;
+    req.cb = cb;
+    req.ctx = ctx;
+
+    portENTER_CRITICAL(&fs_mux);
+    req.id = fs_next_id++;
+    if (!fs_next_id) {
+        fs_next_id = 1;
+    }
+    portEXIT_CRITICAL(&fs_mux);
+
+    if (xQueueSend(fs_queue, &req, 0) != pdTRUE) {
+        portENTER_CRITICAL(&fs_mux);
+        fs_stats.rejected++;
+        portEXIT_CRITICAL(&fs_mux);
+        return 0;
+    }
+    portENTER_CRITICAL(&fs_mux);
+    fs_stats.queued++;
+    portEXIT_CRITICAL(&fs_mux);
+    return req.id;
+}
+
+uint32_t fs_read(fs::FS &fs, const char *path, uint32_t offset, void *buf, size_t len,
+                 fs_done_cb cb, void *ctx) {
+    return submit(FS_OP_READ, fs, path, NULL, buf, len, offset, cb, ctx);
+}
+
+uint32_t fs_write(fs::FS &fs, const char *path, const void *buf, size_t len,
+                  fs_done_cb cb, void *ctx) {
+    return submit(FS_OP_WRITE, fs, path, NULL, buf, len, 0, cb, ctx);
+}
+
+uint32_t fs_append(fs::FS &fs, const char *path, const void *buf, size_t len,
+                   fs_done_cb cb, void *ctx) {
+    return submit(FS_OP_APPEND, fs, path, NULL, buf, len, 0, cb, ctx);
+}
+
+uint32_t fs_stat(fs::FS &fs, const char *path, fs_done_cb cb, void *ctx) {
+    return submit(FS_OP_STAT, fs, path, NULL, NULL, 0, 0, cb, ctx);
+}
+
+uint32_t fs_list(fs::FS &fs, const char *path, char *buf, size_t len,
+                 fs_done_cb cb, void *ctx) {
+    return submit(FS_OP_LIST, fs, path, NULL, buf, len, 0, cb, ctx);
+}
+
+uint32_t fs_remove(fs::FS &fs, const char *path, fs_done_cb cb, void *ctx) {
+    return submit(FS_OP_REMOVE, fs, path, NULL, NULL, 0, 0, cb, ctx);
+}
+
+uint32_t fs_mkdir(fs::FS &fs, const char *path, fs_done_cb cb, void *ctx) {
+    return submit(FS_OP_MKDIR, fs, path, NULL, NULL, 0, 0, cb, ctx);
+}
+
+uint32_t fs_rename(fs::FS &fs, const char *from, const char *to, fs_done_cb cb, void *ctx) {
+    return submit(FS_OP_RENAME, fs, from, to, NULL, 0, 0, cb, ctx);
+}
+
+bool fs_capacity(uint64_t *total, uint64_t *used) {
+    portENTER_CRITICAL(&fs_mux);
+    bool valid = cap_valid;
+    bool refresh = (cap_stale || !cap_valid) && !cap_queued;
+    if (refresh) {
+        cap_stale = false;
+        cap_queued = true;
+    }
+    if (total) {
+        *total = cap_total;
+    }
+    if (used) {
+        *used = cap_used;
+    }
+    portEXIT_CRITICAL(&fs_mux);
+
+    if (refresh && !submit(FS_OP_CAPACITY, SD, NULL, NULL, NULL, 0, 0, NULL, NULL)) {
+        portENTER_CRITICAL(&fs_mux);
+        cap_queued = false;
+        cap_stale = true;
+        portEXIT_CRITICAL(&fs_mux);
+    }
+    return valid;
+}
+
+void fs_invalidate_usage() {
+    portENTER_CRITICAL(&fs_mux);
+    cap_stale = true;
+    portEXIT_CRITICAL(&fs_mux);
+}
+
+void fs_card_changed() {
+    portENTER_CRITICAL(&fs_mux);
+    cap_valid = false;
+    cap_stale = true;
+    cap_total = 0;
+    cap_used = 0;
+    portEXIT_CRITICAL(&fs_mux);
+}
+
+void fs_get_stats(fs_stats_t *stats) {
+    portENTER_CRITICAL(&fs_mux);
+    *stats = fs_stats;
+    portEXIT_CRITICAL(&fs_mux);
+}
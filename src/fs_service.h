@@ -0,0 +1,105 @@
+/**
+ * @file      fs_service.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     File system requests run on a worker task, completed by callback or event
+ */
+
+#ifndef FS_SERVICE_H
+#define FS_SERVICE_H
+
+#include <Arduino.h>
+#include <FS.h>
+
+/**
+ * Callers queue a request and carry on; the worker runs them in order and
+ * reports each through its callback, in the worker task, or, without one,
+ * as an EventType::FS_COMPLETE event carrying the FsResult. Buffers passed
+ * in belong to the service until then. Requests on SD hold spi_bus for the
+ * one operation.
+ *
+ * Card capacity is cached: fs_capacity() answers from the cache at once
+ * and queues a refresh when there is none or a write made it stale. Code
+ * that writes SD itself calls fs_invalidate_usage()
+ *
+ * Successful writes, removes, mkdirs and renames on SD also mark the
+ * file manager's index of the directory stale (dir_index_touch()).
+ */
+
+#define FS_QUEUE_DEPTH              8
+#define FS_PATH_MAX                 64
+#define FS_TASK_STACK               (1024 * 4)
+#define FS_TASK_PRIORITY            (tskIDLE_PRIORITY + 1)  // SD writes stay below the radio
+
+enum FsOp {
+    FS_OP_READ = 0,             // len bytes at offset into buf
+    FS_OP_WRITE,                // Replace the file with buf
+    FS_OP_APPEND,
+    FS_OP_STAT,                 // size and is_dir
+    FS_OP_LIST,                 // Names into buf, one per line, directories end in '/'
+    FS_OP_REMOVE,
+    FS_OP_MKDIR,
+    FS_OP_RENAME,               // path to path2
+    FS_OP_CAPACITY,             // Refreshes the cache
+};
+
+struct FsResult {
+    uint32_t id;
+    uint8_t op;
+    bool ok;
+    bool is_dir;
+    uint32_t size;              // Bytes moved, listed or the file size
+    uint64_t total;             // FS_OP_CAPACITY
+    uint64_t used;
+    void *ctx;
+};
+
+typedef void (*fs_done_cb)(const FsResult *res, void *ctx);
+
+typedef struct {
+    uint32_t queued;
+    uint32_t done;
+    uint32_t failed;
+    uint32_t rejected;          // Queue full
+    uint32_t busy_max_ms;       // Longest single operation
+    uint32_t capacity_ms;       // Last capacity scan
+} fs_stats_t;
+
+/**
+ * @brief Start the worker. Safe to call again
+ */
+bool fs_service_begin();
+
+/**
+ * @return request id, 0 if the queue is full or the service is not running
+ */
+uint32_t fs_read(fs::FS &fs, const char *path, uint32_t offset, void *buf, size_t len,
+                 fs_done_cb cb = NULL, void *ctx = NULL);
+uint32_t fs_write(fs::FS &fs, const char *path, const void *buf, size_t len,
+                  fs_done_cb cb = NULL, void *ctx = NULL);
+uint32_t fs_append(fs::FS &fs, const char *path, const void *buf, size_t len,
+                   fs_done_cb cb = NULL, void *ctx = NULL);
+uint32_t fs_stat(fs::FS &fs, const char *path, fs_done_cb cb = NULL, void *ctx = NULL);
+uint32_t fs_list(fs::FS &fs, const char *path, char *buf, size_t len,
+                 fs_done_cb cb = NULL, void *ctx = NULL);
+uint32_t fs_remove(fs::FS &fs, const char *path, fs_done_cb cb = NULL, void *ctx = NULL);
+uint32_t fs_mkdir(fs::FS &fs, const char *path, fs_done_cb cb = NULL, void *ctx = NULL);
+uint32_t fs_rename(fs::FS &fs, const char *from, const char *to, fs_done_cb cb = NULL, void *ctx = NULL);
+
+/**
+ * @brief SD card size and use from the cache, never touching the card
+ * @return false until the first scan completed
+ */
+bool fs_capacity(uint64_t *total, uint64_t *used);
+void fs_invalidate_usage();
+
+/**
+ * @brief A card came or went: drop the cached figures entirely
+ */
+void fs_card_changed();
+
+void fs_get_stats(fs_stats_t *stats);
+
+#endif // FS_SERVICE_H
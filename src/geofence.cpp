@@ -0,0 +1,564 @@
+/**
+ * @file      geofence.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Geofences and waypoints: grid index, fixed-point point-in-polygon,
+ *            enter/exit events and GPS rate from the nearest boundary
+ */
+
+#include "geofence.h"
+#include <SD.h>
+#include <math.h>
+#include "simple_logger.h"
+#include "spi_bus.h"
+#include "sd_manager.h"
+#include "peripheral.h"
+#ifdef INTEGRATION_LAYER_ENABLED
+#include "integration/config_manager.h"
+#include "integration/event_bridge.h"
+#endif
+
+#define M_PER_E7            0.0111319f  // Metres per 1e-7 deg of latitude
+#define CELL_OFFSET_LAT     900000000LL
+#define CELL_OFFSET_LNG     1800000000LL
+
+struct Fence {
+    char name[GEOFENCE_NAME_MAX];
+    int32_t min_lat, min_lng;
+    int32_t max_lat, max_lng;
+    uint32_t first;                 // Vertex; a waypoint's centre
+    uint16_t count;                 // Vertices, 1 for a waypoint
+    uint16_t radius_m;              // Waypoints only
+};
+
+struct Vertex {
+    int32_t lat, lng;
+};
+
+struct IndexEntry {
+    uint32_t cell;                  // Row << 16 | column
+    uint16_t fence;
+    uint16_t reserved;
+};
+
+static SemaphoreHandle_t fence_lock = nullptr;
+static String fence_path = GEOFENCE_FILE;
+static GeofenceStats fence_stats;
+
+// PSRAM, replaced as a whole on reload
+static Fence *fences = nullptr;
+static Vertex *vertices = nullptr;
+static IndexEntry *fence_index = nullptr;
+static uint32_t *fence_seen = nullptr;          // Epoch a fence was last a candidate in
+static uint16_t fence_count = 0;
+static uint32_t vertex_count = 0;
+static uint32_t index_count = 0;
+static uint16_t wide[GEOFENCE_WIDE_MAX];
+static uint8_t wide_count = 0;
+
+// State, under fence_lock
+static uint8_t inside[GEOFENCE_MAX / 8];
+static bool state_known = false;
+static uint32_t check_epoch = 0;
+static uint32_t fix_interval = 0;
+
+static inline bool bit_get(uint16_t i) {
+    return inside[i >> 3] & (1 << (i & 7));
+}
+
+static inline void bit_set(uint16_t i, bool on) {
+    if (on) {
+        inside[i >> 3] |= 1 << (i & 7);
+    } else {
+        inside[i >> 3] &= ~(1 << (i & 7));
+    }
+}
+
+static inline uint32_t cell_row(int32_t lat) {
+    return (uint32_t)((lat + CELL_OFFSET_LAT) / GEOFENCE_CELL_E7);
+}
+
+static inline uint32_t cell_col(int32_t lng) {
+    return (uint32_t)((lng + CELL_OFFSET_LNG) / GEOFENCE_CELL_E7);
+}
+
+static void *psram_realloc(void *p, size_t size) {
+    return heap_caps_realloc(p, size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+}
+
+static void release() {
+    free(fences);
+    free(vertices);
+    free(fence_index);
+    free(fence_seen);
+    fences = nullptr;
+    vertices = nullptr;
+    fence_index = nullptr;
+    fence_seen = nullptr;
+    fence_count = 0;
+    vertex_count = 0;
+    index_count = 0;
+    wide_count = 0;
+}
+
+// ===== Loading =====
+
+static bool add_vertex(int32_t lat, int32_t lng) {
+    if (vertex_count >= GEOFENCE_VERTICES_MAX) {
+        return false;
+    }
+    // Doubling keeps the reallocations to a handful
+    if (!(vertex_count & (vertex_count - 1))) {
+        Vertex *grown = (Vertex *)psram_realloc(vertices, max(vertex_count * 2, (uint32_t)64) * sizeof(Vertex));
+        if (!grown) {
+            return false;
+        }
+        vertices = grown;
+    }
+    vertices[vertex_count++] = { lat, lng };
+    return true;
+}
+
+static bool to_e7(double lat, double lng, int32_t *lat_e7, int32_t *lng_e7) {
+    if (lat < -90 || lat > 90 || lng < -180 || lng > 180) {
+        return false;
+    }
+    *lat_e7 = (int32_t)lround(lat * 1e7);
+    *lng_e7 = (int32_t)lround(lng * 1e7);
+    return true;
+}
+
+static Fence *open_fence(const char *name) {
+    if (fence_count >= GEOFENCE_MAX) {
+        return nullptr;
+    }
+    if (!(fence_count & (fence_count - 1))) {
+        Fence *grown = (Fence *)psram_realloc(fences, max(fence_count * 2, 16) * sizeof(Fence));
+        if (!grown) {
+            return nullptr;
+        }
+        fences = grown;
+    }
+    Fence *f = &fences[fence_count];
+    memset(f, 0, sizeof(*f));
+    strlcpy(f->name, name, sizeof(f->name));
+    f->first = vertex_count;
+    return f;
+}
+
+// Bounds the fence; drops it if it cannot be used
+static void close_fence(Fence *f, bool waypoint) {
+    if (!f) {
+        return;
+    }
+    f->count = vertex_count - f->first;
+    if (!f->count) {
+        LOG_WARNF("Geofence", "Skipping \"%s\": no points", f->name);
+        return;
+    }
+    const Vertex *v = vertices + f->first;
+    if (!waypoint && f->count > 1 && v[0].lat == v[f->count - 1].lat && v[0].lng == v[f->count - 1].lng) {
+        f->count--;
+        vertex_count--;
+    }
+    if (waypoint) {
+        int32_t dlat = (int32_t)(f->radius_m / M_PER_E7);
+        int32_t dlng = (int32_t)(dlat / max(cosf(v[0].lat * 1e-7f * (float)M_PI / 180), 0.01f));
+        f->min_lat = v[0].lat - dlat;
+        f->max_lat = v[0].lat + dlat;
+        f->min_lng = v[0].lng - dlng;
+        f->max_lng = v[0].lng + dlng;
+    } else {
+        f->min_lat = f->max_lat = v[0].lat;
+        f->min_lng = f->max_lng = v[0].lng;
+        for (uint16_t i = 1; i < f->count; i++) {
+            f->min_lat = min(f->min_lat, v[i].lat);
+            f->max_lat = max(f->max_lat, v[i].lat);
+            f->min_lng = min(f->min_lng, v[i].lng);
+            f->max_lng = max(f->max_lng, v[i].lng);
+        }
+    }
+    if ((!waypoint && f->count < 3) || f->max_lat - f->min_lat > GEOFENCE_SPAN_MAX_E7 ||
+        f->max_lng - f->min_lng > GEOFENCE_SPAN_MAX_E7) {
+        LOG_WARNF("Geofence", "Skipping \"%s\": too few points or too large", f->name);
+        vertex_count = f->first;
+        return;
+    }
+    if (waypoint) {
+        fence_stats.waypoints++;
+    }
+    fence_count++;
+}
+
+static bool parse(File &file) {
+    char line[GEOFENCE_LINE_MAX];
+    Fence *open = nullptr;
+    uint32_t number = 0;
+    while (file.available()) {
+        size_t n = file.readBytesUntil('\n', line, sizeof(line) - 1);
+        line[n] = '\0';
+        number++;
+        char *s = line;
+        while (*s == ' ' || *s == '\t') {
+            s++;
+        }
+        s[strcspn(s, "\r")] = '\0';
+        if (!*s || *s == '#') {
+            continue;
+        }
+
+        double lat, lng;
+        int32_t lat_e7, lng_e7;
+        if (!strncmp(s, "fence ", 6)) {
+            close_fence(open, false);
+            open = open_fence(s + 6);
+            if (!open) {
+                break;
+            }
+        } else if (!strncmp(s, "waypoint ", 9)) {
+            close_fence(open, false);
+            open = nullptr;
+            unsigned radius;
+            int used = 0;
+            if (sscanf(s + 9, "%lf %lf %u %n", &lat, &lng, &radius, &used) < 3 || !used ||
+                !to_e7(lat, lng, &lat_e7, &lng_e7) || !radius || radius > UINT16_MAX) {
+                LOG_WARNF("Geofence", "Line %lu: bad waypoint", (unsigned long)number);
+                continue;
+            }
+            Fence *w = open_fence(s + 9 + used);
+            if (!w || !add_vertex(lat_e7, lng_e7)) {
+                break;
+            }
+            w->radius_m = radius;
+            close_fence(w, true);
+        } else if (open && sscanf(s, "%lf %lf", &lat, &lng) == 2 && to_e7(lat, lng, &lat_e7, &lng_e7)) {
+            if (!add_vertex(lat_e7, lng_e7)) {
+                break;
+            }
+        } else {
+            LOG_WARNF("Geofence", "Line %lu: not understood", (unsigned long)number);
+        }
+    }
+    close_fence(open, false);
+    if (fence_count >= GEOFENCE_MAX || vertex_count >= GEOFENCE_VERTICES_MAX) {
+        LOG_WARN("Geofence", "Too many fences or points, the rest are ignored");
+    }
+    return fence_count > 0;
+}
+
+static int compare_entry(const void *a, const void *b) {
+    uint32_t ca = ((const IndexEntry *)a)->cell, cb = ((const IndexEntry *)b)->cell;
+    return ca < cb ? -1 : ca > cb;
+}
+
+static bool build_index() {
+    uint32_t total = 0;
+    for (uint16_t i = 0; i < fence_count; i++) {
+        const Fence *f = &fences[i];
+        uint32_t cells = (cell_row(f->max_lat) - cell_row(f->min_lat) + 1) * (cell_col(f->max_lng) - cell_col(f->min_lng) + 1);
+        if (cells > GEOFENCE_CELLS_MAX && wide_count < GEOFENCE_WIDE_MAX) {
+            wide[wide_count++] = i;
+        } else {
+            total += cells;
+        }
+    }
+    fence_index = (IndexEntry *)psram_realloc(nullptr, max(total, (uint32_t)1) * sizeof(IndexEntry));
+    fence_seen = (uint32_t *)psram_realloc(nullptr, fence_count * sizeof(uint32_t));
+    if (!fence_index || !fence_seen) {
+        return false;
+    }
+    memset(fence_seen, 0, fence_count * sizeof(uint32_t));
+
+    uint8_t w = 0;
+    for (uint16_t i = 0; i < fence_count; i++) {
+        if (w < wide_count && wide[w] == i) {
+            w++;
+            continue;
+        }
+        const Fence *f = &fences[i];
+        for (uint32_t row = cell_row(f->min_lat); row <= cell_row(f->max_lat); row++) {
+            for (uint32_t col = cell_col(f->min_lng); col <= cell_col(f->max_lng); col++) {
+                fence_index[index_count++] = { row << 16 | col, i, 0 };
+            }
+        }
+    }
+    qsort(fence_index, index_count, sizeof(IndexEntry), compare_entry);
+    return true;
+}
+
+static bool load() {
+    release();
+    memset(&fence_stats, 0, sizeof(fence_stats));
+    memset(inside, 0, sizeof(inside));
+    state_known = false;
+
+    if (!sd_manager_mounted()) {
+        return false;
+    }
+    bool ok;
+    spi_bus_acquire(SPI_CLIENT_SD);
+    File file = SD.open(fence_path.c_str(), FILE_READ);
+    ok = file && parse(file);
+    if (file) {
+        file.close();
+    }
+    spi_bus_release(SPI_CLIENT_SD);
+
+    ok = ok && build_index();
+    if (!ok) {
+        release();
+        return false;
+    }
+    fence_stats.fences = fence_count - fence_stats.waypoints;
+    fence_stats.vertices = vertex_count;
+    fence_stats.index_entries = index_count;
+    LOG_INFOF("Geofence", "%u fences, %u waypoints, %lu points, %lu index entries", fence_stats.fences,
+              fence_stats.waypoints, (unsigned long)vertex_count, (unsigned long)index_count);
+    return true;
+}
+
+// ===== Tests =====
+
+// Crossing number in integers relative to the box corner: coordinates fit
+// in 32 bits there and every product in 64
+static bool point_in_polygon(const Fence *f, int32_t lat, int32_t lng) {
+    const Vertex *v = vertices + f->first;
+    int64_t py = lat - f->min_lat, px = lng - f->min_lng;
+    bool in = false;
+    for (uint16_t i = 0, j = f->count - 1; i < f->count; j = i++) {
+        int64_t yi = v[i].lat - f->min_lat, yj = v[j].lat - f->min_lat;
+        if ((yi > py) == (yj > py)) {
+            continue;
+        }
+        int64_t xi = v[i].lng - f->min_lng, xj = v[j].lng - f->min_lng;
+        // px left of the edge at py, multiplied out by (yj - yi)
+        int64_t lhs = (px - xi) * (yj - yi);
+        int64_t rhs = (xj - xi) * (py - yi);
+        if (yj > yi ? lhs < rhs : lhs > rhs) {
+            in = !in;
+        }
+    }
+    return in;
+}
+
+// Metres to the boundary; fine as float, it only sizes margins and the GPS rate
+static float boundary_distance(const Fence *f, int32_t lat, int32_t lng, float m_lng) {
+    const Vertex *v = vertices + f->first;
+    if (f->radius_m) {
+        float dx = (v[0].lng - lng) * m_lng, dy = (v[0].lat - lat) * M_PER_E7;
+        return fabsf(sqrtf(dx * dx + dy * dy) - f->radius_m);
+    }
+    float best = INFINITY;
+    for (uint16_t i = 0, j = f->count - 1; i < f->count; j = i++) {
+        float ax = (v[j].lng - lng) * m_lng, ay = (v[j].lat - lat) * M_PER_E7;
+        float bx = (v[i].lng - lng) * m_lng, by = (v[i].lat - lat) * M_PER_E7;
+        float dx = bx - ax, dy = by - ay;
+        float len2 = dx * dx + dy * dy;
+        float t = len2 > 0 ? constrain(-(ax * dx + ay * dy) / len2, 0.0f, 1.0f) : 0;
+        float cx = ax + t * dx, cy = ay + t * dy;
+        best = min(best, cx * cx + cy * cy);
+    }
+    return sqrtf(best);
+}
+
+// Lower bound of the distance to anything in the fence
+static float box_distance(const Fence *f, int32_t lat, int32_t lng, float m_lng) {
+    int32_t dlat = lat < f->min_lat ? f->min_lat - lat : lat > f->max_lat ? lat - f->max_lat : 0;
+    int32_t dlng = lng < f->min_lng ? f->min_lng - lng : lng > f->max_lng ? lng - f->max_lng : 0;
+    return max(dlat * M_PER_E7, dlng * m_lng);
+}
+
+static bool contains(const Fence *f, int32_t lat, int32_t lng, float m_lng) {
+    if (lat < f->min_lat || lat > f->max_lat || lng < f->min_lng || lng > f->max_lng) {
+        return false;
+    }
+    fence_stats.tests++;
+    if (f->radius_m) {
+        const Vertex *c = vertices + f->first;
+        float dx = (c->lng - lng) * m_lng, dy = (c->lat - lat) * M_PER_E7;
+        return dx * dx + dy * dy < (float)f->radius_m * f->radius_m;
+    }
+    return point_in_polygon(f, lat, lng);
+}
+
+// ===== Updates =====
+
+static void publish(uint16_t i, bool entered, int32_t lat, int32_t lng) {
+    fence_stats.crossings++;
+    LOG_INFOF("Geofence", "%s \"%s\"", entered ? "Entered" : "Left", fences[i].name);
+#ifdef INTEGRATION_LAYER_ENABLED
+    if (GlobalEventBridge) {
+        GeofenceEvent ev = {};
+        ev.fence = i;
+        ev.entered = entered;
+        ev.waypoint = fences[i].radius_m != 0;
+        strlcpy(ev.name, fences[i].name, sizeof(ev.name));
+        ev.lat = lat;
+        ev.lng = lng;
+        GlobalEventBridge->publishTypedEvent(EventType::GEOFENCE_CROSSED, "Geofence", ev);
+    }
+#endif
+}
+
+static void check_fence(uint16_t i, int32_t lat, int32_t lng, float m_lng, float margin, float *nearest) {
+    if (fence_seen[i] == check_epoch) {
+        return;
+    }
+    fence_seen[i] = check_epoch;
+    fence_stats.candidates++;
+    const Fence *f = &fences[i];
+    bool was = bit_get(i);
+    bool in = contains(f, lat, lng, m_lng);
+    if (in == was && box_distance(f, lat, lng, m_lng) >= *nearest) {
+        return;
+    }
+    float d = boundary_distance(f, lat, lng, m_lng);
+    *nearest = min(*nearest, d);
+    if (in == was) {
+        return;
+    }
+    if (!state_known) {
+        bit_set(i, in);
+    } else if (d >= margin) {
+        bit_set(i, in);
+        publish(i, in, lat, lng);
+    }
+}
+
+static void set_fix_interval(uint32_t ms) {
+    // Small changes are not worth waking the GPS task for
+    if (fix_interval && ms * 4 > fix_interval * 3 && ms * 3 < fix_interval * 4) {
+        return;
+    }
+    fix_interval = ms;
+    fence_stats.fix_interval_ms = ms;
+    gps_power_request(GPS_CONSUMER_FENCE, ms);
+}
+
+static void check(const gps_fix_t *fix) {
+    uint32_t start = micros();
+    int32_t lat, lng;
+    if (!to_e7(fix->lat, fix->lng, &lat, &lng)) {
+        return;
+    }
+    float m_lng = M_PER_E7 * max(cosf((float)fix->lat * (float)M_PI / 180), 0.01f);
+    float margin = max((float)GEOFENCE_HYSTERESIS_M, fix->h_acc);
+    // The 3x3 cells reach at least one cell in every direction
+    float nearest = min((float)GEOFENCE_FAR_M, GEOFENCE_CELL_E7 * min(M_PER_E7, m_lng));
+    fence_stats.updates++;
+    if (!++check_epoch) {
+        memset(fence_seen, 0, fence_count * sizeof(uint32_t));
+        check_epoch = 1;
+    }
+
+    uint32_t row = cell_row(lat), col = cell_col(lng);
+    for (uint32_t r = row ? row - 1 : 0; r <= row + 1; r++) {
+        for (uint32_t c = col ? col - 1 : 0; c <= col + 1; c++) {
+            uint32_t key = r << 16 | c;
+            uint32_t lo = 0, hi = index_count;
+            while (lo < hi) {
+                uint32_t mid = (lo + hi) / 2;
+                if (fence_index[mid].cell < key) {
+                    lo = mid + 1;
+                } else {
+                    hi = mid;
+                }
+            }
+            for (; lo < index_count && fence_index[lo].cell == key; lo++) {
+                check_fence(fence_index[lo].fence, lat, lng, m_lng, margin, &nearest);
+            }
+        }
+    }
+    for (uint8_t w = 0; w < wide_count; w++) {
+        check_fence(wide[w], lat, lng, m_lng, margin, &nearest);
+    }
+    // A fix that jumped far away still has to leave what it was in
+    for (uint16_t b = 0; b < (fence_count + 7) / 8; b++) {
+        for (uint8_t m = inside[b]; m; m &= m - 1) {
+            check_fence(b * 8 + __builtin_ctz(m), lat, lng, m_lng, margin, &nearest);
+        }
+    }
+    state_known = true;
+
+    // Half the time the boundary could be reached in
+    float speed = max((float)fix->speed / 3.6f, GEOFENCE_SPEED_MIN_MPS);
+    uint32_t ms = (uint32_t)constrain(nearest / speed * 500.0f, (float)GEOFENCE_FIX_MIN_MS, (float)GEOFENCE_FIX_MAX_MS);
+    fence_stats.nearest_m = (uint32_t)nearest;
+    set_fix_interval(ms);
+    fence_stats.check_us_max = max(fence_stats.check_us_max, (uint32_t)(micros() - start));
+}
+
+#ifdef INTEGRATION_LAYER_ENABLED
+static void on_location(const Event &event, void *context) {
+    const gps_fix_t *fix = event.getPayload<gps_fix_t>();
+    if (!fix || !fix->valid) {
+        return;
+    }
+    xSemaphoreTake(fence_lock, portMAX_DELAY);
+    if (fence_count) {
+        check(fix);
+    }
+    xSemaphoreGive(fence_lock);
+}
+#endif
+
+// ===== API =====
+
+bool geofence_begin() {
+#ifdef INTEGRATION_LAYER_ENABLED
+    if (fence_lock) {
+        return fence_count > 0;
+    }
+    if (!GlobalEventBridge || !GET_CONFIG_BOOL("geofence", "enabled", true)) {
+        return false;
+    }
+    fence_path = GET_CONFIG_STRING("geofence", "file", String(GEOFENCE_FILE));
+    fence_lock = xSemaphoreCreateMutex();
+    if (!fence_lock || !geofence_reload()) {
+        return false;
+    }
+    // Off the GPS task: a large fence set takes a while to test
+    uint8_t worker = GlobalEventBridge->createWorker("geofence", 1);
+    return GlobalEventBridge->subscribe("Geofence", EventType::GPS_LOCATION_UPDATE, on_location, nullptr,
+                                        EventPriority::EVENT_LOW, worker);
+#else
+    return false;
+#endif
+}
+
+bool geofence_reload() {
+    if (!fence_lock) {
+        return false;
+    }
+    xSemaphoreTake(fence_lock, portMAX_DELAY);
+    bool ok = load();
+    fix_interval = 0;
+    xSemaphoreGive(fence_lock);
+    // Prompt first fix, then the nearest boundary sets the pace
+    gps_power_request(GPS_CONSUMER_FENCE, ok ? GEOFENCE_FIX_MIN_MS : 0);
+    return ok;
+}
+
+bool geofence_inside(uint16_t fence) {
+    return fence < fence_count && state_known && bit_get(fence);
+}
+
+const char *geofence_name(uint16_t fence) {
+    return fence < fence_count ? fences[fence].name : "";
+}
+
+uint16_t geofence_count() {
+    return fence_count;
+}
+
+void geofence_get_stats(GeofenceStats *stats) {
+    if (!fence_lock) {
+        memset(stats, 0, sizeof(*stats));
+        return;
+    }
+    xSemaphoreTake(fence_lock, portMAX_DELAY);
+    *stats = fence_stats;
+    xSemaphoreGive(fence_lock);
+}
@@ -0,0 +1,113 @@
+/**
+ * @file      geofence.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Geofences and waypoints: grid index, fixed-point point-in-polygon,
+ *            enter/exit events and GPS rate from the nearest boundary
+ */
+
+#ifndef GEOFENCE_H
+#define GEOFENCE_H
+
+#include <Arduino.h>
+
+/**
+ * Fences are polygons, waypoints are circles; both come from
+ * GEOFENCE_FILE on the SD card:
+ *
+ *   # comment
+ *   fence Home
+ *   51.50120 -0.14190
+ *   51.50160 -0.14020
+ *   51.50030 -0.13980
+ *   waypoint 51.51030 -0.13410 50 Cafe
+ *
+ * A fence takes the "lat lng" lines up to the next keyword; a waypoint
+ * gives its centre and radius in metres before its name. Coordinates are
+ * kept as 1e-7 deg integers; fences may not cross the antimeridian.
+ *
+ * Index: a grid of GEOFENCE_CELL_E7 cells, one (cell, fence) entry per
+ * cell a fence's bounding box touches, sorted and binary searched from
+ * PSRAM. Fences wider than GEOFENCE_CELLS_MAX cells go on a short list
+ * that is always checked. Each GPS_LOCATION_UPDATE looks up its cell and
+ * the eight around it, drops fences whose box misses the fix, and runs
+ * the crossing-number test on the rest in 64-bit integers relative to
+ * the fence's corner, so no float rounding decides an edge case.
+ *
+ * A fence changes state only once the fix is GEOFENCE_HYSTERESIS_M (or
+ * its own accuracy, if worse) past the boundary, so a fix wandering
+ * along it does not flap. The first fix sets the state silently. Each
+ * change goes out as EventType::GEOFENCE_CROSSED with a GeofenceEvent.
+ *
+ * GPS rate: the nearest boundary among the candidates bounds how soon a
+ * crossing can happen, at the fix's speed or GEOFENCE_SPEED_MIN_MPS if
+ * slower. Half that time, within GEOFENCE_FIX_MIN_MS..GEOFENCE_FIX_MAX_MS,
+ * is asked of the GPS power manager as GPS_CONSUMER_FENCE.
+ *
+ * Config section "geofence": enabled, file.
+ */
+
+#define GEOFENCE_FILE               "/gps/fences.txt"
+#define GEOFENCE_MAX                1024
+#define GEOFENCE_VERTICES_MAX       65536       // All fences together
+#define GEOFENCE_NAME_MAX           24
+#define GEOFENCE_SPAN_MAX_E7        100000000   // 10 deg; keeps the cross products in 64 bits
+#define GEOFENCE_CELL_E7            200000      // 0.02 deg, about 2 km
+#define GEOFENCE_CELLS_MAX          64          // Larger fences are always checked
+#define GEOFENCE_WIDE_MAX           32
+#define GEOFENCE_HYSTERESIS_M       15
+#define GEOFENCE_SPEED_MIN_MPS      2.0f        // Assumed when slower: walking can start any time
+#define GEOFENCE_FIX_MIN_MS         5000
+#define GEOFENCE_FIX_MAX_MS         300000
+#define GEOFENCE_FAR_M              2000        // Nothing in the 3x3 cells is at least this far
+#define GEOFENCE_LINE_MAX           96
+
+// EventType::GEOFENCE_CROSSED payload
+struct GeofenceEvent {
+    uint16_t fence;
+    bool entered;
+    bool waypoint;
+    char name[GEOFENCE_NAME_MAX];
+    int32_t lat;                    // 1e-7 deg, the fix that crossed
+    int32_t lng;
+};
+
+struct GeofenceStats {
+    uint16_t fences;
+    uint16_t waypoints;
+    uint32_t vertices;
+    uint32_t index_entries;
+    uint32_t updates;
+    uint32_t candidates;            // Fences past the grid, all updates
+    uint32_t tests;                 // Past the bounding box too
+    uint32_t crossings;
+    uint32_t check_us_max;
+    uint32_t nearest_m;             // To a boundary, last update
+    uint32_t fix_interval_ms;
+};
+
+/**
+ * @brief Load GEOFENCE_FILE and follow GPS_LOCATION_UPDATE
+ * @return false without the event bridge or any fences
+ */
+bool geofence_begin();
+
+/**
+ * @brief Reload the file, e.g. after it was edited; states start over
+ */
+bool geofence_reload();
+
+/**
+ * @brief Whether the last fix was inside a fence, false if unknown
+ */
+bool geofence_inside(uint16_t fence);
+
+const char *geofence_name(uint16_t fence);
+
+uint16_t geofence_count();
+
+void geofence_get_stats(GeofenceStats *stats);
+
+#endif // GEOFENCE_H
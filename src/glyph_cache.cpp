@@ -0,0 +1,242 @@
+/**
+ * @file      glyph_cache.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Glyph cache implementation
+ */
+
+#include "glyph_cache.h"
+#include "simple_logger.h"
+#include "src/assets.h"
+#include <esp_heap_caps.h>
+
+#define GLYPH_CACHE_NONE  (-1)
+
+struct GlyphEntry {
+    const lv_font_t* font;        // Cached wrapper font, nullptr when the slot is free
+    uint32_t letter;
+    uint32_t last_used;           // LRU stamp
+    int16_t next;                 // Next entry in the same hash bucket
+    uint8_t bitmap[GLYPH_CACHE_SLOT_BYTES];
+};
+
+static GlyphEntry* entries = nullptr;
+static int16_t buckets[GLYPH_CACHE_BUCKETS];
+static uint16_t entries_used = 0;
+static uint32_t use_clock = 0;
+
+static uint32_t cache_hits = 0;
+static uint32_t cache_misses = 0;
+static uint32_t cache_evictions = 0;
+static uint32_t cache_bypassed = 0;
+
+static bool cached_get_glyph_dsc(const lv_font_t* font, lv_font_glyph_dsc_t* dsc_out,
+                                 uint32_t letter, uint32_t letter_next);
+static const uint8_t* cached_get_glyph_bitmap(const lv_font_t* font, uint32_t letter);
+
+static lv_font_t make_cached_font(const lv_font_t* base) {
+    lv_font_t font = *base;
+    font.get_glyph_dsc = cached_get_glyph_dsc;
+    font.get_glyph_bitmap = cached_get_glyph_bitmap;
+    font.user_data = (void*)base;
+    return font;
+}
+
+lv_font_t Font_Mono_Bold_14_cached = make_cached_font(&Font_Mono_Bold_14);
+lv_font_t Font_Mono_Bold_15_cached = make_cached_font(&Font_Mono_Bold_15);
+lv_font_t Font_Mono_Bold_16_cached = make_cached_font(&Font_Mono_Bold_16);
+lv_font_t Font_Mono_Bold_17_cached = make_cached_font(&Font_Mono_Bold_17);
+lv_font_t Font_Mono_Bold_18_cached = make_cached_font(&Font_Mono_Bold_18);
+lv_font_t Font_Mono_Bold_19_cached = make_cached_font(&Font_Mono_Bold_19);
+lv_font_t Font_Mono_Bold_20_cached = make_cached_font(&Font_Mono_Bold_20);
+
+static inline const lv_font_t* base_font(const lv_font_t* font) {
+    return (const lv_font_t*)font->user_data;
+}
+
+static inline uint32_t bucket_of(const lv_font_t* font, uint32_t letter) {
+    return (((uint32_t)(uintptr_t)font >> 2) * 31 + letter) & (GLYPH_CACHE_BUCKETS - 1);
+}
+
+// Only multi-bit glyphs that fit a slot are served from the cache
+static inline bool cacheable(const lv_font_glyph_dsc_t* dsc) {
+    if (!entries || dsc->bpp <= 1 || dsc->bpp == 3) {
+        return false;
+    }
+    uint32_t pixels = (uint32_t)dsc->box_w * dsc->box_h;
+    return pixels > 0 && (pixels + 7) / 8 <= GLYPH_CACHE_SLOT_BYTES;
+}
+
+static bool cached_get_glyph_dsc(const lv_font_t* font, lv_font_glyph_dsc_t* dsc_out,
+                                 uint32_t letter, uint32_t letter_next) {
+    const lv_font_t* base = base_font(font);
+    if (!base->get_glyph_dsc(base, dsc_out, letter, letter_next)) {
+        return false;
+    }
+    
+    // Must agree with cached_get_glyph_bitmap() on which glyphs come back as 1bpp
+    if (cacheable(dsc_out)) {
+        dsc_out->bpp = 1;
+    }
+    return true;
+}
+
+static void threshold_glyph(const uint8_t* src, uint8_t bpp, uint32_t pixels, uint8_t* dst) {
+    uint8_t mask = (1 << bpp) - 1;
+    uint8_t half = 1 << (bpp - 1);
+    
+    memset(dst, 0, (pixels + 7) / 8);
+    for (uint32_t i = 0; i < pixels; i++) {
+        uint32_t bit = i * bpp;
+        uint8_t value = (src[bit >> 3] >> (8 - bpp - (bit & 7))) & mask;
+        if (value >= half) {
+            dst[i >> 3] |= 0x80 >> (i & 7);
+        }
+    }
+}
+
+static GlyphEntry* lookup(const lv_font_t* font, uint32_t letter) {
+    for (int16_t i = buckets[bucket_of(font, letter)]; i != GLYPH_CACHE_NONE; i = entries[i].next) {
+        if (entries[i].font == font && entries[i].letter == letter) {
+            return &entries[i];
+        }
+    }
+    return nullptr;
+}
+
+static void unlink(int16_t index) {
+    int16_t* link = &buckets[bucket_of(entries[index].font, entries[index].letter)];
+    while (*link != GLYPH_CACHE_NONE) {
+        if (*link == index) {
+            *link = entries[index].next;
+            return;
+        }
+        link = &entries[*link].next;
+    }
+}
+
+static GlyphEntry* claim(const lv_font_t* font, uint32_t letter) {
+    int16_t index;
+    
+    if (entries_used < GLYPH_CACHE_ENTRIES) {
+        index = entries_used++;
+    } else {
+        // Full: evict the least recently used glyph
+        index = 0;
+        for (int16_t i = 1; i < GLYPH_CACHE_ENTRIES; i++) {
+            if (entries[i].last_used < entries[index].last_used) {
+                index = i;
+            }
+        }
+        unlink(index);
+        cache_evictions++;
+    }
+    
+    GlyphEntry* entry = &entries[index];
+    uint32_t bucket = bucket_of(font, letter);
+    entry->font = font;
+    entry->letter = letter;
+    entry->next = buckets[bucket];
+    buckets[bucket] = index;
+    return entry;
+}
+
+static const uint8_t* cached_get_glyph_bitmap(const lv_font_t* font, uint32_t letter) {
+    const lv_font_t* base = base_font(font);
+    
+    lv_font_glyph_dsc_t dsc;
+    bool found = base->get_glyph_dsc(base, &dsc, letter, 0);
+    if (!found || !cacheable(&dsc)) {
+        if (found && entries && dsc.bpp > 1) {
+            cache_bypassed++;
+        }
+        return base->get_glyph_bitmap(base, letter);
+    }
+    
+    GlyphEntry* entry = lookup(font, letter);
+    if (entry) {
+        cache_hits++;
+    } else {
+        const uint8_t* src = base->get_glyph_bitmap(base, letter);
+        if (!src) {
+            return nullptr;
+        }
+        cache_misses++;
+        entry = claim(font, letter);
+        threshold_glyph(src, dsc.bpp, (uint32_t)dsc.box_w * dsc.box_h, entry->bitmap);
+    }
+    
+    entry->last_used = ++use_clock;
+    return entry->bitmap;
+}
+
+bool glyph_cache_init() {
+    if (entries) {
+        return true;
+    }
+    
+    entries = (GlyphEntry*)heap_caps_malloc(sizeof(GlyphEntry) * GLYPH_CACHE_ENTRIES,
+                                            MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!entries) {
+        LOG_WARN("FONT", "No PSRAM for glyph cache, fonts stay uncached");
+        return false;
+    }
+    
+    for (int i = 0; i < GLYPH_CACHE_BUCKETS; i++) {
+        buckets[i] = GLYPH_CACHE_NONE;
+    }
+    entries_used = 0;
+    use_clock = 0;
+    
+    LOG_INFOF("FONT", "Glyph cache: %u entries, %u bytes PSRAM",
+              GLYPH_CACHE_ENTRIES, sizeof(GlyphEntry) * GLYPH_CACHE_ENTRIES);
+    return true;
+}
+
+void glyph_cache_deinit() {
+    if (entries) {
+        heap_caps_free(entries);
+        entries = nullptr;
+    }
+    entries_used = 0;
+}
+
+void glyph_cache_prewarm(const lv_font_t* font, uint32_t first, uint32_t last) {
+    if (!entries || !font || font->get_glyph_bitmap != cached_get_glyph_bitmap) {
+        return;
+    }
+    
+    for (uint32_t letter = first; letter <= last; letter++) {
+        cached_get_glyph_bitmap(font, letter);
+    }
+}
+
+void glyph_cache_rebind() {
+    Font_Mono_Bold_14_cached = make_cached_font(&Font_Mono_Bold_14);
+    Font_Mono_Bold_15_cached = make_cached_font(&Font_Mono_Bold_15);
+    Font_Mono_Bold_16_cached = make_cached_font(&Font_Mono_Bold_16);
+    Font_Mono_Bold_17_cached = make_cached_font(&Font_Mono_Bold_17);
+    Font_Mono_Bold_18_cached = make_cached_font(&Font_Mono_Bold_18);
+    Font_Mono_Bold_19_cached = make_cached_font(&Font_Mono_Bold_19);
+    Font_Mono_Bold_20_cached = make_cached_font(&Font_Mono_Bold_20);
+}
+
+void glyph_cache_get_stats(GlyphCacheStats* stats) {
+    if (!stats) {
+        return;
+    }
+    
+    stats->hits = cache_hits;
+    stats->misses = cache_misses;
+    stats->evictions = cache_evictions;
+    stats->bypassed = cache_bypassed;
+    stats->entries = entries_used;
+}
+
+void glyph_cache_print_stats() {
+    LOG_INFOF("FONT", "Glyph cache: %u/%u entries, %lu hits, %lu misses, %lu evictions, %lu bypassed",
+              entries_used, GLYPH_CACHE_ENTRIES, cache_hits, cache_misses,
+              cache_evictions, cache_bypassed);
+}
@@ -0,0 +1,67 @@
+/**
+ * @file      glyph_cache.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     PSRAM cache of pre-thresholded 1bpp glyph bitmaps for the Mono Bold fonts
+ */
+
+#ifndef GLYPH_CACHE_H
+#define GLYPH_CACHE_H
+
+#include <Arduino.h>
+#include <lvgl.h>
+
+// Glyph cache configuration
+#define GLYPH_CACHE_ENTRIES     768   // Glyphs kept before LRU eviction (7 fonts x 95 ASCII fit)
+#define GLYPH_CACHE_SLOT_BYTES  48    // 1bpp bitmap bytes per entry; larger glyphs bypass the cache
+#define GLYPH_CACHE_BUCKETS     256   // Hash buckets, power of two
+
+// Cached wrappers of Font_Mono_Bold_14..20. Use these instead of the raw fonts;
+// glyphs are thresholded at half coverage, which is what the 1-bit panel shows anyway.
+// C linkage for the constant styles in ui_theme.c.
+extern "C" {
+extern lv_font_t Font_Mono_Bold_14_cached;
+extern lv_font_t Font_Mono_Bold_15_cached;
+extern lv_font_t Font_Mono_Bold_16_cached;
+extern lv_font_t Font_Mono_Bold_17_cached;
+extern lv_font_t Font_Mono_Bold_18_cached;
+extern lv_font_t Font_Mono_Bold_19_cached;
+extern lv_font_t Font_Mono_Bold_20_cached;
+}
+
+struct GlyphCacheStats {
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t evictions;
+    uint32_t bypassed;     // Glyphs too large for a slot
+    uint16_t entries;      // Slots currently in use
+};
+
+/**
+ * @brief Allocate the cache in PSRAM. Until this succeeds the cached fonts
+ *        fall straight through to the original glyph data.
+ */
+bool glyph_cache_init();
+
+/**
+ * @brief Free the cache; cached fonts keep working uncached
+ */
+void glyph_cache_deinit();
+
+/**
+ * @brief Rasterize a codepoint range of a cached font ahead of use
+ */
+void glyph_cache_prewarm(const lv_font_t* font, uint32_t first, uint32_t last);
+
+/**
+ * @brief Copy the metrics of the base fonts into the wrappers again, for
+ *        bases filled in at run time (asset_store)
+ */
+void glyph_cache_rebind();
+
+void glyph_cache_get_stats(GlyphCacheStats* stats);
+void glyph_cache_print_stats();
+
+#endif // GLYPH_CACHE_H
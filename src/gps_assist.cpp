@@ -0,0 +1,539 @@
+/**
+ * @file      gps_assist.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Assisted GNSS: AssistNow fetch over the routed bearer, LittleFS
+ *            cache, MGA injection paced for the GPS UART
+ */
+
+#include "gps_assist.h"
+#include <HTTPClient.h>
+#include <LittleFS.h>
+#include <esp_rom_crc.h>
+#include <esp_timer.h>
+#include "simple_logger.h"
+#include "net_manager.h"
+#include "radio_sched.h"
+#include "time_service.h"
+#include "tls_client.h"
+#ifdef INTEGRATION_LAYER_ENABLED
+#include "integration/config_manager.h"
+#endif
+
+static_assert(sizeof(GpsAssistHeader) == 28, "Header is part of the cache file format");
+
+#define UBX_SYNC1               0xB5
+#define UBX_SYNC2               0x62
+#define UBX_HEADER_SIZE         6
+#define UBX_CLASS_MGA           0x13
+#define UBX_MGA_INI             0x40
+#define UBX_MGA_INI_POS_LLH     0x01
+#define UBX_MGA_INI_TIME_UTC    0x10
+
+static portMUX_TYPE assist_mux = portMUX_INITIALIZER_UNLOCKED;
+static GpsAssistStats assist_stats;
+static SemaphoreHandle_t assist_lock = nullptr;     // The cache, against a fetch replacing it
+static bool assist_fetching = false;
+static uint32_t assist_failed_at = 0;
+static bool assist_failed = false;
+
+static String assist_url;
+static bool assist_cell = true;
+static uint32_t assist_refresh_s = GPS_ASSIST_REFRESH_MIN * 60;
+static uint32_t assist_max_age_s = GPS_ASSIST_MAX_AGE_MIN * 60;
+
+// The cache, PSRAM; header.length bytes of frames
+static GpsAssistHeader assist_head;
+static uint8_t *assist_data = nullptr;
+static uint32_t assist_gen = 0;
+
+// Injection under way, GPS task only
+static uint32_t inject_gen = 0;
+static uint32_t inject_pos = 0;
+
+// ===== Clock =====
+
+static uint32_t clock_now() {
+    return time_valid() ? time_now_s() : 0;
+}
+
+// RFC 7231 IMF-fixdate, "Sun, 06 Nov 1994 08:49:37 GMT"; 0 if it is not one
+static uint32_t parse_http_date(const char *s) {
+    static const char months[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+    char mon[4];
+    int day, year, hour, min, sec;
+    if (sscanf(s, "%*3s, %d %3s %d %d:%d:%d", &day, mon, &year, &hour, &min, &sec) != 6) {
+        return 0;
+    }
+    const char *m = strstr(months, mon);
+    if (!m || (m - months) % 3 || day < 1 || day > 31 || hour > 23 || min > 59 || sec > 60) {
+        return 0;
+    }
+    int64_t t = time_make_utc(year, (m - months) / 3 + 1, day, hour, min, sec);
+    return t >= TIME_VALID_S && t <= UINT32_MAX ? (uint32_t)t : 0;
+}
+
+// ===== Frames =====
+
+static uint8_t *ubx_frame(uint8_t *p, uint8_t cls, uint8_t id, const uint8_t *payload, uint16_t len) {
+    uint8_t *start = p;
+    *p++ = UBX_SYNC1;
+    *p++ = UBX_SYNC2;
+    *p++ = cls;
+    *p++ = id;
+    *p++ = (uint8_t)len;
+    *p++ = (uint8_t)(len >> 8);
+    memcpy(p, payload, len);
+    p += len;
+    uint8_t ck_a = 0, ck_b = 0;
+    for (uint8_t *q = start + 2; q < p; q++) {
+        ck_a += *q;
+        ck_b += ck_a;
+    }
+    *p++ = ck_a;
+    *p++ = ck_b;
+    return p;
+}
+
+// Length of the well-formed frame at p, 0 if there is none
+static uint32_t frame_len(const uint8_t *p, uint32_t avail) {
+    if (avail < UBX_HEADER_SIZE + 2 || p[0] != UBX_SYNC1 || p[1] != UBX_SYNC2) {
+        return 0;
+    }
+    uint32_t len = UBX_HEADER_SIZE + (p[4] | (p[5] << 8)) + 2;
+    if (len > avail) {
+        return 0;
+    }
+    uint8_t ck_a = 0, ck_b = 0;
+    for (uint32_t i = 2; i < len - 2; i++) {
+        ck_a += p[i];
+        ck_b += ck_a;
+    }
+    return ck_a == p[len - 2] && ck_b == p[len - 1] ? len : 0;
+}
+
+// Keeps MGA frames other than INI in place, resyncing past damage
+static uint32_t filter_frames(uint8_t *data, uint32_t len, uint16_t *frames, uint16_t *dropped) {
+    uint32_t in = 0, out = 0;
+    *frames = *dropped = 0;
+    while (in < len) {
+        uint32_t n = frame_len(data + in, len - in);
+        if (!n) {
+            const uint8_t *next = (const uint8_t *)memchr(data + in + 1, UBX_SYNC1, len - in - 1);
+            in = next ? next - data : len;
+            (*dropped)++;
+            continue;
+        }
+        if (data[in + 2] == UBX_CLASS_MGA && data[in + 3] != UBX_MGA_INI) {
+            memmove(data + out, data + in, n);
+            out += n;
+            (*frames)++;
+        } else {
+            (*dropped)++;
+        }
+        in += n;
+    }
+    return out;
+}
+
+// ===== Cache =====
+
+static void cache_install(const GpsAssistHeader *head, uint8_t *data) {
+    xSemaphoreTake(assist_lock, portMAX_DELAY);
+    uint8_t *old = assist_data;
+    assist_head = *head;
+    assist_data = data;
+    assist_gen++;
+    xSemaphoreGive(assist_lock);
+    free(old);
+
+    portENTER_CRITICAL(&assist_mux);
+    assist_stats.fetched = head->fetched;
+    assist_stats.cached_bytes = head->length;
+    assist_stats.cached_frames = head->frames;
+    portEXIT_CRITICAL(&assist_mux);
+}
+
+static bool cache_load() {
+    if (!LittleFS.begin(false)) {
+        return false;
+    }
+    File f = LittleFS.open(GPS_ASSIST_FILE, FILE_READ);
+    if (!f) {
+        return false;
+    }
+    GpsAssistHeader head;
+    uint8_t *data = nullptr;
+    bool ok = f.read((uint8_t *)&head, sizeof(head)) == sizeof(head) && head.magic == GPS_ASSIST_MAGIC &&
+              head.length && head.length <= GPS_ASSIST_DATA_MAX;
+    if (ok) {
+        data = (uint8_t *)heap_caps_malloc(head.length, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        ok = data && f.read(data, head.length) == head.length && esp_rom_crc32_le(0, data, head.length) == head.crc;
+    }
+    f.close();
+    if (!ok) {
+        free(data);
+        LOG_WARN("AGNSS", "Cached assistance data is damaged");
+        return false;
+    }
+    cache_install(&head, data);
+    return true;
+}
+
+static bool cache_save(const GpsAssistHeader *head, const uint8_t *data) {
+    if (!LittleFS.begin(false)) {
+        return false;
+    }
+    if (!LittleFS.exists(GPS_ASSIST_DIR)) {
+        LittleFS.mkdir(GPS_ASSIST_DIR);
+    }
+    File f = LittleFS.open(GPS_ASSIST_TMP_FILE, FILE_WRITE);
+    if (!f) {
+        return false;
+    }
+    bool ok = f.write((const uint8_t *)head, sizeof(*head)) == sizeof(*head) &&
+              f.write(data, head->length) == head->length;
+    f.close();
+    // A cut mid-write leaves the old cache, never half of the new one
+    ok = ok && LittleFS.rename(GPS_ASSIST_TMP_FILE, GPS_ASSIST_FILE);
+    if (!ok) {
+        LittleFS.remove(GPS_ASSIST_TMP_FILE);
+    }
+    return ok;
+}
+
+// ===== Fetch =====
+
+static int fetch(uint8_t *buf, uint32_t *len, uint32_t *server_time, int64_t *server_mono) {
+    static WiFiClient tcp;
+    static TlsClient tls;
+    WiFiClient *client = &tcp;
+    if (!strncmp(assist_url.c_str(), "https://", 8)) {
+#ifdef INTEGRATION_LAYER_ENABLED
+        String ca = GET_CONFIG_STRING("agnss", "ca", String(""));
+        if (!ca.length() || !tls.setCACertFile(ca.c_str())) {
+            tls.setInsecure();
+        }
+#else
+        tls.setInsecure();
+#endif
+        client = &tls;
+    }
+    HTTPClient http;
+    // HTTP/1.0: no chunked body, and the server closes when it is done
+    http.useHTTP10(true);
+    http.setTimeout(GPS_ASSIST_HTTP_TIMEOUT_MS);
+    http.setConnectTimeout(GPS_ASSIST_HTTP_TIMEOUT_MS);
+    static const char *keep[] = {"Date"};
+    http.collectHeaders(keep, 1);
+    if (!http.begin(*client, assist_url)) {
+        return HTTPC_ERROR_CONNECTION_REFUSED;
+    }
+    int code = http.GET();
+    *server_mono = esp_timer_get_time();
+    *server_time = parse_http_date(http.header("Date").c_str());
+    if (code != HTTP_CODE_OK) {
+        http.end();
+        return code;
+    }
+
+    int size = http.getSize();
+    WiFiClient *stream = http.getStreamPtr();
+    uint32_t got = 0;
+    uint32_t last = millis();
+    while (http.connected() && (size < 0 || got < (uint32_t)size)) {
+        size_t avail = stream->available();
+        if (!avail) {
+            if (millis() - last > GPS_ASSIST_HTTP_TIMEOUT_MS) {
+                code = HTTPC_ERROR_READ_TIMEOUT;
+                break;
+            }
+            delay(10);
+            continue;
+        }
+        if (got >= GPS_ASSIST_DATA_MAX) {
+            code = HTTPC_ERROR_TOO_LESS_RAM;
+            break;
+        }
+        int n = stream->readBytes(buf + got, min(avail, (size_t)(GPS_ASSIST_DATA_MAX - got)));
+        got += n > 0 ? n : 0;
+        last = millis();
+    }
+    if (code == HTTP_CODE_OK && size >= 0 && got < (uint32_t)size) {
+        code = HTTPC_ERROR_CONNECTION_LOST;
+    }
+    http.end();
+    *len = got;
+    return code;
+}
+
+static bool fetch_run() {
+    uint8_t *buf = (uint8_t *)heap_caps_malloc(GPS_ASSIST_DATA_MAX, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!buf) {
+        return false;
+    }
+    uint32_t len = 0, server = 0;
+    int64_t server_mono = 0;
+    int code = fetch(buf, &len, &server, &server_mono);
+    if (server) {
+        // Whole seconds: the middle of the second is the best guess
+        time_feed(TIME_SRC_HTTP, server * 1000000LL + 500000, server_mono, TIME_HTTP_ACC_US);
+    }
+
+    GpsAssistHeader head = {};
+    uint16_t dropped = 0;
+    if (code == HTTP_CODE_OK) {
+        head.length = filter_frames(buf, len, &head.frames, &dropped);
+    }
+    portENTER_CRITICAL(&assist_mux);
+    assist_stats.last_http = code;
+    assist_stats.dropped_frames = dropped;
+    portEXIT_CRITICAL(&assist_mux);
+    uint32_t now = clock_now();
+    if (code != HTTP_CODE_OK || !head.frames || !now) {
+        LOG_WARNF("AGNSS", "Fetch failed: HTTP %d, %u frames%s", code, head.frames, now ? "" : ", no clock");
+        free(buf);
+        return false;
+    }
+
+    head.magic = GPS_ASSIST_MAGIC;
+    head.fetched = now;
+    head.crc = esp_rom_crc32_le(0, buf, head.length);
+    gps_fix_t fix;
+    gps_get_fix(&fix);
+    if (fix.valid) {
+        head.has_pos = 1;
+        head.lat = (int32_t)lround(fix.lat * 1e7);
+        head.lng = (int32_t)lround(fix.lng * 1e7);
+    } else if (assist_data && assist_head.has_pos) {
+        head.has_pos = 1;
+        head.lat = assist_head.lat;
+        head.lng = assist_head.lng;
+    }
+    if (!cache_save(&head, buf)) {
+        LOG_WARN("AGNSS", "Cannot write the cache, keeping the data in RAM only");
+    }
+    uint8_t *data = (uint8_t *)heap_caps_realloc(buf, head.length, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    cache_install(&head, data ? data : buf);
+    LOG_INFOF("AGNSS", "%u frames, %lu bytes, %u dropped", head.frames, (unsigned long)head.length, dropped);
+
+    // A receiver searching right now gets them at once
+    if (gps_power_state() == GPS_PWR_ACQUIRE) {
+        gps_request_assist();
+    }
+    return true;
+}
+
+static void fetch_task(void *arg) {
+    bool ok = fetch_run();
+    portENTER_CRITICAL(&assist_mux);
+    assist_stats.fetches++;
+    if (!ok) {
+        assist_stats.fetch_failures++;
+    }
+    portEXIT_CRITICAL(&assist_mux);
+    assist_failed = !ok;
+    assist_failed_at = millis();
+    assist_fetching = false;
+    vTaskDelete(NULL);
+}
+
+static bool fetch_start(bool force) {
+    int route = net_manager_route();
+    if (!assist_url.length() || !(route == NET_BEARER_WIFI || (route == NET_BEARER_CELL && assist_cell))) {
+        return false;
+    }
+    if (!force) {
+        uint32_t now = clock_now();
+        bool fresh = assist_data && now && now >= assist_head.fetched && now - assist_head.fetched < assist_refresh_s;
+        if (fresh || (assist_failed && millis() - assist_failed_at < GPS_ASSIST_RETRY_MS)) {
+            return false;
+        }
+    }
+    portENTER_CRITICAL(&assist_mux);
+    bool busy = assist_fetching;
+    assist_fetching = true;
+    portEXIT_CRITICAL(&assist_mux);
+    if (busy) {
+        return false;
+    }
+    if (xTaskCreate(fetch_task, "agnss", GPS_ASSIST_TASK_STACK, NULL, GPS_ASSIST_TASK_PRIORITY, NULL) != pdPASS) {
+        LOG_ERROR("AGNSS", "Failed to start the fetch task");
+        assist_fetching = false;
+        return false;
+    }
+    return true;
+}
+
+static void check_due(void *ctx) {
+    fetch_start(false);
+}
+
+static void route_changed(int from, int to, void *ctx) {
+    if (to == NET_BEARER_WIFI || to == NET_BEARER_CELL) {
+        fetch_start(false);
+    }
+}
+
+// ===== Injection =====
+
+static bool send_time(gps_assist_write_fn write) {
+    uint32_t acc = time_accuracy_us();
+    if (!time_valid() || acc > GPS_ASSIST_TIME_ACC_MAX_S * 1000000UL) {
+        return false;
+    }
+    int64_t now = time_now_us();
+    struct tm tm;
+    time_t t = (time_t)(now / 1000000);
+    gmtime_r(&t, &tm);
+
+    uint8_t msg[24] = {0};
+    uint16_t year = tm.tm_year + 1900;
+    uint32_t ns = (uint32_t)(now % 1000000) * 1000;
+    uint16_t acc_s = acc / 1000000;
+    uint32_t acc_ns = acc % 1000000 * 1000;
+    msg[0] = UBX_MGA_INI_TIME_UTC;
+    msg[3] = 0x80;                  // Leap seconds unknown
+    memcpy(msg + 4, &year, 2);
+    msg[6] = tm.tm_mon + 1;
+    msg[7] = tm.tm_mday;
+    msg[8] = tm.tm_hour;
+    msg[9] = tm.tm_min;
+    msg[10] = tm.tm_sec;
+    memcpy(msg + 12, &ns, 4);
+    memcpy(msg + 16, &acc_s, 2);
+    memcpy(msg + 20, &acc_ns, 4);
+    uint8_t frame[UBX_HEADER_SIZE + sizeof(msg) + 2];
+    write(frame, ubx_frame(frame, UBX_CLASS_MGA, UBX_MGA_INI, msg, sizeof(msg)) - frame);
+    return true;
+}
+
+static bool send_position(const gps_fix_t *last, uint32_t now, gps_assist_write_fn write) {
+    int32_t lat, lng, alt_cm = 0;
+    uint64_t acc_m;
+    if (last->valid) {
+        lat = (int32_t)lround(last->lat * 1e7);
+        lng = (int32_t)lround(last->lng * 1e7);
+        alt_cm = (int32_t)lround(last->altitude * 100);
+        acc_m = (last->h_acc > 0 ? (uint32_t)last->h_acc : GPS_ASSIST_POS_ACC_DEFAULT_M) +
+                (uint64_t)(now - last->time_ms) / 1000 * GPS_ASSIST_POS_DRIFT_MPS;
+    } else {
+        uint32_t clock = clock_now();
+        if (!assist_data || !assist_head.has_pos || !clock || clock < assist_head.fetched) {
+            return false;
+        }
+        lat = assist_head.lat;
+        lng = assist_head.lng;
+        acc_m = GPS_ASSIST_POS_ACC_DEFAULT_M + (uint64_t)(clock - assist_head.fetched) * GPS_ASSIST_POS_DRIFT_MPS;
+    }
+    if (acc_m > GPS_ASSIST_POS_ACC_MAX_M) {
+        return false;
+    }
+    uint8_t msg[20] = {0};
+    uint32_t acc_cm = (uint32_t)acc_m * 100;
+    msg[0] = UBX_MGA_INI_POS_LLH;
+    memcpy(msg + 4, &lat, 4);
+    memcpy(msg + 8, &lng, 4);
+    memcpy(msg + 12, &alt_cm, 4);
+    memcpy(msg + 16, &acc_cm, 4);
+    uint8_t frame[UBX_HEADER_SIZE + sizeof(msg) + 2];
+    write(frame, ubx_frame(frame, UBX_CLASS_MGA, UBX_MGA_INI, msg, sizeof(msg)) - frame);
+    return true;
+}
+
+bool gps_assist_start(const gps_fix_t *last, uint32_t now, gps_assist_write_fn write) {
+    if (!assist_lock) {
+        return false;
+    }
+    xSemaphoreTake(assist_lock, portMAX_DELAY);
+    // Time first: the receiver needs it to place the position and the orbits
+    bool timed = send_time(write);
+    bool placed = send_position(last, now, write);
+    uint32_t clock = clock_now();
+    bool frames = assist_data && clock && clock >= assist_head.fetched && clock - assist_head.fetched < assist_max_age_s;
+    inject_gen = assist_gen;
+    inject_pos = 0;
+    xSemaphoreGive(assist_lock);
+
+    if (timed || placed || frames) {
+        LOG_INFOF("AGNSS", "Assisting the receiver:%s%s%s", timed ? " time" : "", placed ? " position" : "",
+                  frames ? " ephemeris" : "");
+        portENTER_CRITICAL(&assist_mux);
+        assist_stats.injections++;
+        portEXIT_CRITICAL(&assist_mux);
+    }
+    return frames;
+}
+
+bool gps_assist_step(gps_assist_write_fn write) {
+    xSemaphoreTake(assist_lock, portMAX_DELAY);
+    if (inject_gen != assist_gen || !assist_data) {
+        // Replaced mid-way; the fetch asks for a fresh start if it matters
+        xSemaphoreGive(assist_lock);
+        return false;
+    }
+    // Whole frames only, so a pause never splits one
+    uint32_t end = inject_pos;
+    while (end < assist_head.length) {
+        uint32_t n = UBX_HEADER_SIZE + (assist_data[end + 4] | (assist_data[end + 5] << 8)) + 2;
+        if (end > inject_pos && end + n - inject_pos > GPS_ASSIST_CHUNK) {
+            break;
+        }
+        end += n;
+    }
+    end = min(end, assist_head.length);
+    write(assist_data + inject_pos, end - inject_pos);
+    uint32_t sent = end - inject_pos;
+    inject_pos = end;
+    bool more = inject_pos < assist_head.length;
+    xSemaphoreGive(assist_lock);
+
+    portENTER_CRITICAL(&assist_mux);
+    assist_stats.injected_bytes += sent;
+    portEXIT_CRITICAL(&assist_mux);
+    return more;
+}
+
+// ===== API =====
+
+bool gps_assist_begin() {
+    if (assist_lock) {
+        return true;
+    }
+    assist_lock = xSemaphoreCreateMutex();
+    if (!assist_lock) {
+        return false;
+    }
+#ifdef INTEGRATION_LAYER_ENABLED
+    assist_url = GET_CONFIG_STRING("agnss", "url", String(""));
+    assist_cell = GET_CONFIG_BOOL("agnss", "cell", true);
+    assist_refresh_s = GET_CONFIG_INT("agnss", "refresh_min", GPS_ASSIST_REFRESH_MIN) * 60;
+    assist_max_age_s = GET_CONFIG_INT("agnss", "max_age_min", GPS_ASSIST_MAX_AGE_MIN) * 60;
+#endif
+
+    // A receiver that started before the cache was in gets it now
+    if (cache_load() && gps_power_state() == GPS_PWR_ACQUIRE) {
+        gps_request_assist();
+    }
+    if (!assist_url.length()) {
+        LOG_INFO("AGNSS", "No agnss.url, using the cache only");
+        return true;
+    }
+    net_manager_on_route(route_changed);
+    // The check only needs to happen some time in the period: it rides another wake
+    radio_sched_add("agnss", GPS_ASSIST_CHECK_MS, GPS_ASSIST_CHECK_MS / 3, check_due);
+    fetch_start(false);
+    return true;
+}
+
+bool gps_assist_refresh() {
+    return assist_lock && fetch_start(true);
+}
+
+void gps_assist_get_stats(GpsAssistStats *stats) {
+    portENTER_CRITICAL(&assist_mux);
+    *stats = assist_stats;
+    portEXIT_CRITICAL(&assist_mux);
+}
@@ -0,0 +1,120 @@
+/**
+ * @file      gps_assist.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Assisted GNSS: AssistNow data fetched over WiFi or 4G, cached
+ *            on LittleFS and injected into the receiver on a cold start
+ */
+
+#ifndef GPS_ASSIST_H
+#define GPS_ASSIST_H
+
+#include <Arduino.h>
+#include "peripheral.h"
+
+/**
+ * A cold start has to download ephemeris from the sky at 50 bit/s, which
+ * takes 30 s at best and minutes under trees; the receiver burns full
+ * acquisition power all that time. Handed ephemeris, the time and a rough
+ * position up front, it fixes in a few seconds.
+ *
+ * Data: the UBX-MGA frames an AssistNow Online URL returns, fetched by a
+ * short-lived task whenever the route has IP (WiFi, or 4G when agnss.cell
+ * allows) and the cache is older than agnss.refresh_min. Frames are
+ * checked and kept in GPS_ASSIST_FILE with the fetch time and where the
+ * device was, and in PSRAM for the GPS task. The server's own
+ * MGA-INI-TIME is dropped: it is stale by the time it is replayed.
+ *
+ * Clock: the HTTP Date header of each fetch goes to the time service as
+ * a source of last resort; the time and accuracy sent to the receiver are
+ * the service's, whichever source it has.
+ *
+ * Injection, from the GPS task when the receiver starts without usable
+ * ephemeris (main power cut, or more than GPS_ASSIST_STALE_MS in backup):
+ * MGA-INI-TIME_UTC from the clock, MGA-INI-POS_LLH from the last fix or
+ * the fetch position with its accuracy grown by how long ago it was,
+ * then the cached frames GPS_ASSIST_CHUNK bytes every GPS_ASSIST_PACE_MS,
+ * so the receiver's input buffer keeps up without flow control. Data
+ * past agnss.max_age_min, or of unknown age, is not sent.
+ *
+ * Config section "agnss": url (AssistNow Online request with token; off
+ * when empty), ca (PEM bundle on LittleFS for https), cell (fetch over 4G
+ * too), refresh_min, max_age_min.
+ */
+
+#define GPS_ASSIST_DIR              "/gps"
+#define GPS_ASSIST_FILE             "/gps/agnss.ubx"
+#define GPS_ASSIST_TMP_FILE         "/gps/agnss.tmp"
+#define GPS_ASSIST_MAGIC            0x53534741  // "AGSS"
+#define GPS_ASSIST_DATA_MAX         (16 * 1024) // AssistNow Online for GPS+Galileo is 5-8 KB
+#define GPS_ASSIST_REFRESH_MIN      120
+#define GPS_ASSIST_MAX_AGE_MIN      240         // Broadcast ephemeris is good for about 4 h
+#define GPS_ASSIST_CHECK_MS         (15 * 60 * 1000)
+#define GPS_ASSIST_RETRY_MS         (5 * 60 * 1000)     // After a failed fetch
+#define GPS_ASSIST_STALE_MS         (2 * 3600 * 1000UL) // Backup this long counts as a cold start
+#define GPS_ASSIST_CHUNK            512
+#define GPS_ASSIST_PACE_MS          200
+#define GPS_ASSIST_HTTP_TIMEOUT_MS  15000
+#define GPS_ASSIST_TASK_STACK       (1024 * 8)
+#define GPS_ASSIST_TASK_PRIORITY    (tskIDLE_PRIORITY + 1)
+#define GPS_ASSIST_TIME_ACC_MAX_S   600         // Not worth sending beyond this
+#define GPS_ASSIST_POS_ACC_DEFAULT_M 100        // A fix that does not report its accuracy
+#define GPS_ASSIST_POS_DRIFT_MPS    30          // How fast an old position goes stale
+#define GPS_ASSIST_POS_ACC_MAX_M    300000      // The receiver ignores worse
+
+// GPS_ASSIST_FILE: this, then the frames
+struct GpsAssistHeader {
+    uint32_t magic;
+    uint32_t fetched;               // Unix time
+    uint32_t length;
+    uint32_t crc;                   // Of the frames
+    uint16_t frames;
+    uint8_t has_pos;
+    uint8_t reserved;
+    int32_t lat;                    // 1e-7 deg, where the device was when fetched
+    int32_t lng;
+};
+
+struct GpsAssistStats {
+    uint32_t fetches;
+    uint32_t fetch_failures;
+    uint32_t fetched;               // Unix time of the cached data, 0 for none
+    uint32_t cached_bytes;
+    uint16_t cached_frames;
+    uint16_t dropped_frames;        // Bad checksum or not MGA, last fetch
+    uint32_t injections;
+    uint32_t injected_bytes;
+    int last_http;                  // Status or HTTPClient error of the last fetch
+};
+
+typedef void (*gps_assist_write_fn)(const uint8_t *data, size_t len);
+
+/**
+ * @brief Load the cache and start refreshing it; off without agnss.url,
+ *        though a cache already on flash is still used
+ */
+bool gps_assist_begin();
+
+/**
+ * @brief Fetch now if a route with IP is up, whatever the cache's age
+ */
+bool gps_assist_refresh();
+
+/**
+ * @brief GPS task: send time and position, and line up the cached frames
+ * @param last the last fix, its time_ms against now
+ * @return true while gps_assist_step() has frames to send
+ */
+bool gps_assist_start(const gps_fix_t *last, uint32_t now, gps_assist_write_fn write);
+
+/**
+ * @brief GPS task: the next GPS_ASSIST_CHUNK of frames
+ * @return true while more remain
+ */
+bool gps_assist_step(gps_assist_write_fn write);
+
+void gps_assist_get_stats(GpsAssistStats *stats);
+
+#endif // GPS_ASSIST_H
@@ -0,0 +1,387 @@
+/**
+ * @file      gps_track.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     GPS track logger: adaptive sampling, delta/varint coding and
+ *            sector-sized block writes with a time index
+ */
+
+#include "gps_track.h"
+#include "simple_logger.h"
+#include <SD.h>
+#include "spi_bus.h"
+#include "fs_service.h"
+#include "sd_manager.h"
+#include "coro_sched.h"
+#include <esp_rom_crc.h>
+#include <math.h>
+
+static_assert(sizeof(GpsTrackBlockHeader) == 32, "Block header is part of the file format");
+static_assert(sizeof(GpsTrackIndexEntry) == 16, "Index entry is part of the file format");
+
+#define TRACK_POINT_MAX     20      // Four varints of up to 5 bytes
+#define TRACK_SIG_FIX       0x01
+#define TRACK_SIG_STOP      0x02
+
+static bool track_running = false;
+static volatile bool track_stop_req = false;
+static Coro track_coro;
+static bool track_sd_client = false;    // Registered with sd_manager
+static GpsTrackStats track_stats;
+
+// Open block and sampling state, track coroutine only
+static uint8_t track_block[GPS_TRACK_BLOCK_SIZE];
+static GpsTrackBlockHeader *const track_head = (GpsTrackBlockHeader *)track_block;
+static bool track_indexed = false;   // Open block has its index entry
+static bool track_dirty = false;
+static bool track_have_last = false;
+static GpsTrackPoint track_last;
+static float track_last_heading = 0;
+static uint32_t track_fix_version = 0;
+static uint32_t track_flush_time = 0;
+
+static inline uint32_t zigzag(int32_t v) {
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static inline int32_t unzigzag(uint32_t v) {
+    return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+static uint8_t *put_varint(uint8_t *p, uint32_t v) {
+    while (v >= 0x80) {
+        *p++ = (uint8_t)v | 0x80;
+        v >>= 7;
+    }
+    *p++ = (uint8_t)v;
+    return p;
+}
+
+static const uint8_t *get_varint(const uint8_t *p, const uint8_t *end, uint32_t *v) {
+    uint32_t result = 0;
+    for (int shift = 0; shift < 35 && p < end; shift += 7) {
+        uint8_t b = *p++;
+        result |= (uint32_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) {
+            *v = result;
+            return p;
+        }
+    }
+    return nullptr;
+}
+
+// Civil date to days since 1970-01-01 (Howard Hinnant's algorithm)
+static uint32_t epoch_seconds(const gps_fix_t *fix) {
+    int y = fix->year - (fix->month <= 2);
+    int era = y / 400;
+    int yoe = y - era * 400;
+    int doy = (153 * (fix->month + (fix->month > 2 ? -3 : 9)) + 2) / 5 + fix->day - 1;
+    int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    uint32_t days = era * 146097 + doe - 719468;
+    return days * 86400UL + fix->hour * 3600UL + fix->minute * 60UL + fix->second;
+}
+
+static uint32_t block_crc() {
+    uint32_t saved = track_head->crc;
+    track_head->crc = 0;
+    uint32_t crc = esp_rom_crc32_le(0, track_block, GPS_TRACK_BLOCK_SIZE);
+    track_head->crc = saved;
+    return crc;
+}
+
+// The open block goes to its own slot, so repeated flushes of it overwrite in place
+static void write_block() {
+    SpiBusHold bus(SPI_CLIENT_SD);
+    track_head->crc = block_crc();
+    
+    File f = SD.open(GPS_TRACK_FILE, "r+");
+    if (!f || !f.seek(track_head->block * GPS_TRACK_BLOCK_SIZE) ||
+        f.write(track_block, GPS_TRACK_BLOCK_SIZE) != GPS_TRACK_BLOCK_SIZE) {
+        track_stats.write_errors++;
+        if (f) {
+            f.close();
+        }
+        return;
+    }
+    f.close();
+    fs_invalidate_usage();
+    track_stats.bytes_written += GPS_TRACK_BLOCK_SIZE;
+    track_dirty = false;
+    track_flush_time = millis();
+    
+    if (!track_indexed) {
+        GpsTrackIndexEntry entry = {track_head->block, track_head->time, track_head->lat, track_head->lng};
+        File idx = SD.open(GPS_TRACK_INDEX_FILE, FILE_APPEND);
+        if (idx && idx.write((const uint8_t *)&entry, sizeof(entry)) == sizeof(entry)) {
+            track_indexed = true;
+            track_stats.bytes_written += sizeof(entry);
+        } else {
+            track_stats.write_errors++;
+        }
+        if (idx) {
+            idx.close();
+        }
+    }
+}
+
+static void open_block(uint32_t block, const GpsTrackPoint *pt) {
+    memset(track_block, 0, sizeof(track_block));
+    track_head->magic = GPS_TRACK_MAGIC;
+    track_head->block = block;
+    track_head->time = pt->time;
+    track_head->lat = pt->lat;
+    track_head->lng = pt->lng;
+    track_head->alt_dm = pt->alt_dm;
+    track_head->count = 1;
+    track_indexed = false;
+    track_stats.blocks = block + 1;
+}
+
+static void append(const GpsTrackPoint *pt) {
+    if (track_head->count == 0) {
+        open_block(track_head->block, pt);
+    } else {
+        uint8_t coded[TRACK_POINT_MAX];
+        uint8_t *p = coded;
+        p = put_varint(p, pt->time - track_last.time);
+        p = put_varint(p, zigzag(pt->lat - track_last.lat));
+        p = put_varint(p, zigzag(pt->lng - track_last.lng));
+        p = put_varint(p, zigzag(pt->alt_dm - track_last.alt_dm));
+        size_t len = p - coded;
+    
+        if (track_head->used + len > GPS_TRACK_PAYLOAD_SIZE) {
+            write_block();
+            open_block(track_head->block + 1, pt);
+        } else {
+            memcpy(track_block + sizeof(GpsTrackBlockHeader) + track_head->used, coded, len);
+            track_head->used += len;
+            track_head->count++;
+        }
+    }
+    track_last = *pt;
+    track_dirty = true;
+    track_stats.points++;
+}
+
+static bool wanted(const gps_fix_t *fix, uint32_t t) {
+    if (!track_have_last) {
+        return true;
+    }
+    
+    double lat = track_last.lat * 1e-7;
+    double lng = track_last.lng * 1e-7;
+    double moved = gps_distance_m(lat, lng, fix->lat, fix->lng);
+    if (moved >= GPS_TRACK_MIN_DISTANCE_M) {
+        return true;
+    }
+    if (fix->speed >= GPS_TRACK_MIN_SPEED_KMH && moved >= GPS_TRACK_MIN_TURN_M) {
+        float turn = fabsf(fix->heading - track_last_heading);
+        if (turn > 180) {
+            turn = 360 - turn;
+        }
+        if (turn >= GPS_TRACK_MIN_HEADING_DEG) {
+            return true;
+        }
+    }
+    return t - track_last.time >= GPS_TRACK_KEEPALIVE_S;
+}
+
+static void track_on_fix() {
+    coro_signal(&track_coro, TRACK_SIG_FIX);
+}
+
+static void track_sample() {
+    gps_fix_t fix;
+    uint32_t version = gps_get_fix(&fix);
+    // Points are keyed by UTC, so a fix without a date waits
+    if (version == track_fix_version || !fix.valid || fix.year < 2020) {
+        return;
+    }
+    track_fix_version = version;
+    uint32_t t = epoch_seconds(&fix);
+    if (wanted(&fix, t)) {
+        GpsTrackPoint pt;
+        pt.time = t;
+        pt.lat = (int32_t)lround(fix.lat * 1e7);
+        pt.lng = (int32_t)lround(fix.lng * 1e7);
+        pt.alt_dm = (int32_t)lround(fix.altitude * 10);
+        append(&pt);
+        track_have_last = true;
+        track_last_heading = fix.heading;
+    }
+}
+
+// Until the open block's flush falls due
+static uint32_t track_flush_wait() {
+    if (!track_dirty) {
+        return CORO_FOREVER;
+    }
+    uint32_t since = millis() - track_flush_time;
+    return since >= GPS_TRACK_FLUSH_S * 1000UL ? 0 : GPS_TRACK_FLUSH_S * 1000UL - since;
+}
+
+static CoroStatus track_coro_fn(Coro *co) {
+    CORO_BEGIN(co);
+    while (!track_stop_req) {
+        CORO_AWAIT(co, TRACK_SIG_FIX | TRACK_SIG_STOP, track_flush_wait());
+        if (co->fired & TRACK_SIG_FIX) {
+            track_sample();
+        }
+        if (track_dirty && millis() - track_flush_time >= GPS_TRACK_FLUSH_S * 1000UL) {
+            write_block();
+        }
+    }
+
+    gps_set_fix_notify(NULL);
+    if (track_dirty) {
+        write_block();
+    }
+    gps_power_request(GPS_CONSUMER_TRACK, 0);
+    track_running = false;
+    CORO_END(co);
+}
+
+// Eject: the open block goes out before the card is unmounted. After a
+// removal the write fails and is counted, and logging stops either way
+static void track_detach() {
+    if (!coro_running(&track_coro)) {
+        return;
+    }
+    gps_track_stop();
+    for (int i = 0; i < 100 && coro_running(&track_coro); i++) {
+        vTaskDelay(pdMS_TO_TICKS(20));
+    }
+}
+
+bool gps_track_begin() {
+    if (coro_running(&track_coro)) {
+        return !track_stop_req;     // Still writing out the last block
+    }
+    SpiBusHold bus(SPI_CLIENT_SD);
+    if (SD.cardType() == CARD_NONE || !(SD.exists(GPS_TRACK_DIR) || SD.mkdir(GPS_TRACK_DIR))) {
+        LOG_WARN("GPSTrack", "No SD card, track not recorded");
+        return false;
+    }
+    
+    // "r+" needs the file to exist
+    if (!SD.exists(GPS_TRACK_FILE)) {
+        File f = SD.open(GPS_TRACK_FILE, FILE_WRITE);
+        if (!f) {
+            LOG_ERROR("GPSTrack", "Failed to create the track file");
+            return false;
+        }
+        f.close();
+    }
+    File f = SD.open(GPS_TRACK_FILE, FILE_READ);
+    uint32_t blocks = f ? (f.size() + GPS_TRACK_BLOCK_SIZE - 1) / GPS_TRACK_BLOCK_SIZE : 0;
+    if (f) {
+        f.close();
+    }
+    
+    memset(track_block, 0, sizeof(track_block));
+    track_head->block = blocks;
+    track_stats.blocks = blocks;
+    track_dirty = false;
+    track_have_last = false;
+    track_flush_time = millis();
+    track_stop_req = false;
+    
+    if (!track_sd_client) {
+        track_sd_client = sd_manager_add_client("GPSTrack", NULL, track_detach);
+    }
+    if (!coro_spawn(&track_coro, "gps_track", track_coro_fn)) {
+        LOG_ERROR("GPSTrack", "Failed to start the track coroutine");
+        return false;
+    }
+    gps_set_fix_notify(track_on_fix);
+    track_running = true;
+    gps_power_request(GPS_CONSUMER_TRACK, GPS_TRACK_FIX_INTERVAL_MS);
+    LOG_INFOF("GPSTrack", "Recording from block %lu", (unsigned long)blocks);
+    return true;
+}
+
+void gps_track_stop() {
+    track_stop_req = true;
+    coro_signal(&track_coro, TRACK_SIG_STOP);
+}
+
+bool gps_track_running() {
+    return track_running;
+}
+
+const GpsTrackStats *gps_track_stats() {
+    return &track_stats;
+}
+
+int32_t gps_track_find(uint32_t t) {
+    SpiBusHold bus(SPI_CLIENT_SD);
+    File idx = SD.open(GPS_TRACK_INDEX_FILE, FILE_READ);
+    if (!idx) {
+        return -1;
+    }
+    
+    // Last entry starting at or before t
+    GpsTrackIndexEntry entry;
+    int32_t lo = 0;
+    int32_t hi = idx.size() / sizeof(entry) - 1;
+    int32_t found = -1;
+    while (lo <= hi) {
+        int32_t mid = (lo + hi) / 2;
+        idx.seek(mid * sizeof(entry));
+        if (idx.read((uint8_t *)&entry, sizeof(entry)) != sizeof(entry)) {
+            break;
+        }
+        if (entry.time <= t) {
+            found = entry.block;
+            lo = mid + 1;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    idx.close();
+    return found;
+}
+
+size_t gps_track_read_block(uint32_t block, GpsTrackPoint *out, size_t max) {
+    uint8_t buf[GPS_TRACK_BLOCK_SIZE];
+    bool ok;
+    {
+        SpiBusHold bus(SPI_CLIENT_SD);
+        File f = SD.open(GPS_TRACK_FILE, FILE_READ);
+        if (!f) {
+            return 0;
+        }
+        ok = f.seek(block * GPS_TRACK_BLOCK_SIZE) && f.read(buf, sizeof(buf)) == sizeof(buf);
+        f.close();
+    }
+    
+    GpsTrackBlockHeader head;
+    memcpy(&head, buf, sizeof(head));
+    if (!ok || head.magic != GPS_TRACK_MAGIC || head.block != block || head.used > GPS_TRACK_PAYLOAD_SIZE) {
+        return 0;
+    }
+    memset(buf + offsetof(GpsTrackBlockHeader, crc), 0, sizeof(head.crc));
+    if (esp_rom_crc32_le(0, buf, sizeof(buf)) != head.crc) {
+        return 0;
+    }
+    
+    GpsTrackPoint pt = {head.time, head.lat, head.lng, head.alt_dm};
+    const uint8_t *p = buf + sizeof(head);
+    const uint8_t *end = p + head.used;
+    size_t n = 0;
+    while (n < max && n < head.count) {
+        out[n++] = pt;
+        uint32_t dt, dlat, dlng, dalt;
+        if (p == end || !(p = get_varint(p, end, &dt)) || !(p = get_varint(p, end, &dlat)) ||
+            !(p = get_varint(p, end, &dlng)) || !(p = get_varint(p, end, &dalt))) {
+            break;
+        }
+        pt.time += dt;
+        pt.lat += unzigzag(dlat);
+        pt.lng += unzigzag(dlng);
+        pt.alt_dm += unzigzag(dalt);
+    }
+    return n;
+}
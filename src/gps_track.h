@@ -0,0 +1,94 @@
+/**
+ * @file      gps_track.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Background GPS track logger: delta/varint-coded sector blocks on SD
+ */
+
+#ifndef GPS_TRACK_H
+#define GPS_TRACK_H
+
+#include <Arduino.h>
+#include "peripheral.h"
+
+// Storage, one block per SD sector so every write is a whole sector
+#define GPS_TRACK_BLOCK_SIZE        512
+#define GPS_TRACK_MAGIC             0x4B525447UL  // "GTRK"
+#define GPS_TRACK_DIR               "/gps"
+#define GPS_TRACK_FILE              "/gps/track.bin"
+#define GPS_TRACK_INDEX_FILE        "/gps/track.idx"
+
+// Adaptive sampling: a point on movement or a turn, time only as a keep-alive
+#define GPS_TRACK_MIN_DISTANCE_M    15
+#define GPS_TRACK_MIN_HEADING_DEG   25
+#define GPS_TRACK_MIN_SPEED_KMH     3     // Course over ground is noise below this
+#define GPS_TRACK_MIN_TURN_M        3     // A turn needs this much movement too
+#define GPS_TRACK_KEEPALIVE_S       900
+#define GPS_TRACK_FIX_INTERVAL_MS   30000 // Fix age asked of the GPS power manager
+
+// Coroutine, woken by each published fix
+#define GPS_TRACK_FLUSH_S           300   // Open block rewritten in place this often
+
+/**
+ * Block layout, little-endian: this header, then every point after the first
+ * as varint(dt s), zigzag varint(dlat), zigzag varint(dlng), zigzag varint(dalt).
+ * Each block starts from an absolute point, so any one decodes on its own
+ */
+struct GpsTrackBlockHeader {
+    uint32_t magic;
+    uint32_t block;                 // Position in the file
+    uint32_t time;                  // UTC seconds of the first point
+    int32_t lat, lng;               // 1e-7 deg
+    int32_t alt_dm;
+    uint16_t count;                 // Points, the first included
+    uint16_t used;                  // Coded bytes after the header
+    uint32_t crc;                   // Over the whole block with this field 0
+};
+
+#define GPS_TRACK_PAYLOAD_SIZE      (GPS_TRACK_BLOCK_SIZE - sizeof(GpsTrackBlockHeader))
+
+// One per block in the index file, in write order
+struct GpsTrackIndexEntry {
+    uint32_t block;
+    uint32_t time;
+    int32_t lat, lng;
+};
+
+struct GpsTrackPoint {
+    uint32_t time;                  // UTC seconds
+    int32_t lat, lng;               // 1e-7 deg
+    int32_t alt_dm;
+};
+
+struct GpsTrackStats {
+    uint32_t points;
+    uint32_t blocks;                // Blocks in the file, the open one included
+    uint32_t bytes_written;
+    uint32_t write_errors;
+};
+
+/**
+ * @brief Start logging on a new block after the existing ones
+ */
+bool gps_track_begin();
+
+/**
+ * @brief Write the open block and stop; the next begin() starts a fresh one
+ */
+void gps_track_stop();
+bool gps_track_running();
+const GpsTrackStats *gps_track_stats();
+
+/**
+ * @brief Block holding time t, by binary search over the index; -1 if none
+ */
+int32_t gps_track_find(uint32_t t);
+
+/**
+ * @brief Decode one block; returns the number of points, 0 if it fails its CRC
+ */
+size_t gps_track_read_block(uint32_t block, GpsTrackPoint *out, size_t max);
+
+#endif // GPS_TRACK_H
@@ -0,0 +1,404 @@
+/**
+ * @file      hw_probe.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Parallel presence probes per bus, with a cache of absent parts in NVS
+ */
+
+#include "hw_probe.h"
+#include <Preferences.h>
+#include <driver/i2c.h>
+#include <esp_timer.h>
+#include <freertos/event_groups.h>
+#include "simple_logger.h"
+#include "utilities.h"
+#include "i2c_bus.h"
+#include "spi_bus.h"
+#include "power_domain.h"
+#include "modem_at.h"
+#include "usb_console.h"
+#ifdef INTEGRATION_LAYER_ENABLED
+#include "integration/config_manager.h"
+#endif
+
+#define SX1262_GET_STATUS       0xC0
+
+typedef uint8_t (*probe_fn)(int arg);
+
+struct Probe {
+    int peri_id;
+    const char *name;
+    uint8_t bus;
+    probe_fn fn;
+    int arg;
+};
+
+// ===== Probes =====
+
+// Address acknowledge only, bounded; the bus is held like any driver's
+static uint8_t probe_i2c(int dev) {
+    if (!i2c_bus_acquire(dev, HW_PROBE_I2C_MS)) {
+        return HW_PROBE_SKIPPED;
+    }
+    static const uint8_t addrs[I2C_DEV_NUM] = {
+        BOARD_I2C_ADDR_TOUCH, BOARD_I2C_ADDR_KEYBOARD, BOARD_I2C_ADDR_GYROSCOPDE,
+        BOARD_I2C_ADDR_LTR_553ALS, BOARD_I2C_ADDR_BQ25896, BOARD_I2C_ADDR_BQ27220,
+    };
+    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
+    i2c_master_start(cmd);
+    i2c_master_write_byte(cmd, addrs[dev] << 1 | I2C_MASTER_WRITE, true);
+    i2c_master_stop(cmd);
+    bool ack = i2c_master_cmd_begin((i2c_port_t)I2C_BUS_PORT, cmd, pdMS_TO_TICKS(HW_PROBE_I2C_MS)) == ESP_OK;
+    i2c_cmd_link_delete(cmd);
+    // A missing part is not the bus's error
+    i2c_bus_release(dev, true);
+    return ack ? HW_PROBE_PRESENT : HW_PROBE_ABSENT;
+}
+
+// GetStatus: a chip answers with its mode in the status byte, an empty
+// socket reads all zeros or all ones
+static uint8_t probe_lora(int arg) {
+    int user = -1;
+    if (!power_domain_is_on(PWR_DOMAIN_LORA)) {
+        user = power_domain_user(PWR_DOMAIN_LORA, "probe");
+        power_domain_acquire(user);
+        power_domain_wait(PWR_DOMAIN_LORA);
+    }
+    uint8_t state = HW_PROBE_SKIPPED;
+    if (spi_bus_acquire(SPI_CLIENT_LORA, HW_PROBE_SPI_MS)) {
+        uint32_t start = millis();
+        pinMode(BOARD_LORA_BUSY, INPUT);
+        while (digitalRead(BOARD_LORA_BUSY) && millis() - start < HW_PROBE_SPI_MS) {
+            vTaskDelay(1);
+        }
+        if (digitalRead(BOARD_LORA_BUSY)) {
+            state = HW_PROBE_ABSENT;
+        } else {
+            SPI.beginTransaction(spi_bus_settings(SPI_CLIENT_LORA));
+            digitalWrite(BOARD_LORA_CS, LOW);
+            SPI.transfer(SX1262_GET_STATUS);
+            uint8_t status = SPI.transfer(0x00);
+            digitalWrite(BOARD_LORA_CS, HIGH);
+            SPI.endTransaction();
+            state = status != 0x00 && status != 0xFF ? HW_PROBE_PRESENT : HW_PROBE_ABSENT;
+        }
+        spi_bus_release(SPI_CLIENT_LORA);
+    }
+    if (user >= 0) {
+        power_domain_release(user);
+    }
+    return state;
+}
+
+// Any byte will do: at the wrong rate it is noise, but something is talking
+static uint8_t probe_gps(int arg) {
+    int user = power_domain_user(PWR_DOMAIN_GPS, "probe");
+    power_domain_acquire(user);
+    power_domain_wait(PWR_DOMAIN_GPS);
+    SerialGPS.begin(38400, SERIAL_8N1, BOARD_GPS_RXD, BOARD_GPS_TXD);
+    uint32_t start = millis();
+    bool heard = false;
+    while (!heard && millis() - start < HW_PROBE_GPS_MS) {
+        heard = SerialGPS.available() > 0;
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    SerialGPS.end();
+    power_domain_release(user);
+    return heard ? HW_PROBE_PRESENT : HW_PROBE_ABSENT;
+}
+
+// One AT where the driver's bring-up would retry for seconds. Only reached
+// while the driver is down, so the port is nobody else's
+static uint8_t probe_modem(int arg) {
+    if (!power_domain_is_on(PWR_DOMAIN_6609)) {
+        return HW_PROBE_SKIPPED;
+    }
+    SerialAT.begin(MODEM_AT_BAUD_DEFAULT, SERIAL_8N1, BOARD_A7682E_TXD, BOARD_A7682E_RXD);
+    while (SerialAT.available()) {
+        SerialAT.read();
+    }
+    SerialAT.print("AT\r\n");
+    char line[8];
+    size_t len = 0;
+    bool ok = false;
+    uint32_t start = millis();
+    while (!ok && millis() - start < HW_PROBE_AT_MS) {
+        if (!SerialAT.available()) {
+            vTaskDelay(pdMS_TO_TICKS(5));
+            continue;
+        }
+        char c = SerialAT.read();
+        if (c == '\n') {
+            line[len] = '\0';
+            ok = !strncmp(line, "OK", 2);
+            len = 0;
+        } else if (c != '\r' && len < sizeof(line) - 1) {
+            line[len++] = c;
+        }
+    }
+    return ok ? HW_PROBE_PRESENT : HW_PROBE_ABSENT;
+}
+
+static const Probe probes[] = {
+    { E_PERI_TOUCH,      "touch",   HW_PROBE_BUS_I2C,        probe_i2c,   I2C_DEV_TOUCH },
+    { E_PERI_KYEPAD,     "keypad",  HW_PROBE_BUS_I2C,        probe_i2c,   I2C_DEV_KEYPAD },
+    { E_PERI_BHI260AP,   "bhi260",  HW_PROBE_BUS_I2C,        probe_i2c,   I2C_DEV_BHI260 },
+    { E_PERI_LTR_553ALS, "ltr553",  HW_PROBE_BUS_I2C,        probe_i2c,   I2C_DEV_LTR553 },
+    { E_PERI_BQ25896,    "bq25896", HW_PROBE_BUS_I2C,        probe_i2c,   I2C_DEV_BQ25896 },
+    { E_PERI_BQ27220,    "bq27220", HW_PROBE_BUS_I2C,        probe_i2c,   I2C_DEV_BQ27220 },
+    { E_PERI_LORA,       "sx1262",  HW_PROBE_BUS_SPI,        probe_lora,  0 },
+    { E_PERI_GPS,        "gps",     HW_PROBE_BUS_GPS_UART,   probe_gps,   0 },
+    { E_PERI_A7682E,     "a7682e",  HW_PROBE_BUS_MODEM_UART, probe_modem, 0 },
+};
+
+#define PROBE_COUNT     (sizeof(probes) / sizeof(probes[0]))
+
+static const char *const state_names[] = { "unknown", "present", "absent", "absent (cached)", "skipped", "timeout" };
+
+static HwProbeResult results[E_PERI_NUM_MAX];
+static HwProbeStats probe_stats;
+static uint32_t run_gen = 0;            // A late task of an earlier run leaves results alone
+static bool run_full = false;
+static bool cache_loaded = false;
+static bool cache_enabled = true;
+static uint8_t recheck_runs = HW_PROBE_RECHECK_RUNS;
+static EventGroupHandle_t bus_done = NULL;
+static SemaphoreHandle_t run_lock = NULL;
+static portMUX_TYPE probe_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// ===== Cache =====
+
+static void cache_load() {
+    if (cache_loaded) {
+        return;
+    }
+#ifdef INTEGRATION_LAYER_ENABLED
+    cache_enabled = GET_CONFIG_BOOL("selftest", "cache", true);
+    recheck_runs = GET_CONFIG_INT("selftest", "recheck_runs", HW_PROBE_RECHECK_RUNS);
+#endif
+    uint32_t absent = 0;
+    uint8_t runs = 0;
+    Preferences prefs;
+    if (cache_enabled && prefs.begin(HW_PROBE_NVS_NAMESPACE, true)) {
+        // Another board or another set of probes: what was absent may not be
+        if (prefs.getString("rev", "") == HW_PROBE_BOARD_REV && prefs.getUChar("ver", 0) == HW_PROBE_VERSION) {
+            absent = prefs.getUInt("absent", 0);
+            runs = prefs.getUChar("runs", 0);
+        }
+        prefs.end();
+    }
+    portENTER_CRITICAL(&probe_mux);
+    probe_stats.absent_mask = absent;
+    probe_stats.runs_since_full = runs;
+    cache_loaded = true;
+    portEXIT_CRITICAL(&probe_mux);
+}
+
+static void cache_save(uint32_t absent, uint8_t runs) {
+    if (!cache_enabled) {
+        return;
+    }
+    Preferences prefs;
+    if (!prefs.begin(HW_PROBE_NVS_NAMESPACE, false)) {
+        LOG_WARN("Probe", "NVS not available, absent parts not cached");
+        return;
+    }
+    prefs.putString("rev", HW_PROBE_BOARD_REV);
+    prefs.putUChar("ver", HW_PROBE_VERSION);
+    prefs.putUInt("absent", absent);
+    prefs.putUChar("runs", runs);
+    prefs.end();
+}
+
+// ===== Runner =====
+
+static void bus_task(void *param) {
+    uint8_t bus = (uint8_t)(uintptr_t)param;
+    uint32_t gen = run_gen;
+    for (size_t i = 0; i < PROBE_COUNT; i++) {
+        const Probe *p = &probes[i];
+        if (p->bus != bus || results[p->peri_id].state != HW_PROBE_TIMEOUT) {
+            continue;
+        }
+        int64_t start = esp_timer_get_time();
+        uint8_t state = peri_init_ready(p->peri_id) ? HW_PROBE_PRESENT : p->fn(p->arg);
+        uint32_t us = (uint32_t)(esp_timer_get_time() - start);
+        portENTER_CRITICAL(&probe_mux);
+        if (gen == run_gen) {
+            results[p->peri_id].state = state;
+            results[p->peri_id].us = us;
+        }
+        portEXIT_CRITICAL(&probe_mux);
+    }
+    xEventGroupSetBits(bus_done, 1 << bus);
+    vTaskDelete(NULL);
+}
+
+int hw_probe_run(bool full) {
+    if (!run_lock) {
+        run_lock = xSemaphoreCreateMutex();
+        bus_done = xEventGroupCreate();
+    }
+    if (!run_lock || !bus_done || xSemaphoreTake(run_lock, pdMS_TO_TICKS(2 * HW_PROBE_DEADLINE_MS)) != pdTRUE) {
+        return -1;
+    }
+    cache_load();
+    bool recheck = full || !cache_enabled || probe_stats.runs_since_full >= recheck_runs;
+    uint32_t cached = recheck ? 0 : probe_stats.absent_mask;
+
+    // Every probe starts as timed out and its bus task overwrites that
+    uint32_t start = millis();
+    EventBits_t wanted = 0;
+    portENTER_CRITICAL(&probe_mux);
+    run_gen++;
+    run_full = recheck;
+    for (size_t i = 0; i < PROBE_COUNT; i++) {
+        const Probe *p = &probes[i];
+        bool skip = cached & (1UL << p->peri_id);
+        results[p->peri_id].bus = p->bus;
+        results[p->peri_id].state = skip ? HW_PROBE_CACHED_ABSENT : HW_PROBE_TIMEOUT;
+        results[p->peri_id].us = 0;
+        if (!skip) {
+            wanted |= 1 << p->bus;
+        }
+    }
+    portEXIT_CRITICAL(&probe_mux);
+
+    xEventGroupClearBits(bus_done, (1 << HW_PROBE_BUS_COUNT) - 1);
+    EventBits_t started = 0;
+    for (uint8_t bus = 0; bus < HW_PROBE_BUS_COUNT; bus++) {
+        if ((wanted & (1 << bus)) &&
+            xTaskCreate(bus_task, "hw_probe", HW_PROBE_TASK_STACK, (void *)(uintptr_t)bus, HW_PROBE_TASK_PRIORITY,
+                        NULL) == pdPASS) {
+            started |= 1 << bus;
+        }
+    }
+    if (started) {
+        xEventGroupWaitBits(bus_done, started, pdFALSE, pdTRUE, pdMS_TO_TICKS(HW_PROBE_DEADLINE_MS));
+    }
+
+    // Results and the cache from what finished; a timeout proves nothing
+    int present = 0;
+    uint32_t absent = cached;
+    uint32_t serial_us = 0;
+    uint32_t probed = 0;
+    portENTER_CRITICAL(&probe_mux);
+    run_gen++;
+    for (size_t i = 0; i < PROBE_COUNT; i++) {
+        const HwProbeResult *r = &results[probes[i].peri_id];
+        uint32_t bit = 1UL << probes[i].peri_id;
+        if (r->state == HW_PROBE_PRESENT) {
+            present++;
+            absent &= ~bit;
+        } else if (r->state == HW_PROBE_ABSENT) {
+            absent |= bit;
+        }
+        if (r->state != HW_PROBE_CACHED_ABSENT) {
+            serial_us += r->us;
+            probed++;
+        }
+    }
+    uint8_t runs = recheck ? 0 : probe_stats.runs_since_full + 1;
+    probe_stats.runs++;
+    probe_stats.last_ms = millis() - start;
+    probe_stats.serial_ms = serial_us / 1000;
+    probe_stats.probed = probed;
+    probe_stats.skipped = PROBE_COUNT - probed;
+    probe_stats.absent_mask = absent;
+    probe_stats.runs_since_full = runs;
+    portEXIT_CRITICAL(&probe_mux);
+
+    cache_save(absent, runs);
+    LOG_INFOF("Probe", "%d of %u parts present in %lu ms (%lu ms one after another), %lu skipped",
+              present, (unsigned)PROBE_COUNT, (unsigned long)probe_stats.last_ms,
+              (unsigned long)probe_stats.serial_ms, (unsigned long)probe_stats.skipped);
+    xSemaphoreGive(run_lock);
+    return present;
+}
+
+// ===== API =====
+
+bool hw_probe_known_absent(int peri_id) {
+    if (peri_id < 0 || peri_id >= E_PERI_NUM_MAX) {
+        return false;
+    }
+    cache_load();
+    return cache_enabled && probe_stats.runs_since_full < recheck_runs &&
+           (probe_stats.absent_mask & (1UL << peri_id));
+}
+
+void hw_probe_get(int peri_id, HwProbeResult *out) {
+    if (peri_id < 0 || peri_id >= E_PERI_NUM_MAX) {
+        *out = {};
+        return;
+    }
+    portENTER_CRITICAL(&probe_mux);
+    *out = results[peri_id];
+    portEXIT_CRITICAL(&probe_mux);
+}
+
+const char *hw_probe_name(int peri_id) {
+    for (size_t i = 0; i < PROBE_COUNT; i++) {
+        if (probes[i].peri_id == peri_id) {
+            return probes[i].name;
+        }
+    }
+    return "?";
+}
+
+const char *hw_probe_state_name(uint8_t state) {
+    return state < sizeof(state_names) / sizeof(state_names[0]) ? state_names[state] : "?";
+}
+
+void hw_probe_forget() {
+    Preferences prefs;
+    if (prefs.begin(HW_PROBE_NVS_NAMESPACE, false)) {
+        prefs.clear();
+        prefs.end();
+    }
+    portENTER_CRITICAL(&probe_mux);
+    probe_stats.absent_mask = 0;
+    probe_stats.runs_since_full = 0;
+    cache_loaded = true;
+    portEXIT_CRITICAL(&probe_mux);
+}
+
+void hw_probe_get_stats(HwProbeStats *out) {
+    portENTER_CRITICAL(&probe_mux);
+    *out = probe_stats;
+    portEXIT_CRITICAL(&probe_mux);
+}
+
+static void rpc_selftest(Print &out, const char *args) {
+    if (!strcmp(args, "forget")) {
+        hw_probe_forget();
+        out.println("ok");
+        return;
+    }
+    if (args[0] && strcmp(args, "full")) {
+        out.println("usage: selftest [full | forget]");
+        return;
+    }
+    int present = hw_probe_run(args[0] != '\0');
+    if (present < 0) {
+        out.println("a run is already going");
+        return;
+    }
+    for (size_t i = 0; i < PROBE_COUNT; i++) {
+        HwProbeResult r;
+        hw_probe_get(probes[i].peri_id, &r);
+        out.printf("%-8s %-16s %6lu us\n", probes[i].name, hw_probe_state_name(r.state), (unsigned long)r.us);
+    }
+    HwProbeStats s;
+    hw_probe_get_stats(&s);
+    out.printf("%d present, %lu ms (%lu ms one after another), %lu skipped from the cache%s\n", present,
+               (unsigned long)s.last_ms, (unsigned long)s.serial_ms, (unsigned long)s.skipped,
+               run_full ? ", cache rechecked" : "");
+}
+
+void hw_probe_begin() {
+    cache_load();
+    usb_console_rpc("selftest", rpc_selftest);
+}
@@ -0,0 +1,115 @@
+/**
+ * @file      hw_probe.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Parallel presence probes per bus, with a cache of absent parts in NVS
+ */
+
+#ifndef HW_PROBE_H
+#define HW_PROBE_H
+
+#include <Arduino.h>
+#include "peripheral.h"
+
+/**
+ * One task per independent bus, all started together: the I2C parts one
+ * after another on theirs (address acknowledge), the SX1262 on SPI
+ * (GetStatus), the GPS and the modem each on their own UART. Every probe
+ * has its own bound and the run as a whole HW_PROBE_DEADLINE_MS, so a
+ * missing part costs one short timeout instead of a driver's retries. A
+ * part whose driver is already up counts as present without being touched.
+ * The modem is only asked while its rail is on; the card is left to
+ * sd_manager, being removable.
+ *
+ * Parts found absent are kept in NVS under the board revision
+ * (HW_PROBE_BOARD_REV). Later boots skip their probes, and
+ * peri_init_ensure() skips their drivers' bring-up, until
+ * HW_PROBE_RECHECK_RUNS runs have passed, a full run finds them, or the
+ * revision changes. A probe that timed out on the run deadline is not
+ * cached either way.
+ *
+ * Console: "selftest" runs the probes and prints them, "selftest full"
+ * ignores the cache, "selftest forget" clears it.
+ * Config section "selftest": cache (true), recheck_runs.
+ */
+
+#ifndef HW_PROBE_BOARD_REV
+#define HW_PROBE_BOARD_REV          "tdeckpro-v1"   // Set per board in build_flags
+#endif
+#define HW_PROBE_NVS_NAMESPACE      "hwprobe"
+#define HW_PROBE_VERSION            1       // Bump when the probes change what they find
+#define HW_PROBE_DEADLINE_MS        2500    // Whole run
+#define HW_PROBE_I2C_MS             10      // Per address
+#define HW_PROBE_SPI_MS             20      // Bus wait, then SX1262 BUSY
+#define HW_PROBE_GPS_MS             1200    // Any byte; the receiver talks at least once a second
+#define HW_PROBE_AT_MS              500     // One AT, no retries
+#define HW_PROBE_RECHECK_RUNS       20      // Cached absences are probed again after these
+#define HW_PROBE_TASK_STACK         (1024 * 3)
+#define HW_PROBE_TASK_PRIORITY      (tskIDLE_PRIORITY + 2)
+
+enum HwProbeBus {
+    HW_PROBE_BUS_I2C = 0,
+    HW_PROBE_BUS_SPI,
+    HW_PROBE_BUS_GPS_UART,
+    HW_PROBE_BUS_MODEM_UART,
+    HW_PROBE_BUS_COUNT,
+};
+
+enum HwProbeState {
+    HW_PROBE_UNKNOWN = 0,           // Not probed: no probe for it, or never run
+    HW_PROBE_PRESENT,
+    HW_PROBE_ABSENT,
+    HW_PROBE_CACHED_ABSENT,         // Skipped, absent on an earlier run
+    HW_PROBE_SKIPPED,               // Could not be asked, e.g. its rail is off
+    HW_PROBE_TIMEOUT,               // Still running at the deadline
+};
+
+struct HwProbeResult {
+    uint8_t state;                  // HwProbeState
+    uint8_t bus;                    // HwProbeBus
+    uint32_t us;                    // Time the probe took
+};
+
+struct HwProbeStats {
+    uint32_t runs;
+    uint32_t last_ms;               // Wall time of the last run
+    uint32_t serial_ms;             // Its probes' times added up, as one after another
+    uint32_t probed;
+    uint32_t skipped;               // From the cache
+    uint32_t absent_mask;           // Cached, by E_PERI_* bit
+    uint8_t runs_since_full;
+};
+
+/**
+ * @brief Run the probes. Blocks the caller up to HW_PROBE_DEADLINE_MS; not
+ *        from the UI task. full ignores the cache
+ * @return parts present
+ */
+int hw_probe_run(bool full = false);
+
+/**
+ * @brief Absent on an earlier run and not due for a recheck. Any task;
+ *        reads NVS once
+ */
+bool hw_probe_known_absent(int peri_id);
+
+/**
+ * @brief The last run's result for an E_PERI_* part
+ */
+void hw_probe_get(int peri_id, HwProbeResult *out);
+
+const char *hw_probe_name(int peri_id);
+const char *hw_probe_state_name(uint8_t state);
+
+void hw_probe_forget();
+
+/**
+ * @brief Console command. Called from SimpleHardware::runDiagnostics()
+ */
+void hw_probe_begin();
+
+void hw_probe_get_stats(HwProbeStats *out);
+
+#endif // HW_PROBE_H
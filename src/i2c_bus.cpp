@@ -0,0 +1,443 @@
+/**
+ * @file      i2c_bus.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Shared I2C bus arbitration by priority class, with batched register reads
+ */
+
+#include "i2c_bus.h"
+#include "simple_logger.h"
+#include "utilities.h"
+#include <driver/i2c.h>
+#include <esp_timer.h>
+#include <string.h>
+
+// burst: registers auto-increment and reading the ones in between has no side
+// effect, so neighbouring reads can share one transfer. The BQ25896 fault
+// register clears on read, the TCA8418 event FIFO pops and the touch and hub
+// speak their own framing, so those stay one read per transfer
+static const struct {
+    const char *name;
+    uint8_t addr;
+    uint8_t cls;
+    bool burst;
+} bus_devs[I2C_DEV_NUM] = {
+    { "touch",   BOARD_I2C_ADDR_TOUCH,      I2C_BUS_INPUT,      false },
+    { "keypad",  BOARD_I2C_ADDR_KEYBOARD,   I2C_BUS_INPUT,      false },
+    { "bhi260",  BOARD_I2C_ADDR_GYROSCOPDE, I2C_BUS_SENSOR,     false },
+    { "ltr553",  BOARD_I2C_ADDR_LTR_553ALS, I2C_BUS_SENSOR,     true  },
+    { "bq25896", BOARD_I2C_ADDR_BQ25896,    I2C_BUS_BACKGROUND, false },
+    { "bq27220", BOARD_I2C_ADDR_BQ27220,    I2C_BUS_BACKGROUND, true  },
+};
+
+enum {
+    OP_FREE = 0,
+    OP_QUEUED,
+    OP_ACTIVE,
+};
+
+typedef struct {
+    SemaphoreHandle_t sem;
+    uint32_t seq;
+    uint8_t cls;
+    bool used;
+    bool granted;               // Handed the bus by a release
+} bus_waiter_t;
+
+typedef struct {
+    i2c_bus_done_cb cb;
+    void *ctx;
+    uint32_t seq;
+    uint8_t dev;
+    uint8_t remaining;
+    bool ok;
+    bool used;
+} bus_request_t;
+
+typedef struct {
+    uint8_t *buf;
+    uint8_t reg;
+    uint8_t len;
+    uint8_t req;
+    uint8_t state;
+} bus_op_t;
+
+// Everything below is guarded by bus_mux
+static portMUX_TYPE bus_mux = portMUX_INITIALIZER_UNLOCKED;
+static TaskHandle_t bus_task_handle = NULL;
+static bool bus_busy = false;
+static int64_t bus_since = 0;
+static uint32_t bus_seq = 0;
+static bus_waiter_t bus_waiters[I2C_BUS_WAITERS];
+static bus_request_t bus_requests[I2C_BUS_REQUESTS];
+static bus_op_t bus_ops[I2C_BUS_OPS];
+static i2c_bus_stats_t bus_stats[I2C_DEV_NUM];
+
+static inline bool before(uint8_t cls_a, uint32_t seq_a, uint8_t cls_b, uint32_t seq_b) {
+    return cls_a != cls_b ? cls_a < cls_b : (int32_t)(seq_a - seq_b) < 0;
+}
+
+static void note_wait(int dev, int64_t asked, bool contended) {
+    int64_t now = esp_timer_get_time();
+    uint32_t waited = (uint32_t)(now - asked);
+    portENTER_CRITICAL(&bus_mux);
+    bus_since = now;
+    bus_stats[dev].wait_us += waited;
+    if (waited > bus_stats[dev].wait_max_us) {
+        bus_stats[dev].wait_max_us = waited;
+    }
+    if (contended) {
+        bus_stats[dev].contended++;
+    }
+    portEXIT_CRITICAL(&bus_mux);
+}
+
+bool i2c_bus_acquire(int dev, uint32_t timeout_ms) {
+    if (dev < 0 || dev >= I2C_DEV_NUM) {
+        return false;
+    }
+    int64_t asked = esp_timer_get_time();
+    TickType_t start = xTaskGetTickCount();
+    TickType_t ticks = timeout_ms == portMAX_DELAY ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms);
+
+    while (true) {
+        bus_waiter_t *w = NULL;
+        portENTER_CRITICAL(&bus_mux);
+        bool idle = !bus_busy || !bus_task_handle;    // Nothing to arbitrate before begin
+        if (idle) {
+            bus_busy = true;
+        } else {
+            for (int i = 0; i < I2C_BUS_WAITERS; i++) {
+                if (!bus_waiters[i].used) {
+                    w = &bus_waiters[i];
+                    w->used = true;
+                    w->granted = false;
+                    w->cls = bus_devs[dev].cls;
+                    w->seq = bus_seq++;
+                    break;
+                }
+            }
+        }
+        portEXIT_CRITICAL(&bus_mux);
+
+        if (idle) {
+            note_wait(dev, asked, false);
+            return true;
+        }
+
+        TickType_t elapsed = xTaskGetTickCount() - start;
+        TickType_t left = ticks == portMAX_DELAY ? portMAX_DELAY : (elapsed < ticks ? ticks - elapsed : 0);
+        if (!w) {
+            // Every waiter slot is taken; poll rather than lose our place entirely
+            if (left == 0) {
+                break;
+            }
+            vTaskDelay(1);
+            continue;
+        }
+
+        bool got = xSemaphoreTake(w->sem, left) == pdTRUE;
+        portENTER_CRITICAL(&bus_mux);
+        if (!got && w->granted) {
+            got = true;         // Handed over between the timeout and here
+            xSemaphoreTake(w->sem, 0);
+        }
+        w->used = false;
+        portEXIT_CRITICAL(&bus_mux);
+
+        if (got) {
+            note_wait(dev, asked, true);
+            return true;
+        }
+        break;
+    }
+
+    portENTER_CRITICAL(&bus_mux);
+    bus_stats[dev].errors++;
+    portEXIT_CRITICAL(&bus_mux);
+    return false;
+}
+
+void i2c_bus_release(int dev, bool ok) {
+    if (dev < 0 || dev >= I2C_DEV_NUM) {
+        return;
+    }
+    bus_waiter_t *next = NULL;
+
+    portENTER_CRITICAL(&bus_mux);
+    uint32_t held = (uint32_t)(esp_timer_get_time() - bus_since);
+    i2c_bus_stats_t *s = &bus_stats[dev];
+    s->transactions++;
+    s->errors += !ok;
+    s->hold_us += held;
+    if (held > s->hold_max_us) {
+        s->hold_max_us = held;
+    }
+
+    for (int i = 0; i < I2C_BUS_WAITERS; i++) {
+        bus_waiter_t *w = &bus_waiters[i];
+        if (w->used && !w->granted && (!next || before(w->cls, w->seq, next->cls, next->seq))) {
+            next = w;
+        }
+    }
+    if (next) {
+        next->granted = true;   // The bus stays busy, it changes hands here
+    } else {
+        bus_busy = false;
+    }
+    portEXIT_CRITICAL(&bus_mux);
+
+    if (next) {
+        xSemaphoreGive(next->sem);
+    }
+}
+
+static bool bus_transfer(int dev, uint8_t reg, uint8_t *buf, uint8_t len) {
+    return i2c_master_write_read_device((i2c_port_t)I2C_BUS_PORT, bus_devs[dev].addr, &reg, 1,
+                                        buf, len, pdMS_TO_TICKS(I2C_BUS_XFER_MS)) == ESP_OK;
+}
+
+bool i2c_bus_read_reg(int dev, uint8_t reg, uint8_t *buf, uint8_t len) {
+    if (!i2c_bus_acquire(dev)) {
+        return false;
+    }
+    bool ok = bus_transfer(dev, reg, buf, len);
+    i2c_bus_release(dev, ok);
+    return ok;
+}
+
+bool i2c_bus_read_async(int dev, const i2c_bus_op_t *ops, uint8_t count,
+                        i2c_bus_done_cb cb, void *ctx) {
+    if (dev < 0 || dev >= I2C_DEV_NUM || count == 0 || !bus_task_handle) {
+        return false;
+    }
+    for (uint8_t i = 0; i < count; i++) {
+        if (ops[i].len == 0 || ops[i].len > I2C_BUS_BURST_MAX || ops[i].reg + ops[i].len > 0x100) {
+            return false;
+        }
+    }
+
+    bool queued = false;
+    portENTER_CRITICAL(&bus_mux);
+    int req = -1;
+    uint8_t free_ops = 0;
+    for (int i = 0; i < I2C_BUS_REQUESTS && req < 0; i++) {
+        if (!bus_requests[i].used) {
+            req = i;
+        }
+    }
+    for (int i = 0; i < I2C_BUS_OPS; i++) {
+        free_ops += bus_ops[i].state == OP_FREE;
+    }
+    if (req >= 0 && free_ops >= count) {
+        bus_request_t *r = &bus_requests[req];
+        r->used = true;
+        r->cb = cb;
+        r->ctx = ctx;
+        r->seq = bus_seq++;
+        r->dev = dev;
+        r->remaining = count;
+        r->ok = true;
+        for (int i = 0, n = 0; i < I2C_BUS_OPS && n < count; i++) {
+            if (bus_ops[i].state == OP_FREE) {
+                bus_ops[i] = { ops[n].buf, ops[n].reg, ops[n].len, (uint8_t)req, OP_QUEUED };
+                n++;
+            }
+        }
+        queued = true;
+    }
+    portEXIT_CRITICAL(&bus_mux);
+
+    if (queued) {
+        xTaskNotifyGive(bus_task_handle);
+    }
+    return queued;
+}
+
+typedef struct {
+    SemaphoreHandle_t done;
+    bool ok;
+} bus_wait_t;
+
+static void read_done(int dev, bool ok, void *ctx) {
+    bus_wait_t *wait = (bus_wait_t *)ctx;
+    wait->ok = ok;
+    xSemaphoreGive(wait->done);
+}
+
+bool i2c_bus_read(int dev, const i2c_bus_op_t *ops, uint8_t count) {
+    if (!bus_task_handle || xTaskGetCurrentTaskHandle() == bus_task_handle) {
+        bool ok = true;
+        for (uint8_t i = 0; i < count; i++) {
+            ok &= i2c_bus_read_reg(dev, ops[i].reg, ops[i].buf, ops[i].len);
+        }
+        return ok;
+    }
+
+    // The request holds our buffers, so wait it out; the driver's own timeout bounds it
+    StaticSemaphore_t storage;
+    bus_wait_t wait = { xSemaphoreCreateBinaryStatic(&storage), false };
+    if (!i2c_bus_read_async(dev, ops, count, read_done, &wait)) {
+        return false;
+    }
+    xSemaphoreTake(wait.done, portMAX_DELAY);
+    return wait.ok;
+}
+
+// Oldest read of the most urgent class, plus whatever else pending on the same
+// device fits in one burst around it. Marks them active; returns how many
+static uint8_t take_batch(uint8_t *batch, uint8_t *dev, uint8_t *lo, uint8_t *span) {
+    uint8_t n = 0;
+    portENTER_CRITICAL(&bus_mux);
+    int head = -1;
+    for (int i = 0; i < I2C_BUS_OPS; i++) {
+        if (bus_ops[i].state != OP_QUEUED) {
+            continue;
+        }
+        bus_request_t *r = &bus_requests[bus_ops[i].req];
+        if (head < 0) {
+            head = i;
+            continue;
+        }
+        bus_request_t *h = &bus_requests[bus_ops[head].req];
+        if (before(bus_devs[r->dev].cls, r->seq, bus_devs[h->dev].cls, h->seq)) {
+            head = i;
+        }
+    }
+
+    if (head >= 0) {
+        uint8_t d = bus_requests[bus_ops[head].req].dev;
+        uint16_t first = bus_ops[head].reg;
+        uint16_t last = first + bus_ops[head].len;
+        bus_ops[head].state = OP_ACTIVE;
+        batch[n++] = head;
+
+        for (int i = 0; i < I2C_BUS_OPS && bus_devs[d].burst; i++) {
+            bus_op_t *op = &bus_ops[i];
+            if (op->state != OP_QUEUED || bus_requests[op->req].dev != d) {
+                continue;
+            }
+            uint16_t a = op->reg < first ? op->reg : first;
+            uint16_t b = op->reg + op->len > last ? op->reg + op->len : last;
+            if (b - a <= I2C_BUS_BURST_MAX) {
+                first = a;
+                last = b;
+                op->state = OP_ACTIVE;
+                batch[n++] = i;
+            }
+        }
+        *dev = d;
+        *lo = first;
+        *span = last - first;
+    }
+    portEXIT_CRITICAL(&bus_mux);
+    return n;
+}
+
+static void complete_batch(const uint8_t *batch, uint8_t n, uint8_t dev, uint8_t lo,
+                           const uint8_t *data, bool ok) {
+    for (uint8_t k = 0; k < n; k++) {
+        bus_op_t *op = &bus_ops[batch[k]];
+        if (ok) {
+            memcpy(op->buf, data + (op->reg - lo), op->len);
+        }
+
+        i2c_bus_done_cb cb = NULL;
+        void *ctx = NULL;
+        bool done = false;
+        bool req_ok = false;
+        portENTER_CRITICAL(&bus_mux);
+        bus_request_t *r = &bus_requests[op->req];
+        r->ok &= ok;
+        if (--r->remaining == 0) {
+            done = true;
+            req_ok = r->ok;
+            cb = r->cb;
+            ctx = r->ctx;
+            r->used = false;
+        }
+        op->state = OP_FREE;
+        bus_stats[dev].reads++;
+        bus_stats[dev].merged += k > 0;
+        portEXIT_CRITICAL(&bus_mux);
+
+        if (done && cb) {
+            cb(dev, req_ok, ctx);
+        }
+    }
+}
+
+// Sole consumer of the read queue; a notify means something was queued
+static void bus_task(void *param) {
+    uint8_t batch[I2C_BUS_OPS];
+    uint8_t data[I2C_BUS_BURST_MAX];
+
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        uint8_t n, dev, lo, span;
+        while ((n = take_batch(batch, &dev, &lo, &span)) > 0) {
+            bool ok = false;
+            if (i2c_bus_acquire(dev)) {
+                ok = bus_transfer(dev, lo, data, span);
+                i2c_bus_release(dev, ok);
+            }
+            complete_batch(batch, n, dev, lo, data, ok);
+        }
+    }
+}
+
+bool i2c_bus_begin() {
+    if (bus_task_handle) {
+        return true;
+    }
+    for (int i = 0; i < I2C_BUS_WAITERS; i++) {
+        if (!bus_waiters[i].sem) {
+            bus_waiters[i].sem = xSemaphoreCreateBinary();
+        }
+        if (!bus_waiters[i].sem) {
+            LOG_ERROR("I2C", "Failed to create bus waiter semaphores");
+            return false;
+        }
+    }
+    if (xTaskCreate(bus_task, "i2c_bus", I2C_BUS_TASK_STACK, NULL, I2C_BUS_TASK_PRIORITY,
+                    &bus_task_handle) != pdPASS) {
+        LOG_ERROR("I2C", "Failed to create bus task");
+        bus_task_handle = NULL;
+        return false;
+    }
+    LOG_INFO("I2C", "Bus arbitration running: input before sensors before battery");
+    return true;
+}
+
+void i2c_bus_get_stats(int dev, i2c_bus_stats_t *stats) {
+    if (dev < 0 || dev >= I2C_DEV_NUM) {
+        memset(stats, 0, sizeof(*stats));
+        return;
+    }
+    portENTER_CRITICAL(&bus_mux);
+    *stats = bus_stats[dev];
+    portEXIT_CRITICAL(&bus_mux);
+}
+
+const char *i2c_bus_dev_name(int dev) {
+    return dev >= 0 && dev < I2C_DEV_NUM ? bus_devs[dev].name : "?";
+}
+
+void i2c_bus_log_stats() {
+    for (int dev = 0; dev < I2C_DEV_NUM; dev++) {
+        i2c_bus_stats_t s;
+        i2c_bus_get_stats(dev, &s);
+        if (!s.transactions) {
+            continue;
+        }
+        LOG_INFOF("I2C", "%s: %lu xfers, %lu errors, %lu/%lu reads merged, %lu contended, "
+                  "wait avg %lu max %lu us, hold avg %lu max %lu us",
+                  bus_devs[dev].name, (unsigned long)s.transactions, (unsigned long)s.errors,
+                  (unsigned long)s.merged, (unsigned long)s.reads, (unsigned long)s.contended,
+                  (unsigned long)(s.wait_us / s.transactions), (unsigned long)s.wait_max_us,
+                  (unsigned long)(s.hold_us / s.transactions), (unsigned long)s.hold_max_us);
+    }
+}
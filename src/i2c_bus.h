@@ -0,0 +1,107 @@
+/**
+ * @file      i2c_bus.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Shared I2C bus arbitration by priority class, with batched register reads
+ */
+
+#ifndef I2C_BUS_H
+#define I2C_BUS_H
+
+#include <Arduino.h>
+#include "peripheral.h"
+
+#define I2C_BUS_PORT                0       // The port Wire runs on, driver already installed
+#define I2C_BUS_WAITERS             8       // Tasks that can queue for the bus at once
+#define I2C_BUS_OPS                 16      // Queued register reads
+#define I2C_BUS_REQUESTS            8       // Queued batches, each with one completion
+#define I2C_BUS_BURST_MAX           32      // Longest merged read, in bytes
+#define I2C_BUS_XFER_MS             20      // Per-transfer timeout in the IDF driver
+#define I2C_BUS_TASK_PRIORITY       (BHI260_PRIORITY + 1)   // Above every task that uses the bus
+#define I2C_BUS_TASK_STACK          (1024 * 3)
+
+// Lower goes first; within a class the bus is handed out in arrival order
+enum {
+    I2C_BUS_INPUT = 0,          // Touch, keypad: the user is waiting
+    I2C_BUS_SENSOR,             // Sensor hub FIFO, light/proximity events
+    I2C_BUS_BACKGROUND,         // Battery and charger polling
+    I2C_BUS_CLASSES,
+};
+
+enum {
+    I2C_DEV_TOUCH = 0,
+    I2C_DEV_KEYPAD,
+    I2C_DEV_BHI260,
+    I2C_DEV_LTR553,
+    I2C_DEV_BQ25896,
+    I2C_DEV_BQ27220,
+    I2C_DEV_NUM,
+};
+
+typedef struct {
+    uint32_t transactions;      // Bus holds, one per acquire or merged transfer
+    uint32_t errors;
+    uint32_t reads;             // Queued register reads completed
+    uint32_t merged;            // Of those, reads that rode along in another's transfer
+    uint32_t contended;         // Acquires that had to wait
+    uint64_t wait_us;           // Total time from asking to holding the bus
+    uint32_t wait_max_us;
+    uint64_t hold_us;           // Total time holding it
+    uint32_t hold_max_us;
+} i2c_bus_stats_t;
+
+typedef struct {
+    uint8_t reg;
+    uint8_t len;
+    uint8_t *buf;
+} i2c_bus_op_t;
+
+/**
+ * @brief Batch completion, on the bus task. ok is false if any of its reads failed
+ */
+typedef void (*i2c_bus_done_cb)(int dev, bool ok, void *ctx);
+
+/**
+ * @brief Start the bus task. Call once Wire is up; safe to call again
+ */
+bool i2c_bus_begin();
+
+/**
+ * @brief Hold the bus for a run of driver calls on Wire. Waiters get it by
+ *        the device's class, then in order. Before i2c_bus_begin() this
+ *        only records the transaction
+ * @return false if it did not come free within timeout_ms
+ */
+bool i2c_bus_acquire(int dev, uint32_t timeout_ms = portMAX_DELAY);
+
+/**
+ * @brief Hand the bus to the next waiter. ok counts toward the device's errors
+ */
+void i2c_bus_release(int dev, bool ok = true);
+
+/**
+ * @brief Queue register reads and return at once. Reads on a device that
+ *        auto-increments are merged with any others pending on it into one
+ *        burst when they fit in I2C_BUS_BURST_MAX. Buffers must live until cb
+ * @return false if the queue is full or the bus task is not running
+ */
+bool i2c_bus_read_async(int dev, const i2c_bus_op_t *ops, uint8_t count,
+                        i2c_bus_done_cb cb = NULL, void *ctx = NULL);
+
+/**
+ * @brief Queue register reads and block until they complete. Not from the bus task
+ */
+bool i2c_bus_read(int dev, const i2c_bus_op_t *ops, uint8_t count);
+
+/**
+ * @brief One register run, on the calling task, with the bus held
+ */
+bool i2c_bus_read_reg(int dev, uint8_t reg, uint8_t *buf, uint8_t len);
+
+void i2c_bus_get_stats(int dev, i2c_bus_stats_t *stats);
+const char *i2c_bus_dev_name(int dev);
+void i2c_bus_log_stats();
+
+#endif // I2C_BUS_H
@@ -0,0 +1,105 @@
+/**
+ * @file      img_1bpp_decoder.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     1bpp icon decoder implementation
+ */
+
+#include "img_1bpp_decoder.h"
+#include "simple_logger.h"
+#include "src/assets.h"
+
+#if LV_COLOR_DEPTH != 1
+#error "img_1bpp_decoder expands straight to 1-byte lv_color_t, LV_COLOR_DEPTH must be 1"
+#endif
+
+// Four packed pixels (MSB first) to four lv_color_t bytes in address order
+static uint32_t expand_lut[16];
+static lv_img_decoder_t* decoder = nullptr;
+
+static bool is_1bpp_asset(const void* src) {
+    return lv_img_src_get_type(src) == LV_IMG_SRC_VARIABLE &&
+           ((const lv_img_dsc_t*)src)->header.cf == IMG_1BPP_CF;
+}
+
+static lv_res_t decoder_info(lv_img_decoder_t* dec, const void* src, lv_img_header_t* header) {
+    LV_UNUSED(dec);
+    if (!is_1bpp_asset(src)) {
+        return LV_RES_INV;
+    }
+    
+    const lv_img_dsc_t* img = (const lv_img_dsc_t*)src;
+    header->w = img->header.w;
+    header->h = img->header.h;
+    header->always_zero = 0;
+    header->cf = LV_IMG_CF_TRUE_COLOR;   // Opaque: lets LVGL treat the icon as covering its area
+    return LV_RES_OK;
+}
+
+static lv_res_t decoder_open(lv_img_decoder_t* dec, lv_img_decoder_dsc_t* dsc) {
+    LV_UNUSED(dec);
+    if (!is_1bpp_asset(dsc->src)) {
+        return LV_RES_INV;
+    }
+    
+    const lv_img_dsc_t* img = (const lv_img_dsc_t*)dsc->src;
+    uint32_t w = img->header.w;
+    uint32_t h = img->header.h;
+    uint32_t stride = (w + 7) / 8;
+    
+    uint8_t* out = (uint8_t*)lv_mem_alloc(w * h * sizeof(lv_color_t));
+    if (!out) {
+        return LV_RES_INV;
+    }
+    
+    const uint8_t* row = img->data;
+    uint8_t* dst = out;
+    uint32_t whole = w / 8;
+    for (uint32_t y = 0; y < h; y++) {
+        for (uint32_t i = 0; i < whole; i++) {
+            memcpy(dst, &expand_lut[row[i] >> 4], 4);
+            memcpy(dst + 4, &expand_lut[row[i] & 0x0F], 4);
+            dst += 8;
+        }
+        for (uint32_t x = whole * 8; x < w; x++) {
+            *dst++ = (row[x >> 3] >> (7 - (x & 7))) & 1;
+        }
+        row += stride;
+    }
+    
+    dsc->img_data = out;
+    return LV_RES_OK;
+}
+
+static void decoder_close(lv_img_decoder_t* dec, lv_img_decoder_dsc_t* dsc) {
+    LV_UNUSED(dec);
+    if (dsc->img_data) {
+        lv_mem_free((void*)dsc->img_data);
+        dsc->img_data = nullptr;
+    }
+}
+
+bool img_1bpp_decoder_init() {
+    if (decoder) {
+        return true;
+    }
+    
+    // lv_color_t is one byte at LV_COLOR_DEPTH 1, 1 = white
+    for (uint32_t n = 0; n < 16; n++) {
+        expand_lut[n] = ((n >> 3) & 1) | (((n >> 2) & 1) << 8) |
+                        (((n >> 1) & 1) << 16) | ((uint32_t)(n & 1) << 24);
+    }
+    
+    decoder = lv_img_decoder_create();
+    if (!decoder) {
+        LOG_ERROR("LVGL", "Failed to create 1bpp image decoder");
+        return false;
+    }
+    
+    lv_img_decoder_set_info_cb(decoder, decoder_info);
+    lv_img_decoder_set_open_cb(decoder, decoder_open);
+    lv_img_decoder_set_close_cb(decoder, decoder_close);
+    return true;
+}
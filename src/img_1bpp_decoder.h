@@ -0,0 +1,26 @@
+/**
+ * @file      img_1bpp_decoder.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     LVGL image decoder for the generated 1bpp icon assets
+ */
+
+#ifndef IMG_1BPP_DECODER_H
+#define IMG_1BPP_DECODER_H
+
+#include <Arduino.h>
+#include <lvgl.h>
+
+/**
+ * @brief Register the decoder for IMG_1BPP_CF images (see src/src/assets.h).
+ *
+ * The assets are already thresholded and in framebuffer bit order, so the
+ * decoder expands them to opaque lv_color_t in one pass and LVGL copies the
+ * rows with its plain memcpy blend, skipping alpha and colour conversion.
+ * Must be called after lv_init().
+ */
+bool img_1bpp_decoder_init();
+
+#endif // IMG_1BPP_DECODER_H
@@ -0,0 +1,407 @@
+/**
+ * @file      img_pipeline.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     TJpgDec strip output, luminance and the 1bpp dithering kernels
+ */
+
+#include "img_pipeline.h"
+#include "simple_logger.h"
+#include "placement.h"
+#include "src/assets.h"
+#include <esp_heap_caps.h>
+#include <src/extra/libs/sjpg/tjpgd.h>
+
+#if !LV_USE_SJPG || JD_FORMAT != 0
+#error "img_pipeline needs LVGL's TJpgDec (LV_USE_SJPG) with RGB888 output"
+#endif
+
+// 8x8 Bayer matrix, 0..63
+static const uint8_t bayer8[8][8] = {
+    {  0, 32,  8, 40,  2, 34, 10, 42 },
+    { 48, 16, 56, 24, 50, 18, 58, 26 },
+    { 12, 44,  4, 36, 14, 46,  6, 38 },
+    { 60, 28, 52, 20, 62, 30, 54, 22 },
+    {  3, 35, 11, 43,  1, 33,  9, 41 },
+    { 51, 19, 59, 27, 49, 17, 57, 25 },
+    { 15, 47,  7, 39, 13, 45,  5, 37 },
+    { 63, 31, 55, 23, 61, 29, 53, 21 },
+};
+
+// Each Bayer row as two words of 7-bit thresholds, pixels in address order
+static uint32_t bayer_words[8][2];
+static bool bayer_ready = false;
+
+struct JpegJob {
+    JDEC jd;
+    ImgSource* src;
+    ImgTarget dst;
+    ImgDitherState dither;
+    uint8_t* pool;
+    uint8_t* strip;                 // One MCU row of luminance, strip_w wide
+    uint16_t strip_w;
+    uint16_t out_w;                 // Decoded width at the chosen scale
+};
+
+// ===== Sources =====
+
+static size_t memory_read(void* ctx, uint8_t* buf, size_t len) {
+    ImgSource* src = (ImgSource*)ctx;
+    len = LV_MIN(len, src->len - src->pos);
+    if (buf) {
+        memcpy(buf, src->data + src->pos, len);
+    }
+    src->pos += len;
+    return len;
+}
+
+static size_t file_read(void* ctx, uint8_t* buf, size_t len) {
+    ImgSource* src = (ImgSource*)ctx;
+    if (buf) {
+        return src->file->read(buf, len);
+    }
+    size_t left = src->file->size() - src->file->position();
+    len = LV_MIN(len, left);
+    return src->file->seek(len, fs::SeekCur) ? len : 0;
+}
+
+void img_source_memory(ImgSource* src, const uint8_t* data, size_t len) {
+    memset(src, 0, sizeof(*src));
+    src->read = memory_read;
+    src->ctx = src;
+    src->data = data;
+    src->len = len;
+}
+
+void img_source_file(ImgSource* src, fs::File* file) {
+    memset(src, 0, sizeof(*src));
+    src->read = file_read;
+    src->ctx = src;
+    src->file = file;
+}
+
+// ===== Dithering =====
+
+// Gather bit 0 of four pixel bytes in address order into the low nibble
+static inline uint8_t pack_nibble(uint32_t pixels) {
+    return (uint8_t)(((pixels & 0x01010101UL) * 0x08040201UL) >> 24);
+}
+
+static void bayer_init() {
+    for (int y = 0; y < 8; y++) {
+        uint8_t t[8];
+        for (int x = 0; x < 8; x++) {
+            t[x] = bayer8[y][x] * 2 + 1;    // 1..127, against luminance >> 1
+        }
+        memcpy(&bayer_words[y][0], t, 4);
+        memcpy(&bayer_words[y][1], t + 4, 4);
+    }
+    bayer_ready = true;
+}
+
+// Four pixels at once: with both sides below 0x80, (l | 0x80) - t never
+// borrows from the next byte and keeps bit 7 exactly where l >= t
+static inline uint8_t bayer_nibble(const uint8_t* luma, uint32_t t) {
+    uint32_t l;
+    memcpy(&l, luma, sizeof(l));
+    l = (l >> 1) & 0x7F7F7F7FUL;
+    return pack_nibble((((l | 0x80808080UL) - t) & 0x80808080UL) >> 7);
+}
+
+static void PLACE_HOT dither_bayer(const ImgDitherState* st, const uint8_t* luma, uint8_t* out) {
+    const uint32_t* t = bayer_words[st->y & 7];
+    uint16_t x = 0;
+    for (; x + 8 <= st->width; x += 8) {
+        *out++ = (uint8_t)((bayer_nibble(luma + x, t[0]) << 4) | bayer_nibble(luma + x + 4, t[1]));
+    }
+    if (x < st->width) {
+        uint8_t bits = 0xFF;        // Past the edge stays white
+        for (uint8_t i = 0; x + i < st->width; i++) {
+            if ((luma[x + i] >> 1) < bayer8[st->y & 7][i] * 2 + 1) {
+                bits &= ~(0x80 >> i);
+            }
+        }
+        *out = bits;
+    }
+}
+
+static void PLACE_HOT dither_threshold(const ImgDitherState* st, const uint8_t* luma, uint8_t* out) {
+    uint16_t x = 0;
+    for (; x + 8 <= st->width; x += 8) {
+        uint32_t lo, hi;
+        memcpy(&lo, luma + x, sizeof(lo));
+        memcpy(&hi, luma + x + 4, sizeof(hi));
+        *out++ = (uint8_t)((pack_nibble(lo >> 7) << 4) | pack_nibble(hi >> 7));
+    }
+    if (x < st->width) {
+        uint8_t bits = 0xFF;
+        for (uint8_t i = 0; x + i < st->width; i++) {
+            if (luma[x + i] < 0x80) {
+                bits &= ~(0x80 >> i);
+            }
+        }
+        *out = bits;
+    }
+}
+
+static void PLACE_HOT dither_diffuse(ImgDitherState* st, const uint8_t* luma, uint8_t* out) {
+    uint16_t row = st->width + 4;
+    int16_t* cur = st->err + (st->y % 3) * row + 2;
+    int16_t* next = st->err + ((st->y + 1) % 3) * row + 2;
+    int16_t* next2 = st->err + ((st->y + 2) % 3) * row + 2;
+    bool atkinson = st->mode == IMG_DITHER_ATKINSON;
+    uint8_t bits = 0;
+
+    for (uint16_t x = 0; x < st->width; x++) {
+        int32_t v = luma[x] + cur[x];
+        bool white = v >= 128;
+        int32_t e = white ? v - 255 : v;
+        if (white) {
+            bits |= 0x80 >> (x & 7);
+        }
+        if (atkinson) {
+            int16_t e8 = (int16_t)(e >> 3);
+            cur[x + 1] += e8;
+            cur[x + 2] += e8;
+            next[x - 1] += e8;
+            next[x] += e8;
+            next[x + 1] += e8;
+            next2[x] += e8;
+        } else {
+            cur[x + 1] += (int16_t)((e * 7) >> 4);
+            next[x - 1] += (int16_t)((e * 3) >> 4);
+            next[x] += (int16_t)((e * 5) >> 4);
+            next[x + 1] += (int16_t)(e >> 4);
+        }
+        if ((x & 7) == 7) {
+            *out++ = bits;
+            bits = 0;
+        }
+    }
+    if (st->width & 7) {
+        *out = bits | (0xFF >> (st->width & 7));
+    }
+    // This row comes round again as the one two below
+    memset(cur - 2, 0, row * sizeof(int16_t));
+}
+
+bool img_dither_begin(ImgDitherState* st, ImgDither mode, uint16_t width) {
+    st->mode = mode;
+    st->width = width;
+    st->y = 0;
+    st->err = NULL;
+    if (!width || width > IMG_MAX_WIDTH) {
+        return false;
+    }
+    if (mode == IMG_DITHER_BAYER && !bayer_ready) {
+        bayer_init();
+    }
+    if (mode == IMG_DITHER_FLOYD_STEINBERG || mode == IMG_DITHER_ATKINSON) {
+        size_t len = 3 * (width + 4) * sizeof(int16_t);
+        st->err = (int16_t*)heap_caps_calloc(1, len, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        if (!st->err) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void img_dither_row(ImgDitherState* st, const uint8_t* luma, uint8_t* out) {
+    switch (st->mode) {
+        case IMG_DITHER_BAYER:
+            dither_bayer(st, luma, out);
+            break;
+        case IMG_DITHER_FLOYD_STEINBERG:
+        case IMG_DITHER_ATKINSON:
+            dither_diffuse(st, luma, out);
+            break;
+        default:
+            dither_threshold(st, luma, out);
+            break;
+    }
+    st->y++;
+}
+
+void img_dither_end(ImgDitherState* st) {
+    heap_caps_free(st->err);
+    st->err = NULL;
+}
+
+// ===== JPEG =====
+
+static size_t jpeg_in(JDEC* jd, uint8_t* buf, size_t len) {
+    ImgSource* src = ((JpegJob*)jd->device)->src;
+    return src->read(src->ctx, buf, len);
+}
+
+// An MCU block in RGB888; the last block of an MCU row completes the strip
+static int PLACE_HOT jpeg_out(JDEC* jd, void* bitmap, JRECT* rect) {
+    JpegJob* job = (JpegJob*)jd->device;
+    uint16_t bw = rect->right - rect->left + 1;
+    uint16_t bottom = LV_MIN(rect->bottom, job->dst.height - 1);
+    const uint8_t* rgb = (const uint8_t*)bitmap;
+
+    if (rect->left < job->strip_w) {
+        uint16_t w = LV_MIN(bw, job->strip_w - rect->left);
+        for (uint16_t y = rect->top; y <= bottom; y++) {
+            const uint8_t* p = rgb + (y - rect->top) * bw * 3;
+            uint8_t* l = job->strip + (y - rect->top) * job->strip_w + rect->left;
+            for (uint16_t x = 0; x < w; x++, p += 3) {
+                l[x] = (uint8_t)((p[0] * 77 + p[1] * 150 + p[2] * 29) >> 8);
+            }
+        }
+    }
+
+    if (rect->right + 1 >= job->out_w) {
+        for (uint16_t y = rect->top; y <= bottom; y++) {
+            img_dither_row(&job->dither, job->strip + (y - rect->top) * job->strip_w,
+                           job->dst.bits + y * job->dst.stride);
+        }
+        if (rect->bottom + 1 >= job->dst.height) {
+            return 0;       // Rest is cropped
+        }
+    }
+    return 1;
+}
+
+// Output size at a scale, as TJpgDec rounds each MCU
+static uint16_t scaled_dim(uint16_t dim, uint16_t mcu, uint8_t scale) {
+    uint16_t last = (dim - 1) / mcu * mcu;
+    uint16_t rest = (dim - last) >> scale;
+    return (last >> scale) + rest;
+}
+
+static bool jpeg_open(JpegJob* job, ImgSource* src) {
+    memset(job, 0, sizeof(*job));
+    job->src = src;
+    job->pool = (uint8_t*)heap_caps_malloc(IMG_JPEG_POOL, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (!job->pool) {
+        return false;
+    }
+    JRESULT res = jd_prepare(&job->jd, jpeg_in, job->pool, IMG_JPEG_POOL, job);
+    if (res != JDR_OK) {
+        LOG_WARNF("IMG", "Not a JPEG TJpgDec can read (%d)", (int)res);
+        heap_caps_free(job->pool);
+        job->pool = NULL;
+        return false;
+    }
+    return true;
+}
+
+static void jpeg_close(JpegJob* job) {
+    img_dither_end(&job->dither);
+    heap_caps_free(job->strip);
+    heap_caps_free(job->pool);
+    job->strip = NULL;
+    job->pool = NULL;
+}
+
+static uint8_t jpeg_scale(const JpegJob* job, uint16_t max_w, uint16_t max_h) {
+    uint8_t scale = 0;
+    while (scale < 3 && (scaled_dim(job->jd.width, job->jd.msx * 8, scale) > max_w ||
+                         scaled_dim(job->jd.height, job->jd.msy * 8, scale) > max_h)) {
+        scale++;
+    }
+    return scale;
+}
+
+static bool jpeg_run(JpegJob* job, const ImgTarget* dst, uint8_t scale, ImgDither mode, ImgInfo* info) {
+    uint32_t start = micros();
+    uint16_t out_h = scaled_dim(job->jd.height, job->jd.msy * 8, scale);
+    job->out_w = scaled_dim(job->jd.width, job->jd.msx * 8, scale);
+    job->dst = *dst;
+    job->dst.height = LV_MIN(dst->height, out_h);
+    job->strip_w = LV_MIN(dst->width, job->out_w);
+
+    uint16_t strip_h = (job->jd.msy * 8) >> scale;
+    job->strip = (uint8_t*)heap_caps_malloc(job->strip_w * strip_h, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (!job->strip || !img_dither_begin(&job->dither, mode, job->strip_w)) {
+        LOG_WARN("IMG", "No memory for the decode strip");
+        return false;
+    }
+
+    JRESULT res = jd_decomp(&job->jd, jpeg_out, scale);
+    if (res != JDR_OK && res != JDR_INTR) {
+        LOG_WARNF("IMG", "JPEG decode failed (%d)", (int)res);
+        return false;
+    }
+
+    if (info) {
+        info->src_width = job->jd.width;
+        info->src_height = job->jd.height;
+        info->width = job->strip_w;
+        info->height = job->dst.height;
+        info->scale = scale;
+        info->decode_us = micros() - start;
+    }
+    LOG_DEBUGF("IMG", "JPEG %ux%u -> %ux%u in %lu us", job->jd.width, job->jd.height, job->strip_w,
+               job->dst.height, (unsigned long)(micros() - start));
+    return true;
+}
+
+bool img_jpeg_size(ImgSource* src, uint16_t* w, uint16_t* h) {
+    JpegJob job;
+    if (!jpeg_open(&job, src)) {
+        return false;
+    }
+    *w = job.jd.width;
+    *h = job.jd.height;
+    jpeg_close(&job);
+    return true;
+}
+
+bool img_decode_jpeg(ImgSource* src, const ImgTarget* dst, ImgDither mode, ImgInfo* info) {
+    if (!dst || !dst->bits || !dst->width || !dst->height) {
+        return false;
+    }
+    JpegJob job;
+    if (!jpeg_open(&job, src)) {
+        return false;
+    }
+    bool ok = jpeg_run(&job, dst, jpeg_scale(&job, dst->width, dst->height), mode, info);
+    jpeg_close(&job);
+    return ok;
+}
+
+lv_img_dsc_t* img_load_jpeg(ImgSource* src, uint16_t max_w, uint16_t max_h, ImgDither mode) {
+    JpegJob job;
+    if (!max_w || !max_h || !jpeg_open(&job, src)) {
+        return NULL;
+    }
+    uint8_t scale = jpeg_scale(&job, max_w, max_h);
+    uint16_t w = LV_MIN(max_w, scaled_dim(job.jd.width, job.jd.msx * 8, scale));
+    uint16_t h = LV_MIN(max_h, scaled_dim(job.jd.height, job.jd.msy * 8, scale));
+    uint16_t stride = (w + 7) / 8;
+
+    // Descriptor and bits in one block, freed together
+    lv_img_dsc_t* img = (lv_img_dsc_t*)heap_caps_malloc(sizeof(lv_img_dsc_t) + stride * h,
+                                                        MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!img) {
+        jpeg_close(&job);
+        return NULL;
+    }
+    uint8_t* bits = (uint8_t*)(img + 1);
+    memset(bits, 0xFF, stride * h);
+
+    ImgTarget dst = { bits, stride, w, h };
+    if (!jpeg_run(&job, &dst, scale, mode, NULL)) {
+        jpeg_close(&job);
+        heap_caps_free(img);
+        return NULL;
+    }
+    jpeg_close(&job);
+
+    memset(&img->header, 0, sizeof(img->header));
+    img->header.cf = IMG_1BPP_CF;
+    img->header.w = w;
+    img->header.h = h;
+    img->data_size = stride * h;
+    img->data = bits;
+    return img;
+}
+
+void img_free(lv_img_dsc_t* img) {
+    heap_caps_free(img);
+}
@@ -0,0 +1,117 @@
+/**
+ * @file      img_pipeline.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Streaming JPEG decode and 1bpp dithering into packed bitmaps
+ */
+
+#ifndef IMG_PIPELINE_H
+#define IMG_PIPELINE_H
+
+#include <Arduino.h>
+#include <FS.h>
+#include <lvgl.h>
+
+/**
+ * Photos, maps and other grey images for the panel. A JPEG is decoded one
+ * MCU row at a time by TJpgDec (the copy bundled with LVGL), converted to
+ * luminance and dithered straight into a packed 1bpp bitmap in framebuffer
+ * bit order, so the whole image is never held in colour or grey. Working
+ * memory is the decoder pool, one MCU strip of luminance and the error
+ * rows, under 10 KB in internal RAM for a full-width image.
+ *
+ * The output is the layout img_1bpp_decoder draws (IMG_1BPP_CF): rows of
+ * (w + 7) / 8 bytes, MSB first, 1 = white. img_load_jpeg() wraps it in an
+ * lv_img_dsc_t; img_decode_jpeg() writes into any such buffer, e.g. one
+ * the caller keeps for a map tile.
+ *
+ * Sources that render grey themselves (a QR code, a map renderer) feed
+ * rows to img_dither_row() directly.
+ *
+ * Ordered dithering compares four pixels per 32-bit word against the
+ * Bayer row; the error-diffusion modes are serial by nature and run per
+ * pixel on 16-bit error rows.
+ */
+
+#define IMG_JPEG_POOL       3584    // TJpgDec work area, R0.03 without fast decode
+#define IMG_JPEG_INBUF      512     // Read size handed to the source
+#define IMG_MAX_WIDTH       480     // Widest output row (error rows are sized per image)
+
+enum ImgDither {
+    IMG_DITHER_THRESHOLD = 0,       // Line art, QR codes
+    IMG_DITHER_BAYER,               // Ordered 8x8: stable, no worms, good for maps
+    IMG_DITHER_FLOYD_STEINBERG,
+    IMG_DITHER_ATKINSON,            // Loses a quarter of the error: more contrast on photos
+};
+
+/**
+ * @brief Byte source: read len bytes into buf, or skip them when buf is NULL.
+ *        Returns the bytes read or skipped, 0 at the end or on error
+ */
+typedef size_t (*img_read_fn)(void* ctx, uint8_t* buf, size_t len);
+
+struct ImgSource {
+    img_read_fn read;
+    void* ctx;
+    // Used by the built-in sources
+    const uint8_t* data;
+    size_t len;
+    size_t pos;
+    fs::File* file;
+};
+
+struct ImgTarget {
+    uint8_t* bits;                  // Packed rows, MSB first, 1 = white
+    uint16_t stride;                // Bytes per row
+    uint16_t width;                 // Pixels beyond are cropped
+    uint16_t height;
+};
+
+struct ImgInfo {
+    uint16_t src_width;
+    uint16_t src_height;
+    uint16_t width;                 // After scaling and cropping
+    uint16_t height;
+    uint8_t scale;                  // 1 / (1 << scale)
+    uint32_t decode_us;
+};
+
+struct ImgDitherState {
+    ImgDither mode;
+    uint16_t width;
+    uint16_t y;
+    int16_t* err;                   // Rows of width + 4, padded two pixels each side
+};
+
+void img_source_memory(ImgSource* src, const uint8_t* data, size_t len);
+void img_source_file(ImgSource* src, fs::File* file);
+
+/**
+ * @brief Image size without decoding it
+ */
+bool img_jpeg_size(ImgSource* src, uint16_t* w, uint16_t* h);
+
+/**
+ * @brief Decode into dst at its origin, scaled down by 1, 2, 4 or 8 to fit
+ *        dst where possible and cropped otherwise
+ */
+bool img_decode_jpeg(ImgSource* src, const ImgTarget* dst, ImgDither mode, ImgInfo* info = NULL);
+
+/**
+ * @brief Decode into a new IMG_1BPP_CF image (PSRAM) no larger than
+ *        max_w x max_h. Free with img_free()
+ */
+lv_img_dsc_t* img_load_jpeg(ImgSource* src, uint16_t max_w, uint16_t max_h, ImgDither mode);
+void img_free(lv_img_dsc_t* img);
+
+/**
+ * @brief Dither grey rows, top to bottom. luma is width bytes, 0 = black;
+ *        out receives (width + 7) / 8 packed bytes
+ */
+bool img_dither_begin(ImgDitherState* st, ImgDither mode, uint16_t width);
+void img_dither_row(ImgDitherState* st, const uint8_t* luma, uint8_t* out);
+void img_dither_end(ImgDitherState* st);
+
+#endif // IMG_PIPELINE_H
@@ -0,0 +1,138 @@
+/**
+ * @file      input_trace.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Input latency tracing from the GPIO interrupt to the panel update that shows it
+ */
+
+#include "input_trace.h"
+#include "simple_logger.h"
+
+// Bucket upper edges in milliseconds; the last bucket is open
+static const uint32_t trace_edges_ms[INPUT_TRACE_BUCKETS - 1] = {1, 5, 10, 50, 100, 500, 1000};
+static const char *const trace_stage_names[INPUT_STAGE_COUNT] = {
+    "driver", "indev", "render", "flush", "panel", "glass", "total",
+};
+static const char *const trace_source_names[INPUT_SRC_COUNT] = {"keypad", "touch"};
+
+static input_trace_t trace_pending;     // UI task only
+static input_trace_stats_t trace_stats;
+static portMUX_TYPE trace_mux = portMUX_INITIALIZER_UNLOCKED;
+
+void input_trace_indev(const input_tag_t *tag) {
+    if (!tag->irq_us || trace_pending.active) {
+        return;
+    }
+    memset(&trace_pending, 0, sizeof(trace_pending));
+    trace_pending.active = true;
+    trace_pending.source = tag->source;
+    trace_pending.irq_us = tag->irq_us;
+    trace_pending.mark[INPUT_STAGE_DRIVER] = tag->driver_us ? tag->driver_us : tag->irq_us;
+    trace_pending.mark[INPUT_STAGE_INDEV] = micros();
+}
+
+void input_trace_render() {
+    if (trace_pending.active && !trace_pending.mark[INPUT_STAGE_RENDER]) {
+        trace_pending.mark[INPUT_STAGE_RENDER] = micros();
+    }
+}
+
+void input_trace_take(input_trace_t *trace) {
+    // A frame already rendering when the event came does not show it
+    if (!trace_pending.active || !trace_pending.mark[INPUT_STAGE_RENDER]) {
+        trace->active = false;
+        return;
+    }
+    trace_pending.mark[INPUT_STAGE_FLUSH] = micros();
+    *trace = trace_pending;
+    trace_pending.active = false;
+}
+
+void input_trace_panel(input_trace_t *trace) {
+    if (trace->active) {
+        trace->mark[INPUT_STAGE_PANEL] = micros();
+    }
+}
+
+static uint8_t trace_bucket(uint32_t us) {
+    uint32_t ms = us / 1000;
+    uint8_t b = 0;
+    while (b < INPUT_TRACE_BUCKETS - 1 && ms >= trace_edges_ms[b]) {
+        b++;
+    }
+    return b;
+}
+
+void input_trace_glass(input_trace_t *trace) {
+    if (!trace->active) {
+        return;
+    }
+    trace->active = false;
+    trace->mark[INPUT_STAGE_GLASS] = micros();
+
+    uint32_t stage_us[INPUT_STAGE_COUNT];
+    uint32_t prev = trace->irq_us;
+    for (int i = 0; i <= INPUT_STAGE_GLASS; i++) {
+        stage_us[i] = trace->mark[i] - prev;
+        prev = trace->mark[i];
+    }
+    stage_us[INPUT_STAGE_TOTAL] = trace->mark[INPUT_STAGE_GLASS] - trace->irq_us;
+
+    portENTER_CRITICAL(&trace_mux);
+    trace_stats.traces[trace->source < INPUT_SRC_COUNT ? trace->source : 0]++;
+    for (int i = 0; i < INPUT_STAGE_COUNT; i++) {
+        uint16_t *bucket = &trace_stats.buckets[i][trace_bucket(stage_us[i])];
+        if (*bucket < UINT16_MAX) {
+            (*bucket)++;
+        }
+        trace_stats.sum_us[i] += stage_us[i];
+        trace_stats.last_us[i] = stage_us[i];
+        if (stage_us[i] > trace_stats.max_us[i]) {
+            trace_stats.max_us[i] = stage_us[i];
+        }
+    }
+    portEXIT_CRITICAL(&trace_mux);
+}
+
+void input_trace_get_stats(input_trace_stats_t *stats) {
+    portENTER_CRITICAL(&trace_mux);
+    *stats = trace_stats;
+    portEXIT_CRITICAL(&trace_mux);
+}
+
+const char *input_trace_stage_name(int stage) {
+    return stage >= 0 && stage < INPUT_STAGE_COUNT ? trace_stage_names[stage] : "?";
+}
+
+void input_trace_print() {
+    input_trace_stats_t s;
+    input_trace_get_stats(&s);
+
+    uint32_t count = 0;
+    for (int i = 0; i < INPUT_SRC_COUNT; i++) {
+        count += s.traces[i];
+    }
+    LOG_INFOF("Input", "=== Input to glass (%lu %s, %lu %s) ===",
+              (unsigned long)s.traces[INPUT_SRC_KEYPAD], trace_source_names[INPUT_SRC_KEYPAD],
+              (unsigned long)s.traces[INPUT_SRC_TOUCH], trace_source_names[INPUT_SRC_TOUCH]);
+    if (count == 0) {
+        return;
+    }
+
+    LOG_INFO("Input", "stage   <1 <5 <10 <50 <100 <500 <1k >=1k   avg   max ms");
+    for (int stage = 0; stage < INPUT_STAGE_COUNT; stage++) {
+        const uint16_t *b = s.buckets[stage];
+        LOG_INFOF("Input", "%-7s %2u %2u %3u %3u %4u %4u %3u %4u %5lu %5lu",
+                  trace_stage_names[stage], b[0], b[1], b[2], b[3], b[4], b[5], b[6], b[7],
+                  (unsigned long)(s.sum_us[stage] / count / 1000),
+                  (unsigned long)(s.max_us[stage] / 1000));
+    }
+}
+
+void input_trace_reset() {
+    portENTER_CRITICAL(&trace_mux);
+    memset(&trace_stats, 0, sizeof(trace_stats));
+    portEXIT_CRITICAL(&trace_mux);
+}
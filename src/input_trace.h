@@ -0,0 +1,83 @@
+/**
+ * @file      input_trace.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Input latency tracing from the GPIO interrupt to the panel update that shows it
+ */
+
+#ifndef INPUT_TRACE_H
+#define INPUT_TRACE_H
+
+#include <Arduino.h>
+
+#define INPUT_TRACE_BUCKETS         8
+
+enum InputTraceSource {
+    INPUT_SRC_KEYPAD = 0,
+    INPUT_SRC_TOUCH,
+    INPUT_SRC_COUNT
+};
+
+// Each stage ends at the named point and starts where the previous one ended
+enum InputTraceStage {
+    INPUT_STAGE_DRIVER,     // INT to the driver reading the controller
+    INPUT_STAGE_INDEV,      // To LVGL's indev read taking the event
+    INPUT_STAGE_RENDER,     // To the render of the next frame starting
+    INPUT_STAGE_FLUSH,      // To that frame packed and handed to the flush task
+    INPUT_STAGE_PANEL,      // To the panel job starting (bus, earlier update)
+    INPUT_STAGE_GLASS,      // To BUSY release: the update is on the glass
+    INPUT_STAGE_TOTAL,      // INT to glass
+    INPUT_STAGE_COUNT
+};
+
+// Carried with the event from the INT on; irq_us == 0 means untraced
+typedef struct {
+    uint32_t irq_us;
+    uint32_t driver_us;
+    uint8_t source;
+} input_tag_t;
+
+// One input followed through a frame; mark[i] is where stage i ended
+typedef struct {
+    uint32_t irq_us;
+    uint32_t mark[INPUT_STAGE_GLASS + 1];
+    uint8_t source;
+    bool active;
+} input_trace_t;
+
+typedef struct {
+    uint32_t traces[INPUT_SRC_COUNT];
+    uint16_t buckets[INPUT_STAGE_COUNT][INPUT_TRACE_BUCKETS];
+    uint64_t sum_us[INPUT_STAGE_COUNT];
+    uint32_t max_us[INPUT_STAGE_COUNT];
+    uint32_t last_us[INPUT_STAGE_COUNT];
+} input_trace_stats_t;
+
+/**
+ * @brief UI task: LVGL took the event. The first input since the last frame
+ *        is the one followed, as it waits longest for the panel
+ */
+void input_trace_indev(const input_tag_t *tag);
+
+/**
+ * @brief UI task: a render started / a frame went to the flush task. The
+ *        frame carries the trace from here in its flush job
+ */
+void input_trace_render();
+void input_trace_take(input_trace_t *trace);
+
+/**
+ * @brief Flush task: the panel job for the traced frame starts / finished
+ *        with BUSY released. The second one records the histograms
+ */
+void input_trace_panel(input_trace_t *trace);
+void input_trace_glass(input_trace_t *trace);
+
+void input_trace_get_stats(input_trace_stats_t *stats);
+const char *input_trace_stage_name(int stage);
+void input_trace_print();
+void input_trace_reset();
+
+#endif // INPUT_TRACE_H
@@ -8,68 +8,162 @@
  */
 
 #include "config_manager.h"
+#include "boot_trace.h"
+#include "fs_layout.h"
+#include <esp_rom_crc.h>
+#include <algorithm>
+#include <set>
 
 // Global configuration manager instance
 ConfigManager* GlobalConfigManager = nullptr;
 
+// A schema key's value as its slot: converted to the key's type and clamped
+static ConfigSlot schema_slot(ConfigKeyId id, const ConfigValue& value) {
+    const ConfigSchemaEntry& e = config_schema[id];
+    ConfigSlot raw;
+    switch (e.kind) {
+        case CONFIG_SCHEMA_KIND_INTEGER: raw = ConfigSlot(value.asInteger()); break;
+        case CONFIG_SCHEMA_KIND_FLOAT:   raw = ConfigSlot(value.asFloat()); break;
+        default:                         return ConfigSlot(value.asBoolean());
+    }
+    ConfigSlot slot = config_schema_clamp(id, raw);
+    if (slot.i != raw.i) {
+        LOG_WARNF("ConfigManager", "%s.%s out of range, using %s", e.section, e.key,
+                  e.kind == CONFIG_SCHEMA_KIND_FLOAT ? String(slot.f).c_str() : String(slot.i).c_str());
+    }
+    return slot;
+}
+
+static ConfigValue schema_value(ConfigKeyId id, ConfigSlot slot) {
+    switch (config_schema[id].kind) {
+        case CONFIG_SCHEMA_KIND_INTEGER: return ConfigValue(slot.i);
+        case CONFIG_SCHEMA_KIND_FLOAT:   return ConfigValue(slot.f);
+        default:                         return ConfigValue(slot.b);
+    }
+}
+
 // ConfigValue implementation
-ConfigValue::ConfigValue() : type(ConfigValueType::STRING) {
-    string_value = "";
-    int_value = 0;
-    float_value = 0.0f;
-    bool_value = false;
+ConfigValue::ConfigValue() : type(ConfigValueType::STRING), heap(false) {
+    inline_str[0] = '\0';
+}
+
+ConfigValue::ConfigValue(const String& value) : type(ConfigValueType::STRING), heap(false) {
+    assignString(value.c_str(), value.length());
+}
+
+ConfigValue::ConfigValue(StrView value) : type(ConfigValueType::STRING), heap(false) {
+    assignString(value.c_str(), value.length());
+}
+
+ConfigValue::ConfigValue(const char* value) : type(ConfigValueType::STRING), heap(false) {
+    value = value ? value : "";
+    assignString(value, strlen(value));
+}
+
+ConfigValue::ConfigValue(const char* value, size_t length) : type(ConfigValueType::STRING), heap(false) {
+    assignString(value, length);
+}
+
+ConfigValue::ConfigValue(int32_t value) : type(ConfigValueType::INTEGER), heap(false) {
+    int_value = value;
+}
+
+ConfigValue::ConfigValue(float value) : type(ConfigValueType::FLOAT), heap(false) {
+    float_value = value;
+}
+
+ConfigValue::ConfigValue(bool value) : type(ConfigValueType::BOOLEAN), heap(false) {
+    bool_value = value;
+}
+
+ConfigValue::ConfigValue(const JsonObject& value) : type(ConfigValueType::JSON_OBJECT), heap(false) {
+    new (&json_ref) JsonVariant(value);
+}
+
+ConfigValue::ConfigValue(const JsonArray& value) : type(ConfigValueType::JSON_ARRAY), heap(false) {
+    new (&json_ref) JsonVariant(value);
+}
+
+ConfigValue::ConfigValue(const ConfigValue& other) {
+    copyFrom(other);
 }
 
-ConfigValue::ConfigValue(const String& value) : type(ConfigValueType::STRING), string_value(value) {
-    int_value = 0;
-    float_value = 0.0f;
-    bool_value = false;
+ConfigValue::ConfigValue(ConfigValue&& other) noexcept : type(other.type), heap(other.heap) {
+    memcpy(inline_str, other.inline_str, sizeof(inline_str));
+    
+    // The heap string changes hands; leave the source an empty string
+    other.type = ConfigValueType::STRING;
+    other.heap = false;
+    other.inline_str[0] = '\0';
 }
 
-ConfigValue::ConfigValue(const char* value) : type(ConfigValueType::STRING), string_value(String(value)) {
-    int_value = 0;
-    float_value = 0.0f;
-    bool_value = false;
+ConfigValue::~ConfigValue() {
+    release();
 }
 
-ConfigValue::ConfigValue(int32_t value) : type(ConfigValueType::INTEGER), int_value(value) {
-    string_value = String(value);
-    float_value = static_cast<float>(value);
-    bool_value = (value != 0);
+ConfigValue& ConfigValue::operator=(const ConfigValue& other) {
+    if (this != &other) {
+        release();
+        copyFrom(other);
+    }
+    return *this;
 }
 
-ConfigValue::ConfigValue(float value) : type(ConfigValueType::FLOAT), float_value(value) {
-    string_value = String(value);
-    int_value = static_cast<int32_t>(value);
-    bool_value = (value != 0.0f);
+ConfigValue& ConfigValue::operator=(ConfigValue&& other) noexcept {
+    if (this != &other) {
+        release();
+        type = other.type;
+        heap = other.heap;
+        memcpy(inline_str, other.inline_str, sizeof(inline_str));
+        other.type = ConfigValueType::STRING;
+        other.heap = false;
+        other.inline_str[0] = '\0';
+    }
+    return *this;
 }
 
-ConfigValue::ConfigValue(bool value) : type(ConfigValueType::BOOLEAN), bool_value(value) {
-    string_value = value ? "true" : "false";
-    int_value = value ? 1 : 0;
-    float_value = value ? 1.0f : 0.0f;
+void ConfigValue::assignString(const char* value, size_t length) {
+    if (length < CONFIG_VALUE_INLINE_SIZE) {
+        memcpy(inline_str, value, length);
+        inline_str[length] = '\0';
+        heap = false;
+        return;
+    }
+    
+    heap_str = (char*)malloc(length + 1);
+    if (!heap_str) {
+        inline_str[0] = '\0';
+        heap = false;
+        return;
+    }
+    memcpy(heap_str, value, length);
+    heap_str[length] = '\0';
+    heap = true;
 }
 
-ConfigValue::ConfigValue(const JsonObject& value) : type(ConfigValueType::JSON_OBJECT) {
-    json_value.set(value);
-    string_value = "";
-    int_value = 0;
-    float_value = 0.0f;
-    bool_value = false;
+void ConfigValue::copyFrom(const ConfigValue& other) {
+    type = other.type;
+    heap = false;
+    if (other.type == ConfigValueType::STRING && other.heap) {
+        assignString(other.heap_str, strlen(other.heap_str));
+    } else if (other.isJsonObject() || other.isJsonArray()) {
+        new (&json_ref) JsonVariant(other.json_ref);
+    } else {
+        memcpy(inline_str, other.inline_str, sizeof(inline_str));
+    }
 }
 
-ConfigValue::ConfigValue(const JsonArray& value) : type(ConfigValueType::JSON_ARRAY) {
-    json_value.set(value);
-    string_value = "";
-    int_value = 0;
-    float_value = 0.0f;
-    bool_value = false;
+void ConfigValue::release() {
+    if (type == ConfigValueType::STRING && heap) {
+        free(heap_str);
+    }
+    heap = false;
 }
 
 String ConfigValue::asString() const {
     switch (type) {
         case ConfigValueType::STRING:
-            return string_value;
+            return String(heap ? heap_str : inline_str);
         case ConfigValueType::INTEGER:
             return String(int_value);
         case ConfigValueType::FLOAT:
@@ -79,12 +173,19 @@ String ConfigValue::asString() const {
         case ConfigValueType::JSON_OBJECT:
         case ConfigValueType::JSON_ARRAY:
             String result;
-            serializeJson(json_value, result);
+            serializeJson(json_ref, result);
             return result;
     }
     return "";
 }
 
+const char* ConfigValue::asCString() const {
+    if (type != ConfigValueType::STRING) {
+        return nullptr;
+    }
+    return heap ? heap_str : inline_str;
+}
+
 int32_t ConfigValue::asInteger() const {
     switch (type) {
         case ConfigValueType::INTEGER:
@@ -94,7 +195,7 @@ int32_t ConfigValue::asInteger() const {
         case ConfigValueType::BOOLEAN:
             return bool_value ? 1 : 0;
         case ConfigValueType::STRING:
-            return string_value.toInt();
+            return atoi(heap ? heap_str : inline_str);
         default:
             return 0;
     }
@@ -109,7 +210,7 @@ float ConfigValue::asFloat() const {
         case ConfigValueType::BOOLEAN:
             return bool_value ? 1.0f : 0.0f;
         case ConfigValueType::STRING:
-            return string_value.toFloat();
+            return atof(heap ? heap_str : inline_str);
         default:
             return 0.0f;
     }
@@ -123,25 +224,40 @@ bool ConfigValue::asBoolean() const {
             return int_value != 0;
         case ConfigValueType::FLOAT:
             return float_value != 0.0f;
-        case ConfigValueType::STRING:
-            return string_value.equalsIgnoreCase("true") || string_value == "1";
+        case ConfigValueType::STRING: {
+            const char* text = heap ? heap_str : inline_str;
+            return strcasecmp(text, "true") == 0 || strcmp(text, "1") == 0;
+        }
         default:
             return false;
     }
 }
 
 JsonObject ConfigValue::asJsonObject() const {
-    // TODO: Implement proper JsonObject support for ArduinoJson v7
-    // For now, create a minimal empty object
-    JsonDocument doc;
-    return doc.to<JsonObject>();
+    // Valid while the section (or document) the value came from is unchanged
+    return type == ConfigValueType::JSON_OBJECT ? json_ref.as<JsonObject>() : JsonObject();
 }
 
 JsonArray ConfigValue::asJsonArray() const {
-    // TODO: Implement proper JsonArray support for ArduinoJson v7
-    // For now, create a minimal empty array
-    JsonDocument doc;
-    return doc.to<JsonArray>();
+    return type == ConfigValueType::JSON_ARRAY ? json_ref.as<JsonArray>() : JsonArray();
+}
+
+bool ConfigValue::equals(const ConfigValue& other) const {
+    if (type != other.type) {
+        return false;
+    }
+    switch (type) {
+        case ConfigValueType::INTEGER:
+            return int_value == other.int_value;
+        case ConfigValueType::FLOAT:
+            return float_value == other.float_value;
+        case ConfigValueType::BOOLEAN:
+            return bool_value == other.bool_value;
+        case ConfigValueType::STRING:
+            return strcmp(heap ? heap_str : inline_str, other.heap ? other.heap_str : other.inline_str) == 0;
+        default:
+            return asString() == other.asString();
+    }
 }
 
 String ConfigValue::toString() const {
@@ -159,26 +275,64 @@ String ConfigValue::toString() const {
 }
 
 // ConfigSection implementation
-ConfigSection::ConfigSection(const String& name) : section_name(name), modified(false) {
+ConfigSection::ConfigSection(StrView name) : section_name(internKey(name.c_str())), modified(false) {
+}
+
+const char* ConfigSection::internKey(const char* key) {
+    // The same few dozen key names repeat across sections and are never freed
+    static std::set<const char*, ConfigKeyLess> keys;
+    
+    auto it = keys.find(key);
+    if (it != keys.end()) {
+        return *it;
+    }
+    
+    char* copy = strdup(key);
+    if (!copy) {
+        return "";
+    }
+    keys.insert(copy);
+    return copy;
+}
+
+const ConfigValue* ConfigSection::findValue(StrView key) const {
+    auto it = values.find(key.c_str());
+    return it != values.end() ? &it->second : nullptr;
 }
 
-void ConfigSection::setValue(const String& key, const ConfigValue& value) {
-    values[key] = value;
+void ConfigSection::setValue(StrView key, const ConfigValue& value) {
+    const char* name = internKey(key.c_str());
+    dirty_keys.insert(name);
+    
+    if (value.isJsonObject() || value.isJsonArray()) {
+        // Copied into the arena so the value outlives the caller's document
+        JsonVariant slot = json_arena[name];
+        slot.set(value.json_ref);
+        ConfigValue& stored = values[name];
+        stored.release();
+        stored.type = value.type;
+        new (&stored.json_ref) JsonVariant(slot);  // Rebind; operator= would write through
+    } else {
+        json_arena.remove(name);
+        values[name] = value;
+    }
     modified = true;
 }
 
-ConfigValue ConfigSection::getValue(const String& key, const ConfigValue& default_value) const {
-    auto it = values.find(key);
-    return it != values.end() ? it->second : default_value;
+ConfigValue ConfigSection::getValue(StrView key, const ConfigValue& default_value) const {
+    const ConfigValue* value = findValue(key);
+    return value ? *value : default_value;
 }
 
-bool ConfigSection::hasValue(const String& key) const {
-    return values.find(key) != values.end();
+bool ConfigSection::hasValue(StrView key) const {
+    return findValue(key) != nullptr;
 }
 
-bool ConfigSection::removeValue(const String& key) {
-    auto it = values.find(key);
+bool ConfigSection::removeValue(StrView key) {
+    auto it = values.find(key.c_str());
     if (it != values.end()) {
+        json_arena.remove(it->first);
+        dirty_keys.insert(it->first);
         values.erase(it);
         modified = true;
         return true;
@@ -188,45 +342,54 @@ bool ConfigSection::removeValue(const String& key) {
 
 void ConfigSection::clear() {
     if (!values.empty()) {
+        for (const auto& pair : values) {
+            dirty_keys.insert(pair.first);
+        }
         values.clear();
+        json_arena.clear();
         modified = true;
     }
 }
 
-void ConfigSection::setString(const String& key, const String& value) {
+void ConfigSection::setString(StrView key, StrView value) {
     setValue(key, ConfigValue(value));
 }
 
-void ConfigSection::setInteger(const String& key, int32_t value) {
+void ConfigSection::setInteger(StrView key, int32_t value) {
     setValue(key, ConfigValue(value));
 }
 
-void ConfigSection::setFloat(const String& key, float value) {
+void ConfigSection::setFloat(StrView key, float value) {
     setValue(key, ConfigValue(value));
 }
 
-void ConfigSection::setBoolean(const String& key, bool value) {
+void ConfigSection::setBoolean(StrView key, bool value) {
     setValue(key, ConfigValue(value));
 }
 
-String ConfigSection::getString(const String& key, const String& default_value) const {
-    return getValue(key, ConfigValue(default_value)).asString();
+// Getters read in place rather than copying the value out
+String ConfigSection::getString(StrView key, const String& default_value) const {
+    const ConfigValue* value = findValue(key);
+    return value ? value->asString() : default_value;
 }
 
-int32_t ConfigSection::getInteger(const String& key, int32_t default_value) const {
-    return getValue(key, ConfigValue(default_value)).asInteger();
+int32_t ConfigSection::getInteger(StrView key, int32_t default_value) const {
+    const ConfigValue* value = findValue(key);
+    return value ? value->asInteger() : default_value;
 }
 
-float ConfigSection::getFloat(const String& key, float default_value) const {
-    return getValue(key, ConfigValue(default_value)).asFloat();
+float ConfigSection::getFloat(StrView key, float default_value) const {
+    const ConfigValue* value = findValue(key);
+    return value ? value->asFloat() : default_value;
 }
 
-bool ConfigSection::getBoolean(const String& key, bool default_value) const {
-    return getValue(key, ConfigValue(default_value)).asBoolean();
+bool ConfigSection::getBoolean(StrView key, bool default_value) const {
+    const ConfigValue* value = findValue(key);
+    return value ? value->asBoolean() : default_value;
 }
 
-std::vector<String> ConfigSection::getKeys() const {
-    std::vector<String> keys;
+std::vector<const char*> ConfigSection::getKeys() const {
+    std::vector<const char*> keys;
     for (const auto& pair : values) {
         keys.push_back(pair.first);
     }
@@ -235,7 +398,7 @@ std::vector<String> ConfigSection::getKeys() const {
 
 bool ConfigSection::toJson(JsonObject& obj) const {
     for (const auto& pair : values) {
-        const String& key = pair.first;
+        const char* key = pair.first;
         const ConfigValue& value = pair.second;
         
         switch (value.getType()) {
@@ -264,13 +427,14 @@ bool ConfigSection::toJson(JsonObject& obj) const {
 
 bool ConfigSection::fromJson(const JsonObject& obj) {
     values.clear();
+    json_arena.clear();
     
     for (JsonPair pair : obj) {
-        String key = pair.key().c_str();
+        const char* key = pair.key().c_str();
         JsonVariant value = pair.value();
         
-        if (value.is<String>()) {
-            setValue(key, ConfigValue(value.as<String>()));
+        if (value.is<const char*>()) {
+            setValue(key, ConfigValue(value.as<const char*>()));
         } else if (value.is<int>()) {
             setValue(key, ConfigValue(value.as<int32_t>()));
         } else if (value.is<float>()) {
@@ -291,7 +455,9 @@ bool ConfigSection::fromJson(const JsonObject& obj) {
 // ConfigManager implementation
 ConfigManager::ConfigManager(ConfigStorage backend)
     : storage_backend(backend), auto_save_enabled(true), auto_save_interval_ms(30000),
-      last_save_time(0), initialized(false), config_loaded(false), file_system(nullptr) {
+      last_save_time(0), initialized(false), config_loaded(false), loaded_from_snapshot(false),
+      journal_size(0), hot_dirty_time(0), batch_start_time(0), batch_last_time(0), batch_sequence(0),
+      next_watch_id(1), file_system(nullptr) {
 
     config_file_path = getDefaultConfigPath();
     // Don't log during static initialization - logger may not be ready
@@ -322,10 +488,14 @@ bool ConfigManager::initialize() {
     }
 
     // Load configuration
-    if (!loadConfig()) {
+    if (!loadConfig() && !migrateConfig()) {
         LOG_WARN("ConfigManager", "Failed to load configuration, creating default");
         createDefaultConfig();
     }
+    
+    // After the file, so values still stored there can migrate to NVS
+    registerDefaultHotKeys();
+    syncSchema();
 
     initialized = true;
     LOG_INFO("ConfigManager", "Configuration manager initialized successfully");
@@ -339,10 +509,14 @@ void ConfigManager::shutdown() {
 
     LOG_INFO("ConfigManager", "Shutting down configuration manager...");
 
-    // Save configuration if auto-save is enabled
+    // Save configuration if auto-save is enabled; this also folds in the journal
     if (auto_save_enabled) {
         saveConfig();
     }
+    flushHotKeys();
+    hot_keys.clear();
+    flushChanges();
+    watches.clear();
 
     // Clear all sections
     sections.clear();
@@ -360,20 +534,18 @@ void ConfigManager::shutdown() {
 
 bool ConfigManager::initializeFileSystem() {
     switch (storage_backend) {
-        case ConfigStorage::LITTLEFS:
-            if (!LittleFS.begin()) {
-                LOG_WARN("ConfigManager", "LittleFS mount failed, attempting to format...");
-                if (!LittleFS.begin(true)) {  // true = format if mount fails
-                    LOG_ERROR("ConfigManager", "Failed to initialize and format LittleFS");
-                    return false;
-                }
-                LOG_INFO("ConfigManager", "LittleFS formatted and initialized successfully");
-            } else {
-                LOG_INFO("ConfigManager", "LittleFS mounted successfully");
+        case ConfigStorage::LITTLEFS: {
+            BOOT_TRACE_SCOPE("LittleFS");
+            // Both volumes, formatting either if it will not mount
+            if (!fs_layout_begin()) {
+                LOG_ERROR("ConfigManager", "Failed to initialize and format LittleFS");
+                return false;
             }
-            file_system = &LittleFS;
-            LOG_INFO("ConfigManager", "LittleFS initialized for configuration storage");
+            file_system = fs_for(FS_WL_CONFIG);
+            LOG_INFOF("ConfigManager", "LittleFS %s volume initialized for configuration storage",
+                      fs_volume_of(FS_WL_CONFIG) == FS_VOL_HOT ? "hot" : "bulk");
             break;
+        }
 
         case ConfigStorage::SD_CARD:
             if (!SD.begin()) {
@@ -384,6 +556,11 @@ bool ConfigManager::initializeFileSystem() {
             LOG_INFO("ConfigManager", "SD card initialized for configuration storage");
             break;
 
+        case ConfigStorage::NVS:
+            // Key/value only; structured config needs a file system
+            LOG_ERROR("ConfigManager", "NVS holds hot keys only, not the configuration file");
+            return false;
+
         case ConfigStorage::EEPROM:
             // EEPROM initialization would go here
             LOG_WARN("ConfigManager", "EEPROM storage not yet implemented");
@@ -405,6 +582,16 @@ bool ConfigManager::loadConfig() {
         return false;
     }
 
+    // The snapshot is trusted only while the JSON it was compiled from is unchanged
+    if (loadSnapshot()) {
+        config_loaded = true;
+        loaded_from_snapshot = true;
+        LOG_INFOF("ConfigManager", "Configuration loaded from snapshot (%d sections)", sections.size());
+        replayJournal();
+        syncSchema();
+        return true;
+    }
+
     String config_content = readFile(config_file_path);
     if (config_content.isEmpty()) {
         LOG_ERROR("ConfigManager", "Failed to read configuration file");
@@ -429,7 +616,7 @@ bool ConfigManager::loadConfig() {
     }
     JsonObject root = doc.as<JsonObject>();
     for (JsonPair section_pair : root) {
-        String section_name = section_pair.key().c_str();
+        const char* section_name = section_pair.key().c_str();
         JsonObject section_obj = section_pair.value().as<JsonObject>();
 
         auto section = createSection(section_name);
@@ -439,7 +626,13 @@ bool ConfigManager::loadConfig() {
     }
 
     config_loaded = true;
+    loaded_from_snapshot = false;
     LOG_INFOF("ConfigManager", "Configuration loaded successfully (%d sections)", sections.size());
+
+    // Next boot can skip the parse
+    writeSnapshot();
+    replayJournal();
+    syncSchema();
     return true;
 }
 
@@ -456,7 +649,7 @@ bool ConfigManager::saveConfig() {
 
     // Serialize all sections
     for (const auto& pair : sections) {
-        const String& section_name = pair.first;
+        const char* section_name = pair.first;
         const auto& section = pair.second;
 
         JsonObject section_obj = root[section_name].to<JsonObject>();
@@ -475,17 +668,298 @@ bool ConfigManager::saveConfig() {
         return false;
     }
 
+    if (!writeSnapshot()) {
+        LOG_WARN("ConfigManager", "Failed to write configuration snapshot");
+    }
+    
+    // Everything the journal held is in the JSON now
+    if (journal_size > 0 || fileExists(getSidecarPath(CONFIG_JOURNAL_EXT))) {
+        file_system->remove(getSidecarPath(CONFIG_JOURNAL_EXT));
+        journal_size = 0;
+    }
+
     last_save_time = millis();
     LOG_INFO("ConfigManager", "Configuration saved successfully");
     return true;
 }
 
+bool ConfigManager::migrateConfig() {
+    // Only a LittleFS config moved onto the hot volume has an older home
+    fs::FS* hot = file_system;
+    fs::FS* bulk = fs_volume(FS_VOL_BULK);
+    if (storage_backend != ConfigStorage::LITTLEFS || !hot || !bulk || hot == bulk) {
+        return false;
+    }
+    file_system = bulk;
+    bool loaded = loadConfig();
+    file_system = hot;
+    if (!loaded) {
+        return false;
+    }
+    
+    // The journal was replayed on load and the save folds it in
+    if (!saveConfig()) {
+        LOG_WARN("ConfigManager", "Configuration loaded from the bulk volume but not moved");
+        return true;
+    }
+    bulk->remove(config_file_path);
+    bulk->remove(getSnapshotPath());
+    bulk->remove(getSidecarPath(CONFIG_JOURNAL_EXT));
+    LOG_INFOF("ConfigManager", "Configuration moved to the hot volume: %s", config_file_path.c_str());
+    return true;
+}
+
+String ConfigManager::getSidecarPath(const char* ext) const {
+    int dot = config_file_path.lastIndexOf('.');
+    int slash = config_file_path.lastIndexOf('/');
+    String base = (dot > slash) ? config_file_path.substring(0, dot) : config_file_path;
+    return base + ext;
+}
+
+String ConfigManager::getSnapshotPath() const {
+    return getSidecarPath(CONFIG_SNAPSHOT_EXT);
+}
+
+bool ConfigManager::getFileStamp(const String& path, uint32_t& size, uint32_t& mtime) const {
+    if (!file_system) {
+        return false;
+    }
+
+    File file = file_system->open(path, "r");
+    if (!file) {
+        return false;
+    }
+
+    size = file.size();
+    mtime = (uint32_t)file.getLastWrite();
+    file.close();
+    return true;
+}
+
+bool ConfigManager::writeSnapshot() {
+    ConfigSnapshotHeader header;
+    if (!getFileStamp(config_file_path, header.json_size, header.json_mtime)) {
+        return false;
+    }
+
+    // Both maps are ordered by name, so entries come out sorted
+    std::vector<ConfigSnapshotEntry> entries;
+    std::vector<uint8_t> blob;
+    auto appendText = [&blob](StrView text) -> uint32_t {
+        uint32_t offset = blob.size();
+        blob.insert(blob.end(), text.c_str(), text.c_str() + text.length() + 1);
+        return offset;
+    };
+
+    for (const auto& pair : sections) {
+        const auto& section = pair.second;
+        for (const char* key : section->getKeys()) {
+            ConfigValue value = section->getValue(key);
+            ConfigSnapshotEntry entry = {};
+            entry.key_offset = appendText(pair.first);
+            appendText(key);
+            entry.type = static_cast<uint8_t>(value.getType());
+
+            switch (value.getType()) {
+                case ConfigValueType::INTEGER:
+                    entry.value = (uint32_t)value.asInteger();
+                    break;
+                case ConfigValueType::BOOLEAN:
+                    entry.value = value.asBoolean() ? 1 : 0;
+                    break;
+                case ConfigValueType::FLOAT: {
+                    float f = value.asFloat();
+                    memcpy(&entry.value, &f, sizeof(f));
+                    break;
+                }
+                default:
+                    // Strings, and objects/arrays as their JSON text
+                    entry.value = appendText(value.asString());
+                    break;
+            }
+            entries.push_back(entry);
+        }
+    }
+    if (entries.size() > UINT16_MAX) {
+        return false;
+    }
+
+    header.magic = CONFIG_SNAPSHOT_MAGIC;
+    header.version = CONFIG_SNAPSHOT_VERSION;
+    header.entry_count = entries.size();
+    header.blob_size = blob.size();
+    header.crc = esp_rom_crc32_le(0, (const uint8_t*)entries.data(), entries.size() * sizeof(ConfigSnapshotEntry));
+    header.crc = esp_rom_crc32_le(header.crc, blob.data(), blob.size());
+
+    // Written aside and renamed, so a torn write never looks like a snapshot
+    String path = getSnapshotPath();
+    String temp_path = path + ".tmp";
+    File file = file_system->open(temp_path, "w");
+    if (!file) {
+        return false;
+    }
+
+    size_t expected = sizeof(header) + entries.size() * sizeof(ConfigSnapshotEntry) + blob.size();
+    size_t written = file.write((const uint8_t*)&header, sizeof(header));
+    written += file.write((const uint8_t*)entries.data(), entries.size() * sizeof(ConfigSnapshotEntry));
+    written += file.write(blob.data(), blob.size());
+    file.close();
+
+    if (written != expected) {
+        file_system->remove(temp_path);
+        return false;
+    }
+    if (file_system->exists(path)) {
+        file_system->remove(path);
+    }
+    return file_system->rename(temp_path, path);
+}
+
+bool ConfigManager::loadSnapshot() {
+    String path = getSnapshotPath();
+    uint32_t json_size, json_mtime;
+    if (!fileExists(path) || !getFileStamp(config_file_path, json_size, json_mtime)) {
+        return false;
+    }
+
+    // One read of the whole file, then everything is parsed in place
+    File file = file_system->open(path, "r");
+    if (!file) {
+        return false;
+    }
+    size_t size = file.size();
+    if (size < sizeof(ConfigSnapshotHeader)) {
+        file.close();
+        return false;
+    }
+    uint8_t* data = (uint8_t*)ps_malloc(size);
+    if (!data) {
+        data = (uint8_t*)malloc(size);
+    }
+    bool read_ok = data && file.read(data, size) == size;
+    file.close();
+    if (!read_ok) {
+        free(data);
+        return false;
+    }
+
+    ConfigSnapshotHeader header;
+    memcpy(&header, data, sizeof(header));
+    size_t table_size = header.entry_count * sizeof(ConfigSnapshotEntry);
+    const uint8_t* table = data + sizeof(header);
+    const char* blob = (const char*)table + table_size;
+
+    bool valid = header.magic == CONFIG_SNAPSHOT_MAGIC && header.version == CONFIG_SNAPSHOT_VERSION &&
+                 header.json_size == json_size && header.json_mtime == json_mtime &&
+                 sizeof(header) + table_size + header.blob_size == size &&
+                 (header.blob_size == 0 || blob[header.blob_size - 1] == 0);
+    if (valid) {
+        uint32_t crc = esp_rom_crc32_le(0, table, table_size);
+        valid = esp_rom_crc32_le(crc, (const uint8_t*)blob, header.blob_size) == header.crc;
+    }
+    if (!valid) {
+        LOG_INFO("ConfigManager", "Configuration snapshot is stale or corrupt, parsing JSON");
+        free(data);
+        return false;
+    }
+
+    sections.clear();
+    std::shared_ptr<ConfigSection> section;
+    for (uint16_t i = 0; i < header.entry_count && valid; i++) {
+        ConfigSnapshotEntry entry;
+        memcpy(&entry, table + i * sizeof(entry), sizeof(entry));
+
+        // The blob ends in a NUL, so each name is bounded once its start is
+        if (entry.key_offset >= header.blob_size) {
+            valid = false;
+            break;
+        }
+        const char* section_name = blob + entry.key_offset;
+        size_t key_offset = entry.key_offset + strlen(section_name) + 1;
+        if (key_offset >= header.blob_size) {
+            valid = false;
+            break;
+        }
+        const char* key = blob + key_offset;
+
+        if (!section || strcmp(section->getName(), section_name) != 0) {
+            section = createSection(section_name);
+        }
+
+        ConfigValueType type = static_cast<ConfigValueType>(entry.type);
+        bool is_text = type == ConfigValueType::STRING || type == ConfigValueType::JSON_OBJECT ||
+                       type == ConfigValueType::JSON_ARRAY;
+        if (is_text && entry.value >= header.blob_size) {
+            valid = false;
+            break;
+        }
+
+        switch (type) {
+            case ConfigValueType::STRING:
+                section->setValue(key, ConfigValue(blob + entry.value));
+                break;
+            case ConfigValueType::INTEGER:
+                section->setValue(key, ConfigValue((int32_t)entry.value));
+                break;
+            case ConfigValueType::FLOAT: {
+                float f;
+                memcpy(&f, &entry.value, sizeof(f));
+                section->setValue(key, ConfigValue(f));
+                break;
+            }
+            case ConfigValueType::BOOLEAN:
+                section->setValue(key, ConfigValue(entry.value != 0));
+                break;
+            case ConfigValueType::JSON_OBJECT:
+            case ConfigValueType::JSON_ARRAY: {
+                JsonDocument doc;
+                deserializeJson(doc, blob + entry.value);
+                if (type == ConfigValueType::JSON_OBJECT) {
+                    section->setValue(key, ConfigValue(doc.as<JsonObject>()));
+                } else {
+                    section->setValue(key, ConfigValue(doc.as<JsonArray>()));
+                }
+                break;
+            }
+            default:
+                valid = false;
+                break;
+        }
+    }
+    free(data);
+
+    if (!valid) {
+        LOG_WARN("ConfigManager", "Configuration snapshot entry out of range, parsing JSON");
+        sections.clear();
+        return false;
+    }
+
+    for (auto& pair : sections) {
+        pair.second->setModified(false);
+    }
+    return true;
+}
+
 void ConfigManager::update() {
-    if (!initialized || !auto_save_enabled) {
+    if (!initialized) {
         return;
     }
-
+    
+    // The NVS tier is write-through; coalescing only delays the commit
     uint32_t current_time = millis();
+    if (!pending_changes.empty() && (current_time - batch_last_time >= CONFIG_WATCH_DEBOUNCE_MS ||
+                                     current_time - batch_start_time >= CONFIG_WATCH_MAX_DELAY_MS)) {
+        flushChanges();
+    }
+
+    if (hot_dirty_time && current_time - hot_dirty_time >= CONFIG_NVS_COALESCE_MS) {
+        flushHotKeys();
+    }
+    
+    if (!auto_save_enabled) {
+        return;
+    }
+
     if (current_time - last_save_time >= auto_save_interval_ms) {
         // Check if any section has been modified
         bool needs_save = false;
@@ -496,25 +970,245 @@ void ConfigManager::update() {
             }
         }
 
+        // A few-byte append per change; the full rewrite waits for compaction
         if (needs_save) {
-            saveConfig();
+            if (!appendJournal()) {
+                saveConfig();
+            } else if (journal_size >= CONFIG_JOURNAL_COMPACT_SIZE) {
+                LOG_INFOF("ConfigManager", "Compacting %lu byte journal", journal_size);
+                saveConfig();
+            }
+            last_save_time = current_time;
+        }
+    }
+}
+
+bool ConfigManager::encodeJournalRecord(std::vector<uint8_t>& out, const ConfigSection& section, const char* key) const {
+    std::vector<uint8_t> record;
+    uint8_t type = CONFIG_JOURNAL_REMOVED;
+    record.push_back(0);
+    record.push_back(0);
+    record.insert(record.end(), section.getName(), section.getName() + strlen(section.getName()) + 1);
+    record.insert(record.end(), key, key + strlen(key) + 1);
+    
+    if (section.hasValue(key)) {
+        ConfigValue value = section.getValue(key);
+        type = static_cast<uint8_t>(value.getType());
+        
+        uint32_t bits = 0;
+        String text;
+        switch (value.getType()) {
+            case ConfigValueType::INTEGER:
+                bits = (uint32_t)value.asInteger();
+                break;
+            case ConfigValueType::BOOLEAN:
+                bits = value.asBoolean() ? 1 : 0;
+                break;
+            case ConfigValueType::FLOAT: {
+                float f = value.asFloat();
+                memcpy(&bits, &f, sizeof(bits));
+                break;
+            }
+            default:
+                text = value.asString();
+                break;
+        }
+        
+        if (value.isString() || value.isJsonObject() || value.isJsonArray()) {
+            record.insert(record.end(), text.c_str(), text.c_str() + text.length());
+        } else {
+            const uint8_t* p = (const uint8_t*)&bits;
+            record.insert(record.end(), p, p + sizeof(bits));
+        }
+    }
+    
+    // Long values do not fit a record; the caller falls back to a full save
+    size_t payload = record.size() - 2;
+    if (payload > UINT8_MAX) {
+        return false;
+    }
+    record[0] = (uint8_t)payload;
+    record[1] = type;
+    record.push_back(esp_rom_crc8_le(0, record.data() + 1, payload + 1));
+    out.insert(out.end(), record.begin(), record.end());
+    return true;
+}
+
+bool ConfigManager::appendJournal() {
+    if (!file_system || !fileExists(config_file_path)) {
+        return false;
+    }
+    
+    String path = getSidecarPath(CONFIG_JOURNAL_EXT);
+    bool fresh = journal_size == 0;
+    std::vector<uint8_t> out;
+    
+    // A new journal is tied to the JSON it extends, so it is never replayed over a newer one
+    if (fresh) {
+        ConfigJournalHeader header;
+        header.magic = CONFIG_JOURNAL_MAGIC;
+        if (!getFileStamp(config_file_path, header.json_size, header.json_mtime)) {
+            return false;
+        }
+        const uint8_t* p = (const uint8_t*)&header;
+        out.insert(out.end(), p, p + sizeof(header));
+    }
+    
+    for (const auto& pair : sections) {
+        const auto& section = pair.second;
+        for (const char* key : section->getDirtyKeys()) {
+            if (!encodeJournalRecord(out, *section, key)) {
+                return false;
+            }
+        }
+    }
+    
+    File file = file_system->open(path, fresh ? "w" : "a");
+    if (!file) {
+        return false;
+    }
+    size_t written = file.write(out.data(), out.size());
+    file.close();
+    if (written != out.size()) {
+        // Part of a record may have landed; only a full save makes the journal trustworthy again
+        return false;
+    }
+    
+    journal_size += out.size();
+    for (const auto& pair : sections) {
+        pair.second->setModified(false);
+    }
+    return true;
+}
+
+bool ConfigManager::replayJournal() {
+    String path = getSidecarPath(CONFIG_JOURNAL_EXT);
+    journal_size = 0;
+    if (!fileExists(path)) {
+        return true;
+    }
+    
+    File file = file_system->open(path, "r");
+    if (!file) {
+        return false;
+    }
+    size_t size = file.size();
+    std::vector<uint8_t> data(size);
+    bool read_ok = file.read(data.data(), size) == size;
+    file.close();
+    
+    ConfigJournalHeader header;
+    uint32_t json_size, json_mtime;
+    bool valid = read_ok && size >= sizeof(header) && getFileStamp(config_file_path, json_size, json_mtime);
+    if (valid) {
+        memcpy(&header, data.data(), sizeof(header));
+        valid = header.magic == CONFIG_JOURNAL_MAGIC && header.json_size == json_size && header.json_mtime == json_mtime;
+    }
+    if (!valid) {
+        // Left over from before the last full save, or unreadable
+        LOG_INFO("ConfigManager", "Discarding stale configuration journal");
+        file_system->remove(path);
+        return false;
+    }
+    
+    size_t pos = sizeof(header);
+    uint32_t records = 0;
+    while (pos + 3 <= size) {
+        uint8_t payload = data[pos];
+        uint8_t type = data[pos + 1];
+        if (pos + 3 + payload > size || esp_rom_crc8_le(0, &data[pos + 1], payload + 1) != data[pos + 2 + payload]) {
+            break;
+        }
+        
+        const char* section_name = (const char*)&data[pos + 2];
+        const char* end = section_name + payload;
+        const char* key = (const char*)memchr(section_name, '\0', payload);
+        key = key ? key + 1 : end;
+        const char* value = key < end ? (const char*)memchr(key, '\0', end - key) : nullptr;
+        if (!value) {
+            break;
+        }
+        value++;
+        size_t value_len = end - value;
+        
+        auto section = getSection(section_name);
+        if (type == CONFIG_JOURNAL_REMOVED) {
+            if (section) {
+                section->removeValue(key);
+            }
+        } else {
+            if (!section) {
+                section = createSection(section_name);
+            }
+            uint32_t bits = 0;
+            if (value_len == sizeof(bits)) {
+                memcpy(&bits, value, sizeof(bits));
+            }
+            
+            switch (static_cast<ConfigValueType>(type)) {
+                case ConfigValueType::INTEGER:
+                    section->setValue(key, ConfigValue((int32_t)bits));
+                    break;
+                case ConfigValueType::BOOLEAN:
+                    section->setValue(key, ConfigValue(bits != 0));
+                    break;
+                case ConfigValueType::FLOAT: {
+                    float f;
+                    memcpy(&f, &bits, sizeof(f));
+                    section->setValue(key, ConfigValue(f));
+                    break;
+                }
+                case ConfigValueType::STRING:
+                    section->setValue(key, ConfigValue(value, value_len));
+                    break;
+                case ConfigValueType::JSON_OBJECT:
+                case ConfigValueType::JSON_ARRAY: {
+                    JsonDocument doc;
+                    deserializeJson(doc, value, value_len);
+                    if (type == static_cast<uint8_t>(ConfigValueType::JSON_OBJECT)) {
+                        section->setValue(key, ConfigValue(doc.as<JsonObject>()));
+                    } else {
+                        section->setValue(key, ConfigValue(doc.as<JsonArray>()));
+                    }
+                    break;
+                }
+            }
         }
+        pos += 3 + payload;
+        records++;
+    }
+    
+    for (auto& pair : sections) {
+        pair.second->setModified(false);
     }
+    journal_size = pos;
+    
+    // A torn tail would hide everything appended after it: fold the journal in now
+    if (pos != size) {
+        LOG_WARNF("ConfigManager", "Configuration journal truncated at %u of %u bytes", pos, size);
+        saveConfig();
+        return false;
+    }
+    
+    if (records > 0) {
+        LOG_INFOF("ConfigManager", "Replayed %lu configuration journal records", records);
+    }
+    return true;
 }
 
-std::shared_ptr<ConfigSection> ConfigManager::getSection(const String& section_name) {
-    auto it = sections.find(section_name);
+std::shared_ptr<ConfigSection> ConfigManager::getSection(StrView section_name) {
+    auto it = sections.find(section_name.c_str());
     return it != sections.end() ? it->second : nullptr;
 }
 
-std::shared_ptr<ConfigSection> ConfigManager::createSection(const String& section_name) {
+std::shared_ptr<ConfigSection> ConfigManager::createSection(StrView section_name) {
     auto section = std::make_shared<ConfigSection>(section_name);
-    sections[section_name] = section;
+    sections[section->getName()] = section;
     return section;
 }
 
-bool ConfigManager::hasSection(const String& section_name) const {
-    return sections.find(section_name) != sections.end();
+bool ConfigManager::hasSection(StrView section_name) const {
+    return sections.find(section_name.c_str()) != sections.end();
 }
 
 String ConfigManager::getDefaultConfigPath() const {
@@ -588,52 +1282,332 @@ bool ConfigManager::writeFile(const String& path, const String& content) {
     return bytes_written == content.length();
 }
 
-void ConfigManager::setValue(const String& section, const String& key, const ConfigValue& value) {
+void ConfigManager::setValue(StrView section, StrView key, const ConfigValue& value) {
+    // Schema keys are stored as their type and in range, so the file and the table agree
+    ConfigKeyId id = config_schema_find(section.c_str(), key.c_str());
+    if (id != CFG_KEY_COUNT) {
+        ConfigSlot slot = schema_slot(id, value);
+        config_values[id] = slot;
+        storeValue(section, key, schema_value(id, slot));
+        return;
+    }
+    storeValue(section, key, value);
+}
+
+void ConfigManager::storeValue(StrView section, StrView key, const ConfigValue& value) {
+    ConfigHotKey* hot = findHotKey(section, key);
+    if (hot) {
+        if (hot->value.equals(value)) {
+            return;
+        }
+        recordChange(section, key, value);
+        hot->value = value;
+        hot->dirty = true;
+        if (!hot_dirty_time) {
+            hot_dirty_time = millis() | 1;  // 0 means clean
+        }
+        return;
+    }
+    
     auto section_ptr = getSection(section);
     if (!section_ptr) {
         section_ptr = createSection(section);
+    } else {
+        const ConfigValue* current = section_ptr->findValue(key);
+        if (current && current->equals(value)) {
+            return;  // Neither a save nor a notification for a no-op
+        }
     }
     section_ptr->setValue(key, value);
+    recordChange(section, key, value);
+}
+
+ConfigValue ConfigManager::getValue(StrView section, StrView key, const ConfigValue& default_value) const {
+    const ConfigValue* value = findValue(section, key);
+    return value ? *value : default_value;
 }
 
-ConfigValue ConfigManager::getValue(const String& section, const String& key, const ConfigValue& default_value) const {
-    auto it = sections.find(section);
-    if (it != sections.end()) {
-        return it->second->getValue(key, default_value);
+const ConfigValue* ConfigManager::findValue(StrView section, StrView key) const {
+    const ConfigHotKey* hot = findHotKey(section, key);
+    if (hot) {
+        return &hot->value;
     }
-    return default_value;
+    
+    auto it = sections.find(section.c_str());
+    return it != sections.end() ? it->second->findValue(key) : nullptr;
 }
 
-void ConfigManager::setString(const String& section, const String& key, const String& value) {
+void ConfigManager::setString(StrView section, StrView key, StrView value) {
     setValue(section, key, ConfigValue(value));
 }
 
-void ConfigManager::setInteger(const String& section, const String& key, int32_t value) {
+void ConfigManager::setInteger(StrView section, StrView key, int32_t value) {
     setValue(section, key, ConfigValue(value));
 }
 
-void ConfigManager::setFloat(const String& section, const String& key, float value) {
+void ConfigManager::setFloat(StrView section, StrView key, float value) {
     setValue(section, key, ConfigValue(value));
 }
 
-void ConfigManager::setBoolean(const String& section, const String& key, bool value) {
+void ConfigManager::setBoolean(StrView section, StrView key, bool value) {
     setValue(section, key, ConfigValue(value));
 }
 
-String ConfigManager::getString(const String& section, const String& key, const String& default_value) const {
-    return getValue(section, key, ConfigValue(default_value)).asString();
+// Getters read in place rather than copying the value out
+String ConfigManager::getString(StrView section, StrView key, const String& default_value) const {
+    const ConfigValue* value = findValue(section, key);
+    return value ? value->asString() : default_value;
+}
+
+int32_t ConfigManager::getInteger(StrView section, StrView key, int32_t default_value) const {
+    const ConfigValue* value = findValue(section, key);
+    return value ? value->asInteger() : default_value;
+}
+
+float ConfigManager::getFloat(StrView section, StrView key, float default_value) const {
+    const ConfigValue* value = findValue(section, key);
+    return value ? value->asFloat() : default_value;
+}
+
+bool ConfigManager::getBoolean(StrView section, StrView key, bool default_value) const {
+    const ConfigValue* value = findValue(section, key);
+    return value ? value->asBoolean() : default_value;
+}
+
+void ConfigManager::registerDefaultHotKeys() {
+    // Flagged in the schema: the settings screen toggles, small, read at boot and flipped often
+    for (uint16_t i = 0; i < CFG_KEY_COUNT; i++) {
+        const ConfigSchemaEntry& e = config_schema[i];
+        if (e.flags & CONFIG_KEY_HOT) {
+            registerHotKey(e.section, e.key, schema_value((ConfigKeyId)i, e.def));
+        }
+    }
+}
+
+void ConfigManager::syncSchema() {
+    for (uint16_t i = 0; i < CFG_KEY_COUNT; i++) {
+        const ConfigSchemaEntry& e = config_schema[i];
+        const ConfigValue* value = findValue(e.section, e.key);
+        config_values[i] = value ? schema_slot((ConfigKeyId)i, *value) : e.def;
+    }
+}
+
+bool ConfigManager::registerHotKey(StrView section, StrView key, const ConfigValue& default_value) {
+    if (section.length() > CONFIG_NVS_NAME_MAX || key.length() > CONFIG_NVS_NAME_MAX ||
+        default_value.isJsonObject() || default_value.isJsonArray()) {
+        LOG_WARNF("ConfigManager", "Cannot keep %s.%s in NVS", section.c_str(), key.c_str());
+        return false;
+    }
+    if (findHotKey(section, key)) {
+        return true;
+    }
+    
+    ConfigHotKey hot;
+    hot.section = ConfigSection::internKey(section.c_str());
+    hot.key = ConfigSection::internKey(key.c_str());
+    hot.value = default_value;
+    hot.dirty = false;
+    
+    // A value still in the file moves to NVS once and leaves the file
+    auto section_ptr = getSection(section);
+    if (section_ptr && section_ptr->hasValue(key)) {
+        hot.value = section_ptr->getValue(key);
+        hot.dirty = true;
+        section_ptr->removeValue(key);
+        if (!hot_dirty_time) {
+            hot_dirty_time = millis() | 1;
+        }
+    }
+    loadHotKey(hot);
+    
+    hot_keys.push_back(hot);
+    return true;
+}
+
+bool ConfigManager::isHotKey(StrView section, StrView key) const {
+    return findHotKey(section, key) != nullptr;
 }
 
-int32_t ConfigManager::getInteger(const String& section, const String& key, int32_t default_value) const {
-    return getValue(section, key, ConfigValue(default_value)).asInteger();
+ConfigHotKey* ConfigManager::findHotKey(StrView section, StrView key) {
+    for (auto& hot : hot_keys) {
+        if (strcmp(hot.key, key.c_str()) == 0 && strcmp(hot.section, section.c_str()) == 0) {
+            return &hot;
+        }
+    }
+    return nullptr;
 }
 
-float ConfigManager::getFloat(const String& section, const String& key, float default_value) const {
-    return getValue(section, key, ConfigValue(default_value)).asFloat();
+const ConfigHotKey* ConfigManager::findHotKey(StrView section, StrView key) const {
+    return const_cast<ConfigManager*>(this)->findHotKey(section, key);
 }
 
-bool ConfigManager::getBoolean(const String& section, const String& key, bool default_value) const {
-    return getValue(section, key, ConfigValue(default_value)).asBoolean();
+void ConfigManager::loadHotKey(ConfigHotKey& hot) {
+    Preferences prefs;
+    if (!prefs.begin(hot.section, true)) {
+        return;  // Namespace not created yet: nothing stored
+    }
+    
+    if (prefs.isKey(hot.key)) {
+        switch (hot.value.getType()) {
+            case ConfigValueType::INTEGER:
+                hot.value = ConfigValue((int32_t)prefs.getInt(hot.key));
+                break;
+            case ConfigValueType::FLOAT:
+                hot.value = ConfigValue(prefs.getFloat(hot.key));
+                break;
+            case ConfigValueType::BOOLEAN:
+                hot.value = ConfigValue(prefs.getBool(hot.key));
+                break;
+            default:
+                hot.value = ConfigValue(prefs.getString(hot.key));
+                break;
+        }
+        hot.dirty = false;
+    }
+    prefs.end();
+}
+
+bool ConfigManager::flushHotKeys() {
+    bool ok = true;
+    
+    // One open/commit per namespace, however many of its keys changed
+    for (size_t i = 0; i < hot_keys.size(); i++) {
+        if (!hot_keys[i].dirty) {
+            continue;
+        }
+        
+        const char* section = hot_keys[i].section;
+        Preferences prefs;
+        if (!prefs.begin(section, false)) {
+            LOG_ERRORF("ConfigManager", "Failed to open NVS namespace %s", section);
+            ok = false;
+            continue;
+        }
+        
+        for (size_t j = i; j < hot_keys.size(); j++) {
+            ConfigHotKey& hot = hot_keys[j];
+            if (!hot.dirty || hot.section != section) {
+                continue;
+            }
+            
+            bool stored;
+            switch (hot.value.getType()) {
+                case ConfigValueType::INTEGER:
+                    stored = prefs.putInt(hot.key, hot.value.asInteger()) > 0;
+                    break;
+                case ConfigValueType::FLOAT:
+                    stored = prefs.putFloat(hot.key, hot.value.asFloat()) > 0;
+                    break;
+                case ConfigValueType::BOOLEAN:
+                    stored = prefs.putBool(hot.key, hot.value.asBoolean()) > 0;
+                    break;
+                default: {
+                    String text = hot.value.asString();
+                    stored = prefs.putString(hot.key, text) == text.length();
+                    break;
+                }
+            }
+            if (stored) {
+                hot.dirty = false;
+            } else {
+                ok = false;
+            }
+        }
+        prefs.end();
+    }
+    
+    hot_dirty_time = 0;
+    return ok;
+}
+
+uint16_t ConfigManager::watch(StrView section, StrView key, ConfigWatchHandler handler, void* context) {
+    if (!handler) {
+        return 0;
+    }
+    
+    ConfigWatch w;
+    w.id = next_watch_id++;
+    if (next_watch_id == 0) {
+        next_watch_id = 1;
+    }
+    w.section = ConfigSection::internKey(section.c_str());
+    w.key = key.isEmpty() ? nullptr : ConfigSection::internKey(key.c_str());
+    w.handler = handler;
+    w.context = context;
+    watches.push_back(w);
+    return w.id;
+}
+
+bool ConfigManager::unwatch(uint16_t watch_id) {
+    for (auto it = watches.begin(); it != watches.end(); ++it) {
+        if (it->id == watch_id) {
+            watches.erase(it);
+            return true;
+        }
+    }
+    return false;
+}
+
+void ConfigManager::recordChange(StrView section, StrView key, const ConfigValue& value) {
+    const char* section_name = ConfigSection::internKey(section.c_str());
+    const char* key_name = ConfigSection::internKey(key.c_str());
+    uint32_t now = millis();
+    
+    if (pending_changes.empty()) {
+        batch_start_time = now;
+    }
+    batch_last_time = now;
+    
+    // Interned, so pointers compare
+    for (auto& change : pending_changes) {
+        if (change.section == section_name && change.key == key_name) {
+            change.value = value;
+            return;
+        }
+    }
+    pending_changes.push_back({section_name, key_name, value});
+}
+
+void ConfigManager::flushChanges() {
+    if (pending_changes.empty()) {
+        return;
+    }
+    
+    // Handlers may change settings again; those start the next batch
+    std::vector<ConfigChange> batch;
+    batch.swap(pending_changes);
+    batch_sequence++;
+    
+    // Grouped by section so each watcher gets its matches in one call
+    std::stable_sort(batch.begin(), batch.end(), [](const ConfigChange& a, const ConfigChange& b) {
+        return strcmp(a.section, b.section) < 0;
+    });
+    
+    std::vector<ConfigChange> matches;
+    std::vector<ConfigWatch> current = watches;  // Handlers may unwatch
+    for (const auto& w : current) {
+        matches.clear();
+        for (const auto& change : batch) {
+            if (change.section == w.section && (!w.key || change.key == w.key)) {
+                matches.push_back(change);
+            }
+        }
+        if (!matches.empty()) {
+            w.handler(matches.data(), matches.size(), w.context);
+        }
+    }
+    
+    ConfigChangedEvent event;
+    event.batch = batch_sequence;
+    event.changes = batch.size();
+    event.sections = 0;
+    for (size_t i = 0; i < batch.size(); i++) {
+        if (i == 0 || batch[i].section != batch[i - 1].section) {
+            event.sections++;
+        }
+    }
+    event.section = event.sections == 1 ? batch[0].section : nullptr;
+    PUBLISH_TYPED_EVENT(EventType::CONFIG_CHANGED, "ConfigManager", event);
 }
 
 void ConfigManager::printStatus() const {
@@ -642,9 +1616,14 @@ void ConfigManager::printStatus() const {
     LOG_INFOF("ConfigManager", "Config loaded: %s", config_loaded ? "true" : "false");
     LOG_INFOF("ConfigManager", "Storage backend: %s",
               storage_backend == ConfigStorage::LITTLEFS ? "LittleFS" :
-              storage_backend == ConfigStorage::SD_CARD ? "SD_CARD" : "EEPROM");
-    LOG_INFOF("ConfigManager", "Config file: %s", config_file_path.c_str());
+              storage_backend == ConfigStorage::SD_CARD ? "SD_CARD" :
+              storage_backend == ConfigStorage::NVS ? "NVS" : "EEPROM");
+    LOG_INFOF("ConfigManager", "Config file: %s (%s)", config_file_path.c_str(),
+              loaded_from_snapshot ? "loaded from snapshot" : "parsed");
     LOG_INFOF("ConfigManager", "Auto-save: %s (interval: %lums)",
               auto_save_enabled ? "enabled" : "disabled", auto_save_interval_ms);
     LOG_INFOF("ConfigManager", "Sections: %d", sections.size());
+    LOG_INFOF("ConfigManager", "Journal: %lu bytes (compacts at %d)", journal_size, CONFIG_JOURNAL_COMPACT_SIZE);
+    LOG_INFOF("ConfigManager", "NVS hot keys: %d", hot_keys.size());
+    LOG_INFOF("ConfigManager", "Watchers: %d, change batches: %lu", watches.size(), batch_sequence);
 }
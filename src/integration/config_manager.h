@@ -15,11 +15,79 @@
 #include <FS.h>
 #include <SD.h>
 #include <LittleFS.h>
+#include <Preferences.h>
 #include <map>
 #include <memory>
+#include <new>
+#include <set>
 #include <vector>
 #include "simple_logger.h"
+#include "fixed_string.h"
 #include "service_container.h"
+#include "event_bridge.h"
+#include "config_schema.h"
+
+// Binary snapshot written next to the JSON on save and read at boot instead
+// of parsing it, as long as the JSON has not changed since
+#define CONFIG_SNAPSHOT_MAGIC       0x53474643UL  // "CFGS"
+#define CONFIG_SNAPSHOT_VERSION     1
+#define CONFIG_SNAPSHOT_EXT         ".snap"
+
+// Change journal appended between full saves and replayed over the JSON at
+// boot. Compacted into the JSON on shutdown or once it grows past the limit.
+#define CONFIG_JOURNAL_MAGIC        0x4A474643UL  // "CFGJ"
+#define CONFIG_JOURNAL_EXT          ".jnl"
+#define CONFIG_JOURNAL_COMPACT_SIZE 4096
+#define CONFIG_JOURNAL_REMOVED      0xFF          // Record type for a deleted key
+
+// Hot keys live in NVS, one namespace per section; a burst of changes within
+// this window is written in one commit per namespace
+#define CONFIG_NVS_COALESCE_MS      2000
+#define CONFIG_NVS_NAME_MAX         15            // NVS namespace and key length limit
+
+// Change notification: setValue() calls are collected into a batch that is
+// handed to watchers once no change arrived for the debounce time
+#define CONFIG_WATCH_DEBOUNCE_MS    100
+#define CONFIG_WATCH_MAX_DELAY_MS   1000          // A steady stream of changes still flushes this often
+
+// Strings up to this size, NUL included, are stored inside the ConfigValue
+#define CONFIG_VALUE_INLINE_SIZE    12
+
+/**
+ * @brief Snapshot file header
+ * 
+ * Followed by entry_count ConfigSnapshotEntry records sorted by section and
+ * key, then blob_size bytes of NUL-terminated names and text values.
+ */
+struct ConfigSnapshotHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t entry_count;
+    uint32_t json_size;             // Stat of the JSON the snapshot was compiled from
+    uint32_t json_mtime;
+    uint32_t blob_size;
+    uint32_t crc;                   // CRC-32 of the entry table and blob
+};
+
+struct ConfigSnapshotEntry {
+    uint32_t key_offset;            // Section name, then key, in the blob
+    uint8_t type;                   // ConfigValueType
+    uint8_t reserved[3];
+    uint32_t value;                 // INTEGER/BOOLEAN value, FLOAT bits or text offset
+};
+
+/**
+ * @brief Journal file header
+ * 
+ * Followed by records of: payload length (u8), type (ConfigValueType or
+ * CONFIG_JOURNAL_REMOVED), payload of "section\0key\0" plus the value bytes
+ * (4 for scalars, the text otherwise), CRC-8 of type and payload.
+ */
+struct ConfigJournalHeader {
+    uint32_t magic;
+    uint32_t json_size;             // Stat of the JSON the journal applies to
+    uint32_t json_mtime;
+};
 
 /**
  * @brief Configuration Storage Backend
@@ -27,13 +95,14 @@
 enum class ConfigStorage {
     LITTLEFS,    // Internal flash storage
     SD_CARD,     // SD card storage
-    EEPROM       // EEPROM storage (for small configs)
+    EEPROM,      // EEPROM storage (for small configs)
+    NVS          // Hot scalar keys only, see ConfigManager::registerHotKey()
 };
 
 /**
  * @brief Configuration Value Types
  */
-enum class ConfigValueType {
+enum class ConfigValueType : uint8_t {
     STRING,
     INTEGER,
     FLOAT,
@@ -45,26 +114,47 @@ enum class ConfigValueType {
 /**
  * @brief Configuration Value Class
  * 
- * Wrapper for configuration values with type safety
+ * Wrapper for configuration values with type safety. Only the active member
+ * is stored: short strings live inline, longer ones on the heap, and object
+ * and array values are a reference into a JsonDocument - the caller's until
+ * the value is stored in a ConfigSection, which copies it into its arena.
  */
 class ConfigValue {
 private:
     ConfigValueType type;
-    String string_value;
-    int32_t int_value;
-    float float_value;
-    bool bool_value;
-    JsonDocument json_value;
+    bool heap;                      // STRING payload is heap_str, not inline_str
+    union {
+        int32_t int_value;
+        float float_value;
+        bool bool_value;
+        char inline_str[CONFIG_VALUE_INLINE_SIZE];
+        char* heap_str;
+        JsonVariant json_ref;
+    };
+    
+    void assignString(const char* value, size_t length);
+    void copyFrom(const ConfigValue& other);
+    void release();
+    
+    friend class ConfigSection;
     
 public:
     ConfigValue();
     ConfigValue(const String& value);
+    ConfigValue(StrView value);
     ConfigValue(const char* value);
+    ConfigValue(const char* value, size_t length);
     ConfigValue(int32_t value);
     ConfigValue(float value);
     ConfigValue(bool value);
     ConfigValue(const JsonObject& value);
     ConfigValue(const JsonArray& value);
+    ConfigValue(const ConfigValue& other);
+    ConfigValue(ConfigValue&& other) noexcept;
+    ~ConfigValue();
+    
+    ConfigValue& operator=(const ConfigValue& other);
+    ConfigValue& operator=(ConfigValue&& other) noexcept;
     
     // Type getters
     ConfigValueType getType() const { return type; }
@@ -77,6 +167,7 @@ public:
     
     // Value getters
     String asString() const;
+    const char* asCString() const;  // Stored text of a STRING value, nullptr for other types
     int32_t asInteger() const;
     float asFloat() const;
     bool asBoolean() const;
@@ -89,54 +180,112 @@ public:
     operator float() const { return asFloat(); }
     operator bool() const { return asBoolean(); }
     
+    bool equals(const ConfigValue& other) const;
     String toString() const;
 };
 
+/**
+ * @brief One changed key, as handed to watchers
+ */
+struct ConfigChange {
+    const char* section;            // Interned
+    const char* key;                // Interned
+    ConfigValue value;              // JSON values refer into the section and stay valid during the call
+};
+
+/**
+ * @brief Watcher callback: every change of one batch that matches the watch
+ */
+typedef void (*ConfigWatchHandler)(const ConfigChange* changes, size_t count, void* context);
+
+struct ConfigWatch {
+    uint16_t id;
+    const char* section;            // Interned
+    const char* key;                // Interned, nullptr for the whole section
+    ConfigWatchHandler handler;
+    void* context;
+};
+
+/**
+ * @brief CONFIG_CHANGED event payload
+ */
+struct ConfigChangedEvent {
+    uint32_t batch;                 // Sequence number of the batch
+    uint16_t changes;
+    uint16_t sections;              // Distinct sections in the batch
+    const char* section;            // Interned name when sections == 1, else nullptr
+};
+
+/**
+ * @brief Orders interned keys by content, so lookups work with any C string
+ */
+struct ConfigKeyLess {
+    bool operator()(const char* a, const char* b) const { return strcmp(a, b) < 0; }
+};
+
 /**
  * @brief Configuration Section
  * 
- * Groups related configuration values
+ * Groups related configuration values. Keys and section names are interned
+ * once for all sections; object and array values share the section's JSON
+ * arena.
  */
 class ConfigSection {
 private:
-    String section_name;
-    std::map<String, ConfigValue> values;
+    const char* section_name;       // Interned
+    std::map<const char*, ConfigValue, ConfigKeyLess> values;
+    JsonDocument json_arena;        // Object holding every JSON value by key
+    std::set<const char*> dirty_keys;   // Interned keys changed since the last save
     bool modified;
     
 public:
-    ConfigSection(const String& name);
+    ConfigSection(StrView name);
+    
+    static const char* internKey(const char* key);
     
     // Value management
-    void setValue(const String& key, const ConfigValue& value);
-    ConfigValue getValue(const String& key, const ConfigValue& default_value = ConfigValue()) const;
-    bool hasValue(const String& key) const;
-    bool removeValue(const String& key);
+    void setValue(StrView key, const ConfigValue& value);
+    ConfigValue getValue(StrView key, const ConfigValue& default_value = ConfigValue()) const;
+    const ConfigValue* findValue(StrView key) const;    // In place, valid until the key changes
+    bool hasValue(StrView key) const;
+    bool removeValue(StrView key);
     void clear();
     
     // Convenience setters
-    void setString(const String& key, const String& value);
-    void setInteger(const String& key, int32_t value);
-    void setFloat(const String& key, float value);
-    void setBoolean(const String& key, bool value);
+    void setString(StrView key, StrView value);
+    void setInteger(StrView key, int32_t value);
+    void setFloat(StrView key, float value);
+    void setBoolean(StrView key, bool value);
     
     // Convenience getters
-    String getString(const String& key, const String& default_value = "") const;
-    int32_t getInteger(const String& key, int32_t default_value = 0) const;
-    float getFloat(const String& key, float default_value = 0.0f) const;
-    bool getBoolean(const String& key, bool default_value = false) const;
+    String getString(StrView key, const String& default_value = "") const;
+    int32_t getInteger(StrView key, int32_t default_value = 0) const;
+    float getFloat(StrView key, float default_value = 0.0f) const;
+    bool getBoolean(StrView key, bool default_value = false) const;
     
     // Section management
-    const String& getName() const { return section_name; }
+    const char* getName() const { return section_name; }
     bool isModified() const { return modified; }
-    void setModified(bool mod = true) { modified = mod; }
+    void setModified(bool mod = true) { modified = mod; if (!mod) dirty_keys.clear(); }
+    const std::set<const char*>& getDirtyKeys() const { return dirty_keys; }
     size_t getValueCount() const { return values.size(); }
-    std::vector<String> getKeys() const;
+    std::vector<const char*> getKeys() const;   // Interned
     
     // Serialization
     bool toJson(JsonObject& obj) const;
     bool fromJson(const JsonObject& obj);
 };
 
+/**
+ * @brief Key routed to the NVS tier instead of the config file
+ */
+struct ConfigHotKey {
+    const char* section;            // Interned; also the NVS namespace
+    const char* key;                // Interned; also the NVS key
+    ConfigValue value;
+    bool dirty;                     // Changed since the last NVS commit
+};
+
 /**
  * @brief Configuration Manager Class
  * 
@@ -144,7 +293,7 @@ public:
  */
 class ConfigManager : public IService {
 private:
-    std::map<String, std::shared_ptr<ConfigSection>> sections;
+    std::map<const char*, std::shared_ptr<ConfigSection>, ConfigKeyLess> sections;  // By interned name
     ConfigStorage storage_backend;
     String config_file_path;
     bool auto_save_enabled;
@@ -152,6 +301,20 @@ private:
     uint32_t last_save_time;
     bool initialized;
     bool config_loaded;
+    bool loaded_from_snapshot;      // Last load skipped JSON parsing
+    uint32_t journal_size;          // Bytes in the journal, 0 when there is none
+    
+    // NVS tier
+    std::vector<ConfigHotKey> hot_keys;
+    uint32_t hot_dirty_time;        // millis() of the oldest uncommitted hot write, 0 when clean
+    
+    // Change notification
+    std::vector<ConfigWatch> watches;
+    std::vector<ConfigChange> pending_changes;  // One entry per key, latest value
+    uint32_t batch_start_time;      // First change of the open batch
+    uint32_t batch_last_time;       // Latest change of the open batch
+    uint32_t batch_sequence;
+    uint16_t next_watch_id;
     
     // File system references
     fs::FS* file_system;
@@ -173,26 +336,50 @@ public:
     void update(); // Called from main loop for auto-save
     
     // Section management
-    std::shared_ptr<ConfigSection> getSection(const String& section_name);
-    std::shared_ptr<ConfigSection> createSection(const String& section_name);
-    bool hasSection(const String& section_name) const;
-    bool removeSection(const String& section_name);
+    std::shared_ptr<ConfigSection> getSection(StrView section_name);
+    std::shared_ptr<ConfigSection> createSection(StrView section_name);
+    bool hasSection(StrView section_name) const;
+    bool removeSection(StrView section_name);
     std::vector<String> getSectionNames() const;
     
-    // Direct value access (creates sections as needed)
-    void setValue(const String& section, const String& key, const ConfigValue& value);
-    ConfigValue getValue(const String& section, const String& key, const ConfigValue& default_value = ConfigValue()) const;
+    // Key schema: scalars registered here are kept in NVS, everything else in the file.
+    // Routing happens in ConfigManager's accessors; sections never hold hot keys.
+    // Keys in CONFIG_SCHEMA (config_schema.h) are also mirrored to config_values[].
+    bool registerHotKey(StrView section, StrView key, const ConfigValue& default_value);
+    bool isHotKey(StrView section, StrView key) const;
+    bool flushHotKeys();
+    
+    // Change notification; handlers run from update(). key "" watches the whole
+    // section. Changes made through a ConfigSection directly are not reported
+    uint16_t watch(StrView section, StrView key, ConfigWatchHandler handler, void* context = nullptr);
+    bool unwatch(uint16_t watch_id);
+    void flushChanges();
+    
+    // Direct value access (creates sections as needed). Names are looked up
+    // as given, so literals do not build a String per call
+    void setValue(StrView section, StrView key, const ConfigValue& value);
+    ConfigValue getValue(StrView section, StrView key, const ConfigValue& default_value = ConfigValue()) const;
     
     // Convenience methods
-    void setString(const String& section, const String& key, const String& value);
-    void setInteger(const String& section, const String& key, int32_t value);
-    void setFloat(const String& section, const String& key, float value);
-    void setBoolean(const String& section, const String& key, bool value);
+    void setString(StrView section, StrView key, StrView value);
+    void setInteger(StrView section, StrView key, int32_t value);
+    void setFloat(StrView section, StrView key, float value);
+    void setBoolean(StrView section, StrView key, bool value);
+    
+    String getString(StrView section, StrView key, const String& default_value = "") const;
+    int32_t getInteger(StrView section, StrView key, int32_t default_value = 0) const;
+    float getFloat(StrView section, StrView key, float default_value = 0.0f) const;
+    bool getBoolean(StrView section, StrView key, bool default_value = false) const;
     
-    String getString(const String& section, const String& key, const String& default_value = "") const;
-    int32_t getInteger(const String& section, const String& key, int32_t default_value = 0) const;
-    float getFloat(const String& section, const String& key, float default_value = 0.0f) const;
-    bool getBoolean(const String& section, const String& key, bool default_value = false) const;
+    // Copies a STRING value into out without touching the heap; false, and
+    // out set to default_value, when the key is missing or not a string
+    template <size_t N>
+    bool getString(StrView section, StrView key, FixedString<N>& out, StrView default_value = StrView()) const {
+        const ConfigValue* value = findValue(section, key);
+        const char* text = value ? value->asCString() : nullptr;
+        out = text ? StrView(text) : default_value;
+        return text != nullptr;
+    }
     
     // Configuration settings
     void setStorageBackend(ConfigStorage backend);
@@ -210,11 +397,42 @@ public:
     
 private:
     bool initializeFileSystem();
+    bool migrateConfig();           // From the bulk volume to the hot one, once
     bool fileExists(const String& path) const;
     String readFile(const String& path) const;
     bool writeFile(const String& path, const String& content);
     void createDefaultConfig();
     String getDefaultConfigPath() const;
+    
+    // Files kept next to the JSON
+    String getSidecarPath(const char* ext) const;
+    
+    // Binary snapshot
+    String getSnapshotPath() const;
+    bool getFileStamp(const String& path, uint32_t& size, uint32_t& mtime) const;
+    bool loadSnapshot();
+    bool writeSnapshot();
+    
+    // Change journal
+    bool appendJournal();
+    bool replayJournal();
+    bool encodeJournalRecord(std::vector<uint8_t>& out, const ConfigSection& section, const char* key) const;
+    
+    // NVS tier
+    void registerDefaultHotKeys();
+    ConfigHotKey* findHotKey(StrView section, StrView key);
+    const ConfigHotKey* findHotKey(StrView section, StrView key) const;
+    void loadHotKey(ConfigHotKey& hot);
+    
+    // Hot key or section value, in place
+    const ConfigValue* findValue(StrView section, StrView key) const;
+    
+    // Change notification
+    void recordChange(StrView section, StrView key, const ConfigValue& value);
+    
+    // Typed schema table, from whatever the tiers hold now
+    void syncSchema();
+    void storeValue(StrView section, StrView key, const ConfigValue& value);
 };
 
 /**
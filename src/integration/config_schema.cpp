@@ -0,0 +1,75 @@
+/**
+ * @file      config_schema.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Schema table and the flat value table it describes
+ */
+
+#include "config_schema.h"
+#include "config_manager.h"
+
+static_assert(CONFIG_SCHEMA_KIND_INTEGER == (uint8_t)ConfigValueType::INTEGER &&
+              CONFIG_SCHEMA_KIND_FLOAT == (uint8_t)ConfigValueType::FLOAT &&
+              CONFIG_SCHEMA_KIND_BOOLEAN == (uint8_t)ConfigValueType::BOOLEAN,
+              "schema kinds must be ConfigValueType values");
+
+#define CONFIG_SCHEMA_SLOT(type, v) ConfigSlot((CONFIG_SCHEMA_CTYPE_##type)(v))
+
+const ConfigSchemaEntry config_schema[CFG_KEY_COUNT] = {
+#define CONFIG_SCHEMA_ENTRY(id, section, key, type, def, lo, hi, flags)                 \
+    {section, key, CONFIG_SCHEMA_KIND_##type, flags,                                    \
+     CONFIG_SCHEMA_SLOT(type, def), CONFIG_SCHEMA_SLOT(type, lo), CONFIG_SCHEMA_SLOT(type, hi)},
+    CONFIG_SCHEMA(CONFIG_SCHEMA_ENTRY)
+#undef CONFIG_SCHEMA_ENTRY
+};
+
+// Constant-initialised, so the defaults are there before any constructor runs
+ConfigSlot config_values[CFG_KEY_COUNT] = {
+#define CONFIG_SCHEMA_DEFAULT(id, section, key, type, def, lo, hi, flags) CONFIG_SCHEMA_SLOT(type, def),
+    CONFIG_SCHEMA(CONFIG_SCHEMA_DEFAULT)
+#undef CONFIG_SCHEMA_DEFAULT
+};
+
+ConfigKeyId config_schema_find(const char* section, const char* key) {
+    for (uint16_t i = 0; i < CFG_KEY_COUNT; i++) {
+        if (!strcmp(config_schema[i].key, key) && !strcmp(config_schema[i].section, section)) {
+            return (ConfigKeyId)i;
+        }
+    }
+    return CFG_KEY_COUNT;
+}
+
+ConfigSlot config_schema_clamp(ConfigKeyId id, ConfigSlot value) {
+    const ConfigSchemaEntry& e = config_schema[id];
+    switch (e.kind) {
+        case CONFIG_SCHEMA_KIND_INTEGER:
+            return ConfigSlot(constrain(value.i, e.min.i, e.max.i));
+        case CONFIG_SCHEMA_KIND_FLOAT:
+            // NaN compares false both ways and would pass; take the default
+            if (isnan(value.f)) {
+                return e.def;
+            }
+            return ConfigSlot(constrain(value.f, e.min.f, e.max.f));
+        default:
+            return value;
+    }
+}
+
+void config_set(ConfigKeyId id, ConfigSlot value) {
+    if (id >= CFG_KEY_COUNT) {
+        return;
+    }
+    const ConfigSchemaEntry& e = config_schema[id];
+    if (!GlobalConfigManager) {
+        config_values[id] = config_schema_clamp(id, value);
+        return;
+    }
+    // The manager clamps and stores the slot, and saves and reports the change
+    switch (e.kind) {
+        case CONFIG_SCHEMA_KIND_INTEGER: GlobalConfigManager->setInteger(e.section, e.key, value.i); break;
+        case CONFIG_SCHEMA_KIND_FLOAT:   GlobalConfigManager->setFloat(e.section, e.key, value.f); break;
+        default:                         GlobalConfigManager->setBoolean(e.section, e.key, value.b); break;
+    }
+}
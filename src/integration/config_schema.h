@@ -0,0 +1,141 @@
+/**
+ * @file      config_schema.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Typed configuration keys declared once, read from a flat table
+ */
+
+#ifndef CONFIG_SCHEMA_H
+#define CONFIG_SCHEMA_H
+
+#include <Arduino.h>
+
+/**
+ * Scalar keys read on hot paths are declared in CONFIG_SCHEMA below with
+ * their section, name, type, default and range. Each gets a compile-time
+ * id, and its current value lives in config_values[], a plain array of
+ * 32-bit slots initialised with the defaults before anything runs. A read
+ * is GET_CONFIG(LORA_LBT): an index and a load, no map, no string, no
+ * conversion, usable before ConfigManager is up.
+ *
+ * ConfigManager keeps the slots in step: values loaded from the JSON, the
+ * snapshot, the journal or NVS are converted and clamped into them, and
+ * every setValue() on a schema key is clamped before it is stored. The
+ * section and key strings are used only there, to import and export.
+ * Writes go through SET_CONFIG, which takes the manager's path so the
+ * change is saved and watchers hear of it.
+ *
+ * Flags: CONFIG_KEY_HOT keeps the key in NVS, see
+ * ConfigManager::registerHotKey().
+ */
+
+#define CONFIG_KEY_HOT              0x01
+
+// X(id, section, key, type, default, min, max, flags); type INTEGER, FLOAT or BOOLEAN
+#define CONFIG_SCHEMA(X)                                                                        \
+    X(SETTINGS_LANGUAGE,        "settings", "language",          INTEGER, 0,     0, 1,     CONFIG_KEY_HOT) \
+    X(SETTINGS_KEYPAD_LIGHT,    "settings", "keypad_light",      BOOLEAN, false, 0, 1,     CONFIG_KEY_HOT) \
+    X(SETTINGS_MOTOR,           "settings", "motor",             BOOLEAN, false, 0, 1,     CONFIG_KEY_HOT) \
+    X(SETTINGS_GPS,             "settings", "gps",               BOOLEAN, true,  0, 1,     CONFIG_KEY_HOT) \
+    X(SETTINGS_LORA,            "settings", "lora",              BOOLEAN, true,  0, 1,     CONFIG_KEY_HOT) \
+    X(SETTINGS_GYRO,            "settings", "gyro",              BOOLEAN, true,  0, 1,     CONFIG_KEY_HOT) \
+    X(SETTINGS_A7682,           "settings", "a7682",             BOOLEAN, true,  0, 1,     CONFIG_KEY_HOT) \
+    X(LORA_ADR,                 "lora",     "adr",               BOOLEAN, false, 0, 1,     0)              \
+    X(LORA_LBT,                 "lora",     "lbt",               BOOLEAN, false, 0, 1,     0)              \
+    X(LORA_RX_DUTY_CYCLE,       "lora",     "rx_duty_cycle",     BOOLEAN, false, 0, 1,     0)              \
+    X(LORA_COMPRESS,            "lora",     "compress",          BOOLEAN, true,  0, 1,     0)              \
+    X(LORA_ENCRYPT,             "lora",     "encrypt",           BOOLEAN, false, 0, 1,     0)              \
+    X(LORA_REQUIRE_ENCRYPTED,   "lora",     "require_encrypted", BOOLEAN, false, 0, 1,     0)              \
+    X(LORA_FSK,                 "lora",     "fsk",               BOOLEAN, true,  0, 1,     0)              \
+    X(GPS_UBX,                  "gps",      "ubx",               BOOLEAN, false, 0, 1,     0)              \
+    X(GPS_RATE_HZ,              "gps",      "rate_hz",           INTEGER, 1,     1, 10,    0)              \
+    X(GPS_TRACK,                "gps",      "track",             BOOLEAN, false, 0, 1,     0)              \
+    X(REPLAY_SPEED,             "replay",   "speed",             INTEGER, 100,   0, 10000, 0)
+
+enum ConfigKeyId : uint16_t {
+#define CONFIG_SCHEMA_ID(id, section, key, type, def, lo, hi, flags) CFG_##id,
+    CONFIG_SCHEMA(CONFIG_SCHEMA_ID)
+#undef CONFIG_SCHEMA_ID
+    CFG_KEY_COUNT
+};
+
+/**
+ * @brief One value; the schema says which member is live
+ */
+union ConfigSlot {
+    int32_t i;
+    float f;
+    bool b;
+
+    constexpr ConfigSlot() : i(0) {}
+    constexpr ConfigSlot(int32_t v) : i(v) {}
+    constexpr ConfigSlot(float v) : f(v) {}
+    constexpr ConfigSlot(bool v) : b(v) {}
+};
+
+// Schema type to C type, slot member and ConfigValueType (config_manager.h)
+#define CONFIG_SCHEMA_CTYPE_INTEGER     int32_t
+#define CONFIG_SCHEMA_CTYPE_FLOAT       float
+#define CONFIG_SCHEMA_CTYPE_BOOLEAN     bool
+#define CONFIG_SCHEMA_MEMBER_INTEGER    i
+#define CONFIG_SCHEMA_MEMBER_FLOAT      f
+#define CONFIG_SCHEMA_MEMBER_BOOLEAN    b
+#define CONFIG_SCHEMA_KIND_INTEGER      1
+#define CONFIG_SCHEMA_KIND_FLOAT        2
+#define CONFIG_SCHEMA_KIND_BOOLEAN      3
+
+struct ConfigSchemaEntry {
+    const char* section;
+    const char* key;
+    uint8_t kind;                   // ConfigValueType: INTEGER, FLOAT or BOOLEAN
+    uint8_t flags;                  // CONFIG_KEY_*
+    ConfigSlot def;
+    ConfigSlot min;                 // Inclusive; BOOLEAN keys have no range
+    ConfigSlot max;
+};
+
+extern const ConfigSchemaEntry config_schema[CFG_KEY_COUNT];
+extern ConfigSlot config_values[CFG_KEY_COUNT];
+
+/**
+ * @brief Per key C type and compile-time default
+ */
+template <ConfigKeyId K> struct ConfigKeyTraits;
+
+#define CONFIG_SCHEMA_TRAITS(id, section, key, type, def, lo, hi, flags)               \
+    template <> struct ConfigKeyTraits<CFG_##id> {                                      \
+        typedef CONFIG_SCHEMA_CTYPE_##type value_type;                                  \
+        static constexpr value_type default_value() { return (value_type)(def); }       \
+        static value_type read(const ConfigSlot& slot) { return slot.CONFIG_SCHEMA_MEMBER_##type; } \
+    };
+CONFIG_SCHEMA(CONFIG_SCHEMA_TRAITS)
+#undef CONFIG_SCHEMA_TRAITS
+
+template <ConfigKeyId K>
+inline typename ConfigKeyTraits<K>::value_type config_get() {
+    return ConfigKeyTraits<K>::read(config_values[K]);
+}
+
+/**
+ * @brief Store through ConfigManager when it is up, else into the slot;
+ *        clamped either way
+ */
+void config_set(ConfigKeyId id, ConfigSlot value);
+
+/**
+ * @brief Id of section.key, CFG_KEY_COUNT when it is not in the schema
+ */
+ConfigKeyId config_schema_find(const char* section, const char* key);
+
+/**
+ * @brief value clamped to the key's range
+ */
+ConfigSlot config_schema_clamp(ConfigKeyId id, ConfigSlot value);
+
+#define GET_CONFIG(id) config_get<CFG_##id>()
+#define SET_CONFIG(id, value) \
+    config_set(CFG_##id, ConfigSlot((ConfigKeyTraits<CFG_##id>::value_type)(value)))
+
+#endif // CONFIG_SCHEMA_H
@@ -8,28 +8,49 @@
  */
 
 #include "event_bridge.h"
+#include "task_arena.h"
+#include "placement.h"
+#include "metrics.h"
+#include "crash_dump.h"
+
+static_assert((EVENT_QUEUE_SLOTS & (EVENT_QUEUE_SLOTS - 1)) == 0, "EVENT_QUEUE_SLOTS must be a power of two");
+static_assert(static_cast<int>(EventPriority::CRITICAL) == EVENT_PRIORITY_LEVELS - 1, "One queue per EventPriority");
+static_assert(EVENT_SLAB_BLOCKS <= 32, "Slab free mask is one 32-bit word");
+static_assert(EVENT_CONTEXT_UI + EVENT_WORKER_MAX < 256, "Context IDs are uint8_t");
 
 // Global event bridge instance
 EventBridge* GlobalEventBridge = nullptr;
 
+// Source table, ID 0 is reserved for unknown publishers
+char EventBridge::source_names[EVENT_SOURCE_MAX][EVENT_SOURCE_NAME_LEN] = { "unknown" };
+uint16_t EventBridge::source_count = 1;
+portMUX_TYPE EventBridge::source_mux = portMUX_INITIALIZER_UNLOCKED;
+portMUX_TYPE EventBridge::policy_mux = portMUX_INITIALIZER_UNLOCKED;
+
 // Event class implementation
-Event::Event(EventType t, const String& src, EventPriority p)
-    : type(t), priority(p), source(src), timestamp(millis()), handled(false) {
+Event::Event(EventType t, uint16_t src, EventPriority p)
+    : type(t), priority(p), source_id(src), payload_size(0), timestamp(millis()),
+      payload_tag(nullptr), payload(nullptr), handled(false) {
+}
+
+Event::Event(EventType t, uint16_t src, const void* tag, const void* data, uint16_t size,
+             EventPriority p, uint32_t ts)
+    : type(t), priority(p), source_id(src), payload_size(size), timestamp(ts),
+      payload_tag(tag), payload(data), handled(false) {
 }
 
-Event::Event(EventType t, const String& src, std::shared_ptr<EventData> d, EventPriority p)
-    : type(t), priority(p), source(src), data(d), timestamp(millis()), handled(false) {
+const char* Event::getSource() const {
+    return EventBridge::sourceName(source_id);
 }
 
-String Event::toString() const {
-    String result = "Event{";
-    result += "type=" + EventBridge::eventTypeToString(type);
-    result += ", source=" + source;
-    result += ", priority=" + EventBridge::eventPriorityToString(priority);
-    result += ", timestamp=" + String(timestamp);
-    result += ", handled=" + String(handled ? "true" : "false");
-    if (data) {
-        result += ", data=" + data->toString();
+EventText Event::toString() const {
+    EventText result;
+    result.format("Event{type=%s, source=%s, priority=%s, timestamp=%lu, handled=%s",
+                  EventBridge::eventTypeToString(type), getSource(),
+                  EventBridge::eventPriorityToString(priority), (unsigned long)timestamp,
+                  handled ? "true" : "false");
+    if (payload) {
+        result.appendf(", payload=%uB", (unsigned)payload_size);
     }
     result += "}";
     return result;
@@ -37,14 +58,30 @@ String Event::toString() const {
 
 // EventBridge class implementation
 EventBridge::EventBridge()
-    : initialized(false), max_queue_size(100), max_history_size(50),
-      events_processed(0), events_dropped(0), processing_enabled(true),
-      last_process_time(0), process_interval_ms(10) {
+    : dispatch_depth(0), subscriptions_dirty(false), trace(nullptr), trace_capacity(0),
+      trace_written(0), contexts(), context_count(0), ui_task(nullptr), slab_pool(nullptr), slab_free(0), slab_failures(0),
+      events_coalesced(0), events_rate_limited(0), initialized(false),
+      max_queue_size(EVENT_QUEUE_SLOTS), max_history_size(EVENT_TRACE_RECORDS),
+      events_processed(0), events_dropped(0), queue_overflows(0), overflows_reported(0),
+      events_inline(0), budget_exhausted(0), processing_enabled(true), last_process_time(0),
+      process_interval_ms(10), dispatch_budget_us(EVENT_DISPATCH_BUDGET_US) {
     // Don't log during static initialization - logger may not be ready
+    resetQueue();
+    for (EventPolicy& policy : policies) {
+        policy = { EventDeliveryPolicy::QUEUE_ALL, 0, 0 };
+    }
+    resetPolicyState();
+    
+    // Consumers of these only want the newest value
+    setDeliveryPolicy(EventType::GPS_LOCATION_UPDATE, EventDeliveryPolicy::LATEST);
+    setDeliveryPolicy(EventType::LORA_TELEMETRY, EventDeliveryPolicy::LATEST);
+    setDeliveryPolicy(EventType::DOWNLOAD_PROGRESS, EventDeliveryPolicy::LATEST);
 }
 
 EventBridge::~EventBridge() {
     shutdown();
+    free(slab_pool);
+    free(trace);
     LOG_INFO("EventBridge", "Event bridge destroyed");
 }
 
@@ -57,11 +94,49 @@ bool EventBridge::initialize() {
     }
     
     // Clear any existing state
-    subscriptions.clear();
-    event_queue.clear();
-    event_history.clear();
+    for (auto& subs : subscriptions) {
+        subs.clear();
+    }
+    resetQueue();
+    trace_written = 0;
     events_processed = 0;
     events_dropped = 0;
+    queue_overflows = 0;
+    overflows_reported = 0;
+    events_inline = 0;
+    budget_exhausted = 0;
+    slab_failures = 0;
+    events_coalesced = 0;
+    events_rate_limited = 0;
+    resetPolicyState();
+    
+    // Large payloads live in PSRAM; without a pool they are dropped
+    if (!slab_pool) {
+        slab_pool = (uint8_t*)ps_malloc(EVENT_SLAB_BLOCKS * EVENT_SLAB_BLOCK_SIZE);
+        if (!slab_pool) {
+            slab_pool = (uint8_t*)malloc(EVENT_SLAB_BLOCKS * EVENT_SLAB_BLOCK_SIZE);
+        }
+    }
+    // Trace records also go to PSRAM; a failed allocation just disables tracing
+    if (trace && trace_capacity != max_history_size) {
+        free(trace);
+        trace = nullptr;
+    }
+    if (!trace && max_history_size > 0) {
+        trace = (EventTraceRecord*)ps_malloc(max_history_size * sizeof(EventTraceRecord));
+    }
+    trace_capacity = trace ? max_history_size : 0;
+    
+    // The UI context has no task of its own, processEvents() drains it
+    if (context_count == 0 && initContext(contexts[0], "ui")) {
+        context_count = 1;
+    }
+    
+    if (slab_pool) {
+        slab_free = (EVENT_SLAB_BLOCKS == 32) ? 0xFFFFFFFFUL : ((1UL << EVENT_SLAB_BLOCKS) - 1);
+    } else {
+        LOG_WARN("EventBridge", "No memory for payload slab pool");
+    }
     
     // Set global instance
     if (!GlobalEventBridge) {
@@ -87,15 +162,21 @@ void EventBridge::shutdown() {
     // Publish system shutdown event
     publishEvent(EventType::SYSTEM_SHUTDOWN, "EventBridge", EventPriority::EVENT_HIGH);
     
-    // Process any remaining events
+    // Process any remaining events, ignoring the per-pass budget
+    uint32_t budget_us = dispatch_budget_us;
+    dispatch_budget_us = UINT32_MAX;
     processEvents();
+    dispatch_budget_us = budget_us;
     
-    // Clear all subscriptions and events
-    subscriptions.clear();
-    event_queue.clear();
-    event_history.clear();
-    
+    // Stop producers before the ring is emptied
     initialized = false;
+    deinitContexts();
+    
+    // Clear all subscriptions and events
+    for (auto& subs : subscriptions) {
+        subs.clear();
+    }
+    resetQueue();
     
     // Clear global instance if it's this bridge
     if (GlobalEventBridge == this) {
@@ -106,86 +187,449 @@ void EventBridge::shutdown() {
 }
 
 void EventBridge::publishEvent(const Event& event) {
+    publishPayload(event.getType(), event.getSourceId(), event.getPriority(),
+                   event.getPayloadTag(), event.getPayloadData(), event.getPayloadSize());
+}
+
+void EventBridge::publishEvent(EventType type, const char* source, EventPriority priority) {
+    publishPayload(type, internSource(source), priority, nullptr, nullptr, 0);
+}
+
+void EventBridge::publishEvent(EventType type, StrView source, EventPriority priority) {
+    publishPayload(type, internSource(source.c_str()), priority, nullptr, nullptr, 0);
+}
+
+bool IRAM_ATTR EventBridge::tryPublish(EventType type, const char* source, EventPriority priority) {
+    return publishPayload(type, internSource(source), priority, nullptr, nullptr, 0);
+}
+
+bool IRAM_ATTR EventBridge::tryPublish(EventType type, const char* source, uint32_t value, EventPriority priority) {
+    return publishPayload(type, internSource(source), priority, &EventPayloadTag<uint32_t>::id, &value, sizeof(value));
+}
+
+bool IRAM_ATTR EventBridge::publishPayload(EventType type, uint16_t source_id, EventPriority priority,
+                                           const void* tag, const void* data, uint16_t size) {
     if (!initialized || !processing_enabled) {
-        return;
+        events_dropped.fetch_add(1, std::memory_order_relaxed);
+        metrics_count(METRIC_EVENTS_DROPPED);
+        return false;
     }
     
-    // Check queue size limit
-    if (event_queue.size() >= max_queue_size) {
-        LOG_WARNF("EventBridge", "Event queue full, dropping event: %s", 
-                  eventTypeToString(event.getType()).c_str());
-        events_dropped++;
-        return;
+    // CRITICAL events skip the queue and run on the publishing task; handlers
+    // cannot run in an ISR, so from interrupts they are queued like the rest
+    if (priority == EventPriority::CRITICAL && !xPortInIsrContext()) {
+        processEvent(Event(type, source_id, tag, data, size, priority, millis()));
+        events_inline++;
+        events_processed++;
+        metrics_count(METRIC_EVENTS_PROCESSED);
+        return true;
     }
     
-    event_queue.push_back(event);
+    // Policies never apply to CRITICAL events, so those are only lost to a full queue
+    int type_slot = typeSlot(type);
+    EventDeliveryPolicy mode = (type_slot >= 0 && priority != EventPriority::CRITICAL) ?
+                               policies[type_slot].mode : EventDeliveryPolicy::QUEUE_ALL;
+    if (mode == EventDeliveryPolicy::RATE_LIMIT && !takeToken(type_slot, source_id)) {
+        events_rate_limited.fetch_add(1, std::memory_order_relaxed);
+        metrics_count(METRIC_EVENTS_RATE_LIMITED);
+        return false;
+    }
+    if (mode == EventDeliveryPolicy::LATEST && replaceLatest(type_slot, priority, source_id, tag, data, size)) {
+        events_coalesced.fetch_add(1, std::memory_order_relaxed);
+        metrics_count(METRIC_EVENTS_COALESCED);
+        return true;
+    }
     
-    LOG_DEBUGF("EventBridge", "Event published: %s from %s", 
-               eventTypeToString(event.getType()).c_str(), 
-               event.getSource().c_str());
+    return pushSlot(type, priority, source_id, tag, data, size, mode == EventDeliveryPolicy::LATEST);
 }
 
-void EventBridge::publishEvent(EventType type, const String& source, EventPriority priority) {
-    publishEvent(Event(type, source, priority));
+bool IRAM_ATTR EventBridge::pushSlot(EventType type, EventPriority priority, uint16_t source_id,
+                                     const void* tag, const void* data, uint16_t size, bool latest) {
+    uint8_t* slab = nullptr;
+    if (size > EVENT_INLINE_PAYLOAD) {
+        slab = (size <= EVENT_SLAB_BLOCK_SIZE) ? allocSlab() : nullptr;
+        if (!slab) {
+            slab_failures.fetch_add(1, std::memory_order_relaxed);
+            events_dropped.fetch_add(1, std::memory_order_relaxed);
+            metrics_count(METRIC_EVENTS_DROPPED);
+            return false;
+        }
+    }
+    
+    EventQueue& queue = queues[static_cast<int>(priority) & (EVENT_PRIORITY_LEVELS - 1)];
+    
+    // Claim a slot: it is free once its sequence has caught up with the position
+    uint32_t pos = queue.enqueue_pos.load(std::memory_order_relaxed);
+    EventSlot* slot;
+    while (true) {
+        slot = &queue.slots[pos & (EVENT_QUEUE_SLOTS - 1)];
+        int32_t diff = (int32_t)(slot->sequence.load(std::memory_order_acquire) - pos);
+        
+        if (diff == 0) {
+            if (pos - queue.dequeue_pos.load(std::memory_order_relaxed) >= max_queue_size) {
+                diff = -1;
+            } else if (queue.enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            } else {
+                continue;
+            }
+        }
+        if (diff < 0) {
+            // Full; reported from processEvents() because logging is not ISR-safe
+            queue_overflows.fetch_add(1, std::memory_order_relaxed);
+            events_dropped.fetch_add(1, std::memory_order_relaxed);
+            metrics_count(METRIC_EVENTS_DROPPED);
+            freeSlab(slab);
+            return false;
+        }
+        pos = queue.enqueue_pos.load(std::memory_order_relaxed);
+    }
+    
+    slot->type = type;
+    slot->priority = priority;
+    slot->source_id = source_id;
+    slot->timestamp = millis();
+    slot->payload_tag = tag;
+    slot->payload_size = data ? size : 0;
+    slot->slab = slab;
+    slot->latest = latest;
+    if (data && size > 0) {
+        memcpy(slab ? slab : slot->payload, data, size);
+    }
+    
+    // Publish the contents to the consumer
+    slot->sequence.store(pos + 1, std::memory_order_release);
+    
+    if (latest) {
+        // Until the consumer takes it, later events from this source land here.
+        // Dequeued first, the entry is simply stale
+        int type_slot = typeSlot(type);
+        uint8_t level = static_cast<uint8_t>(priority);
+        EventLatestEntry* entry = nullptr;
+        portENTER_CRITICAL_SAFE(&policy_mux);
+        for (EventLatestEntry& e : latest_entries) {
+            bool live = e.type_slot >= 0 &&
+                        queues[e.level].slots[e.pos & (EVENT_QUEUE_SLOTS - 1)].sequence.load(std::memory_order_relaxed) == e.pos + 1;
+            if (e.type_slot == type_slot && e.source_id == source_id && e.level == level) {
+                entry = &e;
+                break;
+            }
+            if (!live && !entry) {
+                entry = &e;
+            }
+        }
+        if (entry) {
+            *entry = { static_cast<int16_t>(type_slot), source_id, level, pos };
+        }
+        portEXIT_CRITICAL_SAFE(&policy_mux);
+    }
+    return true;
 }
 
-void EventBridge::publishEvent(EventType type, const String& source, std::shared_ptr<EventData> data, EventPriority priority) {
-    publishEvent(Event(type, source, data, priority));
+bool IRAM_ATTR EventBridge::replaceLatest(int type_slot, EventPriority priority, uint16_t source_id,
+                                          const void* tag, const void* data, uint16_t size) {
+    uint8_t level = static_cast<uint8_t>(priority);
+    bool replaced = false;
+    portENTER_CRITICAL_SAFE(&policy_mux);
+    for (EventLatestEntry& e : latest_entries) {
+        if (e.type_slot != type_slot || e.source_id != source_id || e.level != level) {
+            continue;
+        }
+        EventSlot& slot = queues[level].slots[e.pos & (EVENT_QUEUE_SLOTS - 1)];
+        // Still queued, and the new payload fits where the old one is. An
+        // oversize raw payload falls through to pushSlot(), which drops it
+        if (slot.sequence.load(std::memory_order_acquire) == e.pos + 1 &&
+            (size <= EVENT_INLINE_PAYLOAD || (slot.slab && size <= EVENT_SLAB_BLOCK_SIZE))) {
+            slot.timestamp = millis();
+            slot.payload_tag = tag;
+            slot.payload_size = data ? size : 0;
+            if (data && size > 0) {
+                memcpy(slot.slab ? slot.slab : slot.payload, data, size);
+            }
+            replaced = true;
+        }
+        break;
+    }
+    portEXIT_CRITICAL_SAFE(&policy_mux);
+    return replaced;
 }
 
-bool EventBridge::subscribe(const String& subscriber_id, EventType event_type, EventHandler handler, EventPriority min_priority) {
-    if (!initialized) {
-        LOG_ERROR("EventBridge", "Cannot subscribe: event bridge not initialized");
+bool IRAM_ATTR EventBridge::takeToken(int type_slot, uint16_t source_id) {
+    const EventPolicy& policy = policies[type_slot];
+    uint32_t now = millis();
+    uint32_t cap = (uint32_t)(policy.burst ? policy.burst : 1) * EVENT_TOKEN_MILLI;
+    bool allowed = true;
+    portENTER_CRITICAL_SAFE(&policy_mux);
+    EventRateBucket* bucket = nullptr;
+    for (EventRateBucket& b : rate_buckets) {
+        if (b.type_slot == type_slot && b.source_id == source_id) {
+            bucket = &b;
+            break;
+        }
+        if (b.type_slot < 0 && !bucket) {
+            bucket = &b;
+        }
+    }
+    // With every bucket taken, further sources go unlimited
+    if (bucket) {
+        if (bucket->type_slot < 0) {
+            *bucket = { static_cast<int16_t>(type_slot), source_id, cap, now };
+        }
+        uint64_t refill = (uint64_t)(now - bucket->refill_ms) * policy.rate_per_s;
+        bucket->tokens = (refill >= cap - bucket->tokens) ? cap : bucket->tokens + refill;
+        bucket->refill_ms = now;
+        if (bucket->tokens >= EVENT_TOKEN_MILLI) {
+            bucket->tokens -= EVENT_TOKEN_MILLI;
+        } else {
+            allowed = false;
+        }
+    }
+    portEXIT_CRITICAL_SAFE(&policy_mux);
+    return allowed;
+}
+
+void EventBridge::resetPolicyState() {
+    portENTER_CRITICAL_SAFE(&policy_mux);
+    for (EventLatestEntry& e : latest_entries) {
+        e.type_slot = -1;
+    }
+    for (EventRateBucket& b : rate_buckets) {
+        b.type_slot = -1;
+    }
+    portEXIT_CRITICAL_SAFE(&policy_mux);
+}
+
+bool EventBridge::setDeliveryPolicy(EventType type, EventDeliveryPolicy mode, uint16_t rate_per_s, uint16_t burst) {
+    int type_slot = typeSlot(type);
+    if (type_slot < 0) {
         return false;
     }
+    portENTER_CRITICAL_SAFE(&policy_mux);
+    policies[type_slot] = { mode, rate_per_s, burst };
+    // Buckets start full again at the new rate
+    for (EventRateBucket& b : rate_buckets) {
+        if (b.type_slot == type_slot) {
+            b.type_slot = -1;
+        }
+    }
+    portEXIT_CRITICAL_SAFE(&policy_mux);
+    return true;
+}
+
+EventDeliveryPolicy EventBridge::getDeliveryPolicy(EventType type) const {
+    int type_slot = typeSlot(type);
+    return type_slot < 0 ? EventDeliveryPolicy::QUEUE_ALL : policies[type_slot].mode;
+}
+
+bool PLACE_HOT EventBridge::dispatchNext(EventQueue& queue) {
+    uint32_t pos = queue.dequeue_pos.load(std::memory_order_relaxed);
+    EventSlot& slot = queue.slots[pos & (EVENT_QUEUE_SLOTS - 1)];
+    if ((int32_t)(slot.sequence.load(std::memory_order_acquire) - (pos + 1)) < 0) {
+        return false;  // Empty, or the next producer has not finished writing
+    }
     
-    LOG_INFOF("EventBridge", "Subscribing %s to event %s", 
-              subscriber_id.c_str(), eventTypeToString(event_type).c_str());
+    uint32_t depth = queue.enqueue_pos.load(std::memory_order_relaxed) - pos;
+    if (depth > queue.high_water) {
+        queue.high_water = depth;
+    }
     
-    subscriptions[event_type].emplace_back(subscriber_id, event_type, handler, min_priority);
+    // Inline payloads are copied out so the slot can be handed back to
+    // producers before the handlers run; slab payloads are borrowed until then.
+    // A LATEST slot can be overwritten up to the sequence store, so that
+    // stretch runs under policy_mux
+    bool latest = slot.latest;
+    if (latest) {
+        portENTER_CRITICAL_SAFE(&policy_mux);
+    }
+    alignas(4) uint8_t inline_copy[EVENT_INLINE_PAYLOAD];
+    uint8_t* slab = slot.slab;
+    const void* payload = nullptr;
+    if (slot.payload_size > 0) {
+        if (slab) {
+            payload = slab;
+        } else {
+            memcpy(inline_copy, slot.payload, slot.payload_size);
+            payload = inline_copy;
+        }
+    }
+    Event event(slot.type, slot.source_id, slot.payload_tag, payload, slot.payload_size,
+                slot.priority, slot.timestamp);
+    slot.slab = nullptr;
+    
+    // One lap ahead: a handler that publishes cannot find its own level full
+    slot.sequence.store(pos + EVENT_QUEUE_SLOTS, std::memory_order_release);
+    if (latest) {
+        portEXIT_CRITICAL_SAFE(&policy_mux);
+    }
+    queue.dequeue_pos.store(pos + 1, std::memory_order_release);
+    
+    crash_trace(CRASH_TRACE_EVENT, ((uint32_t)slot.type << 16) | event.getSourceId());
+    uint32_t start = micros();
+    processEvent(event);
+    metrics_observe(METRIC_EVENT_DISPATCH_US, micros() - start);
+    addToHistory(event);
+    events_processed++;
+    metrics_count(METRIC_EVENTS_PROCESSED);
+    freeSlab(slab);
     return true;
 }
 
-bool EventBridge::unsubscribe(const String& subscriber_id, EventType event_type) {
-    auto it = subscriptions.find(event_type);
-    if (it == subscriptions.end()) {
+uint8_t* IRAM_ATTR EventBridge::allocSlab() {
+    uint32_t mask = slab_free.load(std::memory_order_relaxed);
+    while (mask) {
+        uint32_t bit = mask & (~mask + 1);
+        if (slab_free.compare_exchange_weak(mask, mask & ~bit, std::memory_order_acquire)) {
+            return slab_pool + __builtin_ctz(bit) * EVENT_SLAB_BLOCK_SIZE;
+        }
+    }
+    return nullptr;
+}
+
+void EventBridge::freeSlab(uint8_t* block) {
+    if (block) {
+        slab_free.fetch_or(1UL << ((block - slab_pool) / EVENT_SLAB_BLOCK_SIZE), std::memory_order_release);
+    }
+}
+
+uint16_t IRAM_ATTR EventBridge::internSource(const char* name) {
+    if (!name || !name[0]) {
+        return EVENT_SOURCE_UNKNOWN;
+    }
+    
+    uint16_t id = EVENT_SOURCE_UNKNOWN;
+    portENTER_CRITICAL_SAFE(&source_mux);
+    for (uint16_t i = 1; i < source_count; i++) {
+        if (strncmp(source_names[i], name, EVENT_SOURCE_NAME_LEN - 1) == 0) {
+            id = i;
+            break;
+        }
+    }
+    if (id == EVENT_SOURCE_UNKNOWN && source_count < EVENT_SOURCE_MAX) {
+        strncpy(source_names[source_count], name, EVENT_SOURCE_NAME_LEN - 1);
+        source_names[source_count][EVENT_SOURCE_NAME_LEN - 1] = 0;
+        id = source_count++;
+    }
+    portEXIT_CRITICAL_SAFE(&source_mux);
+    return id;
+}
+
+const char* EventBridge::sourceName(uint16_t source_id) {
+    return source_id < source_count ? source_names[source_id] : source_names[EVENT_SOURCE_UNKNOWN];
+}
+
+void EventBridge::resetQueue() {
+    for (EventQueue& queue : queues) {
+        for (uint32_t i = 0; i < EVENT_QUEUE_SLOTS; i++) {
+            queue.slots[i].slab = nullptr;
+            queue.slots[i].latest = false;
+            queue.slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        queue.enqueue_pos.store(0, std::memory_order_relaxed);
+        queue.dequeue_pos.store(0, std::memory_order_relaxed);
+        queue.high_water = 0;
+    }
+}
+
+size_t EventBridge::getQueueSize() const {
+    size_t size = 0;
+    for (const EventQueue& queue : queues) {
+        size += queue.size();
+    }
+    return size;
+}
+
+int EventBridge::typeSlot(EventType type) {
+    int value = static_cast<int>(type);
+    int builtin = static_cast<int>(EventType::BUILTIN_EVENT_COUNT);
+    int custom = value - static_cast<int>(EventType::CUSTOM_EVENT_BASE);
+    
+    if (value >= 0 && value < builtin) {
+        return value;
+    }
+    if (custom >= 0 && custom < EVENT_CUSTOM_TYPES) {
+        return builtin + custom;
+    }
+    return -1;
+}
+
+bool EventBridge::subscribe(uint16_t subscriber_id, EventType event_type, EventHandler handler,
+                            void* context, EventPriority min_priority, uint8_t exec_context) {
+    if (!initialized) {
+        LOG_ERROR("EventBridge", "Cannot subscribe: event bridge not initialized");
         return false;
     }
     
-    auto& subs = it->second;
-    auto sub_it = std::remove_if(subs.begin(), subs.end(),
-        [&subscriber_id](const EventSubscription& sub) {
-            return sub.subscriber_id == subscriber_id;
-        });
+    int slot = typeSlot(event_type);
+    if (slot < 0 || !handler) {
+        LOG_ERRORF("EventBridge", "Cannot subscribe %s: invalid event type %d or handler",
+                   sourceName(subscriber_id), static_cast<int>(event_type));
+        return false;
+    }
     
-    if (sub_it != subs.end()) {
-        subs.erase(sub_it, subs.end());
-        LOG_INFOF("EventBridge", "Unsubscribed %s from event %s", 
-                  subscriber_id.c_str(), eventTypeToString(event_type).c_str());
-        return true;
+    if (exec_context != EVENT_CONTEXT_INLINE && exec_context >= EVENT_CONTEXT_UI + context_count) {
+        LOG_ERRORF("EventBridge", "Cannot subscribe %s: unknown execution context %u",
+                   sourceName(subscriber_id), exec_context);
+        return false;
     }
     
-    return false;
+    LOG_INFOF("EventBridge", "Subscribing %s to event %s on %s", 
+              sourceName(subscriber_id), eventTypeToString(event_type),
+              exec_context == EVENT_CONTEXT_INLINE ? "inline" : contexts[exec_context - EVENT_CONTEXT_UI].name);
+    
+    subscriptions[slot].emplace_back(subscriber_id, handler, context, min_priority, exec_context);
+    return true;
 }
 
-bool EventBridge::unsubscribeAll(const String& subscriber_id) {
+bool EventBridge::removeSubscription(std::vector<EventSubscription>& subs, uint16_t subscriber_id) {
     bool found = false;
     
-    for (auto& pair : subscriptions) {
-        auto& subs = pair.second;
-        auto sub_it = std::remove_if(subs.begin(), subs.end(),
-            [&subscriber_id](const EventSubscription& sub) {
-                return sub.subscriber_id == subscriber_id;
-            });
-        
-        if (sub_it != subs.end()) {
-            subs.erase(sub_it, subs.end());
+    for (auto& sub : subs) {
+        if (sub.active && sub.subscriber_id == subscriber_id) {
+            sub.active = false;
             found = true;
         }
     }
     
+    // A handler may unsubscribe while its row is being walked; compact afterwards
     if (found) {
-        LOG_INFOF("EventBridge", "Unsubscribed %s from all events", subscriber_id.c_str());
+        subscriptions_dirty = true;
+        if (dispatch_depth == 0) {
+            compactSubscriptions();
+        }
+    }
+    return found;
+}
+
+void EventBridge::compactSubscriptions() {
+    for (auto& subs : subscriptions) {
+        subs.erase(std::remove_if(subs.begin(), subs.end(),
+            [](const EventSubscription& sub) {
+                return !sub.active;
+            }), subs.end());
+    }
+    subscriptions_dirty = false;
+}
+
+bool EventBridge::unsubscribe(uint16_t subscriber_id, EventType event_type) {
+    int slot = typeSlot(event_type);
+    if (slot < 0 || !removeSubscription(subscriptions[slot], subscriber_id)) {
+        return false;
+    }
+    
+    LOG_INFOF("EventBridge", "Unsubscribed %s from event %s", 
+              sourceName(subscriber_id), eventTypeToString(event_type));
+    return true;
+}
+
+bool EventBridge::unsubscribeAll(uint16_t subscriber_id) {
+    bool found = false;
+    
+    for (auto& subs : subscriptions) {
+        found |= removeSubscription(subs, subscriber_id);
+    }
+    
+    if (found) {
+        LOG_INFOF("EventBridge", "Unsubscribed %s from all events", sourceName(subscriber_id));
     }
     
     return found;
@@ -204,95 +648,396 @@ void EventBridge::update() {
 }
 
 void EventBridge::processEvents() {
-    if (!initialized || event_queue.empty()) {
+    if (!initialized) {
         return;
     }
     
-    // Process events in priority order (higher priority first)
-    std::sort(event_queue.begin(), event_queue.end(),
-        [](const Event& a, const Event& b) {
-            return static_cast<int>(a.getPriority()) > static_cast<int>(b.getPriority());
-        });
+    uint32_t overflows = queue_overflows.load(std::memory_order_relaxed);
+    if (overflows != overflows_reported) {
+        LOG_WARNF("EventBridge", "Event queue full, dropped %lu events", overflows - overflows_reported);
+        overflows_reported = overflows;
+    }
     
-    // Process all events in queue
-    while (!event_queue.empty()) {
-        Event event = event_queue.front();
-        event_queue.erase(event_queue.begin());
-        
-        processEvent(event);
-        addToHistory(event);
-        events_processed++;
+    // Deliveries routed to the UI context run here, ahead of new events
+    ui_task = xTaskGetCurrentTaskHandle();
+    if (context_count > 0) {
+        drainContext(contexts[0]);
     }
     
-    trimHistory();
+    // Highest level first, FIFO within a level; the budget leaves the rest
+    // queued for the next pass so a burst of telemetry cannot starve input
+    uint32_t start = micros();
+    for (int level = EVENT_PRIORITY_LEVELS - 1; level >= 0; level--) {
+        while (dispatchNext(queues[level])) {
+            if (micros() - start >= dispatch_budget_us) {
+                budget_exhausted++;
+                return;
+            }
+        }
+    }
 }
 
 void EventBridge::processEvent(const Event& event) {
-    auto it = subscriptions.find(event.getType());
-    if (it == subscriptions.end()) {
+    int slot = typeSlot(event.getType());
+    if (slot < 0 || subscriptions[slot].empty()) {
         return; // No subscribers for this event type
     }
     
-    LOG_DEBUGF("EventBridge", "Processing event: %s", eventTypeToString(event.getType()).c_str());
+    std::vector<EventSubscription>& subs = subscriptions[slot];
+    int priority = static_cast<int>(event.getPriority());
     
-    for (const auto& subscription : it->second) {
-        if (!subscription.active) {
+    // Indexed walk: handlers may subscribe more entries to this row
+    dispatch_depth++;
+    for (size_t i = 0; i < subs.size(); i++) {
+        const EventSubscription& subscription = subs[i];
+        if (!subscription.active || priority < static_cast<int>(subscription.min_priority)) {
             continue;
         }
-        
-        // Check priority filter
-        if (static_cast<int>(event.getPriority()) < static_cast<int>(subscription.min_priority)) {
-            continue;
+        deliver(subscription, event);
+    }
+    dispatch_depth--;
+    
+    if (dispatch_depth == 0 && subscriptions_dirty) {
+        compactSubscriptions();
+    }
+}
+
+void EventBridge::invokeHandler(EventHandler handler, void* context, uint16_t subscriber_id, const Event& event) {
+    try {
+        handler(event, context);
+    } catch (const std::exception& e) {
+        LOG_ERRORF("EventBridge", "Exception in event handler for %s: %s", 
+                   sourceName(subscriber_id), e.what());
+    } catch (...) {
+        LOG_ERRORF("EventBridge", "Unknown exception in event handler for %s", 
+                   sourceName(subscriber_id));
+    }
+}
+
+bool EventBridge::deliver(const EventSubscription& sub, const Event& event) {
+    uint8_t index = sub.exec_context - EVENT_CONTEXT_UI;
+    if (sub.exec_context == EVENT_CONTEXT_INLINE || index >= context_count) {
+        invokeHandler(sub.handler, sub.context, sub.subscriber_id, event);
+        return true;
+    }
+    
+    // Already on the target task: queueing would only add latency
+    EventWorker& ctx = contexts[index];
+    TaskHandle_t target = (index == 0) ? ui_task : ctx.task;
+    if (target && target == xTaskGetCurrentTaskHandle()) {
+        invokeHandler(sub.handler, sub.context, sub.subscriber_id, event);
+        ctx.delivered++;
+        return true;
+    }
+    
+    EventDelivery delivery;
+    delivery.handler = sub.handler;
+    delivery.context = sub.context;
+    delivery.subscriber_id = sub.subscriber_id;
+    delivery.type = event.getType();
+    delivery.priority = event.getPriority();
+    delivery.source_id = event.getSourceId();
+    delivery.payload_size = event.getPayloadSize();
+    delivery.timestamp = event.getTimestamp();
+    delivery.payload_tag = event.getPayloadTag();
+    delivery.slab = nullptr;
+    
+    // Each deferred subscriber gets its own copy, the event's payload is gone
+    // once dispatch returns
+    if (event.hasPayload()) {
+        if (delivery.payload_size > EVENT_INLINE_PAYLOAD) {
+            delivery.slab = allocSlab();
+            if (!delivery.slab) {
+                slab_failures.fetch_add(1, std::memory_order_relaxed);
+                ctx.dropped++;
+                return false;
+            }
         }
-        
-        try {
-            subscription.handler(event);
-        } catch (const std::exception& e) {
-            LOG_ERRORF("EventBridge", "Exception in event handler for %s: %s", 
-                       subscription.subscriber_id.c_str(), e.what());
-        } catch (...) {
-            LOG_ERRORF("EventBridge", "Unknown exception in event handler for %s", 
-                       subscription.subscriber_id.c_str());
+        memcpy(delivery.slab ? delivery.slab : delivery.payload, event.getPayloadData(), delivery.payload_size);
+    } else {
+        delivery.payload_size = 0;
+    }
+    
+    // Never block the dispatching task on a slow consumer
+    if (xQueueSend(ctx.queue, &delivery, 0) != pdTRUE) {
+        freeSlab(delivery.slab);
+        ctx.dropped++;
+        return false;
+    }
+    return true;
+}
+
+void EventBridge::runDelivery(EventDelivery& delivery) {
+    const void* payload = nullptr;
+    if (delivery.payload_size > 0) {
+        payload = delivery.slab ? delivery.slab : delivery.payload;
+    }
+    Event event(delivery.type, delivery.source_id, delivery.payload_tag, payload, delivery.payload_size,
+                delivery.priority, delivery.timestamp);
+    
+    invokeHandler(delivery.handler, delivery.context, delivery.subscriber_id, event);
+    freeSlab(delivery.slab);
+}
+
+void EventBridge::drainContext(EventWorker& ctx) {
+    EventDelivery delivery;
+    while (ctx.queue && xQueueReceive(ctx.queue, &delivery, 0) == pdTRUE) {
+        runDelivery(delivery);
+        ctx.delivered++;
+    }
+}
+
+void EventBridge::worker_task_fn(void* param) {
+    EventWorker* worker = (EventWorker*)param;
+    EventDelivery delivery;
+    
+    // Handlers get per-message scratch, given back after each delivery
+    task_arena_create(TASK_ARENA_MESSAGE_INTERNAL, TASK_ARENA_MESSAGE_PSRAM);
+    
+    // A delivery without a handler is the stop request from shutdown()
+    while (xQueueReceive(worker->queue, &delivery, portMAX_DELAY) == pdTRUE) {
+        if (!delivery.handler) {
+            break;
         }
+        worker->bridge->runDelivery(delivery);
+        worker->delivered++;
+        task_arena_reset();
+    }
+    
+    task_arena_destroy();
+    worker->task = nullptr;
+    vTaskDelete(nullptr);
+}
+
+bool EventBridge::initContext(EventWorker& ctx, const char* name) {
+    strncpy(ctx.name, name, EVENT_WORKER_NAME_LEN - 1);
+    ctx.name[EVENT_WORKER_NAME_LEN - 1] = 0;
+    ctx.queue = xQueueCreate(EVENT_CONTEXT_QUEUE_LEN, sizeof(EventDelivery));
+    ctx.task = nullptr;
+    ctx.bridge = this;
+    ctx.delivered = 0;
+    ctx.dropped = 0;
+    
+    if (!ctx.queue) {
+        LOG_ERRORF("EventBridge", "No memory for %s delivery queue", name);
+        return false;
     }
+    return true;
+}
+
+uint8_t EventBridge::createWorker(const char* name, BaseType_t core, UBaseType_t priority, uint32_t stack_size) {
+    if (!initialized || !name || !name[0]) {
+        LOG_ERROR("EventBridge", "Cannot create worker: event bridge not initialized or no name");
+        return EVENT_CONTEXT_INLINE;
+    }
+    
+    // Services share workers by name
+    for (uint8_t i = 1; i < context_count; i++) {
+        if (strncmp(contexts[i].name, name, EVENT_WORKER_NAME_LEN - 1) == 0) {
+            return EVENT_CONTEXT_UI + i;
+        }
+    }
+    
+    if (context_count == 0 || context_count >= 1 + EVENT_WORKER_MAX) {
+        LOG_ERRORF("EventBridge", "Cannot create worker %s: limit of %d reached", name, EVENT_WORKER_MAX);
+        return EVENT_CONTEXT_INLINE;
+    }
+    
+    EventWorker& worker = contexts[context_count];
+    if (!initContext(worker, name)) {
+        return EVENT_CONTEXT_INLINE;
+    }
+    
+    TaskHandle_t task = nullptr;
+    if (xTaskCreatePinnedToCore(worker_task_fn, worker.name, stack_size, &worker, priority, &task, core) != pdPASS) {
+        LOG_ERRORF("EventBridge", "Failed to start worker %s", name);
+        vQueueDelete(worker.queue);
+        worker.queue = nullptr;
+        return EVENT_CONTEXT_INLINE;
+    }
+    worker.task = task;
+    
+    LOG_INFOF("EventBridge", "Worker %s started on core %d", name, (int)core);
+    return EVENT_CONTEXT_UI + context_count++;
+}
+
+void EventBridge::deinitContexts() {
+    EventDelivery stop;
+    memset(&stop, 0, sizeof(stop));
+    
+    // Workers run what is already queued, then exit on the stop request
+    for (uint8_t i = 1; i < context_count; i++) {
+        EventWorker& worker = contexts[i];
+        if (worker.task && xQueueSend(worker.queue, &stop, pdMS_TO_TICKS(100)) == pdTRUE) {
+            for (int wait = 0; wait < 50 && worker.task; wait++) {
+                vTaskDelay(pdMS_TO_TICKS(10));
+            }
+        }
+        if (worker.task) {
+            LOG_WARNF("EventBridge", "Worker %s did not stop, deleting it", worker.name);
+            vTaskDelete(worker.task);
+            worker.task = nullptr;
+        }
+    }
+    
+    // Whatever is left never runs; hand its slabs back
+    for (uint8_t i = 0; i < context_count; i++) {
+        EventDelivery delivery;
+        while (xQueueReceive(contexts[i].queue, &delivery, 0) == pdTRUE) {
+            freeSlab(delivery.slab);
+        }
+        vQueueDelete(contexts[i].queue);
+        contexts[i].queue = nullptr;
+    }
+    context_count = 0;
+    ui_task = nullptr;
+}
+
+uint32_t EventBridge::getContextDropped(uint8_t exec_context) const {
+    uint8_t index = exec_context - EVENT_CONTEXT_UI;
+    return (exec_context != EVENT_CONTEXT_INLINE && index < context_count) ? contexts[index].dropped : 0;
 }
 
 void EventBridge::addToHistory(const Event& event) {
-    event_history.push_back(event);
-    trimHistory();
+    if (!trace_capacity) {
+        return;
+    }
+    
+    EventTraceRecord& record = trace[trace_written % trace_capacity];
+    record.timestamp = event.getTimestamp();
+    record.type = static_cast<uint16_t>(event.getType());
+    record.source_id = event.getSourceId();
+    record.priority = static_cast<uint8_t>(event.getPriority());
+    record.flags = 0;
+    record.payload_hash = 0;
+    
+    // FNV-1a identifies repeated payloads without keeping them
+    if (event.hasPayload()) {
+        const uint8_t* bytes = static_cast<const uint8_t*>(event.getPayloadData());
+        uint32_t hash = 2166136261UL;
+        for (uint16_t i = 0; i < event.getPayloadSize(); i++) {
+            hash = (hash ^ bytes[i]) * 16777619UL;
+        }
+        record.flags |= EVENT_TRACE_FLAG_PAYLOAD;
+        record.payload_hash = (uint16_t)(hash ^ (hash >> 16));
+    }
+    trace_written++;
+}
+
+const EventTraceRecord* EventBridge::getTraceRecord(size_t index) const {
+    size_t held = getHistorySize();
+    if (index >= held) {
+        return nullptr;
+    }
+    return &trace[(trace_written - held + index) % trace_capacity];
+}
+
+uint32_t EventBridge::traceStart(const uint32_t* cursor) const {
+    // Records older than the ring are gone; resume from the oldest one held
+    uint32_t oldest = trace_written - getHistorySize();
+    if (!cursor || *cursor < oldest || *cursor > trace_written) {
+        return oldest;
+    }
+    return *cursor;
+}
+
+size_t EventBridge::exportTrace(Print& out, uint32_t* cursor) const {
+    size_t exported = 0;
+    
+    for (uint32_t seq = traceStart(cursor); seq < trace_written; seq++) {
+        const EventTraceRecord& r = trace[seq % trace_capacity];
+        out.printf("%lu,%lu,%s,%s,%s,%04x\n", (unsigned long)seq, (unsigned long)r.timestamp,
+                   eventTypeToString(static_cast<EventType>(r.type)), sourceName(r.source_id),
+                   eventPriorityToString(static_cast<EventPriority>(r.priority)), r.payload_hash);
+        exported++;
+    }
+    
+    if (cursor) {
+        *cursor = trace_written;
+    }
+    return exported;
 }
 
-void EventBridge::trimHistory() {
-    while (event_history.size() > max_history_size) {
-        event_history.erase(event_history.begin());
+size_t EventBridge::exportTrace(EventTraceWriter writer, void* context, uint32_t* cursor) const {
+    if (!writer) {
+        return 0;
     }
+    
+    // Records are sent straight out of the ring; a wrap splits a chunk in two
+    size_t exported = 0;
+    uint32_t seq = traceStart(cursor);
+    while (seq < trace_written) {
+        uint32_t index = seq % trace_capacity;
+        uint32_t count = std::min<uint32_t>(trace_written - seq, EVENT_TRACE_CHUNK_RECORDS);
+        count = std::min<uint32_t>(count, trace_capacity - index);
+        if (!writer((const uint8_t*)&trace[index], count * sizeof(EventTraceRecord), context)) {
+            break;
+        }
+        seq += count;
+        exported += count;
+    }
+    
+    if (cursor) {
+        *cursor = seq;
+    }
+    return exported;
 }
 
 size_t EventBridge::getSubscriptionCount() const {
     size_t count = 0;
-    for (const auto& pair : subscriptions) {
-        count += pair.second.size();
+    for (const auto& subs : subscriptions) {
+        count += subs.size();
     }
     return count;
 }
 
 size_t EventBridge::getSubscriptionCount(EventType event_type) const {
-    auto it = subscriptions.find(event_type);
-    return it != subscriptions.end() ? it->second.size() : 0;
+    int slot = typeSlot(event_type);
+    return slot >= 0 ? subscriptions[slot].size() : 0;
 }
 
 void EventBridge::printStatus() const {
     LOG_INFO("EventBridge", "=== Event Bridge Status ===");
     LOG_INFOF("EventBridge", "Initialized: %s", initialized ? "true" : "false");
     LOG_INFOF("EventBridge", "Processing enabled: %s", processing_enabled ? "true" : "false");
-    LOG_INFOF("EventBridge", "Queue size: %d/%d", event_queue.size(), max_queue_size);
-    LOG_INFOF("EventBridge", "History size: %d/%d", event_history.size(), max_history_size);
+    LOG_INFOF("EventBridge", "Queue size: %d (%d per level)", getQueueSize(), max_queue_size);
+    for (int level = EVENT_PRIORITY_LEVELS - 1; level >= 0; level--) {
+        LOG_INFOF("EventBridge", "  %s: %d queued, high water %lu",
+                  eventPriorityToString(static_cast<EventPriority>(level)),
+                  queues[level].size(), queues[level].high_water);
+    }
+    LOG_INFOF("EventBridge", "Dispatched inline: %lu, budget exhausted: %lu", events_inline, budget_exhausted);
+    LOG_INFOF("EventBridge", "Payload slabs: %u/%u free, %lu failures, %u sources",
+              getSlabBlocksFree(), EVENT_SLAB_BLOCKS, getSlabFailures(), source_count);
+    for (uint8_t i = 0; i < context_count; i++) {
+        LOG_INFOF("EventBridge", "  Context %u (%s): %u queued, %lu delivered, %lu dropped",
+                  EVENT_CONTEXT_UI + i, contexts[i].name, (unsigned)uxQueueMessagesWaiting(contexts[i].queue),
+                  contexts[i].delivered, contexts[i].dropped);
+    }
+    LOG_INFOF("EventBridge", "Trace: %d/%d records, %lu written", getHistorySize(), trace_capacity, trace_written);
     LOG_INFOF("EventBridge", "Total subscriptions: %d", getSubscriptionCount());
     LOG_INFOF("EventBridge", "Events processed: %lu", events_processed);
-    LOG_INFOF("EventBridge", "Events dropped: %lu", events_dropped);
+    LOG_INFOF("EventBridge", "Events dropped: %lu (%lu queue overflows)",
+              getEventsDropped(), getQueueOverflows());
+    LOG_INFOF("EventBridge", "Events coalesced: %lu, rate limited: %lu",
+              getEventsCoalesced(), getEventsRateLimited());
+}
+
+void EventBridge::printSubscriptions() const {
+    LOG_INFO("EventBridge", "=== Event Subscriptions ===");
+    for (int slot = 0; slot < EVENT_TYPE_SLOTS; slot++) {
+        int builtin = static_cast<int>(EventType::BUILTIN_EVENT_COUNT);
+        EventType type = static_cast<EventType>(slot < builtin ? slot :
+                         static_cast<int>(EventType::CUSTOM_EVENT_BASE) + slot - builtin);
+        for (const auto& sub : subscriptions[slot]) {
+            LOG_INFOF("EventBridge", "%s -> %s (min %s)%s", eventTypeToString(type),
+                      sourceName(sub.subscriber_id), eventPriorityToString(sub.min_priority),
+                      sub.active ? "" : " inactive");
+        }
+    }
 }
 
-String EventBridge::eventTypeToString(EventType type) {
+const char* EventBridge::eventTypeToString(EventType type) {
     switch (type) {
         case EventType::HARDWARE_INITIALIZED: return "HARDWARE_INITIALIZED";
         case EventType::HARDWARE_ERROR: return "HARDWARE_ERROR";
@@ -306,11 +1051,13 @@ String EventBridge::eventTypeToString(EventType type) {
         case EventType::SD_CARD_REMOVED: return "SD_CARD_REMOVED";
         case EventType::BATTERY_LOW: return "BATTERY_LOW";
         case EventType::BATTERY_CHARGING: return "BATTERY_CHARGING";
+        case EventType::MOTION_STATE: return "MOTION_STATE";
         case EventType::SYSTEM_STARTUP: return "SYSTEM_STARTUP";
         case EventType::SYSTEM_SHUTDOWN: return "SYSTEM_SHUTDOWN";
         case EventType::SERVICE_STARTED: return "SERVICE_STARTED";
         case EventType::SERVICE_STOPPED: return "SERVICE_STOPPED";
         case EventType::SERVICE_ERROR: return "SERVICE_ERROR";
+        case EventType::TASK_WATCH_ALERT: return "TASK_WATCH_ALERT";
         case EventType::APP_LAUNCHED: return "APP_LAUNCHED";
         case EventType::APP_CLOSED: return "APP_CLOSED";
         case EventType::APP_ERROR: return "APP_ERROR";
@@ -319,14 +1066,21 @@ String EventBridge::eventTypeToString(EventType type) {
         case EventType::MQTT_MESSAGE_RECEIVED: return "MQTT_MESSAGE_RECEIVED";
         case EventType::LORA_MESSAGE_RECEIVED: return "LORA_MESSAGE_RECEIVED";
         case EventType::GPS_LOCATION_UPDATE: return "GPS_LOCATION_UPDATE";
+        case EventType::GEOFENCE_CROSSED: return "GEOFENCE_CROSSED";
+        case EventType::LORA_TELEMETRY: return "LORA_TELEMETRY";
+        case EventType::NETWORK_ROUTE_CHANGED: return "NETWORK_ROUTE_CHANGED";
+        case EventType::SUBSYSTEM_POWER: return "SUBSYSTEM_POWER";
+        case EventType::DOWNLOAD_PROGRESS: return "DOWNLOAD_PROGRESS";
         case EventType::USER_INPUT: return "USER_INPUT";
         case EventType::MENU_SELECTED: return "MENU_SELECTED";
         case EventType::BUTTON_PRESSED: return "BUTTON_PRESSED";
+        case EventType::FS_COMPLETE: return "FS_COMPLETE";
+        case EventType::CONFIG_CHANGED: return "CONFIG_CHANGED";
         default: return "UNKNOWN_EVENT";
     }
 }
 
-String EventBridge::eventPriorityToString(EventPriority priority) {
+const char* EventBridge::eventPriorityToString(EventPriority priority) {
     switch (priority) {
         case EventPriority::EVENT_LOW: return "LOW";
         case EventPriority::NORMAL: return "NORMAL";
@@ -15,16 +15,58 @@
 
 #include <Arduino.h>
 #include <vector>
-#include <map>
-#include <functional>
 #include <memory>
+#include <atomic>
+#include <type_traits>
 #include "simple_logger.h"
+#include "fixed_string.h"
 #include "service_container.h"
 
+// Bounded publish queues shared by every producer task and ISR, one per priority
+#define EVENT_PRIORITY_LEVELS       4
+#define EVENT_QUEUE_SLOTS           64    // Per level, power of two, upper bound for setMaxQueueSize()
+#define EVENT_DISPATCH_BUDGET_US    2000  // processEvents() yields to the caller after this long
+
+// Event payloads: small ones ride in the queue slot, larger ones in a PSRAM slab
+#define EVENT_INLINE_PAYLOAD        16
+#define EVENT_SLAB_BLOCKS           32    // One bit each in an atomic free mask
+#define EVENT_SLAB_BLOCK_SIZE       256   // Largest payload
+
+// Interned publisher and subscriber names, referenced by ID
+#define EVENT_SOURCE_MAX            32
+#define EVENT_SOURCE_NAME_LEN       24
+#define EVENT_SOURCE_UNKNOWN        0
+
+// Delivery policies, see EventBridge::setDeliveryPolicy()
+#define EVENT_LATEST_ENTRIES        32    // Pending events that can be overwritten, across LATEST types
+#define EVENT_RATE_BUCKETS          32    // Token buckets, one per type and source across RATE_LIMIT types
+#define EVENT_TOKEN_MILLI           1000  // One event's worth of tokens
+
+// Event::toString(), longer text is cut
+#define EVENT_TEXT_SIZE             128
+
+// Subscription table: one row per built-in type plus a block of custom types
+#define EVENT_CUSTOM_TYPES          32    // CUSTOM_EVENT_BASE .. CUSTOM_EVENT_BASE + 31
+
+// Event trace: compact records of dispatched events, oldest overwritten
+#define EVENT_TRACE_RECORDS         256   // Default capacity, see setMaxHistorySize()
+#define EVENT_TRACE_CHUNK_RECORDS   32    // Records per binary export chunk, 384 bytes fits MAX_MQTT_MESSAGE_SIZE
+#define EVENT_TRACE_FLAG_PAYLOAD    0x01
+
+// Handler execution contexts; worker IDs follow, see EventBridge::createWorker()
+#define EVENT_CONTEXT_INLINE        0     // Wherever the event is dispatched
+#define EVENT_CONTEXT_UI            1     // The task that calls processEvents()
+#define EVENT_WORKER_MAX            4
+#define EVENT_CONTEXT_QUEUE_LEN     16    // Pending deliveries per deferred context
+#define EVENT_WORKER_STACK          4096
+#define EVENT_WORKER_NAME_LEN       16
+
 // Forward declarations
 class EventBridge;
 class Event;
 
+typedef FixedString<EVENT_TEXT_SIZE> EventText;
+
 /**
  * @brief Event Types
  * 
@@ -40,10 +82,11 @@ enum class EventType {
     TOUCH_RELEASED,
     WIFI_CONNECTED,
     WIFI_DISCONNECTED,
-    SD_CARD_INSERTED,
-    SD_CARD_REMOVED,
+    SD_CARD_INSERTED,       // SdCardEvent payload
+    SD_CARD_REMOVED,        // SdCardEvent payload, removed or ejected
     BATTERY_LOW,
     BATTERY_CHARGING,
+    MOTION_STATE,           // MotionStateEvent payload
     
     // System events
     SYSTEM_STARTUP,
@@ -51,6 +94,7 @@ enum class EventType {
     SERVICE_STARTED,
     SERVICE_STOPPED,
     SERVICE_ERROR,
+    TASK_WATCH_ALERT,       // TaskWatchEvent payload
     
     // Application events
     APP_LAUNCHED,
@@ -63,12 +107,25 @@ enum class EventType {
     MQTT_MESSAGE_RECEIVED,
     LORA_MESSAGE_RECEIVED,
     GPS_LOCATION_UPDATE,
+    GEOFENCE_CROSSED,       // GeofenceEvent payload
+    LORA_TELEMETRY,
+    NETWORK_ROUTE_CHANGED,  // NetRouteEvent payload
+    SUBSYSTEM_POWER,        // uint32_t payload, see energy_mark()
+    DOWNLOAD_PROGRESS,      // DlProgressEvent payload
     
     // User events
     USER_INPUT,
     MENU_SELECTED,
     BUTTON_PRESSED,
     
+    // Storage events
+    FS_COMPLETE,            // FsResult payload, requests queued without a callback
+    
+    // Configuration events
+    CONFIG_CHANGED,         // One per coalesced batch, ConfigChangedEvent payload
+    
+    BUILTIN_EVENT_COUNT,    // Not an event, sizes the subscription table
+    
     // Custom events (for extensibility)
     CUSTOM_EVENT_BASE = 1000
 };
@@ -84,92 +141,217 @@ enum class EventPriority {
 };
 
 /**
- * @brief Event Data Base Class
+ * @brief Event Delivery Policy
  * 
- * Base class for all event data payloads
+ * Per event type, for high-rate producers whose consumers only want the
+ * newest value. CRITICAL events always take QUEUE_ALL
  */
-class EventData {
-public:
-    virtual ~EventData() = default;
-    virtual String toString() const { return "EventData"; }
+enum class EventDeliveryPolicy : uint8_t {
+    QUEUE_ALL = 0,
+    LATEST,                 // An event still queued from the same source and level is overwritten
+    RATE_LIMIT              // Token bucket per source, events over the rate are dropped
 };
 
 /**
- * @brief Generic Event Data Template
+ * @brief Event Payload Type Tag
  * 
- * Template for strongly-typed event data
+ * The address of id is unique per payload type, so typed access is
+ * checked without RTTI
  */
 template<typename T>
-class TypedEventData : public EventData {
-private:
-    T data;
-    
-public:
-    TypedEventData(const T& d) : data(d) {}
-    
-    const T& getData() const { return data; }
-    T& getData() { return data; }
-    
-    String toString() const override {
-        return "TypedEventData<" + String(typeid(T).name()) + ">";
-    }
+struct EventPayloadTag {
+    static const char id;
 };
 
+template<typename T>
+const char EventPayloadTag<T>::id = 0;
+
 /**
  * @brief Event Class
  * 
- * Represents a single event in the system
+ * Represents a single event in the system. The payload is borrowed from
+ * the queue slot (or the publisher) and is only valid during dispatch.
  */
 class Event {
 private:
     EventType type;
     EventPriority priority;
-    String source;
+    uint16_t source_id;
+    uint16_t payload_size;
     uint32_t timestamp;
-    std::shared_ptr<EventData> data;
+    const void* payload_tag;
+    const void* payload;
     bool handled;
     
 public:
-    Event(EventType t, const String& src, EventPriority p = EventPriority::NORMAL);
-    Event(EventType t, const String& src, std::shared_ptr<EventData> d, EventPriority p = EventPriority::NORMAL);
+    Event(EventType t, uint16_t src, EventPriority p = EventPriority::NORMAL);
+    Event(EventType t, uint16_t src, const void* tag, const void* data, uint16_t size,
+          EventPriority p, uint32_t ts);
     
     // Getters
     EventType getType() const { return type; }
     EventPriority getPriority() const { return priority; }
-    const String& getSource() const { return source; }
+    uint16_t getSourceId() const { return source_id; }
+    const char* getSource() const;
     uint32_t getTimestamp() const { return timestamp; }
-    std::shared_ptr<EventData> getData() const { return data; }
+    const void* getPayloadTag() const { return payload_tag; }
+    const void* getPayloadData() const { return payload; }
+    uint16_t getPayloadSize() const { return payload_size; }
+    bool hasPayload() const { return payload != nullptr; }
     bool isHandled() const { return handled; }
     
     // Setters
     void setHandled(bool h = true) { handled = h; }
     
-    // Utility methods
+    // Typed payload, nullptr if the event carries another type
     template<typename T>
-    std::shared_ptr<TypedEventData<T>> getTypedData() const;
+    const T* getPayload() const;
     
-    String toString() const;
+    EventText toString() const;
+};
+
+/**
+ * @brief Event Queue Slot
+ * 
+ * Fixed-size ring entry; publishing never touches the heap. sequence
+ * implements the bounded MPMC scheme: a slot is free when it equals the
+ * enqueue position and holds data when it is one past it.
+ */
+struct EventSlot {
+    std::atomic<uint32_t> sequence;
+    EventType type;
+    EventPriority priority;
+    uint16_t source_id;
+    uint16_t payload_size;
+    uint32_t timestamp;
+    const void* payload_tag;        // nullptr when the event has no payload
+    uint8_t* slab;                  // Slab block for payloads above EVENT_INLINE_PAYLOAD
+    bool latest;                    // LATEST policy: payload may be overwritten until dequeued
+    alignas(4) uint8_t payload[EVENT_INLINE_PAYLOAD];
+};
+
+/**
+ * @brief Event Queue
+ * 
+ * One priority level: a multi-producer/single-consumer FIFO of slots
+ */
+struct EventQueue {
+    EventSlot slots[EVENT_QUEUE_SLOTS];
+    std::atomic<uint32_t> enqueue_pos;
+    std::atomic<uint32_t> dequeue_pos;      // Written by processEvents() only
+    uint32_t high_water;
+    
+    size_t size() const { return enqueue_pos.load(std::memory_order_relaxed) - dequeue_pos.load(std::memory_order_relaxed); }
 };
 
 /**
  * @brief Event Handler Function Type
  */
-typedef std::function<void(const Event&)> EventHandler;
+typedef void (*EventHandler)(const Event& event, void* context);
 
 /**
  * @brief Event Subscription Information
  */
 struct EventSubscription {
-    String subscriber_id;
-    EventType event_type;
     EventHandler handler;
+    void* context;
+    uint16_t subscriber_id;         // Interned name, see EventBridge::internSource()
     EventPriority min_priority;
+    uint8_t exec_context;           // EVENT_CONTEXT_* or a worker ID
     bool active;
     
-    EventSubscription(const String& id, EventType type, EventHandler h, EventPriority min_p = EventPriority::EVENT_LOW)
-        : subscriber_id(id), event_type(type), handler(h), min_priority(min_p), active(true) {}
+    EventSubscription(uint16_t id, EventHandler h, void* ctx, EventPriority min_p, uint8_t exec)
+        : handler(h), context(ctx), subscriber_id(id), min_priority(min_p), exec_context(exec), active(true) {}
+};
+
+/**
+ * @brief Deferred Handler Call
+ * 
+ * Queued by value to the UI or a worker context. The payload is copied,
+ * into the record or a slab block, since the queue slot is reused first.
+ * A delivery already queued still runs if its subscriber unsubscribes.
+ */
+struct EventDelivery {
+    EventHandler handler;
+    void* context;
+    uint16_t subscriber_id;
+    EventType type;
+    EventPriority priority;
+    uint16_t source_id;
+    uint16_t payload_size;
+    uint32_t timestamp;
+    const void* payload_tag;
+    uint8_t* slab;                  // Freed by the receiving context
+    alignas(4) uint8_t payload[EVENT_INLINE_PAYLOAD];
+};
+
+/**
+ * @brief Deferred Execution Context
+ * 
+ * A delivery queue plus, for workers, the task pinned to a core that drains it
+ */
+struct EventWorker {
+    char name[EVENT_WORKER_NAME_LEN];
+    QueueHandle_t queue;
+    TaskHandle_t volatile task;     // nullptr for the UI context and once a worker has exited
+    EventBridge* bridge;
+    uint32_t delivered;
+    uint32_t dropped;
+};
+
+/**
+ * @brief Event Trace Record
+ * 
+ * 12-byte summary of one dispatched event, also the binary export format
+ * (little-endian, as stored)
+ */
+struct EventTraceRecord {
+    uint32_t timestamp;
+    uint16_t type;
+    uint16_t source_id;
+    uint8_t priority;
+    uint8_t flags;                  // EVENT_TRACE_FLAG_*
+    uint16_t payload_hash;          // FNV-1a of the payload folded to 16 bits, 0 without one
+};
+
+/**
+ * @brief Trace export sink
+ * 
+ * Receives binary chunks of records, e.g. for publishing on
+ * MQTT_TOPIC_TELEMETRY. Returning false stops the export.
+ */
+typedef bool (*EventTraceWriter)(const uint8_t* data, size_t len, void* context);
+
+/**
+ * @brief Delivery policy state
+ * 
+ * A LATEST entry points at the queue position of the last event queued for
+ * its type and source; once that slot has been dequeued the entry is stale
+ * and free for reuse. Buckets hold thousandths of an event.
+ */
+struct EventPolicy {
+    EventDeliveryPolicy mode;
+    uint16_t rate_per_s;
+    uint16_t burst;
+};
+
+struct EventLatestEntry {
+    int16_t type_slot;              // -1 when free
+    uint16_t source_id;
+    uint8_t level;
+    uint32_t pos;
+};
+
+struct EventRateBucket {
+    int16_t type_slot;              // -1 when free
+    uint16_t source_id;
+    uint32_t tokens;                // EVENT_TOKEN_MILLI per event
+    uint32_t refill_ms;
 };
 
+// Row count of the subscription table
+#define EVENT_TYPE_SLOTS    (static_cast<int>(EventType::BUILTIN_EVENT_COUNT) + EVENT_CUSTOM_TYPES)
+
 /**
  * @brief Event Bridge Class
  * 
@@ -178,20 +360,56 @@ struct EventSubscription {
  */
 class EventBridge : public IService {
 private:
-    std::map<EventType, std::vector<EventSubscription>> subscriptions;
-    std::vector<Event> event_queue;
-    std::vector<Event> event_history;
+    std::vector<EventSubscription> subscriptions[EVENT_TYPE_SLOTS];  // Indexed by typeSlot()
+    uint8_t dispatch_depth;         // Unsubscribes while > 0 only deactivate
+    bool subscriptions_dirty;       // Inactive entries waiting to be compacted
+    
+    // Event trace ring, written by the consumer only
+    EventTraceRecord* trace;
+    size_t trace_capacity;
+    uint32_t trace_written;         // Records ever written, the next record's sequence number
+    
+    // Deferred execution contexts: [0] is EVENT_CONTEXT_UI, workers follow
+    EventWorker contexts[1 + EVENT_WORKER_MAX];
+    uint8_t context_count;
+    TaskHandle_t ui_task;           // Last caller of processEvents()
     
-    bool initialized;
+    // Lock-free publish rings indexed by EventPriority, drained highest first
+    EventQueue queues[EVENT_PRIORITY_LEVELS];
+    
+    // Payload slab pool in PSRAM, claimed and released with one CAS
+    uint8_t* slab_pool;
+    std::atomic<uint32_t> slab_free;        // Bit set = block free
+    std::atomic<uint32_t> slab_failures;
+    
+    // Delivery policies by typeSlot(); policy_mux also covers the slots of LATEST events
+    EventPolicy policies[EVENT_TYPE_SLOTS];
+    EventLatestEntry latest_entries[EVENT_LATEST_ENTRIES];
+    EventRateBucket rate_buckets[EVENT_RATE_BUCKETS];
+    static portMUX_TYPE policy_mux;
+    std::atomic<uint32_t> events_coalesced;
+    std::atomic<uint32_t> events_rate_limited;
+    
+    // Interned source names, shared by every bridge instance
+    static char source_names[EVENT_SOURCE_MAX][EVENT_SOURCE_NAME_LEN];
+    static uint16_t source_count;
+    static portMUX_TYPE source_mux;
+    
+    volatile bool initialized;
     size_t max_queue_size;
     size_t max_history_size;
     uint32_t events_processed;
-    uint32_t events_dropped;
+    std::atomic<uint32_t> events_dropped;   // Overflows plus events rejected while disabled
+    std::atomic<uint32_t> queue_overflows;
+    uint32_t overflows_reported;
+    uint32_t events_inline;         // CRITICAL events dispatched by the publisher
+    uint32_t budget_exhausted;      // processEvents() passes cut short by the budget
     
     // Processing control
     bool processing_enabled;
     uint32_t last_process_time;
     uint32_t process_interval_ms;
+    uint32_t dispatch_budget_us;
     
 public:
     EventBridge();
@@ -203,19 +421,45 @@ public:
     const char* getServiceName() const override { return "EventBridge"; }
     bool isInitialized() const override { return initialized; }
     
-    // Event publishing
+    // Event publishing (tasks; CRITICAL events dispatch on the caller)
     void publishEvent(const Event& event);
-    void publishEvent(EventType type, const String& source, EventPriority priority = EventPriority::NORMAL);
-    void publishEvent(EventType type, const String& source, std::shared_ptr<EventData> data, EventPriority priority = EventPriority::NORMAL);
+    void publishEvent(EventType type, const char* source, EventPriority priority = EventPriority::NORMAL);
+    void publishEvent(EventType type, StrView source, EventPriority priority = EventPriority::NORMAL);
     
-    // Template for easy typed event publishing
+    // Typed payloads are copied bytewise into the queue, no allocation
     template<typename T>
-    void publishTypedEvent(EventType type, const String& source, const T& data, EventPriority priority = EventPriority::NORMAL);
+    bool publishTypedEvent(EventType type, const char* source, const T& data, EventPriority priority = EventPriority::NORMAL);
+    
+    // Non-blocking publish for FreeRTOS tasks and ISRs, false if the level is full.
+    // value arrives as a uint32_t payload
+    bool tryPublish(EventType type, const char* source, EventPriority priority = EventPriority::NORMAL);
+    bool tryPublish(EventType type, const char* source, uint32_t value, EventPriority priority = EventPriority::NORMAL);
+    bool publishPayload(EventType type, uint16_t source_id, EventPriority priority,
+                        const void* tag, const void* data, uint16_t size);
+    
+    // Source interning; safe from ISRs, names longer than the slot are truncated
+    static uint16_t internSource(const char* name);
+    static const char* sourceName(uint16_t source_id);
     
     // Event subscription
-    bool subscribe(const String& subscriber_id, EventType event_type, EventHandler handler, EventPriority min_priority = EventPriority::EVENT_LOW);
-    bool unsubscribe(const String& subscriber_id, EventType event_type);
-    bool unsubscribeAll(const String& subscriber_id);
+    bool subscribe(uint16_t subscriber_id, EventType event_type, EventHandler handler,
+                   void* context = nullptr, EventPriority min_priority = EventPriority::EVENT_LOW,
+                   uint8_t exec_context = EVENT_CONTEXT_INLINE);
+    bool subscribe(const char* subscriber, EventType event_type, EventHandler handler,
+                   void* context = nullptr, EventPriority min_priority = EventPriority::EVENT_LOW,
+                   uint8_t exec_context = EVENT_CONTEXT_INLINE) {
+        return subscribe(internSource(subscriber), event_type, handler, context, min_priority, exec_context);
+    }
+    
+    // Named worker task for slow handlers (SD, MQTT); an existing name returns
+    // its ID. Returns the context ID for subscribe(), EVENT_CONTEXT_INLINE on failure
+    uint8_t createWorker(const char* name, BaseType_t core, UBaseType_t priority = 1,
+                         uint32_t stack_size = EVENT_WORKER_STACK);
+    bool unsubscribe(uint16_t subscriber_id, EventType event_type);
+    bool unsubscribe(const char* subscriber, EventType event_type) {
+        return unsubscribe(internSource(subscriber), event_type);
+    }
+    bool unsubscribeAll(uint16_t subscriber_id);
     
     // Event processing
     void processEvents();
@@ -223,30 +467,81 @@ public:
     void update(); // Called from main loop
 
     // Configuration
-    void setMaxQueueSize(size_t size) { max_queue_size = size; }
-    void setMaxHistorySize(size_t size) { max_history_size = size; }
+    void setMaxQueueSize(size_t size) { max_queue_size = size < 1 ? 1 : (size > EVENT_QUEUE_SLOTS ? EVENT_QUEUE_SLOTS : size); }
+    void setMaxHistorySize(size_t size) { max_history_size = size; }  // Trace capacity, applied by initialize()
     void setProcessInterval(uint32_t interval_ms) { process_interval_ms = interval_ms; }
     void setProcessingEnabled(bool enabled) { processing_enabled = enabled; }
+    void setDispatchBudget(uint32_t budget_us) { dispatch_budget_us = budget_us; }
+    
+    // QUEUE_ALL by default; GPS fixes and LoRa telemetry start as LATEST.
+    // rate_per_s and burst apply to RATE_LIMIT, burst being the bucket size;
+    // a rate of 0 lets each source through burst times and no more
+    bool setDeliveryPolicy(EventType type, EventDeliveryPolicy mode, uint16_t rate_per_s = 0, uint16_t burst = 1);
+    EventDeliveryPolicy getDeliveryPolicy(EventType type) const;
     
     // Status and diagnostics
-    size_t getQueueSize() const { return event_queue.size(); }
-    size_t getHistorySize() const { return event_history.size(); }
+    size_t getQueueSize() const;
+    size_t getQueueSize(EventPriority priority) const { return queues[static_cast<int>(priority)].size(); }
+    size_t getHistorySize() const { return trace_written < trace_capacity ? trace_written : trace_capacity; }
     size_t getSubscriptionCount() const;
     size_t getSubscriptionCount(EventType event_type) const;
     uint32_t getEventsProcessed() const { return events_processed; }
-    uint32_t getEventsDropped() const { return events_dropped; }
+    uint32_t getEventsDropped() const { return events_dropped.load(std::memory_order_relaxed); }
+    uint32_t getQueueOverflows() const { return queue_overflows.load(std::memory_order_relaxed); }
+    uint32_t getEventsInline() const { return events_inline; }
+    uint32_t getBudgetExhausted() const { return budget_exhausted; }
+    uint32_t getSlabFailures() const { return slab_failures.load(std::memory_order_relaxed); }
+    uint32_t getEventsCoalesced() const { return events_coalesced.load(std::memory_order_relaxed); }
+    uint32_t getEventsRateLimited() const { return events_rate_limited.load(std::memory_order_relaxed); }
+    uint32_t getContextDropped(uint8_t exec_context) const;
+    uint8_t getSlabBlocksFree() const { return __builtin_popcount(slab_free.load(std::memory_order_relaxed)); }
     
     void printStatus() const;
     void printSubscriptions() const;
     
+    // Event trace inspection, index 0 is the oldest record still held.
+    // Pointers refer into the ring and stay valid until it wraps over them
+    const EventTraceRecord* getTraceRecord(size_t index) const;
+    uint32_t getTraceSequence() const { return trace_written; }
+    
+    // Stream records with sequence >= *cursor and advance it; start from 0 for
+    // everything still held. Text goes one CSV line per record
+    size_t exportTrace(Print& out, uint32_t* cursor = nullptr) const;
+    size_t exportTrace(EventTraceWriter writer, void* context, uint32_t* cursor = nullptr) const;
+    
     // Utility methods
-    static String eventTypeToString(EventType type);
-    static String eventPriorityToString(EventPriority priority);
+    static const char* eventTypeToString(EventType type);
+    static const char* eventPriorityToString(EventPriority priority);
+    static int typeSlot(EventType type);    // Table row, -1 outside both ranges
     
 private:
+    bool removeSubscription(std::vector<EventSubscription>& subs, uint16_t subscriber_id);
+    void compactSubscriptions();
+    
+    // Execution contexts
+    bool initContext(EventWorker& ctx, const char* name);
+    void deinitContexts();
+    bool deliver(const EventSubscription& sub, const Event& event);
+    void runDelivery(EventDelivery& delivery);
+    void drainContext(EventWorker& ctx);
+    static void worker_task_fn(void* param);
+    static void invokeHandler(EventHandler handler, void* context, uint16_t subscriber_id, const Event& event);
     void addToHistory(const Event& event);
-    void trimQueue();
-    void trimHistory();
+    uint32_t traceStart(const uint32_t* cursor) const;
+    
+    // Publish ring
+    void resetQueue();
+    bool pushSlot(EventType type, EventPriority priority, uint16_t source_id,
+                  const void* tag, const void* data, uint16_t size, bool latest = false);
+    
+    // Delivery policies, under policy_mux
+    void resetPolicyState();
+    bool replaceLatest(int type_slot, EventPriority priority, uint16_t source_id,
+                       const void* tag, const void* data, uint16_t size);
+    bool takeToken(int type_slot, uint16_t source_id);
+    uint8_t* allocSlab();
+    void freeSlab(uint8_t* block);
+    bool dispatchNext(EventQueue& queue);
 };
 
 /**
@@ -272,14 +567,18 @@ extern EventBridge* GlobalEventBridge;
 
 // Template implementations
 template<typename T>
-std::shared_ptr<TypedEventData<T>> Event::getTypedData() const {
-    return std::dynamic_pointer_cast<TypedEventData<T>>(data);
+const T* Event::getPayload() const {
+    if (payload_tag != &EventPayloadTag<T>::id || payload_size != sizeof(T)) {
+        return nullptr;
+    }
+    return static_cast<const T*>(payload);
 }
 
 template<typename T>
-void EventBridge::publishTypedEvent(EventType type, const String& source, const T& data, EventPriority priority) {
-    auto typed_data = std::make_shared<TypedEventData<T>>(data);
-    publishEvent(Event(type, source, typed_data, priority));
+bool EventBridge::publishTypedEvent(EventType type, const char* source, const T& data, EventPriority priority) {
+    static_assert(std::is_trivially_copyable<T>::value, "Event payloads are copied bytewise");
+    static_assert(sizeof(T) <= EVENT_SLAB_BLOCK_SIZE, "Event payload larger than a slab block");
+    return publishPayload(type, internSource(source), priority, &EventPayloadTag<T>::id, &data, sizeof(T));
 }
 
 #endif // INTEGRATION_LAYER_ENABLED
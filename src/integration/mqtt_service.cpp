@@ -0,0 +1,51 @@
+/**
+ * @file      mqtt_service.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     MQTTService implementation
+ */
+
+#include "mqtt_service.h"
+#include "mqtt_client.h"
+#include "simple_logger.h"
+
+bool MQTTService::initialize() {
+    if (initialized) {
+        return true;
+    }
+    
+    // Broker and credentials come from the "mqtt" config section
+    if (!mqtt_begin()) {
+        LOG_WARN("MQTTService", "MQTT client not started");
+        return false;
+    }
+    initialized = true;
+    return true;
+}
+
+void MQTTService::shutdown() {
+    if (!initialized) {
+        return;
+    }
+    mqtt_end();
+    initialized = false;
+}
+
+uint32_t MQTTService::getHeartbeat() const {
+    // A lost broker is the task's to retry; only a stalled task is unhealthy
+    return initialized ? mqtt_heartbeat() : 0;
+}
+
+bool MQTTService::suspend() {
+    if (!initialized) {
+        return false;
+    }
+    mqtt_suspend(true);
+    return true;
+}
+
+void MQTTService::resume() {
+    mqtt_suspend(false);
+}
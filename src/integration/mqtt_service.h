@@ -0,0 +1,40 @@
+/**
+ * @file      mqtt_service.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     MQTTService: the MQTT client under the service manager
+ */
+
+#ifndef MQTT_SERVICE_H
+#define MQTT_SERVICE_H
+
+#include "service_container.h"
+
+/**
+ * @brief Lifecycle and health for the mqtt_client task
+ * 
+ * The client runs on its own task; this only starts and stops it, feeds
+ * the health schedule from the task's loop counter, and takes it off the
+ * air in low power modes
+ */
+class MQTTService : public IService {
+private:
+    bool initialized;
+    
+public:
+    MQTTService() : initialized(false) {}
+    ~MQTTService() override { shutdown(); }
+    
+    bool initialize() override;
+    void shutdown() override;
+    const char* getServiceName() const override { return "MQTTService"; }
+    bool isInitialized() const override { return initialized; }
+    
+    uint32_t getHeartbeat() const override;
+    bool suspend() override;
+    void resume() override;
+};
+
+#endif // MQTT_SERVICE_H
@@ -15,8 +15,12 @@
 // Global service container instance
 ServiceContainer* GlobalServiceContainer = nullptr;
 
-ServiceContainer::ServiceContainer() : container_initialized(false) {
+ServiceContainer::ServiceContainer() : container_initialized(false), slot_count(0) {
     // Don't log during static initialization - logger may not be ready
+    for (auto& slot : slots) {
+        slot.type = nullptr;
+        slot.typed.store(nullptr, std::memory_order_relaxed);
+    }
 }
 
 ServiceContainer::~ServiceContainer() {
@@ -35,6 +39,59 @@ void ServiceContainer::registerService(const String& name, ServiceFactory factor
     services[name] = ServiceRegistration(name, factory, singleton);
 }
 
+ServiceRegistration* ServiceContainer::registerTyped(const String& name, ServiceFactory factory, bool singleton,
+                                                     ServiceTypeId type, ServiceCaster caster) {
+    // Re-registration keeps the slot so handles already handed out stay bound
+    auto it = services.find(name);
+    uint8_t slot = it != services.end() ? it->second.slot : (uint8_t)SERVICE_SLOT_NONE;
+    
+    registerService(name, factory, singleton);
+    ServiceRegistration& registration = services[name];
+    registration.type = type;
+    registration.caster = caster;
+    
+    if (singleton && slot == SERVICE_SLOT_NONE) {
+        if (slot_count < SERVICE_CONTAINER_MAX_SLOTS) {
+            slot = slot_count++;
+        } else {
+            LOG_WARNF("ServiceContainer", "Handle table full, %s is reachable by name only", name.c_str());
+        }
+    }
+    registration.slot = singleton ? slot : (uint8_t)SERVICE_SLOT_NONE;
+    if (registration.slot != SERVICE_SLOT_NONE) {
+        slots[registration.slot].type = type;
+        slots[registration.slot].typed.store(nullptr, std::memory_order_release);
+    }
+    return &registration;
+}
+
+ServiceSlot* ServiceContainer::findSlot(ServiceTypeId type) {
+    for (uint8_t i = 0; i < slot_count; i++) {
+        if (slots[i].type == type) {
+            return &slots[i];
+        }
+    }
+    LOG_ERROR("ServiceContainer", "No singleton service registered for the requested handle type");
+    return nullptr;
+}
+
+ServiceSlot* ServiceContainer::findSlot(const String& name, ServiceTypeId type) {
+    auto it = services.find(name);
+    if (it == services.end() || it->second.type != type || it->second.slot == SERVICE_SLOT_NONE) {
+        LOG_ERRORF("ServiceContainer", "No handle for service %s with the requested type", name.c_str());
+        return nullptr;
+    }
+    return &slots[it->second.slot];
+}
+
+void ServiceContainer::publishInstance(ServiceRegistration& registration) {
+    if (registration.slot == SERVICE_SLOT_NONE || !registration.caster) {
+        return;
+    }
+    void* typed = registration.instance ? registration.caster(registration.instance.get()) : nullptr;
+    slots[registration.slot].typed.store(typed, std::memory_order_release);
+}
+
 std::shared_ptr<IService> ServiceContainer::getService(const String& name) {
     auto it = services.find(name);
     if (it == services.end()) {
@@ -60,6 +117,7 @@ std::shared_ptr<IService> ServiceContainer::getService(const String& name) {
     if (registration.singleton) {
         registration.instance = instance;
         instances[name] = instance;
+        publishInstance(registration);
     }
     
     return instance;
@@ -110,6 +168,13 @@ bool ServiceContainer::initializeService(const String& name) {
     }
 }
 
+void ServiceContainer::setServiceInitialized(const String& name, bool initialized) {
+    auto it = services.find(name);
+    if (it != services.end()) {
+        it->second.initialized = initialized;
+    }
+}
+
 bool ServiceContainer::initializeAllServices() {
     LOG_INFO("ServiceContainer", "Initializing all services...");
     
@@ -152,6 +217,7 @@ void ServiceContainer::shutdownService(const String& name) {
     if (registration.singleton) {
         registration.instance.reset();
         instances.erase(name);
+        publishInstance(registration);
     }
 }
 
@@ -200,6 +266,13 @@ void ServiceContainer::shutdown() {
     services.clear();
     instances.clear();
     
+    // Handles still held elsewhere read nullptr from here on
+    for (uint8_t i = 0; i < slot_count; i++) {
+        slots[i].type = nullptr;
+        slots[i].typed.store(nullptr, std::memory_order_release);
+    }
+    slot_count = 0;
+    
     container_initialized = false;
     
     // Clear global instance if it's this container
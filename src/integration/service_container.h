@@ -14,13 +14,17 @@
 #ifdef INTEGRATION_LAYER_ENABLED
 
 #include <Arduino.h>
+#include <atomic>
 #include <map>
 #include <memory>
 #include <functional>
-#include <typeinfo>
 #include <vector>
 #include "simple_logger.h"
 
+// Singletons reachable through typed handles; later registrations work by name only
+#define SERVICE_CONTAINER_MAX_SLOTS 16
+#define SERVICE_SLOT_NONE           0xFF
+
 // Forward declarations
 class ServiceContainer;
 
@@ -36,6 +40,19 @@ public:
     virtual void shutdown() = 0;
     virtual const char* getServiceName() const = 0;
     virtual bool isInitialized() const = 0;
+    
+    // Health probes. A counter the service bumps from its own loop is the
+    // cheap liveness signal (0 = not provided); checkHealth() is the active
+    // check and may touch hardware, so it only runs when the counter stalls
+    virtual uint32_t getHeartbeat() const { return 0; }
+    virtual bool checkHealth() { return isInitialized(); }
+    
+    // Low-power hooks, driven by ServiceManager::setPowerMode(). suspend()
+    // quiesces without giving up state so resume() is quick rather than a
+    // cold start; both should return in milliseconds. Returning false, the
+    // default, keeps the service running
+    virtual bool suspend() { return false; }
+    virtual void resume() {}
 };
 
 /**
@@ -45,6 +62,65 @@ public:
  */
 typedef std::function<std::shared_ptr<IService>(ServiceContainer*)> ServiceFactory;
 
+/**
+ * @brief Compile-time service type identity
+ * 
+ * The address of a per-type tag, so typed lookups need neither RTTI
+ * (the integrated build uses -fno-rtti) nor a string compare.
+ */
+typedef const void* ServiceTypeId;
+
+template<typename T>
+struct ServiceTypeTag {
+    static const char tag;
+};
+
+template<typename T>
+const char ServiceTypeTag<T>::tag = 0;
+
+template<typename T>
+constexpr ServiceTypeId serviceTypeId() {
+    return &ServiceTypeTag<T>::tag;
+}
+
+// IService* -> T*, instantiated where T is known; a static_cast keeps
+// multiple inheritance offsets right
+typedef void* (*ServiceCaster)(IService*);
+
+template<typename T>
+void* serviceCast(IService* service) {
+    return static_cast<T*>(service);
+}
+
+/**
+ * @brief Published singleton pointer behind every handle of one service
+ */
+struct ServiceSlot {
+    ServiceTypeId type;
+    std::atomic<void*> typed;       // T*, set once the singleton exists, cleared on shutdown
+};
+
+/**
+ * @brief Typed handle resolved once, read with a single atomic load
+ * 
+ * Holds no reference: the container owns the instance, and get() returns
+ * nullptr before the singleton is created and after it is shut down.
+ */
+template<typename T>
+class ServiceHandle {
+private:
+    ServiceSlot* slot;
+
+public:
+    ServiceHandle() : slot(nullptr) {}
+    explicit ServiceHandle(ServiceSlot* s) : slot(s) {}
+    
+    T* get() const { return slot ? static_cast<T*>(slot->typed.load(std::memory_order_acquire)) : nullptr; }
+    T* operator->() const { return get(); }
+    explicit operator bool() const { return get() != nullptr; }
+    bool isBound() const { return slot != nullptr; }
+};
+
 /**
  * @brief Service Registration Information
  * 
@@ -56,10 +132,13 @@ struct ServiceRegistration {
     bool singleton;
     std::shared_ptr<IService> instance;
     bool initialized;
+    ServiceTypeId type;             // nullptr when registered without a type
+    ServiceCaster caster;
+    uint8_t slot;                   // SERVICE_SLOT_NONE if the table was full
     
-    ServiceRegistration() : singleton(true), initialized(false) {}
+    ServiceRegistration() : singleton(true), initialized(false), type(nullptr), caster(nullptr), slot(SERVICE_SLOT_NONE) {}
     ServiceRegistration(const String& n, ServiceFactory f, bool s = true) 
-        : name(n), factory(f), singleton(s), initialized(false) {}
+        : name(n), factory(f), singleton(s), initialized(false), type(nullptr), caster(nullptr), slot(SERVICE_SLOT_NONE) {}
 };
 
 /**
@@ -74,6 +153,10 @@ private:
     std::map<String, std::shared_ptr<IService>> instances;
     bool container_initialized;
     
+    // Fixed so handles stay valid; only the typed pointers change after boot
+    ServiceSlot slots[SERVICE_CONTAINER_MAX_SLOTS];
+    uint8_t slot_count;
+    
     // Prevent copying
     ServiceContainer(const ServiceContainer&) = delete;
     ServiceContainer& operator=(const ServiceContainer&) = delete;
@@ -82,9 +165,12 @@ public:
     ServiceContainer();
     ~ServiceContainer();
     
-    // Service registration
+    // Service registration, the typed forms return the service's handle
+    template<typename T>
+    ServiceHandle<T> registerService(const String& name, bool singleton = true);
+    
     template<typename T>
-    void registerService(const String& name, bool singleton = true);
+    ServiceHandle<T> registerService(const String& name, ServiceFactory factory, bool singleton = true);
     
     void registerService(const String& name, ServiceFactory factory, bool singleton = true);
     
@@ -94,8 +180,16 @@ public:
     
     std::shared_ptr<IService> getService(const String& name);
     
+    // Typed handles: resolve once (at registration or startup), then call through them
+    template<typename T>
+    ServiceHandle<T> getHandle();
+    
+    template<typename T>
+    ServiceHandle<T> getHandle(const String& name);
+    
     // Service management
     bool initializeService(const String& name);
+    void setServiceInitialized(const String& name, bool initialized);  // After initialize() ran elsewhere
     bool initializeAllServices();
     void shutdownService(const String& name);
     void shutdownAllServices();
@@ -117,6 +211,11 @@ public:
     
 private:
     std::shared_ptr<IService> createServiceInstance(const String& name);
+    ServiceRegistration* registerTyped(const String& name, ServiceFactory factory, bool singleton,
+                                       ServiceTypeId type, ServiceCaster caster);
+    ServiceSlot* findSlot(ServiceTypeId type);
+    ServiceSlot* findSlot(const String& name, ServiceTypeId type);
+    void publishInstance(ServiceRegistration& registration);
 };
 
 /**
@@ -139,27 +238,53 @@ extern ServiceContainer* GlobalServiceContainer;
 #define RESOLVE_SERVICE(type, name) \
     GlobalServiceContainer->getService<type>(name)
 
+#define SERVICE_HANDLE(container, type) \
+    container->getHandle<type>()
+
 // Template implementations
 template<typename T>
-void ServiceContainer::registerService(const String& name, bool singleton) {
-    LOG_INFOF("ServiceContainer", "Registering service: %s (singleton: %s)", 
-              name.c_str(), singleton ? "true" : "false");
-    
+ServiceHandle<T> ServiceContainer::registerService(const String& name, bool singleton) {
     ServiceFactory factory = [](ServiceContainer* container) -> std::shared_ptr<IService> {
         return std::make_shared<T>();
     };
     
-    services[name] = ServiceRegistration(name, factory, singleton);
+    return registerService<T>(name, factory, singleton);
+}
+
+template<typename T>
+ServiceHandle<T> ServiceContainer::registerService(const String& name, ServiceFactory factory, bool singleton) {
+    ServiceRegistration* registration = registerTyped(name, factory, singleton, serviceTypeId<T>(), &serviceCast<T>);
+    if (!singleton || registration->slot == SERVICE_SLOT_NONE) {
+        return ServiceHandle<T>();
+    }
+    return ServiceHandle<T>(&slots[registration->slot]);
 }
 
 template<typename T>
 std::shared_ptr<T> ServiceContainer::getService(const String& name) {
+    auto it = services.find(name);
+    if (it == services.end() || it->second.type != serviceTypeId<T>()) {
+        LOG_ERRORF("ServiceContainer", "Service %s not registered with the requested type", name.c_str());
+        return nullptr;
+    }
+    
     auto service = getService(name);
     if (!service) {
         return nullptr;
     }
     
-    return std::dynamic_pointer_cast<T>(service);
+    // Aliasing constructor: shares ownership, points at the T subobject
+    return std::shared_ptr<T>(service, static_cast<T*>(it->second.caster(service.get())));
+}
+
+template<typename T>
+ServiceHandle<T> ServiceContainer::getHandle() {
+    return ServiceHandle<T>(findSlot(serviceTypeId<T>()));
+}
+
+template<typename T>
+ServiceHandle<T> ServiceContainer::getHandle(const String& name) {
+    return ServiceHandle<T>(findSlot(name, serviceTypeId<T>()));
 }
 
 #endif // INTEGRATION_LAYER_ENABLED
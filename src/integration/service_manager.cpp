@@ -9,13 +9,18 @@
 
 #include "service_manager.h"
 #include "simple_hardware.h"
+#include "boot_trace.h"
+#include "mqtt_service.h"
+#include "metrics.h"
+#include "power_mode.h"
 
 // Global service manager instance
 ServiceManager* GlobalServiceManager = nullptr;
 
 ServiceManager::ServiceManager()
-    : hardware(nullptr), initialized(false), services_started(false), shutdown_in_progress(false),
-      total_startup_time(0), total_shutdown_time(0), services_started_count(0), services_failed_count(0) {
+    : hardware(nullptr), health_next_due(0), power_mode(POWER_BALANCED), power_transition_us(0), initialized(false), services_started(false), shutdown_in_progress(false),
+      total_startup_time(0), total_shutdown_time(0), services_started_count(0), services_failed_count(0),
+      startup_run(0) {
     // Don't log during static initialization - logger may not be ready
 }
 
@@ -93,6 +98,8 @@ void ServiceManager::shutdown() {
     service_registry.clear();
     startup_order.clear();
     running_services.clear();
+    health_state.clear();
+    power_state.clear();
     
     total_shutdown_time += millis() - shutdown_start;
     
@@ -139,13 +146,13 @@ void ServiceManager::setConfigManager(std::shared_ptr<ConfigManager> config) {
 
 void ServiceManager::registerService(const ServiceInfo& info) {
     LOG_INFOF("ServiceManager", "Registering service: %s (%s)", 
-              info.name.c_str(), info.description.c_str());
+              info.name.c_str(), info.description);
     
-    if (isServiceRegistered(info.name)) {
+    if (isServiceRegistered(info.name.c_str())) {
         LOG_WARNF("ServiceManager", "Service %s already registered, overwriting", info.name.c_str());
     }
     
-    service_registry[info.name] = info;
+    service_registry[info.name.c_str()] = info;
 }
 
 void ServiceManager::registerCoreServices() {
@@ -176,21 +183,25 @@ void ServiceManager::registerCommunicationServices() {
     // MQTT Service
     ServiceInfo mqtt_info("MQTTService", "MQTT communication service", ServiceStartupOrder::COMMUNICATION);
     mqtt_info.required = false;
-    mqtt_info.dependencies.push_back("SimpleHardware");
+    mqtt_info.addDependency("SimpleHardware");
     mqtt_info.startup_timeout_ms = 10000;
+    mqtt_info.suspend_mode = POWER_ULTRA_LOW_POWER;
     registerService(mqtt_info);
+    if (!service_container->hasService(mqtt_info.name.c_str())) {
+        service_container->registerService<MQTTService>(mqtt_info.name.c_str());
+    }
     
     // LoRa Service
     ServiceInfo lora_info("LoRaService", "LoRa communication service", ServiceStartupOrder::COMMUNICATION);
     lora_info.required = false;
-    lora_info.dependencies.push_back("SimpleHardware");
+    lora_info.addDependency("SimpleHardware");
     lora_info.startup_timeout_ms = 8000;
     registerService(lora_info);
     
     // GPS Service
     ServiceInfo gps_info("GPSService", "GPS location service", ServiceStartupOrder::COMMUNICATION);
     gps_info.required = false;
-    gps_info.dependencies.push_back("SimpleHardware");
+    gps_info.addDependency("SimpleHardware");
     gps_info.startup_timeout_ms = 15000;
     registerService(gps_info);
 }
@@ -201,16 +212,16 @@ void ServiceManager::registerApplicationServices() {
     // UI Service
     ServiceInfo ui_info("UIService", "User interface service", ServiceStartupOrder::APPLICATION);
     ui_info.required = false;
-    ui_info.dependencies.push_back("SimpleHardware");
-    ui_info.dependencies.push_back("EventBridge");
+    ui_info.addDependency("SimpleHardware");
+    ui_info.addDependency("EventBridge");
     ui_info.startup_timeout_ms = 8000;
     registerService(ui_info);
     
     // Application Manager
     ServiceInfo app_info("ApplicationManager", "Application lifecycle manager", ServiceStartupOrder::APPLICATION);
     app_info.required = false;
-    app_info.dependencies.push_back("UIService");
-    app_info.dependencies.push_back("ConfigManager");
+    app_info.addDependency("UIService");
+    app_info.addDependency("ConfigManager");
     app_info.startup_timeout_ms = 5000;
     registerService(app_info);
 }
@@ -225,27 +236,194 @@ bool ServiceManager::startAllServices() {
     
     uint32_t startup_start = millis();
     bool all_success = true;
-    
-    // Start services in calculated order
+    uint32_t run = ++startup_run;
+    BOOT_TRACE_SCOPE("Services.start");
+    
+    // One node per auto-start service, in tier order so earlier tiers win ties
+    enum NodeState : uint8_t { PENDING, STARTING, STARTED, FAILED };
+    struct Node {
+        const String* name;
+        const ServiceInfo* info;
+        std::shared_ptr<IService> instance;
+        NodeState state;
+        uint32_t started_at;
+        uint8_t span;               // Boot trace span while STARTING
+    };
+    std::vector<Node> nodes;
     for (const String& service_name : startup_order) {
         const ServiceInfo& info = service_registry[service_name];
-        
         if (!info.auto_start) {
             LOG_INFOF("ServiceManager", "Skipping service %s (auto_start disabled)", service_name.c_str());
             continue;
         }
+        nodes.push_back({&service_name, &info, nullptr, PENDING, 0, BOOT_TRACE_INVALID});
+    }
+    
+    auto findNode = [&nodes](StrView name) -> Node* {
+        for (auto& node : nodes) {
+            if (name == *node.name) {
+                return &node;
+            }
+        }
+        return nullptr;
+    };
+    
+    auto fail = [&](Node& node, const char* error) {
+        node.state = FAILED;
+        onServiceFailed(*node.name, error);
+        if (node.info->required) {
+            LOG_ERRORF("ServiceManager", "Required service %s failed to start", node.name->c_str());
+            all_success = false;
+        } else {
+            LOG_WARNF("ServiceManager", "Optional service %s failed to start", node.name->c_str());
+        }
+    };
+    
+    ServiceStartupPool* pool = nullptr;
+    size_t in_flight = 0;
+    
+    while (true) {
+        // Dispatch everything that became ready. System services complete on
+        // the spot and can unblock others, so repeat until nothing changes
+        bool changed = true;
+        while (changed && all_success) {
+            changed = false;
+            for (auto& node : nodes) {
+                if (node.state != PENDING) {
+                    continue;
+                }
+                
+                bool ready = true;
+                const char* blocked = nullptr;
+                for (uint8_t d = 0; d < node.info->dependency_count; d++) {
+                    const ServiceName& dep = node.info->dependencies[d];
+                    if (isServiceRunning(dep)) {
+                        continue;
+                    }
+                    Node* dep_node = findNode(dep);
+                    if (!dep_node || dep_node->state == FAILED) {
+                        blocked = dep.c_str();
+                        break;
+                    }
+                    ready = false;
+                }
+                if (blocked) {
+                    LOG_ERRORF("ServiceManager", "Cannot start service %s: dependency %s unavailable",
+                               node.name->c_str(), blocked);
+                    fail(node, "Dependencies not met");
+                    changed = true;
+                    continue;
+                }
+                if (!ready) {
+                    continue;
+                }
+                
+                if (isServiceRunning(*node.name)) {
+                    node.state = STARTED;
+                    changed = true;
+                    continue;
+                }
+                
+                LOG_INFOF("ServiceManager", "Starting service: %s", node.name->c_str());
+                if (isSystemService(*node.name)) {
+                    running_services.push_back(*node.name);
+                    onServiceStarted(*node.name);
+                    node.state = STARTED;
+                    changed = true;
+                    continue;
+                }
+                
+                // Resolved here: the container is not safe to touch from the workers
+                node.instance = service_container->getService(*node.name);
+                if (!node.instance) {
+                    LOG_ERRORF("ServiceManager", "Service %s not found in container", node.name->c_str());
+                    fail(node, "Service not found in container");
+                    changed = true;
+                    continue;
+                }
+                
+                if (!pool) {
+                    pool = createStartupPool(nodes.size());
+                }
+                ServiceStartupJob job = {node.instance.get(), run, (uint16_t)(&node - nodes.data())};
+                node.span = boot_trace_begin(node.name->c_str());
+                if (!pool || xQueueSend(pool->jobs, &job, 0) != pdTRUE) {
+                    // No pool: initialise on this task, as the sequential path did
+                    bool ok = service_container->initializeService(*node.name);
+                    boot_trace_end(node.span);
+                    if (ok) {
+                        running_services.push_back(*node.name);
+                        onServiceStarted(*node.name);
+                        node.state = STARTED;
+                    } else {
+                        fail(node, "Initialization failed");
+                    }
+                    changed = true;
+                    continue;
+                }
+                node.state = STARTING;
+                node.started_at = millis();
+                in_flight++;
+            }
+        }
+        
+        if (in_flight == 0) {
+            break;
+        }
         
-        if (!startServiceInternal(service_name, true)) {
-            if (info.required) {
-                LOG_ERRORF("ServiceManager", "Required service %s failed to start", service_name.c_str());
-                all_success = false;
-                break;
+        // Sleep until a result arrives or the nearest startup deadline
+        uint32_t now = millis();
+        uint32_t wait_ms = UINT32_MAX;
+        for (const auto& node : nodes) {
+            if (node.state == STARTING) {
+                uint32_t elapsed = now - node.started_at;
+                uint32_t left = elapsed < node.info->startup_timeout_ms ? node.info->startup_timeout_ms - elapsed : 0;
+                wait_ms = left < wait_ms ? left : wait_ms;
+            }
+        }
+        
+        ServiceStartupResult result;
+        if (xQueueReceive(pool->results, &result, pdMS_TO_TICKS(wait_ms)) == pdTRUE &&
+            result.run == run && result.index < nodes.size() && nodes[result.index].state == STARTING) {
+            Node& node = nodes[result.index];
+            in_flight--;
+            boot_trace_end(node.span);
+            if (result.success) {
+                service_container->setServiceInitialized(*node.name, true);
+                running_services.push_back(*node.name);
+                LOG_INFOF("ServiceManager", "Service %s initialised in %lums", node.name->c_str(), result.elapsed_ms);
+                metrics_observe(METRIC_SERVICE_INIT_MS, result.elapsed_ms);
+                onServiceStarted(*node.name);
+                node.state = STARTED;
             } else {
-                LOG_WARNF("ServiceManager", "Optional service %s failed to start", service_name.c_str());
+                LOG_ERRORF("ServiceManager", "Failed to initialize service: %s", node.name->c_str());
+                fail(node, "Initialization failed");
+            }
+        }
+        
+        // The worker stays stuck in a timed-out initialize(); its late result is dropped
+        now = millis();
+        for (auto& node : nodes) {
+            if (node.state == STARTING && now - node.started_at >= node.info->startup_timeout_ms) {
+                LOG_ERRORF("ServiceManager", "Service %s startup timeout", node.name->c_str());
+                in_flight--;
+                boot_trace_end(node.span);
+                fail(node, "Startup timeout");
             }
         }
     }
     
+    // A required failure stops dispatch; whatever was never reached is reported
+    for (auto& node : nodes) {
+        if (node.state == PENDING) {
+            LOG_WARNF("ServiceManager", "Service %s not started", node.name->c_str());
+        }
+    }
+    
+    if (pool) {
+        releaseStartupPool(pool);
+    }
+    
     total_startup_time += millis() - startup_start;
     services_started = all_success;
     
@@ -255,6 +433,71 @@ bool ServiceManager::startAllServices() {
     return all_success;
 }
 
+ServiceStartupPool* ServiceManager::createStartupPool(size_t job_count) {
+    ServiceStartupPool* pool = new ServiceStartupPool();
+    pool->jobs = xQueueCreate(job_count + SERVICE_STARTUP_WORKERS, sizeof(ServiceStartupJob));
+    pool->results = xQueueCreate(job_count, sizeof(ServiceStartupResult));
+    pool->workers.store(0);
+    if (!pool->jobs || !pool->results) {
+        if (pool->jobs) {
+            vQueueDelete(pool->jobs);
+        }
+        if (pool->results) {
+            vQueueDelete(pool->results);
+        }
+        delete pool;
+        return nullptr;
+    }
+    
+    for (int i = 0; i < SERVICE_STARTUP_WORKERS; i++) {
+        pool->workers.fetch_add(1);
+        if (xTaskCreatePinnedToCore(startup_worker_fn, "svc_start", SERVICE_STARTUP_STACK, pool,
+                                    SERVICE_STARTUP_PRIORITY, nullptr, i % portNUM_PROCESSORS) != pdPASS) {
+            pool->workers.fetch_sub(1);
+        }
+    }
+    if (pool->workers.load() == 0) {
+        vQueueDelete(pool->jobs);
+        vQueueDelete(pool->results);
+        delete pool;
+        return nullptr;
+    }
+    return pool;
+}
+
+void ServiceManager::releaseStartupPool(ServiceStartupPool* pool) {
+    // One stop job per worker; the pool is not touched after this
+    ServiceStartupJob stop = {nullptr, 0, 0};
+    uint8_t workers = pool->workers.load();
+    for (uint8_t i = 0; i < workers; i++) {
+        xQueueSend(pool->jobs, &stop, portMAX_DELAY);
+    }
+}
+
+void ServiceManager::startup_worker_fn(void* param) {
+    ServiceStartupPool* pool = static_cast<ServiceStartupPool*>(param);
+    ServiceStartupJob job;
+    
+    while (xQueueReceive(pool->jobs, &job, portMAX_DELAY) == pdTRUE && job.service) {
+        ServiceStartupResult result = {job.run, job.index, false, 0};
+        uint32_t start = millis();
+        try {
+            result.success = job.service->initialize();
+        } catch (...) {
+            result.success = false;
+        }
+        result.elapsed_ms = millis() - start;
+        xQueueSend(pool->results, &result, 0);
+    }
+    
+    if (pool->workers.fetch_sub(1) == 1) {
+        vQueueDelete(pool->jobs);
+        vQueueDelete(pool->results);
+        delete pool;
+    }
+    vTaskDelete(nullptr);
+}
+
 bool ServiceManager::startService(const String& name) {
     return startServiceInternal(name, true);
 }
@@ -352,17 +595,25 @@ bool ServiceManager::isSystemService(const String& name) const {
 
 void ServiceManager::onServiceStarted(const String& name) {
     services_started_count++;
+    metrics_count(METRIC_SERVICES_STARTED);
+    
+    // Freshly (re)started: watch it closely until it proves stable
+    health_state[name] = {SERVICE_HEALTH_MIN_INTERVAL_MS, 0, 0, 0, true};
+    scheduleHealthCheck(name, SERVICE_HEALTH_MIN_INTERVAL_MS);
     LOG_INFOF("ServiceManager", "Service %s started successfully", name.c_str());
     publishServiceEvent(EventType::SERVICE_STARTED, name);
 }
 
 void ServiceManager::onServiceStopped(const String& name) {
+    health_state.erase(name);
+    power_state.erase(name);
     LOG_INFOF("ServiceManager", "Service %s stopped", name.c_str());
     publishServiceEvent(EventType::SERVICE_STOPPED, name);
 }
 
 void ServiceManager::onServiceFailed(const String& name, const String& error) {
     services_failed_count++;
+    metrics_count(METRIC_SERVICES_FAILED);
     LOG_ERRORF("ServiceManager", "Service %s failed: %s", name.c_str(), error.c_str());
     publishServiceEvent(EventType::SERVICE_ERROR, name, error);
 }
@@ -390,7 +641,8 @@ bool ServiceManager::checkDependencies(const String& service_name) const {
     }
     
     const ServiceInfo& info = it->second;
-    for (const String& dep : info.dependencies) {
+    for (uint8_t d = 0; d < info.dependency_count; d++) {
+        const ServiceName& dep = info.dependencies[d];
         if (!isServiceRunning(dep)) {
             LOG_WARNF("ServiceManager", "Service %s dependency %s not running", 
                       service_name.c_str(), dep.c_str());
@@ -405,8 +657,9 @@ bool ServiceManager::isServiceRegistered(const String& name) const {
     return service_registry.find(name) != service_registry.end();
 }
 
-bool ServiceManager::isServiceRunning(const String& name) const {
-    return std::find(running_services.begin(), running_services.end(), name) != running_services.end();
+bool ServiceManager::isServiceRunning(StrView name) const {
+    return std::find_if(running_services.begin(), running_services.end(),
+                        [name](const String& running) { return name == running; }) != running_services.end();
 }
 
 void ServiceManager::calculateStartupOrder() {
@@ -480,6 +733,144 @@ bool ServiceManager::stopAllServices() {
     return all_stopped;
 }
 
+std::vector<String> ServiceManager::dependencyOrder() const {
+    // Startup tiers, then each service after whatever it depends on
+    std::vector<String> order;
+    std::vector<String> pending = startup_order;
+    bool progress = true;
+    while (!pending.empty() && progress) {
+        progress = false;
+        for (auto it = pending.begin(); it != pending.end();) {
+            const ServiceInfo& info = service_registry.at(*it);
+            bool ready = true;
+            for (uint8_t d = 0; d < info.dependency_count && ready; d++) {
+                const ServiceName& dep = info.dependencies[d];
+                ready = std::find_if(pending.begin(), pending.end(),
+                                     [&dep](const String& p) { return dep == p; }) == pending.end();
+            }
+            if (ready) {
+                order.push_back(*it);
+                it = pending.erase(it);
+                progress = true;
+            } else {
+                ++it;
+            }
+        }
+    }
+    // A cycle keeps tier order
+    order.insert(order.end(), pending.begin(), pending.end());
+    return order;
+}
+
+bool ServiceManager::hasActiveDependent(const String& name) const {
+    for (const String& running : running_services) {
+        if (isServiceSuspended(running)) {
+            continue;
+        }
+        const ServiceInfo& info = service_registry.at(running);
+        for (uint8_t d = 0; d < info.dependency_count; d++) {
+            if (info.dependencies[d] == name) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool ServiceManager::suspendService(const String& name) {
+    auto service = service_container ? service_container->getService(name) : nullptr;
+    if (!service || hasActiveDependent(name)) {
+        return false;
+    }
+    
+    uint32_t start = micros();
+    bool ok = service->suspend();
+    uint32_t elapsed = micros() - start;
+    if (!ok) {
+        LOG_WARNF("ServiceManager", "Service %s did not suspend", name.c_str());
+        return false;
+    }
+    
+    ServicePowerState& state = power_state[name];
+    state.suspended = true;
+    state.cycles++;
+    state.suspend_us = elapsed;
+    if (elapsed > state.suspend_max_us) {
+        state.suspend_max_us = elapsed;
+    }
+    metrics_observe(METRIC_SERVICE_SUSPEND_US, elapsed);
+    // Nothing to probe while it is quiet
+    health_state.erase(name);
+    LOG_INFOF("ServiceManager", "Service %s suspended in %luus", name.c_str(), (unsigned long)elapsed);
+    return true;
+}
+
+void ServiceManager::resumeService(const String& name) {
+    auto service = service_container ? service_container->getService(name) : nullptr;
+    ServicePowerState& state = power_state[name];
+    state.suspended = false;
+    if (!service) {
+        return;
+    }
+    
+    uint32_t start = micros();
+    service->resume();
+    uint32_t elapsed = micros() - start;
+    state.resume_us = elapsed;
+    if (elapsed > state.resume_max_us) {
+        state.resume_max_us = elapsed;
+    }
+    metrics_observe(METRIC_SERVICE_RESUME_US, elapsed);
+    
+    health_state[name] = {SERVICE_HEALTH_MIN_INTERVAL_MS, 0, 0, 0, true};
+    scheduleHealthCheck(name, SERVICE_HEALTH_MIN_INTERVAL_MS);
+    LOG_INFOF("ServiceManager", "Service %s resumed in %luus", name.c_str(), (unsigned long)elapsed);
+}
+
+bool ServiceManager::setPowerMode(uint8_t mode) {
+    power_mode = mode;
+    if (!initialized) {
+        return true;
+    }
+    
+    uint32_t start = micros();
+    bool all_ok = true;
+    std::vector<String> order = dependencyOrder();
+    
+    // Dependents quiesce before what they use
+    for (auto it = order.rbegin(); it != order.rend(); ++it) {
+        const ServiceInfo& info = service_registry.at(*it);
+        if (mode >= info.suspend_mode && isServiceRunning(*it) && !isServiceSuspended(*it) &&
+            !isSystemService(*it) && !suspendService(*it)) {
+            all_ok = false;
+        }
+    }
+    // And come back after it
+    for (const String& name : order) {
+        if (mode < service_registry.at(name).suspend_mode && isServiceSuspended(name)) {
+            resumeService(name);
+        }
+    }
+    
+    power_transition_us = micros() - start;
+    LOG_DEBUGF("ServiceManager", "Power mode %u applied in %luus", mode, (unsigned long)power_transition_us);
+    return all_ok;
+}
+
+bool ServiceManager::isServiceSuspended(StrView name) const {
+    auto it = power_state.find(name);
+    return it != power_state.end() && it->second.suspended;
+}
+
+bool ServiceManager::getServicePowerState(const String& name, ServicePowerState* out) const {
+    auto it = power_state.find(name);
+    if (it == power_state.end()) {
+        return false;
+    }
+    *out = it->second;
+    return true;
+}
+
 void ServiceManager::update() {
     // Update all running services
     for (const auto& pair : service_registry) {
@@ -491,22 +882,110 @@ void ServiceManager::update() {
         }
     }
 
-    // Perform periodic health checks
-    static uint32_t last_health_check = 0;
-    uint32_t current_time = millis();
-    if (current_time - last_health_check > 30000) { // Every 30 seconds
+    // Probe whatever is due; nothing to do until the earliest deadline
+    if (!health_state.empty() && (int32_t)(millis() - health_next_due) >= 0) {
         performHealthChecks();
-        last_health_check = current_time;
     }
 }
 
+void ServiceManager::scheduleHealthCheck(const String& name, uint32_t delay_ms) {
+    auto it = health_state.find(name);
+    if (it == health_state.end()) {
+        return;
+    }
+    
+    uint32_t due = millis() + delay_ms;
+    it->second.next_check = due;
+    if (health_state.size() == 1 || (int32_t)(due - health_next_due) < 0) {
+        health_next_due = due;
+    }
+}
+
+bool ServiceManager::probeService(const String& name, ServiceHealthState& state) {
+    if (isSystemService(name) || !service_container) {
+        return true;  // Not owned by the container, nothing to probe
+    }
+    
+    auto service = service_container->getService(name);
+    if (!service) {
+        return false;
+    }
+    
+    // A moving heartbeat proves liveness without waking the bus or the modem
+    uint32_t heartbeat = service->getHeartbeat();
+    if (heartbeat != 0 && heartbeat != state.last_heartbeat) {
+        state.last_heartbeat = heartbeat;
+        return true;
+    }
+    
+    return service->checkHealth();
+}
+
 void ServiceManager::performHealthChecks() {
-    // Basic health check for all running services
-    for (const auto& pair : service_registry) {
-        const String& service_name = pair.first;
-        if (isServiceRunning(service_name)) {
-            // TODO: Implement actual health checks when services are available
-            LOG_DEBUGF("ServiceManager", "Health check for service: %s - OK", service_name.c_str());
+    uint32_t now = millis();
+    std::vector<String> failed;
+    
+    for (auto& pair : health_state) {
+        const String& name = pair.first;
+        ServiceHealthState& state = pair.second;
+        if ((int32_t)(now - state.next_check) < 0) {
+            continue;
+        }
+        
+        state.healthy = probeService(name, state);
+        if (state.healthy) {
+            state.failures = 0;
+            state.interval_ms = state.interval_ms * 2 < SERVICE_HEALTH_MAX_INTERVAL_MS ?
+                                state.interval_ms * 2 : SERVICE_HEALTH_MAX_INTERVAL_MS;
+            LOG_DEBUGF("ServiceManager", "Health check for service: %s - OK, next in %lums",
+                       name.c_str(), state.interval_ms);
+        } else {
+            state.failures++;
+            state.interval_ms = SERVICE_HEALTH_MIN_INTERVAL_MS;
+            LOG_WARNF("ServiceManager", "Health check for service: %s - FAILED (%u in a row)",
+                      name.c_str(), state.failures);
+            if (state.failures >= SERVICE_HEALTH_FAILURE_LIMIT) {
+                failed.push_back(name);
+            }
+        }
+        state.next_check = now + state.interval_ms;
+    }
+    
+    // Recovery changes health_state, so it runs after the walk
+    for (const String& name : failed) {
+        handleServiceFailure(name);
+    }
+    
+    health_next_due = now + SERVICE_HEALTH_MAX_INTERVAL_MS;
+    for (const auto& pair : health_state) {
+        if ((int32_t)(pair.second.next_check - health_next_due) < 0) {
+            health_next_due = pair.second.next_check;
         }
     }
 }
+
+bool ServiceManager::performHealthCheck() {
+    // Overall health as of the last probes; does not probe anything itself
+    for (const auto& pair : health_state) {
+        if (!pair.second.healthy) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void ServiceManager::handleServiceFailure(const String& service_name) {
+    LOG_ERRORF("ServiceManager", "Service %s failed its health checks, restarting", service_name.c_str());
+    onServiceFailed(service_name, "Health check failed");
+    
+    if (!restartService(service_name)) {
+        LOG_ERRORF("ServiceManager", "Restart of service %s failed", service_name.c_str());
+    }
+}
+
+bool ServiceManager::restartService(const String& name) {
+    if (!stopService(name)) {
+        return false;
+    }
+    return startService(name);
+}
@@ -13,11 +13,33 @@
 #include <Arduino.h>
 #include <vector>
 #include <memory>
+#include <atomic>
 #include "simple_logger.h"
 #include "service_container.h"
 #include "event_bridge.h"
 #include "config_manager.h"
 
+// Parallel startup: every service whose dependencies are running initialises
+// at once on a small task pool, one worker per core
+#define SERVICE_STARTUP_WORKERS     2
+#define SERVICE_STARTUP_STACK       6144
+#define SERVICE_STARTUP_PRIORITY    2
+
+// Health scheduling: each passing check doubles a service's interval up to
+// the max; a failure or a (re)start drops it back to the min
+#define SERVICE_HEALTH_MIN_INTERVAL_MS  5000
+#define SERVICE_HEALTH_MAX_INTERVAL_MS  300000
+#define SERVICE_HEALTH_FAILURE_LIMIT    3       // Consecutive failures before a restart
+
+// Low-power suspension, see ServiceManager::setPowerMode()
+#define SERVICE_SUSPEND_NEVER       0xFF    // ServiceInfo::suspend_mode of services that keep running
+
+// Registration info is held inline; longer names are cut
+#define SERVICE_NAME_SIZE           24
+#define SERVICE_DEPENDENCY_MAX      4
+
+typedef FixedString<SERVICE_NAME_SIZE> ServiceName;
+
 // Forward declarations
 class ServiceManager;
 class SimpleHardware;
@@ -41,22 +63,85 @@ enum class ServiceStartupOrder {
  * Contains information about how a service should be managed
  */
 struct ServiceInfo {
-    String name;
-    String description;
+    ServiceName name;
+    const char* description;        // Static text
     ServiceStartupOrder startup_order;
     bool required;
     bool auto_start;
     uint32_t startup_timeout_ms;
     uint32_t shutdown_timeout_ms;
-    std::vector<String> dependencies;
+    ServiceName dependencies[SERVICE_DEPENDENCY_MAX];
+    uint8_t dependency_count;
+    uint8_t suspend_mode;           // PowerMode from which on it is suspended, or SERVICE_SUSPEND_NEVER
 
     // Default constructor
-    ServiceInfo() : startup_order(ServiceStartupOrder::APPLICATION), required(false), auto_start(true),
-                   startup_timeout_ms(10000), shutdown_timeout_ms(5000) {}
+    ServiceInfo() : description(""), startup_order(ServiceStartupOrder::APPLICATION), required(false), auto_start(true),
+                   startup_timeout_ms(10000), shutdown_timeout_ms(5000), dependency_count(0),
+                   suspend_mode(SERVICE_SUSPEND_NEVER) {}
 
-    ServiceInfo(const String& n, const String& desc, ServiceStartupOrder order = ServiceStartupOrder::APPLICATION)
+    ServiceInfo(StrView n, const char* desc, ServiceStartupOrder order = ServiceStartupOrder::APPLICATION)
         : name(n), description(desc), startup_order(order), required(false), auto_start(true),
-          startup_timeout_ms(10000), shutdown_timeout_ms(5000) {}
+          startup_timeout_ms(10000), shutdown_timeout_ms(5000), dependency_count(0),
+          suspend_mode(SERVICE_SUSPEND_NEVER) {}
+
+    bool addDependency(StrView dep) {
+        if (dependency_count >= SERVICE_DEPENDENCY_MAX) {
+            return false;
+        }
+        dependencies[dependency_count++] = dep;
+        return true;
+    }
+};
+
+/**
+ * @brief Startup job handed to a pool worker, by value
+ */
+struct ServiceStartupJob {
+    IService* service;              // nullptr tells the worker to exit
+    uint32_t run;                   // startAllServices() pass the job belongs to
+    uint16_t index;                 // Node in that pass
+};
+
+struct ServiceStartupResult {
+    uint32_t run;
+    uint16_t index;
+    bool success;
+    uint32_t elapsed_ms;
+};
+
+/**
+ * @brief Startup worker pool
+ * 
+ * Outlives the startAllServices() pass that created it if a worker is still
+ * stuck in a timed-out initialize(); the last worker to exit frees it
+ */
+struct ServiceStartupPool {
+    QueueHandle_t jobs;
+    QueueHandle_t results;          // Deep enough for every job, so workers never block on it
+    std::atomic<uint8_t> workers;   // Tasks still alive
+};
+
+/**
+ * @brief Per-service health schedule
+ */
+struct ServiceHealthState {
+    uint32_t interval_ms;
+    uint32_t next_check;            // millis() when the next probe is due
+    uint32_t last_heartbeat;
+    uint8_t failures;               // Consecutive
+    bool healthy;                   // Result of the last probe
+};
+
+/**
+ * @brief Per-service suspend state and quiesce timings
+ */
+struct ServicePowerState {
+    bool suspended;
+    uint32_t cycles;                // Suspends that took
+    uint32_t suspend_us;            // Last suspend()
+    uint32_t resume_us;             // Last resume()
+    uint32_t suspend_max_us;
+    uint32_t resume_max_us;
 };
 
 /**
@@ -75,6 +160,11 @@ private:
     std::map<String, ServiceInfo> service_registry;
     std::vector<String> startup_order;
     std::vector<String> running_services;
+    std::map<String, ServiceHealthState> health_state;
+    uint32_t health_next_due;       // Earliest next_check, so idle update() calls return early
+    std::map<String, ServicePowerState, StrViewLess> power_state;
+    uint8_t power_mode;             // PowerMode last passed to setPowerMode()
+    uint32_t power_transition_us;   // Whole last setPowerMode() pass
     
     bool initialized;
     bool services_started;
@@ -85,6 +175,7 @@ private:
     uint32_t total_shutdown_time;
     uint32_t services_started_count;
     uint32_t services_failed_count;
+    uint32_t startup_run;           // Tags pool results with their startAllServices() pass
     
 public:
     ServiceManager();
@@ -115,6 +206,16 @@ public:
     bool stopAllServices();
     bool restartService(const String& name);
     
+    // Power modes: entering one suspends, dependents first, every running
+    // service whose suspend_mode it reaches; leaving it resumes them,
+    // dependencies first. A dependency stays up while a dependent could not
+    // be suspended. Called by SimplePower on each mode change
+    bool setPowerMode(uint8_t mode);
+    uint8_t getPowerMode() const { return power_mode; }
+    bool isServiceSuspended(StrView name) const;
+    bool getServicePowerState(const String& name, ServicePowerState* out) const;
+    uint32_t getPowerTransitionTime() const { return power_transition_us; }
+    
     // Dependency management
     bool resolveDependencies();
     std::vector<String> getDependencies(const String& service_name) const;
@@ -122,7 +223,7 @@ public:
     
     // Service information
     bool isServiceRegistered(const String& name) const;
-    bool isServiceRunning(const String& name) const;
+    bool isServiceRunning(StrView name) const;
     ServiceInfo getServiceInfo(const String& name) const;
     std::vector<String> getRegisteredServices() const;
     std::vector<String> getRunningServices() const;
@@ -159,6 +260,21 @@ private:
     bool waitForServiceStartup(const String& name, uint32_t timeout_ms);
     bool waitForServiceShutdown(const String& name, uint32_t timeout_ms);
     
+    // Power modes
+    std::vector<String> dependencyOrder() const;
+    bool hasActiveDependent(const String& name) const;
+    bool suspendService(const String& name);
+    void resumeService(const String& name);
+    
+    // Health scheduling
+    void scheduleHealthCheck(const String& name, uint32_t delay_ms);
+    bool probeService(const String& name, ServiceHealthState& state);
+    
+    // Parallel startup pool
+    ServiceStartupPool* createStartupPool(size_t job_count);
+    void releaseStartupPool(ServiceStartupPool* pool);
+    static void startup_worker_fn(void* param);
+    
     // Event handling
     void onServiceStarted(const String& name);
     void onServiceStopped(const String& name);
@@ -0,0 +1,377 @@
+/**
+ * @file      job_pool.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Work-stealing background job pool: per-worker priority deques, groups, parallel for
+ */
+
+#include "job_pool.h"
+#include "power_governor.h"
+#include "simple_logger.h"
+
+#define DEQUE_MASK          (JOB_POOL_DEQUE - 1)
+
+// head is the steal end (oldest), tail the owner's end (newest)
+struct JobWorker {
+    TaskHandle_t task;
+    portMUX_TYPE mux;
+    Job *deque[JOB_PRIO_COUNT][JOB_POOL_DEQUE];
+    uint32_t head[JOB_PRIO_COUNT];
+    uint32_t tail[JOB_PRIO_COUNT];
+    volatile bool idle;
+};
+
+static JobWorker workers[JOB_POOL_WORKERS];
+static JobPoolStats pool_stats;
+static volatile uint32_t pool_pending = 0;
+static uint32_t pool_next = 0;              // Round robin for outside submitters
+static bool pool_started = false;
+static volatile bool pool_ready = false;     // Every worker is up
+static portMUX_TYPE pool_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static inline void stat_add(uint32_t *counter, uint32_t n) {
+    __atomic_fetch_add(counter, n, __ATOMIC_RELAXED);
+}
+
+// Worker index of the calling task, -1 outside the pool
+static int self_worker() {
+    TaskHandle_t me = xTaskGetCurrentTaskHandle();
+    for (int i = 0; i < JOB_POOL_WORKERS; i++) {
+        if (workers[i].task == me) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// ===== Deques =====
+
+static Job *pop_own(JobWorker *w, uint8_t prio) {
+    Job *job = NULL;
+    portENTER_CRITICAL(&w->mux);
+    while (!job && w->tail[prio] != w->head[prio]) {
+        w->tail[prio]--;
+        job = w->deque[prio][w->tail[prio] & DEQUE_MASK];   // NULL where one was cancelled
+    }
+    if (job) {
+        job->state = JOB_RUNNING;
+    }
+    portEXIT_CRITICAL(&w->mux);
+    return job;
+}
+
+static Job *steal(JobWorker *w, uint8_t prio) {
+    Job *job = NULL;
+    portENTER_CRITICAL(&w->mux);
+    while (!job && w->head[prio] != w->tail[prio]) {
+        job = w->deque[prio][w->head[prio] & DEQUE_MASK];
+        w->head[prio]++;
+    }
+    if (job) {
+        job->state = JOB_RUNNING;
+    }
+    portEXIT_CRITICAL(&w->mux);
+    return job;
+}
+
+// Highest priority first across the pool; own jobs before stolen ones within a priority
+static Job *find_job(int self, bool *stolen) {
+    for (uint8_t prio = 0; prio < JOB_PRIO_COUNT; prio++) {
+        Job *job = pop_own(&workers[self], prio);
+        if (job) {
+            *stolen = false;
+            return job;
+        }
+        for (int i = 1; i < JOB_POOL_WORKERS; i++) {
+            job = steal(&workers[(self + i) % JOB_POOL_WORKERS], prio);
+            if (job) {
+                *stolen = true;
+                return job;
+            }
+        }
+    }
+    return NULL;
+}
+
+// The waiter returns once pending is 0 and no finisher is left inside, so
+// the group (often on its stack) is not touched after it went away
+static void group_finish(JobGroup *group) {
+    if (!group) {
+        return;
+    }
+    __atomic_add_fetch(&group->finishing, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_sub_fetch(&group->pending, 1, __ATOMIC_SEQ_CST) == 0) {
+        xSemaphoreGive(group->done);
+    }
+    __atomic_sub_fetch(&group->finishing, 1, __ATOMIC_SEQ_CST);
+}
+
+static void run_job(int self, Job *job, bool stolen) {
+    uint32_t start = micros();
+    job->fn(job);
+    stat_add(&pool_stats.busy_us[self], micros() - start);
+    stat_add(&pool_stats.executed[self], 1);
+    if (stolen) {
+        stat_add(&pool_stats.stolen[self], 1);
+    }
+    JobGroup *group = job->group;
+    job->state = JOB_DONE;                  // The owner may reuse it from here
+    __atomic_sub_fetch(&pool_pending, 1, __ATOMIC_SEQ_CST);
+    group_finish(group);
+}
+
+// ===== Workers =====
+
+static void worker_task(void *param) {
+    int self = (int)(intptr_t)param;
+    JobWorker *w = &workers[self];
+    while (1) {
+        bool stolen;
+        Job *job = find_job(self, &stolen);
+        if (job) {
+            run_job(self, job, stolen);
+            continue;
+        }
+        w->idle = true;
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        w->idle = false;
+    }
+}
+
+bool job_pool_begin() {
+    portENTER_CRITICAL(&pool_mux);
+    bool started = pool_started;
+    pool_started = true;
+    portEXIT_CRITICAL(&pool_mux);
+    if (started) {
+        return pool_ready;
+    }
+
+    for (int i = 0; i < JOB_POOL_WORKERS; i++) {
+        workers[i].mux = portMUX_INITIALIZER_UNLOCKED;
+    }
+    for (int i = 0; i < JOB_POOL_WORKERS; i++) {
+        char name[8];
+        snprintf(name, sizeof(name), "job%d", i);
+        if (xTaskCreatePinnedToCore(worker_task, name, JOB_POOL_TASK_STACK, (void *)(intptr_t)i,
+                                    JOB_POOL_TASK_PRIORITY, &workers[i].task, i) != pdPASS) {
+            LOG_ERROR("Jobs", "Failed to start a worker");
+            return false;
+        }
+    }
+    // A backlog keeps the clock up
+    power_governor_add_source("jobs", job_pool_pending);
+    pool_ready = true;
+    LOG_INFOF("Jobs", "%d workers", JOB_POOL_WORKERS);
+    return true;
+}
+
+// ===== Jobs =====
+
+bool job_submit(Job *job, job_fn fn, void *ctx, JobPriority priority, JobGroup *group) {
+    if (job->state == JOB_QUEUED || job->state == JOB_RUNNING) {
+        return false;
+    }
+    if (!pool_ready && !job_pool_begin()) {
+        return false;
+    }
+    job->fn = fn;
+    job->ctx = ctx;
+    job->priority = priority < JOB_PRIO_COUNT ? priority : JOB_PRIO_LOW;
+    job->cancel = false;
+    job->group = group;
+
+    int self = self_worker();
+    if (self < 0) {
+        self = __atomic_fetch_add(&pool_next, 1, __ATOMIC_RELAXED) % JOB_POOL_WORKERS;
+    }
+    JobWorker *w = &workers[self];
+    uint8_t prio = job->priority;
+
+    portENTER_CRITICAL(&w->mux);
+    bool full = w->tail[prio] - w->head[prio] >= JOB_POOL_DEQUE;
+    if (!full) {
+        job->worker = self;
+        job->state = JOB_QUEUED;
+        if (group) {
+            __atomic_add_fetch(&group->pending, 1, __ATOMIC_SEQ_CST);
+        }
+        __atomic_add_fetch(&pool_pending, 1, __ATOMIC_SEQ_CST);
+        w->deque[prio][w->tail[prio] & DEQUE_MASK] = job;
+        w->tail[prio]++;
+    }
+    portEXIT_CRITICAL(&w->mux);
+    if (full) {
+        stat_add(&pool_stats.rejected, 1);
+        return false;
+    }
+    stat_add(&pool_stats.submitted, 1);
+
+    xTaskNotifyGive(w->task);
+    // Its own worker is busy: let an idle one steal it
+    if (!w->idle) {
+        for (int i = 1; i < JOB_POOL_WORKERS; i++) {
+            JobWorker *other = &workers[(self + i) % JOB_POOL_WORKERS];
+            if (other->idle) {
+                xTaskNotifyGive(other->task);
+                break;
+            }
+        }
+    }
+    return true;
+}
+
+bool job_cancel(Job *job) {
+    if (job->state != JOB_QUEUED && job->state != JOB_RUNNING) {
+        return job->state != JOB_DONE;
+    }
+    JobWorker *w = &workers[job->worker];
+    uint8_t prio = job->priority;
+    bool dropped = false;
+
+    portENTER_CRITICAL(&w->mux);
+    if (job->state == JOB_QUEUED) {
+        // Leave a hole; pops skip it
+        for (uint32_t i = w->head[prio]; i != w->tail[prio]; i++) {
+            if (w->deque[prio][i & DEQUE_MASK] == job) {
+                w->deque[prio][i & DEQUE_MASK] = NULL;
+                job->state = JOB_CANCELLED;
+                dropped = true;
+                break;
+            }
+        }
+    } else {
+        job->cancel = true;
+    }
+    portEXIT_CRITICAL(&w->mux);
+
+    if (dropped) {
+        stat_add(&pool_stats.cancelled, 1);
+        __atomic_sub_fetch(&pool_pending, 1, __ATOMIC_SEQ_CST);
+        group_finish(job->group);
+    }
+    return dropped;
+}
+
+bool job_cancelled(const Job *job) {
+    return job->cancel;
+}
+
+// ===== Groups =====
+
+void job_group_init(JobGroup *group) {
+    group->pending = 0;
+    group->finishing = 0;
+    group->done = xSemaphoreCreateBinaryStatic(&group->done_buf);
+}
+
+bool job_group_wait(JobGroup *group, uint32_t timeout_ms) {
+    int self = self_worker();
+    uint32_t start = millis();
+    while (group->pending) {
+        uint32_t waited = millis() - start;
+        if (timeout_ms != UINT32_MAX && waited >= timeout_ms) {
+            return false;
+        }
+        // A worker blocking here could deadlock the pool on its own children
+        if (self >= 0) {
+            bool stolen;
+            Job *job = find_job(self, &stolen);
+            if (job) {
+                run_job(self, job, stolen);
+            } else {
+                xSemaphoreTake(group->done, 1);
+            }
+        } else {
+            TickType_t wait = timeout_ms == UINT32_MAX ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms - waited);
+            xSemaphoreTake(group->done, wait ? wait : 1);
+        }
+    }
+    // The last finisher may still be in xSemaphoreGive(); it can be a
+    // lower priority task on this core, so sleep rather than spin
+    while (__atomic_load_n(&group->finishing, __ATOMIC_SEQ_CST)) {
+        vTaskDelay(1);
+    }
+    return true;
+}
+
+// ===== Parallel for =====
+
+struct RangeJob {
+    Job job;
+    job_range_fn fn;
+    void *ctx;
+    uint32_t from;
+    uint32_t to;
+};
+
+static void range_run(Job *job) {
+    RangeJob *r = (RangeJob *)job->ctx;
+    r->fn(r->ctx, r->from, r->to);
+}
+
+void job_parallel_for(uint32_t begin, uint32_t end, uint32_t grain, job_range_fn fn, void *ctx,
+                      JobPriority priority) {
+    if (end <= begin) {
+        return;
+    }
+    uint32_t len = end - begin;
+    grain = grain ? grain : 1;
+    uint32_t chunks = (len + grain - 1) / grain;
+    chunks = chunks < JOB_POOL_SPLIT_MAX ? chunks : JOB_POOL_SPLIT_MAX;
+    if (chunks < 2 || (!pool_ready && !job_pool_begin())) {
+        fn(ctx, begin, end);
+        return;
+    }
+
+    RangeJob ranges[JOB_POOL_SPLIT_MAX];
+    JobGroup group;
+    job_group_init(&group);
+    for (uint32_t i = 0; i < chunks; i++) {
+        RangeJob *r = &ranges[i];
+        r->fn = fn;
+        r->ctx = ctx;
+        r->from = begin + (uint32_t)((uint64_t)len * i / chunks);
+        r->to = begin + (uint32_t)((uint64_t)len * (i + 1) / chunks);
+        r->job.state = JOB_IDLE;
+    }
+    // The first chunk is the caller's; a full deque means running that one here too
+    for (uint32_t i = 1; i < chunks; i++) {
+        if (!job_submit(&ranges[i].job, range_run, &ranges[i], priority, &group)) {
+            fn(ctx, ranges[i].from, ranges[i].to);
+        }
+    }
+    fn(ctx, ranges[0].from, ranges[0].to);
+    job_group_wait(&group);
+}
+
+// ===== Stats =====
+
+uint32_t job_pool_pending() {
+    return pool_pending;
+}
+
+const JobPoolStats *job_pool_stats() {
+    return &pool_stats;
+}
+
+void job_pool_print(Print &out) {
+    out.printf("Jobs: %lu submitted, %lu pending, %lu cancelled, %lu rejected\n",
+               (unsigned long)pool_stats.submitted, (unsigned long)pool_pending,
+               (unsigned long)pool_stats.cancelled, (unsigned long)pool_stats.rejected);
+    for (int i = 0; i < JOB_POOL_WORKERS; i++) {
+        JobWorker *w = &workers[i];
+        uint32_t queued[JOB_PRIO_COUNT];
+        portENTER_CRITICAL(&w->mux);
+        for (uint8_t prio = 0; prio < JOB_PRIO_COUNT; prio++) {
+            queued[prio] = w->tail[prio] - w->head[prio];
+        }
+        portEXIT_CRITICAL(&w->mux);
+        out.printf("  job%d: %lu run, %lu stolen, %lu ms busy, queued %lu/%lu/%lu%s\n", i,
+                   (unsigned long)pool_stats.executed[i], (unsigned long)pool_stats.stolen[i],
+                   (unsigned long)(pool_stats.busy_us[i] / 1000), (unsigned long)queued[0],
+                   (unsigned long)queued[1], (unsigned long)queued[2], w->idle ? ", idle" : "");
+    }
+}
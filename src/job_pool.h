@@ -0,0 +1,125 @@
+/**
+ * @file      job_pool.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Work-stealing background job pool, one worker per core
+ */
+
+#ifndef JOB_POOL_H
+#define JOB_POOL_H
+
+#include <Arduino.h>
+
+/**
+ * Heavy background work (compression, crypto, dithering, indexing, patch
+ * application) goes here instead of onto the UI loop or into a task of its
+ * own. There is one worker per core, each with a deque per priority. A
+ * worker takes its own newest job first, which keeps split work warm in
+ * its cache; an idle worker steals the oldest job of the highest priority
+ * from the other. Jobs submitted from a worker go to that worker's deque,
+ * others are dealt round robin.
+ *
+ * Jobs are intrusive and owned by the submitter; they must stay valid
+ * until they finish. A JobGroup counts outstanding jobs, and waiting on it
+ * from a worker runs queued jobs instead of blocking, so a job may split
+ * itself and wait for its halves. job_cancel() drops a job that has not
+ * started and raises a flag a running one can poll.
+ *
+ * Queued and running jobs are a power governor work source, so a backlog
+ * keeps the clock up until it drains.
+ */
+
+#define JOB_POOL_WORKERS            portNUM_PROCESSORS
+#define JOB_POOL_DEQUE              32      // Per worker and priority, power of two
+#define JOB_POOL_TASK_STACK         (1024 * 6)
+#define JOB_POOL_TASK_PRIORITY      (tskIDLE_PRIORITY + 2)  // Under the UI and radio tasks
+#define JOB_POOL_SPLIT_MAX          16      // Chunks in one parallel for
+
+enum JobPriority {
+    JOB_PRIO_HIGH = 0,
+    JOB_PRIO_NORMAL,
+    JOB_PRIO_LOW,
+    JOB_PRIO_COUNT,
+};
+
+enum JobState {
+    JOB_IDLE = 0,
+    JOB_QUEUED,
+    JOB_RUNNING,
+    JOB_DONE,
+    JOB_CANCELLED,                  // Dropped before it ran
+};
+
+struct Job;
+typedef void (*job_fn)(Job *job);
+
+struct JobGroup {
+    volatile uint32_t pending;
+    volatile uint32_t finishing;    // Finishers still touching the group; it may go out of scope at 0
+    SemaphoreHandle_t done;
+    StaticSemaphore_t done_buf;
+};
+
+struct Job {
+    job_fn fn;
+    void *ctx;
+    uint8_t priority;               // JobPriority
+    volatile uint8_t state;         // JobState
+    volatile bool cancel;
+    uint8_t worker;                 // Whose deque it was queued on
+    JobGroup *group;
+};
+
+struct JobPoolStats {
+    uint32_t submitted;
+    uint32_t executed[JOB_POOL_WORKERS];
+    uint32_t stolen[JOB_POOL_WORKERS];
+    uint32_t cancelled;
+    uint32_t rejected;              // Deque full
+    uint32_t busy_us[JOB_POOL_WORKERS];
+};
+
+bool job_pool_begin();
+
+/**
+ * @brief Queue a job. Safe from any task
+ * @return false if its deque is full; the caller may run it inline
+ */
+bool job_submit(Job *job, job_fn fn, void *ctx = NULL, JobPriority priority = JOB_PRIO_NORMAL,
+                JobGroup *group = NULL);
+
+/**
+ * @brief Drop job if it has not started; otherwise flag it for job_cancelled()
+ * @return true if it will not run
+ */
+bool job_cancel(Job *job);
+bool job_cancelled(const Job *job);
+
+void job_group_init(JobGroup *group);
+
+/**
+ * @brief Until every job in group has finished or been dropped. On a worker,
+ *        runs queued jobs meanwhile
+ * @return false on timeout
+ */
+bool job_group_wait(JobGroup *group, uint32_t timeout_ms = UINT32_MAX);
+
+// [from, to) of a parallel for
+typedef void (*job_range_fn)(void *ctx, uint32_t from, uint32_t to);
+
+/**
+ * @brief Run fn over [begin, end) in chunks of at least grain, spread over the
+ *        workers; the caller runs a chunk too and returns when all are done
+ */
+void job_parallel_for(uint32_t begin, uint32_t end, uint32_t grain, job_range_fn fn, void *ctx,
+                      JobPriority priority = JOB_PRIO_HIGH);
+
+// Queued plus running
+uint32_t job_pool_pending();
+
+const JobPoolStats *job_pool_stats();
+void job_pool_print(Print &out);
+
+#endif // JOB_POOL_H
@@ -0,0 +1,264 @@
+/**
+ * @file      keymap.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Keymap layers, sticky modifiers and chorded shortcuts for the TCA8418 keypad
+ */
+
+#include "keymap.h"
+#include "simple_logger.h"
+#include <lvgl.h>
+#ifdef INTEGRATION_LAYER_ENABLED
+#include "integration/event_bridge.h"
+#include "integration/config_manager.h"
+#endif
+
+#define BS      LV_KEY_BACKSPACE
+#define ENT     LV_KEY_ENTER
+#define SHF     KEYMAP_SHIFT
+#define SYM     KEYMAP_SYMBOL
+#define ALT     KEYMAP_ALT
+#define CHD     KEYMAP_CHORD
+#define ___     KEYMAP_NONE
+
+struct KeymapLayer {
+    uint8_t key[KEYMAP_KEYS];
+};
+
+// Layers as printed on the keyboard, row by row from the top left. The
+// bottom row has five keys on the last five columns
+static constexpr KeymapLayer keymap_base_rows = {{
+    'q', 'w', 'e', 'r', 't', 'y', 'u', 'i', 'o', 'p',
+    'a', 's', 'd', 'f', 'g', 'h', 'j', 'k', 'l', BS,
+    ALT, 'z', 'x', 'c', 'v', 'b', 'n', 'm', '$', ENT,
+    ___, ___, ___, ___, ___, SHF, SYM, ' ', '0', SHF,
+}};
+
+static constexpr KeymapLayer keymap_symbol_rows = {{
+    '#', '1', '2', '3', '(', ')', '_', '-', '+', '@',
+    '*', '4', '5', '6', '/', ':', ';', '\'', '"', BS,
+    ALT, '7', '8', '9', '?', '!', ',', '.', '%', ENT,
+    ___, ___, ___, ___, ___, SHF, SYM, ' ', '0', SHF,
+}};
+
+// Navigation on the left hand and around hjkl, everything else is a shortcut
+static constexpr KeymapLayer keymap_alt_rows = {{
+    LV_KEY_ESC, LV_KEY_UP, CHD, CHD, CHD, CHD, CHD, CHD, CHD, CHD,
+    LV_KEY_LEFT, LV_KEY_DOWN, LV_KEY_RIGHT, CHD, LV_KEY_HOME, LV_KEY_PREV, LV_KEY_NEXT, LV_KEY_END, CHD, LV_KEY_DEL,
+    ALT, CHD, CHD, CHD, CHD, CHD, CHD, CHD, CHD, ENT,
+    ___, ___, ___, ___, ___, SHF, SYM, CHD, CHD, SHF,
+}};
+
+// The TCA8418 numbers keys along a row from the right
+static constexpr uint8_t keymap_pos(uint8_t n) {
+    return (n / KEYMAP_COLS) * KEYMAP_COLS + (KEYMAP_COLS - 1 - n % KEYMAP_COLS);
+}
+
+static constexpr uint8_t keymap_upper(uint8_t c) {
+    return c >= 'a' && c <= 'z' ? c - ('a' - 'A') : c;
+}
+
+// C++11 has no index_sequence, so the key numbers are spelled out here
+template<uint8_t... I> struct KeymapIndices {};
+template<uint8_t N, uint8_t... I> struct KeymapMakeIndices : KeymapMakeIndices<N - 1, N - 1, I...> {};
+template<uint8_t... I> struct KeymapMakeIndices<0, I...> { typedef KeymapIndices<I...> type; };
+typedef KeymapMakeIndices<KEYMAP_KEYS>::type KeymapKeys;
+
+template<uint8_t... I>
+static constexpr KeymapLayer keymap_by_number(const KeymapLayer &rows, KeymapIndices<I...>) {
+    return KeymapLayer{{ rows.key[keymap_pos(I)]... }};
+}
+
+template<uint8_t... I>
+static constexpr KeymapLayer keymap_shifted(const KeymapLayer &rows, KeymapIndices<I...>) {
+    return KeymapLayer{{ keymap_upper(rows.key[keymap_pos(I)])... }};
+}
+
+// Indexed by key number, so decoding an event is one lookup
+static constexpr KeymapLayer keymap_layers[KEYMAP_LAYERS] = {
+    keymap_by_number(keymap_base_rows, KeymapKeys()),
+    keymap_shifted(keymap_base_rows, KeymapKeys()),
+    keymap_by_number(keymap_symbol_rows, KeymapKeys()),
+    keymap_by_number(keymap_alt_rows, KeymapKeys()),
+};
+
+#undef BS
+#undef ENT
+#undef SHF
+#undef SYM
+#undef ALT
+#undef CHD
+#undef ___
+
+static_assert(keymap_layers[KEYMAP_LAYER_BASE].key[0] == 'p', "key 0 is the top right key");
+static_assert(keymap_layers[KEYMAP_LAYER_SHIFT].key[9] == 'Q', "shift layer is the base layer in capitals");
+static_assert(keymap_layers[KEYMAP_LAYER_BASE].key[32] == ' ', "space sits mid bottom row");
+
+// UI task only
+typedef struct {
+    uint32_t key;
+    bool pressed;
+} keymap_out_t;
+
+static keymap_out_t keymap_out[KEYMAP_OUT_SIZE];
+static uint8_t keymap_out_head = 0;
+static uint8_t keymap_out_tail = 0;
+static uint8_t mods_held = 0;
+static uint8_t mods_oneshot = 0;        // Tapped: applies to the next key
+static uint8_t mods_locked = 0;         // Tapped twice: applies until tapped again
+static uint8_t mods_used = 0;           // Held modifiers that another key went out under
+static uint8_t down_key = KEYMAP_KEYS;  // Key number LVGL sees pressed
+static uint32_t down_out = 0;           // What it was sent as
+static uint16_t repeat_delay_ms = KEYMAP_REPEAT_DELAY_MS;
+static uint16_t repeat_interval_ms = 1000 / KEYMAP_REPEAT_RATE_HZ;
+static keymap_chord_cb chord_cb = NULL;
+
+bool keymap_begin() {
+    int delay_ms = KEYMAP_REPEAT_DELAY_MS;
+    int rate_hz = KEYMAP_REPEAT_RATE_HZ;
+#ifdef INTEGRATION_LAYER_ENABLED
+    delay_ms = GET_CONFIG_INT("keymap", "repeat_delay_ms", KEYMAP_REPEAT_DELAY_MS);
+    rate_hz = GET_CONFIG_INT("keymap", "repeat_rate_hz", KEYMAP_REPEAT_RATE_HZ);
+#endif
+    repeat_delay_ms = constrain(delay_ms, 100, 2000);
+    repeat_interval_ms = 1000 / constrain(rate_hz, 1, 50);
+    LOG_INFOF("Keymap", "%d layers, repeat after %u ms every %u ms",
+              KEYMAP_LAYERS, repeat_delay_ms, repeat_interval_ms);
+    return true;
+}
+
+uint8_t keymap_lookup(int layer, uint8_t key) {
+    if (layer < 0 || layer >= KEYMAP_LAYERS || key >= KEYMAP_KEYS) {
+        return KEYMAP_NONE;
+    }
+    return keymap_layers[layer].key[key];
+}
+
+static void push_out(uint32_t key, bool pressed) {
+    if ((uint8_t)(keymap_out_head - keymap_out_tail) >= KEYMAP_OUT_SIZE) {
+        return;
+    }
+    keymap_out[keymap_out_head & (KEYMAP_OUT_SIZE - 1)] = {key, pressed};
+    keymap_out_head++;
+}
+
+static uint8_t modifier_bit(uint8_t entry) {
+    switch (entry) {
+        case KEYMAP_SHIFT:  return KEYMAP_MOD_SHIFT;
+        case KEYMAP_SYMBOL: return KEYMAP_MOD_SYMBOL;
+        case KEYMAP_ALT:    return KEYMAP_MOD_ALT;
+    }
+    return 0;
+}
+
+// A tap without another key in between: off -> one-shot -> locked -> off
+static void modifier_tapped(uint8_t bit) {
+    if (mods_locked & bit) {
+        mods_locked &= ~bit;
+    } else if (mods_oneshot & bit) {
+        mods_oneshot &= ~bit;
+        mods_locked |= bit;
+    } else {
+        mods_oneshot |= bit;
+    }
+}
+
+static void send_chord(const keypad_event_t *ev, uint8_t mods) {
+    KeyChordEvent chord = {mods, ev->code, (char)keymap_lookup(KEYMAP_LAYER_BASE, ev->code),
+                           ev->time_ms, ev->irq_us};
+    if (chord_cb) {
+        chord_cb(&chord);
+    }
+#ifdef INTEGRATION_LAYER_ENABLED
+    if (GlobalEventBridge) {
+        GlobalEventBridge->publishTypedEvent(EventType::USER_INPUT, "Keymap", chord, EventPriority::EVENT_HIGH);
+    }
+#endif
+}
+
+void keymap_feed(const keypad_event_t *ev) {
+    uint8_t base = keymap_lookup(KEYMAP_LAYER_BASE, ev->code);
+    uint8_t bit = modifier_bit(base);
+
+    if (ev->state == KEYPAD_RELEASE) {
+        if (bit) {
+            mods_held &= ~bit;
+            if (!(mods_used & bit)) {
+                modifier_tapped(bit);
+            }
+            mods_used &= ~bit;
+        } else if (ev->code == down_key) {
+            push_out(down_out, false);
+            down_key = KEYMAP_KEYS;
+        }
+        return;
+    }
+
+    if (bit) {
+        mods_held |= bit;
+        mods_used &= ~bit;
+        return;
+    }
+
+    uint8_t mods = mods_held | mods_oneshot | mods_locked;
+    int layer = mods & KEYMAP_MOD_ALT ? KEYMAP_LAYER_ALT :
+                mods & KEYMAP_MOD_SYMBOL ? KEYMAP_LAYER_SYMBOL :
+                mods & KEYMAP_MOD_SHIFT ? KEYMAP_LAYER_SHIFT : KEYMAP_LAYER_BASE;
+    uint8_t entry = keymap_lookup(layer, ev->code);
+    if (entry == KEYMAP_NONE) {
+        return;
+    }
+    mods_used |= mods_held;
+    mods_oneshot = 0;
+
+    if (entry == KEYMAP_CHORD) {
+        send_chord(ev, mods);
+        return;
+    }
+
+    // LVGL tracks one key: a roll-over releases the previous one first
+    if (down_key < KEYMAP_KEYS) {
+        push_out(down_out, false);
+    }
+    down_key = ev->code;
+    down_out = entry;
+    push_out(entry, true);
+}
+
+bool keymap_take(uint32_t *key, bool *pressed) {
+    if (keymap_out_tail == keymap_out_head) {
+        return false;
+    }
+    keymap_out_t *out = &keymap_out[keymap_out_tail & (KEYMAP_OUT_SIZE - 1)];
+    *key = out->key;
+    *pressed = out->pressed;
+    keymap_out_tail++;
+    return true;
+}
+
+bool keymap_pending() {
+    return keymap_out_tail != keymap_out_head;
+}
+
+bool keymap_held() {
+    return down_key < KEYMAP_KEYS;
+}
+
+uint8_t keymap_modifiers() {
+    return mods_held | mods_oneshot | mods_locked;
+}
+
+uint8_t keymap_locked() {
+    return mods_locked;
+}
+
+void keymap_get_repeat(uint16_t *delay_ms, uint16_t *interval_ms) {
+    *delay_ms = repeat_delay_ms;
+    *interval_ms = repeat_interval_ms;
+}
+
+void keymap_set_chord_cb(keymap_chord_cb cb) {
+    chord_cb = cb;
+}
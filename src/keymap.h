@@ -0,0 +1,86 @@
+/**
+ * @file      keymap.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Keymap layers, sticky modifiers and chorded shortcuts for the TCA8418 keypad
+ */
+
+#ifndef KEYMAP_H
+#define KEYMAP_H
+
+#include <Arduino.h>
+#include "peripheral.h"
+
+#define KEYMAP_ROWS                 4
+#define KEYMAP_COLS                 10
+#define KEYMAP_KEYS                 (KEYMAP_ROWS * KEYMAP_COLS)    // TCA8418 key numbers 0-39
+#define KEYMAP_OUT_SIZE             4       // LVGL key events one keypad event can produce, power of two
+
+// Long press repeats the key through LVGL's keypad driver
+#define KEYMAP_REPEAT_DELAY_MS      400
+#define KEYMAP_REPEAT_RATE_HZ       20
+
+enum {
+    KEYMAP_LAYER_BASE = 0,
+    KEYMAP_LAYER_SHIFT,
+    KEYMAP_LAYER_SYMBOL,
+    KEYMAP_LAYER_ALT,
+    KEYMAP_LAYERS,
+};
+
+// Table entries: ASCII and LVGL control keys (LV_KEY_*) go to the focused
+// widget, the values from KEYMAP_CHORD up are handled by the engine
+#define KEYMAP_NONE                 0x00
+#define KEYMAP_CHORD                0xE0    // Published as a shortcut instead of typed
+#define KEYMAP_SHIFT                0xF0
+#define KEYMAP_SYMBOL               0xF1
+#define KEYMAP_ALT                  0xF2
+
+// Modifier bits, as carried in a chord
+#define KEYMAP_MOD_SHIFT            0x01
+#define KEYMAP_MOD_SYMBOL           0x02
+#define KEYMAP_MOD_ALT              0x04
+
+// EventType::USER_INPUT payload
+struct KeyChordEvent {
+    uint8_t mods;               // KEYMAP_MOD_* in effect
+    uint8_t key;                // TCA8418 key number
+    char base;                  // Its base layer character
+    uint32_t time_ms;           // Keypad INT time
+    uint32_t irq_us;            // The same edge, input_trace's tag
+};
+
+typedef void (*keymap_chord_cb)(const KeyChordEvent *chord);
+
+/**
+ * @brief Read the repeat settings. The engine itself needs no setup
+ */
+bool keymap_begin();
+
+/**
+ * @brief Entry for a key on a layer, KEYMAP_NONE past the table
+ */
+uint8_t keymap_lookup(int layer, uint8_t key);
+
+/**
+ * @brief UI task: run one keypad event through the modifiers and layers.
+ *        Keys for LVGL come out of keymap_take(), chords go to the callback
+ *        and the EventBridge
+ */
+void keymap_feed(const keypad_event_t *ev);
+bool keymap_take(uint32_t *key, bool *pressed);
+bool keymap_pending();
+
+/**
+ * @brief True while a typed key is down, so LVGL keeps reading and repeats it
+ */
+bool keymap_held();
+
+uint8_t keymap_modifiers();     // Held, one-shot and locked together
+uint8_t keymap_locked();
+void keymap_get_repeat(uint16_t *delay_ms, uint16_t *interval_ms);
+void keymap_set_chord_cb(keymap_chord_cb cb);
+
+#endif // KEYMAP_H
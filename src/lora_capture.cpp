@@ -0,0 +1,500 @@
+/**
+ * @file      lora_capture.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     LoRa packet capture to SD as pcapng, for Wireshark
+ */
+
+#include "lora_capture.h"
+#include "simple_logger.h"
+#include "peripheral.h"
+#include "sd_manager.h"
+#include "spi_bus.h"
+#include "fs_service.h"
+#include "fs_lz4.h"
+#include "time_service.h"
+#include "timer_wheel.h"
+#include "usb_console.h"
+#include <SD.h>
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+
+#ifdef INTEGRATION_LAYER_ENABLED
+#include "integration/config_manager.h"
+#endif
+
+static_assert(sizeof(LoraTapHeader) == 15, "LoRaTap v0 header");
+static_assert(LORA_CAPTURE_BUF_SIZE % LORA_CAPTURE_SECTOR == 0, "Buffers are whole sectors");
+
+// pcapng blocks, host order; the byte-order magic tells readers it is little-endian
+#define PCAPNG_SHB              0x0A0D0D0AUL
+#define PCAPNG_IDB              0x00000001UL
+#define PCAPNG_EPB              0x00000006UL
+#define PCAPNG_CB_NOCOPY        0x00000BADUL    // Custom block, dropped when a tool rewrites the file
+#define PCAPNG_BYTE_ORDER       0x1A2B3C4DUL
+#define PCAPNG_OPT_END          0
+#define PCAPNG_EPB_FLAGS        2
+#define PCAPNG_FLAG_IN          0x00000001UL
+#define PCAPNG_FLAG_OUT         0x00000002UL
+#define PCAPNG_FLAG_CRC_ERROR   0x80000000UL    // Link-layer error bits, 31 is CRC
+#define PCAPNG_PAD_PEN          32473           // IANA example enterprise; the block only pads
+
+#define CAP_SHB_SIZE            28
+#define CAP_IDB_SIZE            20
+#define CAP_EPB_FIXED           (28 + 12 + 4)   // Header, flags option and end, trailing length
+#define CAP_PAD_MIN             16              // Smallest custom block
+#define CAP_STOP_WAIT_MS        2000
+
+enum {
+    CAP_FREE = 0,
+    CAP_FILLING,
+    CAP_SEALED,                 // Waiting in cap_sealed for its append
+    CAP_OUT,                    // With the FS service
+};
+
+typedef struct {
+    uint8_t *data;
+    uint16_t fill;
+    uint8_t state;
+    uint16_t file;              // Index of the file it goes to
+    uint32_t opened_ms;         // First record in it
+} cap_buf_t;
+
+volatile bool lora_capture_on = false;
+
+static cap_buf_t cap_bufs[LORA_CAPTURE_BUFS];
+static int cap_cur = -1;
+static uint8_t cap_sealed[LORA_CAPTURE_BUFS];  // In seal order
+static uint8_t cap_sealed_head = 0;
+static uint8_t cap_sealed_tail = 0;
+static uint16_t cap_file = 0;
+static bool cap_file_new = false;       // The next buffer opens with the file headers
+static uint32_t cap_file_bytes = 0;
+static bool cap_scanned = false;
+static LoraCaptureStats cap_stats;
+static portMUX_TYPE cap_mux = portMUX_INITIALIZER_UNLOCKED;
+static SemaphoreHandle_t cap_submit_lock = NULL;    // Appends go out in seal order
+static WheelTimer cap_timer;
+static bool cap_sd_client = false;
+static bool cap_compress = false;
+static FsLz4Stream *cap_lz4 = NULL;     // Compressed: the current file's stream, under cap_submit_lock
+static uint16_t cap_lz4_file = 0;
+
+// ===== pcapng =====
+
+static inline void put32(uint8_t *p, uint32_t v) {
+    memcpy(p, &v, 4);
+}
+
+static inline void put16(uint8_t *p, uint16_t v) {
+    memcpy(p, &v, 2);
+}
+
+static size_t write_headers(uint8_t *p) {
+    // Section header, no options; section length unknown (-1)
+    put32(p, PCAPNG_SHB);
+    put32(p + 4, CAP_SHB_SIZE);
+    put32(p + 8, PCAPNG_BYTE_ORDER);
+    put16(p + 12, 1);
+    put16(p + 14, 0);
+    put32(p + 16, 0xFFFFFFFFUL);
+    put32(p + 20, 0xFFFFFFFFUL);
+    put32(p + 24, CAP_SHB_SIZE);
+    p += CAP_SHB_SIZE;
+
+    // One interface, microsecond stamps (the default resolution), no snap length
+    put32(p, PCAPNG_IDB);
+    put32(p + 4, CAP_IDB_SIZE);
+    put16(p + 8, LORA_CAPTURE_LINKTYPE);
+    put16(p + 10, 0);
+    put32(p + 12, 0);
+    put32(p + 16, CAP_IDB_SIZE);
+    return CAP_SHB_SIZE + CAP_IDB_SIZE;
+}
+
+static void write_pad(uint8_t *p, size_t len) {
+    put32(p, PCAPNG_CB_NOCOPY);
+    put32(p + 4, len);
+    put32(p + 8, PCAPNG_PAD_PEN);
+    memset(p + 12, 0, len - 16);
+    put32(p + len - 4, len);
+}
+
+// ===== Buffers =====
+
+// Under cap_mux: close the current buffer, padded to size bytes. Compressed
+// there is no sector to fill: the stream writes blocks of its own
+static void seal(size_t size) {
+    cap_buf_t *b = &cap_bufs[cap_cur];
+    if (cap_compress) {
+        size = b->fill;
+    } else {
+        write_pad(b->data + b->fill, size - b->fill);
+    }
+    b->fill = size;
+    b->state = CAP_SEALED;
+    cap_sealed[cap_sealed_head++ % LORA_CAPTURE_BUFS] = cap_cur;
+    cap_cur = -1;
+
+    cap_file_bytes += size;
+    if (cap_file_bytes + LORA_CAPTURE_BUF_SIZE > LORA_CAPTURE_FILE_MAX) {
+        cap_file = (cap_file + 1) % LORA_CAPTURE_FILES;
+        cap_file_new = true;
+        cap_file_bytes = 0;
+    }
+
+    uint8_t out = 0;
+    for (int i = 0; i < LORA_CAPTURE_BUFS; i++) {
+        out += cap_bufs[i].state >= CAP_SEALED;
+    }
+    if (out > cap_stats.bufs_out_max) {
+        cap_stats.bufs_out_max = out;
+    }
+}
+
+// Under cap_mux: a buffer to append to, or -1 with every one out
+static int open_buf() {
+    for (int i = 0; i < LORA_CAPTURE_BUFS; i++) {
+        cap_buf_t *b = &cap_bufs[i];
+        if (b->state != CAP_FREE) {
+            continue;
+        }
+        b->state = CAP_FILLING;
+        b->fill = 0;
+        b->file = cap_file;
+        b->opened_ms = millis();
+        if (cap_file_new) {
+            b->fill = write_headers(b->data);
+            cap_file_new = false;
+            cap_stats.files++;
+        }
+        cap_cur = i;
+        return i;
+    }
+    return -1;
+}
+
+static void make_path(char *out, size_t len, uint16_t file) {
+    snprintf(out, len, LORA_CAPTURE_DIR "/lora_%03u.pcapng%s", (unsigned)file, cap_compress ? ".lz4" : "");
+}
+
+// Under cap_submit_lock: the buffer goes into the file's stream, which
+// copies it, so it is free again at once
+static void submit_compressed(int i) {
+    cap_buf_t *b = &cap_bufs[i];
+    if (!cap_lz4 || cap_lz4_file != b->file) {
+        if (cap_lz4) {
+            fs_lz4_close(cap_lz4, 0);
+        }
+        char path[FS_PATH_MAX];
+        make_path(path, sizeof(path), b->file);
+        cap_lz4 = fs_lz4_open(SD, path);
+        cap_lz4_file = b->file;
+    }
+    bool ok = cap_lz4 && fs_lz4_write(cap_lz4, b->data, b->fill);
+    portENTER_CRITICAL(&cap_mux);
+    if (ok) {
+        cap_stats.bytes += b->fill;
+    } else {
+        cap_stats.write_errors++;
+    }
+    b->state = CAP_FREE;
+    portEXIT_CRITICAL(&cap_mux);
+}
+
+static void write_done(const FsResult *res, void *ctx) {
+    cap_buf_t *b = &cap_bufs[(intptr_t)ctx];
+    portENTER_CRITICAL(&cap_mux);
+    if (res->ok) {
+        cap_stats.bytes += res->size;
+    } else {
+        cap_stats.write_errors++;
+    }
+    b->state = CAP_FREE;
+    portEXIT_CRITICAL(&cap_mux);
+}
+
+// Hand sealed buffers to the FS service, oldest first
+static void submit() {
+    if (cap_sealed_tail == cap_sealed_head) {
+        return;
+    }
+    xSemaphoreTake(cap_submit_lock, portMAX_DELAY);
+    while (true) {
+        int i = -1;
+        portENTER_CRITICAL(&cap_mux);
+        if (cap_sealed_tail != cap_sealed_head) {
+            i = cap_sealed[cap_sealed_tail++ % LORA_CAPTURE_BUFS];
+            cap_bufs[i].state = CAP_OUT;
+        }
+        portEXIT_CRITICAL(&cap_mux);
+        if (i < 0) {
+            break;
+        }
+        if (cap_compress) {
+            submit_compressed(i);
+            continue;
+        }
+        char path[FS_PATH_MAX];
+        make_path(path, sizeof(path), cap_bufs[i].file);
+        if (!fs_append(SD, path, cap_bufs[i].data, cap_bufs[i].fill, write_done, (void *)(intptr_t)i)) {
+            portENTER_CRITICAL(&cap_mux);
+            cap_stats.write_errors++;
+            cap_bufs[i].state = CAP_FREE;
+            portEXIT_CRITICAL(&cap_mux);
+        }
+    }
+    xSemaphoreGive(cap_submit_lock);
+}
+
+// A quiet radio still gets its frames to the card within the flush time
+static void flush_tick(WheelTimer *timer) {
+    portENTER_CRITICAL(&cap_mux);
+    if (cap_cur >= 0 && cap_bufs[cap_cur].fill &&
+        millis() - cap_bufs[cap_cur].opened_ms >= LORA_CAPTURE_FLUSH_MS) {
+        size_t fill = cap_bufs[cap_cur].fill;
+        seal((fill + CAP_PAD_MIN + LORA_CAPTURE_SECTOR - 1) / LORA_CAPTURE_SECTOR * LORA_CAPTURE_SECTOR);
+    }
+    portEXIT_CRITICAL(&cap_mux);
+    submit();
+}
+
+// ===== Capture =====
+
+void lora_capture_frame(bool rx, const uint8_t *data, size_t len, float rssi, float snr, bool crc_ok) {
+    if (!lora_capture_on) {
+        return;
+    }
+    const lora_profile_t *p = lora_get_profile();
+    int64_t ts = time_at_mono_us(esp_timer_get_time());
+    size_t cap_len = sizeof(LoraTapHeader) + len;
+    size_t block = CAP_EPB_FIXED + ((cap_len + 3) & ~3);
+
+    portENTER_CRITICAL(&cap_mux);
+    if (cap_cur >= 0 && cap_bufs[cap_cur].fill + block + CAP_PAD_MIN > LORA_CAPTURE_BUF_SIZE) {
+        seal(LORA_CAPTURE_BUF_SIZE);
+    }
+    if (cap_cur < 0 && open_buf() < 0) {
+        cap_stats.dropped++;
+        portEXIT_CRITICAL(&cap_mux);
+        return;
+    }
+    cap_buf_t *b = &cap_bufs[cap_cur];
+    uint8_t *o = b->data + b->fill;
+    b->fill += block;
+
+    put32(o, PCAPNG_EPB);
+    put32(o + 4, block);
+    put32(o + 8, 0);
+    put32(o + 12, (uint32_t)((uint64_t)ts >> 32));
+    put32(o + 16, (uint32_t)ts);
+    put32(o + 20, cap_len);
+    put32(o + 24, cap_len);
+
+    LoraTapHeader *tap = (LoraTapHeader *)(o + 28);
+    uint32_t hz = (uint32_t)lroundf(p->freq * 1e6f);
+    int rssi_field = (int)lroundf(rssi) + 139;
+    tap->version = 0;
+    tap->padding = 0;
+    tap->length = __builtin_bswap16(sizeof(LoraTapHeader));
+    tap->frequency = __builtin_bswap32(hz);
+    // GFSK frames have neither; SF 0 tells them apart in Wireshark
+    bool fsk = lora_fsk_running() != NULL;
+    tap->bandwidth = fsk ? 0 : (uint8_t)lroundf(p->bw / 125.0f);
+    tap->sf = fsk ? 0 : p->sf;
+    tap->packet_rssi = rx ? constrain(rssi_field, 0, 255) : 0;
+    tap->max_rssi = 0;
+    tap->current_rssi = 0;
+    tap->snr = rx ? (int8_t)constrain(lroundf(snr * 4), -128, 127) : 0;
+    tap->sync_word = p->sync_word;
+    memcpy(o + 28 + sizeof(LoraTapHeader), data, len);
+    memset(o + 28 + cap_len, 0, ((cap_len + 3) & ~3) - cap_len);
+
+    uint8_t *opt = o + 28 + ((cap_len + 3) & ~3);
+    put16(opt, PCAPNG_EPB_FLAGS);
+    put16(opt + 2, 4);
+    put32(opt + 4, (rx ? PCAPNG_FLAG_IN : PCAPNG_FLAG_OUT) | (crc_ok ? 0 : PCAPNG_FLAG_CRC_ERROR));
+    put16(opt + 8, PCAPNG_OPT_END);
+    put16(opt + 10, 0);
+    put32(opt + 12, block);
+
+    if (rx) {
+        cap_stats.rx++;
+        cap_stats.crc_errors += !crc_ok;
+    } else {
+        cap_stats.tx++;
+    }
+    bool sealed = cap_sealed_tail != cap_sealed_head;
+    portEXIT_CRITICAL(&cap_mux);
+
+    if (sealed) {
+        submit();
+    }
+}
+
+// Eject: what is buffered goes out before the unmount
+static void capture_detach() {
+    lora_capture_stop();
+}
+
+// Next index past the highest file already on the card
+static bool scan_files() {
+    SpiBusHold bus(SPI_CLIENT_SD);
+    if (!SD.exists(LORA_CAPTURE_DIR) && !SD.mkdir(LORA_CAPTURE_DIR)) {
+        return false;
+    }
+    File dir = SD.open(LORA_CAPTURE_DIR);
+    if (!dir) {
+        return false;
+    }
+    int next = 0;
+    for (File f = dir.openNextFile(); f; f = dir.openNextFile()) {
+        const char *name = strrchr(f.name(), '/');
+        name = name ? name + 1 : f.name();
+        unsigned n;
+        if (sscanf(name, "lora_%u.pcapng", &n) == 1 && (int)n >= next) {
+            next = n + 1;
+        }
+        f.close();
+    }
+    dir.close();
+    cap_file = next % LORA_CAPTURE_FILES;
+    return true;
+}
+
+bool lora_capture_start() {
+    if (lora_capture_on) {
+        return true;
+    }
+    if (!cap_submit_lock || !sd_manager_mounted()) {
+        LOG_WARN("LoraCap", "No SD card");
+        return false;
+    }
+    for (int i = 0; i < LORA_CAPTURE_BUFS; i++) {
+        if (!cap_bufs[i].data) {
+            cap_bufs[i].data = (uint8_t *)heap_caps_malloc(LORA_CAPTURE_BUF_SIZE, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+            if (!cap_bufs[i].data) {
+                LOG_ERROR("LoraCap", "Failed to allocate the buffers");
+                return false;
+            }
+        }
+    }
+    if (!cap_sd_client) {
+        cap_sd_client = sd_manager_add_client("LoraCap", NULL, capture_detach);
+    }
+    if (!cap_scanned) {
+        if (!scan_files()) {
+            LOG_ERROR("LoraCap", "Cannot use " LORA_CAPTURE_DIR);
+            return false;
+        }
+        cap_scanned = true;
+    } else {
+        cap_file = (cap_file + 1) % LORA_CAPTURE_FILES;
+    }
+
+    portENTER_CRITICAL(&cap_mux);
+    memset(&cap_stats, 0, sizeof(cap_stats));
+    make_path(cap_stats.path, sizeof(cap_stats.path), cap_file);
+    cap_file_new = true;
+    cap_file_bytes = 0;
+    portEXIT_CRITICAL(&cap_mux);
+
+    // A leftover file with this name would be appended to
+    fs_remove(SD, cap_stats.path);
+    lora_capture_on = true;
+    timer_wheel_arm(&cap_timer, LORA_CAPTURE_FLUSH_MS, LORA_CAPTURE_FLUSH_MS);
+    LOG_INFOF("LoraCap", "Capturing to %s", cap_stats.path);
+    return true;
+}
+
+void lora_capture_stop() {
+    if (!lora_capture_on) {
+        return;
+    }
+    lora_capture_on = false;
+    timer_wheel_cancel(&cap_timer);
+
+    portENTER_CRITICAL(&cap_mux);
+    if (cap_cur >= 0) {
+        size_t fill = cap_bufs[cap_cur].fill;
+        seal((fill + CAP_PAD_MIN + LORA_CAPTURE_SECTOR - 1) / LORA_CAPTURE_SECTOR * LORA_CAPTURE_SECTOR);
+    }
+    portEXIT_CRITICAL(&cap_mux);
+    submit();
+
+    uint32_t start = millis();
+    while (millis() - start < CAP_STOP_WAIT_MS) {
+        bool out = false;
+        portENTER_CRITICAL(&cap_mux);
+        for (int i = 0; i < LORA_CAPTURE_BUFS; i++) {
+            out |= cap_bufs[i].state != CAP_FREE;
+        }
+        portEXIT_CRITICAL(&cap_mux);
+        if (!out) {
+            break;
+        }
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    xSemaphoreTake(cap_submit_lock, portMAX_DELAY);
+    if (cap_lz4) {
+        fs_lz4_close(cap_lz4);
+        cap_lz4 = NULL;
+    }
+    xSemaphoreGive(cap_submit_lock);
+    LOG_INFOF("LoraCap", "Capture stopped: %lu rx (%lu bad CRC), %lu tx, %lu bytes, %lu dropped, %lu write errors",
+              (unsigned long)cap_stats.rx, (unsigned long)cap_stats.crc_errors, (unsigned long)cap_stats.tx,
+              (unsigned long)cap_stats.bytes, (unsigned long)cap_stats.dropped,
+              (unsigned long)cap_stats.write_errors);
+}
+
+void lora_capture_get_stats(LoraCaptureStats *stats) {
+    portENTER_CRITICAL(&cap_mux);
+    *stats = cap_stats;
+    portEXIT_CRITICAL(&cap_mux);
+    stats->running = lora_capture_on;
+}
+
+static void rpc_lcap(Print &out, const char *args) {
+    if (!strcmp(args, "start")) {
+        out.println(lora_capture_start() ? "ok" : "failed, see the log");
+        return;
+    }
+    if (!strcmp(args, "stop")) {
+        lora_capture_stop();
+        out.println("ok");
+        return;
+    }
+    if (args[0]) {
+        out.println("usage: lcap [start | stop]");
+        return;
+    }
+    LoraCaptureStats s;
+    lora_capture_get_stats(&s);
+    out.printf("%s %s, %lu files\n", s.running ? "capturing to" : "stopped, last", s.path, (unsigned long)s.files);
+    out.printf("rx %lu (bad CRC %lu), tx %lu, %lu bytes\n", (unsigned long)s.rx, (unsigned long)s.crc_errors,
+               (unsigned long)s.tx, (unsigned long)s.bytes);
+    out.printf("dropped %lu, write errors %lu, buffers out max %u/%u\n", (unsigned long)s.dropped,
+               (unsigned long)s.write_errors, s.bufs_out_max, LORA_CAPTURE_BUFS);
+}
+
+bool lora_capture_begin() {
+    if (cap_submit_lock) {
+        return true;
+    }
+    cap_submit_lock = xSemaphoreCreateMutex();
+    if (!cap_submit_lock) {
+        LOG_ERROR("LoraCap", "Failed to create the lock");
+        return false;
+    }
+    timer_wheel_init(&cap_timer, "lcap", flush_tick);
+    usb_console_rpc("lcap", rpc_lcap);
+#ifdef INTEGRATION_LAYER_ENABLED
+    cap_compress = GET_CONFIG_BOOL("capture", "compress", false);
+    if (GET_CONFIG_BOOL("capture", "lora", false)) {
+        return lora_capture_start();
+    }
+#endif
+    return true;
+}
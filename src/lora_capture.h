@@ -0,0 +1,104 @@
+/**
+ * @file      lora_capture.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     LoRa packet capture to SD as pcapng, for Wireshark
+ */
+
+#ifndef LORA_CAPTURE_H
+#define LORA_CAPTURE_H
+
+#include <Arduino.h>
+
+/**
+ * Every frame on air, as it was on air: received ones straight out of the
+ * radio, before decryption and unpacking, CRC failures included and
+ * flagged; sent ones as they start. Each is an Enhanced Packet Block with
+ * link type LoRaTap (270): frequency, bandwidth, SF, RSSI and SNR in a
+ * small header ahead of the payload, the direction in epb_flags. Stamps
+ * are UTC once time_service has a source, time since boot before.
+ *
+ * The radio task only copies a record into the current buffer under a
+ * spinlock. A full buffer, or one left open for LORA_CAPTURE_FLUSH_MS, is
+ * padded to a whole number of sectors with a custom block readers skip
+ * and queued on the FS service as one append; buffers come back when the
+ * write completes. Every write is sectors at a sector offset, so the card
+ * never reads to modify. With all buffers out, records are counted as
+ * dropped rather than waited for.
+ *
+ * Files are /capture/lora_NNN.pcapng, a new one past LORA_CAPTURE_FILE_MAX.
+ * Console: "lcap start", "lcap stop", "lcap" for the counters. Config
+ * capture.lora starts one at boot.
+ *
+ * With capture.compress the files are lora_NNN.pcapng.lz4, written through
+ * fs_lz4: sealed buffers are copied into the stream unpadded and the stream
+ * does the block-sized writes. bytes and LORA_CAPTURE_FILE_MAX then count
+ * pcapng bytes before compression.
+ */
+
+#define LORA_CAPTURE_DIR            "/capture"
+#define LORA_CAPTURE_SECTOR         512
+#define LORA_CAPTURE_BUF_SIZE       (8 * LORA_CAPTURE_SECTOR)   // One append
+#define LORA_CAPTURE_BUFS           4                           // PSRAM
+#define LORA_CAPTURE_FLUSH_MS       5000
+#define LORA_CAPTURE_FILE_MAX       (32UL * 1024 * 1024)
+#define LORA_CAPTURE_FILES          1000                        // lora_000 to lora_999
+#define LORA_CAPTURE_LINKTYPE       270                         // LINKTYPE_LORATAP
+
+// LoRaTap v0, big-endian fields
+struct __attribute__((packed)) LoraTapHeader {
+    uint8_t version;                // 0
+    uint8_t padding;
+    uint16_t length;                // sizeof(LoraTapHeader)
+    uint32_t frequency;             // Hz
+    uint8_t bandwidth;              // In 125 kHz steps
+    uint8_t sf;
+    uint8_t packet_rssi;            // dBm + 139
+    uint8_t max_rssi;
+    uint8_t current_rssi;
+    int8_t snr;                     // dB * 4
+    uint8_t sync_word;
+};
+
+struct LoraCaptureStats {
+    bool running;
+    char path[32];
+    uint32_t rx;
+    uint32_t tx;
+    uint32_t crc_errors;            // Received with a bad CRC, captured and flagged
+    uint32_t dropped;               // No buffer free
+    uint32_t write_errors;          // Appends that failed or were refused
+    uint32_t bytes;                 // Written since the capture started, uncompressed
+    uint32_t files;
+    uint8_t bufs_out_max;           // Most buffers waiting on the card at once
+};
+
+/**
+ * @brief Console command and config; starts a capture if capture.lora is set
+ */
+bool lora_capture_begin();
+
+/**
+ * @brief Open the next free capture file and start capturing
+ */
+bool lora_capture_start();
+
+/**
+ * @brief Write out what is buffered and close the capture
+ */
+void lora_capture_stop();
+
+/**
+ * @brief Radio task: one frame. rx false for a frame being sent; crc_ok
+ *        false for a received frame that failed its CRC
+ */
+void lora_capture_frame(bool rx, const uint8_t *data, size_t len, float rssi, float snr, bool crc_ok);
+
+extern volatile bool lora_capture_on;
+static inline bool lora_capture_running() { return lora_capture_on; }
+
+void lora_capture_get_stats(LoraCaptureStats *stats);
+
+#endif // LORA_CAPTURE_H
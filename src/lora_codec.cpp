@@ -0,0 +1,112 @@
+/**
+ * @file      lora_codec.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Short-message compression for LoRa payloads: greedy dictionary
+ *            match, canonical Huffman code from the generated tables
+ */
+
+#include "lora_codec.h"
+#include "lora_dict.h"
+
+static_assert(LORA_DICT_SYMBOLS == 256 + LORA_DICT_ENTRIES + 1, "lora_dict.h is out of step with lora_codec");
+
+// Longest entry starting at in[0], as a symbol; the byte itself otherwise
+static inline uint16_t next_symbol(const uint8_t *in, size_t left, size_t *used) {
+    for (uint16_t n = lora_dict_first[in[0]]; n < lora_dict_first[in[0] + 1]; n++) {
+        size_t len = lora_dict_offset[n + 1] - lora_dict_offset[n];
+        if (len <= left && memcmp(in, lora_dict_text + lora_dict_offset[n], len) == 0) {
+            *used = len;
+            return 256 + n;
+        }
+    }
+    *used = 1;
+    return in[0];
+}
+
+size_t lora_codec_encode(const uint8_t *in, size_t len, uint8_t *out, size_t cap) {
+    if (len < 3) {
+        return 0;
+    }
+    // Only worth sending when it saves at least a byte
+    size_t limit = len - 1 < cap ? len - 1 : cap;
+    out[0] = LORA_CODEC_MAGIC;
+    size_t pos = 1;
+    uint32_t acc = 0;
+    uint8_t bits = 0;
+    size_t i = 0;
+    bool end = false;
+    while (!end) {
+        uint16_t sym = LORA_DICT_EOF;
+        if (i < len) {
+            size_t used;
+            sym = next_symbol(in + i, len - i, &used);
+            i += used;
+        } else {
+            end = true;
+        }
+        acc = (acc << lora_code_len[sym]) | lora_code_bits[sym];
+        bits += lora_code_len[sym];
+        while (bits >= 8) {
+            if (pos == limit) {
+                return 0;
+            }
+            bits -= 8;
+            out[pos++] = acc >> bits;
+        }
+    }
+    if (bits) {
+        if (pos == limit) {
+            return 0;
+        }
+        out[pos++] = acc << (8 - bits);
+    }
+    return pos;
+}
+
+int lora_codec_decode(const uint8_t *in, size_t len, uint8_t *out, size_t cap) {
+    if (!lora_codec_is_packed(in, len)) {
+        return -1;
+    }
+    size_t total_bits = (len - 1) * 8;
+    size_t bit = 0;
+    size_t pos = 0;
+    for (;;) {
+        uint16_t code = 0;
+        uint16_t sym = LORA_DICT_SYMBOLS;
+        for (uint8_t l = 1; l <= LORA_DICT_MAX_CODE; l++) {
+            if (bit == total_bits) {
+                return -1;              // Ran out before the end marker
+            }
+            code = (code << 1) | ((in[1 + bit / 8] >> (7 - bit % 8)) & 1);
+            bit++;
+            uint16_t at = code - lora_code_base[l];
+            if (code >= lora_code_base[l] && at < lora_code_count[l]) {
+                sym = lora_code_symbols[lora_code_start[l] + at];
+                break;
+            }
+        }
+        if (sym == LORA_DICT_SYMBOLS) {
+            return -1;
+        }
+        if (sym == LORA_DICT_EOF) {
+            return pos;
+        }
+        if (sym < 256) {
+            if (pos == cap) {
+                return -1;
+            }
+            out[pos++] = sym;
+        } else {
+            uint16_t n = sym - 256;
+            size_t entry = lora_dict_offset[n + 1] - lora_dict_offset[n];
+            if (pos + entry > cap) {
+                return -1;
+            }
+            memcpy(out + pos, lora_dict_text + lora_dict_offset[n], entry);
+            pos += entry;
+        }
+    }
+}
@@ -0,0 +1,46 @@
+/**
+ * @file      lora_codec.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Short-message compression for LoRa payloads: static dictionary and Huffman code
+ */
+
+#ifndef LORA_CODEC_H
+#define LORA_CODEC_H
+
+#include <Arduino.h>
+
+/**
+ * Tuned for what goes over LoRa: a few words of typed text or a line of
+ * key=value telemetry, where a general-purpose compressor has nothing to
+ * learn from. The dictionary and the code are trained ahead of time on
+ * script/lora_corpus.txt by script/lora_dict.py, which writes them to
+ * src/lora_dict.h as constexpr tables, so neither side keeps state.
+ *
+ * peri_lora packs every packet at submit (before lora_crypt seals it)
+ * when that makes it shorter, and unpacks on receive; a packed payload
+ * starts with LORA_CODEC_MAGIC, the per-packet flag. Config lora.compress
+ * (true) turns packing off; unpacking always works.
+ */
+
+#define LORA_CODEC_MAGIC            0xFD    // Never starts UTF-8 text; lora_crypt has 0xFE
+
+/**
+ * @brief Pack len bytes into out, marker included
+ * @return Packed length; 0 when that is not shorter than len or exceeds cap
+ */
+size_t lora_codec_encode(const uint8_t *in, size_t len, uint8_t *out, size_t cap);
+
+/**
+ * @brief Unpack a packed payload (marker included) into out
+ * @return Unpacked length; -1 for a corrupt payload or one that exceeds cap
+ */
+int lora_codec_decode(const uint8_t *in, size_t len, uint8_t *out, size_t cap);
+
+inline bool lora_codec_is_packed(const uint8_t *buf, size_t len) {
+    return len >= 2 && buf[0] == LORA_CODEC_MAGIC;
+}
+
+#endif // LORA_CODEC_H
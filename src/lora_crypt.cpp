@@ -0,0 +1,298 @@
+/**
+ * @file      lora_crypt.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     LoRa link encryption: in-place AES-CCM on the pooled packet
+ *            buffers, NVS-reserved sequence numbers, per-sender replay windows
+ */
+
+#include "lora_crypt.h"
+#include <Preferences.h>
+#include <esp_timer.h>
+#include <mbedtls/ccm.h>
+#include "simple_logger.h"
+#ifdef INTEGRATION_LAYER_ENABLED
+#include "integration/config_manager.h"
+#endif
+
+#define CRYPT_NONCE_LEN     13
+
+struct CryptPeer {
+    uint32_t id;
+    uint32_t heard_ms;              // For eviction; 0 marks a free slot
+    bool has_key;
+    bool seen;                      // top is valid
+    uint32_t top;                   // Highest sequence number accepted
+    uint64_t window;                // Bit n: top - n was accepted
+    mbedtls_ccm_context ccm;
+};
+
+static bool crypt_on = false;
+static bool crypt_require = false;
+static uint32_t crypt_node = 0;
+static uint8_t crypt_key[LORA_CRYPT_KEY_LEN];
+
+// TX side, under the radio lock
+static mbedtls_ccm_context crypt_tx;
+static uint32_t crypt_seq = 0;
+static uint32_t crypt_seq_limit = 0;    // First number not reserved yet
+
+// RX side, on the LoRa task
+static CryptPeer crypt_peers[LORA_CRYPT_PEERS];
+
+static portMUX_TYPE crypt_mux = portMUX_INITIALIZER_UNLOCKED;
+static LoraCryptStats crypt_stats;
+
+static inline void put32(uint8_t *p, uint32_t v) {
+    p[0] = v;
+    p[1] = v >> 8;
+    p[2] = v >> 16;
+    p[3] = v >> 24;
+}
+
+static inline uint32_t get32(const uint8_t *p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static bool hex_key(const String &hex, uint8_t *out) {
+    if (hex.length() != LORA_CRYPT_KEY_LEN * 2) {
+        return false;
+    }
+    for (size_t i = 0; i < LORA_CRYPT_KEY_LEN; i++) {
+        char byte[3] = {hex[i * 2], hex[i * 2 + 1], '\0'};
+        char *end;
+        out[i] = strtoul(byte, &end, 16);
+        if (*end) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Numbers handed out before a reset are never used again, at the cost of
+// skipping what was left of the reserved block
+static bool reserve_seq() {
+    Preferences prefs;
+    if (!prefs.begin(LORA_CRYPT_NVS_NAMESPACE, false)) {
+        return false;
+    }
+    uint32_t limit = crypt_seq + LORA_CRYPT_SEQ_RESERVE;
+    bool ok = prefs.putUInt("seq", limit) == sizeof(uint32_t);
+    prefs.end();
+    if (ok) {
+        crypt_seq_limit = limit;
+    }
+    return ok;
+}
+
+static void nonce_of(uint8_t *nonce, uint32_t sender, uint32_t seq) {
+    memset(nonce, 0, CRYPT_NONCE_LEN);
+    put32(nonce, sender);
+    put32(nonce + 4, seq);
+}
+
+static void note_time(uint32_t *max_us, int64_t start) {
+    uint32_t us = esp_timer_get_time() - start;
+    portENTER_CRITICAL(&crypt_mux);
+    if (us > *max_us) {
+        *max_us = us;
+    }
+    portEXIT_CRITICAL(&crypt_mux);
+}
+
+#define CRYPT_COUNT(field) do { \
+    portENTER_CRITICAL(&crypt_mux); crypt_stats.field++; portEXIT_CRITICAL(&crypt_mux); \
+} while (0)
+
+// ===== Peers =====
+
+static CryptPeer *peer_find(uint32_t id) {
+    uint32_t now = millis() | 1;
+    CryptPeer *slot = nullptr;
+    for (int i = 0; i < LORA_CRYPT_PEERS; i++) {
+        CryptPeer *p = &crypt_peers[i];
+        if (p->heard_ms && p->id == id) {
+            if (p->has_key) {
+                p->heard_ms = now;
+                return p;
+            }
+            // A sender without a key is looked up again now and then
+            if (now - p->heard_ms < LORA_CRYPT_RETRY_MS) {
+                return p;
+            }
+            slot = p;
+            break;
+        }
+        // Else a free slot, or the one heard from longest ago
+        if (!slot || (slot->heard_ms && (!p->heard_ms || p->heard_ms < slot->heard_ms))) {
+            slot = p;
+        }
+    }
+
+    CryptPeer *p = slot;
+    if (p->heard_ms) {
+        mbedtls_ccm_free(&p->ccm);
+    }
+    memset(p, 0, offsetof(CryptPeer, ccm));
+    mbedtls_ccm_init(&p->ccm);
+    p->id = id;
+    p->heard_ms = now;
+
+    uint8_t key[LORA_CRYPT_KEY_LEN];
+    memcpy(key, crypt_key, sizeof(key));
+#ifdef INTEGRATION_LAYER_ENABLED
+    char name[12];
+    snprintf(name, sizeof(name), "%08lx", (unsigned long)id);
+    String hex = GET_CONFIG_STRING("lora_peers", name, String(""));
+    if (hex.length() && !hex_key(hex, key)) {
+        LOG_WARNF("LoRaCrypt", "Bad key for peer %s", name);
+        return p;
+    }
+#endif
+    p->has_key = mbedtls_ccm_setkey(&p->ccm, MBEDTLS_CIPHER_ID_AES, key, LORA_CRYPT_KEY_LEN * 8) == 0;
+    return p;
+}
+
+// Sliding window: true the first time a sequence number in range is seen
+static bool window_accept(CryptPeer *p, uint32_t seq) {
+    if (!p->seen || (int32_t)(seq - p->top) > 0) {
+        uint32_t shift = p->seen ? seq - p->top : LORA_CRYPT_WINDOW;
+        p->window = shift >= LORA_CRYPT_WINDOW ? 1 : (p->window << shift) | 1;
+        p->top = seq;
+        p->seen = true;
+        return true;
+    }
+    uint32_t back = p->top - seq;
+    if (back >= LORA_CRYPT_WINDOW || (p->window & (1ULL << back))) {
+        return false;
+    }
+    p->window |= 1ULL << back;
+    return true;
+}
+
+// ===== API =====
+
+bool lora_crypt_begin() {
+    if (crypt_on) {
+        return true;
+    }
+    uint64_t mac = ESP.getEfuseMac();
+    crypt_node = (uint32_t)(mac >> 16);     // The device-unique bytes and one more
+#ifdef INTEGRATION_LAYER_ENABLED
+    if (!GET_CONFIG(LORA_ENCRYPT)) {
+        return false;
+    }
+    crypt_require = GET_CONFIG(LORA_REQUIRE_ENCRYPTED);
+    if (!hex_key(GET_CONFIG_STRING("lora", "key", String("")), crypt_key)) {
+        LOG_ERROR("LoRaCrypt", "lora.encrypt needs lora.key, 32 hex digits; sending in the clear");
+        return false;
+    }
+#else
+    return false;
+#endif
+
+    Preferences prefs;
+    if (prefs.begin(LORA_CRYPT_NVS_NAMESPACE, true)) {
+        crypt_seq = prefs.getUInt("seq", 0);
+        prefs.end();
+    }
+    mbedtls_ccm_init(&crypt_tx);
+    if (!reserve_seq() || mbedtls_ccm_setkey(&crypt_tx, MBEDTLS_CIPHER_ID_AES, crypt_key, LORA_CRYPT_KEY_LEN * 8) != 0) {
+        LOG_ERROR("LoRaCrypt", "Cannot set up encryption; sending in the clear");
+        return false;
+    }
+    crypt_on = true;
+    LOG_INFOF("LoRaCrypt", "Encrypting as %08lx from sequence %lu%s", (unsigned long)crypt_node,
+              (unsigned long)crypt_seq, crypt_require ? ", plaintext dropped" : "");
+    return true;
+}
+
+bool lora_crypt_enabled() {
+    return crypt_on;
+}
+
+uint32_t lora_crypt_node_id() {
+    return crypt_node;
+}
+
+size_t lora_crypt_seal(uint8_t *buf, size_t len, size_t cap) {
+    if (len + LORA_CRYPT_OVERHEAD > cap) {
+        return 0;
+    }
+    // Out of reserved numbers: one NVS write per LORA_CRYPT_SEQ_RESERVE packets
+    if (crypt_seq == crypt_seq_limit && !reserve_seq()) {
+        return 0;
+    }
+    int64_t start = esp_timer_get_time();
+    uint32_t seq = crypt_seq++;
+    buf[0] = LORA_CRYPT_MAGIC;
+    put32(buf + 1, crypt_node);
+    put32(buf + 5, seq);
+    uint8_t nonce[CRYPT_NONCE_LEN];
+    nonce_of(nonce, crypt_node, seq);
+    uint8_t *body = buf + LORA_CRYPT_HEADER;
+    if (mbedtls_ccm_encrypt_and_tag(&crypt_tx, len, nonce, sizeof(nonce), buf, LORA_CRYPT_HEADER,
+                                    body, body, body + len, LORA_CRYPT_TAG) != 0) {
+        return 0;
+    }
+    note_time(&crypt_stats.seal_us_max, start);
+    CRYPT_COUNT(sealed);
+    return len + LORA_CRYPT_OVERHEAD;
+}
+
+bool lora_crypt_is_own(const uint8_t *buf, size_t len) {
+    return crypt_on && len >= LORA_CRYPT_OVERHEAD && buf[0] == LORA_CRYPT_MAGIC && get32(buf + 1) == crypt_node;
+}
+
+int lora_crypt_open(uint8_t *buf, size_t len) {
+    if (len < LORA_CRYPT_OVERHEAD || buf[0] != LORA_CRYPT_MAGIC) {
+        if (crypt_require) {
+            CRYPT_COUNT(plaintext_dropped);
+            return -1;
+        }
+        return len;
+    }
+    if (!crypt_on) {
+        CRYPT_COUNT(no_key);
+        return -1;
+    }
+
+    int64_t start = esp_timer_get_time();
+    uint32_t sender = get32(buf + 1);
+    uint32_t seq = get32(buf + 5);
+    if (sender == crypt_node) {
+        return -1;                  // Our own, repeated by someone
+    }
+    CryptPeer *peer = peer_find(sender);
+    if (!peer->has_key) {
+        CRYPT_COUNT(no_key);
+        return -1;
+    }
+
+    size_t body_len = len - LORA_CRYPT_OVERHEAD;
+    uint8_t *body = buf + LORA_CRYPT_HEADER;
+    uint8_t nonce[CRYPT_NONCE_LEN];
+    nonce_of(nonce, sender, seq);
+    if (mbedtls_ccm_auth_decrypt(&peer->ccm, body_len, nonce, sizeof(nonce), buf, LORA_CRYPT_HEADER,
+                                 body, body, body + body_len, LORA_CRYPT_TAG) != 0) {
+        CRYPT_COUNT(auth_failed);
+        return -1;
+    }
+    // Only authentic numbers move the window, so forgeries cannot block a sender
+    if (!window_accept(peer, seq)) {
+        CRYPT_COUNT(replayed);
+        return -1;
+    }
+    memmove(buf, body, body_len);
+    note_time(&crypt_stats.open_us_max, start);
+    CRYPT_COUNT(opened);
+    return body_len;
+}
+
+void lora_crypt_get_stats(LoraCryptStats *out) {
+    portENTER_CRITICAL(&crypt_mux);
+    *out = crypt_stats;
+    portEXIT_CRITICAL(&crypt_mux);
+}
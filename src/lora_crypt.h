@@ -0,0 +1,87 @@
+/**
+ * @file      lora_crypt.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     LoRa link encryption: AES-CCM per sender key, replay window
+ */
+
+#ifndef LORA_CRYPT_H
+#define LORA_CRYPT_H
+
+#include <Arduino.h>
+
+/**
+ * Every packet the radio sends is sealed in its TX pool slot and every
+ * sealed packet received is opened in its RX ring slot, before the link
+ * layers see it; nothing above peri_lora changes.
+ *
+ * Frame: magic, sender id (4), sequence number (4), ciphertext, 4-byte
+ * tag. The header is authenticated too. The nonce is the sender id and
+ * sequence number, so only those travel; sequence numbers are reserved in
+ * NVS ahead of use and never repeat under a key.
+ *
+ * Keys are per sender: a device seals with its own key (lora.key) and
+ * opens with the key configured for the sender (lora_peers.<id>, id as 8
+ * hex digits), else with its own key, which makes a shared network key
+ * the simple setup. Each sender has a sliding window of the last
+ * LORA_CRYPT_WINDOW sequence numbers; repeats and older ones are dropped,
+ * which also removes duplicates from TX retries.
+ *
+ * Config section "lora": encrypt (false), key (32 hex digits),
+ * require_encrypted (false: plaintext is still delivered).
+ */
+
+#define LORA_CRYPT_MAGIC            0xFE    // Never starts UTF-8 text
+#define LORA_CRYPT_HEADER           9       // Magic, sender, sequence
+#define LORA_CRYPT_TAG              4
+#define LORA_CRYPT_OVERHEAD         (LORA_CRYPT_HEADER + LORA_CRYPT_TAG)
+#define LORA_CRYPT_KEY_LEN          16
+#define LORA_CRYPT_PEERS            16      // Senders tracked; the least recently heard goes
+#define LORA_CRYPT_WINDOW           64
+#define LORA_CRYPT_SEQ_RESERVE      1024    // Sequence numbers per NVS write
+#define LORA_CRYPT_RETRY_MS         60000   // Before a sender without a key is looked up again
+#define LORA_CRYPT_NVS_NAMESPACE    "loracrypt"
+
+struct LoraCryptStats {
+    uint32_t sealed;
+    uint32_t opened;
+    uint32_t auth_failed;
+    uint32_t replayed;
+    uint32_t no_key;                // Sealed by a sender we have no key for
+    uint32_t plaintext_dropped;     // With require_encrypted
+    uint32_t seal_us_max;
+    uint32_t open_us_max;
+};
+
+/**
+ * @brief Load the key and reserve sequence numbers. From lora_init()
+ */
+bool lora_crypt_begin();
+bool lora_crypt_enabled();
+uint32_t lora_crypt_node_id();
+
+/**
+ * @brief Seal in place. The plaintext is at buf + LORA_CRYPT_HEADER;
+ *        header and tag are written around it
+ * @return Frame length, 0 if it does not fit in cap
+ */
+size_t lora_crypt_seal(uint8_t *buf, size_t len, size_t cap);
+
+/**
+ * @brief True for a frame this device already sealed, e.g. a queued packet
+ *        carried through deep sleep
+ */
+bool lora_crypt_is_own(const uint8_t *buf, size_t len);
+
+/**
+ * @brief Open in place; the plaintext ends up at buf[0]
+ * @return Plaintext length; len unchanged for plaintext that is let
+ *         through; -1 to drop the packet
+ */
+int lora_crypt_open(uint8_t *buf, size_t len);
+
+void lora_crypt_get_stats(LoraCryptStats *out);
+
+#endif // LORA_CRYPT_H
@@ -0,0 +1,280 @@
+/* Generated by script/lora_dict.py from script/lora_corpus.txt, do not edit */
+
+#ifndef LORA_DICT_H
+#define LORA_DICT_H
+
+#include <stdint.h>
+
+#define LORA_DICT_ENTRIES 192
+#define LORA_DICT_SYMBOLS 449
+#define LORA_DICT_EOF 448
+#define LORA_DICT_MAX_CODE 15
+#define LORA_DICT_SAMPLES 39
+
+// Entry n is lora_dict_text[lora_dict_offset[n] .. lora_dict_offset[n + 1])
+static constexpr uint8_t lora_dict_text[] = {
+    0x20, 0x61, 0x74, 0x20, 0x74, 0x68, 0x65, 0x20, 0x20, 0x69, 0x6e, 0x20, 0x74, 0x68, 0x65, 0x20,
+    0x20, 0x6c, 0x61, 0x74, 0x3d, 0x34, 0x37, 0x2e, 0x20, 0x6c, 0x6f, 0x6e, 0x3d, 0x2d, 0x31, 0x32,
+    0x20, 0x6f, 0x6e, 0x20, 0x74, 0x68, 0x65, 0x20, 0x20, 0x70, 0x72, 0x65, 0x73, 0x3d, 0x31, 0x30,
+    0x20, 0x70, 0x72, 0x65, 0x73, 0x3d, 0x39, 0x39, 0x20, 0x72, 0x73, 0x73, 0x69, 0x3d, 0x2d, 0x31,
+    0x20, 0x72, 0x73, 0x73, 0x69, 0x3d, 0x2d, 0x36, 0x20, 0x61, 0x74, 0x20, 0x74, 0x68, 0x65, 0x20,
+    0x69, 0x6e, 0x20, 0x74, 0x68, 0x65, 0x20, 0x6c, 0x61, 0x74, 0x3d, 0x34, 0x37, 0x20, 0x6c, 0x6f,
+    0x6e, 0x3d, 0x2d, 0x31, 0x20, 0x6f, 0x6e, 0x20, 0x74, 0x68, 0x65, 0x20, 0x70, 0x72, 0x65, 0x73,
+    0x3d, 0x31, 0x20, 0x70, 0x72, 0x65, 0x73, 0x3d, 0x39, 0x20, 0x72, 0x73, 0x73, 0x69, 0x3d, 0x2d,
+    0x20, 0x73, 0x6e, 0x72, 0x3d, 0x2d, 0x31, 0x20, 0x74, 0x65, 0x6d, 0x70, 0x3d, 0x31, 0x20, 0x74,
+    0x65, 0x6d, 0x70, 0x3d, 0x32, 0x20, 0x61, 0x74, 0x20, 0x74, 0x68, 0x20, 0x62, 0x61, 0x74, 0x3d,
+    0x35, 0x20, 0x6c, 0x61, 0x74, 0x3d, 0x34, 0x20, 0x6c, 0x6f, 0x6e, 0x3d, 0x2d, 0x20, 0x6f, 0x6e,
+    0x20, 0x74, 0x68, 0x20, 0x70, 0x72, 0x65, 0x73, 0x3d, 0x20, 0x72, 0x73, 0x73, 0x69, 0x3d, 0x20,
+    0x73, 0x61, 0x74, 0x73, 0x3d, 0x20, 0x73, 0x6e, 0x72, 0x3d, 0x2d, 0x20, 0x74, 0x65, 0x6d, 0x70,
+    0x3d, 0x20, 0x61, 0x6c, 0x74, 0x20, 0x20, 0x61, 0x6c, 0x74, 0x3d, 0x20, 0x61, 0x74, 0x20, 0x74,
+    0x20, 0x62, 0x61, 0x74, 0x3d, 0x20, 0x68, 0x64, 0x67, 0x20, 0x20, 0x68, 0x75, 0x6d, 0x3d, 0x20,
+    0x6c, 0x61, 0x74, 0x3d, 0x20, 0x6c, 0x6f, 0x6e, 0x3d, 0x20, 0x70, 0x72, 0x65, 0x73, 0x20, 0x72,
+    0x73, 0x73, 0x69, 0x20, 0x73, 0x61, 0x74, 0x73, 0x20, 0x73, 0x6e, 0x72, 0x3d, 0x20, 0x73, 0x70,
+    0x64, 0x20, 0x20, 0x74, 0x68, 0x65, 0x20, 0x20, 0x75, 0x70, 0x3d, 0x31, 0x20, 0x76, 0x3d, 0x33,
+    0x2e, 0x20, 0x79, 0x6f, 0x75, 0x20, 0x20, 0x34, 0x37, 0x2e, 0x20, 0x61, 0x6c, 0x74, 0x20, 0x61,
+    0x74, 0x20, 0x20, 0x62, 0x61, 0x74, 0x20, 0x68, 0x64, 0x67, 0x20, 0x68, 0x75, 0x6d, 0x20, 0x69,
+    0x73, 0x20, 0x20, 0x6c, 0x61, 0x74, 0x20, 0x6c, 0x6f, 0x6e, 0x20, 0x70, 0x72, 0x65, 0x20, 0x72,
+    0x73, 0x73, 0x20, 0x73, 0x61, 0x74, 0x20, 0x73, 0x6e, 0x72, 0x20, 0x73, 0x70, 0x64, 0x20, 0x74,
+    0x65, 0x6d, 0x20, 0x74, 0x68, 0x65, 0x20, 0x75, 0x70, 0x3d, 0x20, 0x79, 0x6f, 0x75, 0x20, 0x34,
+    0x37, 0x20, 0x61, 0x6c, 0x20, 0x61, 0x74, 0x20, 0x62, 0x61, 0x20, 0x68, 0x64, 0x20, 0x68, 0x75,
+    0x20, 0x69, 0x73, 0x20, 0x6c, 0x61, 0x20, 0x6c, 0x6f, 0x20, 0x70, 0x72, 0x20, 0x72, 0x73, 0x20,
+    0x73, 0x61, 0x20, 0x73, 0x6e, 0x20, 0x73, 0x70, 0x20, 0x74, 0x65, 0x20, 0x74, 0x68, 0x20, 0x75,
+    0x70, 0x20, 0x61, 0x20, 0x62, 0x20, 0x68, 0x20, 0x69, 0x20, 0x6c, 0x20, 0x72, 0x20, 0x73, 0x20,
+    0x74, 0x20, 0x75, 0x2c, 0x2d, 0x31, 0x32, 0x32, 0x2e, 0x32, 0x2c, 0x2d, 0x31, 0x32, 0x32, 0x2e,
+    0x2d, 0x31, 0x2e, 0x36, 0x20, 0x68, 0x75, 0x6d, 0x3d, 0x30, 0x20, 0x6c, 0x61, 0x74, 0x3d, 0x34,
+    0x37, 0x30, 0x20, 0x31, 0x20, 0x74, 0x65, 0x6d, 0x70, 0x3d, 0x31, 0x32, 0x32, 0x32, 0x2e, 0x33,
+    0x32, 0x2e, 0x32, 0x32, 0x32, 0x2e, 0x32, 0x2e, 0x32, 0x32, 0x34, 0x37, 0x35, 0x20, 0x37, 0x20,
+    0x72, 0x73, 0x73, 0x69, 0x3d, 0x2d, 0x37, 0x2e, 0x38, 0x20, 0x6c, 0x61, 0x74, 0x3d, 0x34, 0x37,
+    0x3d, 0x34, 0x61, 0x74, 0x20, 0x74, 0x68, 0x65, 0x20, 0x61, 0x6c, 0x74, 0x20, 0x61, 0x6c, 0x74,
+    0x3d, 0x61, 0x74, 0x20, 0x61, 0x6c, 0x61, 0x74, 0x62, 0x61, 0x74, 0x3d, 0x31, 0x62, 0x61, 0x74,
+    0x3d, 0x35, 0x62, 0x61, 0x74, 0x3d, 0x62, 0x61, 0x74, 0x62, 0x61, 0x64, 0x20, 0x65, 0x20, 0x65,
+    0x6d, 0x65, 0x72, 0x67, 0x20, 0x68, 0x75, 0x6d, 0x3d, 0x68, 0x65, 0x69, 0x6e, 0x20, 0x74, 0x68,
+    0x65, 0x20, 0x69, 0x6e, 0x67, 0x20, 0x69, 0x6e, 0x67, 0x69, 0x73, 0x20, 0x69, 0x6e, 0x69, 0x73,
+    0x6b, 0x6d, 0x2f, 0x68, 0x20, 0x68, 0x64, 0x67, 0x6b, 0x6d, 0x2f, 0x68, 0x20, 0x6c, 0x61, 0x74,
+    0x3d, 0x34, 0x37, 0x2e, 0x35, 0x6c, 0x6f, 0x6e, 0x3d, 0x2d, 0x31, 0x32, 0x32, 0x6c, 0x61, 0x74,
+    0x6c, 0x6f, 0x6e, 0x6c, 0x61, 0x6c, 0x6f, 0x6d, 0x20, 0x73, 0x70, 0x64, 0x20, 0x31, 0x6d, 0x20,
+    0x73, 0x70, 0x64, 0x20, 0x6d, 0x70, 0x6e, 0x20, 0x74, 0x68, 0x65, 0x20, 0x6e, 0x6f, 0x64, 0x65,
+    0x3d, 0x31, 0x6e, 0x6f, 0x64, 0x65, 0x3d, 0x6e, 0x6f, 0x64, 0x65, 0x6e, 0x67, 0x20, 0x6e, 0x67,
+    0x6e, 0x6f, 0x6f, 0x6e, 0x20, 0x74, 0x68, 0x65, 0x20, 0x6f, 0x64, 0x65, 0x6f, 0x6e, 0x6f, 0x75,
+    0x70, 0x6f, 0x73, 0x20, 0x34, 0x37, 0x2e, 0x35, 0x70, 0x6f, 0x73, 0x20, 0x34, 0x37, 0x2e, 0x37,
+    0x70, 0x72, 0x65, 0x73, 0x3d, 0x31, 0x30, 0x32, 0x70, 0x6f, 0x73, 0x20, 0x34, 0x37, 0x2e, 0x70,
+    0x72, 0x65, 0x73, 0x3d, 0x31, 0x30, 0x70, 0x72, 0x65, 0x73, 0x3d, 0x39, 0x39, 0x70, 0x6f, 0x73,
+    0x72, 0x73, 0x73, 0x69, 0x3d, 0x2d, 0x31, 0x72, 0x73, 0x73, 0x69, 0x3d, 0x2d, 0x72, 0x73, 0x73,
+    0x69, 0x72, 0x65, 0x73, 0x6e, 0x72, 0x3d, 0x2d, 0x31, 0x73, 0x61, 0x74, 0x73, 0x3d, 0x73, 0x6e,
+    0x72, 0x3d, 0x2d, 0x73, 0x6f, 0x69, 0x6c, 0x3d, 0x73, 0x6e, 0x72, 0x3d, 0x73, 0x73, 0x69, 0x73,
+    0x20, 0x73, 0x69, 0x74, 0x20, 0x74, 0x68, 0x65, 0x20, 0x74, 0x65, 0x6d, 0x70, 0x3d, 0x31, 0x74,
+    0x65, 0x6d, 0x70, 0x3d, 0x32, 0x74, 0x3d, 0x31, 0x37, 0x33, 0x74, 0x65, 0x6d, 0x70, 0x3d, 0x74,
+    0x20, 0x74, 0x68, 0x74, 0x65, 0x6d, 0x70, 0x74, 0x68, 0x65, 0x20, 0x74, 0x20, 0x74, 0x74, 0x68,
+    0x65, 0x74, 0x20, 0x74, 0x65, 0x74, 0x68, 0x75, 0x70, 0x3d, 0x76, 0x3d, 0x33, 0x2e, 0x79, 0x6f,
+    0x75, 0x20, 0x79, 0x6f, 0x75,
+};
+
+static constexpr uint16_t lora_dict_offset[LORA_DICT_ENTRIES + 1] = {
+    0, 8, 16, 24, 32, 40, 48, 56, 64, 72, 79, 86,
+    93, 100, 107, 114, 121, 128, 135, 142, 149, 155, 161, 167,
+    173, 179, 185, 191, 197, 203, 209, 214, 219, 224, 229, 234,
+    239, 244, 249, 254, 259, 264, 269, 274, 279, 284, 289, 294,
+    298, 302, 306, 310, 314, 318, 322, 326, 330, 334, 338, 342,
+    346, 350, 354, 358, 362, 366, 369, 372, 375, 378, 381, 384,
+    387, 390, 393, 396, 399, 402, 405, 408, 411, 414, 417, 419,
+    421, 423, 425, 427, 429, 431, 433, 435, 442, 448, 450, 457,
+    465, 467, 474, 476, 480, 483, 486, 488, 490, 492, 494, 502,
+    504, 512, 514, 521, 525, 529, 532, 534, 536, 541, 546, 550,
+    553, 555, 557, 559, 561, 563, 565, 569, 571, 578, 582, 585,
+    588, 590, 592, 600, 605, 613, 621, 624, 627, 629, 631, 638,
+    644, 646, 652, 658, 663, 667, 670, 672, 674, 681, 684, 686,
+    688, 696, 704, 712, 719, 726, 733, 736, 743, 749, 753, 755,
+    761, 766, 771, 776, 780, 783, 785, 787, 793, 799, 805, 810,
+    815, 819, 823, 827, 830, 833, 835, 837, 839, 842, 846, 850,
+    853,
+};
+
+// Entries starting with byte b: [lora_dict_first[b], lora_dict_first[b + 1]), longest first
+static constexpr uint16_t lora_dict_first[257] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 91, 91, 91,
+    91, 91, 91, 91, 91, 91, 91, 91, 91, 93, 94, 95,
+    95, 97, 99, 104, 104, 105, 106, 106, 108, 109, 109, 109,
+    109, 109, 110, 110, 110, 110, 110, 110, 110, 110, 110, 110,
+    110, 110, 110, 110, 110, 110, 110, 110, 110, 110, 110, 110,
+    110, 110, 110, 110, 110, 110, 110, 110, 110, 110, 110, 110,
+    110, 110, 116, 121, 121, 122, 125, 125, 126, 128, 134, 134,
+    136, 142, 145, 152, 156, 163, 163, 167, 175, 188, 189, 190,
+    190, 190, 192, 192, 192, 192, 192, 192, 192, 192, 192, 192,
+    192, 192, 192, 192, 192, 192, 192, 192, 192, 192, 192, 192,
+    192, 192, 192, 192, 192, 192, 192, 192, 192, 192, 192, 192,
+    192, 192, 192, 192, 192, 192, 192, 192, 192, 192, 192, 192,
+    192, 192, 192, 192, 192, 192, 192, 192, 192, 192, 192, 192,
+    192, 192, 192, 192, 192, 192, 192, 192, 192, 192, 192, 192,
+    192, 192, 192, 192, 192, 192, 192, 192, 192, 192, 192, 192,
+    192, 192, 192, 192, 192, 192, 192, 192, 192, 192, 192, 192,
+    192, 192, 192, 192, 192, 192, 192, 192, 192, 192, 192, 192,
+    192, 192, 192, 192, 192, 192, 192, 192, 192, 192, 192, 192,
+    192, 192, 192, 192, 192, 192, 192, 192, 192, 192, 192, 192,
+    192, 192, 192, 192, 192,
+};
+
+// Symbol s: byte s below 256, else entry s - 256, and LORA_DICT_EOF
+static constexpr uint16_t lora_code_bits[LORA_DICT_SYMBOLS] = {
+    3850, 3851, 3852, 3853, 3854, 3855, 3856, 3857, 3858, 3859, 3860, 3861,
+    3862, 3863, 3864, 3865, 3866, 3867, 3868, 3869, 3870, 3871, 3872, 3873,
+    3874, 3875, 3876, 3877, 3878, 3879, 3880, 3881, 22, 886, 3882, 3883,
+    3884, 1876, 3885, 887, 3886, 3887, 3888, 3889, 74, 888, 23, 3890,
+    24, 2, 25, 3, 4, 26, 5, 6, 7, 8, 406, 3891,
+    3892, 3893, 3894, 407, 3895, 1877, 1878, 3896, 3897, 3898, 3899, 3900,
+    3901, 889, 3902, 3903, 3904, 3905, 3906, 3907, 3908, 3909, 3910, 3911,
+    3912, 3913, 3914, 3915, 3916, 3917, 3918, 3919, 3920, 3921, 3922, 3923,
+    3924, 27, 178, 28, 75, 9, 76, 77, 179, 29, 890, 78,
+    30, 31, 32, 10, 79, 1879, 33, 34, 35, 80, 180, 36,
+    891, 81, 1880, 3925, 3926, 3927, 3928, 3929, 3930, 3931, 3932, 3933,
+    3934, 3935, 3936, 3937, 3938, 3939, 3940, 3941, 3942, 3943, 3944, 3945,
+    3946, 3947, 3948, 3949, 3950, 3951, 3952, 3953, 3954, 3955, 3956, 3957,
+    3958, 3959, 3960, 3961, 3962, 3963, 3964, 3965, 3966, 3967, 3968, 3969,
+    3970, 3971, 3972, 3973, 3974, 3975, 3976, 3977, 3978, 3979, 3980, 3981,
+    3982, 3983, 3984, 3985, 3986, 3987, 3988, 3989, 3990, 3991, 3992, 3993,
+    3994, 3995, 3996, 3997, 3998, 3999, 4000, 4001, 4002, 4003, 4004, 4005,
+    4006, 4007, 4008, 4009, 4010, 4011, 4012, 4013, 4014, 4015, 4016, 4017,
+    4018, 4019, 4020, 4021, 4022, 4023, 4024, 4025, 4026, 4027, 4028, 4029,
+    4030, 4031, 4032, 4033, 4034, 4035, 4036, 4037, 4038, 4039, 4040, 4041,
+    4042, 4043, 4044, 4045, 4046, 4047, 4048, 4049, 4050, 4051, 4052, 4053,
+    4054, 4055, 4056, 4057, 892, 893, 181, 182, 894, 408, 895, 896,
+    897, 4058, 4059, 4060, 4061, 4062, 4063, 4064, 898, 409, 1881, 183,
+    4065, 899, 4066, 4067, 4068, 4069, 4070, 410, 411, 900, 184, 412,
+    4071, 185, 4072, 413, 4073, 4074, 4075, 1882, 4076, 901, 4077, 414,
+    415, 416, 417, 4078, 4079, 902, 1883, 4080, 4081, 186, 1884, 4082,
+    4083, 4084, 4085, 1885, 4086, 4087, 1886, 418, 903, 4088, 904, 4089,
+    1887, 4090, 4091, 4092, 1888, 905, 1889, 4093, 1890, 4094, 4095, 1891,
+    906, 1892, 419, 1893, 907, 908, 1894, 909, 420, 1895, 1896, 910,
+    421, 1897, 911, 422, 82, 912, 423, 1898, 424, 1899, 187, 913,
+    425, 83, 914, 915, 916, 917, 426, 918, 919, 427, 188, 189,
+    920, 428, 190, 921, 429, 84, 85, 1900, 191, 922, 923, 192,
+    1901, 86, 430, 193, 194, 924, 195, 1902, 1903, 925, 926, 1904,
+    927, 431, 928, 432, 929, 1905, 433, 434, 1906, 1907, 930, 196,
+    931, 1908, 197, 198, 435, 436, 1909, 437, 1910, 1911, 1912, 1913,
+    1914, 1915, 87, 1916, 932, 1917, 199, 1918, 1919, 438, 933, 1920,
+    439, 440, 200, 441, 1921, 1922, 201, 1923, 1924, 88, 202, 442,
+    934, 935, 936, 937, 0,
+};
+
+static constexpr uint8_t lora_code_len[LORA_DICT_SYMBOLS] = {
+    12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,
+    12, 12, 12, 12, 12, 12, 12, 12, 6, 10, 12, 12, 12, 11, 12, 10, 12, 12, 12, 12, 7, 10, 6, 12,
+    6, 5, 6, 5, 5, 6, 5, 5, 5, 5, 9, 12, 12, 12, 12, 9, 12, 11, 11, 12, 12, 12, 12, 12,
+    12, 10, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,
+    12, 6, 8, 6, 7, 5, 7, 7, 8, 6, 10, 7, 6, 6, 6, 5, 7, 11, 6, 6, 6, 7, 8, 6,
+    10, 7, 11, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,
+    12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,
+    12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,
+    12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,
+    12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,
+    12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 10, 10, 8, 8, 10, 9, 10, 10,
+    10, 12, 12, 12, 12, 12, 12, 12, 10, 9, 11, 8, 12, 10, 12, 12, 12, 12, 12, 9, 9, 10, 8, 9,
+    12, 8, 12, 9, 12, 12, 12, 11, 12, 10, 12, 9, 9, 9, 9, 12, 12, 10, 11, 12, 12, 8, 11, 12,
+    12, 12, 12, 11, 12, 12, 11, 9, 10, 12, 10, 12, 11, 12, 12, 12, 11, 10, 11, 12, 11, 12, 12, 11,
+    10, 11, 9, 11, 10, 10, 11, 10, 9, 11, 11, 10, 9, 11, 10, 9, 7, 10, 9, 11, 9, 11, 8, 10,
+    9, 7, 10, 10, 10, 10, 9, 10, 10, 9, 8, 8, 10, 9, 8, 10, 9, 7, 7, 11, 8, 10, 10, 8,
+    11, 7, 9, 8, 8, 10, 8, 11, 11, 10, 10, 11, 10, 9, 10, 9, 10, 11, 9, 9, 11, 11, 10, 8,
+    10, 11, 8, 8, 9, 9, 11, 9, 11, 11, 11, 11, 11, 11, 7, 11, 10, 11, 8, 11, 11, 9, 10, 11,
+    9, 9, 8, 9, 11, 11, 8, 11, 11, 7, 8, 9, 10, 10, 10, 10, 4,
+};
+
+// Canonical decode: codes of length l are lora_code_base[l] onwards,
+// lora_code_count[l] of them, symbols from lora_code_symbols[lora_code_start[l]]
+static constexpr uint16_t lora_code_base[LORA_DICT_MAX_CODE + 1] = {
+    0, 0, 0, 0, 0, 2, 22, 74, 178, 406, 886, 1876, 3850, 8192, 16384, 32768,
+};
+
+static constexpr uint16_t lora_code_count[LORA_DICT_MAX_CODE + 1] = {
+    0, 0, 0, 0, 1, 9, 15, 15, 25, 37, 52, 49, 246, 0, 0, 0,
+};
+
+static constexpr uint16_t lora_code_start[LORA_DICT_MAX_CODE + 1] = {
+    0, 0, 0, 0, 0, 1, 10, 25, 40, 65, 102, 154, 203, 449, 449, 449,
+};
+
+static constexpr uint16_t lora_code_symbols[LORA_DICT_SYMBOLS] = {
+    448, 49, 51, 52, 54, 55, 56, 57, 101, 111, 32, 46,
+    48, 50, 53, 97, 99, 105, 108, 109, 110, 114, 115, 116,
+    119, 44, 100, 102, 103, 107, 112, 117, 121, 352, 361, 377,
+    378, 385, 422, 441, 98, 104, 118, 258, 259, 275, 286, 289,
+    309, 358, 370, 371, 374, 380, 383, 387, 388, 390, 407, 410,
+    411, 426, 434, 438, 442, 58, 63, 261, 273, 283, 284, 287,
+    291, 299, 300, 301, 302, 319, 338, 344, 348, 351, 354, 356,
+    360, 366, 369, 373, 376, 386, 397, 399, 402, 403, 412, 413,
+    415, 429, 432, 433, 435, 443, 33, 39, 45, 73, 106, 120,
+    256, 257, 260, 262, 263, 264, 272, 277, 285, 297, 305, 320,
+    322, 329, 336, 340, 341, 343, 347, 350, 353, 359, 362, 363,
+    364, 365, 367, 368, 372, 375, 381, 382, 389, 393, 394, 396,
+    398, 400, 406, 408, 424, 430, 444, 445, 446, 447, 37, 65,
+    66, 113, 122, 274, 295, 306, 310, 315, 318, 324, 328, 330,
+    332, 335, 337, 339, 342, 345, 346, 349, 355, 357, 379, 384,
+    391, 392, 395, 401, 404, 405, 409, 414, 416, 417, 418, 419,
+    420, 421, 423, 425, 427, 428, 431, 436, 437, 439, 440, 0,
+    1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12,
+    13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24,
+    25, 26, 27, 28, 29, 30, 31, 34, 35, 36, 38, 40,
+    41, 42, 43, 47, 59, 60, 61, 62, 64, 67, 68, 69,
+    70, 71, 72, 74, 75, 76, 77, 78, 79, 80, 81, 82,
+    83, 84, 85, 86, 87, 88, 89, 90, 91, 92, 93, 94,
+    95, 96, 123, 124, 125, 126, 127, 128, 129, 130, 131, 132,
+    133, 134, 135, 136, 137, 138, 139, 140, 141, 142, 143, 144,
+    145, 146, 147, 148, 149, 150, 151, 152, 153, 154, 155, 156,
+    157, 158, 159, 160, 161, 162, 163, 164, 165, 166, 167, 168,
+    169, 170, 171, 172, 173, 174, 175, 176, 177, 178, 179, 180,
+    181, 182, 183, 184, 185, 186, 187, 188, 189, 190, 191, 192,
+    193, 194, 195, 196, 197, 198, 199, 200, 201, 202, 203, 204,
+    205, 206, 207, 208, 209, 210, 211, 212, 213, 214, 215, 216,
+    217, 218, 219, 220, 221, 222, 223, 224, 225, 226, 227, 228,
+    229, 230, 231, 232, 233, 234, 235, 236, 237, 238, 239, 240,
+    241, 242, 243, 244, 245, 246, 247, 248, 249, 250, 251, 252,
+    253, 254, 255, 265, 266, 267, 268, 269, 270, 271, 276, 278,
+    279, 280, 281, 282, 288, 290, 292, 293, 294, 296, 298, 303,
+    304, 307, 308, 311, 312, 313, 314, 316, 317, 321, 323, 325,
+    326, 327, 331, 333, 334,
+};
+
+// Held out of training, for the benchmarks
+static constexpr const char *lora_dict_samples[LORA_DICT_SAMPLES] = {
+    "t=1737810272 bat=79 temp=10.9 lat=47.6510 lon=-122.1509",
+    "bat=73 v=3.74 lat=47.64760 lon=-122.33143 alt=321 sats=10",
+    "temp=33.5 hum=29 pres=1020.6",
+    "pos 47.79724,-122.20123 alt 291m spd 24km/h hdg 342",
+    "node=13 rssi=-96 snr=-11.2 up=92448",
+    "t=1737436719 bat=55 temp=-0.9 lat=47.7191 lon=-122.3730",
+    "node=4 rssi=-63 snr=9.8 up=244372",
+    "bat=51 v=4.13 lat=47.67848 lon=-122.42555 alt=364 sats=6",
+    "node=12 rssi=-68 snr=5.2 up=379187",
+    "temp=26.6 hum=62 pres=993.5",
+    "pos 47.45239,-122.52430 alt 743m spd 6km/h hdg 269",
+    "t=1737482121 bat=69 temp=0.2 lat=47.6333 lon=-122.1683",
+    "bat=17 v=3.81 lat=47.49940 lon=-122.41923 alt=575 sats=3",
+    "soil=33 temp=9.5 bat=95",
+    "t=1737504966 bat=70 temp=11.2 lat=47.7330 lon=-122.4654",
+    "bat=28 v=3.62 lat=47.50623 lon=-122.51416 alt=132 sats=9",
+    "bat=38 v=4.09 lat=47.64327 lon=-122.44104 alt=464 sats=3",
+    "temp=34.8 hum=24 pres=990.6",
+    "temp=20.4 hum=71 pres=1029.6",
+    "soil=26 temp=29.2 bat=80",
+    "bat=15 v=3.87 lat=47.51986 lon=-122.27813 alt=541 sats=5",
+    "temp=17.7 hum=22 pres=1023.1",
+    "soil=37 temp=26.9 bat=21",
+    "bat=88 v=3.99 lat=47.63988 lon=-122.39729 alt=311 sats=12",
+    "soil=57 temp=15.2 bat=67",
+    "soil=36 temp=20.4 bat=61",
+    "pos 47.43056,-122.15983 alt 773m spd 17km/h hdg 24",
+    "bat=83 v=4.00 lat=47.77339 lon=-122.36565 alt=659 sats=7",
+    "temp=17.0 hum=77 pres=1026.3",
+    "node=9 rssi=-79 snr=-11.9 up=263984",
+    "bat=72 v=4.08 lat=47.55661 lon=-122.15927 alt=459 sats=6",
+    "node=4 rssi=-113 snr=-13.2 up=275015",
+    "node=14 rssi=-115 snr=-8.6 up=349946",
+    "node=6 rssi=-97 snr=-2.9 up=477369",
+    "temp=32.4 hum=79 pres=991.3",
+    "t=1738528344 bat=62 temp=2.7 lat=47.5894 lon=-122.3809",
+    "bat=45 v=4.14 lat=47.50487 lon=-122.24335 alt=304 sats=3",
+    "fishing is good today",
+    "sorry, missed your message",
+};
+
+#endif /* LORA_DICT_H */
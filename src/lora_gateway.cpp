@@ -0,0 +1,579 @@
+/**
+ * @file      lora_gateway.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     LoRa to MQTT gateway: batched uplink of heard packets, airtime-scheduled downlink
+ */
+
+#include "lora_gateway.h"
+#include "lora_mesh.h"
+#include "lora_codec.h"
+#include "mqtt_client.h"
+#include "peripheral.h"
+#include "placement.h"
+#include "time_service.h"
+#include "timer_wheel.h"
+#include "usb_console.h"
+#include "simple_logger.h"
+#include "config/os_config.h"
+#ifdef INTEGRATION_LAYER_ENABLED
+#include "integration/config_manager.h"
+#endif
+
+#define GW_REC_HEAD_MAX         9       // dt_ms varint of up to five bytes, rssi, snr, flags, len
+#define GW_BENCH_SETTLE_MS      200     // For the LoRa task to take the last injected frames
+
+struct GwDownFrame {
+    uint32_t time_ms;               // Queued
+    uint8_t len;
+    uint8_t data[LORA_PACKET_MAX];
+};
+
+// A batch taken from the filling side, on its way to the MQTT client
+struct GwSealed {
+    MqttBuffer *buf;
+    size_t len;
+    int32_t bench_lo;               // Benchmark frames in it, -1 for none
+    int32_t bench_hi;
+};
+
+struct GwBench {
+    volatile bool on;
+    uint32_t base_id;
+    uint32_t count;
+    uint32_t *rx_ms;                // Receive stamp by frame, 0 once handed over
+    uint32_t *latency;              // UINT32_MAX until handed over
+    volatile uint32_t forwarded;
+    volatile uint32_t last_ms;
+};
+
+static portMUX_TYPE gw_mux = portMUX_INITIALIZER_UNLOCKED;
+static volatile bool gw_running = false;
+static bool gw_ready = false;
+static bool gw_hooked = false;
+static bool gw_subscribed = false;
+static LoraGatewayStats gw_stats;
+static char gw_topic_up[MQTT_TOPIC_MAX];
+static char gw_topic_down[MQTT_TOPIC_MAX];
+static uint32_t gw_interval_ms = LORA_GW_INTERVAL_MS;
+static size_t gw_batch_bytes = 0;
+static uint8_t gw_qos = 1;
+static bool gw_downlink = true;
+static uint8_t gw_reserve_pct = LORA_GW_RESERVE_PCT;
+
+// The open batch: only the LoRa task opens one, it or the timer seals it
+static MqttBuffer *gw_buf = NULL;
+static uint8_t *gw_payload = NULL;
+static size_t gw_fill = 0;
+static size_t gw_limit = 0;
+static uint32_t gw_opened_ms = 0;   // millis() of t0
+static int32_t gw_bench_lo = -1;
+static int32_t gw_bench_hi = -1;
+static uint16_t gw_seq = 0;
+static WheelTimer gw_timer;
+
+// Downlink frames, oldest at gw_down_tail
+static PLACE_BULK GwDownFrame gw_down[LORA_GW_DOWN_SLOTS];
+static uint8_t gw_down_tail = 0;
+static uint8_t gw_down_count = 0;
+static WheelTimer gw_down_timer;
+
+static GwBench gw_bench;
+
+// ===== Uplink =====
+
+static inline void put16(uint8_t *p, uint16_t v) {
+    memcpy(p, &v, 2);
+}
+
+static inline void put32(uint8_t *p, uint32_t v) {
+    memcpy(p, &v, 4);
+}
+
+static size_t put_varint(uint8_t *p, uint32_t v) {
+    size_t n = 0;
+    while (v >= 0x80) {
+        p[n++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    p[n++] = (uint8_t)v;
+    return n;
+}
+
+// Under gw_mux
+static GwSealed take_batch() {
+    GwSealed s = {gw_buf, gw_fill, gw_bench_lo, gw_bench_hi};
+    gw_buf = NULL;
+    gw_payload = NULL;
+    gw_fill = 0;
+    return s;
+}
+
+// Under gw_mux
+static void bench_done(int32_t lo, int32_t hi) {
+    uint32_t now = millis();
+    uint32_t n = 0;
+    for (int32_t i = lo; i <= hi; i++) {
+        if (gw_bench.rx_ms[i]) {
+            gw_bench.latency[i] = now - gw_bench.rx_ms[i];
+            gw_bench.rx_ms[i] = 0;
+            n++;
+        }
+    }
+    gw_bench.forwarded += n;
+    gw_bench.last_ms = now;
+}
+
+static void send_batch(const GwSealed &s) {
+    if (!s.buf) {
+        return;
+    }
+    bool ok = mqtt_publish_buffer(s.buf, s.len);
+    portENTER_CRITICAL(&gw_mux);
+    if (ok) {
+        gw_stats.batches++;
+        gw_stats.sent_bytes += s.len;
+        // The benchmark's arrays go away with gw_bench.on, both under the lock
+        if (s.bench_lo >= 0 && gw_bench.on) {
+            bench_done(s.bench_lo, s.bench_hi);
+        }
+    } else {
+        gw_stats.batch_failed++;
+    }
+    portEXIT_CRITICAL(&gw_mux);
+}
+
+// LoRa task: a pool buffer with the batch header, t0 at the first frame
+static bool open_batch(uint32_t time_ms) {
+    MqttBuffer *buf = mqtt_buffer_acquire(gw_topic_up, gw_qos);
+    size_t capacity = 0;
+    uint8_t *p = mqtt_buffer_payload(buf, &capacity);
+    if (!p) {
+        return false;
+    }
+    int64_t t0_ms = time_from_millis(time_ms) / 1000;
+    p[0] = LORA_GW_VERSION;
+    p[1] = time_valid() ? LORA_GW_BATCH_UTC : 0;
+    put16(p + 2, gw_seq++);
+    put32(p + 4, lora_mesh_node_id());
+    memcpy(p + 8, &t0_ms, 8);
+
+    portENTER_CRITICAL(&gw_mux);
+    gw_buf = buf;
+    gw_payload = p;
+    gw_fill = LORA_GW_BATCH_HEADER;
+    gw_limit = gw_batch_bytes && gw_batch_bytes < capacity ? gw_batch_bytes : capacity;
+    gw_opened_ms = time_ms;
+    gw_bench_lo = -1;
+    gw_bench_hi = -1;
+    portEXIT_CRITICAL(&gw_mux);
+    timer_wheel_arm(&gw_timer, gw_interval_ms);
+    return true;
+}
+
+static int32_t bench_index(const lora_packet_t *pkt) {
+    if (!gw_bench.on || pkt->len < LORA_MESH_HEADER_SIZE) {
+        return -1;
+    }
+    uint32_t from, id;
+    memcpy(&from, pkt->data + 4, 4);
+    memcpy(&id, pkt->data + 8, 4);
+    uint32_t i = id - gw_bench.base_id;
+    return from == LORA_GW_BENCH_NODE && i < gw_bench.count ? (int32_t)i : -1;
+}
+
+// LoRa task
+static void forward(const lora_packet_t *pkt, uint8_t flags) {
+    if (!gw_running) {
+        return;
+    }
+    uint8_t packed[LORA_PACKET_MAX];
+    const uint8_t *data = packed;
+    size_t len = lora_codec_encode(pkt->data, pkt->len, packed, sizeof(packed));
+    if (len) {
+        flags |= LORA_GW_REC_PACKED;
+    } else {
+        data = pkt->data;
+        len = pkt->len;
+    }
+    int32_t bench = bench_index(pkt);
+
+    // Full under batch_bytes: that one goes, this frame opens the next
+    GwSealed full = {};
+    portENTER_CRITICAL(&gw_mux);
+    if (gw_buf && gw_fill > LORA_GW_BATCH_HEADER && gw_fill + GW_REC_HEAD_MAX + len > gw_limit) {
+        full = take_batch();
+    }
+    bool open = gw_buf != NULL;
+    portEXIT_CRITICAL(&gw_mux);
+    send_batch(full);
+    if (!open && !open_batch(pkt->time_ms)) {
+        portENTER_CRITICAL(&gw_mux);
+        gw_stats.no_buffer++;
+        portEXIT_CRITICAL(&gw_mux);
+        return;
+    }
+
+    portENTER_CRITICAL(&gw_mux);
+    if (!gw_buf) {
+        gw_stats.no_buffer++;
+        portEXIT_CRITICAL(&gw_mux);
+        return;
+    }
+    int32_t dt = (int32_t)(pkt->time_ms - gw_opened_ms);
+    uint8_t *o = gw_payload + gw_fill;
+    o += put_varint(o, dt > 0 ? dt : 0);
+    *o++ = (uint8_t)(int8_t)constrain(lroundf(pkt->rssi), -128, 127);
+    *o++ = (uint8_t)(int8_t)constrain(lroundf(pkt->snr * 4), -128, 127);
+    *o++ = flags;
+    *o++ = (uint8_t)len;
+    memcpy(o, data, len);
+    gw_fill = o + len - gw_payload;
+    if (bench >= 0 && gw_bench.on) {
+        gw_bench.rx_ms[bench] = pkt->time_ms | 1;
+        if (gw_bench_lo < 0) {
+            gw_bench_lo = bench;
+        }
+        gw_bench_hi = bench;
+    }
+    gw_stats.uplinked++;
+    gw_stats.raw_bytes += pkt->len;
+    portEXIT_CRITICAL(&gw_mux);
+}
+
+static void mesh_tap(const lora_packet_t *pkt) {
+    if (pkt->data[12] & LORA_MESH_FLAG_VIA_MQTT) {
+        gw_stats.via_mqtt++;
+        return;
+    }
+    forward(pkt, LORA_GW_REC_MESH);
+}
+
+// Everything else that is heard; it stays in the RX queue for the UI
+static bool rx_hook(const lora_packet_t *pkt) {
+    bool mesh = pkt->len >= LORA_MESH_HEADER_SIZE && pkt->data[13] == LORA_MESH_CHANNEL_HASH;
+    if (!mesh || !lora_mesh_node_id()) {
+        forward(pkt, 0);
+    }
+    return false;
+}
+
+// A quiet channel still gets its frames upstream within the interval
+static void flush_tick(WheelTimer *timer) {
+    GwSealed s = {};
+    int32_t left = 0;
+    portENTER_CRITICAL(&gw_mux);
+    if (gw_buf) {
+        left = (int32_t)(gw_interval_ms - (millis() - gw_opened_ms));
+        if (left <= 0) {
+            s = take_batch();
+        }
+    }
+    portEXIT_CRITICAL(&gw_mux);
+    send_batch(s);
+    if (left > 0) {
+        timer_wheel_arm(&gw_timer, left);
+    }
+}
+
+// ===== Downlink =====
+
+// MQTT task
+static void on_downlink(const char *topic, const uint8_t *payload, size_t len, void *ctx) {
+    if (!gw_running) {
+        return;
+    }
+    uint32_t now = millis();
+    bool queued = false;
+    size_t off = 0;
+    while (off < len) {
+        uint8_t n = payload[off++];
+        if (!n || off + n > len) {
+            portENTER_CRITICAL(&gw_mux);
+            gw_stats.down_malformed++;
+            portEXIT_CRITICAL(&gw_mux);
+            break;
+        }
+        portENTER_CRITICAL(&gw_mux);
+        if (gw_down_count < LORA_GW_DOWN_SLOTS) {
+            GwDownFrame *f = &gw_down[(gw_down_tail + gw_down_count) % LORA_GW_DOWN_SLOTS];
+            f->time_ms = now;
+            f->len = n;
+            memcpy(f->data, payload + off, n);
+            if (n >= LORA_MESH_HEADER_SIZE && f->data[13] == LORA_MESH_CHANNEL_HASH) {
+                f->data[12] |= LORA_MESH_FLAG_VIA_MQTT;
+            }
+            gw_down_count++;
+            gw_stats.down_received++;
+            queued = true;
+        } else {
+            gw_stats.down_full++;
+        }
+        portEXIT_CRITICAL(&gw_mux);
+        off += n;
+    }
+    if (queued) {
+        timer_wheel_arm(&gw_down_timer, 1);
+    }
+}
+
+static void down_pop() {
+    portENTER_CRITICAL(&gw_mux);
+    gw_down_tail = (gw_down_tail + 1) % LORA_GW_DOWN_SLOTS;
+    gw_down_count--;
+    portEXIT_CRITICAL(&gw_mux);
+}
+
+// Oldest first, each only once the TX queue and the airtime budget have room
+static void down_tick(WheelTimer *timer) {
+    lora_counters_t counters;
+    lora_get_counters(&counters);
+    uint32_t reserve_ms = (uint32_t)((uint64_t)counters.airtime_budget_us * gw_reserve_pct / 100 / 1000);
+    bool held = false;
+    GwDownFrame f;
+    while (true) {
+        portENTER_CRITICAL(&gw_mux);
+        bool any = gw_down_count > 0;
+        if (any) {
+            f = gw_down[gw_down_tail];
+        }
+        portEXIT_CRITICAL(&gw_mux);
+        if (!any) {
+            break;
+        }
+        if (millis() - f.time_ms >= LORA_GW_DOWN_TTL_MS) {
+            down_pop();
+            gw_stats.down_expired++;
+            continue;
+        }
+        if (lora_tx_pending() >= LORA_GW_DOWN_TX_DEPTH) {
+            held = true;
+            break;
+        }
+        if (lora_tx_airtime_left_ms() < lora_time_on_air_us(f.len) / 1000 + 1 + reserve_ms) {
+            gw_stats.airtime_waits++;
+            held = true;
+            break;
+        }
+        if (!lora_tx_submit(f.data, f.len, LORA_TX_PRIO_LOW, LORA_TX_RETRIES, 0)) {
+            held = true;
+            break;
+        }
+        down_pop();
+        gw_stats.down_sent++;
+    }
+    if (held) {
+        timer_wheel_arm(&gw_down_timer, LORA_GW_DOWN_RETRY_MS);
+    }
+}
+
+// ===== Benchmark =====
+
+bool lora_gateway_bench(uint32_t count, size_t len, LoraGatewayBench *out) {
+    memset(out, 0, sizeof(*out));
+    if (!gw_running || !lora_mesh_node_id() || !mqtt_connected() || gw_bench.on) {
+        return false;
+    }
+    count = count < 1 ? 1 : count > LORA_GW_BENCH_MAX ? LORA_GW_BENCH_MAX : count;
+    len = len <= LORA_MESH_HEADER_SIZE ? LORA_MESH_HEADER_SIZE + 1 : len > LORA_PACKET_MAX ? LORA_PACKET_MAX : len;
+    gw_bench.rx_ms = (uint32_t *)calloc(count, sizeof(uint32_t));
+    gw_bench.latency = (uint32_t *)calloc(count, sizeof(uint32_t));
+    if (!gw_bench.rx_ms || !gw_bench.latency) {
+        free(gw_bench.rx_ms);
+        free(gw_bench.latency);
+        return false;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        gw_bench.latency[i] = UINT32_MAX;
+    }
+
+    // Random payload, as incompressible as encrypted traffic. Hop limit 0 and
+    // a destination that is not this node: nothing is relayed or delivered
+    uint8_t frame[LORA_PACKET_MAX];
+    esp_fill_random(frame + LORA_MESH_HEADER_SIZE, len - LORA_MESH_HEADER_SIZE);
+    uint32_t node = LORA_GW_BENCH_NODE;
+    memcpy(frame, &node, 4);
+    memcpy(frame + 4, &node, 4);
+    frame[12] = 0;
+    frame[13] = LORA_MESH_CHANNEL_HASH;
+    frame[14] = 0;
+    frame[15] = 0;
+
+    lora_gateway_flush();
+    gw_bench.base_id = esp_random();
+    gw_bench.count = count;
+    gw_bench.forwarded = 0;
+    gw_bench.on = true;
+
+    uint32_t start = millis();
+    for (uint32_t i = 0; i < count && millis() - start < LORA_GW_BENCH_TIMEOUT_MS; i++) {
+        uint32_t id = gw_bench.base_id + i;
+        memcpy(frame + 8, &id, 4);
+        while (!lora_rx_replay(frame, len, -60.0f, 8.0f) && millis() - start < LORA_GW_BENCH_TIMEOUT_MS) {
+            vTaskDelay(1);
+        }
+        out->injected++;
+    }
+    vTaskDelay(pdMS_TO_TICKS(GW_BENCH_SETTLE_MS));
+    lora_gateway_flush();
+    while (gw_bench.forwarded < out->injected && millis() - start < LORA_GW_BENCH_TIMEOUT_MS) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    portENTER_CRITICAL(&gw_mux);
+    gw_bench.on = false;
+    portEXIT_CRITICAL(&gw_mux);
+
+    out->forwarded = gw_bench.forwarded;
+    out->elapsed_ms = gw_bench.last_ms - start;
+    if (out->forwarded && out->elapsed_ms) {
+        out->packets_per_s_x100 = (uint32_t)((uint64_t)out->forwarded * 100000 / out->elapsed_ms);
+    }
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        if (gw_bench.latency[i] != UINT32_MAX) {
+            gw_bench.latency[n++] = gw_bench.latency[i];
+        }
+    }
+    if (n) {
+        bench_summarize(gw_bench.latency, n, &out->latency_ms);
+    }
+    free(gw_bench.rx_ms);
+    free(gw_bench.latency);
+    gw_bench.rx_ms = NULL;
+    gw_bench.latency = NULL;
+    return out->forwarded > 0;
+}
+
+// ===== Console =====
+
+static void rpc_gw(Print &out, const char *args) {
+    if (!strcmp(args, "start")) {
+        out.println(lora_gateway_start() ? "ok" : "failed, see the log");
+        return;
+    }
+    if (!strcmp(args, "stop")) {
+        lora_gateway_stop();
+        out.println("ok");
+        return;
+    }
+    if (!strncmp(args, "bench", 5)) {
+        unsigned count = 200, len = 64;
+        sscanf(args + 5, "%u %u", &count, &len);
+        LoraGatewayBench b;
+        if (!lora_gateway_bench(count, len, &b)) {
+            bench_skip(out, "lora.gateway", "needs the gateway, the mesh and an MQTT connection");
+            return;
+        }
+        char extra[96];
+        snprintf(extra, sizeof(extra), "pps=%lu.%02lu injected=%lu forwarded=%lu len=%u",
+                 (unsigned long)(b.packets_per_s_x100 / 100), (unsigned long)(b.packets_per_s_x100 % 100),
+                 (unsigned long)b.injected, (unsigned long)b.forwarded, len);
+        bench_report(out, "lora.gateway.latency", "ms", b.latency_ms, extra);
+        return;
+    }
+    if (args[0]) {
+        out.println("usage: gw [start | stop | bench [count] [len]]");
+        return;
+    }
+    LoraGatewayStats s;
+    lora_gateway_get_stats(&s);
+    out.printf("%s, batches every %lu ms or %u bytes, QoS %u\n", s.running ? "running" : "stopped",
+               (unsigned long)gw_interval_ms, (unsigned)(gw_batch_bytes ? gw_batch_bytes : MAX_MQTT_MESSAGE_SIZE),
+               gw_qos);
+    out.printf("up: %lu frames in %lu batches (%lu failed), %lu -> %lu bytes, no buffer %lu, via MQTT %lu\n",
+               (unsigned long)s.uplinked, (unsigned long)s.batches, (unsigned long)s.batch_failed,
+               (unsigned long)s.raw_bytes, (unsigned long)s.sent_bytes, (unsigned long)s.no_buffer,
+               (unsigned long)s.via_mqtt);
+    out.printf("down: %lu received, %lu sent, %u queued, expired %lu, full %lu, malformed %lu, airtime waits %lu\n",
+               (unsigned long)s.down_received, (unsigned long)s.down_sent, s.down_queued,
+               (unsigned long)s.down_expired, (unsigned long)s.down_full, (unsigned long)s.down_malformed,
+               (unsigned long)s.airtime_waits);
+}
+
+// ===== API =====
+
+bool lora_gateway_start() {
+    if (gw_running) {
+        return true;
+    }
+    if (!gw_ready) {
+        return false;
+    }
+    if (!peri_init_ensure(E_PERI_LORA)) {
+        LOG_ERROR("Gateway", "No LoRa radio");
+        return false;
+    }
+    if (!lora_mesh_node_id() && !lora_mesh_begin(NULL)) {
+        LOG_WARN("Gateway", "No mesh, frames go up without duplicate suppression");
+    }
+    if (!gw_hooked) {
+        if (!lora_add_rx_hook(rx_hook)) {
+            LOG_ERROR("Gateway", "No free LoRa RX hook");
+            return false;
+        }
+        gw_hooked = true;
+    }
+    snprintf(gw_topic_up, sizeof(gw_topic_up), MQTT_TOPIC_GATEWAY_UP, mqtt_device_id());
+    if (gw_downlink && !gw_subscribed) {
+        snprintf(gw_topic_down, sizeof(gw_topic_down), MQTT_TOPIC_GATEWAY_DOWN, mqtt_device_id());
+        gw_subscribed = mqtt_on_topic(gw_topic_down, on_downlink) && mqtt_subscribe(gw_topic_down, 1);
+    }
+    lora_mesh_set_tap(mesh_tap);
+    lora_set_mode(LORA_MODE_RECV);
+    gw_running = true;
+    LOG_INFOF("Gateway", "Forwarding to %s", gw_topic_up);
+    return true;
+}
+
+void lora_gateway_stop() {
+    if (!gw_running) {
+        return;
+    }
+    gw_running = false;
+    lora_mesh_set_tap(NULL);
+    timer_wheel_cancel(&gw_timer);
+    lora_gateway_flush();
+}
+
+void lora_gateway_flush() {
+    portENTER_CRITICAL(&gw_mux);
+    GwSealed s = take_batch();
+    portEXIT_CRITICAL(&gw_mux);
+    send_batch(s);
+}
+
+bool lora_gateway_begin() {
+    if (gw_ready) {
+        return true;
+    }
+    bool enabled = false;
+#ifdef INTEGRATION_LAYER_ENABLED
+    enabled = GET_CONFIG_BOOL("gateway", "enabled", false);
+    gw_interval_ms = GET_CONFIG_INT("gateway", "interval_ms", LORA_GW_INTERVAL_MS);
+    gw_batch_bytes = GET_CONFIG_INT("gateway", "batch_bytes", 0);
+    gw_qos = GET_CONFIG_INT("gateway", "qos", 1) ? 1 : 0;
+    gw_downlink = GET_CONFIG_BOOL("gateway", "downlink", true);
+    gw_reserve_pct = GET_CONFIG_INT("gateway", "reserve_pct", LORA_GW_RESERVE_PCT);
+#endif
+    if (!gw_interval_ms) {
+        gw_interval_ms = LORA_GW_INTERVAL_MS;
+    }
+    if (gw_reserve_pct > 100) {
+        gw_reserve_pct = 100;
+    }
+    timer_wheel_init(&gw_timer, "gw", flush_tick);
+    timer_wheel_init(&gw_down_timer, "gwdown", down_tick);
+    usb_console_rpc("gw", rpc_gw);
+    gw_ready = true;
+    return enabled ? lora_gateway_start() : true;
+}
+
+void lora_gateway_get_stats(LoraGatewayStats *out) {
+    portENTER_CRITICAL(&gw_mux);
+    *out = gw_stats;
+    out->down_queued = gw_down_count;
+    portEXIT_CRITICAL(&gw_mux);
+    out->running = gw_running;
+}
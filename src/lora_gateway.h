@@ -0,0 +1,117 @@
+/**
+ * @file      lora_gateway.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     LoRa to MQTT gateway: batched uplink of heard packets, airtime-scheduled downlink
+ */
+
+#ifndef LORA_GATEWAY_H
+#define LORA_GATEWAY_H
+
+#include <Arduino.h>
+#include "bench_suite.h"
+
+/**
+ * For a unit at a base camp with WiFi or 4G: what it hears on LoRa goes
+ * upstream, what the broker sends goes out on LoRa.
+ *
+ * Uplink. Mesh packets come from the mesh's tap, so a packet relayed by
+ * several nodes goes up once, as the mesh's packet-ID cache decides;
+ * other frames from an RX hook that leaves them in the RX queue. Frames
+ * already flagged LORA_MESH_FLAG_VIA_MQTT came from a broker and stay
+ * here. The LoRa task writes each one straight into an MQTT pool buffer,
+ * packed with lora_codec when that makes it shorter. The buffer goes to
+ * MQTT_TOPIC_GATEWAY_UP when the next frame would not fit under
+ * batch_bytes, or interval_ms after its first frame, so a busy channel
+ * costs one publish per buffer rather than one per packet. Little-endian:
+ *
+ *   batch   version(1) flags(1) seq(2) node(4) t0_ms(8) record...
+ *   record  dt_ms(varint) rssi(i8) snr_x4(i8) flags(1) len(1) data
+ *
+ * node is the mesh node ID; t0_ms is UTC with LORA_GW_BATCH_UTC, time
+ * since boot without; dt_ms counts from t0.
+ *
+ * Downlink. MQTT_TOPIC_GATEWAY_DOWN carries len(1) frame pairs, each
+ * frame sent as is. Mesh frames get LORA_MESH_FLAG_VIA_MQTT, so the
+ * relays that come back are not sent up again. Frames wait in a queue
+ * and join the TX queue at low priority while it holds fewer than
+ * LORA_GW_DOWN_TX_DEPTH frames and the duty-cycle budget has the frame's
+ * airtime left over on top of reserve_pct of the budget, which stays for
+ * this node's own traffic. A frame still waiting after
+ * LORA_GW_DOWN_TTL_MS is dropped.
+ *
+ * Console: "gw" for the counters, "gw bench [count] [len]" injects count
+ * mesh frames from LORA_GW_BENCH_NODE through the RX path and reports
+ * packets per second forwarded and the latency from receive to the batch
+ * handed to the MQTT client. Benchmark frames go upstream like any other.
+ *
+ * Config section "gateway": enabled (false), interval_ms, batch_bytes
+ * (0 for a full buffer), qos (1), downlink (true), reserve_pct.
+ */
+
+#define LORA_GW_VERSION             1
+#define LORA_GW_BATCH_HEADER        16
+#define LORA_GW_BATCH_UTC           0x01    // Batch flag: t0_ms is UTC
+#define LORA_GW_REC_MESH            0x01    // Record flag: from the mesh tap
+#define LORA_GW_REC_PACKED          0x02    // Record flag: data is lora_codec packed
+#define LORA_GW_INTERVAL_MS         5000
+#define LORA_GW_DOWN_SLOTS          16
+#define LORA_GW_DOWN_TTL_MS         60000
+#define LORA_GW_DOWN_RETRY_MS       500     // While a frame waits for airtime or the TX queue
+#define LORA_GW_DOWN_TX_DEPTH       2       // Downlinks only join a TX queue shorter than this
+#define LORA_GW_RESERVE_PCT         25      // Duty-cycle budget kept for local traffic
+#define LORA_GW_BENCH_NODE          0x7FFFFFFEUL
+#define LORA_GW_BENCH_MAX           512
+#define LORA_GW_BENCH_TIMEOUT_MS    30000
+
+struct LoraGatewayStats {
+    bool running;
+    uint32_t uplinked;              // Frames into a batch
+    uint32_t via_mqtt;              // Skipped, they came from a broker
+    uint32_t batches;
+    uint32_t batch_failed;          // Refused by the MQTT client
+    uint32_t no_buffer;             // Frames dropped on an empty MQTT pool
+    uint32_t raw_bytes;             // Frame bytes before packing
+    uint32_t sent_bytes;            // Batch bytes, headers included
+    uint32_t down_received;
+    uint32_t down_sent;
+    uint32_t down_expired;
+    uint32_t down_full;             // Dropped, the queue was full
+    uint32_t down_malformed;        // Downlink messages with a bad length
+    uint32_t airtime_waits;         // Retries for want of airtime
+    uint8_t down_queued;
+};
+
+struct LoraGatewayBench {
+    uint32_t injected;
+    uint32_t forwarded;
+    uint32_t elapsed_ms;            // First injection to the last batch handed over
+    uint32_t packets_per_s_x100;
+    BenchResult latency_ms;         // Receive stamp to the batch handed over
+};
+
+/**
+ * @brief Console command and config; starts the gateway when enabled.
+ *        After MQTT; brings up the radio and the mesh itself
+ */
+bool lora_gateway_begin();
+
+bool lora_gateway_start();
+void lora_gateway_stop();
+
+/**
+ * @brief Hand the open batch to the MQTT client now
+ */
+void lora_gateway_flush();
+
+/**
+ * @brief Inject count mesh frames of len bytes and wait for them upstream.
+ *        Needs the gateway running and an MQTT connection; blocks the caller
+ */
+bool lora_gateway_bench(uint32_t count, size_t len, LoraGatewayBench *out);
+
+void lora_gateway_get_stats(LoraGatewayStats *out);
+
+#endif // LORA_GATEWAY_H
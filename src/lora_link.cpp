@@ -0,0 +1,595 @@
+/**
+ * @file      lora_link.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     LoRa message link: fragmentation, reassembly and selective-repeat ACKs
+ */
+
+#include "lora_link.h"
+#include "simple_logger.h"
+#include "lora_stats.h"
+#include <esp_rom_crc.h>
+#ifdef INTEGRATION_LAYER_ENABLED
+#include "integration/config_manager.h"
+#endif
+
+#define LINK_TYPE_DATA      0x01
+#define LINK_TYPE_ACK       0x02
+#define LINK_TYPE_FAST_REQ  0x03    // arg: GFSK preset index
+#define LINK_TYPE_FAST_ACK  0x04    // arg: the index accepted, or LINK_FAST_REFUSED
+#define LINK_TYPE_FAST_END  0x05
+#define LINK_TYPE_MASK      0x7F
+#define LINK_FLAG_ACK_REQ   0x80    // Last fragment of a round: answer with an ACK
+#define LINK_FAST_REFUSED   0xFF
+
+struct LinkRxSlot {
+    bool used;
+    uint16_t src;
+    uint16_t msg_id;
+    uint8_t count;
+    uint8_t last_len;               // Payload of the final fragment
+    uint32_t bitmap;
+    uint32_t touched;               // millis() of the latest fragment
+    uint8_t data[LORA_LINK_MSG_MAX + 4];
+};
+
+struct LinkDone {
+    uint16_t src;
+    uint16_t msg_id;
+    bool valid;
+};
+
+static lora_link_recv_cb link_on_message = nullptr;
+static uint16_t link_node_id = 0;
+static bool link_started = false;
+static LoraLinkStats link_stats;
+
+// Sender: one message in flight, its fragments kept until fully ACKed
+static SemaphoreHandle_t link_send_mutex = NULL;
+static SemaphoreHandle_t link_ack_sem = NULL;
+static volatile bool link_waiting = false;
+static volatile uint16_t link_wait_msg = 0;
+static volatile uint32_t link_ack_bitmap = 0;
+static volatile uint16_t link_ack_from = 0;    // First receiver to answer, for peer stats
+static volatile float link_ack_rssi = 0;        // Latest ACK, for the GFSK fallback
+static uint16_t link_msg_seq = 0;
+static uint8_t link_tx_buf[LORA_LINK_MSG_MAX + 4];
+
+// Receiver, touched only from the LoRa task
+static LinkRxSlot link_rx[LORA_LINK_RX_SLOTS];
+static LinkDone link_done[LORA_LINK_DONE_CACHE];
+static uint8_t link_done_next = 0;
+
+// GFSK bulk mode: the one peer it runs with, and a request waiting for its answer
+static volatile uint16_t link_fast_with = 0;
+static volatile uint16_t link_fast_asked = 0;
+static volatile uint8_t link_fast_answer = LINK_FAST_REFUSED;
+
+static inline void put16(uint8_t *p, uint16_t v) { memcpy(p, &v, sizeof(v)); }
+static inline void put32(uint8_t *p, uint32_t v) { memcpy(p, &v, sizeof(v)); }
+static inline uint16_t get16(const uint8_t *p) { uint16_t v; memcpy(&v, p, sizeof(v)); return v; }
+static inline uint32_t get32(const uint8_t *p) { uint32_t v; memcpy(&v, p, sizeof(v)); return v; }
+
+static inline uint32_t full_bitmap(uint8_t count) {
+    return count >= 32 ? 0xFFFFFFFFUL : (1UL << count) - 1;
+}
+
+static void send_ack(uint16_t dst, uint16_t msg_id, uint32_t bitmap) {
+    uint8_t frame[LORA_LINK_ACK_SIZE];
+    frame[0] = LORA_LINK_MAGIC;
+    frame[1] = LINK_TYPE_ACK;
+    put16(frame + 2, link_node_id);
+    put16(frame + 4, msg_id);
+    put16(frame + 6, dst);
+    put32(frame + 8, bitmap);
+    
+    // ACKs jump the queue; a lost one is recovered by the next round
+    lora_tx_enqueue(frame, sizeof(frame), LORA_TX_PRIO_HIGH, 0);
+}
+
+static void send_ctrl(uint8_t type, uint16_t dst, uint8_t arg) {
+    uint8_t frame[LORA_LINK_CTRL_SIZE];
+    frame[0] = LORA_LINK_MAGIC;
+    frame[1] = type;
+    put16(frame + 2, link_node_id);
+    put16(frame + 4, dst);
+    frame[6] = arg;
+    lora_tx_enqueue(frame, sizeof(frame), LORA_TX_PRIO_HIGH, 0);
+}
+
+static void on_ack(const lora_packet_t *pkt) {
+    uint16_t msg_id = get16(pkt->data + 4);
+    uint16_t dst = get16(pkt->data + 6);
+    
+    if (dst != link_node_id || !link_waiting || msg_id != link_wait_msg) {
+        return;
+    }
+    link_ack_bitmap |= get32(pkt->data + 8);
+    link_ack_rssi = pkt->rssi;
+    if (!link_ack_from) {
+        link_ack_from = get16(pkt->data + 2);
+    }
+    lora_stats_peer_rx(get16(pkt->data + 2), pkt);
+    xSemaphoreGive(link_ack_sem);
+}
+
+static bool is_done(uint16_t src, uint16_t msg_id) {
+    for (int i = 0; i < LORA_LINK_DONE_CACHE; i++) {
+        if (link_done[i].valid && link_done[i].src == src && link_done[i].msg_id == msg_id) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Slot for a new message: a free one, else the one idle the longest
+static LinkRxSlot *claim_slot(uint16_t src, uint16_t msg_id, uint8_t count, uint32_t now) {
+    LinkRxSlot *victim = &link_rx[0];
+    
+    for (int i = 0; i < LORA_LINK_RX_SLOTS; i++) {
+        LinkRxSlot *slot = &link_rx[i];
+        if (slot->used && now - slot->touched >= LORA_LINK_RX_TIMEOUT_MS) {
+            slot->used = false;
+            link_stats.rx_evicted++;
+        }
+        if (slot->used && slot->src == src && slot->msg_id == msg_id) {
+            if (slot->count == count) {
+                return slot;
+            }
+            victim = slot;          // Same ID, different shape: start over
+            break;
+        }
+        if (!slot->used) {
+            if (victim->used) {
+                victim = slot;
+            }
+        } else if (victim->used && (int32_t)(slot->touched - victim->touched) < 0) {
+            victim = slot;
+        }
+    }
+    
+    if (victim->used) {
+        link_stats.rx_evicted++;
+    }
+    victim->used = true;
+    victim->src = src;
+    victim->msg_id = msg_id;
+    victim->count = count;
+    victim->last_len = 0;
+    victim->bitmap = 0;
+    victim->touched = now;
+    return victim;
+}
+
+static void on_data(const lora_packet_t *pkt) {
+    uint8_t flags = pkt->data[1];
+    uint16_t src = get16(pkt->data + 2);
+    uint16_t msg_id = get16(pkt->data + 4);
+    uint8_t index = pkt->data[6];
+    uint8_t count = pkt->data[7];
+    size_t len = pkt->len - LORA_LINK_DATA_HEADER;
+    
+    // Every fragment but the last is full, and the whole message fits a
+    // reassembly slot: the header comes off the air unauthenticated
+    if (src == link_node_id || count == 0 || count > LORA_LINK_MSG_FRAGS || index >= count ||
+        (index + 1 < count && len != LORA_LINK_FRAG_PAYLOAD) ||
+        index * LORA_LINK_FRAG_PAYLOAD + len > sizeof(LinkRxSlot::data)) {
+        return;
+    }
+    lora_stats_peer_rx(src, pkt);
+    
+    // A repeat of a delivered message only needs its ACK again
+    if (is_done(src, msg_id)) {
+        if (flags & LINK_FLAG_ACK_REQ) {
+            send_ack(src, msg_id, full_bitmap(count));
+        }
+        return;
+    }
+    
+    LinkRxSlot *slot = claim_slot(src, msg_id, count, pkt->time_ms);
+    memcpy(slot->data + index * LORA_LINK_FRAG_PAYLOAD, pkt->data + LORA_LINK_DATA_HEADER, len);
+    slot->bitmap |= 1UL << index;
+    slot->touched = pkt->time_ms;
+    if (index + 1 == count) {
+        slot->last_len = len;
+    }
+    link_stats.fragments_received++;
+    
+    uint32_t ack = slot->bitmap;
+    if (slot->bitmap == full_bitmap(count)) {
+        size_t total = (count - 1) * LORA_LINK_FRAG_PAYLOAD + slot->last_len;
+        uint32_t crc = 0;
+        if (total > 4) {
+            memcpy(&crc, slot->data + total - 4, sizeof(crc));
+        }
+    
+        if (total > 4 && esp_rom_crc32_le(0, slot->data, total - 4) == crc) {
+            link_done[link_done_next].src = src;
+            link_done[link_done_next].msg_id = msg_id;
+            link_done[link_done_next].valid = true;
+            link_done_next = (link_done_next + 1) % LORA_LINK_DONE_CACHE;
+            link_stats.messages_received++;
+            if (link_on_message) {
+                link_on_message(src, slot->data, total - 4);
+            }
+        } else {
+            // Report nothing received so the sender repeats the whole message
+            link_stats.crc_errors++;
+            LOG_WARNF("LoRaLink", "CRC mismatch on message %u from %04x", msg_id, src);
+            ack = 0;
+        }
+        slot->used = false;
+    }
+    
+    if (flags & LINK_FLAG_ACK_REQ) {
+        send_ack(src, msg_id, ack);
+    }
+}
+
+// A request is answered on LoRa; the GFSK switch waits for the answer to go out
+static void on_fast_req(uint16_t src, uint8_t index) {
+    size_t count;
+    const lora_fsk_t *presets = lora_get_fsk_presets(&count);
+    bool allowed = true;
+#ifdef INTEGRATION_LAYER_ENABLED
+    allowed = GET_CONFIG(LORA_FSK);
+#endif
+    // Not while this end is sending, or in bulk mode with another peer
+    if (!allowed || index >= count || link_waiting || link_fast_asked ||
+        (link_fast_with && link_fast_with != src && lora_fsk_running())) {
+        send_ctrl(LINK_TYPE_FAST_ACK, src, LINK_FAST_REFUSED);
+        return;
+    }
+    send_ctrl(LINK_TYPE_FAST_ACK, src, index);
+    link_fast_with = src;
+    link_stats.fast_sessions++;
+    lora_fsk_start(&presets[index], LORA_LINK_FAST_IDLE_MS);
+    LOG_INFOF("LoRaLink", "GFSK %s with %04x", presets[index].name, src);
+}
+
+static void on_ctrl(const lora_packet_t *pkt) {
+    uint8_t type = pkt->data[1] & LINK_TYPE_MASK;
+    uint16_t src = get16(pkt->data + 2);
+    uint8_t arg = pkt->data[6];
+    
+    if (get16(pkt->data + 4) != link_node_id || src == link_node_id) {
+        return;
+    }
+    if (type == LINK_TYPE_FAST_REQ) {
+        on_fast_req(src, arg);
+    } else if (type == LINK_TYPE_FAST_ACK) {
+        if (link_fast_asked == src) {
+            link_fast_answer = arg;
+            xSemaphoreGive(link_ack_sem);
+        }
+    } else if (src == link_fast_with) {
+        link_fast_with = 0;
+        lora_fsk_stop();
+    }
+}
+
+static bool link_rx_hook(const lora_packet_t *pkt) {
+    if (pkt->len < 2 || pkt->data[0] != LORA_LINK_MAGIC) {
+        return false;
+    }
+    
+    uint8_t type = pkt->data[1] & LINK_TYPE_MASK;
+    if (type == LINK_TYPE_ACK && pkt->len == LORA_LINK_ACK_SIZE) {
+        on_ack(pkt);
+    } else if (type == LINK_TYPE_DATA && pkt->len > LORA_LINK_DATA_HEADER) {
+        on_data(pkt);
+    } else if (type >= LINK_TYPE_FAST_REQ && type <= LINK_TYPE_FAST_END && pkt->len == LORA_LINK_CTRL_SIZE) {
+        on_ctrl(pkt);
+    }
+    
+    // Malformed link frames are swallowed as well
+    return true;
+}
+
+bool lora_link_begin(lora_link_recv_cb on_message) {
+    if (link_send_mutex == NULL) {
+        link_send_mutex = xSemaphoreCreateMutex();
+        link_ack_sem = xSemaphoreCreateBinary();
+    }
+    if (link_send_mutex == NULL || link_ack_sem == NULL) {
+        LOG_ERROR("LoRaLink", "Failed to create semaphores");
+        return false;
+    }
+    
+    // The last two bytes of the factory MAC
+    link_node_id = (uint16_t)(ESP.getEfuseMac() >> 32);
+    link_msg_seq = (uint16_t)esp_random();
+    link_on_message = on_message;
+    lora_add_rx_hook(link_rx_hook);
+    link_started = true;
+    
+    LOG_INFOF("LoRaLink", "Link started, node %04x", link_node_id);
+    return true;
+}
+
+uint16_t lora_link_node_id() {
+    return link_node_id;
+}
+
+static void send_fragment(uint16_t msg_id, uint8_t index, uint8_t count, size_t total, bool ack_req) {
+    uint8_t frame[LORA_PACKET_MAX];
+    size_t offset = index * LORA_LINK_FRAG_PAYLOAD;
+    size_t len = total - offset < LORA_LINK_FRAG_PAYLOAD ? total - offset : LORA_LINK_FRAG_PAYLOAD;
+    
+    frame[0] = LORA_LINK_MAGIC;
+    frame[1] = LINK_TYPE_DATA | (ack_req ? LINK_FLAG_ACK_REQ : 0);
+    put16(frame + 2, link_node_id);
+    put16(frame + 4, msg_id);
+    frame[6] = index;
+    frame[7] = count;
+    memcpy(frame + LORA_LINK_DATA_HEADER, link_tx_buf + offset, len);
+    
+    // Keep a TX slot free for the ACKs this device owes its own peers
+    while (lora_tx_pending() >= LORA_TX_POOL_SIZE - 1) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    
+    // Lost here or on air, the fragment shows up missing in the next ACK
+    lora_tx_enqueue(frame, LORA_LINK_DATA_HEADER + len, LORA_TX_PRIO_NORMAL, 0);
+}
+
+// One message, with link_send_mutex held. sent and resent count its fragments
+static int send_message(const uint8_t *data, size_t len, uint32_t *sent_out, uint32_t *resent_out) {
+    uint32_t crc = esp_rom_crc32_le(0, data, len);
+    memcpy(link_tx_buf, data, len);
+    memcpy(link_tx_buf + len, &crc, sizeof(crc));
+    size_t total = len + sizeof(crc);
+    uint8_t count = (total + LORA_LINK_FRAG_PAYLOAD - 1) / LORA_LINK_FRAG_PAYLOAD;
+    uint32_t full = full_bitmap(count);
+    
+    link_wait_msg = link_msg_seq++;
+    link_ack_bitmap = 0;
+    link_ack_from = 0;
+    xSemaphoreTake(link_ack_sem, 0);
+    link_waiting = true;
+    
+    if (lora_get_mode() != LORA_MODE_RECV) {
+        lora_set_mode(LORA_MODE_RECV);
+    }
+    
+    int result = LORA_LINK_ERR_TIMEOUT;
+    uint32_t sent = 0;
+    uint32_t resent = 0;
+    for (int round = 0; round < LORA_LINK_ROUNDS; round++) {
+        uint32_t missing = full & ~link_ack_bitmap;
+        int last = 31 - __builtin_clz(missing);
+    
+        for (int i = 0; i <= last; i++) {
+            if (missing & (1UL << i)) {
+                send_fragment(link_wait_msg, i, count, total, i == last);
+                link_stats.fragments_sent++;
+                sent++;
+                if (round > 0) {
+                    link_stats.fragments_resent++;
+                    resent++;
+                }
+            }
+        }
+    
+        // The ACK timer starts once the round is on air
+        while (lora_tx_pending() > 0) {
+            vTaskDelay(pdMS_TO_TICKS(10));
+        }
+        uint32_t wait_ms = lora_time_on_air_us(LORA_LINK_ACK_SIZE) / 1000 * 2 + LORA_LINK_ACK_GUARD_MS;
+    
+        if (xSemaphoreTake(link_ack_sem, pdMS_TO_TICKS(wait_ms)) == pdTRUE && (link_ack_bitmap & full) == full) {
+            result = LORA_LINK_OK;
+            break;
+        }
+    }
+    
+    link_waiting = false;
+    
+    // Every resend stands for a fragment lost on the way; unanswered sends have no peer to charge
+    if (link_ack_from) {
+        lora_stats_peer_tx(link_ack_from, sent, resent + __builtin_popcount(full & ~link_ack_bitmap));
+    }
+    if (result == LORA_LINK_OK) {
+        link_stats.messages_sent++;
+    } else {
+        link_stats.messages_failed++;
+        LOG_WARNF("LoRaLink", "Message %u unacknowledged after %d rounds", link_wait_msg, LORA_LINK_ROUNDS);
+    }
+    *sent_out = sent;
+    *resent_out = resent;
+    return result;
+}
+
+static inline bool fast_running() {
+    return link_fast_with && lora_fsk_running();
+}
+
+// With link_send_mutex held: tell the peer while still on GFSK, then wait
+// for the local radio to be back on LoRa
+static void fast_end_locked() {
+    if (fast_running()) {
+        send_ctrl(LINK_TYPE_FAST_END, link_fast_with, 0);
+    }
+    link_fast_with = 0;
+    lora_fsk_stop();
+    
+    uint32_t start = millis();
+    while (lora_fsk_running() && millis() - start < LORA_LINK_FAST_SWITCH_MS) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+}
+
+int lora_link_send(const uint8_t *data, size_t len) {
+    if (!link_started || len == 0 || len > LORA_LINK_MSG_MAX) {
+        return LORA_LINK_ERR_ARG;
+    }
+    if (xSemaphoreTake(link_send_mutex, 0) != pdTRUE) {
+        return LORA_LINK_ERR_BUSY;
+    }
+    
+    bool fast = fast_running();
+    uint32_t sent = 0;
+    uint32_t resent = 0;
+    int result = send_message(data, len, &sent, &resent);
+    
+    // GFSK has the link margin of a much slower LoRa profile only at short
+    // range: a failed message, a weak ACK or a quarter of the fragments
+    // resent ends it, and a failed message goes again over LoRa
+    if (fast && (result != LORA_LINK_OK || link_ack_rssi < LORA_LINK_FAST_MIN_RSSI || resent * 4 > sent)) {
+        LOG_WARNF("LoRaLink", "GFSK link to %04x degraded (%s, ACK %.0f dBm, %lu/%lu resent), back to LoRa",
+                  link_fast_with, result == LORA_LINK_OK ? "delivered" : "failed", link_ack_rssi,
+                  (unsigned long)resent, (unsigned long)sent);
+        link_stats.fast_fallbacks++;
+        fast_end_locked();
+        if (result != LORA_LINK_OK) {
+            result = send_message(data, len, &sent, &resent);
+        }
+    }
+    xSemaphoreGive(link_send_mutex);
+    return result;
+}
+
+int lora_link_fast_begin(uint16_t peer, const char *fsk_name) {
+    size_t count;
+    const lora_fsk_t *presets = lora_get_fsk_presets(&count);
+    const lora_fsk_t *fsk = lora_find_fsk(fsk_name);
+    if (!link_started || fsk == NULL || peer == 0 || peer == link_node_id) {
+        return LORA_LINK_ERR_ARG;
+    }
+    if (xSemaphoreTake(link_send_mutex, 0) != pdTRUE) {
+        return LORA_LINK_ERR_BUSY;
+    }
+    if (lora_fsk_running()) {
+        fast_end_locked();
+    }
+    if (lora_get_mode() != LORA_MODE_RECV) {
+        lora_set_mode(LORA_MODE_RECV);
+    }
+    
+    link_fast_answer = LINK_FAST_REFUSED;
+    xSemaphoreTake(link_ack_sem, 0);
+    link_fast_asked = peer;
+    
+    int result = LORA_LINK_ERR_TIMEOUT;
+    for (int i = 0; i < LORA_LINK_FAST_TRIES; i++) {
+        send_ctrl(LINK_TYPE_FAST_REQ, peer, (uint8_t)(fsk - presets));
+        while (lora_tx_pending() > 0) {
+            vTaskDelay(pdMS_TO_TICKS(10));
+        }
+        uint32_t wait_ms = lora_time_on_air_us(LORA_LINK_CTRL_SIZE) / 1000 * 2 + LORA_LINK_ACK_GUARD_MS;
+        if (xSemaphoreTake(link_ack_sem, pdMS_TO_TICKS(wait_ms)) == pdTRUE) {
+            result = link_fast_answer == fsk - presets ? LORA_LINK_OK : LORA_LINK_ERR_REFUSED;
+            break;
+        }
+    }
+    link_fast_asked = 0;
+    
+    if (result == LORA_LINK_OK) {
+        // The peer switches as its answer leaves the air, this end as it arrives
+        link_fast_with = peer;
+        link_stats.fast_sessions++;
+        lora_fsk_start(fsk, LORA_LINK_FAST_IDLE_MS);
+        uint32_t start = millis();
+        while (lora_fsk_running() != fsk && millis() - start < LORA_LINK_FAST_SWITCH_MS) {
+            vTaskDelay(pdMS_TO_TICKS(5));
+        }
+        vTaskDelay(pdMS_TO_TICKS(LORA_LINK_FAST_SETTLE_MS));
+        if (lora_fsk_running() != fsk) {
+            link_fast_with = 0;
+            result = LORA_LINK_ERR_TIMEOUT;
+        }
+    }
+    if (result != LORA_LINK_OK) {
+        LOG_WARNF("LoRaLink", "GFSK %s with %04x: %s", fsk->name, peer,
+                  result == LORA_LINK_ERR_REFUSED ? "refused" : "no answer");
+    }
+    xSemaphoreGive(link_send_mutex);
+    return result;
+}
+
+void lora_link_fast_end() {
+    if (!link_started) {
+        return;
+    }
+    xSemaphoreTake(link_send_mutex, portMAX_DELAY);
+    fast_end_locked();
+    xSemaphoreGive(link_send_mutex);
+}
+
+uint16_t lora_link_fast_peer() {
+    return fast_running() ? link_fast_with : 0;
+}
+
+const LoraLinkStats *lora_link_stats() {
+    return &link_stats;
+}
+
+uint32_t lora_link_benchmark(Print &out, size_t msg_len, uint8_t count) {
+    if (msg_len == 0 || msg_len > LORA_LINK_MSG_MAX) {
+        msg_len = LORA_LINK_MSG_MAX;
+    }
+    size_t total = msg_len + 4;
+    size_t frags = (total + LORA_LINK_FRAG_PAYLOAD - 1) / LORA_LINK_FRAG_PAYLOAD;
+    size_t last_len = total - (frags - 1) * LORA_LINK_FRAG_PAYLOAD;
+    
+    // Loss-free exchange: every fragment once, one ACK
+    out.printf("LoRa link goodput, %u byte messages in %u fragments\n", (unsigned)msg_len, (unsigned)frags);
+    out.printf("%-12s %4s %6s %10s %10s %10s\n", "profile", "SF", "BW", "airtime", "B/s", "B/s@duty");
+    
+    size_t preset_count;
+    const lora_profile_t *presets = lora_get_presets(&preset_count);
+    for (size_t i = 0; i < preset_count; i++) {
+        const lora_profile_t *p = &presets[i];
+        uint64_t us = (uint64_t)(frags - 1) * lora_profile_time_on_air_us(p, LORA_PACKET_MAX) +
+                      lora_profile_time_on_air_us(p, LORA_LINK_DATA_HEADER + last_len) +
+                      lora_profile_time_on_air_us(p, LORA_LINK_ACK_SIZE);
+        uint32_t goodput = (uint32_t)(msg_len * 1000000ULL / us);
+        out.printf("%-12s %4u %6.0f %8lums %10lu %10lu\n", p->name, p->sf, p->bw, (unsigned long)(us / 1000),
+                   (unsigned long)goodput, (unsigned long)(goodput * LORA_DUTY_PERMILLE / 1000));
+    }
+    
+    const lora_fsk_t *fsk = lora_get_fsk_presets(&preset_count);
+    for (size_t i = 0; i < preset_count; i++) {
+        const lora_fsk_t *f = &fsk[i];
+        uint64_t us = (uint64_t)(frags - 1) * lora_fsk_time_on_air_us(f, LORA_PACKET_MAX) +
+                      lora_fsk_time_on_air_us(f, LORA_LINK_DATA_HEADER + last_len) +
+                      lora_fsk_time_on_air_us(f, LORA_LINK_ACK_SIZE);
+        uint32_t goodput = (uint32_t)(msg_len * 1000000ULL / us);
+        out.printf("%-12s %4s %6.0f %8lums %10lu %10lu\n", f->name, "-", f->rx_bw, (unsigned long)(us / 1000),
+                   (unsigned long)goodput, (unsigned long)(goodput * LORA_DUTY_PERMILLE / 1000));
+    }
+    
+    if (count == 0) {
+        return 0;
+    }
+    
+    // Measured against a peer running lora_link on the same profile, or in bulk mode with it
+    uint8_t *msg = (uint8_t *)malloc(msg_len);
+    if (!msg) {
+        LOG_ERROR("LoRaLink", "Benchmark buffer allocation failed");
+        return 0;
+    }
+    for (size_t i = 0; i < msg_len; i++) {
+        msg[i] = (uint8_t)esp_random();
+    }
+    
+    LoraLinkStats before = link_stats;
+    uint32_t delivered = 0;
+    uint32_t start = millis();
+    for (uint8_t n = 0; n < count; n++) {
+        if (lora_link_send(msg, msg_len) == LORA_LINK_OK) {
+            delivered++;
+        }
+    }
+    uint32_t elapsed = millis() - start;
+    free(msg);
+    
+    uint32_t goodput = elapsed ? (uint32_t)((uint64_t)delivered * msg_len * 1000 / elapsed) : 0;
+    const lora_fsk_t *running = lora_fsk_running();
+    out.printf("measured on %s: %lu/%u delivered in %lu ms, %lu B/s, %lu fragments resent\n",
+               running ? running->name : lora_get_profile()->name, (unsigned long)delivered, count, (unsigned long)elapsed,
+               (unsigned long)goodput, (unsigned long)(link_stats.fragments_resent - before.fragments_resent));
+    return goodput;
+}
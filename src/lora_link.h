@@ -0,0 +1,123 @@
+/**
+ * @file      lora_link.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Fragmenting, acknowledged LoRa message link on top of the packet queues
+ */
+
+#ifndef LORA_LINK_H
+#define LORA_LINK_H
+
+#include <Arduino.h>
+#include "peripheral.h"
+
+// Frames start with the magic byte, so plain text packets pass through to
+// the RX queue untouched
+#define LORA_LINK_MAGIC             0xD7
+#define LORA_LINK_DATA_HEADER       8     // magic, type, src(2), msg_id(2), index, count
+#define LORA_LINK_ACK_SIZE          12    // magic, type, src(2), msg_id(2), dst(2), bitmap(4)
+#define LORA_LINK_CTRL_SIZE         7     // magic, type, src(2), dst(2), arg
+#define LORA_LINK_FRAG_PAYLOAD      (LORA_PACKET_MAX - LORA_LINK_DATA_HEADER)
+#define LORA_LINK_FRAG_MAX          32    // Width of the ACK bitmap
+#define LORA_LINK_MSG_MAX           4096  // Payload bytes, the CRC32 rides on top
+#define LORA_LINK_MSG_FRAGS         ((LORA_LINK_MSG_MAX + 4 + LORA_LINK_FRAG_PAYLOAD - 1) / LORA_LINK_FRAG_PAYLOAD) // Largest count a message needs
+
+// Reassembly
+#define LORA_LINK_RX_SLOTS          2     // Messages reassembled at once
+#define LORA_LINK_RX_TIMEOUT_MS     30000 // An idle partial message is dropped
+#define LORA_LINK_DONE_CACHE        4     // Completed messages still re-ACKed
+
+// Selective repeat
+#define LORA_LINK_ROUNDS            6     // Send rounds before giving up
+#define LORA_LINK_ACK_GUARD_MS      500   // Wait for the ACK beyond its airtime
+
+// GFSK bulk mode
+#define LORA_LINK_FAST_TRIES        3     // Requests before the peer counts as absent
+#define LORA_LINK_FAST_IDLE_MS      5000  // Both ends drop back to LoRa after this long idle
+#define LORA_LINK_FAST_SWITCH_MS    500   // Wait for the local radio to change modem
+#define LORA_LINK_FAST_SETTLE_MS    20    // Head start for the peer's own switch
+#define LORA_LINK_FAST_MIN_RSSI     -95   // dBm of the last ACK; weaker falls back
+
+static_assert(LORA_LINK_MSG_FRAGS <= LORA_LINK_FRAG_MAX,
+              "LORA_LINK_MSG_MAX does not fit the ACK bitmap");
+
+enum {
+    LORA_LINK_OK = 0,
+    LORA_LINK_ERR_ARG,              // Empty, too large, or link not started
+    LORA_LINK_ERR_BUSY,             // Another send is in progress
+    LORA_LINK_ERR_TIMEOUT,          // Rounds exhausted without a full ACK
+    LORA_LINK_ERR_REFUSED,          // Peer declined the GFSK bulk mode
+};
+
+/**
+ * @brief Complete, CRC-checked message. Runs on the LoRa task: copy the data
+ *        out and return quickly
+ */
+typedef void (*lora_link_recv_cb)(uint16_t src, const uint8_t *data, size_t len);
+
+struct LoraLinkStats {
+    uint32_t messages_sent;
+    uint32_t messages_failed;
+    uint32_t messages_received;
+    uint32_t fragments_sent;
+    uint32_t fragments_resent;
+    uint32_t fragments_received;
+    uint32_t crc_errors;
+    uint32_t rx_evicted;            // Partial messages dropped for a new one or on timeout
+    uint32_t fast_sessions;         // GFSK bulk mode entered, either end
+    uint32_t fast_fallbacks;        // Left for a failed message or a weak link
+};
+
+/**
+ * @brief Hook the link into the LoRa RX path; call after lora_init()
+ */
+bool lora_link_begin(lora_link_recv_cb on_message);
+uint16_t lora_link_node_id();
+
+/**
+ * @brief Send one message and wait until the peer ACKed every fragment.
+ *
+ * Blocks the calling task for the whole exchange (seconds on slow profiles),
+ * so never call it from the LVGL or LoRa task. The radio is put into receive
+ * mode, which the ACKs need.
+ */
+int lora_link_send(const uint8_t *data, size_t len);
+
+/**
+ * @brief Move the exchange with peer to GFSK bulk mode (lora_fsk_t preset
+ *        fsk_name) for transfers far faster than any LoRa profile.
+ *
+ * Negotiated over LoRa: the peer answers a request and both ends switch
+ * once the answer is on air. lora_link_send() keeps working on GFSK and
+ * returns to LoRa on its own when a message fails, which it then repeats
+ * over LoRa, or when the ACKs come in weak or many fragments need resending.
+ * A peer that has lora.fsk off, or is sending itself, declines. Either end
+ * drops back after LORA_LINK_FAST_IDLE_MS without traffic. Blocks like
+ * lora_link_send().
+ */
+int lora_link_fast_begin(uint16_t peer, const char *fsk_name);
+
+/**
+ * @brief Tell the peer and go back to LoRa; waits for a send in progress
+ */
+void lora_link_fast_end();
+
+/**
+ * @brief Peer of the running bulk mode, 0 on LoRa
+ */
+uint16_t lora_link_fast_peer();
+
+const LoraLinkStats *lora_link_stats();
+
+/**
+ * @brief Goodput table: airtime-bound goodput of every preset, LoRa and
+ *        GFSK, for a message of msg_len bytes, then (if count > 0) the
+ *        measured goodput of count messages to a peer on the running modem
+ *
+ * @return Measured goodput in bytes/s, 0 when nothing was measured
+ */
+uint32_t lora_link_benchmark(Print &out, size_t msg_len, uint8_t count);
+
+#endif // LORA_LINK_H
@@ -0,0 +1,524 @@
+/**
+ * @file      lora_mesh.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Flood-routing mesh: duplicate suppression, managed rebroadcast,
+ *            neighbour table and SD-backed store-and-forward
+ */
+
+#include "lora_mesh.h"
+#include "simple_logger.h"
+#include "lora_stats.h"
+#include "placement.h"
+#include <SD.h>
+#include "spi_bus.h"
+#include "fs_service.h"
+#include "sd_manager.h"
+#include <esp_timer.h>
+
+struct MeshSeen {
+    uint32_t from;
+    uint32_t id;
+    uint32_t relay_ticket;          // Our queued rebroadcast, 0 once aired or cancelled
+};
+
+struct MeshStoredPacket {
+    uint32_t to;
+    uint32_t stamp;                 // Store order, the oldest is replaced first
+    uint8_t used;
+    uint8_t len;
+    uint8_t data[LORA_PACKET_MAX];
+};
+
+static lora_mesh_recv_cb mesh_on_packet = nullptr;
+static volatile lora_mesh_tap_cb mesh_tap = nullptr;
+static uint32_t mesh_node_id = 0;
+static uint32_t mesh_packet_id = 0;
+static bool mesh_started = false;
+static LoraMeshStats mesh_stats;
+static TaskHandle_t mesh_task_handle = NULL;
+
+// Neighbours and the store-and-forward queue are shared with the mesh task
+// and senders; the LoRa task only holds the lock for short copies
+static portMUX_TYPE mesh_mux = portMUX_INITIALIZER_UNLOCKED;
+static LoraMeshNode mesh_nodes[LORA_MESH_NODES];
+static size_t mesh_node_count = 0;
+static PLACE_BULK MeshStoredPacket mesh_sf[LORA_MESH_SF_SLOTS];
+static uint32_t mesh_sf_dirty = 0;  // Records the mesh task still has to write
+static uint32_t mesh_sf_stamp = 0;
+static bool mesh_sf_replay = false; // A quiet node was heard again
+static bool mesh_sf_persist = false;
+
+// Duplicate suppression, LoRa task only
+static MeshSeen mesh_seen[LORA_MESH_SEEN_SIZE];
+static uint8_t mesh_seen_next = 0;
+
+static_assert(LORA_MESH_SF_SLOTS <= 32, "mesh_sf_dirty is a 32-bit mask");
+
+static void decode_header(const uint8_t *p, LoraMeshHeader *h) {
+    memcpy(&h->to, p, 4);
+    memcpy(&h->from, p + 4, 4);
+    memcpy(&h->id, p + 8, 4);
+    h->flags = p[12];
+    h->channel = p[13];
+    h->next_hop = p[14];
+    h->relay_node = p[15];
+}
+
+static void encode_header(uint8_t *p, const LoraMeshHeader *h) {
+    memcpy(p, &h->to, 4);
+    memcpy(p + 4, &h->from, 4);
+    memcpy(p + 8, &h->id, 4);
+    p[12] = h->flags;
+    p[13] = h->channel;
+    p[14] = h->next_hop;
+    p[15] = h->relay_node;
+}
+
+static MeshSeen *find_seen(uint32_t from, uint32_t id) {
+    for (int i = 0; i < LORA_MESH_SEEN_SIZE; i++) {
+        if (mesh_seen[i].id == id && mesh_seen[i].from == from) {
+            return &mesh_seen[i];
+        }
+    }
+    return nullptr;
+}
+
+static MeshSeen *remember(uint32_t from, uint32_t id) {
+    MeshSeen *seen = &mesh_seen[mesh_seen_next];
+    mesh_seen_next = (mesh_seen_next + 1) % LORA_MESH_SEEN_SIZE;
+    seen->from = from;
+    seen->id = id;
+    seen->relay_ticket = 0;
+    return seen;
+}
+
+// Called with mesh_mux held
+static bool node_fresh(uint32_t node, uint32_t now) {
+    for (size_t i = 0; i < mesh_node_count; i++) {
+        if (mesh_nodes[i].node == node) {
+            return now - mesh_nodes[i].last_heard < LORA_MESH_NODE_FRESH_MS;
+        }
+    }
+    return false;
+}
+
+static void heard(const LoraMeshHeader *h, const lora_packet_t *pkt) {
+    uint8_t hop_limit = h->flags & LORA_MESH_FLAG_HOP_LIMIT;
+    uint8_t hop_start = (h->flags & LORA_MESH_FLAG_HOP_START) >> LORA_MESH_HOP_START_SHIFT;
+    
+    portENTER_CRITICAL(&mesh_mux);
+    LoraMeshNode *node = nullptr;
+    for (size_t i = 0; i < mesh_node_count; i++) {
+        if (mesh_nodes[i].node == h->from) {
+            node = &mesh_nodes[i];
+            break;
+        }
+    }
+    
+    // New node: a free entry, else the one heard least recently
+    if (!node) {
+        if (mesh_node_count < LORA_MESH_NODES) {
+            node = &mesh_nodes[mesh_node_count++];
+        } else {
+            node = &mesh_nodes[0];
+            for (size_t i = 1; i < mesh_node_count; i++) {
+                if ((int32_t)(mesh_nodes[i].last_heard - node->last_heard) < 0) {
+                    node = &mesh_nodes[i];
+                }
+            }
+        }
+        node->node = h->from;
+        node->packets = 0;
+        node->last_heard = pkt->time_ms - LORA_MESH_NODE_FRESH_MS;
+    }
+    
+    if (pkt->time_ms - node->last_heard >= LORA_MESH_NODE_FRESH_MS) {
+        mesh_sf_replay = true;
+    }
+    node->last_heard = pkt->time_ms;
+    node->packets++;
+    node->snr = pkt->snr;
+    node->rssi = (int16_t)pkt->rssi;
+    // Firmware before hop_start was added leaves it 0
+    node->hops = hop_start >= hop_limit && hop_start ? hop_start - hop_limit : 0xFF;
+    bool direct = node->hops == 0;
+    portEXIT_CRITICAL(&mesh_mux);
+    
+    // A relayed packet's signal belongs to the relayer, not to the originator
+    if (direct) {
+        lora_stats_peer_rx(h->from, pkt);
+    }
+}
+
+// Keep a unicast until its destination is heard again
+static void sf_store(uint32_t to, const uint8_t *data, size_t len) {
+    portENTER_CRITICAL(&mesh_mux);
+    int slot = 0;
+    for (int i = 0; i < LORA_MESH_SF_SLOTS; i++) {
+        if (!mesh_sf[i].used) {
+            slot = i;
+            break;
+        }
+        if ((int32_t)(mesh_sf[i].stamp - mesh_sf[slot].stamp) < 0) {
+            slot = i;
+        }
+    }
+    
+    MeshStoredPacket *rec = &mesh_sf[slot];
+    rec->to = to;
+    rec->stamp = mesh_sf_stamp++;
+    rec->used = 1;
+    rec->len = len;
+    memcpy(rec->data, data, len);
+    mesh_sf_dirty |= 1UL << slot;
+    portEXIT_CRITICAL(&mesh_mux);
+    
+    mesh_stats.stored++;
+}
+
+// Contention slot of 2.5 symbols plus turnaround. Weak receptions pick from
+// a smaller window, so the relay that extends the range most airs first
+static uint32_t relay_delay_ms(float snr) {
+    const lora_profile_t *p = lora_get_profile();
+    float slot_ms = 2.5f * (1 << p->sf) / p->bw + 0.2f;
+    
+    int cw = LORA_MESH_CW_MIN + (int)((snr + 20.0f) * (LORA_MESH_CW_MAX - LORA_MESH_CW_MIN) / 30.0f);
+    if (cw < LORA_MESH_CW_MIN) {
+        cw = LORA_MESH_CW_MIN;
+    } else if (cw > LORA_MESH_CW_MAX) {
+        cw = LORA_MESH_CW_MAX;
+    }
+    return (uint32_t)(slot_ms * (esp_random() % (1UL << cw)));
+}
+
+static bool mesh_rx_hook(const lora_packet_t *pkt) {
+    if (pkt->len < LORA_MESH_HEADER_SIZE || pkt->data[13] != LORA_MESH_CHANNEL_HASH) {
+        return false;
+    }
+    
+    int64_t start = esp_timer_get_time();
+    LoraMeshHeader h;
+    decode_header(pkt->data, &h);
+    mesh_stats.received++;
+    
+    // Our own packet relayed back
+    if (h.from == mesh_node_id) {
+        mesh_stats.duplicates++;
+        return true;
+    }
+    heard(&h, pkt);
+    
+    bool deliver = false;
+    MeshSeen *seen = find_seen(h.from, h.id);
+    if (seen) {
+        // Someone else relayed it first, ours would add nothing
+        mesh_stats.duplicates++;
+        if (seen->relay_ticket && lora_tx_cancel(seen->relay_ticket)) {
+            mesh_stats.relays_cancelled++;
+        }
+        seen->relay_ticket = 0;
+    } else {
+        seen = remember(h.from, h.id);
+        deliver = h.to == mesh_node_id || h.to == LORA_MESH_BROADCAST;
+        lora_mesh_tap_cb tap = mesh_tap;
+        if (tap) {
+            tap(pkt);
+        }
+    
+        uint8_t hop_limit = h.flags & LORA_MESH_FLAG_HOP_LIMIT;
+        if (h.to == mesh_node_id) {
+            // Reached its destination
+        } else if (hop_limit == 0) {
+            mesh_stats.hop_limited++;
+        } else {
+            uint8_t frame[LORA_PACKET_MAX];
+            memcpy(frame, pkt->data, pkt->len);
+            frame[12] = (h.flags & ~LORA_MESH_FLAG_HOP_LIMIT) | (hop_limit - 1);
+            frame[15] = (uint8_t)mesh_node_id;
+    
+            seen->relay_ticket = lora_tx_submit(frame, pkt->len, LORA_TX_PRIO_NORMAL, 0, relay_delay_ms(pkt->snr));
+            if (seen->relay_ticket) {
+                mesh_stats.relayed++;
+            }
+    
+            bool fresh = true;
+            if (h.to != LORA_MESH_BROADCAST) {
+                portENTER_CRITICAL(&mesh_mux);
+                fresh = node_fresh(h.to, pkt->time_ms);
+                portEXIT_CRITICAL(&mesh_mux);
+            }
+            if (!fresh) {
+                sf_store(h.to, frame, pkt->len);
+            }
+        }
+    }
+    
+    uint32_t us = (uint32_t)(esp_timer_get_time() - start);
+    if (us > mesh_stats.max_decision_us) {
+        mesh_stats.max_decision_us = us;
+    }
+    
+    if (deliver) {
+        mesh_stats.delivered++;
+        if (mesh_on_packet) {
+            mesh_on_packet(&h, pkt->data + LORA_MESH_HEADER_SIZE, pkt->len - LORA_MESH_HEADER_SIZE);
+        }
+    }
+    return true;
+}
+
+static void sf_load() {
+    SpiBusHold bus(SPI_CLIENT_SD);
+    if (SD.cardType() == CARD_NONE || !(SD.exists("/mesh") || SD.mkdir("/mesh"))) {
+        LOG_WARN("LoRaMesh", "No SD card, store-and-forward kept in RAM only");
+        return;
+    }
+    mesh_sf_persist = true;
+    
+    File f = SD.open(LORA_MESH_SF_FILE, FILE_READ);
+    if (f && f.size() == sizeof(mesh_sf)) {
+        f.read((uint8_t *)mesh_sf, sizeof(mesh_sf));
+        f.close();
+    
+        size_t held = 0;
+        for (int i = 0; i < LORA_MESH_SF_SLOTS; i++) {
+            if (mesh_sf[i].used) {
+                held++;
+                if ((int32_t)(mesh_sf[i].stamp - mesh_sf_stamp) >= 0) {
+                    mesh_sf_stamp = mesh_sf[i].stamp + 1;
+                }
+            }
+        }
+        LOG_INFOF("LoRaMesh", "Loaded %u stored packets", (unsigned)held);
+        return;
+    }
+    if (f) {
+        f.close();
+    }
+    
+    // Missing or from another build: start empty at the fixed size
+    memset(mesh_sf, 0, sizeof(mesh_sf));
+    f = SD.open(LORA_MESH_SF_FILE, FILE_WRITE);
+    if (f) {
+        f.write((const uint8_t *)mesh_sf, sizeof(mesh_sf));
+        f.close();
+        fs_invalidate_usage();
+    }
+}
+
+// Rewrite changed records in place, one copy at a time outside the lock
+static void sf_flush() {
+    portENTER_CRITICAL(&mesh_mux);
+    uint32_t dirty = mesh_sf_dirty;
+    mesh_sf_dirty = 0;
+    portEXIT_CRITICAL(&mesh_mux);
+    
+    if (!dirty || !mesh_sf_persist) {
+        return;
+    }
+    
+    SpiBusHold bus(SPI_CLIENT_SD);
+    File f = SD.open(LORA_MESH_SF_FILE, "r+");
+    if (!f) {
+        LOG_WARN("LoRaMesh", "Failed to open the store-and-forward file");
+        return;
+    }
+    
+    MeshStoredPacket rec;
+    for (int i = 0; i < LORA_MESH_SF_SLOTS; i++) {
+        if (!(dirty & (1UL << i))) {
+            continue;
+        }
+        portENTER_CRITICAL(&mesh_mux);
+        rec = mesh_sf[i];
+        portEXIT_CRITICAL(&mesh_mux);
+    
+        f.seek(i * sizeof(rec));
+        f.write((const uint8_t *)&rec, sizeof(rec));
+    }
+    f.close();
+}
+
+// A card went in: RAM holds the current records, so all of them go to it
+static void sf_attach() {
+    {
+        SpiBusHold bus(SPI_CLIENT_SD);
+        if (!(SD.exists("/mesh") || SD.mkdir("/mesh"))) {
+            return;
+        }
+        File f = SD.open(LORA_MESH_SF_FILE, FILE_READ);
+        bool sized = f && f.size() == sizeof(mesh_sf);
+        if (f) {
+            f.close();
+        }
+        // "r+" needs the file at its fixed size
+        if (!sized) {
+            f = SD.open(LORA_MESH_SF_FILE, FILE_WRITE);
+            if (!f) {
+                return;
+            }
+            MeshStoredPacket empty;
+            memset(&empty, 0, sizeof(empty));
+            for (int i = 0; i < LORA_MESH_SF_SLOTS; i++) {
+                f.write((const uint8_t *)&empty, sizeof(empty));
+            }
+            f.close();
+            fs_invalidate_usage();
+        }
+    }
+    portENTER_CRITICAL(&mesh_mux);
+    mesh_sf_dirty = (uint32_t)((1ULL << LORA_MESH_SF_SLOTS) - 1);
+    mesh_sf_persist = true;
+    portEXIT_CRITICAL(&mesh_mux);
+}
+
+// Before an eject the changed records go out; after a removal the writes just stop
+static void sf_detach() {
+    sf_flush();
+    mesh_sf_persist = false;
+}
+
+// Stored packets whose destination is reachable again go back on air
+static void sf_replay() {
+    uint32_t now = millis();
+    MeshStoredPacket rec;
+    
+    for (int i = 0; i < LORA_MESH_SF_SLOTS; i++) {
+        portENTER_CRITICAL(&mesh_mux);
+        bool ready = mesh_sf[i].used && node_fresh(mesh_sf[i].to, now);
+        if (ready) {
+            rec = mesh_sf[i];
+            mesh_sf[i].used = 0;
+            mesh_sf_dirty |= 1UL << i;
+        }
+        portEXIT_CRITICAL(&mesh_mux);
+    
+        if (ready && lora_tx_submit(rec.data, rec.len, LORA_TX_PRIO_LOW, LORA_TX_RETRIES, 0)) {
+            mesh_stats.replayed++;
+        }
+    }
+}
+
+static void mesh_task(void *param) {
+    while (1) {
+        vTaskDelay(pdMS_TO_TICKS(LORA_MESH_TASK_PERIOD_MS));
+    
+        if (mesh_sf_replay) {
+            mesh_sf_replay = false;
+            sf_replay();
+        }
+        sf_flush();
+    }
+}
+
+bool lora_mesh_begin(lora_mesh_recv_cb on_packet) {
+    if (mesh_started) {
+        if (on_packet) {
+            mesh_on_packet = on_packet;
+        }
+        return true;
+    }
+    // Meshtastic node number: the last four bytes of the factory MAC
+    uint64_t mac = ESP.getEfuseMac();
+    mesh_node_id = 0;
+    for (int i = 2; i < 6; i++) {
+        mesh_node_id = (mesh_node_id << 8) | (uint8_t)(mac >> (8 * i));
+    }
+    mesh_packet_id = esp_random();
+    mesh_on_packet = on_packet;
+    
+    sf_load();
+    if (!lora_add_rx_hook(mesh_rx_hook)) {
+        LOG_ERROR("LoRaMesh", "No free LoRa RX hook");
+        return false;
+    }
+    if (mesh_task_handle == NULL) {
+        sd_manager_add_client("LoRaMesh", sf_attach, sf_detach);
+        xTaskCreate(mesh_task, "mesh_task", 1024 * 3, NULL, LORA_MESH_TASK_PRIORITY, &mesh_task_handle);
+    }
+    
+    // Relaying needs the receiver on
+    lora_set_mode(LORA_MODE_RECV);
+    mesh_started = true;
+    
+    LOG_INFOF("LoRaMesh", "Joined mesh as !%08lx", (unsigned long)mesh_node_id);
+    return true;
+}
+
+uint32_t lora_mesh_node_id() {
+    return mesh_node_id;
+}
+
+void lora_mesh_set_tap(lora_mesh_tap_cb tap) {
+    mesh_tap = tap;
+}
+
+struct MeshCopy {
+    const uint8_t *payload;
+    size_t len;
+};
+
+static size_t fill_copy(const LoraMeshHeader *h, uint8_t *payload, size_t cap, void *ctx) {
+    MeshCopy *c = (MeshCopy *)ctx;
+    memcpy(payload, c->payload, c->len);
+    return c->len;
+}
+
+bool lora_mesh_send(uint32_t to, const uint8_t *payload, size_t len) {
+    if (len > LORA_MESH_PAYLOAD_MAX) {
+        return false;
+    }
+    MeshCopy c = {payload, len};
+    return lora_mesh_send_fill(to, fill_copy, &c);
+}
+
+bool lora_mesh_send_fill(uint32_t to, lora_mesh_fill_cb fill, void *ctx) {
+    if (!mesh_started) {
+        return false;
+    }
+    
+    LoraMeshHeader h;
+    h.to = to;
+    h.from = mesh_node_id;
+    h.id = ++mesh_packet_id;
+    h.flags = LORA_MESH_HOP_LIMIT | (LORA_MESH_HOP_LIMIT << LORA_MESH_HOP_START_SHIFT);
+    h.channel = LORA_MESH_CHANNEL_HASH;
+    h.next_hop = 0;
+    h.relay_node = (uint8_t)mesh_node_id;
+    
+    uint8_t frame[LORA_PACKET_MAX];
+    encode_header(frame, &h);
+    size_t len = fill(&h, frame + LORA_MESH_HEADER_SIZE, LORA_MESH_PAYLOAD_MAX, ctx);
+    if (!len || len > LORA_MESH_PAYLOAD_MAX) {
+        return false;
+    }
+    size_t frame_len = LORA_MESH_HEADER_SIZE + len;
+    
+    bool ok = lora_tx_submit(frame, frame_len, LORA_TX_PRIO_NORMAL, LORA_TX_RETRIES, 0) != 0;
+    
+    bool fresh = true;
+    if (to != LORA_MESH_BROADCAST) {
+        portENTER_CRITICAL(&mesh_mux);
+        fresh = node_fresh(to, millis());
+        portEXIT_CRITICAL(&mesh_mux);
+    }
+    if (!fresh) {
+        sf_store(to, frame, frame_len);
+    }
+    return ok;
+}
+
+size_t lora_mesh_nodes(LoraMeshNode *out, size_t max) {
+    portENTER_CRITICAL(&mesh_mux);
+    size_t n = mesh_node_count < max ? mesh_node_count : max;
+    memcpy(out, mesh_nodes, n * sizeof(LoraMeshNode));
+    portEXIT_CRITICAL(&mesh_mux);
+    return n;
+}
+
+const LoraMeshStats *lora_mesh_stats() {
+    return &mesh_stats;
+}
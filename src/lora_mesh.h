@@ -0,0 +1,119 @@
+/**
+ * @file      lora_mesh.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Flood-routing LoRa mesh using the Meshtastic packet header
+ */
+
+#ifndef LORA_MESH_H
+#define LORA_MESH_H
+
+#include <Arduino.h>
+#include "peripheral.h"
+
+// Meshtastic radio header, little-endian on air
+#define LORA_MESH_HEADER_SIZE       16
+#define LORA_MESH_PAYLOAD_MAX       (LORA_PACKET_MAX - LORA_MESH_HEADER_SIZE)
+#define LORA_MESH_BROADCAST         0xFFFFFFFFUL
+#define LORA_MESH_FLAG_HOP_LIMIT    0x07
+#define LORA_MESH_FLAG_WANT_ACK     0x08
+#define LORA_MESH_FLAG_VIA_MQTT     0x10
+#define LORA_MESH_FLAG_HOP_START    0xE0
+#define LORA_MESH_HOP_START_SHIFT   5
+
+// Routing
+#define LORA_MESH_HOP_LIMIT         3     // Meshtastic default
+#define LORA_MESH_CHANNEL_HASH      0x08  // LongFast with the default key
+#define LORA_MESH_SEEN_SIZE         64    // Packet IDs remembered for duplicate suppression
+#define LORA_MESH_NODES             32    // Neighbour table entries
+#define LORA_MESH_CW_MIN            3     // Rebroadcast contention window, 2^CW slots,
+#define LORA_MESH_CW_MAX            8     // weak links relay first
+
+// Store-and-forward for unicasts to nodes that have gone quiet
+#define LORA_MESH_SF_SLOTS          16
+#define LORA_MESH_SF_FILE           "/mesh/sf.bin"
+#define LORA_MESH_NODE_FRESH_MS     600000  // Heard this recently counts as reachable
+#define LORA_MESH_TASK_PERIOD_MS    1000
+#define LORA_MESH_TASK_PRIORITY     (tskIDLE_PRIORITY + 1)  // SD writes stay below the radio
+
+struct LoraMeshHeader {
+    uint32_t to;
+    uint32_t from;
+    uint32_t id;
+    uint8_t flags;
+    uint8_t channel;
+    uint8_t next_hop;
+    uint8_t relay_node;             // Low byte of the last relayer's node ID
+};
+
+struct LoraMeshNode {
+    uint32_t node;
+    uint32_t last_heard;            // millis()
+    uint32_t packets;
+    float snr;
+    int16_t rssi;
+    uint8_t hops;                   // Hops away, 0 = neighbour, 0xFF = unknown
+};
+
+struct LoraMeshStats {
+    uint32_t received;
+    uint32_t delivered;             // Handed to the receive callback
+    uint32_t duplicates;
+    uint32_t relayed;
+    uint32_t relays_cancelled;      // Someone else relayed first
+    uint32_t hop_limited;
+    uint32_t stored;
+    uint32_t replayed;
+    uint32_t max_decision_us;       // Slowest RX-hook forwarding decision
+};
+
+/**
+ * @brief Packet for this node or a broadcast. The payload is passed through
+ *        as received; Meshtastic nodes send it encrypted. Runs on the LoRa task
+ */
+typedef void (*lora_mesh_recv_cb)(const LoraMeshHeader *header, const uint8_t *payload, size_t len);
+
+/**
+ * @brief Every packet heard for the first time, whatever its destination,
+ *        as received. Runs on the LoRa task ahead of the relay decision
+ */
+typedef void (*lora_mesh_tap_cb)(const lora_packet_t *pkt);
+
+/**
+ * @brief Writes the payload of an outgoing packet into the frame, after
+ *        the header it is sent with (its id and from are final)
+ * @return Payload length, 0 to send nothing
+ */
+typedef size_t (*lora_mesh_fill_cb)(const LoraMeshHeader *header, uint8_t *payload, size_t cap, void *ctx);
+
+/**
+ * @brief Join the mesh: claims every packet with the channel hash, loads the
+ *        store-and-forward queue from SD and starts the mesh task.
+ *        Call after lora_init(), normally on the "meshtastic" profile, and
+ *        after lora_link_begin() if both run, as the first hook to claim wins.
+ *        Once joined, a later call only sets on_packet, if given
+ */
+bool lora_mesh_begin(lora_mesh_recv_cb on_packet);
+uint32_t lora_mesh_node_id();         // 0 until lora_mesh_begin()
+void lora_mesh_set_tap(lora_mesh_tap_cb tap);
+
+/**
+ * @brief Flood a packet. Unicasts to a node not heard for
+ *        LORA_MESH_NODE_FRESH_MS are also kept for store-and-forward
+ */
+bool lora_mesh_send(uint32_t to, const uint8_t *payload, size_t len);
+
+/**
+ * @brief lora_mesh_send() with the payload written in place by fill
+ */
+bool lora_mesh_send_fill(uint32_t to, lora_mesh_fill_cb fill, void *ctx);
+
+/**
+ * @brief Copy of the neighbour table; returns the number of entries
+ */
+size_t lora_mesh_nodes(LoraMeshNode *out, size_t max);
+const LoraMeshStats *lora_mesh_stats();
+
+#endif // LORA_MESH_H
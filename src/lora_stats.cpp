@@ -0,0 +1,279 @@
+/**
+ * @file      lora_stats.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     LoRa link statistics implementation
+ */
+
+#include "lora_stats.h"
+#include "simple_logger.h"
+#include <math.h>
+#ifdef INTEGRATION_LAYER_ENABLED
+#include "integration/event_bridge.h"
+#include <freertos/timers.h>
+#endif
+
+#define STATS_EWMA_WEIGHT   0.125f
+
+static portMUX_TYPE stats_mux = portMUX_INITIALIZER_UNLOCKED;
+static uint16_t stats_rssi_hist[LORA_STATS_BUCKETS];
+static uint16_t stats_snr_hist[LORA_STATS_BUCKETS];
+static float stats_rssi_avg = 0;
+static float stats_snr_avg = 0;
+static bool stats_have_avg = false;
+static LoraStatsPeer stats_peers[LORA_STATS_PEERS];
+static size_t stats_peer_count = 0;
+static LoraStatsSample stats_ring[LORA_STATS_RING];
+static uint16_t stats_ring_head = 0;   // Next slot to write
+static uint16_t stats_ring_count = 0;
+
+static inline int bucket(float value, int min, int step) {
+    int b = (int)floorf((value - min) / step);
+    return b < 0 ? 0 : (b >= LORA_STATS_BUCKETS ? LORA_STATS_BUCKETS - 1 : b);
+}
+
+// Saturating, one stuck bucket must not wrap the shares
+static inline void count(uint16_t *hist, int b) {
+    if (hist[b] < UINT16_MAX) {
+        hist[b]++;
+    }
+}
+
+static inline float ewma(float avg, float value) {
+    return avg + (value - avg) * STATS_EWMA_WEIGHT;
+}
+
+void lora_stats_rx(const lora_packet_t *pkt) {
+    portENTER_CRITICAL(&stats_mux);
+    count(stats_rssi_hist, bucket(pkt->rssi, LORA_STATS_RSSI_MIN, LORA_STATS_RSSI_STEP));
+    count(stats_snr_hist, bucket(pkt->snr, LORA_STATS_SNR_MIN, LORA_STATS_SNR_STEP));
+    stats_rssi_avg = stats_have_avg ? ewma(stats_rssi_avg, pkt->rssi) : pkt->rssi;
+    stats_snr_avg = stats_have_avg ? ewma(stats_snr_avg, pkt->snr) : pkt->snr;
+    stats_have_avg = true;
+    
+    LoraStatsSample *s = &stats_ring[stats_ring_head];
+    s->time_ms = pkt->time_ms;
+    s->peer = 0;
+    s->rssi = (int16_t)pkt->rssi;
+    s->snr_q2 = (int8_t)(pkt->snr * 4);
+    s->len = pkt->len;
+    stats_ring_head = (stats_ring_head + 1) % LORA_STATS_RING;
+    if (stats_ring_count < LORA_STATS_RING) {
+        stats_ring_count++;
+    }
+    portEXIT_CRITICAL(&stats_mux);
+}
+
+// Called with stats_mux held
+static LoraStatsPeer *find_peer(uint32_t peer, uint32_t now) {
+    for (size_t i = 0; i < stats_peer_count; i++) {
+        if (stats_peers[i].peer == peer) {
+            return &stats_peers[i];
+        }
+    }
+    
+    LoraStatsPeer *p;
+    if (stats_peer_count < LORA_STATS_PEERS) {
+        p = &stats_peers[stats_peer_count++];
+    } else {
+        p = &stats_peers[0];
+        for (size_t i = 1; i < stats_peer_count; i++) {
+            if ((int32_t)(stats_peers[i].last_heard - p->last_heard) < 0) {
+                p = &stats_peers[i];
+            }
+        }
+    }
+    memset(p, 0, sizeof(*p));
+    p->peer = peer;
+    p->last_heard = now;
+    return p;
+}
+
+void lora_stats_peer_rx(uint32_t peer, const lora_packet_t *pkt) {
+    portENTER_CRITICAL(&stats_mux);
+    LoraStatsPeer *p = find_peer(peer, pkt->time_ms);
+    p->rssi_avg = p->rx ? ewma(p->rssi_avg, pkt->rssi) : pkt->rssi;
+    p->snr_avg = p->rx ? ewma(p->snr_avg, pkt->snr) : pkt->snr;
+    p->rx++;
+    p->last_heard = pkt->time_ms;
+    count(p->rssi_hist, bucket(pkt->rssi, LORA_STATS_RSSI_MIN, LORA_STATS_RSSI_STEP));
+    count(p->snr_hist, bucket(pkt->snr, LORA_STATS_SNR_MIN, LORA_STATS_SNR_STEP));
+    
+    // The packet lora_stats_rx() just sampled now has a sender
+    LoraStatsSample *s = &stats_ring[(stats_ring_head + LORA_STATS_RING - 1) % LORA_STATS_RING];
+    if (stats_ring_count && s->time_ms == pkt->time_ms && s->peer == 0) {
+        s->peer = peer;
+    }
+    portEXIT_CRITICAL(&stats_mux);
+}
+
+void lora_stats_peer_tx(uint32_t peer, uint32_t sent, uint32_t lost) {
+    portENTER_CRITICAL(&stats_mux);
+    LoraStatsPeer *p = find_peer(peer, millis());
+    p->tx += sent;
+    p->tx_lost += lost;
+    portEXIT_CRITICAL(&stats_mux);
+}
+
+void lora_stats_summary(LoraStatsSummary *out) {
+    lora_get_counters(&out->radio);
+    
+    uint32_t sent = 0;
+    uint32_t lost = 0;
+    portENTER_CRITICAL(&stats_mux);
+    memcpy(out->rssi_hist, stats_rssi_hist, sizeof(stats_rssi_hist));
+    memcpy(out->snr_hist, stats_snr_hist, sizeof(stats_snr_hist));
+    out->rssi_avg = stats_rssi_avg;
+    out->snr_avg = stats_snr_avg;
+    for (size_t i = 0; i < stats_peer_count; i++) {
+        sent += stats_peers[i].tx;
+        lost += stats_peers[i].tx_lost;
+    }
+    portEXIT_CRITICAL(&stats_mux);
+    
+    // Receive errors are lost packets we heard; unacknowledged sends the ones we did not
+    uint32_t bad = out->radio.rx_errors + lost;
+    uint32_t total = out->radio.rx_packets + out->radio.rx_errors + sent;
+    out->per_permille = total ? (uint16_t)((uint64_t)bad * 1000 / total) : 0;
+    out->airtime_permille = out->radio.airtime_budget_us ?
+        (uint16_t)((uint64_t)out->radio.airtime_window_us * 1000 / out->radio.airtime_budget_us) : 0;
+}
+
+size_t lora_stats_peers(LoraStatsPeer *out, size_t max) {
+    portENTER_CRITICAL(&stats_mux);
+    size_t n = stats_peer_count < max ? stats_peer_count : max;
+    memcpy(out, stats_peers, n * sizeof(LoraStatsPeer));
+    portEXIT_CRITICAL(&stats_mux);
+    return n;
+}
+
+size_t lora_stats_samples(LoraStatsSample *out, size_t max) {
+    portENTER_CRITICAL(&stats_mux);
+    size_t n = stats_ring_count < max ? stats_ring_count : max;
+    for (size_t i = 0; i < n; i++) {
+        out[i] = stats_ring[(stats_ring_head + LORA_STATS_RING - 1 - i) % LORA_STATS_RING];
+    }
+    portEXIT_CRITICAL(&stats_mux);
+    return n;
+}
+
+void lora_stats_format(char *buf, size_t len) {
+    LoraStatsSummary s;
+    lora_stats_summary(&s);
+    
+    if (!stats_have_avg) {
+        snprintf(buf, len, "No RX  Air%u.%u%%", s.airtime_permille / 10, s.airtime_permille % 10);
+        return;
+    }
+    snprintf(buf, len, "%ddBm %.1fdB PER%u%% Air%u.%u%%", (int)s.rssi_avg, s.snr_avg,
+             (s.per_permille + 5) / 10, s.airtime_permille / 10, s.airtime_permille % 10);
+}
+
+static inline uint8_t *put8(uint8_t *p, uint8_t v) { *p = v; return p + 1; }
+static inline uint8_t *put16(uint8_t *p, uint16_t v) { memcpy(p, &v, 2); return p + 2; }
+static inline uint8_t *put32(uint8_t *p, uint32_t v) { memcpy(p, &v, 4); return p + 4; }
+
+static inline int8_t clamp8(float v) {
+    return v < -128 ? -128 : (v > 127 ? 127 : (int8_t)v);
+}
+
+static inline uint16_t sat16(uint32_t v) {
+    return v > UINT16_MAX ? UINT16_MAX : (uint16_t)v;
+}
+
+static uint8_t *put_hist(uint8_t *p, const uint16_t *hist) {
+    uint32_t total = 0;
+    for (int i = 0; i < LORA_STATS_BUCKETS; i++) {
+        total += hist[i];
+    }
+    for (int i = 0; i < LORA_STATS_BUCKETS; i++) {
+        p = put8(p, total ? (uint8_t)(hist[i] * 255UL / total) : 0);
+    }
+    return p;
+}
+
+size_t lora_stats_frame(uint8_t *buf, size_t max) {
+    LoraStatsSummary s;
+    LoraStatsPeer peers[LORA_STATS_PEERS];
+    lora_stats_summary(&s);
+    size_t peer_count = lora_stats_peers(peers, LORA_STATS_PEERS);
+    
+    // Header, counters, radio setup and histograms are 86 bytes, peers 12 each
+    size_t fixed = 86;
+    if (max < fixed) {
+        return 0;
+    }
+    if (peer_count > (max - fixed) / 12) {
+        peer_count = (max - fixed) / 12;
+    }
+    
+    const lora_profile_t *profile = lora_get_profile();
+    uint8_t *p = buf;
+    p = put16(p, LORA_STATS_FRAME_MAGIC);
+    p = put8(p, LORA_STATS_FRAME_VERSION);
+    p = put8(p, peer_count);
+    p = put32(p, millis() / 1000);
+    
+    p = put32(p, s.radio.rx_packets);
+    p = put32(p, s.radio.rx_errors);
+    p = put32(p, s.radio.rx_dropped);
+    p = put32(p, s.radio.tx_sent);
+    p = put32(p, s.radio.tx_failed);
+    p = put32(p, s.radio.tx_retries);
+    p = put32(p, s.radio.tx_dropped);
+    p = put32(p, s.radio.lbt_busy);
+    p = put32(p, s.radio.airtime_window_us / 1000);
+    p = put32(p, s.radio.airtime_budget_us / 1000);
+    
+    p = put8(p, s.radio.tx_queued);
+    p = put8(p, s.radio.tx_queued_max);
+    p = put8(p, profile->sf);
+    p = put16(p, (uint16_t)profile->bw);
+    p = put8(p, (uint8_t)profile->power);
+    
+    p = put_hist(p, s.rssi_hist);
+    p = put_hist(p, s.snr_hist);
+    
+    for (size_t i = 0; i < peer_count; i++) {
+        p = put32(p, peers[i].peer);
+        p = put16(p, sat16(peers[i].rx));
+        p = put16(p, sat16(peers[i].tx));
+        p = put16(p, sat16(peers[i].tx_lost));
+        p = put8(p, (uint8_t)clamp8(peers[i].rssi_avg));
+        p = put8(p, (uint8_t)clamp8(peers[i].snr_avg * 4));
+    }
+    return p - buf;
+}
+
+#ifdef INTEGRATION_LAYER_ENABLED
+static TimerHandle_t stats_timer = NULL;
+
+static void stats_publish(TimerHandle_t timer) {
+    if (!GlobalEventBridge) {
+        return;
+    }
+    
+    LoraTelemetryEvent ev;
+    ev.len = lora_stats_frame(ev.frame, sizeof(ev.frame));
+    GlobalEventBridge->publishTypedEvent(EventType::LORA_TELEMETRY, "LoRa", ev, EventPriority::EVENT_LOW);
+}
+#endif
+
+bool lora_stats_begin(uint32_t period_ms) {
+#ifdef INTEGRATION_LAYER_ENABLED
+    if (stats_timer == NULL) {
+        stats_timer = xTimerCreate("lora_stats", pdMS_TO_TICKS(period_ms), pdTRUE, NULL, stats_publish);
+        if (stats_timer == NULL) {
+            LOG_ERROR("LoRaStats", "Failed to create the telemetry timer");
+            return false;
+        }
+    } else {
+        xTimerChangePeriod(stats_timer, pdMS_TO_TICKS(period_ms), 0);
+    }
+    return xTimerStart(stats_timer, 0) == pdPASS;
+#else
+    return false;
+#endif
+}
@@ -0,0 +1,95 @@
+/**
+ * @file      lora_stats.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     LoRa link statistics: signal histograms, per-peer loss, airtime and telemetry frames
+ */
+
+#ifndef LORA_STATS_H
+#define LORA_STATS_H
+
+#include <Arduino.h>
+#include "peripheral.h"
+
+// Histograms, fixed buckets
+#define LORA_STATS_BUCKETS          16
+#define LORA_STATS_RSSI_MIN         -140  // dBm, bucket 0 starts here
+#define LORA_STATS_RSSI_STEP        8
+#define LORA_STATS_SNR_MIN          -20   // dB
+#define LORA_STATS_SNR_STEP         2
+
+// Tables
+#define LORA_STATS_PEERS            8     // Least recently heard peer is replaced
+#define LORA_STATS_RING             64    // Most recent packets kept as samples
+
+// Telemetry
+#define LORA_STATS_FRAME_MAGIC      0x544C  // "LT"
+#define LORA_STATS_FRAME_VERSION    1
+#define LORA_STATS_FRAME_MAX        224
+#define LORA_STATS_PUBLISH_MS       60000
+
+struct LoraStatsSample {
+    uint32_t time_ms;
+    uint32_t peer;                  // 0 until a link layer names the sender
+    int16_t rssi;                   // dBm
+    int8_t snr_q2;                  // dB * 4, as the radio reports it
+    uint8_t len;
+};
+
+struct LoraStatsPeer {
+    uint32_t peer;
+    uint32_t last_heard;
+    uint32_t rx;
+    uint32_t tx;                    // Packets sent to the peer that expected an answer
+    uint32_t tx_lost;               // Of those, never acknowledged
+    float rssi_avg;
+    float snr_avg;
+    uint16_t rssi_hist[LORA_STATS_BUCKETS];
+    uint16_t snr_hist[LORA_STATS_BUCKETS];
+};
+
+struct LoraStatsSummary {
+    lora_counters_t radio;
+    uint16_t rssi_hist[LORA_STATS_BUCKETS];
+    uint16_t snr_hist[LORA_STATS_BUCKETS];
+    float rssi_avg;
+    float snr_avg;
+    uint16_t per_permille;          // Failed receptions plus unacknowledged sends
+    uint16_t airtime_permille;      // Of the duty-cycle budget
+};
+
+struct LoraTelemetryEvent {
+    uint8_t len;
+    uint8_t frame[LORA_STATS_FRAME_MAX];
+};
+
+// Fed by the radio (every packet) and the link layers (per peer)
+void lora_stats_rx(const lora_packet_t *pkt);
+void lora_stats_peer_rx(uint32_t peer, const lora_packet_t *pkt);
+void lora_stats_peer_tx(uint32_t peer, uint32_t sent, uint32_t lost);
+
+void lora_stats_summary(LoraStatsSummary *out);
+size_t lora_stats_peers(LoraStatsPeer *out, size_t max);
+size_t lora_stats_samples(LoraStatsSample *out, size_t max);  // Newest first
+
+/**
+ * @brief One line for the LoRa screen: average RSSI/SNR, PER and airtime
+ */
+void lora_stats_format(char *buf, size_t len);
+
+/**
+ * @brief Binary telemetry frame, little-endian, version LORA_STATS_FRAME_VERSION:
+ *        magic, version, peer count, uptime s, radio counters, airtime ms used
+ *        and budget, queue depth, SF/BW/power, both histograms as 8-bit
+ *        shares of 255, then 12 bytes per peer. Returns its size
+ */
+size_t lora_stats_frame(uint8_t *buf, size_t max);
+
+/**
+ * @brief Publish the frame on the EventBridge as LORA_TELEMETRY every period_ms
+ */
+bool lora_stats_begin(uint32_t period_ms = LORA_STATS_PUBLISH_MS);
+
+#endif // LORA_STATS_H
@@ -0,0 +1,255 @@
+/**
+ * @file      lvgl_draw_1bpp.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Packed 1bpp blend stage for the LVGL software renderer
+ */
+
+#include "lvgl_draw_1bpp.h"
+#include "placement.h"
+
+#if LV_COLOR_DEPTH != 1
+#error "lvgl_draw_1bpp packs lv_color_t bit 0, LV_COLOR_DEPTH must be 1"
+#endif
+
+// Gather bit 0 of four pixel bytes in address order into the low nibble
+static inline uint8_t pack_nibble(uint32_t pixels) {
+    return (uint8_t)(((pixels & 0x01010101UL) * 0x08040201UL) >> 24);
+}
+
+static inline void put_px(uint8_t* row, int32_t x, bool white) {
+    uint8_t bit = 0x80 >> (x & 7);
+    row[x >> 3] = white ? (row[x >> 3] | bit) : (row[x >> 3] & ~bit);
+}
+
+// Solid span: partial edge bytes, memset (word stores) for the middle
+static void PLACE_HOT fill_span(uint8_t* row, int32_t x1, int32_t x2, bool white) {
+    int32_t b1 = x1 >> 3;
+    int32_t b2 = x2 >> 3;
+    uint8_t m1 = 0xFF >> (x1 & 7);
+    uint8_t m2 = (uint8_t)(0xFF << (7 - (x2 & 7)));
+    
+    if (b1 == b2) {
+        uint8_t m = m1 & m2;
+        row[b1] = white ? (row[b1] | m) : (row[b1] & ~m);
+        return;
+    }
+    
+    row[b1] = white ? (row[b1] | m1) : (row[b1] & ~m1);
+    if (b2 > b1 + 1) {
+        memset(row + b1 + 1, white ? 0xFF : 0x00, b2 - b1 - 1);
+    }
+    row[b2] = white ? (row[b2] | m2) : (row[b2] & ~m2);
+}
+
+// Unmasked image span, eight source pixels per destination byte
+static void PLACE_HOT map_span(uint8_t* row, int32_t x1, int32_t x2, const lv_color_t* src) {
+    const uint8_t* s = (const uint8_t*)src;
+    int32_t x = x1;
+    
+    while ((x & 7) && x <= x2) {
+        put_px(row, x++, *s++ & 1);
+    }
+    while (x + 7 <= x2) {
+        uint32_t lo, hi;
+        memcpy(&lo, s, sizeof(lo));
+        memcpy(&hi, s + 4, sizeof(hi));
+        row[x >> 3] = (uint8_t)((pack_nibble(lo) << 4) | pack_nibble(hi));
+        s += 8;
+        x += 8;
+    }
+    while (x <= x2) {
+        put_px(row, x++, *s++ & 1);
+    }
+}
+
+// Masked and/or translucent span. At 1bpp lv_color_mix() returns the
+// foreground above 50% opacity and the background otherwise, so each pixel
+// either takes the source value or is left alone.
+static void PLACE_HOT blend_span(uint8_t* row, int32_t x1, int32_t x2, const lv_color_t* src,
+                       bool white, const lv_opa_t* mask, lv_opa_t opa) {
+    uint8_t set = 0;
+    uint8_t val = 0;
+    int32_t x = x1;
+    
+    while (x <= x2) {
+        // Glyph masks are mostly empty or solid; take those a byte at a time
+        if (mask && !src && opa >= LV_OPA_MAX && (x & 7) == 0 && x + 7 <= x2) {
+            uint32_t lo, hi;
+            memcpy(&lo, mask, sizeof(lo));
+            memcpy(&hi, mask + 4, sizeof(hi));
+            if ((lo | hi) == 0) {
+                mask += 8;
+                x += 8;
+                continue;
+            }
+            if ((lo & hi) == 0xFFFFFFFFUL) {
+                row[x >> 3] = white ? 0xFF : 0x00;
+                mask += 8;
+                x += 8;
+                continue;
+            }
+        }
+    
+        lv_opa_t a;
+        if (!mask) {
+            a = opa;
+        } else if (opa >= LV_OPA_MAX) {
+            a = *mask++;
+        } else {
+            a = (lv_opa_t)(((uint16_t)*mask++ * opa) >> 8);
+        }
+    
+        if (a > LV_OPA_50) {
+            uint8_t bit = 0x80 >> (x & 7);
+            set |= bit;
+            if (src ? (src->full & 1) : white) {
+                val |= bit;
+            }
+        }
+        if (src) {
+            src++;
+        }
+    
+        if ((x & 7) == 7 || x == x2) {
+            if (set) {
+                row[x >> 3] = (row[x >> 3] & ~set) | val;
+            }
+            set = val = 0;
+        }
+        x++;
+    }
+}
+
+static void blend_1bpp(lv_draw_ctx_t* draw_ctx, const lv_draw_sw_blend_dsc_t* dsc) {
+    LVGLDraw1bppCtx* ctx = (LVGLDraw1bppCtx*)draw_ctx;
+    
+    // Layers, snapshots and unbound contexts keep the lv_color_t buffer
+    if (!ctx->fb || !ctx->draw_buf || draw_ctx->buf != ctx->draw_buf->buf_act) {
+        lv_draw_sw_blend_basic(draw_ctx, dsc);
+        return;
+    }
+    
+    const lv_opa_t* mask = dsc->mask_buf;
+    if (mask && dsc->mask_res == LV_DRAW_MASK_RES_TRANSP) {
+        return;
+    }
+    if (dsc->mask_res == LV_DRAW_MASK_RES_FULL_COVER) {
+        mask = nullptr;
+    }
+    if (!mask && dsc->opa <= LV_OPA_50) {
+        return;
+    }
+    
+    lv_area_t area;
+    if (!_lv_area_intersect(&area, dsc->blend_area, draw_ctx->clip_area)) {
+        return;
+    }
+    area.x1 = LV_MAX(area.x1, 0);
+    area.y1 = LV_MAX(area.y1, 0);
+    area.x2 = LV_MIN(area.x2, ctx->width - 1);
+    area.y2 = LV_MIN(area.y2, ctx->height - 1);
+    if (area.x1 > area.x2 || area.y1 > area.y2) {
+        return;
+    }
+    
+    const lv_color_t* src = dsc->src_buf;
+    lv_coord_t src_stride = 0;
+    if (src) {
+        src_stride = lv_area_get_width(dsc->blend_area);
+        src += src_stride * (area.y1 - dsc->blend_area->y1) + (area.x1 - dsc->blend_area->x1);
+    }
+    
+    lv_coord_t mask_stride = 0;
+    if (mask) {
+        mask_stride = lv_area_get_width(dsc->mask_area);
+        mask += mask_stride * (area.y1 - dsc->mask_area->y1) + (area.x1 - dsc->mask_area->x1);
+    }
+    
+    bool white = dsc->color.full & 1;
+    bool solid = !mask && dsc->opa >= LV_OPA_MAX;
+    uint8_t* row = ctx->fb + area.y1 * ctx->stride;
+    
+    for (lv_coord_t y = area.y1; y <= area.y2; y++) {
+        if (!src && !mask) {
+            fill_span(row, area.x1, area.x2, white);  // opa above 50% is a plain fill at 1bpp
+        } else if (src && solid) {
+            map_span(row, area.x1, area.x2, src);
+        } else {
+            blend_span(row, area.x1, area.x2, src, white, mask, dsc->opa);
+        }
+        row += ctx->stride;
+        src += src_stride;
+        mask += mask_stride;
+    }
+}
+
+void lvgl_draw_1bpp_ctx_init(lv_disp_drv_t* drv, lv_draw_ctx_t* draw_ctx) {
+    lv_draw_sw_init_ctx(drv, draw_ctx);
+    
+    LVGLDraw1bppCtx* ctx = (LVGLDraw1bppCtx*)draw_ctx;
+    ctx->base_draw.blend = blend_1bpp;
+    ctx->fb = nullptr;
+    ctx->stride = 0;
+    ctx->width = 0;
+    ctx->height = 0;
+    ctx->draw_buf = nullptr;
+}
+
+void lvgl_draw_1bpp_ctx_deinit(lv_disp_drv_t* drv, lv_draw_ctx_t* draw_ctx) {
+    lv_draw_sw_deinit_ctx(drv, draw_ctx);
+    
+    LVGLDraw1bppCtx* ctx = (LVGLDraw1bppCtx*)draw_ctx;
+    ctx->fb = nullptr;
+    ctx->draw_buf = nullptr;
+}
+
+void lvgl_draw_1bpp_set_target(lv_disp_t* disp, uint8_t* fb, uint16_t stride) {
+    if (!disp || disp->driver->draw_ctx_init != lvgl_draw_1bpp_ctx_init) {
+        return;
+    }
+    
+    LVGLDraw1bppCtx* ctx = (LVGLDraw1bppCtx*)disp->driver->draw_ctx;
+    ctx->fb = fb;
+    ctx->stride = stride;
+    // Rotated displays draw in their turned geometry
+    ctx->width = lv_disp_get_hor_res(disp);
+    ctx->height = lv_disp_get_ver_res(disp);
+    ctx->draw_buf = disp->driver->draw_buf;
+}
+
+bool lvgl_draw_1bpp_blit(lv_draw_ctx_t* draw_ctx, const uint8_t* bitmap, lv_coord_t x, lv_coord_t y,
+                         lv_coord_t w, lv_coord_t h, lv_color_t color) {
+    lv_disp_t* disp = _lv_refr_get_disp_refreshing();
+    if (!disp || disp->driver->draw_ctx != draw_ctx || disp->driver->draw_ctx_init != lvgl_draw_1bpp_ctx_init) {
+        return false;
+    }
+    LVGLDraw1bppCtx* ctx = (LVGLDraw1bppCtx*)draw_ctx;
+    if (!ctx->fb || !ctx->draw_buf || draw_ctx->buf != ctx->draw_buf->buf_act) {
+        return false;
+    }
+    
+    lv_area_t box = { x, y, (lv_coord_t)(x + w - 1), (lv_coord_t)(y + h - 1) };
+    lv_area_t area;
+    if (!_lv_area_intersect(&area, &box, draw_ctx->clip_area)) {
+        return true;
+    }
+    area.x1 = LV_MAX(area.x1, 0);
+    area.y1 = LV_MAX(area.y1, 0);
+    area.x2 = LV_MIN(area.x2, ctx->width - 1);
+    area.y2 = LV_MIN(area.y2, ctx->height - 1);
+    
+    bool white = color.full & 1;
+    for (lv_coord_t py = area.y1; py <= area.y2; py++) {
+        uint8_t* row = ctx->fb + py * ctx->stride;
+        uint32_t bit = (uint32_t)(py - y) * w + (area.x1 - x);
+        for (lv_coord_t px = area.x1; px <= area.x2; px++, bit++) {
+            if (bitmap[bit >> 3] & (0x80 >> (bit & 7))) {
+                put_px(row, px, white);
+            }
+        }
+    }
+    return true;
+}
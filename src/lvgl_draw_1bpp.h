@@ -0,0 +1,66 @@
+/**
+ * @file      lvgl_draw_1bpp.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     LVGL draw context that blends straight into the packed 1bpp framebuffer
+ */
+
+#ifndef LVGL_DRAW_1BPP_H
+#define LVGL_DRAW_1BPP_H
+
+#include <Arduino.h>
+#include <lvgl.h>
+#include <src/draw/sw/lv_draw_sw.h>
+
+/**
+ * Software draw context whose blend step writes bits into the packed
+ * framebuffer instead of one lv_color_t per pixel into the render band.
+ *
+ * Every LVGL software primitive (fills, borders, lines, arcs, glyphs and
+ * images) ends in a blend call, so the rasterisers are reused unchanged and
+ * only the last stage is replaced. Layers (opacity, transforms) render into
+ * their own lv_color_t buffers through the stock blender and reach the
+ * framebuffer when the layer itself is blended.
+ */
+struct LVGLDraw1bppCtx {
+    lv_draw_sw_ctx_t base_draw;     // Must stay first, LVGL casts to it
+    uint8_t* fb;                    // Packed target, MSB first, 1 = white
+    uint16_t stride;                // Bytes per framebuffer row
+    lv_coord_t width;
+    lv_coord_t height;
+    const lv_disp_draw_buf_t* draw_buf;  // Only blends aimed at its buf_act are redirected
+};
+
+/**
+ * @brief lv_disp_drv_t::draw_ctx_init, use with draw_ctx_size = sizeof(LVGLDraw1bppCtx)
+ */
+void lvgl_draw_1bpp_ctx_init(lv_disp_drv_t* drv, lv_draw_ctx_t* draw_ctx);
+
+/**
+ * @brief lv_disp_drv_t::draw_ctx_deinit
+ */
+void lvgl_draw_1bpp_ctx_deinit(lv_disp_drv_t* drv, lv_draw_ctx_t* draw_ctx);
+
+/**
+ * @brief Point a registered display's draw context at its packed framebuffer.
+ *
+ * Until this is called (or with fb == nullptr) the context behaves exactly
+ * like lv_draw_sw and the flush callback has to pack the band itself.
+ */
+void lvgl_draw_1bpp_set_target(lv_disp_t* disp, uint8_t* fb, uint16_t stride);
+
+/**
+ * @brief Copy a packed 1bpp bitmap (rows not padded, as the glyph cache
+ *        keeps glyphs) straight into the framebuffer, set bits in color
+ *
+ * For widgets that draw many small bitmaps from their DRAW_MAIN handler,
+ * such as terminal cells. Clipped to the context's clip area.
+ * @return false when draw_ctx is not drawing into a packed framebuffer;
+ *         the caller then goes through lv_draw_letter or the like
+ */
+bool lvgl_draw_1bpp_blit(lv_draw_ctx_t* draw_ctx, const uint8_t* bitmap, lv_coord_t x, lv_coord_t y,
+                         lv_coord_t w, lv_coord_t h, lv_color_t color);
+
+#endif // LVGL_DRAW_1BPP_H
@@ -9,22 +9,165 @@
 
 #include "lvgl_integration.h"
 #include "simple_logger.h"
+#include "lvgl_mem.h"
+#include "glyph_cache.h"
+#include "img_1bpp_decoder.h"
+#include "lvgl_draw_1bpp.h"
+#include "lvgl_layers.h"
+#include "simple_power.h"
+#include "power_governor.h"
+#include "energy_profiler.h"
+#include "ui_scr_mrg.h"
+#include "ui_anim_policy.h"
+#include "ui_theme.h"
+#include "fb_rotate.h"
+#include "i2c_bus.h"
+#include "spi_bus.h"
+#include "keymap.h"
+#include "task_arena.h"
+#include "placement.h"
+#include "task_watch.h"
+#include "screen_mirror.h"
+#include "event_replay.h"
+#include "usb_console.h"
+#include <esp_heap_caps.h>
+#include <soc/soc_memory_layout.h>
+
+// The flush engine reads the LVGL buffer as one byte per pixel
+static_assert(sizeof(lv_color_t) == 1, "LVGLIntegration expects LV_COLOR_DEPTH 1");
+
+// Gather the low bit of four colour bytes into a nibble, first pixel in the high bit
+static inline uint8_t pack_nibble(uint32_t pixels) {
+    return (uint8_t)(((pixels & 0x01010101UL) * 0x08040201UL) >> 24);
+}
+
+// Band buffers are rewritten every frame; keep them in internal RAM when it fits
+static void* alloc_band(size_t bytes) {
+#if LVGL_BAND_IN_SRAM
+    void* buf = heap_caps_malloc(bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (buf) {
+        return buf;
+    }
+    LOG_WARN("LVGL", "No internal RAM for render band, using PSRAM");
+#endif
+    return ps_malloc(bytes);
+}
+
+// Compare a span of packed pixels a word at a time; rows are not word-aligned
+static inline bool span_equal(const uint8_t* a, const uint8_t* b, int32_t len) {
+    while (len >= 4) {
+        uint32_t wa, wb;
+        memcpy(&wa, a, sizeof(wa));
+        memcpy(&wb, b, sizeof(wb));
+        if (wa != wb) {
+            return false;
+        }
+        a += 4;
+        b += 4;
+        len -= 4;
+    }
+    while (len-- > 0) {
+        if (*a++ != *b++) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Snapshot cache hooks for ui_scr_mrg
+static const scr_snapshot_ops_t snapshot_ops = {
+    LVGL_FB_SIZE,
+    LVGLIntegration::snapshot_save_cb,
+    LVGLIntegration::snapshot_show_cb
+};
+
+// Per-screen accounting from ui_scr_mrg as CSV, one line per registered
+// screen; "screens reset" clears it
+static void rpc_screens(Print& out, const char* args) {
+    static int ids[LVGL_SCREEN_STATS_MAX];
+    static scr_stats_t stats[LVGL_SCREEN_STATS_MAX];
+    if (!strcmp(args, "reset")) {
+        scr_mgr_reset_stats();
+        out.println("ok");
+        return;
+    }
+    if (args[0]) {
+        out.println("usage: screens [reset]");
+        return;
+    }
+    int n = scr_mgr_get_stats(ids, stats, LVGL_SCREEN_STATS_MAX);
+    out.println("id,visits,creates,create_us,create_max_us,entry_us,entry_max_us,mem_delta,objects,"
+                "refreshes,first_flush_ms,first_flush_max_ms,active_s");
+    for (int i = 0; i < n; i++) {
+        const scr_stats_t& st = stats[i];
+        out.printf("%d,%lu,%lu,%lu,%lu,%lu,%lu,%ld,%u,%lu,%lu,%lu,%lu\n", ids[i],
+                   (unsigned long)st.visits, (unsigned long)st.creates,
+                   (unsigned long)st.create_us, (unsigned long)st.create_max_us,
+                   (unsigned long)st.entry_us, (unsigned long)st.entry_max_us,
+                   (long)st.mem_delta, st.objects, (unsigned long)st.refreshes,
+                   (unsigned long)st.first_flush_ms, (unsigned long)st.first_flush_max_ms,
+                   (unsigned long)(st.active_ms / 1000));
+    }
+}
 
 // Static instance
 LVGLIntegration* LVGLIntegration::instance = nullptr;
 LVGLIntegration* LVGL = nullptr;
+SemaphoreHandle_t LVGLIntegration::busy_semaphore = nullptr;
+volatile bool LVGLIntegration::touch_irq = false;
+volatile uint32_t LVGLIntegration::touch_irq_us = 0;
 
 LVGLIntegration::LVGLIntegration() {
     display = nullptr;
     touch_indev = nullptr;
+    keypad_indev = nullptr;
+    keypad_group = nullptr;
     buf1 = nullptr;
     buf2 = nullptr;
+    framebuffer = nullptr;
+    front_buffer = nullptr;
+    rotation = LV_DISP_ROT_NONE;
+    fb_width = LVGL_DISPLAY_WIDTH;
+    fb_height = LVGL_DISPLAY_HEIGHT;
+    fb_stride = LVGL_FB_STRIDE;
+    sent_buffer = nullptr;
+    rotated_sent = nullptr;
+    last_rotate_us = 0;
     epd_display = nullptr;
     touch_controller = nullptr;
     initialized = false;
     display_needs_refresh = false;
     last_refresh_time = 0;
     refresh_interval_ms = 5000; // 5 seconds default for e-paper
+    clean_idle_ms = REFRESH_CLEAN_IDLE_MS;
+    frames_flushed = 0;
+    frame_pack_us = 0;
+    last_pack_us = 0;
+    last_commit_us = 0;
+    total_pack_us = 0;
+    total_commit_us = 0;
+    dirty_count = 0;
+    full_refresh_pending = true; // First frame clears the panel completely
+    last_screen = nullptr;
+    partial_updates = 0;
+    full_updates = 0;
+    flush_task = nullptr;
+    flush_busy = false;
+    frame_deferred = false;
+    blanked = false;
+    diff_tiles_unchanged = 0;
+    diff_tiles_changed = 0;
+    frames_skipped = 0;
+    panel_early_ons = 0;
+    panel_idle_offs = 0;
+    snapshot_restore = false;
+    panel_kept = false;
+    ui_task = nullptr;
+    next_work_time = 0;
+    render_lock = -1;
+    render_boost = false;
+    remote_touch = false;
+    memset(&touch_tag, 0, sizeof(touch_tag));
 }
 
 LVGLIntegration* LVGLIntegration::getInstance() {
@@ -47,8 +190,13 @@ bool LVGLIntegration::init(GxEPD2_BW<GxEPD2_310_GDEQ031T10, GxEPD2_310_GDEQ031T1
     epd_display = display_ptr;
     touch_controller = touch_ptr;
     
+    // Nothing between updates resets the controller, so its setting and RAM
+    // stay valid and a partial update starts with the refresh itself
+    epd_display->epd2.setKeepInit(true);
+    
     // Initialize LVGL
     lv_init();
+    img_1bpp_decoder_init();
     
     // Initialize display
     if (!initDisplay()) {
@@ -62,9 +210,34 @@ bool LVGLIntegration::init(GxEPD2_BW<GxEPD2_310_GDEQ031T10, GxEPD2_310_GDEQ031T1
         return false;
     }
     
+    // Keys are optional: without the TCA8418 the queue just stays empty
+    initKeypad();
+    
     // Setup monochrome theme
     setupMonochromeTheme();
     
+    // Rasterize the menu fonts once so the first screens draw from the glyph cache
+    if (glyph_cache_init()) {
+        glyph_cache_prewarm(&Font_Mono_Bold_14_cached, 0x20, 0x7E);
+        glyph_cache_prewarm(&Font_Mono_Bold_15_cached, 0x20, 0x7E);
+        glyph_cache_prewarm(&Font_Mono_Bold_16_cached, 0x20, 0x7E);
+    }
+    
+    // Let the screen manager cache rendered screens
+    scr_mgr_set_snapshot_ops(&snapshot_ops);
+    scr_mgr_set_mem_probe(lvgl_mem_used);
+    usb_console_rpc("screens", rpc_screens);
+    
+    // Every animation step would be another panel update
+    ui_anim_policy_set(LVGL_ANIM_POLICY);
+    
+    if (render_lock < 0) {
+        render_lock = power_governor_lock_create("lvgl_render");
+    }
+    
+    // Scratch for UI timers and event handlers, given back after every pass
+    task_arena_create(TASK_ARENA_FRAME_INTERNAL, TASK_ARENA_FRAME_PSRAM);
+    
     initialized = true;
     LOG_INFO("LVGL", "LVGL integration initialized successfully");
     return true;
@@ -75,13 +248,39 @@ bool LVGLIntegration::initDisplay() {
     
     // Allocate display buffers
     size_t buffer_size = LVGL_BUFFER_SIZE;
-    buf1 = (lv_color_t*)ps_malloc(buffer_size * sizeof(lv_color_t));
-    buf2 = (lv_color_t*)ps_malloc(buffer_size * sizeof(lv_color_t));
+    buf1 = (lv_color_t*)alloc_band(buffer_size * sizeof(lv_color_t));
+#if LVGL_DRAW_DIRECT_1BPP
+    // Rendering goes to the framebuffer and the flush is synchronous, so a
+    // second band buffer would never be used
+    buf2 = nullptr;
+    if (!buf1) {
+#else
+    buf2 = (lv_color_t*)alloc_band(buffer_size * sizeof(lv_color_t));
     
     if (!buf1 || !buf2) {
+#endif
         LOG_ERROR("LVGL", "Failed to allocate display buffers");
         return false;
     }
+    LOG_INFOF("LVGL", "Render band: %d rows, %u bytes in %s", LVGL_BAND_ROWS,
+              (unsigned)(buffer_size * sizeof(lv_color_t)),
+              esp_ptr_internal(buf1) ? "SRAM" : "PSRAM");
+    
+    // Allocate the packed framebuffers, starting white like the panel
+    framebuffer = (uint8_t*)ps_malloc(LVGL_FB_SIZE);
+    front_buffer = (uint8_t*)ps_malloc(LVGL_FB_SIZE);
+    if (!framebuffer || !front_buffer) {
+        LOG_ERROR("LVGL", "Failed to allocate packed framebuffers");
+        return false;
+    }
+    memset(framebuffer, 0xFF, LVGL_FB_SIZE);
+    memset(front_buffer, 0xFF, LVGL_FB_SIZE);
+    sent_buffer = front_buffer;
+    
+    // Panel I/O runs on the other core; fall back to inline flushing without it
+    if (!startFlushTask()) {
+        LOG_WARN("LVGL", "Flush task unavailable, panel updates will block LVGL");
+    }
     
     // Initialize display buffer
     lv_disp_draw_buf_init(&draw_buf, buf1, buf2, buffer_size);
@@ -93,8 +292,15 @@ bool LVGLIntegration::initDisplay() {
     disp_drv.hor_res = LVGL_DISPLAY_WIDTH;
     disp_drv.ver_res = LVGL_DISPLAY_HEIGHT;
     disp_drv.flush_cb = display_flush_cb;
+    disp_drv.rounder_cb = rounder_cb;
+    disp_drv.render_start_cb = render_start_cb;
     disp_drv.draw_buf = &draw_buf;
-    disp_drv.full_refresh = 1; // E-paper needs full refresh for proper rendering
+    disp_drv.full_refresh = 0; // Only invalidated areas are rendered; the scheduler decides panel updates
+#if LVGL_DRAW_DIRECT_1BPP
+    disp_drv.draw_ctx_init = lvgl_draw_1bpp_ctx_init;
+    disp_drv.draw_ctx_deinit = lvgl_draw_1bpp_ctx_deinit;
+    disp_drv.draw_ctx_size = sizeof(LVGLDraw1bppCtx);
+#endif
     
     // Register display driver
     display = lv_disp_drv_register(&disp_drv);
@@ -103,6 +309,10 @@ bool LVGLIntegration::initDisplay() {
         return false;
     }
     
+#if LVGL_DRAW_DIRECT_1BPP
+    lvgl_draw_1bpp_set_target(display, framebuffer, LVGL_FB_STRIDE);
+#endif
+    
     LOG_INFO("LVGL", "LVGL display driver initialized");
     return true;
 }
@@ -124,55 +334,698 @@ bool LVGLIntegration::initTouch() {
         return false;
     }
 
-    // Configure for faster, more responsive touch detection
+    // Drain the touch pipeline quickly while touched; touch_read_cb parks the
+    // timer on release and the INT pin restarts it
     if (touch_indev && touch_indev->driver) {
-        // Set faster read period for more responsive touch (10ms instead of default 30ms)
-        touch_indev->driver->read_timer->period = 10;
-        LOG_INFO("LVGL", "Touch read period set to 10ms for better responsiveness");
+        touch_indev->driver->read_timer->period = LVGL_TOUCH_READ_PERIOD_MS;
     }
+    attachWakeSources();
 
     LOG_INFO("LVGL", "LVGL touch driver initialized");
     return true;
 }
 
+bool LVGLIntegration::initKeypad() {
+    static lv_indev_drv_t indev_drv;
+    lv_indev_drv_init(&indev_drv);
+
+    indev_drv.type = LV_INDEV_TYPE_KEYPAD;
+    indev_drv.read_cb = keypad_read_cb;
+    
+    // A held key repeats at the keymap's rate
+    keymap_begin();
+    keymap_get_repeat(&indev_drv.long_press_time, &indev_drv.long_press_repeat_time);
+
+    keypad_indev = lv_indev_drv_register(&indev_drv);
+    if (!keypad_indev) {
+        LOG_ERROR("LVGL", "Failed to register keypad driver");
+        return false;
+    }
+
+    // Keys go to the focused widget of the default group
+    keypad_group = lv_group_create();
+    lv_group_set_default(keypad_group);
+    lv_indev_set_group(keypad_indev, keypad_group);
+
+    // The keypad task drains the FIFO on INT and wakes the UI loop, which
+    // readies this timer; it never polls the controller
+    lv_timer_pause(keypad_indev->driver->read_timer);
+
+    LOG_INFO("LVGL", "LVGL keypad driver initialized");
+    return true;
+}
+
+void LVGLIntegration::attachWakeSources() {
+    // CST328 pulls INT low on new data; the keypad task owns the TCA8418's INT
+    pinMode(BOARD_TOUCH_INT, INPUT_PULLUP);
+    attachInterrupt(digitalPinToInterrupt(BOARD_TOUCH_INT), touch_isr, FALLING);
+    LOG_INFO("LVGL", "Touch INT wakes the UI loop");
+}
+
 void LVGLIntegration::display_flush_cb(lv_disp_drv_t* disp_drv, const lv_area_t* area, lv_color_t* color_p) {
     LVGLIntegration* lvgl = getInstance();
     
-    if (!lvgl->epd_display) {
+    if (!lvgl->epd_display || !lvgl->framebuffer) {
         lv_disp_flush_ready(disp_drv);
         return;
     }
     
-    // For e-paper display, we need to convert LVGL buffer to display format
-    // LVGL uses 1-bit color, which should map directly to e-paper
+#if !LVGL_DRAW_DIRECT_1BPP
+    // Pack this band into the persistent framebuffer, 8 pixels per byte
+    uint32_t pack_start = micros();
+    lvgl->packArea(lvgl->framebuffer, area, color_p);
+    lvgl->frame_pack_us += micros() - pack_start;
+#endif
+    // With LVGL_DRAW_DIRECT_1BPP the band is already in the framebuffer
+    
+    lvgl->addDirtyRect(area);
+    
+    // LVGL renders in bands; only touch the panel once the frame is complete
+    if (lv_disp_flush_is_last(disp_drv)) {
+        lvgl->last_pack_us = lvgl->frame_pack_us;
+        lvgl->total_pack_us += lvgl->frame_pack_us;
+        lvgl->frame_pack_us = 0;
+        lvgl->profiler.markFlushDone();
+        lvgl_layers_frame_done(lvgl->display);
+        scr_mgr_note_flush();
+        
+        // While the panel is busy (or blanked) the dirty rects keep
+        // accumulating and are sent as one update once it is free
+        if (lvgl->flush_busy || lvgl->blanked) {
+            lvgl->frame_deferred = true;
+        } else {
+            lvgl->submitFrame();
+        }
+        lvgl->frames_flushed++;
+    }
+    
+    // Tell LVGL that flushing is done
+    lv_disp_flush_ready(disp_drv);
+}
+
+void LVGLIntegration::render_start_cb(lv_disp_drv_t* disp_drv) {
+    LVGLIntegration* lvgl = getInstance();
+    lvgl->profiler.markRenderStart();
+    input_trace_render();
+    
+    // Frames render at full clock; the governor drops back once the UI is idle
+    if (!lvgl->render_boost) {
+        power_governor_acquire(lvgl->render_lock);
+        lvgl->render_boost = true;
+    }
+    
+    // The flush task brings the driving voltages up while LVGL draws, so the
+    // update does not wait for them
+    if (lvgl->flush_task && !lvgl->flush_busy && !lvgl->blanked &&
+        !lvgl->epd_display->epd2.isPoweredOn()) {
+        xTaskNotifyGive(lvgl->flush_task);
+    }
+}
+
+void LVGLIntegration::rounder_cb(lv_disp_drv_t* disp_drv, lv_area_t* area) {
+    // Dynamic widgets stop at the chrome's edge instead of repainting it
+    lvgl_layers_trim(getInstance()->display, area);
+    
+    // Widen to whole bytes so packing and panel windows stay byte-aligned
+    area->x1 &= ~7;
+    area->x2 |= 7;
+}
+
+void PLACE_HOT LVGLIntegration::packArea(uint8_t* fb, const lv_area_t* area, const lv_color_t* color_p) {
+    int32_t x1 = LV_MAX(area->x1, 0);
+    int32_t y1 = LV_MAX(area->y1, 0);
+    int32_t x2 = LV_MIN(area->x2, fb_width - 1);
+    int32_t y2 = LV_MIN(area->y2, fb_height - 1);
+    int32_t src_stride = lv_area_get_width(area);
+    
+    if (x1 > x2 || y1 > y2) {
+        return;
+    }
+    
+    const uint8_t* src_row = (const uint8_t*)color_p + (y1 - area->y1) * src_stride + (x1 - area->x1);
+    
+    for (int32_t y = y1; y <= y2; y++) {
+        uint8_t* dst = fb + y * fb_stride;
+        const uint8_t* src = src_row;
+        int32_t x = x1;
+        
+        // Leading pixels up to the next byte boundary
+        while ((x & 7) && x <= x2) {
+            uint8_t mask = 0x80 >> (x & 7);
+            dst[x >> 3] = *src++ ? (dst[x >> 3] | mask) : (dst[x >> 3] & ~mask);
+            x++;
+        }
+        
+        // Whole bytes: two 32-bit loads per 8 pixels, no per-pixel branches
+        while (x + 7 <= x2) {
+            uint32_t lo, hi;
+            memcpy(&lo, src, sizeof(lo));
+            memcpy(&hi, src + 4, sizeof(hi));
+            dst[x >> 3] = (uint8_t)((pack_nibble(lo) << 4) | pack_nibble(hi));
+            src += 8;
+            x += 8;
+        }
+        
+        // Trailing pixels
+        while (x <= x2) {
+            uint8_t mask = 0x80 >> (x & 7);
+            dst[x >> 3] = *src++ ? (dst[x >> 3] | mask) : (dst[x >> 3] & ~mask);
+            x++;
+        }
+        
+        src_row += src_stride;
+    }
+}
+
+bool LVGLIntegration::startFlushTask() {
+    busy_semaphore = xSemaphoreCreateBinary();
+    if (!busy_semaphore) {
+        return false;
+    }
+    
+    // Sleep on the BUSY edge instead of polling the pin every millisecond
+    attachInterrupt(digitalPinToInterrupt(BOARD_EPD_BUSY), busy_isr, CHANGE);
+    epd_display->epd2.setBusyCallback(busy_wait_cb);
+    epd_display->epd2.setTransferCallback(transfer_break_cb);
+    
+    if (xTaskCreatePinnedToCore(flush_task_fn, "epd_flush", LVGL_FLUSH_TASK_STACK, this,
+                                LVGL_FLUSH_TASK_PRIORITY, &flush_task, LVGL_FLUSH_TASK_CORE) != pdPASS) {
+        flush_task = nullptr;
+        return false;
+    }
+    
+    LOG_INFOF("LVGL", "Flush task started on core %d", LVGL_FLUSH_TASK_CORE);
+    return true;
+}
+
+void LVGLIntegration::flush_task_fn(void* param) {
+    LVGLIntegration* lvgl = (LVGLIntegration*)param;
+    int watch = task_watch_add("epd_flush", LVGL_FLUSH_WATCH_MS);
+    
+    while (1) {
+        // Powered panels get LVGL_PANEL_OFF_IDLE_MS for the next update,
+        // then the voltages go down so the image does not fade
+        TickType_t idle = lvgl->epd_display->epd2.isPoweredOn() ? pdMS_TO_TICKS(LVGL_PANEL_OFF_IDLE_MS)
+                                                                 : portMAX_DELAY;
+        if (!ulTaskNotifyTake(pdTRUE, idle)) {
+            lvgl->setPanelPower(false);
+            continue;
+        }
+        if (!lvgl->flush_busy) {
+            // From render_start_cb, no job yet
+            lvgl->setPanelPower(true);
+            continue;
+        }
+        
+        task_watch_kick(watch);
+        energy_mark(ENERGY_DISPLAY, true);
+        lvgl->runJob(lvgl->flush_job);
+        energy_mark(ENERGY_DISPLAY, false);
+        task_watch_pause(watch);
+        lvgl->flush_busy = false;
+        
+        // A frame queued behind this one is sent from update()
+        if (lvgl->frame_deferred) {
+            lvgl->wake();
+        }
+    }
+}
+
+void IRAM_ATTR LVGLIntegration::busy_isr() {
+    BaseType_t woken = pdFALSE;
+    xSemaphoreGiveFromISR(busy_semaphore, &woken);
+    if (woken) {
+        portYIELD_FROM_ISR();
+    }
+}
+
+void IRAM_ATTR LVGLIntegration::touch_isr() {
+    if (!touch_irq) {
+        touch_irq_us = micros();
+    }
+    touch_irq = true;
+    instance->wakeFromISR();
+}
+
+void IRAM_ATTR LVGLIntegration::wakeFromISR() {
+    if (!ui_task) {
+        return;
+    }
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(ui_task, &woken);
+    if (woken) {
+        portYIELD_FROM_ISR();
+    }
+}
+
+void LVGLIntegration::busy_wait_cb(const void* param) {
+    // GxEPD2 re-checks the pin after this returns; the timeout covers a missed edge.
+    // The panel needs no SPI while it drives the waveform, so the bus is free meanwhile
+    bool held = spi_bus_held();
+    if (held) {
+        spi_bus_release(SPI_CLIENT_EPD);
+    }
+    uint32_t start = micros();
+    xSemaphoreTake(busy_semaphore, pdMS_TO_TICKS(20));
+    getInstance()->profiler.addBusyTime(micros() - start);
+    if (held) {
+        spi_bus_acquire(SPI_CLIENT_EPD);
+    }
+}
+
+void LVGLIntegration::transfer_break_cb(const void* param) {
+    // Each image chunk is one transfer buffer, about 2 ms at SPI_BUS_EPD_HZ
+    spi_bus_yield(SPI_CLIENT_EPD);
+}
+
+bool LVGLIntegration::diffRect(lv_area_t* rect) {
+    // Shrink the rectangle to the diff tiles whose pixels differ from the
+    // frame last sent to the panel; false if nothing changed at all
+    int32_t tx1 = rect->x1 / LVGL_DIFF_TILE_WIDTH;
+    int32_t tx2 = rect->x2 / LVGL_DIFF_TILE_WIDTH;
+    int32_t ty1 = rect->y1 / LVGL_DIFF_TILE_HEIGHT;
+    int32_t ty2 = rect->y2 / LVGL_DIFF_TILE_HEIGHT;
+    int32_t cx1 = INT32_MAX, cy1 = INT32_MAX, cx2 = -1, cy2 = -1;
+    
+    for (int32_t ty = ty1; ty <= ty2; ty++) {
+        int32_t y1 = LV_MAX(ty * LVGL_DIFF_TILE_HEIGHT, rect->y1);
+        int32_t y2 = LV_MIN(ty * LVGL_DIFF_TILE_HEIGHT + LVGL_DIFF_TILE_HEIGHT - 1, rect->y2);
+        for (int32_t tx = tx1; tx <= tx2; tx++) {
+            int32_t b1 = LV_MAX(tx * LVGL_DIFF_TILE_WIDTH, rect->x1) / 8;
+            int32_t b2 = LV_MIN(tx * LVGL_DIFF_TILE_WIDTH + LVGL_DIFF_TILE_WIDTH - 1, rect->x2) / 8;
+            bool changed = false;
+            for (int32_t y = y1; y <= y2 && !changed; y++) {
+                int32_t offset = y * fb_stride + b1;
+                changed = !span_equal(framebuffer + offset, sent_buffer + offset, b2 - b1 + 1);
+            }
+            if (changed) {
+                diff_tiles_changed++;
+                cx1 = LV_MIN(cx1, b1 * 8);
+                cx2 = LV_MAX(cx2, b2 * 8 + 7);
+                cy1 = LV_MIN(cy1, y1);
+                cy2 = LV_MAX(cy2, y2);
+            } else {
+                diff_tiles_unchanged++;
+            }
+        }
+    }
+    
+    if (cx2 < 0) {
+        return false;
+    }
+    rect->x1 = cx1;
+    rect->y1 = cy1;
+    rect->x2 = cx2;
+    rect->y2 = cy2;
+    return true;
+}
+
+void LVGLIntegration::diffDirtyRects() {
+    uint8_t kept = 0;
+    for (uint8_t i = 0; i < dirty_count; i++) {
+        if (diffRect(&dirty_rects[i])) {
+            dirty_rects[kept++] = dirty_rects[i];
+        }
+    }
+    dirty_count = kept;
+}
+
+void LVGLIntegration::submitFrame() {
+    mergeDirtyRects();
+    diffDirtyRects();
+    frame_deferred = false;
+    
+    bool full = shouldRefreshFull();
+    if (!full && dirty_count == 0) {
+        // Identical pixels: leave the panel asleep
+        frames_skipped++;
+        profiler.discardFrame();
+        return;
+    }
+    
+    // Snapshot the back buffer so LVGL can keep rendering into it
+    publishFrame();
     
-    int32_t w = area->x2 - area->x1 + 1;
-    int32_t h = area->y2 - area->y1 + 1;
+    if (full) {
+        flush_job.type = FLUSH_JOB_FULL;
+        flush_job.count = 0;
+        full_refresh_pending = false;
+        refresh_policy.recordFull();
+        full_updates++;
+        LOG_DEBUG("LVGL", "Full refresh");
+    } else {
+        flush_job.type = FLUSH_JOB_PARTIAL;
+        flush_job.count = dirty_count;
+        for (uint8_t i = 0; i < dirty_count; i++) {
+            flush_job.rects[i] = dirty_rects[i];
+            mapToPanel(&flush_job.rects[i]);
+            refresh_policy.recordPartial(&flush_job.rects[i]);
+        }
+        partial_updates++;
+        LOG_DEBUGF("LVGL", "Partial refresh: %u rects", dirty_count);
+    }
+    dirty_count = 0;
     
-    // Set full window for reliable e-paper rendering
-    lvgl->epd_display->setFullWindow();
-    lvgl->epd_display->firstPage();
+    profiler.markSubmit(flush_job.type, flush_job.count);
+    submitJob();
+    
+    display_needs_refresh = false;
+    last_refresh_time = millis();
+}
+
+void LVGLIntegration::publishFrame() {
+    if (rotation == LV_DISP_ROT_NONE) {
+        memcpy(front_buffer, framebuffer, LVGL_FB_SIZE);
+        return;
+    }
+    
+    uint32_t start = micros();
+    memcpy(sent_buffer, framebuffer, LVGL_FB_SIZE);
+    fb_rotate(front_buffer, framebuffer, fb_width, fb_height, rotation);
+    last_rotate_us = micros() - start;
+}
+
+void LVGLIntegration::mapToPanel(lv_area_t* rect) {
+    // Inverse of the pointer mapping in lv_indev.c, widened to whole panel bytes
+    lv_area_t r = *rect;
+    switch (rotation) {
+        case LV_DISP_ROT_90:
+            rect->x1 = r.y1;
+            rect->x2 = r.y2;
+            rect->y1 = fb_width - 1 - r.x2;
+            rect->y2 = fb_width - 1 - r.x1;
+            break;
+        case LV_DISP_ROT_180:
+            rect->x1 = fb_width - 1 - r.x2;
+            rect->x2 = fb_width - 1 - r.x1;
+            rect->y1 = fb_height - 1 - r.y2;
+            rect->y2 = fb_height - 1 - r.y1;
+            break;
+        case LV_DISP_ROT_270:
+            rect->x1 = fb_height - 1 - r.y2;
+            rect->x2 = fb_height - 1 - r.y1;
+            rect->y1 = r.x1;
+            rect->y2 = r.x2;
+            break;
+        default:
+            return;
+    }
+    rect->x1 &= ~7;
+    rect->x2 |= 7;
+}
 
-    do {
-        // Clear the entire screen for proper e-paper rendering
-        lvgl->epd_display->fillScreen(GxEPD_WHITE);
+void LVGLIntegration::submitJob() {
+    // The first frame rendered after an input is the one that shows it
+    if (flush_job.type != FLUSH_JOB_CLEAN) {
+        input_trace_take(&flush_job.trace);
+    } else {
+        flush_job.trace.active = false;
+    }
+    if (flush_task) {
+        flush_busy = true;
+        xTaskNotifyGive(flush_task);
+    } else {
+        runJob(flush_job);
+    }
+}
 
-        // Draw pixels from LVGL buffer
-        for (int32_t y = 0; y < h; y++) {
-            for (int32_t x = 0; x < w; x++) {
-                lv_color_t pixel = color_p[y * w + x];
-                // Convert LVGL 1-bit color to e-paper color
-                uint16_t color = (pixel.full == 0) ? GxEPD_BLACK : GxEPD_WHITE;
-                lvgl->epd_display->drawPixel(area->x1 + x, area->y1 + y, color);
+void LVGLIntegration::runJob(const FlushJob& job) {
+    SpiBusHold bus(SPI_CLIENT_EPD);
+    input_trace_t trace = job.trace;
+    input_trace_panel(&trace);
+    profiler.beginPanel();
+    
+    switch (job.type) {
+        case FLUSH_JOB_FULL:
+            commitFrame(true);
+            break;
+        case FLUSH_JOB_PARTIAL:
+            for (uint8_t i = 0; i < job.count; i++) {
+                commitRect(&job.rects[i]);
             }
+            break;
+        case FLUSH_JOB_CLEAN:
+            cleanRect(&job.rects[0]);
+            break;
+    }
+    
+    profiler.endPanel();
+    screen_mirror_frame(front_buffer);
+    
+    // The last BUSY wait was the refresh itself, so the input is on the glass
+    if (trace.active) {
+        input_trace_glass(&trace);
+        if (trace.source == INPUT_SRC_KEYPAD) {
+            keypad_note_glyph((trace.mark[INPUT_STAGE_GLASS] - trace.irq_us) / 1000);
+        }
+    }
+}
+
+void LVGLIntegration::setPanelPower(bool on) {
+    if (epd_display->epd2.isPoweredOn() == on) {
+        return;
+    }
+    SpiBusHold bus(SPI_CLIENT_EPD);
+    if (on) {
+        epd_display->epd2.powerOn();
+        panel_early_ons++;
+    } else {
+        epd_display->epd2.powerOff();
+        panel_idle_offs++;
+    }
+}
+
+bool LVGLIntegration::waitFlushIdle(uint32_t timeout_ms) {
+    uint32_t start = millis();
+    while (flush_busy) {
+        if (millis() - start >= timeout_ms) {
+            return false;
         }
-    } while (lvgl->epd_display->nextPage());
+        delay(1);
+    }
+    return true;
+}
+
+void LVGLIntegration::commitFrame(bool full_refresh) {
+    uint32_t commit_start = micros();
     
-    // Mark that display needs refresh
-    lvgl->display_needs_refresh = true;
+    epd_display->epd2.setUpdateClass(full_refresh ? GxEPD2_310_GDEQ031T10::UPDATE_FULL_SCREEN
+                                                  : GxEPD2_310_GDEQ031T10::UPDATE_ICON);
     
-    // Tell LVGL that flushing is done
-    lv_disp_flush_ready(disp_drv);
+    // Same sequence as GxEPD2_BW::display(), but sourced from the packed framebuffer
+    if (full_refresh) {
+        epd_display->epd2.writeImageForFullRefresh(front_buffer, 0, 0, LVGL_DISPLAY_WIDTH, LVGL_DISPLAY_HEIGHT,
+                                                   false, LVGL_FB_MIRROR_Y);
+    } else {
+        epd_display->epd2.writeImage(front_buffer, 0, 0, LVGL_DISPLAY_WIDTH, LVGL_DISPLAY_HEIGHT,
+                                     false, LVGL_FB_MIRROR_Y);
+    }
+    epd_display->epd2.refresh(!full_refresh);
+    if (epd_display->epd2.hasFastPartialUpdate) {
+        epd_display->epd2.writeImageAgain(front_buffer, 0, 0, LVGL_DISPLAY_WIDTH, LVGL_DISPLAY_HEIGHT,
+                                          false, LVGL_FB_MIRROR_Y);
+    }
+    // The flush task powers the panel down once updates stop; inline, nothing would
+    if (full_refresh && !flush_task) {
+        epd_display->epd2.powerOff();
+    }
+    
+    last_commit_us = micros() - commit_start;
+    total_commit_us += last_commit_us;
+}
+
+void LVGLIntegration::commitRect(const lv_area_t* rect) {
+    uint32_t commit_start = micros();
+    
+    int16_t x = rect->x1;
+    int16_t w = lv_area_get_width(rect);
+    int16_t h = lv_area_get_height(rect);
+    // Panel RAM is vertically flipped relative to LVGL (see LVGL_FB_MIRROR_Y)
+    int16_t y = LVGL_DISPLAY_HEIGHT - rect->y1 - h;
+    
+    // Small areas (labels, typed text) get the fastest waveform
+    epd_display->epd2.setUpdateClass(lv_area_get_size(rect) <= LVGL_TEXT_UPDATE_MAX_AREA
+                                     ? GxEPD2_310_GDEQ031T10::UPDATE_TEXT
+                                     : GxEPD2_310_GDEQ031T10::UPDATE_ICON);
+    
+    epd_display->epd2.writeImagePart(front_buffer, x, y, LVGL_DISPLAY_WIDTH, LVGL_DISPLAY_HEIGHT,
+                                     x, y, w, h, false, LVGL_FB_MIRROR_Y);
+    epd_display->epd2.refresh(x, y, w, h);
+    if (epd_display->epd2.hasFastPartialUpdate) {
+        epd_display->epd2.writeImagePartAgain(front_buffer, x, y, LVGL_DISPLAY_WIDTH, LVGL_DISPLAY_HEIGHT,
+                                              x, y, w, h, false, LVGL_FB_MIRROR_Y);
+    }
+    
+    last_commit_us = micros() - commit_start;
+    total_commit_us += last_commit_us;
+}
+
+void LVGLIntegration::addDirtyRect(const lv_area_t* area) {
+    lv_area_t rect;
+    rect.x1 = LV_MAX(area->x1, 0) & ~7;
+    rect.y1 = LV_MAX(area->y1, 0);
+    rect.x2 = LV_MIN(area->x2 | 7, fb_width - 1);
+    rect.y2 = LV_MIN(area->y2, fb_height - 1);
+    if (rect.x1 > rect.x2 || rect.y1 > rect.y2) {
+        return;
+    }
+    
+    // Absorb into an overlapping or touching rectangle first
+    for (uint8_t i = 0; i < dirty_count; i++) {
+        if (rect.x1 <= dirty_rects[i].x2 + 1 && rect.x2 + 1 >= dirty_rects[i].x1 &&
+            rect.y1 <= dirty_rects[i].y2 + 1 && rect.y2 + 1 >= dirty_rects[i].y1) {
+            _lv_area_join(&dirty_rects[i], &dirty_rects[i], &rect);
+            return;
+        }
+    }
+    
+    if (dirty_count < LVGL_MAX_DIRTY_RECTS) {
+        dirty_rects[dirty_count++] = rect;
+        return;
+    }
+    
+    // Out of slots: grow whichever rectangle gains the least area
+    uint8_t best = 0;
+    uint32_t best_growth = UINT32_MAX;
+    for (uint8_t i = 0; i < dirty_count; i++) {
+        lv_area_t joined;
+        _lv_area_join(&joined, &dirty_rects[i], &rect);
+        uint32_t growth = lv_area_get_size(&joined) - lv_area_get_size(&dirty_rects[i]);
+        if (growth < best_growth) {
+            best_growth = growth;
+            best = i;
+        }
+    }
+    _lv_area_join(&dirty_rects[best], &dirty_rects[best], &rect);
+}
+
+void LVGLIntegration::mergeDirtyRects() {
+    // Joining may create new overlaps, so repeat until the set is stable
+    bool merged = true;
+    while (merged) {
+        merged = false;
+        for (uint8_t i = 0; i < dirty_count && !merged; i++) {
+            for (uint8_t j = i + 1; j < dirty_count; j++) {
+                lv_area_t joined;
+                _lv_area_join(&joined, &dirty_rects[i], &dirty_rects[j]);
+                // Merge overlaps, and neighbours whose union wastes little area
+                uint32_t parts = lv_area_get_size(&dirty_rects[i]) + lv_area_get_size(&dirty_rects[j]);
+                if (_lv_area_is_on(&dirty_rects[i], &dirty_rects[j]) ||
+                    lv_area_get_size(&joined) <= parts + parts / 4) {
+                    dirty_rects[i] = joined;
+                    dirty_rects[j] = dirty_rects[--dirty_count];
+                    merged = true;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+bool LVGLIntegration::shouldRefreshFull() {
+    // The resumed screen redraws what the panel kept, so no clearing flash
+    lv_obj_t* screen = lv_scr_act();
+    if (panel_kept) {
+        panel_kept = false;
+        last_screen = screen;
+        return false;
+    }
+    
+    // Screen changes (scr_mgr_switch, setActiveScreen) get a clean panel
+    if (screen != last_screen) {
+        last_screen = screen;
+        return true;
+    }
+    
+    if (full_refresh_pending || refresh_policy.needsFullRefresh()) {
+        return true;
+    }
+    
+    // Cached screens are restored with the fast waveform however much changed
+    if (snapshot_restore) {
+        snapshot_restore = false;
+        return false;
+    }
+    
+    uint32_t dirty_area = 0;
+    for (uint8_t i = 0; i < dirty_count; i++) {
+        dirty_area += lv_area_get_size(&dirty_rects[i]);
+    }
+    return dirty_area * 100 >= (uint32_t)LVGL_DISPLAY_WIDTH * LVGL_DISPLAY_HEIGHT * LVGL_FULL_REFRESH_COVERAGE;
+}
+
+void LVGLIntegration::cleanRect(const lv_area_t* rect) {
+    int16_t x = rect->x1 & ~7;
+    int16_t w = ((rect->x2 | 7) + 1) - x;
+    int16_t h = lv_area_get_height(rect);
+    int16_t y = LVGL_DISPLAY_HEIGHT - rect->y1 - h;
+    
+    // Drive every pixel of the region through an inverted image and back,
+    // which clears accumulated ghosting without flashing the rest of the panel
+    epd_display->epd2.setUpdateClass(GxEPD2_310_GDEQ031T10::UPDATE_ICON);
+    epd_display->epd2.writeImagePart(front_buffer, x, y, LVGL_DISPLAY_WIDTH, LVGL_DISPLAY_HEIGHT,
+                                     x, y, w, h, true, LVGL_FB_MIRROR_Y);
+    epd_display->epd2.refresh(x, y, w, h);
+    epd_display->epd2.writeImagePartAgain(front_buffer, x, y, LVGL_DISPLAY_WIDTH, LVGL_DISPLAY_HEIGHT,
+                                          x, y, w, h, true, LVGL_FB_MIRROR_Y);
+    epd_display->epd2.writeImagePart(front_buffer, x, y, LVGL_DISPLAY_WIDTH, LVGL_DISPLAY_HEIGHT,
+                                     x, y, w, h, false, LVGL_FB_MIRROR_Y);
+    epd_display->epd2.refresh(x, y, w, h);
+    epd_display->epd2.writeImagePartAgain(front_buffer, x, y, LVGL_DISPLAY_WIDTH, LVGL_DISPLAY_HEIGHT,
+                                          x, y, w, h, false, LVGL_FB_MIRROR_Y);
+}
+
+void LVGLIntegration::cleanGhostedRegion() {
+    lv_area_t region;
+    if (!refresh_policy.getCleanRegion(&region)) {
+        return;
+    }
+    
+    // A region covering most of the panel is cheaper as one full refresh
+    if (lv_area_get_size(&region) * 100 >=
+        (uint32_t)LVGL_DISPLAY_WIDTH * LVGL_DISPLAY_HEIGHT * LVGL_FULL_REFRESH_COVERAGE) {
+        forceRefresh();
+        return;
+    }
+    
+    publishFrame();
+    flush_job.type = FLUSH_JOB_CLEAN;
+    flush_job.rects[0] = region;
+    flush_job.count = 1;
+    profiler.markSubmit(flush_job.type, flush_job.count);
+    submitJob();
+    refresh_policy.recordCleaned(&region);
+    LOG_DEBUGF("LVGL", "Cleaned ghosted region %d,%d %dx%d",
+               region.x1, region.y1, lv_area_get_width(&region), lv_area_get_height(&region));
+}
+
+uint32_t LVGLIntegration::getIdleTime() {
+    // Idle means no input on LVGL and no activity reported to the power manager
+    uint32_t idle = display ? lv_disp_get_inactive_time(display) : 0;
+    if (Power) {
+        idle = LV_MIN(idle, Power->getIdleTime());
+    }
+    return idle;
+}
+
+void LVGLIntegration::sampleTouch() {
+    // One I2C read per INT; no points means the finger lifted
+    int16_t x, y;
+    if (!i2c_bus_acquire(I2C_DEV_TOUCH, LVGL_TOUCH_BUS_WAIT_MS)) {
+        return;     // The next INT or the stale check retries
+    }
+    bool pressed = touch_controller->getPoint(&x, &y, 1) > 0;
+    i2c_bus_release(I2C_DEV_TOUCH);
+    touch_pipeline.pushSample(x, y, pressed, millis());
+    remote_touch = false;
+    if (event_replay_recording()) {
+        EventReplayTouch rec = {x, y, pressed, {0, 0, 0}};
+        event_replay_record(REPLAY_SRC_TOUCH, &rec, sizeof(rec));
+    }
+    if (touch_irq_us) {
+        touch_tag = {touch_irq_us, (uint32_t)micros(), INPUT_SRC_TOUCH};
+        touch_irq_us = 0;
+    }
 }
 
 void LVGLIntegration::touch_read_cb(lv_indev_drv_t* indev_drv, lv_indev_data_t* data) {
@@ -183,18 +1036,62 @@ void LVGLIntegration::touch_read_cb(lv_indev_drv_t* indev_drv, lv_indev_data_t*
         return;
     }
     
-    if (lvgl->touch_controller->isPressed()) {
-        int16_t x, y;
-        if (lvgl->touch_controller->getPoint(&x, &y, 1)) {
-            data->point.x = x;
-            data->point.y = y;
-            data->state = LV_INDEV_STATE_PR;
-        } else {
-            data->state = LV_INDEV_STATE_REL;
+    uint32_t now = millis();
+    lvgl->touch_pipeline.process(now);
+    
+    // A press with no INT for a while may have lost its lift edge; a remote
+    // press has no INT and ends with its own release
+    if (!lvgl->remote_touch && lvgl->touch_pipeline.isStale(now)) {
+        lvgl->sampleTouch();
+        lvgl->touch_pipeline.process(now);
+    }
+    
+    data->point = lvgl->touch_pipeline.getPoint();
+    data->state = lvgl->touch_pipeline.isPressed() ? LV_INDEV_STATE_PR : LV_INDEV_STATE_REL;
+    input_trace_indev(&lvgl->touch_tag);
+    lvgl->touch_tag.irq_us = 0;
+    
+    // LVGL has seen the release; stop polling until the next touch INT
+    if (lvgl->touch_pipeline.isSettled() && !touch_irq) {
+        lv_timer_pause(indev_drv->read_timer);
+    }
+}
+
+void LVGLIntegration::keypad_read_cb(lv_indev_drv_t* indev_drv, lv_indev_data_t* data) {
+    LVGLIntegration* lvgl = getInstance();
+    static uint32_t last_key = 0;
+    
+    // One LVGL key per call; continue_reading makes LVGL call again at once
+    // so a burst is handled within one timer run. Modifiers and chords are
+    // taken by the keymap and produce nothing here
+    uint32_t key;
+    bool pressed;
+    bool got = keymap_take(&key, &pressed);
+    keypad_event_t ev;
+    while (!got && !lvgl->blanked && (keypad_event_take(&ev) || screen_mirror_take_key(&ev))) {
+        keymap_feed(&ev);
+        got = keymap_take(&key, &pressed);
+        if (got && pressed) {
+            input_tag_t tag = {ev.irq_us, ev.read_us, INPUT_SRC_KEYPAD};
+            input_trace_indev(&tag);
         }
-    } else {
-        data->state = LV_INDEV_STATE_REL;
     }
+    
+    if (!got) {
+        // A key still down is reported pressed so LVGL repeats it
+        bool held = keymap_held() && !lvgl->blanked;
+        data->key = last_key;
+        data->state = held ? LV_INDEV_STATE_PR : LV_INDEV_STATE_REL;
+        if (!held) {
+            lv_timer_pause(indev_drv->read_timer);
+        }
+        return;
+    }
+    
+    last_key = key;
+    data->key = key;
+    data->state = pressed ? LV_INDEV_STATE_PR : LV_INDEV_STATE_REL;
+    data->continue_reading = keymap_pending() || keypad_pending() || screen_mirror_key_pending();
 }
 
 void LVGLIntegration::setupMonochromeTheme() {
@@ -209,12 +1106,10 @@ void LVGLIntegration::setupMonochromeTheme() {
 }
 
 lv_theme_t* LVGLIntegration::createMonochromeTheme() {
-    // Use the basic theme as a base and modify for monochrome
-    lv_theme_t* theme = lv_theme_basic_init(display);
+    // Constant styles in flash (ui_theme.c); nothing is built in the LVGL heap
+    lv_theme_t* theme = ui_theme_mono_init(display);
     
     if (theme) {
-        // The basic theme should work well for monochrome displays
-        // Additional customizations can be added here if needed
         LOG_INFO("LVGL", "Monochrome theme created successfully");
     } else {
         LOG_ERROR("LVGL", "Failed to create monochrome theme");
@@ -223,13 +1118,74 @@ lv_theme_t* LVGLIntegration::createMonochromeTheme() {
     return theme;
 }
 
-void LVGLIntegration::update() {
+uint32_t LVGLIntegration::update() {
     if (!initialized) {
-        return;
+        return LVGL_IDLE_WAIT_MAX_MS;
+    }
+    
+    // Read the controller once per touch INT and restart the read timer
+    // parked by touch_read_cb
+    if (touch_irq && touch_indev) {
+        touch_irq = false;
+        if (touch_controller && !blanked) {
+            sampleTouch();
+        }
+        lv_timer_resume(touch_indev->driver->read_timer);
+        lv_timer_ready(touch_indev->driver->read_timer);
+    }
+    
+    // A mirror just switched on starts from what the panel shows
+    if (!flush_busy && screen_mirror_wants_frame()) {
+        screen_mirror_frame(front_buffer);
+    }
+    
+    // Touches from the screen mirror go where the INT-read samples go
+    int16_t rx, ry;
+    bool rpressed;
+    bool remote = false;
+    while (touch_indev && !blanked && screen_mirror_take_touch(&rx, &ry, &rpressed)) {
+        touch_pipeline.pushSample(rx, ry, rpressed, millis());
+        remote_touch = rpressed;
+        remote = true;
+    }
+    // Replayed samples stand in for the controller read, INT edge included
+    uint32_t inject_us;
+    while (touch_indev && !blanked && event_replay_take_touch(&rx, &ry, &rpressed, &inject_us)) {
+        touch_pipeline.pushSample(rx, ry, rpressed, millis());
+        touch_tag = {inject_us, (uint32_t)micros(), INPUT_SRC_TOUCH};
+        remote_touch = rpressed;
+        remote = true;
+    }
+    if (remote) {
+        lv_timer_resume(touch_indev->driver->read_timer);
+        lv_timer_ready(touch_indev->driver->read_timer);
+    }
+    
+    // Keys queued by the keypad task or the mirror, handed to LVGL in this timer run
+    if (keypad_indev && !blanked && (keypad_pending() || screen_mirror_key_pending())) {
+        lv_timer_resume(keypad_indev->driver->read_timer);
+        lv_timer_ready(keypad_indev->driver->read_timer);
+    }
+    
+    // Pending invalidations start the clock for the next frame
+    if (display && display->inv_p > 0) {
+        profiler.markInvalidate();
     }
     
     // Handle LVGL tasks
-    lv_timer_handler();
+    uint32_t next = lv_timer_handler();
+    task_arena_reset();
+    if (render_boost) {
+        power_governor_release(render_lock);
+        render_boost = false;
+    }
+    
+    profiler.updateOverlay();
+    
+    // Send frames that completed while the panel was busy
+    if (frame_deferred && !flush_busy && !blanked) {
+        submitFrame();
+    }
     
     // Check if display needs refresh and enough time has passed
     uint32_t current_time = millis();
@@ -238,6 +1194,54 @@ void LVGLIntegration::update() {
         
         forceRefresh();
     }
+    
+    // Clean ghosted regions while the user is not interacting
+    if (!flush_busy && !frame_deferred && !blanked && refresh_policy.needsCleaning() &&
+        getIdleTime() >= clean_idle_ms) {
+        cleanGhostedRegion();
+    }
+    
+    if (display_needs_refresh) {
+        uint32_t elapsed = millis() - last_refresh_time;
+        next = LV_MIN(next, elapsed < refresh_interval_ms ? refresh_interval_ms - elapsed : 0);
+    }
+    next = LV_MIN(next, LVGL_IDLE_WAIT_MAX_MS);
+    next_work_time = millis() + next;
+    return next;
+}
+
+void LVGLIntegration::waitForWork(uint32_t max_ms) {
+    if (!ui_task) {
+        ui_task = xTaskGetCurrentTaskHandle();
+    }
+    
+    uint32_t wait = max_ms;
+    if (initialized) {
+        int32_t until_next = (int32_t)(next_work_time - millis());
+        wait = LV_MIN(wait, (uint32_t)LV_MAX(until_next, 0));
+        
+        // Invalidations made after update() resume the refresh timer
+        if (display && display->inv_p > 0 && display->refr_timer) {
+            wait = LV_MIN(wait, display->refr_timer->period);
+        }
+        if (touch_irq || (frame_deferred && !flush_busy && !blanked) ||
+            (keypad_indev && !blanked && keypad_pending())) {
+            wait = 0;
+        }
+    }
+    
+    // Any wake source gives the notification, so the wait ends early on input
+    if (wait > 0) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(wait));
+    } else {
+        taskYIELD();
+    }
+}
+
+void LVGLIntegration::wake() {
+    if (ui_task) {
+        xTaskNotifyGive(ui_task);
+    }
 }
 
 void LVGLIntegration::forceRefresh() {
@@ -245,14 +1249,98 @@ void LVGLIntegration::forceRefresh() {
         return;
     }
     
-    // Force a full display refresh for e-paper
-    epd_display->display();
-    display_needs_refresh = false;
-    last_refresh_time = millis();
+    // Force a full display refresh for e-paper, after any update in flight
+    full_refresh_pending = true;
+    if (flush_busy || blanked) {
+        frame_deferred = true;
+    } else if (framebuffer) {
+        submitFrame();
+    }
     
     LOG_DEBUG("LVGL", "Display refreshed");
 }
 
+void LVGLIntegration::snapshot_save_cb(uint8_t* buf) {
+    LVGLIntegration* lvgl = getInstance();
+    if (lvgl->framebuffer) {
+        memcpy(buf, lvgl->framebuffer, LVGL_FB_SIZE);
+    }
+}
+
+void LVGLIntegration::snapshot_show_cb(const uint8_t* buf) {
+    getInstance()->showSnapshot(buf);
+}
+
+void LVGLIntegration::showSnapshot(const uint8_t* snapshot) {
+    if (!initialized || !framebuffer || !snapshot) {
+        return;
+    }
+    
+    // Put the cached frame up now; when LVGL re-renders the screen the frame
+    // diff finds matching tiles and only what changed meanwhile is sent
+    memcpy(framebuffer, snapshot, LVGL_FB_SIZE);
+    lv_area_t screen_area = {0, 0, (lv_coord_t)(fb_width - 1), (lv_coord_t)(fb_height - 1)};
+    addDirtyRect(&screen_area);
+    
+    // The screen was already loaded; the cached frame stands in for its first full refresh
+    last_screen = lv_scr_act();
+    full_refresh_pending = false;
+    snapshot_restore = true;
+    
+    if (flush_busy || blanked) {
+        frame_deferred = true;
+    } else {
+        submitFrame();
+    }
+}
+
+void LVGLIntegration::resumeOnPanel() {
+    // E-paper holds its image unpowered; the first frame after a deep sleep
+    // resume goes out with the fast waveform over it
+    full_refresh_pending = false;
+    panel_kept = true;
+}
+
+void LVGLIntegration::setBlanked(bool blank) {
+    if (!initialized || blank == blanked) {
+        return;
+    }
+    blanked = blank;
+    
+    if (blank) {
+        // Frames wait in the framebuffer; no touch reaches LVGL and the
+        // controller sleeps until the face moves away
+        if (touch_indev) {
+            lv_indev_enable(touch_indev, false);
+        }
+        if (touch_controller) {
+            touch_controller->sleep();
+        }
+        if (!flush_busy) {
+            SpiBusHold bus(SPI_CLIENT_EPD);
+            epd_display->epd2.powerOff();
+        }
+        LOG_INFO("LVGL", "Display and touch blanked");
+        return;
+    }
+    
+    if (touch_controller) {
+        touch_controller->wakeup();
+        // sleep() leaves INT open-drain
+        pinMode(BOARD_TOUCH_INT, INPUT_PULLUP);
+    }
+    // Contacts from while it was blanked end in a release
+    lv_point_t last = touch_pipeline.getPoint();
+    touch_pipeline.pushSample(last.x, last.y, false, millis());
+    if (touch_indev) {
+        lv_indev_enable(touch_indev, true);
+    }
+    if (frame_deferred) {
+        wake();
+    }
+    LOG_INFO("LVGL", "Display and touch back on");
+}
+
 void LVGLIntegration::setRefreshInterval(uint32_t interval_ms) {
     refresh_interval_ms = interval_ms;
     LOG_INFOF("LVGL", "Refresh interval set to %lums", interval_ms);
@@ -262,6 +1350,158 @@ bool LVGLIntegration::isDisplayReady() {
     return initialized && display != nullptr;
 }
 
+void LVGLIntegration::requestFullRefresh() {
+    full_refresh_pending = true;
+    if (display) {
+        lv_obj_invalidate(lv_scr_act());
+    }
+}
+
+void LVGLIntegration::setFullRefreshBudget(uint16_t partial_updates) {
+    uint8_t hard = partial_updates > UINT8_MAX ? UINT8_MAX : partial_updates;
+    refresh_policy.setLimits(LV_MIN(REFRESH_GHOST_SOFT_LIMIT, hard), hard);
+    LOG_INFOF("LVGL", "Full refresh after %u partial updates of one tile", hard);
+}
+
+void LVGLIntegration::setCleanIdle(uint32_t idle_ms) {
+    clean_idle_ms = idle_ms;
+}
+
+bool LVGLIntegration::setRotation(lv_disp_rot_t rot) {
+    if (!initialized || !display) {
+        return false;
+    }
+    if (rot == rotation) {
+        return true;
+    }
+    
+    bool quarter = rot == LV_DISP_ROT_90 || rot == LV_DISP_ROT_270;
+    if (rot != LV_DISP_ROT_NONE && !rotated_sent) {
+        rotated_sent = (uint8_t*)ps_malloc(LVGL_FB_SIZE);
+        if (!rotated_sent) {
+            LOG_ERROR("LVGL", "No memory for the rotated frame");
+            return false;
+        }
+    }
+    
+    // The flush task reads the front buffer, whose layout is about to change
+    if (!waitFlushIdle()) {
+        LOG_WARN("LVGL", "Flush task busy, rotation not applied");
+        return false;
+    }
+    
+    rotation = rot;
+    sent_buffer = rot == LV_DISP_ROT_NONE ? front_buffer : rotated_sent;
+    fb_width = quarter ? LVGL_DISPLAY_HEIGHT : LVGL_DISPLAY_WIDTH;
+    fb_height = quarter ? LVGL_DISPLAY_WIDTH : LVGL_DISPLAY_HEIGHT;
+    fb_stride = fb_width / 8;
+    
+    // Nothing rendered so far lines up with the new layout, cached frames included
+    memset(framebuffer, 0xFF, LVGL_FB_SIZE);
+    memset(sent_buffer, 0xFF, LVGL_FB_SIZE);
+    dirty_count = 0;
+    frame_deferred = false;
+    scr_mgr_drop_snapshots();
+    
+    // Resizes the screens and invalidates the active one, which goes out as a full refresh
+    lv_disp_set_rotation(display, rot);
+#if LVGL_DRAW_DIRECT_1BPP
+    lvgl_draw_1bpp_set_target(display, framebuffer, fb_stride);
+#endif
+    full_refresh_pending = true;
+    
+    LOG_INFOF("LVGL", "Display rotated %d degrees, %dx%d", rot * 90, fb_width, fb_height);
+    return true;
+}
+
+uint32_t LVGLIntegration::benchmarkFlush(uint16_t frames) {
+    if (!framebuffer || frames == 0) {
+        return 0;
+    }
+    
+    // Render-sized band of alternating pixels so every byte takes the packing path
+    const int32_t band_rows = LVGL_BUFFER_SIZE / fb_width;
+    lv_color_t* band = (lv_color_t*)ps_malloc(LVGL_BUFFER_SIZE * sizeof(lv_color_t));
+    if (!band) {
+        LOG_ERROR("LVGL", "Benchmark buffer allocation failed");
+        return 0;
+    }
+    for (uint32_t i = 0; i < LVGL_BUFFER_SIZE; i++) {
+        band[i] = (i & 1) ? lv_color_white() : lv_color_black();
+    }
+    
+    uint32_t start = micros();
+    for (uint16_t f = 0; f < frames; f++) {
+        for (int32_t y = 0; y < fb_height; y += band_rows) {
+            lv_area_t area = {0, (lv_coord_t)y, (lv_coord_t)(fb_width - 1),
+                              (lv_coord_t)(LV_MIN(y + band_rows, fb_height) - 1)};
+            packArea(framebuffer, &area, band);
+        }
+    }
+    uint32_t per_frame_us = (micros() - start) / frames;
+    
+    free(band);
+    
+    // Leave the framebuffer as the panel last saw it
+    memset(framebuffer, 0xFF, LVGL_FB_SIZE);
+    if (display) {
+        lv_obj_invalidate(lv_scr_act());
+    }
+    
+    LOG_INFOF("LVGL", "Flush benchmark: %u frames, %lu us/frame pack (%dx%d)",
+              frames, per_frame_us, fb_width, fb_height);
+    return per_frame_us;
+}
+
+void LVGLIntegration::enableProfiling(bool enabled, bool overlay) {
+    profiler.enable(enabled);
+    if (display) {
+        profiler.showOverlay(enabled && overlay);
+    }
+    LOG_INFOF("LVGL", "Pipeline profiling %s%s", enabled ? "enabled" : "disabled",
+              enabled && overlay ? " with overlay" : "");
+}
+
+void LVGLIntegration::printStatus() {
+    LOG_INFO("LVGL", "=== LVGL Flush Status ===");
+    LOG_INFOF("LVGL", "Initialized: %s", initialized ? "true" : "false");
+    LOG_INFOF("LVGL", "Frames flushed: %lu", frames_flushed);
+    LOG_INFOF("LVGL", "Last frame: pack %lu us, panel %lu us", last_pack_us, last_commit_us);
+    LOG_INFOF("LVGL", "Panel updates: %lu partial, %lu full", partial_updates, full_updates);
+    if (rotation != LV_DISP_ROT_NONE) {
+        LOG_INFOF("LVGL", "Rotation: %d degrees, last frame rotated in %lu us", rotation * 90, last_rotate_us);
+    }
+    LOG_INFOF("LVGL", "Frame diff: %lu tiles unchanged, %lu changed, %lu frames skipped",
+              diff_tiles_unchanged, diff_tiles_changed, frames_skipped);
+    LOG_INFOF("LVGL", "Panel power: %s, %lu early power-ons, %lu idle power-offs",
+              epd_display && epd_display->epd2.isPoweredOn() ? "on" : "off",
+              panel_early_ons, panel_idle_offs);
+    LOG_INFOF("LVGL", "Ghosting: worst tile %u, %u tiles due, %lu regions cleaned",
+              refresh_policy.getWorstTile(), refresh_policy.getGhostedTiles(),
+              refresh_policy.getRegionsCleaned());
+    LOG_INFOF("LVGL", "Touch: %lu samples, %lu dropped, %lu jitter suppressed",
+              touch_pipeline.getSamples(), touch_pipeline.getSamplesDropped(),
+              touch_pipeline.getJitterSuppressed());
+    keypad_stats_t keys;
+    keypad_get_stats(&keys);
+    LOG_INFOF("LVGL", "Keys: %lu events in %lu bursts, %lu dropped, %lu FIFO overflows",
+              keys.events, keys.bursts, keys.dropped, keys.overflows);
+    if (keys.glyph_count > 0) {
+        LOG_INFOF("LVGL", "Key to glyph: last %lu ms, avg %lu ms, max %lu ms",
+                  keys.glyph_last_ms, keys.glyph_avg_ms, keys.glyph_max_ms);
+    }
+    if (frames_flushed > 0) {
+        LOG_INFOF("LVGL", "Average frame: pack %lu us, panel %lu us",
+                  total_pack_us / frames_flushed, total_commit_us / frames_flushed);
+    }
+    if (profiler.isEnabled()) {
+        profiler.printHistogram();
+    }
+    input_trace_print();
+    lvgl_mem_print_stats();
+    glyph_cache_print_stats();
+}
+
 lv_obj_t* LVGLIntegration::createScreen() {
     if (!initialized) {
         return nullptr;
@@ -280,7 +1520,7 @@ lv_obj_t* LVGLIntegration::createScreen() {
 void LVGLIntegration::setActiveScreen(lv_obj_t* screen) {
     if (initialized && screen) {
         lv_scr_load(screen);
-        display_needs_refresh = true;
+        full_refresh_pending = true;
     }
 }
 
@@ -291,6 +1531,28 @@ void LVGLIntegration::deinit() {
     
     LOG_INFO("LVGL", "Deinitializing LVGL integration...");
     
+    scr_mgr_set_snapshot_ops(nullptr);
+    glyph_cache_deinit();
+    
+    // Stop panel I/O before its buffers go away
+    if (flush_task) {
+        if (!waitFlushIdle()) {
+            LOG_WARN("LVGL", "Flush task still busy at deinit");
+        }
+        vTaskDelete(flush_task);
+        flush_task = nullptr;
+    }
+    detachInterrupt(digitalPinToInterrupt(BOARD_TOUCH_INT));
+    if (busy_semaphore) {
+        detachInterrupt(digitalPinToInterrupt(BOARD_EPD_BUSY));
+        if (epd_display) {
+            epd_display->epd2.setBusyCallback(nullptr);
+            epd_display->epd2.setTransferCallback(nullptr);
+        }
+        vSemaphoreDelete(busy_semaphore);
+        busy_semaphore = nullptr;
+    }
+    
     // Free buffers
     if (buf1) {
         free(buf1);
@@ -300,10 +1562,25 @@ void LVGLIntegration::deinit() {
         free(buf2);
         buf2 = nullptr;
     }
+    if (framebuffer) {
+        free(framebuffer);
+        framebuffer = nullptr;
+    }
+    if (front_buffer) {
+        free(front_buffer);
+        front_buffer = nullptr;
+    }
+    if (rotated_sent) {
+        free(rotated_sent);
+        rotated_sent = nullptr;
+    }
+    sent_buffer = nullptr;
     
     // Reset state
     display = nullptr;
     touch_indev = nullptr;
+    keypad_indev = nullptr;
+    keypad_group = nullptr;
     epd_display = nullptr;
     touch_controller = nullptr;
     initialized = false;
@@ -15,11 +15,75 @@
 #include <GxEPD2_BW.h>
 #include <TouchDrvCSTXXX.hpp>
 #include "utilities.h"
+#include "refresh_policy.h"
+#include "display_profiler.h"
+#include "input_trace.h"
+#include "touch_pipeline.h"
 
-// Display configuration
-#define LVGL_DISPLAY_WIDTH  320
-#define LVGL_DISPLAY_HEIGHT 240
-#define LVGL_BUFFER_SIZE    (LVGL_DISPLAY_WIDTH * LVGL_DISPLAY_HEIGHT / 8)  // 1-bit display
+// Display configuration (matches the GDEQ031T10 panel geometry)
+#define LVGL_DISPLAY_WIDTH  LCD_HOR_SIZE
+#define LVGL_DISPLAY_HEIGHT LCD_VER_SIZE
+
+// Render band: LVGL draws the invalidated area one horizontal slice at a time
+// into this buffer before it lands in the framebuffer below
+#define LVGL_BAND_DIVISOR   10    // Band height as a fraction of the screen
+#define LVGL_BAND_ROWS      ((LVGL_DISPLAY_HEIGHT + LVGL_BAND_DIVISOR - 1) / LVGL_BAND_DIVISOR)
+#define LVGL_BUFFER_SIZE    (LVGL_DISPLAY_WIDTH * LVGL_BAND_ROWS)
+#define LVGL_BAND_IN_SRAM   1     // Place band buffers in internal RAM, PSRAM as fallback
+
+// Packed 1bpp framebuffer in panel RAM format (MSB first, 1 = white)
+#define LVGL_FB_STRIDE      (LVGL_DISPLAY_WIDTH / 8)
+#define LVGL_FB_SIZE        (LVGL_FB_STRIDE * LVGL_DISPLAY_HEIGHT)
+
+// setRotation(2) + mirror(true) in SimpleHardware::initDisplay() reduce to a
+// vertical flip in panel RAM, so frames are written with mirror_y set
+#define LVGL_FB_MIRROR_Y    true
+
+// Blend straight into the packed framebuffer (lvgl_draw_1bpp) instead of
+// rendering lv_color_t bands and packing them in the flush callback
+#define LVGL_DRAW_DIRECT_1BPP   1
+
+// E-paper shows no motion: animations jump to their end (ui_anim_policy.h).
+// UI_ANIM_FULL for a panel that refreshes at the anim timer's rate
+#define LVGL_ANIM_POLICY        UI_ANIM_FINAL
+
+// Partial refresh scheduling
+#define LVGL_MAX_DIRTY_RECTS        4     // Merged rectangles pushed per frame
+#define LVGL_FULL_REFRESH_COVERAGE  75    // Percent of the panel above which a full refresh is cheaper
+#define LVGL_DIFF_TILE_WIDTH        32    // Frame-diff tile, one 32-bit word per row
+#define LVGL_DIFF_TILE_HEIGHT       16
+#define LVGL_TEXT_UPDATE_MAX_AREA   (LVGL_DISPLAY_WIDTH * LVGL_DISPLAY_HEIGHT / 8)  // Largest rect sent with the text waveform
+
+// Panel I/O task (the Arduino loop and LVGL run on core 1)
+#define LVGL_FLUSH_TASK_CORE        0
+#define LVGL_FLUSH_TASK_PRIORITY    2
+#define LVGL_FLUSH_TASK_STACK       4096
+#define LVGL_FLUSH_WATCH_MS         5000    // A full refresh is well under this
+#define LVGL_FLUSH_IDLE_TIMEOUT_MS  5000
+#define LVGL_PANEL_OFF_IDLE_MS      2000    // Driving voltages kept up this long for the next update
+
+// Demand-driven UI loop: the caller sleeps until touch/keypad INT, a flush
+// completing or the next LVGL timer deadline instead of polling
+#define LVGL_TOUCH_READ_PERIOD_MS   10    // Touch read rate while a finger is down
+#define LVGL_TOUCH_BUS_WAIT_MS      5     // Longest wait for the I2C bus before skipping a sample
+#define LVGL_IDLE_WAIT_MAX_MS       1000  // Longest sleep, bounds the refresh and ghost-clean checks
+
+// "screens" console export of the per-screen accounting in ui_scr_mrg
+#define LVGL_SCREEN_STATS_MAX       48
+
+// Panel work handed to the flush task
+enum FlushJobType {
+    FLUSH_JOB_FULL,      // Full-waveform refresh of the whole panel
+    FLUSH_JOB_PARTIAL,   // Partial refresh of the listed rectangles
+    FLUSH_JOB_CLEAN      // Ghost-clearing pass over the first rectangle
+};
+
+struct FlushJob {
+    FlushJobType type;
+    lv_area_t rects[LVGL_MAX_DIRTY_RECTS];
+    uint8_t count;
+    input_trace_t trace; // The input this frame is the first to show, if traced
+};
 
 // Forward declarations
 class SimpleHardware;
@@ -37,12 +101,30 @@ private:
     // LVGL objects
     lv_disp_t* display;
     lv_indev_t* touch_indev;
+    lv_indev_t* keypad_indev;
+    lv_group_t* keypad_group;       // Default group, so new widgets take keys
     
     // Display buffers
     lv_disp_draw_buf_t draw_buf;
     lv_color_t* buf1;
     lv_color_t* buf2;
     
+    // Packed framebuffers: LVGL packs into the back buffer while the
+    // flush task sends the front buffer to the panel
+    uint8_t* framebuffer;
+    uint8_t* front_buffer;
+    
+    // Rotation: LVGL lays the frame out for the turned display and the
+    // front buffer gets it rotated back to panel order. The frame diff needs
+    // the last frame in LVGL's layout, which is the front buffer unrotated
+    lv_disp_rot_t rotation;
+    lv_coord_t fb_width;            // Framebuffer geometry as LVGL sees it
+    lv_coord_t fb_height;
+    uint16_t fb_stride;
+    uint8_t* sent_buffer;           // Last frame sent, LVGL layout
+    uint8_t* rotated_sent;          // Its own allocation once rotated
+    uint32_t last_rotate_us;
+    
     // Hardware references
     GxEPD2_BW<GxEPD2_310_GDEQ031T10, GxEPD2_310_GDEQ031T10::HEIGHT>* epd_display;
     TouchDrvCSTXXX* touch_controller;
@@ -52,6 +134,64 @@ private:
     bool display_needs_refresh;
     uint32_t last_refresh_time;
     uint32_t refresh_interval_ms;
+    uint32_t clean_idle_ms;             // Idle time before ghosted regions are cleaned
+    
+    // Flush statistics (microseconds)
+    uint32_t frames_flushed;
+    uint32_t frame_pack_us;
+    uint32_t last_pack_us;
+    uint32_t last_commit_us;
+    uint32_t total_pack_us;
+    uint32_t total_commit_us;
+    
+    // Dirty-rectangle scheduler state (byte-aligned, LVGL coordinates)
+    lv_area_t dirty_rects[LVGL_MAX_DIRTY_RECTS];
+    uint8_t dirty_count;
+    bool full_refresh_pending;
+    bool snapshot_restore;          // Next frame restores a cached screen
+    bool panel_kept;                // Panel still shows the screen from before deep sleep
+    lv_obj_t* last_screen;
+    uint32_t partial_updates;
+    uint32_t full_updates;
+    
+    // Frame-diff statistics
+    uint32_t diff_tiles_unchanged;
+    uint32_t diff_tiles_changed;
+    uint32_t frames_skipped;
+    
+    // Panel power: the controller stays initialised, only its driving
+    // voltages are switched
+    uint32_t panel_early_ons;       // Powered up while LVGL was still rendering
+    uint32_t panel_idle_offs;       // Powered down after LVGL_PANEL_OFF_IDLE_MS without an update
+    
+    // Per-tile ghosting accounting
+    RefreshPolicy refresh_policy;
+    
+    // Pipeline timing
+    DisplayProfiler profiler;
+    
+    // INT-fed touch samples, filtered before LVGL sees them
+    TouchPipeline touch_pipeline;
+    
+    // Governor lock held from render start until lv_timer_handler() returns
+    int render_lock;
+    bool render_boost;
+    
+    // Flush task state
+    TaskHandle_t flush_task;
+    FlushJob flush_job;
+    volatile bool flush_busy;
+    bool frame_deferred;
+    bool blanked;                   // Proximity: panel updates held, touch off
+    static SemaphoreHandle_t busy_semaphore;
+    
+    // UI loop wake-up
+    TaskHandle_t ui_task;           // Task blocked in waitForWork()
+    uint32_t next_work_time;        // millis() of the next LVGL timer deadline
+    static volatile bool touch_irq;
+    static volatile uint32_t touch_irq_us;  // First touch INT not yet sampled
+    input_tag_t touch_tag;          // Last sample, until touch_read_cb hands it to LVGL
+    bool remote_touch;              // Screen mirror press down, no INT to poll for
     
     // Private constructor for singleton
     LVGLIntegration();
@@ -59,11 +199,51 @@ private:
     // Static callback functions for LVGL
     static void display_flush_cb(lv_disp_drv_t* disp_drv, const lv_area_t* area, lv_color_t* color_p);
     static void touch_read_cb(lv_indev_drv_t* indev_drv, lv_indev_data_t* data);
+    static void keypad_read_cb(lv_indev_drv_t* indev_drv, lv_indev_data_t* data);
+    static void rounder_cb(lv_disp_drv_t* disp_drv, lv_area_t* area);
+    static void render_start_cb(lv_disp_drv_t* disp_drv);
+    
+    // Flush task and BUSY line handling
+    static void flush_task_fn(void* param);
+    static void busy_isr();
+    static void busy_wait_cb(const void* param);
+    static void transfer_break_cb(const void* param);
+    static void touch_isr();
+    void wakeFromISR();
+    
+    // Screen manager snapshot hooks
+    static void snapshot_save_cb(uint8_t* buf);
+    static void snapshot_show_cb(const uint8_t* buf);
     
     // Internal methods
     bool initDisplay();
     bool initTouch();
+    bool initKeypad();
+    void attachWakeSources();
+    void sampleTouch();
     void setupMonochromeTheme();
+    
+    // Flush engine
+    void packArea(uint8_t* fb, const lv_area_t* area, const lv_color_t* color_p);
+    void publishFrame();
+    void mapToPanel(lv_area_t* rect);
+    void commitFrame(bool full_refresh);
+    void commitRect(const lv_area_t* rect);
+    void cleanRect(const lv_area_t* rect);
+    
+    // Refresh scheduler
+    void addDirtyRect(const lv_area_t* area);
+    void mergeDirtyRects();
+    bool diffRect(lv_area_t* rect);
+    void diffDirtyRects();
+    bool shouldRefreshFull();
+    void submitFrame();
+    void submitJob();
+    void runJob(const FlushJob& job);
+    void setPanelPower(bool on);
+    bool startFlushTask();
+    void cleanGhostedRegion();
+    uint32_t getIdleTime();
 
 public:
     // Singleton access
@@ -75,12 +255,34 @@ public:
     void deinit();
     
     // Main loop functions
-    void update();
+    uint32_t update();              // Returns ms until LVGL has work again
+    void waitForWork(uint32_t max_ms = LVGL_IDLE_WAIT_MAX_MS);
+    void wake();                    // Cut waitForWork() short from another task
+    TouchGesture takeTouchGesture() { return touch_pipeline.takeGesture(); }
+    TouchPipeline* getTouchPipeline() { return &touch_pipeline; }
     void forceRefresh();
     
     // Display management
     void setRefreshInterval(uint32_t interval_ms);
     bool isDisplayReady();
+    void requestFullRefresh();
+    bool waitFlushIdle(uint32_t timeout_ms = LVGL_FLUSH_IDLE_TIMEOUT_MS);
+    bool isFlushBusy() { return flush_busy; }
+    void showSnapshot(const uint8_t* snapshot);
+    void resumeOnPanel();
+    void setFullRefreshBudget(uint16_t partial_updates);
+    void setCleanIdle(uint32_t idle_ms);    // Default REFRESH_CLEAN_IDLE_MS
+    bool setRotation(lv_disp_rot_t rot);    // UI task; full refresh in the new layout
+    void setBlanked(bool blank);            // UI task; frames are held, not dropped
+    bool isBlanked() { return blanked; }
+    lv_disp_rot_t getRotation() { return rotation; }
+    const uint8_t* getPanelFrame() { return front_buffer; }  // Panel layout, as on the glass once flushes are idle
+    
+    // Flush diagnostics
+    uint32_t benchmarkFlush(uint16_t frames = 16);
+    void printStatus();
+    void enableProfiling(bool enabled, bool overlay = false);
+    DisplayProfiler* getProfiler() { return &profiler; }
     
     // Theme and styling
     void applyMonochromeTheme();
@@ -93,6 +295,12 @@ public:
     // Status
     bool isInitialized() { return initialized; }
     uint32_t getLastRefreshTime() { return last_refresh_time; }
+    uint32_t getFramesFlushed() { return frames_flushed; }
+    uint32_t getLastPackTime() { return last_pack_us; }
+    uint32_t getLastCommitTime() { return last_commit_us; }
+    uint32_t getPartialUpdates() { return partial_updates; }
+    uint32_t getFullUpdates() { return full_updates; }
+    uint32_t getFramesSkipped() { return frames_skipped; }
 };
 
 // Global LVGL integration instance
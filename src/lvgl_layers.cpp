@@ -0,0 +1,132 @@
+/**
+ * @file      lvgl_layers.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Chrome registry and the invalidation trim
+ */
+
+#include "lvgl_layers.h"
+
+struct ChromeLayer {
+    lv_obj_t* obj;
+    lv_area_t drawn;            // Where the framebuffer holds it
+    bool valid;                 // drawn is current
+};
+
+static ChromeLayer layers[LVGL_LAYERS_MAX];
+static uint8_t layer_count = 0;
+static uint32_t trimmed = 0;
+static uint32_t pixels_saved = 0;
+
+// ===== Registry =====
+
+static void chrome_delete_cb(lv_event_t* e) {
+    lv_obj_t* obj = lv_event_get_target(e);
+    for (uint8_t i = 0; i < layer_count; i++) {
+        if (layers[i].obj == obj) {
+            layers[i] = layers[--layer_count];
+            return;
+        }
+    }
+}
+
+bool lvgl_layers_add_static(lv_obj_t* obj) {
+    if (!obj || layer_count >= LVGL_LAYERS_MAX) {
+        return false;
+    }
+    ChromeLayer* layer = &layers[layer_count++];
+    layer->obj = obj;
+    layer->valid = false;
+    lv_obj_add_event_cb(obj, chrome_delete_cb, LV_EVENT_DELETE, NULL);
+    return true;
+}
+
+// ===== Trim =====
+
+// Shown on the settled active screen, so its pixels are the ones flushed
+static bool chrome_shown(lv_disp_t* disp, lv_obj_t* obj) {
+    if (disp->prev_scr || disp->scr_to_load || lv_obj_get_screen(obj) != disp->act_scr) {
+        return false;
+    }
+    for (lv_obj_t* o = obj; o; o = lv_obj_get_parent(o)) {
+        if (lv_obj_has_flag(o, LV_OBJ_FLAG_HIDDEN)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool trim_at(lv_area_t* area, const lv_area_t* band) {
+    if (_lv_area_is_in(area, band, 0)) {
+        return false;       // The chrome's own change
+    }
+    if (band->x1 <= area->x1 && band->x2 >= area->x2) {
+        if (band->y1 <= area->y1 && band->y2 >= area->y1) {
+            area->y1 = band->y2 + 1;
+            return true;
+        }
+        if (band->y1 <= area->y2 && band->y2 >= area->y2) {
+            area->y2 = band->y1 - 1;
+            return true;
+        }
+    }
+    if (band->y1 <= area->y1 && band->y2 >= area->y2) {
+        if (band->x1 <= area->x1 && band->x2 >= area->x1) {
+            area->x1 = band->x2 + 1;
+            return true;
+        }
+        if (band->x1 <= area->x2 && band->x2 >= area->x2) {
+            area->x2 = band->x1 - 1;
+            return true;
+        }
+    }
+    return false;
+}
+
+void lvgl_layers_trim(lv_disp_t* disp, lv_area_t* area) {
+    // The rounder is also probed with made-up areas while rendering
+    if (!disp || disp->rendering_in_progress || !layer_count) {
+        return;
+    }
+    if (lv_obj_get_child_cnt(disp->top_layer) > 0) {
+        return;
+    }
+
+    for (uint8_t i = 0; i < layer_count; i++) {
+        ChromeLayer* layer = &layers[i];
+        lv_area_t now;
+        if (!layer->valid || !chrome_shown(disp, layer->obj)) {
+            continue;
+        }
+        lv_obj_get_coords(layer->obj, &now);
+        if (memcmp(&now, &layer->drawn, sizeof(now)) != 0) {
+            continue;
+        }
+        uint32_t before = lv_area_get_size(area);
+        if (trim_at(area, &layer->drawn)) {
+            trimmed++;
+            pixels_saved += before - lv_area_get_size(area);
+        }
+    }
+}
+
+void lvgl_layers_frame_done(lv_disp_t* disp) {
+    for (uint8_t i = 0; i < layer_count; i++) {
+        ChromeLayer* layer = &layers[i];
+        layer->valid = disp && chrome_shown(disp, layer->obj);
+        if (layer->valid) {
+            lv_obj_get_coords(layer->obj, &layer->drawn);
+        }
+    }
+}
+
+void lvgl_layers_get_stats(LVGLLayerStats* stats) {
+    if (!stats) {
+        return;
+    }
+    stats->trimmed = trimmed;
+    stats->pixels_saved = pixels_saved;
+    stats->chrome = layer_count;
+}
@@ -0,0 +1,65 @@
+/**
+ * @file      lvgl_layers.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Static chrome layer: invalidations from dynamic widgets stop at the chrome's edge
+ */
+
+#ifndef LVGL_LAYERS_H
+#define LVGL_LAYERS_H
+
+#include <Arduino.h>
+#include <lvgl.h>
+
+/**
+ * The packed framebuffer persists between frames, so chrome that has been
+ * drawn once (taskbar, back button, screen title) already is the static
+ * layer; what costs render time is redrawing it. That happens whenever a
+ * dynamic widget's invalidated area, or two areas LVGL joins, reaches into
+ * the chrome: LVGL repaints every object under the area, chrome included.
+ *
+ * Chrome objects registered here are treated as the top layer over their
+ * own rectangle. Once such an object has been flushed at its current
+ * position, an invalidation that overlaps it from the outside is trimmed
+ * back to the chrome's edge and only the dynamic part is rendered. The
+ * chrome's own invalidations (a new battery figure, the title text) lie
+ * inside its rectangle and go through untouched, as does everything while
+ * a screen animates or lv_layer_top() holds a popup that may cover it.
+ *
+ * Only trims that leave a rectangle are made: the chrome has to span the
+ * area's full width or height and sit at one of its edges, as the
+ * full-width taskbar does for anything beneath it. A registered object must be
+ * opaque over its rectangle, or at least have nothing dynamic beneath it.
+ */
+
+#define LVGL_LAYERS_MAX     16  // Chrome objects tracked at once, across the screen stack
+
+struct LVGLLayerStats {
+    uint32_t trimmed;           // Invalidated areas cut back at a chrome edge
+    uint32_t pixels_saved;      // Pixels those areas no longer render
+    uint8_t chrome;             // Objects registered
+};
+
+/**
+ * @brief Register obj as static chrome. Dropped again when obj is deleted
+ * @return false when LVGL_LAYERS_MAX objects are registered already
+ */
+bool lvgl_layers_add_static(lv_obj_t* obj);
+
+/**
+ * @brief Trim an invalidated area, from the display's rounder_cb before any
+ *        other rounding
+ */
+void lvgl_layers_trim(lv_disp_t* disp, lv_area_t* area);
+
+/**
+ * @brief A frame has been flushed: record where each chrome object now is in
+ *        the framebuffer. From the flush callback's last band
+ */
+void lvgl_layers_frame_done(lv_disp_t* disp);
+
+void lvgl_layers_get_stats(LVGLLayerStats* stats);
+
+#endif // LVGL_LAYERS_H
@@ -0,0 +1,176 @@
+/**
+ * @file      lvgl_mem.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Tiered LVGL allocator implementation
+ */
+
+#include "lvgl_mem.h"
+#include "simple_logger.h"
+#include <esp_heap_caps.h>
+#include <multi_heap.h>
+
+// Internal-RAM pool managed by the IDF multi_heap (TLSF) allocator
+static uint8_t pool_memory[LVGL_MEM_POOL_SIZE] __attribute__((aligned(4)));
+static multi_heap_handle_t pool_heap = nullptr;
+
+static uint32_t pool_allocs = 0;
+static uint32_t psram_allocs = 0;
+static uint32_t fallback_allocs = 0;
+static uint32_t failed_allocs = 0;
+
+static bool pool_ready() {
+    // LVGL allocates from lv_init(), before any code of ours runs, so set up lazily
+    if (!pool_heap) {
+        pool_heap = multi_heap_register(pool_memory, sizeof(pool_memory));
+    }
+    return pool_heap != nullptr;
+}
+
+static bool in_pool(const void* ptr) {
+    const uint8_t* p = (const uint8_t*)ptr;
+    return p >= pool_memory && p < pool_memory + sizeof(pool_memory);
+}
+
+static void* alloc_psram(size_t size) {
+    return heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+}
+
+static void* alloc_pool(size_t size) {
+    return pool_ready() ? multi_heap_malloc(pool_heap, size) : nullptr;
+}
+
+extern "C" void* lvgl_mem_alloc(size_t size) {
+    bool small = size < LVGL_MEM_SMALL_THRESHOLD;
+    void* ptr = small ? alloc_pool(size) : alloc_psram(size);
+    
+    if (ptr) {
+        if (small) {
+            pool_allocs++;
+        } else {
+            psram_allocs++;
+        }
+        return ptr;
+    }
+    
+    // Preferred tier is full: try the other one, then any byte-addressable heap
+    ptr = small ? alloc_psram(size) : alloc_pool(size);
+    if (!ptr) {
+        ptr = heap_caps_malloc(size, MALLOC_CAP_8BIT);
+    }
+    
+    if (ptr) {
+        fallback_allocs++;
+    } else {
+        failed_allocs++;
+    }
+    return ptr;
+}
+
+extern "C" void lvgl_mem_free(void* ptr) {
+    if (!ptr) {
+        return;
+    }
+    
+    if (in_pool(ptr)) {
+        multi_heap_free(pool_heap, ptr);
+    } else {
+        heap_caps_free(ptr);
+    }
+}
+
+extern "C" void* lvgl_mem_realloc(void* ptr, size_t new_size) {
+    if (!ptr) {
+        return lvgl_mem_alloc(new_size);
+    }
+    
+    if (!in_pool(ptr)) {
+        // heap_caps_realloc keeps the block in a heap with matching caps
+        void* moved = heap_caps_realloc(ptr, new_size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (!moved) {
+            moved = heap_caps_realloc(ptr, new_size, MALLOC_CAP_8BIT);
+        }
+        if (!moved) {
+            failed_allocs++;
+        }
+        return moved;
+    }
+    
+    // Pool blocks that stay small are resized in place when possible
+    if (new_size < LVGL_MEM_SMALL_THRESHOLD) {
+        void* resized = multi_heap_realloc(pool_heap, ptr, new_size);
+        if (resized) {
+            return resized;
+        }
+    }
+    
+    // Growing past the threshold (or no room in the pool): move to a new block
+    void* moved = lvgl_mem_alloc(new_size);
+    if (!moved) {
+        return nullptr;
+    }
+    
+    size_t old_size = multi_heap_get_allocated_size(pool_heap, ptr);
+    memcpy(moved, ptr, old_size < new_size ? old_size : new_size);
+    multi_heap_free(pool_heap, ptr);
+    return moved;
+}
+
+static uint8_t fragmentation(size_t free_bytes, size_t largest_free) {
+    if (free_bytes == 0) {
+        return 0;
+    }
+    return (uint8_t)(100 - (largest_free * 100) / free_bytes);
+}
+
+void lvgl_mem_get_stats(LVGLMemStats* stats) {
+    if (!stats) {
+        return;
+    }
+    
+    memset(stats, 0, sizeof(LVGLMemStats));
+    stats->pool_allocs = pool_allocs;
+    stats->psram_allocs = psram_allocs;
+    stats->fallback_allocs = fallback_allocs;
+    stats->failed_allocs = failed_allocs;
+    
+    if (pool_ready()) {
+        multi_heap_info_t info;
+        multi_heap_get_info(pool_heap, &info);
+        stats->pool_total = info.total_free_bytes + info.total_allocated_bytes;
+        stats->pool_free = info.total_free_bytes;
+        stats->pool_min_free = info.minimum_free_bytes;
+        stats->pool_largest_free = info.largest_free_block;
+        stats->pool_fragmentation = fragmentation(info.total_free_bytes, info.largest_free_block);
+    }
+    
+    multi_heap_info_t psram_info;
+    heap_caps_get_info(&psram_info, MALLOC_CAP_SPIRAM);
+    stats->psram_free = psram_info.total_free_bytes;
+    stats->psram_largest_free = psram_info.largest_free_block;
+    stats->psram_fragmentation = fragmentation(psram_info.total_free_bytes, psram_info.largest_free_block);
+}
+
+uint32_t lvgl_mem_used() {
+    size_t used = heap_caps_get_total_size(MALLOC_CAP_SPIRAM) - heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+    if (pool_ready()) {
+        used += LVGL_MEM_POOL_SIZE - multi_heap_free_size(pool_heap);
+    }
+    return used;
+}
+
+void lvgl_mem_print_stats() {
+    LVGLMemStats stats;
+    lvgl_mem_get_stats(&stats);
+    
+    LOG_INFO("LVGL", "=== LVGL Memory ===");
+    LOG_INFOF("LVGL", "Allocations: %lu pool, %lu PSRAM, %lu fallback, %lu failed",
+              stats.pool_allocs, stats.psram_allocs, stats.fallback_allocs, stats.failed_allocs);
+    LOG_INFOF("LVGL", "Pool: %u/%u bytes free (min %u), largest %u, fragmentation %u%%",
+              stats.pool_free, stats.pool_total, stats.pool_min_free,
+              stats.pool_largest_free, stats.pool_fragmentation);
+    LOG_INFOF("LVGL", "PSRAM: %u bytes free, largest %u, fragmentation %u%%",
+              stats.psram_free, stats.psram_largest_free, stats.psram_fragmentation);
+}
@@ -0,0 +1,55 @@
+/**
+ * @file      lvgl_mem.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Tiered LVGL allocator: internal-RAM pool for small blocks, PSRAM for large ones
+ */
+
+#ifndef LVGL_MEM_H
+#define LVGL_MEM_H
+
+#include <Arduino.h>
+
+// Allocator configuration
+#define LVGL_MEM_POOL_SIZE        (32U * 1024U)  // Internal SRAM reserved for small LVGL blocks
+#define LVGL_MEM_SMALL_THRESHOLD  256            // Requests below this go to the internal pool
+
+// lvgl_mem_alloc / lvgl_mem_free / lvgl_mem_realloc are declared in config/lv_conf.h
+// so LVGL can call them; the functions below are for diagnostics only
+
+struct LVGLMemStats {
+    uint32_t pool_allocs;         // Small blocks served by the internal pool
+    uint32_t psram_allocs;        // Blocks served by PSRAM
+    uint32_t fallback_allocs;     // Blocks that had to fall back to the other tier
+    uint32_t failed_allocs;       // Requests nothing could satisfy
+    size_t pool_total;
+    size_t pool_free;
+    size_t pool_min_free;         // Low-water mark of the internal pool
+    size_t pool_largest_free;
+    size_t psram_free;
+    size_t psram_largest_free;
+    uint8_t pool_fragmentation;   // Percent of free pool memory outside the largest block
+    uint8_t psram_fragmentation;
+};
+
+/**
+ * @brief Fill in current allocator counters and heap fragmentation
+ */
+void lvgl_mem_get_stats(LVGLMemStats* stats);
+
+/**
+ * @brief Pool bytes allocated plus PSRAM in use by anyone. Cheap; a
+ *        difference across a short stretch of the UI task approximates
+ *        what LVGL took in it, lv_mem_monitor() being empty with
+ *        LV_MEM_CUSTOM
+ */
+uint32_t lvgl_mem_used();
+
+/**
+ * @brief Log allocator counters and fragmentation
+ */
+void lvgl_mem_print_stats();
+
+#endif // LVGL_MEM_H
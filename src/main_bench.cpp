@@ -0,0 +1,46 @@
+/**
+ * @file      main_bench.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Benchmark build: bring up the hardware, run the suite, repeat on a key
+ *
+ *   pio run -e T-Deck-Pro-Bench -t upload && pio device monitor | grep ^BENCH
+ *
+ * The suite runs once after boot and again for every 'b' sent over serial.
+ */
+
+#include <Arduino.h>
+#include "simple_logger.h"
+#include "simple_hardware.h"
+#include "bench_suite.h"
+
+static bool hardware_ready = false;
+
+void setup() {
+    Serial.begin(115200);
+    delay(1000); // Let the host open the port before the first results
+
+    // Warnings only, so the BENCH lines are not buried in boot logs
+    SimpleLogger* logger = SimpleLogger::getInstance();
+    if (!logger->init(LOG_WARN)) {
+        Serial.println("ERROR: Failed to initialize logger");
+        return;
+    }
+
+    SimpleHardware* hardware = SimpleHardware::getInstance();
+    hardware_ready = hardware->init();
+    if (!hardware_ready) {
+        LOG_WARN("Bench", "Hardware initialization incomplete, some benchmarks will skip");
+    }
+
+    bench_suite_run(Serial);
+}
+
+void loop() {
+    if (Serial.available() && Serial.read() == 'b') {
+        bench_suite_run(Serial);
+    }
+    delay(10);
+}
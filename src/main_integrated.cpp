@@ -4,21 +4,69 @@
  * @license   MIT
  * @copyright Copyright (c) 2025
  * @date      2025-01-11
- * @brief     Integrated main entry point for T-Deck-Pro OS (Phase 1 + Phase 2)
+ * @brief     Main entry point for T-Deck-Pro OS: the boot pipeline and the main loop
+ *
+ * Boot order lives in the stage table below. Critical steps (logger, buses,
+ * power) run first, then the splash and input bring-up side by side, then
+ * the menu; radios, network and services follow in the background.
  */
 
 #include <Arduino.h>
 #include "simple_logger.h"
 #include "simple_hardware.h"
+#include "boot_trace.h"
+#include "boot_pipeline.h"
+#include "net_manager.h"
+#include "gps_assist.h"
+#include "time_service.h"
+#include "geofence.h"
+#include "tsdb.h"
+#include "espnow_link.h"
+#include "ble_link.h"
+#include "mqtt_client.h"
+#include "wg_tunnel.h"
+#include "power_governor.h"
+#include "energy_profiler.h"
+#include "cpu_profiler.h"
+#include "resume_state.h"
+#include "crash_dump.h"
+#include "task_stack.h"
+#include "wake_monitor.h"
+#include "mem_trace.h"
+#include "metrics.h"
+#include "task_watch.h"
+#include "msg_store.h"
+#include "text_search.h"
+#include "font_pager.h"
+#include "ota_update.h"
+#include "screen_mirror.h"
+#include "usb_msc.h"
+#include "usb_console.h"
+#include "event_replay.h"
+#include "lora_capture.h"
+#include "asset_store.h"
+#include "dir_index.h"
+#include "modem_sms.h"
+#include "predict.h"
+#include "batt_forecast.h"
+#include "modem_power.h"
+#include "modem_ppp.h"
+#include "dl_manager.h"
+#include "mesh_proto.h"
+#include "sensor_sampler.h"
+#include "nav_fusion.h"
+#include "status_glance.h"
+#include "radio_sched.h"
+#include "lora_gateway.h"
 
-// Phase 2 Integration Layer (conditional compilation)
-// TEMPORARILY DISABLED FOR DEBUGGING
-//#ifdef INTEGRATION_LAYER_ENABLED
-//#include "integration/service_container.h"
-//#include "integration/event_bridge.h"
-//#include "integration/config_manager.h"
-//#include "integration/service_manager.h"
-//#endif
+// Integration layer services (event bridge, config, service manager), on
+// in T-Deck-Pro-Hybrid
+#ifdef BOOT_SERVICES_ENABLED
+#include "integration/service_container.h"
+#include "integration/event_bridge.h"
+#include "integration/config_manager.h"
+#include "integration/service_manager.h"
+#endif
 
 #ifdef LVGL_INTEGRATION_ENABLED
 #include "lvgl_integration.h"
@@ -28,213 +76,405 @@
 SimpleLogger* logger = nullptr;
 SimpleHardware* hardware = nullptr;
 
-// TEMPORARILY DISABLED FOR DEBUGGING
-//#ifdef INTEGRATION_LAYER_ENABLED
-//ServiceContainer* serviceContainer = nullptr;
-//EventBridge* eventBridge = nullptr;
-//ConfigManager* configManager = nullptr;
-//ServiceManager* serviceManager = nullptr;
-//#endif
+#ifdef BOOT_SERVICES_ENABLED
+ServiceContainer* serviceContainer = nullptr;
+EventBridge* eventBridge = nullptr;
+ConfigManager* configManager = nullptr;
+ServiceManager* serviceManager = nullptr;
+#endif
 
 // System state
 bool system_initialized = false;
-bool phase2_enabled = false;
 uint32_t last_update_time = 0;
 uint32_t update_interval_ms = 100; // 10Hz update rate
+int loop_watch = -1;
+#define LOOP_WATCH_MS 2000         // UI and system updates stalled this long get reported
 
 // Function declarations
-bool initializePhase1();
-bool initializePhase2();
 void updateSystem();
 void handleSystemError(const char* error_msg);
 void printSystemStatus();
 
-void setup() {
-    // Initialize serial communication
-    Serial.begin(115200);
-    delay(1000); // Wait for serial to stabilize
-    
-    Serial.println("=== T-Deck-Pro OS Integrated Boot ===");
-    Serial.println("Version: 1.0.0-integrated");
-    Serial.println("Build: " __DATE__ " " __TIME__);
-    
-    // Initialize Phase 1 (Hardware Abstraction Layer)
-    if (!initializePhase1()) {
-        handleSystemError("Phase 1 initialization failed");
-        return;
-    }
-    
-    Serial.println("Phase 1 initialization complete");
-    
-#ifdef PHASE2_ENABLED
-    // Initialize Phase 2 (Integration Layer & Services)
-    if (!initializePhase2()) {
-        Serial.println("WARNING: Phase 2 initialization failed, continuing with Phase 1 only");
-        phase2_enabled = false;
-    } else {
-        Serial.println("Phase 2 initialization complete");
-        phase2_enabled = true;
+// ===== Boot stages =====
+
+static bool stage_logger() {
+    logger = SimpleLogger::getInstance();
+    if (!logger || !logger->init(LOG_INFO)) {
+        Serial.println("ERROR: Failed to initialize logger");
+        return false;
     }
-#else
-    Serial.println("Phase 2 disabled at compile time");
-#endif
-    
-    system_initialized = true;
-    printSystemStatus();
-    
-    Serial.println("=== T-Deck-Pro OS Boot Complete ===");
+    hardware = SimpleHardware::getInstance();
+    return true;
 }
 
-void loop() {
-    if (!system_initialized) {
-        delay(1000);
-        return;
+static bool stage_display() {
+    if (!hardware->initDisplay()) {
+        return false;
     }
-    
-    uint32_t current_time = millis();
-    if (current_time - last_update_time >= update_interval_ms) {
-        updateSystem();
-        last_update_time = current_time;
+    // Waking from deep sleep the panel kept its image and there is no splash
+    if (!resume_state_resuming()) {
+        boot_pipeline_splash_shown();
     }
-    
-    // Small delay to prevent watchdog issues
-    delay(1);
+    return true;
 }
 
-bool initializePhase1() {
-    Serial.println("Initializing Phase 1 components...");
-    
-    // Initialize logger
-    logger = SimpleLogger::getInstance();
-    if (!logger) {
-        Serial.println("ERROR: Failed to create logger instance");
-        return false;
-    }
+static bool stage_menu() {
+    // Whatever is left of the splash time; init ran underneath it
+    boot_pipeline_splash_wait();
+    return hardware->initLVGL();
+}
 
-    if (!logger->init(LOG_INFO)) {
-        Serial.println("ERROR: Failed to initialize logger");
+static bool stage_resume() {
+    // Screens, power mode, last fix and LoRa queue from before deep sleep
+    resume_state_restore();
+    return true;
+}
+
+static bool stage_profilers() {
+    // mAh per subsystem from the fuel gauge, for the battery screen and telemetry
+    bool ok = energy_profiler_begin();
+    // Off unless profiler.enabled; the config watch turns it on and off later
+    ok &= cpu_profiler_begin();
+    // Periodic export of the registry; recording needs no set-up
+    ok &= metrics_begin();
+    // Heartbeats, run-queue latency and stack reports; tasks add themselves
+    task_watch_begin();
+    return ok;
+}
+
+static bool stage_diagnostics() {
+    return hardware->runDiagnostics();
+}
+
+#if FEATURE_WIREGUARD_ENABLED
+static bool stage_wireguard() {
+    return wg_tunnel_begin();
+}
+#endif
+
+#if FEATURE_MQTT_ENABLED
+static bool stage_mqtt() {
+    // Own task, idle until WiFi is up; stays off without a configured broker
+    return mqtt_begin();
+}
+#endif
+
+#ifdef BOOT_SERVICES_ENABLED
+static bool stage_config() {
+    configManager = new ConfigManager(ConfigStorage::LITTLEFS);
+    return configManager->initialize();
+}
+
+static bool stage_services() {
+    serviceContainer = new ServiceContainer();
+    if (!serviceContainer->initialize()) {
+        LOG_ERROR("System", "Service Container initialization failed");
         return false;
     }
 
-    LOG_INFO("System", "Logger initialized");
-    
-    // Initialize hardware abstraction layer
-    hardware = SimpleHardware::getInstance();
-    if (!hardware) {
-        LOG_ERROR("System", "Failed to get hardware instance");
+    eventBridge = new EventBridge();
+    if (!eventBridge->initialize()) {
+        LOG_ERROR("System", "Event Bridge initialization failed");
         return false;
     }
 
-    if (!hardware->init()) {
-        LOG_ERROR("System", "Hardware initialization failed");
+    serviceManager = new ServiceManager();
+    serviceManager->setServiceContainer(std::shared_ptr<ServiceContainer>(serviceContainer));
+    serviceManager->setEventBridge(std::shared_ptr<EventBridge>(eventBridge));
+    if (configManager) {
+        serviceManager->setConfigManager(std::shared_ptr<ConfigManager>(configManager));
+    }
+    if (!serviceManager->initialize()) {
+        LOG_ERROR("System", "Service Manager initialization failed");
         return false;
     }
-    
-    LOG_INFO("System", "Hardware abstraction layer initialized");
-    
-    // Run hardware diagnostics
-    if (!hardware->runDiagnostics()) {
-        LOG_WARN("System", "Hardware diagnostics reported issues");
+    if (!serviceManager->startAllServices()) {
+        LOG_WARN("System", "Some services failed to start");
     }
-    
     return true;
 }
+#endif
 
-bool initializePhase2() {
-// TEMPORARILY DISABLED FOR DEBUGGING
-//#ifdef INTEGRATION_LAYER_ENABLED
-    LOG_INFO("System", "Phase 2 initialization temporarily disabled for debugging");
-    return true;
+static bool stage_power() { return hardware->initPowerManagement(); }
+static bool stage_buses() { return hardware->initBuses(); }
+static bool stage_input() { return hardware->initInput(); }
+static bool stage_wifi() { return hardware->initWiFi(); }
 
-/*    try {
-        // Initialize service container
-        serviceContainer = new ServiceContainer();
-        if (!serviceContainer || !serviceContainer->initialize()) {
-            LOG_ERROR("System", "Failed to initialize service container");
-            return false;
-        }
-        LOG_INFO("System", "Service container initialized");
-        
-        // Initialize event bridge
-        eventBridge = new EventBridge();
-        if (!eventBridge || !eventBridge->initialize()) {
-            LOG_ERROR("System", "Failed to initialize event bridge");
-            return false;
-        }
-        LOG_INFO("System", "Event bridge initialized");
-        
-        // Initialize configuration manager
-        configManager = new ConfigManager(ConfigStorage::LITTLEFS);
-        if (!configManager || !configManager->initialize()) {
-            LOG_ERROR("System", "Failed to initialize config manager");
-            return false;
-        }
-        LOG_INFO("System", "Configuration manager initialized");
-        
-        // Initialize service manager
-        serviceManager = new ServiceManager();
-        if (!serviceManager) {
-            LOG_ERROR("System", "Failed to create service manager");
-            return false;
-        }
-        
-        // Configure service manager with dependencies
-        serviceManager->setServiceContainer(std::shared_ptr<ServiceContainer>(serviceContainer));
-        serviceManager->setEventBridge(std::shared_ptr<EventBridge>(eventBridge));
-        serviceManager->setConfigManager(std::shared_ptr<ConfigManager>(configManager));
-        serviceManager->initializeWithHardware(hardware);
-        
-        if (!serviceManager->initialize()) {
-            LOG_ERROR("System", "Failed to initialize service manager");
-            return false;
-        }
-        LOG_INFO("System", "Service manager initialized");
-        
-        // Start all registered services
-        if (!serviceManager->startAllServices()) {
-            LOG_WARN("System", "Some services failed to start");
-        }
-        
-        LOG_INFO("System", "Phase 2 integration layer ready");
-        return true;
-        
-    } catch (const std::exception& e) {
-        LOG_ERRORF("System", "Exception during Phase 2 initialization: %s", e.what());
-        return false;
-    } catch (...) {
-        LOG_ERROR("System", "Unknown exception during Phase 2 initialization");
-        return false;
+static bool stage_sd() {
+    bool ok = hardware->initSD();
+    // Message history goes on the card when there is one, LittleFS otherwise
+    if (msg_store_begin()) {
+        text_search_begin();
     }
+    return ok;
+}
+
+static bool stage_fonts() {
+    // Optional: without the CJK font the UI is Latin only
+    font_pager_begin();
+    return true;
+}
+
+enum BootStageId {
+    STAGE_LOGGER,
+#ifdef BOOT_SERVICES_ENABLED
+    STAGE_CONFIG,
+#endif
+    STAGE_STACKS,
+    STAGE_BUSES,
+    STAGE_ASSETS,
+    STAGE_POWER,
+    STAGE_DISPLAY,
+    STAGE_INPUT,
+    STAGE_MENU,
+    STAGE_RESUME,
+    STAGE_GOVERNOR,
+    STAGE_PROFILERS,
+    STAGE_CONSOLE,
+    STAGE_SENSORS,
+    STAGE_NAV,
+    STAGE_GLANCE,
+    STAGE_WIFI,
+    STAGE_SD,
+    STAGE_FONTS,
+    STAGE_NET,
+    STAGE_TIME,
+    STAGE_TSDB,
+    STAGE_AGNSS,
+    STAGE_ESPNOW,
+    STAGE_BLE,
+#if FEATURE_WIREGUARD_ENABLED
+    STAGE_WIREGUARD,
+#endif
+#if FEATURE_MQTT_ENABLED
+    STAGE_MQTT,
+#endif
+    STAGE_OTA,
+    STAGE_MIRROR,
+    STAGE_MSC,
+    STAGE_REPLAY,
+    STAGE_CAPTURE,
+#if FEATURE_FILE_MANAGER_ENABLED
+    STAGE_DIRINDEX,
+#endif
+    STAGE_SMS,
+    STAGE_PREDICT,
+    STAGE_FORECAST,
+    STAGE_MODEM_POWER,
+    STAGE_PPP,
+    STAGE_DOWNLOAD,
+    STAGE_RADIO,
+#if FEATURE_MESHTASTIC_ENABLED
+    STAGE_MESH,
+#endif
+#if FEATURE_MQTT_ENABLED
+    STAGE_GATEWAY,
+#endif
+#ifdef BOOT_SERVICES_ENABLED
+    STAGE_SERVICES,
+    STAGE_GEOFENCE,
+#endif
+    STAGE_DIAGNOSTICS,
+    STAGE_COUNT
+};
+
+#if FEATURE_WIREGUARD_ENABLED
+#define MQTT_AFTER  BOOT_AFTER(STAGE_WIREGUARD)
 #else
-    LOG_INFO("System", "Phase 2 integration layer disabled at compile time");
-    return false;
+#define MQTT_AFTER  BOOT_AFTER(STAGE_NET)
+#endif
+
+#if FEATURE_MQTT_ENABLED
+#define OTA_AFTER   (BOOT_AFTER(STAGE_SD) | BOOT_AFTER(STAGE_MQTT))
+#else
+#define OTA_AFTER   (BOOT_AFTER(STAGE_SD) | BOOT_AFTER(STAGE_NET))
+#endif
+
+// In BootStageId order
+static const BootStage boot_stages[] = {
+    // Critical: nothing else can report or reach a device without these
+    { "logger",      stage_logger,      0,                                          BOOT_STAGE_REQUIRED | BOOT_STAGE_MAIN },
+#ifdef BOOT_SERVICES_ENABLED
+    // Loaded before any worker starts, so no step reads a half-built config
+    // and the "boot" section can switch off the optional steps below
+    { "config",      stage_config,      BOOT_AFTER(STAGE_LOGGER),                   BOOT_STAGE_MAIN },
+#endif
+    // Flash guard and stack placement, before the deferred steps start their tasks
+    { "stacks",      task_stack_begin,  BOOT_AFTER(STAGE_LOGGER),                   BOOT_STAGE_MAIN },
+    { "buses",       stage_buses,       BOOT_AFTER(STAGE_LOGGER),                   BOOT_STAGE_REQUIRED },
+    // Fonts and images mapped from flash; LVGL must not see them before this
+    { "assets",      asset_store_begin, BOOT_AFTER(STAGE_LOGGER),                   0 },
+    { "power",       stage_power,       BOOT_AFTER(STAGE_BUSES),                    BOOT_STAGE_REQUIRED },
+
+    // Splash and input side by side: the panel refresh is the long pole
+    { "display",     stage_display,     BOOT_AFTER(STAGE_BUSES),                    BOOT_STAGE_REQUIRED },
+    { "input",       stage_input,       BOOT_AFTER(STAGE_POWER),                    BOOT_STAGE_REQUIRED },
+
+    // LVGL is driven from loop(), so it is set up on the setup task
+    { "menu",        stage_menu,        BOOT_AFTER(STAGE_DISPLAY) | BOOT_AFTER(STAGE_INPUT) | BOOT_AFTER(STAGE_ASSETS),
+      BOOT_STAGE_REQUIRED | BOOT_STAGE_MAIN },
+    { "resume",      stage_resume,      BOOT_AFTER(STAGE_MENU),                     BOOT_STAGE_MAIN },
+
+    // Deferred: the menu is usable while these come up
+    // Clock follows load from here on; drivers boost through governor locks
+    { "governor",    power_governor_begin, BOOT_AFTER(STAGE_MENU),                  BOOT_STAGE_DEFERRED },
+    { "profilers",   stage_profilers,   BOOT_AFTER(STAGE_POWER),                    BOOT_STAGE_DEFERRED },
+    // Framed logs, metrics and RPC on the USB port once script/console.py says hello
+    { "console",     usb_console_begin, BOOT_AFTER(STAGE_LOGGER),                   BOOT_STAGE_DEFERRED },
+    // Gauge, light and motion read on the I2C scheduler; UI and telemetry read the snapshots
+    { "sensors",     sensor_sampler_begin, BOOT_AFTER(STAGE_POWER) | BOOT_AFTER(STAGE_CONSOLE), BOOT_STAGE_DEFERRED },
+    // Step and gyro dead reckoning between GPS fixes, which it spaces out while it holds
+    { "nav",         nav_fusion_begin,  BOOT_AFTER(STAGE_POWER) | BOOT_AFTER(STAGE_CONSOLE), BOOT_STAGE_DEFERRED },
+    // Clock, unread and battery redrawn from timer wakes while asleep
+    { "glance",      status_glance_begin, BOOT_AFTER(STAGE_CONSOLE),                BOOT_STAGE_DEFERRED },
+    { "wifi",        stage_wifi,        BOOT_AFTER(STAGE_LOGGER),                   BOOT_STAGE_DEFERRED },
+    { "sd",          stage_sd,          BOOT_AFTER(STAGE_BUSES),                    BOOT_STAGE_DEFERRED },
+    // CJK glyphs paged from flash or the card behind the Mono fonts
+    { "fonts",       stage_fonts,       BOOT_AFTER(STAGE_SD) | BOOT_AFTER(STAGE_MENU), BOOT_STAGE_DEFERRED },
+    // Failover across WiFi, 4G and LoRa; it only reads bearers the hardware brought up
+    { "net",         net_manager_begin, BOOT_AFTER(STAGE_WIFI),                     BOOT_STAGE_DEFERRED },
+    // SNTP and NITZ for the clock; GPS feeds it on its own
+    { "time",        time_service_start_sync, BOOT_AFTER(STAGE_NET),                BOOT_STAGE_DEFERRED },
+    // Battery and sensor history; samples wait for the clock, blocks go to the card
+    { "tsdb",        tsdb_begin,        BOOT_AFTER(STAGE_SD) | BOOT_AFTER(STAGE_POWER), BOOT_STAGE_DEFERRED },
+    // Cached ephemeris for the GPS, refreshed over whichever link has IP
+    { "agnss",       gps_assist_begin,  BOOT_AFTER(STAGE_NET),                      BOOT_STAGE_DEFERRED },
+    // Registers with net as a peer transport; off unless espnow.enabled
+    { "espnow",      espnow_link_begin, BOOT_AFTER(STAGE_NET),                      BOOT_STAGE_DEFERRED },
+    // Phone link; messages from the app go out through net. Off unless ble.enabled
+    { "ble",         ble_link_begin,    BOOT_AFTER(STAGE_NET),                      BOOT_STAGE_DEFERRED },
+#if FEATURE_WIREGUARD_ENABLED
+    // Before MQTT so a VPN-only broker connection never starts in the clear
+    { "wireguard",   stage_wireguard,   BOOT_AFTER(STAGE_NET),                      BOOT_STAGE_DEFERRED },
+#endif
+#if FEATURE_MQTT_ENABLED
+    { "mqtt",        stage_mqtt,        MQTT_AFTER,                                 BOOT_STAGE_DEFERRED },
+#endif
+    // Marks this image good, so a new one that never gets here is rolled back
+    { "ota",         ota_update_begin,  OTA_AFTER,                                  BOOT_STAGE_DEFERRED },
+    // Remote view for support over USB or MQTT; off unless mirror.usb or mirror.mqtt
+    { "mirror",      screen_mirror_begin, BOOT_AFTER(STAGE_MENU),                   BOOT_STAGE_DEFERRED },
+    // The card as a USB drive; only on the TinyUSB build (env T-Deck-Pro-MSC)
+    { "msc",         usb_msc_begin,     BOOT_AFTER(STAGE_SD),                       BOOT_STAGE_DEFERRED },
+    // Input traces for repeatable load; replay.play starts one once the system is up
+    { "replay",      event_replay_begin, BOOT_AFTER(STAGE_SD) | BOOT_AFTER(STAGE_CONSOLE), BOOT_STAGE_DEFERRED },
+    // LoRa frames to /capture as pcapng; capture.lora starts one at boot
+    { "capture",     lora_capture_begin, BOOT_AFTER(STAGE_SD) | BOOT_AFTER(STAGE_CONSOLE), BOOT_STAGE_DEFERRED },
+#if FEATURE_FILE_MANAGER_ENABLED
+    // Index files for the Files screen; rebuilds run on the job pool
+    { "dirindex",    dir_index_begin,   BOOT_AFTER(STAGE_SD) | BOOT_AFTER(STAGE_CONSOLE), BOOT_STAGE_DEFERRED },
+#endif
+    // Received SMS into the message store, which stage_sd starts
+    { "sms",         modem_sms_begin,   BOOT_AFTER(STAGE_SD) | BOOT_AFTER(STAGE_CONSOLE), BOOT_STAGE_DEFERRED },
+    // Word completion for the LoRa compose line, from the asset pack dictionary
+    { "predict",     predict_begin,     BOOT_AFTER(STAGE_ASSETS) | BOOT_AFTER(STAGE_CONSOLE), BOOT_STAGE_DEFERRED },
+    // Battery runtime from the profiler's attribution, seeded from the history
+    { "forecast",    batt_forecast_begin, BOOT_AFTER(STAGE_PROFILERS) | BOOT_AFTER(STAGE_TSDB) | BOOT_AFTER(STAGE_CONSOLE),
+      BOOT_STAGE_DEFERRED },
+    // PSM or eDRX and UART sleep on the modem, once it is up
+    { "modempower",  modem_power_begin, BOOT_AFTER(STAGE_CONSOLE),                  BOOT_STAGE_DEFERRED },
+    // 4G data as an lwIP PPP netif, following the route net_manager picks
+    { "ppp",         modem_ppp_begin,   BOOT_AFTER(STAGE_NET) | BOOT_AFTER(STAGE_CONSOLE), BOOT_STAGE_DEFERRED },
+    // Shared downloader into files; transfers wait for a route on their own
+    { "dl",          dl_manager_begin,  BOOT_AFTER(STAGE_SD) | BOOT_AFTER(STAGE_CONSOLE), BOOT_STAGE_DEFERRED },
+    // Periodic network work into shared wakes; tunes WiFi listen and eDRX
+    { "radio",       radio_sched_begin, BOOT_AFTER(STAGE_MODEM_POWER),              BOOT_STAGE_DEFERRED },
+#if FEATURE_MESHTASTIC_ENABLED
+    // Meshtastic packets decoded for this node; mesh.enabled joins the mesh
+    { "mesh",        mesh_proto_begin,  BOOT_AFTER(STAGE_SD) | BOOT_AFTER(STAGE_CONSOLE), BOOT_STAGE_DEFERRED },
+#endif
+#if FEATURE_MQTT_ENABLED
+    // LoRa to MQTT relay for base-camp units, gateway.enabled starts it
+    { "gateway",     lora_gateway_begin, BOOT_AFTER(STAGE_MQTT) | BOOT_AFTER(STAGE_CONSOLE), BOOT_STAGE_DEFERRED },
+#endif
+#ifdef BOOT_SERVICES_ENABLED
+    { "services",    stage_services,    BOOT_AFTER(STAGE_CONFIG),                   BOOT_STAGE_DEFERRED },
+    // Follows GPS_LOCATION_UPDATE, so it needs the event bridge; fences come off the card
+    { "geofence",    geofence_begin,    BOOT_AFTER(STAGE_SERVICES) | BOOT_AFTER(STAGE_SD), BOOT_STAGE_DEFERRED },
+#endif
+    { "diagnostics", stage_diagnostics, BOOT_AFTER(STAGE_WIFI) | BOOT_AFTER(STAGE_SD), BOOT_STAGE_DEFERRED },
+};
+
+static_assert(sizeof(boot_stages) / sizeof(boot_stages[0]) == STAGE_COUNT, "boot_stages out of step with BootStageId");
+static_assert(STAGE_COUNT <= BOOT_PIPELINE_MAX_STAGES, "More boot steps than the pipeline tracks");
+
+void setup() {
+    uint8_t setup_span = boot_trace_begin("setup");
+
+    // A glitch or a battery check that finds enough charge sleeps again from here
+    wake_monitor_begin();
+    // The clock through deep sleep or a reset, before anything stamps time
+    time_service_begin();
+    // A deep sleep wake carries on where it left off
+    resume_state_begin();
+    // Keep what the last crash left in RTC memory before anything traces over it
+    crash_dump_begin();
+
+    // No wait for the host: boot timing is in the trace printed at the end
+    Serial.begin(115200);
+
+    // Heap tracing in DEBUG builds (see [mem_trace] in platformio.ini)
+    mem_trace_begin();
+
+    Serial.println("=== T-Deck-Pro OS Boot ===");
+    Serial.println("Build: " __DATE__ " " __TIME__);
+
+    if (!boot_pipeline_run(boot_stages, STAGE_COUNT)) {
+        boot_trace_end(setup_span);
+        handleSystemError("Boot failed");
+        return;
+    }
+
+    system_initialized = true;
+    loop_watch = task_watch_add("loop", LOOP_WATCH_MS);
+    resume_state_finish();
+    boot_trace_end(setup_span);
+
+    printSystemStatus();
+}
+
+void loop() {
+    if (!system_initialized) {
+        delay(1000);
+        return;
+    }
+    task_watch_kick(loop_watch);
+
+    uint32_t current_time = millis();
+    if (current_time - last_update_time >= update_interval_ms) {
+        updateSystem();
+        last_update_time = current_time;
+    }
+
+#ifdef LVGL_INTEGRATION_ENABLED
+    // Run LVGL on demand and sleep until input, its next timer or the next system update
+    if (hardware && hardware->isLVGLReady()) {
+        hardware->updateLVGL();
+        uint32_t elapsed = millis() - last_update_time;
+        LVGL->waitForWork(elapsed < update_interval_ms ? update_interval_ms - elapsed : 0);
+        return;
+    }
 #endif
-*/
+
+    // Small delay to prevent watchdog issues
+    delay(1);
 }
 
 void updateSystem() {
-    // Update Phase 1 components
     if (hardware) {
         hardware->update();
     }
-    
-// TEMPORARILY DISABLED FOR DEBUGGING
-//#ifdef INTEGRATION_LAYER_ENABLED
-//    if (phase2_enabled) {
-//        // Update Phase 2 components
-//        if (eventBridge) {
-//            eventBridge->update();
-//        }
-//
-//        if (configManager) {
-//            configManager->update();
-//        }
-//
-//        if (serviceManager) {
-//            serviceManager->update();
-//        }
-//    }
-//#endif
+
+#ifdef BOOT_SERVICES_ENABLED
+    // Set by background boot steps; each is usable once its step has succeeded
+    if (boot_pipeline_succeeded(STAGE_CONFIG)) {
+        configManager->update();
+    }
+    if (boot_pipeline_succeeded(STAGE_SERVICES)) {
+        eventBridge->update();
+        serviceManager->update();
+    }
+#endif
 
 #ifdef LVGL_INTEGRATION_ENABLED
     // Update LVGL if hardware is ready
@@ -247,17 +487,17 @@ void updateSystem() {
 void handleSystemError(const char* error_msg) {
     Serial.print("SYSTEM ERROR: ");
     Serial.println(error_msg);
-    
+
     if (logger) {
         LOG_ERRORF("System", "Critical error: %s", error_msg);
     }
-    
+
     // Flash LED or display error on screen if possible
     if (hardware) {
         hardware->updateDisplay("SYSTEM ERROR", 10, 30);
         hardware->refreshDisplay(true);
     }
-    
+
     // Enter error state - keep system responsive but limited
     while (true) {
         delay(1000);
@@ -267,22 +507,15 @@ void handleSystemError(const char* error_msg) {
 
 void printSystemStatus() {
     LOG_INFO("System", "=== System Status ===");
-    LOG_INFOF("System", "Phase 1 (Hardware): %s", "ACTIVE");
-    LOG_INFOF("System", "Phase 2 (Services): %s", phase2_enabled ? "ACTIVE" : "DISABLED");
-    
+#ifdef BOOT_SERVICES_ENABLED
+    LOG_INFOF("System", "Services: %s", boot_pipeline_finished() ? "started" : "starting in background");
+#endif
+
     if (hardware) {
         LOG_INFOF("System", "Free Heap: %luKB", hardware->getFreeHeap() / 1024);
         LOG_INFOF("System", "Free PSRAM: %luKB", hardware->getFreePSRAM() / 1024);
         LOG_INFOF("System", "Uptime: %lus", hardware->getUptime() / 1000);
     }
-    
-// TEMPORARILY DISABLED FOR DEBUGGING
-//#ifdef INTEGRATION_LAYER_ENABLED
-//    if (phase2_enabled && serviceManager) {
-//        LOG_INFOF("System", "Services Started: %lu", serviceManager->getServicesStartedCount());
-//        LOG_INFOF("System", "Services Failed: %lu", serviceManager->getServicesFailedCount());
-//    }
-//#endif
-    
+
     LOG_INFO("System", "==================");
 }
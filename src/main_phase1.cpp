@@ -12,6 +12,12 @@
 #include "simple_logger.h"
 #include "simple_hardware.h"
 #include "simple_power.h"
+#include "simple_display_queue.h"
+#include "boot_trace.h"
+#include "resume_state.h"
+#include "wake_monitor.h"
+#include "plugin_runtime.h"
+#include "mem_trace.h"
 
 // System state
 bool system_initialized = false;
@@ -60,6 +66,16 @@ bool initializeSystem() {
     
     LOG_INFO("System", "Power manager initialized successfully");
     
+    // Initialize display update queue
+    SimpleDisplayQueue* display_queue = SimpleDisplayQueue::getInstance();
+    if (!display_queue->init()) {
+        LOG_ERROR("System", "Display queue initialization failed");
+        return false;
+    }
+    
+    // Installed plugins come from the flash index; the card is only read for new ones
+    plugin_runtime_begin();
+    
     // Run hardware diagnostics
     if (!hardware->runDiagnostics()) {
         LOG_WARN("System", "Some hardware components failed diagnostics");
@@ -70,6 +86,13 @@ bool initializeSystem() {
     power->enableAutoPowerManagement(true);
     power->setIdleTimeout(300000); // 5 minutes
     
+    // Waking from deep sleep: settings from before, and the panel kept its image
+    if (resume_state_resuming()) {
+        resume_state_restore();
+        LOG_INFO("System", "System resumed from deep sleep");
+        return true;
+    }
+    
     // Display welcome message
     String welcome = "T-Deck-Pro OS\nPhase 1 Active\n\nSystem Ready!\n\nTouch screen to\ninteract";
     hardware->updateDisplay(welcome.c_str(), 10, 30);
@@ -97,13 +120,11 @@ void testWiFiConnection() {
             scan_result += "   RSSI: " + String(networks[i].rssi) + "dBm\n";
         }
         
-        Hardware->updateDisplay(scan_result.c_str(), 10, 30);
-        // Don't refresh immediately - let main loop handle it
+        DisplayQueue->requestInteractive(scan_result.c_str());
 
         LOG_INFOF("WiFi", "Found %d networks", network_count);
     } else {
-        Hardware->updateDisplay("No WiFi networks\nfound", 10, 30);
-        // Don't refresh immediately - let main loop handle it
+        DisplayQueue->requestInteractive("No WiFi networks\nfound");
         LOG_WARN("WiFi", "No WiFi networks found");
     }
     
@@ -136,25 +157,16 @@ void testPowerManagement() {
     power_info += "Free Heap: " + String(stats.free_heap_kb) + "KB\n";
     power_info += "Free PSRAM: " + String(stats.free_psram_kb) + "KB\n";
     
-    Hardware->updateDisplay(power_info.c_str(), 10, 30);
-    // Don't refresh immediately - let main loop handle it
+    DisplayQueue->requestInteractive(power_info.c_str());
     
     Power->printPowerInfo();
     LOG_INFO("Power", "Power management test completed");
 }
 
 /**
- * @brief Update system status display
+ * @brief Build the system status text
  */
-void updateStatusDisplay() {
-    uint32_t now = millis();
-
-    // Update display content every 10 seconds, but refresh much less frequently
-    if (now - last_status_update < 10000) { // Update every 10 seconds
-        return;
-    }
-    last_status_update = now;
-
+String buildStatusText() {
     String status = Hardware->getSystemInfo();
 
     // Add touch status
@@ -172,13 +184,24 @@ void updateStatusDisplay() {
     uint32_t idle_time = Power->getIdleTime() / 1000;
     status += "Idle: " + String(idle_time) + "s\n";
 
-    // Update display buffer but don't refresh automatically
-    // Only refresh on user interaction to avoid constant refreshing
-    Hardware->updateDisplay(status.c_str(), 10, 30);
+    return status;
+}
+
+/**
+ * @brief Update system status display
+ */
+void updateStatusDisplay() {
+    uint32_t now = millis();
+
+    // Sample status every 10 seconds; the queue decides when the panel updates
+    if (now - last_status_update < 10000) {
+        return;
+    }
+    last_status_update = now;
 
-    // Note: Display refresh is now handled only in touch handler
+    DisplayQueue->requestTelemetry(buildStatusText().c_str());
 
-    LOG_DEBUG("Status", "Status display updated");
+    LOG_DEBUG("Status", "Status display update queued");
 }
 
 /**
@@ -195,11 +218,6 @@ void handleTouchInput() {
         // Reset idle timer on user activity
         Power->resetIdleTimer();
 
-        // Force a display refresh on user interaction (with minimal debounce)
-        static uint32_t last_touch_refresh = 0;
-        uint32_t now = millis();
-        bool should_refresh = (now - last_touch_refresh > 2000); // 2 second minimum between touch refreshes
-
         // Simple touch response - cycle through different functions
         static int touch_action = 0;
         touch_action = (touch_action + 1) % 4;
@@ -207,7 +225,7 @@ void handleTouchInput() {
         switch (touch_action) {
             case 0:
                 // Show system info
-                updateStatusDisplay();
+                DisplayQueue->requestInteractive(buildStatusText().c_str());
                 break;
             case 1:
                 // Test WiFi
@@ -226,20 +244,12 @@ void handleTouchInput() {
                     Power->setPowerMode(modes[power_mode]);
                     
                     String mode_msg = "Power Mode:\n" + String(Power->getPowerModeString());
-                    Hardware->updateDisplay(mode_msg.c_str(), 10, 30);
-                    // Don't refresh immediately - let the main loop handle it
+                    DisplayQueue->requestInteractive(mode_msg.c_str());
                     
                     LOG_INFOF("Touch", "Switched to power mode: %s", Power->getPowerModeString());
                 }
                 break;
         }
-
-        // Refresh display if enough time has passed since last touch refresh
-        if (should_refresh) {
-            Hardware->refreshDisplay(false); // Partial refresh for user interactions
-            last_touch_refresh = now;
-            LOG_DEBUG("Touch", "Display refreshed due to user interaction");
-        }
     }
 }
 
@@ -249,10 +259,20 @@ void handleTouchInput() {
 void setup() {
     // Record boot time
     boot_time = millis();
+    uint8_t setup_span = boot_trace_begin("setup");
+    
+    // A glitch or a battery check that finds enough charge sleeps again from here
+    wake_monitor_begin();
+    bool resuming = resume_state_begin();
     
     // Initialize serial for early debugging
     Serial.begin(115200);
-    delay(1000); // Allow serial to stabilize
+    if (!resuming) {
+        delay(1000); // Allow serial to stabilize
+    }
+
+    // Heap tracing in DEBUG builds (see [mem_trace] in platformio.ini)
+    mem_trace_begin();
     
     Serial.println("\n=== T-Deck-Pro OS Phase 1 ===");
     Serial.println("Initializing system...");
@@ -276,12 +296,27 @@ void setup() {
     
     system_initialized = true;
     
-    // Initial tests
-    delay(2000); // Show welcome message
-    testWiFiConnection();
-    delay(3000);
-    testPowerManagement();
-    delay(3000);
+    // Initial tests, skipped on resume so the last screen stays up
+    if (!resuming) {
+        delay(2000); // Show welcome message
+        testWiFiConnection();
+        DisplayQueue->flush();
+        delay(3000);
+        testPowerManagement();
+        DisplayQueue->flush();
+        delay(3000);
+    }
+    resume_state_finish();
+    
+    boot_trace_end(setup_span);
+    boot_trace_finish();
+    
+    // A previous boot that never finished shows where it hung
+    const BootTraceRecord* previous = boot_trace_record(true);
+    if (previous && !previous->finished_us) {
+        boot_trace_print(Serial, true);
+    }
+    boot_trace_print(Serial);
     
     LOG_INFO("System", "Setup completed successfully");
     LOG_INFO("System", "Entering main loop...");
@@ -307,6 +342,9 @@ void loop() {
     // Update status display periodically
     updateStatusDisplay();
     
+    // Push coalesced screen updates to the panel
+    DisplayQueue->update();
+    
     // Small delay to prevent overwhelming the system
     delay(50);
 }
@@ -1,320 +0,0 @@
-/**
- * @file      main_simple.cpp
- * @author    T-Deck-Pro OS Team
- * @license   MIT
- * @copyright Copyright (c) 2025
- * @date      2025-01-11
- * @brief     T-Deck-Pro OS Phase 1 - Simplified Working Version
- */
-
-#include <Arduino.h>
-#include "utilities.h"
-#include <GxEPD2_BW.h>
-#include <TouchDrvCSTXXX.hpp>
-#include <WiFi.h>
-#include <SD.h>
-
-// Hardware instances
-GxEPD2_BW<GxEPD2_310_GDEQ031T10, GxEPD2_310_GDEQ031T10::HEIGHT> display(
-    GxEPD2_310_GDEQ031T10(BOARD_EPD_CS, BOARD_EPD_DC, BOARD_EPD_RST, BOARD_EPD_BUSY)
-);
-
-TouchDrvCSTXXX touch;
-
-// System state
-bool system_initialized = false;
-uint32_t boot_time = 0;
-uint32_t last_status_update = 0;
-
-// Test configuration
-const char* test_wifi_ssid = "YourWiFiNetwork";
-const char* test_wifi_password = "YourPassword";
-
-/**
- * @brief Initialize display
- */
-bool initDisplay() {
-    Serial.println("[INFO] Initializing e-paper display...");
-    
-    try {
-        display.init(115200);
-        display.setRotation(0);
-        display.setFullWindow();
-        display.firstPage();
-        
-        do {
-            display.fillScreen(GxEPD_WHITE);
-            display.setCursor(10, 30);
-            display.setTextColor(GxEPD_BLACK);
-            display.println("T-Deck-Pro OS");
-            display.println("Phase 1 Active");
-            display.println("");
-            display.println("Initializing...");
-        } while (display.nextPage());
-        
-        Serial.println("[INFO] Display initialized successfully");
-        return true;
-    } catch (...) {
-        Serial.println("[ERROR] Display initialization failed");
-        return false;
-    }
-}
-
-/**
- * @brief Initialize touch controller
- */
-bool initTouch() {
-    Serial.println("[INFO] Initializing touch controller...");
-    
-    touch.setPins(BOARD_TOUCH_RST, BOARD_TOUCH_INT);
-    
-    if (touch.begin(Wire, BOARD_I2C_ADDR_TOUCH, BOARD_TOUCH_SDA, BOARD_TOUCH_SCL)) {
-        Serial.println("[INFO] Touch controller initialized successfully");
-        return true;
-    } else {
-        Serial.println("[ERROR] Touch controller initialization failed");
-        return false;
-    }
-}
-
-/**
- * @brief Initialize WiFi
- */
-bool initWiFi() {
-    Serial.println("[INFO] Initializing WiFi...");
-    
-    WiFi.mode(WIFI_STA);
-    WiFi.disconnect();
-    delay(100);
-    
-    Serial.println("[INFO] WiFi initialized successfully");
-    return true;
-}
-
-/**
- * @brief Initialize SD card
- */
-bool initSDCard() {
-    Serial.println("[INFO] Initializing SD card...");
-    
-    if (SD.begin(BOARD_SD_CS)) {
-        uint64_t cardSize = SD.cardSize() / (1024 * 1024);
-        Serial.printf("[INFO] SD card initialized successfully - Size: %lluMB\n", cardSize);
-        return true;
-    } else {
-        Serial.println("[ERROR] SD card initialization failed");
-        return false;
-    }
-}
-
-/**
- * @brief Initialize power management
- */
-bool initPowerManagement() {
-    Serial.println("[INFO] Initializing power management...");
-    
-    // Enable power for various components
-    pinMode(BOARD_GPS_EN, OUTPUT);
-    pinMode(BOARD_1V8_EN, OUTPUT);
-    pinMode(BOARD_6609_EN, OUTPUT);
-    pinMode(BOARD_LORA_EN, OUTPUT);
-
-    // Enable 1.8V rail for gyroscope
-    digitalWrite(BOARD_1V8_EN, HIGH);
-    delay(100);
-    
-    Serial.println("[INFO] Power management initialized successfully");
-    return true;
-}
-
-/**
- * @brief Initialize the system
- */
-bool initializeSystem() {
-    Serial.println("\n=== T-Deck-Pro OS Phase 1 ===");
-    Serial.println("Starting system initialization...");
-    
-    // Initialize I2C and SPI
-    Wire.begin(BOARD_I2C_SDA, BOARD_I2C_SCL);
-    Wire.setClock(400000);
-    SPI.begin(BOARD_SPI_SCK, BOARD_SPI_MISO, BOARD_SPI_MOSI);
-    
-    // Initialize components
-    bool success = true;
-    success &= initPowerManagement();
-    success &= initDisplay();
-    success &= initTouch();
-    success &= initWiFi();
-    success &= initSDCard();
-    
-    if (success) {
-        Serial.println("[INFO] System initialization completed successfully");
-        return true;
-    } else {
-        Serial.println("[ERROR] System initialization failed");
-        return false;
-    }
-}
-
-/**
- * @brief Test WiFi connectivity
- */
-void testWiFiConnection() {
-    Serial.println("[INFO] Testing WiFi connectivity...");
-    
-    // Scan for networks
-    int networks = WiFi.scanNetworks();
-    Serial.printf("[INFO] Found %d networks\n", networks);
-    
-    for (int i = 0; i < networks; i++) {
-        Serial.printf("  %d: %s (RSSI: %d)\n", i + 1, WiFi.SSID(i).c_str(), WiFi.RSSI(i));
-    }
-    
-    // Try to connect (uncomment and set credentials to test)
-    /*
-    Serial.printf("[INFO] Attempting to connect to %s...\n", test_wifi_ssid);
-    WiFi.begin(test_wifi_ssid, test_wifi_password);
-    
-    int attempts = 0;
-    while (WiFi.status() != WL_CONNECTED && attempts < 20) {
-        delay(500);
-        Serial.print(".");
-        attempts++;
-    }
-    
-    if (WiFi.status() == WL_CONNECTED) {
-        Serial.println("\n[INFO] WiFi connected successfully!");
-        Serial.printf("[INFO] IP Address: %s\n", WiFi.localIP().toString().c_str());
-    } else {
-        Serial.println("\n[ERROR] WiFi connection failed");
-    }
-    */
-}
-
-/**
- * @brief Update status display
- */
-void updateStatusDisplay() {
-    uint32_t now = millis();
-    
-    if (now - last_status_update < 10000) { // Update every 10 seconds
-        return;
-    }
-    last_status_update = now;
-    
-    display.setPartialWindow(0, 0, display.width(), display.height());
-    display.firstPage();
-    
-    do {
-        display.fillScreen(GxEPD_WHITE);
-        display.setCursor(10, 30);
-        display.setTextColor(GxEPD_BLACK);
-        
-        display.println("T-Deck-Pro OS");
-        display.println("Phase 1 Active");
-        display.println("");
-        
-        // Uptime
-        uint32_t uptime_seconds = (now - boot_time) / 1000;
-        display.printf("Uptime: %lu s\n", uptime_seconds);
-        
-        // WiFi status
-        if (WiFi.status() == WL_CONNECTED) {
-            display.println("WiFi: Connected");
-            display.printf("IP: %s\n", WiFi.localIP().toString().c_str());
-        } else {
-            display.println("WiFi: Disconnected");
-        }
-        
-        // Memory info
-        display.printf("Free Heap: %d KB\n", ESP.getFreeHeap() / 1024);
-        display.printf("Free PSRAM: %d KB\n", ESP.getFreePsram() / 1024);
-        
-        // Touch status
-        if (touch.isPressed()) {
-            display.println("Touch: Pressed");
-        } else {
-            display.println("Touch: Released");
-        }
-        
-    } while (display.nextPage());
-    
-    Serial.println("[DEBUG] Status display updated");
-}
-
-/**
- * @brief Arduino setup function
- */
-void setup() {
-    boot_time = millis();
-    
-    // Initialize serial
-    Serial.begin(115200);
-    delay(1000);
-    
-    // Initialize system
-    if (!initializeSystem()) {
-        Serial.println("[FATAL] System initialization failed!");
-        
-        // Try to show error on display
-        display.setFullWindow();
-        display.firstPage();
-        do {
-            display.fillScreen(GxEPD_WHITE);
-            display.setCursor(10, 30);
-            display.setTextColor(GxEPD_BLACK);
-            display.println("SYSTEM INIT");
-            display.println("FAILED!");
-            display.println("");
-            display.println("Check Serial");
-            display.println("for details");
-        } while (display.nextPage());
-        
-        // Halt system
-        while (true) {
-            delay(1000);
-        }
-    }
-    
-    system_initialized = true;
-    
-    // Test WiFi
-    testWiFiConnection();
-    
-    Serial.println("[INFO] Setup completed successfully");
-    Serial.println("[INFO] Entering main loop...");
-}
-
-/**
- * @brief Arduino main loop function
- */
-void loop() {
-    if (!system_initialized) {
-        delay(100);
-        return;
-    }
-    
-    // Handle touch input
-    if (touch.isPressed()) {
-        int16_t x, y;
-        if (touch.getPoint(&x, &y, 1)) {
-            Serial.printf("[INFO] Touch detected at (%d, %d)\n", x, y);
-            
-            // Simple touch response - show coordinates on display
-            display.setPartialWindow(0, 200, display.width(), 50);
-            display.firstPage();
-            do {
-                display.fillScreen(GxEPD_WHITE);
-                display.setCursor(10, 220);
-                display.setTextColor(GxEPD_BLACK);
-                display.printf("Touch: (%d, %d)", x, y);
-            } while (display.nextPage());
-        }
-    }
-    
-    // Update status display periodically
-    updateStatusDisplay();
-    
-    // Small delay
-    delay(50);
-}
@@ -0,0 +1,491 @@
+/**
+ * @file      map_tiles.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Map tile pack reader, scanline rasteriser and rendered-tile cache
+ */
+
+#include "map_tiles.h"
+#include "simple_logger.h"
+#include "spi_bus.h"
+#include <esp_heap_caps.h>
+#include <SD.h>
+
+#define TILE_NONE       (-1)
+#define SUBPX_SHIFT     1       // Extent units to 1/16 pixel
+#define SCAN_X_MAX      128     // Edge crossings per scanline
+
+static_assert(sizeof(MapPackHeader) == 32, "Header is part of the file format");
+static_assert(sizeof(MapPackTile) == 16, "Index entry is part of the file format");
+static_assert(MAP_TILE_EXTENT == (MAP_TILE_PX * 16) << SUBPX_SHIFT, "SUBPX_SHIFT follows the extent");
+
+struct TileSlot {
+    uint16_t x;
+    uint16_t y;
+    uint8_t z;
+    int16_t next;                   // Bucket chain
+    int16_t newer;                  // LRU list, most recent at lru_head
+    int16_t older;
+    uint8_t bits[MAP_TILE_BYTES];
+};
+
+struct KindStyle {
+    uint8_t fill[4];                // Ink per row, y & 3; areas only
+    uint8_t width;                  // Brush, 0 for an area
+    uint8_t core;                   // White line drawn inside in the second pass
+    uint8_t dash;                   // Brush steps drawn, bit per step & 7
+    bool outline;                   // Area with a 1px edge
+};
+
+static const KindStyle styles[MAP_KIND_NUM] = {
+    /* WATER      */ { { 0xAA, 0x55, 0xAA, 0x55 }, 0, 0, 0xFF, false },
+    /* PARK       */ { { 0x88, 0x00, 0x22, 0x00 }, 0, 0, 0xFF, false },
+    /* BUILDING   */ { { 0xFF, 0xAA, 0xFF, 0xAA }, 0, 0, 0xFF, true },
+    /* BORDER     */ { { 0 }, 1, 0, 0x3F, false },
+    /* PATH       */ { { 0 }, 1, 0, 0x33, false },
+    /* RAIL       */ { { 0 }, 2, 0, 0x0F, false },
+    /* ROAD_MINOR */ { { 0 }, 2, 0, 0xFF, false },
+    /* ROAD_MAJOR */ { { 0 }, 5, 3, 0xFF, false },
+};
+
+static File map_file;
+static MapPackHeader header;
+static MapPackTile *tiles = NULL;           // The resident index, PSRAM
+static TileSlot *slots = NULL;              // PSRAM
+static uint8_t *tile_data = NULL;           // One encoded tile, PSRAM
+static int16_t (*points)[2] = NULL;         // One decoded feature, internal RAM
+static int16_t buckets[MAP_CACHE_BUCKETS];
+static int16_t lru_head = TILE_NONE;
+static int16_t lru_tail = TILE_NONE;
+static uint16_t slots_used = 0;
+static bool ready = false;
+
+static uint32_t hits = 0;
+static uint32_t misses = 0;
+static uint32_t empty = 0;
+static uint32_t evictions = 0;
+static uint32_t read_errors = 0;
+static uint32_t render_us_max = 0;
+
+// ===== Source =====
+
+static bool source_read(uint32_t offset, void *dst, uint32_t len) {
+    spi_bus_acquire(SPI_CLIENT_SD);
+    bool ok = map_file && map_file.seek(offset) && map_file.read((uint8_t *)dst, len) == len;
+    spi_bus_release(SPI_CLIENT_SD);
+    return ok;
+}
+
+// ===== Index =====
+
+static inline uint64_t tile_key(uint8_t z, uint32_t x, uint32_t y) {
+    return (uint64_t)z << 32 | y << 16 | x;
+}
+
+static const MapPackTile *find_tile(uint8_t z, uint32_t x, uint32_t y) {
+    uint64_t key = tile_key(z, x, y);
+    uint32_t lo = 0;
+    uint32_t hi = header.tile_count;
+    while (lo < hi) {
+        uint32_t mid = (lo + hi) / 2;
+        if (tile_key(tiles[mid].z, tiles[mid].x, tiles[mid].y) < key) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo < header.tile_count && tile_key(tiles[lo].z, tiles[lo].x, tiles[lo].y) == key) {
+        return &tiles[lo];
+    }
+    return NULL;
+}
+
+// ===== Raster =====
+
+static inline int32_t unzigzag(uint32_t v) {
+    return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+static const uint8_t *get_varint(const uint8_t *p, const uint8_t *end, uint32_t *v) {
+    uint32_t result = 0;
+    for (int shift = 0; shift < 35 && p < end; shift += 7) {
+        uint8_t b = *p++;
+        result |= (uint32_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) {
+            *v = result;
+            return p;
+        }
+    }
+    return nullptr;
+}
+
+// Pixels x0..x1 of a row take ink's bits: 0xFF solid, 0x00 white, else a pattern
+static void span(uint8_t *row, int x0, int x1, uint8_t ink) {
+    x0 = max(x0, 0);
+    x1 = min(x1, MAP_TILE_PX - 1);
+    if (x0 > x1) {
+        return;
+    }
+    int b0 = x0 >> 3;
+    int b1 = x1 >> 3;
+    uint8_t m0 = 0xFF >> (x0 & 7);
+    uint8_t m1 = 0xFF << (7 - (x1 & 7));
+    if (b0 == b1) {
+        m0 &= m1;
+        row[b0] = (row[b0] & ~m0) | (ink & m0);
+        return;
+    }
+    row[b0] = (row[b0] & ~m0) | (ink & m0);
+    memset(row + b0 + 1, ink, b1 - b0 - 1);
+    row[b1] = (row[b1] & ~m1) | (ink & m1);
+}
+
+static void stamp(uint8_t *bits, int x, int y, int w, uint8_t ink) {
+    int y0 = max(y - w / 2, 0);
+    int y1 = min(y - w / 2 + w - 1, MAP_TILE_PX - 1);
+    for (int r = y0; r <= y1; r++) {
+        span(bits + r * MAP_TILE_STRIDE, x - w / 2, x - w / 2 + w - 1, ink);
+    }
+}
+
+static void draw_line(uint8_t *bits, uint16_t n, int w, uint8_t dash, uint8_t ink, bool closed) {
+    uint32_t step = 0;
+    uint16_t segments = closed ? n : n - 1;
+    for (uint16_t i = 0; i < segments; i++) {
+        int x0 = (points[i][0] + 8) >> 4;
+        int y0 = (points[i][1] + 8) >> 4;
+        int x1 = (points[(i + 1) % n][0] + 8) >> 4;
+        int y1 = (points[(i + 1) % n][1] + 8) >> 4;
+
+        // Wholly outside, brush included: keep the dash phase and move on
+        int lo = -w;
+        int hi = MAP_TILE_PX + w;
+        if ((x0 < lo && x1 < lo) || (x0 > hi && x1 > hi) || (y0 < lo && y1 < lo) || (y0 > hi && y1 > hi)) {
+            step += max(abs(x1 - x0), abs(y1 - y0));
+            continue;
+        }
+
+        int dx = abs(x1 - x0);
+        int dy = -abs(y1 - y0);
+        int sx = x0 < x1 ? 1 : -1;
+        int sy = y0 < y1 ? 1 : -1;
+        int err = dx + dy;
+        while (true) {
+            if (dash >> (step++ & 7) & 1) {
+                stamp(bits, x0, y0, w, ink);
+            }
+            if (x0 == x1 && y0 == y1) {
+                break;
+            }
+            int e2 = 2 * err;
+            if (e2 >= dy) {
+                err += dy;
+                x0 += sx;
+            }
+            if (e2 <= dx) {
+                err += dx;
+                y0 += sy;
+            }
+        }
+    }
+}
+
+// Even-odd rule, sampled at pixel centres
+static void fill_area(uint8_t *bits, uint16_t n, const uint8_t *fill) {
+    int32_t ymin = INT32_MAX;
+    int32_t ymax = INT32_MIN;
+    for (uint16_t i = 0; i < n; i++) {
+        ymin = min(ymin, (int32_t)points[i][1]);
+        ymax = max(ymax, (int32_t)points[i][1]);
+    }
+    int r0 = max((int)((ymin + 7) >> 4), 0);
+    int r1 = min((int)((ymax + 7) >> 4) - 1, MAP_TILE_PX - 1);
+
+    int16_t xs[SCAN_X_MAX];
+    for (int r = r0; r <= r1; r++) {
+        int32_t yc = r * 16 + 8;
+        int count = 0;
+        for (uint16_t i = 0, j = n - 1; i < n && count < SCAN_X_MAX; j = i++) {
+            int32_t yi = points[i][1];
+            int32_t yj = points[j][1];
+            if ((yi > yc) == (yj > yc)) {
+                continue;
+            }
+            int32_t xi = points[i][0];
+            int32_t xj = points[j][0];
+            int16_t x = xj + (yc - yj) * (xi - xj) / (yi - yj);
+            int k = count++;
+            for (; k > 0 && xs[k - 1] > x; k--) {
+                xs[k] = xs[k - 1];
+            }
+            xs[k] = x;
+        }
+        uint8_t *row = bits + r * MAP_TILE_STRIDE;
+        for (int k = 0; k + 1 < count; k += 2) {
+            span(row, (xs[k] + 7) >> 4, ((xs[k + 1] + 7) >> 4) - 1, fill[r & 3]);
+        }
+    }
+}
+
+// One feature into points, up to MAP_FEATURE_POINTS_MAX of them; nullptr at the end or a cut
+static const uint8_t *read_feature(const uint8_t *p, const uint8_t *end, uint8_t *kind, uint16_t *n) {
+    uint32_t count;
+    if (p >= end) {
+        return nullptr;
+    }
+    *kind = *p++;
+    if (!(p = get_varint(p, end, &count)) || !count) {
+        return nullptr;
+    }
+    int32_t x = 0;
+    int32_t y = 0;
+    *n = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t zx, zy;
+        if (!(p = get_varint(p, end, &zx)) || !(p = get_varint(p, end, &zy))) {
+            return nullptr;
+        }
+        x += unzigzag(zx);
+        y += unzigzag(zy);
+        if (*n < MAP_FEATURE_POINTS_MAX) {
+            points[*n][0] = (int16_t)constrain(x >> SUBPX_SHIFT, INT16_MIN, INT16_MAX);
+            points[*n][1] = (int16_t)constrain(y >> SUBPX_SHIFT, INT16_MIN, INT16_MAX);
+            (*n)++;
+        }
+    }
+    return p;
+}
+
+static void raster_tile(const uint8_t *data, uint32_t len, uint8_t *bits) {
+    memset(bits, 0, MAP_TILE_BYTES);
+
+    // Pass 0 draws every feature in file order, pass 1 the white cores over the casings
+    for (int pass = 0; pass < 2; pass++) {
+        const uint8_t *p = data;
+        uint8_t kind;
+        uint16_t n;
+        while ((p = read_feature(p, data + len, &kind, &n))) {
+            if (kind >= MAP_KIND_NUM) {
+                continue;
+            }
+            const KindStyle *s = &styles[kind];
+            if (pass == 1) {
+                if (s->core) {
+                    draw_line(bits, n, s->core, s->dash, 0x00, false);
+                }
+            } else if (!s->width) {
+                if (n >= 3) {
+                    fill_area(bits, n, s->fill);
+                }
+                if (s->outline) {
+                    draw_line(bits, n, 1, 0xFF, 0xFF, true);
+                }
+            } else {
+                draw_line(bits, n, s->width, s->dash, 0xFF, false);
+            }
+        }
+    }
+}
+
+// ===== LRU =====
+
+static inline uint32_t bucket_of(uint8_t z, uint32_t x, uint32_t y) {
+    return ((x * 73856093UL) ^ (y * 19349663UL) ^ (z * 83492791UL)) >> 8 & (MAP_CACHE_BUCKETS - 1);
+}
+
+static void lru_unlink(int16_t i) {
+    TileSlot *s = &slots[i];
+    if (s->newer != TILE_NONE) {
+        slots[s->newer].older = s->older;
+    } else {
+        lru_head = s->older;
+    }
+    if (s->older != TILE_NONE) {
+        slots[s->older].newer = s->newer;
+    } else {
+        lru_tail = s->newer;
+    }
+}
+
+static void lru_push(int16_t i) {
+    slots[i].newer = TILE_NONE;
+    slots[i].older = lru_head;
+    if (lru_head != TILE_NONE) {
+        slots[lru_head].newer = i;
+    }
+    lru_head = i;
+    if (lru_tail == TILE_NONE) {
+        lru_tail = i;
+    }
+}
+
+static int16_t lookup(uint8_t z, uint32_t x, uint32_t y) {
+    for (int16_t i = buckets[bucket_of(z, x, y)]; i != TILE_NONE; i = slots[i].next) {
+        if (slots[i].x == x && slots[i].y == y && slots[i].z == z) {
+            return i;
+        }
+    }
+    return TILE_NONE;
+}
+
+static void bucket_remove(int16_t index) {
+    TileSlot *s = &slots[index];
+    int16_t *link = &buckets[bucket_of(s->z, s->x, s->y)];
+    while (*link != TILE_NONE) {
+        if (*link == index) {
+            *link = s->next;
+            return;
+        }
+        link = &slots[*link].next;
+    }
+}
+
+static int16_t claim(uint8_t z, uint32_t x, uint32_t y) {
+    int16_t index;
+    if (slots_used < MAP_CACHE_TILES) {
+        index = slots_used++;
+    } else {
+        index = lru_tail;
+        lru_unlink(index);
+        bucket_remove(index);
+        evictions++;
+    }
+    uint32_t bucket = bucket_of(z, x, y);
+    slots[index].x = x;
+    slots[index].y = y;
+    slots[index].z = z;
+    slots[index].next = buckets[bucket];
+    buckets[bucket] = index;
+    lru_push(index);
+    return index;
+}
+
+// ===== API =====
+
+static void release() {
+    heap_caps_free(tiles);
+    heap_caps_free(slots);
+    heap_caps_free(tile_data);
+    heap_caps_free(points);
+    tiles = NULL;
+    slots = NULL;
+    tile_data = NULL;
+    points = NULL;
+    if (map_file) {
+        map_file.close();
+    }
+}
+
+bool map_tiles_begin() {
+    if (ready) {
+        return true;
+    }
+    if (SD.cardType() == CARD_NONE) {
+        LOG_INFO("MAP", "No SD card");
+        return false;
+    }
+    spi_bus_acquire(SPI_CLIENT_SD);
+    map_file = SD.open(MAP_SD_FILE, FILE_READ);
+    spi_bus_release(SPI_CLIENT_SD);
+    if (!map_file) {
+        LOG_INFO("MAP", "No map pack at " MAP_SD_FILE);
+        return false;
+    }
+    if (!source_read(0, &header, sizeof(header)) || header.magic != MAP_PACK_MAGIC ||
+        header.version != MAP_PACK_VERSION || !header.tile_count || header.zoom_max > MAP_ZOOM_MAX ||
+        header.zoom_min > header.zoom_max) {
+        LOG_WARN("MAP", "Map pack is not a version 1 pack");
+        release();
+        return false;
+    }
+
+    size_t index_len = header.tile_count * sizeof(MapPackTile);
+    tiles = (MapPackTile *)heap_caps_malloc(index_len, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    slots = (TileSlot *)heap_caps_malloc(sizeof(TileSlot) * MAP_CACHE_TILES, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    tile_data = (uint8_t *)heap_caps_malloc(MAP_TILE_DATA_MAX, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    // Walked once per scanline by the fill: keep it out of PSRAM
+    points = (int16_t(*)[2])heap_caps_malloc(sizeof(int16_t) * 2 * MAP_FEATURE_POINTS_MAX,
+                                             MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (!tiles || !slots || !tile_data || !points || !source_read(header.index_offset, tiles, index_len)) {
+        LOG_WARN("MAP", "Map index not loaded");
+        release();
+        return false;
+    }
+
+    for (int i = 0; i < MAP_CACHE_BUCKETS; i++) {
+        buckets[i] = TILE_NONE;
+    }
+    lru_head = lru_tail = TILE_NONE;
+    slots_used = 0;
+    ready = true;
+
+    LOG_INFOF("MAP", "Map pack: %lu tiles, zoom %u-%u, %u bytes index, %u bytes cache",
+              (unsigned long)header.tile_count, header.zoom_min, header.zoom_max, (unsigned)index_len,
+              (unsigned)(sizeof(TileSlot) * MAP_CACHE_TILES));
+    return true;
+}
+
+bool map_tiles_ready() {
+    return ready;
+}
+
+void map_tiles_get_info(uint8_t *zoom_min, uint8_t *zoom_max, double *lat, double *lng) {
+    *zoom_min = header.zoom_min;
+    *zoom_max = header.zoom_max;
+    *lat = header.center_lat / 1e7;
+    *lng = header.center_lng / 1e7;
+}
+
+const uint8_t *map_tiles_get(uint8_t z, uint32_t x, uint32_t y, bool render) {
+    if (!ready || z > MAP_ZOOM_MAX || x >= (1UL << z) || y >= (1UL << z)) {
+        return NULL;
+    }
+    int16_t index = lookup(z, x, y);
+    if (index != TILE_NONE) {
+        hits++;
+        lru_unlink(index);
+        lru_push(index);
+        return slots[index].bits;
+    }
+    if (!render) {
+        return NULL;
+    }
+
+    // Tiles outside the pack are cached blank, so the index is searched once
+    index = claim(z, x, y);
+    uint8_t *bits = slots[index].bits;
+    const MapPackTile *t = find_tile(z, x, y);
+    if (!t) {
+        memset(bits, 0, MAP_TILE_BYTES);
+        empty++;
+        return bits;
+    }
+
+    misses++;
+    uint32_t start = micros();
+    uint32_t len = min(t->length, (uint32_t)MAP_TILE_DATA_MAX);
+    // A tile that cannot be read stays blank until it is evicted
+    if (!source_read(header.data_offset + t->offset, tile_data, len)) {
+        read_errors++;
+        len = 0;
+    }
+    raster_tile(tile_data, len, bits);
+    render_us_max = max(render_us_max, (uint32_t)(micros() - start));
+    return bits;
+}
+
+void map_tiles_get_stats(MapTileStats *stats) {
+    if (!stats) {
+        return;
+    }
+    stats->tiles = ready ? header.tile_count : 0;
+    stats->hits = hits;
+    stats->misses = misses;
+    stats->empty = empty;
+    stats->evictions = evictions;
+    stats->read_errors = read_errors;
+    stats->render_us_max = render_us_max;
+    stats->cached = slots_used;
+}
@@ -0,0 +1,123 @@
+/**
+ * @file      map_tiles.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Offline vector map: tile pack on SD, 1bpp scanline rasteriser, PSRAM LRU of rendered tiles
+ */
+
+#ifndef MAP_TILES_H
+#define MAP_TILES_H
+
+#include <Arduino.h>
+
+/**
+ * The map is one pack file on the SD card (script/map_pack.py builds it
+ * from GeoJSON). Tiles follow the usual web-mercator z/x/y grid; each is
+ * a run of features whose coordinates are quantised to MAP_TILE_EXTENT
+ * units per tile side and delta/varint coded. The tile index, 16 bytes a
+ * tile sorted by z, y, x, is the spatial index: it is loaded into PSRAM
+ * and binary searched, so a tile costs one seek and one read.
+ *
+ * A tile is rasterised straight into a packed 1bpp bitmap of
+ * MAP_TILE_PX square, 1 = ink: areas by an even-odd scanline fill with a
+ * grey pattern, lines as square-brush Bresenham runs. Rendered tiles are
+ * kept in an LRU of MAP_CACHE_TILES slots in PSRAM, so panning back over
+ * a tile, or a GPS update that leaves the view where it was, costs
+ * nothing but the blit.
+ *
+ * Tile layout, little endian: features back to back, each
+ *   kind (MapKind), varint point count, then zigzag varint x, y of the
+ *   first point and zigzag varint deltas for the rest.
+ * Areas are single rings, closed implicitly; the packer writes features
+ * in MapKind order, so areas lie under roads and major roads on top.
+ * Coordinates may run MAP_TILE_BUFFER units past the tile edge.
+ *
+ * Call from the LVGL task only.
+ */
+
+#define MAP_PACK_MAGIC              0x504D4454  // "TDMP"
+#define MAP_PACK_VERSION            1
+#define MAP_SD_FILE                 "/maps/map.tdm"
+#define MAP_TILE_PX                 128         // Rendered tile side
+#define MAP_TILE_EXTENT             4096        // Coordinate units per tile side
+#define MAP_TILE_BUFFER             256         // Units a feature may extend past the edge
+#define MAP_TILE_STRIDE             (MAP_TILE_PX / 8)
+#define MAP_TILE_BYTES              (MAP_TILE_STRIDE * MAP_TILE_PX)
+#define MAP_ZOOM_MAX                16          // x and y fit the index's 16 bits
+#define MAP_CACHE_TILES             48          // 2 KB each in PSRAM
+#define MAP_CACHE_BUCKETS           64          // Power of two
+#define MAP_TILE_DATA_MAX           32768       // Largest encoded tile
+#define MAP_FEATURE_POINTS_MAX      1024        // Longer features are split by the packer
+
+enum MapKind : uint8_t {
+    MAP_KIND_WATER = 0,
+    MAP_KIND_PARK,
+    MAP_KIND_BUILDING,
+    MAP_KIND_BORDER,
+    MAP_KIND_PATH,
+    MAP_KIND_RAIL,
+    MAP_KIND_ROAD_MINOR,
+    MAP_KIND_ROAD_MAJOR,
+    MAP_KIND_NUM,
+};
+
+struct MapPackHeader {
+    uint32_t magic;
+    uint8_t version;
+    uint8_t zoom_min;
+    uint8_t zoom_max;
+    uint8_t reserved0;
+    uint32_t tile_count;
+    uint32_t index_offset;
+    uint32_t data_offset;
+    int32_t center_lat;             // 1e-7 deg, where to look without a fix
+    int32_t center_lng;
+    uint8_t reserved[4];
+};
+
+struct MapPackTile {
+    uint16_t x;
+    uint16_t y;
+    uint8_t z;
+    uint8_t reserved;
+    uint16_t features;
+    uint32_t offset;                // From data_offset
+    uint32_t length;
+};
+
+struct MapTileStats {
+    uint32_t tiles;                 // In the pack
+    uint32_t hits;
+    uint32_t misses;                // Rendered
+    uint32_t empty;                 // Not in the pack, cached blank
+    uint32_t evictions;
+    uint32_t read_errors;
+    uint32_t render_us_max;
+    uint16_t cached;
+};
+
+/**
+ * @brief Open the pack and load its index
+ * @return false without a card or a valid pack; the map screen says so
+ */
+bool map_tiles_begin();
+
+bool map_tiles_ready();
+
+/**
+ * @brief Zoom range and default centre of the pack
+ */
+void map_tiles_get_info(uint8_t *zoom_min, uint8_t *zoom_max, double *lat, double *lng);
+
+/**
+ * @brief A rendered tile, MAP_TILE_BYTES of packed rows, 1 = ink. Valid
+ *        until the next call that may render.
+ * @param render false to look in the cache only; NULL on a miss
+ */
+const uint8_t *map_tiles_get(uint8_t z, uint32_t x, uint32_t y, bool render);
+
+void map_tiles_get_stats(MapTileStats *stats);
+
+#endif // MAP_TILES_H
@@ -0,0 +1,505 @@
+/**
+ * @file      mem_trace.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Heap allocation-site profiler for DEBUG_MEMORY_TRACKING builds
+ */
+
+#include "mem_trace.h"
+
+#if DEBUG_MEMORY_TRACKING
+
+#include "simple_logger.h"
+#include "timer_wheel.h"
+#include <esp_heap_caps.h>
+#include <esp_debug_helpers.h>
+#include <soc/soc_memory_layout.h>
+#include <sys/reent.h>
+
+static_assert((MEM_TRACE_SITES & (MEM_TRACE_SITES - 1)) == 0, "MEM_TRACE_SITES is a power of two");
+static_assert((MEM_TRACE_LIVE_MAX & (MEM_TRACE_LIVE_MAX - 1)) == 0, "MEM_TRACE_LIVE_MAX is a power of two");
+
+extern "C" {
+void* __real_malloc(size_t size);
+void __real_free(void* ptr);
+void* __real_calloc(size_t n, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+void* __real__malloc_r(struct _reent* r, size_t size);
+void __real__free_r(struct _reent* r, void* ptr);
+void* __real__calloc_r(struct _reent* r, size_t n, size_t size);
+void* __real__realloc_r(struct _reent* r, void* ptr, size_t size);
+void* __real_heap_caps_malloc(size_t size, uint32_t caps);
+void* __real_heap_caps_calloc(size_t n, size_t size, uint32_t caps);
+void* __real_heap_caps_realloc(void* ptr, size_t size, uint32_t caps);
+}
+
+// A block being followed. site is an index into the site table
+struct MemLive {
+    uintptr_t ptr;                  // 0 when the slot is free
+    uint32_t size;
+    uint32_t ms;
+    uint16_t site;
+    uint8_t region;
+    uint8_t reserved;
+};
+
+static mem_site_t* sites = NULL;    // Site 0 takes what the table has no room for
+static MemLive* live = NULL;
+static mem_trace_event_t* ring = NULL;
+static uint16_t ring_head = 0;
+static uint16_t ring_count = 0;
+static volatile bool tracing = false;
+static portMUX_TYPE trace_mux = portMUX_INITIALIZER_UNLOCKED;
+static mem_trace_stats_t trace_stats;
+static uint32_t last_report_ms = 0;
+static WheelTimer report_timer;
+
+// Windowed-ABI return addresses carry the caller's window size in their top
+// bits; the call instruction is 3 bytes before
+static inline uint32_t stack_pc(uint32_t pc) {
+    if (pc & 0x80000000) {
+        pc = (pc & 0x3fffffff) | 0x40000000;
+    }
+    return pc - 3;
+}
+
+static inline uint32_t hash32(uint32_t h) {
+    h ^= h >> 16;
+    h *= 0x7feb352d;
+    h ^= h >> 15;
+    return h;
+}
+
+// The frames above the wrapper that called us
+static void __attribute__((noinline)) capture(uint32_t* pcs) {
+    esp_backtrace_frame_t frame;
+    memset(pcs, 0, MEM_TRACE_DEPTH * sizeof(uint32_t));
+    esp_backtrace_get_start(&frame.pc, &frame.sp, &frame.next_pc);
+    frame.exc_frame = NULL;
+    // The start frame is capture(); then the tracker and the wrapper
+    int skip = 2;
+    int n = 0;
+    while (n < MEM_TRACE_DEPTH && esp_backtrace_get_next_frame(&frame)) {
+        if (skip) {
+            skip--;
+            continue;
+        }
+        pcs[n++] = stack_pc(frame.pc);
+    }
+}
+
+// Under trace_mux
+static uint16_t find_site(const uint32_t* pcs, uint8_t region) {
+    if (!pcs[0]) {
+        return 0;                   // No frame could be read
+    }
+    uint32_t h = region;
+    for (int i = 0; i < MEM_TRACE_DEPTH; i++) {
+        h = hash32(h ^ pcs[i]);
+    }
+    for (uint32_t probe = 0; probe < MEM_TRACE_SITES; probe++) {
+        uint32_t i = (h + probe) & (MEM_TRACE_SITES - 1);
+        if (i == 0) {
+            continue;
+        }
+        mem_site_t* s = &sites[i];
+        if (!s->pc[0]) {
+            memcpy(s->pc, pcs, sizeof(s->pc));
+            s->region = region;
+            return i;
+        }
+        if (s->region == region && !memcmp(s->pc, pcs, sizeof(s->pc))) {
+            return i;
+        }
+    }
+    trace_stats.sites_full++;
+    return 0;
+}
+
+// Under trace_mux
+static void log_event(uint16_t site, uint8_t region, uint32_t size, uint32_t life_ms, uint32_t now) {
+    if (trace_stats.events++ % MEM_TRACE_SAMPLE) {
+        return;
+    }
+    mem_trace_event_t* e = &ring[ring_head];
+    e->ms = now;
+    e->size = size;
+    e->life_ms = life_ms;
+    e->site = site;
+    e->region = region;
+    ring_head = (ring_head + 1) % MEM_TRACE_RING;
+    if (ring_count < MEM_TRACE_RING) {
+        ring_count++;
+    }
+}
+
+static inline uint32_t live_slot(uintptr_t ptr) {
+    return hash32(ptr >> 2) & (MEM_TRACE_LIVE_MAX - 1);
+}
+
+// Under trace_mux. Linear probing with backward-shift removal, so lookups
+// never have to step over tombstones
+static bool live_take(uintptr_t ptr, MemLive* out) {
+    uint32_t i = live_slot(ptr);
+    for (uint32_t probe = 0; probe < MEM_TRACE_LIVE_MAX; probe++, i = (i + 1) & (MEM_TRACE_LIVE_MAX - 1)) {
+        if (!live[i].ptr) {
+            return false;
+        }
+        if (live[i].ptr != ptr) {
+            continue;
+        }
+        *out = live[i];
+        uint32_t hole = i;
+        uint32_t j = i;
+        while (true) {
+            j = (j + 1) & (MEM_TRACE_LIVE_MAX - 1);
+            if (!live[j].ptr) {
+                break;
+            }
+            // Move j back unless its home lies cyclically in (hole, j]
+            uint32_t home = live_slot(live[j].ptr);
+            bool stays = hole <= j ? (home > hole && home <= j) : (home > hole || home <= j);
+            if (!stays) {
+                live[hole] = live[j];
+                hole = j;
+            }
+        }
+        live[hole].ptr = 0;
+        return true;
+    }
+    return false;
+}
+
+// Under trace_mux
+static bool live_put(const MemLive* block) {
+    uint32_t i = live_slot(block->ptr);
+    for (uint32_t probe = 0; probe < MEM_TRACE_LIVE_MAX; probe++, i = (i + 1) & (MEM_TRACE_LIVE_MAX - 1)) {
+        if (!live[i].ptr) {
+            live[i] = *block;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Under trace_mux
+static void charge(const uint32_t* pcs, void* ptr, size_t size, uint32_t now) {
+    uint8_t region = esp_ptr_external_ram(ptr) ? MEM_REGION_PSRAM : MEM_REGION_INTERNAL;
+    uint16_t site = find_site(pcs, region);
+    mem_site_t* s = &sites[site];
+    s->allocs++;
+    s->bytes += size;
+    MemLive block = {(uintptr_t)ptr, (uint32_t)size, now, site, region, 0};
+    // Blocks past a full table are counted but never charged live
+    if (live_put(&block)) {
+        s->live_bytes += size;
+        s->live_blocks++;
+        trace_stats.live_bytes[region] += size;
+        trace_stats.live_blocks[region]++;
+    } else {
+        trace_stats.table_full++;
+    }
+    log_event(site, region, size, 0, now);
+}
+
+// Under trace_mux, for a block already out of the live table
+static void release(const MemLive* block, uint32_t now) {
+    mem_site_t* s = &sites[block->site];
+    uint32_t life = now - block->ms;
+    s->live_bytes -= block->size;
+    s->live_blocks--;
+    s->frees++;
+    s->life_ms += life;
+    if (life < MEM_TRACE_SHORT_MS) {
+        s->short_lived++;
+    }
+    trace_stats.live_bytes[block->region] -= block->size;
+    trace_stats.live_blocks[block->region]--;
+    log_event(block->site, block->region, 0, life, now);
+}
+
+static bool take(void* ptr, MemLive* block) {
+    if (!tracing || !ptr) {
+        return false;
+    }
+    portENTER_CRITICAL_SAFE(&trace_mux);
+    bool found = live_take((uintptr_t)ptr, block);
+    if (!found) {
+        trace_stats.untracked_frees++;
+    }
+    portEXIT_CRITICAL_SAFE(&trace_mux);
+    return found;
+}
+
+// Each wrapper calls one of the two track_ functions that capture, and they
+// call capture() directly, so the frames to skip are always the same
+static void __attribute__((noinline)) track_alloc(void* ptr, size_t size) {
+    if (!tracing || !ptr || xPortInIsrContext()) {
+        return;
+    }
+    uint32_t pcs[MEM_TRACE_DEPTH];
+    capture(pcs);
+    uint32_t now = millis();
+    portENTER_CRITICAL_SAFE(&trace_mux);
+    charge(pcs, ptr, size, now);
+    portEXIT_CRITICAL_SAFE(&trace_mux);
+}
+
+// old was taken out of the table before the real realloc, so no other task
+// can be handed its address while it is still listed. A realloc is charged
+// as a free and a new allocation, so a growing String shows as churn at
+// the site that grows it
+static void __attribute__((noinline)) track_realloc(const MemLive* old, void* ptr, size_t size) {
+    if (!tracing) {
+        return;
+    }
+    uint32_t pcs[MEM_TRACE_DEPTH];
+    if (ptr) {
+        capture(pcs);
+    }
+    uint32_t now = millis();
+    portENTER_CRITICAL_SAFE(&trace_mux);
+    if (!ptr && size) {
+        // Failed, the old block is still there
+        if (old && !live_put(old)) {
+            trace_stats.table_full++;
+        }
+    } else {
+        if (old) {
+            release(old, now);
+        }
+        if (ptr) {
+            charge(pcs, ptr, size, now);
+        }
+    }
+    portEXIT_CRITICAL_SAFE(&trace_mux);
+}
+
+static void track_free(void* ptr) {
+    MemLive block;
+    if (take(ptr, &block)) {
+        uint32_t now = millis();
+        portENTER_CRITICAL_SAFE(&trace_mux);
+        release(&block, now);
+        portEXIT_CRITICAL_SAFE(&trace_mux);
+    }
+}
+
+// ------------------------------------------------------------------ Wrappers
+
+extern "C" {
+
+void* __wrap_malloc(size_t size) {
+    void* p = __real_malloc(size);
+    track_alloc(p, size);
+    return p;
+}
+
+void __wrap_free(void* ptr) {
+    track_free(ptr);
+    __real_free(ptr);
+}
+
+void* __wrap_calloc(size_t n, size_t size) {
+    void* p = __real_calloc(n, size);
+    track_alloc(p, n * size);
+    return p;
+}
+
+void* __wrap_realloc(void* ptr, size_t size) {
+    MemLive old;
+    bool had = take(ptr, &old);
+    void* p = __real_realloc(ptr, size);
+    track_realloc(had ? &old : NULL, p, size);
+    return p;
+}
+
+void* __wrap__malloc_r(struct _reent* r, size_t size) {
+    void* p = __real__malloc_r(r, size);
+    track_alloc(p, size);
+    return p;
+}
+
+void __wrap__free_r(struct _reent* r, void* ptr) {
+    track_free(ptr);
+    __real__free_r(r, ptr);
+}
+
+void* __wrap__calloc_r(struct _reent* r, size_t n, size_t size) {
+    void* p = __real__calloc_r(r, n, size);
+    track_alloc(p, n * size);
+    return p;
+}
+
+void* __wrap__realloc_r(struct _reent* r, void* ptr, size_t size) {
+    MemLive old;
+    bool had = take(ptr, &old);
+    void* p = __real__realloc_r(r, ptr, size);
+    track_realloc(had ? &old : NULL, p, size);
+    return p;
+}
+
+void* __wrap_heap_caps_malloc(size_t size, uint32_t caps) {
+    void* p = __real_heap_caps_malloc(size, caps);
+    track_alloc(p, size);
+    return p;
+}
+
+void* __wrap_heap_caps_calloc(size_t n, size_t size, uint32_t caps) {
+    void* p = __real_heap_caps_calloc(n, size, caps);
+    track_alloc(p, n * size);
+    return p;
+}
+
+void* __wrap_heap_caps_realloc(void* ptr, size_t size, uint32_t caps) {
+    MemLive old;
+    bool had = take(ptr, &old);
+    void* p = __real_heap_caps_realloc(ptr, size, caps);
+    track_realloc(had ? &old : NULL, p, size);
+    return p;
+}
+
+} // extern "C"
+
+// -------------------------------------------------------------------- Report
+
+// Indexes of the n sites of a region with the most live bytes, most first
+static int top_sites(uint8_t region, uint16_t* out, int max) {
+    int n = 0;
+    for (uint16_t i = 0; i < MEM_TRACE_SITES; i++) {
+        const mem_site_t* s = &sites[i];
+        if (s->region != region || (!s->live_bytes && s->allocs == s->allocs_reported)) {
+            continue;
+        }
+        if (n < max) {
+            n++;
+        } else if (sites[out[max - 1]].live_bytes >= s->live_bytes) {
+            continue;
+        }
+        int j = n - 1;
+        while (j > 0 && sites[out[j - 1]].live_bytes < s->live_bytes) {
+            out[j] = out[j - 1];
+            j--;
+        }
+        out[j] = i;
+    }
+    return n;
+}
+
+static void print_site(Print& out, uint16_t index, uint32_t elapsed_ms) {
+    const mem_site_t* s = &sites[index];
+    char line[160];
+    uint32_t rate = elapsed_ms ? (uint32_t)((uint64_t)(s->allocs - s->allocs_reported) * 10000 / elapsed_ms) : 0;
+    uint32_t mean = s->frees ? s->life_ms / s->frees : 0;
+    snprintf(line, sizeof(line), "  #%-3u live %7lu B %5lu blk  %3lu.%lu/s  total %7lu  short %3lu%%  life %lu ms",
+             index, (unsigned long)s->live_bytes, (unsigned long)s->live_blocks, (unsigned long)(rate / 10),
+             (unsigned long)(rate % 10), (unsigned long)s->allocs,
+             (unsigned long)(s->frees ? s->short_lived * 100 / s->frees : 0), (unsigned long)mean);
+    out.println(line);
+    if (!index) {
+        out.println("      (sites past the table)");
+        return;
+    }
+    // pc:sp pairs as a panic prints them, for the monitor's decoder
+    int len = snprintf(line, sizeof(line), "      Backtrace:");
+    for (int i = 0; i < MEM_TRACE_DEPTH && s->pc[i] && len < (int)sizeof(line); i++) {
+        len += snprintf(line + len, sizeof(line) - len, " 0x%08lx:0x00000000", (unsigned long)s->pc[i]);
+    }
+    out.println(line);
+}
+
+void mem_trace_print(Print& out, bool show_ring) {
+    if (!sites) {
+        out.println("Heap trace: not running");
+        return;
+    }
+    static const char* const region_names[MEM_REGION_COUNT] = {"internal", "PSRAM"};
+    uint32_t now = millis();
+    uint32_t elapsed = now - last_report_ms;
+    mem_trace_stats_t st;
+    mem_trace_get_stats(&st);
+
+    char line[96];
+    snprintf(line, sizeof(line), "Heap trace: %lu events, %lu untracked frees, %lu past the table",
+             (unsigned long)st.events, (unsigned long)st.untracked_frees, (unsigned long)st.table_full);
+    out.println(line);
+
+    // Counters are read without the lock; a report may be a few events off
+    uint16_t top[MEM_TRACE_TOP];
+    for (uint8_t r = 0; r < MEM_REGION_COUNT; r++) {
+        snprintf(line, sizeof(line), " %s: %lu B live in %lu blocks, %u B free, %u B largest", region_names[r],
+                 (unsigned long)st.live_bytes[r], (unsigned long)st.live_blocks[r],
+                 heap_caps_get_free_size(r ? MALLOC_CAP_SPIRAM : MALLOC_CAP_INTERNAL),
+                 heap_caps_get_largest_free_block(r ? MALLOC_CAP_SPIRAM : MALLOC_CAP_INTERNAL));
+        out.println(line);
+        int n = top_sites(r, top, MEM_TRACE_TOP);
+        for (int i = 0; i < n; i++) {
+            print_site(out, top[i], elapsed);
+        }
+    }
+    for (uint16_t i = 0; i < MEM_TRACE_SITES; i++) {
+        sites[i].allocs_reported = sites[i].allocs;
+    }
+    last_report_ms = now;
+
+    if (!show_ring) {
+        return;
+    }
+    out.println(" Sampled events (ms, site, region, size or lifetime):");
+    uint16_t start = (ring_head + MEM_TRACE_RING - ring_count) % MEM_TRACE_RING;
+    for (uint16_t i = 0; i < ring_count; i++) {
+        mem_trace_event_t e = ring[(start + i) % MEM_TRACE_RING];
+        if (e.size) {
+            snprintf(line, sizeof(line), "  %8lu #%-3u %c alloc %lu", (unsigned long)e.ms, e.site,
+                     e.region ? 'P' : 'I', (unsigned long)e.size);
+        } else {
+            snprintf(line, sizeof(line), "  %8lu #%-3u %c free after %lu ms", (unsigned long)e.ms, e.site,
+                     e.region ? 'P' : 'I', (unsigned long)e.life_ms);
+        }
+        out.println(line);
+    }
+}
+
+static void report_tick(WheelTimer* timer) {
+    mem_trace_print(Serial);
+}
+
+bool mem_trace_begin() {
+    if (sites) {
+        return true;
+    }
+    // From the real allocator, so the profiler does not profile itself
+    const uint32_t caps = MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT;
+    sites = (mem_site_t*)__real_heap_caps_calloc(MEM_TRACE_SITES, sizeof(mem_site_t), caps);
+    live = (MemLive*)__real_heap_caps_calloc(MEM_TRACE_LIVE_MAX, sizeof(MemLive), caps);
+    ring = (mem_trace_event_t*)__real_heap_caps_calloc(MEM_TRACE_RING, sizeof(mem_trace_event_t), caps);
+    if (!sites || !live || !ring) {
+        __real_free(sites);
+        __real_free(live);
+        __real_free(ring);
+        sites = NULL;
+        live = NULL;
+        ring = NULL;
+        LOG_ERROR("MemTrace", "No PSRAM for the tables");
+        return false;
+    }
+    last_report_ms = millis();
+    tracing = true;
+
+    if (MEM_TRACE_REPORT_MS) {
+        timer_wheel_init(&report_timer, "memtrace", report_tick);
+        timer_wheel_arm(&report_timer, MEM_TRACE_REPORT_MS, MEM_TRACE_REPORT_MS);
+    }
+    LOG_INFOF("MemTrace", "Tracing %u sites, %u live blocks", MEM_TRACE_SITES, MEM_TRACE_LIVE_MAX);
+    return true;
+}
+
+void mem_trace_get_stats(mem_trace_stats_t* stats) {
+    portENTER_CRITICAL_SAFE(&trace_mux);
+    *stats = trace_stats;
+    portEXIT_CRITICAL_SAFE(&trace_mux);
+}
+
+#endif // DEBUG_MEMORY_TRACKING
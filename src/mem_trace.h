@@ -0,0 +1,105 @@
+/**
+ * @file      mem_trace.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Heap allocation-site profiler for DEBUG_MEMORY_TRACKING builds
+ */
+
+#ifndef MEM_TRACE_H
+#define MEM_TRACE_H
+
+#include <Arduino.h>
+#include "config/os_config.h"
+
+/**
+ * Every malloc, calloc, realloc and free, newlib's _r variants and the
+ * heap_caps allocators are routed through this module by the linker
+ * (--wrap, see [mem_trace] in platformio.ini), so String, operator new
+ * and library code are all seen. An allocation is charged to a site, the
+ * few return addresses above the allocator, kept apart for internal RAM
+ * and PSRAM. Per site the profiler keeps live bytes and blocks, totals,
+ * the allocation rate and how long freed blocks lived; blocks freed
+ * within MEM_TRACE_SHORT_MS count as churn.
+ *
+ * Live blocks are followed in a PSRAM table so a free finds its site;
+ * blocks from before mem_trace_begin() or past a full table are not
+ * charged. One event in MEM_TRACE_SAMPLE also goes to a ring for a
+ * timeline. Reports print the busiest sites with a "Backtrace:" line
+ * that the esp32_exception_decoder monitor filter turns into symbols.
+ *
+ * heap_caps_free() is left alone because newlib's free() ends in it;
+ * a block given back that way stays live in the report.
+ */
+
+#define MEM_TRACE_DEPTH             6       // Return addresses per site
+#define MEM_TRACE_SITES             256     // Power of two
+#define MEM_TRACE_LIVE_MAX          8192    // Power of two, 16 bytes each in PSRAM
+#define MEM_TRACE_RING              512
+#define MEM_TRACE_SAMPLE            16      // One event in this many goes to the ring
+#define MEM_TRACE_SHORT_MS          100
+#define MEM_TRACE_TOP               12      // Sites per region in a report
+#define MEM_TRACE_REPORT_MS         60000   // 0 for no periodic report
+
+enum MemRegion {
+    MEM_REGION_INTERNAL = 0,
+    MEM_REGION_PSRAM,
+    MEM_REGION_COUNT,
+};
+
+typedef struct {
+    uint32_t pc[MEM_TRACE_DEPTH];
+    uint8_t region;
+    uint32_t live_bytes;
+    uint32_t live_blocks;
+    uint32_t allocs;
+    uint32_t frees;
+    uint32_t bytes;                 // Allocated in total
+    uint32_t short_lived;           // Freed within MEM_TRACE_SHORT_MS
+    uint32_t life_ms;               // Summed over the frees, for the mean
+    uint32_t allocs_reported;       // allocs at the last report, for the rate
+} mem_site_t;
+
+typedef struct {
+    uint32_t ms;
+    uint32_t size;                  // 0 for a free
+    uint32_t life_ms;               // Of a freed block
+    uint16_t site;
+    uint8_t region;
+} mem_trace_event_t;
+
+typedef struct {
+    uint32_t events;
+    uint32_t untracked_frees;       // Blocks from before the start or past a full table
+    uint32_t table_full;
+    uint32_t sites_full;            // Charged to site 0
+    uint32_t live_bytes[MEM_REGION_COUNT];
+    uint32_t live_blocks[MEM_REGION_COUNT];
+} mem_trace_stats_t;
+
+#if DEBUG_MEMORY_TRACKING
+
+/**
+ * @brief Allocate the tables in PSRAM and start charging allocations.
+ *        Call early in setup(); earlier blocks are not followed
+ */
+bool mem_trace_begin();
+
+/**
+ * @brief Busiest sites by live bytes for each region, with the rate since
+ *        the last report, then the last ring events if asked
+ */
+void mem_trace_print(Print& out, bool ring = false);
+
+void mem_trace_get_stats(mem_trace_stats_t* stats);
+
+#else
+
+inline bool mem_trace_begin() { return false; }
+inline void mem_trace_print(Print& out, bool ring = false) {}
+inline void mem_trace_get_stats(mem_trace_stats_t* stats) { memset(stats, 0, sizeof(*stats)); }
+
+#endif // DEBUG_MEMORY_TRACKING
+
+#endif // MEM_TRACE_H
@@ -0,0 +1,665 @@
+/**
+ * @file      mesh_proto.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Meshtastic protobuf codec: in-place decode, encode into the mesh frame
+ */
+
+#include "mesh_proto.h"
+#include <stddef.h>
+#include <esp_timer.h>
+#include <mbedtls/aes.h>
+#include "simple_logger.h"
+#include "msg_store.h"
+#include "usb_console.h"
+#ifdef INTEGRATION_LAYER_ENABLED
+#include "integration/config_manager.h"
+#endif
+
+// ===== Tables =====
+
+#define PB_F(tag, type, st, member)     { tag, type, (uint16_t)offsetof(st, member), NULL }
+#define PB_M(tag, st, member, sub)      { tag, MESH_PB_MESSAGE, (uint16_t)offsetof(st, member), &sub }
+#define PB_COUNT(fields)                (uint8_t)(sizeof(fields) / sizeof(fields[0]))
+
+static constexpr MeshPbField data_fields[] = {
+    PB_F(1, MESH_PB_UINT32,   MeshData, portnum),
+    PB_F(2, MESH_PB_BYTES,    MeshData, payload),
+    PB_F(3, MESH_PB_BOOL,     MeshData, want_response),
+    PB_F(4, MESH_PB_FIXED32,  MeshData, dest),
+    PB_F(5, MESH_PB_FIXED32,  MeshData, source),
+    PB_F(6, MESH_PB_FIXED32,  MeshData, request_id),
+    PB_F(7, MESH_PB_FIXED32,  MeshData, reply_id),
+    PB_F(8, MESH_PB_FIXED32,  MeshData, emoji),
+    PB_F(9, MESH_PB_UINT32,   MeshData, bitfield),
+};
+extern constexpr MeshPbMsg mesh_pb_data = { data_fields, PB_COUNT(data_fields) };
+
+static constexpr MeshPbField position_fields[] = {
+    PB_F(1,  MESH_PB_SFIXED32, MeshPosition, latitude_i),
+    PB_F(2,  MESH_PB_SFIXED32, MeshPosition, longitude_i),
+    PB_F(3,  MESH_PB_INT32,    MeshPosition, altitude),
+    PB_F(4,  MESH_PB_FIXED32,  MeshPosition, time),
+    PB_F(5,  MESH_PB_UINT32,   MeshPosition, location_source),
+    PB_F(9,  MESH_PB_SINT32,   MeshPosition, altitude_hae),
+    PB_F(11, MESH_PB_UINT32,   MeshPosition, pdop),
+    PB_F(15, MESH_PB_UINT32,   MeshPosition, ground_speed),
+    PB_F(16, MESH_PB_UINT32,   MeshPosition, ground_track),
+    PB_F(19, MESH_PB_UINT32,   MeshPosition, sats_in_view),
+    PB_F(23, MESH_PB_UINT32,   MeshPosition, precision_bits),
+};
+extern constexpr MeshPbMsg mesh_pb_position = { position_fields, PB_COUNT(position_fields) };
+
+static constexpr MeshPbField user_fields[] = {
+    PB_F(1, MESH_PB_BYTES,    MeshUser, id),
+    PB_F(2, MESH_PB_BYTES,    MeshUser, long_name),
+    PB_F(3, MESH_PB_BYTES,    MeshUser, short_name),
+    PB_F(5, MESH_PB_UINT32,   MeshUser, hw_model),
+    PB_F(6, MESH_PB_BOOL,     MeshUser, is_licensed),
+    PB_F(7, MESH_PB_UINT32,   MeshUser, role),
+    PB_F(8, MESH_PB_BYTES,    MeshUser, public_key),
+};
+extern constexpr MeshPbMsg mesh_pb_user = { user_fields, PB_COUNT(user_fields) };
+
+// route_request and route_reply (repeated node lists) go to the field callback
+static constexpr MeshPbField routing_fields[] = {
+    PB_F(3, MESH_PB_UINT32,   MeshRouting, error_reason),
+};
+extern constexpr MeshPbMsg mesh_pb_routing = { routing_fields, PB_COUNT(routing_fields) };
+
+static constexpr MeshPbField metrics_fields[] = {
+    PB_F(1, MESH_PB_UINT32,   MeshDeviceMetrics, battery_level),
+    PB_F(2, MESH_PB_FLOAT,    MeshDeviceMetrics, voltage),
+    PB_F(3, MESH_PB_FLOAT,    MeshDeviceMetrics, channel_utilization),
+    PB_F(4, MESH_PB_FLOAT,    MeshDeviceMetrics, air_util_tx),
+    PB_F(5, MESH_PB_UINT32,   MeshDeviceMetrics, uptime_seconds),
+};
+static constexpr MeshPbMsg mesh_pb_metrics = { metrics_fields, PB_COUNT(metrics_fields) };
+
+static constexpr MeshPbField telemetry_fields[] = {
+    PB_F(1, MESH_PB_FIXED32,  MeshTelemetry, time),
+    PB_M(2, MeshTelemetry, device_metrics, mesh_pb_metrics),
+};
+extern constexpr MeshPbMsg mesh_pb_telemetry = { telemetry_fields, PB_COUNT(telemetry_fields) };
+
+static constexpr MeshPbField packet_fields[] = {
+    PB_F(1,  MESH_PB_FIXED32,  MeshPacket, from),
+    PB_F(2,  MESH_PB_FIXED32,  MeshPacket, to),
+    PB_F(3,  MESH_PB_UINT32,   MeshPacket, channel),
+    PB_M(4,  MeshPacket, decoded, mesh_pb_data),
+    PB_F(5,  MESH_PB_BYTES,    MeshPacket, encrypted),
+    PB_F(6,  MESH_PB_FIXED32,  MeshPacket, id),
+    PB_F(7,  MESH_PB_FIXED32,  MeshPacket, rx_time),
+    PB_F(8,  MESH_PB_FLOAT,    MeshPacket, rx_snr),
+    PB_F(9,  MESH_PB_UINT32,   MeshPacket, hop_limit),
+    PB_F(10, MESH_PB_BOOL,     MeshPacket, want_ack),
+    PB_F(11, MESH_PB_UINT32,   MeshPacket, priority),
+    PB_F(12, MESH_PB_INT32,    MeshPacket, rx_rssi),
+    PB_F(14, MESH_PB_BOOL,     MeshPacket, via_mqtt),
+    PB_F(15, MESH_PB_UINT32,   MeshPacket, hop_start),
+};
+extern constexpr MeshPbMsg mesh_pb_packet = { packet_fields, PB_COUNT(packet_fields) };
+
+static_assert(PB_COUNT(position_fields) <= MESH_PB_FIELDS_MAX && PB_COUNT(packet_fields) <= MESH_PB_FIELDS_MAX,
+              "A table is wider than the presence mask");
+
+// LongFast's default key (PSK index 1); LORA_MESH_CHANNEL_HASH is derived from it
+static constexpr uint8_t mesh_default_key[16] = {
+    0xd4, 0xf1, 0xbb, 0x3a, 0x20, 0x29, 0x07, 0x59, 0xf0, 0xbc, 0xff, 0xab, 0xcf, 0x4e, 0x69, 0x01,
+};
+
+struct MeshHandler {
+    uint32_t port;
+    mesh_proto_handler fn;
+    void *ctx;
+};
+
+static portMUX_TYPE proto_mux = portMUX_INITIALIZER_UNLOCKED;
+static MeshHandler proto_handlers[MESH_PROTO_HANDLERS];
+static MeshProtoStats proto_stats;
+static mbedtls_aes_context proto_aes;
+static bool proto_ready = false;
+
+// ===== Wire =====
+
+enum {
+    WIRE_VARINT = 0,
+    WIRE_FIXED64 = 1,
+    WIRE_LEN = 2,
+    WIRE_FIXED32 = 5,
+};
+
+static inline uint8_t wire_of(uint8_t type) {
+    switch (type) {
+    case MESH_PB_FIXED32:
+    case MESH_PB_SFIXED32:
+    case MESH_PB_FLOAT:
+        return WIRE_FIXED32;
+    case MESH_PB_BYTES:
+    case MESH_PB_MESSAGE:
+        return WIRE_LEN;
+    default:
+        return WIRE_VARINT;
+    }
+}
+
+static inline bool read_varint(const uint8_t **p, const uint8_t *end, uint64_t *v) {
+    uint64_t x = 0;
+    for (int shift = 0; *p < end && shift < 64; shift += 7) {
+        uint8_t b = *(*p)++;
+        x |= (uint64_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) {
+            *v = x;
+            return true;
+        }
+    }
+    return false;
+}
+
+static inline size_t varint_size(uint64_t v) {
+    size_t n = 1;
+    while (v >= 0x80) {
+        v >>= 7;
+        n++;
+    }
+    return n;
+}
+
+static inline uint8_t *write_varint(uint8_t *p, const uint8_t *end, uint64_t v) {
+    if (!p) {
+        return NULL;
+    }
+    while (v >= 0x80) {
+        if (p >= end) {
+            return NULL;
+        }
+        *p++ = (uint8_t)v | 0x80;
+        v >>= 7;
+    }
+    if (p >= end) {
+        return NULL;
+    }
+    *p++ = (uint8_t)v;
+    return p;
+}
+
+static inline uint8_t *write_raw(uint8_t *p, const uint8_t *end, const void *data, size_t len) {
+    if (!p || (size_t)(end - p) < len) {
+        return NULL;
+    }
+    memcpy(p, data, len);
+    return p + len;
+}
+
+static inline const MeshPbField *find_field(const MeshPbMsg *msg, uint8_t tag, int *index) {
+    for (int i = 0; i < msg->count; i++) {
+        if (msg->fields[i].tag == tag) {
+            *index = i;
+            return &msg->fields[i];
+        }
+    }
+    return NULL;
+}
+
+// ===== Decode =====
+
+static bool decode(const MeshPbMsg *msg, const uint8_t *p, const uint8_t *end, uint8_t *out,
+                   mesh_pb_field_cb cb, void *ctx, int depth) {
+    uint32_t *has = (uint32_t *)out;
+    while (p < end) {
+        uint64_t key;
+        if (!read_varint(&p, end, &key) || (key >> 3) == 0) {
+            return false;
+        }
+        uint32_t tag = key >> 3;
+        uint8_t wire = key & 7;
+
+        uint64_t value = 0;
+        MeshPbSpan span = {NULL, 0};
+        switch (wire) {
+        case WIRE_VARINT:
+            if (!read_varint(&p, end, &value)) {
+                return false;
+            }
+            break;
+        case WIRE_FIXED64:
+        case WIRE_FIXED32: {
+            size_t n = wire == WIRE_FIXED64 ? 8 : 4;
+            if ((size_t)(end - p) < n) {
+                return false;
+            }
+            memcpy(&value, p, n);
+            p += n;
+            break;
+        }
+        case WIRE_LEN: {
+            uint64_t n;
+            if (!read_varint(&p, end, &n) || n > (uint64_t)(end - p)) {
+                return false;
+            }
+            span.data = p;
+            span.len = (uint16_t)n;
+            p += n;
+            break;
+        }
+        default:
+            return false;           // Groups are long gone from proto3
+        }
+
+        int index;
+        const MeshPbField *f = tag <= 0xFF ? find_field(msg, tag, &index) : NULL;
+        if (!f || wire_of(f->type) != wire) {
+            if (cb && !cb(tag, wire, value, span, ctx)) {
+                return false;
+            }
+            continue;
+        }
+
+        uint8_t *dst = out + f->offset;
+        switch (f->type) {
+        case MESH_PB_UINT32:
+        case MESH_PB_FIXED32:
+            *(uint32_t *)dst = (uint32_t)value;
+            break;
+        case MESH_PB_INT32:
+        case MESH_PB_SFIXED32:
+            *(int32_t *)dst = (int32_t)value;
+            break;
+        case MESH_PB_SINT32:
+            *(int32_t *)dst = (int32_t)((uint32_t)(value >> 1) ^ -(uint32_t)(value & 1));
+            break;
+        case MESH_PB_BOOL:
+            *(bool *)dst = value != 0;
+            break;
+        case MESH_PB_FLOAT: {
+            uint32_t bits = (uint32_t)value;
+            memcpy(dst, &bits, 4);
+            break;
+        }
+        case MESH_PB_BYTES:
+            *(MeshPbSpan *)dst = span;
+            break;
+        case MESH_PB_MESSAGE:
+            // A repeated occurrence merges into what is there, as protobuf does
+            if (depth >= MESH_PB_DEPTH_MAX ||
+                !decode(f->sub, span.data, span.data + span.len, dst, cb, ctx, depth + 1)) {
+                return false;
+            }
+            break;
+        }
+        *has |= 1UL << index;
+    }
+    return true;
+}
+
+static void clear(const MeshPbMsg *msg, uint8_t *out) {
+    *(uint32_t *)out = 0;
+    for (int i = 0; i < msg->count; i++) {
+        const MeshPbField *f = &msg->fields[i];
+        uint8_t *dst = out + f->offset;
+        switch (f->type) {
+        case MESH_PB_BOOL:
+            *(bool *)dst = false;
+            break;
+        case MESH_PB_BYTES:
+            *(MeshPbSpan *)dst = {NULL, 0};
+            break;
+        case MESH_PB_MESSAGE:
+            clear(f->sub, dst);
+            break;
+        default:
+            *(uint32_t *)dst = 0;
+            break;
+        }
+    }
+}
+
+// ===== Encode =====
+
+static uint64_t scalar_of(const MeshPbField *f, const uint8_t *src) {
+    switch (f->type) {
+    case MESH_PB_INT32:
+        return (uint64_t)(int64_t)*(const int32_t *)src;
+    case MESH_PB_SINT32: {
+        int32_t v = *(const int32_t *)src;
+        return (uint32_t)((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+    }
+    case MESH_PB_BOOL:
+        return *(const bool *)src ? 1 : 0;
+    default:
+        return *(const uint32_t *)src;
+    }
+}
+
+static size_t size_of(const MeshPbMsg *msg, const uint8_t *in) {
+    uint32_t has = *(const uint32_t *)in;
+    size_t n = 0;
+    for (int i = 0; i < msg->count; i++) {
+        if (!(has & (1UL << i))) {
+            continue;
+        }
+        const MeshPbField *f = &msg->fields[i];
+        const uint8_t *src = in + f->offset;
+        n += varint_size((uint32_t)f->tag << 3);
+        switch (wire_of(f->type)) {
+        case WIRE_FIXED32:
+            n += 4;
+            break;
+        case WIRE_LEN: {
+            size_t len = f->type == MESH_PB_BYTES ? ((const MeshPbSpan *)src)->len : size_of(f->sub, src);
+            n += varint_size(len) + len;
+            break;
+        }
+        default:
+            n += varint_size(scalar_of(f, src));
+            break;
+        }
+    }
+    return n;
+}
+
+static uint8_t *encode(const MeshPbMsg *msg, const uint8_t *in, uint8_t *p, const uint8_t *end) {
+    uint32_t has = *(const uint32_t *)in;
+    for (int i = 0; i < msg->count && p; i++) {
+        if (!(has & (1UL << i))) {
+            continue;
+        }
+        const MeshPbField *f = &msg->fields[i];
+        const uint8_t *src = in + f->offset;
+        uint8_t wire = wire_of(f->type);
+        p = write_varint(p, end, (uint32_t)f->tag << 3 | wire);
+        switch (wire) {
+        case WIRE_FIXED32:
+            p = write_raw(p, end, src, 4);
+            break;
+        case WIRE_LEN:
+            if (f->type == MESH_PB_BYTES) {
+                const MeshPbSpan *s = (const MeshPbSpan *)src;
+                p = write_varint(p, end, s->len);
+                p = write_raw(p, end, s->data, s->len);
+            } else {
+                p = write_varint(p, end, size_of(f->sub, src));
+                p = p ? encode(f->sub, src, p, end) : NULL;
+            }
+            break;
+        default:
+            p = write_varint(p, end, scalar_of(f, src));
+            break;
+        }
+    }
+    return p;
+}
+
+// ===== API: codec =====
+
+uint32_t mesh_pb_bit(const MeshPbMsg *msg, uint8_t tag) {
+    int index;
+    return find_field(msg, tag, &index) ? 1UL << index : 0;
+}
+
+bool mesh_pb_decode(const MeshPbMsg *msg, const uint8_t *buf, size_t len, void *out,
+                    mesh_pb_field_cb cb, void *ctx) {
+    clear(msg, (uint8_t *)out);
+    return decode(msg, buf, buf + len, (uint8_t *)out, cb, ctx, 0);
+}
+
+size_t mesh_pb_size(const MeshPbMsg *msg, const void *in) {
+    return size_of(msg, (const uint8_t *)in);
+}
+
+size_t mesh_pb_encode(const MeshPbMsg *msg, const void *in, uint8_t *out, size_t cap) {
+    uint8_t *p = encode(msg, (const uint8_t *)in, out, out + cap);
+    return p ? p - out : 0;
+}
+
+// ===== Mesh =====
+
+// AES-CTR both ways; the nonce is the packet id as 64 bits, then the sender
+static void crypt(const LoraMeshHeader *h, const uint8_t *in, uint8_t *out, size_t len) {
+    uint8_t nonce[16] = {0};
+    uint8_t stream[16];
+    size_t off = 0;
+    uint64_t id = h->id;
+    memcpy(nonce, &id, 8);
+    memcpy(nonce + 8, &h->from, 4);
+    mbedtls_aes_crypt_ctr(&proto_aes, len, &off, nonce, stream, in, out);
+}
+
+static void stat_max(uint32_t *slot, uint32_t us) {
+    portENTER_CRITICAL(&proto_mux);
+    if (us > *slot) {
+        *slot = us;
+    }
+    portEXIT_CRITICAL(&proto_mux);
+}
+
+static bool open_packet(const LoraMeshHeader *h, const uint8_t *payload, size_t len, uint8_t *plain, MeshData *d) {
+    crypt(h, payload, plain, len);
+    return mesh_pb_decode(&mesh_pb_data, plain, len, d) && d->portnum;
+}
+
+static void on_packet(const LoraMeshHeader *h, const uint8_t *payload, size_t len) {
+    int64_t start = esp_timer_get_time();
+    uint8_t plain[LORA_MESH_PAYLOAD_MAX];
+    MeshData d;
+    if (!proto_ready || len > sizeof(plain) || !open_packet(h, payload, len, plain, &d)) {
+        portENTER_CRITICAL(&proto_mux);
+        proto_stats.malformed++;
+        portEXIT_CRITICAL(&proto_mux);
+        return;
+    }
+    stat_max(&proto_stats.decode_us_max, (uint32_t)(esp_timer_get_time() - start));
+
+    MeshHandler handler = {0, NULL, NULL};
+    portENTER_CRITICAL(&proto_mux);
+    proto_stats.decoded++;
+    for (int i = 0; i < MESH_PROTO_HANDLERS; i++) {
+        if (proto_handlers[i].fn && proto_handlers[i].port == d.portnum) {
+            handler = proto_handlers[i];
+            break;
+        }
+    }
+    if (handler.fn) {
+        proto_stats.handled++;
+    } else if (d.portnum == MESH_PORT_TEXT) {
+        proto_stats.texts++;
+    } else {
+        proto_stats.unhandled++;
+    }
+    portEXIT_CRITICAL(&proto_mux);
+
+    if (handler.fn) {
+        handler.fn(h, &d, handler.ctx);
+    } else if (d.portnum == MESH_PORT_TEXT && d.payload.len) {
+        char peer[12];
+        snprintf(peer, sizeof(peer), "!%08lx", (unsigned long)h->from);
+        msg_store_append(MSG_CHANNEL_MESH, peer, (const char *)d.payload.data, d.payload.len);
+    }
+}
+
+struct MeshFill {
+    uint32_t port;
+    const MeshPbMsg *msg;           // Payload as a message
+    const void *payload;
+    const uint8_t *raw;             // Or as bytes
+    size_t raw_len;
+};
+
+// Data { portnum = 1, payload = 2 } straight into the frame, then encrypted there
+static size_t fill_data(const LoraMeshHeader *h, uint8_t *out, size_t cap, void *ctx) {
+    const MeshFill *f = (const MeshFill *)ctx;
+    int64_t start = esp_timer_get_time();
+    const uint8_t *end = out + cap;
+
+    uint8_t *p = write_varint(out, end, 1 << 3 | WIRE_VARINT);
+    p = write_varint(p, end, f->port);
+    if (f->msg) {
+        p = write_varint(p, end, 2 << 3 | WIRE_LEN);
+        p = write_varint(p, end, mesh_pb_size(f->msg, f->payload));
+        p = p ? encode(f->msg, (const uint8_t *)f->payload, p, end) : NULL;
+    } else if (f->raw) {
+        p = write_varint(p, end, 2 << 3 | WIRE_LEN);
+        p = write_varint(p, end, f->raw_len);
+        p = write_raw(p, end, f->raw, f->raw_len);
+    }
+    if (!p) {
+        return 0;
+    }
+    crypt(h, out, out, p - out);
+    stat_max(&proto_stats.encode_us_max, (uint32_t)(esp_timer_get_time() - start));
+    return p - out;
+}
+
+static bool send_fill(uint32_t to, MeshFill *f) {
+    if (!proto_ready || !lora_mesh_send_fill(to, fill_data, f)) {
+        return false;
+    }
+    portENTER_CRITICAL(&proto_mux);
+    proto_stats.sent++;
+    portEXIT_CRITICAL(&proto_mux);
+    return true;
+}
+
+// ===== Console =====
+
+static void bench(Print &out, uint32_t n) {
+    LoraMeshHeader h = {LORA_MESH_BROADCAST, 0x12345678, 0xCAFE0001, 0x63, LORA_MESH_CHANNEL_HASH, 0, 0x78};
+    static const char text[] = "Camp at the north ridge, 2 km past the hut. Bring water.";
+
+    MeshPosition pos;
+    memset(&pos, 0, sizeof(pos));
+    pos.latitude_i = 473977420;
+    pos.longitude_i = 85455940;
+    pos.altitude = 1402;
+    pos.time = 1736600000;
+    pos.sats_in_view = 9;
+    pos.precision_bits = 32;
+    pos.has = mesh_pb_bit(&mesh_pb_position, 1) | mesh_pb_bit(&mesh_pb_position, 2) |
+              mesh_pb_bit(&mesh_pb_position, 3) | mesh_pb_bit(&mesh_pb_position, 4) |
+              mesh_pb_bit(&mesh_pb_position, 19) | mesh_pb_bit(&mesh_pb_position, 23);
+
+    MeshFill fills[2] = {
+        {MESH_PORT_TEXT, NULL, NULL, (const uint8_t *)text, sizeof(text) - 1},
+        {MESH_PORT_POSITION, &mesh_pb_position, &pos, NULL, 0},
+    };
+    const char *names[2] = {"text", "position"};
+
+    for (int k = 0; k < 2; k++) {
+        uint8_t frame[LORA_MESH_PAYLOAD_MAX], plain[LORA_MESH_PAYLOAD_MAX];
+        size_t len = 0;
+        int64_t t0 = esp_timer_get_time();
+        for (uint32_t i = 0; i < n; i++) {
+            len = fill_data(&h, frame, sizeof(frame), &fills[k]);
+        }
+        int64_t t1 = esp_timer_get_time();
+        bool ok = len > 0;
+        MeshData d;
+        for (uint32_t i = 0; i < n && ok; i++) {
+            ok = open_packet(&h, frame, len, plain, &d);
+        }
+        int64_t t2 = esp_timer_get_time();
+        if (ok && k == 1) {
+            MeshPosition back;
+            ok = mesh_pb_decode(&mesh_pb_position, d.payload.data, d.payload.len, &back) &&
+                 back.latitude_i == pos.latitude_i && back.altitude == pos.altitude && back.has == pos.has;
+        }
+        out.printf("%-9s %3u B: encode %.1f us, decode %.1f us per packet, round trip %s\n", names[k],
+                   (unsigned)len, (double)(t1 - t0) / n, (double)(t2 - t1) / n, ok ? "ok" : "FAILED");
+    }
+}
+
+static void rpc_meshpb(Print &out, const char *args) {
+    while (*args == ' ') {
+        args++;
+    }
+    if (!strncmp(args, "bench", 5)) {
+        int n = atoi(args + 5);
+        bench(out, n > 0 ? n : MESH_PROTO_BENCH_N);
+        return;
+    }
+    if (!strncmp(args, "send ", 5)) {
+        const char *text = args + 5;
+        out.println(mesh_proto_send_text(LORA_MESH_BROADCAST, text, strlen(text)) ? "sent" : "not sent");
+        return;
+    }
+    MeshProtoStats s;
+    mesh_proto_get_stats(&s);
+    out.printf("%s as !%08lx\n", lora_mesh_node_id() ? "In the mesh" : "Not in the mesh",
+               (unsigned long)lora_mesh_node_id());
+    out.printf("decoded %lu (texts %lu, handled %lu, unhandled %lu), malformed %lu, sent %lu\n",
+               (unsigned long)s.decoded, (unsigned long)s.texts, (unsigned long)s.handled,
+               (unsigned long)s.unhandled, (unsigned long)s.malformed, (unsigned long)s.sent);
+    out.printf("slowest decode %lu us, encode %lu us\n", (unsigned long)s.decode_us_max,
+               (unsigned long)s.encode_us_max);
+}
+
+// ===== API: mesh =====
+
+bool mesh_proto_begin() {
+    if (proto_ready) {
+        return true;
+    }
+    mbedtls_aes_init(&proto_aes);
+    if (mbedtls_aes_setkey_enc(&proto_aes, mesh_default_key, 128) != 0) {
+        LOG_ERROR("MeshProto", "Failed to set the channel key");
+        return false;
+    }
+    proto_ready = true;
+    usb_console_rpc("meshpb", rpc_meshpb);
+
+    bool enabled = false;
+#ifdef INTEGRATION_LAYER_ENABLED
+    enabled = GET_CONFIG_BOOL("mesh", "enabled", false);
+#endif
+    if (!enabled) {
+        return true;
+    }
+    if (!peri_init_ensure(E_PERI_LORA)) {
+        LOG_ERROR("MeshProto", "No LoRa radio");
+        return false;
+    }
+    return lora_mesh_begin(on_packet);
+}
+
+bool mesh_proto_set_handler(uint32_t port, mesh_proto_handler handler, void *ctx) {
+    bool ok = false;
+    portENTER_CRITICAL(&proto_mux);
+    for (int i = 0; i < MESH_PROTO_HANDLERS && !ok; i++) {
+        if (proto_handlers[i].fn && proto_handlers[i].port == port) {
+            proto_handlers[i] = {port, handler, ctx};
+            ok = true;
+        }
+    }
+    for (int i = 0; i < MESH_PROTO_HANDLERS && !ok && handler; i++) {
+        if (!proto_handlers[i].fn) {
+            proto_handlers[i] = {port, handler, ctx};
+            ok = true;
+        }
+    }
+    portEXIT_CRITICAL(&proto_mux);
+    return ok || !handler;
+}
+
+bool mesh_proto_send(uint32_t to, uint32_t port, const MeshPbMsg *msg, const void *payload) {
+    MeshFill f = {port, payload ? msg : NULL, payload, NULL, 0};
+    return send_fill(to, &f);
+}
+
+bool mesh_proto_send_text(uint32_t to, const char *text, size_t len) {
+    MeshFill f = {MESH_PORT_TEXT, NULL, NULL, (const uint8_t *)text, len};
+    if (!len || !send_fill(to, &f)) {
+        return false;
+    }
+    char peer[12];
+    snprintf(peer, sizeof(peer), "!%08lx", (unsigned long)to);
+    msg_store_append(MSG_CHANNEL_MESH, peer, text, len, MSG_FLAG_OUT);
+    return true;
+}
+
+void mesh_proto_get_stats(MeshProtoStats *out) {
+    portENTER_CRITICAL(&proto_mux);
+    *out = proto_stats;
+    portEXIT_CRITICAL(&proto_mux);
+}
@@ -0,0 +1,249 @@
+/**
+ * @file      mesh_proto.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Meshtastic protobuf codec: in-place decode, encode into the mesh frame
+ */
+
+#ifndef MESH_PROTO_H
+#define MESH_PROTO_H
+
+#include <Arduino.h>
+#include "lora_mesh.h"
+
+/**
+ * The messages Meshtastic nodes put on air are described by constexpr
+ * field tables (MeshPbMsg), nanopb style, and decoded by one table-driven
+ * reader into plain structs. Nothing is copied out of the packet: bytes
+ * and strings come back as MeshPbSpan pointing into the buffer, nested
+ * messages fill the embedded struct, and fields a table does not map
+ * (repeated ones, newer fields) go to a field callback if one is given.
+ * Spans are valid as long as the buffer is.
+ *
+ * Every message struct starts with a presence mask, bit i for the i-th
+ * entry of its table: set by the decoder for fields it saw, read by the
+ * encoder, which writes only those. A zero latitude can be sent that way.
+ *
+ * On air the Data message is AES-CTR encrypted with the channel key
+ * (LongFast's default key, which LORA_MESH_CHANNEL_HASH matches; the
+ * nonce is packet id and sender). Received packets for this node are
+ * decrypted into one LORA_MESH_PAYLOAD_MAX buffer on the stack and decoded
+ * from there; sends are encoded straight into the frame lora_mesh hands to
+ * the TX queue and encrypted in place. Relays never get here: lora_mesh
+ * forwards them on the header alone, ciphertext untouched.
+ *
+ * Text messages go to msg_store on MSG_CHANNEL_MESH with the sender as
+ * "!%08x". Other ports go to the handler registered for them.
+ *
+ * Console: "meshpb" for counters, "meshpb bench [n]" to time decode and
+ * encode of a text and a position packet, "meshpb send <text>" to
+ * broadcast a text.
+ * Config section "mesh": enabled (false), joins the mesh at boot.
+ */
+
+#define MESH_PB_FIELDS_MAX          32      // Of one message; the presence mask's width
+#define MESH_PB_DEPTH_MAX           4       // Nested messages
+#define MESH_PROTO_HANDLERS         8
+#define MESH_PROTO_BENCH_N          1000
+
+// PortNum, the ones this codec has tables for or routes
+#define MESH_PORT_TEXT              1
+#define MESH_PORT_POSITION          3
+#define MESH_PORT_NODEINFO          4
+#define MESH_PORT_ROUTING           5
+#define MESH_PORT_TELEMETRY         67
+#define MESH_PORT_TRACEROUTE        70
+
+enum MeshPbType {
+    MESH_PB_UINT32 = 0,             // uint32/enum/bool as varint -> uint32_t
+    MESH_PB_INT32,                  // int32 as varint, sign-extended -> int32_t
+    MESH_PB_SINT32,                 // zigzag varint -> int32_t
+    MESH_PB_BOOL,                   // -> bool
+    MESH_PB_FIXED32,                // -> uint32_t
+    MESH_PB_SFIXED32,               // -> int32_t
+    MESH_PB_FLOAT,                  // -> float
+    MESH_PB_BYTES,                  // bytes/string -> MeshPbSpan
+    MESH_PB_MESSAGE,                // -> embedded struct, described by sub
+};
+
+struct MeshPbSpan {
+    const uint8_t *data;            // Into the decoded buffer
+    uint16_t len;
+};
+
+struct MeshPbMsg;
+
+struct MeshPbField {
+    uint8_t tag;
+    uint8_t type;                   // MeshPbType
+    uint16_t offset;                // Into the struct
+    const MeshPbMsg *sub;           // MESH_PB_MESSAGE only
+};
+
+struct MeshPbMsg {
+    const MeshPbField *fields;
+    uint8_t count;
+};
+
+/**
+ * @brief A field the table does not map. value holds varints and fixed
+ *        types, span length-delimited ones
+ * @return false stops the decode as failed
+ */
+typedef bool (*mesh_pb_field_cb)(uint32_t tag, uint8_t wire, uint64_t value, MeshPbSpan span, void *ctx);
+
+// ===== Messages =====
+
+// Data, the payload of every packet; payload is decoded per portnum
+struct MeshData {
+    uint32_t has;
+    uint32_t portnum;
+    MeshPbSpan payload;
+    bool want_response;
+    uint32_t dest;
+    uint32_t source;
+    uint32_t request_id;
+    uint32_t reply_id;
+    uint32_t emoji;
+    uint32_t bitfield;
+};
+
+struct MeshPosition {
+    uint32_t has;
+    int32_t latitude_i;             // 1e-7 degrees
+    int32_t longitude_i;
+    int32_t altitude;               // m
+    uint32_t time;                  // UTC s
+    uint32_t location_source;
+    int32_t altitude_hae;
+    uint32_t pdop;                  // 1/100
+    uint32_t ground_speed;          // m/s
+    uint32_t ground_track;          // 1e-5 degrees
+    uint32_t sats_in_view;
+    uint32_t precision_bits;
+};
+
+struct MeshUser {
+    uint32_t has;
+    MeshPbSpan id;                  // "!%08x"
+    MeshPbSpan long_name;
+    MeshPbSpan short_name;
+    uint32_t hw_model;
+    bool is_licensed;
+    uint32_t role;
+    MeshPbSpan public_key;
+};
+
+struct MeshRouting {
+    uint32_t has;
+    uint32_t error_reason;          // 0 for an ACK
+};
+
+struct MeshDeviceMetrics {
+    uint32_t has;
+    uint32_t battery_level;         // %, 101 on external power
+    float voltage;
+    float channel_utilization;
+    float air_util_tx;
+    uint32_t uptime_seconds;
+};
+
+struct MeshTelemetry {
+    uint32_t has;
+    uint32_t time;
+    MeshDeviceMetrics device_metrics;
+};
+
+// MeshPacket of the phone API (over BLE, not on air)
+struct MeshPacket {
+    uint32_t has;
+    uint32_t from;
+    uint32_t to;
+    uint32_t channel;
+    MeshData decoded;
+    MeshPbSpan encrypted;
+    uint32_t id;
+    uint32_t rx_time;
+    float rx_snr;
+    uint32_t hop_limit;
+    bool want_ack;
+    uint32_t priority;
+    int32_t rx_rssi;
+    bool via_mqtt;
+    uint32_t hop_start;
+};
+
+extern const MeshPbMsg mesh_pb_data;
+extern const MeshPbMsg mesh_pb_position;
+extern const MeshPbMsg mesh_pb_user;
+extern const MeshPbMsg mesh_pb_routing;
+extern const MeshPbMsg mesh_pb_telemetry;
+extern const MeshPbMsg mesh_pb_packet;
+
+/**
+ * @brief Presence bit of the field with tag in msg, for filling `has`
+ */
+uint32_t mesh_pb_bit(const MeshPbMsg *msg, uint8_t tag);
+
+// ===== Codec =====
+
+/**
+ * @brief Decode buf into out (zeroed first) in place; see above for spans
+ * @return false for a malformed buffer or a callback that refused
+ */
+bool mesh_pb_decode(const MeshPbMsg *msg, const uint8_t *buf, size_t len, void *out,
+                    mesh_pb_field_cb cb = NULL, void *ctx = NULL);
+
+/**
+ * @brief Encoded size of the fields set in in's presence mask
+ */
+size_t mesh_pb_size(const MeshPbMsg *msg, const void *in);
+
+/**
+ * @brief Encode in into out
+ * @return Bytes written, 0 when it does not fit in cap
+ */
+size_t mesh_pb_encode(const MeshPbMsg *msg, const void *in, uint8_t *out, size_t cap);
+
+// ===== Mesh =====
+
+struct MeshProtoStats {
+    uint32_t decoded;
+    uint32_t malformed;             // Wrong key, other channel, or not protobuf
+    uint32_t texts;
+    uint32_t handled;               // Went to a registered handler
+    uint32_t unhandled;
+    uint32_t sent;
+    uint32_t decode_us_max;         // Decrypt and decode of one packet
+    uint32_t encode_us_max;         // Encode and encrypt of one packet
+};
+
+/**
+ * @brief A delivered packet of a registered port. data's spans point into
+ *        the decrypted buffer, valid for the call. Runs on the LoRa task
+ */
+typedef void (*mesh_proto_handler)(const LoraMeshHeader *header, const MeshData *data, void *ctx);
+
+/**
+ * @brief Register the console command and, with mesh.enabled, join the mesh
+ */
+bool mesh_proto_begin();
+
+/**
+ * @brief Receive packets of port through handler; one per port
+ */
+bool mesh_proto_set_handler(uint32_t port, mesh_proto_handler handler, void *ctx);
+
+/**
+ * @brief Send payload (a struct described by msg, or NULL for none) on port,
+ *        encoded and encrypted in the outgoing frame
+ */
+bool mesh_proto_send(uint32_t to, uint32_t port, const MeshPbMsg *msg, const void *payload);
+
+bool mesh_proto_send_text(uint32_t to, const char *text, size_t len);
+
+void mesh_proto_get_stats(MeshProtoStats *out);
+
+#endif // MESH_PROTO_H
@@ -0,0 +1,197 @@
+/**
+ * @file      metrics.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Metrics registry: snapshots, system gauges and the periodic compact export
+ */
+
+#include "metrics.h"
+#include <esp_heap_caps.h>
+#include "simple_logger.h"
+#include "timer_wheel.h"
+#include "usb_console.h"
+#include "power_governor.h"
+#include "config/os_config.h"
+#if FEATURE_MQTT_ENABLED
+#include "mqtt_client.h"
+#endif
+#ifdef INTEGRATION_LAYER_ENABLED
+#include "integration/config_manager.h"
+#endif
+
+uint32_t metrics_counter_cells[portNUM_PROCESSORS][METRIC_COUNTER_COUNT];
+int32_t metrics_gauge_cells[METRIC_GAUGE_COUNT];
+MetricsHistCell metrics_hist_cells[portNUM_PROCESSORS][METRIC_HISTOGRAM_COUNT];
+
+#define METRICS_NAME(id, name)  name,
+
+static const char *const counter_names[] = { METRICS_COUNTERS(METRICS_NAME) };
+static const char *const gauge_names[] = { METRICS_GAUGES(METRICS_NAME) };
+static const char *const histogram_names[] = { METRICS_HISTOGRAMS(METRICS_NAME) };
+
+static WheelTimer export_timer;
+static bool export_serial = true;
+static bool export_mqtt = false;
+
+const char *metrics_counter_name(MetricCounter id) {
+    return id < METRIC_COUNTER_COUNT ? counter_names[id] : "?";
+}
+
+const char *metrics_gauge_name(MetricGauge id) {
+    return id < METRIC_GAUGE_COUNT ? gauge_names[id] : "?";
+}
+
+const char *metrics_histogram_name(MetricHistogram id) {
+    return id < METRIC_HISTOGRAM_COUNT ? histogram_names[id] : "?";
+}
+
+// Gauges nobody pushes: read at snapshot time
+static void sample_system() {
+    metrics_gauge(METRIC_HEAP_FREE, heap_caps_get_free_size(MALLOC_CAP_INTERNAL));
+    metrics_gauge(METRIC_HEAP_MIN_FREE, heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL));
+    metrics_gauge(METRIC_PSRAM_FREE, heap_caps_get_free_size(MALLOC_CAP_SPIRAM));
+    if (power_governor_running()) {
+        const PowerGovernorStats *gov = power_governor_stats();
+        metrics_gauge(METRIC_CPU_MHZ, gov->mhz);
+        metrics_gauge(METRIC_CPU_LOAD0, gov->load[0]);
+        metrics_gauge(METRIC_CPU_LOAD1, gov->load[1]);
+    } else {
+        metrics_gauge(METRIC_CPU_MHZ, getCpuFrequencyMhz());
+    }
+}
+
+void metrics_snapshot(MetricsSnapshot *out) {
+    sample_system();
+    memset(out, 0, sizeof(*out));
+    out->ms = millis();
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        for (int i = 0; i < METRIC_COUNTER_COUNT; i++) {
+            out->counters[i] += __atomic_load_n(&metrics_counter_cells[core][i], __ATOMIC_RELAXED);
+        }
+        for (int i = 0; i < METRIC_HISTOGRAM_COUNT; i++) {
+            const MetricsHistCell *cell = &metrics_hist_cells[core][i];
+            MetricsHistSnapshot *h = &out->histograms[i];
+            for (int b = 0; b < METRICS_HIST_BUCKETS; b++) {
+                uint32_t n = __atomic_load_n(&cell->buckets[b], __ATOMIC_RELAXED);
+                h->buckets[b] += n;
+                h->count += n;
+            }
+            uint32_t max = __atomic_load_n(&cell->max, __ATOMIC_RELAXED);
+            h->max = max > h->max ? max : h->max;
+        }
+    }
+    for (int i = 0; i < METRIC_GAUGE_COUNT; i++) {
+        out->gauges[i] = __atomic_load_n(&metrics_gauge_cells[i], __ATOMIC_RELAXED);
+    }
+}
+
+uint32_t metrics_percentile(const MetricsHistSnapshot *hist, uint8_t pct) {
+    if (!hist->count) {
+        return 0;
+    }
+    uint32_t rank = (uint32_t)(((uint64_t)hist->count * pct + 99) / 100);
+    uint32_t seen = 0;
+    for (int b = 0; b < METRICS_HIST_BUCKETS - 1; b++) {
+        seen += hist->buckets[b];
+        if (seen >= rank) {
+            // Never above what was actually seen
+            uint32_t bound = b ? (1UL << b) - 1 : 0;
+            return bound < hist->max ? bound : hist->max;
+        }
+    }
+    return hist->max;
+}
+
+// ===== Export =====
+
+// Appends one pair, or nothing when it would not fit
+static size_t append(char *buf, size_t len, size_t pos, const char *format, ...) {
+    if (pos >= len) {
+        return pos;
+    }
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(buf + pos, len - pos, format, args);
+    va_end(args);
+    if (n < 0 || (size_t)n >= len - pos) {
+        buf[pos] = '\0';
+        return pos;
+    }
+    return pos + n;
+}
+
+size_t metrics_format(const MetricsSnapshot *snap, char *buf, size_t len) {
+    if (!len) {
+        return 0;
+    }
+    buf[0] = '\0';
+    size_t pos = append(buf, len, 0, "t=%lu", (unsigned long)snap->ms);
+    for (int i = 0; i < METRIC_COUNTER_COUNT; i++) {
+        pos = append(buf, len, pos, " %s=%lu", counter_names[i], (unsigned long)snap->counters[i]);
+    }
+    for (int i = 0; i < METRIC_GAUGE_COUNT; i++) {
+        pos = append(buf, len, pos, " %s=%ld", gauge_names[i], (long)snap->gauges[i]);
+    }
+    for (int i = 0; i < METRIC_HISTOGRAM_COUNT; i++) {
+        const MetricsHistSnapshot *h = &snap->histograms[i];
+        pos = append(buf, len, pos, " %s=%lu/%lu/%lu/%lu", histogram_names[i], (unsigned long)h->count,
+                     (unsigned long)metrics_percentile(h, 50), (unsigned long)metrics_percentile(h, 99),
+                     (unsigned long)h->max);
+    }
+    return pos;
+}
+
+void metrics_print(Print &out) {
+    MetricsSnapshot snap;
+    char line[METRICS_LINE_MAX];
+    metrics_snapshot(&snap);
+    metrics_format(&snap, line, sizeof(line));
+    out.println(line);
+}
+
+static void export_tick(WheelTimer *timer) {
+    MetricsSnapshot snap;
+    metrics_snapshot(&snap);
+
+#if FEATURE_MQTT_ENABLED
+    if (export_mqtt && mqtt_connected()) {
+        char topic[64];
+        snprintf(topic, sizeof(topic), METRICS_TOPIC, mqtt_device_id());
+        // Never waits: a busy pool skips this round
+        MqttBuffer *buf = mqtt_buffer_acquire(topic);
+        if (buf) {
+            size_t capacity;
+            uint8_t *payload = mqtt_buffer_payload(buf, &capacity);
+            mqtt_publish_buffer(buf, metrics_format(&snap, (char *)payload, capacity));
+        }
+    }
+#endif
+    // A console host takes the snapshot as it is; its tool knows the layout
+    if (export_serial && usb_console_wants(USB_CONSOLE_CH_METRICS)) {
+        usb_console_send(USB_CONSOLE_CH_METRICS, &snap, sizeof(snap));
+    } else if (export_serial) {
+        char line[METRICS_LINE_MAX];
+        metrics_format(&snap, line, sizeof(line));
+        Serial.print(F("[metrics] "));
+        Serial.println(line);
+    }
+}
+
+bool metrics_begin() {
+    uint32_t export_ms = METRICS_EXPORT_MS;
+#ifdef INTEGRATION_LAYER_ENABLED
+    export_ms = GET_CONFIG_INT("metrics", "export_ms", METRICS_EXPORT_MS);
+    export_serial = GET_CONFIG_BOOL("metrics", "serial", true);
+    export_mqtt = GET_CONFIG_BOOL("metrics", "mqtt", false);
+#endif
+    if (!export_ms || (!export_serial && !export_mqtt)) {
+        return true;
+    }
+    timer_wheel_init(&export_timer, "metrics", export_tick);
+    timer_wheel_arm(&export_timer, export_ms, export_ms);
+    LOG_INFOF("Metrics", "%d counters, %d gauges, %d histograms, export every %lu ms", METRIC_COUNTER_COUNT,
+              METRIC_GAUGE_COUNT, METRIC_HISTOGRAM_COUNT, (unsigned long)export_ms);
+    return true;
+}
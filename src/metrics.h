@@ -0,0 +1,147 @@
+/**
+ * @file      metrics.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Lock-free metrics registry: per-core counters, gauges, log-scale histograms
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <Arduino.h>
+
+/**
+ * Every metric is declared once in the lists below and gets a compile-time
+ * id, so recording one is an array index and an atomic add, with no
+ * lookup, lock or allocation. The recording functions are inline, touch
+ * only DRAM, and are safe from ISRs and IRAM code.
+ *
+ * Counters and histograms keep one cell per core and are summed when a
+ * snapshot is taken, so the two cores never contend. Histogram bucket b
+ * counts values in [2^(b-1), 2^b); the last bucket takes everything
+ * above. Units are part of the name. Gauges hold the last value set.
+ *
+ * metrics_snapshot() is what a diagnostics screen reads. metrics_begin()
+ * arms a periodic compact export to serial and, when connected, to MQTT;
+ * see metrics.export_ms and metrics.mqtt.
+ */
+
+#define METRICS_HIST_BUCKETS        16
+#define METRICS_EXPORT_MS           60000
+#define METRICS_TOPIC               "tdeckpro/%s/metrics"
+#define METRICS_LINE_MAX            768
+
+// X(id, name)
+#define METRICS_COUNTERS(X)                                 \
+    X(EVENTS_PROCESSED,     "events.processed")             \
+    X(EVENTS_DROPPED,       "events.dropped")               \
+    X(EVENTS_COALESCED,     "events.coalesced")             \
+    X(EVENTS_RATE_LIMITED,  "events.rate_limited")          \
+    X(SERVICES_STARTED,     "services.started")             \
+    X(SERVICES_FAILED,      "services.failed")              \
+    X(TASKS_OVERRUNS,       "tasks.overruns")               \
+    X(TASKS_STARVED,        "tasks.starved")                \
+    X(TASKS_STACK_LOW,      "tasks.stack_low")              \
+    X(DL_BYTES,             "dl.bytes")                     \
+    X(DL_RESUMES,           "dl.resumes")                   \
+    X(DL_FAILED,            "dl.failed")
+
+#define METRICS_GAUGES(X)                                   \
+    X(HEAP_FREE,            "heap.free")                    \
+    X(HEAP_MIN_FREE,        "heap.min_free")                \
+    X(PSRAM_FREE,           "psram.free")                   \
+    X(CPU_MHZ,              "cpu.mhz")                      \
+    X(CPU_LOAD0,            "cpu.load0")                    \
+    X(CPU_LOAD1,            "cpu.load1")                    \
+    X(TASKS_STACK_MIN,      "tasks.stack_min")              \
+    X(TASKS_PSRAM_STACK,    "tasks.psram_stack")
+
+#define METRICS_HISTOGRAMS(X)                               \
+    X(EVENT_DISPATCH_US,    "events.dispatch_us")           \
+    X(SERVICE_INIT_MS,      "services.init_ms")             \
+    X(SERVICE_SUSPEND_US,   "services.suspend_us")          \
+    X(SERVICE_RESUME_US,    "services.resume_us")           \
+    X(TASKS_LATE_MS,        "tasks.late_ms")                \
+    X(TASKS_READY_MS,       "tasks.ready_ms")               \
+    X(DL_KIB_PER_S,         "dl.kib_per_s")
+
+#define METRICS_ENUM(id, name)  METRIC_##id,
+
+enum MetricCounter { METRICS_COUNTERS(METRICS_ENUM) METRIC_COUNTER_COUNT };
+enum MetricGauge { METRICS_GAUGES(METRICS_ENUM) METRIC_GAUGE_COUNT };
+enum MetricHistogram { METRICS_HISTOGRAMS(METRICS_ENUM) METRIC_HISTOGRAM_COUNT };
+
+struct MetricsHistCell {
+    uint32_t buckets[METRICS_HIST_BUCKETS];
+    uint32_t max;
+};
+
+// The cells; record through the functions below
+extern uint32_t metrics_counter_cells[portNUM_PROCESSORS][METRIC_COUNTER_COUNT];
+extern int32_t metrics_gauge_cells[METRIC_GAUGE_COUNT];
+extern MetricsHistCell metrics_hist_cells[portNUM_PROCESSORS][METRIC_HISTOGRAM_COUNT];
+
+static inline void metrics_count(MetricCounter id, uint32_t n = 1) {
+    __atomic_fetch_add(&metrics_counter_cells[xPortGetCoreID()][id], n, __ATOMIC_RELAXED);
+}
+
+static inline void metrics_gauge(MetricGauge id, int32_t value) {
+    __atomic_store_n(&metrics_gauge_cells[id], value, __ATOMIC_RELAXED);
+}
+
+static inline uint8_t metrics_bucket(uint32_t value) {
+    uint8_t b = value ? 32 - __builtin_clz(value) : 0;
+    return b < METRICS_HIST_BUCKETS ? b : METRICS_HIST_BUCKETS - 1;
+}
+
+static inline void metrics_observe(MetricHistogram id, uint32_t value) {
+    MetricsHistCell *cell = &metrics_hist_cells[xPortGetCoreID()][id];
+    __atomic_fetch_add(&cell->buckets[metrics_bucket(value)], 1, __ATOMIC_RELAXED);
+    uint32_t seen = __atomic_load_n(&cell->max, __ATOMIC_RELAXED);
+    while (value > seen &&
+           !__atomic_compare_exchange_n(&cell->max, &seen, value, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+struct MetricsHistSnapshot {
+    uint32_t count;
+    uint32_t buckets[METRICS_HIST_BUCKETS];
+    uint32_t max;
+};
+
+struct MetricsSnapshot {
+    uint32_t ms;                    // millis() when taken
+    uint32_t counters[METRIC_COUNTER_COUNT];
+    int32_t gauges[METRIC_GAUGE_COUNT];
+    MetricsHistSnapshot histograms[METRIC_HISTOGRAM_COUNT];
+};
+
+/**
+ * @brief Arm the periodic export. Reads metrics.export_ms and metrics.mqtt
+ */
+bool metrics_begin();
+
+/**
+ * @brief Sum the per-core cells; system gauges are sampled first
+ */
+void metrics_snapshot(MetricsSnapshot *out);
+
+/**
+ * @brief Upper bound of the bucket holding the pct-th percentile, 0 when empty
+ */
+uint32_t metrics_percentile(const MetricsHistSnapshot *hist, uint8_t pct);
+
+const char *metrics_counter_name(MetricCounter id);
+const char *metrics_gauge_name(MetricGauge id);
+const char *metrics_histogram_name(MetricHistogram id);
+
+/**
+ * @brief One line of name=value pairs; histograms as name=count/p50/p99/max
+ * @return Length written, truncated at a pair boundary
+ */
+size_t metrics_format(const MetricsSnapshot *snap, char *buf, size_t len);
+void metrics_print(Print &out);
+
+#endif // METRICS_H
@@ -0,0 +1,545 @@
+/**
+ * @file      modem_at.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     AT-command engine: one reader task owns SerialAT, runs queued
+ *            commands one at a time and routes unsolicited lines
+ */
+
+#include "modem_at.h"
+#include "utilities.h"
+#include "simple_logger.h"
+#include "power_governor.h"
+#include "usb_console.h"
+
+#define URC_PREFIX_MAX      16
+#define MONITOR_TIMEOUT_MS  5000
+
+struct AtRequest {
+    uint32_t ticket;
+    uint32_t timeout_ms;
+    modem_at_cb cb;
+    modem_at_line_cb lines;         // Streamed: intermediate lines bypass the response
+    void *ctx;
+    const uint8_t *data;            // Written at the "> " prompt; the caller keeps it
+    size_t data_len;
+    char cmd[MODEM_AT_CMD_MAX];
+    char match[MODEM_AT_MATCH_MAX];
+};
+
+struct AtResult {
+    uint32_t ticket;
+    int result;
+    char response[MODEM_AT_RESPONSE_MAX];
+};
+
+struct UrcHandler {
+    char prefix[URC_PREFIX_MAX];
+    modem_urc_cb cb;
+    void *ctx;
+};
+
+static TaskHandle_t at_task_handle = NULL;
+static Stream *volatile at_port = &SerialAT;
+static QueueHandle_t at_queue = NULL;
+static volatile bool at_monitor = false;
+static volatile modem_tap_cb at_tap = NULL;
+static void *volatile at_tap_ctx = NULL;
+static volatile uint32_t at_rx_bytes = 0;
+static volatile uint32_t at_wake_idle_ms = 0;   // 0: the modem never sleeps on its own
+static volatile uint32_t at_wake_lead_ms = 0;
+static volatile uint32_t at_io_ms = 0;          // Last byte either way
+static volatile uint32_t at_asleep_ms = 0;      // Quiet past at_wake_idle_ms, summed
+static volatile uint32_t at_wakes = 0;
+
+// Tickets finish in queue order, so everything after at_done_seq is pending
+static portMUX_TYPE at_mux = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t at_ticket_seq = 0;
+static uint32_t at_done_seq = 0;
+static AtResult at_results[MODEM_AT_RESULTS];
+static uint8_t at_results_next = 0;
+static UrcHandler at_urc[MODEM_AT_URC_HANDLERS];
+static volatile size_t at_urc_count = 0;
+
+// Modem task only
+static AtRequest at_active;
+static bool at_busy = false;
+static bool at_data_pending = false;
+static int at_sleep_lock = -1;      // A UART wake would eat the start of the answer
+static uint32_t at_deadline = 0;
+static char at_echo[MODEM_AT_CMD_MAX + 2];
+static char at_resp[MODEM_AT_RESPONSE_MAX];
+static size_t at_resp_len = 0;
+static char at_line[MODEM_AT_LINE_MAX];
+static size_t at_line_len = 0;
+static char at_mon_line[MODEM_AT_CMD_MAX];
+static size_t at_mon_len = 0;
+
+static inline bool starts_with(const char *s, const char *prefix) {
+    return strncmp(s, prefix, strlen(prefix)) == 0;
+}
+
+static void respond(const char *line) {
+    size_t len = strlen(line);
+    if (at_resp_len && at_resp_len + 1 < sizeof(at_resp)) {
+        at_resp[at_resp_len++] = '\n';
+    }
+    if (at_resp_len + len >= sizeof(at_resp)) {
+        len = sizeof(at_resp) - 1 - at_resp_len;
+    }
+    memcpy(at_resp + at_resp_len, line, len);
+    at_resp_len += len;
+    at_resp[at_resp_len] = '\0';
+}
+
+static void finish(int result) {
+    portENTER_CRITICAL(&at_mux);
+    AtResult *r = &at_results[at_results_next];
+    at_results_next = (at_results_next + 1) % MODEM_AT_RESULTS;
+    r->ticket = at_active.ticket;
+    r->result = result;
+    memcpy(r->response, at_resp, at_resp_len + 1);
+    at_done_seq = at_active.ticket;
+    portEXIT_CRITICAL(&at_mux);
+    
+    at_busy = false;
+    power_governor_release(at_sleep_lock);
+    if (result == MODEM_AT_TIMEOUT) {
+        LOG_WARNF("ModemAT", "AT%s timed out", at_active.cmd);
+    }
+    if (at_active.cb) {
+        at_active.cb(at_active.ticket, result, at_resp, at_active.ctx);
+    }
+}
+
+static void tap(const char *line, bool tx) {
+    modem_tap_cb cb = at_tap;
+    if (cb) {
+        cb(line, tx, at_tap_ctx);
+    }
+}
+
+// Ends a quiet spell of the link, counting what of it the modem could sleep
+static void link_active() {
+    uint32_t now = millis();
+    uint32_t idle = at_wake_idle_ms;
+    uint32_t quiet = now - at_io_ms;
+    if (idle && quiet > idle) {
+        at_asleep_ms += quiet - idle;
+    }
+    at_io_ms = now;
+}
+
+static void start_next() {
+    if (!xQueueReceive(at_queue, &at_active, 0)) {
+        return;
+    }
+    
+    // An asleep modem (AT+CSCLK=2) wakes on the first byte and drops it
+    uint32_t idle = at_wake_idle_ms;
+    if (idle && millis() - at_io_ms > idle) {
+        at_port->write('\r');
+        at_wakes++;
+        vTaskDelay(pdMS_TO_TICKS(at_wake_lead_ms));
+    }
+    link_active();
+    
+    const char *at = strncasecmp(at_active.cmd, "AT", 2) == 0 ? "" : "AT";
+    snprintf(at_echo, sizeof(at_echo), "%s%s", at, at_active.cmd);
+    at_port->write((const uint8_t *)at_echo, strlen(at_echo));
+    at_port->write('\r');
+    tap(at_echo, true);
+    
+    at_resp_len = 0;
+    at_resp[0] = '\0';
+    at_deadline = millis() + at_active.timeout_ms;
+    at_data_pending = at_active.data != NULL;
+    at_busy = true;
+    power_governor_acquire(at_sleep_lock);
+}
+
+// "+CSQ: 20,99" answers "+CSQ", even if "+CSQ" were also registered as a URC
+static bool answers_active(const char *line) {
+    if (!at_busy || at_active.cmd[0] != '+') {
+        return false;
+    }
+    size_t n = strcspn(at_active.cmd, "=?");
+    return strncmp(line, at_active.cmd, n) == 0 && line[n] == ':';
+}
+
+static bool dispatch_urc(const char *line) {
+    size_t count = at_urc_count;
+    for (size_t i = 0; i < count; i++) {
+        if (starts_with(line, at_urc[i].prefix)) {
+            at_urc[i].cb(line, at_urc[i].ctx);
+            return true;
+        }
+    }
+    return false;
+}
+
+static void handle_line(const char *line) {
+    if (usb_console_wants(USB_CONSOLE_CH_MODEM)) {
+        usb_console_send(USB_CONSOLE_CH_MODEM, line, strlen(line));
+    } else if (at_monitor) {
+        SerialMon.println(line);
+    }
+    tap(line, false);
+    
+    if (at_busy) {
+        if (strcmp(line, at_echo) == 0) {
+            return;     // Echo, in case ATE0 did not stick
+        }
+        if (strcmp(line, "OK") == 0 && !at_active.match[0]) {
+            finish(MODEM_AT_OK);
+            return;
+        }
+        if (strcmp(line, "ERROR") == 0 || starts_with(line, "+CME ERROR") || starts_with(line, "+CMS ERROR")) {
+            respond(line);
+            finish(MODEM_AT_ERROR);
+            return;
+        }
+        if (at_active.match[0] && starts_with(line, at_active.match)) {
+            respond(line);
+            finish(MODEM_AT_OK);
+            return;
+        }
+    }
+    
+    if (!answers_active(line) && dispatch_urc(line)) {
+        return;
+    }
+    if (at_busy && at_active.lines) {
+        at_active.lines(line, at_active.ctx);
+    } else if (at_busy) {
+        respond(line);
+    }
+}
+
+static void read_port() {
+    int c;
+    if (at_port->available() > 0) {
+        link_active();
+    }
+    while ((c = at_port->read()) >= 0) {
+        at_rx_bytes++;
+        if (c == '\r') {
+            continue;
+        }
+        if (c != '\n') {
+            if (at_line_len < sizeof(at_line) - 1) {
+                at_line[at_line_len++] = c;
+            }
+            // The payload prompt is a line of its own with no end
+            if (at_data_pending && at_line_len == 1 && c == '>') {
+                at_port->write(at_active.data, at_active.data_len);
+                at_data_pending = false;
+                at_line_len = 0;
+                link_active();
+            }
+            continue;
+        }
+        at_line[at_line_len] = '\0';
+        if (at_line_len) {
+            handle_line(at_line);
+        }
+        at_line_len = 0;
+    }
+}
+
+// The USB console's modem channel: one command per frame
+static void console_rx(const uint8_t *data, size_t len, void *ctx) {
+    char cmd[MODEM_AT_CMD_MAX];
+    if (len >= sizeof(cmd)) {
+        return;
+    }
+    memcpy(cmd, data, len);
+    cmd[len] = '\0';
+    modem_at_send(cmd, MONITOR_TIMEOUT_MS);
+}
+
+// USB serial lines become queued commands, as the raw bridge allowed before.
+// Not while the console owns the port's input
+static void read_monitor() {
+    if (usb_console_running()) {
+        return;
+    }
+    int c;
+    while ((c = SerialMon.read()) >= 0) {
+        if (c != '\r' && c != '\n') {
+            if (at_mon_len < sizeof(at_mon_line) - 1) {
+                at_mon_line[at_mon_len++] = c;
+            }
+            continue;
+        }
+        at_mon_line[at_mon_len] = '\0';
+        if (at_mon_len && !modem_at_send(at_mon_line, MONITOR_TIMEOUT_MS)) {
+            SerialMon.println("[A7682E] command queue full");
+        }
+        at_mon_len = 0;
+    }
+}
+
+void modem_at_wake() {
+    if (at_task_handle) {
+        xTaskNotifyGive(at_task_handle);
+    }
+}
+
+static void at_task(void *param) {
+    while (1) {
+        TickType_t wait = portMAX_DELAY;
+        if (at_monitor) {
+            wait = pdMS_TO_TICKS(20);       // USB CDC has no receive event to wait on
+        }
+        if (at_busy) {
+            int32_t left = (int32_t)(at_deadline - millis());
+            TickType_t until = left > 0 ? pdMS_TO_TICKS(left) + 1 : 0;
+            if (until < wait) {
+                wait = until;
+            }
+        }
+        ulTaskNotifyTake(pdTRUE, wait);
+    
+        read_port();
+        if (at_monitor) {
+            read_monitor();
+        }
+        if (at_busy && (int32_t)(millis() - at_deadline) >= 0) {
+            finish(MODEM_AT_TIMEOUT);
+        }
+        // A final line can finish one command and the next goes straight out
+        while (!at_busy && uxQueueMessagesWaiting(at_queue)) {
+            start_next();
+        }
+    }
+}
+
+bool modem_at_begin() {
+    if (at_task_handle) {
+        return true;
+    }
+    if (at_sleep_lock < 0) {
+        at_sleep_lock = power_governor_sleep_lock_create("modem_at");
+    }
+    at_queue = xQueueCreate(MODEM_AT_QUEUE_DEPTH, sizeof(AtRequest));
+    if (!at_queue) {
+        LOG_ERROR("ModemAT", "Failed to create the command queue");
+        return false;
+    }
+    if (xTaskCreate(at_task, "modem_at", MODEM_AT_TASK_STACK, NULL, MODEM_AT_TASK_PRIORITY, &at_task_handle) != pdPASS) {
+        LOG_ERROR("ModemAT", "Failed to start the modem task");
+        vQueueDelete(at_queue);
+        at_queue = NULL;
+        return false;
+    }
+    SerialAT.onReceive(modem_at_wake, false);
+    usb_console_on(USB_CONSOLE_CH_MODEM, console_rx);
+    
+    // Without echo a response never has to be told apart from the command
+    modem_at_send("E0");
+    return true;
+}
+
+static uint32_t queue(const char *cmd, uint32_t timeout_ms, const char *match, modem_at_line_cb lines,
+                      modem_at_cb cb, void *ctx, const uint8_t *data = NULL, size_t data_len = 0) {
+    if (!at_queue || !cmd) {
+        return 0;
+    }
+    
+    AtRequest req;
+    strlcpy(req.cmd, cmd, sizeof(req.cmd));
+    strlcpy(req.match, match ? match : "", sizeof(req.match));
+    req.timeout_ms = timeout_ms;
+    req.cb = cb;
+    req.lines = lines;
+    req.ctx = ctx;
+    req.data = data;
+    req.data_len = data_len;
+    
+    // Ticket and queue slot together, so queue order stays ticket order
+    portENTER_CRITICAL(&at_mux);
+    if (uxQueueSpacesAvailable(at_queue) == 0) {
+        portEXIT_CRITICAL(&at_mux);
+        return 0;
+    }
+    if (++at_ticket_seq == 0) {
+        at_ticket_seq = 1;
+    }
+    req.ticket = at_ticket_seq;
+    xQueueSend(at_queue, &req, 0);
+    portEXIT_CRITICAL(&at_mux);
+    
+    xTaskNotifyGive(at_task_handle);
+    return req.ticket;
+}
+
+uint32_t modem_at_send(const char *cmd, uint32_t timeout_ms, const char *match, modem_at_cb cb, void *ctx) {
+    return queue(cmd, timeout_ms, match, NULL, cb, ctx);
+}
+
+uint32_t modem_at_send_data(const char *cmd, const uint8_t *data, size_t len, uint32_t timeout_ms, const char *match) {
+    return queue(cmd, timeout_ms, match, NULL, NULL, NULL, data, len);
+}
+
+uint32_t modem_at_stream(const char *cmd, uint32_t timeout_ms, modem_at_line_cb lines, modem_at_cb cb, void *ctx) {
+    return queue(cmd, timeout_ms, NULL, lines, cb, ctx);
+}
+
+int modem_at_result(uint32_t ticket, char *response, size_t len) {
+    int result = MODEM_AT_UNKNOWN;
+    portENTER_CRITICAL(&at_mux);
+    if (ticket && (int32_t)(ticket - at_done_seq) > 0 && (int32_t)(ticket - at_ticket_seq) <= 0) {
+        result = MODEM_AT_PENDING;
+    } else {
+        for (int i = 0; i < MODEM_AT_RESULTS; i++) {
+            if (at_results[i].ticket == ticket && ticket) {
+                result = at_results[i].result;
+                if (response && len) {
+                    strlcpy(response, at_results[i].response, len);
+                }
+                break;
+            }
+        }
+    }
+    portEXIT_CRITICAL(&at_mux);
+    return result;
+}
+
+int modem_at_wait(uint32_t ticket, char *response, size_t len) {
+    int result;
+    while ((result = modem_at_result(ticket, response, len)) == MODEM_AT_PENDING) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    return result;
+}
+
+bool modem_at_on_urc(const char *prefix, modem_urc_cb cb, void *ctx) {
+    portENTER_CRITICAL(&at_mux);
+    if (at_urc_count >= MODEM_AT_URC_HANDLERS) {
+        portEXIT_CRITICAL(&at_mux);
+        return false;
+    }
+    UrcHandler *h = &at_urc[at_urc_count];
+    strlcpy(h->prefix, prefix, sizeof(h->prefix));
+    h->cb = cb;
+    h->ctx = ctx;
+    at_urc_count++;
+    portEXIT_CRITICAL(&at_mux);
+    return true;
+}
+
+void modem_at_set_monitor(bool on) {
+    at_monitor = on;
+    modem_at_wake();
+}
+
+void modem_at_set_tap(modem_tap_cb cb, void *ctx) {
+    // Context first: the modem task reads the callback, then its context
+    at_tap = NULL;
+    at_tap_ctx = ctx;
+    at_tap = cb;
+}
+
+void modem_at_set_port(Stream *port) {
+    at_port = port ? port : &SerialAT;
+    if (!port) {
+        SerialAT.onReceive(modem_at_wake, false);
+    }
+    modem_at_wake();
+}
+
+uint32_t modem_at_rx_bytes() {
+    return at_rx_bytes;
+}
+
+void modem_at_set_sleep(uint32_t idle_ms, uint32_t lead_ms) {
+    if (!at_wake_idle_ms) {
+        at_io_ms = millis();        // Quiet before this was not sleep
+    }
+    at_wake_lead_ms = lead_ms;
+    at_wake_idle_ms = idle_ms;
+}
+
+uint32_t modem_at_asleep_ms() {
+    uint32_t idle = at_wake_idle_ms;
+    uint32_t quiet = millis() - at_io_ms;
+    return at_asleep_ms + (idle && quiet > idle ? quiet - idle : 0);
+}
+
+uint32_t modem_at_wakes() {
+    return at_wakes;
+}
+
+// end() drops the driver, so the bigger RX ring and the receive event are set up again
+static void uart_setup(uint32_t baud) {
+    SerialAT.end();
+    SerialAT.setRxBufferSize(MODEM_AT_UART_RX_BUFFER);
+    SerialAT.begin(baud, SERIAL_8N1, BOARD_A7682E_TXD, BOARD_A7682E_RXD);
+#if defined(BOARD_A7682E_RTS) && defined(BOARD_A7682E_CTS)
+    SerialAT.setPins(-1, -1, BOARD_A7682E_CTS, BOARD_A7682E_RTS);
+    SerialAT.setHwFlowCtrlMode(UART_HW_FLOWCTRL_CTS_RTS, 64);
+#endif
+    SerialAT.setRxFIFOFull(64);
+    SerialAT.setRxTimeout(2);
+    SerialAT.onReceive(modem_at_wake, false);
+}
+
+static bool probe() {
+    for (int i = 0; i < 3; i++) {
+        if (modem_at_wait(modem_at_send("", 300)) == MODEM_AT_OK) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool switch_baud(uint32_t from, uint32_t to) {
+    char cmd[24];
+    snprintf(cmd, sizeof(cmd), "+IPR=%lu", (unsigned long)to);
+    if (modem_at_wait(modem_at_send(cmd)) != MODEM_AT_OK) {
+        return false;
+    }
+    // The modem answers OK at the old rate, then switches
+    vTaskDelay(pdMS_TO_TICKS(20));
+    uart_setup(to);
+    if (probe()) {
+        return true;
+    }
+    
+    LOG_WARNF("ModemAT", "No answer at %lu baud", (unsigned long)to);
+    uart_setup(from);
+    return false;
+}
+
+uint32_t modem_at_negotiate_baud(uint32_t max_baud) {
+    static const uint32_t rates[] = {3000000, 921600, 460800, 230400, MODEM_AT_BAUD_DEFAULT};
+    uint32_t current = SerialAT.baudRate();
+    if (!at_task_handle || at_port != &SerialAT) {
+        return current;
+    }
+
+#if defined(BOARD_A7682E_RTS) && defined(BOARD_A7682E_CTS)
+    modem_at_wait(modem_at_send("+IFC=2,2"));
+#endif
+    for (size_t i = 0; i < sizeof(rates) / sizeof(rates[0]); i++) {
+        if (rates[i] > max_baud) {
+            continue;
+        }
+        if (rates[i] == current || switch_baud(current, rates[i])) {
+            current = rates[i];
+            break;
+        }
+    }
+    
+    // A failed step can leave the modem at the new rate, so check where it is
+    if (!probe()) {
+        LOG_ERRORF("ModemAT", "Modem lost after baud change, back to %lu", (unsigned long)MODEM_AT_BAUD_DEFAULT);
+        uart_setup(MODEM_AT_BAUD_DEFAULT);
+        current = MODEM_AT_BAUD_DEFAULT;
+    }
+    LOG_INFOF("ModemAT", "Link at %lu baud", (unsigned long)current);
+    return current;
+}
@@ -0,0 +1,154 @@
+/**
+ * @file      modem_at.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Asynchronous AT-command engine and URC dispatcher for the A7682E
+ */
+
+#ifndef MODEM_AT_H
+#define MODEM_AT_H
+
+#include <Arduino.h>
+#include "peripheral.h"
+
+#define MODEM_AT_QUEUE_DEPTH        8
+#define MODEM_AT_CMD_MAX            96
+#define MODEM_AT_MATCH_MAX          16
+#define MODEM_AT_RESPONSE_MAX       256   // Intermediate lines, joined with '\n'
+#define MODEM_AT_LINE_MAX           512   // A PDU line is up to 188 octets in hex
+#define MODEM_AT_RESULTS            8     // Finished commands kept for polling
+#define MODEM_AT_URC_HANDLERS       12
+#define MODEM_AT_TIMEOUT_MS         1000  // Default per-command timeout
+#define MODEM_AT_TASK_PRIORITY      A7682E_PRIORITY
+#define MODEM_AT_TASK_STACK         (1024 * 4)
+
+// UART link; the board does not route RTS/CTS, define both pins to enable them
+#define MODEM_AT_UART_RX_BUFFER     4096  // Driver ring, absorbs bursts at high baud
+#define MODEM_AT_BAUD_DEFAULT       115200
+#define MODEM_AT_BAUD_MAX           921600
+// #define BOARD_A7682E_RTS         -1
+// #define BOARD_A7682E_CTS         -1
+
+enum ModemAtResult {
+    MODEM_AT_OK = 0,
+    MODEM_AT_PENDING = 1,
+    MODEM_AT_ERROR = -1,            // ERROR, +CME ERROR or +CMS ERROR
+    MODEM_AT_TIMEOUT = -2,
+    MODEM_AT_UNKNOWN = -3,          // Ticket too old or never issued
+};
+
+/**
+ * @brief Completion callback, on the modem task. UI code should hand off
+ *        with lv_async_call() rather than touch LVGL here
+ */
+typedef void (*modem_at_cb)(uint32_t ticket, int result, const char *response, void *ctx);
+
+/**
+ * @brief One intermediate line of a streamed command, on the modem task
+ */
+typedef void (*modem_at_line_cb)(const char *line, void *ctx);
+
+/**
+ * @brief Unsolicited result code, the whole line (e.g. "+CMTI: \"SM\",3")
+ */
+typedef void (*modem_urc_cb)(const char *line, void *ctx);
+
+/**
+ * @brief Every line on the port: commands as sent (tx) and each line received
+ */
+typedef void (*modem_tap_cb)(const char *line, bool tx, void *ctx);
+
+/**
+ * @brief Take over SerialAT: one reader task owns the port from here on, so
+ *        blocking TinyGsm calls must not be mixed in. Safe to call again
+ */
+bool modem_at_begin();
+
+/**
+ * @brief Queue a command and return at once.
+ * @param cmd       Without the "AT" prefix, e.g. "+CSQ"; a leading "AT" is kept as is
+ * @param match     Final line that completes the command in place of OK (e.g. "CONNECT",
+ *                  or a URC that follows the OK), or NULL
+ * @return Ticket for modem_at_result(), 0 if the queue is full
+ */
+uint32_t modem_at_send(const char *cmd, uint32_t timeout_ms = MODEM_AT_TIMEOUT_MS,
+                       const char *match = NULL, modem_at_cb cb = NULL, void *ctx = NULL);
+
+/**
+ * @brief As modem_at_send, for commands that take a payload after a "> "
+ *        prompt (+CIPSEND). data goes out as it is once the prompt
+ *        arrives, and must stay valid until the command finishes
+ */
+uint32_t modem_at_send_data(const char *cmd, const uint8_t *data, size_t len, uint32_t timeout_ms,
+                            const char *match = NULL);
+
+/**
+ * @brief As modem_at_send, for answers longer than MODEM_AT_RESPONSE_MAX
+ *        (e.g. +CMGL): each intermediate line goes to lines instead of the
+ *        response, which keeps only an error line. ctx goes to both callbacks
+ */
+uint32_t modem_at_stream(const char *cmd, uint32_t timeout_ms, modem_at_line_cb lines,
+                         modem_at_cb cb = NULL, void *ctx = NULL);
+
+/**
+ * @brief Poll a ticket; MODEM_AT_PENDING until it finishes. Copies the response
+ */
+int modem_at_result(uint32_t ticket, char *response = NULL, size_t len = 0);
+
+/**
+ * @brief Block a non-UI task until the command finishes
+ */
+int modem_at_wait(uint32_t ticket, char *response = NULL, size_t len = 0);
+
+/**
+ * @brief Route unsolicited lines starting with prefix ("+CMTI", "RING", "+CGEV")
+ */
+bool modem_at_on_urc(const char *prefix, modem_urc_cb cb, void *ctx = NULL);
+
+/**
+ * @brief Mirror modem traffic to SerialMon and send its lines as commands
+ */
+void modem_at_set_monitor(bool on);
+
+/**
+ * @brief One listener for all traffic, e.g. an on-screen console; NULL removes it.
+ *        Called from the modem task, so it must not block
+ */
+void modem_at_set_tap(modem_tap_cb cb, void *ctx = NULL);
+
+/**
+ * @brief Run over another port, e.g. a CMUX channel; NULL goes back to SerialAT.
+ *        The port owner calls modem_at_wake() when data arrives
+ */
+void modem_at_set_port(Stream *port);
+void modem_at_wake();
+
+/**
+ * @brief Step the link up through the rates the modem accepts (AT+IPR), up to
+ *        max_baud, checking each with AT before keeping it. SerialAT only, so
+ *        before CMUX. Returns the rate in use afterwards
+ */
+uint32_t modem_at_negotiate_baud(uint32_t max_baud = MODEM_AT_BAUD_MAX);
+
+/**
+ * @brief Bytes read off the port since boot, for throughput measurements
+ */
+uint32_t modem_at_rx_bytes();
+
+/**
+ * @brief The modem sleeps once the link has been quiet for idle_ms
+ *        (AT+CSCLK=2) and loses the byte that wakes it: a command after such
+ *        a spell goes out lead_ms behind a lone CR. 0 turns it off
+ */
+void modem_at_set_sleep(uint32_t idle_ms, uint32_t lead_ms);
+
+/**
+ * @brief Time the link stayed quiet past idle_ms, summed: what the modem
+ *        was free to sleep. And the wake bytes sent
+ */
+uint32_t modem_at_asleep_ms();
+uint32_t modem_at_wakes();
+
+#endif // MODEM_AT_H
@@ -0,0 +1,279 @@
+/**
+ * @file      modem_bench.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     HTTP download benchmarks: the modem's own TCP stack, and AT sockets against PPP
+ */
+
+#include "modem_bench.h"
+#include "modem_at.h"
+#include "modem_ppp.h"
+#include "simple_logger.h"
+#include "lwip/sockets.h"
+#include "lwip/netdb.h"
+
+static bool http_get(const char *url, ModemBenchResult *r) {
+    char cmd[MODEM_AT_CMD_MAX];
+    char resp[MODEM_AT_RESPONSE_MAX];
+    
+    modem_at_wait(modem_at_send("+HTTPTERM"));      // A previous run may have left it open
+    if (modem_at_wait(modem_at_send("+HTTPINIT")) != MODEM_AT_OK) {
+        return false;
+    }
+    snprintf(cmd, sizeof(cmd), "+HTTPPARA=\"URL\",\"%s\"", url);
+    if (modem_at_wait(modem_at_send(cmd)) != MODEM_AT_OK) {
+        return false;
+    }
+    
+    // OK comes at once, the fetch is done when the +HTTPACTION URC arrives
+    uint32_t start = millis();
+    if (modem_at_wait(modem_at_send("+HTTPACTION=0", MODEM_BENCH_ACTION_MS, "+HTTPACTION:"), resp, sizeof(resp)) != MODEM_AT_OK) {
+        return false;
+    }
+    r->network_ms = millis() - start;
+    
+    int status = 0;
+    unsigned long len = 0;
+    const char *action = strstr(resp, "+HTTPACTION:");
+    if (!action || sscanf(action, "+HTTPACTION: %*d,%d,%lu", &status, &len) != 2 || status != 200) {
+        LOG_WARNF("ModemBench", "HTTP status %d", status);
+        return false;
+    }
+    r->content_len = len;
+    
+    uint32_t rx_start = modem_at_rx_bytes();
+    start = millis();
+    for (uint32_t offset = 0; offset < len; offset += MODEM_BENCH_CHUNK) {
+        snprintf(cmd, sizeof(cmd), "+HTTPREAD=%lu,%d", (unsigned long)offset, MODEM_BENCH_CHUNK);
+        if (modem_at_wait(modem_at_send(cmd, MODEM_BENCH_READ_MS, "+HTTPREAD: 0")) != MODEM_AT_OK) {
+            return false;
+        }
+    }
+    r->read_ms = millis() - start;
+    r->link_bytes = modem_at_rx_bytes() - rx_start;
+    r->bytes_per_s = r->read_ms ? (uint32_t)((uint64_t)len * 1000 / r->read_ms) : 0;
+    return true;
+}
+
+size_t modem_bench_run(const char *url, const uint32_t *bauds, size_t count, ModemBenchResult *out) {
+    if (!modem_at_begin()) {
+        return 0;
+    }
+    
+    for (size_t i = 0; i < count; i++) {
+        ModemBenchResult *r = &out[i];
+        memset(r, 0, sizeof(*r));
+        r->baud = modem_at_negotiate_baud(bauds[i]);
+        r->ok = http_get(url, r);
+        modem_at_wait(modem_at_send("+HTTPTERM"));
+    
+        if (r->ok) {
+            LOG_INFOF("ModemBench", "%lu baud: %lu bytes, fetch %lu ms, UART %lu ms, %lu B/s",
+                      (unsigned long)r->baud, (unsigned long)r->content_len, (unsigned long)r->network_ms,
+                      (unsigned long)r->read_ms, (unsigned long)r->bytes_per_s);
+        } else {
+            LOG_WARNF("ModemBench", "%lu baud: download failed", (unsigned long)r->baud);
+        }
+    }
+    return count;
+}
+
+// ===== AT sockets against PPP =====
+
+struct SockRead {
+    uint32_t bytes;
+    int rest;                       // Still buffered in the modem, -1 unknown
+};
+
+static volatile bool sock_closed = false;
+
+static void on_ipclose(const char *line, void *ctx) {
+    sock_closed = true;
+}
+
+// "+CIPRXGET: 3,<link>,<read>,<rest>" then the data as one hex line
+static void rxget_line(const char *line, void *ctx) {
+    SockRead *rd = (SockRead *)ctx;
+    int n, rest;
+    if (sscanf(line, "+CIPRXGET: 3,%*d,%d,%d", &n, &rest) == 2) {
+        rd->rest = rest;
+    } else if (line[0] != '+') {
+        rd->bytes += strlen(line) / 2;
+    }
+}
+
+static bool parse_url(const char *url, char *host, size_t host_len, uint16_t *port, const char **path) {
+    if (strncmp(url, "http://", 7) != 0) {
+        return false;
+    }
+    url += 7;
+    size_t n = strcspn(url, ":/");
+    if (!n || n >= host_len) {
+        return false;
+    }
+    memcpy(host, url, n);
+    host[n] = '\0';
+    url += n;
+    *port = 80;
+    if (*url == ':') {
+        *port = (uint16_t)strtoul(url + 1, (char **)&url, 10);
+    }
+    *path = *url == '/' ? url : "/";
+    return *port != 0;
+}
+
+static void finish(ModemSockBenchResult *r, uint32_t sent, uint32_t first, uint32_t last) {
+    if (!r->bytes) {
+        return;
+    }
+    r->first_byte_ms = first - sent;
+    r->read_ms = last - first;
+    r->bytes_per_s = r->read_ms ? (uint32_t)((uint64_t)r->bytes * 1000 / r->read_ms) : 0;
+}
+
+static bool sock_get_ppp(const struct sockaddr_in *addr, const char *req, ModemSockBenchResult *r) {
+    static uint8_t buf[1460];
+    int s = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (s < 0) {
+        return false;
+    }
+    struct ifreq ifr = {};
+    strlcpy(ifr.ifr_name, modem_ppp_ifname(), sizeof(ifr.ifr_name));
+    setsockopt(s, SOL_SOCKET, SO_BINDTODEVICE, &ifr, sizeof(ifr));
+    struct timeval tv = { MODEM_BENCH_CONNECT_MS / 1000, 0 };
+    setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(s, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+    uint32_t start = millis();
+    size_t len = strlen(req);
+    if (connect(s, (const struct sockaddr *)addr, sizeof(*addr)) != 0) {
+        close(s);
+        return false;
+    }
+    r->connect_ms = millis() - start;
+    if (send(s, req, len, 0) != (ssize_t)len) {
+        close(s);
+        return false;
+    }
+    uint32_t sent = millis();
+    uint32_t first = sent;
+    int n;
+    while ((n = recv(s, buf, sizeof(buf), 0)) > 0 && millis() - sent < MODEM_BENCH_SOCK_MS) {
+        if (!r->bytes) {
+            first = millis();
+        }
+        r->bytes += n;
+    }
+    close(s);
+    finish(r, sent, first, millis());
+    return n == 0 && r->bytes;
+}
+
+static bool sock_get_at(const char *ip, uint16_t port, const char *req, ModemSockBenchResult *r) {
+    char cmd[MODEM_AT_CMD_MAX];
+    char resp[MODEM_AT_RESPONSE_MAX];
+    static bool urc_registered = false;
+    if (!urc_registered) {
+        urc_registered = modem_at_on_urc("+IPCLOSE", on_ipclose);
+    }
+
+    // Manual receive before the network opens; ERROR from NETOPEN means it already was
+    modem_at_wait(modem_at_send("+CIPRXGET=1"));
+    modem_at_wait(modem_at_send("+NETOPEN", MODEM_BENCH_CONNECT_MS, "+NETOPEN:"));
+
+    sock_closed = false;
+    snprintf(cmd, sizeof(cmd), "+CIPOPEN=0,\"TCP\",\"%s\",%u", ip, port);
+    uint32_t start = millis();
+    if (modem_at_wait(modem_at_send(cmd, MODEM_BENCH_CONNECT_MS, "+CIPOPEN:"), resp, sizeof(resp)) != MODEM_AT_OK ||
+        !strstr(resp, "+CIPOPEN: 0,0")) {
+        return false;
+    }
+    r->connect_ms = millis() - start;
+
+    size_t len = strlen(req);
+    snprintf(cmd, sizeof(cmd), "+CIPSEND=0,%u", (unsigned)len);
+    r->commands = 1;
+    if (modem_at_wait(modem_at_send_data(cmd, (const uint8_t *)req, len, MODEM_BENCH_READ_MS, "+CIPSEND:")) != MODEM_AT_OK) {
+        return false;
+    }
+    uint32_t sent = millis();
+    uint32_t first = sent;
+    bool done = false;
+    snprintf(cmd, sizeof(cmd), "+CIPRXGET=3,0,%d", MODEM_BENCH_SOCK_CHUNK);
+    while (!done && millis() - sent < MODEM_BENCH_SOCK_MS) {
+        SockRead rd = { 0, -1 };
+        // ERROR when nothing is buffered
+        modem_at_wait(modem_at_stream(cmd, MODEM_BENCH_READ_MS, rxget_line, NULL, &rd));
+        r->commands++;
+        if (rd.bytes) {
+            if (!r->bytes) {
+                first = millis();
+            }
+            r->bytes += rd.bytes;
+            continue;
+        }
+        if (sock_closed) {
+            done = true;
+        } else {
+            vTaskDelay(pdMS_TO_TICKS(20));
+        }
+    }
+    uint32_t last = millis();
+    modem_at_wait(modem_at_send("+CIPCLOSE=0", MODEM_BENCH_READ_MS));
+    finish(r, sent, first, last);
+    return done && r->bytes;
+}
+
+bool modem_bench_sockets(const char *url, ModemSockBenchResult out[MODEM_BENCH_PATHS]) {
+    char host[64];
+    uint16_t port;
+    const char *path;
+    memset(out, 0, sizeof(ModemSockBenchResult) * MODEM_BENCH_PATHS);
+    if (!parse_url(url, host, sizeof(host), &port, &path) || !modem_at_begin()) {
+        return false;
+    }
+    char req[MODEM_AT_CMD_MAX * 2];
+    snprintf(req, sizeof(req), "GET %s HTTP/1.0\r\nHost: %s\r\nConnection: close\r\n\r\n", path, host);
+
+    ModemPppStats ppp;
+    modem_ppp_get_stats(&ppp);
+    modem_ppp_hold(MODEM_PPP_HOLD_UP);
+    bool up = modem_ppp_connect();
+
+    struct addrinfo hints = {};
+    struct addrinfo *res = NULL;
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(host, NULL, &hints, &res) != 0 || !res) {
+        modem_ppp_hold(ppp.hold);
+        LOG_WARNF("ModemBench", "Cannot resolve %s", host);
+        return false;
+    }
+    struct sockaddr_in addr = *(struct sockaddr_in *)res->ai_addr;
+    freeaddrinfo(res);
+    addr.sin_port = htons(port);
+    char ip[16];
+    inet_ntoa_r(addr.sin_addr, ip, sizeof(ip));
+
+    ModemSockBenchResult *r = &out[MODEM_BENCH_PPP];
+    r->ok = up && sock_get_ppp(&addr, req, r);
+
+    // The AT stack needs the PDP context PPP holds, and the port without the multiplexer
+    modem_ppp_hold(MODEM_PPP_HOLD_DOWN);
+    modem_ppp_disconnect();
+    r = &out[MODEM_BENCH_AT];
+    r->ok = sock_get_at(ip, port, req, r);
+    modem_at_wait(modem_at_send("+NETCLOSE", MODEM_BENCH_READ_MS, "+NETCLOSE:"));
+    modem_ppp_hold(ppp.hold);
+
+    for (int i = 0; i < MODEM_BENCH_PATHS; i++) {
+        r = &out[i];
+        LOG_INFOF("ModemBench", "%s %s: connect %lu ms, first byte %lu ms, %lu B in %lu ms, %lu B/s, %lu commands",
+                  i == MODEM_BENCH_PPP ? "PPP" : "AT", r->ok ? "ok" : "failed", (unsigned long)r->connect_ms,
+                  (unsigned long)r->first_byte_ms, (unsigned long)r->bytes, (unsigned long)r->read_ms,
+                  (unsigned long)r->bytes_per_s, (unsigned long)r->commands);
+    }
+    return true;
+}
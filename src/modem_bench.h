@@ -0,0 +1,65 @@
+/**
+ * @file      modem_bench.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Cellular download benchmarks: A7682E UART rates, AT sockets against PPP
+ */
+
+#ifndef MODEM_BENCH_H
+#define MODEM_BENCH_H
+
+#include <Arduino.h>
+
+#define MODEM_BENCH_CHUNK           2048  // Bytes per AT+HTTPREAD
+#define MODEM_BENCH_ACTION_MS       60000 // Whole download into the modem
+#define MODEM_BENCH_READ_MS         10000 // Per chunk over the UART
+#define MODEM_BENCH_SOCK_CHUNK      240   // Bytes per AT+CIPRXGET, read as hex to fit MODEM_AT_LINE_MAX
+#define MODEM_BENCH_SOCK_MS         60000 // Whole response
+#define MODEM_BENCH_CONNECT_MS      20000
+
+struct ModemBenchResult {
+    uint32_t baud;                  // Rate actually in use
+    uint32_t content_len;
+    uint32_t network_ms;            // HTTPACTION: the modem fetching over LTE
+    uint32_t read_ms;               // HTTPREAD: moving the body over the UART
+    uint32_t link_bytes;            // Bytes received during read_ms, AT framing included
+    uint32_t bytes_per_s;           // Body bytes over read_ms, the sustained link rate
+    bool ok;
+};
+
+enum ModemBenchPath {
+    MODEM_BENCH_AT = 0,             // +CIPOPEN, +CIPSEND, +CIPRXGET on the modem's TCP stack
+    MODEM_BENCH_PPP,                // lwIP sockets over the PPP netif
+    MODEM_BENCH_PATHS,
+};
+
+struct ModemSockBenchResult {
+    uint32_t connect_ms;            // TCP open, request not yet sent
+    uint32_t first_byte_ms;         // Request sent to the first response byte
+    uint32_t read_ms;               // First byte to the server closing
+    uint32_t bytes;                 // Response, headers included
+    uint32_t bytes_per_s;           // bytes over read_ms
+    uint32_t commands;              // AT commands the exchange took; 0 over PPP
+    bool ok;
+};
+
+/**
+ * @brief Download url once per rate (over SerialAT, so before CMUX) and time
+ *        the network fetch and the UART transfer separately. Blocks the caller;
+ *        leaves the link at the last rate tried
+ * @return Number of results written
+ */
+size_t modem_bench_run(const char *url, const uint32_t *bauds, size_t count, ModemBenchResult *out);
+
+/**
+ * @brief GET an http:// URL with HTTP/1.0 over each path, to the same
+ *        address. PPP goes first and resolves the name; it is held down
+ *        for the AT run, which needs the modem's own PDP context, and the
+ *        hold is given back at the end. Blocks the caller
+ * @return false when the URL, the modem or the name lookup did not work out
+ */
+bool modem_bench_sockets(const char *url, ModemSockBenchResult out[MODEM_BENCH_PATHS]);
+
+#endif // MODEM_BENCH_H
@@ -0,0 +1,533 @@
+/**
+ * @file      modem_cmux.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     27.010 basic-mode framing, channel setup and MSC flow control
+ */
+
+#include "modem_cmux.h"
+#include "modem_at.h"
+#include "utilities.h"
+#include "simple_logger.h"
+#include "power_governor.h"
+
+#define CMUX_FLAG           0xF9
+#define CMUX_EA             0x01
+#define CMUX_CR             0x02
+#define CMUX_PF             0x10
+
+// Frame types, P/F bit clear
+#define CMUX_SABM           0x2F
+#define CMUX_UA             0x63
+#define CMUX_DM             0x0F
+#define CMUX_DISC           0x43
+#define CMUX_UIH            0xEF
+
+// Control channel message types, C/R bit clear
+#define CMUX_MSG_MSC        0xE1
+#define CMUX_MSG_CLD        0xC1
+#define CMUX_MSG_NSC        0x11
+
+// V.24 signals in MSC: ready to communicate, ready to receive, data valid
+#define CMUX_V24_FC         0x02
+#define CMUX_V24_READY      (CMUX_EA | 0x04 | 0x08 | 0x80)
+
+#define CMUX_FCS_GOOD       0xCF
+#define CMUX_RX_CHUNK       128
+#define CMUX_TX_PAUSE_MS    1000  // Longest a write waits on the modem's flow control
+
+class ModemCmux {
+public:
+    static void deliver(ModemCmuxChannel *ch, const uint8_t *data, size_t len);
+    static void reset(ModemCmuxChannel *ch, uint8_t dlci, uint8_t *ring, size_t size);
+    static void set_open(ModemCmuxChannel *ch, bool open) { ch->open = open; }
+    static void set_tx_paused(ModemCmuxChannel *ch, bool paused) { ch->tx_paused = paused; }
+};
+
+enum CmuxRxState {
+    RX_FLAG, RX_ADDR, RX_CTRL, RX_LEN, RX_LEN2, RX_DATA, RX_FCS, RX_END
+};
+
+static uint8_t *cmux_rings[MODEM_CMUX_CHANNELS];
+static const size_t cmux_ring_size[MODEM_CMUX_CHANNELS] = {
+    0, MODEM_CMUX_AT_BUFFER, MODEM_CMUX_PPP_BUFFER, MODEM_CMUX_GNSS_BUFFER
+};
+
+static ModemCmuxChannel cmux_channels[MODEM_CMUX_CHANNELS];
+static ModemCmuxStats cmux_stats;
+static SemaphoreHandle_t cmux_tx_lock = NULL;
+static TaskHandle_t cmux_task_handle = NULL;
+static volatile bool cmux_running = false;
+static int cmux_sleep_lock = -1;    // PPP and GNSS stream without warning, so no light sleep while up
+static volatile bool cmux_stop_req = false;
+
+// Receive state, multiplexer task only
+static CmuxRxState rx_state = RX_FLAG;
+static uint8_t rx_header[4];
+static size_t rx_header_len = 0;
+static uint8_t rx_info[MODEM_CMUX_FRAME_MAX];
+static size_t rx_len = 0;
+static size_t rx_got = 0;
+
+static uint8_t fcs_calc(const uint8_t *p, size_t len) {
+    uint8_t fcs = 0xFF;
+    while (len--) {
+        fcs ^= *p++;
+        for (int i = 0; i < 8; i++) {
+            fcs = (fcs & 1) ? (fcs >> 1) ^ 0xE0 : fcs >> 1;
+        }
+    }
+    return fcs;
+}
+
+// Whole frame in one write, so frames from different tasks never interleave
+static bool send_frame(uint8_t dlci, uint8_t ctrl, bool command, const uint8_t *info, size_t len) {
+    uint8_t frame[MODEM_CMUX_FRAME_MAX + 6];
+    uint8_t *p = frame;
+    *p++ = CMUX_FLAG;
+    *p++ = (dlci << 2) | (command ? CMUX_CR : 0) | CMUX_EA;
+    *p++ = ctrl;
+    *p++ = (len << 1) | CMUX_EA;    // N1 of 127 never needs the second length byte
+    // UIH frames protect the header only, and the other types carry no info
+    uint8_t fcs = 0xFF - fcs_calc(frame + 1, 3);
+    if (len) {
+        memcpy(p, info, len);
+        p += len;
+    }
+    *p++ = fcs;
+    *p++ = CMUX_FLAG;
+    
+    xSemaphoreTake(cmux_tx_lock, portMAX_DELAY);
+    size_t n = SerialAT.write(frame, p - frame);
+    cmux_stats.tx_frames++;
+    xSemaphoreGive(cmux_tx_lock);
+    return n == (size_t)(p - frame);
+}
+
+static bool send_msc(uint8_t dlci, uint8_t signals) {
+    uint8_t msg[4] = {CMUX_MSG_MSC | CMUX_CR, (2 << 1) | CMUX_EA, (uint8_t)((dlci << 2) | CMUX_CR | CMUX_EA), signals};
+    return send_frame(MODEM_CMUX_CONTROL, CMUX_UIH, true, msg, sizeof(msg));
+}
+
+void ModemCmux::reset(ModemCmuxChannel *ch, uint8_t dlci, uint8_t *ring, size_t size) {
+    ch->dlci = dlci;
+    ch->ring = ring;
+    ch->size = size;
+    ch->head = 0;
+    ch->tail = 0;
+    ch->open = false;
+    ch->tx_paused = false;
+    ch->rx_paused = false;
+}
+
+void ModemCmux::deliver(ModemCmuxChannel *ch, const uint8_t *data, size_t len) {
+    if (!ch->ring) {
+        return;
+    }
+    size_t head = ch->head;
+    size_t used = (head + ch->size - ch->tail) % ch->size;
+    size_t space = ch->size - 1 - used;
+    if (len > space) {
+        cmux_stats.rx_overflow += len - space;
+        len = space;
+    }
+    for (size_t i = 0; i < len; i++) {
+        ch->ring[head] = data[i];
+        head = (head + 1) % ch->size;
+    }
+    ch->head = head;
+    
+    if (!ch->rx_paused && used + len > ch->size * 3 / 4) {
+        ch->rx_paused = send_msc(ch->dlci, CMUX_V24_READY | CMUX_V24_FC);
+    }
+    if (len && ch->notify) {
+        ch->notify();
+    }
+}
+
+int ModemCmuxChannel::available() {
+    return size ? (head + size - tail) % size : 0;
+}
+
+int ModemCmuxChannel::peek() {
+    return head == tail ? -1 : ring[tail];
+}
+
+int ModemCmuxChannel::read() {
+    uint8_t c;
+    return read(&c, 1) ? c : -1;
+}
+
+size_t ModemCmuxChannel::read(uint8_t *buf, size_t len) {
+    size_t n = 0;
+    size_t t = tail;
+    while (n < len && t != head) {
+        buf[n++] = ring[t];
+        t = (t + 1) % size;
+    }
+    tail = t;
+    
+    // Let the modem resume once the consumer has caught up
+    if (rx_paused && (size_t)available() < size / 4) {
+        rx_paused = !send_msc(dlci, CMUX_V24_READY);
+    }
+    return n;
+}
+
+size_t ModemCmuxChannel::write(uint8_t c) {
+    return write(&c, 1);
+}
+
+size_t ModemCmuxChannel::write(const uint8_t *buf, size_t len) {
+    size_t sent = 0;
+    while (open && sent < len) {
+        uint32_t start = millis();
+        while (tx_paused && millis() - start < CMUX_TX_PAUSE_MS) {
+            vTaskDelay(pdMS_TO_TICKS(5));
+        }
+        if (tx_paused) {
+            break;
+        }
+    
+        size_t n = len - sent;
+        if (n > MODEM_CMUX_FRAME_MAX) {
+            n = MODEM_CMUX_FRAME_MAX;
+        }
+        if (!send_frame(dlci, CMUX_UIH, true, buf + sent, n)) {
+            break;
+        }
+        sent += n;
+    }
+    return sent;
+}
+
+static ModemCmuxChannel *channel_of(uint8_t dlci) {
+    return dlci < MODEM_CMUX_CHANNELS ? &cmux_channels[dlci] : NULL;
+}
+
+static void handle_control(const uint8_t *info, size_t len) {
+    if (len < 2) {
+        return;
+    }
+    uint8_t type = info[0] & ~CMUX_CR;
+    bool command = info[0] & CMUX_CR;
+    size_t value_len = info[1] >> 1;
+    const uint8_t *value = info + 2;
+    if (!command || 2 + value_len > len) {
+        return;                     // Replies to our MSCs need no action
+    }
+    
+    if (type == CMUX_MSG_MSC && value_len >= 2) {
+        ModemCmuxChannel *ch = channel_of(value[0] >> 2);
+        if (ch) {
+            ModemCmux::set_tx_paused(ch, value[1] & CMUX_V24_FC);
+        }
+        uint8_t reply[4] = {CMUX_MSG_MSC, info[1], value[0], value[1]};
+        send_frame(MODEM_CMUX_CONTROL, CMUX_UIH, true, reply, sizeof(reply));
+    } else if (type == CMUX_MSG_CLD) {
+        uint8_t reply[2] = {CMUX_MSG_CLD, CMUX_EA};
+        send_frame(MODEM_CMUX_CONTROL, CMUX_UIH, true, reply, sizeof(reply));
+        for (int i = 0; i < MODEM_CMUX_CHANNELS; i++) {
+            ModemCmux::set_open(&cmux_channels[i], false);
+        }
+        LOG_WARN("ModemCMUX", "Modem closed the multiplexer");
+    } else {
+        uint8_t reply[3] = {CMUX_MSG_NSC, (1 << 1) | CMUX_EA, info[0]};
+        send_frame(MODEM_CMUX_CONTROL, CMUX_UIH, true, reply, sizeof(reply));
+    }
+}
+
+static void handle_frame() {
+    uint8_t dlci = rx_header[0] >> 2;
+    uint8_t ctrl = rx_header[1] & ~CMUX_PF;
+    ModemCmuxChannel *ch = channel_of(dlci);
+    if (!ch) {
+        return;
+    }
+    cmux_stats.rx_frames++;
+    
+    switch (ctrl) {
+    case CMUX_UA:
+        ModemCmux::set_open(ch, true);
+        break;
+    case CMUX_DM:
+        ModemCmux::set_open(ch, false);
+        break;
+    case CMUX_SABM:
+    case CMUX_DISC:
+        send_frame(dlci, CMUX_UA | CMUX_PF, false, NULL, 0);
+        ModemCmux::set_open(ch, ctrl == CMUX_SABM);
+        break;
+    case CMUX_UIH:
+        if (dlci == MODEM_CMUX_CONTROL) {
+            handle_control(rx_info, rx_len);
+        } else {
+            ModemCmux::deliver(ch, rx_info, rx_len);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+// A closing flag may also open the next frame, so a frame ends at RX_ADDR
+static void parse(uint8_t c) {
+    switch (rx_state) {
+    case RX_FLAG:
+        if (c == CMUX_FLAG) {
+            rx_state = RX_ADDR;
+        }
+        break;
+    case RX_ADDR:
+        if (c == CMUX_FLAG) {
+            break;
+        }
+        rx_header[0] = c;
+        rx_header_len = 1;
+        rx_state = (c & CMUX_EA) ? RX_CTRL : RX_FLAG;
+        break;
+    case RX_CTRL:
+        rx_header[rx_header_len++] = c;
+        rx_state = RX_LEN;
+        break;
+    case RX_LEN:
+        rx_header[rx_header_len++] = c;
+        rx_len = c >> 1;
+        rx_got = 0;
+        rx_state = (c & CMUX_EA) ? (rx_len ? RX_DATA : RX_FCS) : RX_LEN2;
+        break;
+    case RX_LEN2:
+        rx_header[rx_header_len++] = c;
+        rx_len |= (size_t)c << 7;
+        rx_state = rx_len > MODEM_CMUX_FRAME_MAX ? RX_FLAG : (rx_len ? RX_DATA : RX_FCS);
+        break;
+    case RX_DATA:
+        rx_info[rx_got++] = c;
+        if (rx_got == rx_len) {
+            rx_state = RX_FCS;
+        }
+        break;
+    case RX_FCS:
+        rx_header[rx_header_len] = c;
+        if (fcs_calc(rx_header, rx_header_len + 1) == CMUX_FCS_GOOD) {
+            rx_state = RX_END;
+        } else {
+            cmux_stats.fcs_errors++;
+            rx_state = RX_FLAG;
+        }
+        break;
+    case RX_END:
+        if (c == CMUX_FLAG) {
+            handle_frame();
+            rx_state = RX_ADDR;
+        } else {
+            rx_state = RX_FLAG;
+        }
+        break;
+    }
+}
+
+static void cmux_uart_event() {
+    if (cmux_task_handle) {
+        xTaskNotifyGive(cmux_task_handle);
+    }
+}
+
+static void cmux_task(void *param) {
+    uint8_t chunk[CMUX_RX_CHUNK];
+    while (!cmux_stop_req) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(100));
+        int n;
+        while ((n = SerialAT.available()) > 0) {
+            n = SerialAT.read(chunk, n < (int)sizeof(chunk) ? n : sizeof(chunk));
+            for (int i = 0; i < n; i++) {
+                parse(chunk[i]);
+            }
+        }
+    }
+    cmux_task_handle = NULL;
+    vTaskDelete(NULL);
+}
+
+static bool open_channel(uint8_t dlci) {
+    ModemCmuxChannel *ch = &cmux_channels[dlci];
+    for (int attempt = 0; attempt < 3 && !ch->isOpen(); attempt++) {
+        send_frame(dlci, CMUX_SABM | CMUX_PF, true, NULL, 0);
+        uint32_t start = millis();
+        while (!ch->isOpen() && millis() - start < MODEM_CMUX_OPEN_TIMEOUT_MS) {
+            vTaskDelay(pdMS_TO_TICKS(10));
+        }
+    }
+    return ch->isOpen() && (dlci == MODEM_CMUX_CONTROL || send_msc(dlci, CMUX_V24_READY));
+}
+
+// AT+CMUX port speed index, 1 = 9600 to 8 = 921600
+static int port_speed(uint32_t baud) {
+    static const uint32_t speeds[] = {9600, 19200, 38400, 57600, 115200, 230400, 460800, 921600};
+    for (size_t i = 0; i < sizeof(speeds) / sizeof(speeds[0]); i++) {
+        if (speeds[i] == baud) {
+            return i + 1;
+        }
+    }
+    return 5;
+}
+
+// Kept for the next begin(); PSRAM, these only see UART rate traffic
+static bool alloc_rings() {
+    for (int i = 1; i < MODEM_CMUX_CHANNELS; i++) {
+        if (!cmux_rings[i]) {
+            cmux_rings[i] = (uint8_t *)ps_malloc(cmux_ring_size[i]);
+            if (!cmux_rings[i]) {
+                cmux_rings[i] = (uint8_t *)malloc(cmux_ring_size[i]);
+            }
+        }
+        if (!cmux_rings[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void stop_task() {
+    cmux_stop_req = true;
+    cmux_uart_event();
+    for (int i = 0; i < 50 && cmux_task_handle; i++) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+}
+
+bool modem_cmux_begin(uint32_t baud) {
+    if (cmux_running) {
+        return true;
+    }
+    if (!modem_at_begin()) {
+        return false;
+    }
+    
+    if (baud) {
+        modem_at_negotiate_baud(baud);
+    }
+    char cmd[32];
+    snprintf(cmd, sizeof(cmd), "+CMUX=0,0,%d,%d", port_speed(SerialAT.baudRate()), MODEM_CMUX_FRAME_MAX);
+    if (modem_at_wait(modem_at_send(cmd)) != MODEM_AT_OK) {
+        LOG_ERROR("ModemCMUX", "Modem refused AT+CMUX");
+        return false;
+    }
+    
+    if (!cmux_tx_lock) {
+        cmux_tx_lock = xSemaphoreCreateMutex();
+    }
+    if (!alloc_rings()) {
+        LOG_ERROR("ModemCMUX", "No memory for channel buffers");
+        return false;
+    }
+    for (uint8_t dlci = 0; dlci < MODEM_CMUX_CHANNELS; dlci++) {
+        ModemCmux::reset(&cmux_channels[dlci], dlci, cmux_rings[dlci], cmux_ring_size[dlci]);
+    }
+    rx_state = RX_FLAG;
+    cmux_stop_req = false;
+    
+    if (xTaskCreate(cmux_task, "modem_cmux", MODEM_CMUX_TASK_STACK, NULL, MODEM_CMUX_TASK_PRIORITY, &cmux_task_handle) != pdPASS) {
+        LOG_ERROR("ModemCMUX", "Failed to start the multiplexer task");
+        return false;
+    }
+    // Wake on the FIFO threshold or a short idle gap, not once per byte
+    SerialAT.setRxFIFOFull(64);
+    SerialAT.setRxTimeout(2);
+    SerialAT.onReceive(cmux_uart_event, false);
+    
+    for (uint8_t dlci = 0; dlci < MODEM_CMUX_CHANNELS; dlci++) {
+        if (!open_channel(dlci) && dlci <= MODEM_CMUX_AT) {
+            LOG_ERRORF("ModemCMUX", "DLCI %u did not open", dlci);
+            stop_task();
+            modem_at_set_port(NULL);
+            return false;
+        }
+    }
+    
+    cmux_channels[MODEM_CMUX_AT].onReceive(modem_at_wake);
+    modem_at_set_port(&cmux_channels[MODEM_CMUX_AT]);
+    if (cmux_sleep_lock < 0) {
+        cmux_sleep_lock = power_governor_sleep_lock_create("modem_cmux");
+    }
+    power_governor_acquire(cmux_sleep_lock);
+    cmux_running = true;
+    LOG_INFOF("ModemCMUX", "Multiplexer up, PPP %s, GNSS %s",
+              cmux_channels[MODEM_CMUX_PPP].isOpen() ? "open" : "closed",
+              cmux_channels[MODEM_CMUX_GNSS].isOpen() ? "open" : "closed");
+    return true;
+}
+
+void modem_cmux_end() {
+    if (!cmux_running) {
+        return;
+    }
+    cmux_running = false;
+    
+    uint8_t cld[2] = {CMUX_MSG_CLD | CMUX_CR, CMUX_EA};
+    send_frame(MODEM_CMUX_CONTROL, CMUX_UIH, true, cld, sizeof(cld));
+    vTaskDelay(pdMS_TO_TICKS(100));
+    stop_task();
+    for (int i = 0; i < MODEM_CMUX_CHANNELS; i++) {
+        ModemCmux::set_open(&cmux_channels[i], false);
+    }
+    modem_at_set_port(NULL);
+    power_governor_release(cmux_sleep_lock);
+}
+
+bool modem_cmux_active() {
+    return cmux_running;
+}
+
+ModemCmuxChannel *modem_cmux_channel(uint8_t dlci) {
+    return cmux_running ? channel_of(dlci) : NULL;
+}
+
+bool modem_cmux_dial(const char *apn, uint32_t timeout_ms) {
+    ModemCmuxChannel *ch = modem_cmux_channel(MODEM_CMUX_PPP);
+    if (!ch || !ch->isOpen()) {
+        return false;
+    }
+    
+    char cmd[MODEM_AT_CMD_MAX];
+    snprintf(cmd, sizeof(cmd), "+CGDCONT=1,\"IP\",\"%s\"", apn);
+    if (modem_at_wait(modem_at_send(cmd, 5000)) != MODEM_AT_OK) {
+        return false;
+    }
+    
+    while (ch->read() >= 0) {
+    }
+    ch->print("ATD*99#\r");
+    
+    char line[32];
+    size_t n = 0;
+    uint32_t start = millis();
+    while (millis() - start < timeout_ms) {
+        int c = ch->read();
+        if (c < 0) {
+            vTaskDelay(pdMS_TO_TICKS(10));
+            continue;
+        }
+        if (c != '\r' && c != '\n') {
+            if (n < sizeof(line) - 1) {
+                line[n++] = c;
+            }
+            continue;
+        }
+        line[n] = '\0';
+        n = 0;
+        if (strncmp(line, "CONNECT", 7) == 0) {
+            return true;
+        }
+        if (strcmp(line, "NO CARRIER") == 0 || strcmp(line, "ERROR") == 0 || strcmp(line, "BUSY") == 0) {
+            return false;
+        }
+    }
+    return false;
+}
+
+const ModemCmuxStats *modem_cmux_stats() {
+    return &cmux_stats;
+}
@@ -0,0 +1,101 @@
+/**
+ * @file      modem_cmux.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     3GPP 27.010 basic-mode multiplexer over the A7682E UART
+ */
+
+#ifndef MODEM_CMUX_H
+#define MODEM_CMUX_H
+
+#include <Arduino.h>
+#include "peripheral.h"
+
+// Virtual channels (DLCI); 0 is the multiplexer's own control channel
+#define MODEM_CMUX_CONTROL          0
+#define MODEM_CMUX_AT               1
+#define MODEM_CMUX_PPP              2
+#define MODEM_CMUX_GNSS             3
+#define MODEM_CMUX_CHANNELS         4
+
+// Link
+#define MODEM_CMUX_FRAME_MAX        127   // N1, info bytes per frame, as set by AT+CMUX
+#define MODEM_CMUX_OPEN_TIMEOUT_MS  1000  // Per SABM/UA exchange
+#define MODEM_CMUX_TASK_PRIORITY    A7682E_PRIORITY
+#define MODEM_CMUX_TASK_STACK       (1024 * 3)
+
+// Per-channel receive rings in PSRAM; the modem is told to pause a channel above 3/4 full
+#define MODEM_CMUX_AT_BUFFER        2048
+#define MODEM_CMUX_PPP_BUFFER       (1024 * 32)
+#define MODEM_CMUX_GNSS_BUFFER      2048
+
+struct ModemCmuxStats {
+    uint32_t rx_frames;
+    uint32_t tx_frames;
+    uint32_t fcs_errors;
+    uint32_t rx_overflow;           // Bytes dropped on a full channel ring
+};
+
+/**
+ * One virtual serial port. read() side is meant for a single consumer task;
+ * write() may be called from any task, frames never interleave on the wire
+ */
+class ModemCmuxChannel : public Stream {
+public:
+    int available() override;
+    int read() override;
+    int peek() override;
+    size_t read(uint8_t *buf, size_t len);
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t *buf, size_t len) override;
+    void flush() override {}
+
+    bool isOpen() const { return open; }
+
+    /**
+     * @brief Called from the multiplexer task after data lands in the ring
+     */
+    void onReceive(void (*cb)()) { notify = cb; }
+
+private:
+    friend class ModemCmux;
+    uint8_t dlci = 0;
+    uint8_t *ring = nullptr;
+    size_t size = 0;
+    volatile size_t head = 0;       // Written by the multiplexer task
+    volatile size_t tail = 0;       // Written by the reader
+    volatile bool open = false;
+    volatile bool tx_paused = false;    // Modem flow control, MSC FC bit
+    volatile bool rx_paused = false;    // Our flow control towards the modem
+    void (*notify)() = nullptr;
+};
+
+/**
+ * @brief Switch the modem into CMUX mode and open the AT, PPP and GNSS
+ *        channels. The modem_at engine moves onto the AT channel
+ * @param baud  Highest line rate to negotiate first, 0 to keep the current one
+ */
+bool modem_cmux_begin(uint32_t baud = 0);
+
+/**
+ * @brief Close down the multiplexer; the modem_at engine goes back to SerialAT
+ */
+void modem_cmux_end();
+bool modem_cmux_active();
+
+/**
+ * @brief Channel by DLCI, NULL when the multiplexer is not running
+ */
+ModemCmuxChannel *modem_cmux_channel(uint8_t dlci);
+
+/**
+ * @brief Set the PDP context and dial on the PPP channel. From CONNECT on the
+ *        channel carries PPP frames for the network stack
+ */
+bool modem_cmux_dial(const char *apn, uint32_t timeout_ms = 30000);
+
+const ModemCmuxStats *modem_cmux_stats();
+
+#endif // MODEM_CMUX_H
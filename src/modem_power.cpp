@@ -0,0 +1,339 @@
+/**
+ * @file      modem_power.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     A7682E PSM, eDRX and UART sleep: 3GPP timer encoding, residency, launch downlinks
+ */
+
+#include "modem_power.h"
+#include "modem_at.h"
+#include "mqtt_client.h"
+#include "plugin_runtime.h"
+#include "timer_wheel.h"
+#include "job_pool.h"
+#include "usb_console.h"
+#include "simple_logger.h"
+#ifdef INTEGRATION_LAYER_ENABLED
+#include "integration/config_manager.h"
+#include "integration/event_bridge.h"
+#endif
+
+// A GPRS timer unit: its code in bits 8-6 and its length
+struct TimerUnit {
+    uint8_t code;
+    uint32_t s;
+};
+
+// 3GPP TS 24.008: GPRS timer 3 (T3412 extended) and GPRS timer 2 (T3324), shortest unit first
+static const TimerUnit tau_units[] = {
+    { 3, 2 }, { 4, 30 }, { 5, 60 }, { 0, 600 }, { 1, 3600 }, { 2, 36000 }, { 6, 1152000 },
+};
+static const TimerUnit active_units[] = {
+    { 0, 2 }, { 1, 60 }, { 2, 360 },
+};
+
+// E-UTRAN eDRX cycles by their 4-bit value, in 10 ms
+static const uint32_t edrx_cycles[16] = {
+    512, 1024, 2048, 4096, 6144, 8192, 10240, 12288,
+    14336, 16384, 32768, 65536, 131072, 262144, 524288, 1048576,
+};
+
+static ModemPowerMode pwr_mode = MODEM_PWR_EDRX;
+static uint32_t pwr_edrx_s = MODEM_PWR_EDRX_S;
+static uint32_t pwr_tau_s = MODEM_PWR_TAU_S;
+static uint32_t pwr_active_s = MODEM_PWR_ACTIVE_S;
+static bool pwr_launch = true;
+static bool pwr_launch_subscribed = false;
+static char pwr_launch_topic[MQTT_TOPIC_MAX];
+
+static portMUX_TYPE pwr_mux = portMUX_INITIALIZER_UNLOCKED;
+static bool pwr_busy = false;
+static Job pwr_jobs[2];             // The one finishing may still be marked running
+static WheelTimer pwr_timer;
+static bool pwr_running = false;
+static uint32_t pwr_since_ms = 0;
+static uint32_t pwr_psm_enter_ms = 0;   // 0 while out of PSM
+static ModemPowerStats pwr_stats;
+
+// ===== Encoding =====
+
+static void bits_string(uint8_t value, int bits, char *out) {
+    for (int i = 0; i < bits; i++) {
+        out[i] = value & (1 << (bits - 1 - i)) ? '1' : '0';
+    }
+    out[bits] = '\0';
+}
+
+// The shortest unit that reaches s in 5 bits, rounding up
+static void encode_timer(const TimerUnit *units, size_t count, uint32_t s, char *out) {
+    uint8_t code = units[count - 1].code;
+    uint32_t value = 31;
+    for (size_t i = 0; i < count; i++) {
+        uint32_t v = (s + units[i].s - 1) / units[i].s;
+        if (v <= 31) {
+            code = units[i].code;
+            value = v;
+            break;
+        }
+    }
+    bits_string((code << 5) | value, 8, out);
+}
+
+// The longest cycle not over s
+static void encode_edrx(uint32_t s, char *out) {
+    uint8_t value = 0;
+    for (uint8_t i = 0; i < 16; i++) {
+        if (edrx_cycles[i] <= s * 100) {
+            value = i;
+        }
+    }
+    bits_string(value, 4, out);
+}
+
+// ===== Modem =====
+
+static bool send(const char *cmd) {
+    return modem_at_wait(modem_at_send(cmd, MODEM_PWR_TIMEOUT_MS)) == MODEM_AT_OK;
+}
+
+// "+CEDRXRDP: 4,"0101","0101","0001"": asked, granted, paging time window
+static void read_granted() {
+    char resp[MODEM_AT_RESPONSE_MAX];
+    char asked[5], granted[5] = "", ptw[5] = "";
+    int act;
+    if (modem_at_wait(modem_at_send("+CEDRXRDP", MODEM_PWR_TIMEOUT_MS), resp, sizeof(resp)) != MODEM_AT_OK) {
+        return;
+    }
+    const char *line = strstr(resp, "+CEDRXRDP:");
+    if (line && sscanf(line + 10, " %d,\"%4[01]\",\"%4[01]\",\"%4[01]\"", &act, asked, granted, ptw) < 3) {
+        granted[0] = ptw[0] = '\0';
+    }
+    portENTER_CRITICAL(&pwr_mux);
+    memcpy(pwr_stats.edrx_granted, granted, sizeof(granted));
+    memcpy(pwr_stats.ptw_granted, ptw, sizeof(ptw));
+    portEXIT_CRITICAL(&pwr_mux);
+}
+
+static void apply_job(Job *job) {
+    char cmd[48];
+    char edrx[5] = "", tau[9] = "", active[9] = "";
+    bool ok = true;
+    ModemPowerMode mode = pwr_mode;
+
+    if (mode == MODEM_PWR_EDRX) {
+        encode_edrx(pwr_edrx_s, edrx);
+        ok &= send("+CPSMS=0");
+        snprintf(cmd, sizeof(cmd), "+CEDRXS=1,%d,\"%s\"", MODEM_PWR_ACT_EUTRAN, edrx);
+        ok &= send(cmd);
+    } else if (mode == MODEM_PWR_PSM) {
+        encode_timer(tau_units, sizeof(tau_units) / sizeof(tau_units[0]), pwr_tau_s, tau);
+        encode_timer(active_units, sizeof(active_units) / sizeof(active_units[0]), pwr_active_s, active);
+        ok &= send("+CEDRXS=0");
+        snprintf(cmd, sizeof(cmd), "+CPSMS=1,,,\"%s\",\"%s\"", tau, active);
+        ok &= send(cmd);
+    } else {
+        ok &= send("+CEDRXS=0");
+        ok &= send("+CPSMS=0");
+    }
+    // Not every firmware reports PSM; its residency then stays 0
+    send("+CPSMSTATUS=1");
+    if (send("+CSCLK=2")) {
+        modem_at_set_sleep(MODEM_PWR_IDLE_MS, MODEM_PWR_WAKE_LEAD_MS);
+    } else {
+        ok = false;
+    }
+    read_granted();
+
+    portENTER_CRITICAL(&pwr_mux);
+    pwr_stats.mode = mode;
+    pwr_stats.applied = ok;
+    memcpy(pwr_stats.edrx_asked, edrx, sizeof(edrx));
+    memcpy(pwr_stats.tau_asked, tau, sizeof(tau));
+    memcpy(pwr_stats.active_asked, active, sizeof(active));
+    pwr_busy = false;
+    portEXIT_CRITICAL(&pwr_mux);
+    if (ok) {
+        timer_wheel_cancel(&pwr_timer);
+        LOG_INFOF("ModemPwr", "%s applied, eDRX granted \"%s\"",
+                  mode == MODEM_PWR_EDRX ? "eDRX" : mode == MODEM_PWR_PSM ? "PSM" : "Sleep", pwr_stats.edrx_granted);
+    } else {
+        LOG_WARN("ModemPwr", "Modem refused part of the setup, trying again");
+    }
+}
+
+// ===== Launch =====
+
+#ifdef INTEGRATION_LAYER_ENABLED
+static void on_mqtt(const Event &event, void *context) {
+    const MqttMessageEvent *msg = event.getPayload<MqttMessageEvent>();
+    if (!msg || strcmp(msg->topic, pwr_launch_topic) != 0 || !msg->len || msg->len > sizeof(msg->data)) {
+        return;
+    }
+    char name[APP_NAME_MAX_LENGTH];
+    size_t len = min((size_t)msg->len, sizeof(name) - 1);
+    memcpy(name, msg->data, len);
+    name[len] = '\0';
+    if (plugin_launch(name)) {
+        pwr_stats.launches++;
+        LOG_INFOF("ModemPwr", "Launched %s on request", name);
+    } else {
+        LOG_WARNF("ModemPwr", "Cannot launch %s", name);
+    }
+}
+#endif
+
+// The device id exists once the MQTT client has started
+static void subscribe_launch() {
+#ifdef INTEGRATION_LAYER_ENABLED
+    if (!pwr_launch || pwr_launch_subscribed || !mqtt_device_id()[0] || !GlobalEventBridge) {
+        return;
+    }
+    snprintf(pwr_launch_topic, sizeof(pwr_launch_topic), MQTT_TOPIC_LAUNCH, mqtt_device_id());
+    // QoS 1, so the broker holds it while the modem is out of reach
+    if (mqtt_subscribe(pwr_launch_topic, 1) &&
+        GlobalEventBridge->subscribe("ModemPwr", EventType::MQTT_MESSAGE_RECEIVED, on_mqtt)) {
+        pwr_launch_subscribed = true;
+    }
+#endif
+}
+
+// ===== Triggers =====
+
+static void apply() {
+    portENTER_CRITICAL(&pwr_mux);
+    if (pwr_busy) {
+        portEXIT_CRITICAL(&pwr_mux);
+        return;
+    }
+    pwr_busy = true;
+    portEXIT_CRITICAL(&pwr_mux);
+
+    Job *job = &pwr_jobs[0];
+    if (job->state == JOB_QUEUED || job->state == JOB_RUNNING) {
+        job = &pwr_jobs[1];
+    }
+    if (!job_submit(job, apply_job, NULL, JOB_PRIO_LOW)) {
+        portENTER_CRITICAL(&pwr_mux);
+        pwr_busy = false;
+        portEXIT_CRITICAL(&pwr_mux);
+    }
+}
+
+static void check_timer(WheelTimer *timer) {
+    subscribe_launch();
+    if (!pwr_stats.applied && peri_init_ready(E_PERI_A7682E) && modem_at_begin()) {
+        apply();
+    }
+}
+
+// The modem started again (power cut, reset): it is awake and has forgotten the setup
+static void on_restart(const char *line, void *ctx) {
+    modem_at_set_sleep(0, 0);
+    pwr_stats.applied = false;
+    timer_wheel_arm(&pwr_timer, MODEM_PWR_CHECK_MS, MODEM_PWR_CHECK_MS);
+}
+
+static void on_psm_status(const char *line, void *ctx) {
+    uint32_t now = millis();
+    portENTER_CRITICAL(&pwr_mux);
+    if (strstr(line, "ENTER")) {
+        if (!pwr_psm_enter_ms) {
+            pwr_psm_enter_ms = now ? now : 1;
+            pwr_stats.psm_entries++;
+        }
+    } else if (strstr(line, "EXIT") && pwr_psm_enter_ms) {
+        pwr_stats.psm_ms += now - pwr_psm_enter_ms;
+        pwr_psm_enter_ms = 0;
+    }
+    portEXIT_CRITICAL(&pwr_mux);
+}
+
+static const char *mode_name(uint8_t mode) {
+    return mode == MODEM_PWR_EDRX ? "edrx" : mode == MODEM_PWR_PSM ? "psm" : "on";
+}
+
+static void rpc_modempower(Print &out, const char *args) {
+    if (args[0]) {
+        ModemPowerMode mode = !strcmp(args, "edrx") ? MODEM_PWR_EDRX : !strcmp(args, "psm") ? MODEM_PWR_PSM : MODEM_PWR_ON;
+        if (strcmp(args, mode_name(mode)) != 0) {
+            out.println("modes: edrx, psm, on");
+            return;
+        }
+        out.println(modem_power_set_mode(mode) ? "applying" : "not running");
+        return;
+    }
+    ModemPowerStats s;
+    modem_power_get_stats(&s);
+    out.printf("mode %s%s, eDRX asked \"%s\" granted \"%s\" ptw \"%s\", PSM tau \"%s\" active \"%s\"\n",
+               mode_name(s.mode), s.applied ? "" : " (not applied)", s.edrx_asked, s.edrx_granted, s.ptw_granted,
+               s.tau_asked, s.active_asked);
+    uint32_t since = s.since_ms ? s.since_ms : 1;
+    out.printf("over %lu s: UART asleep %lu s (%lu%%), PSM %lu s (%lu%%, %lu entries), %lu wakes, %lu launches\n",
+               (unsigned long)(s.since_ms / 1000), (unsigned long)(s.asleep_ms / 1000),
+               (unsigned long)((uint64_t)s.asleep_ms * 100 / since), (unsigned long)(s.psm_ms / 1000),
+               (unsigned long)((uint64_t)s.psm_ms * 100 / since), (unsigned long)s.psm_entries,
+               (unsigned long)s.wakes, (unsigned long)s.launches);
+}
+
+// ===== API =====
+
+bool modem_power_begin() {
+#ifdef INTEGRATION_LAYER_ENABLED
+    String mode = GET_CONFIG_STRING("modem_power", "mode", String("edrx"));
+    pwr_mode = mode == "psm" ? MODEM_PWR_PSM : mode == "on" ? MODEM_PWR_ON : MODEM_PWR_EDRX;
+    pwr_edrx_s = GET_CONFIG_INT("modem_power", "edrx_s", MODEM_PWR_EDRX_S);
+    pwr_tau_s = GET_CONFIG_INT("modem_power", "tau_s", MODEM_PWR_TAU_S);
+    pwr_active_s = GET_CONFIG_INT("modem_power", "active_s", MODEM_PWR_ACTIVE_S);
+    pwr_launch = GET_CONFIG_BOOL("modem_power", "launch", true);
+#endif
+    pwr_stats.mode = pwr_mode;
+    pwr_since_ms = millis();
+    pwr_running = true;
+    // The last URC of a modem start
+    modem_at_on_urc("PB DONE", on_restart);
+    modem_at_on_urc("+CPSMSTATUS", on_psm_status);
+    usb_console_rpc("modempower", rpc_modempower);
+    timer_wheel_init(&pwr_timer, "modem_pwr", check_timer);
+    timer_wheel_arm(&pwr_timer, MODEM_PWR_CHECK_MS, MODEM_PWR_CHECK_MS);
+    return true;
+}
+
+bool modem_power_set_mode(ModemPowerMode mode) {
+    if (!pwr_running) {
+        return false;
+    }
+    pwr_mode = mode;
+    pwr_stats.applied = false;
+    timer_wheel_arm(&pwr_timer, 1, MODEM_PWR_CHECK_MS);
+    return true;
+}
+
+bool modem_power_set_edrx(uint32_t edrx_s) {
+    if (!pwr_running) {
+        return false;
+    }
+    char was[5], now[5];
+    encode_edrx(pwr_edrx_s, was);
+    encode_edrx(edrx_s, now);
+    pwr_edrx_s = edrx_s;
+    if (pwr_mode == MODEM_PWR_EDRX && strcmp(was, now) != 0) {
+        pwr_stats.applied = false;
+        timer_wheel_arm(&pwr_timer, 1, MODEM_PWR_CHECK_MS);
+    }
+    return true;
+}
+
+void modem_power_get_stats(ModemPowerStats *out) {
+    uint32_t now = millis();
+    portENTER_CRITICAL(&pwr_mux);
+    *out = pwr_stats;
+    if (pwr_psm_enter_ms) {
+        out->psm_ms += now - pwr_psm_enter_ms;
+    }
+    portEXIT_CRITICAL(&pwr_mux);
+    out->asleep_ms = modem_at_asleep_ms();
+    out->wakes = modem_at_wakes();
+    out->since_ms = now - pwr_since_ms;
+}
@@ -0,0 +1,92 @@
+/**
+ * @file      modem_power.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     A7682E power saving with the modem kept attached: 3GPP PSM and eDRX, UART sleep
+ */
+
+#ifndef MODEM_POWER_H
+#define MODEM_POWER_H
+
+#include <Arduino.h>
+
+/**
+ * The modem stays registered and the network decides when it listens:
+ *
+ *  - eDRX: the modem listens for paging once per cycle (AT+CEDRXS), so a
+ *    downlink arrives within one cycle and a TCP session, MQTT included,
+ *    survives with a keepalive longer than the cycle.
+ *  - PSM: after each contact the modem listens for the active time
+ *    (T3324) and is then unreachable until the periodic TAU (T3412) or
+ *    uplink data (AT+CPSMS). Cheapest, but downlinks wait for the broker
+ *    to hold them: the launch topic is subscribed with QoS 1.
+ *  - on: neither; the modem still sleeps between commands.
+ *
+ * In every mode the modem sleeps on its own once its UART is quiet
+ * (AT+CSCLK=2) and modem_at wakes it before a command. Whatever it has
+ * to say, a URC or downlink data, it sends on its own and pulls RI low,
+ * which, like UART activity, wakes the host from light sleep (see
+ * power_governor). A message on MQTT_TOPIC_LAUNCH names a plugin to start.
+ *
+ * Residency is what the modem itself reports for PSM (AT+CPSMSTATUS
+ * URCs) and, for the UART sleep, the time the link stayed quiet past
+ * MODEM_PWR_IDLE_MS. The timers the network granted are read back with
+ * AT+CEDRXRDP; it may grant less than was asked for, or nothing.
+ *
+ * Config section "modem_power": mode ("edrx", "psm" or "on"), edrx_s,
+ * tau_s, active_s, launch (true).
+ */
+
+#define MODEM_PWR_EDRX_S            82      // Rounded down to a 3GPP step, here 81.92 s
+#define MODEM_PWR_TAU_S             (4 * 3600)  // Periodic TAU in PSM, T3412 extended
+#define MODEM_PWR_ACTIVE_S          60      // Reachable after each contact in PSM, T3324
+#define MODEM_PWR_IDLE_MS           5000    // Quiet UART before the modem counts as asleep
+#define MODEM_PWR_WAKE_LEAD_MS      50      // From the wake byte to the command
+#define MODEM_PWR_CHECK_MS          10000   // Until the modem is up and configured
+#define MODEM_PWR_ACT_EUTRAN        4       // +CEDRXS access technology
+#define MODEM_PWR_TIMEOUT_MS        5000
+
+enum ModemPowerMode {
+    MODEM_PWR_ON = 0,
+    MODEM_PWR_EDRX,
+    MODEM_PWR_PSM,
+};
+
+struct ModemPowerStats {
+    uint8_t mode;                   // ModemPowerMode
+    bool applied;                   // Since the modem last started
+    char edrx_asked[5];             // Bit strings as in AT+CEDRXS, "" when unused
+    char edrx_granted[5];
+    char ptw_granted[5];
+    char tau_asked[9];              // As in AT+CPSMS
+    char active_asked[9];
+    uint32_t asleep_ms;             // UART quiet past MODEM_PWR_IDLE_MS
+    uint32_t psm_ms;                // Between the modem's ENTER PSM and EXIT PSM
+    uint32_t psm_entries;
+    uint32_t wakes;                 // Wake bytes sent ahead of commands
+    uint32_t since_ms;              // Residency is over this
+    uint32_t launches;              // Plugins started from MQTT_TOPIC_LAUNCH
+};
+
+/**
+ * @brief Read the config and configure the modem once it is up, again
+ *        whenever it restarts
+ */
+bool modem_power_begin();
+
+/**
+ * @brief Switch mode at run time; the config keeps the boot mode
+ */
+bool modem_power_set_mode(ModemPowerMode mode);
+
+/**
+ * @brief Ask for another eDRX cycle, rounded down; applied in eDRX mode
+ *        only when the step changes
+ */
+bool modem_power_set_edrx(uint32_t edrx_s);
+
+void modem_power_get_stats(ModemPowerStats *out);
+
+#endif // MODEM_POWER_H
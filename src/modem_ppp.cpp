@@ -0,0 +1,471 @@
+/**
+ * @file      modem_ppp.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     A7682E data as an lwIP PPP netif over the CMUX data channel
+ */
+
+#include "modem_ppp.h"
+#include "modem_cmux.h"
+#include "modem_at.h"
+#include "modem_bench.h"
+#include "net_manager.h"
+#include "timer_wheel.h"
+#include "job_pool.h"
+#include "usb_console.h"
+#include "simple_logger.h"
+#include <esp_netif.h>
+#include <esp_netif_ppp.h>
+#include <esp_event.h>
+#include "lwip/ip4_addr.h"
+#ifdef INTEGRATION_LAYER_ENABLED
+#include "integration/config_manager.h"
+#endif
+
+static bool ppp_enabled = true;
+static String ppp_apn = MODEM_PPP_APN;
+static String ppp_user;
+static String ppp_pass;
+static uint32_t ppp_baud = MODEM_PPP_BAUD;
+
+static esp_netif_t *ppp_netif = NULL;
+static esp_netif_driver_base_t ppp_driver;
+static char ppp_ifname[8] = "";
+static TaskHandle_t ppp_rx_task = NULL;
+static SemaphoreHandle_t ppp_lock = NULL;       // Bring-up and teardown
+static ModemCmuxChannel *volatile ppp_ch = NULL;    // Set from CONNECT to the hang-up
+static volatile bool ppp_stopping = false;      // Our own hang-up, not a drop
+static volatile bool ppp_closed = false;        // LCP is down
+static volatile bool ppp_failed = false;        // The link fell; the next check hangs up
+static volatile int ppp_hold = MODEM_PPP_AUTO;
+static esp_netif_dns_info_t ppp_dns;            // From IPCP, kept while WiFi owns the servers
+static esp_netif_dns_info_t ppp_other_dns;      // What PPP replaced as default
+
+static portMUX_TYPE ppp_mux = portMUX_INITIALIZER_UNLOCKED;
+static bool ppp_busy = false;
+static Job ppp_jobs[2];             // The one finishing may still be marked running
+static WheelTimer ppp_timer;
+static bool ppp_running = false;
+static uint32_t ppp_cell_ms = 0;    // Last seen on the cell route
+static uint32_t ppp_retry_ms = 0;   // Current backoff, 0 after a good dial
+static uint32_t ppp_next_dial = 0;
+static ModemPppStats ppp_stats;
+
+// ===== Driver =====
+
+static esp_err_t ppp_transmit(void *handle, void *buffer, size_t len) {
+    ModemCmuxChannel *ch = ppp_ch;
+    if (!ch || !ch->isOpen() || ch->write((const uint8_t *)buffer, len) != len) {
+        ppp_stats.tx_errors++;
+        return ESP_FAIL;
+    }
+    ppp_stats.tx_bytes += len;
+    return ESP_OK;
+}
+
+static esp_err_t ppp_post_attach(esp_netif_t *netif, esp_netif_iodriver_handle handle) {
+    esp_netif_driver_ifconfig_t cfg = {};
+    cfg.handle = handle;
+    cfg.transmit = ppp_transmit;
+    ppp_driver.netif = netif;
+    return esp_netif_set_driver_config(netif, &cfg);
+}
+
+// Multiplexer task: frames landed in the channel ring
+static void ppp_rx_notify() {
+    if (ppp_rx_task) {
+        xTaskNotifyGive(ppp_rx_task);
+    }
+}
+
+static void ppp_rx(void *param) {
+    static uint8_t buf[MODEM_PPP_RX_CHUNK];
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(200));
+        ModemCmuxChannel *ch = ppp_ch;
+        if (!ch) {
+            continue;
+        }
+        size_t n;
+        while ((n = ch->read(buf, sizeof(buf))) > 0) {
+            ppp_stats.rx_bytes += n;
+            esp_netif_receive(ppp_netif, buf, n, NULL);
+        }
+        // The modem closed the channel or the multiplexer went away under us
+        if (!ppp_stopping && (!ch->isOpen() || !modem_cmux_active())) {
+            ppp_failed = true;
+        }
+    }
+}
+
+// ===== Events =====
+
+static void on_ip_event(void *arg, esp_event_base_t base, int32_t id, void *data) {
+    if (id == IP_EVENT_PPP_GOT_IP) {
+        ip_event_got_ip_t *ev = (ip_event_got_ip_t *)data;
+        if (ev->esp_netif != ppp_netif) {
+            return;
+        }
+        esp_netif_get_dns_info(ppp_netif, ESP_NETIF_DNS_MAIN, &ppp_dns);
+        portENTER_CRITICAL(&ppp_mux);
+        ppp_stats.ip = ev->ip_info.ip.addr;
+        ppp_stats.up = true;
+        ppp_stats.up_since_ms = millis();
+        portEXIT_CRITICAL(&ppp_mux);
+    } else if (id == IP_EVENT_PPP_LOST_IP) {
+        portENTER_CRITICAL(&ppp_mux);
+        ppp_stats.ip = 0;
+        ppp_stats.up = false;
+        portEXIT_CRITICAL(&ppp_mux);
+        if (!ppp_stopping) {
+            ppp_failed = true;
+        }
+    }
+}
+
+static void on_ppp_status(void *arg, esp_event_base_t base, int32_t id, void *data) {
+    if (id == NETIF_PPP_ERRORUSER) {
+        ppp_closed = true;          // Our own close finished
+    } else if (id > NETIF_PPP_ERRORNONE && id < NETIF_PP_PHASE_OFFSET) {
+        ppp_closed = true;
+        if (!ppp_stopping) {
+            ppp_failed = true;
+            LOG_WARNF("ModemPPP", "Link error %ld", (long)id);
+        }
+    }
+}
+
+// ===== Link =====
+
+static bool netif_create() {
+    if (ppp_netif) {
+        return true;
+    }
+    esp_netif_init();
+    esp_err_t err = esp_event_loop_create_default();
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
+        return false;
+    }
+    esp_netif_config_t cfg = ESP_NETIF_DEFAULT_PPP();
+    ppp_netif = esp_netif_new(&cfg);
+    if (!ppp_netif) {
+        LOG_ERROR("ModemPPP", "Cannot create the PPP netif");
+        return false;
+    }
+    esp_netif_ppp_config_t params = {};
+    params.ppp_phase_event_enabled = false;
+    params.ppp_error_event_enabled = true;
+    esp_netif_ppp_set_params(ppp_netif, &params);
+    if (ppp_user.length()) {
+        esp_netif_ppp_set_auth(ppp_netif, NETIF_PPP_AUTHTYPE_PAP, ppp_user.c_str(), ppp_pass.c_str());
+    }
+    ppp_driver.post_attach = ppp_post_attach;
+    esp_netif_attach(ppp_netif, &ppp_driver);
+    esp_event_handler_register(IP_EVENT, IP_EVENT_PPP_GOT_IP, on_ip_event, NULL);
+    esp_event_handler_register(IP_EVENT, IP_EVENT_PPP_LOST_IP, on_ip_event, NULL);
+    esp_event_handler_register(NETIF_PPP_STATUS, ESP_EVENT_ANY_ID, on_ppp_status, NULL);
+
+    if (xTaskCreate(ppp_rx, "modem_ppp", MODEM_PPP_TASK_STACK, NULL, MODEM_PPP_TASK_PRIORITY, &ppp_rx_task) != pdPASS) {
+        LOG_ERROR("ModemPPP", "Failed to start the receive task");
+        return false;
+    }
+    return true;
+}
+
+// The default netif and the DNS servers follow the route. lwIP keeps one
+// set of DNS servers, which the last DHCP or IPCP wrote, so they are swapped by hand
+static void apply_default() {
+    bool want = ppp_stats.up && net_manager_route() == NET_BEARER_CELL;
+    if (want == ppp_stats.is_default) {
+        return;
+    }
+    esp_netif_t *wifi = esp_netif_get_handle_from_ifkey("WIFI_STA_DEF");
+    if (want) {
+        esp_netif_get_dns_info(ppp_netif, ESP_NETIF_DNS_MAIN, &ppp_other_dns);
+        esp_netif_set_default_netif(ppp_netif);
+        esp_netif_set_dns_info(ppp_netif, ESP_NETIF_DNS_MAIN, &ppp_dns);
+    } else {
+        if (wifi) {
+            esp_netif_set_default_netif(wifi);
+            if (ppp_other_dns.ip.u_addr.ip4.addr) {
+                esp_netif_set_dns_info(wifi, ESP_NETIF_DNS_MAIN, &ppp_other_dns);
+            }
+        }
+    }
+    ppp_stats.is_default = want;
+    LOG_INFOF("ModemPPP", "Default netif %s", want ? ppp_ifname : "WiFi");
+}
+
+static void link_down() {
+    if (!ppp_ch && !modem_cmux_active()) {
+        return;
+    }
+    ppp_stopping = true;
+    if (ppp_ch) {
+        ppp_closed = false;
+        esp_netif_action_stop(ppp_netif, NULL, 0, NULL);
+        for (uint32_t start = millis(); !ppp_closed && millis() - start < MODEM_PPP_STOP_MS;) {
+            vTaskDelay(pdMS_TO_TICKS(50));
+        }
+        ppp_ch = NULL;
+    }
+    // CLD also hangs up the data call
+    modem_cmux_end();
+    portENTER_CRITICAL(&ppp_mux);
+    ppp_stats.up = false;
+    ppp_stats.ip = 0;
+    portEXIT_CRITICAL(&ppp_mux);
+    apply_default();
+    ppp_stopping = false;
+    ppp_failed = false;
+}
+
+static bool link_up(uint32_t timeout_ms) {
+    if (ppp_ch && ppp_stats.up) {
+        return true;
+    }
+    if (ppp_ch) {
+        link_down();                // Dialled but never got an address
+    }
+    if (!peri_init_ready(E_PERI_A7682E) || !netif_create()) {
+        return false;
+    }
+    uint32_t start = millis();
+    ppp_stats.dials++;
+    ppp_failed = false;
+
+    ModemCmuxChannel *ch = NULL;
+    if (!modem_cmux_begin(ppp_baud) || !(ch = modem_cmux_channel(MODEM_CMUX_PPP)) ||
+        !modem_cmux_dial(ppp_apn.c_str(), MODEM_PPP_DIAL_MS)) {
+        ppp_stats.dial_fails++;
+        LOG_WARNF("ModemPPP", "Dial on \"%s\" failed", ppp_apn.c_str());
+        modem_cmux_end();
+        return false;
+    }
+    ppp_ch = ch;
+    ch->onReceive(ppp_rx_notify);
+    esp_netif_action_start(ppp_netif, NULL, 0, NULL);
+    esp_netif_get_netif_impl_name(ppp_netif, ppp_ifname);
+
+    while (!ppp_stats.up && !ppp_failed && millis() - start < timeout_ms) {
+        vTaskDelay(pdMS_TO_TICKS(50));
+    }
+    if (!ppp_stats.up) {
+        ppp_stats.dial_fails++;
+        LOG_WARN("ModemPPP", "No address from IPCP");
+        link_down();
+        return false;
+    }
+    ppp_stats.last_dial_ms = millis() - start;
+    char ip[16];
+    esp_ip4_addr_t addr = { ppp_stats.ip };
+    esp_ip4addr_ntoa(&addr, ip, sizeof(ip));
+    LOG_INFOF("ModemPPP", "Up as %s on %s in %lu ms", ip, ppp_ifname, (unsigned long)ppp_stats.last_dial_ms);
+    apply_default();
+    return true;
+}
+
+// ===== Triggers =====
+
+static bool wanted(uint32_t now) {
+    int hold = ppp_hold;
+    if (hold != MODEM_PPP_AUTO) {
+        return hold == MODEM_PPP_HOLD_UP;
+    }
+    return ppp_enabled && ppp_cell_ms && now - ppp_cell_ms < MODEM_PPP_LINGER_MS;
+}
+
+static void backoff(uint32_t now) {
+    ppp_retry_ms = ppp_retry_ms ? min(ppp_retry_ms * 2, (uint32_t)MODEM_PPP_RETRY_MAX_MS) : MODEM_PPP_RETRY_MS;
+    ppp_next_dial = now + ppp_retry_ms;
+}
+
+static void sync_job(Job *job) {
+    xSemaphoreTake(ppp_lock, portMAX_DELAY);
+    if (ppp_failed && ppp_ch) {
+        ppp_stats.drops++;
+        LOG_WARN("ModemPPP", "Link fell");
+        link_down();
+        backoff(millis());
+    }
+    uint32_t now = millis();
+    if (wanted(now) && !ppp_ch && (int32_t)(now - ppp_next_dial) >= 0) {
+        if (link_up(MODEM_PPP_DIAL_MS + MODEM_PPP_IP_MS)) {
+            ppp_retry_ms = 0;
+        } else {
+            backoff(millis());
+        }
+    } else if (!wanted(now) && (ppp_ch || modem_cmux_active())) {
+        LOG_INFO("ModemPPP", "Hanging up");
+        link_down();
+    }
+    xSemaphoreGive(ppp_lock);
+
+    portENTER_CRITICAL(&ppp_mux);
+    ppp_busy = false;
+    portEXIT_CRITICAL(&ppp_mux);
+}
+
+static void sync() {
+    portENTER_CRITICAL(&ppp_mux);
+    if (ppp_busy) {
+        portEXIT_CRITICAL(&ppp_mux);
+        return;
+    }
+    ppp_busy = true;
+    portEXIT_CRITICAL(&ppp_mux);
+
+    Job *job = &ppp_jobs[0];
+    if (job->state == JOB_QUEUED || job->state == JOB_RUNNING) {
+        job = &ppp_jobs[1];
+    }
+    if (!job_submit(job, sync_job, NULL, JOB_PRIO_LOW)) {
+        portENTER_CRITICAL(&ppp_mux);
+        ppp_busy = false;
+        portEXIT_CRITICAL(&ppp_mux);
+    }
+}
+
+static void check_timer(WheelTimer *timer) {
+    uint32_t now = millis();
+    if (net_manager_route() == NET_BEARER_CELL) {
+        ppp_cell_ms = now ? now : 1;
+    }
+    bool want = wanted(now);
+    bool dialled = ppp_ch != NULL;
+    if ((ppp_failed && dialled) || (want && !dialled && (int32_t)(now - ppp_next_dial) >= 0) ||
+        (!want && (dialled || modem_cmux_active()))) {
+        sync();
+    }
+}
+
+// ===== Console =====
+
+static const char *hold_name(int hold) {
+    return hold == MODEM_PPP_HOLD_UP ? "up" : hold == MODEM_PPP_HOLD_DOWN ? "down" : "auto";
+}
+
+static void rpc_ppp(Print &out, const char *args) {
+    if (!strcmp(args, "up") || !strcmp(args, "down") || !strcmp(args, "auto")) {
+        modem_ppp_hold(!strcmp(args, "up") ? MODEM_PPP_HOLD_UP : !strcmp(args, "down") ? MODEM_PPP_HOLD_DOWN
+                                                                                      : MODEM_PPP_AUTO);
+        out.printf("hold %s\n", args);
+        return;
+    }
+    if (!strncmp(args, "bench ", 6)) {
+        ModemSockBenchResult res[MODEM_BENCH_PATHS];
+        if (!modem_bench_sockets(args + 6, res)) {
+            out.println("bench failed: http:// URL, modem and a name lookup needed");
+            return;
+        }
+        static const char *paths[MODEM_BENCH_PATHS] = {"AT", "PPP"};
+        for (int i = 0; i < MODEM_BENCH_PATHS; i++) {
+            const ModemSockBenchResult *r = &res[i];
+            out.printf("%-3s %s connect %lu ms, first byte %lu ms, %lu B in %lu ms, %lu B/s, %lu commands\n",
+                       paths[i], r->ok ? "ok  " : "FAIL", (unsigned long)r->connect_ms,
+                       (unsigned long)r->first_byte_ms, (unsigned long)r->bytes, (unsigned long)r->read_ms,
+                       (unsigned long)r->bytes_per_s, (unsigned long)r->commands);
+        }
+        return;
+    }
+    if (args[0]) {
+        out.println("usage: ppp [up|down|auto|bench <http url>]");
+        return;
+    }
+    ModemPppStats s;
+    modem_ppp_get_stats(&s);
+    char ip[16] = "-";
+    if (s.ip) {
+        esp_ip4_addr_t addr = { s.ip };
+        esp_ip4addr_ntoa(&addr, ip, sizeof(ip));
+    }
+    out.printf("%s%s, %s %s, hold %s, apn \"%s\"\n", s.up ? "up" : "down", s.is_default ? " (default)" : "",
+               ppp_ifname[0] ? ppp_ifname : "no netif", ip, hold_name(s.hold), ppp_apn.c_str());
+    out.printf("%lu dials (%lu failed, last %lu ms), %lu drops, up %lu s, rx %lu B, tx %lu B, %lu tx errors\n",
+               (unsigned long)s.dials, (unsigned long)s.dial_fails, (unsigned long)s.last_dial_ms,
+               (unsigned long)s.drops, s.up ? (unsigned long)((millis() - s.up_since_ms) / 1000) : 0UL,
+               (unsigned long)s.rx_bytes, (unsigned long)s.tx_bytes, (unsigned long)s.tx_errors);
+}
+
+// ===== API =====
+
+bool modem_ppp_begin() {
+#ifdef INTEGRATION_LAYER_ENABLED
+    ppp_enabled = GET_CONFIG_BOOL("ppp", "enabled", true);
+    ppp_apn = GET_CONFIG_STRING("ppp", "apn", String(MODEM_PPP_APN));
+    ppp_user = GET_CONFIG_STRING("ppp", "user", String(""));
+    ppp_pass = GET_CONFIG_STRING("ppp", "pass", String(""));
+    ppp_baud = GET_CONFIG_INT("ppp", "baud", MODEM_PPP_BAUD);
+#endif
+    if (!ppp_lock) {
+        ppp_lock = xSemaphoreCreateMutex();
+    }
+    if (!ppp_lock) {
+        return false;
+    }
+    ppp_stats.hold = ppp_hold;
+    ppp_running = true;
+    usb_console_rpc("ppp", rpc_ppp);
+    timer_wheel_init(&ppp_timer, "modem_ppp", check_timer);
+    timer_wheel_arm(&ppp_timer, MODEM_PPP_CHECK_MS, MODEM_PPP_CHECK_MS);
+    return true;
+}
+
+bool modem_ppp_connect(uint32_t timeout_ms) {
+    if (!ppp_lock) {
+        return false;
+    }
+    xSemaphoreTake(ppp_lock, portMAX_DELAY);
+    bool ok = link_up(timeout_ms);
+    xSemaphoreGive(ppp_lock);
+    return ok;
+}
+
+void modem_ppp_disconnect() {
+    if (!ppp_lock) {
+        return;
+    }
+    xSemaphoreTake(ppp_lock, portMAX_DELAY);
+    link_down();
+    xSemaphoreGive(ppp_lock);
+}
+
+void modem_ppp_hold(int hold) {
+    ppp_hold = hold;
+    ppp_stats.hold = hold;
+    ppp_next_dial = millis();
+    ppp_retry_ms = 0;
+    if (ppp_running) {
+        timer_wheel_arm(&ppp_timer, 1, MODEM_PPP_CHECK_MS);
+    }
+}
+
+bool modem_ppp_up() {
+    return ppp_stats.up;
+}
+
+const char *modem_ppp_ifname() {
+    return ppp_ifname;
+}
+
+void modem_ppp_get_stats(ModemPppStats *out) {
+    portENTER_CRITICAL(&ppp_mux);
+    *out = ppp_stats;
+    portEXIT_CRITICAL(&ppp_mux);
+}
+
+void modem_ppp_route_changed(int to) {
+    if (!ppp_running) {
+        return;
+    }
+    if (to == NET_BEARER_CELL) {
+        uint32_t now = millis();
+        ppp_cell_ms = now ? now : 1;
+    }
+    if (ppp_netif) {
+        apply_default();
+    }
+    timer_wheel_arm(&ppp_timer, 1, MODEM_PPP_CHECK_MS);
+}
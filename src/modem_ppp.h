@@ -0,0 +1,107 @@
+/**
+ * @file      modem_ppp.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     A7682E data as an lwIP PPP netif over the CMUX data channel
+ */
+
+#ifndef MODEM_PPP_H
+#define MODEM_PPP_H
+
+#include <Arduino.h>
+#include "peripheral.h"
+
+/**
+ * The modem dials on the CMUX PPP channel (modem_cmux_dial) and the
+ * channel becomes the esp_netif "PPP_DEF": lwIP runs PPP, IP, TCP and
+ * DNS on the ESP32, and the modem only carries frames. Anything written
+ * against sockets or WiFiClient works over 4G unchanged: MQTT, HTTP,
+ * tls_client, and WireGuard, whose outer netif is already PPP_DEF on the
+ * cell route. TCP gets its normal window instead of one AT command per
+ * read and per write. The AT channel stays free for the modem's own
+ * commands, SMS and signal probes included.
+ *
+ * The link follows net_manager: it is brought up when the route moves to
+ * 4G and becomes the default netif while the route stays there, and is
+ * dropped MODEM_PPP_LINGER_MS after the route leaves 4G. The multiplexer
+ * keeps the host out of light sleep while it is up. A link that falls
+ * (NO CARRIER, LCP failure, the multiplexer closing) is dialled again
+ * after MODEM_PPP_RETRY_MS, doubling up to MODEM_PPP_RETRY_MAX_MS.
+ *
+ * Console: "ppp" for the link, "ppp up" and "ppp down" hold it so until
+ * "ppp auto", "ppp bench <http url>" compares this path with the modem's
+ * AT sockets (modem_bench_sockets).
+ * Config section "ppp": enabled (true), apn ("internet"), user, pass,
+ * baud (921600).
+ */
+
+#define MODEM_PPP_APN               "internet"
+#define MODEM_PPP_BAUD              921600  // Negotiated before the multiplexer starts
+#define MODEM_PPP_CHECK_MS          2000
+#define MODEM_PPP_DIAL_MS           30000   // ATD*99# to CONNECT
+#define MODEM_PPP_IP_MS             20000   // CONNECT to an address from IPCP
+#define MODEM_PPP_STOP_MS           3000    // LCP terminate
+#define MODEM_PPP_LINGER_MS         60000   // Off the cell route before hanging up
+#define MODEM_PPP_RETRY_MS          10000
+#define MODEM_PPP_RETRY_MAX_MS      300000
+#define MODEM_PPP_RX_CHUNK          512
+#define MODEM_PPP_TASK_STACK        (1024 * 3)
+#define MODEM_PPP_TASK_PRIORITY     A7682E_PRIORITY
+
+enum ModemPppHold {
+    MODEM_PPP_AUTO = -1,            // Follow the route
+    MODEM_PPP_HOLD_DOWN = 0,
+    MODEM_PPP_HOLD_UP = 1,
+};
+
+struct ModemPppStats {
+    bool up;                        // Has an address
+    bool is_default;
+    int8_t hold;                    // ModemPppHold
+    uint32_t ip;                    // Network order, 0 while down
+    uint32_t dials;
+    uint32_t dial_fails;
+    uint32_t drops;                 // Fell without being asked to
+    uint32_t last_dial_ms;          // ATD to an address
+    uint32_t up_since_ms;
+    uint32_t rx_bytes;              // PPP frames, both ways
+    uint32_t tx_bytes;
+    uint32_t tx_errors;             // Frames the channel would not take
+};
+
+/**
+ * @brief Read the config and start following the route. Brings nothing up
+ *        by itself
+ */
+bool modem_ppp_begin();
+
+/**
+ * @brief Bring the link up now and wait for an address. Blocks; not from
+ *        the UI task
+ */
+bool modem_ppp_connect(uint32_t timeout_ms = MODEM_PPP_DIAL_MS + MODEM_PPP_IP_MS);
+
+/**
+ * @brief Hang up and close the multiplexer. Blocks up to MODEM_PPP_STOP_MS
+ */
+void modem_ppp_disconnect();
+
+void modem_ppp_hold(int hold);
+bool modem_ppp_up();
+
+/**
+ * @brief The netif name, for SO_BINDTODEVICE; "" while it does not exist
+ */
+const char *modem_ppp_ifname();
+
+void modem_ppp_get_stats(ModemPppStats *out);
+
+/**
+ * @brief Called by net_manager when the route changes: the default netif
+ *        follows it
+ */
+void modem_ppp_route_changed(int to);
+
+#endif // MODEM_PPP_H
@@ -0,0 +1,695 @@
+/**
+ * @file      modem_sms.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Received SMS: one +CMGL per sweep, PDU decoding, concatenation, bulk delete
+ */
+
+#include "modem_sms.h"
+#include "modem_at.h"
+#include "msg_store.h"
+#include "time_service.h"
+#include "timer_wheel.h"
+#include "job_pool.h"
+#include "usb_console.h"
+#include "simple_logger.h"
+#include <esp_heap_caps.h>
+#ifdef INTEGRATION_LAYER_ENABLED
+#include "integration/config_manager.h"
+#endif
+
+enum PartState : uint8_t {
+    PART_NEW,
+    PART_DONE,                      // Stored, delete the slot
+    PART_DROP,                      // Not a message we can show, delete the slot
+    PART_KEEP,                      // Waiting for its other parts, or for the store
+};
+
+struct SmsPart {
+    uint16_t slot;
+    uint16_t ref;                   // Concatenation reference
+    uint8_t total;                  // 1 when not concatenated
+    uint8_t seq;
+    PartState state;
+    uint32_t time;                  // UTC seconds, 0 when the PDU had none that made sense
+    char sender[SMS_SENDER_MAX + 1];
+    uint16_t len;
+    char text[SMS_PART_TEXT_MAX];
+};
+
+// Text to the store in records of at most MSG_STORE_TEXT_MAX
+struct Delivery {
+    const char *sender;
+    uint32_t time;
+    bool ok;
+    size_t len;
+    char buf[MSG_STORE_TEXT_MAX];
+};
+
+enum SmsAlphabet {
+    ALPHA_GSM7,
+    ALPHA_8BIT,
+    ALPHA_UCS2,
+};
+
+// GSM 03.38 default alphabet; 0x1B escapes to the extension table
+static const uint16_t gsm7_table[128] = {
+    0x0040, 0x00A3, 0x0024, 0x00A5, 0x00E8, 0x00E9, 0x00F9, 0x00EC,
+    0x00F2, 0x00C7, 0x000A, 0x00D8, 0x00F8, 0x000D, 0x00C5, 0x00E5,
+    0x0394, 0x005F, 0x03A6, 0x0393, 0x039B, 0x03A9, 0x03A0, 0x03A8,
+    0x03A3, 0x0398, 0x039E, 0x0020, 0x00C6, 0x00E6, 0x00DF, 0x00C9,
+    0x0020, 0x0021, 0x0022, 0x0023, 0x00A4, 0x0025, 0x0026, 0x0027,
+    0x0028, 0x0029, 0x002A, 0x002B, 0x002C, 0x002D, 0x002E, 0x002F,
+    0x0030, 0x0031, 0x0032, 0x0033, 0x0034, 0x0035, 0x0036, 0x0037,
+    0x0038, 0x0039, 0x003A, 0x003B, 0x003C, 0x003D, 0x003E, 0x003F,
+    0x00A1, 0x0041, 0x0042, 0x0043, 0x0044, 0x0045, 0x0046, 0x0047,
+    0x0048, 0x0049, 0x004A, 0x004B, 0x004C, 0x004D, 0x004E, 0x004F,
+    0x0050, 0x0051, 0x0052, 0x0053, 0x0054, 0x0055, 0x0056, 0x0057,
+    0x0058, 0x0059, 0x005A, 0x00C4, 0x00D6, 0x00D1, 0x00DC, 0x00A7,
+    0x00BF, 0x0061, 0x0062, 0x0063, 0x0064, 0x0065, 0x0066, 0x0067,
+    0x0068, 0x0069, 0x006A, 0x006B, 0x006C, 0x006D, 0x006E, 0x006F,
+    0x0070, 0x0071, 0x0072, 0x0073, 0x0074, 0x0075, 0x0076, 0x0077,
+    0x0078, 0x0079, 0x007A, 0x00E4, 0x00F6, 0x00F1, 0x00FC, 0x00E0,
+};
+
+static portMUX_TYPE sms_mux = portMUX_INITIALIZER_UNLOCKED;
+static bool sms_busy = false;
+static bool sms_pending = false;
+static Job sms_jobs[2];             // The one finishing may still be marked running
+static WheelTimer sms_timer;
+static bool sms_ready = false;
+static bool sms_setup = false;      // PDU mode and +CMTI routing set on the modem
+static SmsStats sms_stats;
+
+// The batch: filled on the modem task during +CMGL, then read by the sweep job
+static SmsPart *sms_batch = NULL;
+static size_t sms_count = 0;
+static bool sms_overflow = false;
+static int sms_list_slot = -1;      // From the +CMGL header, for the PDU line after it
+static uint8_t sms_pdu[SMS_PDU_MAX];
+
+// ===== Text =====
+
+static size_t put_utf8(uint32_t cp, char *out, size_t len, size_t max) {
+    char tmp[4];
+    size_t n;
+    if (cp < 0x80) {
+        tmp[0] = cp;
+        n = 1;
+    } else if (cp < 0x800) {
+        tmp[0] = 0xC0 | (cp >> 6);
+        tmp[1] = 0x80 | (cp & 0x3F);
+        n = 2;
+    } else if (cp < 0x10000) {
+        tmp[0] = 0xE0 | (cp >> 12);
+        tmp[1] = 0x80 | ((cp >> 6) & 0x3F);
+        tmp[2] = 0x80 | (cp & 0x3F);
+        n = 3;
+    } else {
+        tmp[0] = 0xF0 | (cp >> 18);
+        tmp[1] = 0x80 | ((cp >> 12) & 0x3F);
+        tmp[2] = 0x80 | ((cp >> 6) & 0x3F);
+        tmp[3] = 0x80 | (cp & 0x3F);
+        n = 4;
+    }
+    if (len + n > max) {
+        return len;
+    }
+    memcpy(out + len, tmp, n);
+    return len + n;
+}
+
+static uint16_t gsm7_ext(uint8_t c) {
+    switch (c) {
+    case 0x0A: return 0x000C;
+    case 0x14: return '^';
+    case 0x28: return '{';
+    case 0x29: return '}';
+    case 0x2F: return '\\';
+    case 0x3C: return '[';
+    case 0x3D: return '~';
+    case 0x3E: return ']';
+    case 0x40: return '|';
+    case 0x65: return 0x20AC;       // Euro sign
+    default:   return gsm7_table[c];
+    }
+}
+
+// Septets first to last of packed data, which is bytes long
+static size_t unpack_gsm7(const uint8_t *data, size_t bytes, size_t first, size_t last, char *out, size_t max) {
+    size_t len = 0;
+    bool escape = false;
+    for (size_t s = first; s < last; s++) {
+        size_t bit = s * 7;
+        size_t at = bit / 8;
+        uint8_t shift = bit % 8;
+        if (at >= bytes) {
+            break;
+        }
+        uint16_t v = data[at] >> shift;
+        if (shift > 1 && at + 1 < bytes) {
+            v |= data[at + 1] << (8 - shift);
+        }
+        uint8_t c = v & 0x7F;
+        if (c == 0x1B && !escape) {
+            escape = true;
+            continue;
+        }
+        len = put_utf8(escape ? gsm7_ext(c) : gsm7_table[c], out, len, max);
+        escape = false;
+    }
+    return len;
+}
+
+static size_t unpack_ucs2(const uint8_t *data, size_t bytes, char *out, size_t max) {
+    size_t len = 0;
+    for (size_t i = 0; i + 1 < bytes; i += 2) {
+        uint32_t cp = (data[i] << 8) | data[i + 1];
+        if (cp >= 0xD800 && cp < 0xDC00 && i + 3 < bytes) {
+            uint32_t lo = (data[i + 2] << 8) | data[i + 3];
+            if (lo >= 0xDC00 && lo < 0xE000) {
+                cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+                i += 2;
+            }
+        }
+        if (cp >= 0xD800 && cp < 0xE000) {
+            cp = 0xFFFD;            // Half a pair
+        }
+        len = put_utf8(cp, out, len, max);
+    }
+    return len;
+}
+
+// Binary payloads (ringtones, WAP push): shown, not interpreted
+static size_t unpack_8bit(const uint8_t *data, size_t bytes, char *out, size_t max) {
+    size_t len = min(bytes, max);
+    for (size_t i = 0; i < len; i++) {
+        out[i] = data[i] >= 0x20 && data[i] < 0x7F ? data[i] : '.';
+    }
+    return len;
+}
+
+// ===== PDU =====
+
+static int hex_nibble(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    return -1;
+}
+
+static size_t unhex(const char *hex, uint8_t *out, size_t max) {
+    size_t n = 0;
+    while (hex[0] && hex[1] && n < max) {
+        int hi = hex_nibble(hex[0]);
+        int lo = hex_nibble(hex[1]);
+        if (hi < 0 || lo < 0) {
+            return 0;
+        }
+        out[n++] = (hi << 4) | lo;
+        hex += 2;
+    }
+    return hex[0] ? 0 : n;
+}
+
+static inline uint8_t swapped_bcd(uint8_t b) {
+    return (b & 0x0F) * 10 + (b >> 4);
+}
+
+// Originating address: digits semi-octets long, or alphanumeric in GSM 7-bit
+static void decode_address(const uint8_t *data, uint8_t digits, uint8_t toa, char *out) {
+    size_t len = 0;
+    if ((toa & 0x70) == 0x50) {
+        len = unpack_gsm7(data, (digits + 1) / 2, 0, digits * 4 / 7, out, SMS_SENDER_MAX);
+    } else {
+        if ((toa & 0x70) == 0x10) {
+            out[len++] = '+';
+        }
+        for (uint8_t i = 0; i < digits && len < SMS_SENDER_MAX; i++) {
+            uint8_t d = i & 1 ? data[i / 2] >> 4 : data[i / 2] & 0x0F;
+            if (d < 10) {
+                out[len++] = '0' + d;
+            } else if (d == 0x0A || d == 0x0B) {
+                out[len++] = d == 0x0A ? '*' : '#';
+            }
+        }
+    }
+    out[len] = '\0';
+}
+
+// Service centre time stamp, local time and a zone in quarter hours
+static uint32_t decode_scts(const uint8_t *data) {
+    int yy = swapped_bcd(data[0]);
+    int mo = swapped_bcd(data[1]);
+    int dd = swapped_bcd(data[2]);
+    int hh = swapped_bcd(data[3]);
+    int mi = swapped_bcd(data[4]);
+    int ss = swapped_bcd(data[5]);
+    int tz = swapped_bcd(data[6] & 0xF7);
+    if (mo < 1 || mo > 12 || dd < 1 || dd > 31 || hh > 23 || mi > 59 || ss > 59) {
+        return 0;
+    }
+    if (data[6] & 0x08) {
+        tz = -tz;
+    }
+    return (uint32_t)(time_make_utc(2000 + yy, mo, dd, hh, mi, ss) - tz * 15 * 60);
+}
+
+static SmsAlphabet dcs_alphabet(uint8_t dcs, bool *ok) {
+    *ok = true;
+    if ((dcs & 0x80) == 0) {
+        // General coding, marked for automatic deletion or not
+        if (dcs & 0x20) {
+            *ok = false;            // Compressed
+        }
+        switch ((dcs >> 2) & 0x03) {
+        case 1:  return ALPHA_8BIT;
+        case 2:  return ALPHA_UCS2;
+        default: return ALPHA_GSM7;
+        }
+    }
+    if ((dcs & 0xF0) == 0xF0) {
+        return dcs & 0x04 ? ALPHA_8BIT : ALPHA_GSM7;
+    }
+    if ((dcs & 0xF0) == 0xE0) {
+        return ALPHA_UCS2;
+    }
+    return ALPHA_GSM7;              // Message waiting groups
+}
+
+// SMS-DELIVER into part; anything else is false
+static bool decode_pdu(const char *hex, SmsPart *part) {
+    size_t n = unhex(hex, sms_pdu, sizeof(sms_pdu));
+    if (!n || sms_pdu[0] + 1u >= n) {
+        return false;
+    }
+    const uint8_t *p = sms_pdu + sms_pdu[0] + 1;
+    const uint8_t *end = sms_pdu + n;
+    if (end - p < 3) {
+        return false;
+    }
+
+    uint8_t first = *p++;
+    if ((first & 0x03) != 0) {
+        return false;               // Status report or submit
+    }
+    uint8_t digits = *p++;
+    uint8_t toa = *p++;
+    if (digits > 20 || p + (digits + 1) / 2 + 10 > end) {
+        return false;
+    }
+    decode_address(p, digits, toa, part->sender);
+    p += (digits + 1) / 2;
+    p++;                            // Protocol identifier
+    bool ok;
+    SmsAlphabet alphabet = dcs_alphabet(*p++, &ok);
+    if (!ok) {
+        return false;
+    }
+    part->time = decode_scts(p);
+    p += 7;
+    uint8_t udl = *p++;
+    size_t ud_bytes = alphabet == ALPHA_GSM7 ? (udl * 7 + 7) / 8 : udl;
+    if (p + ud_bytes > end) {
+        return false;
+    }
+
+    part->ref = 0;
+    part->total = 1;
+    part->seq = 1;
+    size_t skip = 0;
+    if (first & 0x40) {
+        uint8_t udhl = p[0];
+        if (udhl + 1u > ud_bytes) {
+            return false;
+        }
+        for (size_t i = 1; i + 1 < udhl + 1u; i += 2 + p[i + 1]) {
+            const uint8_t *ie = p + i;
+            if (ie[0] == 0x00 && ie[1] == 3 && i + 5 <= udhl + 1u) {
+                part->ref = ie[2];
+                part->total = ie[3];
+                part->seq = ie[4];
+            } else if (ie[0] == 0x08 && ie[1] == 4 && i + 6 <= udhl + 1u) {
+                part->ref = (ie[2] << 8) | ie[3];
+                part->total = ie[4];
+                part->seq = ie[5];
+            }
+        }
+        if (!part->total || !part->seq || part->seq > part->total) {
+            part->total = part->seq = 1;
+        }
+        skip = udhl + 1;
+    }
+
+    if (alphabet == ALPHA_GSM7) {
+        // The header is padded out to a whole septet
+        part->len = unpack_gsm7(p, ud_bytes, (skip * 8 + 6) / 7, udl, part->text, sizeof(part->text));
+    } else if (alphabet == ALPHA_UCS2) {
+        part->len = unpack_ucs2(p + skip, ud_bytes - skip, part->text, sizeof(part->text));
+    } else {
+        part->len = unpack_8bit(p + skip, ud_bytes - skip, part->text, sizeof(part->text));
+    }
+    return true;
+}
+
+// ===== Listing =====
+
+// "+CMGL: <index>,<stat>,[<alpha>],<length>" and then the PDU, on the modem task
+static void list_line(const char *line, void *ctx) {
+    if (!strncmp(line, "+CMGL:", 6)) {
+        int slot, stat;
+        sms_list_slot = -1;
+        // Stored outgoing messages (2, 3) are not ours to delete
+        if (sscanf(line + 6, "%d,%d", &slot, &stat) == 2 && (stat == 0 || stat == 1) && slot >= 0) {
+            sms_list_slot = slot;
+        }
+        return;
+    }
+    if (sms_list_slot < 0) {
+        return;
+    }
+    if (sms_count >= SMS_BATCH_MAX) {
+        sms_overflow = true;
+        sms_list_slot = -1;
+        return;
+    }
+    SmsPart *part = &sms_batch[sms_count++];
+    part->slot = sms_list_slot;
+    part->state = decode_pdu(line, part) ? PART_NEW : PART_DROP;
+    sms_list_slot = -1;
+}
+
+// ===== Delivery =====
+
+static bool store(const char *sender, const char *text, size_t len, uint32_t time) {
+    for (int i = 0; i < SMS_STORE_RETRIES; i++) {
+        if (msg_store_append(MSG_CHANNEL_SMS, sender, text, len, 0, 0, time)) {
+            return true;
+        }
+        vTaskDelay(pdMS_TO_TICKS(50));
+    }
+    return false;
+}
+
+static void deliver_flush(Delivery *d) {
+    if (d->len && d->ok) {
+        d->ok = store(d->sender, d->buf, d->len, d->time);
+    }
+    d->len = 0;
+}
+
+// Records break between characters, never inside one
+static void deliver_add(Delivery *d, const char *text, size_t len) {
+    while (len) {
+        size_t n = min(len, sizeof(d->buf) - d->len);
+        if (n < len) {
+            while (n && (text[n] & 0xC0) == 0x80) {
+                n--;
+            }
+        }
+        memcpy(d->buf + d->len, text, n);
+        d->len += n;
+        text += n;
+        len -= n;
+        if (len) {
+            deliver_flush(d);
+        }
+    }
+}
+
+static SmsPart *find_part(const SmsPart *like, uint8_t seq) {
+    for (size_t i = 0; i < sms_count; i++) {
+        SmsPart *p = &sms_batch[i];
+        if (p->state == PART_NEW && p->seq == seq && p->ref == like->ref && p->total == like->total &&
+            !strcmp(p->sender, like->sender)) {
+            return p;
+        }
+    }
+    return NULL;
+}
+
+static void set_group(const SmsPart *like, PartState state) {
+    for (size_t i = 0; i < sms_count; i++) {
+        SmsPart *p = &sms_batch[i];
+        // Repeats of a part go with the rest
+        if (p->state == PART_NEW && p->ref == like->ref && p->total == like->total &&
+            !strcmp(p->sender, like->sender)) {
+            p->state = state;
+        }
+    }
+}
+
+// One message from first, a part of it; waits if parts are missing and not too old
+static void deliver(SmsPart *first) {
+    uint16_t found = 0;
+    uint32_t oldest = UINT32_MAX;
+    for (uint16_t seq = 1; seq <= first->total; seq++) {
+        const SmsPart *p = find_part(first, seq);
+        if (p) {
+            found++;
+            if (p->time && p->time < oldest) {
+                oldest = p->time;
+            }
+        }
+    }
+    if (found < first->total) {
+        bool expired = time_valid() && oldest != UINT32_MAX &&
+                       (int32_t)(time_now_s() - oldest) > SMS_PARTIAL_TIMEOUT_S;
+        if (!expired) {
+            set_group(first, PART_KEEP);
+            return;
+        }
+    }
+
+    Delivery d;
+    d.sender = first->sender;
+    d.time = oldest != UINT32_MAX ? oldest : 0;
+    d.ok = true;
+    d.len = 0;
+    for (uint16_t seq = 1; seq <= first->total; seq++) {
+        const SmsPart *p = find_part(first, seq);
+        if (p) {
+            deliver_add(&d, p->text, p->len);
+        } else {
+            deliver_add(&d, SMS_GAP_MARKER, strlen(SMS_GAP_MARKER));
+        }
+    }
+    deliver_flush(&d);
+    if (!d.ok) {
+        sms_stats.store_failures++;
+    } else {
+        sms_stats.messages++;
+        if (first->total > 1) {
+            sms_stats.concatenated++;
+        }
+    }
+    set_group(first, d.ok ? PART_DONE : PART_KEEP);
+}
+
+// ===== Sweep =====
+
+static bool modem_setup() {
+    if (sms_setup) {
+        return true;
+    }
+    // New messages are stored and announced with +CMTI, never routed straight to the port
+    if (modem_at_wait(modem_at_send("+CMGF=0")) != MODEM_AT_OK ||
+        modem_at_wait(modem_at_send("+CNMI=2,1,0,0,0")) != MODEM_AT_OK) {
+        LOG_WARN("SMS", "PDU mode setup failed");
+        return false;
+    }
+    sms_setup = true;
+    return true;
+}
+
+static void delete_slots(bool bulk) {
+    uint32_t n = 0;
+    for (size_t i = 0; i < sms_count; i++) {
+        if (sms_batch[i].state == PART_DONE || sms_batch[i].state == PART_DROP) {
+            n++;
+        }
+    }
+    if (!n) {
+        return;
+    }
+    // Every read message: what came in since the listing is still unread
+    if (bulk) {
+        if (modem_at_wait(modem_at_send("+CMGD=1,1", SMS_DELETE_TIMEOUT_MS)) == MODEM_AT_OK) {
+            sms_stats.deleted += n;
+            return;
+        }
+        LOG_WARN("SMS", "Bulk delete failed, deleting by slot");
+    }
+    char cmd[24];
+    for (size_t i = 0; i < sms_count; i++) {
+        const SmsPart *p = &sms_batch[i];
+        if (p->state != PART_DONE && p->state != PART_DROP) {
+            continue;
+        }
+        snprintf(cmd, sizeof(cmd), "+CMGD=%u", p->slot);
+        if (modem_at_wait(modem_at_send(cmd, SMS_DELETE_TIMEOUT_MS)) == MODEM_AT_OK) {
+            sms_stats.deleted++;
+        }
+    }
+}
+
+// true if a full batch made room for more
+static bool sweep() {
+    if (!peri_init_ready(E_PERI_A7682E) || !modem_at_begin() || !modem_setup()) {
+        return false;
+    }
+    uint32_t start = millis();
+    sms_count = 0;
+    sms_overflow = false;
+    sms_list_slot = -1;
+    // 4: all of them, read or not
+    int result = modem_at_wait(modem_at_stream("+CMGL=4", SMS_LIST_TIMEOUT_MS, list_line));
+    if (result != MODEM_AT_OK) {
+        // The modem may have restarted and lost the mode
+        sms_setup = false;
+        LOG_WARNF("SMS", "Listing failed (%d)", result);
+        return false;
+    }
+
+    for (size_t i = 0; i < sms_count; i++) {
+        SmsPart *p = &sms_batch[i];
+        if (p->state == PART_DROP) {
+            sms_stats.decode_errors++;
+        } else {
+            sms_stats.parts++;
+        }
+    }
+    for (size_t i = 0; i < sms_count; i++) {
+        if (sms_batch[i].state == PART_NEW) {
+            deliver(&sms_batch[i]);
+        }
+    }
+    uint32_t kept = 0;
+    for (size_t i = 0; i < sms_count; i++) {
+        kept += sms_batch[i].state == PART_KEEP;
+    }
+    uint32_t deleted = sms_stats.deleted;
+    delete_slots(!kept && !sms_overflow);
+
+    uint32_t ms = millis() - start;
+    sms_stats.sweeps++;
+    sms_stats.partial = kept;
+    sms_stats.overflows += sms_overflow;
+    sms_stats.last_sweep_ms = ms;
+    sms_stats.last_sweep_parts = sms_count;
+    if (ms > sms_stats.max_sweep_ms) {
+        sms_stats.max_sweep_ms = ms;
+    }
+    if (sms_count) {
+        LOG_INFOF("SMS", "%u parts in %lu ms, %u waiting", (unsigned)sms_count, (unsigned long)ms, (unsigned)kept);
+    }
+    return sms_overflow && sms_stats.deleted != deleted;
+}
+
+static void sweep_job(Job *job) {
+    while (true) {
+        bool more = sweep();
+        portENTER_CRITICAL(&sms_mux);
+        if (!sms_pending && !more) {
+            sms_busy = false;
+            portEXIT_CRITICAL(&sms_mux);
+            return;
+        }
+        sms_pending = false;
+        portEXIT_CRITICAL(&sms_mux);
+    }
+}
+
+// ===== Triggers =====
+
+static void on_cmti(const char *line, void *ctx) {
+    modem_sms_sweep();
+}
+
+static void check_timer(WheelTimer *timer) {
+    modem_sms_sweep();
+}
+
+static void rpc_sms(Print &out, const char *args) {
+    if (!strcmp(args, "sweep")) {
+        out.println(modem_sms_sweep() ? "started" : "not running");
+        return;
+    }
+    SmsStats s;
+    modem_sms_get_stats(&s);
+    out.printf("sweeps %lu, last %lu parts in %lu ms, longest %lu ms%s\n", (unsigned long)s.sweeps,
+               (unsigned long)s.last_sweep_parts, (unsigned long)s.last_sweep_ms, (unsigned long)s.max_sweep_ms,
+               modem_sms_busy() ? ", busy" : "");
+    out.printf("parts %lu, messages %lu (concatenated %lu), waiting %lu, deleted %lu\n", (unsigned long)s.parts,
+               (unsigned long)s.messages, (unsigned long)s.concatenated, (unsigned long)s.partial,
+               (unsigned long)s.deleted);
+    out.printf("decode errors %lu, store failures %lu, overflows %lu\n", (unsigned long)s.decode_errors,
+               (unsigned long)s.store_failures, (unsigned long)s.overflows);
+}
+
+// ===== API =====
+
+bool modem_sms_begin() {
+    uint32_t check_ms = SMS_CHECK_MIN * 60 * 1000UL;
+#ifdef INTEGRATION_LAYER_ENABLED
+    if (!GET_CONFIG_BOOL("sms", "enabled", true)) {
+        LOG_INFO("SMS", "Disabled");
+        return true;
+    }
+    check_ms = GET_CONFIG_INT("sms", "check_min", SMS_CHECK_MIN) * 60 * 1000UL;
+#endif
+    sms_batch = (SmsPart *)heap_caps_malloc(SMS_BATCH_MAX * sizeof(SmsPart), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!sms_batch) {
+        LOG_ERROR("SMS", "No memory for the batch");
+        return false;
+    }
+    sms_ready = true;
+    modem_at_on_urc("+CMTI", on_cmti);
+    usb_console_rpc("sms", rpc_sms);
+    timer_wheel_init(&sms_timer, "sms", check_timer);
+    timer_wheel_arm(&sms_timer, SMS_FIRST_CHECK_MS, check_ms);
+    return true;
+}
+
+bool modem_sms_sweep() {
+    if (!sms_ready) {
+        return false;
+    }
+    portENTER_CRITICAL(&sms_mux);
+    if (sms_busy) {
+        sms_pending = true;
+        portEXIT_CRITICAL(&sms_mux);
+        return true;
+    }
+    sms_busy = true;
+    sms_pending = false;
+    portEXIT_CRITICAL(&sms_mux);
+
+    Job *job = &sms_jobs[0];
+    if (job->state == JOB_QUEUED || job->state == JOB_RUNNING) {
+        job = &sms_jobs[1];
+    }
+    if (!job_submit(job, sweep_job, NULL, JOB_PRIO_LOW)) {
+        portENTER_CRITICAL(&sms_mux);
+        sms_busy = false;
+        portEXIT_CRITICAL(&sms_mux);
+        return false;
+    }
+    return true;
+}
+
+bool modem_sms_busy() {
+    return sms_busy;
+}
+
+void modem_sms_get_stats(SmsStats *out) {
+    *out = sms_stats;
+}
@@ -0,0 +1,80 @@
+/**
+ * @file      modem_sms.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Received SMS on the A7682E: batched PDU-mode reads into the message store
+ */
+
+#ifndef MODEM_SMS_H
+#define MODEM_SMS_H
+
+#include <Arduino.h>
+
+/**
+ * Messages are never read one by one. A sweep lists every stored message
+ * with a single AT+CMGL in PDU mode, streamed through modem_at so the
+ * answer has no size limit, and decodes each PDU on the modem task into
+ * a batch in PSRAM: sender, service centre time and the text as UTF-8
+ * from the GSM 7-bit alphabet (with its extension table), 8-bit data or
+ * UCS2. Parts of a concatenated message are put together by sender,
+ * reference and part count, then every message goes to msg_store on the
+ * SMS channel and the slots it came from are deleted, all read ones with
+ * one AT+CMGD=1,1 when nothing has to stay behind.
+ *
+ * A message with parts still to come stays on the SIM until its last part
+ * arrives, or for SMS_PARTIAL_TIMEOUT_S after which it is stored with a
+ * gap marker for each missing part. A message the store does not take
+ * also stays, for the next sweep. Stored outgoing messages are left alone.
+ *
+ * A +CMTI URC starts a sweep, and so does a periodic check, for messages
+ * that came in while the modem was off or the URC was lost. Sweeps run on
+ * the job pool; one asked for during a sweep runs right after it.
+ *
+ * Config section "sms": enabled (true), check_min.
+ */
+
+#define SMS_BATCH_MAX               160     // Parts per sweep (PSRAM); more are left to the next
+#define SMS_SENDER_MAX              24      // UTF-8, an alphanumeric sender may use 11 characters
+#define SMS_PART_TEXT_MAX           320     // 160 septets, 2 bytes of UTF-8 a septet at most
+#define SMS_PDU_MAX                 184     // SMSC and TPDU, octets
+#define SMS_PARTIAL_TIMEOUT_S       (24 * 3600)
+#define SMS_CHECK_MIN               10      // Periodic sweep
+#define SMS_FIRST_CHECK_MS          15000   // After boot, for what came in while off
+#define SMS_LIST_TIMEOUT_MS         30000
+#define SMS_DELETE_TIMEOUT_MS       25000
+#define SMS_STORE_RETRIES           40      // 50 ms waits for room in the store queue
+#define SMS_GAP_MARKER              "[...]"
+
+struct SmsStats {
+    uint32_t sweeps;
+    uint32_t parts;                 // PDUs decoded
+    uint32_t messages;              // Stored to msg_store
+    uint32_t concatenated;          // Of them, put together from several parts
+    uint32_t partial;               // Parts left waiting after the last sweep
+    uint32_t deleted;               // Slots
+    uint32_t decode_errors;         // Status reports and bad PDUs, deleted unread
+    uint32_t store_failures;        // Kept on the SIM for the next sweep
+    uint32_t overflows;             // Sweeps that found more than SMS_BATCH_MAX parts
+    uint32_t last_sweep_ms;
+    uint32_t max_sweep_ms;
+    uint32_t last_sweep_parts;
+};
+
+/**
+ * @brief Listen for +CMTI and start the periodic check; needs msg_store_begin()
+ */
+bool modem_sms_begin();
+
+/**
+ * @brief Read, store and delete everything on the SIM, in the background
+ * @return false before modem_sms_begin() or if the job pool is full
+ */
+bool modem_sms_sweep();
+
+bool modem_sms_busy();
+
+void modem_sms_get_stats(SmsStats *out);
+
+#endif // MODEM_SMS_H
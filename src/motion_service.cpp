@@ -0,0 +1,255 @@
+/**
+ * @file      motion_service.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Motion context from the BHI260AP detectors, driving GPS and display policy
+ */
+
+#include "motion_service.h"
+#include "simple_logger.h"
+#include "peripheral.h"
+#include "timer_wheel.h"
+#include "usb_console.h"
+#include "lvgl_integration.h"
+#include "bosch/SensorBhy2Define.h"
+#ifdef INTEGRATION_LAYER_ENABLED
+#include "integration/config_manager.h"
+#include "integration/event_bridge.h"
+#endif
+
+#define MOTION_NONE             -1
+
+// Activity recognition: low byte an activity ended, high byte one started
+#define MOTION_AR_BICYCLE_END   0x0008
+#define MOTION_AR_VEHICLE_END   0x0010
+#define MOTION_AR_BICYCLE_START 0x0800
+#define MOTION_AR_VEHICLE_START 0x1000
+#define MOTION_AR_RIDE_START    (MOTION_AR_BICYCLE_START | MOTION_AR_VEHICLE_START)
+#define MOTION_AR_RIDE_END      (MOTION_AR_BICYCLE_END | MOTION_AR_VEHICLE_END)
+
+static const char *const state_names[MOTION_STATE_COUNT] = { "unknown", "still", "moving", "fast" };
+
+// Hub task and timer task decide, the UI task takes the change
+static MotionState state = MOTION_UNKNOWN;
+static uint32_t state_since = 0;
+static bool held = false;
+static bool riding = false;                 // Activity recognition: bicycle or vehicle
+static uint32_t slow_since = 0;             // Under MOTION_SLOW_KMH while fast, 0 if not
+static uint32_t last_steps = 0;
+static bool steps_seen = false;
+static volatile int8_t pending_ui = MOTION_NONE;
+static MotionStats motion_stats;
+static portMUX_TYPE motion_mux = portMUX_INITIALIZER_UNLOCKED;
+static WheelTimer speed_timer;
+static bool started = false;
+static bool gps_policy = true;
+static uint16_t fast_kmh = MOTION_FAST_KMH;
+
+// ===== Policy =====
+
+// Detectors armed in turn: any motion only while still, the rest only
+// while not, so neither keeps interrupting in the state it confirms
+static void arm_detectors(bool still) {
+    BHI260AP_set_sensor(SENSOR_ID_ANY_MOTION_WU, still ? 1 : 0, 0);
+    BHI260AP_set_sensor(SENSOR_ID_STATIONARY_DET, still ? 0 : 1, 0);
+    BHI260AP_set_sensor(SENSOR_ID_AR, still ? 0 : 1, 0);
+    if (still) {
+        timer_wheel_cancel(&speed_timer);
+    } else {
+        timer_wheel_arm(&speed_timer, MOTION_SPEED_CHECK_MS, MOTION_SPEED_CHECK_MS);
+    }
+}
+
+static void publish(MotionState prev, MotionState next, MotionCause cause) {
+#ifdef INTEGRATION_LAYER_ENABLED
+    if (GlobalEventBridge) {
+        MotionStateEvent ev = {};
+        ev.state = next;
+        ev.previous = prev;
+        ev.cause = cause;
+        ev.speed_kmh_x10 = motion_stats.speed_kmh_x10;
+        ev.steps = motion_stats.steps;
+        GlobalEventBridge->publishTypedEvent(EventType::MOTION_STATE, "Motion", ev);
+    }
+#endif
+}
+
+static void enter(MotionState next, MotionCause cause) {
+    uint32_t now = millis();
+    portENTER_CRITICAL(&motion_mux);
+    MotionState prev = state;
+    if (next == prev || (held && cause != MOTION_CAUSE_CONSOLE)) {
+        portEXIT_CRITICAL(&motion_mux);
+        return;
+    }
+    motion_stats.time_ms[prev] += now - state_since;
+    motion_stats.changes++;
+    state = next;
+    state_since = now;
+    slow_since = 0;
+    pending_ui = next;
+    portEXIT_CRITICAL(&motion_mux);
+
+    bool still = next == MOTION_STATIONARY;
+    if (still != (prev == MOTION_STATIONARY)) {
+        arm_detectors(still);
+    }
+    if (gps_policy) {
+        gps_power_scale(still ? 0 : next == MOTION_FAST ? MOTION_FAST_GPS_PCT : 100);
+    }
+    if (LVGL) {
+        LVGL->wake();
+    }
+    LOG_INFOF("Motion", "%s -> %s", state_names[prev], state_names[next]);
+    publish(prev, next, cause);
+}
+
+// ===== Inputs =====
+
+static void on_hub_event(uint8_t sensor_id, uint32_t value) {
+    switch (sensor_id) {
+        case SENSOR_ID_STATIONARY_DET:
+            motion_stats.stationary_events++;
+            riding = false;
+            enter(MOTION_STATIONARY, MOTION_CAUSE_STATIONARY);
+            break;
+        case SENSOR_ID_ANY_MOTION_WU:
+        case SENSOR_ID_SIG_HW_WU:
+            motion_stats.motion_events++;
+            if (state == MOTION_STATIONARY || state == MOTION_UNKNOWN) {
+                enter(MOTION_MOVING, sensor_id == SENSOR_ID_ANY_MOTION_WU ? MOTION_CAUSE_ANY_MOTION
+                                                                           : MOTION_CAUSE_SIGNIFICANT);
+            }
+            break;
+        case SENSOR_ID_STC_WU:
+            motion_stats.steps = value;
+            // The first report is the count so far, not a step
+            if (steps_seen && value != last_steps &&
+                (state == MOTION_STATIONARY || state == MOTION_UNKNOWN)) {
+                enter(MOTION_MOVING, MOTION_CAUSE_STEPS);
+            }
+            steps_seen = true;
+            last_steps = value;
+            break;
+        case SENSOR_ID_AR:
+            motion_stats.activity_events++;
+            if (value & MOTION_AR_RIDE_START) {
+                riding = true;
+                enter(MOTION_FAST, MOTION_CAUSE_ACTIVITY);
+            } else if (value & MOTION_AR_RIDE_END) {
+                // The speed check ends it once the GPS agrees
+                riding = false;
+            }
+            break;
+    }
+}
+
+static void speed_check(WheelTimer *timer) {
+    gps_fix_t fix;
+    gps_get_fix(&fix);
+    uint32_t now = millis();
+    if (!fix.valid || now - fix.time_ms > 2 * MOTION_SPEED_CHECK_MS) {
+        return;
+    }
+    motion_stats.speed_kmh_x10 = (uint16_t)constrain(fix.speed * 10, 0, UINT16_MAX);
+
+    if (fix.speed >= fast_kmh) {
+        if (state == MOTION_MOVING || state == MOTION_UNKNOWN) {
+            enter(MOTION_FAST, MOTION_CAUSE_SPEED);
+        }
+        slow_since = 0;
+    } else if (state == MOTION_FAST && !riding && fix.speed < MOTION_SLOW_KMH) {
+        if (!slow_since) {
+            slow_since = now;
+        } else if (now - slow_since >= MOTION_FAST_HOLD_MS) {
+            enter(MOTION_MOVING, MOTION_CAUSE_SPEED);
+        }
+    } else {
+        slow_since = 0;
+    }
+}
+
+// ===== API =====
+
+MotionState motion_state() {
+    return state;
+}
+
+bool motion_take(uint8_t *out) {
+    int8_t s = pending_ui;
+    if (s == MOTION_NONE) {
+        return false;
+    }
+    pending_ui = MOTION_NONE;
+    *out = s;
+    return true;
+}
+
+void motion_get_stats(MotionStats *out) {
+    portENTER_CRITICAL(&motion_mux);
+    *out = motion_stats;
+    out->state = state;
+    out->held = held;
+    out->time_ms[state] += millis() - state_since;
+    portEXIT_CRITICAL(&motion_mux);
+}
+
+static void rpc_motion(Print &out, const char *args) {
+    if (args[0]) {
+        int s = MOTION_STATE_COUNT;
+        for (int i = MOTION_STATIONARY; i < MOTION_STATE_COUNT; i++) {
+            if (!strcmp(args, state_names[i])) {
+                s = i;
+            }
+        }
+        if (!strcmp(args, "auto")) {
+            held = false;
+            out.println("ok");
+        } else if (s < MOTION_STATE_COUNT) {
+            held = true;
+            enter((MotionState)s, MOTION_CAUSE_CONSOLE);
+            out.println("ok, held");
+        } else {
+            out.println("usage: motion [still | moving | fast | auto]");
+        }
+        return;
+    }
+    MotionStats m;
+    motion_get_stats(&m);
+    out.printf("%s%s, %lu changes, %u.%u km/h, %lu steps\n", state_names[m.state], m.held ? " (held)" : "",
+               (unsigned long)m.changes, m.speed_kmh_x10 / 10, m.speed_kmh_x10 % 10, (unsigned long)m.steps);
+    out.printf("events: stationary %lu, motion %lu, activity %lu\n", (unsigned long)m.stationary_events,
+               (unsigned long)m.motion_events, (unsigned long)m.activity_events);
+    out.printf("time s: still %lu, moving %lu, fast %lu, unknown %lu\n",
+               (unsigned long)(m.time_ms[MOTION_STATIONARY] / 1000), (unsigned long)(m.time_ms[MOTION_MOVING] / 1000),
+               (unsigned long)(m.time_ms[MOTION_FAST] / 1000), (unsigned long)(m.time_ms[MOTION_UNKNOWN] / 1000));
+}
+
+bool motion_begin() {
+    if (started) {
+        return true;
+    }
+#ifdef INTEGRATION_LAYER_ENABLED
+    if (!GET_CONFIG_BOOL("motion", "enabled", true)) {
+        LOG_INFO("Motion", "Motion policy disabled in config");
+        return false;
+    }
+    gps_policy = GET_CONFIG_BOOL("motion", "gps", true);
+    fast_kmh = GET_CONFIG_INT("motion", "fast_kmh", MOTION_FAST_KMH);
+#endif
+    if (!peri_init_ensure(E_PERI_BHI260AP) && !BHI260AP_init()) {
+        LOG_WARN("Motion", "No BHI260AP, GPS and display keep their rates");
+        return false;
+    }
+    started = true;
+    state_since = millis();
+    timer_wheel_init(&speed_timer, "motion", speed_check);
+    BHI260AP_set_event_cb(on_hub_event);
+    // Unknown counts as moving until the hub says otherwise
+    arm_detectors(false);
+    usb_console_rpc("motion", rpc_motion);
+    LOG_INFO("Motion", "Watching for motion");
+    return true;
+}
@@ -0,0 +1,103 @@
+/**
+ * @file      motion_service.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Motion context from the BHI260AP detectors, driving GPS and display policy
+ */
+
+#ifndef MOTION_SERVICE_H
+#define MOTION_SERVICE_H
+
+#include <Arduino.h>
+
+/**
+ * Runs off the sensor hub's own detectors, delivered by its interrupt;
+ * the host never samples the accelerometer for this. Stationary detect
+ * and any-motion are armed in turn, so a device on a desk or in a pocket
+ * wakes the CPU once per change rather than per sample: only stationary
+ * detect while moving, only any-motion while still. Significant motion
+ * and new steps also count as moving.
+ *
+ * Moving fast: activity recognition reporting a bicycle or a vehicle, or
+ * a GPS fix at fast_kmh or more, checked every MOTION_SPEED_CHECK_MS while
+ * moving. It ends with the activity, once the speed has stayed under
+ * MOTION_SLOW_KMH for MOTION_FAST_HOLD_MS.
+ *
+ * Each change goes out as EventType::MOTION_STATE with a
+ * MotionStateEvent, and the policy follows it:
+ *  - GPS: background consumers (track, geofence, apps) are parked while
+ *    stationary and get fixes MOTION_FAST_GPS_PCT as far apart while
+ *    moving fast, through gps_power_scale(); the UI's own requests stand
+ *  - display: while moving, ghosted regions wait MOTION_CLEAN_IDLE_MS of
+ *    idle before a cleaning flash, and auto rotation pauses while still
+ *
+ * Console: "motion" for the state and counters, "motion still | moving |
+ * fast" holds a state for testing, "motion auto" lets the sensors decide.
+ * Config section "motion": enabled (true), gps (true), fast_kmh.
+ */
+
+#define MOTION_FAST_KMH             15      // Cycling pace
+#define MOTION_SLOW_KMH             8
+#define MOTION_FAST_HOLD_MS         60000   // Under MOTION_SLOW_KMH this long ends moving fast
+#define MOTION_SPEED_CHECK_MS       10000
+#define MOTION_FAST_GPS_PCT         25      // Background fix intervals while moving fast
+#define MOTION_CLEAN_IDLE_MS        15000
+
+enum MotionState {
+    MOTION_UNKNOWN = 0,             // No detector has spoken; policy as moving
+    MOTION_STATIONARY,
+    MOTION_MOVING,
+    MOTION_FAST,
+    MOTION_STATE_COUNT,
+};
+
+// EventType::MOTION_STATE payload
+struct MotionStateEvent {
+    uint8_t state;                  // MotionState
+    uint8_t previous;
+    uint8_t cause;                  // MotionCause
+    uint16_t speed_kmh_x10;         // Last GPS speed, 0 without a fix
+    uint32_t steps;                 // Hub step counter
+};
+
+enum MotionCause {
+    MOTION_CAUSE_STATIONARY = 0,    // Stationary detect
+    MOTION_CAUSE_ANY_MOTION,
+    MOTION_CAUSE_SIGNIFICANT,
+    MOTION_CAUSE_STEPS,
+    MOTION_CAUSE_ACTIVITY,          // Activity recognition started or ended a ride
+    MOTION_CAUSE_SPEED,
+    MOTION_CAUSE_CONSOLE,
+};
+
+struct MotionStats {
+    uint8_t state;
+    bool held;                      // Set from the console
+    uint32_t changes;
+    uint32_t stationary_events;
+    uint32_t motion_events;         // Any motion and significant motion
+    uint32_t activity_events;
+    uint32_t steps;
+    uint16_t speed_kmh_x10;
+    uint32_t time_ms[MOTION_STATE_COUNT];   // In each state, the current one up to now
+};
+
+/**
+ * @brief Bring up the sensor hub if needed and arm its detectors. Reads the
+ *        "motion" config section. UI task
+ */
+bool motion_begin();
+
+MotionState motion_state();
+
+/**
+ * @brief A state change, once. The UI loop applies the display side with
+ *        LVGLIntegration::setCleanIdle() and auto_rotate_pause()
+ */
+bool motion_take(uint8_t *state);
+
+void motion_get_stats(MotionStats *out);
+
+#endif // MOTION_SERVICE_H
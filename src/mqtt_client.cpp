@@ -0,0 +1,1214 @@
+/**
+ * @file      mqtt_client.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     MQTT client task: connection, outbound pool, QoS1 outbox, telemetry
+ */
+
+#include "mqtt_client.h"
+#include "net_manager.h"
+#include "wg_tunnel.h"
+#include "tls_client.h"
+#include "simple_logger.h"
+#include "radio_sched.h"
+#include <WiFi.h>
+#include <SD.h>
+#include "spi_bus.h"
+#include <esp_rom_crc.h>
+#ifdef INTEGRATION_LAYER_ENABLED
+#include "integration/event_bridge.h"
+#include "integration/config_manager.h"
+#endif
+
+// Control packet types, upper nibble of the fixed header
+#define MQTT_CONNECT        0x10
+#define MQTT_CONNACK        0x20
+#define MQTT_PUBLISH        0x30
+#define MQTT_PUBACK         0x40
+#define MQTT_SUBSCRIBE      0x82    // Reserved flags 0010
+#define MQTT_SUBACK         0x90
+#define MQTT_PINGREQ        0xC0
+#define MQTT_PINGRESP       0xD0
+#define MQTT_DISCONNECT     0xE0
+#define MQTT_FLAG_DUP       0x08
+
+#define MQTT_OUTBOX_MAGIC   0x4D514F42  // "MQOB"
+
+struct MqttBuffer {
+    uint8_t *frame;             // MQTT_FRAME_SIZE bytes
+    uint16_t head;              // First byte of the sealed frame
+    uint16_t end;               // One past the last byte
+    uint16_t payload;           // Payload offset, fixed when the topic goes in
+    uint16_t id_offset;         // Packet identifier, 0 for QoS0
+    uint16_t packet_id;
+    uint8_t qos;
+    uint8_t retain;
+    int8_t slot;                // Outbox slot while in flight, -1 otherwise
+    uint32_t seq;               // Resend order
+    MqttBuffer *next;           // Free list
+};
+
+// On SD as a fixed array of slots, one per in-flight message
+struct MqttOutboxHeader {
+    uint32_t magic;             // 0 marks a free slot
+    uint32_t seq;
+    uint16_t packet_id;
+    uint16_t head;
+    uint16_t end;
+    uint16_t reserved;
+    uint32_t crc;               // Over frame[head..end)
+};
+
+#define MQTT_OUTBOX_SLOT    (sizeof(MqttOutboxHeader) + MQTT_FRAME_SIZE)
+
+struct MqttSubscription {
+    char topic[MQTT_TOPIC_MAX];
+    uint8_t qos;
+    bool sent;                  // In this session
+};
+
+struct MqttTelemetryKey {
+    char key[MQTT_TELEMETRY_KEY_MAX];
+    float value;
+    bool dirty;
+};
+
+static portMUX_TYPE mqtt_mux = portMUX_INITIALIZER_UNLOCKED;
+static MqttBuffer mqtt_pool[MQTT_POOL_BUFFERS];
+static MqttBuffer *mqtt_free = NULL;
+static SemaphoreHandle_t mqtt_pool_sem = NULL;      // Counts free buffers
+static QueueHandle_t mqtt_out = NULL;
+static TaskHandle_t mqtt_task_handle = NULL;
+static volatile bool mqtt_running = false;
+static volatile bool mqtt_link_up = false;
+static volatile bool mqtt_route_changed = false;
+static volatile bool mqtt_suspended = false;
+static volatile bool mqtt_resumed = false;      // Set by mqtt_suspend(), the task resets its backoff
+static volatile uint32_t mqtt_loops = 0;
+static MqttStats mqtt_stat;
+
+// Task-only state
+static WiFiClient mqtt_tcp;
+static TlsClient mqtt_tls;
+static WiFiClient *mqtt_client = &mqtt_tcp;
+static MqttBuffer *mqtt_inflight[MQTT_INFLIGHT_MAX];
+static uint16_t mqtt_next_id = 1;
+static uint32_t mqtt_next_seq = 1;
+static File mqtt_outbox;
+static uint8_t mqtt_rx[MQTT_RX_BUFFER];
+static size_t mqtt_rx_len = 0;
+static uint32_t mqtt_last_tx = 0;
+static uint32_t mqtt_last_rx = 0;
+static bool mqtt_ping_pending = false;
+static uint32_t mqtt_backoff_ms = MQTT_BACKOFF_MIN_MS;
+static uint32_t mqtt_next_attempt = 0;
+static uint32_t mqtt_next_batch = 0;
+
+// Guarded by mqtt_mux
+static MqttSubscription mqtt_subs[MAX_MQTT_SUBSCRIPTIONS];
+static uint8_t mqtt_sub_count = 0;
+static MqttTelemetryKey mqtt_telemetry[MQTT_TELEMETRY_KEYS];
+static uint8_t mqtt_telemetry_count = 0;
+static uint32_t mqtt_telemetry_ms = MQTT_TELEMETRY_INTERVAL_MS;
+// Keepalive pings and telemetry batches go out in shared radio windows
+static int mqtt_radio_ping = -1;
+static int mqtt_radio_telemetry = -1;
+static volatile bool mqtt_ping_due = false;
+static volatile bool mqtt_telemetry_due = false;
+static mqtt_message_cb mqtt_msg_cb = NULL;
+static void *mqtt_msg_ctx = NULL;
+
+struct MqttTopicHandler {
+    char topic[MQTT_TOPIC_MAX];
+    mqtt_message_cb cb;
+    void *ctx;
+};
+
+static MqttTopicHandler mqtt_topic_handlers[MQTT_TOPIC_HANDLERS];
+static uint8_t mqtt_topic_handler_count = 0;
+
+// Set once in mqtt_begin
+static String mqtt_host;
+static uint16_t mqtt_port = 1883;
+static String mqtt_user;
+static String mqtt_password;
+static char mqtt_device[13] = {0};
+static char mqtt_status_topic[MQTT_TOPIC_MAX];
+static char mqtt_telemetry_topic[MQTT_TOPIC_MAX];
+
+static inline void put16(uint8_t *p, uint16_t v) {
+    p[0] = v >> 8;
+    p[1] = v & 0xFF;
+}
+
+static inline uint16_t get16(const uint8_t *p) {
+    return ((uint16_t)p[0] << 8) | p[1];
+}
+
+// Remaining length; returns the bytes used
+static size_t encode_length(uint8_t *out, size_t len) {
+    size_t n = 0;
+    do {
+        uint8_t b = len & 0x7F;
+        len >>= 7;
+        out[n++] = b | (len ? 0x80 : 0);
+    } while (len);
+    return n;
+}
+
+// 0 while incomplete, -1 on a malformed length
+static int decode_length(const uint8_t *in, size_t avail, size_t *len) {
+    size_t value = 0;
+    for (int i = 0; i < 4; i++) {
+        if ((size_t)i >= avail) {
+            return 0;
+        }
+        value |= (size_t)(in[i] & 0x7F) << (7 * i);
+        if (!(in[i] & 0x80)) {
+            *len = value;
+            return i + 1;
+        }
+    }
+    return -1;
+}
+
+// Pool
+
+static MqttBuffer *pool_take(uint32_t wait_ms) {
+    if (!mqtt_pool_sem || xSemaphoreTake(mqtt_pool_sem, pdMS_TO_TICKS(wait_ms)) != pdTRUE) {
+        return NULL;
+    }
+    portENTER_CRITICAL(&mqtt_mux);
+    MqttBuffer *buf = mqtt_free;
+    mqtt_free = buf->next;
+    portEXIT_CRITICAL(&mqtt_mux);
+    buf->next = NULL;
+    buf->slot = -1;
+    buf->id_offset = 0;
+    buf->packet_id = 0;
+    return buf;
+}
+
+void mqtt_buffer_release(MqttBuffer *buf) {
+    if (!buf) {
+        return;
+    }
+    portENTER_CRITICAL(&mqtt_mux);
+    buf->next = mqtt_free;
+    mqtt_free = buf;
+    portEXIT_CRITICAL(&mqtt_mux);
+    xSemaphoreGive(mqtt_pool_sem);
+}
+
+MqttBuffer *mqtt_buffer_acquire(const char *topic, uint8_t qos, bool retain, uint32_t wait_ms) {
+    size_t topic_len = topic ? strlen(topic) : 0;
+    if (topic_len == 0 || topic_len > MQTT_TOPIC_MAX || qos > 1) {
+        return NULL;
+    }
+    MqttBuffer *buf = pool_take(wait_ms);
+    if (!buf) {
+        portENTER_CRITICAL(&mqtt_mux);
+        mqtt_stat.pool_exhausted++;
+        portEXIT_CRITICAL(&mqtt_mux);
+        return NULL;
+    }
+    
+    // Variable header right after the headroom, the fixed header is prepended on seal
+    uint8_t *p = buf->frame + MQTT_FRAME_HEADROOM;
+    put16(p, topic_len);
+    memcpy(p + 2, topic, topic_len);
+    p += 2 + topic_len;
+    if (qos) {
+        buf->id_offset = p - buf->frame;
+        p += 2;
+    }
+    buf->qos = qos;
+    buf->retain = retain;
+    buf->payload = p - buf->frame;
+    buf->end = buf->payload;
+    return buf;
+}
+
+uint8_t *mqtt_buffer_payload(MqttBuffer *buf, size_t *capacity) {
+    if (!buf) {
+        return NULL;
+    }
+    if (capacity) {
+        *capacity = MQTT_FRAME_SIZE - buf->payload;
+    }
+    return buf->frame + buf->payload;
+}
+
+bool mqtt_publish_buffer(MqttBuffer *buf, size_t payload_len) {
+    if (!buf) {
+        return false;
+    }
+    if (!mqtt_running || payload_len > (size_t)(MQTT_FRAME_SIZE - buf->payload)) {
+        mqtt_buffer_release(buf);
+        return false;
+    }
+    buf->end = buf->payload + payload_len;
+    
+    // Seal: fixed header and remaining length end right where the topic starts
+    uint8_t len[4];
+    size_t n = encode_length(len, buf->end - MQTT_FRAME_HEADROOM);
+    buf->head = MQTT_FRAME_HEADROOM - 1 - n;
+    buf->frame[buf->head] = MQTT_PUBLISH | (buf->qos << 1) | (buf->retain ? 1 : 0);
+    memcpy(buf->frame + buf->head + 1, len, n);
+    
+    if (xQueueSend(mqtt_out, &buf, 0) != pdTRUE) {
+        mqtt_buffer_release(buf);
+        return false;
+    }
+    xTaskNotifyGive(mqtt_task_handle);
+    return true;
+}
+
+bool mqtt_publish(const char *topic, const void *data, size_t len, uint8_t qos, bool retain) {
+    MqttBuffer *buf = mqtt_buffer_acquire(topic, qos, retain);
+    size_t capacity;
+    uint8_t *payload = mqtt_buffer_payload(buf, &capacity);
+    if (!payload) {
+        return false;
+    }
+    if (len > capacity) {
+        mqtt_buffer_release(buf);
+        return false;
+    }
+    memcpy(payload, data, len);
+    return mqtt_publish_buffer(buf, len);
+}
+
+// Outbox
+
+static void outbox_write(MqttBuffer *buf) {
+    if (!mqtt_outbox) {
+        return;
+    }
+    MqttOutboxHeader h = {};
+    h.magic = MQTT_OUTBOX_MAGIC;
+    h.seq = buf->seq;
+    h.packet_id = buf->packet_id;
+    h.head = buf->head;
+    h.end = buf->end;
+    h.crc = esp_rom_crc32_le(0, buf->frame + buf->head, buf->end - buf->head);
+    
+    // Frame first, the header makes the slot live
+    SpiBusHold bus(SPI_CLIENT_SD);
+    mqtt_outbox.seek(buf->slot * MQTT_OUTBOX_SLOT + sizeof(h));
+    mqtt_outbox.write(buf->frame + buf->head, buf->end - buf->head);
+    mqtt_outbox.seek(buf->slot * MQTT_OUTBOX_SLOT);
+    mqtt_outbox.write((const uint8_t *)&h, sizeof(h));
+    mqtt_outbox.flush();
+}
+
+static void outbox_clear(int slot) {
+    if (!mqtt_outbox) {
+        return;
+    }
+    uint32_t magic = 0;
+    SpiBusHold bus(SPI_CLIENT_SD);
+    mqtt_outbox.seek(slot * MQTT_OUTBOX_SLOT);
+    mqtt_outbox.write((const uint8_t *)&magic, sizeof(magic));
+    mqtt_outbox.flush();
+}
+
+static void outbox_open() {
+    SpiBusHold bus(SPI_CLIENT_SD);
+    if (SD.cardType() == CARD_NONE || !(SD.exists(MQTT_OUTBOX_DIR) || SD.mkdir(MQTT_OUTBOX_DIR))) {
+        LOG_WARN("MQTT", "No SD card, QoS1 messages are kept in RAM only");
+        return;
+    }
+    if (!SD.exists(MQTT_OUTBOX_FILE)) {
+        File f = SD.open(MQTT_OUTBOX_FILE, FILE_WRITE);
+        if (!f) {
+            LOG_ERROR("MQTT", "Cannot create the outbox");
+            return;
+        }
+        uint8_t zero[sizeof(MqttOutboxHeader)] = {0};
+        for (int i = 0; i < MQTT_INFLIGHT_MAX; i++) {
+            f.seek(i * MQTT_OUTBOX_SLOT);
+            f.write(zero, sizeof(zero));
+        }
+        f.close();
+    }
+    mqtt_outbox = SD.open(MQTT_OUTBOX_FILE, "r+");
+    if (!mqtt_outbox) {
+        LOG_ERROR("MQTT", "Cannot open the outbox");
+        return;
+    }
+    mqtt_stat.persistent = true;
+    
+    // Messages a previous boot never got acknowledged
+    for (int i = 0; i < MQTT_INFLIGHT_MAX; i++) {
+        MqttOutboxHeader h;
+        mqtt_outbox.seek(i * MQTT_OUTBOX_SLOT);
+        if (mqtt_outbox.read((uint8_t *)&h, sizeof(h)) != sizeof(h) || h.magic != MQTT_OUTBOX_MAGIC) {
+            continue;
+        }
+        MqttBuffer *buf = h.end <= MQTT_FRAME_SIZE && h.head < h.end ? pool_take(0) : NULL;
+        if (!buf) {
+            outbox_clear(i);
+            continue;
+        }
+        size_t n = h.end - h.head;
+        if (mqtt_outbox.read(buf->frame + h.head, n) != n ||
+            esp_rom_crc32_le(0, buf->frame + h.head, n) != h.crc) {
+            mqtt_buffer_release(buf);
+            outbox_clear(i);
+            continue;
+        }
+        buf->head = h.head;
+        buf->end = h.end;
+        buf->qos = 1;
+        buf->packet_id = h.packet_id;
+        buf->seq = h.seq;
+        buf->slot = i;
+        mqtt_inflight[i] = buf;
+        if (h.seq >= mqtt_next_seq) {
+            mqtt_next_seq = h.seq + 1;
+        }
+        if (h.packet_id >= mqtt_next_id) {
+            mqtt_next_id = h.packet_id + 1;
+        }
+        mqtt_stat.restored++;
+        mqtt_stat.inflight++;
+    }
+    if (mqtt_stat.restored) {
+        LOG_INFOF("MQTT", "Restored %lu unacknowledged messages", mqtt_stat.restored);
+    }
+}
+
+// In flight
+
+static bool packet_id_used(uint16_t id) {
+    for (int i = 0; i < MQTT_INFLIGHT_MAX; i++) {
+        if (mqtt_inflight[i] && mqtt_inflight[i]->packet_id == id) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static uint16_t next_packet_id() {
+    uint16_t id;
+    do {
+        id = mqtt_next_id++;
+    } while (id == 0 || packet_id_used(id));
+    return id;
+}
+
+static bool inflight_add(MqttBuffer *buf) {
+    int slot = -1;
+    for (int i = 0; i < MQTT_INFLIGHT_MAX; i++) {
+        if (!mqtt_inflight[i]) {
+            slot = i;
+            break;
+        }
+    }
+    if (slot < 0) {
+        return false;
+    }
+    buf->packet_id = next_packet_id();
+    put16(buf->frame + buf->id_offset, buf->packet_id);
+    buf->seq = mqtt_next_seq++;
+    buf->slot = slot;
+    mqtt_inflight[slot] = buf;
+    outbox_write(buf);
+    portENTER_CRITICAL(&mqtt_mux);
+    mqtt_stat.inflight++;
+    portEXIT_CRITICAL(&mqtt_mux);
+    return true;
+}
+
+static void inflight_ack(uint16_t id) {
+    for (int i = 0; i < MQTT_INFLIGHT_MAX; i++) {
+        MqttBuffer *buf = mqtt_inflight[i];
+        if (buf && buf->packet_id == id) {
+            mqtt_inflight[i] = NULL;
+            outbox_clear(i);
+            mqtt_buffer_release(buf);
+            portENTER_CRITICAL(&mqtt_mux);
+            mqtt_stat.inflight--;
+            mqtt_stat.puback++;
+            portEXIT_CRITICAL(&mqtt_mux);
+            return;
+        }
+    }
+}
+
+// Wire
+
+static bool send_raw(const uint8_t *data, size_t len) {
+    if (mqtt_client->write(data, len) != len) {
+        return false;
+    }
+    mqtt_last_tx = millis();
+    return true;
+}
+
+static bool send_frame(MqttBuffer *buf, bool dup) {
+    if (dup) {
+        buf->frame[buf->head] |= MQTT_FLAG_DUP;
+    }
+    if (!send_raw(buf->frame + buf->head, buf->end - buf->head)) {
+        return false;
+    }
+    portENTER_CRITICAL(&mqtt_mux);
+    mqtt_stat.tx_publish++;
+    if (dup) {
+        mqtt_stat.resent++;
+    }
+    portEXIT_CRITICAL(&mqtt_mux);
+    return true;
+}
+
+static void publish_event_disconnected(uint32_t reason) {
+#ifdef INTEGRATION_LAYER_ENABLED
+    if (GlobalEventBridge) {
+        GlobalEventBridge->tryPublish(EventType::MQTT_DISCONNECTED, "MQTT", reason, EventPriority::EVENT_HIGH);
+    }
+#endif
+}
+
+static void drop_connection(const char *why) {
+    if (!mqtt_link_up && !mqtt_client->connected()) {
+        return;
+    }
+    mqtt_client->stop();
+    mqtt_rx_len = 0;
+    bool was_up = mqtt_link_up;
+    mqtt_link_up = false;
+    if (was_up) {
+        LOG_WARNF("MQTT", "Disconnected: %s", why);
+        mqtt_stat.disconnects++;
+        publish_event_disconnected(mqtt_stat.disconnects);
+    }
+    mqtt_next_attempt = millis() + mqtt_backoff_ms;
+}
+
+static void deliver(const uint8_t *body, size_t len, uint8_t flags) {
+    if (len < 2) {
+        return;
+    }
+    size_t topic_len = get16(body);
+    uint8_t qos = (flags >> 1) & 0x03;
+    size_t offset = 2 + topic_len + (qos ? 2 : 0);
+    if (offset > len || topic_len >= MQTT_TOPIC_MAX) {
+        return;
+    }
+    char topic[MQTT_TOPIC_MAX];
+    memcpy(topic, body + 2, topic_len);
+    topic[topic_len] = '\0';
+    const uint8_t *payload = body + offset;
+    size_t payload_len = len - offset;
+    
+    if (qos == 1) {
+        uint8_t ack[4] = {MQTT_PUBACK, 2, body[2 + topic_len], body[3 + topic_len]};
+        send_raw(ack, sizeof(ack));
+    }
+    mqtt_stat.rx_publish++;
+    radio_sched_activity();
+    
+    portENTER_CRITICAL(&mqtt_mux);
+    mqtt_message_cb cb = mqtt_msg_cb;
+    void *ctx = mqtt_msg_ctx;
+    portEXIT_CRITICAL(&mqtt_mux);
+    if (cb) {
+        cb(topic, payload, payload_len, ctx);
+    }
+    for (uint8_t i = 0; i < mqtt_topic_handler_count; i++) {
+        if (!strcmp(mqtt_topic_handlers[i].topic, topic)) {
+            mqtt_topic_handlers[i].cb(topic, payload, payload_len, mqtt_topic_handlers[i].ctx);
+        }
+    }
+#ifdef INTEGRATION_LAYER_ENABLED
+    if (GlobalEventBridge) {
+        MqttMessageEvent ev = {};
+        memcpy(ev.topic, topic, topic_len + 1);
+        ev.len = payload_len;
+        memcpy(ev.data, payload, payload_len < sizeof(ev.data) ? payload_len : sizeof(ev.data));
+        GlobalEventBridge->publishTypedEvent(EventType::MQTT_MESSAGE_RECEIVED, "MQTT", ev);
+    }
+#endif
+}
+
+// Returns the CONNACK return code when one arrives, -1 otherwise
+static int handle_packet(uint8_t type, const uint8_t *body, size_t len) {
+    switch (type & 0xF0) {
+        case MQTT_CONNACK:
+            if (len >= 2) {
+                return body[1] | ((body[0] & 0x01) << 8);  // Session present above the code
+            }
+            break;
+        case MQTT_PUBLISH:
+            deliver(body, len, type & 0x0F);
+            break;
+        case MQTT_PUBACK:
+            if (len >= 2) {
+                inflight_ack(get16(body));
+            }
+            break;
+        case MQTT_SUBACK:
+            if (len >= 3 && body[2] == 0x80) {
+                LOG_WARNF("MQTT", "Subscription %u refused", get16(body));
+            }
+            break;
+        case MQTT_PINGRESP:
+            mqtt_ping_pending = false;
+            break;
+        default:
+            break;
+    }
+    return -1;
+}
+
+static int poll_rx() {
+    int connack = -1;
+    int avail;
+    while ((avail = mqtt_client->available()) > 0) {
+        size_t room = sizeof(mqtt_rx) - mqtt_rx_len;
+        int n = mqtt_client->read(mqtt_rx + mqtt_rx_len, (size_t)avail < room ? avail : room);
+        if (n <= 0) {
+            break;
+        }
+        mqtt_rx_len += n;
+        mqtt_last_rx = millis();
+    
+        size_t off = 0;
+        while (mqtt_rx_len - off >= 2) {
+            size_t body_len;
+            int n_len = decode_length(mqtt_rx + off + 1, mqtt_rx_len - off - 1, &body_len);
+            if (n_len == 0) {
+                break;
+            }
+            size_t total = 1 + n_len + body_len;
+            if (n_len < 0 || total > sizeof(mqtt_rx)) {
+                drop_connection("inbound packet too large");
+                return -1;
+            }
+            if (off + total > mqtt_rx_len) {
+                break;
+            }
+            int code = handle_packet(mqtt_rx[off], mqtt_rx + off + 1 + n_len, body_len);
+            if (code >= 0) {
+                connack = code;
+            }
+            off += total;
+        }
+        memmove(mqtt_rx, mqtt_rx + off, mqtt_rx_len - off);
+        mqtt_rx_len -= off;
+    }
+    return connack;
+}
+
+static size_t put_string(uint8_t *p, const char *s, size_t len) {
+    put16(p, len);
+    memcpy(p + 2, s, len);
+    return 2 + len;
+}
+
+static void send_subscriptions() {
+    for (int i = 0; i < MAX_MQTT_SUBSCRIPTIONS; i++) {
+        MqttSubscription sub;
+        portENTER_CRITICAL(&mqtt_mux);
+        bool pending = i < mqtt_sub_count && !mqtt_subs[i].sent;
+        if (pending) {
+            sub = mqtt_subs[i];
+            mqtt_subs[i].sent = true;
+        }
+        portEXIT_CRITICAL(&mqtt_mux);
+        if (!pending) {
+            continue;
+        }
+    
+        uint8_t pkt[8 + MQTT_TOPIC_MAX];
+        size_t topic_len = strlen(sub.topic);
+        size_t body = 2 + 2 + topic_len + 1;
+        size_t n = 0;
+        pkt[n++] = MQTT_SUBSCRIBE;
+        n += encode_length(pkt + n, body);
+        put16(pkt + n, next_packet_id());
+        n += 2;
+        n += put_string(pkt + n, sub.topic, topic_len);
+        pkt[n++] = sub.qos;
+        send_raw(pkt, n);
+    }
+}
+
+static bool connect_broker() {
+    uint32_t start = millis();
+    if (!mqtt_client->connect(mqtt_host.c_str(), mqtt_port, MQTT_CONNECT_TIMEOUT)) {
+        LOG_WARNF("MQTT", "Cannot reach %s:%u", mqtt_host.c_str(), mqtt_port);
+        return false;
+    }
+    if (mqtt_client == &mqtt_tls) {
+        mqtt_tls.setNoDelay(true);
+    } else {
+        mqtt_tcp.setNoDelay(true);
+    }
+    mqtt_rx_len = 0;
+    
+    // Clean session off: the broker keeps subscriptions and our QoS1 state across drops
+    char client_id[24];
+    snprintf(client_id, sizeof(client_id), "tdeckpro-%s", mqtt_device);
+    static const char offline[] = "offline";
+    size_t id_len = strlen(client_id);
+    size_t will_len = strlen(mqtt_status_topic);
+    uint8_t flags = 0x04 | 0x08 | 0x20;     // Will, will QoS1, will retain
+    size_t body = 10 + 2 + id_len + 2 + will_len + 2 + sizeof(offline) - 1;
+    if (mqtt_user.length()) {
+        flags |= 0x80;
+        body += 2 + mqtt_user.length();
+        if (mqtt_password.length()) {
+            flags |= 0x40;
+            body += 2 + mqtt_password.length();
+        }
+    }
+    
+    uint8_t pkt[256];
+    if (body + 5 > sizeof(pkt)) {
+        LOG_ERROR("MQTT", "Credentials too long");
+        mqtt_client->stop();
+        return false;
+    }
+    size_t n = 0;
+    pkt[n++] = MQTT_CONNECT;
+    n += encode_length(pkt + n, body);
+    n += put_string(pkt + n, "MQTT", 4);
+    pkt[n++] = 4;                           // 3.1.1
+    pkt[n++] = flags;
+    put16(pkt + n, MQTT_KEEPALIVE_INTERVAL);
+    n += 2;
+    n += put_string(pkt + n, client_id, id_len);
+    n += put_string(pkt + n, mqtt_status_topic, will_len);
+    n += put_string(pkt + n, offline, sizeof(offline) - 1);
+    if (flags & 0x80) {
+        n += put_string(pkt + n, mqtt_user.c_str(), mqtt_user.length());
+    }
+    if (flags & 0x40) {
+        n += put_string(pkt + n, mqtt_password.c_str(), mqtt_password.length());
+    }
+    if (!send_raw(pkt, n)) {
+        mqtt_client->stop();
+        return false;
+    }
+    
+    int connack = -1;
+    while (connack < 0 && mqtt_client->connected() && millis() - start < MQTT_CONNECT_TIMEOUT) {
+        vTaskDelay(pdMS_TO_TICKS(MQTT_POLL_MS));
+        mqtt_loops++;
+        connack = poll_rx();
+    }
+    if (connack < 0 || (connack & 0xFF) != 0) {
+        LOG_WARNF("MQTT", "Broker refused the connection (%d)", connack);
+        mqtt_client->stop();
+        return false;
+    }
+    bool session_present = connack & 0x100;
+    
+    mqtt_link_up = true;
+    mqtt_last_rx = millis();
+    mqtt_ping_pending = false;
+    mqtt_backoff_ms = MQTT_BACKOFF_MIN_MS;
+    mqtt_stat.connects++;
+    LOG_INFOF("MQTT", "Connected to %s:%u in %lums%s%s", mqtt_host.c_str(), mqtt_port,
+              millis() - start, mqtt_client != &mqtt_tls ? "" : mqtt_tls.resumed() ? ", TLS resumed" : ", TLS",
+              session_present ? ", session resumed" : "");
+    
+    // Without a stored session the broker forgot our subscriptions too
+    portENTER_CRITICAL(&mqtt_mux);
+    for (int i = 0; i < mqtt_sub_count; i++) {
+        if (!session_present) {
+            mqtt_subs[i].sent = false;
+        }
+    }
+    portEXIT_CRITICAL(&mqtt_mux);
+    send_subscriptions();
+    
+    // Everything not acknowledged goes again, oldest first, with DUP
+    uint16_t resend = 0;
+    uint32_t after = 0;
+    for (;;) {
+        MqttBuffer *next = NULL;
+        for (int i = 0; i < MQTT_INFLIGHT_MAX; i++) {
+            MqttBuffer *buf = mqtt_inflight[i];
+            if (buf && buf->seq > after && (!next || buf->seq < next->seq)) {
+                next = buf;
+            }
+        }
+        if (!next) {
+            break;
+        }
+        send_frame(next, true);
+        after = next->seq;
+        resend++;
+    }
+    
+    mqtt_publish(mqtt_status_topic, "online", 6, 1, true);
+
+#ifdef INTEGRATION_LAYER_ENABLED
+    if (GlobalEventBridge) {
+        MqttConnectedEvent ev = {session_present, resend};
+        GlobalEventBridge->publishTypedEvent(EventType::MQTT_CONNECTED, "MQTT", ev, EventPriority::EVENT_HIGH);
+    }
+#endif
+    return true;
+}
+
+static void drain_outbound() {
+    MqttBuffer *buf;
+    bool sent_any = false;
+    while (xQueuePeek(mqtt_out, &buf, 0) == pdTRUE) {
+        // A full window leaves the message queued until a PUBACK frees a slot
+        if (buf->qos && !inflight_add(buf)) {
+            return;
+        }
+        xQueueReceive(mqtt_out, &buf, 0);
+        bool sent = mqtt_link_up && send_frame(buf, false);
+        sent_any |= sent;
+        if (buf->qos) {
+            if (!sent && mqtt_link_up) {
+                drop_connection("write failed");
+            }
+            continue;
+        }
+        if (!sent) {
+            portENTER_CRITICAL(&mqtt_mux);
+            mqtt_stat.dropped++;
+            portEXIT_CRITICAL(&mqtt_mux);
+            if (mqtt_link_up) {
+                drop_connection("write failed");
+            }
+        }
+        mqtt_buffer_release(buf);
+    }
+    if (sent_any) {
+        radio_sched_activity();
+    }
+}
+
+static void flush_telemetry() {
+    portENTER_CRITICAL(&mqtt_mux);
+    uint32_t interval = mqtt_telemetry_ms;
+    portEXIT_CRITICAL(&mqtt_mux);
+    uint32_t now = millis();
+    if (mqtt_radio_telemetry >= 0) {
+        if (!mqtt_telemetry_due) {
+            return;
+        }
+        mqtt_telemetry_due = false;
+    } else if ((int32_t)(now - mqtt_next_batch) < 0) {
+        return;
+    }
+    mqtt_next_batch = now + interval;
+    if (!mqtt_link_up) {
+        return;
+    }
+    
+    MqttBuffer *buf = mqtt_buffer_acquire(mqtt_telemetry_topic);
+    size_t capacity;
+    char *out = (char *)mqtt_buffer_payload(buf, &capacity);
+    if (!out) {
+        return;
+    }
+    
+    // One JSON object straight into the publish buffer; keys that do not fit wait a batch
+    int len = snprintf(out, capacity, "{\"ts\":%lu", (unsigned long)(now / 1000));
+    int keys = 0;
+    portENTER_CRITICAL(&mqtt_mux);
+    for (int i = 0; i < mqtt_telemetry_count; i++) {
+        MqttTelemetryKey *k = &mqtt_telemetry[i];
+        if (!k->dirty) {
+            continue;
+        }
+        int n = snprintf(out + len, capacity - len, ",\"%s\":%g", k->key, k->value);
+        if (n < 0 || (size_t)(len + n + 1) >= capacity) {
+            continue;
+        }
+        len += n;
+        k->dirty = false;
+        keys++;
+    }
+    portEXIT_CRITICAL(&mqtt_mux);
+    if (!keys) {
+        mqtt_buffer_release(buf);
+        return;
+    }
+    out[len++] = '}';
+    if (mqtt_publish_buffer(buf, len)) {
+        mqtt_stat.telemetry_batches++;
+    }
+}
+
+static void keepalive() {
+    uint32_t now = millis();
+    if (now - mqtt_last_rx > MQTT_KEEPALIVE_INTERVAL * 1500UL) {
+        drop_connection("keepalive timeout");
+        return;
+    }
+    // A window asks early; the full interval without traffic is the backstop
+    bool due = mqtt_ping_due || now - mqtt_last_tx >= MQTT_KEEPALIVE_INTERVAL * 1000UL;
+    if (!mqtt_ping_pending && due) {
+        mqtt_ping_due = false;
+        if (now - mqtt_last_tx >= MQTT_PING_IDLE_MS) {
+            static const uint8_t ping[2] = {MQTT_PINGREQ, 0};
+            mqtt_ping_pending = send_raw(ping, sizeof(ping));
+        }
+    }
+}
+
+static void radio_ping(void *ctx) {
+    mqtt_ping_due = true;
+    if (mqtt_task_handle) {
+        xTaskNotifyGive(mqtt_task_handle);
+    }
+}
+
+static void radio_telemetry(void *ctx) {
+    mqtt_telemetry_due = true;
+    if (mqtt_task_handle) {
+        xTaskNotifyGive(mqtt_task_handle);
+    }
+}
+
+static void on_route(int from, int to, void *ctx) {
+    mqtt_route_changed = true;
+    if (mqtt_task_handle) {
+        xTaskNotifyGive(mqtt_task_handle);
+    }
+}
+
+static void mqtt_task(void *param) {
+    while (mqtt_running) {
+        ulTaskNotifyTake(pdTRUE, mqtt_suspended ? portMAX_DELAY :
+                                 pdMS_TO_TICKS(mqtt_link_up ? MQTT_POLL_MS : MQTT_IDLE_MS));
+        mqtt_loops++;
+    
+        // Off the air until resumed; the outbox, subscriptions and queued
+        // publishes wait for the next connect
+        if (mqtt_suspended) {
+            if (mqtt_link_up) {
+                static const uint8_t bye[2] = {MQTT_DISCONNECT, 0};
+                send_raw(bye, sizeof(bye));
+            }
+            drop_connection("suspended");
+            continue;
+        }
+        if (mqtt_resumed) {
+            mqtt_resumed = false;
+            mqtt_backoff_ms = MQTT_BACKOFF_MIN_MS;
+            mqtt_next_attempt = millis();
+        }
+    
+        // A new route means a new source address, the old socket would only time out
+        if (mqtt_route_changed) {
+            mqtt_route_changed = false;
+            drop_connection("route changed");
+            mqtt_next_attempt = millis();
+        }
+    
+        if (mqtt_link_up && !mqtt_client->connected()) {
+            drop_connection("closed by peer");
+        }
+        // VPN-only devices wait for the tunnel instead of connecting in the clear
+        if (!mqtt_link_up && WiFi.status() == WL_CONNECTED && wg_tunnel_uplink_allowed() &&
+            (int32_t)(millis() - mqtt_next_attempt) >= 0) {
+            if (!connect_broker()) {
+                mqtt_next_attempt = millis() + mqtt_backoff_ms;
+                mqtt_backoff_ms = mqtt_backoff_ms * 2 > MQTT_BACKOFF_MAX_MS ? MQTT_BACKOFF_MAX_MS : mqtt_backoff_ms * 2;
+            }
+        }
+    
+        if (mqtt_link_up) {
+            poll_rx();
+            send_subscriptions();
+        }
+        drain_outbound();
+        if (mqtt_link_up) {
+            flush_telemetry();
+            keepalive();
+        }
+    }
+    
+    if (mqtt_link_up) {
+        static const uint8_t bye[2] = {MQTT_DISCONNECT, 0};
+        send_raw(bye, sizeof(bye));
+    }
+    drop_connection("stopped");
+    mqtt_task_handle = NULL;
+    vTaskDelete(NULL);
+}
+
+bool mqtt_begin(const char *host, uint16_t port) {
+    if (mqtt_running) {
+        return true;
+    }
+    
+    mqtt_host = host ? host : "";
+    mqtt_port = port;
+#ifdef INTEGRATION_LAYER_ENABLED
+    mqtt_host = GET_CONFIG_STRING("mqtt", "host", mqtt_host);
+    // TLS: mqtt.ca names a PEM bundle on LittleFS; without one the broker is
+    // not verified, and only with mqtt.tls_insecure
+    bool tls = GET_CONFIG_BOOL("mqtt", "tls", false);
+    if (tls) {
+        String ca = GET_CONFIG_STRING("mqtt", "ca", String(""));
+        if (ca.length()) {
+            if (!mqtt_tls.setCACertFile(ca.c_str())) {
+                return false;
+            }
+        } else if (GET_CONFIG_BOOL("mqtt", "tls_insecure", false)) {
+            mqtt_tls.setInsecure();
+        } else {
+            LOG_ERROR("MQTT", "TLS needs mqtt.ca, or mqtt.tls_insecure");
+            return false;
+        }
+        mqtt_tls.setPersistent(true);
+        mqtt_client = &mqtt_tls;
+        mqtt_port = 8883;
+    }
+    mqtt_port = GET_CONFIG_INT("mqtt", "port", mqtt_port);
+    mqtt_user = GET_CONFIG_STRING("mqtt", "user", String(""));
+    mqtt_password = GET_CONFIG_STRING("mqtt", "password", String(""));
+    mqtt_telemetry_ms = GET_CONFIG_INT("mqtt", "telemetry_interval", MQTT_TELEMETRY_INTERVAL_MS);
+#endif
+    if (!mqtt_host.length()) {
+        LOG_INFO("MQTT", "No broker configured");
+        return false;
+    }
+    
+    uint64_t mac = ESP.getEfuseMac();
+    snprintf(mqtt_device, sizeof(mqtt_device), "%02x%02x%02x%02x%02x%02x",
+             (uint8_t)mac, (uint8_t)(mac >> 8), (uint8_t)(mac >> 16),
+             (uint8_t)(mac >> 24), (uint8_t)(mac >> 32), (uint8_t)(mac >> 40));
+    snprintf(mqtt_status_topic, sizeof(mqtt_status_topic), MQTT_TOPIC_STATUS, mqtt_device);
+    snprintf(mqtt_telemetry_topic, sizeof(mqtt_telemetry_topic), MQTT_TOPIC_TELEMETRY, mqtt_device);
+    
+    if (!mqtt_pool_sem) {
+        uint8_t *frames = (uint8_t *)ps_malloc(MQTT_POOL_BUFFERS * MQTT_FRAME_SIZE);
+        mqtt_pool_sem = xSemaphoreCreateCounting(MQTT_POOL_BUFFERS, MQTT_POOL_BUFFERS);
+        mqtt_out = xQueueCreate(MQTT_QUEUE_DEPTH, sizeof(MqttBuffer *));
+        if (!frames || !mqtt_pool_sem || !mqtt_out) {
+            LOG_ERROR("MQTT", "Out of memory for the publish pool");
+            return false;
+        }
+        for (int i = 0; i < MQTT_POOL_BUFFERS; i++) {
+            mqtt_pool[i].frame = frames + i * MQTT_FRAME_SIZE;
+            mqtt_pool[i].next = i + 1 < MQTT_POOL_BUFFERS ? &mqtt_pool[i + 1] : NULL;
+        }
+        mqtt_free = &mqtt_pool[0];
+        outbox_open();
+    }
+    
+    mqtt_running = true;
+    mqtt_next_batch = millis() + mqtt_telemetry_ms;
+    if (mqtt_radio_ping < 0) {
+        mqtt_radio_ping = radio_sched_add("mqtt_ping", MQTT_KEEPALIVE_INTERVAL * 1000UL,
+                                          MQTT_KEEPALIVE_INTERVAL * 1000UL / 3, radio_ping);
+        mqtt_radio_telemetry = radio_sched_add("telemetry", mqtt_telemetry_ms, mqtt_telemetry_ms / 2,
+                                               radio_telemetry);
+    }
+    if (xTaskCreate(mqtt_task, "mqtt", MQTT_TASK_STACK, NULL, MQTT_TASK_PRIORITY, &mqtt_task_handle) != pdPASS) {
+        LOG_ERROR("MQTT", "Failed to start the MQTT task");
+        mqtt_running = false;
+        return false;
+    }
+    net_manager_on_route(on_route);
+    LOG_INFOF("MQTT", "Client %s for %s:%u", mqtt_device, mqtt_host.c_str(), mqtt_port);
+    return true;
+}
+
+void mqtt_end() {
+    if (!mqtt_running) {
+        return;
+    }
+    mqtt_running = false;
+    xTaskNotifyGive(mqtt_task_handle);
+    while (mqtt_task_handle) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    net_manager_on_route(NULL);
+}
+
+void mqtt_suspend(bool suspend) {
+    if (suspend == mqtt_suspended) {
+        return;
+    }
+    // The backoff is the task's; it resets it when it sees the flag
+    mqtt_resumed = !suspend;
+    mqtt_suspended = suspend;
+    if (mqtt_task_handle) {
+        xTaskNotifyGive(mqtt_task_handle);
+    }
+}
+
+bool mqtt_connected() {
+    return mqtt_link_up;
+}
+
+const char *mqtt_device_id() {
+    return mqtt_device;
+}
+
+bool mqtt_subscribe(const char *topic, uint8_t qos) {
+    if (!topic || strlen(topic) >= MQTT_TOPIC_MAX || qos > 1) {
+        return false;
+    }
+    bool ok = false;
+    portENTER_CRITICAL(&mqtt_mux);
+    for (int i = 0; i < mqtt_sub_count; i++) {
+        if (strcmp(mqtt_subs[i].topic, topic) == 0) {
+            mqtt_subs[i].sent = mqtt_subs[i].sent && mqtt_subs[i].qos == qos;
+            mqtt_subs[i].qos = qos;
+            ok = true;
+            break;
+        }
+    }
+    if (!ok && mqtt_sub_count < MAX_MQTT_SUBSCRIPTIONS) {
+        MqttSubscription *sub = &mqtt_subs[mqtt_sub_count++];
+        strlcpy(sub->topic, topic, sizeof(sub->topic));
+        sub->qos = qos;
+        sub->sent = false;
+        ok = true;
+    }
+    portEXIT_CRITICAL(&mqtt_mux);
+    if (ok && mqtt_task_handle) {
+        xTaskNotifyGive(mqtt_task_handle);
+    }
+    return ok;
+}
+
+void mqtt_on_message(mqtt_message_cb cb, void *ctx) {
+    portENTER_CRITICAL(&mqtt_mux);
+    mqtt_msg_cb = cb;
+    mqtt_msg_ctx = ctx;
+    portEXIT_CRITICAL(&mqtt_mux);
+}
+
+bool mqtt_on_topic(const char *topic, mqtt_message_cb cb, void *ctx) {
+    if (!topic || !cb || strlen(topic) >= MQTT_TOPIC_MAX) {
+        return false;
+    }
+    bool ok = false;
+    portENTER_CRITICAL(&mqtt_mux);
+    if (mqtt_topic_handler_count < MQTT_TOPIC_HANDLERS) {
+        MqttTopicHandler *h = &mqtt_topic_handlers[mqtt_topic_handler_count];
+        strcpy(h->topic, topic);
+        h->cb = cb;
+        h->ctx = ctx;
+        // Published last: deliver() reads the table without the lock
+        mqtt_topic_handler_count++;
+        ok = true;
+    }
+    portEXIT_CRITICAL(&mqtt_mux);
+    return ok;
+}
+
+bool mqtt_telemetry_set(const char *key, float value) {
+    if (!key || strlen(key) >= MQTT_TELEMETRY_KEY_MAX) {
+        return false;
+    }
+    bool ok = false;
+    portENTER_CRITICAL(&mqtt_mux);
+    for (int i = 0; i < mqtt_telemetry_count; i++) {
+        if (strcmp(mqtt_telemetry[i].key, key) == 0) {
+            mqtt_telemetry[i].value = value;
+            mqtt_telemetry[i].dirty = true;
+            ok = true;
+            break;
+        }
+    }
+    if (!ok && mqtt_telemetry_count < MQTT_TELEMETRY_KEYS) {
+        MqttTelemetryKey *k = &mqtt_telemetry[mqtt_telemetry_count++];
+        strlcpy(k->key, key, sizeof(k->key));
+        k->value = value;
+        k->dirty = true;
+        ok = true;
+    }
+    portEXIT_CRITICAL(&mqtt_mux);
+    return ok;
+}
+
+void mqtt_telemetry_interval(uint32_t interval_ms) {
+    portENTER_CRITICAL(&mqtt_mux);
+    mqtt_telemetry_ms = interval_ms;
+    portEXIT_CRITICAL(&mqtt_mux);
+    radio_sched_set_period(mqtt_radio_telemetry, interval_ms, interval_ms / 2);
+}
+
+bool mqtt_bench_run(uint32_t count, size_t payload_len, uint8_t qos, MqttBenchResult *out, uint32_t timeout_ms) {
+    if (!out || !mqtt_link_up || count == 0) {
+        return false;
+    }
+    memset(out, 0, sizeof(*out));
+    char topic[MQTT_TOPIC_MAX];
+    snprintf(topic, sizeof(topic), "tdeckpro/%s/bench", mqtt_device);
+    
+    portENTER_CRITICAL(&mqtt_mux);
+    uint32_t tx_base = mqtt_stat.tx_publish;
+    uint32_t ack_base = mqtt_stat.puback;
+    portEXIT_CRITICAL(&mqtt_mux);
+    
+    uint32_t start = millis();
+    for (uint32_t i = 0; i < count; i++) {
+        MqttBuffer *buf = mqtt_buffer_acquire(topic, qos);
+        if (!buf) {
+            out->pool_waits++;
+            buf = mqtt_buffer_acquire(topic, qos, false, timeout_ms);
+        }
+        size_t capacity;
+        uint8_t *payload = mqtt_buffer_payload(buf, &capacity);
+        if (!payload) {
+            break;
+        }
+        size_t len = payload_len < capacity ? payload_len : capacity;
+        memset(payload, 'a' + (i % 26), len);
+        if (len >= 4) {
+            memcpy(payload, &i, 4);
+        }
+        if (!mqtt_publish_buffer(buf, len)) {
+            break;
+        }
+        out->messages++;
+    }
+    
+    // Wait for the task to put everything on the wire, and for the broker's acks
+    uint32_t sent = 0;
+    uint32_t acked = 0;
+    while (millis() - start < timeout_ms && mqtt_link_up) {
+        portENTER_CRITICAL(&mqtt_mux);
+        sent = mqtt_stat.tx_publish - tx_base;
+        acked = mqtt_stat.puback - ack_base;
+        portEXIT_CRITICAL(&mqtt_mux);
+        if (sent >= out->messages && !out->send_ms) {
+            out->send_ms = millis() - start;
+        }
+        if (sent >= out->messages && (qos == 0 || acked >= out->messages)) {
+            break;
+        }
+        vTaskDelay(pdMS_TO_TICKS(5));
+    }
+    out->acked = qos ? acked : 0;
+    if (qos && acked >= out->messages) {
+        out->ack_ms = millis() - start;
+    }
+    uint32_t ms = qos ? out->ack_ms : out->send_ms;
+    if (ms) {
+        out->msgs_per_s = (uint64_t)out->messages * 1000 / ms;
+        out->bytes_per_s = (uint64_t)out->messages * payload_len * 1000 / ms;
+    }
+    LOG_INFOF("MQTT", "Bench %lu x %u B QoS%u: %lu msg/s, %lu B/s, %lu pool waits",
+              out->messages, (unsigned)payload_len, qos, out->msgs_per_s, out->bytes_per_s, out->pool_waits);
+    return out->messages == count && ms != 0;
+}
+
+const MqttStats *mqtt_stats() {
+    return &mqtt_stat;
+}
+
+uint32_t mqtt_heartbeat() {
+    return mqtt_loops;
+}
@@ -0,0 +1,162 @@
+/**
+ * @file      mqtt_client.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     MQTT 3.1.1 client: own network task, pooled zero-copy publish,
+ *            batched telemetry and a QoS1 outbox that survives reconnects
+ */
+
+#ifndef MQTT_CLIENT_H
+#define MQTT_CLIENT_H
+
+#include <Arduino.h>
+#include "config/os_config.h"
+
+// Publish buffers, in PSRAM. A frame is built in place, the task writes it out as is
+#define MQTT_POOL_BUFFERS           16
+#define MQTT_TOPIC_MAX              96
+#define MQTT_FRAME_HEADROOM         5     // Fixed header and the longest remaining length
+#define MQTT_FRAME_SIZE             (MQTT_FRAME_HEADROOM + 2 + MQTT_TOPIC_MAX + 2 + MAX_MQTT_MESSAGE_SIZE)
+#define MQTT_RX_BUFFER              1024  // Largest inbound packet, bigger ones drop the connection
+
+// QoS1 messages stay in flight until PUBACK; each one has a slot in the outbox file
+#define MQTT_INFLIGHT_MAX           8
+#define MQTT_OUTBOX_DIR             "/mqtt"
+#define MQTT_OUTBOX_FILE            "/mqtt/outbox.bin"
+
+// Telemetry keys are batched into one publish on MQTT_TOPIC_TELEMETRY per interval
+#define MQTT_TELEMETRY_KEYS         24
+#define MQTT_TELEMETRY_KEY_MAX      16
+#define MQTT_TELEMETRY_INTERVAL_MS  30000
+#define MQTT_TOPIC_HANDLERS         4     // mqtt_on_topic() takers
+
+// Task
+#define MQTT_QUEUE_DEPTH            MQTT_POOL_BUFFERS
+#define MQTT_POLL_MS                20    // Socket poll while connected
+#define MQTT_IDLE_MS                1000  // Wake-up while disconnected
+#define MQTT_PING_IDLE_MS           20000 // An early ping is skipped when something went out since
+#define MQTT_BACKOFF_MIN_MS         1000
+#define MQTT_BACKOFF_MAX_MS         60000
+#define MQTT_TASK_PRIORITY          (tskIDLE_PRIORITY + 2)
+#define MQTT_TASK_STACK             (1024 * 8)  // Room for a TLS handshake
+
+struct MqttBuffer;
+
+struct MqttStats {
+    uint32_t connects;
+    uint32_t disconnects;
+    uint32_t tx_publish;
+    uint32_t rx_publish;
+    uint32_t puback;
+    uint32_t resent;                // QoS1 messages sent again with DUP after a reconnect
+    uint32_t restored;              // Read back from the outbox at boot
+    uint32_t dropped;               // QoS0 messages published while disconnected
+    uint32_t pool_exhausted;
+    uint32_t telemetry_batches;
+    uint16_t inflight;
+    bool persistent;                // Outbox on SD; RAM only otherwise
+};
+
+// EventBridge payloads
+struct MqttConnectedEvent {
+    bool session_present;
+    uint16_t inflight;              // QoS1 messages being resent
+};
+
+struct MqttMessageEvent {
+    char topic[MQTT_TOPIC_MAX];
+    uint16_t len;                   // Full payload length, data holds the first bytes
+    uint8_t data[152];
+};
+
+struct MqttBenchResult {
+    uint32_t messages;
+    uint32_t acked;
+    uint32_t send_ms;               // First publish to the last one on the wire
+    uint32_t ack_ms;                // First publish to the last PUBACK, QoS1 only
+    uint32_t msgs_per_s;
+    uint32_t bytes_per_s;
+    uint32_t pool_waits;            // Times the publisher blocked on an empty pool
+};
+
+typedef void (*mqtt_message_cb)(const char *topic, const uint8_t *payload, size_t len, void *ctx);
+
+/**
+ * @brief Start the client task. The broker comes from the mqtt.host/port/user/
+ *        password profile when the integration layer is built, else the arguments
+ */
+bool mqtt_begin(const char *host = NULL, uint16_t port = 1883);
+void mqtt_end();
+
+/**
+ * @brief Disconnect and idle the task without ending it; resuming reconnects
+ *        at once. Returns without waiting for the disconnect
+ */
+void mqtt_suspend(bool suspend);
+bool mqtt_connected();
+
+/**
+ * @brief Device part of the default topics, the low six bytes of the factory MAC
+ */
+const char *mqtt_device_id();
+
+/**
+ * @brief Take a pool buffer with the topic already in place
+ * @param wait_ms  How long to wait for a free buffer
+ * @return NULL on an empty pool or a topic over MQTT_TOPIC_MAX
+ */
+MqttBuffer *mqtt_buffer_acquire(const char *topic, uint8_t qos = 0, bool retain = false, uint32_t wait_ms = 0);
+
+/**
+ * @brief Where the payload goes, capacity is the room left after the topic
+ */
+uint8_t *mqtt_buffer_payload(MqttBuffer *buf, size_t *capacity);
+
+/**
+ * @brief Hand the buffer to the task; it always takes ownership, also on false
+ */
+bool mqtt_publish_buffer(MqttBuffer *buf, size_t payload_len);
+void mqtt_buffer_release(MqttBuffer *buf);
+
+/**
+ * @brief Copying convenience form of acquire/payload/publish
+ */
+bool mqtt_publish(const char *topic, const void *data, size_t len, uint8_t qos = 0, bool retain = false);
+
+/**
+ * @brief Subscribe, now or on the next connect. Messages reach cb on the MQTT
+ *        task and the EventBridge as MQTT_MESSAGE_RECEIVED
+ */
+bool mqtt_subscribe(const char *topic, uint8_t qos = 0);
+void mqtt_on_message(mqtt_message_cb cb, void *ctx = NULL);
+
+/**
+ * @brief Whole payloads of one exact topic to cb on the MQTT task, besides
+ *        the mqtt_on_message() taker; for payloads past MqttMessageEvent.data
+ * @return false once MQTT_TOPIC_HANDLERS are taken
+ */
+bool mqtt_on_topic(const char *topic, mqtt_message_cb cb, void *ctx = NULL);
+
+/**
+ * @brief Latest value per key goes out in the next telemetry batch
+ */
+bool mqtt_telemetry_set(const char *key, float value);
+void mqtt_telemetry_interval(uint32_t interval_ms);
+
+/**
+ * @brief Publish count messages of payload_len bytes as fast as the pool allows.
+ *        Runs on the caller's task and needs a connection
+ */
+bool mqtt_bench_run(uint32_t count, size_t payload_len, uint8_t qos, MqttBenchResult *out,
+                    uint32_t timeout_ms = 30000);
+
+const MqttStats *mqtt_stats();
+
+/**
+ * @brief Task loop count, the service's liveness heartbeat
+ */
+uint32_t mqtt_heartbeat();
+
+#endif // MQTT_CLIENT_H
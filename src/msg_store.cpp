@@ -0,0 +1,949 @@
+/**
+ * @file      msg_store.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Message history: append-only segment files, sorted RAM index,
+ *            tail recovery and background compaction
+ */
+
+#include "msg_store.h"
+#include <SD.h>
+#include <LittleFS.h>
+#include <esp_rom_crc.h>
+#include <esp_heap_caps.h>
+#include "simple_logger.h"
+#include "spi_bus.h"
+#include "fs_service.h"
+#include "sd_manager.h"
+#include "peripheral.h"
+#include "status_glance.h"
+#ifdef INTEGRATION_LAYER_ENABLED
+#include "integration/config_manager.h"
+#endif
+
+static_assert(sizeof(MsgStoreRecord) == 16, "Record header is part of the file format");
+
+#define STORE_BODY_MAX      (MSG_STORE_PEER_MAX + MSG_STORE_TEXT_MAX)
+#define STORE_RECORD_MAX    (sizeof(MsgStoreRecord) + STORE_BODY_MAX)
+#define STORE_PATH_MAX      24
+
+// One per message. The main run is sorted by conv, time, then location
+struct MsgIndexEntry {
+    uint32_t conv;                  // Channel in the top 4 bits, peer hash below
+    uint32_t time;
+    uint16_t seg;
+    uint16_t off;
+};
+
+struct MsgSegInfo {
+    uint16_t records;               // Messages and tombstones in the file
+    uint16_t live;                  // Tombstones always count as live
+};
+
+// Queued appends; the body (peer then text) is allocated by the caller and
+// freed by the store task, so callers on small stacks stay small
+struct StoreRequest {
+    MsgStoreRecord head;
+    uint8_t *body;
+};
+
+// A record picked up while compacting a segment
+struct CompactRecord {
+    uint32_t conv;
+    uint32_t time;
+    uint16_t off;
+    uint16_t len;
+    bool tombstone;
+};
+
+static fs::FS *store_fs = nullptr;
+static bool store_on_sd = false;
+static volatile bool store_ready = false;
+static volatile bool store_rebuild_req = false;
+static SemaphoreHandle_t store_lock = NULL;    // Index, segment table and the files
+static QueueHandle_t store_queue = NULL;
+static TaskHandle_t store_task_handle = NULL;
+static MsgStoreStats store_stats;
+static uint16_t store_max_segments = MSG_STORE_MAX_SEGMENTS;
+
+static MsgIndexEntry *idx_main = nullptr;       // PSRAM
+static size_t idx_count = 0;
+static size_t idx_capacity = 0;
+static MsgIndexEntry idx_delta[MSG_STORE_DELTA];
+static size_t delta_count = 0;
+
+// Segments seg_first..seg_last exist; ids only grow (16 bits: 4 GB of history)
+static MsgSegInfo seg_info[MSG_STORE_MAX_SEGMENTS];
+static uint16_t seg_first = 0;
+static uint16_t seg_last = 0;
+static uint16_t seg_count = 0;
+static uint32_t seg_write_off = 0;             // Append position in seg_last
+static uint8_t *seg_buf = nullptr;             // One whole segment, PSRAM
+static const MsgStoreListener *store_listener = nullptr;
+
+// SD operations hold the SPI bus; LittleFS lives on the internal flash
+class StoreFsHold {
+public:
+    StoreFsHold() : sd(store_on_sd) { if (sd) spi_bus_acquire(SPI_CLIENT_SD); }
+    ~StoreFsHold() { if (sd) spi_bus_release(SPI_CLIENT_SD); }
+    StoreFsHold(const StoreFsHold&) = delete;
+    StoreFsHold& operator=(const StoreFsHold&) = delete;
+private:
+    bool sd;
+};
+
+static void *store_alloc(size_t size) {
+    void *p = heap_caps_malloc(size, MALLOC_CAP_SPIRAM);
+    return p ? p : heap_caps_malloc(size, MALLOC_CAP_8BIT);
+}
+
+static uint32_t conv_key(uint8_t channel, const char *peer, size_t len) {
+    uint32_t h = 2166136261UL;      // FNV-1a
+    for (size_t i = 0; i < len; i++) {
+        h = (h ^ (uint8_t)peer[i]) * 16777619UL;
+    }
+    return ((uint32_t)(channel & 0x0F) << 28) | (h & 0x0FFFFFFF);
+}
+
+static inline MsgSegInfo &seg_at(uint16_t id) {
+    return seg_info[id % MSG_STORE_MAX_SEGMENTS];
+}
+
+static void seg_path(char *path, uint16_t id, const char *ext) {
+    snprintf(path, STORE_PATH_MAX, MSG_STORE_DIR "/%05u.%s", (unsigned)id, ext);
+}
+
+static uint32_t record_crc(const MsgStoreRecord *head, const uint8_t *body) {
+    MsgStoreRecord h = *head;
+    h.crc = 0;
+    uint32_t crc = esp_rom_crc32_le(0, (const uint8_t *)&h, sizeof(h));
+    return esp_rom_crc32_le(crc, body, head->peer_len + head->text_len);
+}
+
+/**
+ * Length of the valid record at p, 0 if there is none (a torn or foreign tail)
+ */
+static size_t record_parse(const uint8_t *p, size_t avail, MsgStoreRecord *head) {
+    if (avail < sizeof(MsgStoreRecord)) {
+        return 0;
+    }
+    memcpy(head, p, sizeof(*head));
+    size_t len = sizeof(*head) + head->peer_len + head->text_len;
+    if (head->magic != MSG_STORE_MAGIC || head->peer_len > MSG_STORE_PEER_MAX ||
+        head->text_len > MSG_STORE_TEXT_MAX || len > avail ||
+        record_crc(head, p + sizeof(*head)) != head->crc) {
+        return 0;
+    }
+    return len;
+}
+
+// ===== Index, store_lock held =====
+
+static int entry_cmp(const MsgIndexEntry *a, const MsgIndexEntry *b) {
+    if (a->conv != b->conv) return a->conv < b->conv ? -1 : 1;
+    if (a->time != b->time) return a->time < b->time ? -1 : 1;
+    if (a->seg != b->seg) return a->seg < b->seg ? -1 : 1;
+    if (a->off != b->off) return a->off < b->off ? -1 : 1;
+    return 0;
+}
+
+static int entry_qsort_cmp(const void *a, const void *b) {
+    return entry_cmp((const MsgIndexEntry *)a, (const MsgIndexEntry *)b);
+}
+
+static bool idx_reserve(size_t n) {
+    if (n <= idx_capacity) {
+        return true;
+    }
+    size_t capacity = idx_capacity ? idx_capacity : MSG_STORE_INDEX_INITIAL;
+    while (capacity < n) {
+        capacity *= 2;
+    }
+    void *p = heap_caps_realloc(idx_main, capacity * sizeof(MsgIndexEntry), MALLOC_CAP_SPIRAM);
+    if (!p) {
+        p = heap_caps_realloc(idx_main, capacity * sizeof(MsgIndexEntry), MALLOC_CAP_8BIT);
+    }
+    if (!p) {
+        return false;
+    }
+    idx_main = (MsgIndexEntry *)p;
+    idx_capacity = capacity;
+    return true;
+}
+
+// First main entry not below (conv, time)
+static size_t idx_lower(uint32_t conv, uint32_t time) {
+    size_t lo = 0;
+    size_t hi = idx_count;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        const MsgIndexEntry &e = idx_main[mid];
+        if (e.conv < conv || (e.conv == conv && e.time < time)) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+// Tail into the main run: sort the tail, then merge from the back in place
+static bool idx_merge() {
+    if (!delta_count) {
+        return true;
+    }
+    if (!idx_reserve(idx_count + delta_count)) {
+        return false;
+    }
+    for (size_t i = 1; i < delta_count; i++) {
+        MsgIndexEntry e = idx_delta[i];
+        size_t j = i;
+        for (; j > 0 && entry_cmp(&idx_delta[j - 1], &e) > 0; j--) {
+            idx_delta[j] = idx_delta[j - 1];
+        }
+        idx_delta[j] = e;
+    }
+
+    size_t a = idx_count;
+    size_t b = delta_count;
+    size_t out = idx_count + delta_count;
+    while (b) {
+        if (a && entry_cmp(&idx_main[a - 1], &idx_delta[b - 1]) > 0) {
+            idx_main[--out] = idx_main[--a];
+        } else {
+            idx_main[--out] = idx_delta[--b];
+        }
+    }
+    idx_count += delta_count;
+    delta_count = 0;
+    return true;
+}
+
+static bool idx_add(const MsgIndexEntry &e) {
+    if (delta_count == MSG_STORE_DELTA && !idx_merge()) {
+        return false;
+    }
+    idx_delta[delta_count++] = e;
+    return true;
+}
+
+static MsgIndexEntry *idx_find(uint32_t conv, uint32_t time, uint16_t seg, uint16_t off) {
+    for (size_t i = idx_lower(conv, time); i < idx_count; i++) {
+        MsgIndexEntry &e = idx_main[i];
+        if (e.conv != conv || e.time != time) {
+            break;
+        }
+        if (e.seg == seg && e.off == off) {
+            return &e;
+        }
+    }
+    for (size_t i = 0; i < delta_count; i++) {
+        MsgIndexEntry &e = idx_delta[i];
+        if (e.conv == conv && e.seg == seg && e.off == off) {
+            return &e;
+        }
+    }
+    return nullptr;
+}
+
+// Drops entries matching conv (any_seg) or seg, keeping order; live counts follow
+static void idx_remove(bool by_conv, uint32_t conv, uint16_t seg) {
+    MsgIndexEntry *arrays[2] = {idx_main, idx_delta};
+    size_t *counts[2] = {&idx_count, &delta_count};
+    for (int a = 0; a < 2; a++) {
+        MsgIndexEntry *entries = arrays[a];
+        size_t kept = 0;
+        for (size_t i = 0; i < *counts[a]; i++) {
+            bool drop = by_conv ? entries[i].conv == conv : entries[i].seg == seg;
+            if (!drop) {
+                entries[kept++] = entries[i];
+            } else if (by_conv && seg_at(entries[i].seg).live) {
+                seg_at(entries[i].seg).live--;
+            }
+        }
+        *counts[a] = kept;
+    }
+}
+
+// ===== Segments, store task =====
+
+static uint32_t segment_read(uint16_t id, uint32_t *file_size) {
+    char path[STORE_PATH_MAX];
+    seg_path(path, id, "seg");
+    StoreFsHold hold;
+    File f = store_fs->open(path, FILE_READ);
+    if (!f) {
+        *file_size = 0;
+        return 0;
+    }
+    *file_size = f.size();
+    uint32_t n = f.read(seg_buf, min((uint32_t)MSG_STORE_SEGMENT_SIZE, *file_size));
+    f.close();
+    return n;
+}
+
+// Past the limit the oldest segment and its messages go
+static void segment_trim() {
+    while (seg_count > store_max_segments) {
+        char path[STORE_PATH_MAX];
+        seg_path(path, seg_first, "seg");
+        {
+            StoreFsHold hold;
+            store_fs->remove(path);
+        }
+        idx_remove(false, 0, seg_first);
+        seg_at(seg_first) = {0, 0};
+        if (store_listener) {
+            store_listener->changed(seg_first, store_listener->ctx);
+        }
+        seg_first++;
+        seg_count--;
+        store_stats.dropped_segments++;
+    }
+}
+
+/**
+ * A compaction cut short between removing the old segment and renaming the
+ * new one leaves only the .tmp; one cut short earlier leaves both, and the
+ * old segment is still whole
+ */
+static void segment_recover_tmp(uint16_t id) {
+    char tmp[STORE_PATH_MAX];
+    char seg[STORE_PATH_MAX];
+    seg_path(tmp, id, "tmp");
+    seg_path(seg, id, "seg");
+    StoreFsHold hold;
+    if (store_fs->exists(seg)) {
+        store_fs->remove(tmp);
+    } else {
+        store_fs->rename(tmp, seg);
+    }
+}
+
+static void store_rebuild() {
+    uint32_t start = millis();
+    xSemaphoreTake(store_lock, portMAX_DELAY);
+    store_ready = false;
+    idx_count = 0;
+    delta_count = 0;
+    seg_count = 0;
+    seg_write_off = 0;
+    memset(seg_info, 0, sizeof(seg_info));
+
+    bool found = false;
+    uint16_t lo = 0xFFFF;
+    uint16_t hi = 0;
+    int32_t tmp_id = -1;
+    {
+        StoreFsHold hold;
+        if (!store_fs->exists(MSG_STORE_DIR) && !store_fs->mkdir(MSG_STORE_DIR)) {
+            LOG_ERROR("MsgStore", "Cannot create " MSG_STORE_DIR);
+            xSemaphoreGive(store_lock);
+            return;
+        }
+        File dir = store_fs->open(MSG_STORE_DIR);
+        for (File f = dir.openNextFile(); f; f = dir.openNextFile()) {
+            const char *name = strrchr(f.name(), '/');
+            name = name ? name + 1 : f.name();
+            char *ext = nullptr;
+            uint32_t id = strtoul(name, &ext, 10);
+            if (ext == name || id > 0xFFFF) {
+                continue;
+            }
+            if (!strcmp(ext, ".tmp")) {
+                tmp_id = id;
+            } else if (!strcmp(ext, ".seg")) {
+                found = true;
+                lo = min(lo, (uint16_t)id);
+                hi = max(hi, (uint16_t)id);
+            }
+        }
+        dir.close();
+    }
+    if (tmp_id >= 0) {
+        segment_recover_tmp(tmp_id);
+        found = true;
+        lo = min(lo, (uint16_t)tmp_id);
+        hi = max(hi, (uint16_t)tmp_id);
+    }
+
+    for (uint32_t id = lo; found && id <= hi; id++) {
+        uint32_t file_size;
+        uint32_t n = segment_read(id, &file_size);
+        uint32_t off = 0;
+        MsgStoreRecord head;
+        size_t len;
+        while ((len = record_parse(seg_buf + off, n - off, &head)) != 0) {
+            const char *peer = (const char *)seg_buf + off + sizeof(head);
+            uint32_t conv = conv_key(head.channel, peer, head.peer_len);
+            if (head.flags & MSG_FLAG_TOMBSTONE) {
+                // Applies to everything before it, this segment included
+                idx_remove(true, conv, 0);
+            } else if (idx_reserve(idx_count + 1)) {
+                idx_main[idx_count++] = {conv, head.time, (uint16_t)id, (uint16_t)off};
+            }
+            seg_at(id).records++;
+            seg_at(id).live++;
+            off += len;
+        }
+
+        if (off < file_size) {
+            store_stats.torn_tails++;
+            LOG_WARNF("MsgStore", "Segment %lu cut at %lu of %lu bytes", id, off, file_size);
+        }
+        if (id == hi) {
+            seg_first = lo;
+            seg_last = hi;
+            seg_count = hi - lo + 1;
+            // A torn tail is never appended after: new records go to a fresh segment
+            seg_write_off = off < file_size ? MSG_STORE_SEGMENT_SIZE : off;
+        }
+    }
+    qsort(idx_main, idx_count, sizeof(MsgIndexEntry), entry_qsort_cmp);
+    segment_trim();
+
+    store_stats.rebuild_ms = millis() - start;
+    store_ready = true;
+    xSemaphoreGive(store_lock);
+    LOG_INFOF("MsgStore", "%lu messages in %u segments on %s, indexed in %lums", (unsigned long)idx_count,
+              (unsigned)seg_count, store_on_sd ? "SD" : "LittleFS", store_stats.rebuild_ms);
+}
+
+static void store_write(StoreRequest *req) {
+    size_t body_len = req->head.peer_len + req->head.text_len;
+    size_t len = sizeof(MsgStoreRecord) + body_len;
+
+    xSemaphoreTake(store_lock, portMAX_DELAY);
+    if (!store_ready) {
+        store_stats.dropped++;
+        xSemaphoreGive(store_lock);
+        return;
+    }
+    if (!seg_count) {
+        seg_first = seg_last = 0;
+        seg_count = 1;
+        seg_write_off = 0;
+    } else if (seg_write_off + len > MSG_STORE_SEGMENT_SIZE) {
+        seg_last++;
+        seg_count++;
+        seg_write_off = 0;
+        seg_at(seg_last) = {0, 0};
+        segment_trim();
+    }
+
+    char path[STORE_PATH_MAX];
+    seg_path(path, seg_last, "seg");
+    bool ok;
+    {
+        StoreFsHold hold;
+        File f = store_fs->open(path, FILE_APPEND);
+        ok = f && f.write((const uint8_t *)&req->head, sizeof(req->head)) == sizeof(req->head) &&
+             f.write(req->body, body_len) == body_len;
+        if (f) {
+            f.close();
+        }
+    }
+
+    if (ok) {
+        uint32_t conv = conv_key(req->head.channel, (const char *)req->body, req->head.peer_len);
+        if (req->head.flags & MSG_FLAG_TOMBSTONE) {
+            idx_remove(true, conv, 0);
+        } else {
+            idx_add({conv, req->head.time, seg_last, (uint16_t)seg_write_off});
+            if (store_listener) {
+                store_listener->appended(seg_last, seg_write_off, &req->head, (const char *)req->body,
+                                         store_listener->ctx);
+            }
+        }
+        seg_at(seg_last).records++;
+        seg_at(seg_last).live++;
+        seg_write_off += len;
+        store_stats.appended++;
+        if (store_on_sd) {
+            fs_invalidate_usage();
+        }
+    } else {
+        // Whatever part of it landed stays behind as a torn tail; start over elsewhere
+        store_stats.write_errors++;
+        seg_write_off = MSG_STORE_SEGMENT_SIZE;
+    }
+    xSemaphoreGive(store_lock);
+}
+
+static int compact_cmp(const void *pa, const void *pb) {
+    const CompactRecord *a = (const CompactRecord *)pa;
+    const CompactRecord *b = (const CompactRecord *)pb;
+    if (a->conv != b->conv) return a->conv < b->conv ? -1 : 1;
+    // A tombstone heads its conversation, so it never hides what outlived it
+    if (a->tombstone != b->tombstone) return a->tombstone ? -1 : 1;
+    if (a->time != b->time) return a->time < b->time ? -1 : 1;
+    return a->off < b->off ? -1 : 1;
+}
+
+/**
+ * Rewrite the oldest sealed segment that is mostly dead: live records only,
+ * grouped by conversation. The oldest segment also sheds its tombstones,
+ * as there is nothing older left for them to hide
+ */
+static bool store_compact() {
+    xSemaphoreTake(store_lock, portMAX_DELAY);
+    int32_t victim = -1;
+    for (uint16_t id = seg_first; seg_count && id != seg_last; id++) {
+        const MsgSegInfo &info = seg_at(id);
+        if (info.records && info.live * 100U < info.records * (uint32_t)MSG_STORE_COMPACT_PCT) {
+            victim = id;
+            break;
+        }
+    }
+    if (victim < 0) {
+        xSemaphoreGive(store_lock);
+        return false;
+    }
+
+    uint16_t id = victim;
+    uint32_t file_size;
+    uint32_t n = segment_read(id, &file_size);
+    CompactRecord *records = (CompactRecord *)store_alloc(
+        (MSG_STORE_SEGMENT_SIZE / sizeof(MsgStoreRecord)) * sizeof(CompactRecord));
+    if (!records) {
+        xSemaphoreGive(store_lock);
+        return false;
+    }
+
+    size_t kept = 0;
+    uint32_t off = 0;
+    MsgStoreRecord head;
+    size_t len;
+    while ((len = record_parse(seg_buf + off, n - off, &head)) != 0) {
+        uint32_t conv = conv_key(head.channel, (const char *)seg_buf + off + sizeof(head), head.peer_len);
+        bool tombstone = head.flags & MSG_FLAG_TOMBSTONE;
+        bool live = tombstone ? id != seg_first : idx_find(conv, head.time, id, off) != nullptr;
+        if (live) {
+            records[kept++] = {conv, head.time, (uint16_t)off, (uint16_t)len, tombstone};
+        }
+        off += len;
+    }
+    qsort(records, kept, sizeof(CompactRecord), compact_cmp);
+
+    char tmp[STORE_PATH_MAX];
+    char seg[STORE_PATH_MAX];
+    seg_path(tmp, id, "tmp");
+    seg_path(seg, id, "seg");
+    bool ok;
+    {
+        StoreFsHold hold;
+        File f = store_fs->open(tmp, FILE_WRITE);
+        ok = (bool)f;
+        for (size_t i = 0; ok && i < kept; i++) {
+            ok = f.write(seg_buf + records[i].off, records[i].len) == records[i].len;
+        }
+        if (f) {
+            f.close();
+        }
+        ok = ok && store_fs->remove(seg) && store_fs->rename(tmp, seg);
+        if (!ok) {
+            store_fs->remove(tmp);
+        }
+    }
+
+    if (ok) {
+        uint32_t new_off = 0;
+        for (size_t i = 0; i < kept; i++) {
+            if (!records[i].tombstone) {
+                MsgIndexEntry *e = idx_find(records[i].conv, records[i].time, id, records[i].off);
+                if (e) {
+                    e->off = new_off;
+                }
+            }
+            new_off += records[i].len;
+        }
+        seg_at(id) = {(uint16_t)kept, (uint16_t)kept};
+        store_stats.compactions++;
+        if (store_listener) {
+            store_listener->changed(id, store_listener->ctx);
+        }
+        if (store_on_sd) {
+            fs_invalidate_usage();
+        }
+        LOG_DEBUGF("MsgStore", "Segment %u compacted, %lu of %lu bytes kept", (unsigned)id,
+                   (unsigned long)new_off, (unsigned long)file_size);
+    } else {
+        store_stats.write_errors++;
+    }
+    free(records);
+    xSemaphoreGive(store_lock);
+    return ok;
+}
+
+static void store_task(void *param) {
+    store_rebuild();
+    while (true) {
+        StoreRequest req;
+        if (xQueueReceive(store_queue, &req, pdMS_TO_TICKS(MSG_STORE_IDLE_MS)) == pdTRUE) {
+            store_write(&req);
+            free(req.body);
+            continue;
+        }
+        if (store_rebuild_req) {
+            store_rebuild_req = false;
+            store_rebuild();
+        } else if (store_ready) {
+            store_compact();
+        }
+    }
+}
+
+// ===== Card changes =====
+
+static void store_sd_detach() {
+    if (!store_on_sd) {
+        return;
+    }
+    // Appends are dropped until the card is back; wait out the one in flight
+    xSemaphoreTake(store_lock, portMAX_DELAY);
+    store_ready = false;
+    xSemaphoreGive(store_lock);
+}
+
+static void store_sd_attach() {
+    if (store_on_sd) {
+        store_rebuild_req = true;
+    }
+}
+
+// ===== LoRa =====
+
+// Text frames on their way to the rx queue; binary link layer frames are not messages
+static bool store_lora_tap(const lora_packet_t *pkt) {
+    if (!pkt->len) {
+        return false;
+    }
+    for (uint16_t i = 0; i < pkt->len; i++) {
+        uint8_t c = pkt->data[i];
+        if (c < 0x20 && c != '\n' && c != '\r' && c != '\t') {
+            return false;
+        }
+    }
+    msg_store_append(MSG_CHANNEL_LORA, "lora", (const char *)pkt->data, pkt->len, 0, (int8_t)pkt->rssi);
+    return false;
+}
+
+// ===== API =====
+
+bool msg_store_begin() {
+    if (store_task_handle) {
+        return true;
+    }
+#ifdef INTEGRATION_LAYER_ENABLED
+    if (!GET_CONFIG_BOOL("messages", "enabled", true)) {
+        LOG_INFO("MsgStore", "Message history disabled by config");
+        return false;
+    }
+#endif
+
+    if (sd_manager_mounted()) {
+        store_fs = &SD;
+        store_on_sd = true;
+        store_max_segments = MSG_STORE_MAX_SEGMENTS;
+    } else if (LittleFS.begin(false)) {
+        store_fs = &LittleFS;
+        store_on_sd = false;
+        store_max_segments = MSG_STORE_LFS_SEGMENTS;
+    } else {
+        LOG_WARN("MsgStore", "No SD card or LittleFS, message history off");
+        return false;
+    }
+#ifdef INTEGRATION_LAYER_ENABLED
+    int32_t max_segments = GET_CONFIG_INT("messages", "max_segments", (int32_t)store_max_segments);
+    if (max_segments > 0 && max_segments < store_max_segments) {
+        store_max_segments = max_segments;
+    }
+#endif
+
+    seg_buf = (uint8_t *)store_alloc(MSG_STORE_SEGMENT_SIZE);
+    store_lock = xSemaphoreCreateMutex();
+    store_queue = xQueueCreate(MSG_STORE_QUEUE_DEPTH, sizeof(StoreRequest));
+    if (!seg_buf || !store_lock || !store_queue) {
+        LOG_ERROR("MsgStore", "Out of memory");
+        return false;
+    }
+    if (store_on_sd) {
+        sd_manager_add_client("MsgStore", store_sd_attach, store_sd_detach);
+    }
+    if (xTaskCreate(store_task, "msg_store", MSG_STORE_TASK_STACK, NULL, MSG_STORE_TASK_PRIORITY,
+                    &store_task_handle) != pdPASS) {
+        LOG_ERROR("MsgStore", "Failed to start the store task");
+        return false;
+    }
+    lora_add_rx_hook(store_lora_tap);
+    return true;
+}
+
+bool msg_store_append(uint8_t channel, const char *peer, const char *text, size_t len,
+                      uint8_t flags, int8_t rssi, uint32_t time) {
+    if (!store_queue || !peer) {
+        return false;
+    }
+    size_t peer_len = min(strlen(peer), (size_t)MSG_STORE_PEER_MAX);
+    len = min(len, (size_t)MSG_STORE_TEXT_MAX);
+
+    StoreRequest req;
+    req.body = (uint8_t *)store_alloc(peer_len + len + 1);
+    if (!req.body) {
+        store_stats.dropped++;
+        return false;
+    }
+    memcpy(req.body, peer, peer_len);
+    if (len) {
+        memcpy(req.body + peer_len, text, len);
+    }
+    req.head.magic = MSG_STORE_MAGIC;
+    req.head.channel = channel;
+    req.head.flags = flags;
+    req.head.time = time ? time : (uint32_t)::time(NULL);
+    req.head.peer_len = peer_len;
+    req.head.rssi = rssi;
+    req.head.text_len = len;
+    req.head.crc = record_crc(&req.head, req.body);
+
+    if (xQueueSend(store_queue, &req, 0) != pdTRUE) {
+        free(req.body);
+        store_stats.dropped++;
+        return false;
+    }
+    if (!(flags & (MSG_FLAG_OUT | MSG_FLAG_TOMBSTONE))) {
+        status_glance_note_message();
+    }
+    return true;
+}
+
+bool msg_store_delete_conversation(uint8_t channel, const char *peer) {
+    return msg_store_append(channel, peer, "", 0, MSG_FLAG_TOMBSTONE);
+}
+
+// Fills out from the record at e; false for a hash collision or a bad read
+static bool store_read_message(File &f, const MsgIndexEntry &e, uint8_t channel, const char *peer,
+                               size_t peer_len, uint8_t *body, MsgStoreMessage *out) {
+    MsgStoreRecord head;
+    if (!f.seek(e.off) || f.read((uint8_t *)&head, sizeof(head)) != sizeof(head) ||
+        head.magic != MSG_STORE_MAGIC || head.peer_len > MSG_STORE_PEER_MAX ||
+        head.text_len > MSG_STORE_TEXT_MAX ||
+        f.read(body, head.peer_len + head.text_len) != (size_t)(head.peer_len + head.text_len) ||
+        record_crc(&head, body) != head.crc) {
+        return false;
+    }
+    if (peer && (head.channel != channel || head.peer_len != peer_len || memcmp(body, peer, peer_len))) {
+        return false;
+    }
+    out->time = head.time;
+    out->channel = head.channel;
+    out->flags = head.flags;
+    out->rssi = head.rssi;
+    memcpy(out->peer, body, head.peer_len);
+    out->peer[head.peer_len] = '\0';
+    memcpy(out->text, body + head.peer_len, head.text_len);
+    out->text[head.text_len] = '\0';
+    return true;
+}
+
+size_t msg_store_conversation(uint8_t channel, const char *peer, uint32_t before,
+                              MsgStoreMessage *out, size_t max) {
+    if (!store_ready || !peer || !max) {
+        return 0;
+    }
+    size_t peer_len = min(strlen(peer), (size_t)MSG_STORE_PEER_MAX);
+    uint32_t conv = conv_key(channel, peer, peer_len);
+    uint8_t *body = (uint8_t *)store_alloc(STORE_BODY_MAX);
+    if (!body) {
+        return 0;
+    }
+
+    size_t n = 0;
+    xSemaphoreTake(store_lock, portMAX_DELAY);
+    if (store_ready && idx_merge()) {
+        // The conversation is one run of the index, oldest first
+        size_t lo = idx_lower(conv, 0);
+        size_t end = before ? idx_lower(conv, before) : conv == UINT32_MAX ? idx_count : idx_lower(conv + 1, 0);
+        size_t begin = end - lo > max ? end - max : lo;
+
+        StoreFsHold hold;
+        File f;
+        int32_t open_seg = -1;
+        char path[STORE_PATH_MAX];
+        for (size_t i = begin; i < end; i++) {
+            const MsgIndexEntry &e = idx_main[i];
+            if (e.seg != open_seg) {
+                if (f) {
+                    f.close();
+                }
+                seg_path(path, e.seg, "seg");
+                f = store_fs->open(path, FILE_READ);
+                open_seg = e.seg;
+            }
+            if (f && store_read_message(f, e, channel, peer, peer_len, body, &out[n])) {
+                n++;
+            }
+        }
+        if (f) {
+            f.close();
+        }
+    }
+    xSemaphoreGive(store_lock);
+    free(body);
+    return n;
+}
+
+size_t msg_store_conversations(MsgStoreConversation *out, size_t max) {
+    if (!store_ready || !max) {
+        return 0;
+    }
+    MsgIndexEntry *last = (MsgIndexEntry *)store_alloc(max * sizeof(MsgIndexEntry));
+    uint8_t *body = (uint8_t *)store_alloc(STORE_BODY_MAX);
+    MsgStoreMessage *msg = (MsgStoreMessage *)store_alloc(sizeof(MsgStoreMessage));
+    size_t n = 0;
+
+    xSemaphoreTake(store_lock, portMAX_DELAY);
+    if (last && body && msg && store_ready && idx_merge()) {
+        // Newest entry of each run, kept most recent first
+        for (size_t i = 0; i < idx_count; i++) {
+            if (i + 1 < idx_count && idx_main[i + 1].conv == idx_main[i].conv) {
+                continue;
+            }
+            const MsgIndexEntry &e = idx_main[i];
+            size_t run = i + 1 - idx_lower(e.conv, 0);
+            size_t pos = n;
+            while (pos > 0 && last[pos - 1].time < e.time) {
+                pos--;
+            }
+            if (pos >= max) {
+                continue;
+            }
+            size_t move = (n < max ? n : max - 1) - pos;
+            memmove(&last[pos + 1], &last[pos], move * sizeof(MsgIndexEntry));
+            memmove(&out[pos + 1], &out[pos], move * sizeof(MsgStoreConversation));
+            last[pos] = e;
+            out[pos].last_time = e.time;
+            out[pos].count = run;
+            if (n < max) {
+                n++;
+            }
+        }
+
+        // Peer names come from the newest record of each
+        StoreFsHold hold;
+        char path[STORE_PATH_MAX];
+        for (size_t i = 0; i < n; i++) {
+            seg_path(path, last[i].seg, "seg");
+            File f = store_fs->open(path, FILE_READ);
+            if (f && store_read_message(f, last[i], 0, nullptr, 0, body, msg)) {
+                out[i].channel = msg->channel;
+                strlcpy(out[i].peer, msg->peer, sizeof(out[i].peer));
+            } else {
+                out[i].channel = last[i].conv >> 28;
+                out[i].peer[0] = '\0';
+            }
+            if (f) {
+                f.close();
+            }
+        }
+    }
+    xSemaphoreGive(store_lock);
+    free(msg);
+    free(body);
+    free(last);
+    return n;
+}
+
+void msg_store_get_stats(MsgStoreStats *out) {
+    if (!store_lock) {
+        memset(out, 0, sizeof(*out));
+        return;
+    }
+    xSemaphoreTake(store_lock, portMAX_DELAY);
+    *out = store_stats;
+    out->ready = store_ready;
+    out->on_sd = store_on_sd;
+    out->messages = idx_count + delta_count;
+    out->segments = seg_count;
+    xSemaphoreGive(store_lock);
+}
+
+void msg_store_set_listener(const MsgStoreListener *listener) {
+    if (store_lock) {
+        xSemaphoreTake(store_lock, portMAX_DELAY);
+    }
+    store_listener = listener;
+    if (store_lock) {
+        xSemaphoreGive(store_lock);
+    }
+}
+
+bool msg_store_segments(uint16_t *first, uint16_t *last) {
+    if (!store_ready) {
+        return false;
+    }
+    xSemaphoreTake(store_lock, portMAX_DELAY);
+    bool ok = store_ready && seg_count;
+    *first = seg_first;
+    *last = seg_last;
+    xSemaphoreGive(store_lock);
+    return ok;
+}
+
+bool msg_store_scan_segment(uint16_t seg, MsgStoreRecordFn fn, void *ctx) {
+    if (!store_ready) {
+        return false;
+    }
+    xSemaphoreTake(store_lock, portMAX_DELAY);
+    bool ok = store_ready && seg_count && (uint16_t)(seg - seg_first) < seg_count;
+    if (ok) {
+        // seg_buf is only used under the lock
+        uint32_t file_size;
+        uint32_t n = segment_read(seg, &file_size);
+        uint32_t off = 0;
+        MsgStoreRecord head;
+        size_t len;
+        while ((len = record_parse(seg_buf + off, n - off, &head)) != 0) {
+            const char *body = (const char *)seg_buf + off + sizeof(head);
+            if (!(head.flags & MSG_FLAG_TOMBSTONE) &&
+                idx_find(conv_key(head.channel, body, head.peer_len), head.time, seg, off)) {
+                fn(seg, off, &head, body, ctx);
+            }
+            off += len;
+        }
+    }
+    xSemaphoreGive(store_lock);
+    return ok;
+}
+
+bool msg_store_read(uint16_t seg, uint16_t off, MsgStoreMessage *out) {
+    if (!store_ready) {
+        return false;
+    }
+    uint8_t *body = (uint8_t *)store_alloc(STORE_BODY_MAX);
+    if (!body) {
+        return false;
+    }
+    bool ok = false;
+    xSemaphoreTake(store_lock, portMAX_DELAY);
+    if (store_ready && (uint16_t)(seg - seg_first) < seg_count) {
+        char path[STORE_PATH_MAX];
+        seg_path(path, seg, "seg");
+        StoreFsHold hold;
+        File f = store_fs->open(path, FILE_READ);
+        MsgIndexEntry e = {0, 0, seg, off};
+        if (f && store_read_message(f, e, 0, nullptr, 0, body, out)) {
+            // Deleted messages stay on disk until compaction; the index knows
+            ok = !(out->flags & MSG_FLAG_TOMBSTONE) &&
+                 idx_find(conv_key(out->channel, out->peer, strlen(out->peer)), out->time, seg, off);
+        }
+        if (f) {
+            f.close();
+        }
+    }
+    xSemaphoreGive(store_lock);
+    free(body);
+    return ok;
+}
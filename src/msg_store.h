@@ -0,0 +1,172 @@
+/**
+ * @file      msg_store.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Log-structured message history for LoRa, SMS and MQTT conversations
+ */
+
+#ifndef MSG_STORE_H
+#define MSG_STORE_H
+
+#include <Arduino.h>
+
+/**
+ * Messages are appended to fixed-size segment files, on the SD card or,
+ * without one, LittleFS. Nothing is rewritten in place: deleting a
+ * conversation appends a tombstone. A conversation is a channel plus a
+ * peer (node id, phone number, topic).
+ *
+ * The RAM index holds one entry per message, sorted by conversation and
+ * then time, so a conversation is one contiguous run of it. Inserts go
+ * to a small unsorted tail that is merged in whenever it fills. The
+ * index is rebuilt from the segments at start. A torn record at the end
+ * of the last segment, left by a crash or a pulled card, ends that
+ * segment and appends carry on in a new one.
+ *
+ * When idle the store task compacts segments that are mostly dead. It
+ * drops deleted messages and writes the rest grouped by conversation,
+ * so old history reads back in runs. Past the segment limit the oldest
+ * segment is dropped.
+ *
+ * Config section "messages": enabled (true), max_segments.
+ */
+
+#define MSG_STORE_DIR               "/msgs"
+#define MSG_STORE_SEGMENT_SIZE      (64 * 1024)  // Offsets are 16 bits
+#define MSG_STORE_MAX_SEGMENTS      256     // SD: 16 MB, ~100k short messages
+#define MSG_STORE_LFS_SEGMENTS      4       // LittleFS shares the flash with config and plugins
+#define MSG_STORE_MAGIC             0x534D  // "MS"
+#define MSG_STORE_PEER_MAX          32
+#define MSG_STORE_TEXT_MAX          512
+#define MSG_STORE_DELTA             128     // Unsorted index tail, merged when full
+#define MSG_STORE_INDEX_INITIAL     4096    // Entries, doubles as needed (PSRAM)
+#define MSG_STORE_COMPACT_PCT       50      // Compact a segment below this share of live records
+#define MSG_STORE_IDLE_MS           5000    // Quiet time before compaction runs
+#define MSG_STORE_QUEUE_DEPTH       8
+#define MSG_STORE_TASK_STACK        (1024 * 4)
+#define MSG_STORE_TASK_PRIORITY     (tskIDLE_PRIORITY + 1)
+
+enum MsgChannel {
+    MSG_CHANNEL_LORA = 1,
+    MSG_CHANNEL_SMS,
+    MSG_CHANNEL_MQTT,
+    MSG_CHANNEL_MESH,
+};
+
+#define MSG_FLAG_OUT                0x01    // Sent from this device
+#define MSG_FLAG_TOMBSTONE          0x80    // Deletes the conversation up to here
+
+/**
+ * On-disk record, little-endian: this header, the peer and then the text,
+ * neither NUL-terminated. Records never straddle segments
+ */
+struct MsgStoreRecord {
+    uint16_t magic;
+    uint8_t channel;
+    uint8_t flags;
+    uint32_t time;                  // UTC seconds
+    uint8_t peer_len;
+    int8_t rssi;                    // dBm, 0 when not received over the air
+    uint16_t text_len;
+    uint32_t crc;                   // Header with this field 0, then peer and text
+};
+
+struct MsgStoreMessage {
+    uint32_t time;
+    uint8_t channel;
+    uint8_t flags;
+    int8_t rssi;
+    char peer[MSG_STORE_PEER_MAX + 1];
+    char text[MSG_STORE_TEXT_MAX + 1];
+};
+
+struct MsgStoreConversation {
+    uint8_t channel;
+    char peer[MSG_STORE_PEER_MAX + 1];
+    uint32_t last_time;
+    uint32_t count;
+};
+
+struct MsgStoreStats {
+    bool ready;                     // Index built, appends are being written
+    bool on_sd;
+    uint32_t messages;              // In the index
+    uint32_t segments;
+    uint32_t appended;
+    uint32_t dropped;               // Queue full or no file system
+    uint32_t write_errors;
+    uint32_t torn_tails;            // Segments cut short at a bad record
+    uint32_t compactions;
+    uint32_t dropped_segments;      // Past max_segments
+    uint32_t rebuild_ms;
+};
+
+/**
+ * A record in a segment: the header, then the peer and the text
+ */
+typedef void (*MsgStoreRecordFn)(uint16_t seg, uint16_t off, const MsgStoreRecord *head,
+                                 const char *body, void *ctx);
+
+/**
+ * Follows every change, for indexes built over the store. Called on the
+ * store task with the store locked: keep it short and never call back in
+ */
+struct MsgStoreListener {
+    MsgStoreRecordFn appended;      // Messages only, not tombstones
+    void (*changed)(uint16_t seg, void *ctx);   // Compacted or dropped: offsets in it are stale
+    void *ctx;
+};
+
+/**
+ * @brief Start the store task, which builds the index in the background,
+ *        and record LoRa text traffic
+ */
+bool msg_store_begin();
+
+/**
+ * @brief Queue a message; never blocks on storage. time 0 is now
+ * @return false if it was dropped
+ */
+bool msg_store_append(uint8_t channel, const char *peer, const char *text, size_t len,
+                      uint8_t flags = 0, int8_t rssi = 0, uint32_t time = 0);
+
+/**
+ * @brief The newest max messages of a conversation older than before (0:
+ *        all), oldest first. Reads storage on the calling task
+ * @return Messages written
+ */
+size_t msg_store_conversation(uint8_t channel, const char *peer, uint32_t before,
+                              MsgStoreMessage *out, size_t max);
+
+/**
+ * @brief Conversations, most recent first
+ */
+size_t msg_store_conversations(MsgStoreConversation *out, size_t max);
+
+bool msg_store_delete_conversation(uint8_t channel, const char *peer);
+
+void msg_store_get_stats(MsgStoreStats *out);
+
+void msg_store_set_listener(const MsgStoreListener *listener);
+
+/**
+ * @brief Segment ids in use, oldest to newest (the one being appended to)
+ * @return false when the store is empty or not ready
+ */
+bool msg_store_segments(uint16_t *first, uint16_t *last);
+
+/**
+ * @brief Call fn for every live message in a segment, in file order, with
+ *        the store locked
+ */
+bool msg_store_scan_segment(uint16_t seg, MsgStoreRecordFn fn, void *ctx);
+
+/**
+ * @brief The message at a location from an index
+ * @return false when it has been deleted, compacted away or never was
+ */
+bool msg_store_read(uint16_t seg, uint16_t off, MsgStoreMessage *out);
+
+#endif // MSG_STORE_H
@@ -0,0 +1,621 @@
+/**
+ * @file      nav_fusion.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     GPS and step dead reckoning in a fixed-point EKF, stretching the GPS fix interval
+ */
+
+#include "nav_fusion.h"
+#include <esp_timer.h>
+#include <math.h>
+#include "peripheral.h"
+#include "motion_service.h"
+#include "timer_wheel.h"
+#include "usb_console.h"
+#include "simple_logger.h"
+#ifdef INTEGRATION_LAYER_ENABLED
+#include "integration/config_manager.h"
+#endif
+
+// Q16.16
+typedef int32_t fx_t;
+#define FX_ONE                      65536
+#define FX_PI                       205887
+#define FX_M(m)                     ((fx_t)((m) * FX_ONE))
+
+#define NAV_VAR_MAX                 FX_M(16000)     // m^2; keeps the 2x2 products in int64
+#define NAV_VAR_HEADING0            FX_M(9.8696)    // pi^2: heading offset unknown
+#define NAV_VAR_STEP0               FX_M(0.04)      // (0.2 m)^2
+#define NAV_VAR_HEADING_OK          FX_M((NAV_HEADING_OK_DEG * M_PI / 180) * (NAV_HEADING_OK_DEG * M_PI / 180))
+#define NAV_Q_STEP_POS              FX_M(0.01)      // (0.1 m)^2 per step
+#define NAV_Q_STEP_LEN              FX_M(0.00004)   // Step length walk per step
+#define NAV_Q_HEADING_S             FX_M(0.0003)    // Gyro drift, rad^2/s
+#define NAV_Q_POS_S                 FX_M(0.05)      // Unmodelled motion, m^2/s
+#define NAV_STEP_MIN                FX_M(0.3)
+#define NAV_STEP_MAX                FX_M(1.2)
+#define NAV_STEPS_MAX               20              // More at once is a counter reset
+#define NAV_HUB_TICKS_S             64000           // Hub timestamp rate
+#define NAV_INIT_DIST_M             20              // Straight walk that seeds the heading offset
+#define NAV_INIT_TURN_DEG           10              // More turn than this in it starts over
+#define NAV_BIAS_SHIFT              6               // Zero-rate average while stationary, 1/64 per sample
+
+#define NAV_M_PER_E7_Q32            47811357LL      // Metres per 1e-7 degree of latitude, Q32
+#define NAV_RAD_TO_BIN              10430           // Q16 radians to binary angle
+#define NAV_BIN_PER_DEG             11930465UL      // 2^32 / 360
+#define NAV_BIN_TO_RAD_Q48          411775LL        // 2 pi, Q16, per 2^32 binary angle units
+#define NAV_CORDIC_GAIN             39797           // 0.60725, Q16
+
+enum { NX_E = 0, NX_N, NX_B, NX_L, NX_COUNT };
+
+struct NavFilter {
+    fx_t x[NX_COUNT];               // East, north (m), heading offset (rad), step length (m)
+    fx_t P[NX_COUNT][NX_COUNT];
+};
+
+// sin over the first quadrant in 64 steps, Q16
+static const int32_t nav_sin_table[65] = {
+    0, 1608, 3216, 4821, 6424, 8022, 9616, 11204,
+    12785, 14359, 15924, 17479, 19024, 20557, 22078, 23586,
+    25080, 26558, 28020, 29466, 30893, 32303, 33692, 35062,
+    36410, 37736, 39040, 40320, 41576, 42806, 44011, 45190,
+    46341, 47464, 48559, 49624, 50660, 51665, 52639, 53581,
+    54491, 55368, 56212, 57022, 57798, 58538, 59244, 59914,
+    60547, 61145, 61705, 62228, 62714, 63162, 63572, 63944,
+    64277, 64571, 64827, 65043, 65220, 65358, 65457, 65516,
+    65536,
+};
+
+// atan(2^-i) in binary angle units
+static const int32_t nav_atan_table[16] = {
+    536870912, 316933406, 167458907, 85004756, 42667331, 21354465, 10679838, 5340245,
+    2670163, 1335087, 667544, 333772, 166886, 83443, 41722, 20861,
+};
+
+static portMUX_TYPE nav_mux = portMUX_INITIALIZER_UNLOCKED;
+static NavFilter nav_filter;
+static NavFusionStats nav_stats;
+static bool nav_running = false;
+static bool nav_gps = true;
+static fx_t nav_max_var = FX_M(NAV_MAX_ERROR_M * NAV_MAX_ERROR_M);
+static uint32_t nav_gap_ms = NAV_GAP_MS;
+static fx_t nav_step0 = FX_M(NAV_STEP_CM / 100.0);
+static WheelTimer nav_timer;
+
+// Origin of the east/north plane, set by the first fix
+static bool nav_origin = false;
+static int32_t nav_lat0_e7 = 0;
+static int32_t nav_lng0_e7 = 0;
+static fx_t nav_cos_lat0 = FX_ONE;
+static uint32_t nav_version = 0;
+static uint32_t nav_time_ms = 0;
+
+// Hub task: gyro heading, binary angle, and the step counter
+static volatile uint32_t nav_psi = 0;
+static uint64_t nav_imu_ts = 0;
+static int32_t nav_gyro_k = 0;      // Binary angle per (LSB * hub tick), Q16
+static int32_t nav_gyro_bias = 0;   // Zero rate about gravity, LSB Q8
+static float nav_gyro_dps = 0;
+static uint32_t nav_last_steps = 0;
+static bool nav_steps_seen = false;
+static volatile uint32_t nav_step_ms = 0;
+
+// Wheel task
+static uint32_t nav_fix_version = 0;
+static uint32_t nav_fix_ms = 0;
+static uint32_t nav_fixes_moving = 0;
+static uint32_t nav_tick_ms = 0;
+static bool nav_stretching = false;
+static volatile bool nav_heading = false;   // Offset seeded; steps predict from here on
+static bool nav_anchor = false;     // Start of the straight walk that seeds it
+static fx_t nav_anchor_e = 0;
+static fx_t nav_anchor_n = 0;
+static uint32_t nav_anchor_psi = 0;
+
+// ===== Fixed point =====
+
+static inline fx_t fx_sat(int64_t v) {
+    return v > INT32_MAX ? INT32_MAX : v < INT32_MIN ? INT32_MIN : (fx_t)v;
+}
+
+static inline fx_t fx_mul(fx_t a, fx_t b) {
+    return fx_sat(((int64_t)a * b) >> 16);
+}
+
+static fx_t fx_sin(uint32_t angle) {
+    uint32_t quadrant = angle >> 30;
+    uint32_t p = angle & 0x3FFFFFFF;
+    if (quadrant & 1) {
+        p = 0x40000000 - p;
+    }
+    uint32_t i = p >> 24;
+    int32_t v = nav_sin_table[i];
+    if (i < 64) {
+        uint32_t frac = (p >> 8) & 0xFFFF;
+        v += ((nav_sin_table[i + 1] - v) * (int32_t)frac) >> 16;
+    }
+    return quadrant & 2 ? -v : v;
+}
+
+static inline fx_t fx_cos(uint32_t angle) {
+    return fx_sin(angle + 0x40000000);
+}
+
+static uint32_t isqrt64(uint64_t v) {
+    uint64_t r = 0, bit = 1ULL << 62;
+    while (bit > v) {
+        bit >>= 2;
+    }
+    while (bit) {
+        if (v >= r + bit) {
+            v -= r + bit;
+            r = (r >> 1) + bit;
+        } else {
+            r >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)r;
+}
+
+static inline uint32_t rad_to_bin(fx_t rad) {
+    return (uint32_t)((int64_t)rad * NAV_RAD_TO_BIN);
+}
+
+static inline fx_t bin_to_rad(uint32_t angle) {
+    return (fx_t)(((int64_t)(int32_t)angle * NAV_BIN_TO_RAD_Q48) >> 32);
+}
+
+// Bearing of (e, n), clockwise from north, as a binary angle; CORDIC vectoring
+static uint32_t fx_bearing(fx_t e, fx_t n) {
+    int64_t x = n, y = e;
+    uint32_t angle = 0;
+    if (x < 0) {
+        // Into the right half plane first
+        angle = 0x80000000;
+        x = -x;
+        y = -y;
+    }
+    for (int i = 0; i < 16; i++) {
+        int64_t dx = y >> i, dy = x >> i;
+        if (y > 0) {
+            x += dx;
+            y -= dy;
+            angle += nav_atan_table[i];
+        } else {
+            x -= dx;
+            y += dy;
+            angle -= nav_atan_table[i];
+        }
+    }
+    return angle;
+}
+
+// ===== Filter =====
+
+static void filter_clamp(NavFilter *f) {
+    for (int i = 0; i < NX_COUNT; i++) {
+        for (int j = i + 1; j < NX_COUNT; j++) {
+            fx_t m = (fx_t)(((int64_t)f->P[i][j] + f->P[j][i]) / 2);
+            f->P[i][j] = f->P[j][i] = m;
+        }
+        f->P[i][i] = constrain(f->P[i][i], 1, NAV_VAR_MAX);
+    }
+    if (f->x[NX_B] > FX_PI) {
+        f->x[NX_B] -= 2 * FX_PI;
+    } else if (f->x[NX_B] < -FX_PI) {
+        f->x[NX_B] += 2 * FX_PI;
+    }
+    f->x[NX_L] = constrain(f->x[NX_L], NAV_STEP_MIN, NAV_STEP_MAX);
+}
+
+static void filter_reset(NavFilter *f, fx_t e, fx_t n, fx_t var, fx_t step) {
+    memset(f, 0, sizeof(*f));
+    f->x[NX_E] = e;
+    f->x[NX_N] = n;
+    f->x[NX_L] = step;
+    f->P[NX_E][NX_E] = var;
+    f->P[NX_N][NX_N] = var;
+    f->P[NX_B][NX_B] = NAV_VAR_HEADING0;
+    f->P[NX_L][NX_L] = NAV_VAR_STEP0;
+}
+
+// steps along gyro heading psi: x += F(x), P = F P F' + Q, with F the
+// identity but for the position rows' dependence on offset and length
+static void filter_predict(NavFilter *f, uint32_t steps, uint32_t psi) {
+    uint32_t theta = psi + rad_to_bin(f->x[NX_B]);
+    fx_t s = fx_sin(theta);
+    fx_t c = fx_cos(theta);
+    fx_t d = f->x[NX_L] * (int32_t)steps;
+    f->x[NX_E] += fx_mul(d, s);
+    f->x[NX_N] += fx_mul(d, c);
+
+    fx_t feb = fx_mul(d, c), fel = s * (int32_t)steps;
+    fx_t fnb = -fx_mul(d, s), fnl = c * (int32_t)steps;
+    fx_t (*P)[NX_COUNT] = f->P;
+    fx_t a[2][NX_COUNT];            // Rows E and N of F P
+    for (int j = 0; j < NX_COUNT; j++) {
+        a[0][j] = fx_sat(P[NX_E][j] + (((int64_t)feb * P[NX_B][j] + (int64_t)fel * P[NX_L][j]) >> 16));
+        a[1][j] = fx_sat(P[NX_N][j] + (((int64_t)fnb * P[NX_B][j] + (int64_t)fnl * P[NX_L][j]) >> 16));
+    }
+    for (int j = 0; j < NX_COUNT; j++) {
+        P[NX_E][j] = a[0][j];
+        P[NX_N][j] = a[1][j];
+    }
+    // Then (F P) F': columns E and N
+    for (int i = 0; i < NX_COUNT; i++) {
+        fx_t pb = P[i][NX_B], pl = P[i][NX_L];
+        P[i][NX_E] = fx_sat(P[i][NX_E] + (((int64_t)pb * feb + (int64_t)pl * fel) >> 16));
+        P[i][NX_N] = fx_sat(P[i][NX_N] + (((int64_t)pb * fnb + (int64_t)pl * fnl) >> 16));
+    }
+    P[NX_E][NX_E] += NAV_Q_STEP_POS * (int32_t)steps;
+    P[NX_N][NX_N] += NAV_Q_STEP_POS * (int32_t)steps;
+    P[NX_L][NX_L] += NAV_Q_STEP_LEN * (int32_t)steps;
+    filter_clamp(f);
+}
+
+static void filter_age(NavFilter *f, uint32_t dt_ms) {
+    dt_ms = min(dt_ms, (uint32_t)60000);
+    fx_t pos = (fx_t)((int64_t)NAV_Q_POS_S * dt_ms / 1000);
+    f->P[NX_E][NX_E] += pos;
+    f->P[NX_N][NX_N] += pos;
+    f->P[NX_B][NX_B] += (fx_t)((int64_t)NAV_Q_HEADING_S * dt_ms / 1000);
+    filter_clamp(f);
+}
+
+// Position measurement (ze, zn) with variance r. false when it was too far
+// off to blend and the position restarted from it
+static bool filter_correct(NavFilter *f, fx_t ze, fx_t zn, fx_t r) {
+    fx_t (*P)[NX_COUNT] = f->P;
+    int64_t s00 = (int64_t)P[0][0] + r, s11 = (int64_t)P[1][1] + r, s01 = P[0][1];
+    int64_t ye = (int64_t)ze - f->x[NX_E], yn = (int64_t)zn - f->x[NX_N];
+
+    // Gate on the trace: |y|^2 against k^2 (s00 + s11), both Q32
+    if (ye * ye + yn * yn > (int64_t)NAV_RESET_SIGMA * NAV_RESET_SIGMA * ((s00 + s11) << 16)) {
+        fx_t step = f->x[NX_L];
+        fx_t heading = P[NX_B][NX_B];
+        fx_t b = f->x[NX_B];
+        filter_reset(f, ze, zn, r, step);
+        // The heading offset is not what was wrong with a lost position
+        f->x[NX_B] = b;
+        P[NX_B][NX_B] = max(heading, (fx_t)NAV_VAR_HEADING_OK);
+        return false;
+    }
+
+    int64_t det = (s00 * s11 - s01 * s01) >> 16;
+    if (det <= 0) {
+        return true;
+    }
+    fx_t k[NX_COUNT][2];
+    for (int i = 0; i < NX_COUNT; i++) {
+        k[i][0] = fx_sat(((int64_t)P[i][0] * s11 - (int64_t)P[i][1] * s01) / det);
+        k[i][1] = fx_sat(((int64_t)P[i][1] * s00 - (int64_t)P[i][0] * s01) / det);
+    }
+    for (int i = 0; i < NX_COUNT; i++) {
+        f->x[i] = fx_sat(f->x[i] + ((k[i][0] * ye + k[i][1] * yn) >> 16));
+    }
+    // P -= K H P, from the rows of P as they were
+    fx_t p0[NX_COUNT], p1[NX_COUNT];
+    memcpy(p0, P[0], sizeof(p0));
+    memcpy(p1, P[1], sizeof(p1));
+    for (int i = 0; i < NX_COUNT; i++) {
+        for (int j = 0; j < NX_COUNT; j++) {
+            P[i][j] = fx_sat(P[i][j] - (((int64_t)k[i][0] * p0[j] + (int64_t)k[i][1] * p1[j]) >> 16));
+        }
+    }
+    filter_clamp(f);
+    return true;
+}
+
+// ===== Plane =====
+
+static void plane_origin(int32_t lat_e7, int32_t lng_e7) {
+    nav_lat0_e7 = lat_e7;
+    nav_lng0_e7 = lng_e7;
+    // 2^32 / 3.6e9 degrees per binary angle unit, Q32
+    nav_cos_lat0 = max(fx_cos((uint32_t)(((int64_t)lat_e7 * 5124095576LL) >> 32)), (fx_t)1);
+}
+
+static void plane_of(int32_t lat_e7, int32_t lng_e7, int64_t *e, int64_t *n) {
+    int64_t dlat = (int64_t)lat_e7 - nav_lat0_e7;
+    int64_t dlng = (int64_t)lng_e7 - nav_lng0_e7;
+    if (dlng > 1800000000LL) {
+        dlng -= 3600000000LL;
+    } else if (dlng < -1800000000LL) {
+        dlng += 3600000000LL;
+    }
+    *n = (dlat * NAV_M_PER_E7_Q32) >> 16;
+    *e = (((dlng * NAV_M_PER_E7_Q32) >> 16) * nav_cos_lat0) >> 16;
+}
+
+// ===== Inputs =====
+
+// Hub task, once per gyro sample
+static void on_imu(const bhi260_imu_t *s) {
+    nav_stats.samples++;            // Only this task writes it
+    if (s->gyro_dps != nav_gyro_dps) {
+        nav_gyro_dps = s->gyro_dps;
+        nav_gyro_k = (int32_t)(s->gyro_dps * ((float)NAV_BIN_PER_DEG / NAV_HUB_TICKS_S) * FX_ONE);
+    }
+    uint64_t dt = s->timestamp - nav_imu_ts;
+    nav_imu_ts = s->timestamp;
+    if (dt && dt < NAV_HUB_TICKS_S) {
+        // Rate about the gravity axis: gyro . accel / |accel|, gyro LSBs
+        int32_t ax = s->accel[0], ay = s->accel[1], az = s->accel[2];
+        uint32_t g = isqrt64((uint64_t)((int64_t)ax * ax + (int64_t)ay * ay + (int64_t)az * az));
+        if (g) {
+            int64_t dot = (int64_t)s->gyro[0] * ax + (int64_t)s->gyro[1] * ay + (int64_t)s->gyro[2] * az;
+            int32_t up = (int32_t)((dot << 8) / g);
+            // Lying still, the rate left is the gyro's offset
+            if (motion_state() == MOTION_STATIONARY) {
+                nav_gyro_bias += (up - nav_gyro_bias) >> NAV_BIAS_SHIFT;
+            }
+            // Counter-clockwise from above turns the heading west
+            nav_psi -= (uint32_t)(((int64_t)(up - nav_gyro_bias) * (int64_t)dt * nav_gyro_k) >> 24);
+        }
+    }
+
+    uint32_t steps = s->steps - nav_last_steps;
+    nav_last_steps = s->steps;
+    if (!nav_steps_seen) {
+        nav_steps_seen = true;
+        return;
+    }
+    if (!steps || steps > NAV_STEPS_MAX) {
+        return;
+    }
+    nav_step_ms = millis();
+    if (!nav_heading) {
+        return;
+    }
+    // The burst reaches us up to a latency period after the steps; they go
+    // along the heading at its start
+    int64_t t0 = esp_timer_get_time();
+    portENTER_CRITICAL(&nav_mux);
+    filter_predict(&nav_filter, steps, nav_psi);
+    nav_version++;
+    nav_time_ms = millis();
+    portEXIT_CRITICAL(&nav_mux);
+    uint32_t us = (uint32_t)(esp_timer_get_time() - t0);
+    portENTER_CRITICAL(&nav_mux);
+    nav_stats.steps += steps;
+    nav_stats.predicts++;
+    nav_stats.predict_us_max = max(nav_stats.predict_us_max, us);
+    portEXIT_CRITICAL(&nav_mux);
+}
+
+// The gyro heading is relative: its offset to true comes from the course
+// of a straight walk between two fixes, then the filter refines it
+static void seed_heading(fx_t e, fx_t n, fx_t acc) {
+    uint32_t psi = nav_psi;
+    int32_t turn = (int32_t)(psi - nav_anchor_psi);
+    if (!nav_anchor || (uint32_t)abs(turn) > NAV_INIT_TURN_DEG * NAV_BIN_PER_DEG) {
+        nav_anchor = true;
+        nav_anchor_e = e;
+        nav_anchor_n = n;
+        nav_anchor_psi = psi;
+        return;
+    }
+    fx_t de = e - nav_anchor_e, dn = n - nav_anchor_n;
+    fx_t dist = (fx_t)isqrt64((uint64_t)((int64_t)de * de + (int64_t)dn * dn));
+    if (dist < FX_M(NAV_INIT_DIST_M)) {
+        return;
+    }
+    uint32_t mid = nav_anchor_psi + turn / 2;
+    fx_t sd = (fx_t)(((int64_t)acc * 2 << 16) / dist);  // Two fixes' error across the distance
+    portENTER_CRITICAL(&nav_mux);
+    nav_filter.x[NX_B] = bin_to_rad(fx_bearing(de, dn) - mid);
+    nav_filter.P[NX_B][NX_B] = max(fx_mul(sd, sd), (fx_t)1);
+    filter_clamp(&nav_filter);
+    portEXIT_CRITICAL(&nav_mux);
+    nav_heading = true;
+    nav_anchor = false;
+    LOG_INFOF("Nav", "Heading offset seeded over %.0f m", dist / (float)FX_ONE);
+}
+
+static void take_fix(const gps_fix_t *fix, uint32_t now) {
+    int32_t lat_e7 = (int32_t)lround(fix->lat * 1e7);
+    int32_t lng_e7 = (int32_t)lround(fix->lng * 1e7);
+    float acc = fix->h_acc > 0 ? min(fix->h_acc, 100.0f) : NAV_FIX_ACC_M;
+    fx_t r = FX_M(acc * acc);
+
+    int64_t t0 = esp_timer_get_time();
+    bool blended = true, rebased = false;
+    int64_t e = 0, n = 0;
+    portENTER_CRITICAL(&nav_mux);
+    if (!nav_origin) {
+        plane_origin(lat_e7, lng_e7);
+        filter_reset(&nav_filter, 0, 0, r, nav_step0);
+        nav_origin = true;
+    } else {
+        plane_of(lat_e7, lng_e7, &e, &n);
+        if (llabs(e) > FX_M(NAV_ORIGIN_MAX_M) || llabs(n) > FX_M(NAV_ORIGIN_MAX_M)) {
+            // Re-centre on the fix; the estimate moves with it if still near
+            int64_t xe = nav_filter.x[NX_E] - e, xn = nav_filter.x[NX_N] - n;
+            plane_origin(lat_e7, lng_e7);
+            if (llabs(xe) < FX_M(NAV_ORIGIN_MAX_M) && llabs(xn) < FX_M(NAV_ORIGIN_MAX_M)) {
+                nav_filter.x[NX_E] = (fx_t)xe;
+                nav_filter.x[NX_N] = (fx_t)xn;
+            } else {
+                filter_reset(&nav_filter, 0, 0, r, nav_filter.x[NX_L]);
+            }
+            e = n = 0;
+            rebased = true;
+            nav_anchor = false;
+        }
+        if (nav_heading) {
+            blended = filter_correct(&nav_filter, (fx_t)e, (fx_t)n, r);
+        } else {
+            filter_reset(&nav_filter, (fx_t)e, (fx_t)n, r, nav_filter.x[NX_L]);
+        }
+    }
+    nav_version++;
+    nav_time_ms = now;
+    portEXIT_CRITICAL(&nav_mux);
+    uint32_t us = (uint32_t)(esp_timer_get_time() - t0);
+
+    portENTER_CRITICAL(&nav_mux);
+    nav_stats.fixes++;
+    nav_stats.resets += !blended;
+    nav_stats.rebases += rebased;
+    nav_stats.correct_us_max = max(nav_stats.correct_us_max, us);
+    portEXIT_CRITICAL(&nav_mux);
+    nav_fix_ms = now;
+    if (now - nav_step_ms < NAV_STEP_IDLE_MS) {
+        nav_fixes_moving++;
+        if (!nav_heading) {
+            seed_heading((fx_t)e, (fx_t)n, FX_M(acc));
+        }
+    } else {
+        nav_anchor = false;
+    }
+}
+
+// ===== GPS duty =====
+
+static void tick(WheelTimer *timer) {
+    uint32_t now = millis();
+    gps_fix_t fix;
+    uint32_t version = gps_get_fix(&fix);
+    if (version != nav_fix_version) {
+        nav_fix_version = version;
+        if (fix.valid) {
+            take_fix(&fix, now);
+        }
+    }
+    fx_t var, heading;
+    portENTER_CRITICAL(&nav_mux);
+    filter_age(&nav_filter, now - nav_tick_ms);
+    var = nav_filter.P[NX_E][NX_E] + nav_filter.P[NX_N][NX_N];
+    heading = nav_filter.P[NX_B][NX_B];
+    if (nav_stretching) {
+        nav_stats.stretch_ms += now - nav_tick_ms;
+    }
+    portEXIT_CRITICAL(&nav_mux);
+    nav_tick_ms = now;
+
+    MotionState motion = motion_state();
+    bool walking = now - nav_step_ms < NAV_STEP_IDLE_MS;
+    bool stretch = nav_gps && nav_origin && nav_fixes_moving >= NAV_FIXES_MIN && heading < NAV_VAR_HEADING_OK &&
+                   var < nav_max_var && motion != MOTION_FAST && (walking || motion == MOTION_STATIONARY);
+    if (stretch != nav_stretching) {
+        nav_stretching = stretch;
+        gps_power_stretch(stretch ? nav_gap_ms : 0);
+        if (stretch) {
+            portENTER_CRITICAL(&nav_mux);
+            nav_stats.stretches++;
+            portEXIT_CRITICAL(&nav_mux);
+        }
+        LOG_INFOF("Nav", "%s GPS gaps, error %.1f m", stretch ? "Stretching" : "Back to normal",
+                  sqrtf(var / (float)FX_ONE));
+    }
+}
+
+// ===== Console =====
+
+static void rpc_bench(Print &out, uint32_t n) {
+    NavFilter f;
+    filter_reset(&f, 0, 0, FX_M(25), FX_M(0.7));
+    uint32_t psi = 0;
+    int64_t t0 = esp_timer_get_time();
+    for (uint32_t i = 0; i < n; i++) {
+        psi += 0x00800000;          // Turning slowly
+        filter_predict(&f, 1, psi);
+    }
+    int64_t t1 = esp_timer_get_time();
+    for (uint32_t i = 0; i < n; i++) {
+        filter_correct(&f, f.x[NX_E] + FX_M(1), f.x[NX_N] - FX_M(1), FX_M(16));
+        filter_predict(&f, 2, psi);
+    }
+    int64_t t2 = esp_timer_get_time();
+    uint32_t predict_ns = (uint32_t)((t1 - t0) * 1000 / n);
+    uint32_t pair_ns = (uint32_t)((t2 - t1) * 1000 / n);
+    out.printf("%lu rounds: predict %lu ns, correct %lu ns\n", (unsigned long)n, (unsigned long)predict_ns,
+               (unsigned long)(pair_ns > predict_ns ? pair_ns - predict_ns : 0));
+}
+
+static void rpc_nav(Print &out, const char *args) {
+    if (!strncmp(args, "bench", 5)) {
+        long n = atol(args + 5);
+        rpc_bench(out, n > 0 ? n : NAV_BENCH_N);
+        return;
+    }
+    if (args[0]) {
+        out.println("usage: nav [bench [n]]");
+        return;
+    }
+    NavEstimate e;
+    if (nav_get(&e)) {
+        out.printf("%.7f %.7f +-%.1f m, heading %.0f, step %.2f m%s%s, fix %lu s ago\n", e.lat, e.lng, e.error_m,
+                   e.heading_deg, e.step_m, e.calibrated ? "" : " (uncalibrated)", e.stretching ? ", stretching" : "",
+                   (unsigned long)(e.fix_age_ms / 1000));
+    } else {
+        out.println("no fix yet");
+    }
+    NavFusionStats s;
+    nav_fusion_get_stats(&s);
+    out.printf("%lu steps in %lu predicts, %lu fixes (%lu reset, %lu rebased), worst %lu/%lu us\n",
+               (unsigned long)s.steps, (unsigned long)s.predicts, (unsigned long)s.fixes, (unsigned long)s.resets,
+               (unsigned long)s.rebases, (unsigned long)s.predict_us_max, (unsigned long)s.correct_us_max);
+    out.printf("stretched %lu times, %lu s in all\n", (unsigned long)s.stretches, (unsigned long)(s.stretch_ms / 1000));
+}
+
+// ===== API =====
+
+bool nav_fusion_begin() {
+    if (nav_running) {
+        return true;
+    }
+#ifdef INTEGRATION_LAYER_ENABLED
+    if (!GET_CONFIG_BOOL("nav", "enabled", true)) {
+        LOG_INFO("Nav", "Dead reckoning disabled in config");
+        return false;
+    }
+    nav_gps = GET_CONFIG_BOOL("nav", "gps", true);
+    int max_error = GET_CONFIG_INT("nav", "max_error_m", NAV_MAX_ERROR_M);
+    nav_max_var = FX_M(max_error * max_error);
+    nav_gap_ms = GET_CONFIG_INT("nav", "gap_ms", NAV_GAP_MS);
+    nav_step0 = constrain(FX_M(GET_CONFIG_INT("nav", "step_cm", NAV_STEP_CM) / 100.0), NAV_STEP_MIN, NAV_STEP_MAX);
+#endif
+    nav_running = true;
+    nav_tick_ms = millis();
+    BHI260AP_set_imu_cb(on_imu);
+    timer_wheel_init(&nav_timer, "nav", tick);
+    timer_wheel_arm(&nav_timer, NAV_TICK_MS, NAV_TICK_MS);
+    usb_console_rpc("nav", rpc_nav);
+    return true;
+}
+
+bool nav_get(NavEstimate *out) {
+    NavFilter f;
+    portENTER_CRITICAL(&nav_mux);
+    f = nav_filter;
+    out->version = nav_version;
+    out->time_ms = nav_time_ms;
+    bool origin = nav_origin;
+    portEXIT_CRITICAL(&nav_mux);
+    if (!origin) {
+        memset(out, 0, sizeof(*out));
+        return false;
+    }
+    // Doubles only on the way out
+    double m_per_e7 = NAV_M_PER_E7_Q32 / 4294967296.0;
+    double n = f.x[NX_N] / (double)FX_ONE, e = f.x[NX_E] / (double)FX_ONE;
+    out->lat = (nav_lat0_e7 + n / m_per_e7) / 1e7;
+    out->lng = (nav_lng0_e7 + e / (m_per_e7 * nav_cos_lat0 / FX_ONE)) / 1e7;
+    out->error_m = sqrtf(((int64_t)f.P[NX_E][NX_E] + f.P[NX_N][NX_N]) / (float)FX_ONE);
+    uint32_t theta = nav_psi + rad_to_bin(f.x[NX_B]);
+    out->heading_deg = theta / (float)NAV_BIN_PER_DEG;
+    out->step_m = f.x[NX_L] / (float)FX_ONE;
+    out->calibrated = f.P[NX_B][NX_B] < NAV_VAR_HEADING_OK;
+    out->stretching = nav_stretching;
+    out->fix_age_ms = millis() - nav_fix_ms;
+    return true;
+}
+
+void nav_fusion_get_stats(NavFusionStats *out) {
+    portENTER_CRITICAL(&nav_mux);
+    *out = nav_stats;
+    portEXIT_CRITICAL(&nav_mux);
+}
@@ -0,0 +1,99 @@
+/**
+ * @file      nav_fusion.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     GPS and step dead reckoning in a fixed-point EKF, stretching the GPS fix interval
+ */
+
+#ifndef NAV_FUSION_H
+#define NAV_FUSION_H
+
+#include <Arduino.h>
+
+/**
+ * A four-state extended Kalman filter, all in Q16.16 integers: east and
+ * north of an origin (m), the offset from gyro heading to true heading
+ * (rad), and step length (m).
+ *
+ * Predict runs on the sensor hub task, fed by BHI260AP_set_imu_cb() once
+ * per gyro sample of each FIFO burst. The gyro's rate about the gravity
+ * axis (from the accel sample) is integrated into a heading, so the device
+ * need not be held flat. Each new count of the hub's step counter moves
+ * the position that many step lengths along the heading. Correct runs on
+ * the timer wheel each NAV_TICK_MS when the GPS has published a new fix,
+ * with the fix's own accuracy as the measurement noise. Between them,
+ * heading drift and unmodelled motion grow the covariance with time.
+ *
+ * The gyro heading is relative, so the offset and step length are only
+ * known after a few fixes on the move. Until then the filter follows the
+ * GPS. A fix more than NAV_RESET_SIGMA deviations off restarts the
+ * position from it rather than dragging the estimate across.
+ *
+ * GPS duty: once the offset is known to NAV_HEADING_OK_DEG and the error
+ * estimate is under max_error_m, gps_power_stretch() lets every consumer's
+ * fixes come at most gap_ms apart. When the error reaches max_error_m the
+ * stretch ends and the receiver wakes for a fix. Not while moving fast
+ * (motion_service.h): steps say nothing in a vehicle or on a bicycle.
+ *
+ * nav_get() gives the fused position at any rate the UI wants. Filter
+ * steps cost a few hundred integer multiplies; "nav bench" times them.
+ *
+ * Console: "nav" for the estimate and counters, "nav bench [n]" to time
+ * predict and correct.
+ * Config section "nav": enabled (true), gps (true), max_error_m (25),
+ * gap_ms (60000), step_cm (70).
+ */
+
+#define NAV_TICK_MS                 1000
+#define NAV_MAX_ERROR_M             25      // Stretch GPS gaps while under this
+#define NAV_GAP_MS                  60000   // Longest gap between fixes
+#define NAV_STEP_CM                 70      // Initial step length
+#define NAV_HEADING_OK_DEG          10      // Offset known this well before stretching
+#define NAV_FIXES_MIN               3       // Fixes on the move before stretching
+#define NAV_STEP_IDLE_MS            10000   // No steps this long while moving: not walking
+#define NAV_RESET_SIGMA             5
+#define NAV_FIX_ACC_M               5       // When the receiver reports none (NMEA)
+#define NAV_ORIGIN_MAX_M            10000   // Re-centre the plane past this
+#define NAV_BENCH_N                 10000
+
+struct NavEstimate {
+    uint32_t version;               // 0: no fix yet
+    uint32_t time_ms;               // Last predict or correct
+    double lat, lng;
+    float error_m;                  // One sigma, horizontal
+    float heading_deg;              // True, once calibrated
+    float step_m;
+    bool calibrated;                // Heading offset known
+    bool stretching;                // GPS gaps stretched by dead reckoning
+    uint32_t fix_age_ms;
+};
+
+struct NavFusionStats {
+    uint32_t samples;               // IMU samples integrated
+    uint32_t steps;
+    uint32_t predicts;
+    uint32_t fixes;                 // Corrections
+    uint32_t resets;                // Fixes too far off to blend
+    uint32_t rebases;               // Origin moved
+    uint32_t stretches;             // Times the stretch started
+    uint32_t stretch_ms;            // Total time stretched
+    uint32_t predict_us_max;
+    uint32_t correct_us_max;
+};
+
+/**
+ * @brief Read the config, tap the hub's IMU samples and start polling fixes
+ */
+bool nav_fusion_begin();
+
+/**
+ * @brief The fused position; any task
+ * @return false until the first fix
+ */
+bool nav_get(NavEstimate *out);
+
+void nav_fusion_get_stats(NavFusionStats *out);
+
+#endif // NAV_FUSION_H
@@ -0,0 +1,403 @@
+/**
+ * @file      net_manager.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Network manager: adaptive link probes, scoring and route selection
+ */
+
+#include "net_manager.h"
+#include "peripheral.h"
+#include "modem_at.h"
+#include "modem_ppp.h"
+#include "lora_stats.h"
+#include "simple_logger.h"
+#include <WiFi.h>
+#ifdef INTEGRATION_LAYER_ENABLED
+#include "integration/event_bridge.h"
+#include "integration/config_manager.h"
+#endif
+
+#define NET_EWMA_SHIFT      3       // 1/8 of each new sample
+
+struct NetLink {
+    NetLinkStatus status;
+    uint32_t next_probe;
+};
+
+static portMUX_TYPE net_mux = portMUX_INITIALIZER_UNLOCKED;
+static NetLink net_links[NET_BEARER_COUNT];
+static volatile int net_route = NET_BEARER_NONE;
+static volatile int net_standby = NET_BEARER_NONE;
+static uint32_t net_route_since = 0;
+static net_route_cb net_cb = NULL;
+static void *net_cb_ctx = NULL;
+static TaskHandle_t net_task_handle = NULL;
+static volatile bool net_cell_changed = false;  // Set by the modem task's answers
+static const NetPeerTransport *net_transports[NET_PEER_TRANSPORTS];
+static uint8_t net_transport_count = 0;
+
+static const int32_t net_energy[NET_BEARER_COUNT] = {NET_ENERGY_WIFI, NET_ENERGY_CELL, NET_ENERGY_LORA};
+
+// Probe target for WiFi, a TCP connect is one round trip and no payload
+static String net_probe_host = "1.1.1.1";
+static uint16_t net_probe_port = 53;
+
+static inline uint32_t ewma(uint32_t avg, uint32_t sample, bool first) {
+    return first ? sample : avg + ((int32_t)(sample - avg) >> NET_EWMA_SHIFT);
+}
+
+// With net_mux held
+static void record(NetLinkStatus *s, bool ok, uint32_t rtt_ms) {
+    bool first = s->probes == 0;
+    s->probes++;
+    if (!ok) {
+        s->failures++;
+    } else {
+        s->rtt_ms = ewma(s->rtt_ms, rtt_ms, first || s->rtt_ms == 0);
+    }
+    s->loss_permille = ewma(s->loss_permille, ok ? 0 : 1000, first);
+}
+
+static int role_of(int bearer) {
+    return bearer == net_route ? 0 : (bearer == net_standby ? 1 : 2);
+}
+
+// Stable links back off; a change or failure goes back to the role's minimum
+static void schedule(int bearer, bool changed) {
+    static const uint32_t min_ms[] = {NET_ACTIVE_PROBE_MIN_MS, NET_STANDBY_PROBE_MIN_MS, NET_IDLE_PROBE_MS};
+    static const uint32_t max_ms[] = {NET_ACTIVE_PROBE_MAX_MS, NET_STANDBY_PROBE_MAX_MS, NET_IDLE_PROBE_MS};
+    int role = role_of(bearer);
+    NetLinkStatus *s = &net_links[bearer].status;
+    
+    uint32_t interval = s->probe_interval_ms * 2;
+    if (changed || interval < min_ms[role]) {
+        interval = min_ms[role];
+    } else if (interval > max_ms[role]) {
+        interval = max_ms[role];
+    }
+    s->probe_interval_ms = interval;
+    net_links[bearer].next_probe = millis() + interval;
+}
+
+static bool probe_wifi() {
+    NetLinkStatus *s = &net_links[NET_BEARER_WIFI].status;
+    if (WiFi.status() != WL_CONNECTED) {
+        // Keep a standby associated; WiFi's own auto-reconnect handles the rest
+        if (net_standby == NET_BEARER_WIFI && (WiFi.getMode() & WIFI_MODE_STA)) {
+            WiFi.reconnect();
+        }
+        bool changed = s->up;
+        s->up = false;
+        return changed;
+    }
+    
+    WiFiClient client;
+    uint32_t start = millis();
+    bool ok = client.connect(net_probe_host.c_str(), net_probe_port, NET_PROBE_TIMEOUT_MS);
+    uint32_t rtt = millis() - start;
+    client.stop();
+    
+    portENTER_CRITICAL(&net_mux);
+    bool changed = !s->up || !ok;
+    s->up = true;
+    s->signal_dbm = WiFi.RSSI();
+    record(s, ok, rtt);
+    portEXIT_CRITICAL(&net_mux);
+    return changed;
+}
+
+static void cell_csq_done(uint32_t ticket, int result, const char *response, void *ctx) {
+    NetLinkStatus *s = &net_links[NET_BEARER_CELL].status;
+    int csq = 99;
+    const char *p = strstr(response, "+CSQ:");
+    if (result == MODEM_AT_OK && p) {
+        sscanf(p, "+CSQ: %d", &csq);
+    }
+    
+    portENTER_CRITICAL(&net_mux);
+    s->signal_dbm = csq == 99 ? 0 : -113 + 2 * csq;
+    // No cheap network round trip on the modem, so weaker signal stands in for a slower link
+    uint32_t rtt = NET_CELL_RTT_MS;
+    if (s->signal_dbm && s->signal_dbm < NET_CELL_GOOD_DBM) {
+        rtt += (NET_CELL_GOOD_DBM - s->signal_dbm) * 5;
+    }
+    bool ok = result == MODEM_AT_OK && csq != 99;
+    record(s, ok, rtt);
+    portEXIT_CRITICAL(&net_mux);
+    if (!ok) {
+        net_cell_changed = true;
+    }
+}
+
+static void cell_cereg_done(uint32_t ticket, int result, const char *response, void *ctx) {
+    int n = 0;
+    int stat = 0;
+    const char *p = strstr(response, "+CEREG:");
+    if (result == MODEM_AT_OK && p) {
+        sscanf(p, "+CEREG: %d,%d", &n, &stat);
+    }
+    // Registered on the home network or roaming
+    bool up = stat == 1 || stat == 5;
+    if (up != net_links[NET_BEARER_CELL].status.up) {
+        net_cell_changed = true;
+    }
+    net_links[NET_BEARER_CELL].status.up = up;
+}
+
+// Answers arrive on the modem task, so this probe never blocks the manager and
+// reports what the previous probe's answers changed
+static bool probe_cell() {
+    NetLinkStatus *s = &net_links[NET_BEARER_CELL].status;
+    bool changed = net_cell_changed;
+    net_cell_changed = false;
+    if (!peri_init_ready(E_PERI_A7682E) || !modem_at_begin()) {
+        changed |= s->up;
+        s->up = false;
+        return changed;
+    }
+    if (!modem_at_send("+CEREG?", NET_PROBE_TIMEOUT_MS, NULL, cell_cereg_done) ||
+        !modem_at_send("+CSQ", NET_PROBE_TIMEOUT_MS, NULL, cell_csq_done)) {
+        portENTER_CRITICAL(&net_mux);
+        record(s, false, 0);
+        portEXIT_CRITICAL(&net_mux);
+        return true;
+    }
+    return changed;
+}
+
+// Nothing is sent: a probe on a 1% duty cycle would cost more than the traffic
+static bool probe_lora() {
+    NetLinkStatus *s = &net_links[NET_BEARER_LORA].status;
+    bool was_up = s->up;
+    bool up = false;
+    if (peri_init_ready(E_PERI_LORA) && lora_tx_airtime_left_ms() > 0) {
+        LoraStatsPeer peers[LORA_STATS_PEERS];
+        size_t n = lora_stats_peers(peers, LORA_STATS_PEERS);
+        uint32_t now = millis();
+        int16_t best = INT16_MIN;
+        for (size_t i = 0; i < n; i++) {
+            if (now - peers[i].last_heard < NET_LORA_PEER_MS) {
+                up = true;
+                if (peers[i].rssi_avg > best) {
+                    best = (int16_t)peers[i].rssi_avg;
+                }
+            }
+        }
+        if (up) {
+            LoraStatsSummary summary;
+            lora_stats_summary(&summary);
+            uint32_t toa_ms = lora_profile_time_on_air_us(lora_get_profile(), NET_LORA_PROBE_LEN) / 1000;
+            portENTER_CRITICAL(&net_mux);
+            s->signal_dbm = best;
+            s->rtt_ms = 2 * toa_ms;
+            s->loss_permille = summary.per_permille;
+            s->probes++;
+            portEXIT_CRITICAL(&net_mux);
+        }
+    }
+    s->up = up;
+    return up != was_up;
+}
+
+static int32_t score(int bearer) {
+    const NetLinkStatus *s = &net_links[bearer].status;
+    if (!s->up) {
+        return NET_SCORE_DOWN;
+    }
+    return s->rtt_ms / 10 + s->loss_permille / 5 + net_energy[bearer];
+}
+
+static void select_route() {
+    int best = NET_BEARER_NONE;
+    int second = NET_BEARER_NONE;
+    portENTER_CRITICAL(&net_mux);
+    for (int i = 0; i < NET_BEARER_COUNT; i++) {
+        NetLinkStatus *s = &net_links[i].status;
+        s->score = score(i);
+        if (s->score == NET_SCORE_DOWN) {
+            continue;
+        }
+        if (best < 0 || s->score < net_links[best].status.score) {
+            second = best;
+            best = i;
+        } else if (second < 0 || s->score < net_links[second].status.score) {
+            second = i;
+        }
+    }
+    portEXIT_CRITICAL(&net_mux);
+    
+    int from = net_route;
+    int to = from;
+    if (from < 0 || !net_links[from].status.up) {
+        to = best;                  // Route lost, move at once
+    } else if (best >= 0 && best != from &&
+               net_links[best].status.score + NET_SWITCH_MARGIN < net_links[from].status.score &&
+               millis() - net_route_since >= NET_HOLD_MS) {
+        to = best;
+    }
+    
+    // The standby is the best link that is not the route, warm or not
+    int standby = to == best ? second : best;
+    if (standby < 0) {
+        for (int i = 0; i < NET_BEARER_COUNT; i++) {
+            if (i != to) {
+                standby = i;
+                break;
+            }
+        }
+    }
+    if (standby != net_standby) {
+        net_standby = standby;
+        net_links[standby].next_probe = millis();
+    }
+    if (to == from) {
+        return;
+    }
+    
+    net_route = to;
+    net_route_since = millis();
+    int32_t to_score = to >= 0 ? net_links[to].status.score : NET_SCORE_DOWN;
+    LOG_INFOF("NetMgr", "Route %s -> %s (score %ld), standby %s", net_bearer_name(from), net_bearer_name(to),
+              (long)to_score, net_bearer_name(net_standby));
+    for (int i = 0; i < NET_BEARER_COUNT; i++) {
+        schedule(i, true);
+    }
+    modem_ppp_route_changed(to);
+    if (net_cb) {
+        net_cb(from, to, net_cb_ctx);
+    }
+#ifdef INTEGRATION_LAYER_ENABLED
+    if (GlobalEventBridge) {
+        NetRouteEvent ev = {(int8_t)from, (int8_t)to, (int8_t)net_standby, to_score};
+        GlobalEventBridge->publishTypedEvent(EventType::NETWORK_ROUTE_CHANGED, "NetMgr", ev, EventPriority::EVENT_HIGH);
+    }
+#endif
+}
+
+static void net_task(void *param) {
+    while (1) {
+        uint32_t now = millis();
+        // Association is free to check and WiFi is the usual route, so catch its loss at once
+        bool wifi_lost = net_links[NET_BEARER_WIFI].status.up && WiFi.status() != WL_CONNECTED;
+        for (int i = 0; i < NET_BEARER_COUNT; i++) {
+            if (!(i == NET_BEARER_WIFI && wifi_lost) && (int32_t)(now - net_links[i].next_probe) < 0) {
+                continue;
+            }
+            bool changed = false;
+            switch (i) {
+            case NET_BEARER_WIFI:
+                changed = probe_wifi();
+                break;
+            case NET_BEARER_CELL:
+                changed = probe_cell();
+                break;
+            case NET_BEARER_LORA:
+                changed = probe_lora();
+                break;
+            }
+            schedule(i, changed);
+        }
+        select_route();
+        vTaskDelay(pdMS_TO_TICKS(NET_TICK_MS));
+    }
+}
+
+#ifdef INTEGRATION_LAYER_ENABLED
+// Association, not the route: the energy profiler and anything else that cares
+// about the radio being up listens for these
+static void wifi_link_event(WiFiEvent_t event, WiFiEventInfo_t info) {
+    if (GlobalEventBridge) {
+        GlobalEventBridge->tryPublish(event == ARDUINO_EVENT_WIFI_STA_CONNECTED ? EventType::WIFI_CONNECTED
+                                                                               : EventType::WIFI_DISCONNECTED, "NetMgr");
+    }
+}
+#endif
+
+bool net_manager_begin() {
+    if (net_task_handle) {
+        return true;
+    }
+#ifdef INTEGRATION_LAYER_ENABLED
+    net_probe_host = GET_CONFIG_STRING("net", "probe_host", net_probe_host);
+    net_probe_port = GET_CONFIG_INT("net", "probe_port", net_probe_port);
+    WiFi.onEvent(wifi_link_event, ARDUINO_EVENT_WIFI_STA_CONNECTED);
+    WiFi.onEvent(wifi_link_event, ARDUINO_EVENT_WIFI_STA_DISCONNECTED);
+#endif
+
+    uint32_t now = millis();
+    for (int i = 0; i < NET_BEARER_COUNT; i++) {
+        memset(&net_links[i], 0, sizeof(net_links[i]));
+        net_links[i].status.score = NET_SCORE_DOWN;
+        net_links[i].next_probe = now;
+    }
+    if (xTaskCreate(net_task, "net_mgr", 1024 * 4, NULL, NET_TASK_PRIORITY, &net_task_handle) != pdPASS) {
+        LOG_ERROR("NetMgr", "Failed to start the network manager task");
+        return false;
+    }
+    return true;
+}
+
+int net_manager_route() {
+    return net_route;
+}
+
+int net_manager_standby() {
+    return net_standby;
+}
+
+bool net_manager_link(int bearer, NetLinkStatus *out) {
+    if (bearer < 0 || bearer >= NET_BEARER_COUNT) {
+        return false;
+    }
+    portENTER_CRITICAL(&net_mux);
+    *out = net_links[bearer].status;
+    portEXIT_CRITICAL(&net_mux);
+    return true;
+}
+
+void net_manager_on_route(net_route_cb cb, void *ctx) {
+    net_cb_ctx = ctx;
+    net_cb = cb;
+}
+
+bool net_manager_add_transport(const NetPeerTransport *transport) {
+    if (net_transport_count >= NET_PEER_TRANSPORTS) {
+        return false;
+    }
+    net_transports[net_transport_count++] = transport;
+    LOG_INFOF("NetMgr", "Peer transport %s added", transport->name);
+    return true;
+}
+
+bool net_manager_send(uint32_t peer, const uint8_t *data, size_t len) {
+    bool sent = false;
+    for (uint8_t i = 0; i < net_transport_count; i++) {
+        const NetPeerTransport *t = net_transports[i];
+        if (t->reaches(peer) && t->send(peer, data, len)) {
+            if (peer != NET_PEER_BROADCAST) {
+                return true;
+            }
+            sent = true;
+        }
+    }
+    // The last resort for a peer, and the long-range leg of a broadcast
+    if (peri_init_ready(E_PERI_LORA) && lora_tx_enqueue(data, len, LORA_TX_PRIO_NORMAL, LORA_TX_RETRIES)) {
+        sent = true;
+    }
+    return sent;
+}
+
+const char *net_bearer_name(int bearer) {
+    switch (bearer) {
+    case NET_BEARER_WIFI:
+        return "WiFi";
+    case NET_BEARER_CELL:
+        return "4G";
+    case NET_BEARER_LORA:
+        return "LoRa";
+    default:
+        return "none";
+    }
+}
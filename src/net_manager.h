@@ -0,0 +1,122 @@
+/**
+ * @file      net_manager.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Bearer scoring and failover: WiFi, 4G and LoRa with a warm standby
+ */
+
+#ifndef NET_MANAGER_H
+#define NET_MANAGER_H
+
+#include <Arduino.h>
+
+enum NetBearer {
+    NET_BEARER_NONE = -1,
+    NET_BEARER_WIFI = 0,
+    NET_BEARER_CELL,
+    NET_BEARER_LORA,
+    NET_BEARER_COUNT,
+};
+
+// Score, lower is better: rtt/10 + loss/5 + energy. A down link never scores
+#define NET_ENERGY_WIFI             10
+#define NET_ENERGY_CELL             40
+#define NET_ENERGY_LORA             80
+#define NET_SCORE_DOWN              INT32_MAX
+
+// Switching: a better link has to win by the margin, and a route is held a while
+#define NET_SWITCH_MARGIN           10
+#define NET_HOLD_MS                 30000
+
+// Probe schedule per role; a stable link backs off from min to max
+#define NET_ACTIVE_PROBE_MIN_MS     10000
+#define NET_ACTIVE_PROBE_MAX_MS     60000
+#define NET_STANDBY_PROBE_MIN_MS    30000
+#define NET_STANDBY_PROBE_MAX_MS    120000
+#define NET_IDLE_PROBE_MS           300000
+#define NET_PROBE_TIMEOUT_MS        1000
+
+// Link estimates where there is nothing cheap to measure
+#define NET_CELL_RTT_MS             80    // Plus a penalty below NET_CELL_GOOD_DBM
+#define NET_CELL_GOOD_DBM           -95
+#define NET_LORA_PROBE_LEN          32    // Airtime of this, both ways, is the RTT
+#define NET_LORA_PEER_MS            600000 // LoRa counts as up with a peer heard this recently
+
+// Peer messaging, apart from the IP route
+#define NET_PEER_BROADCAST          0xFFFFFFFFUL
+#define NET_PEER_TRANSPORTS         2
+
+#define NET_TICK_MS                 1000
+#define NET_TASK_PRIORITY           (tskIDLE_PRIORITY + 1)
+
+struct NetLinkStatus {
+    bool up;
+    uint32_t rtt_ms;                // EWMA
+    uint16_t loss_permille;         // EWMA of failed probes
+    int16_t signal_dbm;             // 0 when the bearer has none
+    int32_t score;
+    uint32_t probe_interval_ms;
+    uint32_t probes;
+    uint32_t failures;
+};
+
+// EventBridge payload for NETWORK_ROUTE_CHANGED
+struct NetRouteEvent {
+    int8_t from;
+    int8_t to;
+    int8_t standby;
+    int32_t score;
+};
+
+typedef void (*net_route_cb)(int from, int to, void *ctx);
+
+/**
+ * A carrier for payloads to other devices, addressed by node id, that is
+ * cheaper than LoRa where it reaches: ESP-NOW. Received payloads go into
+ * the LoRa RX path (lora_rx_inject), so the message store, link layers
+ * and LORA_MESSAGE_RECEIVED see them as they see radio packets
+ */
+struct NetPeerTransport {
+    const char *name;
+    bool (*reaches)(uint32_t peer);     // NET_PEER_BROADCAST: anyone at all
+    bool (*send)(uint32_t peer, const uint8_t *data, size_t len);
+};
+
+/**
+ * @brief Start the manager task. Bearers are only read, never brought up here:
+ *        the UI owns peripheral init, the manager keeps an up standby warm
+ */
+bool net_manager_begin();
+
+/**
+ * @brief Bearer new traffic should use, NET_BEARER_NONE when all are down.
+ *        MQTT reconnects on a change; a persistent session keeps subscriptions
+ */
+int net_manager_route();
+int net_manager_standby();
+bool net_manager_link(int bearer, NetLinkStatus *out);
+
+/**
+ * @brief Called on the manager task after the route changes
+ */
+void net_manager_on_route(net_route_cb cb, void *ctx = NULL);
+
+const char *net_bearer_name(int bearer);
+
+/**
+ * @brief Add a peer transport; the first added is tried first
+ */
+bool net_manager_add_transport(const NetPeerTransport *transport);
+
+/**
+ * @brief Send a payload, as a LoRa packet would carry it, to a peer: over
+ *        the first transport that reaches it, LoRa otherwise. A broadcast
+ *        goes out on every transport that reaches anyone and on LoRa for
+ *        the devices out of their range; receivers keep the first copy
+ * @return false if no carrier took it
+ */
+bool net_manager_send(uint32_t peer, const uint8_t *data, size_t len);
+
+#endif // NET_MANAGER_H
@@ -0,0 +1,556 @@
+/**
+ * @file      ota_patch.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Streaming delta patcher: LZSS decoder, bsdiff steps, sector writer and checkpoints
+ */
+
+#include "ota_patch.h"
+#include <esp_ota_ops.h>
+#include <esp_partition.h>
+#include <mbedtls/md.h>
+#include <Preferences.h>
+#include "simple_logger.h"
+#include "asset_store.h"
+#ifdef INTEGRATION_LAYER_ENABLED
+#include "integration/config_manager.h"
+#endif
+
+static_assert(sizeof(OtaPatchHeader) == 116, "Patch header is part of the file format");
+
+#define OTA_WINDOW_SIZE     (1 << OTA_PATCH_WINDOW_BITS)
+#define OTA_CTRL_SIZE       12      // diff u32, extra u32, seek i32, little-endian
+
+// Decoder states
+enum {
+    INF_TAG = 0,
+    INF_LITERAL,
+    INF_INDEX,
+    INF_COUNT,
+    INF_COPY,
+};
+
+// Step parser states
+enum {
+    OPS_CTRL = 0,
+    OPS_DIFF,
+    OPS_EXTRA,
+};
+
+// heatshrink-format LZSS decoder; plain data, so it can be checkpointed
+struct OtaInflate {
+    uint8_t window[OTA_WINDOW_SIZE];
+    uint16_t head;                  // Next window slot
+    uint16_t value;                 // Bits of the field being read
+    uint16_t index;                 // Back-reference distance - 1
+    uint16_t copy_left;
+    uint8_t state;
+    uint8_t need;                   // Bits still missing from the field
+    uint8_t in_byte;
+    uint8_t in_bits;                // Bits of in_byte not used yet
+};
+
+struct OtaOps {
+    uint8_t state;
+    uint8_t ctrl_len;
+    uint8_t ctrl[OTA_CTRL_SIZE];
+    uint32_t left;                  // Of the diff or extra run
+    uint32_t extra;                 // Extra run after the diff
+    int32_t seek;
+    uint32_t src_pos;
+};
+
+// Saved right after a sector is written, so target_done is a sector multiple
+struct OtaCheckpoint {
+    uint8_t target_sha256[32];      // Which patch it belongs to
+    uint32_t body_done;
+    uint32_t target_done;
+    OtaOps ops;
+    OtaInflate inflate;
+};
+
+static OtaPatchHeader ota_header;
+static const esp_partition_t *ota_slot = nullptr;
+static const esp_partition_t *ota_running = nullptr;
+static bool ota_active = false;
+static bool ota_complete = false;
+static uint32_t ota_resumed_from = 0;
+
+// Checkpointed
+static OtaCheckpoint ota_state;
+
+static mbedtls_md_context_t ota_sha;
+static bool ota_sha_ready = false;
+static uint8_t *ota_page = nullptr;            // Sector being filled
+static uint8_t *ota_src_cache = nullptr;
+static uint32_t ota_src_cache_base = UINT32_MAX;
+
+// ===== Hashing and authentication =====
+
+static bool sha_start() {
+    if (ota_sha_ready) {
+        mbedtls_md_free(&ota_sha);
+    }
+    mbedtls_md_init(&ota_sha);
+    ota_sha_ready = mbedtls_md_setup(&ota_sha, mbedtls_md_info_from_type(MBEDTLS_MD_SHA256), 0) == 0 &&
+                    mbedtls_md_starts(&ota_sha) == 0;
+    return ota_sha_ready;
+}
+
+// SHA-256 of a partition's first len bytes, continuing ota_sha
+static bool sha_partition(const esp_partition_t *part, uint32_t len, uint8_t *buf) {
+    for (uint32_t off = 0; off < len; off += OTA_PATCH_SECTOR) {
+        uint32_t n = min((uint32_t)OTA_PATCH_SECTOR, len - off);
+        if (esp_partition_read(part, off, buf, n) != ESP_OK) {
+            return false;
+        }
+        mbedtls_md_update(&ota_sha, buf, n);
+    }
+    return true;
+}
+
+static bool hex_to_bytes(const char *hex, uint8_t *out, size_t len) {
+    if (strlen(hex) != len * 2) {
+        return false;
+    }
+    for (size_t i = 0; i < len; i++) {
+        char byte[3] = {hex[i * 2], hex[i * 2 + 1], '\0'};
+        char *end;
+        out[i] = strtoul(byte, &end, 16);
+        if (*end) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static int header_authenticate(const OtaPatchHeader *header) {
+    uint8_t key[32];
+    bool have_key = false;
+    bool allow_unsigned = false;
+#ifdef INTEGRATION_LAYER_ENABLED
+    String hex = GET_CONFIG_STRING("ota", "key", String(""));
+    have_key = hex.length() && hex_to_bytes(hex.c_str(), key, sizeof(key));
+    allow_unsigned = GET_CONFIG_BOOL("ota", "allow_unsigned", false);
+#endif
+    if (!have_key) {
+        uint8_t zero[32] = {0};
+        return allow_unsigned && !memcmp(header->mac, zero, sizeof(zero)) ? OTA_PATCH_OK : OTA_PATCH_ERR_AUTH;
+    }
+
+    uint8_t mac[32];
+    mbedtls_md_hmac(mbedtls_md_info_from_type(MBEDTLS_MD_SHA256), key, sizeof(key),
+                    (const uint8_t *)header, offsetof(OtaPatchHeader, mac), mac);
+    uint8_t diff = 0;
+    for (size_t i = 0; i < sizeof(mac); i++) {
+        diff |= mac[i] ^ header->mac[i];
+    }
+    return diff ? OTA_PATCH_ERR_AUTH : OTA_PATCH_OK;
+}
+
+// ===== Output =====
+
+static void checkpoint_save() {
+    Preferences prefs;
+    if (prefs.begin(OTA_PATCH_NVS_NAMESPACE, false)) {
+        prefs.putBytes("ckpt", &ota_state, sizeof(ota_state));
+        prefs.end();
+    }
+}
+
+static bool checkpoint_load(OtaCheckpoint *out) {
+    Preferences prefs;
+    if (!prefs.begin(OTA_PATCH_NVS_NAMESPACE, true)) {
+        return false;
+    }
+    bool ok = prefs.getBytes("ckpt", out, sizeof(*out)) == sizeof(*out);
+    prefs.end();
+    return ok;
+}
+
+// The sector is erased only now, so a resumed patch simply writes it again
+static int page_flush() {
+    uint32_t len = ota_state.target_done % OTA_PATCH_SECTOR;
+    len = len ? len : OTA_PATCH_SECTOR;
+    uint32_t base = ota_state.target_done - len;
+    if (esp_partition_erase_range(ota_slot, base, OTA_PATCH_SECTOR) != ESP_OK ||
+        esp_partition_write(ota_slot, base, ota_page, len) != ESP_OK) {
+        return OTA_PATCH_ERR_FLASH;
+    }
+    mbedtls_md_update(&ota_sha, ota_page, len);
+
+    if (ota_state.target_done % OTA_PATCH_CHECKPOINT == 0 && ota_state.target_done < ota_header.target_size) {
+        checkpoint_save();
+    }
+    return OTA_PATCH_MORE;
+}
+
+static int out_put(uint8_t b) {
+    ota_page[ota_state.target_done % OTA_PATCH_SECTOR] = b;
+    ota_state.target_done++;
+    bool last = ota_state.target_done == ota_header.target_size;
+    if (ota_state.target_done % OTA_PATCH_SECTOR == 0 || last) {
+        int r = page_flush();
+        if (r != OTA_PATCH_MORE) {
+            return r;
+        }
+    }
+    if (last) {
+        ota_complete = true;
+        return OTA_PATCH_OK;
+    }
+    return OTA_PATCH_MORE;
+}
+
+static int source_byte(uint32_t pos, uint8_t *b) {
+    if (pos >= ota_header.source_size) {
+        return OTA_PATCH_ERR_DATA;
+    }
+    uint32_t base = pos & ~(uint32_t)(OTA_PATCH_SECTOR - 1);
+    if (base != ota_src_cache_base) {
+        uint32_t n = min((uint32_t)OTA_PATCH_SECTOR, ota_header.source_size - base);
+        if (esp_partition_read(ota_running, base, ota_src_cache, n) != ESP_OK) {
+            return OTA_PATCH_ERR_FLASH;
+        }
+        ota_src_cache_base = base;
+    }
+    *b = ota_src_cache[pos - base];
+    return OTA_PATCH_MORE;
+}
+
+// ===== bsdiff steps =====
+
+static uint32_t get_le32(const uint8_t *p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// State moves on before the byte goes out: out_put may checkpoint
+static int ops_put(uint8_t b) {
+    OtaOps &ops = ota_state.ops;
+    switch (ops.state) {
+    case OPS_CTRL: {
+        ops.ctrl[ops.ctrl_len++] = b;
+        if (ops.ctrl_len < OTA_CTRL_SIZE) {
+            return OTA_PATCH_MORE;
+        }
+        ops.ctrl_len = 0;
+        uint32_t diff = get_le32(ops.ctrl);
+        ops.extra = get_le32(ops.ctrl + 4);
+        ops.seek = (int32_t)get_le32(ops.ctrl + 8);
+        if ((uint64_t)ota_state.target_done + diff + ops.extra > ota_header.target_size) {
+            return OTA_PATCH_ERR_DATA;
+        }
+        if (diff) {
+            ops.state = OPS_DIFF;
+            ops.left = diff;
+        } else if (ops.extra) {
+            ops.state = OPS_EXTRA;
+            ops.left = ops.extra;
+        } else {
+            ops.src_pos += ops.seek;
+        }
+        return OTA_PATCH_MORE;
+    }
+    case OPS_DIFF: {
+        uint8_t s;
+        int r = source_byte(ops.src_pos, &s);
+        if (r != OTA_PATCH_MORE) {
+            return r;
+        }
+        ops.src_pos++;
+        if (!--ops.left) {
+            if (ops.extra) {
+                ops.state = OPS_EXTRA;
+                ops.left = ops.extra;
+            } else {
+                ops.src_pos += ops.seek;
+                ops.state = OPS_CTRL;
+            }
+        }
+        return out_put(b + s);
+    }
+    case OPS_EXTRA:
+        if (!--ops.left) {
+            ops.src_pos += ops.seek;
+            ops.state = OPS_CTRL;
+        }
+        return out_put(b);
+    }
+    return OTA_PATCH_ERR_DATA;
+}
+
+// ===== LZSS =====
+
+static int inflate_emit(uint8_t b) {
+    OtaInflate &inf = ota_state.inflate;
+    inf.window[inf.head] = b;
+    inf.head = (inf.head + 1) & (OTA_WINDOW_SIZE - 1);
+    return ops_put(b);
+}
+
+// Runs the decoder until it wants another input byte
+static int inflate_run() {
+    OtaInflate &inf = ota_state.inflate;
+    while (true) {
+        if (inf.state == INF_COPY) {
+            uint8_t b = inf.window[(inf.head - inf.index - 1) & (OTA_WINDOW_SIZE - 1)];
+            if (!--inf.copy_left) {
+                inf.state = INF_TAG;
+            }
+            int r = inflate_emit(b);
+            if (r != OTA_PATCH_MORE) {
+                return r;
+            }
+            continue;
+        }
+        if (!inf.in_bits) {
+            return OTA_PATCH_MORE;
+        }
+        uint8_t bit = (inf.in_byte >> --inf.in_bits) & 1;
+
+        if (inf.state == INF_TAG) {
+            inf.state = bit ? INF_LITERAL : INF_INDEX;
+            inf.need = bit ? 8 : OTA_PATCH_WINDOW_BITS;
+            inf.value = 0;
+            continue;
+        }
+        inf.value = (inf.value << 1) | bit;
+        if (--inf.need) {
+            continue;
+        }
+        if (inf.state == INF_LITERAL) {
+            inf.state = INF_TAG;
+            int r = inflate_emit(inf.value);
+            if (r != OTA_PATCH_MORE) {
+                return r;
+            }
+        } else if (inf.state == INF_INDEX) {
+            inf.index = inf.value;
+            inf.state = INF_COUNT;
+            inf.need = OTA_PATCH_LOOKAHEAD_BITS;
+            inf.value = 0;
+        } else {
+            inf.copy_left = inf.value + 1;
+            inf.state = INF_COPY;
+        }
+    }
+}
+
+// ===== API =====
+
+static void ota_release() {
+    free(ota_page);
+    free(ota_src_cache);
+    ota_page = nullptr;
+    ota_src_cache = nullptr;
+    ota_src_cache_base = UINT32_MAX;
+    if (ota_sha_ready) {
+        mbedtls_md_free(&ota_sha);
+        ota_sha_ready = false;
+    }
+    ota_active = false;
+}
+
+// Source and target slot: the app's OTA slots, or the asset pack's
+static bool patch_slots(const OtaPatchHeader *header, const esp_partition_t **running,
+                        const esp_partition_t **slot) {
+    if (header->flags & OTA_PATCH_FLAG_ASSETS) {
+        *running = asset_store_partition();
+        *slot = asset_store_spare();
+    } else {
+        *running = esp_ota_get_running_partition();
+        *slot = esp_ota_get_next_update_partition(NULL);
+    }
+    // A full image needs no source, so a first asset pack can go in this way
+    if (header->source_size && (!*running || header->source_size > (*running)->size)) {
+        return false;
+    }
+    return *slot && *slot != *running && header->target_size <= (*slot)->size;
+}
+
+int ota_patch_check(const OtaPatchHeader *header) {
+    if (header->magic != OTA_PATCH_MAGIC || header->version != OTA_PATCH_VERSION ||
+        header->window_bits != OTA_PATCH_WINDOW_BITS || header->lookahead_bits != OTA_PATCH_LOOKAHEAD_BITS ||
+        (header->flags & ~OTA_PATCH_FLAG_ASSETS) || !header->target_size || !header->body_size) {
+        return OTA_PATCH_ERR_HEADER;
+    }
+    int r = header_authenticate(header);
+    if (r != OTA_PATCH_OK) {
+        return r;
+    }
+    const esp_partition_t *running;
+    const esp_partition_t *slot;
+    if (!patch_slots(header, &running, &slot)) {
+        return OTA_PATCH_ERR_SLOT;
+    }
+    if (!header->source_size) {
+        return OTA_PATCH_OK;
+    }
+
+    // Made against this build? Reads the running image once, on its own
+    // hash so a patch being applied is not disturbed
+    uint8_t *buf = (uint8_t *)malloc(OTA_PATCH_SECTOR);
+    if (!buf) {
+        return OTA_PATCH_ERR_STATE;
+    }
+    mbedtls_md_context_t ctx;
+    mbedtls_md_init(&ctx);
+    bool ok = mbedtls_md_setup(&ctx, mbedtls_md_info_from_type(MBEDTLS_MD_SHA256), 0) == 0 &&
+              mbedtls_md_starts(&ctx) == 0;
+    for (uint32_t off = 0; ok && off < header->source_size; off += OTA_PATCH_SECTOR) {
+        uint32_t n = min((uint32_t)OTA_PATCH_SECTOR, header->source_size - off);
+        ok = esp_partition_read(running, off, buf, n) == ESP_OK && mbedtls_md_update(&ctx, buf, n) == 0;
+    }
+    uint8_t sha[32];
+    ok = ok && mbedtls_md_finish(&ctx, sha) == 0;
+    mbedtls_md_free(&ctx);
+    free(buf);
+    if (!ok) {
+        return OTA_PATCH_ERR_FLASH;
+    }
+    return memcmp(sha, header->source_sha256, sizeof(sha)) ? OTA_PATCH_ERR_SOURCE : OTA_PATCH_OK;
+}
+
+int ota_patch_begin(const OtaPatchHeader *header, uint32_t *body_offset) {
+    ota_patch_abort();
+    *body_offset = 0;
+    int r = ota_patch_check(header);
+    if (r != OTA_PATCH_OK) {
+        return r;
+    }
+    patch_slots(header, &ota_running, &ota_slot);
+
+    ota_page = (uint8_t *)malloc(OTA_PATCH_SECTOR);
+    ota_src_cache = (uint8_t *)malloc(OTA_PATCH_SECTOR);
+    if (!ota_page || !ota_src_cache || !sha_start()) {
+        ota_release();
+        return OTA_PATCH_ERR_STATE;
+    }
+    ota_header = *header;
+    ota_complete = false;
+    ota_resumed_from = 0;
+
+    // Same patch as the checkpoint: what was written is hashed again and kept
+    if (checkpoint_load(&ota_state) &&
+        !memcmp(ota_state.target_sha256, header->target_sha256, sizeof(header->target_sha256)) &&
+        ota_state.target_done % OTA_PATCH_SECTOR == 0 && ota_state.target_done < header->target_size &&
+        ota_state.body_done <= header->body_size) {
+        if (!sha_partition(ota_slot, ota_state.target_done, ota_page)) {
+            ota_release();
+            return OTA_PATCH_ERR_FLASH;
+        }
+        ota_resumed_from = ota_state.body_done;
+        *body_offset = ota_state.body_done;
+        LOG_INFOF("OTA", "Resuming at %lu of %lu patch bytes, %lu written", (unsigned long)ota_state.body_done,
+                  (unsigned long)header->body_size, (unsigned long)ota_state.target_done);
+    } else {
+        memset(&ota_state, 0, sizeof(ota_state));
+        memcpy(ota_state.target_sha256, header->target_sha256, sizeof(ota_state.target_sha256));
+    }
+
+    ota_active = true;
+    // The rest of the input byte the checkpoint was taken in
+    r = inflate_run();
+    if (r != OTA_PATCH_MORE && r != OTA_PATCH_OK) {
+        ota_release();
+        return r;
+    }
+    return OTA_PATCH_OK;
+}
+
+int ota_patch_feed(const uint8_t *data, size_t len) {
+    if (!ota_active) {
+        return OTA_PATCH_ERR_STATE;
+    }
+    for (size_t i = 0; i < len && !ota_complete; i++) {
+        if (ota_state.body_done >= ota_header.body_size) {
+            return OTA_PATCH_ERR_DATA;
+        }
+        // Counted as consumed once loaded, along with the bits left of it
+        ota_state.inflate.in_byte = data[i];
+        ota_state.inflate.in_bits = 8;
+        ota_state.body_done++;
+        int r = inflate_run();
+        if (r != OTA_PATCH_MORE && r != OTA_PATCH_OK) {
+            LOG_ERRORF("OTA", "Patch failed at %lu: %s", (unsigned long)ota_state.body_done,
+                       ota_patch_result_name(r));
+            ota_release();
+            return r;
+        }
+    }
+    return ota_complete ? OTA_PATCH_OK : OTA_PATCH_MORE;
+}
+
+int ota_patch_finish() {
+    if (!ota_active || !ota_complete) {
+        return OTA_PATCH_ERR_STATE;
+    }
+    uint8_t sha[32];
+    bool ok = mbedtls_md_finish(&ota_sha, sha) == 0 &&
+              !memcmp(sha, ota_header.target_sha256, sizeof(sha));
+    ota_release();
+    // A finished patch is never resumed, whatever the outcome
+    ota_patch_discard();
+    if (!ok) {
+        LOG_ERROR("OTA", "Image hash mismatch");
+        return OTA_PATCH_ERR_VERIFY;
+    }
+    if (ota_header.flags & OTA_PATCH_FLAG_ASSETS) {
+        if (!asset_store_set_boot(ota_slot)) {
+            return OTA_PATCH_ERR_VERIFY;
+        }
+        LOG_INFOF("OTA", "Asset pack of %lu bytes in %s, used from the next reset",
+                  (unsigned long)ota_header.target_size, ota_slot->label);
+        return OTA_PATCH_OK;
+    }
+    // Checks the image format and its own digest too
+    esp_err_t err = esp_ota_set_boot_partition(ota_slot);
+    if (err != ESP_OK) {
+        LOG_ERRORF("OTA", "Slot %s rejected: %s", ota_slot->label, esp_err_to_name(err));
+        return OTA_PATCH_ERR_VERIFY;
+    }
+    LOG_INFOF("OTA", "%lu bytes in %s, boots on the next reset", (unsigned long)ota_header.target_size,
+              ota_slot->label);
+    return OTA_PATCH_OK;
+}
+
+void ota_patch_abort() {
+    if (ota_active) {
+        ota_release();
+    }
+}
+
+void ota_patch_discard() {
+    Preferences prefs;
+    if (prefs.begin(OTA_PATCH_NVS_NAMESPACE, false)) {
+        prefs.remove("ckpt");
+        prefs.end();
+    }
+}
+
+void ota_patch_get_progress(OtaPatchProgress *out) {
+    out->active = ota_active;
+    out->body_done = ota_state.body_done;
+    out->body_size = ota_header.body_size;
+    out->target_done = ota_state.target_done;
+    out->target_size = ota_header.target_size;
+    out->resumed_from = ota_resumed_from;
+}
+
+const char *ota_patch_result_name(int result) {
+    switch (result) {
+    case OTA_PATCH_OK:          return "ok";
+    case OTA_PATCH_MORE:        return "more";
+    case OTA_PATCH_ERR_HEADER:  return "bad header";
+    case OTA_PATCH_ERR_AUTH:    return "not authenticated";
+    case OTA_PATCH_ERR_SOURCE:  return "made for another build";
+    case OTA_PATCH_ERR_SLOT:    return "no room";
+    case OTA_PATCH_ERR_FLASH:   return "flash error";
+    case OTA_PATCH_ERR_DATA:    return "corrupt data";
+    case OTA_PATCH_ERR_VERIFY:  return "verify failed";
+    case OTA_PATCH_ERR_STATE:   return "not started";
+    default:                    return "?";
+    }
+}
@@ -0,0 +1,120 @@
+/**
+ * @file      ota_patch.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Streaming delta patcher: compressed binary diff against the running app into the other slot
+ */
+
+#ifndef OTA_PATCH_H
+#define OTA_PATCH_H
+
+#include <Arduino.h>
+
+/**
+ * A patch is this header and then an LZSS-compressed (heatshrink format)
+ * stream of bsdiff-style steps: a control triple (diff, extra, seek),
+ * diff bytes added to the source at the read position, extra bytes taken
+ * as they are, then the read position moves by seek. script/ota_diff.py
+ * builds one from two firmware.bin files.
+ *
+ * Bytes can arrive in pieces of any size, from any transport. Output
+ * goes to the inactive OTA slot a flash sector at a time, erased just
+ * before it is written. Every OTA_PATCH_CHECKPOINT bytes of output the
+ * decoder state is saved to NVS; after a reset the same patch carries on
+ * from the input offset ota_patch_begin() returns. The SHA-256 of the
+ * output is checked against the header before the slot is made bootable.
+ *
+ * With OTA_PATCH_FLAG_ASSETS the same applies to the asset pack
+ * (asset_store.h): the mapped pack is the source, the other asset slot
+ * the target, and finishing marks that slot for the next reset.
+ *
+ * Headers carry an HMAC-SHA256 under the fleet key (config ota.key, hex).
+ * Without a key only unsigned patches pass, and only with
+ * ota.allow_unsigned set.
+ */
+
+#define OTA_PATCH_MAGIC             0x44504454  // "TDPD"
+#define OTA_PATCH_VERSION           1
+#define OTA_PATCH_WINDOW_BITS       10      // LZSS window, 1 KB of RAM
+#define OTA_PATCH_LOOKAHEAD_BITS    4
+#define OTA_PATCH_SECTOR            4096
+#define OTA_PATCH_CHECKPOINT        (64 * 1024)
+#define OTA_PATCH_NVS_NAMESPACE     "ota"
+#define OTA_PATCH_FLAG_ASSETS       0x01    // Asset pack instead of the app
+
+struct OtaPatchHeader {
+    uint32_t magic;
+    uint8_t version;
+    uint8_t window_bits;
+    uint8_t lookahead_bits;
+    uint8_t flags;                  // OTA_PATCH_FLAG_*
+    uint32_t source_size;           // Bytes of the running app or pack the diff is against, 0 for a full image
+    uint32_t target_size;
+    uint32_t body_size;             // Compressed bytes after the header
+    uint8_t source_sha256[32];
+    uint8_t target_sha256[32];
+    uint8_t mac[32];                // HMAC-SHA256 of everything above, all zero when unsigned
+};
+
+enum OtaPatchResult {
+    OTA_PATCH_OK = 0,
+    OTA_PATCH_MORE,                 // Fed fine, output not complete yet
+    OTA_PATCH_ERR_HEADER,           // Bad magic, version or parameters
+    OTA_PATCH_ERR_AUTH,             // MAC missing or wrong
+    OTA_PATCH_ERR_SOURCE,           // Made against another build than the one running
+    OTA_PATCH_ERR_SLOT,             // No inactive slot, or it is too small
+    OTA_PATCH_ERR_FLASH,
+    OTA_PATCH_ERR_DATA,             // Steps point outside the source or the target
+    OTA_PATCH_ERR_VERIFY,           // Output hash does not match
+    OTA_PATCH_ERR_STATE,            // Not begun, or already finished
+};
+
+struct OtaPatchProgress {
+    bool active;
+    uint32_t body_done;             // Compressed bytes consumed
+    uint32_t body_size;
+    uint32_t target_done;           // Bytes written to the slot
+    uint32_t target_size;
+    uint32_t resumed_from;          // Body offset picked up after a reset, 0 when fresh
+};
+
+/**
+ * @brief Check a header: format, MAC, slot size and that it was made
+ *        against the running build. Safe while another patch is applied
+ */
+int ota_patch_check(const OtaPatchHeader *header);
+
+/**
+ * @brief Check a header and set up for its body. With a checkpoint of this
+ *        same patch, carries on from it
+ * @param body_offset Where the body has to continue from; 0 unless resumed
+ */
+int ota_patch_begin(const OtaPatchHeader *header, uint32_t *body_offset);
+
+/**
+ * @brief Feed the next body bytes
+ * @return OTA_PATCH_MORE until the whole target is written, then OTA_PATCH_OK
+ */
+int ota_patch_feed(const uint8_t *data, size_t len);
+
+/**
+ * @brief Verify the written image and boot from it on the next reset
+ */
+int ota_patch_finish();
+
+/**
+ * @brief Stop; the checkpoint stays so the same patch can resume later
+ */
+void ota_patch_abort();
+
+/**
+ * @brief Forget the checkpoint, e.g. for a patch that keeps failing
+ */
+void ota_patch_discard();
+
+void ota_patch_get_progress(OtaPatchProgress *out);
+const char *ota_patch_result_name(int result);
+
+#endif // OTA_PATCH_H
@@ -0,0 +1,742 @@
+/**
+ * @file      ota_update.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Patch transports: ranged HTTP with resume, files, and a LoRa
+ *            multicast carousel
+ */
+
+#include "ota_update.h"
+#include <HTTPClient.h>
+#include <SD.h>
+#include <LittleFS.h>
+#include <Preferences.h>
+#include <esp_ota_ops.h>
+#include "simple_logger.h"
+#include "spi_bus.h"
+#include "fs_service.h"
+#include "sd_manager.h"
+#include "peripheral.h"
+#include "mqtt_client.h"
+#include "tls_client.h"
+#include "config/os_config.h"
+#ifdef INTEGRATION_LAYER_ENABLED
+#include "integration/config_manager.h"
+#endif
+
+static_assert(sizeof(OtaLoraAnnounce) <= LORA_PACKET_MAX, "Announcement must fit one packet");
+static_assert(sizeof(OtaLoraData) + OTA_LORA_BLOCK <= LORA_PACKET_MAX, "Data frame must fit one packet");
+
+enum OtaJobType {
+    OTA_JOB_URL = 0,
+    OTA_JOB_FILE,
+    OTA_JOB_SERVE,
+};
+
+struct OtaJob {
+    uint8_t type;
+    uint8_t rounds;
+    bool sd;
+    char path[OTA_URL_MAX + 1];
+};
+
+struct OtaLoraFrame {
+    uint16_t len;
+    uint8_t data[LORA_PACKET_MAX];
+};
+
+// OTA_LORA_MAP_FILE: this, then one bit per block
+struct OtaLoraMap {
+    uint8_t target_sha256[32];
+    uint16_t blocks;
+    uint16_t have;
+};
+
+static portMUX_TYPE ota_mux = portMUX_INITIALIZER_UNLOCKED;
+static OtaStatus ota_status;
+static bool ota_busy = false;                   // A job or a LoRa apply owns the patcher
+static OtaJob ota_job;
+static bool ota_reboot = true;
+
+static QueueHandle_t lora_queue = nullptr;
+static TaskHandle_t lora_task_handle = nullptr;
+static OtaLoraMap lora_map;
+static uint8_t *lora_bits = nullptr;
+static bool lora_collecting = false;
+static bool lora_on_sd = false;
+static bool lora_session_known = false;
+static uint16_t lora_session = 0;
+static uint16_t lora_unsaved = 0;
+static uint8_t lora_rejected[32];               // Target of the last header that failed its check
+
+// Card files hold the SPI bus; LittleFS lives on the internal flash
+class OtaFsHold {
+public:
+    explicit OtaFsHold(bool sd) : sd(sd) { if (sd) spi_bus_acquire(SPI_CLIENT_SD); }
+    ~OtaFsHold() { if (sd) spi_bus_release(SPI_CLIENT_SD); }
+    OtaFsHold(const OtaFsHold&) = delete;
+    OtaFsHold& operator=(const OtaFsHold&) = delete;
+private:
+    bool sd;
+};
+
+// Patch files go to the card when there is one
+static fs::FS *ota_fs(bool *sd) {
+    *sd = sd_manager_mounted();
+    if (*sd) {
+        return &SD;
+    }
+    return LittleFS.begin(false) ? &LittleFS : nullptr;
+}
+
+static inline fs::FS *ota_fs_for(bool sd) {
+    return sd ? (fs::FS *)&SD : (fs::FS *)&LittleFS;
+}
+
+// ===== State =====
+
+static bool job_claim(uint8_t state) {
+    portENTER_CRITICAL(&ota_mux);
+    bool ok = !ota_busy;
+    if (ok) {
+        ota_busy = true;
+        ota_status.state = state;
+    }
+    portEXIT_CRITICAL(&ota_mux);
+    return ok;
+}
+
+static void set_state(uint8_t state) {
+    portENTER_CRITICAL(&ota_mux);
+    ota_status.state = state;
+    portEXIT_CRITICAL(&ota_mux);
+}
+
+static void save_url(const char *url) {
+    Preferences prefs;
+    if (prefs.begin(OTA_PATCH_NVS_NAMESPACE, false)) {
+        if (url) {
+            prefs.putString("url", url);
+        } else {
+            prefs.remove("url");
+        }
+        prefs.end();
+    }
+}
+
+// OTA_PATCH_MORE means stopped short with the checkpoint kept; anything but
+// OK after that will not get better by trying the same patch again
+static void job_finish(int r, bool apply) {
+    if (apply && r != OTA_PATCH_MORE) {
+        if (r != OTA_PATCH_OK) {
+            ota_patch_discard();
+        }
+        save_url(nullptr);
+    }
+    portENTER_CRITICAL(&ota_mux);
+    ota_status.last_result = r;
+    ota_status.state = r == OTA_PATCH_OK ? (apply ? OTA_DONE : OTA_IDLE) : OTA_FAILED;
+    ota_busy = false;
+    portEXIT_CRITICAL(&ota_mux);
+
+    if (r != OTA_PATCH_OK) {
+        LOG_WARNF("OTA", "Stopped: %s%s", ota_patch_result_name(r),
+                  r == OTA_PATCH_MORE ? ", will resume" : "");
+    } else if (apply) {
+        LOG_INFO("OTA", "New image verified, boots next");
+        if (ota_reboot) {
+            vTaskDelay(pdMS_TO_TICKS(OTA_REBOOT_DELAY_MS));
+            ESP.restart();
+        }
+    }
+}
+
+// ===== HTTP =====
+
+typedef int (*ota_sink_t)(const uint8_t *data, size_t len, void *ctx);
+
+// ctx points at the write position
+static int copy_sink(const uint8_t *data, size_t len, void *ctx) {
+    uint8_t **pos = (uint8_t **)ctx;
+    memcpy(*pos, data, len);
+    *pos += len;
+    return OTA_PATCH_MORE;
+}
+
+static int body_sink(const uint8_t *data, size_t len, void *ctx) {
+    return ota_patch_feed(data, len);
+}
+
+/**
+ * One GET for bytes [from, from + len). *got counts what reached the sink,
+ * so the next try knows where to pick up. OTA_PATCH_OK once all len bytes
+ * are through, OTA_PATCH_MORE when the connection gave out first, or
+ * whatever the sink failed with. The connection stays open for the next
+ * GET when the server keeps it alive and the response was read to its end
+ */
+static int http_fetch(HTTPClient &http, WiFiClient &client, const char *url, uint32_t from, uint32_t len,
+                      uint8_t *buf, ota_sink_t sink, void *ctx, uint32_t *got) {
+    if (!http.begin(client, url)) {
+        return OTA_PATCH_MORE;
+    }
+    char range[40];
+    snprintf(range, sizeof(range), "bytes=%lu-%lu", (unsigned long)(from + *got),
+             (unsigned long)(from + len - 1));
+    http.addHeader("Range", range);
+    int code = http.GET();
+
+    // A server that ignores ranges sends everything; skip to the wanted part
+    uint32_t skip = 0;
+    if (code == HTTP_CODE_OK) {
+        skip = from + *got;
+    } else if (code != HTTP_CODE_PARTIAL_CONTENT) {
+        LOG_WARNF("OTA", "HTTP %d for %s", code, url);
+        client.stop();
+        http.end();
+        return OTA_PATCH_MORE;
+    }
+
+    WiFiClient *stream = http.getStreamPtr();
+    int r = OTA_PATCH_MORE;
+    while (*got < len) {
+        size_t want = skip ? min(skip, (uint32_t)OTA_READ_CHUNK) : min(len - *got, (uint32_t)OTA_READ_CHUNK);
+        size_t n = stream->readBytes(buf, want);   // Waits up to the timeout
+        if (!n) {
+            break;
+        }
+        if (skip) {
+            skip -= n;
+            continue;
+        }
+        r = sink(buf, n, ctx);
+        *got += n;
+        if (r != OTA_PATCH_MORE && r != OTA_PATCH_OK) {
+            break;
+        }
+    }
+    // Anything left of the body would be read as the next response
+    if (code != HTTP_CODE_PARTIAL_CONTENT || *got < len || (r != OTA_PATCH_MORE && r != OTA_PATCH_OK)) {
+        client.stop();
+    }
+    http.end();
+    if (r != OTA_PATCH_MORE && r != OTA_PATCH_OK) {
+        return r;
+    }
+    return *got >= len ? OTA_PATCH_OK : OTA_PATCH_MORE;
+}
+
+// Tries again while it gets anywhere; OTA_HTTP_RETRIES fruitless tries in a row end it
+static int http_fetch_retry(HTTPClient &http, WiFiClient &client, const char *url, uint32_t from, uint32_t len,
+                            uint8_t *buf, ota_sink_t sink, void *ctx) {
+    uint32_t got = 0;
+    int fails = 0;
+    for (;;) {
+        uint32_t before = got;
+        int r = http_fetch(http, client, url, from, len, buf, sink, ctx, &got);
+        if (r != OTA_PATCH_MORE) {
+            return r;
+        }
+        fails = got > before ? 0 : fails + 1;
+        if (fails >= OTA_HTTP_RETRIES) {
+            return OTA_PATCH_MORE;
+        }
+        vTaskDelay(pdMS_TO_TICKS(min(1000UL << fails, 60000UL)));
+    }
+}
+
+static int run_url(const char *url) {
+    uint8_t *buf = (uint8_t *)malloc(OTA_READ_CHUNK);
+    if (!buf) {
+        return OTA_PATCH_MORE;
+    }
+    // One connection for the header and the body GETs. The patch carries
+    // its own MAC, so the server is only checked with ota.ca set
+    static WiFiClient tcp;
+    static TlsClient tls;
+    WiFiClient *client = &tcp;
+    if (!strncmp(url, "https://", 8)) {
+#ifdef INTEGRATION_LAYER_ENABLED
+        String ca = GET_CONFIG_STRING("ota", "ca", String(""));
+        if (!ca.length() || !tls.setCACertFile(ca.c_str())) {
+            tls.setInsecure();
+        }
+#else
+        tls.setInsecure();
+#endif
+        client = &tls;
+    }
+    HTTPClient http;
+    http.setReuse(true);
+    http.setTimeout(OTA_HTTP_TIMEOUT_MS);
+    http.setConnectTimeout(OTA_HTTP_TIMEOUT_MS);
+    OtaPatchHeader header;
+    uint32_t offset = 0;
+    uint8_t *pos = (uint8_t *)&header;
+    int r = http_fetch_retry(http, *client, url, 0, sizeof(header), buf, copy_sink, &pos);
+    if (r == OTA_PATCH_OK) {
+        r = ota_patch_begin(&header, &offset);
+    }
+    if (r == OTA_PATCH_OK) {
+        LOG_INFOF("OTA", "Fetching %lu patch bytes for a %lu byte image", (unsigned long)(header.body_size - offset),
+                  (unsigned long)header.target_size);
+        r = http_fetch_retry(http, *client, url, sizeof(header) + offset, header.body_size - offset, buf, body_sink, nullptr);
+        r = r == OTA_PATCH_OK ? ota_patch_finish() : r;
+        if (r == OTA_PATCH_MORE) {
+            ota_patch_abort();
+        }
+    }
+    client->stop();
+    free(buf);
+    return r;
+}
+
+// ===== Files =====
+
+static int run_file(const char *path, bool sd) {
+    fs::FS *fs = ota_fs_for(sd);
+    File f;
+    {
+        OtaFsHold hold(sd);
+        f = fs->open(path, FILE_READ);
+    }
+    if (!f) {
+        LOG_WARNF("OTA", "Cannot read %s", path);
+        return OTA_PATCH_ERR_STATE;
+    }
+    uint8_t *buf = (uint8_t *)malloc(OTA_READ_CHUNK);
+
+    OtaPatchHeader header;
+    uint32_t offset = 0;
+    int r = OTA_PATCH_ERR_STATE;
+    if (buf) {
+        OtaFsHold hold(sd);
+        r = f.read((uint8_t *)&header, sizeof(header)) == sizeof(header) ? OTA_PATCH_OK : OTA_PATCH_ERR_HEADER;
+    }
+    if (r == OTA_PATCH_OK) {
+        r = ota_patch_begin(&header, &offset);
+    }
+    if (r == OTA_PATCH_OK) {
+        bool seeked;
+        {
+            OtaFsHold hold(sd);
+            seeked = f.seek(sizeof(header) + offset);
+        }
+        r = seeked ? OTA_PATCH_MORE : OTA_PATCH_ERR_HEADER;
+        while (r == OTA_PATCH_MORE) {
+            size_t n;
+            {
+                OtaFsHold hold(sd);
+                n = f.read(buf, OTA_READ_CHUNK);
+            }
+            if (!n) {
+                break;
+            }
+            r = ota_patch_feed(buf, n);
+        }
+        // Short file: finish reports what is missing
+        r = r == OTA_PATCH_OK || r == OTA_PATCH_MORE ? ota_patch_finish() : r;
+    }
+    {
+        OtaFsHold hold(sd);
+        f.close();
+    }
+    free(buf);
+    return r;
+}
+
+// ===== LoRa: gateway =====
+
+static void lora_send(const void *frame, size_t len) {
+    // Leave room in the pool for everything else the radio sends
+    while (lora_tx_pending() >= 2) {
+        vTaskDelay(pdMS_TO_TICKS(50));
+    }
+    if (lora_tx_enqueue((const uint8_t *)frame, len, LORA_TX_PRIO_LOW, 0)) {
+        portENTER_CRITICAL(&ota_mux);
+        ota_status.lora_frames++;
+        portEXIT_CRITICAL(&ota_mux);
+    }
+}
+
+static int run_serve(const char *path, bool sd, uint8_t rounds) {
+    fs::FS *fs = ota_fs_for(sd);
+    OtaLoraAnnounce ann;
+    File f;
+    {
+        OtaFsHold hold(sd);
+        f = fs->open(path, FILE_READ);
+        if (f && f.read((uint8_t *)&ann.header, sizeof(ann.header)) != sizeof(ann.header)) {
+            f.close();
+        }
+    }
+    if (!f) {
+        LOG_WARNF("OTA", "Cannot read %s", path);
+        return OTA_PATCH_ERR_STATE;
+    }
+    uint32_t blocks = (ann.header.body_size + OTA_LORA_BLOCK - 1) / OTA_LORA_BLOCK;
+    if (ann.header.magic != OTA_PATCH_MAGIC || !blocks || blocks > OTA_LORA_BLOCKS_MAX) {
+        OtaFsHold hold(sd);
+        f.close();
+        return OTA_PATCH_ERR_HEADER;
+    }
+    ann.magic = OTA_LORA_MAGIC;
+    ann.type = OTA_LORA_ANNOUNCE;
+    ann.session = (uint16_t)esp_random();
+    ann.blocks = blocks;
+    ann.block_size = OTA_LORA_BLOCK;
+    ann.reserved = 0;
+    portENTER_CRITICAL(&ota_mux);
+    ota_status.lora_blocks = blocks;
+    ota_status.lora_have = 0;
+    ota_status.lora_frames = 0;
+    portEXIT_CRITICAL(&ota_mux);
+    LOG_INFOF("OTA", "Serving %s over LoRa: %lu blocks, %u rounds", path, (unsigned long)blocks, rounds);
+
+    uint8_t frame[sizeof(OtaLoraData) + OTA_LORA_BLOCK];
+    OtaLoraData *hdr = (OtaLoraData *)frame;
+    hdr->magic = OTA_LORA_MAGIC;
+    hdr->type = OTA_LORA_DATA;
+    hdr->session = ann.session;
+    int r = OTA_PATCH_OK;
+    for (uint8_t round = 0; round < rounds && r == OTA_PATCH_OK; round++) {
+        for (uint32_t b = 0; b < blocks; b++) {
+            if (b % OTA_LORA_ANNOUNCE_EVERY == 0) {
+                lora_send(&ann, sizeof(ann));
+            }
+            size_t n = min((uint32_t)OTA_LORA_BLOCK, ann.header.body_size - b * OTA_LORA_BLOCK);
+            bool ok;
+            {
+                OtaFsHold hold(sd);
+                ok = f.seek(sizeof(OtaPatchHeader) + b * OTA_LORA_BLOCK) &&
+                     f.read(frame + sizeof(OtaLoraData), n) == n;
+            }
+            if (!ok) {
+                r = OTA_PATCH_ERR_STATE;
+                break;
+            }
+            hdr->block = b;
+            lora_send(frame, sizeof(OtaLoraData) + n);
+            portENTER_CRITICAL(&ota_mux);
+            ota_status.lora_have = b + 1;
+            portEXIT_CRITICAL(&ota_mux);
+        }
+    }
+    OtaFsHold hold(sd);
+    f.close();
+    return r;
+}
+
+// ===== LoRa: receiver =====
+
+static void lora_map_save() {
+    OtaFsHold hold(lora_on_sd);
+    File f = ota_fs_for(lora_on_sd)->open(OTA_LORA_MAP_FILE, FILE_WRITE);
+    if (f) {
+        f.write((const uint8_t *)&lora_map, sizeof(lora_map));
+        f.write(lora_bits, (lora_map.blocks + 7) / 8);
+        f.close();
+    }
+    if (lora_on_sd) {
+        fs_invalidate_usage();
+    }
+    lora_unsaved = 0;
+}
+
+static void lora_forget() {
+    lora_collecting = false;
+    lora_session_known = false;
+    OtaFsHold hold(lora_on_sd);
+    fs::FS *fs = ota_fs_for(lora_on_sd);
+    fs->remove(OTA_LORA_FILE);
+    fs->remove(OTA_LORA_MAP_FILE);
+}
+
+static void lora_status_update() {
+    portENTER_CRITICAL(&ota_mux);
+    ota_status.lora_blocks = lora_map.blocks;
+    ota_status.lora_have = lora_map.have;
+    ota_status.lora_frames++;
+    portEXIT_CRITICAL(&ota_mux);
+}
+
+// Picks up blocks saved before a reset when they are for the same patch
+static bool lora_start(const OtaLoraAnnounce *ann) {
+    fs::FS *fs = ota_fs(&lora_on_sd);
+    if (!fs) {
+        return false;
+    }
+    size_t map_bytes = (ann->blocks + 7) / 8;
+    bool resumed = false;
+    {
+        OtaFsHold hold(lora_on_sd);
+        File f = fs->open(OTA_LORA_MAP_FILE, FILE_READ);
+        OtaLoraMap saved;
+        if (f && f.read((uint8_t *)&saved, sizeof(saved)) == sizeof(saved) && saved.blocks == ann->blocks &&
+            saved.have <= saved.blocks &&
+            !memcmp(saved.target_sha256, ann->header.target_sha256, sizeof(saved.target_sha256)) &&
+            f.read(lora_bits, map_bytes) == map_bytes && fs->exists(OTA_LORA_FILE)) {
+            lora_map = saved;
+            resumed = true;
+        }
+        if (f) {
+            f.close();
+        }
+        if (!resumed) {
+            fs->mkdir(OTA_DIR);
+            File data = fs->open(OTA_LORA_FILE, FILE_WRITE);
+            if (!data) {
+                return false;
+            }
+            data.write((const uint8_t *)&ann->header, sizeof(ann->header));
+            data.close();
+        }
+    }
+    if (!resumed) {
+        memcpy(lora_map.target_sha256, ann->header.target_sha256, sizeof(lora_map.target_sha256));
+        lora_map.blocks = ann->blocks;
+        lora_map.have = 0;
+        memset(lora_bits, 0, map_bytes);
+        lora_map_save();
+    }
+    lora_collecting = true;
+    set_state(OTA_COLLECTING);
+    LOG_INFOF("OTA", "Collecting a patch over LoRa, %u of %u blocks held", lora_map.have, lora_map.blocks);
+    return true;
+}
+
+static void lora_try_apply() {
+    if (!lora_collecting || lora_map.have < lora_map.blocks || !job_claim(OTA_APPLYING)) {
+        return;
+    }
+    lora_map_save();
+    int r = run_file(OTA_LORA_FILE, lora_on_sd);
+    if (r != OTA_PATCH_OK && r != OTA_PATCH_MORE && r != OTA_PATCH_ERR_FLASH) {
+        // Checked before collecting, so the blocks themselves are bad
+        lora_forget();
+    }
+    job_finish(r, true);
+}
+
+static void lora_on_announce(const OtaLoraAnnounce *ann) {
+    if (ann->block_size != OTA_LORA_BLOCK || !ann->blocks || ann->blocks > OTA_LORA_BLOCKS_MAX ||
+        ann->blocks != (ann->header.body_size + OTA_LORA_BLOCK - 1) / OTA_LORA_BLOCK) {
+        return;
+    }
+    bool same = lora_collecting &&
+                !memcmp(lora_map.target_sha256, ann->header.target_sha256, sizeof(lora_map.target_sha256));
+    if (!same) {
+        if (!memcmp(lora_rejected, ann->header.target_sha256, sizeof(lora_rejected)) || ota_busy) {
+            return;
+        }
+        // Not for this device (other build, other key) or no room for it
+        int r = ota_patch_check(&ann->header);
+        if (r != OTA_PATCH_OK || !lora_start(ann)) {
+            LOG_INFOF("OTA", "Ignoring a LoRa patch: %s", r == OTA_PATCH_OK ? "no storage" : ota_patch_result_name(r));
+            memcpy(lora_rejected, ann->header.target_sha256, sizeof(lora_rejected));
+            return;
+        }
+    }
+    lora_session = ann->session;
+    lora_session_known = true;
+    lora_try_apply();
+}
+
+static void lora_on_data(const uint8_t *frame, size_t len) {
+    const OtaLoraData *hdr = (const OtaLoraData *)frame;
+    if (!lora_collecting || !lora_session_known || hdr->session != lora_session || hdr->block >= lora_map.blocks) {
+        return;
+    }
+    uint16_t b = hdr->block;
+    uint8_t mask = 1 << (b & 7);
+    if (lora_bits[b >> 3] & mask) {
+        lora_status_update();
+        return;
+    }
+    // Only the last block is short
+    uint32_t body_size = 0;
+    {
+        OtaFsHold hold(lora_on_sd);
+        File f = ota_fs_for(lora_on_sd)->open(OTA_LORA_FILE, "r+");
+        OtaPatchHeader header;
+        bool ok = f && f.read((uint8_t *)&header, sizeof(header)) == sizeof(header);
+        body_size = ok ? header.body_size : 0;
+        size_t n = len - sizeof(OtaLoraData);
+        ok = ok && n == min((uint32_t)OTA_LORA_BLOCK, body_size - b * OTA_LORA_BLOCK) &&
+             f.seek(sizeof(header) + b * OTA_LORA_BLOCK) && f.write(frame + sizeof(OtaLoraData), n) == n;
+        if (f) {
+            f.close();
+        }
+        if (!ok) {
+            return;
+        }
+    }
+    lora_bits[b >> 3] |= mask;
+    lora_map.have++;
+    lora_status_update();
+    if (++lora_unsaved >= OTA_LORA_MAP_SAVE_EVERY) {
+        lora_map_save();
+    }
+}
+
+// Runs in the LoRa task: only queue, the card work happens in ours
+static bool lora_hook(const lora_packet_t *pkt) {
+    if (pkt->len < sizeof(OtaLoraData) || pkt->data[0] != OTA_LORA_MAGIC) {
+        return false;
+    }
+    OtaLoraFrame frame;
+    frame.len = pkt->len;
+    memcpy(frame.data, pkt->data, pkt->len);
+    xQueueSend(lora_queue, &frame, 0);
+    return true;
+}
+
+static void lora_task(void *arg) {
+    static OtaLoraFrame frame;
+    for (;;) {
+        if (xQueueReceive(lora_queue, &frame, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        if (frame.data[1] == OTA_LORA_ANNOUNCE && frame.len == sizeof(OtaLoraAnnounce)) {
+            lora_on_announce((const OtaLoraAnnounce *)frame.data);
+        } else if (frame.data[1] == OTA_LORA_DATA) {
+            lora_on_data(frame.data, frame.len);
+            lora_try_apply();
+        }
+    }
+}
+
+// ===== Jobs =====
+
+static void job_task(void *arg) {
+    int r;
+    switch (ota_job.type) {
+    case OTA_JOB_URL:
+        r = run_url(ota_job.path);
+        break;
+    case OTA_JOB_FILE:
+        r = run_file(ota_job.path, ota_job.sd);
+        break;
+    default:
+        r = run_serve(ota_job.path, ota_job.sd, ota_job.rounds);
+        break;
+    }
+    job_finish(r, ota_job.type != OTA_JOB_SERVE);
+    vTaskDelete(NULL);
+}
+
+static bool job_start(uint8_t type, uint8_t state, const char *path, uint8_t rounds) {
+    if (!path || strlen(path) > OTA_URL_MAX) {
+        return false;
+    }
+    if (!job_claim(state)) {
+        LOG_WARN("OTA", "An update is already running");
+        return false;
+    }
+    ota_job.type = type;
+    ota_job.rounds = rounds;
+    strlcpy(ota_job.path, path, sizeof(ota_job.path));
+    if (type != OTA_JOB_URL && !ota_fs(&ota_job.sd)) {
+        job_finish(OTA_PATCH_ERR_STATE, false);
+        return false;
+    }
+    if (type == OTA_JOB_URL) {
+        // Kept until the update ends one way or the other, so a reset resumes it
+        save_url(path);
+    }
+    if (xTaskCreate(job_task, "ota", OTA_TASK_STACK, NULL, OTA_TASK_PRIORITY, NULL) != pdPASS) {
+        LOG_ERROR("OTA", "Failed to start the update task");
+        job_finish(OTA_PATCH_ERR_STATE, false);
+        return false;
+    }
+    return true;
+}
+
+#if FEATURE_MQTT_ENABLED
+static void mqtt_trigger(const char *topic, const uint8_t *payload, size_t len, void *ctx) {
+    size_t topic_len = strlen(topic);
+    if (topic_len < 4 || strcmp(topic + topic_len - 4, "/ota") || !len || len > OTA_URL_MAX) {
+        return;
+    }
+    char url[OTA_URL_MAX + 1];
+    memcpy(url, payload, len);
+    url[len] = '\0';
+    LOG_INFOF("OTA", "Update requested over MQTT: %s", url);
+    ota_update_url(url);
+}
+#endif
+
+// The core would mark every image good at start-up; leave that to
+// ota_update_begin(), so an image that cannot boot that far is rolled back
+extern "C" bool verifyRollbackLater() {
+    return true;
+}
+
+// ===== API =====
+
+bool ota_update_begin() {
+    static bool started = false;
+    if (started) {
+        return true;
+    }
+    started = true;
+
+    // Getting this far counts as a good boot; no rollback from here on
+    esp_ota_mark_app_valid_cancel_rollback();
+
+    bool lora = true;
+#ifdef INTEGRATION_LAYER_ENABLED
+    ota_reboot = GET_CONFIG_BOOL("ota", "reboot", true);
+    lora = GET_CONFIG_BOOL("ota", "lora", true);
+#endif
+
+    Preferences prefs;
+    String url;
+    if (prefs.begin(OTA_PATCH_NVS_NAMESPACE, true)) {
+        url = prefs.getString("url", "");
+        prefs.end();
+    }
+    if (url.length()) {
+        LOG_INFOF("OTA", "Carrying on the update from %s", url.c_str());
+        ota_update_url(url.c_str());
+    }
+
+#if FEATURE_MQTT_ENABLED
+    char topic[64];
+    snprintf(topic, sizeof(topic), "tdeckpro/%s/ota", mqtt_device_id());
+    mqtt_on_message(mqtt_trigger);
+    mqtt_subscribe(topic, 1);
+#endif
+
+    if (lora) {
+        lora_bits = (uint8_t *)malloc(OTA_LORA_BLOCKS_MAX / 8);
+        lora_queue = xQueueCreate(OTA_LORA_QUEUE_DEPTH, sizeof(OtaLoraFrame));
+        if (!lora_bits || !lora_queue ||
+            xTaskCreate(lora_task, "ota_lora", OTA_TASK_STACK, NULL, OTA_TASK_PRIORITY, &lora_task_handle) != pdPASS) {
+            LOG_ERROR("OTA", "No memory for LoRa updates");
+            return false;
+        }
+        lora_add_rx_hook(lora_hook);
+    }
+    return true;
+}
+
+bool ota_update_url(const char *url) {
+    return job_start(OTA_JOB_URL, OTA_DOWNLOADING, url, 0);
+}
+
+bool ota_update_file(const char *path) {
+    return job_start(OTA_JOB_FILE, OTA_APPLYING, path, 0);
+}
+
+bool ota_lora_serve(const char *path, uint8_t rounds) {
+    return job_start(OTA_JOB_SERVE, OTA_SERVING, path, rounds ? rounds : 1);
+}
+
+void ota_update_get_status(OtaStatus *out) {
+    portENTER_CRITICAL(&ota_mux);
+    *out = ota_status;
+    portEXIT_CRITICAL(&ota_mux);
+    ota_patch_get_progress(&out->patch);
+}
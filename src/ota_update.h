@@ -0,0 +1,120 @@
+/**
+ * @file      ota_update.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Firmware updates: delta patches over HTTP, from a file, or by LoRa multicast
+ */
+
+#ifndef OTA_UPDATE_H
+#define OTA_UPDATE_H
+
+#include <Arduino.h>
+#include "ota_patch.h"
+
+/**
+ * Transports around ota_patch. Each hands the patch over as it arrives;
+ * nothing is staged in full before it is applied.
+ *
+ * HTTP: ranged GETs on one kept-alive connection, over whichever link
+ * has IP (WiFi, or 4G through PPP). A dropped connection picks up at the
+ * byte it stopped at, and an update cut off by a reset carries on from
+ * its checkpoint at the next boot. "tdeckpro/<id>/ota" on MQTT starts one with the URL as payload.
+ *
+ * LoRa: a gateway running ota_lora_serve() repeats the patch as numbered
+ * blocks, with an announcement every OTA_LORA_ANNOUNCE_EVERY blocks.
+ * Devices the announced patch is meant for (ota_patch_check) collect the
+ * blocks into OTA_LORA_FILE, in any order and across any number of
+ * rounds, and apply the file once every block is in. Nothing is sent
+ * back, so one gateway serves any number of devices.
+ *
+ * Config section "ota": key, allow_unsigned (see ota_patch.h),
+ * ca (PEM bundle on LittleFS to check https servers against), lora (true:
+ * listen for multicast), reboot (true: restart into the new image when
+ * done).
+ */
+
+#define OTA_DIR                     "/ota"
+#define OTA_LORA_FILE               "/ota/lora.bin"
+#define OTA_LORA_MAP_FILE           "/ota/lora.map"
+#define OTA_URL_MAX                 200
+#define OTA_LORA_MAGIC              0xD8    // Next to lora_link's 0xD7
+#define OTA_LORA_BLOCK              200     // Patch bytes per data frame
+#define OTA_LORA_BLOCKS_MAX         8192    // 1.6 MB of patch
+#define OTA_LORA_ANNOUNCE_EVERY     32
+#define OTA_LORA_MAP_SAVE_EVERY     64      // Blocks between bitmap saves
+#define OTA_LORA_QUEUE_DEPTH        8
+#define OTA_HTTP_RETRIES            8
+#define OTA_HTTP_TIMEOUT_MS         15000
+#define OTA_READ_CHUNK              1024
+#define OTA_REBOOT_DELAY_MS         3000
+#define OTA_TASK_STACK              (1024 * 8)
+#define OTA_TASK_PRIORITY           (tskIDLE_PRIORITY + 1)
+
+enum OtaLoraFrameType {
+    OTA_LORA_ANNOUNCE = 1,          // OtaLoraAnnounce
+    OTA_LORA_DATA,                  // OtaLoraData, then up to OTA_LORA_BLOCK bytes
+};
+
+struct OtaLoraAnnounce {
+    uint8_t magic;
+    uint8_t type;
+    uint16_t session;               // Random per ota_lora_serve() call
+    uint16_t blocks;
+    uint8_t block_size;
+    uint8_t reserved;
+    OtaPatchHeader header;
+} __attribute__((packed));
+
+struct OtaLoraData {
+    uint8_t magic;
+    uint8_t type;
+    uint16_t session;
+    uint16_t block;
+} __attribute__((packed));
+
+enum OtaState {
+    OTA_IDLE = 0,
+    OTA_DOWNLOADING,                // Patch coming in over HTTP
+    OTA_COLLECTING,                 // LoRa blocks coming in
+    OTA_APPLYING,                   // From a file
+    OTA_SERVING,                    // Sending a patch over LoRa
+    OTA_DONE,                       // New image set to boot
+    OTA_FAILED,
+};
+
+struct OtaStatus {
+    uint8_t state;
+    int last_result;                // OtaPatchResult of the last attempt
+    OtaPatchProgress patch;
+    uint16_t lora_blocks;           // Receiving or serving
+    uint16_t lora_have;
+    uint32_t lora_frames;           // Frames heard or sent
+};
+
+/**
+ * @brief Mark the running image good, carry on an interrupted HTTP update
+ *        and start listening on MQTT and LoRa
+ */
+bool ota_update_begin();
+
+/**
+ * @brief Fetch and apply a patch in the background
+ */
+bool ota_update_url(const char *url);
+
+/**
+ * @brief Apply a patch file (SD when mounted, otherwise LittleFS) in the
+ *        background
+ */
+bool ota_update_file(const char *path);
+
+/**
+ * @brief Send a patch file over LoRa, every block rounds times
+ */
+bool ota_lora_serve(const char *path, uint8_t rounds);
+
+void ota_update_get_status(OtaStatus *out);
+
+#endif // OTA_UPDATE_H
@@ -0,0 +1,224 @@
+#include <Wire.h>
+#include <Arduino.h>
+#include "utilities.h"
+#include "peripheral.h"
+#include "factory.h"
+#include "i2c_bus.h"
+#include "coro_sched.h"
+
+#define BQ25896_REG_ADC_CTRL    0x02    // CONV_START bit 7, CONV_RATE bit 6
+#define BQ25896_REG_STATUS      0x0B    // Start of the status and ADC run
+#define BQ25896_REG_LAST        0x14
+#define BQ25896_CONV_START      0x80
+#define BQ25896_CONV_RATE       0x40
+#define BQ25896_ADC_POLL_MS     20
+#define BQ25896_SIG_INT         0x01
+#define BQ25896_SIG_ADC         0x02
+
+// Offsets into the burst from REG0B
+enum {
+    RUN_STATUS = 0,     // 0B: VBUS_STAT, CHRG_STAT, PG_STAT
+    RUN_FAULT,          // 0C: clears latched faults on read
+    RUN_VINDPM,         // 0D
+    RUN_BATV,           // 0E
+    RUN_SYSV,           // 0F
+    RUN_TSPCT,          // 10
+    RUN_VBUSV,          // 11: VBUS_GD bit 7
+    RUN_ICHGR,          // 12
+    RUN_DPM,            // 13
+    RUN_PART,           // 14
+    RUN_LEN,
+};
+
+static Coro chg_coro;
+static portMUX_TYPE chg_mux = portMUX_INITIALIZER_UNLOCKED;
+static bq25896_snapshot_t chg_snap;         // under chg_mux
+static bool chg_have = false;
+static uint32_t chg_adc_from = 0;           // conversion start, for its timeout
+
+static bool chg_read_reg(uint8_t reg, uint8_t *val)
+{
+    return i2c_bus_read_reg(I2C_DEV_BQ25896, reg, val, 1);
+}
+
+static bool chg_write_reg(uint8_t reg, uint8_t val)
+{
+    i2c_bus_acquire(I2C_DEV_BQ25896);
+    bool ok = PPM.writeRegister(reg, val) == 0;
+    i2c_bus_release(I2C_DEV_BQ25896, ok);
+    return ok;
+}
+
+// The pulse on INT marks a change; the registers say what it was
+static void IRAM_ATTR chg_int_isr(void)
+{
+    BaseType_t woken = pdFALSE;
+    coro_signal_from_isr(&chg_coro, BQ25896_SIG_INT, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+/**
+ * Status and fault, plus the ADC results when a conversion just finished:
+ * one run from REG0B, the ADC registers only when they are new
+ */
+static void chg_read(bool adc, bool irq)
+{
+    uint8_t buf[RUN_LEN];
+    uint8_t len = adc ? RUN_LEN : RUN_FAULT + 1;
+    bool ok = i2c_bus_read_reg(I2C_DEV_BQ25896, BQ25896_REG_STATUS, buf, len);
+
+    portENTER_CRITICAL(&chg_mux);
+    if(irq) chg_snap.interrupts++;
+    else if(!adc) chg_snap.polls++;
+    if(!ok) {
+        chg_snap.read_errors++;
+        portEXIT_CRITICAL(&chg_mux);
+        return;
+    }
+    chg_snap.time_ms = millis();
+    chg_snap.vbus_stat = (buf[RUN_STATUS] >> 5) & 0x07;
+    chg_snap.chrg_stat = (buf[RUN_STATUS] >> 3) & 0x03;
+    chg_snap.power_good = buf[RUN_STATUS] & 0x04;
+    chg_snap.fault = buf[RUN_FAULT];
+    chg_snap.faults_seen |= buf[RUN_FAULT];
+    if(adc) {
+        uint8_t batv = buf[RUN_BATV] & 0x7F;
+        chg_snap.vbat_mv = batv ? batv * 20 + 2304 : 0;
+        chg_snap.vsys_mv = (buf[RUN_SYSV] & 0x7F) * 20 + 2304;
+        chg_snap.ts_pct = (buf[RUN_TSPCT] & 0x7F) * 0.465f + 21;
+        chg_snap.vbus_good = buf[RUN_VBUSV] & 0x80;
+        chg_snap.vbus_mv = chg_snap.vbus_good ? (buf[RUN_VBUSV] & 0x7F) * 100 + 2600 : 0;
+        chg_snap.ichg_ma = (buf[RUN_ICHGR] & 0x7F) * 50;
+        chg_snap.adc_ms = chg_snap.time_ms;
+        chg_snap.conversions++;
+    }
+    chg_have = true;
+    portEXIT_CRITICAL(&chg_mux);
+}
+
+// One-shot: CONV_RATE off so the ADC sleeps between requests
+static bool chg_adc_start(void)
+{
+    uint8_t ctrl;
+    if(!chg_read_reg(BQ25896_REG_ADC_CTRL, &ctrl)) return false;
+    ctrl = (ctrl & ~BQ25896_CONV_RATE) | BQ25896_CONV_START;
+    return chg_write_reg(BQ25896_REG_ADC_CTRL, ctrl);
+}
+
+static bool chg_adc_busy(void)
+{
+    uint8_t ctrl;
+    if(millis() - chg_adc_from > BQ25896_ADC_TIMEOUT_MS) return false;
+    return !chg_read_reg(BQ25896_REG_ADC_CTRL, &ctrl) || (ctrl & BQ25896_CONV_START);
+}
+
+static CoroStatus chg_coro_fn(Coro *co)
+{
+    CORO_BEGIN(co);
+    chg_read(false, false);
+    while(1){
+        CORO_AWAIT(co, BQ25896_SIG_INT | BQ25896_SIG_ADC,
+                   BOARD_BQ25896_INT < 0 ? BQ25896_POLL_MS : CORO_FOREVER);
+
+        if((co->fired & BQ25896_SIG_ADC) && chg_adc_start()){
+            // CONV_START clears itself when every channel is done
+            chg_adc_from = millis();
+            do {
+                CORO_SLEEP(co, BQ25896_ADC_POLL_MS);
+            } while(chg_adc_busy());
+            chg_read(true, false);
+        } else {
+            chg_read(false, co->fired & BQ25896_SIG_INT);
+        }
+    }
+    CORO_END(co);
+}
+
+bool BQ25896_init(void)
+{
+    if(coro_running(&chg_coro)) return true;
+
+    Wire.beginTransmission(BOARD_I2C_ADDR_BQ25896);
+    if(Wire.endTransmission() != 0) return false;
+
+    i2c_bus_acquire(I2C_DEV_BQ25896);
+    PPM.init(Wire, BOARD_I2C_SDA, BOARD_I2C_SCL, BOARD_I2C_ADDR_BQ25896);
+    // Set the minimum operating voltage. Below this voltage, the PPM will protect
+    PPM.setSysPowerDownVoltage(3300);
+    // Set input current limit, default is 500mA
+    PPM.setInputCurrentLimit(3250);
+    // Disable current limit pin
+    PPM.disableCurrentLimitPin();
+    // Set the charging target voltage, Range:3840 ~ 4608mV ,step:16 mV
+    PPM.setChargeTargetVoltage(4208);
+    // Set the precharge current , Range: 64mA ~ 1024mA ,step:64mA
+    PPM.setPrechargeCurr(64);
+    // Set the charging current , Range:0~5056mA ,step:64mA
+    PPM.setChargerConstantCurr(832);
+    PPM.enableCharge();
+    // Set once here, so the snapshot carries them without a read
+    chg_snap.vreg_mv = PPM.getChargeTargetVoltage();
+    chg_snap.iprechg_ma = PPM.getPrechargeCurr();
+    i2c_bus_release(I2C_DEV_BQ25896);
+
+    // The ADC stays off (CONV_RATE clear) until a reader asks for a conversion
+    uint8_t ctrl;
+    if(chg_read_reg(BQ25896_REG_ADC_CTRL, &ctrl)) {
+        chg_write_reg(BQ25896_REG_ADC_CTRL, ctrl & ~(BQ25896_CONV_RATE | BQ25896_CONV_START));
+    }
+
+    // Nothing polls the charger when INT is wired: its coroutine waits on the shared scheduler
+    coro_spawn(&chg_coro, "bq25896", chg_coro_fn);
+    if(BOARD_BQ25896_INT >= 0) {
+        pinMode(BOARD_BQ25896_INT, INPUT_PULLUP);
+        attachInterrupt(BOARD_BQ25896_INT, chg_int_isr, FALLING);
+    }
+    return true;
+}
+
+bool BQ25896_get_snapshot(bq25896_snapshot_t *out)
+{
+    portENTER_CRITICAL(&chg_mux);
+    *out = chg_snap;
+    bool have = chg_have;
+    portEXIT_CRITICAL(&chg_mux);
+    return have;
+}
+
+void BQ25896_request_adc(uint32_t max_age_ms)
+{
+    portENTER_CRITICAL(&chg_mux);
+    bool fresh = chg_snap.adc_ms && millis() - chg_snap.adc_ms <= max_age_ms;
+    portEXIT_CRITICAL(&chg_mux);
+    if(!fresh && coro_running(&chg_coro)) coro_signal(&chg_coro, BQ25896_SIG_ADC);
+}
+
+const char *BQ25896_bus_str(uint8_t vbus_stat)
+{
+    static const char *const names[] = {
+        "No input", "USB Host SDP", "USB CDP", "USB DCP",
+        "HVDCP", "Unknown Adapter", "Non-Standard Adapter", "OTG",
+    };
+    return names[vbus_stat & 0x07];
+}
+
+const char *BQ25896_chg_str(uint8_t chrg_stat)
+{
+    static const char *const names[] = {
+        "Not Charging", "Pre-charge", "Fast Charging", "Charge Termination Done",
+    };
+    return names[chrg_stat & 0x03];
+}
+
+// NTC_FAULT, REG0C[2:0]: boost mode reports only cold and hot
+const char *BQ25896_ntc_str(uint8_t fault)
+{
+    switch(fault & 0x07) {
+    case 0: return "NTC normal";
+    case 2: return "NTC warm";
+    case 3: return "NTC cool";
+    case 5: return "NTC cold";
+    case 6: return "NTC hot";
+    default: return "Unknown";
+    }
+}
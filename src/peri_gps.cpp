@@ -1,31 +1,167 @@
 
 #include "utilities.h"
 #include "peripheral.h"
+#include "boot_trace.h"
+#include "gps_track.h"
+#include "gps_assist.h"
+#include "time_service.h"
+#include "power_governor.h"
+#include "energy_profiler.h"
+#include "power_domain.h"
+#include "timer_wheel.h"
+#include "usb_console.h"
+#include "event_replay.h"
 #include <TinyGPS++.h>
+#ifdef INTEGRATION_LAYER_ENABLED
+#include "integration/config_manager.h"
+#include "integration/event_bridge.h"
+#endif
+#include <math.h>
+#include <esp_timer.h>
+#include <freertos/stream_buffer.h>
 
 /* clang-format off */
 
+// UART wakes the task on an idle line after a sentence burst or a part-full FIFO
+#define GPS_RX_BUFFER_SIZE      1024
+#define GPS_RX_FIFO_FULL        64      // bytes
+#define GPS_RX_TIMEOUT_SYMBOLS  4       // ~1 ms of silence at 38400
+#define GPS_RX_CHUNK            128
+#define GPS_IDLE_WAKE_MS        1000    // for the wiring check when nothing arrives
+
+// UBX framing
+#define UBX_SYNC1               0xB5
+#define UBX_SYNC2               0x62
+#define UBX_HEADER_SIZE         6       // sync, class, id, length
+#define UBX_PAYLOAD_MAX         100
+#define UBX_CLASS_NAV           0x01
+#define UBX_NAV_PVT             0x07
+#define UBX_NAV_PVT_SIZE        92
+#define UBX_CLASS_ACK           0x05
+#define UBX_ACK_NAK             0x00
+#define UBX_ACK_ACK             0x01
+#define UBX_CLASS_CFG           0x06
+#define UBX_CFG_VALSET          0x8A
+#define UBX_CLASS_RXM           0x02
+#define UBX_RXM_PMREQ           0x41
+#define UBX_PMREQ_BACKUP        0x02
+#define UBX_PMREQ_FORCE         0x04
+#define UBX_PMREQ_WAKE_UARTRX   0x08
+
+// M10 configuration keys for CFG-VALSET
+#define UBX_KEY_RATE_MEAS               0x30210001  // U2, ms
+#define UBX_KEY_RATE_NAV                0x30210002  // U2, measurements per solution
+#define UBX_KEY_MSGOUT_NAV_PVT_UART1    0x20910007  // U1, per solution
+#define UBX_KEY_UART1OUTPROT_UBX        0x10740001  // L
+#define UBX_KEY_UART1OUTPROT_NMEA       0x10740002  // L
+
 TinyGPSPlus gps;
 static bool GPS_Recovery();
 bool setupGPS();
 void displayInfo();
+static void gps_store();
+static void gps_sleep_hold(bool hold);
+static void gps_pps_isr(void);
+
+// UBX-NAV-PVT payload, read in place from the frame buffer
+typedef struct __attribute__((packed)) {
+    uint32_t itow;
+    uint16_t year;
+    uint8_t month, day, hour, min, sec;
+    uint8_t valid;          // bit 0 date, bit 1 time, bit 2 fully resolved
+    uint32_t t_acc;
+    int32_t nano;
+    uint8_t fix_type;       // 0 none, 2 2D, 3 3D, 4 GNSS + dead reckoning
+    uint8_t flags;          // bit 0 gnssFixOK
+    uint8_t flags2;
+    uint8_t num_sv;
+    int32_t lon, lat;       // 1e-7 deg
+    int32_t height, h_msl;  // mm
+    uint32_t h_acc, v_acc;  // mm
+    int32_t vel_n, vel_e, vel_d;
+    int32_t g_speed;        // mm/s
+    int32_t head_mot;       // 1e-5 deg
+    uint32_t s_acc, head_acc;
+    uint16_t p_dop;
+    uint16_t flags3;
+    uint8_t reserved[4];
+    int32_t head_veh;
+    int16_t mag_dec;
+    uint16_t mag_acc;
+} ubx_nav_pvt_t;
 
 static TaskHandle_t gps_handle;
-static double gps_lat=0, gps_lng=0, gps_altitude=0, gps_speed=0;
-static uint16_t gps_year=0;
-static uint8_t gps_month=0, gps_day=0;
-static uint8_t gps_hour=0, gps_minute=0, gps_second=0;
-static uint32_t gps_vsat=0;
+static uint32_t gps_rx_bytes = 0;
+static StreamBufferHandle_t gps_replay_bytes = NULL;   // event_replay to gps_task
+static bool gps_parsing_replay = false;                 // gps_task only
+static WheelTimer gps_wiring_timer;
+
+// Seqlock: the GPS task is the only writer, an odd sequence means a write is under way
+static gps_fix_t gps_fix;
+static volatile uint32_t gps_fix_seq = 0;
+static gps_fix_t gps_work;              // the writer's copy, GPS task only
+
+// Location updates go out only past this distance from the last one sent
+static float gps_move_threshold_m = GPS_MOVE_THRESHOLD_M;
+static bool gps_move_sent = false;
+static double gps_move_lat = 0, gps_move_lng = 0;
+
+// UBX receive path
+static uint8_t ubx_frame[UBX_HEADER_SIZE + UBX_PAYLOAD_MAX + 2];
+static uint16_t ubx_pos = 0;
+static uint16_t ubx_len = 0;
+static bool gps_ubx_enabled = false;
+static uint8_t gps_ubx_rate_hz = 1;
+static volatile bool gps_mode_pending = false;
+
+// AGNSS: requested on a start without ephemeris, then paced out from the task
+static volatile bool gps_assist_pending = false;
+static bool gps_assist_more = false;
+static uint32_t gps_assist_at = 0;
+
+// Time: the PPS edge that starts each second, stamped in the interrupt,
+// and when the current chunk of messages was read
+static volatile int64_t gps_pps_us = 0;
+static volatile int64_t gps_pps_prev_us = 0;
+static volatile uint32_t gps_pps_seq = 0;
+static bool gps_pps_on = true;
+static int64_t gps_rx_us = 0;
+
+// Power: the task keeps the receiver in software backup between fixes, RAM
+// and ephemeris stay powered so each wake is a hot start
+static uint32_t gps_power_need[GPS_CONSUMER_MAX];  // max fix age per consumer, 0 = none
+static volatile uint16_t gps_power_pct = 100;      // background consumers' scale
+static volatile uint32_t gps_power_gap = 0;        // dead reckoning's floor on the interval
+static volatile bool gps_power_enabled = true;
+static gps_power_state_t gps_power = GPS_PWR_ACQUIRE;
+static uint32_t gps_power_since = 0;       // entered the current state
+static uint32_t gps_power_wake_at = 0;     // backup: scheduled wake
+static uint32_t gps_power_fix_ver = 0;     // fix version when acquisition started
+static uint32_t gps_power_ttff = 0;        // last acquisition, ms
+static int gps_sleep_lock = -1;            // no light sleep while it streams, a wake loses bytes
+static bool gps_sleep_held = false;
 
 uint8_t buffer[256];
 
+// The rail is the receiver's alone; the power state machine holds it
+static void gps_rail(bool on)
+{
+    static int user = -1;
+    if (user < 0) user = power_domain_user(PWR_DOMAIN_GPS, "gps");
+    power_domain_set(user, on);
+}
+
 bool gps_init(void)
 {   
+    BOOT_TRACE_SCOPE("GPS");
     bool result = false;
+    gps_rail(true);
+    power_domain_wait(PWR_DOMAIN_GPS);
     // L76K GPS USE 9600 BAUDRATE
     // result = setupGPS();
     if(!result) {
         // Set u-blox m10q gps baudrate 38400
+        SerialGPS.setRxBufferSize(GPS_RX_BUFFER_SIZE);
         SerialGPS.begin(38400, SERIAL_8N1, BOARD_GPS_RXD, BOARD_GPS_TXD);
         result = GPS_Recovery();
         if (!result) {
@@ -39,144 +175,708 @@ bool gps_init(void)
         }
     }
     if(result) {
+        if(gps_sleep_lock < 0) gps_sleep_lock = power_governor_sleep_lock_create("gps_uart");
+        gps_sleep_hold(gps_power == GPS_PWR_ACQUIRE || gps_power == GPS_PWR_ON);
         Serial.println("GPS Task Create...!");
+        // Whatever state the receiver kept, assistance cannot hurt a first fix
+        gps_assist_pending = true;
         gps_task_create();
+#ifdef INTEGRATION_LAYER_ENABLED
+        gps_pps_on = GET_CONFIG_BOOL("time", "pps", true);
+#endif
+        if (gps_pps_on) {
+            pinMode(BOARD_GPS_PPS, INPUT);
+            attachInterrupt(BOARD_GPS_PPS, gps_pps_isr, RISING);
+        }
+#ifdef INTEGRATION_LAYER_ENABLED
+        gps_move_threshold_m = GET_CONFIG_FLOAT("gps", "move_threshold_m", GPS_MOVE_THRESHOLD_M);
+        if (GET_CONFIG(GPS_UBX)) {
+            gps_set_ubx(true, GET_CONFIG(GPS_RATE_HZ));
+        }
+        if (GET_CONFIG(GPS_TRACK)) {
+            gps_track_begin();
+        }
+#endif
     }
     return result;
 }
 
-void gps_task(void *param)
+static void (*volatile gps_fix_notify)(void) = NULL;
+
+static void gps_fix_store(const gps_fix_t *fix)
+{
+    gps_fix_seq++;
+    __sync_synchronize();
+    gps_fix = *fix;
+    __sync_synchronize();
+    gps_fix_seq++;
+}
+
+static void gps_fix_publish(gps_fix_t *fix)
+{
+    fix->version++;
+    fix->time_ms = millis();
+    gps_fix_store(fix);
+    if (gps_fix_notify) {
+        gps_fix_notify();
+    }
+}
+
+// Lock-free; retries if the GPS task published mid-copy. The writer runs at
+// GPS_PRIORITY, so a reader on its core never spins on a preempted write
+static void gps_fix_read(gps_fix_t *out)
+{
+    uint32_t seq;
+    do {
+        while ((seq = gps_fix_seq) & 1) {
+        }
+        __sync_synchronize();
+        *out = gps_fix;
+        __sync_synchronize();
+    } while (seq != gps_fix_seq);
+}
+
+double gps_distance_m(double lat1, double lng1, double lat2, double lng2)
+{
+    // Equirectangular is plenty at threshold distances
+    const double deg = M_PI / 180.0;
+    double x = (lng2 - lng1) * deg * cos((lat1 + lat2) * 0.5 * deg);
+    double y = (lat2 - lat1) * deg;
+    return 6371000.0 * sqrt(x * x + y * y);
+}
+
+static void gps_location_notify(const gps_fix_t *fix)
+{
+    if (!fix->valid) return;
+    if (gps_move_sent && gps_distance_m(gps_move_lat, gps_move_lng, fix->lat, fix->lng) < gps_move_threshold_m) return;
+    gps_move_sent = true;
+    gps_move_lat = fix->lat;
+    gps_move_lng = fix->lng;
+#ifdef INTEGRATION_LAYER_ENABLED
+    if (GlobalEventBridge) {
+        GlobalEventBridge->publishTypedEvent(EventType::GPS_LOCATION_UPDATE, "GPS", *fix);
+    }
+#endif
+}
+
+static void ubx_send(uint8_t cls, uint8_t id, const uint8_t *payload, uint16_t len)
+{
+    uint8_t head[UBX_HEADER_SIZE] = {UBX_SYNC1, UBX_SYNC2, cls, id, (uint8_t)len, (uint8_t)(len >> 8)};
+    uint8_t ck_a = 0, ck_b = 0;
+    for (int i = 2; i < UBX_HEADER_SIZE; i++) {
+        ck_a += head[i];
+        ck_b += ck_a;
+    }
+    for (uint16_t i = 0; i < len; i++) {
+        ck_a += payload[i];
+        ck_b += ck_a;
+    }
+    uint8_t ck[2] = {ck_a, ck_b};
+    SerialGPS.write(head, sizeof(head));
+    SerialGPS.write(payload, len);
+    SerialGPS.write(ck, sizeof(ck));
+}
+
+static void gps_assist_write(const uint8_t *data, size_t len)
+{
+    SerialGPS.write(data, len);
+}
+
+static uint8_t *ubx_key(uint8_t *p, uint32_t key, uint32_t value, uint8_t size)
+{
+    memcpy(p, &key, 4);
+    memcpy(p + 4, &value, size);
+    return p + 4 + size;
+}
+
+// One CFG-VALSET in RAM; the receiver applies all keys or none
+static void gps_ubx_configure()
+{
+    uint8_t msg[4 + 5 * 8];
+    uint8_t *p = msg;
+    bool on = gps_ubx_enabled;
+    *p++ = 0;           // version
+    *p++ = 0x01;        // RAM layer
+    *p++ = 0;
+    *p++ = 0;
+    p = ubx_key(p, UBX_KEY_RATE_MEAS, on ? 1000 / gps_ubx_rate_hz : 1000, 2);
+    p = ubx_key(p, UBX_KEY_RATE_NAV, 1, 2);
+    p = ubx_key(p, UBX_KEY_MSGOUT_NAV_PVT_UART1, on ? 1 : 0, 1);
+    p = ubx_key(p, UBX_KEY_UART1OUTPROT_UBX, 1, 1);
+    p = ubx_key(p, UBX_KEY_UART1OUTPROT_NMEA, on ? 0 : 1, 1);
+    ubx_send(UBX_CLASS_CFG, UBX_CFG_VALSET, msg, p - msg);
+}
+
+static void IRAM_ATTR gps_pps_isr(void)
+{
+    gps_pps_seq++;
+    gps_pps_prev_us = gps_pps_us;
+    gps_pps_us = esp_timer_get_time();
+    gps_pps_seq++;
+}
+
+// The edge of the second a message read at rx_us is for, if the pulse is steady
+static bool gps_pps_edge(int64_t rx_us, int64_t *edge)
+{
+    int64_t at, prev;
+    uint32_t seq;
+    do {
+        seq = gps_pps_seq;
+        at = gps_pps_us;
+        prev = gps_pps_prev_us;
+    } while ((seq & 1) || seq != gps_pps_seq);
+    int64_t period = at - prev;
+    if (!at || !prev || rx_us < at || rx_us - at >= 1000000 - TIME_PPS_JITTER_US ||
+        period < 1000000 - TIME_PPS_JITTER_US || period > 1000000 + TIME_PPS_JITTER_US) {
+        return false;
+    }
+    *edge = at;
+    return true;
+}
+
+// A solution's time: exact at the PPS edge when it is on a whole second, else on arrival
+static void gps_time_feed(int64_t epoch_us, uint32_t t_acc_us)
+{
+    int64_t second = (epoch_us + 500000) / 1000000 * 1000000;
+    int64_t off = epoch_us - second;
+    int64_t edge;
+    // A recorded sentence's time is the recording's, not now
+    if (gps_parsing_replay) return;
+    if (gps_pps_on && off > -TIME_PPS_JITTER_US && off < TIME_PPS_JITTER_US && gps_pps_edge(gps_rx_us, &edge)) {
+        time_feed(TIME_SRC_PPS, second, edge, t_acc_us + TIME_PPS_ACC_US);
+    } else {
+        time_feed(TIME_SRC_GPS, epoch_us + TIME_GPS_LATENCY_US, gps_rx_us, t_acc_us + TIME_GPS_ACC_US);
+    }
+}
+
+static void ubx_nav_pvt(const ubx_nav_pvt_t *pvt)
+{
+    gps_fix_t *fix = &gps_work;
+    fix->fix_type = pvt->fix_type;
+    fix->vsat = pvt->num_sv;
+    fix->valid = (pvt->flags & 0x01) && pvt->fix_type >= 2;
+    if (fix->valid) {
+        fix->lat = pvt->lat * 1e-7;
+        fix->lng = pvt->lon * 1e-7;
+        fix->altitude = pvt->h_msl / 1000.0;
+        fix->speed = pvt->g_speed * 0.0036;
+        fix->heading = pvt->head_mot * 1e-5f;
+        fix->h_acc = pvt->h_acc / 1000.0f;
+        fix->v_acc = pvt->v_acc / 1000.0f;
+    }
+    if (pvt->valid & 0x01) {
+        fix->year = pvt->year;
+        fix->month = pvt->month;
+        fix->day = pvt->day;
+    }
+    if (pvt->valid & 0x02) {
+        fix->hour = pvt->hour;
+        fix->minute = pvt->min;
+        fix->second = pvt->sec;
+    }
+    if ((pvt->valid & 0x07) == 0x07 && fix->valid) {
+        int64_t epoch = time_make_utc(pvt->year, pvt->month, pvt->day, pvt->hour, pvt->min, pvt->sec) * 1000000LL +
+                        pvt->nano / 1000;
+        gps_time_feed(epoch, pvt->t_acc / 1000);
+    }
+    gps_fix_publish(fix);
+    gps_location_notify(fix);
+}
+
+static void ubx_dispatch(uint8_t cls, uint8_t id, const uint8_t *payload, uint16_t len)
+{
+    if (cls == UBX_CLASS_NAV && id == UBX_NAV_PVT && len == UBX_NAV_PVT_SIZE) {
+        ubx_nav_pvt((const ubx_nav_pvt_t *)payload);
+    } else if (cls == UBX_CLASS_ACK && len == 2 && payload[0] == UBX_CLASS_CFG && payload[1] == UBX_CFG_VALSET) {
+        if (id == UBX_ACK_NAK && gps_ubx_enabled) {
+            // NMEA output is unchanged, so the fix keeps coming on the text path
+            Serial.println("GPS rejected UBX mode, staying on NMEA");
+            gps_ubx_enabled = false;
+        }
+    }
+}
+
+// Returns true while the byte belongs to a UBX frame
+static bool ubx_feed(uint8_t c)
+{
+    if (ubx_pos == 0) {
+        if (c != UBX_SYNC1) return false;
+        ubx_frame[ubx_pos++] = c;
+        return true;
+    }
+    if (ubx_pos == 1 && c != UBX_SYNC2) {
+        ubx_pos = 0;
+        return ubx_feed(c);
+    }
+    
+    ubx_frame[ubx_pos++] = c;
+    if (ubx_pos == UBX_HEADER_SIZE) {
+        ubx_len = ubx_frame[4] | (ubx_frame[5] << 8);
+        if (ubx_len > UBX_PAYLOAD_MAX) {
+            // Too long for anything parsed here, the rest falls through to NMEA and is ignored there
+            ubx_pos = 0;
+        }
+        return true;
+    }
+    if (ubx_pos < UBX_HEADER_SIZE + ubx_len + 2) return true;
+    
+    ubx_pos = 0;
+    uint8_t ck_a = 0, ck_b = 0;
+    for (int i = 2; i < UBX_HEADER_SIZE + ubx_len; i++) {
+        ck_a += ubx_frame[i];
+        ck_b += ck_a;
+    }
+    if (ck_a == ubx_frame[UBX_HEADER_SIZE + ubx_len] && ck_b == ubx_frame[UBX_HEADER_SIZE + ubx_len + 1]) {
+        ubx_dispatch(ubx_frame[2], ubx_frame[3], ubx_frame + UBX_HEADER_SIZE, ubx_len);
+    }
+    return true;
+}
+
+static uint32_t gps_power_interval()
+{
+    uint32_t interval = 0;
+    uint16_t pct = gps_power_pct;
+    for (int i = 0; i < GPS_CONSUMER_MAX; i++) {
+        uint32_t need = gps_power_need[i];
+        if (need && i != GPS_CONSUMER_UI) {
+            need = pct ? max((uint32_t)((uint64_t)need * pct / 100), (uint32_t)GPS_UI_FIX_INTERVAL_MS) : 0;
+        }
+        if (need && (!interval || need < interval)) {
+            interval = need;
+        }
+    }
+    uint32_t gap = gps_power_gap;
+    if (interval && interval < gap) {
+        interval = gap;
+    }
+    return interval;
+}
+
+static void gps_sleep_hold(bool hold)
+{
+    if(hold == gps_sleep_held) return;
+    gps_sleep_held = hold;
+    if(hold) power_governor_acquire(gps_sleep_lock);
+    else power_governor_release(gps_sleep_lock);
+    energy_mark(ENERGY_GPS, hold);
+}
+
+static void gps_power_enter(gps_power_state_t state, uint32_t now)
+{
+    gps_power = state;
+    gps_power_since = now;
+    gps_sleep_hold(state == GPS_PWR_ACQUIRE || state == GPS_PWR_ON);
+}
+
+// duration_ms 0 sleeps until the next UART wake
+static void gps_power_sleep(uint32_t duration_ms, uint32_t now)
+{
+    uint8_t msg[16] = {0};
+    uint32_t flags = UBX_PMREQ_BACKUP | UBX_PMREQ_FORCE;
+    uint32_t wake = UBX_PMREQ_WAKE_UARTRX;
+    memcpy(msg + 4, &duration_ms, 4);
+    memcpy(msg + 8, &flags, 4);
+    memcpy(msg + 12, &wake, 4);
+    ubx_send(UBX_CLASS_RXM, UBX_RXM_PMREQ, msg, sizeof(msg));
+    gps_power_wake_at = now + duration_ms;
+    gps_power_enter(GPS_PWR_BACKUP, now);
+}
+
+static void gps_power_wake(uint32_t now)
+{
+    // Any traffic wakes it; the first bytes are lost while it starts up
+    static const uint8_t wake[8] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+    SerialGPS.write(wake, sizeof(wake));
+    delay(GPS_PWR_WAKE_MS);
+    // Backup drops the RAM configuration layer
+    gps_mode_pending = gps_ubx_enabled;
+    // Ephemeris kept through a long backup has gone stale
+    if (now - gps_power_since >= GPS_ASSIST_STALE_MS) gps_assist_pending = true;
+    gps_power_fix_ver = gps_work.version;
+    gps_power_enter(GPS_PWR_ACQUIRE, now);
+}
+
+static void gps_power_step(uint32_t now)
+{
+    uint32_t interval = gps_power_interval();
+    bool continuous = interval && interval <= GPS_PWR_CONTINUOUS_MS;
+    
+    if (!gps_power_enabled) {
+        if (gps_power != GPS_PWR_OFF) {
+            gps_rail(false);
+            gps_power_enter(GPS_PWR_OFF, now);
+        }
+        return;
+    }
+    
+    switch (gps_power) {
+    case GPS_PWR_OFF:
+        // Main power was cut, this one is a cold start
+        gps_rail(true);
+        power_domain_wait(PWR_DOMAIN_GPS);
+        gps_mode_pending = gps_ubx_enabled;
+        gps_assist_pending = true;
+        gps_power_fix_ver = gps_work.version;
+        gps_power_enter(GPS_PWR_ACQUIRE, now);
+        break;
+    
+    case GPS_PWR_BACKUP:
+        // A consumer may have asked for fresher fixes since it went to sleep
+        if (interval && (continuous || (int32_t)(now - gps_power_wake_at) >= 0 || now - gps_power_since >= interval)) {
+            gps_power_wake(now);
+        }
+        break;
+    
+    case GPS_PWR_ACQUIRE:
+        if (gps_work.valid && gps_work.version != gps_power_fix_ver) {
+            gps_power_ttff = now - gps_power_since;
+            gps_power_enter(GPS_PWR_ON, now);
+        } else if (!interval) {
+            gps_power_sleep(0, now);
+        } else if (now - gps_power_since >= GPS_PWR_ACQUIRE_TIMEOUT_MS && !continuous) {
+            // No sky view; try again a full interval later rather than burn power searching
+            gps_power_sleep(interval, now);
+        }
+        break;
+    
+    case GPS_PWR_ON:
+        if (!interval) {
+            gps_power_sleep(0, now);
+        } else if (!continuous && now - gps_power_since >= GPS_PWR_SETTLE_MS) {
+            // Wake early enough that the next fix lands within the interval
+            uint32_t lead = gps_power_ttff + GPS_PWR_SETTLE_MS + GPS_PWR_WAKE_MS;
+            if (interval > lead + GPS_PWR_MIN_SLEEP_MS) {
+                gps_power_sleep(interval - lead, now);
+            }
+        }
+        break;
+    }
+}
+
+static void gps_uart_event()
+{
+    // Runs on the UART event task
+    if(gps_handle) xTaskNotifyGive(gps_handle);
+}
+
+// Every completed sentence is stored at once
+static void gps_parse(const uint8_t *chunk, size_t n, uint32_t now)
 {
     static uint32_t last_display_time = 0;
-    static uint32_t last_check_time = 0;
+    for (size_t i = 0; i < n; i++) {
+        // NMEA is 7-bit text, so a UBX sync byte can only start a frame
+        if (ubx_feed(chunk[i])) continue;
+        if (gps.encode(chunk[i])) {
+            gps_store();
+            // Performance optimization: Only display GPS info every 5 seconds to reduce console spam
+            if (now - last_display_time > 5000) {
+                displayInfo();
+                last_display_time = now;
+            }
+        }
+    }
+}
 
+void gps_task(void *param)
+{
+    uint8_t chunk[GPS_RX_CHUNK];
+    
     while(1)
     {
+        // Asleep until the UART has data, a sentence costs a few ms from its last byte
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(gps_assist_more ? GPS_ASSIST_PACE_MS : GPS_IDLE_WAKE_MS));
         uint32_t now = millis();
 
-        // Performance optimization: Reduce serial forwarding overhead
-        while (Serial.available()) {
-            SerialGPS.write(Serial.read());
+        if (gps_mode_pending) {
+            gps_mode_pending = false;
+            gps_ubx_configure();
         }
 
-        // Performance optimization: Process GPS data but limit display updates
-        while (SerialGPS.available()) {
-            int c = SerialGPS.read();
-            if (gps.encode(c)) {
-                // Performance optimization: Only display GPS info every 5 seconds to reduce console spam
-                if (now - last_display_time > 5000) {
-                    displayInfo();
-                    last_display_time = now;
-                }
-            }
+        // Any byte wakes a receiver in backup, so only while it searches or tracks
+        bool awake = gps_power == GPS_PWR_ACQUIRE || gps_power == GPS_PWR_ON;
+        if (gps_assist_pending && awake) {
+            gps_assist_pending = false;
+            gps_assist_more = gps_assist_start(&gps_work, now, gps_assist_write);
+            gps_assist_at = now;
+        } else if (gps_assist_more && (!awake || now - gps_assist_at >= GPS_ASSIST_PACE_MS)) {
+            gps_assist_more = awake && gps_assist_step(gps_assist_write);
+            gps_assist_at = now;
         }
-
-        // Performance optimization: Check for GPS detection less frequently
-        if (now - last_check_time > 10000) { // Check every 10 seconds instead of constantly
-            if (now > 30000 && gps.charsProcessed() < 10) {
-                Serial.println(F("No GPS detected: check wiring."));
+    
+        // Drain the driver's ring buffer in chunks
+        size_t n;
+        while ((n = SerialGPS.read(chunk, sizeof(chunk))) > 0) {
+            gps_rx_bytes += n;
+            gps_rx_us = esp_timer_get_time();
+            if (usb_console_wants(USB_CONSOLE_CH_GPS)) {
+                usb_console_send(USB_CONSOLE_CH_GPS, chunk, n);
             }
-            last_check_time = now;
+            if (event_replay_recording()) {
+                event_replay_record(REPLAY_SRC_GPS, chunk, n);
+            }
+            gps_parse(chunk, n, now);
+        }
+        while (gps_replay_bytes && (n = xStreamBufferReceive(gps_replay_bytes, chunk, sizeof(chunk), 0)) > 0) {
+            gps_parsing_replay = true;
+            gps_parse(chunk, n, now);
+            gps_parsing_replay = false;
         }
+    
+        gps_power_step(millis());
+    }
+}
 
-        // Performance optimization: Increase delay to reduce CPU usage
-        delay(100); // 100ms instead of 1ms - GPS doesn't need millisecond precision
+static void gps_wiring_check(WheelTimer *timer)
+{
+    if(gps_rx_bytes < 10) {
+        Serial.println(F("No GPS detected: check wiring."));
+    } else {
+        timer_wheel_cancel(timer);
     }
 }
 
+// The USB console's GPS channel, e.g. for u-center: host bytes go to the
+// receiver, gps_task sends back what it reads
+static void gps_console_rx(const uint8_t *data, size_t len, void *ctx)
+{
+    SerialGPS.write(data, len);
+}
+
 void gps_task_create(void)
 {
+    gps_replay_bytes = xStreamBufferCreate(EVENT_REPLAY_GPS_BUFFER, 1);
+    // Runs from here on; with no consumer the power manager parks the receiver in backup
     xTaskCreate(gps_task, "gps_task", 1024 * 3, NULL, GPS_PRIORITY, &gps_handle);
-    vTaskSuspend(gps_handle);
+    timer_wheel_init(&gps_wiring_timer, "gps_wiring", gps_wiring_check);
+    timer_wheel_arm(&gps_wiring_timer, 30000, 10000);
+    
+    // After GPS_Recovery(), its ACK polling reads the port itself
+    SerialGPS.setRxFIFOFull(GPS_RX_FIFO_FULL);
+    SerialGPS.setRxTimeout(GPS_RX_TIMEOUT_SYMBOLS);
+    SerialGPS.onReceive(gps_uart_event, false);
+    usb_console_on(USB_CONSOLE_CH_GPS, gps_console_rx);
+}
+
+bool gps_replay_feed(const uint8_t *data, size_t len)
+{
+    if (!gps_handle || !gps_replay_bytes || xStreamBufferSpacesAvailable(gps_replay_bytes) < len) {
+        return false;
+    }
+    xStreamBufferSend(gps_replay_bytes, data, len, 0);
+    xTaskNotifyGive(gps_handle);
+    return true;
 }
 
 void gps_task_suspend(void)
 {
-    vTaskSuspend(gps_handle);
+    gps_power_request(GPS_CONSUMER_UI, 0);
 }
 
 void gps_task_resume(void)
 {
-    vTaskResume(gps_handle);
+    gps_power_request(GPS_CONSUMER_UI, GPS_UI_FIX_INTERVAL_MS);
+}
+
+void gps_power_request(int consumer, uint32_t max_age_ms)
+{
+    if (consumer < 0 || consumer >= GPS_CONSUMER_MAX) return;
+    gps_power_need[consumer] = max_age_ms;
+    if (gps_handle) xTaskNotifyGive(gps_handle);
+}
+
+void gps_power_scale(uint16_t pct)
+{
+    gps_power_pct = pct;
+    if (gps_handle) xTaskNotifyGive(gps_handle);
+}
+
+void gps_power_stretch(uint32_t gap_ms)
+{
+    if (gps_power_gap == gap_ms) return;
+    gps_power_gap = gap_ms;
+    if (gps_handle) xTaskNotifyGive(gps_handle);
+}
+
+void gps_power_enable(bool on)
+{
+    gps_power_enabled = on;
+    if (gps_handle) {
+        xTaskNotifyGive(gps_handle);
+    } else {
+        gps_rail(on);
+    }
+}
+
+gps_power_state_t gps_power_state(void)
+{
+    return gps_power;
+}
+
+uint32_t gps_power_ttff_ms(void)
+{
+    return gps_power_ttff;
+}
+
+void gps_request_assist(void)
+{
+    gps_assist_pending = true;
+    if (gps_handle) xTaskNotifyGive(gps_handle);
+}
+
+bool gps_set_ubx(bool enable, uint8_t rate_hz)
+{
+    if (rate_hz < GPS_UBX_RATE_MIN) rate_hz = GPS_UBX_RATE_MIN;
+    if (rate_hz > GPS_UBX_RATE_MAX) rate_hz = GPS_UBX_RATE_MAX;
+    gps_ubx_enabled = enable;
+    gps_ubx_rate_hz = rate_hz;
+    
+    // The GPS task owns the port, it sends the configuration on its next wake
+    gps_mode_pending = true;
+    if (gps_handle) xTaskNotifyGive(gps_handle);
+    return gps_handle != NULL;
+}
+
+bool gps_get_ubx(uint8_t *rate_hz)
+{
+    if (rate_hz) *rate_hz = gps_ubx_rate_hz;
+    return gps_ubx_enabled;
+}
+
+void gps_restore_fix(const gps_fix_t *fix, uint32_t age_ms)
+{
+    // gps_work belongs to the task once it runs
+    if (gps_handle || !fix->valid) return;
+    gps_work = *fix;
+    gps_work.version = 1;
+    gps_work.time_ms = millis() - age_ms;   // Ages past boot wrap, age arithmetic still holds
+    gps_fix_store(&gps_work);
+}
+
+void gps_set_fix_notify(void (*cb)(void))
+{
+    gps_fix_notify = cb;
+}
+
+uint32_t gps_get_fix(gps_fix_t *fix)
+{
+    gps_fix_read(fix);
+    return fix->version;
 }
 
 void gps_get_coord(double *lat, double *lng)
 {
-    *lat = gps_lat;
-    *lng = gps_lng;
+    gps_fix_t fix;
+    gps_fix_read(&fix);
+    *lat = fix.lat;
+    *lng = fix.lng;
 }
 
 void gps_get_data(uint16_t *year, uint8_t *month, uint8_t *day)
 {
-    *year = gps_year;
-    *month = gps_month;
-    *day = gps_day;
+    gps_fix_t fix;
+    gps_fix_read(&fix);
+    *year = fix.year;
+    *month = fix.month;
+    *day = fix.day;
 }
 
 void gps_get_time(uint8_t *hour, uint8_t *minute, uint8_t *second)
 {
-    *hour = gps_hour;
-    *minute = gps_minute;
-    *second = gps_second;
+    gps_fix_t fix;
+    gps_fix_read(&fix);
+    *hour = fix.hour;
+    *minute = fix.minute;
+    *second = fix.second;
 }
 
 void gps_get_satellites(uint32_t *vsat)
 {
-    *vsat = gps_vsat;   // Visible Satellites
+    gps_fix_t fix;
+    gps_fix_read(&fix);
+    *vsat = fix.vsat;   // Visible Satellites
 }
 
 void gps_get_speed(double *speed)
 {
-    *speed = gps_speed;
+    gps_fix_t fix;
+    gps_fix_read(&fix);
+    *speed = fix.speed;
+}
+
+void gps_get_accuracy(float *h_acc, float *v_acc)
+{
+    gps_fix_t fix;
+    gps_fix_read(&fix);
+    *h_acc = fix.h_acc;
+    *v_acc = fix.v_acc;
 }
 
 /* clang-format on */
+static void gps_store()
+{
+    gps_fix_t *fix = &gps_work;
+    // Reading the time clears its updated flag, so first
+    bool timed = gps.time.isUpdated() && gps.time.isValid() && gps.date.isValid() && gps.location.isValid();
+    fix->valid = gps.location.isValid();
+    if (fix->valid) {
+        fix->lat = gps.location.lat();
+        fix->lng = gps.location.lng();
+    }
+    if (gps.altitude.isValid()) {
+        fix->altitude = gps.altitude.meters();
+    }
+    if (gps.date.isValid()) {
+        fix->year = gps.date.year();
+        fix->month = gps.date.month();
+        fix->day = gps.date.day();
+    }
+    if (gps.time.isValid()) {
+        fix->hour = gps.time.hour();
+        fix->minute = gps.time.minute();
+        fix->second = gps.time.second();
+    }
+    if (gps.satellites.isValid()) {
+        fix->vsat = gps.satellites.value();
+    }
+    if (gps.speed.isValid()) {
+        fix->speed = gps.speed.kmph();
+    }
+    if (gps.course.isValid()) {
+        fix->heading = gps.course.deg();
+    }
+    if (timed) {
+        int64_t epoch = time_make_utc(fix->year, fix->month, fix->day, fix->hour, fix->minute, fix->second) * 1000000LL +
+                        gps.time.centisecond() * 10000;
+        gps_time_feed(epoch, 0);
+    }
+    gps_fix_publish(fix);
+    gps_location_notify(fix);
+}
+
 void displayInfo()
 {
     // Performance optimization: Disable GPS console output for launcher performance
     // Only update GPS data variables, no serial printing to reduce system load
     static bool gps_console_disabled = true; // Set to false to re-enable GPS console output
-
+    
     if (gps_console_disabled) {
-        // Silent mode: Only update variables, no console output
-        if (gps.location.isValid()) {
-            gps_lat = gps.location.lat();
-            gps_lng = gps.location.lng();
-        }
-        if (gps.date.isValid()) {
-            gps_year = gps.date.year();
-            gps_month = gps.date.month();
-            gps_day = gps.date.day();
-        }
-        if (gps.time.isValid()) {
-            gps_hour = gps.time.hour();
-            gps_minute = gps.time.minute();
-            gps_second = gps.time.second();
-        }
-        if (gps.satellites.isValid()) {
-            gps_vsat = gps.satellites.value();
-        }
-        if (gps.speed.isValid()) {
-            gps_speed = gps.speed.kmph();
-        }
-        return; // Exit early to avoid console output
+        // Silent mode: gps_store() already took the fix, no console output
+        return;
     }
-
+    
     // Original console output code (only runs if gps_console_disabled = false)
-
+    
     if (gps.location.isValid())
     {
-        gps_lat = gps.location.lat();
-        gps_lng = gps.location.lng();
         // Performance optimization: Only print location when it changes significantly
         static double last_lat = 0, last_lng = 0;
-        if (abs(gps_lat - last_lat) > 0.0001 || abs(gps_lng - last_lng) > 0.0001) {
+        if (abs(gps_work.lat - last_lat) > 0.0001 || abs(gps_work.lng - last_lng) > 0.0001) {
             Serial.print(F("Location: "));
-            Serial.print(gps_lat, 6);
+            Serial.print(gps_work.lat, 6);
             Serial.print(F(","));
-            Serial.print(gps_lng, 6);
-            last_lat = gps_lat;
-            last_lng = gps_lng;
+            Serial.print(gps_work.lng, 6);
+            last_lat = gps_work.lat;
+            last_lng = gps_work.lng;
         }
     }
     else
@@ -188,25 +888,22 @@ void displayInfo()
             invalid_printed = true;
         }
     }
-
+    
     if (gps.date.isValid())
     {
-        gps_year = gps.date.year();
-        gps_month = gps.date.month();
-        gps_day = gps.date.day();
         // Performance optimization: Only print date when it changes
         static uint16_t last_year = 0;
         static uint8_t last_month = 0, last_day = 0;
-        if (gps_year != last_year || gps_month != last_month || gps_day != last_day) {
+        if (gps_work.year != last_year || gps_work.month != last_month || gps_work.day != last_day) {
             Serial.print(F("  Date/Time: "));
-            Serial.print(gps_month);
+            Serial.print(gps_work.month);
             Serial.print(F("/"));
-            Serial.print(gps_day);
+            Serial.print(gps_work.day);
             Serial.print(F("/"));
-            Serial.print(gps_year);
-            last_year = gps_year;
-            last_month = gps_month;
-            last_day = gps_day;
+            Serial.print(gps_work.year);
+            last_year = gps_work.year;
+            last_month = gps_work.month;
+            last_day = gps_work.day;
         }
     }
     else
@@ -218,48 +915,43 @@ void displayInfo()
             date_invalid_printed = true;
         }
     }
-
+    
     Serial.print(F(" "));
     if (gps.time.isValid())
     {
-        gps_hour = gps.time.hour();
-        gps_minute = gps.time.minute();
-        gps_second = gps.time.second();
-
-        if (gps_hour < 10)
+    
+        if (gps_work.hour < 10)
             Serial.print(F("0"));
-        Serial.print(gps_hour);
+        Serial.print(gps_work.hour);
         Serial.print(F(":"));
-        if (gps_minute < 10)
+        if (gps_work.minute < 10)
             Serial.print(F("0"));
-        Serial.print(gps_minute);
+        Serial.print(gps_work.minute);
         Serial.print(F(":"));
-        if (gps_second < 10)
+        if (gps_work.second < 10)
             Serial.print(F("0"));
-        Serial.print(gps_second);
+        Serial.print(gps_work.second);
         Serial.print(F("."));
     }
     else
     {
         Serial.print(F("INVALID"));
     }
-
+    
     Serial.print(F("  Satellites: "));
     if(gps.satellites.isValid())
     {
-        gps_vsat = gps.satellites.value();
-        Serial.print(gps_vsat);
+        Serial.print(gps_work.vsat);
         Serial.print(F(" "));
     }
-
+    
     Serial.print(F("  Speed: "));
     if(gps.speed.isValid())
     {
-        gps_speed = gps.speed.kmph();
-        Serial.print(gps_speed);
+        Serial.print(gps_work.speed);
         Serial.print(F(" "));
     }
-
+    
     Serial.println();
 }
 /* clang-format off */
@@ -287,7 +979,7 @@ bool setupGPS()
         Serial.println();
         SerialGPS.flush();
         delay(200);
-
+    
         SerialGPS.write("$PCAS06,0*1B\r\n");
         startTimeout = millis() + 500;
         String ver = "";
@@ -323,7 +1015,7 @@ static int getAck(uint8_t *buffer, uint16_t size, uint8_t requestedClass, uint8_
     bool        ubxFrame = 0;
     uint32_t    startTime = millis();
     uint16_t    needRead;
-
+    
     while (millis() - startTime < 800) {
         while (SerialGPS.available()) {
             int c = SerialGPS.read();
@@ -373,7 +1065,7 @@ static int getAck(uint8_t *buffer, uint16_t size, uint8_t requestedClass, uint8_
                     return needRead;
                 }
                 break;
-
+    
             default:
                 break;
             }
@@ -388,7 +1080,7 @@ static bool GPS_Recovery()
     uint8_t cfg_clear2[] = {0xB5, 0x62, 0x06, 0x09, 0x0D, 0x00, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x1B, 0xA1};
     uint8_t cfg_clear3[] = {0xB5, 0x62, 0x06, 0x09, 0x0D, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, 0x03, 0x1D, 0xB3};
     SerialGPS.write(cfg_clear1, sizeof(cfg_clear1));
-
+    
     if (getAck(buffer, 256, 0x05, 0x01)) {
         Serial.println("Get ack successes!");
     }
@@ -400,7 +1092,7 @@ static bool GPS_Recovery()
     if (getAck(buffer, 256, 0x05, 0x01)) {
         Serial.println("Get ack successes!");
     }
-
+    
     // UBX-CFG-RATE, Size 8, 'Navigation/measurement rate settings'
     uint8_t cfg_rate[] = {0xB5, 0x62, 0x06, 0x08, 0x00, 0x00, 0x0E, 0x30};
     SerialGPS.write(cfg_rate, sizeof(cfg_rate));
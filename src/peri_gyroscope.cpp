@@ -2,9 +2,21 @@
 #include <Wire.h>
 #include <SPI.h>
 #include <Arduino.h>
+#include <esp_sleep.h>
+#include <driver/gpio.h>
+#include <hal/gpio_ll.h>
 #include "SensorBHI260AP.hpp"
 #include "utilities.h"
 #include "peripheral.h"
+#include "boot_trace.h"
+#include "power_domain.h"
+#include "i2c_bus.h"
+
+#define BHI260_EVT_INT      0x01
+#define BHI260_EVT_FLUSH    0x02
+#define BHI260_EVT_CONFIG   0x04
+#define BHI260_CONFIG_SLOTS 4       // sensor changes waiting for the hub task
+#define BHI260_FLUSH_ALL    0xFE    // bhy2_flush_fifo(): every virtual sensor
 
 SensorBHI260AP bhy;
 struct bhy2_data_xyz accel_data;
@@ -15,55 +27,169 @@ float accel_factor;
 float gyro_factor;
 float magn_factor;
 
+static TaskHandle_t bhi_task_handle = NULL;
+static portMUX_TYPE bhi_mux = portMUX_INITIALIZER_UNLOCKED;
+static bhi260_stats_t bhi_stats;
+static bhi260_event_cb bhi_event_cb = NULL;
+static bhi260_quat_cb bhi_quat_cb = NULL;
+static bhi260_imu_cb bhi_imu_cb = NULL;
+static bhi260_imu_t bhi_imu;                // hub task only
+static uint32_t bhi_burst_ms = 0;           // millis() of the last FIFO read
+static volatile bool bhi_flush_pending = false;
+
+typedef struct {
+    uint8_t sensor_id;
+    float rate_hz;
+    uint32_t latency_ms;
+} bhi_config_t;
+static bhi_config_t bhi_config[BHI260_CONFIG_SLOTS];
+static uint8_t bhi_config_count = 0;
+
+// INT is a level held until the FIFO is read: the ISR masks it and the task
+// unmasks it after the burst, so a level wake from light sleep cannot storm
+static void IRAM_ATTR bhi_int_isr(void)
+{
+    gpio_ll_intr_disable(&GPIO, (gpio_num_t)BOARD_GYROSCOPDE_INT);
+    BaseType_t woken = pdFALSE;
+    if(bhi_task_handle){
+        xTaskNotifyFromISR(bhi_task_handle, BHI260_EVT_INT, eSetBits, &woken);
+    }
+    portYIELD_FROM_ISR(woken);
+}
+
+// Batched samples arrive back to back in one burst; only the newest is kept
 void accel_process_callback(uint8_t sensor_id, uint8_t *data_ptr, uint32_t len, uint64_t *timestamp)
 {
     accel_factor = get_sensor_default_scaling(sensor_id);
+    portENTER_CRITICAL(&bhi_mux);
     bhy2_parse_xyz(data_ptr, &accel_data);
-    // Serial.print(bhy.getSensorName(sensor_id));
-    // Serial.print(":");
-    // Serial.printf("x: %f, y: %f, z: %f;\r\n",
-    //               accel_data.x * accel_factor,
-    //               accel_data.y * accel_factor,
-    //               accel_data.z * accel_factor
-    //              );
+    bhi_stats.samples++;
+    portEXIT_CRITICAL(&bhi_mux);
+    bhi_imu.accel[0] = accel_data.x;
+    bhi_imu.accel[1] = accel_data.y;
+    bhi_imu.accel[2] = accel_data.z;
 }
 
 void gyro_process_callback(uint8_t sensor_id, uint8_t *data_ptr, uint32_t len, uint64_t *timestamp)
 {
     gyro_factor = get_sensor_default_scaling(sensor_id);
+    portENTER_CRITICAL(&bhi_mux);
     bhy2_parse_xyz(data_ptr, &gyro_data);
-    // Serial.print(bhy.getSensorName(sensor_id));
-    // Serial.print(":");
-    // Serial.printf("x: %f, y: %f, z: %f;\r\n",
-    //               gyro_data.x * gyro_factor,
-    //               gyro_data.y * gyro_factor,
-    //               gyro_data.z * gyro_factor
-    //              );
+    bhi_stats.samples++;
+    portEXIT_CRITICAL(&bhi_mux);
+    bhi260_imu_cb cb = bhi_imu_cb;
+    if(cb){
+        bhi_imu.gyro[0] = gyro_data.x;
+        bhi_imu.gyro[1] = gyro_data.y;
+        bhi_imu.gyro[2] = gyro_data.z;
+        bhi_imu.gyro_dps = gyro_factor;
+        bhi_imu.steps = bhi_stats.steps;
+        bhi_imu.timestamp = *timestamp;
+        cb(&bhi_imu);
+    }
 }
 
 void magn_process_callback(uint8_t sensor_id, uint8_t *data_ptr, uint32_t len, uint64_t *timestamp)
 {
     magn_factor = get_sensor_default_scaling(sensor_id);
+    portENTER_CRITICAL(&bhi_mux);
     bhy2_parse_xyz(data_ptr, &magn_data);
-    Serial.print(bhy.getSensorName(sensor_id));
-    // Serial.print(":");
-    // Serial.printf("x: %f, y: %f, z: %f;\r\n",
-    //               magn_data.x * magn_factor,
-    //               magn_data.y * magn_factor,
-    //               magn_data.z * magn_factor
-    //              );
+    portEXIT_CRITICAL(&bhi_mux);
+}
+
+static void step_process_callback(uint8_t sensor_id, uint8_t *data_ptr, uint32_t len, uint64_t *timestamp)
+{
+    bhi_stats.steps = bhy2_parse_step_counter(data_ptr);
+    if(bhi_event_cb) bhi_event_cb(sensor_id, bhi_stats.steps);
+}
+
+static void orientation_process_callback(uint8_t sensor_id, uint8_t *data_ptr, uint32_t len, uint64_t *timestamp)
+{
+    bhi_stats.orientation = data_ptr[0];
+    if(bhi_event_cb) bhi_event_cb(sensor_id, bhi_stats.orientation);
+}
+
+static void motion_process_callback(uint8_t sensor_id, uint8_t *data_ptr, uint32_t len, uint64_t *timestamp)
+{
+    bhi_stats.significant_motion++;
+    if(bhi_event_cb) bhi_event_cb(sensor_id, bhi_stats.significant_motion);
+}
+
+// Stationary detect and any motion: the event is the data
+static void detect_process_callback(uint8_t sensor_id, uint8_t *data_ptr, uint32_t len, uint64_t *timestamp)
+{
+    if(bhi_event_cb) bhi_event_cb(sensor_id, 1);
+}
+
+static void activity_process_callback(uint8_t sensor_id, uint8_t *data_ptr, uint32_t len, uint64_t *timestamp)
+{
+    if(bhi_event_cb) bhi_event_cb(sensor_id, data_ptr[0] | (data_ptr[1] << 8));
+}
+
+static void quat_process_callback(uint8_t sensor_id, uint8_t *data_ptr, uint32_t len, uint64_t *timestamp)
+{
+    struct bhy2_data_quaternion q;
+    bhy2_parse_quaternion(data_ptr, &q);
+    float s = get_sensor_default_scaling(sensor_id);
+    if(bhi_quat_cb) bhi_quat_cb(q.w * s, q.x * s, q.y * s, q.z * s);
+}
+
+// One burst per interrupt: the FIFO comes over in BHY_PROCESS_BUFFER_SIZE
+// reads instead of a transaction per sample
+static void bhi_task(void *param)
+{
+    while(1){
+        uint32_t bits = 0;
+        xTaskNotifyWait(0, UINT32_MAX, &bits, portMAX_DELAY);
+
+        if(bits & BHI260_EVT_FLUSH){
+            // The hub answers with INT once the batched data is in the FIFO
+            i2c_bus_acquire(I2C_DEV_BHI260);
+            bhy2_flush_fifo(BHI260_FLUSH_ALL, bhy.getHandler());
+            i2c_bus_release(I2C_DEV_BHI260);
+            bhi_stats.flushes++;
+            bhi_flush_pending = false;
+        }
+        if(bits & BHI260_EVT_CONFIG){
+            bhi_config_t config[BHI260_CONFIG_SLOTS];
+            portENTER_CRITICAL(&bhi_mux);
+            uint8_t n = bhi_config_count;
+            memcpy(config, bhi_config, n * sizeof(config[0]));
+            bhi_config_count = 0;
+            portEXIT_CRITICAL(&bhi_mux);
+            for(uint8_t i = 0; i < n; i++){
+                i2c_bus_acquire(I2C_DEV_BHI260);
+                bool ok = bhy.configure(config[i].sensor_id, config[i].rate_hz, config[i].latency_ms);
+                i2c_bus_release(I2C_DEV_BHI260, ok);
+                if(!ok) Serial.printf("BHI260AP: sensor %u not configured\n", config[i].sensor_id);
+            }
+        }
+        if(bits & BHI260_EVT_INT){
+            i2c_bus_acquire(I2C_DEV_BHI260);
+            bhy.update();
+            i2c_bus_release(I2C_DEV_BHI260);
+            bhi_burst_ms = millis();
+            bhi_stats.bursts++;
+            gpio_intr_enable((gpio_num_t)BOARD_GYROSCOPDE_INT);
+        }
+    }
 }
 
 /**
- * int val_type 
+ * int val_type
  *      1 --- acceleration
  *      2 --- gyroscope
  *      3 --- Magnetometer
 */
 void BHI260AP_get_val(int val_type, float *x, float *y, float *z)
 {
-    bhy.update();
+    // A live reader asks for the batch early rather than see a second-old sample
+    if(bhi_task_handle && !bhi_flush_pending && millis() - bhi_burst_ms > BHI260_LIVE_MS){
+        bhi_flush_pending = true;
+        xTaskNotify(bhi_task_handle, BHI260_EVT_FLUSH, eSetBits);
+    }
 
+    portENTER_CRITICAL(&bhi_mux);
     switch (val_type) {
         case 1:
             *x = accel_data.x * accel_factor;
@@ -86,14 +212,84 @@ void BHI260AP_get_val(int val_type, float *x, float *y, float *z)
             *z = 0;
             break;
     }
+    portEXIT_CRITICAL(&bhi_mux);
+}
+
+bool BHI260AP_set_batching(float rate_hz, uint32_t latency_ms)
+{
+    if(!bhy.getHandler()) return false;
+
+    bool ok = bhy.configure(SENSOR_ID_ACC_PASS, rate_hz, latency_ms);
+    ok &= bhy.configure(SENSOR_ID_GYRO_PASS, rate_hz, latency_ms);
+    Serial.printf("BHI260AP batching %.0f Hz, %lu ms latency\n", rate_hz, latency_ms);
+    return ok;
+}
+
+void BHI260AP_get_stats(bhi260_stats_t *out)
+{
+    portENTER_CRITICAL(&bhi_mux);
+    *out = bhi_stats;
+    portEXIT_CRITICAL(&bhi_mux);
+}
+
+void BHI260AP_set_event_cb(bhi260_event_cb cb)
+{
+    bhi_event_cb = cb;
+}
+
+void BHI260AP_set_imu_cb(bhi260_imu_cb cb)
+{
+    bhi_imu_cb = cb;
+}
+
+bool BHI260AP_set_rotation_cb(bhi260_quat_cb cb, float rate_hz, uint32_t latency_ms)
+{
+    if(!bhy.getHandler()) return false;
+
+    bhi_quat_cb = cb;
+    if(!cb) rate_hz = 0;
+    bool ok = bhy.configure(SENSOR_ID_GAMERV, rate_hz, latency_ms);
+    Serial.printf("BHI260AP game rotation %.1f Hz %s\n", rate_hz, ok ? "set" : "failed");
+    return ok;
+}
+
+bool BHI260AP_set_sensor(uint8_t sensor_id, float rate_hz, uint32_t latency_ms)
+{
+    if(!bhi_task_handle) return false;
+
+    // A later change to the same sensor replaces one still waiting
+    portENTER_CRITICAL(&bhi_mux);
+    uint8_t i = 0;
+    while(i < bhi_config_count && bhi_config[i].sensor_id != sensor_id) i++;
+    bool ok = i < BHI260_CONFIG_SLOTS;
+    if(ok){
+        bhi_config[i].sensor_id = sensor_id;
+        bhi_config[i].rate_hz = rate_hz;
+        bhi_config[i].latency_ms = latency_ms;
+        if(i == bhi_config_count) bhi_config_count++;
+    }
+    portEXIT_CRITICAL(&bhi_mux);
+    if(ok) xTaskNotify(bhi_task_handle, BHI260_EVT_CONFIG, eSetBits);
+    return ok;
 }
 
 bool BHI260AP_init(void)
 {
-    // Set the reset pin and interrupt pin, if any
-    bhy.setPins(BOARD_GYROSCOPDE_RST, BOARD_GYROSCOPDE_INT);
+    // Already up, e.g. brought up by a service before the UI asked for it
+    if(bhi_task_handle) return true;
+
+    power_domain_acquire(power_domain_user(PWR_DOMAIN_1V8, "gyro"));
+    power_domain_wait(PWR_DOMAIN_1V8);
+
+    // INT goes to our own task, so the library polls nothing and keeps no ISR
+    bhy.setPins(BOARD_GYROSCOPDE_RST, SENSOR_PIN_NONE);
 
-    if (!bhy.init(Wire, BOARD_I2C_SDA, BOARD_I2C_SCL, BHI260AP_SLAVE_ADDRESS_L)) {
+    // init() uploads the sensor firmware, the longest step of the bring-up
+    uint8_t fw_span = boot_trace_begin("BHI260.fw");
+    bool fw_ok = bhy.init(Wire, BOARD_I2C_SDA, BOARD_I2C_SCL, BHI260AP_SLAVE_ADDRESS_L);
+    boot_trace_end(fw_span);
+
+    if (!fw_ok) {
         Serial.print("Failed to init BHI260AP - ");
         Serial.println(bhy.getError());
         return false;
@@ -102,13 +298,9 @@ bool BHI260AP_init(void)
     // Output all available sensors to Serial
     // bhy.printSensors(Serial);
 
-    float sample_rate = 100.0;      /* Read out hintr_ctrl measured at 100Hz */
-    uint32_t report_latency_ms = 0; /* Report immediately */
-
-    // Enable acceleration
-    bhy.configure(SENSOR_ID_ACC_PASS, sample_rate, report_latency_ms);
-    // Enable gyroscope
-    bhy.configure(SENSOR_ID_GYRO_PASS, sample_rate, report_latency_ms);
+    // Level INT, active high: it stays up until the FIFO is read, so a burst
+    // that arrives in light sleep is still pending on wake
+    bhy.setInterruptCtrl(BHY2_ICTL_DISABLE_STATUS_FIFO | BHY2_ICTL_DISABLE_DEBUG);
 
     // Set the acceleration sensor result callback function
     bhy.onResultEvent(SENSOR_ID_ACC_PASS, accel_process_callback);
@@ -119,5 +311,28 @@ bool BHI260AP_init(void)
     // Set the Magnetometer sensor result callback function
     bhy.onResultEvent(SENSOR_ID_MAG_PASS, magn_process_callback);
 
+    bhy.onResultEvent(SENSOR_ID_STC_WU, step_process_callback);
+    bhy.onResultEvent(SENSOR_ID_DEVICE_ORI_WU, orientation_process_callback);
+    bhy.onResultEvent(SENSOR_ID_SIG_HW_WU, motion_process_callback);
+    bhy.onResultEvent(SENSOR_ID_GAMERV, quat_process_callback);
+    bhy.onResultEvent(SENSOR_ID_STATIONARY_DET, detect_process_callback);
+    bhy.onResultEvent(SENSOR_ID_ANY_MOTION_WU, detect_process_callback);
+    bhy.onResultEvent(SENSOR_ID_AR, activity_process_callback);
+
+    // Accel and gyro fill the non-wake-up FIFO and come over once per latency period
+    BHI260AP_set_batching(BHI260_RATE_HZ, BHI260_LATENCY_MS);
+
+    // On-change wake-up sensors interrupt right away, whatever is batched
+    if(!bhy.configure(SENSOR_ID_STC_WU, 1, 0)) Serial.println("BHI260AP: no step counter");
+    if(!bhy.configure(SENSOR_ID_DEVICE_ORI_WU, 1, 0)) Serial.println("BHI260AP: no orientation");
+    if(!bhy.configure(SENSOR_ID_SIG_HW_WU, 1, 0)) Serial.println("BHI260AP: no significant motion");
+
+    xTaskCreate(bhi_task, "bhi_task", 1024 * 3, NULL, BHI260_PRIORITY, &bhi_task_handle);
+    pinMode(BOARD_GYROSCOPDE_INT, INPUT);
+    attachInterrupt(BOARD_GYROSCOPDE_INT, bhi_int_isr, ONHIGH);
+
+    // Its INT wakes the chip from light sleep like the other interrupt lines
+    gpio_wakeup_enable((gpio_num_t)BOARD_GYROSCOPDE_INT, GPIO_INTR_HIGH_LEVEL);
+    esp_sleep_enable_gpio_wakeup();
     return true;
-}
\ No newline at end of file
+}
@@ -1,21 +1,26 @@
 
 #include <Adafruit_TCA8418.h>
+#include <atomic>
+#include <esp_sleep.h>
+#include <driver/gpio.h>
+#include <hal/gpio_ll.h>
 #include "utilities.h"
 #include "peripheral.h"
+#include "boot_trace.h"
+#include "wake_monitor.h"
+#include "i2c_bus.h"
+#include "lvgl_integration.h"
+#include "keymap.h"
+#include "event_replay.h"
 
-#define KEYPAD_ROWS 4
-#define KEYPAD_COLS 10
-#define KEYPAD_PRESS_VAL_MIN   129
-#define KEYPAD_PRESS_VAL_MAX   163
-#define KEYPAD_RELEASE_VAL_MIN 1
-#define KEYPAD_RELEASE_VAL_MAX 35
+#define KEYPAD_EVENT_PRESS     0x80 // KEY_EVENT bit 7, the rest is key number + 1
+#define KEYPAD_EVENT_KEY       0x7F
+#define KEYPAD_EC_MASK         0x0F
+#define KEYPAD_DRAIN_PASSES    4    // FIFO refills while we read it only at typing speed
 
-const char keymap[KEYPAD_ROWS][KEYPAD_COLS] = {
-    {'q', 'w', 'e', 'r', 't', 'y', 'u', 'i', 'o', 'p'},
-    {'a', 's', 'd', 'f', 'g', 'h', 'j', 'k', 'l', '0'},
-    {'2', 'z', 'x', 'c', 'v', 'b', 'n', 'm', '$', 'E'},
-    {' ', ' ', ' ', ' ', ' ', '-', '*', 'S', '0', 'U'},
-};
+// keypad task notification bits
+#define KEYPAD_SIG_INT         0x01
+#define KEYPAD_SIG_INJECT      0x02
 
 Adafruit_TCA8418 keypad; 
 keypad_cb keypad_listener = NULL;
@@ -23,26 +28,222 @@ char keypad_curr_val = ' ';
 int keypad_state = KEYPAD_RELEASE;
 bool keypad_update = false;
 
+static TaskHandle_t keypad_task_handle = NULL;
+static volatile uint32_t keypad_int_ms = 0;
+static volatile uint32_t keypad_int_us = 0;
+static int keypad_address = BOARD_I2C_ADDR_KEYBOARD;
+
+// Single producer (keypad task, or keypad_loop on the UI task before it
+// runs), single consumer (UI task)
+static keypad_event_t keypad_queue[KEYPAD_QUEUE_SIZE];
+static std::atomic<uint16_t> keypad_head(0);   // next slot the producer fills
+static std::atomic<uint16_t> keypad_tail(0);   // next slot the consumer takes
+static keypad_stats_t keypad_stats;
+static uint64_t keypad_glyph_sum = 0;
+
+// Replayed keys as raw KEY_EVENT codes, pushed by the keypad task so the
+// queue above keeps its single producer
+typedef struct {
+    uint8_t code;
+    uint32_t inject_us;
+} keypad_inject_t;
+
+static keypad_inject_t keypad_injected[KEYPAD_INJECT_DEPTH];
+static uint16_t keypad_inject_head = 0;
+static uint16_t keypad_inject_tail = 0;
+static portMUX_TYPE keypad_inject_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static bool keypad_decode(uint8_t code, uint32_t time_ms, uint32_t irq_us, keypad_event_t *ev)
+{
+    uint8_t k = (code & KEYPAD_EVENT_KEY) - 1;
+    if(k >= KEYMAP_KEYS) return false;
+
+    ev->time_ms = time_ms;
+    ev->irq_us = irq_us;
+    ev->read_us = micros();
+    ev->code = k;
+    ev->val = keymap_lookup(KEYMAP_LAYER_BASE, k);
+    ev->state = code & KEYPAD_EVENT_PRESS ? KEYPAD_PRESS : KEYPAD_RELEASE;
+    return true;
+}
+
+static void keypad_push(uint8_t code, uint32_t time_ms, uint32_t irq_us)
+{
+    keypad_event_t ev;
+    if(!keypad_decode(code, time_ms, irq_us, &ev)) return;
+    if(event_replay_recording()){
+        EventReplayKey rec = {ev.code, ev.state, ev.val, 0};
+        event_replay_record(REPLAY_SRC_KEY, &rec, sizeof(rec));
+    }
+
+    uint16_t head = keypad_head.load(std::memory_order_relaxed);
+    uint16_t tail = keypad_tail.load(std::memory_order_acquire);
+    if((uint16_t)(head - tail) >= KEYPAD_QUEUE_SIZE){
+        keypad_stats.dropped++;
+        return;
+    }
+    keypad_queue[head & (KEYPAD_QUEUE_SIZE - 1)] = ev;
+    keypad_head.store(head + 1, std::memory_order_release);
+    keypad_stats.events++;
+}
+
+// With the bus held. CFG.AI is clear, so a multi-byte read of KEY_EVENT_A
+// pops one FIFO entry per byte
+static bool keypad_read(uint8_t reg, uint8_t *buf, uint8_t len)
+{
+    Wire.beginTransmission(keypad_address);
+    Wire.write(reg);
+    if(Wire.endTransmission(false) != 0) return false;
+    if(Wire.requestFrom(keypad_address, (int)len) != len) return false;
+    for(uint8_t i = 0; i < len; i++){
+        buf[i] = Wire.read();
+    }
+    return true;
+}
+
+// Empty the FIFO and clear the status that holds INT low
+static void keypad_drain(uint32_t time_ms, uint32_t irq_us)
+{
+    uint8_t codes[KEYPAD_FIFO_DEPTH];
+
+    if(!i2c_bus_acquire(I2C_DEV_KEYPAD)) return;
+    bool ok = true;
+    for(int pass = 0; ok && pass < KEYPAD_DRAIN_PASSES; pass++){
+        uint8_t status = 0, count = 0;
+        ok = keypad_read(TCA8418_REG_INT_STAT, &status, 1) &&
+             keypad_read(TCA8418_REG_KEY_LCK_EC, &count, 1);
+        if(!ok) break;
+        count &= KEYPAD_EC_MASK;
+        if(count > KEYPAD_FIFO_DEPTH) count = KEYPAD_FIFO_DEPTH;
+
+        if(count){
+            ok = keypad_read(TCA8418_REG_KEY_EVENT_A, codes, count);
+            if(!ok) break;
+            keypad_stats.bursts++;
+            for(uint8_t i = 0; i < count; i++){
+                keypad_push(codes[i], time_ms, irq_us);
+            }
+        }
+        if(status & TCA8418_REG_STAT_OVR_FLOW_INT){
+            keypad_stats.overflows++;
+        }
+        if(status){
+            keypad.writeRegister(TCA8418_REG_INT_STAT, status);
+        }
+        // keys that landed after the count was read keep INT asserted
+        if(!count && !status) break;
+    }
+    i2c_bus_release(I2C_DEV_KEYPAD, ok);
+}
+
+// INT is active low and held until the status is cleared: masked here,
+// unmasked by the task once the FIFO is empty
+static void IRAM_ATTR keypad_int_isr(void)
+{
+    gpio_ll_intr_disable(&GPIO, (gpio_num_t)BOARD_KEYBOARD_INT);
+    keypad_int_ms = millis();
+    keypad_int_us = micros();
+    BaseType_t woken = pdFALSE;
+    if(keypad_task_handle){
+        xTaskNotifyFromISR(keypad_task_handle, KEYPAD_SIG_INT, eSetBits, &woken);
+    }
+    portYIELD_FROM_ISR(woken);
+}
+
+static void keypad_drain_injected(void)
+{
+    keypad_inject_t item;
+    while(1){
+        bool got = false;
+        portENTER_CRITICAL(&keypad_inject_mux);
+        if(keypad_inject_tail != keypad_inject_head){
+            item = keypad_injected[keypad_inject_tail++ & (KEYPAD_INJECT_DEPTH - 1)];
+            got = true;
+        }
+        portEXIT_CRITICAL(&keypad_inject_mux);
+        if(!got) return;
+        // the injection stands in for the INT edge, so input_trace times it
+        keypad_push(item.code, millis(), item.inject_us);
+    }
+}
+
+static void keypad_task(void *param)
+{
+    while(1){
+        uint32_t sig = 0;
+        xTaskNotifyWait(0, UINT32_MAX, &sig, portMAX_DELAY);
+
+        uint16_t before = keypad_head.load(std::memory_order_relaxed);
+        if(sig & KEYPAD_SIG_INT){
+            keypad_drain(keypad_int_ms, keypad_int_us);
+        }
+        if(sig & KEYPAD_SIG_INJECT){
+            keypad_drain_injected();
+        }
+        if(keypad_head.load(std::memory_order_relaxed) != before && LVGL){
+            LVGL->wake();
+        }
+        if(sig & KEYPAD_SIG_INT){
+            gpio_intr_enable((gpio_num_t)BOARD_KEYBOARD_INT);
+        }
+    }
+}
+
 bool keypad_init(int address)
 {
+    if(keypad_task_handle) return true;
+
+    BOOT_TRACE_SCOPE("Keypad");
     if(!i2cIsInit(0)){
         Wire.begin(BOARD_KEYBOARD_SDA, BOARD_KEYBOARD_SCL);
         Wire.beginTransmission(address);
         Wire.endTransmission(true);
     }
 
-    if (!keypad.begin(address, &Wire)) {
+    i2c_bus_acquire(I2C_DEV_KEYPAD);
+    bool found = keypad.begin(address, &Wire);
+    if (found) {
+        keypad_address = address;
+
+        // configure the size of the keypad matrix.
+        // all other pins will be inputs
+        keypad.matrix(KEYMAP_ROWS, KEYMAP_COLS);
+
+        // no auto-increment, so the FIFO drains in one read
+        uint8_t cfg = keypad.readRegister(TCA8418_REG_CFG);
+        keypad.writeRegister(TCA8418_REG_CFG, cfg & ~TCA8418_REG_CFG_AI);
+
+        // raise INT on key events so the UI loop can sleep between keys
+        keypad.enableInterrupts();
+    }
+    i2c_bus_release(I2C_DEV_KEYPAD, found);
+
+    if (!found) {
         // Serial.println("keypad not found, check wiring & pullups!");
         log_e("keypad not found, check wiring & pullups!");
         return false;
     }
 
-    // configure the size of the keypad matrix.
-    // all other pins will be inputs
-    keypad.matrix(KEYPAD_ROWS, KEYPAD_COLS);
+    // a key that woke the board from deep sleep was taken by the wake check,
+    // and keys typed during the boot are still queued behind it
+    uint8_t woke = wake_monitor_take_key();
+    if(woke){
+        keypad_push(woke, millis(), 0);     // no INT edge to trace from
+    } else {
+        // flush the internal buffer
+        i2c_bus_acquire(I2C_DEV_KEYPAD);
+        keypad.flush();
+        keypad.writeRegister(TCA8418_REG_INT_STAT, 0xFF);
+        i2c_bus_release(I2C_DEV_KEYPAD);
+    }
+
+    // Nothing polls the keypad: its task sleeps until INT
+    xTaskCreate(keypad_task, "keypad_task", 1024 * 3, NULL, KEYPAD_PRIORITY, &keypad_task_handle);
+    pinMode(BOARD_KEYBOARD_INT, INPUT_PULLUP);
+    attachInterrupt(BOARD_KEYBOARD_INT, keypad_int_isr, ONLOW);
 
-    // flush the internal buffer
-    keypad.flush();
+    gpio_wakeup_enable((gpio_num_t)BOARD_KEYBOARD_INT, GPIO_INTR_LOW_LEVEL);
+    esp_sleep_enable_gpio_wakeup();
 
     return true;
 }
@@ -60,39 +261,65 @@ void keypad_set_flag(void)
     keypad_update = false;
 }
 
-void keypad_loop(void)
+bool keypad_event_take(keypad_event_t *ev)
 {
-    char c = -1;
-    int state = -1;
-    int row, col;
-    int k = keypad.getEvent();
-    int v = keypad.available();
+    uint16_t tail = keypad_tail.load(std::memory_order_relaxed);
+    if(tail == keypad_head.load(std::memory_order_acquire)) return false;
 
-    if(k >=KEYPAD_RELEASE_VAL_MIN && k <= KEYPAD_RELEASE_VAL_MAX){ // release event
-        k = k - KEYPAD_RELEASE_VAL_MIN;
-        state = KEYPAD_RELEASE;
-    }   
+    *ev = keypad_queue[tail & (KEYPAD_QUEUE_SIZE - 1)];
+    keypad_tail.store(tail + 1, std::memory_order_release);
 
-    if(k >=KEYPAD_PRESS_VAL_MIN && k <= KEYPAD_PRESS_VAL_MAX){ // press event
-        k = k - KEYPAD_PRESS_VAL_MIN;
-        state = KEYPAD_PRESS;
-    }
+    keypad_curr_val = ev->val;
+    keypad_state = ev->state;
+    keypad_update = true;
+    if(keypad_listener) keypad_listener(ev->state, ev->val);
+    return true;
+}
 
-    if(state != -1){
-        row = k / KEYPAD_COLS;
-        col = (KEYPAD_COLS-1) - k % KEYPAD_COLS;
-        c = keymap[row][col];
-        Serial.printf("k=%d, v=%d, press:%d, %d, %c\n", k, v, row, col, c);
-        // if(keypad_listener)
-        //     keypad_listener(state, c);
-        
-        keypad_curr_val = c;
-        keypad_state = state;
-        keypad_update = true;
+bool keypad_pending(void)
+{
+    return keypad_tail.load(std::memory_order_relaxed) != keypad_head.load(std::memory_order_acquire);
+}
+
+// Polled fallback for builds that never start the task
+void keypad_loop(void)
+{
+    if(keypad_task_handle) return;
+    keypad_drain(millis(), 0);
+}
+
+bool keypad_inject(uint8_t code, uint8_t state)
+{
+    if(!keypad_task_handle || code >= KEYMAP_KEYS) return false;
+
+    bool ok = false;
+    portENTER_CRITICAL(&keypad_inject_mux);
+    if((uint16_t)(keypad_inject_head - keypad_inject_tail) < KEYPAD_INJECT_DEPTH){
+        keypad_inject_t *item = &keypad_injected[keypad_inject_head++ & (KEYPAD_INJECT_DEPTH - 1)];
+        item->code = (code + 1) | (state == KEYPAD_PRESS ? KEYPAD_EVENT_PRESS : 0);
+        item->inject_us = micros();
+        ok = true;
     }
+    portEXIT_CRITICAL(&keypad_inject_mux);
+    if(ok) xTaskNotify(keypad_task_handle, KEYPAD_SIG_INJECT, eSetBits);
+    return ok;
 }
 
 void keypad_regetser_cb(keypad_cb cb)
 {
     keypad_listener = cb;
-}
\ No newline at end of file
+}
+
+void keypad_get_stats(keypad_stats_t *out)
+{
+    *out = keypad_stats;
+}
+
+void keypad_note_glyph(uint32_t latency_ms)
+{
+    keypad_stats.glyph_last_ms = latency_ms;
+    if(latency_ms > keypad_stats.glyph_max_ms) keypad_stats.glyph_max_ms = latency_ms;
+    keypad_stats.glyph_count++;
+    keypad_glyph_sum += latency_ms;
+    keypad_stats.glyph_avg_ms = keypad_glyph_sum / keypad_stats.glyph_count;
+}
@@ -0,0 +1,53 @@
+
+#include <Arduino.h>
+#include "peripheral.h"
+#include "factory.h"
+#include "hw_probe.h"
+
+// Called from the UI task only (port functions and its idle hook), so no lock
+static peri_init_cb peri_thunks[E_PERI_NUM_MAX] = {0};
+
+void peri_init_defer(int peri_id, peri_init_cb cb)
+{
+    if(peri_id < 0 || peri_id >= E_PERI_NUM_MAX) return;
+
+    peri_thunks[peri_id] = cb;
+    peri_init_st[peri_id] = false;
+}
+
+bool peri_init_ensure(int peri_id)
+{
+    if(peri_id < 0 || peri_id >= E_PERI_NUM_MAX) return false;
+
+    peri_init_cb cb = peri_thunks[peri_id];
+    if(cb && hw_probe_known_absent(peri_id)) {
+        // absent on an earlier self-test: no driver timeouts for a missing part
+        peri_thunks[peri_id] = NULL;
+        Serial.printf("[PERI] deferred init %d skipped, absent\n", peri_id);
+    } else if(cb) {
+        // one attempt, a failure stays false like a failed boot-time init
+        peri_thunks[peri_id] = NULL;
+        uint32_t start = millis();
+        peri_init_st[peri_id] = cb();
+        Serial.printf("[PERI] deferred init %d %s (%lums)\n", peri_id,
+                      peri_init_st[peri_id] ? "done" : "failed", millis() - start);
+    }
+    return peri_init_st[peri_id];
+}
+
+bool peri_init_warmup(void)
+{
+    for(int i = 0; i < E_PERI_NUM_MAX; i++) {
+        if(peri_thunks[i]) {
+            peri_init_ensure(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool peri_init_ready(int peri_id)
+{
+    if(peri_id < 0 || peri_id >= E_PERI_NUM_MAX) return false;
+    return peri_init_st[peri_id];
+}
@@ -1,122 +1,1048 @@
 
 
 #include <RadioLib.h>
+#include <atomic>
+#include <math.h>
+#include <esp_rom_crc.h>
 #include "utilities.h"
 #include "peripheral.h"
+#include "simple_logger.h"
+#include "boot_trace.h"
+#include "lora_stats.h"
+#include "power_governor.h"
+#include "power_domain.h"
+#include "energy_profiler.h"
+#include "spi_bus.h"
+#include "msg_store.h"
+#include "lora_crypt.h"
+#include "lora_codec.h"
+#include "event_replay.h"
+#include "lora_capture.h"
+#ifdef INTEGRATION_LAYER_ENABLED
+#include "integration/event_bridge.h"
+#include "integration/config_manager.h"
+#endif
 
 
-static SX1262 radio = new Module(BOARD_LORA_CS, BOARD_LORA_INT, BOARD_LORA_RST, BOARD_LORA_BUSY);
+static Module *lora_module = new Module(BOARD_LORA_CS, BOARD_LORA_INT, BOARD_LORA_RST, BOARD_LORA_BUSY,
+                                       SPI, spi_bus_settings(SPI_CLIENT_LORA));
+static SX1262 radio = lora_module;
 static int lora_mode = LORA_MODE_SEND;
-static String lora_recv_data;
-static bool lora_recv_success = false;
-static int lora_recv_rssi = 0;
 
-// transmit 
-static int transmissionState = RADIOLIB_ERR_NONE;
-static volatile bool transmittedFlag = false;
+// lora_task and the UI side both drive the radio over SPI, which the SD card
+// and panel share; the radio mutex is always taken before the bus
+static SemaphoreHandle_t lora_mutex = NULL;
+#define LORA_LOCK()   do { xSemaphoreTake(lora_mutex, portMAX_DELAY); spi_bus_acquire(SPI_CLIENT_LORA); } while(0)
+#define LORA_UNLOCK() do { spi_bus_release(SPI_CLIENT_LORA); xSemaphoreGive(lora_mutex); } while(0)
+
+// DIO1 signals both RX done and TX done; lora_task tells them apart by
+// whether a transmission is in flight
+#define LORA_EVT_DIO1    0x01
+#define LORA_EVT_TX_KICK 0x02
+#define LORA_EVT_INJECT  0x04
+
+static TaskHandle_t lora_task_handle = NULL;
 
-static void set_transmit_flag(void){
-    transmittedFlag = true;
+static void IRAM_ATTR lora_dio1_isr(void){
+    BaseType_t woken = pdFALSE;
+    if(lora_task_handle){
+        xTaskNotifyFromISR(lora_task_handle, LORA_EVT_DIO1, eSetBits, &woken);
+    }
+    portYIELD_FROM_ISR(woken);
 }
 
-// receive
+// transmit: a priority queue drained by lora_task under a duty-cycle budget
+typedef struct {
+    uint8_t data[LORA_PACKET_MAX];
+    uint8_t len;
+    uint8_t priority;
+    uint8_t retries;                // attempts left after this one
+    uint8_t attempt;
+    uint32_t seq;                   // FIFO order within a priority
+    uint32_t not_before;            // millis() of the next attempt (retry backoff)
+    uint8_t cad_busy;               // consecutive busy channel scans
+    bool used;
+} lora_tx_slot_t;
+
+static lora_tx_slot_t lora_tx_pool[LORA_TX_POOL_SIZE];
+static uint32_t lora_tx_seq = 1;
+static int lora_tx_active = -1;     // slot on air, or scanning the channel first
+static bool lora_tx_cad = false;    // lora_tx_active is still waiting for its scan
+static uint32_t lora_tx_deadline = 0;
+static int transmissionState = RADIOLIB_ERR_NONE;
+static uint32_t lora_tx_sent_count = 0;
+static uint32_t lora_tx_failed_count = 0;
+static uint32_t lora_tx_dropped_count = 0;
+static uint32_t lora_tx_retry_count = 0;
+static uint32_t lora_tx_packed_count = 0;
+static uint32_t lora_tx_bytes_saved = 0;
+static bool lora_compress = true;
+static uint32_t lora_airtime_total_us = 0;
+static uint8_t lora_tx_queued_max = 0;
+
+// listen-before-talk: a channel scan (CAD) precedes every transmission
+static bool lora_lbt_enabled = false;
+static uint32_t lora_lbt_busy_count = 0;
+
+// token bucket: airtime credit accrues at the duty-cycle rate, capped at
+// one window's worth, and each packet spends its time-on-air
+#define LORA_DUTY_BUDGET_US ((uint32_t)LORA_DUTY_WINDOW_MS * LORA_DUTY_PERMILLE)
+static uint32_t lora_airtime_credit_us = LORA_DUTY_BUDGET_US;
+static uint32_t lora_airtime_stamp = 0;
+
+// receive: lora_task reads each packet straight into the next free slot
+// of a single-producer/single-consumer ring
 static int receivedState = RADIOLIB_ERR_NONE;
-static volatile bool receivedFlag = false;
+static lora_packet_t lora_rx_ring[LORA_RX_POOL_SIZE];
+static std::atomic<uint16_t> lora_rx_head(0);   // next slot the RX task fills
+static std::atomic<uint16_t> lora_rx_tail(0);   // oldest slot the consumer holds
+static uint32_t lora_rx_dropped_count = 0;
+static uint32_t lora_rx_error_count = 0;
+static uint32_t lora_rx_packet_count = 0;
+static uint32_t lora_rx_unpack_failed = 0;
+static uint8_t lora_rx_unpack_buf[LORA_PACKET_MAX];
+
+// payloads from other carriers, handed to lora_task, the ring's only producer;
+// replayed ones stand in for the air and take its path
+typedef struct {
+    uint8_t data[LORA_PACKET_MAX];
+    uint8_t len;
+    bool replay;
+    float rssi;
+    float snr;
+} lora_inject_t;
+
+// one payload sent over two carriers is delivered once
+typedef struct {
+    uint32_t crc;
+    uint32_t time_ms;
+    bool injected;
+} lora_rx_recent_t;
+
+static QueueHandle_t lora_inject_queue = NULL;
+static lora_rx_recent_t lora_rx_recent[LORA_RX_DEDUP];
+static uint8_t lora_rx_recent_next = 0;
+static uint32_t lora_rx_dup_count = 0;
+static lora_rx_hook_t lora_rx_hooks[LORA_RX_HOOKS];
+static uint8_t lora_rx_hook_count = 0;
 
-static void set_receive_flag(void){
-    receivedFlag = true;
+static_assert((LORA_RX_POOL_SIZE & (LORA_RX_POOL_SIZE - 1)) == 0, "LORA_RX_POOL_SIZE must be a power of two");
+
+// radio profiles
+static const lora_profile_t lora_presets[] = {
+    // name         freq       bw     sf  cr  sync  dBm  preamble crc
+    { "default",    LORA_FREQ, 125.0, 10, 6,  0xAB, 22,  15,      false },
+    { "long_range", LORA_FREQ, 125.0, 12, 8,  0xAB, 22,  16,      true  },
+    { "fast",       LORA_FREQ, 500.0, 7,  5,  0xAB, 22,  8,       true  },
+    // Meshtastic LongFast modulation; its channel frequency depends on the
+    // region, so set lora.frequency to match the mesh
+    { "meshtastic", LORA_FREQ, 250.0, 11, 5,  0x2B, 22,  16,      true  },
+};
+
+static lora_profile_t lora_active;      // what the radio is programmed with
+static bool lora_active_valid = false;
+static lora_profile_t lora_pending;     // switch requested while a packet was on air
+static bool lora_pending_valid = false;
+
+// GFSK presets; the receive bandwidth covers 2 * deviation + bitrate
+static const lora_fsk_t lora_fsk_presets[] = {
+    // name     kbps   dev kHz  rx bw kHz  preamble bits
+    { "fsk50",  50.0,  25.0,    117.3,     32 },
+    { "fsk100", 100.0, 50.0,    234.3,     32 },
+    { "fsk300", 300.0, 75.0,    467.0,     32 },
+};
+static const uint8_t lora_fsk_sync[] = { 0xC1, 0x94, 0xC1, 0x3D };
+
+static const lora_fsk_t *lora_fsk_on = NULL;    // what the radio runs instead of lora_active
+static uint32_t lora_fsk_idle_ms = 0;
+static uint32_t lora_fsk_last_ms = 0;           // last frame in or out
+static const lora_fsk_t *lora_modem_next = NULL;
+static bool lora_modem_switch = false;          // lora_modem_next waits for the TX queue to drain
+
+// duty-cycled receive: the radio sleeps between short preamble checks, so
+// transmissions carry a preamble long enough to span the sleep window
+static bool lora_rx_dc_enabled = false;
+
+static uint16_t lora_preamble_of(const lora_profile_t *p)
+{
+    if(lora_rx_dc_enabled && p->preamble < LORA_RX_DC_PREAMBLE) return LORA_RX_DC_PREAMBLE;
+    return p->preamble;
 }
 
-bool lora_init(void)
+// Every receive start goes through here
+static int lora_start_rx(void)
 {
-    Serial.print(F("[SX1262] Initializing ... "));
-    int state = radio.begin(LORA_FREQ);
+    if(lora_rx_dc_enabled && lora_active_valid && lora_fsk_on == NULL){
+        return radio.startReceiveDutyCycleAuto(lora_preamble_of(&lora_active), LORA_RX_DC_MIN_SYMBOLS);
+    }
+    return radio.startReceive();
+}
+
+// adaptive data rate: SF and bandwidth follow the averaged packet SNR
+#define LORA_ADR_HYST_DB 2.0            // the current setting keeps this much extra slack
+static bool lora_adr_enabled = false;
+static float lora_adr_snr = 0;
+static uint8_t lora_adr_count = 0;
+static const float lora_adr_bw[] = { 125.0, 250.0, 500.0 };
+static const float lora_sf_floor_db[] = { -7.5, -10.0, -12.5, -15.0, -17.5, -20.0 }; // SX1262 demodulation floor, SF7..SF12
+
+// Only the fields that differ from 'from' (all of them when it is NULL) are
+// written; stops at the first error
+static int lora_program(const lora_profile_t *to, const lora_profile_t *from)
+{
+    int state = RADIOLIB_ERR_NONE;
+
+#define LORA_PROGRAM(field, call) \
+    if(state == RADIOLIB_ERR_NONE && (from == NULL || from->field != to->field)) state = call
+
+    LORA_PROGRAM(freq, radio.setFrequency(to->freq));
+    LORA_PROGRAM(bw, radio.setBandwidth(to->bw));
+    LORA_PROGRAM(sf, radio.setSpreadingFactor(to->sf));
+    LORA_PROGRAM(cr, radio.setCodingRate(to->cr));
+    LORA_PROGRAM(sync_word, radio.setSyncWord(to->sync_word));
+    LORA_PROGRAM(power, radio.setOutputPower(to->power));
+    LORA_PROGRAM(preamble, radio.setPreambleLength(lora_preamble_of(to)));
+    LORA_PROGRAM(crc, radio.setCRC(to->crc));
+
+#undef LORA_PROGRAM
+    return state;
+}
+
+// Called with lora_mutex held and no packet on air. A profile the radio
+// rejects is rolled back, so the radio always runs a complete profile
+static bool lora_apply_locked(const lora_profile_t *p)
+{
+    // Under GFSK the profile is only stored; leaving GFSK programs it
+    if(lora_fsk_on){
+        lora_active = *p;
+        lora_active_valid = true;
+        return true;
+    }
+
+    int state = lora_program(p, lora_active_valid ? &lora_active : NULL);
+    if(state != RADIOLIB_ERR_NONE){
+        LOG_WARNF("LoRa", "Radio profile %s rejected, code %d", p->name, state);
+        if(lora_active_valid){
+            lora_program(&lora_active, p);
+        }
+    } else {
+        lora_active = *p;
+        lora_active_valid = true;
+    }
+
+    if(lora_mode == LORA_MODE_RECV){
+        receivedState = lora_start_rx();
+    }
+    return state == RADIOLIB_ERR_NONE;
+}
+
+#ifdef INTEGRATION_LAYER_ENABLED
+// Stored per-field overrides (lora.frequency, ...) sit on top of the preset
+static void lora_profile_overlay(lora_profile_t *p)
+{
+    p->freq = GET_CONFIG_FLOAT("lora", "frequency", p->freq);
+    p->bw = GET_CONFIG_FLOAT("lora", "bandwidth", p->bw);
+    p->sf = GET_CONFIG_INT("lora", "spreading_factor", p->sf);
+    p->cr = GET_CONFIG_INT("lora", "coding_rate", p->cr);
+    p->power = GET_CONFIG_INT("lora", "output_power", p->power);
+}
+
+#endif
+
+const lora_profile_t *lora_find_profile(const char *name)
+{
+    for(size_t i = 0; i < sizeof(lora_presets) / sizeof(lora_presets[0]); i++){
+        if(strcmp(lora_presets[i].name, name) == 0) return &lora_presets[i];
+    }
+    return NULL;
+}
+
+const lora_profile_t *lora_get_presets(size_t *count)
+{
+    *count = sizeof(lora_presets) / sizeof(lora_presets[0]);
+    return lora_presets;
+}
+
+// SX1262 datasheet 6.1.4, explicit header; RadioLib turns on low data rate
+// optimisation for symbols of 16 ms and longer
+uint32_t lora_profile_time_on_air_us(const lora_profile_t *p, size_t len)
+{
+    float symbol_us = (float)(1 << p->sf) * 1000.0f / p->bw;
+    int ldro = symbol_us >= 16000.0f;
+    int num = 8 * (int)len - 4 * p->sf + 28 + (p->crc ? 16 : 0);
+    int den = 4 * (p->sf - 2 * ldro);
+    int symbols = 8 + (num > 0 ? (num + den - 1) / den * p->cr : 0);
+    return (uint32_t)((p->preamble + 4.25f + symbols) * symbol_us);
+}
+
+const lora_profile_t *lora_get_profile(void)
+{
+    return lora_active_valid ? &lora_active : lora_find_profile(LORA_PROFILE_DEFAULT);
+}
+
+bool lora_apply_profile(const lora_profile_t *profile)
+{
+    if(lora_mutex == NULL) return false;
+
+    LORA_LOCK();
+    bool ok = true;
+    if(lora_tx_active >= 0){
+        // Never retune under a packet; TX done applies the latest request
+        lora_pending = *profile;
+        lora_pending_valid = true;
+    } else {
+        lora_pending_valid = false;
+        ok = lora_apply_locked(profile);
+    }
+    LORA_UNLOCK();
+
+    lora_adr_count = 0;
+    return ok;
+}
+
+bool lora_set_profile(const char *name)
+{
+    const lora_profile_t *preset = lora_find_profile(name);
+    if(preset == NULL) return false;
+
+    lora_profile_t profile = *preset;
+#ifdef INTEGRATION_LAYER_ENABLED
+    lora_profile_overlay(&profile);
+#endif
+    if(!lora_apply_profile(&profile)) return false;
+
+#ifdef INTEGRATION_LAYER_ENABLED
+    // The watcher sees the same profile again and finds nothing to change
+    SET_CONFIG_STRING("lora", "profile", name);
+#endif
+    return true;
+}
+
+void lora_set_lbt(bool enable)
+{
+    lora_lbt_enabled = enable;
+}
+
+bool lora_get_lbt(void)
+{
+    return lora_lbt_enabled;
+}
+
+uint32_t lora_lbt_busy(void)
+{
+    return lora_lbt_busy_count;
+}
+
+bool lora_set_rx_duty_cycle(bool enable)
+{
+    if(lora_mutex == NULL) return false;
+
+    // The preamble changes with the mode, so wait for the radio to be free
+    LORA_LOCK();
+    while(lora_tx_active >= 0){
+        LORA_UNLOCK();
+        vTaskDelay(pdMS_TO_TICKS(10));
+        LORA_LOCK();
+    }
+
+    lora_rx_dc_enabled = enable;
+    int state = RADIOLIB_ERR_NONE;
+    if(lora_active_valid && lora_fsk_on == NULL){
+        state = radio.setPreambleLength(lora_preamble_of(&lora_active));
+    }
+    if(lora_mode == LORA_MODE_RECV){
+        receivedState = lora_start_rx();
+    }
+    LORA_UNLOCK();
+    return state == RADIOLIB_ERR_NONE;
+}
+
+bool lora_get_rx_duty_cycle(void)
+{
+    return lora_rx_dc_enabled;
+}
+
+void lora_set_adr(bool enable)
+{
+    lora_adr_enabled = enable;
+    lora_adr_count = 0;
+}
+
+bool lora_get_adr(void)
+{
+    return lora_adr_enabled;
+}
+
+// Board properties, independent of the modem and the radio profile
+static int lora_board_setup(void)
+{
+    // set over current protection limit to 140 mA (accepted range is 45 - 240 mA)
+    int state = radio.setCurrentLimit(140);
+
+    // The module has a TCXO on DIO3 and uses DIO2 as RF switch, so DIO2
+    // can't be used as interrupt pin
     if (state == RADIOLIB_ERR_NONE) {
-        Serial.println(F("success!"));
+        state = radio.setTCXO(2.4);
+    }
+    if (state == RADIOLIB_ERR_NONE) {
+        state = radio.setDio2AsRfSwitch();
+    }
+    return state;
+}
+
+static int lora_fsk_program(const lora_fsk_t *f)
+{
+    const lora_profile_t *p = lora_get_profile();
+    int state = radio.beginFSK(p->freq, f->bitrate, f->freq_dev, f->rx_bw, p->power, f->preamble, 2.4);
+
+    if(state == RADIOLIB_ERR_NONE) state = lora_board_setup();
+    if(state == RADIOLIB_ERR_NONE) state = radio.setDataShaping(RADIOLIB_SHAPING_0_5);
+    if(state == RADIOLIB_ERR_NONE) state = radio.setWhitening(true, 0x01FF);
+    if(state == RADIOLIB_ERR_NONE) state = radio.setCRC(2, 0x1D0F, 0x1021, true);
+    if(state == RADIOLIB_ERR_NONE) state = radio.setSyncWord((uint8_t *)lora_fsk_sync, sizeof(lora_fsk_sync));
+    return state;
+}
+
+// Called with lora_mutex held and no packet on air. f NULL goes back to
+// LoRa, as does a GFSK setup the radio rejects
+static void lora_modem_apply_locked(const lora_fsk_t *f)
+{
+    if(f == lora_fsk_on) return;
+
+    lora_profile_t profile = *lora_get_profile();
+    if(f != NULL){
+        int state = lora_fsk_program(f);
+        if(state == RADIOLIB_ERR_NONE){
+            lora_fsk_on = f;
+            lora_fsk_last_ms = millis();
+            LOG_INFOF("LoRa", "GFSK %s, %.0f kbps", f->name, f->bitrate);
+            if(lora_mode == LORA_MODE_RECV){
+                receivedState = lora_start_rx();
+            }
+            return;
+        }
+        LOG_WARNF("LoRa", "GFSK %s rejected, code %d", f->name, state);
+    }
+
+    // begin() puts the modem back to LoRa; the whole profile is programmed again
+    lora_fsk_on = NULL;
+    int state = radio.begin(LORA_FREQ);
+    if(state == RADIOLIB_ERR_NONE) state = lora_board_setup();
+    if(state != RADIOLIB_ERR_NONE){
+        LOG_ERRORF("LoRa", "Return to LoRa failed, code %d", state);
+    }
+    lora_active_valid = false;
+    lora_apply_locked(&profile);
+    lora_adr_count = 0;
+    if(f == NULL){
+        LOG_INFOF("LoRa", "Back on LoRa, profile %s", profile.name);
+    }
+}
+
+const lora_fsk_t *lora_find_fsk(const char *name)
+{
+    for(size_t i = 0; i < sizeof(lora_fsk_presets) / sizeof(lora_fsk_presets[0]); i++){
+        if(strcmp(lora_fsk_presets[i].name, name) == 0) return &lora_fsk_presets[i];
+    }
+    return NULL;
+}
+
+const lora_fsk_t *lora_get_fsk_presets(size_t *count)
+{
+    *count = sizeof(lora_fsk_presets) / sizeof(lora_fsk_presets[0]);
+    return lora_fsk_presets;
+}
+
+// Preamble, sync word, length byte, payload and CRC-16, all at the bit rate
+uint32_t lora_fsk_time_on_air_us(const lora_fsk_t *f, size_t len)
+{
+    uint32_t bits = f->preamble + 8 * sizeof(lora_fsk_sync) + 8 + 8 * (uint32_t)len + 16;
+    return (uint32_t)(bits * 1000.0f / f->bitrate);
+}
+
+uint32_t lora_time_on_air_us(size_t len)
+{
+    const lora_fsk_t *f = lora_fsk_on;
+    return f ? lora_fsk_time_on_air_us(f, len) : lora_profile_time_on_air_us(lora_get_profile(), len);
+}
+
+static void lora_modem_request(const lora_fsk_t *f, uint32_t idle_ms)
+{
+    LORA_LOCK();
+    lora_modem_next = f;
+    lora_modem_switch = true;
+    if(f) lora_fsk_idle_ms = idle_ms;
+    LORA_UNLOCK();
+    if(lora_task_handle){
+        xTaskNotify(lora_task_handle, LORA_EVT_TX_KICK, eSetBits);
+    }
+}
+
+bool lora_fsk_start(const lora_fsk_t *fsk, uint32_t idle_ms)
+{
+    if(lora_mutex == NULL || fsk == NULL) return false;
+    lora_modem_request(fsk, idle_ms);
+    return true;
+}
+
+void lora_fsk_stop(void)
+{
+    if(lora_mutex == NULL) return;
+    lora_modem_request(NULL, 0);
+}
+
+const lora_fsk_t *lora_fsk_running(void)
+{
+    return lora_fsk_on;
+}
+
+// Fastest SF/bandwidth pair whose SNR clears the demodulation floor by
+// LORA_ADR_MARGIN_DB. SNR is measured in-band, so it drops 3 dB for each
+// doubling of the bandwidth. Both ends have to follow the same rule (or be
+// switched together), there is no in-band negotiation.
+static void lora_adr_update(float snr)
+{
+    if(!lora_adr_enabled || !lora_active_valid || lora_fsk_on) return;
+
+    lora_adr_snr = lora_adr_count == 0 ? snr : lora_adr_snr * 0.75f + snr * 0.25f;
+    if(++lora_adr_count < LORA_ADR_SAMPLES) return;
+    lora_adr_count = 0;
+
+    lora_profile_t next = lora_active;
+    float best_rate = 0;
+    for(uint8_t sf = 7; sf <= 12; sf++){
+        for(size_t b = 0; b < sizeof(lora_adr_bw) / sizeof(lora_adr_bw[0]); b++){
+            float bw = lora_adr_bw[b];
+            float margin = lora_adr_snr - 10.0f * log10f(bw / lora_active.bw) - lora_sf_floor_db[sf - 7];
+            bool current = sf == lora_active.sf && bw == lora_active.bw;
+            if(margin < LORA_ADR_MARGIN_DB - (current ? LORA_ADR_HYST_DB : 0)) continue;
+
+            float rate = sf * bw / (1 << sf);
+            if(rate > best_rate){
+                best_rate = rate;
+                next.sf = sf;
+                next.bw = bw;
+            }
+        }
+    }
+
+    // Nothing clears the margin: fall back to the most robust setting
+    if(best_rate == 0){
+        next.sf = 12;
+        next.bw = 125.0;
+    }
+    if(next.sf == lora_active.sf && next.bw == lora_active.bw) return;
+
+    LOG_INFOF("LoRa", "ADR: SNR %.1f dB, SF%u/%.0f kHz -> SF%u/%.0f kHz",
+              lora_adr_snr, lora_active.sf, lora_active.bw, next.sf, next.bw);
+    lora_apply_profile(&next);
+}
+
+// The same payload over the other carrier within LORA_RX_DEDUP_MS is the
+// copy; a repeat over the same carrier is a new message
+static bool lora_rx_duplicate(const lora_packet_t *pkt, bool injected)
+{
+    uint32_t crc = esp_rom_crc32_le(0, pkt->data, pkt->len);
+    for(uint8_t i = 0; i < LORA_RX_DEDUP; i++){
+        lora_rx_recent_t *r = &lora_rx_recent[i];
+        if(r->time_ms && r->crc == crc && pkt->time_ms - r->time_ms < LORA_RX_DEDUP_MS){
+            if(r->injected != injected) return true;
+            r->time_ms = pkt->time_ms;
+            return false;
+        }
+    }
+    lora_rx_recent_t *r = &lora_rx_recent[lora_rx_recent_next];
+    lora_rx_recent_next = (lora_rx_recent_next + 1) % LORA_RX_DEDUP;
+    r->crc = crc;
+    r->time_ms = pkt->time_ms | 1;
+    r->injected = injected;
+    return false;
+}
+
+// Hooks, then the ring, for the packet in the head slot
+static void lora_rx_deliver(lora_packet_t *pkt, bool injected)
+{
+    uint16_t next = (lora_rx_head.load(std::memory_order_relaxed) + 1) & (LORA_RX_POOL_SIZE - 1);
+
+    if(lora_inject_queue && lora_rx_duplicate(pkt, injected)){
+        lora_rx_dup_count++;
+        return;
+    }
+
+    // A link layer's own frames stop here, first claim wins
+    for(uint8_t i = 0; i < lora_rx_hook_count; i++){
+        if(lora_rx_hooks[i](pkt)) return;
+    }
+
+    if(next == lora_rx_tail.load(std::memory_order_acquire)){
+        lora_rx_dropped_count++;
+        return;
+    }
+    lora_rx_head.store(next, std::memory_order_release);
+
+#ifdef INTEGRATION_LAYER_ENABLED
+    if(GlobalEventBridge){
+        GlobalEventBridge->tryPublish(EventType::LORA_MESSAGE_RECEIVED, "LoRa", EventPriority::EVENT_HIGH);
+    }
+#endif
+}
+
+static void lora_rx_read(void)
+{
+    lora_packet_t *pkt = &lora_rx_ring[lora_rx_head.load(std::memory_order_relaxed)];
+
+    // The head slot is not visible to the consumer, so it is safe to read
+    // into even when the ring is full and the packet ends up dropped
+    LORA_LOCK();
+    size_t len = radio.getPacketLength();
+    if(len > LORA_PACKET_MAX) len = LORA_PACKET_MAX;
+    receivedState = radio.readData(pkt->data, len);
+    // RSSI and SNR from one GetPacketStatus, getRSSI() and getSNR() each issue their own
+    uint8_t status[3] = {0, 0, 0};
+    lora_module->SPIreadStream(RADIOLIB_SX126X_CMD_GET_PACKET_STATUS, status, 3);
+    if(lora_fsk_on){
+        // GFSK status is RxStatus, RssiSync, RssiAvg; there is no SNR
+        pkt->rssi = -status[1] / 2.0f;
+        pkt->snr = 0;
     } else {
-        Serial.print(F("failed, code "));
-        Serial.println(state);
-        return false;
+        pkt->rssi = -status[0] / 2.0f;
+        pkt->snr = (int8_t)status[1] / 4.0f;
+    }
+    lora_fsk_last_ms = millis();
+    // A duty-cycled receiver drops to standby after each packet
+    if(lora_rx_dc_enabled && lora_mode == LORA_MODE_RECV && lora_tx_active < 0){
+        lora_start_rx();
     }
+    LORA_UNLOCK();
 
-    radio.setPacketSentAction(set_transmit_flag);
+    // As it was on air, before it is opened; a CRC failure still has its bytes
+    if(lora_capture_running() && (receivedState == RADIOLIB_ERR_NONE || receivedState == RADIOLIB_ERR_CRC_MISMATCH)){
+        lora_capture_frame(true, pkt->data, len, pkt->rssi, pkt->snr, receivedState == RADIOLIB_ERR_NONE);
+    }
 
-    // set carrier frequency to 433.5 MHz
-    if (radio.setFrequency(LORA_FREQ) == RADIOLIB_ERR_INVALID_FREQUENCY) {
-        Serial.println(F("Selected frequency is invalid for this module!"));
-        while (true);
+    if(receivedState != RADIOLIB_ERR_NONE){
+        lora_rx_error_count++;
+        LOG_WARNF("LoRa", "Receive failed, code %d", receivedState);
+        return;
     }
 
-    // set bandwidth to 250 kHz
-    if (radio.setBandwidth(125.0) == RADIOLIB_ERR_INVALID_BANDWIDTH) {
-        Serial.println(F("Selected bandwidth is invalid for this module!"));
-        while (true);
+    lora_rx_packet_count++;
+    // Opened in the ring slot; forged, replayed and unreadable frames stop here
+    int open_len = lora_crypt_open(pkt->data, len);
+    if(open_len < 0) return;
+    len = open_len;
+    if(lora_codec_is_packed(pkt->data, len)){
+        int plain_len = lora_codec_decode(pkt->data, len, lora_rx_unpack_buf, LORA_PACKET_MAX);
+        if(plain_len < 0){
+            lora_rx_unpack_failed++;
+            return;
+        }
+        memcpy(pkt->data, lora_rx_unpack_buf, plain_len);
+        len = plain_len;
     }
 
-    // set spreading factor to 10
-    if (radio.setSpreadingFactor(10) == RADIOLIB_ERR_INVALID_SPREADING_FACTOR) {
-        Serial.println(F("Selected spreading factor is invalid for this module!"));
-        while (true);
+    pkt->data[len] = '\0';
+    pkt->len = len;
+    pkt->time_ms = millis();
+    if(event_replay_recording()){
+        EventReplayLora rec = {(int16_t)lroundf(pkt->rssi * 2), (int8_t)lroundf(pkt->snr * 4), 0};
+        event_replay_record(REPLAY_SRC_LORA, &rec, sizeof(rec), pkt->data, len);
     }
+    lora_stats_rx(pkt);
+    lora_adr_update(pkt->snr);
+    lora_rx_deliver(pkt, false);
+}
+
+static void lora_rx_drain_injected(void)
+{
+    lora_inject_t item;
+    while(xQueueReceive(lora_inject_queue, &item, 0) == pdTRUE){
+        lora_packet_t *pkt = &lora_rx_ring[lora_rx_head.load(std::memory_order_relaxed)];
+        memcpy(pkt->data, item.data, item.len);
+        pkt->data[item.len] = '\0';
+        pkt->len = item.len;
+        pkt->rssi = item.rssi;
+        pkt->snr = item.snr;
+        pkt->time_ms = millis();
+        // not ADR: a replay must not retune the radio it runs on
+        if(item.replay) lora_stats_rx(pkt);
+        lora_rx_deliver(pkt, !item.replay);
+    }
+}
+
+static void lora_airtime_refill(uint32_t now)
+{
+    uint32_t elapsed = now - lora_airtime_stamp;
+    lora_airtime_stamp = now;
+
+    // elapsed ms times permille is the credit in us
+    if(elapsed >= LORA_DUTY_WINDOW_MS || lora_airtime_credit_us + elapsed * LORA_DUTY_PERMILLE >= LORA_DUTY_BUDGET_US){
+        lora_airtime_credit_us = LORA_DUTY_BUDGET_US;
+    } else {
+        lora_airtime_credit_us += elapsed * LORA_DUTY_PERMILLE;
+    }
+}
 
-    // set coding rate to 6
-    if (radio.setCodingRate(6) == RADIOLIB_ERR_INVALID_CODING_RATE) {
-        Serial.println(F("Selected coding rate is invalid for this module!"));
-        while (true);
+// Called with lora_mutex held; a failed attempt backs off or gives up
+static void lora_tx_retry(int i, uint32_t now)
+{
+    lora_tx_slot_t *slot = &lora_tx_pool[i];
+    if(slot->retries == 0){
+        slot->used = false;
+        lora_tx_failed_count++;
+        LOG_WARNF("LoRa", "Transmission failed, code %d, giving up", transmissionState);
+        return;
+    }
+    slot->retries--;
+    lora_tx_retry_count++;
+    slot->attempt++;
+    slot->not_before = now + (LORA_TX_RETRY_MS << (slot->attempt < 5 ? slot->attempt - 1 : 4));
+    LOG_DEBUGF("LoRa", "Transmission failed, code %d, retry %u", transmissionState, slot->attempt);
+}
+
+// Best ready slot: lowest priority value, then oldest. wait_ms gets the
+// time until the earliest backed-off slot becomes ready
+static int lora_tx_pick(uint32_t now, uint32_t *wait_ms)
+{
+    int best = -1;
+    for(int i = 0; i < LORA_TX_POOL_SIZE; i++){
+        lora_tx_slot_t *slot = &lora_tx_pool[i];
+        if(!slot->used) continue;
+
+        if((int32_t)(slot->not_before - now) > 0){
+            uint32_t left = slot->not_before - now;
+            if(left < *wait_ms) *wait_ms = left;
+            continue;
+        }
+        if(best < 0 || slot->priority < lora_tx_pool[best].priority ||
+           (slot->priority == lora_tx_pool[best].priority && (int32_t)(slot->seq - lora_tx_pool[best].seq) < 0)){
+            best = i;
+        }
+    }
+    return best;
+}
+
+// The radio is free again: apply a profile switch that waited for it, or
+// go back to listening. Called with lora_mutex held
+static void lora_radio_idle(void)
+{
+    if(lora_pending_valid){
+        lora_pending_valid = false;
+        lora_apply_locked(&lora_pending);
+    } else if(lora_mode == LORA_MODE_RECV){
+        receivedState = lora_start_rx();
     }
+}
+
+// TX done (or its watchdog), called with lora_mutex held
+static void lora_tx_done(bool ok, uint32_t now)
+{
+    int i = lora_tx_active;
+    lora_tx_active = -1;
+    radio.finishTransmit();
+    energy_mark(ENERGY_LORA_TX, false);
 
-    // set LoRa sync word to 0xAB
-    if (radio.setSyncWord(0xAB) != RADIOLIB_ERR_NONE) {
-        Serial.println(F("Unable to set sync word!"));
-        while (true);
+    if(ok){
+        lora_tx_pool[i].used = false;
+        lora_tx_sent_count++;
+        lora_fsk_last_ms = now;
+    } else {
+        transmissionState = RADIOLIB_ERR_TX_TIMEOUT;
+        lora_tx_retry(i, now);
     }
+    lora_radio_idle();
+}
+
+// Called with lora_mutex held and the radio free; starts slot i on air
+static void lora_tx_start(int i, uint32_t now)
+{
+    lora_tx_slot_t *slot = &lora_tx_pool[i];
+    uint32_t toa = radio.getTimeOnAir(slot->len);
 
-    // set output power to 10 dBm (accepted range is -17 - 22 dBm)
-    if (radio.setOutputPower(22) == RADIOLIB_ERR_INVALID_OUTPUT_POWER) {
-        Serial.println(F("Selected output power is invalid for this module!"));
-        while (true);
+    transmissionState = radio.startTransmit(slot->data, slot->len);
+    if(transmissionState == RADIOLIB_ERR_NONE){
+        lora_airtime_credit_us -= toa < lora_airtime_credit_us ? toa : lora_airtime_credit_us;
+        lora_airtime_total_us += toa;
+        lora_tx_active = i;
+        lora_tx_deadline = now + toa / 1000 * 2 + 100;
+        energy_mark(ENERGY_LORA_TX, true);
+        if(lora_capture_running()) lora_capture_frame(false, slot->data, slot->len, 0, 0, true);
+    } else {
+        lora_tx_retry(i, now);
     }
+}
 
-    // set over current protection limit to 80 mA (accepted range is 45 - 240 mA)
-    // NOTE: set value to 0 to disable overcurrent protection
-    if (radio.setCurrentLimit(140) == RADIOLIB_ERR_INVALID_CURRENT_LIMIT) {
-        Serial.println(F("Selected current limit is invalid for this module!"));
-        while (true);
+// Channel scan done (scanned) or its watchdog, called with lora_mutex held.
+// A busy channel backs the packet off for a random, growing time; after
+// LORA_LBT_MAX_TRIES busy scans it goes out regardless
+static void lora_cad_done(bool scanned, uint32_t now)
+{
+    int i = lora_tx_active;
+    lora_tx_slot_t *slot = &lora_tx_pool[i];
+    bool busy = scanned && radio.getChannelScanResult() == RADIOLIB_LORA_DETECTED;
+
+    lora_tx_active = -1;
+    lora_tx_cad = false;
+    if(!busy){
+        lora_tx_start(i, now);
+        if(lora_tx_active < 0) lora_radio_idle();
+        return;
     }
 
-    // set LoRa preamble length to 15 symbols (accepted range is 0 - 65535)
-    if (radio.setPreambleLength(15) == RADIOLIB_ERR_INVALID_PREAMBLE_LENGTH) {
-        Serial.println(F("Selected preamble length is invalid for this module!"));
-        while (true);
+    lora_lbt_busy_count++;
+    slot->cad_busy++;
+    uint32_t window = LORA_LBT_BACKOFF_MS << (slot->cad_busy < 4 ? slot->cad_busy : 4);
+    slot->not_before = now + LORA_LBT_BACKOFF_MS + esp_random() % window;
+    lora_radio_idle();
+}
+
+// Starts the next packet if the radio is free; returns how long lora_task
+// may sleep before something here needs another look
+static TickType_t lora_tx_service(void)
+{
+    uint32_t now = millis();
+    uint32_t wait_ms = UINT32_MAX;
+
+    LORA_LOCK();
+    if(lora_tx_active >= 0 && (int32_t)(now - lora_tx_deadline) >= 0){
+        if(lora_tx_cad){
+            lora_cad_done(false, now);
+        } else {
+            lora_tx_done(false, now);
+        }
     }
 
-    // disable CRC
-    if (radio.setCRC(false) == RADIOLIB_ERR_INVALID_CRC_CONFIGURATION) {
-        Serial.println(F("Selected CRC is invalid for this module!"));
-        while (true);
+    while(lora_tx_active < 0){
+        int i = lora_tx_pick(now, &wait_ms);
+        if(i < 0) break;
+
+        lora_tx_slot_t *slot = &lora_tx_pool[i];
+        uint32_t toa = radio.getTimeOnAir(slot->len);
+        lora_airtime_refill(now);
+
+        if(toa > LORA_DUTY_BUDGET_US){
+            slot->used = false;
+            lora_tx_dropped_count++;
+            LOG_WARNF("LoRa", "Packet of %u bytes exceeds the duty-cycle budget", slot->len);
+            continue;
+        }
+        if(toa > lora_airtime_credit_us){
+            // Keep priority order: nothing else goes before this one
+            uint32_t left = (toa - lora_airtime_credit_us + LORA_DUTY_PERMILLE - 1) / LORA_DUTY_PERMILLE;
+            if(left < wait_ms) wait_ms = left;
+            break;
+        }
+
+        // Listen first; DIO1 reports the scan result
+        if(lora_lbt_enabled && lora_fsk_on == NULL && slot->cad_busy < LORA_LBT_MAX_TRIES && radio.startChannelScan() == RADIOLIB_ERR_NONE){
+            const lora_profile_t *p = &lora_active;
+            lora_tx_active = i;
+            lora_tx_cad = true;
+            lora_tx_deadline = now + (uint32_t)(8.0f * (1 << p->sf) / p->bw) + 20;
+            break;
+        }
+        lora_tx_start(i, now);
     }
 
-    // Some SX126x modules have TCXO (temperature compensated crystal
-    // oscillator). To configure TCXO reference voltage,
-    // the following method can be used.
-    if (radio.setTCXO(2.4) == RADIOLIB_ERR_INVALID_TCXO_VOLTAGE) {
-        Serial.println(F("Selected TCXO voltage is invalid for this module!"));
-        while (true);
+    if(lora_tx_active >= 0){
+        uint32_t left = (int32_t)(lora_tx_deadline - now) > 0 ? lora_tx_deadline - now : 0;
+        if(left < wait_ms) wait_ms = left;
     }
+    LORA_UNLOCK();
 
-    // Some SX126x modules use DIO2 as RF switch. To enable
-    // this feature, the following method can be used.
-    // NOTE: As long as DIO2 is configured to control RF switch,
-    //       it can't be used as interrupt pin!
-    if (radio.setDio2AsRfSwitch() != RADIOLIB_ERR_NONE) {
-        Serial.println(F("Failed to set DIO2 as RF switch!"));
-        while (true);
+    return wait_ms == UINT32_MAX ? portMAX_DELAY : pdMS_TO_TICKS(wait_ms);
+}
+
+// A requested modem switch, once the TX queue has drained; and the way
+// back to LoRa after GFSK went idle. Returns how long lora_task may sleep
+static TickType_t lora_modem_service(TickType_t wait)
+{
+    if(!lora_modem_switch && lora_fsk_on == NULL) return wait;
+
+    uint32_t now = millis();
+    uint32_t left = UINT32_MAX;
+    LORA_LOCK();
+    if(!lora_modem_switch && lora_fsk_idle_ms){
+        uint32_t idle = now - lora_fsk_last_ms;
+        if(idle >= lora_fsk_idle_ms){
+            LOG_INFOF("LoRa", "GFSK idle for %lu ms", (unsigned long)idle);
+            lora_modem_next = NULL;
+            lora_modem_switch = true;
+        } else {
+            left = lora_fsk_idle_ms - idle;
+        }
+    }
+    if(lora_modem_switch && lora_tx_active < 0 && lora_tx_pending() == 0){
+        lora_modem_switch = false;
+        lora_modem_apply_locked(lora_modem_next);
+    }
+    LORA_UNLOCK();
+
+    // A switch held up by the queue is looked at again when TX completes
+    if(left != UINT32_MAX && pdMS_TO_TICKS(left) < wait) wait = pdMS_TO_TICKS(left);
+    return wait;
+}
+
+static void lora_task(void *param)
+{
+    TickType_t wait = portMAX_DELAY;
+
+    while(1)
+    {
+        uint32_t bits = 0;
+        xTaskNotifyWait(0, UINT32_MAX, &bits, wait);
+
+        if(bits & LORA_EVT_DIO1){
+            if(lora_tx_active >= 0){
+                LORA_LOCK();
+                if(lora_tx_cad){
+                    lora_cad_done(true, millis());
+                } else {
+                    lora_tx_done(true, millis());
+                }
+                LORA_UNLOCK();
+            } else if(lora_mode == LORA_MODE_RECV){
+                lora_rx_read();
+            }
+        }
+        if(bits & LORA_EVT_INJECT){
+            lora_rx_drain_injected();
+        }
+
+        // The next queued packet starts straight from the TX-done wakeup
+        wait = lora_modem_service(lora_tx_service());
+    }
+}
+
+#ifdef INTEGRATION_LAYER_ENABLED
+// A batch of "lora" config changes becomes one profile switch
+static void lora_config_changed(const ConfigChange *changes, size_t count, void *context)
+{
+    lora_profile_t next = *lora_get_profile();
+    bool touched = false;
+
+    for(size_t i = 0; i < count; i++){
+        const char *key = changes[i].key;
+        const ConfigValue &value = changes[i].value;
+
+        if(strcmp(key, "profile") == 0){
+            const lora_profile_t *preset = lora_find_profile(value.asString().c_str());
+            if(preset == NULL){
+                LOG_WARNF("LoRa", "Unknown radio profile %s", value.asString().c_str());
+                continue;
+            }
+            next = *preset;
+            lora_profile_overlay(&next);
+        } else if(strcmp(key, "frequency") == 0){
+            next.freq = value.asFloat();
+        } else if(strcmp(key, "bandwidth") == 0){
+            next.bw = value.asFloat();
+        } else if(strcmp(key, "spreading_factor") == 0){
+            next.sf = value.asInteger();
+        } else if(strcmp(key, "coding_rate") == 0){
+            next.cr = value.asInteger();
+        } else if(strcmp(key, "output_power") == 0){
+            next.power = value.asInteger();
+        } else if(strcmp(key, "adr") == 0){
+            lora_set_adr(value.asBoolean());
+            continue;
+        } else if(strcmp(key, "lbt") == 0){
+            lora_set_lbt(value.asBoolean());
+            continue;
+        } else if(strcmp(key, "rx_duty_cycle") == 0){
+            lora_set_rx_duty_cycle(value.asBoolean());
+            continue;
+        } else if(strcmp(key, "compress") == 0){
+            lora_compress = value.asBoolean();
+            continue;
+        } else {
+            continue;
+        }
+        touched = true;
+    }
+
+    if(touched){
+        lora_apply_profile(&next);
+    }
+}
+#endif
+
+static uint32_t lora_rx_work(void)
+{
+    return lora_rx_pending();
+}
+
+bool lora_init(void)
+{
+    BOOT_TRACE_SCOPE("LoRa");
+    if(lora_mutex == NULL){
+        lora_mutex = xSemaphoreCreateMutex();
+    }
+    // Same user as the Meshtastic power switch, which can still cut it
+    power_domain_acquire(power_domain_user(PWR_DOMAIN_LORA, "lora"));
+    power_domain_wait(PWR_DOMAIN_LORA);
+
+    Serial.print(F("[SX1262] Initializing ... "));
+    int state = radio.begin(LORA_FREQ);
+    if (state == RADIOLIB_ERR_NONE) {
+        Serial.println(F("success!"));
+    } else {
+        Serial.print(F("failed, code "));
+        Serial.println(state);
+        return false;
+    }
+
+    radio.setDio1Action(lora_dio1_isr);
+
+    state = lora_board_setup();
+    if (state != RADIOLIB_ERR_NONE) {
+        LOG_ERRORF("LoRa", "Board setup failed, code %d", state);
+        return false;
+    }
+
+    // Modulation comes from the stored profile, falling back to the default
+    String name = LORA_PROFILE_DEFAULT;
+#ifdef INTEGRATION_LAYER_ENABLED
+    name = GET_CONFIG_STRING("lora", "profile", name);
+    lora_adr_enabled = GET_CONFIG(LORA_ADR);
+    lora_lbt_enabled = GET_CONFIG(LORA_LBT);
+    lora_rx_dc_enabled = GET_CONFIG(LORA_RX_DUTY_CYCLE);
+    lora_compress = GET_CONFIG(LORA_COMPRESS);
+#endif
+    const lora_profile_t *preset = lora_find_profile(name.c_str());
+    if(preset == NULL){
+        LOG_WARNF("LoRa", "Unknown radio profile %s, using %s", name.c_str(), LORA_PROFILE_DEFAULT);
+        preset = lora_find_profile(LORA_PROFILE_DEFAULT);
+    }
+
+    lora_profile_t profile = *preset;
+#ifdef INTEGRATION_LAYER_ENABLED
+    lora_profile_overlay(&profile);
+#endif
+
+    // A bad override must not take the radio down with it
+    lora_active_valid = false;
+    if(!lora_apply_profile(&profile) && !lora_apply_profile(preset)){
+        return false;
     }
 
     Serial.println(F("All settings succesfully changed!"));
 
-    Serial.println(F("[SX1262] Sending first packet ... "));
-    transmissionState = radio.startTransmit("Hello World!");
+    lora_crypt_begin();
+
+    lora_airtime_stamp = millis();
+    if(lora_task_handle == NULL){
+        xTaskCreate(lora_task, "lora_task", 1024 * 3, NULL, LORA_PRIORITY, &lora_task_handle);
+        // A backlog of received packets keeps the clock up until the consumer drains it
+        power_governor_add_source("lora_rx", lora_rx_work);
+    }
+
+#ifdef INTEGRATION_LAYER_ENABLED
+    if(GlobalConfigManager){
+        GlobalConfigManager->watch("lora", "", lora_config_changed);
+    }
+#endif
+
     // radio.sleep();
 
     return true;
@@ -124,14 +1050,14 @@ bool lora_init(void)
 
 void lora_set_mode(int mode) 
 {
-    if(mode == LORA_MODE_SEND){
-        radio.setPacketSentAction(set_transmit_flag);
-        Serial.println(F("[LORA] Sending first packet ... "));
-        transmissionState = radio.startTransmit("Hello World!");
+    LORA_LOCK();
+    if(lora_tx_active >= 0){
+        // TX done picks the matching state (receive or standby) afterwards
+    } else if(mode == LORA_MODE_SEND){
+        radio.standby();
     } else if(mode == LORA_MODE_RECV){
-        radio.setPacketReceivedAction(set_receive_flag);
         Serial.println(F("[LORA] Starting to listen ... "));
-        receivedState = radio.startReceive();
+        receivedState = lora_start_rx();
         if (receivedState == RADIOLIB_ERR_NONE) {
             Serial.println(F("success!"));
         } else {
@@ -140,6 +1066,7 @@ void lora_set_mode(int mode)
         }
     }
     lora_mode = mode;
+    LORA_UNLOCK();
 }
 
 int lora_get_mode(void)
@@ -147,58 +1074,279 @@ int lora_get_mode(void)
     return lora_mode;
 }
 
-void lora_receive_loop(void)
+uint32_t lora_tx_submit(const uint8_t *data, size_t len, int priority, int retries, uint32_t delay_ms)
 {
-    if(receivedFlag){
-        receivedFlag = false;
+    if(len == 0 || len > LORA_PACKET_MAX || lora_mutex == NULL) return 0;
+    // Frames restored from sleep were packed and sealed before it
+    bool seal = lora_crypt_enabled() && !lora_crypt_is_own(data, len);
+    bool pack = lora_compress && !lora_crypt_is_own(data, len) && !lora_codec_is_packed(data, len);
+    if(seal && !pack && len + LORA_CRYPT_OVERHEAD > LORA_PACKET_MAX){
+        lora_tx_dropped_count++;
+        return 0;
+    }
 
-        lora_recv_success = true;
+    LORA_LOCK();
+    int free_slot = -1;
+    int victim = -1;    // newest queued packet of the lowest priority
+    for(int i = 0; i < LORA_TX_POOL_SIZE; i++){
+        lora_tx_slot_t *slot = &lora_tx_pool[i];
+        if(!slot->used){
+            free_slot = i;
+            break;
+        }
+        if(i == lora_tx_active) continue;
+        if(victim < 0 || slot->priority > lora_tx_pool[victim].priority ||
+           (slot->priority == lora_tx_pool[victim].priority && (int32_t)(slot->seq - lora_tx_pool[victim].seq) > 0)){
+            victim = i;
+        }
+    }
 
-        // String str;
-        receivedState = radio.readData(lora_recv_data);
-        if(receivedState == RADIOLIB_ERR_NONE){
-            Serial.println(F("[SX1262] Received packet!"));
+    // Full: a more urgent packet displaces the least urgent one
+    if(free_slot < 0 && victim >= 0 && lora_tx_pool[victim].priority > priority){
+        free_slot = victim;
+        lora_tx_dropped_count++;
+    }
+    if(free_slot < 0){
+        lora_tx_dropped_count++;
+        LORA_UNLOCK();
+        return 0;
+    }
 
-            Serial.print(F("[SX1262] Data:\t\t"));
-            Serial.println(lora_recv_data.c_str());
-            // Serial.println("%d", (int)lora_recv_data.toInt());
+    // Packed, then sealed, in the slot itself; retries resend the same frame
+    lora_tx_slot_t *slot = &lora_tx_pool[free_slot];
+    uint8_t *body = seal ? slot->data + LORA_CRYPT_HEADER : slot->data;
+    size_t room = seal ? LORA_PACKET_MAX - LORA_CRYPT_OVERHEAD : LORA_PACKET_MAX;
+    size_t packed = pack ? lora_codec_encode(data, len, body, room) : 0;
+    if(packed){
+        lora_tx_packed_count++;
+        lora_tx_bytes_saved += len - packed;
+        len = packed;
+    } else if(len <= room){
+        memcpy(body, data, len);
+    } else {
+        len = 0;    // Too long to seal and would not pack
+    }
+    if(seal && len){
+        len = lora_crypt_seal(slot->data, len, LORA_PACKET_MAX);
+    }
+    if(len == 0){
+        slot->used = false;
+        lora_tx_dropped_count++;
+        LORA_UNLOCK();
+        return 0;
+    }
+    slot->len = len;
+    slot->priority = priority;
+    slot->retries = retries;
+    slot->attempt = 0;
+    // The sequence number doubles as the ticket, 0 means not queued
+    if(lora_tx_seq == 0) lora_tx_seq++;
+    uint32_t ticket = lora_tx_seq++;
+    slot->seq = ticket;
+    slot->not_before = delay_ms ? millis() + delay_ms : 0;
+    slot->cad_busy = 0;
+    slot->used = true;
 
-            Serial.print(F("[SX1262] RSSI:\t\t"));
-            Serial.print(radio.getRSSI());
-            lora_recv_rssi = (int) radio.getRSSI();
-            Serial.println(F(" dBm"));
-        }else{
-            Serial.print(F("failed, code "));
-            Serial.println(receivedState);
+    int queued = 0;
+    for(int i = 0; i < LORA_TX_POOL_SIZE; i++){
+        if(lora_tx_pool[i].used) queued++;
+    }
+    if(queued > lora_tx_queued_max) lora_tx_queued_max = queued;
+    LORA_UNLOCK();
+
+    if(lora_task_handle){
+        xTaskNotify(lora_task_handle, LORA_EVT_TX_KICK, eSetBits);
+    }
+    return ticket;
+}
+
+bool lora_tx_enqueue(const uint8_t *data, size_t len, int priority, int retries)
+{
+    return lora_tx_submit(data, len, priority, retries, 0) != 0;
+}
+
+bool lora_tx_cancel(uint32_t ticket)
+{
+    if(ticket == 0 || lora_mutex == NULL) return false;
+
+    bool found = false;
+    LORA_LOCK();
+    for(int i = 0; i < LORA_TX_POOL_SIZE; i++){
+        lora_tx_slot_t *slot = &lora_tx_pool[i];
+        if(slot->used && slot->seq == ticket && i != lora_tx_active){
+            slot->used = false;
+            found = true;
+            break;
         }
     }
+    LORA_UNLOCK();
+    return found;
+}
+
+static bool lora_rx_queue(const uint8_t *data, size_t len, float rssi, float snr, bool replay)
+{
+    if(lora_task_handle == NULL || len == 0 || len > LORA_PACKET_MAX) return false;
+    if(lora_inject_queue == NULL){
+        lora_inject_queue = xQueueCreate(LORA_RX_INJECT_DEPTH, sizeof(lora_inject_t));
+        if(lora_inject_queue == NULL) return false;
+    }
+    lora_inject_t item;
+    memcpy(item.data, data, len);
+    item.len = len;
+    item.replay = replay;
+    item.rssi = rssi;
+    item.snr = snr;
+    if(xQueueSend(lora_inject_queue, &item, 0) != pdTRUE){
+        lora_rx_dropped_count++;
+        return false;
+    }
+    xTaskNotify(lora_task_handle, LORA_EVT_INJECT, eSetBits);
+    return true;
+}
+
+bool lora_rx_inject(const uint8_t *data, size_t len, int8_t rssi)
+{
+    return lora_rx_queue(data, len, rssi, 0, false);
+}
+
+bool lora_rx_replay(const uint8_t *data, size_t len, float rssi, float snr)
+{
+    return lora_rx_queue(data, len, rssi, snr, true);
 }
 
 void lora_transmit(const char *str)
 {
-    if(transmittedFlag){
-        transmittedFlag = false;
-        if(transmissionState == RADIOLIB_ERR_NONE){
-            Serial.println(F("transmission finished!"));
-        } else {
-            Serial.print(F("failed, code "));
-            Serial.println(transmissionState);
+    size_t len = strlen(str);
+    if(!lora_tx_enqueue((const uint8_t *)str, len, LORA_TX_PRIO_NORMAL, LORA_TX_RETRIES)){
+        LOG_WARN("LoRa", "TX queue full, packet dropped");
+        return;
+    }
+    msg_store_append(MSG_CHANNEL_LORA, "lora", str, len, MSG_FLAG_OUT);
+}
+
+int lora_tx_pending(void)
+{
+    int n = 0;
+    for(int i = 0; i < LORA_TX_POOL_SIZE; i++){
+        if(lora_tx_pool[i].used) n++;
+    }
+    return n;
+}
+
+int lora_tx_save(lora_tx_saved_t *out, int max)
+{
+    if(lora_mutex == NULL) return 0;
+
+    // Selection sort by priority, then FIFO: the pool is tiny
+    bool taken[LORA_TX_POOL_SIZE] = {false};
+    int n = 0;
+    LORA_LOCK();
+    while(n < max){
+        int best = -1;
+        for(int i = 0; i < LORA_TX_POOL_SIZE; i++){
+            lora_tx_slot_t *slot = &lora_tx_pool[i];
+            if(!slot->used || taken[i]) continue;
+            if(best < 0 || slot->priority < lora_tx_pool[best].priority ||
+               (slot->priority == lora_tx_pool[best].priority && (int32_t)(slot->seq - lora_tx_pool[best].seq) < 0)){
+                best = i;
+            }
         }
+        if(best < 0) break;
+        taken[best] = true;
+        lora_tx_slot_t *slot = &lora_tx_pool[best];
+        memcpy(out[n].data, slot->data, slot->len);
+        out[n].len = slot->len;
+        out[n].priority = slot->priority;
+        out[n].retries = slot->retries;
+        n++;
+    }
+    LORA_UNLOCK();
+    return n;
+}
+
+uint32_t lora_tx_airtime_left_ms(void)
+{
+    return lora_airtime_credit_us / 1000;
+}
+
+void lora_get_counters(lora_counters_t *out)
+{
+    out->rx_packets = lora_rx_packet_count;
+    out->rx_errors = lora_rx_error_count;
+    out->rx_dropped = lora_rx_dropped_count;
+    out->tx_sent = lora_tx_sent_count;
+    out->tx_failed = lora_tx_failed_count;
+    out->tx_retries = lora_tx_retry_count;
+    out->tx_dropped = lora_tx_dropped_count;
+    out->tx_packed = lora_tx_packed_count;
+    out->tx_bytes_saved = lora_tx_bytes_saved;
+    out->rx_unpack_failed = lora_rx_unpack_failed;
+    out->rx_duplicates = lora_rx_dup_count;
+    out->lbt_busy = lora_lbt_busy_count;
+    out->airtime_us = lora_airtime_total_us;
+    out->airtime_budget_us = LORA_DUTY_BUDGET_US;
 
-        radio.finishTransmit();
-        Serial.print(F("[Lora] Sending another packet ... "));
-        transmissionState = radio.startTransmit(str);
+    // Credit not yet refilled is what the last window spent
+    uint32_t credit = lora_airtime_credit_us;
+    out->airtime_window_us = credit < LORA_DUTY_BUDGET_US ? LORA_DUTY_BUDGET_US - credit : 0;
+    out->tx_queued = lora_tx_pending();
+    out->tx_queued_max = lora_tx_queued_max;
+}
+
+const lora_packet_t *lora_rx_peek(void)
+{
+    uint16_t t = lora_rx_tail.load(std::memory_order_relaxed);
+    if(t == lora_rx_head.load(std::memory_order_acquire)) return NULL;
+    return &lora_rx_ring[t];
+}
+
+int lora_rx_pending(void)
+{
+    uint16_t t = lora_rx_tail.load(std::memory_order_relaxed);
+    return (lora_rx_head.load(std::memory_order_acquire) - t) & (LORA_RX_POOL_SIZE - 1);
+}
+
+void lora_rx_pop(void)
+{
+    uint16_t t = lora_rx_tail.load(std::memory_order_relaxed);
+    if(t == lora_rx_head.load(std::memory_order_acquire)) return;
+    lora_rx_tail.store((t + 1) & (LORA_RX_POOL_SIZE - 1), std::memory_order_release);
+}
+
+uint32_t lora_rx_dropped(void)
+{
+    return lora_rx_dropped_count;
+}
+
+uint32_t lora_rx_errors(void)
+{
+    return lora_rx_error_count;
+}
+
+bool lora_add_rx_hook(lora_rx_hook_t hook)
+{
+    for(uint8_t i = 0; i < lora_rx_hook_count; i++){
+        if(lora_rx_hooks[i] == hook) return true;
     }
+    if(lora_rx_hook_count >= LORA_RX_HOOKS) return false;
+
+    // The entry is in place before the count makes it visible to the RX task
+    lora_rx_hooks[lora_rx_hook_count] = hook;
+    lora_rx_hook_count++;
+    return true;
 }
 
 bool lora_get_recv(const char **str, int *rssi)
 {
-    *str = lora_recv_data.c_str();
-    *rssi = lora_recv_rssi;
-    return lora_recv_success;
+    const lora_packet_t *pkt = lora_rx_peek();
+    if(pkt == NULL) return false;
+
+    *str = (const char *)pkt->data;
+    *rssi = (int)pkt->rssi;
+    return true;
 }
 
 void lora_set_recv_flag(void)
 {
-    lora_recv_success = false;
+    lora_rx_pop();
 }
\ No newline at end of file
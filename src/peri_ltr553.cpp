@@ -1,14 +1,113 @@
 #include <Wire.h>
 #include <SPI.h>
 #include <Arduino.h>
+#include <esp_sleep.h>
+#include <driver/gpio.h>
+#include <hal/gpio_ll.h>
 #include "SensorLTR553.hpp"
 #include "utilities.h"
 #include "peripheral.h"
+#include "i2c_bus.h"
+#include "coro_sched.h"
+
+#define LTR553_ST_ALS_INVALID   0x80
+#define LTR553_ST_ALS_INT       0x08
+#define LTR553_ST_PS_INT        0x02
+#define LTR553_ALS_MAX          0xFFFF
+#define LTR553_PS_MAX           0x07FF
+#define LTR553_SIG_INT          0x01
 
 SensorLTR553 als;
 
+static Coro ltr_coro;
+static ltr553_event_cb ltr_event_cb = NULL;
+static ltr553_stats_t ltr_stats;
+
+static bool ltr_read(uint8_t reg, uint8_t *buf, uint8_t len)
+{
+    return i2c_bus_read_reg(I2C_DEV_LTR553, reg, buf, len);
+}
+
+// INT is active low and held until the data registers are read: masked here,
+// unmasked by the coroutine once it has read them
+static void IRAM_ATTR ltr_int_isr(void)
+{
+    gpio_ll_intr_disable(&GPIO, (gpio_num_t)BOARD_ALS_INT);
+    BaseType_t woken = pdFALSE;
+    coro_signal_from_isr(&ltr_coro, LTR553_SIG_INT, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+// Only leaving the current state is outside the window
+static void als_window(bool dark)
+{
+    i2c_bus_acquire(I2C_DEV_LTR553);
+    if(dark) als.setLightSensorThreshold(0, LTR553_ALS_BRIGHT);
+    else als.setLightSensorThreshold(LTR553_ALS_DARK, LTR553_ALS_MAX);
+    i2c_bus_release(I2C_DEV_LTR553);
+}
+
+static void ps_window(bool near)
+{
+    i2c_bus_acquire(I2C_DEV_LTR553);
+    if(near) als.setProximityThreshold(LTR553_PS_FAR, LTR553_PS_MAX);
+    else als.setProximityThreshold(0, LTR553_PS_NEAR);
+    i2c_bus_release(I2C_DEV_LTR553);
+}
+
+static void ltr_als_event(bool valid)
+{
+    uint8_t buf[4];     // CH1 then CH0; reading them clears the ALS interrupt
+    if(!ltr_read(LTR553_REG_ALS_DATA_CH1_0, buf, sizeof(buf)) || !valid) return;
+
+    uint16_t ch0 = buf[2] | (buf[3] << 8);
+    ltr_stats.als = ch0;
+    bool dark = ltr_stats.dark ? ch0 <= LTR553_ALS_BRIGHT : ch0 < LTR553_ALS_DARK;
+    if(dark == ltr_stats.dark) return;
+
+    ltr_stats.dark = dark;
+    ltr_stats.als_events++;
+    als_window(dark);
+    if(ltr_event_cb) ltr_event_cb(dark ? LTR553_EVT_DARK : LTR553_EVT_BRIGHT, ch0);
+}
+
+static void ltr_ps_event(const uint8_t *buf)
+{
+    uint16_t ps = buf[0] | ((buf[1] & 0x07) << 8);
+    ltr_stats.ps = ps;
+    bool near = ltr_stats.near ? ps >= LTR553_PS_FAR : ps > LTR553_PS_NEAR;
+    if(near == ltr_stats.near) return;
+
+    ltr_stats.near = near;
+    ltr_stats.ps_events++;
+    ps_window(near);
+    if(ltr_event_cb) ltr_event_cb(near ? LTR553_EVT_NEAR : LTR553_EVT_FAR, ps);
+}
+
+static CoroStatus ltr_coro_fn(Coro *co)
+{
+    CORO_BEGIN(co);
+    while(1){
+        CORO_AWAIT(co, LTR553_SIG_INT, CORO_FOREVER);
+
+        // Status and the PS data follow each other, so one burst reads both;
+        // reading the PS data clears its interrupt
+        uint8_t buf[3];
+        if(ltr_read(LTR553_REG_ALS_PS_STATUS, buf, sizeof(buf))){
+            uint8_t status = buf[0];
+            ltr_stats.interrupts++;
+            if(status & LTR553_ST_PS_INT) ltr_ps_event(buf + 1);
+            if(status & LTR553_ST_ALS_INT) ltr_als_event(!(status & LTR553_ST_ALS_INVALID));
+        }
+        gpio_intr_enable((gpio_num_t)BOARD_ALS_INT);
+    }
+    CORO_END(co);
+}
+
 bool LTR553_init(void)
 {
+    if(coro_running(&ltr_coro)) return true;
+
     if (!als.begin(Wire, LTR553_SLAVE_ADDRESS, BOARD_I2C_SDA, BOARD_I2C_SCL)) {
         Serial.println("Failed to find LTR553 - check your wiring!");
         return false;
@@ -16,13 +115,10 @@ bool LTR553_init(void)
 
     Serial.println("Init LTR553 Sensor success!");
 
-    // Set the ambient light high and low thresholds.
-    // If the value exceeds or falls below the set value, an interrupt will be triggered.
-    als.setLightSensorThreshold(10, 200);
-
-    // Set the high and low thresholds of the proximity sensor.
+    // Start bright and far: the first interrupt is a crossing into dark or near.
     // If the value exceeds or falls below the set value, an interrupt will be triggered.
-    als.setProximityThreshold(10, 30);
+    als_window(false);
+    ps_window(false);
 
     // Controls the Light Sensor N number of times the measurement data is outside the range
     // defined by the upper and lower threshold limits before asserting the interrupt.
@@ -30,7 +126,7 @@ bool LTR553_init(void)
 
     // Controls the Proximity  N number of times the measurement data is outside the range
     // defined by the upper and lower threshold limits before asserting the interrupt.
-    als.setProximityPersists(5);
+    als.setProximityPersists(LTR553_PS_PERSIST);
 
     /*
     *  ALS_IRQ_ACTIVE_LOW, // INT pin is considered active when it is a logic 0 (default)
@@ -108,9 +204,28 @@ bool LTR553_init(void)
     // Enable proximity sensor
     als.enableProximity();
 
+    // Nothing polls the sensor: its coroutine waits for INT on the shared scheduler
+    coro_spawn(&ltr_coro, "ltr553", ltr_coro_fn);
+    pinMode(BOARD_ALS_INT, INPUT_PULLUP);
+    attachInterrupt(BOARD_ALS_INT, ltr_int_isr, ONLOW);
+
+    // A crossing wakes the chip from light sleep like the other interrupt lines
+    gpio_wakeup_enable((gpio_num_t)BOARD_ALS_INT, GPIO_INTR_LOW_LEVEL);
+    esp_sleep_enable_gpio_wakeup();
+
     return true;
 }
 
+void LTR553_set_event_cb(ltr553_event_cb cb)
+{
+    ltr_event_cb = cb;
+}
+
+void LTR553_get_stats(ltr553_stats_t *out)
+{
+    *out = ltr_stats;
+}
+
 uint16_t LTR_553ALS_get_channel(int ch) // ch 0~1
 {
     return als.getLightSensor(ch);
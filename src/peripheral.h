@@ -6,6 +6,8 @@
 #define WS2812_PRIORITY  (configMAX_PRIORITIES - 3)
 #define BATTERY_PRIORITY (configMAX_PRIORITIES - 4)
 #define A7682E_PRIORITY  (configMAX_PRIORITIES - 5)
+#define BHI260_PRIORITY  (configMAX_PRIORITIES - 6)
+#define KEYPAD_PRIORITY  (configMAX_PRIORITIES - 8)
 
 enum {
     E_PERI_LORA = 0,
@@ -24,22 +26,202 @@ enum {
     E_PERI_NUM_MAX,
 };
 
+// deferred init: the thunk runs on the first ui_* access or an idle warmup step
+typedef bool (*peri_init_cb)(void);
+
+void peri_init_defer(int peri_id, peri_init_cb cb);
+bool peri_init_ensure(int peri_id);
+bool peri_init_warmup(void); // runs one pending thunk, false once none are left
+bool peri_init_ready(int peri_id);  // no init, safe from any task
+
 // lora sx1262
 #define LORA_FREQ      850.0
 #define LORA_MODE_SEND 0
 #define LORA_MODE_RECV 1
 
+#define LORA_RX_POOL_SIZE 8   // queued packets, power of two
+#define LORA_PACKET_MAX   255 // SX1262 FIFO
+
+typedef struct {
+    uint8_t data[LORA_PACKET_MAX + 1]; // NUL-terminated for text payloads
+    uint16_t len;
+    float rssi;
+    float snr;
+    uint32_t time_ms;
+} lora_packet_t;
+
+#define LORA_TX_POOL_SIZE   8
+#define LORA_TX_PRIO_HIGH   0
+#define LORA_TX_PRIO_NORMAL 1
+#define LORA_TX_PRIO_LOW    2
+#define LORA_TX_RETRIES     2       // default for lora_transmit()
+#define LORA_TX_RETRY_MS    200     // first retry delay, doubles per attempt
+#define LORA_DUTY_PERMILLE  10      // EU868 g1 sub-band: 1% airtime
+#define LORA_DUTY_WINDOW_MS 3600000 // budget window, one hour
+
+// radio profiles: a named preset (lora.profile) with optional per-field
+// overrides (lora.frequency, lora.bandwidth, ...) on top
+typedef struct {
+    const char *name;
+    float freq;         // MHz
+    float bw;           // kHz
+    uint8_t sf;
+    uint8_t cr;         // 4/cr
+    uint8_t sync_word;
+    int8_t power;       // dBm
+    uint16_t preamble;  // symbols
+    bool crc;
+} lora_profile_t;
+
+#define LORA_PROFILE_DEFAULT "default" // also: long_range, fast, meshtastic
+#define LORA_ADR_MARGIN_DB   5.0       // SNR kept above the demodulation floor
+#define LORA_ADR_SAMPLES     8         // received packets per ADR decision
+
 bool lora_init(void);
 void lora_set_mode(int mode);
 int lora_get_mode(void);
-void lora_receive_loop(void);
-void lora_transmit(const char *str);
+
+// tx queue: never blocks on the radio; false if the packet was not queued
+bool lora_tx_enqueue(const uint8_t *data, size_t len, int priority, int retries);
+// held back for delay_ms; the ticket (0 if not queued) cancels it before it airs
+uint32_t lora_tx_submit(const uint8_t *data, size_t len, int priority, int retries, uint32_t delay_ms);
+bool lora_tx_cancel(uint32_t ticket);
+void lora_transmit(const char *str); // normal priority, LORA_TX_RETRIES
+int lora_tx_pending(void);
+uint32_t lora_tx_airtime_left_ms(void);
+// queued packets in send order, to carry them through deep sleep; the one
+// on air is included. lora_tx_enqueue() puts them back
+typedef struct {
+    uint8_t data[LORA_PACKET_MAX];
+    uint8_t len;
+    uint8_t priority;
+    uint8_t retries;
+} lora_tx_saved_t;
+int lora_tx_save(lora_tx_saved_t *out, int max);
+
+// counters for link statistics, since boot
+typedef struct {
+    uint32_t rx_packets;
+    uint32_t rx_errors;
+    uint32_t rx_dropped;
+    uint32_t tx_sent;
+    uint32_t tx_failed;
+    uint32_t tx_retries;
+    uint32_t tx_dropped;
+    uint32_t tx_packed;         // sent in lora_codec form
+    uint32_t tx_bytes_saved;    // by packing
+    uint32_t rx_unpack_failed;
+    uint32_t rx_duplicates;     // the second copy of a payload sent over two carriers
+    uint32_t lbt_busy;
+    uint32_t airtime_us;        // total time on air
+    uint32_t airtime_window_us; // spent from the duty-cycle budget
+    uint32_t airtime_budget_us;
+    uint8_t tx_queued;
+    uint8_t tx_queued_max;
+} lora_counters_t;
+void lora_get_counters(lora_counters_t *out);
+
+// switching reprograms only the fields that differ from the running profile
+// and waits for a packet on air to finish
+bool lora_set_profile(const char *name); // preset plus stored overrides, persisted
+bool lora_apply_profile(const lora_profile_t *profile);
+const lora_profile_t *lora_get_profile(void);
+const lora_profile_t *lora_find_profile(const char *name);
+const lora_profile_t *lora_get_presets(size_t *count);
+uint32_t lora_profile_time_on_air_us(const lora_profile_t *profile, size_t len);
+void lora_set_adr(bool enable);
+bool lora_get_adr(void);
+
+// duty-cycled receive sleeps between preamble checks: awake for about
+// MIN_SYMBOLS + 1 of every PREAMBLE - MIN_SYMBOLS + 1 symbols (~16% at 64/8).
+// Peers must send the long preamble too, which this mode also switches on
+#define LORA_RX_DC_PREAMBLE    64
+#define LORA_RX_DC_MIN_SYMBOLS 8
+bool lora_set_rx_duty_cycle(bool enable);
+bool lora_get_rx_duty_cycle(void);
+
+// listen-before-talk: CAD before each packet, random growing backoff while
+// the channel is busy, sent regardless after LORA_LBT_MAX_TRIES busy scans
+#define LORA_LBT_MAX_TRIES     6
+#define LORA_LBT_BACKOFF_MS    50
+void lora_set_lbt(bool enable);
+bool lora_get_lbt(void);
+uint32_t lora_lbt_busy(void);
+
+// GFSK for short-range bulk transfers, on the profile's frequency and power,
+// whitened, CRC-16. The LoRa profile stays stored and is programmed back on
+// lora_fsk_stop(), or by itself after idle_ms without a frame either way.
+// Both switch once the TX queue has drained, so a frame announcing the
+// switch still goes out on the old modem. No ADR, LBT or duty-cycled
+// receive while it runs; the duty-cycle budget still applies
+typedef struct {
+    const char *name;
+    float bitrate;      // kbps
+    float freq_dev;     // kHz
+    float rx_bw;        // kHz, one the SX1262 offers
+    uint16_t preamble;  // bits
+} lora_fsk_t;
+const lora_fsk_t *lora_find_fsk(const char *name); // fsk50, fsk100, fsk300
+const lora_fsk_t *lora_get_fsk_presets(size_t *count);
+uint32_t lora_fsk_time_on_air_us(const lora_fsk_t *fsk, size_t len);
+bool lora_fsk_start(const lora_fsk_t *fsk, uint32_t idle_ms);
+void lora_fsk_stop(void);
+const lora_fsk_t *lora_fsk_running(void); // NULL while on LoRa
+// one packet on whichever modem is running
+uint32_t lora_time_on_air_us(size_t len);
+
+// rx queue, one consumer: peek the oldest packet, pop it once done with it
+const lora_packet_t *lora_rx_peek(void);
+void lora_rx_pop(void);
+int lora_rx_pending(void);
+uint32_t lora_rx_dropped(void);
+uint32_t lora_rx_errors(void);
+
+// link layers claim their frames (returning true) before they reach the
+// queue; hooks run on the LoRa task in the order they were added
+#define LORA_RX_HOOKS 4
+typedef bool (*lora_rx_hook_t)(const lora_packet_t *pkt);
+bool lora_add_rx_hook(lora_rx_hook_t hook);
+
+// payloads from another carrier (ESP-NOW) take the same path as received
+// packets, hooks included; one that also came over the air is delivered once
+#define LORA_RX_INJECT_DEPTH 4
+#define LORA_RX_DEDUP        8
+#define LORA_RX_DEDUP_MS     30000
+bool lora_rx_inject(const uint8_t *data, size_t len, int8_t rssi);
+// a recorded packet (event_replay.h), delivered as if it came over the air
+bool lora_rx_replay(const uint8_t *data, size_t len, float rssi, float snr);
+
+// oldest packet as text; lora_set_recv_flag() pops it
 bool lora_get_recv(const char **str, int *rssi);
 void lora_set_recv_flag(void);
 
-// keypad
+// keypad: INT drains the TCA8418's event FIFO in one burst into a queue the
+// UI task takes from, so keys typed faster than a frame are all delivered
 #define KEYPAD_PRESS   1
 #define KEYPAD_RELEASE 0
+#define KEYPAD_FIFO_DEPTH 10    // events the TCA8418 holds
+#define KEYPAD_QUEUE_SIZE 32    // power of two
+
+typedef struct {
+    uint32_t time_ms;           // INT edge, shared by the events of one burst
+    uint32_t irq_us;            // The same edge and the FIFO read, for input_trace
+    uint32_t read_us;
+    uint8_t code;               // TCA8418 key number, see keymap.h
+    char val;
+    uint8_t state;              // KEYPAD_PRESS or KEYPAD_RELEASE
+} keypad_event_t;
+
+typedef struct {
+    uint32_t events;
+    uint32_t bursts;            // FIFO reads, one or more per INT
+    uint32_t dropped;           // queue full, the UI task fell behind
+    uint32_t overflows;         // the TCA8418's own FIFO filled before we read it
+    uint32_t glyph_last_ms;     // key press to the panel update that shows it
+    uint32_t glyph_avg_ms;
+    uint32_t glyph_max_ms;
+    uint32_t glyph_count;
+} keypad_stats_t;
 
 typedef void (*keypad_cb)(int state, char val);
 
@@ -48,25 +230,185 @@ int keypad_get_val(char *c);
 void keypad_loop(void);
 void keypad_regetser_cb(keypad_cb cb);
 void keypad_set_flag(void);
+// UI task only; also sets what keypad_get_val() returns
+bool keypad_event_take(keypad_event_t *ev);
+bool keypad_pending(void);
+void keypad_get_stats(keypad_stats_t *out);
+void keypad_note_glyph(uint32_t latency_ms);
+// a recorded key (event_replay.h), queued by the keypad task as if read from the FIFO
+#define KEYPAD_INJECT_DEPTH 16  // power of two
+bool keypad_inject(uint8_t code, uint8_t state);
 
-// gyro
+// gyro: the BHI260AP batches samples in its FIFO and raises INT once per
+// latency period, or at once for its wake-up virtual sensors
+#define BHI260_RATE_HZ    100
+#define BHI260_LATENCY_MS 1000  // samples delivered in one burst
+#define BHI260_LIVE_MS    200   // BHI260AP_get_val() flushes the FIFO when older
+typedef struct {
+    uint32_t steps;             // on-chip step counter
+    uint8_t orientation;        // device orientation, 0-3
+    uint32_t significant_motion;// events since init
+    uint32_t bursts;            // FIFO reads, one per interrupt
+    uint32_t samples;           // accel and gyro samples in them
+    uint32_t flushes;           // early reads asked for by live readers
+} bhi260_stats_t;
+// wake-up sensors: step counter, orientation and significant motion, on the hub task;
+// also stationary detect and any motion (value 1) and activity recognition
+// (value the AR bit field) once started with BHI260AP_set_sensor()
+typedef void (*bhi260_event_cb)(uint8_t sensor_id, uint32_t value);
+// game rotation vector (on-chip fusion, no magnetometer), unit quaternion on the hub task
+typedef void (*bhi260_quat_cb)(float w, float x, float y, float z);
+// raw accel and gyro, once per gyro sample as the FIFO burst is parsed, on the hub task
+typedef struct {
+    int16_t gyro[3];            // gyro_dps per LSB
+    int16_t accel[3];           // the latest accel sample, any scale
+    float gyro_dps;
+    uint32_t steps;             // step counter as of this burst
+    uint64_t timestamp;         // hub time, 1/64000 s
+} bhi260_imu_t;
+typedef void (*bhi260_imu_cb)(const bhi260_imu_t *s);
 bool BHI260AP_init(void);
 void BHI260AP_get_val(int val_type, float *x, float *y, float *z);
+bool BHI260AP_set_batching(float rate_hz, uint32_t latency_ms);
+void BHI260AP_get_stats(bhi260_stats_t *out);
+void BHI260AP_set_event_cb(bhi260_event_cb cb);
+bool BHI260AP_set_rotation_cb(bhi260_quat_cb cb, float rate_hz, uint32_t latency_ms); // NULL or 0 Hz stops it
+void BHI260AP_set_imu_cb(bhi260_imu_cb cb);    // NULL stops it
+bool BHI260AP_set_sensor(uint8_t sensor_id, float rate_hz, uint32_t latency_ms);  // queued for the hub task, safe in its callbacks; 0 Hz stops it
 
-// LTR553
+// LTR553: INT only, the thresholds are moved after each crossing so the
+// next interrupt is the crossing back (raw counts, CH0 at 8x gain)
+#define LTR553_ALS_DARK    30   // below: dark, keypad light on
+#define LTR553_ALS_BRIGHT  60   // above: bright again
+#define LTR553_PS_NEAR     400  // 11-bit proximity counts
+#define LTR553_PS_FAR      250
+#define LTR553_PS_PERSIST  2    // samples at 200 ms before a proximity INT
+enum {
+    LTR553_EVT_DARK = 0,
+    LTR553_EVT_BRIGHT,
+    LTR553_EVT_NEAR,
+    LTR553_EVT_FAR,
+};
+typedef struct {
+    uint32_t interrupts;
+    uint32_t als_events;        // dark/bright changes
+    uint32_t ps_events;         // near/far changes
+    uint16_t als;               // CH0 at the last ALS interrupt
+    uint16_t ps;                // proximity at the last PS interrupt
+    bool dark;
+    bool near;
+} ltr553_stats_t;
+// on the sensor task
+typedef void (*ltr553_event_cb)(int event, uint16_t value);
 bool LTR553_init(void);
+void LTR553_set_event_cb(ltr553_event_cb cb);
+void LTR553_get_stats(ltr553_stats_t *out);
 uint16_t LTR_553ALS_get_channel(int ch); // ch 0~1
 uint16_t LTR_553ALS_get_ps(void);
 
+// BQ25896: status is read when INT pulses (polled where INT is not routed),
+// the ADC runs one-shot only when a reader wants fresh values, and status
+// and ADC registers come in one burst into a snapshot readers copy
+#ifndef BOARD_BQ25896_INT
+#define BOARD_BQ25896_INT      -1   // not routed on this board rev
+#endif
+#define BQ25896_POLL_MS        5000 // status without INT
+#define BQ25896_ADC_TIMEOUT_MS 1000 // one-shot conversion of every channel
+#define BQ25896_UI_ADC_MS      5000 // ADC age the battery screen accepts
+typedef struct {
+    uint32_t time_ms;           // last status read
+    uint32_t adc_ms;            // last conversion, 0 before the first
+    uint8_t vbus_stat;          // REG0B[7:5], BQ25896_bus_str()
+    uint8_t chrg_stat;          // 0 none, 1 pre, 2 fast, 3 done
+    bool power_good;
+    bool vbus_good;             // from the ADC
+    uint8_t fault;              // REG0C as last read
+    uint8_t faults_seen;        // every fault bit read since init
+    uint16_t vbat_mv;
+    uint16_t vsys_mv;
+    uint16_t vbus_mv;
+    uint16_t ichg_ma;
+    float ts_pct;               // NTC as a share of REGN
+    uint16_t vreg_mv;           // charge target, set at init
+    uint16_t iprechg_ma;
+    uint32_t interrupts;
+    uint32_t polls;
+    uint32_t conversions;
+    uint32_t read_errors;
+} bq25896_snapshot_t;
+bool BQ25896_init(void);
+bool BQ25896_get_snapshot(bq25896_snapshot_t *out); // any task; false before the first read
+void BQ25896_request_adc(uint32_t max_age_ms);      // converts in the background when older
+const char *BQ25896_bus_str(uint8_t vbus_stat);
+const char *BQ25896_chg_str(uint8_t chrg_stat);
+const char *BQ25896_ntc_str(uint8_t fault);
+
 // gps u-blox m10q
+#define GPS_MOVE_THRESHOLD_M 10   // GPS_LOCATION_UPDATE only past this distance
+typedef struct {
+    uint32_t version;       // bumped on every published fix
+    uint32_t time_ms;       // millis() when it was published
+    bool valid;             // position is a real fix
+    double lat, lng;
+    double altitude;        // m above mean sea level
+    double speed;           // km/h
+    float heading;          // deg
+    float h_acc, v_acc;     // m, 0 when the source does not report it
+    uint16_t year;
+    uint8_t month, day;
+    uint8_t hour, minute, second;
+    uint8_t fix_type;
+    uint32_t vsat;
+} gps_fix_t;
+// Power: consumers state how old a fix may get, the receiver sleeps in
+// software backup between fixes when every consumer allows it
+#define GPS_CONSUMER_UI             0
+#define GPS_CONSUMER_TRACK          1
+#define GPS_CONSUMER_APP            2
+#define GPS_CONSUMER_FENCE          3
+#define GPS_CONSUMER_MAX            4
+#define GPS_UI_FIX_INTERVAL_MS      1000
+#define GPS_PWR_CONTINUOUS_MS       15000   // intervals up to this keep it on
+#define GPS_PWR_SETTLE_MS           3000    // stays on after a fix
+#define GPS_PWR_MIN_SLEEP_MS        5000
+#define GPS_PWR_WAKE_MS             100
+#define GPS_PWR_ACQUIRE_TIMEOUT_MS  120000
+typedef enum {
+    GPS_PWR_OFF,        // BOARD_GPS_EN low, next start is cold
+    GPS_PWR_ACQUIRE,
+    GPS_PWR_ON,
+    GPS_PWR_BACKUP,     // UBX-RXM-PMREQ backup, ephemeris kept
+} gps_power_state_t;
 bool gps_init(void);
 void gps_task_create(void);
 void gps_task_suspend(void);
 void gps_task_resume(void);
+double gps_distance_m(double lat1, double lng1, double lat2, double lng2);
+uint32_t gps_get_fix(gps_fix_t *fix);   // consistent copy from any core, returns its version
+void gps_set_fix_notify(void (*cb)(void));  // called on the GPS task after each published fix
+void gps_restore_fix(const gps_fix_t *fix, uint32_t age_ms);   // before gps_init, a fix kept through deep sleep
 void gps_get_coord(double *lat, double *lng);
 void gps_get_data(uint16_t *year, uint8_t *month, uint8_t *day);
 void gps_get_time(uint8_t *hour, uint8_t *minute, uint8_t *second);
 void gps_get_satellites(uint32_t *vsat);
 void gps_get_speed(double *speed);
+void gps_get_accuracy(float *h_acc, float *v_acc);   // metres, 0 on NMEA
+// UBX NAV-PVT only, NMEA output off; rate 1-10 Hz
+#define GPS_UBX_RATE_MIN 1
+#define GPS_UBX_RATE_MAX 10
+bool gps_set_ubx(bool enable, uint8_t rate_hz);
+bool gps_get_ubx(uint8_t *rate_hz);
+void gps_power_request(int consumer, uint32_t max_age_ms);   // 0 releases
+// background consumers (all but GPS_CONSUMER_UI) get their intervals scaled
+// by pct / 100, never below GPS_UI_FIX_INTERVAL_MS; 0 parks them (motion_service.h)
+void gps_power_scale(uint16_t pct);
+// dead reckoning (nav_fusion.h) covers gaps up to gap_ms: every consumer's
+// interval, the UI's included, is raised to at least that; 0 ends it
+void gps_power_stretch(uint32_t gap_ms);
+void gps_power_enable(bool on);
+gps_power_state_t gps_power_state(void);
+uint32_t gps_power_ttff_ms(void);
+void gps_request_assist(void);   // send AGNSS data (gps_assist.h) on the next task wake
+bool gps_replay_feed(const uint8_t *data, size_t len);   // recorded UART bytes, parsed as if received
 
 #endif
\ No newline at end of file
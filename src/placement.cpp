@@ -0,0 +1,189 @@
+/**
+ * @file      placement.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Placement checks and the flash versus IRAM interrupt latency benchmark
+ */
+
+#include "placement.h"
+#include "simple_logger.h"
+#include <esp_intr_alloc.h>
+#include <esp_heap_caps.h>
+#include <soc/soc_memory_layout.h>
+#include <hal/cpu_hal.h>
+
+// Xtensa level-1 software interrupt, raised and cleared by writing INTSET/INTCLEAR
+#define BENCH_SW_INTR_BIT           (1u << 7)
+#define BENCH_SPIN_MAX              1000000
+
+struct BenchShot {
+    volatile uint32_t entry;        // CCOUNT at the handler's first instruction
+    volatile bool fired;
+};
+
+struct BenchRun {
+    uint32_t samples;
+    PlacementBenchResult* flash;
+    PlacementBenchResult* iram;
+    bool ok;
+    SemaphoreHandle_t done;
+};
+
+static BenchShot bench_shot;
+static volatile bool stress_running = false;
+
+PlacementRegion placement_region(const void* addr) {
+    if (esp_ptr_in_iram(addr)) {
+        return PLACEMENT_IRAM;
+    }
+    if (esp_ptr_external_ram(addr)) {
+        return PLACEMENT_PSRAM;
+    }
+    if (esp_ptr_in_dram(addr)) {
+        return PLACEMENT_DRAM;
+    }
+    return PLACEMENT_FLASH;
+}
+
+const char* placement_region_name(PlacementRegion region) {
+    switch (region) {
+        case PLACEMENT_IRAM:  return "IRAM";
+        case PLACEMENT_DRAM:  return "DRAM";
+        case PLACEMENT_PSRAM: return "PSRAM";
+        default:              return "flash";
+    }
+}
+
+bool placement_check(const char* what, const void* addr, PlacementRegion want) {
+    PlacementRegion got = placement_region(addr);
+    if (got == want || (want == PLACEMENT_PSRAM && got == PLACEMENT_DRAM)) {
+        return true;
+    }
+    LOG_WARNF("Placement", "%s at %p is in %s, wanted %s", what, addr,
+              placement_region_name(got), placement_region_name(want));
+    return false;
+}
+
+// The two handlers are the same code; only where they are linked differs
+static void IRAM_ATTR bench_isr_iram(void* arg) {
+    bench_shot.entry = cpu_hal_get_cycle_count();
+    uint32_t bit = BENCH_SW_INTR_BIT;
+    __asm__ __volatile__("wsr %0, intclear\n rsync" :: "r"(bit));
+    bench_shot.fired = true;
+}
+
+static void __attribute__((noinline)) bench_isr_flash(void* arg) {
+    bench_shot.entry = cpu_hal_get_cycle_count();
+    uint32_t bit = BENCH_SW_INTR_BIT;
+    __asm__ __volatile__("wsr %0, intclear\n rsync" :: "r"(bit));
+    bench_shot.fired = true;
+}
+
+// Keeps the shared cache and the SPI bus to flash and PSRAM busy from the other core
+static void stress_task_fn(void* arg) {
+    uint8_t* a = (uint8_t*)heap_caps_malloc(PLACEMENT_BENCH_STRESS, MALLOC_CAP_SPIRAM);
+    uint8_t* b = (uint8_t*)heap_caps_malloc(PLACEMENT_BENCH_STRESS, MALLOC_CAP_SPIRAM);
+    while (stress_running && a && b) {
+        memcpy(a, b, PLACEMENT_BENCH_STRESS);
+        memcpy(b, a, PLACEMENT_BENCH_STRESS);
+        vTaskDelay(1);              // Leave the idle task its watchdog feed
+    }
+    heap_caps_free(a);
+    heap_caps_free(b);
+    vTaskDelete(NULL);
+}
+
+static bool bench_variant(intr_handler_t handler, int flags, uint32_t samples, PlacementBenchResult* out) {
+    intr_handle_t handle;
+    if (esp_intr_alloc(ETS_INTERNAL_SW0_INTR_SOURCE, flags, handler, NULL, &handle) != ESP_OK) {
+        LOG_ERROR("Placement", "No software interrupt for the benchmark");
+        return false;
+    }
+
+    uint64_t total = 0;
+    memset(out, 0, sizeof(*out));
+    out->min_ns = UINT32_MAX;
+    uint32_t mhz = getCpuFrequencyMhz();
+
+    for (uint32_t i = 0; i < samples; i++) {
+        vTaskDelay(pdMS_TO_TICKS(PLACEMENT_BENCH_GAP_MS));
+        bench_shot.fired = false;
+        uint32_t bit = BENCH_SW_INTR_BIT;
+        uint32_t start = cpu_hal_get_cycle_count();
+        __asm__ __volatile__("wsr %0, intset\n rsync" :: "r"(bit));
+
+        for (uint32_t spin = 0; !bench_shot.fired && spin < BENCH_SPIN_MAX; spin++) {
+        }
+        if (!bench_shot.fired) {
+            continue;
+        }
+        uint32_t ns = (bench_shot.entry - start) * 1000 / mhz;
+        total += ns;
+        out->samples++;
+        if (ns < out->min_ns) {
+            out->min_ns = ns;
+        }
+        if (ns > out->max_ns) {
+            out->max_ns = ns;
+        }
+    }
+    esp_intr_free(handle);
+
+    if (out->samples == 0) {
+        out->min_ns = 0;
+        return false;
+    }
+    out->avg_ns = total / out->samples;
+    return true;
+}
+
+// Pinned so the interrupt, the trigger and both CCOUNT reads are on one core
+static void bench_task_fn(void* arg) {
+    BenchRun* run = (BenchRun*)arg;
+    run->ok = bench_variant(bench_isr_flash, 0, run->samples, run->flash) &&
+              bench_variant(bench_isr_iram, ESP_INTR_FLAG_IRAM, run->samples, run->iram);
+    xSemaphoreGive(run->done);
+    vTaskDelete(NULL);
+}
+
+bool placement_bench_isr(uint32_t samples, PlacementBenchResult* flash, PlacementBenchResult* iram) {
+    placement_check("bench_isr_iram", (const void*)bench_isr_iram, PLACEMENT_IRAM);
+    placement_check("bench_isr_flash", (const void*)bench_isr_flash, PLACEMENT_FLASH);
+
+    BenchRun run = {samples, flash, iram, false, xSemaphoreCreateBinary()};
+    if (!run.done) {
+        return false;
+    }
+
+    stress_running = true;
+    xTaskCreatePinnedToCore(stress_task_fn, "place_stress", PLACEMENT_BENCH_STACK, NULL,
+                            tskIDLE_PRIORITY + 1, NULL, !PLACEMENT_BENCH_CORE);
+    if (xTaskCreatePinnedToCore(bench_task_fn, "place_bench", PLACEMENT_BENCH_STACK, &run,
+                                tskIDLE_PRIORITY + 2, NULL, PLACEMENT_BENCH_CORE) != pdPASS) {
+        stress_running = false;
+        vSemaphoreDelete(run.done);
+        return false;
+    }
+    xSemaphoreTake(run.done, portMAX_DELAY);
+    stress_running = false;
+    vSemaphoreDelete(run.done);
+
+    if (run.ok) {
+        LOG_INFOF("Placement", "ISR entry, flash: %lu/%lu/%lu ns, IRAM: %lu/%lu/%lu ns (min/avg/max)",
+                  (unsigned long)flash->min_ns, (unsigned long)flash->avg_ns, (unsigned long)flash->max_ns,
+                  (unsigned long)iram->min_ns, (unsigned long)iram->avg_ns, (unsigned long)iram->max_ns);
+    }
+    return run.ok;
+}
+
+void placement_bench_print(Print& out, const PlacementBenchResult* flash, const PlacementBenchResult* iram) {
+    out.printf("%-8s %8s %8s %8s %8s\n", "handler", "samples", "min ns", "avg ns", "max ns");
+    const PlacementBenchResult* rows[] = {flash, iram};
+    const char* names[] = {"flash", "IRAM"};
+    for (int i = 0; i < 2; i++) {
+        out.printf("%-8s %8lu %8lu %8lu %8lu\n", names[i], (unsigned long)rows[i]->samples,
+                   (unsigned long)rows[i]->min_ns, (unsigned long)rows[i]->avg_ns, (unsigned long)rows[i]->max_ns);
+    }
+}
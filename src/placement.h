@@ -0,0 +1,94 @@
+/**
+ * @file      placement.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Where hot code and data live: IRAM, DRAM or PSRAM, and an ISR latency benchmark
+ */
+
+#ifndef PLACEMENT_H
+#define PLACEMENT_H
+
+/**
+ * Code runs from flash and PSRAM is read through the same cache, so an
+ * interrupt or inner loop that misses waits for an SPI burst, longer still
+ * while the other core streams the framebuffer or a download from PSRAM.
+ *
+ *   PLACE_ISR       interrupt handlers, and everything they call
+ *   PLACE_HOT       per-pixel and per-event loops: packing, rotation, dispatch
+ *   PLACE_HOT_DATA  small const tables those loops index; const data is in
+ *                   flash otherwise
+ *   PLACE_BULK      large static buffers touched rarely; PSRAM when the SDK
+ *                   allows .bss there, internal RAM when it does not
+ *
+ * The stock esp32s3_out.ld named in the board JSON already routes .iram1,
+ * .dram1 and .ext_ram.bss input sections, which these attributes emit, so
+ * no linker fragment of our own is needed. IRAM is scarce (the SDK keeps
+ * about 100 KB of it); mark a function only when it runs per interrupt, per
+ * pixel row or per event and the benchmark or a trace shows it missing.
+ *
+ * The attributes also compile on the host, where they are empty.
+ */
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <esp_attr.h>
+
+#define PLACE_ISR                   IRAM_ATTR
+#define PLACE_HOT                   IRAM_ATTR
+#define PLACE_HOT_DATA              DRAM_ATTR
+#define PLACE_BULK                  EXT_RAM_ATTR
+#else
+#define PLACE_ISR
+#define PLACE_HOT
+#define PLACE_HOT_DATA
+#define PLACE_BULK
+#endif
+
+#ifdef ARDUINO
+
+#define PLACEMENT_BENCH_SAMPLES     500
+#define PLACEMENT_BENCH_GAP_MS      2       // Between shots, for the system to run
+#define PLACEMENT_BENCH_STRESS      (128 * 1024)   // PSRAM copied per stress pass
+#define PLACEMENT_BENCH_CORE        1
+#define PLACEMENT_BENCH_STACK       (1024 * 3)
+
+enum PlacementRegion {
+    PLACEMENT_IRAM = 0,
+    PLACEMENT_DRAM,
+    PLACEMENT_PSRAM,
+    PLACEMENT_FLASH,
+};
+
+struct PlacementBenchResult {
+    uint32_t samples;
+    uint32_t min_ns;
+    uint32_t avg_ns;
+    uint32_t max_ns;                // The number that matters for an ISR
+};
+
+/**
+ * @brief Where an address lives
+ */
+PlacementRegion placement_region(const void* addr);
+const char* placement_region_name(PlacementRegion region);
+
+/**
+ * @brief Log a warning if addr is not in the wanted region; true if it is.
+ *        PSRAM is also satisfied by internal RAM, for SDKs without PSRAM .bss
+ */
+bool placement_check(const char* what, const void* addr, PlacementRegion want);
+
+/**
+ * @brief Time software interrupts from the trigger to the first instruction
+ *        of the handler, once with the handler in flash and once in IRAM,
+ *        while the other core copies through PSRAM. Blocks the caller
+ */
+bool placement_bench_isr(uint32_t samples, PlacementBenchResult* flash, PlacementBenchResult* iram);
+
+void placement_bench_print(Print& out, const PlacementBenchResult* flash, const PlacementBenchResult* iram);
+
+#endif // ARDUINO
+
+#endif // PLACEMENT_H
@@ -0,0 +1,80 @@
+/**
+ * @file      plugin_api.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Binary interface between the firmware and plugins loaded from /apps
+ */
+
+#ifndef PLUGIN_API_H
+#define PLUGIN_API_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/**
+ * A plugin is a .tdp file under /apps: a PluginImageHeader, then its code
+ * and literals, its constants, and a relocation table, each section linked
+ * at 0 and padded to 4 bytes. The code runs in place from flash through
+ * the instruction bus and the constants are read through the data bus, so
+ * both are fixed up once, when the image is copied to flash.
+ *
+ * Writable globals are not supported (data_size and bss_size must be 0):
+ * a plugin keeps its state in memory from api->malloc, which comes from
+ * its own arena. Everything it may call is in the PluginApi it is handed;
+ * it links against nothing in the firmware.
+ */
+
+#define PLUGIN_IMAGE_MAGIC          0x41504454UL  // "TDPA"
+#define PLUGIN_ABI_VERSION          1
+#define PLUGIN_NAME_MAX             16
+
+// A relocation is one word: where the address is stored and what it points
+// into. The stored word holds the target's offset in its section
+#define PLUGIN_RELOC_IN_RODATA      0x80000000UL  // Else in text
+#define PLUGIN_RELOC_TO_RODATA      0x40000000UL  // Else to text
+#define PLUGIN_RELOC_OFFSET_MASK    0x3FFFFFFFUL
+
+struct PluginImageHeader {
+    uint32_t magic;
+    uint16_t abi;
+    uint16_t header_size;           // sizeof(PluginImageHeader)
+    char name[PLUGIN_NAME_MAX];
+    uint32_t text_size;
+    uint32_t rodata_size;
+    uint32_t reloc_count;
+    uint32_t data_size;             // Must be 0
+    uint32_t bss_size;              // Must be 0
+    uint32_t entry;                 // plugin_main, offset into text
+    uint32_t heap_size;             // Arena wanted; 0 for PLUGIN_HEAP_SIZE
+    uint32_t stack_size;            // 0 for PLUGIN_STACK_SIZE
+    uint32_t crc;                   // CRC-32 of everything after the header
+};
+
+typedef struct PluginCtx PluginCtx;
+
+/**
+ * Grows only at the end; a plugin checks size before using a later member
+ */
+typedef struct {
+    uint32_t version;
+    uint32_t size;                  // sizeof(PluginApi) of the firmware
+    void (*log)(PluginCtx *ctx, const char *msg);
+    void *(*malloc)(PluginCtx *ctx, size_t size);
+    void *(*realloc)(PluginCtx *ctx, void *ptr, size_t size);
+    void (*free)(PluginCtx *ctx, void *ptr);
+    size_t (*heap_free)(PluginCtx *ctx);
+    void (*delay_ms)(uint32_t ms);
+    uint32_t (*millis)(void);
+    bool (*should_stop)(PluginCtx *ctx);   // Poll this and return when set
+} PluginApi;
+
+/**
+ * The entry point, in its own task. Returning ends the plugin; its arena
+ * and stack are then freed whatever it left allocated
+ */
+typedef int (*plugin_main_t)(const PluginApi *api, PluginCtx *ctx);
+
+#endif // PLUGIN_API_H
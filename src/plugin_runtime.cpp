@@ -0,0 +1,693 @@
+/**
+ * @file      plugin_runtime.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Plugins installed from /apps into the apps partition and run in place from flash
+ */
+
+#include "plugin_runtime.h"
+#include "simple_logger.h"
+#include "config/os_config.h"
+#include "sd_manager.h"
+#include "spi_bus.h"
+#include <SD.h>
+#include <esp_partition.h>
+#include <esp_heap_caps.h>
+#include <esp_rom_crc.h>
+#include <esp_timer.h>
+#include <multi_heap.h>
+
+#define PLUGIN_INDEX_MAGIC          0x58444950UL  // "PIDX"
+#define PLUGIN_READ_PIECE           4096          // SD reads per bus hold
+#define PLUGIN_STACK_MIN            4096
+#define PLUGIN_STACK_MAX            (64 * 1024)
+
+struct PluginIndexEntry {
+    char file[PLUGIN_FILE_MAX];
+    uint32_t file_size;             // Of the SD file it came from, to spot a new one
+    uint32_t file_time;
+    uint8_t used;
+    uint8_t reserved[3];
+};
+
+struct PluginIndex {
+    uint32_t magic;
+    uint32_t seq;                   // Higher wins; picks the sector it goes to
+    uint32_t ibase;                 // Mapping the slots are relocated for
+    uint32_t dbase;
+    PluginIndexEntry entries[MAX_PLUGINS];    // Entry i is slot i
+    uint32_t crc;
+};
+
+static_assert(sizeof(PluginIndex) <= SPI_FLASH_SEC_SIZE, "Index fits a sector");
+static_assert(PLUGIN_INDEX_SECTORS * SPI_FLASH_SEC_SIZE <= PLUGIN_SLOTS_OFFSET, "Index ends before the slots");
+
+enum {
+    RUN_IDLE = 0,
+    RUN_RUNNING,
+    RUN_EXITED,                     // Returned, suspended until reaped
+    RUN_DELETED,                    // Memory freed at the next pass, after the idle task
+    RUN_INSTALLING,
+};
+
+struct PluginCtx {
+    uint8_t slot;
+    multi_heap_handle_t heap;
+    volatile bool stop;
+    volatile uint8_t in_api;        // Not deleted inside a firmware call
+};
+
+typedef struct {
+    PluginCtx ctx;
+    TaskHandle_t task;
+    StaticTask_t tcb;
+    uint8_t *stack;
+    uint8_t *arena;
+    volatile uint8_t state;
+    int exit_code;
+    uint32_t stop_ms;               // When stop was asked
+} plugin_run_t;
+
+static const esp_partition_t *apps_part = NULL;
+static const uint8_t *apps_i = NULL;    // Instruction bus view of the partition
+static const uint8_t *apps_d = NULL;    // Data bus view
+static spi_flash_mmap_handle_t apps_i_map, apps_d_map;
+
+static TaskHandle_t runtime_task_handle = NULL;
+static SemaphoreHandle_t plugin_lock = NULL;    // Index and flash
+static portMUX_TYPE plugin_mux = portMUX_INITIALIZER_UNLOCKED;
+static volatile bool scan_req = false;
+static PluginIndex plugin_index;
+static plugin_run_t runs[MAX_PLUGINS];
+static plugin_stats_t plugin_stats;
+
+static uint32_t slot_offset(int slot) {
+    return PLUGIN_SLOTS_OFFSET + slot * PLUGIN_SLOT_SIZE;
+}
+
+static const PluginImageHeader *slot_header(int slot) {
+    return (const PluginImageHeader *)(apps_d + slot_offset(slot));
+}
+
+static uint32_t slot_text_i(int slot) {
+    return (uint32_t)(apps_i + slot_offset(slot) + sizeof(PluginImageHeader));
+}
+
+static uint32_t slot_rodata_d(int slot, const PluginImageHeader *h) {
+    return (uint32_t)(apps_d + slot_offset(slot) + sizeof(PluginImageHeader) + h->text_size);
+}
+
+static uint32_t image_body_size(const PluginImageHeader *h) {
+    return h->text_size + h->rodata_size + h->reloc_count * 4;
+}
+
+static bool slot_valid(int slot) {
+    const PluginImageHeader *h = slot_header(slot);
+    return plugin_index.entries[slot].used && h->magic == PLUGIN_IMAGE_MAGIC && h->abi == PLUGIN_ABI_VERSION;
+}
+
+// -------------------------------------------------------------------- Index
+
+static uint32_t index_crc(const PluginIndex *idx) {
+    return esp_rom_crc32_le(0, (const uint8_t *)idx, offsetof(PluginIndex, crc));
+}
+
+static void load_index() {
+    const PluginIndex *best = NULL;
+    for (int i = 0; i < PLUGIN_INDEX_SECTORS; i++) {
+        const PluginIndex *idx = (const PluginIndex *)(apps_d + i * SPI_FLASH_SEC_SIZE);
+        if (idx->magic == PLUGIN_INDEX_MAGIC && idx->crc == index_crc(idx) && (!best || idx->seq > best->seq)) {
+            best = idx;
+        }
+    }
+    if (best) {
+        plugin_index = *best;
+    } else {
+        memset(&plugin_index, 0, sizeof(plugin_index));
+        plugin_index.magic = PLUGIN_INDEX_MAGIC;
+    }
+}
+
+// Under plugin_lock. Into the other sector, so a cut leaves the last index
+static bool write_index() {
+    plugin_index.seq++;
+    plugin_index.crc = index_crc(&plugin_index);
+    uint32_t off = (plugin_index.seq % PLUGIN_INDEX_SECTORS) * SPI_FLASH_SEC_SIZE;
+    if (esp_partition_erase_range(apps_part, off, SPI_FLASH_SEC_SIZE) != ESP_OK ||
+        esp_partition_write(apps_part, off, &plugin_index, sizeof(plugin_index)) != ESP_OK) {
+        LOG_ERROR("Plugin", "Failed to write the index");
+        return false;
+    }
+    return true;
+}
+
+// --------------------------------------------------------------- Relocation
+
+// Adds di to the words that point into text and dd to those pointing into
+// rodata. body is text, rodata and the relocations, as in the slot
+static bool relocate(uint8_t *body, const PluginImageHeader *h, uint32_t di, uint32_t dd) {
+    const uint32_t *relocs = (const uint32_t *)(body + h->text_size + h->rodata_size);
+    for (uint32_t i = 0; i < h->reloc_count; i++) {
+        uint32_t r = relocs[i];
+        uint32_t off = r & PLUGIN_RELOC_OFFSET_MASK;
+        bool in_rodata = r & PLUGIN_RELOC_IN_RODATA;
+        uint32_t limit = in_rodata ? h->rodata_size : h->text_size;
+        if ((off & 3) || off + 4 > limit) {
+            return false;
+        }
+        uint32_t *word = (uint32_t *)(body + (in_rodata ? h->text_size : 0) + off);
+        *word += (r & PLUGIN_RELOC_TO_RODATA) ? dd : di;
+    }
+    return true;
+}
+
+static bool write_slot(int slot, const uint8_t *image, uint32_t len) {
+    return esp_partition_erase_range(apps_part, slot_offset(slot), PLUGIN_SLOT_SIZE) == ESP_OK &&
+           esp_partition_write(apps_part, slot_offset(slot), image, len) == ESP_OK;
+}
+
+// The mapping moved since the slots were written: shift every address by as much
+static void rebase(uint32_t ibase, uint32_t dbase) {
+    uint32_t di = ibase - plugin_index.ibase;
+    uint32_t dd = dbase - plugin_index.dbase;
+    for (int slot = 0; slot < MAX_PLUGINS; slot++) {
+        if (!slot_valid(slot)) {
+            plugin_index.entries[slot].used = 0;
+            continue;
+        }
+        const PluginImageHeader *h = slot_header(slot);
+        uint32_t len = sizeof(PluginImageHeader) + image_body_size(h);
+        uint8_t *image = (uint8_t *)ps_malloc(len);
+        if (!image) {
+            plugin_index.entries[slot].used = 0;
+            continue;
+        }
+        memcpy(image, h, len);
+        PluginImageHeader *hdr = (PluginImageHeader *)image;
+        if (!relocate(image + sizeof(PluginImageHeader), hdr, di, dd) || !write_slot(slot, image, len)) {
+            plugin_index.entries[slot].used = 0;
+        }
+        free(image);
+        plugin_stats.rebases++;
+    }
+    plugin_index.ibase = ibase;
+    plugin_index.dbase = dbase;
+    write_index();
+}
+
+// ------------------------------------------------------------------ Install
+
+static bool read_file(File &f, uint8_t *buf, uint32_t len) {
+    uint32_t got = 0;
+    while (got < len) {
+        uint32_t n = len - got < PLUGIN_READ_PIECE ? len - got : PLUGIN_READ_PIECE;
+        SpiBusHold bus(SPI_CLIENT_SD);
+        if (f.read(buf + got, n) != n) {
+            return false;
+        }
+        got += n;
+    }
+    return true;
+}
+
+static bool check_header(const PluginImageHeader *h, const char *path) {
+    const char *why = NULL;
+    if (h->magic != PLUGIN_IMAGE_MAGIC || h->header_size != sizeof(PluginImageHeader)) {
+        why = "not a plugin image";
+    } else if (h->abi != PLUGIN_ABI_VERSION) {
+        why = "built for another ABI";
+    } else if (h->data_size || h->bss_size) {
+        why = "has writable globals";
+    } else if ((h->text_size & 3) || (h->rodata_size & 3) || h->entry >= h->text_size) {
+        why = "bad section layout";
+    } else if (sizeof(PluginImageHeader) + image_body_size(h) > PLUGIN_SLOT_SIZE) {
+        why = "too large for a slot";
+    }
+    if (why) {
+        LOG_WARNF("Plugin", "%s: %s", path, why);
+    }
+    return !why;
+}
+
+// Runtime task, slot marked RUN_INSTALLING
+static bool install(int slot, const char *path) {
+    File f;
+    {
+        SpiBusHold bus(SPI_CLIENT_SD);
+        f = SD.open(path, FILE_READ);
+    }
+    if (!f) {
+        return false;
+    }
+    PluginImageHeader h;
+    uint8_t *image = NULL;
+    bool ok = read_file(f, (uint8_t *)&h, sizeof(h)) && check_header(&h, path);
+    uint32_t len = sizeof(h) + image_body_size(&h);
+    if (ok) {
+        image = (uint8_t *)ps_malloc(len);
+        ok = image && read_file(f, image + sizeof(h), len - sizeof(h));
+    }
+    {
+        SpiBusHold bus(SPI_CLIENT_SD);
+        f.close();
+    }
+    if (ok && esp_rom_crc32_le(0, image + sizeof(h), len - sizeof(h)) != h.crc) {
+        LOG_WARNF("Plugin", "%s: CRC mismatch", path);
+        ok = false;
+    }
+    if (ok) {
+        // Sections were linked at 0; they land at the slot's mapped addresses
+        memcpy(image, &h, sizeof(h));
+        ok = relocate(image + sizeof(h), &h, slot_text_i(slot), slot_rodata_d(slot, &h)) &&
+             write_slot(slot, image, len);
+    }
+    free(image);
+    return ok;
+}
+
+static int find_file(const char *file) {
+    for (int i = 0; i < MAX_PLUGINS; i++) {
+        if (plugin_index.entries[i].used && !strcmp(plugin_index.entries[i].file, file)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static int free_slot() {
+    for (int i = 0; i < MAX_PLUGINS; i++) {
+        if (!plugin_index.entries[i].used && runs[i].state == RUN_IDLE) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+typedef struct {
+    char file[PLUGIN_FILE_MAX];
+    uint32_t size;
+    uint32_t time;
+} app_file_t;
+
+static int list_apps(app_file_t *out, int max) {
+    SpiBusHold bus(SPI_CLIENT_SD);
+    File dir = SD.open(SD_APPS_PATH);
+    if (!dir || !dir.isDirectory()) {
+        return 0;
+    }
+    int n = 0;
+    size_t ext = strlen(PLUGIN_FILE_EXT);
+    for (File f = dir.openNextFile(); f && n < max; f = dir.openNextFile()) {
+        const char *name = strrchr(f.name(), '/');
+        name = name ? name + 1 : f.name();
+        size_t len = strlen(name);
+        if (f.isDirectory() || len <= ext || len >= PLUGIN_FILE_MAX || strcmp(name + len - ext, PLUGIN_FILE_EXT)) {
+            continue;
+        }
+        strcpy(out[n].file, name);
+        out[n].size = f.size();
+        out[n].time = (uint32_t)f.getLastWrite();
+        n++;
+    }
+    return n;
+}
+
+// Only new or changed files are read
+static void scan() {
+    if (!sd_manager_mounted()) {
+        return;
+    }
+    uint32_t start = millis();
+    app_file_t files[MAX_PLUGINS];
+    int n = list_apps(files, MAX_PLUGINS);
+
+    for (int i = 0; i < n; i++) {
+        xSemaphoreTake(plugin_lock, portMAX_DELAY);
+        int slot = find_file(files[i].file);
+        const PluginIndexEntry *e = slot >= 0 ? &plugin_index.entries[slot] : NULL;
+        if (e && e->file_size == files[i].size && e->file_time == files[i].time) {
+            xSemaphoreGive(plugin_lock);
+            continue;
+        }
+        if (slot < 0) {
+            slot = free_slot();
+        }
+        bool idle = slot >= 0 && runs[slot].state == RUN_IDLE;
+        if (idle) {
+            runs[slot].state = RUN_INSTALLING;
+            plugin_index.entries[slot].used = 0;    // Until the new image is in
+        }
+        xSemaphoreGive(plugin_lock);
+        if (!idle) {
+            // Full, or the old version is running: next scan
+            continue;
+        }
+
+        // RUN_INSTALLING keeps launches off the slot while it is written
+        char path[sizeof(SD_APPS_PATH) + PLUGIN_FILE_MAX + 1];
+        snprintf(path, sizeof(path), "%s/%s", SD_APPS_PATH, files[i].file);
+        bool ok = install(slot, path);
+        xSemaphoreTake(plugin_lock, portMAX_DELAY);
+        PluginIndexEntry *entry = &plugin_index.entries[slot];
+        if (ok) {
+            memset(entry, 0, sizeof(*entry));
+            strcpy(entry->file, files[i].file);
+            entry->file_size = files[i].size;
+            entry->file_time = files[i].time;
+            entry->used = 1;
+            plugin_stats.installs++;
+            LOG_INFOF("Plugin", "Installed %.*s from %s in slot %d", PLUGIN_NAME_MAX, slot_header(slot)->name,
+                      files[i].file, slot);
+        } else {
+            plugin_stats.install_fails++;
+        }
+        write_index();
+        runs[slot].state = RUN_IDLE;
+        xSemaphoreGive(plugin_lock);
+    }
+    plugin_stats.scan_ms_last = millis() - start;
+}
+
+// ---------------------------------------------------------------------- API
+
+#define API_ENTER(ctx)  ((ctx)->in_api++)
+#define API_EXIT(ctx)   ((ctx)->in_api--)
+
+static void api_log(PluginCtx *ctx, const char *msg) {
+    API_ENTER(ctx);
+    LOG_INFOF("Plugin", "%.*s: %s", PLUGIN_NAME_MAX, slot_header(ctx->slot)->name, msg);
+    API_EXIT(ctx);
+}
+
+static void *api_malloc(PluginCtx *ctx, size_t size) {
+    API_ENTER(ctx);
+    void *p = multi_heap_malloc(ctx->heap, size);
+    API_EXIT(ctx);
+    return p;
+}
+
+static void *api_realloc(PluginCtx *ctx, void *ptr, size_t size) {
+    API_ENTER(ctx);
+    void *p = multi_heap_realloc(ctx->heap, ptr, size);
+    API_EXIT(ctx);
+    return p;
+}
+
+static void api_free(PluginCtx *ctx, void *ptr) {
+    API_ENTER(ctx);
+    multi_heap_free(ctx->heap, ptr);
+    API_EXIT(ctx);
+}
+
+static size_t api_heap_free(PluginCtx *ctx) {
+    return multi_heap_free_size(ctx->heap);
+}
+
+static void api_delay_ms(uint32_t ms) {
+    vTaskDelay(pdMS_TO_TICKS(ms));
+}
+
+static uint32_t api_millis(void) {
+    return millis();
+}
+
+static bool api_should_stop(PluginCtx *ctx) {
+    return ctx->stop;
+}
+
+static const PluginApi plugin_api = {
+    PLUGIN_ABI_VERSION,
+    sizeof(PluginApi),
+    api_log,
+    api_malloc,
+    api_realloc,
+    api_free,
+    api_heap_free,
+    api_delay_ms,
+    api_millis,
+    api_should_stop,
+};
+
+// ------------------------------------------------------------------ Running
+
+static void plugin_task(void *param) {
+    plugin_run_t *run = (plugin_run_t *)param;
+    int slot = run->ctx.slot;
+    plugin_main_t entry = (plugin_main_t)(slot_text_i(slot) + slot_header(slot)->entry);
+    int rc = entry(&plugin_api, &run->ctx);
+
+    portENTER_CRITICAL(&plugin_mux);
+    run->exit_code = rc;
+    run->state = RUN_EXITED;
+    portEXIT_CRITICAL(&plugin_mux);
+    xTaskNotifyGive(runtime_task_handle);
+    // The runtime task deletes us, so the stack is not in use when it is freed
+    vTaskSuspend(NULL);
+}
+
+// Runtime task. A deleted task's TCB is ours and may still be on the idle
+// task's cleanup list, so the slot is only reused a pass later
+static void reap() {
+    uint32_t now = millis();
+    for (int i = 0; i < MAX_PLUGINS; i++) {
+        plugin_run_t *run = &runs[i];
+        switch (run->state) {
+        case RUN_EXITED:
+            vTaskDelete(run->task);
+            run->state = RUN_DELETED;
+            LOG_INFOF("Plugin", "%.*s exited with %d", PLUGIN_NAME_MAX, slot_header(i)->name, run->exit_code);
+            break;
+        case RUN_RUNNING:
+            if (run->ctx.stop && now - run->stop_ms >= PLUGIN_STOP_TIMEOUT_MS && !run->ctx.in_api) {
+                vTaskDelete(run->task);
+                run->exit_code = -1;
+                run->state = RUN_DELETED;
+                plugin_stats.killed++;
+                LOG_WARNF("Plugin", "%.*s did not stop, deleted", PLUGIN_NAME_MAX, slot_header(i)->name);
+            }
+            break;
+        case RUN_DELETED:
+            free(run->stack);
+            free(run->arena);
+            run->stack = NULL;
+            run->arena = NULL;
+            run->task = NULL;
+            run->stop_ms = 0;
+            run->state = RUN_IDLE;
+            break;
+        }
+    }
+}
+
+static void runtime_task(void *param) {
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(PLUGIN_REAP_MS));
+        if (scan_req) {
+            scan_req = false;
+            scan();
+        }
+        reap();
+    }
+}
+
+static void fill_info(int slot, plugin_info_t *info) {
+    const PluginImageHeader *h = slot_header(slot);
+    memset(info, 0, sizeof(*info));
+    memcpy(info->name, h->name, PLUGIN_NAME_MAX);
+    info->name[PLUGIN_NAME_MAX - 1] = '\0';
+    strcpy(info->file, plugin_index.entries[slot].file);
+    info->code_size = h->text_size + h->rodata_size;
+    info->heap_size = h->heap_size ? MIN(h->heap_size, (uint32_t)PLUGIN_HEAP_MAX) : PLUGIN_HEAP_SIZE;
+    info->stack_size = h->stack_size ? CLAMP(h->stack_size, (uint32_t)PLUGIN_STACK_MIN, (uint32_t)PLUGIN_STACK_MAX)
+                                     : PLUGIN_STACK_SIZE;
+    info->running = runs[slot].state == RUN_RUNNING;
+    info->exit_code = runs[slot].exit_code;
+}
+
+static int find_name(const char *name) {
+    for (int i = 0; i < MAX_PLUGINS; i++) {
+        if (slot_valid(i) && !strncmp(slot_header(i)->name, name, PLUGIN_NAME_MAX)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// ------------------------------------------------------------------- Public
+
+bool plugin_runtime_begin() {
+    if (runtime_task_handle) {
+        return true;
+    }
+    apps_part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, (esp_partition_subtype_t)PLUGIN_PARTITION_SUBTYPE,
+                                         PLUGIN_PARTITION_LABEL);
+    if (!apps_part || apps_part->size < slot_offset(MAX_PLUGINS)) {
+        LOG_WARN("Plugin", "No apps partition, plugins disabled");
+        return false;
+    }
+    if (esp_partition_mmap(apps_part, 0, apps_part->size, SPI_FLASH_MMAP_INST, (const void **)&apps_i,
+                           &apps_i_map) != ESP_OK ||
+        esp_partition_mmap(apps_part, 0, apps_part->size, SPI_FLASH_MMAP_DATA, (const void **)&apps_d,
+                           &apps_d_map) != ESP_OK) {
+        LOG_ERROR("Plugin", "Failed to map the apps partition");
+        return false;
+    }
+    plugin_lock = xSemaphoreCreateMutex();
+    if (!plugin_lock) {
+        return false;
+    }
+
+    load_index();
+    uint32_t ibase = (uint32_t)apps_i, dbase = (uint32_t)apps_d;
+    if (plugin_index.ibase != ibase || plugin_index.dbase != dbase) {
+        if (plugin_index.seq) {
+            LOG_INFO("Plugin", "Partition mapped elsewhere, relocating the installed plugins");
+        }
+        rebase(ibase, dbase);
+    }
+    for (int i = 0; i < MAX_PLUGINS; i++) {
+        if (slot_valid(i)) {
+            plugin_stats.installed++;
+        }
+    }
+
+    if (xTaskCreate(runtime_task, "plugins", PLUGIN_RUNTIME_STACK, NULL, PLUGIN_TASK_PRIORITY,
+                    &runtime_task_handle) != pdPASS) {
+        LOG_ERROR("Plugin", "Failed to start the runtime task");
+        return false;
+    }
+    sd_manager_add_client("Plugins", plugin_rescan, NULL);
+    plugin_rescan();    // The card may have been mounted before we registered
+    LOG_INFOF("Plugin", "%u plugins installed", plugin_stats.installed);
+    return true;
+}
+
+void plugin_rescan() {
+    if (!runtime_task_handle) {
+        return;
+    }
+    scan_req = true;
+    xTaskNotifyGive(runtime_task_handle);
+}
+
+int plugin_count() {
+    int n = 0;
+    for (int i = 0; apps_part && i < MAX_PLUGINS; i++) {
+        if (slot_valid(i)) {
+            n++;
+        }
+    }
+    return n;
+}
+
+bool plugin_info(int index, plugin_info_t *info) {
+    for (int i = 0; apps_part && i < MAX_PLUGINS; i++) {
+        if (!slot_valid(i) || index--) {
+            continue;
+        }
+        fill_info(i, info);
+        return true;
+    }
+    return false;
+}
+
+uint32_t plugin_generation() {
+    return apps_part ? plugin_index.seq : 0;
+}
+
+bool plugin_launch(const char *name) {
+    if (!plugin_lock) {
+        return false;
+    }
+    int64_t start = esp_timer_get_time();
+    xSemaphoreTake(plugin_lock, portMAX_DELAY);
+    int slot = find_name(name);
+    plugin_info_t info;
+    if (slot < 0 || runs[slot].state != RUN_IDLE) {
+        xSemaphoreGive(plugin_lock);
+        return false;
+    }
+    plugin_run_t *run = &runs[slot];
+    fill_info(slot, &info);
+
+    // Both from PSRAM: a plugin never takes internal RAM
+    run->arena = (uint8_t *)heap_caps_malloc(info.heap_size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    run->stack = (uint8_t *)heap_caps_malloc(info.stack_size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    run->ctx.heap = run->arena ? multi_heap_register(run->arena, info.heap_size) : NULL;
+    run->ctx.slot = slot;
+    run->ctx.stop = false;
+    run->ctx.in_api = 0;
+    run->stop_ms = 0;
+    run->exit_code = 0;
+    run->task = NULL;
+    if (run->ctx.heap && run->stack) {
+        run->state = RUN_RUNNING;
+        run->task = xTaskCreateStaticPinnedToCore(plugin_task, info.name, info.stack_size, run, PLUGIN_TASK_PRIORITY,
+                                                  (StackType_t *)run->stack, &run->tcb, tskNO_AFFINITY);
+    }
+    if (!run->task) {
+        free(run->arena);
+        free(run->stack);
+        run->arena = NULL;
+        run->stack = NULL;
+        run->state = RUN_IDLE;
+        xSemaphoreGive(plugin_lock);
+        LOG_WARNF("Plugin", "Not enough PSRAM to start %s", name);
+        return false;
+    }
+    uint32_t us = esp_timer_get_time() - start;
+    plugin_stats.launches++;
+    plugin_stats.launch_us_last = us;
+    if (us > plugin_stats.launch_us_max) {
+        plugin_stats.launch_us_max = us;
+    }
+    xSemaphoreGive(plugin_lock);
+    LOG_INFOF("Plugin", "Started %s in %lu us", name, (unsigned long)us);
+    return true;
+}
+
+bool plugin_running(const char *name) {
+    int slot = apps_part ? find_name(name) : -1;
+    return slot >= 0 && runs[slot].state == RUN_RUNNING;
+}
+
+bool plugin_stop(const char *name) {
+    int slot = apps_part ? find_name(name) : -1;
+    if (slot < 0 || runs[slot].state != RUN_RUNNING) {
+        return false;
+    }
+    if (!runs[slot].ctx.stop) {
+        runs[slot].stop_ms = millis();
+        runs[slot].ctx.stop = true;
+    }
+    return true;
+}
+
+bool plugin_uninstall(const char *name) {
+    if (!plugin_lock) {
+        return false;
+    }
+    xSemaphoreTake(plugin_lock, portMAX_DELAY);
+    int slot = find_name(name);
+    bool ok = slot >= 0 && runs[slot].state == RUN_IDLE;
+    if (ok) {
+        // The slot is erased when it is next installed into
+        plugin_index.entries[slot].used = 0;
+        ok = write_index();
+    }
+    xSemaphoreGive(plugin_lock);
+    return ok;
+}
+
+void plugin_get_stats(plugin_stats_t *stats) {
+    *stats = plugin_stats;
+    stats->installed = plugin_count();
+    stats->running = 0;
+    for (int i = 0; i < MAX_PLUGINS; i++) {
+        if (runs[i].state == RUN_RUNNING) {
+            stats->running++;
+        }
+    }
+}
@@ -0,0 +1,97 @@
+/**
+ * @file      plugin_runtime.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Plugins installed from /apps into the apps partition and run in place from flash
+ */
+
+#ifndef PLUGIN_RUNTIME_H
+#define PLUGIN_RUNTIME_H
+
+#include <Arduino.h>
+#include "plugin_api.h"
+
+/**
+ * Images are copied from SD_APPS_PATH into fixed slots of the "apps" flash
+ * partition once, relocated for the partition's mapping on the way, and
+ * found again at boot through an index in the partition's first sectors,
+ * without touching the card. The whole partition stays mapped, code
+ * through the instruction bus and constants through the data bus, so a
+ * launch is an arena, a stack and a task: nothing is read or copied.
+ *
+ * /apps is only read when a card is mounted (an sd_manager client) or on
+ * plugin_rescan(), and only files whose size or date changed are installed
+ * again. Each plugin gets one PSRAM block holding its TLSF heap and another
+ * for its stack, so it cannot grow past them and internal RAM is not used.
+ * The index is written to two sectors in turn, so a power cut while
+ * writing it leaves the previous one.
+ */
+
+#define PLUGIN_PARTITION_LABEL      "apps"
+#define PLUGIN_PARTITION_SUBTYPE    0x40
+#define PLUGIN_INDEX_SECTORS        2
+#define PLUGIN_SLOTS_OFFSET         0x10000     // After the index, on a 64 KB page
+#define PLUGIN_SLOT_SIZE            0x40000     // Header, code, constants and relocations
+#define PLUGIN_FILE_MAX             32          // Name under SD_APPS_PATH
+#define PLUGIN_FILE_EXT             ".tdp"
+#define PLUGIN_TASK_PRIORITY        (tskIDLE_PRIORITY + 1)
+#define PLUGIN_RUNTIME_STACK        (1024 * 4)
+#define PLUGIN_REAP_MS              1000
+#define PLUGIN_STOP_TIMEOUT_MS      3000        // Then the task is deleted and its memory freed
+
+typedef struct {
+    char name[PLUGIN_NAME_MAX];
+    char file[PLUGIN_FILE_MAX];
+    uint32_t code_size;             // Text and constants in flash
+    uint32_t heap_size;
+    uint32_t stack_size;
+    bool running;
+    int exit_code;                  // Of the last run
+} plugin_info_t;
+
+typedef struct {
+    uint8_t installed;
+    uint8_t running;
+    uint32_t installs;
+    uint32_t install_fails;
+    uint32_t rebases;               // Slots rewritten because the mapping moved
+    uint32_t launches;
+    uint32_t launch_us_last;        // plugin_launch() to the task created
+    uint32_t launch_us_max;
+    uint32_t killed;                // Did not stop in time
+    uint32_t scan_ms_last;
+} plugin_stats_t;
+
+/**
+ * @brief Map the partition and load the index. Call after sd_manager_begin()
+ */
+bool plugin_runtime_begin();
+
+/**
+ * @brief Look for new or changed images in /apps, on the runtime's task
+ */
+void plugin_rescan();
+
+int plugin_count();
+bool plugin_info(int index, plugin_info_t *info);
+
+/**
+ * @brief Changes each time a plugin is installed or removed, across reboots
+ */
+uint32_t plugin_generation();
+
+bool plugin_launch(const char *name);
+bool plugin_running(const char *name);
+
+/**
+ * @brief Ask a plugin to return; it is deleted if it has not after
+ *        PLUGIN_STOP_TIMEOUT_MS
+ */
+bool plugin_stop(const char *name);
+bool plugin_uninstall(const char *name);
+
+void plugin_get_stats(plugin_stats_t *stats);
+
+#endif // PLUGIN_RUNTIME_H
@@ -0,0 +1,199 @@
+/**
+ * @file      power_domain.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Reference-counted power rails with settle-time tracking
+ */
+
+#include "power_domain.h"
+#include "simple_logger.h"
+#include "energy_profiler.h"
+#include "utilities.h"
+
+// settle_ms: from the enable edge until the part answers
+static const struct {
+    const char *name;
+    int8_t pin;
+    uint16_t settle_ms;
+} domain_defs[PWR_DOMAIN_COUNT] = {
+    { "gps",  BOARD_GPS_EN,  100 },
+    { "lora", BOARD_LORA_EN, 10  },
+    { "1v8",  BOARD_1V8_EN,  100 },
+    { "6609", BOARD_6609_EN, 50  },
+};
+
+struct DomainState {
+    uint8_t users;
+    uint32_t on_at;                 // millis() of the last switch on
+    uint32_t switches;
+    uint32_t on_ms;                 // Closed stretches
+};
+
+struct DomainUser {
+    const char *name;
+    int8_t domain;
+    int8_t energy;
+    bool held;
+};
+
+static SemaphoreHandle_t domain_lock = nullptr;
+static DomainState domains[PWR_DOMAIN_COUNT];
+static DomainUser domain_users[POWER_DOMAIN_USERS];
+static uint8_t domain_user_count = 0;
+
+static uint32_t settle_left(int d) {
+    if (!domains[d].users) {
+        return 0;
+    }
+    uint32_t since = millis() - domains[d].on_at;
+    return since < domain_defs[d].settle_ms ? domain_defs[d].settle_ms - since : 0;
+}
+
+bool power_domain_begin() {
+    if (domain_lock) {
+        return true;
+    }
+    domain_lock = xSemaphoreCreateMutex();
+    if (!domain_lock) {
+        return false;
+    }
+    // The level is left alone: a rail brought up before this keeps running
+    // until its first user takes it over
+    for (int d = 0; d < PWR_DOMAIN_COUNT; d++) {
+        pinMode(domain_defs[d].pin, OUTPUT);
+    }
+    return true;
+}
+
+int power_domain_user(PowerDomain domain, const char *name, int energy) {
+    if (domain >= PWR_DOMAIN_COUNT || !power_domain_begin()) {
+        return -1;
+    }
+    xSemaphoreTake(domain_lock, portMAX_DELAY);
+    int user = -1;
+    for (int i = 0; i < domain_user_count; i++) {
+        if (domain_users[i].domain == domain && !strcmp(domain_users[i].name, name)) {
+            user = i;
+            break;
+        }
+    }
+    if (user < 0 && domain_user_count < POWER_DOMAIN_USERS) {
+        user = domain_user_count++;
+        domain_users[user] = { name, (int8_t)domain, (int8_t)energy, false };
+    }
+    xSemaphoreGive(domain_lock);
+    if (user < 0) {
+        LOG_ERRORF("Power", "No room for rail user %s", name);
+    }
+    return user;
+}
+
+uint32_t power_domain_acquire(int user) {
+    if (user < 0 || user >= domain_user_count) {
+        return 0;
+    }
+    DomainUser *u = &domain_users[user];
+    bool mark = false;
+    xSemaphoreTake(domain_lock, portMAX_DELAY);
+    DomainState *d = &domains[u->domain];
+    if (!u->held) {
+        u->held = true;
+        mark = u->energy >= 0;
+        if (!d->users++) {
+            digitalWrite(domain_defs[u->domain].pin, HIGH);
+            d->on_at = millis();
+            d->switches++;
+            LOG_DEBUGF("Power", "Rail %s on for %s", domain_defs[u->domain].name, u->name);
+        }
+    }
+    uint32_t left = settle_left(u->domain);
+    xSemaphoreGive(domain_lock);
+    if (mark) {
+        energy_mark((EnergySubsystem)u->energy, true);
+    }
+    return left;
+}
+
+void power_domain_release(int user) {
+    if (user < 0 || user >= domain_user_count) {
+        return;
+    }
+    DomainUser *u = &domain_users[user];
+    bool mark = false;
+    xSemaphoreTake(domain_lock, portMAX_DELAY);
+    DomainState *d = &domains[u->domain];
+    if (u->held) {
+        u->held = false;
+        mark = u->energy >= 0;
+        if (!--d->users) {
+            digitalWrite(domain_defs[u->domain].pin, LOW);
+            d->on_ms += millis() - d->on_at;
+            LOG_DEBUGF("Power", "Rail %s off after %s", domain_defs[u->domain].name, u->name);
+        }
+    }
+    xSemaphoreGive(domain_lock);
+    if (mark) {
+        energy_mark((EnergySubsystem)u->energy, false);
+    }
+}
+
+uint32_t power_domain_set(int user, bool on) {
+    if (on) {
+        return power_domain_acquire(user);
+    }
+    power_domain_release(user);
+    return 0;
+}
+
+bool power_domain_wait(PowerDomain domain) {
+    if (domain >= PWR_DOMAIN_COUNT || !domain_lock) {
+        return false;
+    }
+    xSemaphoreTake(domain_lock, portMAX_DELAY);
+    bool on = domains[domain].users;
+    uint32_t left = settle_left(domain);
+    xSemaphoreGive(domain_lock);
+    if (left) {
+        delay(left);
+    }
+    return on;
+}
+
+bool power_domain_is_on(PowerDomain domain) {
+    return domain < PWR_DOMAIN_COUNT && domains[domain].users;
+}
+
+bool power_domain_held(int user) {
+    return user >= 0 && user < domain_user_count && domain_users[user].held;
+}
+
+const char *power_domain_name(PowerDomain domain) {
+    return domain < PWR_DOMAIN_COUNT ? domain_defs[domain].name : "?";
+}
+
+void power_domain_get_stats(PowerDomain domain, PowerDomainStats *stats) {
+    memset(stats, 0, sizeof(*stats));
+    if (domain >= PWR_DOMAIN_COUNT || !domain_lock) {
+        return;
+    }
+    xSemaphoreTake(domain_lock, portMAX_DELAY);
+    const DomainState *d = &domains[domain];
+    stats->users = d->users;
+    stats->on = d->users;
+    stats->settled = d->users && !settle_left(domain);
+    stats->switches = d->switches;
+    stats->on_ms = d->on_ms + (d->users ? millis() - d->on_at : 0);
+    xSemaphoreGive(domain_lock);
+}
+
+void power_domain_log() {
+    for (int d = 0; d < PWR_DOMAIN_COUNT; d++) {
+        PowerDomainStats s;
+        power_domain_get_stats((PowerDomain)d, &s);
+        LOG_INFOF("Power", "Rail %s: %s, %u users, %lu switches, on %lu s", domain_defs[d].name,
+                  s.on ? (s.settled ? "on" : "settling") : "off", s.users, (unsigned long)s.switches,
+                  (unsigned long)(s.on_ms / 1000));
+    }
+}
@@ -0,0 +1,85 @@
+/**
+ * @file      power_domain.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Reference-counted power rails with settle-time tracking
+ */
+
+#ifndef POWER_DOMAIN_H
+#define POWER_DOMAIN_H
+
+#include <Arduino.h>
+
+/**
+ * The switchable rails, each behind one enable pin. A rail can feed more
+ * than one part (6609 powers both the A7682E and the PCM5102A), so parts
+ * never drive the pins: each registers as a user of its rail and acquires
+ * and releases its handle. The rail is on while any user holds it and goes
+ * off with the last release; a user that acquires twice still counts once.
+ *
+ * acquire() returns how long the rail still needs to settle, so a driver
+ * that must talk to its part at once waits that long (power_domain_wait)
+ * and one that is only switching on ahead of time does not. A user can
+ * carry an energy_profiler subsystem, marked on and off with its hold.
+ */
+
+#define POWER_DOMAIN_USERS          12
+
+enum PowerDomain {
+    PWR_DOMAIN_GPS = 0,             // BOARD_GPS_EN: the MIA-M10Q
+    PWR_DOMAIN_LORA,                // BOARD_LORA_EN: the SX1262
+    PWR_DOMAIN_1V8,                 // BOARD_1V8_EN: the BHI260AP
+    PWR_DOMAIN_6609,                // BOARD_6609_EN: A7682E and PCM5102A
+    PWR_DOMAIN_COUNT,
+};
+
+struct PowerDomainStats {
+    uint8_t users;                  // Holding it now
+    bool on;
+    bool settled;
+    uint32_t switches;              // Off to on
+    uint32_t on_ms;                 // Total, the current stretch included
+};
+
+/**
+ * @brief Set the pins up. Early in boot; safe to call again
+ */
+bool power_domain_begin();
+
+/**
+ * @brief Handle for a named user of a rail, the same one for the same name.
+ *        energy is an EnergySubsystem, or -1
+ * @return The handle, -1 if the table is full
+ */
+int power_domain_user(PowerDomain domain, const char *name, int energy = -1);
+
+/**
+ * @brief Hold the rail, switching it on if it was off
+ * @return Milliseconds until it has settled, 0 when it already has
+ */
+uint32_t power_domain_acquire(int user);
+
+/**
+ * @brief Let go of it; the rail goes off when nobody else holds it
+ */
+void power_domain_release(int user);
+
+/**
+ * @brief acquire() or release() by a flag, for on/off settings
+ */
+uint32_t power_domain_set(int user, bool on);
+
+/**
+ * @brief Block until the rail has settled; false if it is off
+ */
+bool power_domain_wait(PowerDomain domain);
+
+bool power_domain_is_on(PowerDomain domain);
+bool power_domain_held(int user);
+const char *power_domain_name(PowerDomain domain);
+void power_domain_get_stats(PowerDomain domain, PowerDomainStats *stats);
+void power_domain_log();
+
+#endif // POWER_DOMAIN_H
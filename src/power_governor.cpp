@@ -0,0 +1,426 @@
+/**
+ * @file      power_governor.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     DFS governor: tick-sampled core load and driver work pick the clock
+ */
+
+#include "power_governor.h"
+#include "simple_logger.h"
+#include "utilities.h"
+#include <esp_pm.h>
+#include <esp_sleep.h>
+#include <esp_timer.h>
+#include <esp_freertos_hooks.h>
+#include <driver/gpio.h>
+#include <driver/uart.h>
+#ifdef INTEGRATION_LAYER_ENABLED
+#include "integration/config_manager.h"
+#endif
+
+#define POWER_GOV_MID_MHZ   160
+
+struct PowerGovLock {
+    esp_pm_lock_handle_t pm;        // NULL without CONFIG_PM_ENABLE, the count still steers the governor
+    const char *name;
+    uint16_t depth;
+    bool cpu;                       // Max-frequency lock; otherwise it only blocks light sleep
+};
+
+struct PowerGovSource {
+    const char *name;
+    power_work_fn fn;
+};
+
+static PowerGovLock gov_locks[POWER_GOV_MAX_LOCKS];
+static uint8_t gov_lock_count = 0;
+static PowerGovSource gov_sources[POWER_GOV_MAX_SOURCES];
+static uint8_t gov_source_count = 0;
+static volatile uint8_t gov_holds = 0;
+static portMUX_TYPE gov_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static PowerGovernorStats gov_stat;
+static esp_pm_lock_handle_t gov_own_lock = NULL;
+static bool gov_own_held = false;
+static uint16_t gov_pm_max = 0;
+static bool gov_light_sleep_wanted = false;
+static TaskHandle_t gov_task_handle = NULL;
+static volatile bool gov_running = false;
+static volatile uint32_t gov_ceiling = 240;
+
+// Tick-hook samples: on each core's tick, was anything but its idle task running?
+// Ticks suppressed by light sleep are simply not sampled
+static TaskHandle_t gov_idle[2];
+static volatile uint32_t gov_ticks[2];
+static volatile uint32_t gov_busy[2];
+
+// Light sleep suppresses ticks: a gap between core 0 ticks is time asleep
+#define POWER_GOV_TICK_US   (portTICK_PERIOD_MS * 1000)
+static volatile int64_t gov_tick_us = 0;
+static volatile int64_t gov_awake_since = 0;
+static volatile uint32_t gov_awake_max_ms = 0;
+
+static void IRAM_ATTR sample_core0() {
+    int64_t now = esp_timer_get_time();
+    int64_t gap = now - gov_tick_us;
+    gov_tick_us = now;
+    if (gap > 2 * POWER_GOV_TICK_US) {
+        gov_stat.sleep_us += gap - POWER_GOV_TICK_US;
+        gov_stat.sleeps++;
+        uint32_t awake = (now - gap - gov_awake_since) / 1000;
+        if (awake > gov_awake_max_ms) {
+            gov_awake_max_ms = awake;
+        }
+        gov_awake_since = now;
+    }
+    gov_ticks[0]++;
+    if (xTaskGetCurrentTaskHandleForCPU(0) != gov_idle[0]) {
+        gov_busy[0]++;
+    }
+}
+
+static void IRAM_ATTR sample_core1() {
+    gov_ticks[1]++;
+    if (xTaskGetCurrentTaskHandleForCPU(1) != gov_idle[1]) {
+        gov_busy[1]++;
+    }
+}
+
+static uint16_t level_mhz(uint8_t level) {
+    uint16_t ceiling = gov_ceiling;
+    switch (level) {
+        case POWER_GOV_HIGH:
+            return ceiling;
+        case POWER_GOV_MID:
+            return ceiling < POWER_GOV_MID_MHZ ? ceiling : POWER_GOV_MID_MHZ;
+        default:
+            return ceiling < POWER_GOV_MIN_MHZ ? ceiling : POWER_GOV_MIN_MHZ;
+    }
+}
+
+static bool pm_configure(uint16_t max_mhz, uint16_t min_mhz, bool light_sleep) {
+    esp_pm_config_esp32s3_t cfg;
+    cfg.max_freq_mhz = max_mhz;
+    cfg.min_freq_mhz = max_mhz < min_mhz ? max_mhz : min_mhz;
+    cfg.light_sleep_enable = light_sleep;
+    return esp_pm_configure(&cfg) == ESP_OK;
+}
+
+// With DFS the low level is just "no max lock held", which also lets esp_pm light-sleep;
+// the middle level lowers what the max lock means
+static void apply_level(uint8_t level) {
+    uint16_t mhz = level_mhz(level);
+    if (!gov_stat.pm) {
+        if (getCpuFrequencyMhz() != mhz) {
+            setCpuFrequencyMhz(mhz);
+        }
+        gov_stat.mhz = getCpuFrequencyMhz();
+        return;
+    }
+    
+    uint16_t max_mhz = level == POWER_GOV_MID && !gov_holds ? mhz : level_mhz(POWER_GOV_HIGH);
+    if (max_mhz != gov_pm_max && pm_configure(max_mhz, POWER_GOV_MIN_MHZ, gov_stat.light_sleep)) {
+        gov_pm_max = max_mhz;
+    }
+    bool hold = level != POWER_GOV_LOW;
+    if (hold != gov_own_held) {
+        if (hold) {
+            esp_pm_lock_acquire(gov_own_lock);
+        } else {
+            esp_pm_lock_release(gov_own_lock);
+        }
+        gov_own_held = hold;
+    }
+    gov_stat.mhz = hold ? gov_pm_max : level_mhz(POWER_GOV_LOW);
+}
+
+static uint8_t core_load(int core, uint32_t *last_ticks, uint32_t *last_busy) {
+    uint32_t ticks = gov_ticks[core];
+    uint32_t busy = gov_busy[core];
+    uint32_t dt = ticks - last_ticks[core];
+    uint32_t db = busy - last_busy[core];
+    last_ticks[core] = ticks;
+    last_busy[core] = busy;
+    return dt ? (uint8_t)(db * 100 / dt) : 0;
+}
+
+static void governor_task(void *param) {
+    uint32_t last_ticks[2] = {gov_ticks[0], gov_ticks[1]};
+    uint32_t last_busy[2] = {gov_busy[0], gov_busy[1]};
+    uint32_t last_ms = millis();
+    uint32_t demand_ms = last_ms;       // Last time demand was at or above the current level
+    uint16_t applied_ceiling = gov_ceiling;
+    
+    while (gov_running) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(POWER_GOV_SAMPLE_MS));
+        uint32_t now = millis();
+        gov_stat.time_ms[gov_stat.level] += now - last_ms;
+        last_ms = now;
+    
+        gov_stat.load[0] = core_load(0, last_ticks, last_busy);
+        gov_stat.load[1] = core_load(1, last_ticks, last_busy);
+        uint8_t load = gov_stat.load[0] > gov_stat.load[1] ? gov_stat.load[0] : gov_stat.load[1];
+    
+        uint32_t pending = 0;
+        for (uint8_t i = 0; i < gov_source_count; i++) {
+            pending += gov_sources[i].fn();
+        }
+        gov_stat.pending = pending;
+        gov_stat.holds = gov_holds;
+    
+        uint8_t target = POWER_GOV_LOW;
+        if (gov_holds || pending || load >= POWER_GOV_UP_PERCENT) {
+            target = POWER_GOV_HIGH;
+        } else if (load >= POWER_GOV_MID_PERCENT) {
+            target = POWER_GOV_MID;
+        }
+    
+        // Up at once, down only after the demand has stayed low
+        uint8_t level = gov_stat.level;
+        if (target >= level) {
+            demand_ms = now;
+        }
+        if (target > level || (target < level && now - demand_ms >= POWER_GOV_DOWN_MS)) {
+            level = target;
+        }
+        if (level != gov_stat.level || applied_ceiling != gov_ceiling) {
+            if (level != gov_stat.level) {
+                gov_stat.switches++;
+            }
+            gov_stat.level = level;
+            applied_ceiling = gov_ceiling;
+            gov_stat.ceiling_mhz = applied_ceiling;
+            apply_level(level);
+        }
+    }
+    
+    gov_task_handle = NULL;
+    vTaskDelete(NULL);
+}
+
+// Everything that has work for us raises a line or a UART edge. Levels, since light sleep
+// wakes on GPIO levels only; drivers clear their IRQ lines, so none stays asserted
+static void configure_wake_sources() {
+    gpio_wakeup_enable((gpio_num_t)BOARD_TOUCH_INT, GPIO_INTR_LOW_LEVEL);
+    gpio_wakeup_enable((gpio_num_t)BOARD_KEYBOARD_INT, GPIO_INTR_LOW_LEVEL);
+    gpio_wakeup_enable((gpio_num_t)BOARD_LORA_INT, GPIO_INTR_HIGH_LEVEL);
+    gpio_wakeup_enable((gpio_num_t)BOARD_A7682E_RI, GPIO_INTR_LOW_LEVEL);
+    // The GPS is on UART2, which cannot wake the S3; its RX line can, as a GPIO
+    gpio_wakeup_enable((gpio_num_t)BOARD_GPS_RXD, GPIO_INTR_LOW_LEVEL);
+    esp_sleep_enable_gpio_wakeup();
+    
+    // SerialAT is UART1
+    uart_set_wakeup_threshold(UART_NUM_1, POWER_GOV_UART_WAKE_EDGES);
+    esp_sleep_enable_uart_wakeup(UART_NUM_1);
+}
+
+bool power_governor_begin() {
+    if (gov_running) {
+        return true;
+    }
+    
+    bool enabled = true;
+#ifdef INTEGRATION_LAYER_ENABLED
+    enabled = GET_CONFIG_BOOL("power", "governor", enabled);
+    gov_light_sleep_wanted = GET_CONFIG_BOOL("power", "light_sleep", gov_light_sleep_wanted);
+#endif
+    if (!enabled) {
+        LOG_INFO("Power", "Governor disabled");
+        return false;
+    }
+    
+    // esp_pm refuses light sleep without tickless idle, and everything without CONFIG_PM_ENABLE
+    uint16_t ceiling = gov_ceiling;
+    gov_stat.light_sleep = gov_light_sleep_wanted && pm_configure(ceiling, POWER_GOV_MIN_MHZ, true);
+    if (gov_stat.light_sleep) {
+        configure_wake_sources();
+    }
+    gov_stat.pm = gov_stat.light_sleep || pm_configure(ceiling, POWER_GOV_MIN_MHZ, false);
+    gov_pm_max = gov_stat.pm ? ceiling : 0;
+    if (gov_stat.pm && !gov_own_lock &&
+        esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "governor", &gov_own_lock) != ESP_OK) {
+        gov_stat.pm = false;
+    }
+    
+    gov_idle[0] = xTaskGetIdleTaskHandleForCPU(0);
+    gov_idle[1] = xTaskGetIdleTaskHandleForCPU(1);
+    gov_tick_us = esp_timer_get_time();
+    gov_awake_since = gov_tick_us;
+    esp_register_freertos_tick_hook_for_cpu(sample_core0, 0);
+    esp_register_freertos_tick_hook_for_cpu(sample_core1, 1);
+    
+    // Start high; the first quiet half second brings it down
+    gov_stat.level = POWER_GOV_HIGH;
+    gov_stat.ceiling_mhz = ceiling;
+    apply_level(POWER_GOV_HIGH);
+    
+    gov_running = true;
+    if (xTaskCreate(governor_task, "power_gov", POWER_GOV_TASK_STACK, NULL, POWER_GOV_TASK_PRIORITY,
+                    &gov_task_handle) != pdPASS) {
+        LOG_ERROR("Power", "Failed to start the governor task");
+        gov_running = false;
+        esp_deregister_freertos_tick_hook_for_cpu(sample_core0, 0);
+        esp_deregister_freertos_tick_hook_for_cpu(sample_core1, 1);
+        return false;
+    }
+    LOG_INFOF("Power", "Governor %u-%u MHz via %s%s", level_mhz(POWER_GOV_LOW), ceiling,
+              gov_stat.pm ? "esp_pm" : "setCpuFrequencyMhz", gov_stat.light_sleep ? ", auto light sleep" : "");
+    return true;
+}
+
+void power_governor_end() {
+    if (!gov_running) {
+        return;
+    }
+    gov_running = false;
+    xTaskNotifyGive(gov_task_handle);
+    while (gov_task_handle) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    esp_deregister_freertos_tick_hook_for_cpu(sample_core0, 0);
+    esp_deregister_freertos_tick_hook_for_cpu(sample_core1, 1);
+    
+    // Back to a fixed clock at the ceiling, as SimplePower left it
+    if (gov_stat.pm) {
+        pm_configure(gov_ceiling, gov_ceiling, false);
+        gov_pm_max = gov_ceiling;
+        if (gov_own_held) {
+            esp_pm_lock_release(gov_own_lock);
+            gov_own_held = false;
+        }
+        gov_stat.mhz = gov_ceiling;
+    } else {
+        apply_level(POWER_GOV_HIGH);
+    }
+}
+
+bool power_governor_running() {
+    return gov_running;
+}
+
+void power_governor_set_ceiling(uint32_t mhz) {
+    gov_ceiling = mhz;
+    if (gov_running && gov_task_handle) {
+        xTaskNotifyGive(gov_task_handle);
+    }
+}
+
+static int lock_create(const char *name, bool cpu) {
+    portENTER_CRITICAL(&gov_mux);
+    int id = gov_lock_count < POWER_GOV_MAX_LOCKS ? gov_lock_count++ : -1;
+    portEXIT_CRITICAL(&gov_mux);
+    if (id < 0) {
+        LOG_WARNF("Power", "No lock left for %s", name);
+        return -1;
+    }
+    
+    gov_locks[id].name = name;
+    gov_locks[id].depth = 0;
+    gov_locks[id].cpu = cpu;
+    if (esp_pm_lock_create(cpu ? ESP_PM_CPU_FREQ_MAX : ESP_PM_NO_LIGHT_SLEEP, 0, name, &gov_locks[id].pm) != ESP_OK) {
+        gov_locks[id].pm = NULL;
+    }
+    return id;
+}
+
+int power_governor_lock_create(const char *name) {
+    return lock_create(name, true);
+}
+
+int power_governor_sleep_lock_create(const char *name) {
+    return lock_create(name, false);
+}
+
+void power_governor_acquire(int lock) {
+    if (lock < 0 || lock >= gov_lock_count) {
+        return;
+    }
+    PowerGovLock *l = &gov_locks[lock];
+    if (l->pm) {
+        esp_pm_lock_acquire(l->pm);
+    }
+    portENTER_CRITICAL(&gov_mux);
+    if (l->depth++ == 0 && l->cpu) {
+        gov_holds++;
+    }
+    portEXIT_CRITICAL(&gov_mux);
+    if (!l->cpu) {
+        return;
+    }
+    
+    // Without DFS the clock only moves in the governor task; don't wait a sample for a burst
+    if (!gov_stat.pm && gov_running && gov_stat.level != POWER_GOV_HIGH && gov_task_handle) {
+        xTaskNotifyGive(gov_task_handle);
+    }
+}
+
+void power_governor_release(int lock) {
+    if (lock < 0 || lock >= gov_lock_count) {
+        return;
+    }
+    PowerGovLock *l = &gov_locks[lock];
+    portENTER_CRITICAL(&gov_mux);
+    if (l->depth && --l->depth == 0 && l->cpu) {
+        gov_holds--;
+    }
+    portEXIT_CRITICAL(&gov_mux);
+    if (l->pm) {
+        esp_pm_lock_release(l->pm);
+    }
+}
+
+bool power_governor_add_source(const char *name, power_work_fn fn) {
+    if (!fn) {
+        return false;
+    }
+    portENTER_CRITICAL(&gov_mux);
+    bool ok = gov_source_count < POWER_GOV_MAX_SOURCES;
+    if (ok) {
+        gov_sources[gov_source_count].name = name;
+        gov_sources[gov_source_count].fn = fn;
+        gov_source_count++;
+    }
+    portEXIT_CRITICAL(&gov_mux);
+    return ok;
+}
+
+const PowerGovernorStats *power_governor_stats() {
+    return &gov_stat;
+}
+
+bool power_governor_measure_sleep(uint32_t window_ms, PowerSleepReport *out) {
+    if (!gov_running || !out || !window_ms) {
+        return false;
+    }
+    if (!gov_stat.light_sleep) {
+        LOG_WARN("Power", "Auto light sleep is off (power.light_sleep, tickless idle)");
+    }
+    
+    uint64_t sleep_us = gov_stat.sleep_us;
+    uint32_t sleeps = gov_stat.sleeps;
+    gov_awake_max_ms = 0;
+    gov_awake_since = esp_timer_get_time();
+    uint32_t start = millis();
+    vTaskDelay(pdMS_TO_TICKS(window_ms));
+    
+    memset(out, 0, sizeof(*out));
+    out->window_ms = millis() - start;
+    out->sleep_ms = (gov_stat.sleep_us - sleep_us) / 1000;
+    out->sleeps = gov_stat.sleeps - sleeps;
+    out->sleep_permille = out->window_ms ? (uint64_t)out->sleep_ms * 1000 / out->window_ms : 0;
+    out->avg_sleep_ms = out->sleeps ? out->sleep_ms / out->sleeps : 0;
+    uint32_t tail = (esp_timer_get_time() - gov_awake_since) / 1000;
+    out->longest_awake_ms = gov_awake_max_ms > tail ? gov_awake_max_ms : tail;
+    
+    LOG_INFOF("Power", "Light sleep %u.%u%% of %lums: %lu sleeps, %lums average, longest awake %lums",
+              out->sleep_permille / 10, out->sleep_permille % 10, (unsigned long)out->window_ms,
+              (unsigned long)out->sleeps, (unsigned long)out->avg_sleep_ms, (unsigned long)out->longest_awake_ms);
+    for (uint8_t i = 0; i < gov_lock_count; i++) {
+        if (gov_locks[i].depth) {
+            LOG_INFOF("Power", "  held: %s (%s)", gov_locks[i].name, gov_locks[i].cpu ? "max clock" : "no sleep");
+        }
+    }
+    return true;
+}
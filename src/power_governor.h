@@ -0,0 +1,98 @@
+/**
+ * @file      power_governor.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Load-aware CPU frequency governor on top of ESP-IDF power management
+ */
+
+#ifndef POWER_GOVERNOR_H
+#define POWER_GOVERNOR_H
+
+#include <Arduino.h>
+
+#define POWER_GOV_SAMPLE_MS         50
+#define POWER_GOV_DOWN_MS           500     // Demand must stay low this long before stepping down
+#define POWER_GOV_UP_PERCENT        70      // Busiest core above this: full speed
+#define POWER_GOV_MID_PERCENT       35      // Above this: middle step
+#define POWER_GOV_MIN_MHZ           80      // Lowest clock that keeps APB, WiFi and SPI at speed
+#define POWER_GOV_MAX_LOCKS         8
+#define POWER_GOV_MAX_SOURCES       6
+#define POWER_GOV_TASK_PRIORITY     (tskIDLE_PRIORITY + 4)
+#define POWER_GOV_TASK_STACK        (1024 * 3)
+#define POWER_GOV_UART_WAKE_EDGES   3       // RX edges that wake the chip; those bytes are lost
+
+enum PowerGovLevel {
+    POWER_GOV_LOW,
+    POWER_GOV_MID,
+    POWER_GOV_HIGH,
+    POWER_GOV_LEVELS,
+};
+
+// Work waiting for the CPU; non-zero keeps the clock up
+typedef uint32_t (*power_work_fn)(void);
+
+struct PowerGovernorStats {
+    bool pm;                        // ESP-IDF DFS available; otherwise setCpuFrequencyMhz()
+    bool light_sleep;               // Auto light sleep accepted by esp_pm
+    uint8_t level;                  // PowerGovLevel
+    uint16_t mhz;
+    uint16_t ceiling_mhz;           // From the SimplePower mode
+    uint8_t load[2];                // Per-core busy percent, last window
+    uint8_t holds;                  // Locks currently held by drivers
+    uint32_t pending;               // Sum of the work sources, last window
+    uint32_t switches;
+    uint32_t time_ms[POWER_GOV_LEVELS];
+    uint64_t sleep_us;              // Spent in auto light sleep, from tick gaps on core 0
+    uint32_t sleeps;
+};
+
+struct PowerSleepReport {
+    uint32_t window_ms;
+    uint32_t sleep_ms;
+    uint32_t sleeps;
+    uint16_t sleep_permille;
+    uint32_t avg_sleep_ms;
+    uint32_t longest_awake_ms;      // Worst stretch without sleeping, points at a poller
+};
+
+/**
+ * @brief Configure DFS and start sampling. Reads power.governor/light_sleep
+ */
+bool power_governor_begin();
+void power_governor_end();
+bool power_governor_running();
+
+/**
+ * @brief Highest clock the governor may pick; setPowerMode() lands here while it runs
+ */
+void power_governor_set_ceiling(uint32_t mhz);
+
+/**
+ * @brief A named max-frequency lock for a driver's bursts
+ * @return Lock id, -1 when none are left
+ */
+int power_governor_lock_create(const char *name);
+void power_governor_acquire(int lock);
+void power_governor_release(int lock);
+
+/**
+ * @brief A lock that keeps the chip out of light sleep, for transfers that would lose
+ *        bytes to a UART or GPIO wake. Acquired and released like the max locks
+ */
+int power_governor_sleep_lock_create(const char *name);
+
+/**
+ * @brief Register a pending-work probe, polled from the governor task
+ */
+bool power_governor_add_source(const char *name, power_work_fn fn);
+
+const PowerGovernorStats *power_governor_stats();
+
+/**
+ * @brief Measurement mode: sample sleep for window_ms and log where the time went. Blocks
+ */
+bool power_governor_measure_sleep(uint32_t window_ms, PowerSleepReport *out);
+
+#endif // POWER_GOVERNOR_H
@@ -0,0 +1,21 @@
+/**
+ * @file      power_mode.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Power modes shared by SimplePower and the services it drives
+ */
+
+#ifndef POWER_MODE_H
+#define POWER_MODE_H
+
+// No ESP-IDF includes: the integration layer builds in the simulator too
+enum PowerMode {
+    POWER_HIGH_PERFORMANCE,
+    POWER_BALANCED,
+    POWER_POWER_SAVE,
+    POWER_ULTRA_LOW_POWER
+};
+
+#endif // POWER_MODE_H
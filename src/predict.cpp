@@ -0,0 +1,490 @@
+/**
+ * @file      predict.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Word completion from a flash-resident DAWG and words learned on the device
+ */
+
+#include "predict.h"
+#include <LittleFS.h>
+#include <esp_heap_caps.h>
+#include <esp_rom_crc.h>
+#include <ctype.h>
+#include "simple_logger.h"
+#include "asset_store.h"
+#include "fs_service.h"
+#include "usb_console.h"
+#ifdef INTEGRATION_LAYER_ENABLED
+#include "integration/config_manager.h"
+#endif
+
+#define NODE_WORD       0x80
+#define NODE_EDGES      0x3F
+#define NODE_SIZE       2
+#define EDGE_SIZE       5
+
+// PREDICT_USER_FILE: this header, then count x UserWord
+struct UserFileHeader {
+    uint32_t magic;
+    uint32_t count;
+    uint32_t crc;                   // Of the entries
+};
+
+struct UserWord {
+    char word[PREDICT_WORD_MAX];    // Empty if the slot is free
+    uint16_t count;
+    uint16_t reserved;
+    uint32_t stamp;                 // Learn clock at the last use
+};
+
+struct Walk {
+    PredictCandidate *out;
+    int max;
+    int n;
+    int prefix_len;
+    uint32_t visits;
+    char word[PREDICT_WORD_MAX];
+};
+
+static const uint8_t *dict = nullptr;       // Flash mapping
+static uint32_t dict_size = 0;
+static uint32_t dict_root = 0;
+static UserWord *user = nullptr;            // PREDICT_USER_MAX, PSRAM
+static uint8_t *save_buf = nullptr;
+static uint32_t learn_clock = 0;
+static bool learn_enabled = true;
+static bool saving = false;
+static bool save_again = false;
+static PredictStats predict_stats;
+static portMUX_TYPE predict_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// ===== Candidates =====
+
+// Keeps out best first; a word already there only moves up
+static void offer(Walk *w, const char *word, uint16_t score, bool learned) {
+    for (int i = 0; i < w->n; i++) {
+        if (strcmp(w->out[i].word, word)) {
+            continue;
+        }
+        if (score <= w->out[i].score) {
+            return;
+        }
+        memmove(&w->out[i], &w->out[i + 1], (w->n - i - 1) * sizeof(PredictCandidate));
+        w->n--;
+        break;
+    }
+    if (w->n == w->max && score <= w->out[w->n - 1].score) {
+        return;
+    }
+    int i = w->n < w->max ? w->n++ : w->max - 1;
+    // Equal scores keep the order found
+    for (; i > 0 && w->out[i - 1].score < score; i--) {
+        w->out[i] = w->out[i - 1];
+    }
+    strlcpy(w->out[i].word, word, PREDICT_WORD_MAX);
+    w->out[i].score = score;
+    w->out[i].learned = learned;
+}
+
+static uint16_t user_score(uint16_t count) {
+    return (PREDICT_USER_RANK + min<uint16_t>(count, PREDICT_RANK_MAX + 1) - 1) * PREDICT_RANK_SCALE;
+}
+
+// ===== Dictionary =====
+
+static uint32_t edge_target(const uint8_t *edge) {
+    return edge[2] | edge[3] << 8 | (uint32_t)edge[4] << 16;
+}
+
+// Edge count, -1 if the node runs off the blob
+static int node_edges(uint32_t off) {
+    if (off < sizeof(PredictDictHeader) || off + NODE_SIZE > dict_size) {
+        return -1;
+    }
+    int n = dict[off] & NODE_EDGES;
+    if (n > PREDICT_EDGES_MAX || off + NODE_SIZE + n * EDGE_SIZE > dict_size) {
+        return -1;
+    }
+    return n;
+}
+
+// Node reached by prefix, 0 if none
+static uint32_t descend(const char *prefix) {
+    uint32_t off = dict_root;
+    for (const char *p = prefix; *p; p++) {
+        int n = node_edges(off);
+        const uint8_t *edge = dict + off + NODE_SIZE;
+        int i = 0;
+        // Edges are in letter order
+        for (; i < n && edge[0] < (uint8_t)*p; i++, edge += EDGE_SIZE) {
+        }
+        if (i >= n || edge[0] != (uint8_t)*p) {
+            return 0;
+        }
+        off = edge_target(edge);
+    }
+    return off;
+}
+
+static void collect(Walk *w, uint32_t off, int depth) {
+    int n = node_edges(off);
+    if (n < 0 || ++w->visits > PREDICT_VISIT_MAX) {
+        return;
+    }
+    const uint8_t *node = dict + off;
+    if ((node[0] & NODE_WORD) && depth > w->prefix_len) {
+        w->word[depth] = '\0';
+        offer(w, w->word, node[1] * PREDICT_RANK_SCALE, false);
+    }
+    if (depth >= PREDICT_WORD_MAX - 1) {
+        return;
+    }
+
+    // Best subtree first, so the rest is more often cut
+    uint8_t order[PREDICT_EDGES_MAX];
+    const uint8_t *edges = node + NODE_SIZE;
+    for (int i = 0; i < n; i++) {
+        int j = i;
+        for (; j > 0 && edges[order[j - 1] * EDGE_SIZE + 1] < edges[i * EDGE_SIZE + 1]; j--) {
+            order[j] = order[j - 1];
+        }
+        order[j] = i;
+    }
+    for (int i = 0; i < n; i++) {
+        const uint8_t *edge = edges + order[i] * EDGE_SIZE;
+        if (w->n == w->max && edge[1] * PREDICT_RANK_SCALE <= w->out[w->max - 1].score) {
+            break;
+        }
+        w->word[depth] = edge[0];
+        collect(w, edge_target(edge), depth + 1);
+    }
+}
+
+static bool dict_map() {
+    uint32_t size = 0;
+    const uint8_t *blob = asset_store_blob(PREDICT_DICT_ASSET, &size);
+    if (!blob || size < sizeof(PredictDictHeader)) {
+        LOG_INFO("Predict", "No dictionary in the asset pack, learned words only");
+        return false;
+    }
+    const PredictDictHeader *head = (const PredictDictHeader *)blob;
+    if (head->magic != PREDICT_DICT_MAGIC || head->version != PREDICT_DICT_VERSION) {
+        LOG_WARN("Predict", "Dictionary blob is not a word list this build reads");
+        return false;
+    }
+    dict = blob;
+    dict_size = size;
+    dict_root = sizeof(PredictDictHeader);
+    predict_stats.dict_words = head->words;
+    predict_stats.dict_bytes = size;
+    return true;
+}
+
+// ===== Learned words =====
+
+static void save_start();
+
+static void save_done(const FsResult *res, void *ctx) {
+    bool again = false;
+    portENTER_CRITICAL(&predict_mux);
+    if (res->ok) {
+        predict_stats.saves++;
+    } else {
+        predict_stats.save_errors++;
+    }
+    again = save_again;
+    save_again = false;
+    saving = again;
+    portEXIT_CRITICAL(&predict_mux);
+    if (again) {
+        save_start();
+    }
+}
+
+static void save_written(const FsResult *res, void *ctx) {
+    // A cut mid-write leaves the old table, never half of the new one
+    if (!res->ok || !fs_rename(LittleFS, PREDICT_USER_TMP, PREDICT_USER_FILE, save_done)) {
+        FsResult failed = *res;
+        failed.ok = false;
+        save_done(&failed, ctx);
+    }
+}
+
+static void save_start() {
+    UserFileHeader *head = (UserFileHeader *)save_buf;
+    UserWord *words = (UserWord *)(save_buf + sizeof(UserFileHeader));
+    uint32_t count = 0;
+    portENTER_CRITICAL(&predict_mux);
+    for (int i = 0; i < PREDICT_USER_MAX; i++) {
+        if (user[i].word[0]) {
+            words[count++] = user[i];
+        }
+    }
+    portEXIT_CRITICAL(&predict_mux);
+    head->magic = PREDICT_USER_MAGIC;
+    head->count = count;
+    head->crc = esp_rom_crc32_le(0, (const uint8_t *)words, count * sizeof(UserWord));
+    if (!fs_write(LittleFS, PREDICT_USER_TMP, save_buf, sizeof(UserFileHeader) + count * sizeof(UserWord),
+                  save_written)) {
+        FsResult failed = {};
+        save_done(&failed, nullptr);
+    }
+}
+
+// One write at a time; changes made meanwhile go in the next
+static void save() {
+    if (!save_buf) {
+        return;
+    }
+    bool start = false;
+    portENTER_CRITICAL(&predict_mux);
+    if (saving) {
+        save_again = true;
+    } else {
+        saving = start = true;
+    }
+    portEXIT_CRITICAL(&predict_mux);
+    if (start) {
+        save_start();
+    }
+}
+
+static void user_load() {
+    File f = LittleFS.open(PREDICT_USER_FILE, FILE_READ);
+    if (!f) {
+        return;
+    }
+    UserFileHeader head;
+    bool ok = f.read((uint8_t *)&head, sizeof(head)) == sizeof(head) && head.magic == PREDICT_USER_MAGIC &&
+              head.count <= PREDICT_USER_MAX;
+    size_t len = ok ? head.count * sizeof(UserWord) : 0;
+    ok = ok && f.read((uint8_t *)user, len) == len && esp_rom_crc32_le(0, (const uint8_t *)user, len) == head.crc;
+    f.close();
+    if (!ok) {
+        memset(user, 0, PREDICT_USER_MAX * sizeof(UserWord));
+        LOG_WARN("Predict", "Learned words are damaged, starting over");
+        return;
+    }
+    for (uint32_t i = 0; i < head.count; i++) {
+        user[i].word[PREDICT_WORD_MAX - 1] = '\0';
+        learn_clock = max(learn_clock, user[i].stamp);
+    }
+    predict_stats.user_words = head.count;
+}
+
+static void learn_word(const char *word) {
+    int slot = -1;
+    int victim = 0;
+    portENTER_CRITICAL(&predict_mux);
+    for (int i = 0; i < PREDICT_USER_MAX; i++) {
+        if (!user[i].word[0]) {
+            if (slot < 0) {
+                slot = i;
+            }
+            continue;
+        }
+        if (!strcmp(user[i].word, word)) {
+            if (user[i].count < UINT16_MAX) {
+                user[i].count++;
+            }
+            user[i].stamp = ++learn_clock;
+            predict_stats.learned++;
+            portEXIT_CRITICAL(&predict_mux);
+            return;
+        }
+        // Least used goes first, the longest unused of those
+        if (user[i].count < user[victim].count ||
+            (user[i].count == user[victim].count && user[i].stamp < user[victim].stamp)) {
+            victim = i;
+        }
+    }
+    if (slot < 0) {
+        slot = victim;
+    } else {
+        predict_stats.user_words++;
+    }
+    strlcpy(user[slot].word, word, PREDICT_WORD_MAX);
+    user[slot].count = 1;
+    user[slot].stamp = ++learn_clock;
+    predict_stats.learned++;
+    portEXIT_CRITICAL(&predict_mux);
+}
+
+// ===== API =====
+
+int predict_complete(const char *prefix, PredictCandidate *out, int max) {
+    uint32_t start = micros();
+    Walk w;
+    w.out = out;
+    w.max = min(max, PREDICT_CANDIDATES_MAX);
+    w.n = 0;
+    w.visits = 0;
+    w.prefix_len = strlen(prefix);
+    if (w.prefix_len == 0 || w.prefix_len >= PREDICT_WORD_MAX - 1 || w.max <= 0) {
+        return 0;
+    }
+    for (int i = 0; i < w.prefix_len; i++) {
+        char c = tolower((unsigned char)prefix[i]);
+        if (!islower((unsigned char)c) && c != '\'') {
+            return 0;
+        }
+        w.word[i] = c;
+    }
+    w.word[w.prefix_len] = '\0';
+
+    if (dict) {
+        uint32_t node = descend(w.word);
+        if (node) {
+            collect(&w, node, w.prefix_len);
+        }
+    }
+
+    if (user) {
+        char word[PREDICT_WORD_MAX];
+        portENTER_CRITICAL(&predict_mux);
+        for (int i = 0; i < PREDICT_USER_MAX; i++) {
+            if (user[i].word[0] && !strncmp(user[i].word, w.word, w.prefix_len) && user[i].word[w.prefix_len]) {
+                memcpy(word, user[i].word, PREDICT_WORD_MAX);
+                offer(&w, word, user_score(user[i].count), true);
+            }
+        }
+        portEXIT_CRITICAL(&predict_mux);
+    }
+
+    if (isupper((unsigned char)prefix[0])) {
+        for (int i = 0; i < w.n; i++) {
+            out[i].word[0] = toupper((unsigned char)out[i].word[0]);
+        }
+    }
+
+    uint32_t us = micros() - start;
+    portENTER_CRITICAL(&predict_mux);
+    predict_stats.lookups++;
+    predict_stats.last_us = us;
+    if (us > predict_stats.max_us) {
+        predict_stats.max_us = us;
+    }
+    if (w.visits > predict_stats.visits_max) {
+        predict_stats.visits_max = w.visits;
+    }
+    portEXIT_CRITICAL(&predict_mux);
+    return w.n;
+}
+
+void predict_learn(const char *text) {
+    if (!user || !learn_enabled) {
+        return;
+    }
+    char word[PREDICT_WORD_MAX];
+    int len = 0;
+    bool valid = true;
+    bool learned = false;
+    for (const char *p = text;; p++) {
+        unsigned char c = *p;
+        if (isalpha(c) || c == '\'') {
+            if (len < PREDICT_WORD_MAX - 1) {
+                word[len++] = tolower(c);
+            } else {
+                valid = false;
+            }
+            continue;
+        }
+        if (isalnum(c) || c >= 0x80) {
+            // Digits or UTF-8 inside a word: not one the dictionary could hold
+            valid = false;
+            continue;
+        }
+        if (valid && len >= PREDICT_WORD_MIN && word[0] != '\'') {
+            word[len] = '\0';
+            learn_word(word);
+            learned = true;
+        }
+        len = 0;
+        valid = true;
+        if (!c) {
+            break;
+        }
+    }
+    if (learned) {
+        save();
+    }
+}
+
+void predict_forget() {
+    if (!user) {
+        return;
+    }
+    portENTER_CRITICAL(&predict_mux);
+    memset(user, 0, PREDICT_USER_MAX * sizeof(UserWord));
+    predict_stats.user_words = 0;
+    portEXIT_CRITICAL(&predict_mux);
+    save();
+}
+
+void predict_get_stats(PredictStats *out) {
+    portENTER_CRITICAL(&predict_mux);
+    *out = predict_stats;
+    portEXIT_CRITICAL(&predict_mux);
+}
+
+static void rpc_predict(Print &out, const char *args) {
+    if (!strcmp(args, "forget")) {
+        predict_forget();
+        out.println("ok");
+        return;
+    }
+    if (args[0]) {
+        PredictCandidate cands[PREDICT_CANDIDATES_MAX];
+        int n = predict_complete(args, cands, PREDICT_CANDIDATES_MAX);
+        for (int i = 0; i < n; i++) {
+            out.printf("%-24s %3u%s\n", cands[i].word, cands[i].score, cands[i].learned ? " learned" : "");
+        }
+        PredictStats s;
+        predict_get_stats(&s);
+        out.printf("%d candidates, %lu us\n", n, (unsigned long)s.last_us);
+        return;
+    }
+    PredictStats s;
+    predict_get_stats(&s);
+    out.printf("dictionary: %lu words, %lu bytes; learned: %lu words\n", (unsigned long)s.dict_words,
+               (unsigned long)s.dict_bytes, (unsigned long)s.user_words);
+    out.printf("lookups %lu, last %lu us, max %lu us, max %lu nodes\n", (unsigned long)s.lookups,
+               (unsigned long)s.last_us, (unsigned long)s.max_us, (unsigned long)s.visits_max);
+    out.printf("words learned %lu, saves %lu, errors %lu\n", (unsigned long)s.learned, (unsigned long)s.saves,
+               (unsigned long)s.save_errors);
+}
+
+bool predict_begin() {
+    if (user) {
+        return true;
+    }
+#ifdef INTEGRATION_LAYER_ENABLED
+    if (!GET_CONFIG_BOOL("predict", "enabled", true)) {
+        LOG_INFO("Predict", "Word completion disabled in config");
+        return false;
+    }
+    learn_enabled = GET_CONFIG_BOOL("predict", "learn", true);
+#endif
+    dict_map();
+
+    user = (UserWord *)heap_caps_calloc(PREDICT_USER_MAX, sizeof(UserWord), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!user) {
+        LOG_WARN("Predict", "No memory for learned words");
+    } else if (LittleFS.begin(false) && fs_service_begin()) {
+        if (!LittleFS.exists(PREDICT_USER_DIR)) {
+            LittleFS.mkdir(PREDICT_USER_DIR);
+        }
+        user_load();
+        save_buf = (uint8_t *)heap_caps_malloc(sizeof(UserFileHeader) + PREDICT_USER_MAX * sizeof(UserWord),
+                                               MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    } else {
+        LOG_WARN("Predict", "No LittleFS, learned words last until reboot");
+    }
+
+    usb_console_rpc("predict", rpc_predict);
+    LOG_INFOF("Predict", "%lu dictionary words, %lu learned", (unsigned long)predict_stats.dict_words,
+              (unsigned long)predict_stats.user_words);
+    return dict || user;
+}
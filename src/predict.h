@@ -0,0 +1,107 @@
+/**
+ * @file      predict.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Word completion from a flash-resident DAWG and words learned on the device
+ */
+
+#ifndef PREDICT_H
+#define PREDICT_H
+
+#include <Arduino.h>
+
+/**
+ * The dictionary is the asset pack blob PREDICT_DICT_ASSET, built by
+ * script/dict_pack.py: a minimized trie, read in place through the flash
+ * mapping, so it costs no RAM and a lookup touches only the nodes on the
+ * prefix path and the few subtrees that can still make the top
+ * candidates. Each edge carries the best rank below it, and the walk goes
+ * best first and stops at a subtree that cannot beat the candidates
+ * already held, at most PREDICT_VISIT_MAX nodes per lookup.
+ *
+ * Words sent from the device are learned: a RAM table of up to
+ * PREDICT_USER_MAX words with counts, the least used going first when it
+ * is full. A learned word ranks above a dictionary word of
+ * PREDICT_USER_RANK, and higher with each use; words the dictionary lacks
+ * (names, places) are completed too. The table is kept in LittleFS at
+ * PREDICT_USER_FILE, written through the FS service after each message.
+ *
+ * Words are lowercase letters and the apostrophe. A prefix typed with a
+ * capital gets capitalized candidates; a complete word is not offered
+ * back.
+ *
+ * Console: "predict <prefix>" for the candidates and the time taken,
+ * "predict" for the counters, "predict forget" drops the learned words.
+ * Config section "predict": enabled (true), learn (true).
+ */
+
+#define PREDICT_DICT_ASSET          "words.tdd"
+#define PREDICT_DICT_MAGIC          0x44574454  // "TDWD"
+#define PREDICT_DICT_VERSION        1
+#define PREDICT_WORD_MAX            24      // Longest word and its NUL
+#define PREDICT_WORD_MIN            2
+#define PREDICT_CANDIDATES_MAX      8
+#define PREDICT_VISIT_MAX           4096    // Nodes per lookup
+#define PREDICT_EDGES_MAX           32      // Per node; letters and the apostrophe need 27
+#define PREDICT_RANK_SCALE          16      // Score of a dictionary rank
+#define PREDICT_RANK_MAX            15
+#define PREDICT_USER_MAX            256
+#define PREDICT_USER_RANK           8       // A word used once ranks with these
+#define PREDICT_USER_DIR            "/predict"
+#define PREDICT_USER_FILE           "/predict/user.bin"
+#define PREDICT_USER_TMP            "/predict/user.tmp"
+#define PREDICT_USER_MAGIC          0x52535544  // "DUSR"
+
+// Dictionary blob header; nodes follow, the root first
+struct PredictDictHeader {
+    uint32_t magic;
+    uint8_t version;
+    uint8_t longest;
+    uint16_t reserved;
+    uint32_t nodes;
+    uint32_t words;
+};
+
+struct PredictCandidate {
+    char word[PREDICT_WORD_MAX];
+    uint16_t score;                 // Dictionary rank x 16, learned words above
+    bool learned;
+};
+
+struct PredictStats {
+    uint32_t dict_words;            // 0 without the blob
+    uint32_t dict_bytes;
+    uint32_t user_words;
+    uint32_t lookups;
+    uint32_t last_us;
+    uint32_t max_us;
+    uint32_t visits_max;            // Most nodes read by one lookup
+    uint32_t learned;               // Words taken from sent messages
+    uint32_t saves;
+    uint32_t save_errors;
+};
+
+/**
+ * @brief Map the dictionary, load the learned words and add the console
+ *        command. Either may be missing
+ */
+bool predict_begin();
+
+/**
+ * @brief Best completions of prefix, best first. Any task; microseconds
+ * @return how many were written to out, at most max
+ */
+int predict_complete(const char *prefix, PredictCandidate *out, int max);
+
+/**
+ * @brief Count the words of a sent message and save the table
+ */
+void predict_learn(const char *text);
+
+void predict_forget();
+
+void predict_get_stats(PredictStats *out);
+
+#endif // PREDICT_H
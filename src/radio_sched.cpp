@@ -0,0 +1,269 @@
+/**
+ * @file      radio_sched.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Radio wake coalescing: deadline and slack windows, WiFi listen interval and eDRX tuning
+ */
+
+#include "radio_sched.h"
+#include "timer_wheel.h"
+#include "modem_power.h"
+#include "usb_console.h"
+#include "simple_logger.h"
+#include <WiFi.h>
+#include <esp_wifi.h>
+#ifdef INTEGRATION_LAYER_ENABLED
+#include "integration/config_manager.h"
+#endif
+
+struct RadioJob {
+    const char *name;
+    radio_job_fn fn;
+    void *ctx;
+    uint32_t period_ms;
+    uint32_t slack_ms;
+    uint32_t due_ms;                // Deadline, millis()
+    uint32_t runs;
+    uint32_t late;
+};
+
+static portMUX_TYPE rs_mux = portMUX_INITIALIZER_UNLOCKED;
+static RadioJob rs_jobs[RADIO_SCHED_JOBS];
+static volatile uint8_t rs_count = 0;  // Jobs are never removed, so fn and ctx stay put
+static WheelTimer rs_timer;
+static bool rs_timer_ready = false;
+static bool rs_begun = false;
+static bool rs_tune = true;
+static uint8_t rs_listen_max = RADIO_SCHED_WIFI_LISTEN_MAX;
+static uint32_t rs_since_ms = 0;
+static RadioSchedStats rs_stats;
+
+// ===== Windows =====
+
+// Under rs_mux: jobs whose slack has begun go into ready and get their next deadline
+static size_t take_open(uint32_t now, uint8_t *ready) {
+    size_t n = 0;
+    for (uint8_t i = 0; i < rs_count; i++) {
+        RadioJob *j = &rs_jobs[i];
+        if ((int32_t)(now - (j->due_ms - j->slack_ms)) < 0) {
+            continue;
+        }
+        if ((int32_t)(now - j->due_ms) > RADIO_SCHED_LATE_MS) {
+            j->late++;
+            rs_stats.late++;
+        }
+        j->runs++;
+        j->due_ms = now + j->period_ms;
+        ready[n++] = i;
+    }
+    rs_stats.runs += n;
+    return n;
+}
+
+static void run(const uint8_t *ready, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        rs_jobs[ready[i]].fn(rs_jobs[ready[i]].ctx);
+    }
+}
+
+// The next window is the earliest deadline: as late as every job allows
+static void rearm() {
+    uint32_t now = millis();
+    int32_t wait = INT32_MAX;
+    portENTER_CRITICAL(&rs_mux);
+    for (uint8_t i = 0; i < rs_count; i++) {
+        int32_t left = (int32_t)(rs_jobs[i].due_ms - now);
+        if (left < wait) {
+            wait = left;
+        }
+    }
+    portEXIT_CRITICAL(&rs_mux);
+    if (wait != INT32_MAX) {
+        timer_wheel_arm(&rs_timer, wait > 0 ? wait : 1);
+    }
+}
+
+static void window(WheelTimer *timer) {
+    uint8_t ready[RADIO_SCHED_JOBS];
+    portENTER_CRITICAL(&rs_mux);
+    size_t n = take_open(millis(), ready);
+    if (n) {
+        rs_stats.windows++;
+        rs_stats.shared += n - 1;
+    }
+    portEXIT_CRITICAL(&rs_mux);
+    run(ready, n);
+    rearm();
+}
+
+// ===== Radios =====
+
+static void tune() {
+    if (!rs_begun || !rs_tune || !rs_count) {
+        return;
+    }
+    uint32_t slack = UINT32_MAX;
+    portENTER_CRITICAL(&rs_mux);
+    for (uint8_t i = 0; i < rs_count; i++) {
+        if (rs_jobs[i].slack_ms < slack) {
+            slack = rs_jobs[i].slack_ms;
+        }
+    }
+    portEXIT_CRITICAL(&rs_mux);
+
+    uint32_t beacons = slack / RADIO_SCHED_BEACON_MS;
+    uint8_t listen = beacons < 1 ? 1 : beacons > rs_listen_max ? rs_listen_max : beacons;
+    // Read at association by some driver versions, so it is set again on each connect
+    if (listen != rs_stats.wifi_listen && (WiFi.getMode() & WIFI_MODE_STA)) {
+        wifi_config_t conf;
+        if (esp_wifi_get_config(WIFI_IF_STA, &conf) == ESP_OK) {
+            conf.sta.listen_interval = listen;
+            if (esp_wifi_set_config(WIFI_IF_STA, &conf) == ESP_OK && WiFi.setSleep(WIFI_PS_MAX_MODEM)) {
+                rs_stats.wifi_listen = listen;
+            }
+        }
+    }
+    uint32_t edrx_s = slack / 1000;
+    if (edrx_s != rs_stats.edrx_s && modem_power_set_edrx(edrx_s)) {
+        rs_stats.edrx_s = edrx_s;
+    }
+}
+
+static void on_wifi_connected(arduino_event_id_t event, arduino_event_info_t info) {
+    rs_stats.wifi_listen = 0;
+    tune();
+}
+
+// ===== Console =====
+
+static void rpc_radio(Print &out, const char *args) {
+    RadioSchedStats s;
+    radio_sched_get_stats(&s);
+    uint32_t hours_x100 = s.since_ms / 36000;
+    out.printf("windows %lu (%lu/h), runs %lu, shared %lu, piggybacked %lu, late %lu\n", (unsigned long)s.windows,
+               (unsigned long)(hours_x100 ? (uint64_t)s.windows * 100 / hours_x100 : 0), (unsigned long)s.runs,
+               (unsigned long)s.shared, (unsigned long)s.piggybacked, (unsigned long)s.late);
+    out.printf("wifi listen %u beacons, eDRX %lu s\n", s.wifi_listen, (unsigned long)s.edrx_s);
+    for (int i = 0; i < s.jobs; i++) {
+        RadioJobStats j;
+        if (radio_sched_job_stats(i, &j)) {
+            out.printf("  %-12s every %lu s, slack %lu s, due in %ld s, runs %lu, late %lu\n", j.name,
+                       (unsigned long)(j.period_ms / 1000), (unsigned long)(j.slack_ms / 1000),
+                       (long)(j.due_in_ms / 1000), (unsigned long)j.runs, (unsigned long)j.late);
+        }
+    }
+}
+
+// ===== API =====
+
+int radio_sched_add(const char *name, uint32_t period_ms, uint32_t slack_ms, radio_job_fn fn, void *ctx) {
+    if (!fn || !period_ms) {
+        return -1;
+    }
+    portENTER_CRITICAL(&rs_mux);
+    if (rs_count >= RADIO_SCHED_JOBS) {
+        portEXIT_CRITICAL(&rs_mux);
+        return -1;
+    }
+    if (!rs_timer_ready) {
+        timer_wheel_init(&rs_timer, "radio", window);
+        rs_timer_ready = true;
+    }
+    RadioJob *j = &rs_jobs[rs_count];
+    j->name = name;
+    j->fn = fn;
+    j->ctx = ctx;
+    j->period_ms = period_ms;
+    j->slack_ms = slack_ms < period_ms ? slack_ms : period_ms;
+    j->due_ms = millis() + period_ms;
+    j->runs = 0;
+    j->late = 0;
+    int id = rs_count++;
+    portEXIT_CRITICAL(&rs_mux);
+    rearm();
+    tune();
+    return id;
+}
+
+void radio_sched_set_period(int id, uint32_t period_ms, uint32_t slack_ms) {
+    if (id < 0 || id >= rs_count || !period_ms) {
+        return;
+    }
+    portENTER_CRITICAL(&rs_mux);
+    RadioJob *j = &rs_jobs[id];
+    j->due_ms += period_ms - j->period_ms;
+    j->period_ms = period_ms;
+    j->slack_ms = slack_ms < period_ms ? slack_ms : period_ms;
+    portEXIT_CRITICAL(&rs_mux);
+    rearm();
+    tune();
+}
+
+void radio_sched_defer(int id) {
+    if (id < 0 || id >= rs_count) {
+        return;
+    }
+    portENTER_CRITICAL(&rs_mux);
+    rs_jobs[id].due_ms = millis() + rs_jobs[id].period_ms;
+    portEXIT_CRITICAL(&rs_mux);
+    rearm();
+}
+
+void radio_sched_activity() {
+    if (!rs_count) {
+        return;
+    }
+    uint8_t ready[RADIO_SCHED_JOBS];
+    portENTER_CRITICAL(&rs_mux);
+    size_t n = take_open(millis(), ready);
+    rs_stats.piggybacked += n;
+    portEXIT_CRITICAL(&rs_mux);
+    if (n) {
+        run(ready, n);
+        rearm();
+    }
+}
+
+bool radio_sched_begin() {
+#ifdef INTEGRATION_LAYER_ENABLED
+    rs_tune = GET_CONFIG_BOOL("radio", "tune", true);
+    rs_listen_max = GET_CONFIG_INT("radio", "wifi_listen_max", RADIO_SCHED_WIFI_LISTEN_MAX);
+#endif
+    if (!rs_listen_max) {
+        rs_listen_max = 1;
+    }
+    rs_since_ms = millis();
+    rs_begun = true;
+    if (rs_tune) {
+        WiFi.onEvent(on_wifi_connected, ARDUINO_EVENT_WIFI_STA_CONNECTED);
+    }
+    usb_console_rpc("radio", rpc_radio);
+    tune();
+    return true;
+}
+
+void radio_sched_get_stats(RadioSchedStats *out) {
+    portENTER_CRITICAL(&rs_mux);
+    *out = rs_stats;
+    out->jobs = rs_count;
+    portEXIT_CRITICAL(&rs_mux);
+    out->since_ms = millis() - rs_since_ms;
+}
+
+bool radio_sched_job_stats(int id, RadioJobStats *out) {
+    if (id < 0 || id >= rs_count) {
+        return false;
+    }
+    portENTER_CRITICAL(&rs_mux);
+    const RadioJob *j = &rs_jobs[id];
+    out->name = j->name;
+    out->period_ms = j->period_ms;
+    out->slack_ms = j->slack_ms;
+    out->runs = j->runs;
+    out->late = j->late;
+    out->due_in_ms = (int32_t)(j->due_ms - millis());
+    portEXIT_CRITICAL(&rs_mux);
+    return true;
+}
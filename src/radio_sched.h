@@ -0,0 +1,91 @@
+/**
+ * @file      radio_sched.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Deferrable network work coalesced into shared radio wake windows
+ */
+
+#ifndef RADIO_SCHED_H
+#define RADIO_SCHED_H
+
+#include <Arduino.h>
+
+/**
+ * A radio that wakes for a few bytes stays on for its tail (WiFi beacon
+ * listening, the LTE inactivity timer) whatever the work was, so periodic
+ * work costs per wake, not per byte. Consumers register periodic jobs
+ * with a deadline (the period) and a slack: the job may run anywhere in
+ * the last slack_ms before its deadline. A window opens at the earliest
+ * deadline and runs every job whose slack has begun, so jobs with nearby
+ * deadlines share one wake. When the radio is up anyway, because some
+ * consumer sent or received, radio_sched_activity() runs the jobs whose
+ * slack has begun right away.
+ *
+ * A job's next deadline is a period after it ran. Jobs run on the timer
+ * task: set a flag and wake the owning task, never block.
+ *
+ * The radios are tuned to the shortest slack, the longest any work is
+ * allowed to wait: the WiFi listen interval (in beacons, with max modem
+ * power save) and the modem's eDRX cycle, rounded down. Downlinks then
+ * wait no longer than the jobs do.
+ *
+ * Config section "radio": tune (true), wifi_listen_max.
+ */
+
+#define RADIO_SCHED_JOBS            12
+#define RADIO_SCHED_LATE_MS         1000    // Past the deadline by more counts as late
+#define RADIO_SCHED_BEACON_MS       102     // 100 TU, the common beacon interval
+#define RADIO_SCHED_WIFI_LISTEN_MAX 10      // Beacons; access points hold frames only so long
+
+typedef void (*radio_job_fn)(void *ctx);
+
+struct RadioJobStats {
+    const char *name;
+    uint32_t period_ms;
+    uint32_t slack_ms;
+    uint32_t runs;
+    uint32_t late;
+    int32_t due_in_ms;
+};
+
+struct RadioSchedStats {
+    uint32_t windows;               // Timer wakes that ran at least one job
+    uint32_t runs;
+    uint32_t shared;                // Runs that found the radio woken by another
+    uint32_t piggybacked;           // Runs from radio_sched_activity()
+    uint32_t late;
+    uint32_t since_ms;
+    uint8_t wifi_listen;            // Beacons, 0 untuned
+    uint32_t edrx_s;                // Asked of modem_power, 0 untuned
+    uint8_t jobs;
+};
+
+/**
+ * @brief Register periodic work; the first deadline is a period from now.
+ *        Safe before radio_sched_begin()
+ * @return Job id, -1 when the table is full
+ */
+int radio_sched_add(const char *name, uint32_t period_ms, uint32_t slack_ms, radio_job_fn fn, void *ctx = NULL);
+void radio_sched_set_period(int id, uint32_t period_ms, uint32_t slack_ms);
+
+/**
+ * @brief The consumer did the work itself: next deadline a period from now
+ */
+void radio_sched_defer(int id);
+
+/**
+ * @brief The radio is up anyway: run what may run now
+ */
+void radio_sched_activity();
+
+/**
+ * @brief Read the config and start tuning the radios
+ */
+bool radio_sched_begin();
+
+void radio_sched_get_stats(RadioSchedStats *out);
+bool radio_sched_job_stats(int id, RadioJobStats *out);
+
+#endif // RADIO_SCHED_H
@@ -0,0 +1,146 @@
+/**
+ * @file      refresh_policy.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Ghosting-aware refresh policy implementation
+ */
+
+#include "refresh_policy.h"
+
+RefreshPolicy::RefreshPolicy() {
+    memset(tile_updates, 0, sizeof(tile_updates));
+    soft_limit = REFRESH_GHOST_SOFT_LIMIT;
+    hard_limit = REFRESH_GHOST_HARD_LIMIT;
+    worst_tile = 0;
+    regions_cleaned = 0;
+}
+
+void RefreshPolicy::recordPartial(const lv_area_t* area) {
+    int16_t c1 = LV_MAX(area->x1, 0) / REFRESH_TILE_SIZE;
+    int16_t r1 = LV_MAX(area->y1, 0) / REFRESH_TILE_SIZE;
+    int16_t c2 = LV_MIN(area->x2 / REFRESH_TILE_SIZE, REFRESH_TILE_COLS - 1);
+    int16_t r2 = LV_MIN(area->y2 / REFRESH_TILE_SIZE, REFRESH_TILE_ROWS - 1);
+    
+    for (int16_t r = r1; r <= r2; r++) {
+        for (int16_t c = c1; c <= c2; c++) {
+            uint8_t& count = tile_updates[r][c];
+            if (count < UINT8_MAX) {
+                count++;
+            }
+            if (count > worst_tile) {
+                worst_tile = count;
+            }
+        }
+    }
+}
+
+void RefreshPolicy::recordFull() {
+    memset(tile_updates, 0, sizeof(tile_updates));
+    worst_tile = 0;
+}
+
+void RefreshPolicy::recordCleaned(const lv_area_t* area) {
+    int16_t c1 = LV_MAX(area->x1, 0) / REFRESH_TILE_SIZE;
+    int16_t r1 = LV_MAX(area->y1, 0) / REFRESH_TILE_SIZE;
+    int16_t c2 = LV_MIN(area->x2 / REFRESH_TILE_SIZE, REFRESH_TILE_COLS - 1);
+    int16_t r2 = LV_MIN(area->y2 / REFRESH_TILE_SIZE, REFRESH_TILE_ROWS - 1);
+    
+    for (int16_t r = r1; r <= r2; r++) {
+        for (int16_t c = c1; c <= c2; c++) {
+            tile_updates[r][c] = 0;
+        }
+    }
+    
+    regions_cleaned++;
+    recomputeWorst();
+}
+
+bool RefreshPolicy::getCleanRegion(lv_area_t* region) {
+    if (!needsCleaning()) {
+        return false;
+    }
+    
+    // Find the worst tile, then grow a box over the ghosted tiles around it
+    int16_t worst_r = 0;
+    int16_t worst_c = 0;
+    for (int16_t r = 0; r < REFRESH_TILE_ROWS; r++) {
+        for (int16_t c = 0; c < REFRESH_TILE_COLS; c++) {
+            if (tile_updates[r][c] == worst_tile) {
+                worst_r = r;
+                worst_c = c;
+                r = REFRESH_TILE_ROWS; // Break out of both loops
+                break;
+            }
+        }
+    }
+    
+    int16_t c1 = worst_c, c2 = worst_c, r1 = worst_r, r2 = worst_r;
+    bool grown = true;
+    while (grown) {
+        grown = false;
+        // Extend each edge while the row or column next to it holds a ghosted tile
+        if (r1 > 0) {
+            for (int16_t c = c1; c <= c2; c++) {
+                if (tile_updates[r1 - 1][c] >= soft_limit) { r1--; grown = true; break; }
+            }
+        }
+        if (r2 < REFRESH_TILE_ROWS - 1) {
+            for (int16_t c = c1; c <= c2; c++) {
+                if (tile_updates[r2 + 1][c] >= soft_limit) { r2++; grown = true; break; }
+            }
+        }
+        if (c1 > 0) {
+            for (int16_t r = r1; r <= r2; r++) {
+                if (tile_updates[r][c1 - 1] >= soft_limit) { c1--; grown = true; break; }
+            }
+        }
+        if (c2 < REFRESH_TILE_COLS - 1) {
+            for (int16_t r = r1; r <= r2; r++) {
+                if (tile_updates[r][c2 + 1] >= soft_limit) { c2++; grown = true; break; }
+            }
+        }
+    }
+    
+    region->x1 = c1 * REFRESH_TILE_SIZE;
+    region->y1 = r1 * REFRESH_TILE_SIZE;
+    region->x2 = LV_MIN((c2 + 1) * REFRESH_TILE_SIZE, LCD_HOR_SIZE) - 1;
+    region->y2 = LV_MIN((r2 + 1) * REFRESH_TILE_SIZE, LCD_VER_SIZE) - 1;
+    return true;
+}
+
+void RefreshPolicy::setLimits(uint8_t soft, uint8_t hard) {
+    hard_limit = hard > 0 ? hard : 1;
+    soft_limit = soft > 0 && soft <= hard_limit ? soft : hard_limit;
+}
+
+uint8_t RefreshPolicy::getTileUpdates(int16_t x, int16_t y) {
+    if (x < 0 || y < 0 || x >= LCD_HOR_SIZE || y >= LCD_VER_SIZE) {
+        return 0;
+    }
+    return tile_updates[y / REFRESH_TILE_SIZE][x / REFRESH_TILE_SIZE];
+}
+
+uint16_t RefreshPolicy::getGhostedTiles() {
+    uint16_t ghosted = 0;
+    for (int16_t r = 0; r < REFRESH_TILE_ROWS; r++) {
+        for (int16_t c = 0; c < REFRESH_TILE_COLS; c++) {
+            if (tile_updates[r][c] >= soft_limit) {
+                ghosted++;
+            }
+        }
+    }
+    return ghosted;
+}
+
+void RefreshPolicy::recomputeWorst() {
+    worst_tile = 0;
+    for (int16_t r = 0; r < REFRESH_TILE_ROWS; r++) {
+        for (int16_t c = 0; c < REFRESH_TILE_COLS; c++) {
+            if (tile_updates[r][c] > worst_tile) {
+                worst_tile = tile_updates[r][c];
+            }
+        }
+    }
+}
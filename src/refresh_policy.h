@@ -0,0 +1,68 @@
+/**
+ * @file      refresh_policy.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Ghosting-aware refresh policy for the e-paper display
+ */
+
+#ifndef REFRESH_POLICY_H
+#define REFRESH_POLICY_H
+
+#include <Arduino.h>
+#include <lvgl.h>
+#include "utilities.h"
+
+// Ghosting is tracked on a coarse tile grid (LVGL coordinates)
+#define REFRESH_TILE_SIZE           16
+#define REFRESH_TILE_COLS           ((LCD_HOR_SIZE + REFRESH_TILE_SIZE - 1) / REFRESH_TILE_SIZE)
+#define REFRESH_TILE_ROWS           ((LCD_VER_SIZE + REFRESH_TILE_SIZE - 1) / REFRESH_TILE_SIZE)
+
+// Partial updates a tile may take before it is cleaned while idle
+#define REFRESH_GHOST_SOFT_LIMIT    8
+// Partial updates a tile may take before the whole panel is refreshed
+#define REFRESH_GHOST_HARD_LIMIT    32
+// Idle time before ghosted regions are cleaned
+#define REFRESH_CLEAN_IDLE_MS       3000
+
+/**
+ * @brief Refresh Policy Class
+ * 
+ * Counts partial updates per tile and decides when a region, or the
+ * whole panel, has collected enough ghosting to be cleaned
+ */
+class RefreshPolicy {
+private:
+    uint8_t tile_updates[REFRESH_TILE_ROWS][REFRESH_TILE_COLS];
+    uint8_t soft_limit;
+    uint8_t hard_limit;
+    uint8_t worst_tile;             // Highest counter on the grid
+    uint32_t regions_cleaned;
+    
+    void recomputeWorst();
+
+public:
+    RefreshPolicy();
+    
+    // Update accounting
+    void recordPartial(const lv_area_t* area);
+    void recordFull();
+    void recordCleaned(const lv_area_t* area);
+    
+    // Decisions
+    bool needsFullRefresh() { return worst_tile >= hard_limit; }
+    bool needsCleaning() { return worst_tile >= soft_limit; }
+    bool getCleanRegion(lv_area_t* region);
+    
+    // Configuration
+    void setLimits(uint8_t soft, uint8_t hard);
+    
+    // Status
+    uint8_t getWorstTile() { return worst_tile; }
+    uint8_t getTileUpdates(int16_t x, int16_t y);
+    uint16_t getGhostedTiles();
+    uint32_t getRegionsCleaned() { return regions_cleaned; }
+};
+
+#endif // REFRESH_POLICY_H
@@ -0,0 +1,194 @@
+/**
+ * @file      resume_state.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Deep sleep resume: RTC record of screens, services, GPS fix and LoRa queue
+ */
+
+#include "resume_state.h"
+#include "simple_logger.h"
+#include "simple_power.h"
+#include "ui_scr_mrg.h"
+#include "time_service.h"
+#include <esp_attr.h>
+#include <esp_timer.h>
+#include <esp_system.h>
+#include <esp_rom_crc.h>
+#include <sys/time.h>
+
+RTC_NOINIT_ATTR static ResumeRecord rtc_resume;
+
+static bool resuming = false;
+static bool finished = false;
+static bool lora_held = false;      // Queue still waiting for the radio
+static uint32_t slept_ms = 0;
+
+static uint32_t record_crc(const ResumeRecord *r) {
+    return esp_rom_crc32_le(0, (const uint8_t *)r, offsetof(ResumeRecord, crc));
+}
+
+static bool record_valid(const ResumeRecord *r) {
+    return r->magic == RESUME_MAGIC && r->size == sizeof(ResumeRecord) && r->crc == record_crc(r) &&
+           r->screen_depth <= RESUME_SCREEN_DEPTH && r->lora_used <= RESUME_LORA_BYTES;
+}
+
+static uint64_t now_us() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (uint64_t)tv.tv_sec * 1000000ULL + tv.tv_usec;
+}
+
+bool resume_state_begin() {
+    resuming = esp_reset_reason() == ESP_RST_DEEPSLEEP && record_valid(&rtc_resume);
+    if (!resuming) {
+        rtc_resume.magic = 0;
+        return false;
+    }
+
+    uint64_t now = now_us();
+    slept_ms = now > rtc_resume.sleep_at_us ? (uint32_t)((now - rtc_resume.sleep_at_us) / 1000) : 0;
+    lora_held = rtc_resume.lora_count > 0;
+    return true;
+}
+
+bool resume_state_resuming() {
+    return resuming;
+}
+
+uint32_t resume_state_slept_ms() {
+    return slept_ms;
+}
+
+static void save_lora(ResumeRecord *r) {
+    static lora_tx_saved_t saved[LORA_TX_POOL_SIZE];
+    int n = lora_tx_save(saved, LORA_TX_POOL_SIZE);
+    for (int i = 0; i < n; i++) {
+        uint16_t need = 3 + saved[i].len;
+        if (r->lora_used + need > RESUME_LORA_BYTES) {
+            LOG_WARNF("Resume", "%d LoRa packets dropped, no RTC space", n - i);
+            break;
+        }
+        uint8_t *p = r->lora_pool + r->lora_used;
+        p[0] = saved[i].len;
+        p[1] = saved[i].priority;
+        p[2] = saved[i].retries;
+        memcpy(p + 3, saved[i].data, saved[i].len);
+        r->lora_used += need;
+        r->lora_count++;
+    }
+}
+
+bool resume_state_save() {
+    ResumeRecord *r = &rtc_resume;
+    uint32_t resumes = resuming ? r->resumes + 1 : 0;
+    memset(r, 0, sizeof(*r));
+    r->size = sizeof(*r);
+    r->resumes = resumes;
+
+    r->power_mode = 0xFF;
+    if (Power) {
+        r->power_mode = Power->getPowerMode();
+        r->auto_power = Power->isAutoPowerManagement();
+        r->idle_timeout_ms = Power->getIdleTimeout();
+    }
+
+    int ids[RESUME_SCREEN_DEPTH];
+    r->screen_depth = scr_mgr_get_stack(ids, RESUME_SCREEN_DEPTH);
+    for (int i = 0; i < r->screen_depth; i++) {
+        r->screens[i] = ids[i];
+    }
+
+    gps_get_fix(&r->fix);
+    r->has_fix = r->fix.valid;
+    r->fix_age_ms = r->has_fix ? millis() - r->fix.time_ms : 0;
+
+    save_lora(r);
+
+    // The system clock is brought onto the model first, so both measure the sleep alike
+    time_service_prepare_sleep();
+    r->sleep_at_us = now_us();
+    r->magic = RESUME_MAGIC;
+    r->crc = record_crc(r);
+
+    LOG_INFOF("Resume", "State saved: %u screens, fix %s, %u LoRa packets", r->screen_depth,
+              r->has_fix ? "kept" : "none", r->lora_count);
+    return true;
+}
+
+static void restore_lora() {
+    const ResumeRecord *r = &rtc_resume;
+    const uint8_t *p = r->lora_pool;
+    int queued = 0;
+    for (int i = 0; i < r->lora_count; i++) {
+        if (lora_tx_enqueue(p + 3, p[0], p[1], p[2])) {
+            queued++;
+        }
+        p += 3 + p[0];
+    }
+    lora_held = false;
+    LOG_INFOF("Resume", "%d of %u LoRa packets requeued", queued, r->lora_count);
+}
+
+void resume_state_restore() {
+    if (!resuming) {
+        return;
+    }
+    const ResumeRecord *r = &rtc_resume;
+    LOG_INFOF("Resume", "Resuming after %lu ms asleep (%lu in a row)", slept_ms, r->resumes + 1);
+
+    if (Power && r->power_mode != 0xFF) {
+        Power->setPowerMode((PowerMode)r->power_mode);
+        Power->setIdleTimeout(r->idle_timeout_ms);
+        Power->enableAutoPowerManagement(r->auto_power);
+    }
+
+    if (r->has_fix) {
+        gps_restore_fix(&r->fix, r->fix_age_ms + slept_ms);
+    }
+
+    if (lora_held && peri_init_ready(E_PERI_LORA)) {
+        restore_lora();
+    }
+}
+
+void resume_state_restore_ui() {
+    if (!resuming) {
+        return;
+    }
+    const ResumeRecord *r = &rtc_resume;
+
+    if (r->screen_depth > 0) {
+        // Without animation: the panel already shows the top screen
+        int ids[RESUME_SCREEN_DEPTH];
+        int depth = scr_mgr_get_stack(ids, RESUME_SCREEN_DEPTH);
+        if (depth != 1 || ids[0] != r->screens[0]) {
+            scr_mgr_switch(r->screens[0], false);
+        }
+        for (int i = 1; i < r->screen_depth; i++) {
+            scr_mgr_push(r->screens[i], false);
+        }
+    }
+
+    // The port functions bring the radio up lazily, this is the same task
+    if (lora_held && peri_init_ensure(E_PERI_LORA)) {
+        restore_lora();
+    }
+}
+
+void resume_state_finish() {
+    if (!resuming || finished) {
+        return;
+    }
+    finished = true;
+    uint32_t ms = (uint32_t)(esp_timer_get_time() / 1000);
+    if (ms > RESUME_TARGET_MS) {
+        LOG_WARNF("Resume", "Interactive %lu ms after wake, target %u ms", ms, RESUME_TARGET_MS);
+    } else {
+        LOG_INFOF("Resume", "Interactive %lu ms after wake", ms);
+    }
+
+    // A crash from here on must not resume again; the next sleep writes a new record
+    rtc_resume.magic = 0;
+}
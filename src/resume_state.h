@@ -0,0 +1,90 @@
+/**
+ * @file      resume_state.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Application state kept in RTC memory through deep sleep, for instant-on resume
+ */
+
+#ifndef RESUME_STATE_H
+#define RESUME_STATE_H
+
+#include <Arduino.h>
+#include "peripheral.h"
+
+#define RESUME_MAGIC                0x4D535352UL  // "RSSM"
+#define RESUME_SCREEN_DEPTH         4
+#define RESUME_LORA_BYTES           1024  // Packed TX queue; packets past this are dropped
+#define RESUME_TARGET_MS            1000  // Boot to interactive, warned about past this
+
+/**
+ * Written just before esp_deep_sleep_start() and read back on the wake
+ * boot. The WiFi access point and lease already live in wifi_fast's own
+ * RTC record, and the e-paper panel keeps the last image unpowered
+ */
+struct ResumeRecord {
+    uint32_t magic;
+    uint32_t size;                  // sizeof(ResumeRecord), rejects another build's layout
+    uint64_t sleep_at_us;           // gettimeofday(), which the RTC timer keeps through sleep
+    uint32_t resumes;               // Wakes in a row without a cold boot
+
+    // Services
+    uint8_t power_mode;             // PowerMode, 0xFF without SimplePower
+    uint8_t auto_power;
+    uint32_t idle_timeout_ms;
+
+    // UI
+    uint8_t screen_depth;
+    int8_t screens[RESUME_SCREEN_DEPTH];    // scr_mgr stack, root first
+
+    // GPS
+    uint8_t has_fix;
+    uint32_t fix_age_ms;            // At sleep
+    gps_fix_t fix;
+
+    // LoRa TX queue in send order: len, priority, retries, then the payload
+    uint8_t lora_count;
+    uint16_t lora_used;
+    uint8_t lora_pool[RESUME_LORA_BYTES];
+
+    uint32_t crc;
+};
+
+/**
+ * @brief First thing in setup(): a deep sleep wake with a valid record resumes,
+ *        anything else drops it
+ * @return true when resuming
+ */
+bool resume_state_begin();
+bool resume_state_resuming();
+
+/**
+ * @brief Collect the state from every module. SimplePower calls this on its
+ *        way into deep sleep or hibernation
+ */
+bool resume_state_save();
+
+/**
+ * @brief Put the services back: power mode, last GPS fix, and the LoRa queue
+ *        when the radio is already up. Before gps_init
+ */
+void resume_state_restore();
+
+/**
+ * @brief UI task, after the screens are registered: rebuild the screen stack
+ *        and requeue LoRa packets the radio was not up for
+ */
+void resume_state_restore_ui();
+
+/**
+ * @brief Boot is interactive: logs the resume time and retires the record
+ */
+void resume_state_finish();
+
+/**
+ * @brief How long the device slept, 0 on a cold boot
+ */
+uint32_t resume_state_slept_ms();
+
+#endif // RESUME_STATE_H
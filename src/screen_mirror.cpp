@@ -0,0 +1,444 @@
+/**
+ * @file      screen_mirror.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Remote screen mirror: XOR/RLE tile deltas of the panel image out,
+ *            touch and keys in, over USB CDC or MQTT
+ */
+
+#include "screen_mirror.h"
+#include <esp_heap_caps.h>
+#include "simple_logger.h"
+#include "lvgl_integration.h"
+#include "keymap.h"
+#include "mqtt_client.h"
+#include "usb_console.h"
+#include "task_stack.h"
+
+#ifdef INTEGRATION_LAYER_ENABLED
+#include "integration/config_manager.h"
+#include "integration/event_bridge.h"
+#endif
+
+#define MIRROR_TILES_X      (LVGL_FB_STRIDE / SCREEN_MIRROR_TILE_BYTES)
+#define MIRROR_TILES_Y      (LVGL_DISPLAY_HEIGHT / SCREEN_MIRROR_TILE_ROWS)
+#define MIRROR_TILE_SIZE    (SCREEN_MIRROR_TILE_BYTES * SCREEN_MIRROR_TILE_ROWS)
+#define MIRROR_RLE_MAX      (MIRROR_TILE_SIZE + (MIRROR_TILE_SIZE + 63) / 64)
+#define MIRROR_FRAME_HEADER 4
+
+static_assert(LVGL_FB_STRIDE % SCREEN_MIRROR_TILE_BYTES == 0, "tiles must cover a row");
+static_assert(LVGL_DISPLAY_HEIGHT % SCREEN_MIRROR_TILE_ROWS == 0, "tiles must cover a column");
+static_assert(MIRROR_TILES_X * MIRROR_TILES_Y <= 256, "tile index is one byte");
+static_assert(MIRROR_RLE_MAX <= 255, "tile length is one byte");
+
+#define MIRROR_SIG_FRAME    0x01
+#define MIRROR_SIG_KEY      0x02
+
+// latest under mirror_lock; work and sent belong to the task
+static SemaphoreHandle_t mirror_lock = nullptr;
+static uint8_t *latest = nullptr;           // Last frame from the flush task
+static uint8_t *work = nullptr;             // Its copy being coded
+static uint8_t *sent = nullptr;             // What the remote has
+static bool latest_valid = false;
+static TaskHandle_t mirror_task = nullptr;
+static volatile uint8_t transports = 0;
+static uint8_t frame_seq = 0;
+static char topic_out[MQTT_TOPIC_MAX];
+static char topic_in[MQTT_TOPIC_MAX];
+static bool mqtt_hooked = false;
+static ScreenMirrorStats mirror_stats;
+
+// Two producers (USB on the console task, MQTT on the event worker), one
+// consumer (UI task)
+static portMUX_TYPE input_mux = portMUX_INITIALIZER_UNLOCKED;
+static struct {
+    int16_t x;
+    int16_t y;
+    bool pressed;
+} touch_queue[SCREEN_MIRROR_TOUCH_QUEUE];
+static uint16_t touch_head = 0;
+static uint16_t touch_tail = 0;
+static keypad_event_t key_queue[SCREEN_MIRROR_KEY_QUEUE];
+static uint16_t key_head = 0;
+static uint16_t key_tail = 0;
+
+// ===== Coding =====
+
+static size_t rle_encode(const uint8_t *in, size_t n, uint8_t *out) {
+    size_t i = 0, o = 0;
+    while (i < n) {
+        size_t run = 1;
+        while (i + run < n && in[i + run] == in[i]) {
+            run++;
+        }
+        if (in[i] == 0) {
+            run = min(run, (size_t)128);
+            out[o++] = run - 1;
+            i += run;
+        } else if (run >= 3) {
+            run = min(run, (size_t)64);
+            out[o++] = 0xC0 | (run - 1);
+            out[o++] = in[i];
+            i += run;
+        } else {
+            // Literals up to the next zero or run of three
+            size_t j = i;
+            while (j < n && j - i < 64 && in[j] &&
+                   !(j + 2 < n && in[j] == in[j + 1] && in[j] == in[j + 2])) {
+                j++;
+            }
+            out[o++] = 0x80 | (j - i - 1);
+            memcpy(out + o, in + i, j - i);
+            o += j - i;
+            i = j;
+        }
+    }
+    return o;
+}
+
+// XOR of the two frames over tile t; false when it is unchanged
+static bool tile_delta(int t, const uint8_t *from, const uint8_t *to, uint8_t *delta) {
+    size_t base = (t / MIRROR_TILES_X) * SCREEN_MIRROR_TILE_ROWS * LVGL_FB_STRIDE +
+                  (t % MIRROR_TILES_X) * SCREEN_MIRROR_TILE_BYTES;
+    uint8_t any = 0;
+    for (int r = 0; r < SCREEN_MIRROR_TILE_ROWS; r++) {
+        const uint8_t *a = from + base + r * LVGL_FB_STRIDE;
+        const uint8_t *b = to + base + r * LVGL_FB_STRIDE;
+        for (int c = 0; c < SCREEN_MIRROR_TILE_BYTES; c++) {
+            uint8_t d = a[c] ^ b[c];
+            delta[r * SCREEN_MIRROR_TILE_BYTES + c] = d;
+            any |= d;
+        }
+    }
+    return any;
+}
+
+// ===== Transports =====
+
+static void send(const uint8_t *msg, size_t len) {
+    uint8_t on = transports;
+    if (on & SCREEN_MIRROR_USB) {
+        usb_console_send(USB_CONSOLE_CH_MIRROR, msg, len);
+    }
+    if ((on & SCREEN_MIRROR_MQTT) && mqtt_hooked && mqtt_connected()) {
+        mqtt_publish(topic_out, msg, len);
+    }
+    mirror_stats.messages++;
+    mirror_stats.bytes += len;
+}
+
+static void send_info() {
+    uint8_t msg[] = {
+        'I', SCREEN_MIRROR_VERSION,
+        (uint8_t)LVGL_DISPLAY_WIDTH, (uint8_t)(LVGL_DISPLAY_WIDTH >> 8),
+        (uint8_t)LVGL_DISPLAY_HEIGHT, (uint8_t)(LVGL_DISPLAY_HEIGHT >> 8),
+        SCREEN_MIRROR_TILE_BYTES, SCREEN_MIRROR_TILE_ROWS,
+        LVGL_FB_MIRROR_Y ? SCREEN_MIRROR_FLAG_MIRROR_Y : 0,
+    };
+    send(msg, sizeof(msg));
+}
+
+// Tiles of work that differ from sent, split over as many messages as it takes
+static void send_frame(bool key) {
+    static uint8_t msg[SCREEN_MIRROR_MSG_MAX];
+    uint8_t delta[MIRROR_TILE_SIZE];
+    uint8_t rle[MIRROR_RLE_MAX];
+    size_t len = MIRROR_FRAME_HEADER;
+    uint8_t count = 0;
+    uint16_t tiles = 0;
+    uint32_t bytes = 0;
+    uint8_t flags = key ? SCREEN_MIRROR_FLAG_KEY : 0;
+
+    if (key) {
+        memset(sent, 0, LVGL_FB_SIZE);
+    }
+    msg[0] = 'F';
+    msg[1] = frame_seq;
+    for (int t = 0; t < MIRROR_TILES_X * MIRROR_TILES_Y; t++) {
+        if (!tile_delta(t, sent, work, delta)) {
+            continue;
+        }
+        size_t n = rle_encode(delta, MIRROR_TILE_SIZE, rle);
+        if (len + 2 + n > sizeof(msg)) {
+            msg[2] = flags;
+            msg[3] = count;
+            send(msg, len);
+            bytes += len;
+            flags &= ~SCREEN_MIRROR_FLAG_KEY;
+            len = MIRROR_FRAME_HEADER;
+            count = 0;
+        }
+        msg[len++] = t;
+        msg[len++] = n;
+        memcpy(msg + len, rle, n);
+        len += n;
+        count++;
+        tiles++;
+    }
+    if (!tiles && !key) {
+        return;
+    }
+    msg[2] = flags | SCREEN_MIRROR_FLAG_LAST;
+    msg[3] = count;
+    send(msg, len);
+    bytes += len;
+    memcpy(sent, work, LVGL_FB_SIZE);
+
+    frame_seq++;
+    mirror_stats.sent++;
+    mirror_stats.last_bytes = bytes;
+    mirror_stats.last_tiles = tiles;
+    if (key) {
+        mirror_stats.key_frames++;
+    }
+}
+
+// ===== Input =====
+
+static void push_touch(int16_t x, int16_t y, bool pressed) {
+    bool ok = false;
+    portENTER_CRITICAL(&input_mux);
+    if ((uint16_t)(touch_head - touch_tail) < SCREEN_MIRROR_TOUCH_QUEUE) {
+        touch_queue[touch_head++ & (SCREEN_MIRROR_TOUCH_QUEUE - 1)] = {x, y, pressed};
+        ok = true;
+    }
+    portEXIT_CRITICAL(&input_mux);
+    if (ok) {
+        mirror_stats.touches++;
+    } else {
+        mirror_stats.rejected++;
+    }
+}
+
+static void push_key(uint8_t code, bool pressed) {
+    keypad_event_t ev = {};
+    ev.time_ms = millis();
+    ev.code = code;
+    ev.val = keymap_lookup(KEYMAP_LAYER_BASE, code);
+    ev.state = pressed ? KEYPAD_PRESS : KEYPAD_RELEASE;
+
+    bool ok = false;
+    portENTER_CRITICAL(&input_mux);
+    if ((uint16_t)(key_head - key_tail) < SCREEN_MIRROR_KEY_QUEUE) {
+        key_queue[key_head++ & (SCREEN_MIRROR_KEY_QUEUE - 1)] = ev;
+        ok = true;
+    }
+    portEXIT_CRITICAL(&input_mux);
+    if (ok) {
+        mirror_stats.keys++;
+    } else {
+        mirror_stats.rejected++;
+    }
+}
+
+static void handle_input(const uint8_t *msg, size_t len) {
+    if (!len) {
+        return;
+    }
+    switch (msg[0]) {
+        case 'K':
+            screen_mirror_request_key_frame();
+            return;
+        case 'T':
+            if (len >= 6) {
+                push_touch(msg[1] | msg[2] << 8, msg[3] | msg[4] << 8, msg[5]);
+                break;
+            }
+            mirror_stats.rejected++;
+            return;
+        case 'P':
+            if (len >= 3 && msg[1] < KEYMAP_KEYS) {
+                push_key(msg[1], msg[2]);
+                break;
+            }
+            mirror_stats.rejected++;
+            return;
+        default:
+            mirror_stats.rejected++;
+            return;
+    }
+    if (LVGL) {
+        LVGL->wake();
+    }
+}
+
+static void on_console(const uint8_t *data, size_t len, void *ctx) {
+    handle_input(data, len);
+}
+
+#ifdef INTEGRATION_LAYER_ENABLED
+static void on_mqtt(const Event &event, void *context) {
+    const MqttMessageEvent *msg = event.getPayload<MqttMessageEvent>();
+    if (!msg || strcmp(msg->topic, topic_in) != 0 || msg->len > sizeof(msg->data)) {
+        return;
+    }
+    handle_input(msg->data, msg->len);
+}
+#endif
+
+// ===== Task =====
+
+// Once the client has its device id and a session: frames sent before went
+// nowhere, so the broker side starts from a key frame
+static bool mqtt_hook() {
+    if (!mqtt_connected()) {
+        return false;
+    }
+    snprintf(topic_out, sizeof(topic_out), SCREEN_MIRROR_TOPIC, mqtt_device_id());
+    snprintf(topic_in, sizeof(topic_in), SCREEN_MIRROR_TOPIC_IN, mqtt_device_id());
+    mqtt_subscribe(topic_in);
+    // Through the event bridge: mqtt_on_message() has a single taker, OTA
+#ifdef INTEGRATION_LAYER_ENABLED
+    if (!GlobalEventBridge ||
+        !GlobalEventBridge->subscribe("Mirror", EventType::MQTT_MESSAGE_RECEIVED, on_mqtt)) {
+        LOG_WARN("Mirror", "No event bridge, MQTT input is ignored");
+    }
+#endif
+    mqtt_hooked = true;
+    return true;
+}
+
+static void mirror_task_fn(void *param) {
+    bool key = true;
+    while (true) {
+        uint32_t bits = 0;
+        xTaskNotifyWait(0, UINT32_MAX, &bits, portMAX_DELAY);
+        if ((transports & SCREEN_MIRROR_MQTT) && !mqtt_hooked && mqtt_hook()) {
+            key = true;
+        }
+        if (bits & MIRROR_SIG_KEY) {
+            key = true;
+        }
+        if (!transports || (!key && !(bits & MIRROR_SIG_FRAME))) {
+            continue;
+        }
+
+        xSemaphoreTake(mirror_lock, portMAX_DELAY);
+        bool valid = latest_valid;
+        if (valid) {
+            memcpy(work, latest, LVGL_FB_SIZE);
+        }
+        xSemaphoreGive(mirror_lock);
+        if (!valid) {
+            continue;
+        }
+        if (key) {
+            send_info();
+        }
+        send_frame(key);
+        key = false;
+    }
+}
+
+// ===== API =====
+
+bool screen_mirror_begin() {
+    uint8_t mask = 0;
+#ifdef INTEGRATION_LAYER_ENABLED
+    if (GET_CONFIG_BOOL("mirror", "usb", false)) {
+        mask |= SCREEN_MIRROR_USB;
+    }
+    if (GET_CONFIG_BOOL("mirror", "mqtt", false)) {
+        mask |= SCREEN_MIRROR_MQTT;
+    }
+#endif
+    return mask && screen_mirror_set_transports(mask);
+}
+
+bool screen_mirror_set_transports(uint8_t mask) {
+    if (!mirror_task) {
+        if (!mask) {
+            return true;
+        }
+        latest = (uint8_t *)heap_caps_calloc(1, LVGL_FB_SIZE, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        work = (uint8_t *)heap_caps_calloc(1, LVGL_FB_SIZE, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        sent = (uint8_t *)heap_caps_calloc(1, LVGL_FB_SIZE, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        mirror_lock = xSemaphoreCreateMutex();
+        if (!latest || !work || !sent || !mirror_lock) {
+            LOG_ERROR("Mirror", "No memory for the frame buffers");
+            return false;
+        }
+        if (task_spawn(mirror_task_fn, "mirror", SCREEN_MIRROR_TASK_STACK, nullptr,
+                       SCREEN_MIRROR_TASK_PRIORITY, &mirror_task, tskNO_AFFINITY, TASK_STACK_PSRAM_OK) != pdPASS) {
+            LOG_ERROR("Mirror", "Failed to start the task");
+            return false;
+        }
+    }
+
+    if (mask & SCREEN_MIRROR_USB) {
+        usb_console_on(USB_CONSOLE_CH_MIRROR, on_console);
+        usb_console_begin();
+    }
+
+    uint8_t added = mask & ~transports;
+    transports = mask;
+    mirror_stats.transports = mask;
+    if (added) {
+        screen_mirror_request_key_frame();
+    }
+    // The panel is not redrawn for a mirror: the UI task hands over what it
+    // shows now (screen_mirror_wants_frame)
+    if (LVGL) {
+        LVGL->wake();
+    }
+    LOG_INFOF("Mirror", "Transports:%s%s%s", mask & SCREEN_MIRROR_USB ? " usb" : "",
+              mask & SCREEN_MIRROR_MQTT ? " mqtt" : "", mask ? "" : " none");
+    return true;
+}
+
+void screen_mirror_frame(const uint8_t *fb) {
+    if (!transports || !mirror_task) {
+        return;
+    }
+    xSemaphoreTake(mirror_lock, portMAX_DELAY);
+    memcpy(latest, fb, LVGL_FB_SIZE);
+    latest_valid = true;
+    mirror_stats.frames++;
+    xSemaphoreGive(mirror_lock);
+    xTaskNotify(mirror_task, MIRROR_SIG_FRAME, eSetBits);
+}
+
+bool screen_mirror_wants_frame() {
+    return transports && mirror_task && !latest_valid;
+}
+
+void screen_mirror_request_key_frame() {
+    if (mirror_task) {
+        xTaskNotify(mirror_task, MIRROR_SIG_KEY, eSetBits);
+    }
+}
+
+bool screen_mirror_take_touch(int16_t *x, int16_t *y, bool *pressed) {
+    bool got = false;
+    portENTER_CRITICAL(&input_mux);
+    if (touch_tail != touch_head) {
+        auto &s = touch_queue[touch_tail++ & (SCREEN_MIRROR_TOUCH_QUEUE - 1)];
+        *x = s.x;
+        *y = s.y;
+        *pressed = s.pressed;
+        got = true;
+    }
+    portEXIT_CRITICAL(&input_mux);
+    return got;
+}
+
+bool screen_mirror_take_key(keypad_event_t *ev) {
+    bool got = false;
+    portENTER_CRITICAL(&input_mux);
+    if (key_tail != key_head) {
+        *ev = key_queue[key_tail++ & (SCREEN_MIRROR_KEY_QUEUE - 1)];
+        got = true;
+    }
+    portEXIT_CRITICAL(&input_mux);
+    return got;
+}
+
+bool screen_mirror_key_pending() {
+    return key_tail != key_head;
+}
+
+void screen_mirror_get_stats(ScreenMirrorStats *stats) {
+    *stats = mirror_stats;
+}
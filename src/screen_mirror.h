@@ -0,0 +1,126 @@
+/**
+ * @file      screen_mirror.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Remote screen mirror: XOR/RLE tile deltas of the panel image out,
+ *            touch and keys in, over USB CDC or MQTT
+ */
+
+#ifndef SCREEN_MIRROR_H
+#define SCREEN_MIRROR_H
+
+#include <Arduino.h>
+#include "peripheral.h"
+
+/**
+ * The flush task hands every frame it has put on the glass to
+ * screen_mirror_frame(), so nothing is sent unless the panel changed. The
+ * mirror task compares it with the last frame the remote was sent, tile by
+ * tile, and sends the tiles that differ as the XOR of old and new, run
+ * length coded. A changed label is a tile or two of mostly zero bytes,
+ * which comes to a few tens of bytes on the wire.
+ *
+ * Messages, first byte the type, multi-byte fields little-endian:
+ *
+ *   'I' ver, width u16, height u16, tile bytes, tile rows, flags
+ *   'F' seq, flags, tile count, then per tile: index, length, RLE data
+ *   'K' (in) send a key frame
+ *   'T' (in) x u16, y u16, pressed: a touch sample
+ *   'P' (in) key, pressed: a TCA8418 key number, as keymap.h
+ *
+ * The image is panel RAM: 1bpp, MSB first, 1 = white, rows bottom-up
+ * (SCREEN_MIRROR_FLAG_MIRROR_Y), so flipped it is the physical screen, and
+ * touches are in that screen's pixels, as the touch controller reports
+ * them. Tiles are numbered across, then down. A key frame ('F' with
+ * SCREEN_MIRROR_FLAG_KEY) is XORed against zeros: the receiver clears its
+ * copy first. It follows an 'I', and goes out on a 'K' and whenever a
+ * transport is switched on. A frame too long for one message is split at
+ * tile boundaries; its last message has SCREEN_MIRROR_FLAG_LAST. Deltas
+ * stack on each other, so a receiver that sees seq skip sends a 'K'.
+ *
+ * RLE control byte: 0xxxxxxx is x+1 zero bytes, 10xxxxxx x+1 literal
+ * bytes following, 11xxxxxx x+1 copies of the next byte.
+ *
+ * Transports: on USB the messages travel both ways on the usb_console's
+ * mirror channel, once the host has opened it; the host then sends a 'K'.
+ * On MQTT the messages are published to SCREEN_MIRROR_TOPIC as they are,
+ * and input is read from SCREEN_MIRROR_TOPIC_IN (EventBridge
+ * MQTT_MESSAGE_RECEIVED).
+ *
+ * Input goes into the same queues as the hardware: touch samples into the
+ * touch pipeline, keys through the keymap, both taken on the UI task by
+ * lvgl_integration.
+ *
+ * Config section "mirror": usb, mqtt (both off).
+ */
+
+#define SCREEN_MIRROR_TILE_BYTES    5       // 40 px
+#define SCREEN_MIRROR_TILE_ROWS     16
+#define SCREEN_MIRROR_MSG_MAX       480     // Under MAX_MQTT_MESSAGE_SIZE and USB_CONSOLE_FRAME_MAX
+#define SCREEN_MIRROR_TOUCH_QUEUE   16      // Power of two
+#define SCREEN_MIRROR_KEY_QUEUE     16      // Power of two
+#define SCREEN_MIRROR_TOPIC         "tdeckpro/%s/mirror"
+#define SCREEN_MIRROR_TOPIC_IN      "tdeckpro/%s/mirror/in"
+#define SCREEN_MIRROR_TASK_STACK    4096
+#define SCREEN_MIRROR_TASK_PRIORITY 1
+
+#define SCREEN_MIRROR_VERSION       1
+#define SCREEN_MIRROR_FLAG_KEY      0x01
+#define SCREEN_MIRROR_FLAG_LAST     0x02
+#define SCREEN_MIRROR_FLAG_MIRROR_Y 0x04
+
+enum ScreenMirrorTransport {
+    SCREEN_MIRROR_USB  = 1 << 0,
+    SCREEN_MIRROR_MQTT = 1 << 1,
+};
+
+struct ScreenMirrorStats {
+    uint8_t transports;
+    uint32_t frames;                // Panel updates taken
+    uint32_t sent;                  // Of them, the ones that changed a tile
+    uint32_t key_frames;
+    uint32_t messages;
+    uint32_t bytes;                 // Payload, before USB framing
+    uint32_t last_bytes;            // The last frame
+    uint16_t last_tiles;
+    uint32_t touches;
+    uint32_t keys;
+    uint32_t rejected;              // Bad input messages, or a full queue
+};
+
+/**
+ * @brief Start with the transports switched on in config; false if none are
+ */
+bool screen_mirror_begin();
+
+/**
+ * @brief Switch transports at run time (ScreenMirrorTransport bits), starting
+ *        the service on first use. Each newly on transport gets a key frame
+ */
+bool screen_mirror_set_transports(uint8_t mask);
+
+/**
+ * @brief Flush task: the frame just put on the glass, panel RAM layout
+ */
+void screen_mirror_frame(const uint8_t *fb);
+
+/**
+ * @brief No frame taken yet: the UI task hands over the one on the glass
+ *        while the flush task is idle
+ */
+bool screen_mirror_wants_frame();
+
+void screen_mirror_request_key_frame();
+
+/**
+ * @brief UI task: remote input, in the queues' order
+ */
+bool screen_mirror_take_touch(int16_t *x, int16_t *y, bool *pressed);
+bool screen_mirror_take_key(keypad_event_t *ev);
+bool screen_mirror_key_pending();
+
+void screen_mirror_get_stats(ScreenMirrorStats *stats);
+
+#endif // SCREEN_MIRROR_H
@@ -0,0 +1,401 @@
+/**
+ * @file      sd_manager.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     SD card mounting at the fastest clock it holds, hot-plug and safe eject
+ */
+
+#include "sd_manager.h"
+#include "simple_logger.h"
+#include "utilities.h"
+#include "spi_bus.h"
+#include "fs_service.h"
+#include <SD.h>
+#include <Preferences.h>
+#include <esp_rom_crc.h>
+extern "C" {
+#include "ff.h"
+#include "diskio.h"
+#include "diskio_impl.h"
+}
+#ifdef INTEGRATION_LAYER_ENABLED
+#include "integration/event_bridge.h"
+#endif
+
+// Whole divisors of 80 MHz, fastest first; the last is the safe default.
+// Over the GPIO matrix reads usually stop holding above 80 / 3
+static const uint32_t sd_clocks[] = {
+    40000000, 26666666, 20000000, 16000000, 10000000, SPI_BUS_SD_HZ,
+};
+
+struct SdCardRecord {
+    uint32_t magic;
+    uint32_t sectors;
+    uint32_t hz;
+    uint8_t card_type;
+    uint32_t crc;
+};
+
+typedef struct {
+    const char *name;
+    sd_client_fn attach;
+    sd_client_fn detach;
+} sd_client_t;
+
+static TaskHandle_t sd_task_handle = NULL;
+static SemaphoreHandle_t sd_lock = NULL;        // Mount and unmount
+static volatile SdState sd_state = SD_STATE_ABSENT;
+static SdCardRecord sd_card;                    // The mounted card, else the last one
+static sd_client_t sd_clients[SD_MANAGER_CLIENTS];
+static uint8_t sd_client_count = 0;
+static uint8_t sd_misses = 0;
+static sd_manager_stats_t sd_stats;
+static uint8_t sd_sector[512];
+
+// SDFS keeps its FatFs drive number to itself; sector runs go to the
+// driver under it, which reads and writes multi-block
+struct SdDrive : fs::SDFS {
+    static uint8_t of(fs::SDFS &sd) { return sd.*(&SdDrive::_pdrv); }
+};
+
+static uint32_t record_crc(const SdCardRecord *r) {
+    return esp_rom_crc32_le(0, (const uint8_t *)r, offsetof(SdCardRecord, crc));
+}
+
+static bool load_record(SdCardRecord *r) {
+    Preferences prefs;
+    if (!prefs.begin(SD_MANAGER_NVS_NAMESPACE, true)) {
+        return false;
+    }
+    bool ok = prefs.getBytes("card", r, sizeof(*r)) == sizeof(*r) &&
+              r->magic == SD_MANAGER_MAGIC && r->crc == record_crc(r);
+    prefs.end();
+    return ok;
+}
+
+// Only when the card or its clock changed
+static void store_record(const SdCardRecord *r) {
+    SdCardRecord stored;
+    if (load_record(&stored) && stored.sectors == r->sectors && stored.hz == r->hz &&
+        stored.card_type == r->card_type) {
+        return;
+    }
+    Preferences prefs;
+    if (prefs.begin(SD_MANAGER_NVS_NAMESPACE, false)) {
+        prefs.putBytes("card", r, sizeof(*r));
+        prefs.end();
+    }
+}
+
+// Sector 0, MBR or boot sector, twice alike and signed
+static bool check_card() {
+    if (!SD.readRAW(sd_sector, 0) || sd_sector[510] != 0x55 || sd_sector[511] != 0xAA) {
+        return false;
+    }
+    uint32_t crc = esp_rom_crc32_le(0, sd_sector, sizeof(sd_sector));
+    return SD.readRAW(sd_sector, 0) && esp_rom_crc32_le(0, sd_sector, sizeof(sd_sector)) == crc;
+}
+
+// Bus held
+static bool try_clock(uint32_t hz, bool check) {
+    sd_stats.probes++;
+    spi_bus_set_clock(SPI_CLIENT_SD, hz);
+    if (!SD.begin(BOARD_SD_CS, SPI, hz)) {
+        return false;
+    }
+    if (!check || check_card()) {
+        return true;
+    }
+    sd_stats.fallbacks++;
+    SD.end();
+    return false;
+}
+
+static bool same_card(const SdCardRecord *r) {
+    return SD.numSectors() == r->sectors && SD.cardType() == r->card_type;
+}
+
+// Bus held. The remembered card at its clock, else whatever is in the slot
+// down the ladder
+static uint32_t mount_card() {
+    SdCardRecord rec;
+    if (load_record(&rec)) {
+        if (try_clock(rec.hz, true)) {
+            if (same_card(&rec)) {
+                return rec.hz;
+            }
+            SD.end();
+        }
+    }
+    // Anything there at all? Bringing up an empty slot is slow, so once
+    if (!try_clock(SPI_BUS_SD_HZ, false)) {
+        return 0;
+    }
+    SD.end();
+    for (size_t i = 0; i < sizeof(sd_clocks) / sizeof(sd_clocks[0]); i++) {
+        if (try_clock(sd_clocks[i], true)) {
+            return sd_clocks[i];
+        }
+    }
+    return 0;
+}
+
+static void publish(bool inserted) {
+#ifdef INTEGRATION_LAYER_ENABLED
+    if (GlobalEventBridge) {
+        SdCardEvent ev = {sd_card.sectors, sd_card.hz, sd_card.card_type};
+        GlobalEventBridge->publishTypedEvent(inserted ? EventType::SD_CARD_INSERTED : EventType::SD_CARD_REMOVED,
+                                             "SD", ev, EventPriority::EVENT_HIGH);
+    }
+#endif
+}
+
+static void run_clients(bool attach) {
+    for (uint8_t i = 0; i < sd_client_count; i++) {
+        sd_client_fn fn = attach ? sd_clients[i].attach : sd_clients[i].detach;
+        if (fn) {
+            fn();
+        }
+    }
+}
+
+// Under sd_lock
+static bool mount_locked() {
+    uint32_t start = millis();
+    uint32_t hz;
+    {
+        SpiBusHold bus(SPI_CLIENT_SD);
+        hz = mount_card();
+        if (hz) {
+            sd_card.magic = SD_MANAGER_MAGIC;
+            sd_card.sectors = SD.numSectors();
+            sd_card.card_type = SD.cardType();
+            sd_card.hz = hz;
+            sd_card.crc = record_crc(&sd_card);
+        } else {
+            spi_bus_set_clock(SPI_CLIENT_SD, SPI_BUS_SD_HZ);
+        }
+    }
+    if (!hz) {
+        return false;
+    }
+    store_record(&sd_card);
+    sd_state = SD_STATE_MOUNTED;
+    sd_misses = 0;
+    sd_stats.mounts++;
+    sd_stats.hz = hz;
+    sd_stats.mount_ms_last = millis() - start;
+    LOG_INFOF("SD", "Mounted %luMB at %lu kHz in %lu ms",
+              (unsigned long)(sd_card.sectors / 2048), (unsigned long)(hz / 1000),
+              (unsigned long)sd_stats.mount_ms_last);
+
+    fs_card_changed();
+    fs_capacity(NULL, NULL);
+    run_clients(true);
+    publish(true);
+    return true;
+}
+
+// Under sd_lock. Clients flush first on an eject; after a removal there is
+// nothing left to flush to and they only let go
+static void unmount_locked(SdState next) {
+    if (next == SD_STATE_EJECTED) {
+        run_clients(false);
+    }
+    {
+        SpiBusHold bus(SPI_CLIENT_SD);
+        SD.end();
+    }
+    sd_state = next;
+    fs_card_changed();
+    if (next == SD_STATE_ABSENT) {
+        sd_stats.removals++;
+        LOG_WARN("SD", "Card removed");
+        run_clients(false);
+    } else {
+        LOG_INFO("SD", "Card ejected");
+    }
+    publish(false);
+}
+
+static void poll() {
+    xSemaphoreTake(sd_lock, portMAX_DELAY);
+    switch (sd_state) {
+    case SD_STATE_MOUNTED: {
+        bool there;
+        {
+            SpiBusHold bus(SPI_CLIENT_SD);
+            there = SD.readRAW(sd_sector, 0);
+        }
+        // One failed read can be noise on the bus
+        sd_misses = there ? 0 : sd_misses + 1;
+        if (sd_misses >= 2) {
+            unmount_locked(SD_STATE_ABSENT);
+        }
+        break;
+    }
+    case SD_STATE_ABSENT:
+        mount_locked();
+        break;
+    case SD_STATE_LENT:
+        // The borrower sees its own errors and gives the card back
+        break;
+    case SD_STATE_EJECTED: {
+        // Still in the slot until a bring-up fails
+        SpiBusHold bus(SPI_CLIENT_SD);
+        if (SD.begin(BOARD_SD_CS, SPI, SPI_BUS_SD_HZ)) {
+            SD.end();
+        } else {
+            sd_state = SD_STATE_ABSENT;
+        }
+        break;
+    }
+    }
+    xSemaphoreGive(sd_lock);
+}
+
+static void sd_task(void *param) {
+    while (1) {
+        vTaskDelay(pdMS_TO_TICKS(sd_state == SD_STATE_MOUNTED ? SD_MANAGER_POLL_MS : SD_MANAGER_RETRY_MS));
+        poll();
+    }
+}
+
+bool sd_manager_begin() {
+    if (sd_task_handle) {
+        return sd_state == SD_STATE_MOUNTED;
+    }
+    sd_lock = xSemaphoreCreateMutex();
+    if (!sd_lock) {
+        LOG_ERROR("SD", "Failed to create the mount lock");
+        return false;
+    }
+    fs_service_begin();
+
+    xSemaphoreTake(sd_lock, portMAX_DELAY);
+    bool mounted = mount_locked();
+    xSemaphoreGive(sd_lock);
+    if (!mounted) {
+        LOG_WARN("SD", "No card, watching the slot");
+    }
+
+    if (xTaskCreate(sd_task, "sdmgr", SD_MANAGER_TASK_STACK, NULL, SD_MANAGER_TASK_PRIORITY,
+                    &sd_task_handle) != pdPASS) {
+        LOG_ERROR("SD", "Failed to start the slot watcher");
+    }
+    return mounted;
+}
+
+bool sd_manager_mounted() {
+    return sd_state == SD_STATE_MOUNTED;
+}
+
+SdState sd_manager_state() {
+    return sd_state;
+}
+
+bool sd_manager_add_client(const char *name, sd_client_fn attach, sd_client_fn detach) {
+    if (sd_client_count >= SD_MANAGER_CLIENTS) {
+        LOG_WARNF("SD", "No room for client %s", name);
+        return false;
+    }
+    sd_clients[sd_client_count].name = name;
+    sd_clients[sd_client_count].attach = attach;
+    sd_clients[sd_client_count].detach = detach;
+    sd_client_count++;
+    return true;
+}
+
+bool sd_manager_eject() {
+    if (!sd_lock) {
+        return false;
+    }
+    xSemaphoreTake(sd_lock, portMAX_DELAY);
+    bool ok = sd_state == SD_STATE_MOUNTED;
+    if (ok) {
+        unmount_locked(SD_STATE_EJECTED);
+    }
+    xSemaphoreGive(sd_lock);
+    return ok;
+}
+
+bool sd_manager_mount() {
+    if (!sd_lock) {
+        return false;
+    }
+    xSemaphoreTake(sd_lock, portMAX_DELAY);
+    bool ok = sd_state == SD_STATE_MOUNTED || mount_locked();
+    xSemaphoreGive(sd_lock);
+    return ok;
+}
+
+uint32_t sd_manager_lend() {
+    if (!sd_lock) {
+        return 0;
+    }
+    xSemaphoreTake(sd_lock, portMAX_DELAY);
+    uint32_t sectors = 0;
+    if (sd_state == SD_STATE_MOUNTED) {
+        // Clients flush and close as for an eject; the volume stays mounted
+        // underneath so the card keeps its clock, but nothing opens files
+        run_clients(false);
+        sd_state = SD_STATE_LENT;
+        fs_card_changed();
+        sectors = sd_card.sectors;
+        LOG_INFOF("SD", "Card lent out, %lu sectors", (unsigned long)sectors);
+        publish(false);
+    }
+    xSemaphoreGive(sd_lock);
+    return sectors;
+}
+
+bool sd_manager_reclaim() {
+    if (!sd_lock) {
+        return false;
+    }
+    xSemaphoreTake(sd_lock, portMAX_DELAY);
+    bool ok = false;
+    if (sd_state == SD_STATE_LENT) {
+        {
+            SpiBusHold bus(SPI_CLIENT_SD);
+            SD.end();
+        }
+        sd_state = SD_STATE_ABSENT;
+        ok = mount_locked();
+        if (!ok) {
+            LOG_WARN("SD", "Card did not come back from its loan");
+        }
+    }
+    xSemaphoreGive(sd_lock);
+    return ok;
+}
+
+bool sd_manager_read_sectors(uint8_t *buf, uint32_t lba, uint32_t count) {
+    if (sd_state != SD_STATE_LENT) {
+        return false;
+    }
+    SpiBusHold bus(SPI_CLIENT_SD);
+    return disk_read(SdDrive::of(SD), buf, lba, count) == RES_OK;
+}
+
+bool sd_manager_write_sectors(const uint8_t *buf, uint32_t lba, uint32_t count) {
+    if (sd_state != SD_STATE_LENT) {
+        return false;
+    }
+    SpiBusHold bus(SPI_CLIENT_SD);
+    return disk_write(SdDrive::of(SD), buf, lba, count) == RES_OK;
+}
+
+bool sd_manager_sync() {
+    if (sd_state != SD_STATE_LENT) {
+        return false;
+    }
+    SpiBusHold bus(SPI_CLIENT_SD);
+    return disk_ioctl(SdDrive::of(SD), CTRL_SYNC, NULL) == RES_OK;
+}
+
+void sd_manager_get_stats(sd_manager_stats_t *stats) {
+    *stats = sd_stats;
+}
@@ -0,0 +1,118 @@
+/**
+ * @file      sd_manager.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     SD card mounting at the fastest clock it holds, hot-plug and safe eject
+ */
+
+#ifndef SD_MANAGER_H
+#define SD_MANAGER_H
+
+#include <Arduino.h>
+
+/**
+ * The slot has no card-detect line, so a task checks for the card: a
+ * mounted card by reading its first sector, an empty slot by trying to
+ * bring a card up. A new card is probed down a ladder of clocks, whole
+ * divisors of the 80 MHz APB, until a sector reads back twice the same
+ * with its boot signature. The card's size, type and the clock that held
+ * are kept in NVS, so the same card mounts straight at that clock at boot
+ * and on reinsertion.
+ *
+ * Modules writing to the card register as clients: detach runs before an
+ * eject unmounts and after a card has gone, attach after each mount.
+ * SD_CARD_INSERTED and SD_CARD_REMOVED carry an SdCardEvent
+ *
+ * The card can be lent out whole for raw sector access (USB mass storage):
+ * the clients detach as for an eject and the manager stops looking at the
+ * slot, but the card stays up at its clock. Taking it back mounts it
+ * afresh, since the borrower may have rewritten the FAT under FatFs
+ */
+
+#define SD_MANAGER_POLL_MS          1000    // Mounted: is the card still there
+#define SD_MANAGER_RETRY_MS         3000    // Empty slot: try to bring a card up
+#define SD_MANAGER_CLIENTS          6
+#define SD_MANAGER_TASK_STACK       (1024 * 4)
+#define SD_MANAGER_TASK_PRIORITY    (tskIDLE_PRIORITY + 1)
+#define SD_MANAGER_MAGIC            0x43445344UL  // "DSDC"
+#define SD_MANAGER_NVS_NAMESPACE    "sdmgr"
+
+enum SdState {
+    SD_STATE_ABSENT = 0,
+    SD_STATE_MOUNTED,
+    SD_STATE_EJECTED,           // Unmounted on request; automatic mounts resume once the card is out
+    SD_STATE_LENT,              // Out for raw sector access; no files until it comes back
+};
+
+struct SdCardEvent {
+    uint32_t sectors;
+    uint32_t hz;
+    uint8_t card_type;          // sdcard_type_t
+};
+
+typedef void (*sd_client_fn)(void);
+
+typedef struct {
+    uint32_t mounts;
+    uint32_t removals;          // Cards that went without an eject
+    uint32_t probes;            // Clocks tried, across all mounts
+    uint32_t fallbacks;         // Clocks that failed their check
+    uint32_t mount_ms_last;
+    uint32_t hz;
+} sd_manager_stats_t;
+
+/**
+ * @brief Mount a card if there is one, then start watching the slot. Call
+ *        once SPI and spi_bus are up
+ * @return true if a card is mounted
+ */
+bool sd_manager_begin();
+
+bool sd_manager_mounted();
+SdState sd_manager_state();
+
+/**
+ * @brief Register a module that writes to the card. Either callback may be
+ *        NULL. Both run in the manager's task, or the caller's for eject
+ */
+bool sd_manager_add_client(const char *name, sd_client_fn attach, sd_client_fn detach);
+
+/**
+ * @brief Flush the clients and unmount, so the card can be pulled
+ */
+bool sd_manager_eject();
+
+/**
+ * @brief Mount again after an eject, without pulling the card
+ */
+bool sd_manager_mount();
+
+/**
+ * @brief Detach the clients and hand the mounted card over for sector
+ *        access
+ * @return The card's size in 512-byte sectors, 0 if none is mounted
+ */
+uint32_t sd_manager_lend();
+
+/**
+ * @brief End a loan: mount the card again and reattach the clients
+ */
+bool sd_manager_reclaim();
+
+/**
+ * @brief While lent: count sectors from lba, in one multi-block command.
+ *        Holds spi_bus for the transfer
+ */
+bool sd_manager_read_sectors(uint8_t *buf, uint32_t lba, uint32_t count);
+bool sd_manager_write_sectors(const uint8_t *buf, uint32_t lba, uint32_t count);
+
+/**
+ * @brief While lent: wait for the card to finish programming
+ */
+bool sd_manager_sync();
+
+void sd_manager_get_stats(sd_manager_stats_t *stats);
+
+#endif // SD_MANAGER_H
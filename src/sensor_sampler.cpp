@@ -0,0 +1,335 @@
+/**
+ * @file      sensor_sampler.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Sensors sampled in the background at their own rates into versioned snapshots
+ */
+
+#include "sensor_sampler.h"
+#include "factory.h"
+#include "i2c_bus.h"
+#include "peripheral.h"
+#include "timer_wheel.h"
+#include "usb_console.h"
+#include "simple_logger.h"
+#ifdef INTEGRATION_LAYER_ENABLED
+#include "integration/config_manager.h"
+#endif
+
+#define LTR553_ALS_DATA_CH1_0       0x88    // CH1, CH0, status, PS, one run
+
+struct SensorDef {
+    const char *name;
+    int peri;                       // E_PERI_*
+    int dev;                        // I2C_DEV_*, -1 for none
+    uint32_t period_ms;             // Default
+    bool idles;                     // Stops without a reader
+};
+
+struct SensorState {
+    WheelTimer timer;
+    uint32_t period_ms;             // 0: stopped
+    volatile bool pending;          // Reads queued, completion not in yet
+    volatile bool idle;
+    volatile uint32_t read_ms;      // Last reader
+};
+
+static const SensorDef sensor_defs[SENSOR_COUNT] = {
+    { "gauge",  E_PERI_BQ27220,    I2C_DEV_BQ27220, SENSOR_GAUGE_MS,  false },
+    { "light",  E_PERI_LTR_553ALS, I2C_DEV_LTR553,  SENSOR_LIGHT_MS,  true  },
+    { "motion", E_PERI_BHI260AP,   -1,              SENSOR_MOTION_MS, true  },
+};
+
+static portMUX_TYPE sensor_mux = portMUX_INITIALIZER_UNLOCKED;
+static SensorState sensor_state[SENSOR_COUNT];
+static SensorSamplerStats sensor_stats;
+static SensorGauge sensor_gauge;
+static SensorLight sensor_light;
+static SensorMotion sensor_motion;
+static bool sensor_running = false;
+
+// Raw registers, owned by the bus task while a read is pending
+static uint8_t gauge_raw[8];        // Temperature, voltage, battery status, current
+static uint8_t gauge_cap[4];        // Remaining, full charge
+static uint8_t gauge_soc[4];        // State of charge, of health
+static uint8_t gauge_design[2];
+static uint8_t light_raw[7];        // CH1, CH0, status, PS
+
+static const i2c_bus_op_t gauge_ops[] = {
+    { CommandTemperature, sizeof(gauge_raw), gauge_raw },
+    { CommandRemainingCapacity, sizeof(gauge_cap), gauge_cap },
+    { CommandStateOfCharge, sizeof(gauge_soc), gauge_soc },
+    { CommandDesignCapacity, sizeof(gauge_design), gauge_design },
+};
+
+static const i2c_bus_op_t light_ops[] = {
+    { LTR553_ALS_DATA_CH1_0, sizeof(light_raw), light_raw },
+};
+
+static inline uint16_t le16(const uint8_t *p) {
+    return p[0] | (p[1] << 8);
+}
+
+// ===== Decode =====
+
+static void publish_gauge() {
+    SensorGauge g;
+    g.temp_dk = le16(&gauge_raw[0]);
+    g.mv = le16(&gauge_raw[2]);
+    g.status = le16(&gauge_raw[4]);
+    g.ma = (int16_t)le16(&gauge_raw[6]);
+    g.remain_mah = le16(&gauge_cap[0]);
+    g.full_mah = le16(&gauge_cap[2]);
+    g.soc = min(le16(&gauge_soc[0]), (uint16_t)100);
+    g.soh = min(le16(&gauge_soc[2]), (uint16_t)100);
+    g.design_mah = le16(gauge_design);
+    // As the driver has it: DSG clear is charging, and done once no current flows either
+    bool dsg = g.status & 0x0001;
+    g.charging = !dsg;
+    g.charge_done = !(dsg || g.ma);
+    g.time_ms = millis();
+    portENTER_CRITICAL(&sensor_mux);
+    g.version = sensor_gauge.version + 1;
+    sensor_gauge = g;
+    portEXIT_CRITICAL(&sensor_mux);
+}
+
+static void publish_light() {
+    SensorLight l;
+    l.ch1 = le16(&light_raw[0]);
+    l.ch0 = le16(&light_raw[2]);
+    l.ps = light_raw[5] | ((light_raw[6] & 0x07) << 8);
+    l.ps_saturated = light_raw[6] & 0x80;
+    l.time_ms = millis();
+    portENTER_CRITICAL(&sensor_mux);
+    l.version = sensor_light.version + 1;
+    sensor_light = l;
+    portEXIT_CRITICAL(&sensor_mux);
+}
+
+static void publish_motion() {
+    SensorMotion m;
+    BHI260AP_get_val(1, &m.accel[0], &m.accel[1], &m.accel[2]);
+    BHI260AP_get_val(2, &m.gyro[0], &m.gyro[1], &m.gyro[2]);
+    m.time_ms = millis();
+    portENTER_CRITICAL(&sensor_mux);
+    m.version = sensor_motion.version + 1;
+    sensor_motion = m;
+    sensor_stats.samples[SENSOR_MOTION]++;
+    portEXIT_CRITICAL(&sensor_mux);
+}
+
+// ===== Sampling =====
+
+// On the bus task
+static void read_done(int dev, bool ok, void *ctx) {
+    int id = (int)(intptr_t)ctx;
+    if (ok) {
+        if (id == SENSOR_GAUGE) {
+            publish_gauge();
+        } else {
+            publish_light();
+        }
+    }
+    portENTER_CRITICAL(&sensor_mux);
+    if (ok) {
+        sensor_stats.samples[id]++;
+    } else {
+        sensor_stats.errors[id]++;
+    }
+    portEXIT_CRITICAL(&sensor_mux);
+    sensor_state[id].pending = false;
+}
+
+static void sample(WheelTimer *timer) {
+    int id = (int)(intptr_t)timer->ctx;
+    const SensorDef *def = &sensor_defs[id];
+    SensorState *s = &sensor_state[id];
+
+    if (def->idles && millis() - s->read_ms > SENSOR_IDLE_MS) {
+        portENTER_CRITICAL(&sensor_mux);
+        s->idle = true;
+        portEXIT_CRITICAL(&sensor_mux);
+        timer_wheel_cancel(timer);
+        return;
+    }
+    if (!peri_init_ready(def->peri)) {
+        return;
+    }
+    if (def->dev < 0) {
+        publish_motion();
+        return;
+    }
+    if (s->pending) {
+        portENTER_CRITICAL(&sensor_mux);
+        sensor_stats.skipped[id]++;
+        portEXIT_CRITICAL(&sensor_mux);
+        return;
+    }
+    s->pending = true;
+    const i2c_bus_op_t *ops = id == SENSOR_GAUGE ? gauge_ops : light_ops;
+    uint8_t count = id == SENSOR_GAUGE ? sizeof(gauge_ops) / sizeof(gauge_ops[0]) : 1;
+    if (!i2c_bus_read_async(def->dev, ops, count, read_done, (void *)(intptr_t)id)) {
+        s->pending = false;
+        portENTER_CRITICAL(&sensor_mux);
+        sensor_stats.errors[id]++;
+        portEXIT_CRITICAL(&sensor_mux);
+    }
+}
+
+// A reader of an idle sensor starts it, sampling at once
+static void note_reader(int id) {
+    SensorState *s = &sensor_state[id];
+    s->read_ms = millis();
+    if (!s->idle || !sensor_running) {
+        return;
+    }
+    portENTER_CRITICAL(&sensor_mux);
+    bool wake = s->idle && s->period_ms;
+    s->idle = false;
+    portEXIT_CRITICAL(&sensor_mux);
+    if (wake) {
+        timer_wheel_arm(&s->timer, 1, s->period_ms);
+    }
+}
+
+// ===== Console =====
+
+static void rpc_sensors(Print &out, const char *args) {
+    if (args[0]) {
+        char name[8] = {0};
+        unsigned long ms = 0;
+        if (sscanf(args, "%7s %lu", name, &ms) == 2) {
+            for (int i = 0; i < SENSOR_COUNT; i++) {
+                if (!strcmp(name, sensor_defs[i].name)) {
+                    sensor_sampler_set_period(i, ms);
+                    out.println("ok");
+                    return;
+                }
+            }
+        }
+        out.println("usage: sensors [gauge|light|motion <ms>]");
+        return;
+    }
+    SensorSamplerStats st;
+    sensor_sampler_get_stats(&st);
+    for (int i = 0; i < SENSOR_COUNT; i++) {
+        out.printf("%-6s every %5lu ms%s: %lu samples, %lu errors, %lu skipped\n", sensor_defs[i].name,
+                   (unsigned long)st.period_ms[i], st.idle[i] ? " (idle)" : "", (unsigned long)st.samples[i],
+                   (unsigned long)st.errors[i], (unsigned long)st.skipped[i]);
+    }
+    uint32_t now = millis();
+    SensorGauge g;
+    SensorLight l;
+    SensorMotion m;
+    // Peek without counting as a reader, so the console does not keep them awake
+    portENTER_CRITICAL(&sensor_mux);
+    g = sensor_gauge;
+    l = sensor_light;
+    m = sensor_motion;
+    portEXIT_CRITICAL(&sensor_mux);
+    if (g.version) {
+        out.printf("gauge  v%lu, %lu ms ago: %u mV, %d mA, %u%%, %u/%u mAh, %.1f C%s\n", (unsigned long)g.version,
+                   (unsigned long)(now - g.time_ms), g.mv, g.ma, g.soc, g.remain_mah, g.full_mah,
+                   (g.temp_dk - 2732) / 10.0f, g.charge_done ? ", charged" : g.charging ? ", charging" : "");
+    }
+    if (l.version) {
+        out.printf("light  v%lu, %lu ms ago: ch0 %u, ch1 %u, ps %u%s\n", (unsigned long)l.version,
+                   (unsigned long)(now - l.time_ms), l.ch0, l.ch1, l.ps, l.ps_saturated ? " (saturated)" : "");
+    }
+    if (m.version) {
+        out.printf("motion v%lu, %lu ms ago: accel %.2f %.2f %.2f, gyro %.2f %.2f %.2f\n", (unsigned long)m.version,
+                   (unsigned long)(now - m.time_ms), m.accel[0], m.accel[1], m.accel[2], m.gyro[0], m.gyro[1],
+                   m.gyro[2]);
+    }
+}
+
+// ===== API =====
+
+bool sensor_sampler_begin() {
+    if (sensor_running) {
+        return true;
+    }
+    for (int i = 0; i < SENSOR_COUNT; i++) {
+        SensorState *s = &sensor_state[i];
+        s->period_ms = sensor_defs[i].period_ms;
+#ifdef INTEGRATION_LAYER_ENABLED
+        char key[16];
+        snprintf(key, sizeof(key), "%s_ms", sensor_defs[i].name);
+        s->period_ms = GET_CONFIG_INT("sensors", key, sensor_defs[i].period_ms);
+#endif
+        if (s->period_ms && s->period_ms < SENSOR_PERIOD_MIN_MS) {
+            s->period_ms = SENSOR_PERIOD_MIN_MS;
+        }
+        s->idle = sensor_defs[i].idles;
+        timer_wheel_init(&s->timer, sensor_defs[i].name, sample, (void *)(intptr_t)i);
+    }
+    usb_console_rpc("sensors", rpc_sensors);
+    sensor_running = true;
+    for (int i = 0; i < SENSOR_COUNT; i++) {
+        SensorState *s = &sensor_state[i];
+        if (s->period_ms && (!s->idle || (s->read_ms && millis() - s->read_ms <= SENSOR_IDLE_MS))) {
+            s->idle = false;        // Read before we were up
+            timer_wheel_arm(&s->timer, 1, s->period_ms);
+        }
+    }
+    LOG_INFOF("Sensors", "Sampling gauge every %lu ms, light %lu ms and motion %lu ms while read",
+              (unsigned long)sensor_state[SENSOR_GAUGE].period_ms, (unsigned long)sensor_state[SENSOR_LIGHT].period_ms,
+              (unsigned long)sensor_state[SENSOR_MOTION].period_ms);
+    return true;
+}
+
+bool sensor_get_gauge(SensorGauge *out) {
+    note_reader(SENSOR_GAUGE);
+    portENTER_CRITICAL(&sensor_mux);
+    *out = sensor_gauge;
+    portEXIT_CRITICAL(&sensor_mux);
+    return out->version != 0;
+}
+
+bool sensor_get_light(SensorLight *out) {
+    note_reader(SENSOR_LIGHT);
+    portENTER_CRITICAL(&sensor_mux);
+    *out = sensor_light;
+    portEXIT_CRITICAL(&sensor_mux);
+    return out->version != 0;
+}
+
+bool sensor_get_motion(SensorMotion *out) {
+    note_reader(SENSOR_MOTION);
+    portENTER_CRITICAL(&sensor_mux);
+    *out = sensor_motion;
+    portEXIT_CRITICAL(&sensor_mux);
+    return out->version != 0;
+}
+
+void sensor_sampler_set_period(uint8_t id, uint32_t period_ms) {
+    if (id >= SENSOR_COUNT) {
+        return;
+    }
+    SensorState *s = &sensor_state[id];
+    if (period_ms && period_ms < SENSOR_PERIOD_MIN_MS) {
+        period_ms = SENSOR_PERIOD_MIN_MS;
+    }
+    s->period_ms = period_ms;
+    if (!sensor_running) {
+        return;
+    }
+    if (!period_ms) {
+        timer_wheel_cancel(&s->timer);
+    } else if (!s->idle) {
+        timer_wheel_arm(&s->timer, period_ms, period_ms);
+    }
+}
+
+void sensor_sampler_get_stats(SensorSamplerStats *out) {
+    portENTER_CRITICAL(&sensor_mux);
+    *out = sensor_stats;
+    for (int i = 0; i < SENSOR_COUNT; i++) {
+        out->period_ms[i] = sensor_state[i].period_ms;
+        out->idle[i] = sensor_state[i].idle;
+    }
+    portEXIT_CRITICAL(&sensor_mux);
+}
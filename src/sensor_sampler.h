@@ -0,0 +1,113 @@
+/**
+ * @file      sensor_sampler.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Sensors sampled in the background at their own rates into versioned snapshots
+ */
+
+#ifndef SENSOR_SAMPLER_H
+#define SENSOR_SAMPLER_H
+
+#include <Arduino.h>
+
+/**
+ * Each sensor has a timer on the wheel at its configured period. The
+ * timer queues the sensor's register reads on the I2C scheduler
+ * (i2c_bus_read_async) and returns. The completion decodes them into the
+ * sensor's snapshot on the bus task and bumps its version. Readers copy a
+ * snapshot under a spinlock and never touch the bus, so an LVGL timer can
+ * read one every frame. Comparing version with the last copy says whether
+ * anything changed.
+ *
+ * A sensor is sampled only once its peripheral is up (peri_init_ready).
+ * Bringing it up stays with whoever needs it, as before. A sample still in
+ * flight when the next one is due is skipped, not queued behind it.
+ *
+ * The fuel gauge runs all the time: the status bar, tsdb, the forecast
+ * and BLE status all read it. Light and motion are UI-only. They stop
+ * after SENSOR_IDLE_MS without a reader, and the next read takes one
+ * sample at once, which that reader sees on its following read.
+ * Motion costs no bus traffic: the sensor hub's task already keeps the
+ * latest values, and the sampler copies them at its rate.
+ *
+ * Console: "sensors" for the snapshots and counters, "sensors <name> <ms>"
+ * to change a period (0 stops the sensor).
+ * Config section "sensors": gauge_ms (10000), light_ms (1000), motion_ms (200).
+ */
+
+#define SENSOR_GAUGE_MS             10000
+#define SENSOR_LIGHT_MS             1000
+#define SENSOR_MOTION_MS            200
+#define SENSOR_PERIOD_MIN_MS        50
+#define SENSOR_IDLE_MS              30000   // Without a reader, light and motion stop
+
+enum SensorId {
+    SENSOR_GAUGE = 0,               // BQ27220
+    SENSOR_LIGHT,                   // LTR553
+    SENSOR_MOTION,                  // BHI260AP, from the hub task's copy
+    SENSOR_COUNT,
+};
+
+struct SensorGauge {
+    uint32_t version;               // 0: not sampled yet
+    uint32_t time_ms;               // millis() of the sample
+    uint16_t mv;
+    int16_t ma;                     // Negative discharging
+    uint16_t temp_dk;               // 0.1 K
+    uint16_t status;                // BatteryStatus
+    uint16_t remain_mah;
+    uint16_t full_mah;
+    uint16_t design_mah;
+    uint8_t soc;                    // %
+    uint8_t soh;                    // %
+    bool charging;
+    bool charge_done;
+};
+
+struct SensorLight {
+    uint32_t version;
+    uint32_t time_ms;
+    uint16_t ch0;                   // Visible and IR
+    uint16_t ch1;                   // IR
+    uint16_t ps;                    // Proximity, 11 bits
+    bool ps_saturated;
+};
+
+struct SensorMotion {
+    uint32_t version;
+    uint32_t time_ms;
+    float accel[3];                 // m/s^2
+    float gyro[3];                  // deg/s
+};
+
+struct SensorSamplerStats {
+    uint32_t samples[SENSOR_COUNT];
+    uint32_t errors[SENSOR_COUNT];
+    uint32_t skipped[SENSOR_COUNT]; // The previous sample was still in flight
+    uint32_t period_ms[SENSOR_COUNT];
+    bool idle[SENSOR_COUNT];
+};
+
+/**
+ * @brief Read the config and start the timers. After the I2C bus
+ */
+bool sensor_sampler_begin();
+
+/**
+ * @brief Copy the latest snapshot. Never blocks on the bus
+ * @return false until the first sample
+ */
+bool sensor_get_gauge(SensorGauge *out);
+bool sensor_get_light(SensorLight *out);
+bool sensor_get_motion(SensorMotion *out);
+
+/**
+ * @brief Sample id every period_ms from now; 0 stops it
+ */
+void sensor_sampler_set_period(uint8_t id, uint32_t period_ms);
+
+void sensor_sampler_get_stats(SensorSamplerStats *out);
+
+#endif // SENSOR_SAMPLER_H
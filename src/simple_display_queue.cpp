@@ -0,0 +1,198 @@
+/**
+ * @file      simple_display_queue.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Coalescing display-update queue implementation
+ */
+
+#include "simple_display_queue.h"
+#include "simple_hardware.h"
+#include "simple_logger.h"
+
+// Static instance
+SimpleDisplayQueue* SimpleDisplayQueue::instance = nullptr;
+SimpleDisplayQueue* DisplayQueue = nullptr;
+
+SimpleDisplayQueue::SimpleDisplayQueue() {
+    memset(slots, 0, sizeof(slots));
+    memset(stats, 0, sizeof(stats));
+    coalesce_window_ms[DISPLAY_UPDATE_TELEMETRY] = DISPLAY_QUEUE_TELEMETRY_MS;
+    coalesce_window_ms[DISPLAY_UPDATE_INTERACTIVE] = DISPLAY_QUEUE_INTERACTIVE_MS;
+    min_interval_ms = DISPLAY_QUEUE_MIN_INTERVAL_MS;
+    last_update_ms = 0;
+    lock = nullptr;
+    initialized = false;
+}
+
+SimpleDisplayQueue* SimpleDisplayQueue::getInstance() {
+    if (instance == nullptr) {
+        instance = new SimpleDisplayQueue();
+        DisplayQueue = instance; // Set global pointer
+    }
+    return instance;
+}
+
+bool SimpleDisplayQueue::init() {
+    LOG_INFO("DisplayQueue", "Initializing display update queue...");
+    
+    lock = xSemaphoreCreateMutex();
+    if (!lock) {
+        LOG_ERROR("DisplayQueue", "Failed to create queue lock");
+        return false;
+    }
+    
+    initialized = true;
+    LOG_INFO("DisplayQueue", "Display update queue initialized");
+    return true;
+}
+
+bool SimpleDisplayQueue::request(const char* text, DisplayUpdatePriority priority, int16_t x, int16_t y) {
+    if (!initialized || !text || priority >= DISPLAY_UPDATE_PRIORITY_COUNT) {
+        return false;
+    }
+    
+    xSemaphoreTake(lock, portMAX_DELAY);
+    
+    DisplayUpdateRequest& slot = slots[priority];
+    stats[priority].requests++;
+    if (slot.pending) {
+        // Newer content replaces the pending one; latency counts from the oldest
+        stats[priority].coalesced++;
+    } else {
+        slot.first_request_ms = millis();
+        slot.pending = true;
+    }
+    strlcpy(slot.text, text, sizeof(slot.text));
+    slot.x = x;
+    slot.y = y;
+    
+    // Every update repaints the screen, so older telemetry would hide this
+    if (priority == DISPLAY_UPDATE_INTERACTIVE && slots[DISPLAY_UPDATE_TELEMETRY].pending) {
+        slots[DISPLAY_UPDATE_TELEMETRY].pending = false;
+        stats[DISPLAY_UPDATE_TELEMETRY].superseded++;
+    }
+    
+    xSemaphoreGive(lock);
+    return true;
+}
+
+void SimpleDisplayQueue::update() {
+    if (!initialized) {
+        return;
+    }
+    
+    uint32_t now = millis();
+    if (isDue(DISPLAY_UPDATE_INTERACTIVE, now)) {
+        process(DISPLAY_UPDATE_INTERACTIVE);
+    } else if (isDue(DISPLAY_UPDATE_TELEMETRY, now)) {
+        process(DISPLAY_UPDATE_TELEMETRY);
+    }
+}
+
+void SimpleDisplayQueue::flush() {
+    if (!initialized) {
+        return;
+    }
+    
+    process(DISPLAY_UPDATE_INTERACTIVE);
+    process(DISPLAY_UPDATE_TELEMETRY);
+}
+
+bool SimpleDisplayQueue::isDue(DisplayUpdatePriority priority, uint32_t now) {
+    const DisplayUpdateRequest& slot = slots[priority];
+    if (!slot.pending || now - slot.first_request_ms < coalesce_window_ms[priority]) {
+        return false;
+    }
+    
+    // Interactive updates skip the spacing so input always gets an echo
+    return priority == DISPLAY_UPDATE_INTERACTIVE || now - last_update_ms >= min_interval_ms;
+}
+
+void SimpleDisplayQueue::process(DisplayUpdatePriority priority) {
+    // Copy out under the lock so requesters never wait on the panel
+    static char text[DISPLAY_QUEUE_TEXT_SIZE];
+    int16_t x, y;
+    uint32_t requested_ms;
+    
+    xSemaphoreTake(lock, portMAX_DELAY);
+    DisplayUpdateRequest& slot = slots[priority];
+    if (!slot.pending) {
+        xSemaphoreGive(lock);
+        return;
+    }
+    memcpy(text, slot.text, sizeof(text));
+    x = slot.x;
+    y = slot.y;
+    requested_ms = slot.first_request_ms;
+    slot.pending = false;
+    xSemaphoreGive(lock);
+    
+    if (!Hardware || !Hardware->updateDisplay(text, x, y)) {
+        LOG_WARN("DisplayQueue", "Display not ready, update dropped");
+        return;
+    }
+    
+    // updateDisplay() returns once the panel has finished refreshing
+    uint32_t now = millis();
+    DisplayQueueStats& s = stats[priority];
+    s.updates++;
+    s.last_latency_ms = now - requested_ms;
+    s.total_latency_ms += s.last_latency_ms;
+    if (s.last_latency_ms > s.max_latency_ms) {
+        s.max_latency_ms = s.last_latency_ms;
+    }
+    last_update_ms = now;
+    
+    LOG_DEBUGF("DisplayQueue", "%s update done in %lu ms", getPriorityString(priority), s.last_latency_ms);
+}
+
+void SimpleDisplayQueue::setCoalesceWindow(DisplayUpdatePriority priority, uint32_t window_ms) {
+    if (priority >= DISPLAY_UPDATE_PRIORITY_COUNT) {
+        return;
+    }
+    coalesce_window_ms[priority] = window_ms;
+    LOG_INFOF("DisplayQueue", "%s coalescing window set to %lu ms", getPriorityString(priority), window_ms);
+}
+
+void SimpleDisplayQueue::setMinInterval(uint32_t interval_ms) {
+    min_interval_ms = interval_ms;
+    LOG_INFOF("DisplayQueue", "Minimum telemetry interval set to %lu ms", interval_ms);
+}
+
+bool SimpleDisplayQueue::isPending() {
+    return slots[DISPLAY_UPDATE_INTERACTIVE].pending || slots[DISPLAY_UPDATE_TELEMETRY].pending;
+}
+
+DisplayQueueStats SimpleDisplayQueue::getStats(DisplayUpdatePriority priority) {
+    DisplayQueueStats empty = {};
+    return priority < DISPLAY_UPDATE_PRIORITY_COUNT ? stats[priority] : empty;
+}
+
+uint32_t SimpleDisplayQueue::getAverageLatency(DisplayUpdatePriority priority) {
+    if (priority >= DISPLAY_UPDATE_PRIORITY_COUNT || stats[priority].updates == 0) {
+        return 0;
+    }
+    return stats[priority].total_latency_ms / stats[priority].updates;
+}
+
+const char* SimpleDisplayQueue::getPriorityString(DisplayUpdatePriority priority) {
+    switch (priority) {
+        case DISPLAY_UPDATE_TELEMETRY: return "Telemetry";
+        case DISPLAY_UPDATE_INTERACTIVE: return "Interactive";
+        default: return "Unknown";
+    }
+}
+
+void SimpleDisplayQueue::printStatus() {
+    LOG_INFO("DisplayQueue", "=== Display Queue Status ===");
+    for (int p = DISPLAY_UPDATE_INTERACTIVE; p >= DISPLAY_UPDATE_TELEMETRY; p--) {
+        DisplayUpdatePriority priority = (DisplayUpdatePriority)p;
+        const DisplayQueueStats& s = stats[priority];
+        LOG_INFOF("DisplayQueue", "%s: %lu requests, %lu coalesced, %lu superseded, %lu updates",
+                  getPriorityString(priority), s.requests, s.coalesced, s.superseded, s.updates);
+        LOG_INFOF("DisplayQueue", "%s latency: last %lu ms, avg %lu ms, max %lu ms",
+                  getPriorityString(priority), s.last_latency_ms, getAverageLatency(priority), s.max_latency_ms);
+    }
+}
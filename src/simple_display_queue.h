@@ -0,0 +1,103 @@
+/**
+ * @file      simple_display_queue.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Coalescing display-update queue for the e-paper display
+ */
+
+#ifndef SIMPLE_DISPLAY_QUEUE_H
+#define SIMPLE_DISPLAY_QUEUE_H
+
+#include <Arduino.h>
+
+// Queue configuration
+#define DISPLAY_QUEUE_TEXT_SIZE         512   // Longest screen text accepted
+#define DISPLAY_QUEUE_INTERACTIVE_MS    50    // Coalescing window for user-driven updates
+#define DISPLAY_QUEUE_TELEMETRY_MS      3000  // Coalescing window for background updates
+#define DISPLAY_QUEUE_MIN_INTERVAL_MS   1000  // Minimum gap between telemetry panel updates
+
+enum DisplayUpdatePriority {
+    DISPLAY_UPDATE_TELEMETRY,     // Periodic status, can wait and be merged
+    DISPLAY_UPDATE_INTERACTIVE,   // Response to user input, served first
+    DISPLAY_UPDATE_PRIORITY_COUNT
+};
+
+struct DisplayUpdateRequest {
+    char text[DISPLAY_QUEUE_TEXT_SIZE];
+    int16_t x;
+    int16_t y;
+    uint32_t first_request_ms;    // Oldest request merged into this slot
+    bool pending;
+};
+
+struct DisplayQueueStats {
+    uint32_t requests;
+    uint32_t coalesced;           // Requests merged into an already pending update
+    uint32_t superseded;          // Telemetry dropped in favour of a newer interactive update
+    uint32_t updates;             // Panel updates actually performed
+    uint32_t last_latency_ms;     // Request to panel idle
+    uint32_t max_latency_ms;
+    uint32_t total_latency_ms;
+};
+
+/**
+ * @brief Simple Display Queue Class
+ * 
+ * Accepts screen updates from any task, merges requests that arrive
+ * inside a coalescing window and pushes them to the panel from the
+ * main loop, interactive updates ahead of telemetry
+ */
+class SimpleDisplayQueue {
+private:
+    static SimpleDisplayQueue* instance;
+    
+    DisplayUpdateRequest slots[DISPLAY_UPDATE_PRIORITY_COUNT];
+    DisplayQueueStats stats[DISPLAY_UPDATE_PRIORITY_COUNT];
+    uint32_t coalesce_window_ms[DISPLAY_UPDATE_PRIORITY_COUNT];
+    uint32_t min_interval_ms;
+    uint32_t last_update_ms;
+    SemaphoreHandle_t lock;
+    bool initialized;
+    
+    // Private constructor for singleton
+    SimpleDisplayQueue();
+    
+    bool isDue(DisplayUpdatePriority priority, uint32_t now);
+    void process(DisplayUpdatePriority priority);
+    const char* getPriorityString(DisplayUpdatePriority priority);
+
+public:
+    // Singleton access
+    static SimpleDisplayQueue* getInstance();
+    
+    // Initialization
+    bool init();
+    void update();
+    
+    // Requests (safe from any task)
+    bool request(const char* text, DisplayUpdatePriority priority, int16_t x = 10, int16_t y = 30);
+    bool requestInteractive(const char* text, int16_t x = 10, int16_t y = 30) {
+        return request(text, DISPLAY_UPDATE_INTERACTIVE, x, y);
+    }
+    bool requestTelemetry(const char* text, int16_t x = 10, int16_t y = 30) {
+        return request(text, DISPLAY_UPDATE_TELEMETRY, x, y);
+    }
+    void flush();
+    
+    // Configuration
+    void setCoalesceWindow(DisplayUpdatePriority priority, uint32_t window_ms);
+    void setMinInterval(uint32_t interval_ms);
+    
+    // Status
+    bool isPending();
+    DisplayQueueStats getStats(DisplayUpdatePriority priority);
+    uint32_t getAverageLatency(DisplayUpdatePriority priority);
+    void printStatus();
+};
+
+// Global display queue instance
+extern SimpleDisplayQueue* DisplayQueue;
+
+#endif // SIMPLE_DISPLAY_QUEUE_H
@@ -10,6 +10,21 @@
 #include "simple_hardware.h"
 #include "simple_logger.h"
 #include "lvgl_integration.h"
+#include "boot_trace.h"
+#include "wifi_scan.h"
+#include "wifi_fast.h"
+#include "resume_state.h"
+#include "auto_rotate.h"
+#include "ambient_service.h"
+#include "motion_service.h"
+#include "i2c_bus.h"
+#include "spi_bus.h"
+#include "fs_service.h"
+#include "sd_manager.h"
+#include "power_domain.h"
+#include "energy_profiler.h"
+#include "peripheral.h"
+#include "hw_probe.h"
 
 // Static instance
 SimpleHardware* SimpleHardware::instance = nullptr;
@@ -26,6 +41,7 @@ SimpleHardware::SimpleHardware() {
     
     last_touch = {0, 0, false, 0};
     last_status_update = 0;
+    sensors_started = false;
 }
 
 SimpleHardware* SimpleHardware::getInstance() {
@@ -37,21 +53,15 @@ SimpleHardware* SimpleHardware::getInstance() {
 }
 
 bool SimpleHardware::init() {
+    BOOT_TRACE_SCOPE("Hardware.init");
     LOG_INFO("Hardware", "Starting hardware initialization...");
 
-    // Initialize I2C and SPI
-    LOG_INFO("Hardware", "Initializing I2C and SPI...");
-    Wire.begin(BOARD_I2C_SDA, BOARD_I2C_SCL);
-    Wire.setClock(400000);
-    SPI.begin(BOARD_SPI_SCK, BOARD_SPI_MISO, BOARD_SPI_MOSI);
-    LOG_INFO("Hardware", "I2C and SPI initialized");
-
-    bool success = true;
+    bool success = initBuses();
     
     // Initialize components in order
     success &= initPowerManagement();
     success &= initDisplay();
-    success &= initTouch();
+    success &= initInput();
     success &= initWiFi();
     success &= initSD();
 
@@ -69,30 +79,47 @@ bool SimpleHardware::init() {
     return success;
 }
 
+bool SimpleHardware::initBuses() {
+    LOG_INFO("Hardware", "Initializing I2C and SPI...");
+    Wire.begin(BOARD_I2C_SDA, BOARD_I2C_SCL);
+    Wire.setClock(400000);
+    i2c_bus_begin();
+    SPI.begin(BOARD_SPI_SCK, BOARD_SPI_MISO, BOARD_SPI_MOSI);
+    spi_bus_begin();
+    LOG_INFO("Hardware", "I2C and SPI initialized");
+    return true;
+}
+
+bool SimpleHardware::initInput() {
+    bool success = initTouch();
+    // Keys typed from here on wait in the keypad queue for the first screen
+    if (!keypad_init(BOARD_I2C_ADDR_KEYBOARD)) {
+        LOG_WARN("Keypad", "TCA8418 not found, no key input");
+    }
+    return success;
+}
+
 bool SimpleHardware::initPowerManagement() {
+    BOOT_TRACE_SCOPE("Power");
     LOG_INFO("Power", "Initializing power management...");
 
-    // Enable power for various components
-    LOG_INFO("Power", "Setting up power control pins...");
-    pinMode(BOARD_GPS_EN, OUTPUT);
-    LOG_INFO("Power", "GPS_EN pin configured");
-    pinMode(BOARD_1V8_EN, OUTPUT);
-    LOG_INFO("Power", "1V8_EN pin configured");
-    pinMode(BOARD_6609_EN, OUTPUT);
-    LOG_INFO("Power", "6609_EN pin configured");
-    pinMode(BOARD_LORA_EN, OUTPUT);
-    LOG_INFO("Power", "LORA_EN pin configured");
+    // Rails are switched by their users from here on
+    if (!power_domain_begin()) {
+        LOG_ERROR("Power", "Power rails not set up");
+        return false;
+    }
 
     // Enable 1.8V rail for gyroscope
     LOG_INFO("Power", "Enabling 1.8V rail...");
-    digitalWrite(BOARD_1V8_EN, HIGH);
-    delay(100);
+    power_domain_acquire(power_domain_user(PWR_DOMAIN_1V8, "gyro"));
+    power_domain_wait(PWR_DOMAIN_1V8);
     
     LOG_INFO("Power", "Power management initialized");
     return true;
 }
 
 bool SimpleHardware::initDisplay() {
+    BOOT_TRACE_SCOPE("Display");
     LOG_INFO("Display", "Initializing e-paper display...");
     display_status = HW_INITIALIZING;
     
@@ -107,11 +134,22 @@ bool SimpleHardware::initDisplay() {
             return false;
         }
         
-        display->init(115200);
+        display->epd2.selectSPI(SPI, spi_bus_settings(SPI_CLIENT_EPD));
+        
+        // Waking from deep sleep the panel still shows the last screen: no
+        // initial full refresh and no splash over it
+        bool resuming = resume_state_resuming();
+        display->init(115200, !resuming);
         display->setRotation(2);  // 2 = 180° rotation
         display->mirror(true);    // Enable horizontal mirroring to fix reversed text
         display->setTextWrap(true);
         display->setFullWindow();
+        
+        if (resuming) {
+            display_status = HW_READY;
+            LOG_INFO("Display", "E-paper display resumed, panel image kept");
+            return true;
+        }
         display->firstPage();
 
         do {
@@ -139,6 +177,7 @@ bool SimpleHardware::initDisplay() {
 }
 
 bool SimpleHardware::initTouch() {
+    BOOT_TRACE_SCOPE("Touch");
     LOG_INFO("Touch", "Initializing touch controller...");
     touch_status = HW_INITIALIZING;
     
@@ -163,6 +202,7 @@ bool SimpleHardware::initTouch() {
 }
 
 bool SimpleHardware::initWiFi() {
+    BOOT_TRACE_SCOPE("WiFi");
     LOG_INFO("WiFi", "Initializing WiFi...");
     wifi_status = HW_INITIALIZING;
     
@@ -176,10 +216,12 @@ bool SimpleHardware::initWiFi() {
 }
 
 bool SimpleHardware::initSD() {
+    BOOT_TRACE_SCOPE("SD");
     LOG_INFO("SD", "Initializing SD card...");
     sd_status = HW_INITIALIZING;
     
-    if (SD.begin(BOARD_SD_CS)) {
+    // Probes the clock, starts the free space scan and keeps watching the slot
+    if (sd_manager_begin()) {
         uint64_t cardSize = SD.cardSize() / (1024 * 1024);
         LOG_INFOF("SD", "SD card initialized successfully - Size: %lluMB", cardSize);
         sd_status = HW_READY;
@@ -216,6 +258,9 @@ bool SimpleHardware::updateDisplay(const char* text, int16_t x, int16_t y) {
         return false;
     }
 
+    // Don't interleave with an LVGL panel update in flight
+    LVGLIntegration::getInstance()->waitFlushIdle();
+
     // Use full window for reliable e-paper rendering
     display->setFullWindow();
     display->firstPage();
@@ -266,7 +311,12 @@ bool SimpleHardware::connectWiFi(const char* ssid, const char* password) {
     
     LOG_INFOF("WiFi", "Attempting to connect to: %s", ssid);
     
-    WiFi.begin(ssid, password);
+    // Remembered access point and address first, a few hundred ms after sleep
+    if (wifi_fast_connect(ssid, password)) {
+        LOG_INFOF("WiFi", "Connected! IP: %s", WiFi.localIP().toString().c_str());
+        return true;
+    }
+    wifi_scan_connect(ssid, password);
     
     int attempts = 0;
     const int max_attempts = 20;
@@ -350,6 +400,9 @@ void SimpleHardware::clearDisplay() {
         return;
     }
 
+    // Don't interleave with an LVGL panel update in flight
+    LVGLIntegration::getInstance()->waitFlushIdle();
+
     display->setFullWindow();
     display->firstPage();
 
@@ -398,15 +451,20 @@ int32_t SimpleHardware::getWiFiRSSI() {
 }
 
 bool SimpleHardware::isSDCardAvailable() {
-    return sd_status == HW_READY;
+    return sd_manager_mounted();
 }
 
 uint64_t SimpleHardware::getSDCardSize() {
     return isSDCardAvailable() ? SD.cardSize() : 0;
 }
 
+// Cached by the file service; 0 until its scan completes
 uint64_t SimpleHardware::getSDCardUsed() {
-    return isSDCardAvailable() ? SD.usedBytes() : 0;
+    uint64_t used = 0;
+    if (isSDCardAvailable()) {
+        fs_capacity(NULL, &used);
+    }
+    return used;
 }
 
 BatteryInfo SimpleHardware::getBatteryInfo() {
@@ -424,11 +482,12 @@ void SimpleHardware::enableComponent(const char* component, bool enabled) {
 
     // Component-specific enable/disable logic
     if (strcmp(component, "gps") == 0) {
-        digitalWrite(BOARD_GPS_EN, enabled ? HIGH : LOW);
+        gps_power_enable(enabled);
     } else if (strcmp(component, "lora") == 0) {
-        digitalWrite(BOARD_LORA_EN, enabled ? HIGH : LOW);
+        power_domain_set(power_domain_user(PWR_DOMAIN_LORA, "lora"), enabled);
     } else if (strcmp(component, "6609") == 0) {
-        digitalWrite(BOARD_6609_EN, enabled ? HIGH : LOW);
+        // The modem's hold only: audio keeps the rail up if it is playing
+        power_domain_set(power_domain_user(PWR_DOMAIN_6609, "a7682e", ENERGY_CELL), enabled);
     } else {
         LOG_WARNF("Hardware", "Unknown component: %s", component);
     }
@@ -473,6 +532,8 @@ void SimpleHardware::printDiagnostics() {
     LOG_INFOF("Diagnostics", "Free Heap: %luKB", getFreeHeap() / 1024);
     LOG_INFOF("Diagnostics", "Free PSRAM: %luKB", getFreePSRAM() / 1024);
     LOG_INFOF("Diagnostics", "Uptime: %lus", getUptime() / 1000);
+    i2c_bus_log_stats();
+    spi_bus_log_stats();
 }
 
 bool SimpleHardware::runDiagnostics() {
@@ -499,11 +560,25 @@ bool SimpleHardware::runDiagnostics() {
         LOG_WARN("Diagnostics", "SD card not ready");
     }
 
+    // The rest of the board, all buses at once; parts found absent before are skipped
+    hw_probe_begin();
+    hw_probe_run();
+    for (int i = 0; i < E_PERI_NUM_MAX; i++) {
+        HwProbeResult r;
+        hw_probe_get(i, &r);
+        if (r.state != HW_PROBE_UNKNOWN && r.state != HW_PROBE_PRESENT) {
+            LOG_WARNF("Diagnostics", "%s: %s", hw_probe_name(i), hw_probe_state_name(r.state));
+        }
+    }
+
+    power_domain_log();
+
     LOG_INFOF("Diagnostics", "Diagnostics complete - Status: %s", all_ok ? "PASS" : "FAIL");
     return all_ok;
 }
 
 bool SimpleHardware::initLVGL() {
+    BOOT_TRACE_SCOPE("LVGL");
     LOG_INFO("LVGL", "Initializing LVGL integration...");
 
     if (display_status != HW_READY || touch_status != HW_READY) {
@@ -516,6 +591,9 @@ bool SimpleHardware::initLVGL() {
         LOG_ERROR("LVGL", "Failed to initialize LVGL integration");
         return false;
     }
+    if (resume_state_resuming()) {
+        lvgl->resumeOnPanel();
+    }
 
     LOG_INFO("LVGL", "LVGL integration initialized successfully");
     return true;
@@ -523,9 +601,34 @@ bool SimpleHardware::initLVGL() {
 
 void SimpleHardware::updateLVGL() {
     LVGLIntegration* lvgl = LVGLIntegration::getInstance();
-    if (lvgl->isInitialized()) {
-        lvgl->update();
+    if (!lvgl->isInitialized()) {
+        return;
+    }
+
+    // Sensor bring-up (the hub's firmware upload above all) waits until the
+    // first screen is on the panel
+    if (!sensors_started && lvgl->getFramesFlushed() > 0) {
+        sensors_started = true;
+        auto_rotate_begin();
+        ambient_begin();
+        motion_begin();
+    }
+    uint8_t rotation;
+    if (auto_rotate_take(&rotation)) {
+        lvgl->setRotation((lv_disp_rot_t)rotation);
+    }
+    uint8_t motion;
+    if (motion_take(&motion)) {
+        bool moving = motion == MOTION_MOVING || motion == MOTION_FAST;
+        lvgl->setCleanIdle(moving ? MOTION_CLEAN_IDLE_MS : REFRESH_CLEAN_IDLE_MS);
+        auto_rotate_pause(motion == MOTION_STATIONARY);
     }
+    bool blank;
+    if (ambient_take_blank(&blank)) {
+        lvgl->setBlanked(blank);
+    }
+
+    lvgl->update();
 }
 
 bool SimpleHardware::isLVGLReady() {
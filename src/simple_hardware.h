@@ -66,23 +66,26 @@ private:
     // State tracking
     TouchPoint last_touch;
     uint32_t last_status_update;
+    bool sensors_started;           // Rotation and ambient services, after the first frame
     
     // Private constructor for singleton
     SimpleHardware();
     
-    // Private initialization methods
-    bool initDisplay();
     bool initTouch();
-    bool initWiFi();
-    bool initSD();
-    bool initPowerManagement();
 
 public:
     // Singleton access
     static SimpleHardware* getInstance();
     
-    // System initialization
+    // System initialization: everything in order, or the steps one by one
+    // from the boot pipeline (buses first, LVGL after display and input)
     bool init();
+    bool initBuses();
+    bool initPowerManagement();
+    bool initDisplay();
+    bool initInput();
+    bool initWiFi();
+    bool initSD();
     void update();
     bool runDiagnostics();
     
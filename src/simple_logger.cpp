@@ -8,18 +8,29 @@
  */
 
 #include "simple_logger.h"
+#include "spi_bus.h"
+#include "time_service.h"
 #include <stdarg.h>
 
 // Static instance
 SimpleLogger* SimpleLogger::instance = nullptr;
 SimpleLogger* Logger = nullptr;
 
+// Component table, ID 0 is shared by names that did not fit
+char SimpleLogger::component_names[SLOG_COMPONENT_MAX][SLOG_COMPONENT_NAME_LEN] = { "other" };
+uint8_t SimpleLogger::component_levels[SLOG_COMPONENT_MAX] = { 0 };
+uint8_t SimpleLogger::component_count = 1;
+portMUX_TYPE SimpleLogger::component_mux = portMUX_INITIALIZER_UNLOCKED;
+
 SimpleLogger::SimpleLogger() {
     current_level = LOG_INFO;
     serial_enabled = true;
     sd_enabled = false;
     log_count = 0;
     log_filename = "/logs/system.log";
+    sd_binary = false;
+    binary_filename = "/logs/system.blog";
+    serial_sink = nullptr;
 }
 
 SimpleLogger* SimpleLogger::getInstance() {
@@ -51,6 +62,7 @@ void SimpleLogger::enableSD(bool enabled, const char* filename) {
     }
     
     if (enabled) {
+        SpiBusHold bus(SPI_CLIENT_SD);
         // Create logs directory if it doesn't exist
         if (SD.exists("/logs") || SD.mkdir("/logs")) {
             Serial.println("[LOGGER] SD card logging enabled");
@@ -61,10 +73,57 @@ void SimpleLogger::enableSD(bool enabled, const char* filename) {
     }
 }
 
+void SimpleLogger::enableBinarySD(bool enabled, const char* filename) {
+    if (filename) {
+        binary_filename = String(filename);
+    }
+    sd_binary = enabled;
+    
+    // Session marker: millis restarts at every boot
+    if (isBinaryLogging()) {
+        SLogPacker packer(binary_buffer);
+        writeBinary(SLOG_LEVEL_SESSION, 0, packer);
+    }
+}
+
+void SimpleLogger::setSerialSink(slog_sink_fn sink) {
+    serial_sink = sink;
+}
+
 void SimpleLogger::setLogLevel(LogLevel level) {
     current_level = level;
 }
 
+uint8_t SimpleLogger::internComponent(const char* component) {
+    if (!component || !component[0]) {
+        return 0;
+    }
+    
+    uint8_t id = 0;
+    portENTER_CRITICAL(&component_mux);
+    for (uint8_t i = 1; i < component_count; i++) {
+        if (strncmp(component_names[i], component, SLOG_COMPONENT_NAME_LEN - 1) == 0) {
+            id = i;
+            break;
+        }
+    }
+    if (id == 0 && component_count < SLOG_COMPONENT_MAX) {
+        strncpy(component_names[component_count], component, SLOG_COMPONENT_NAME_LEN - 1);
+        component_names[component_count][SLOG_COMPONENT_NAME_LEN - 1] = 0;
+        id = component_count++;
+    }
+    portEXIT_CRITICAL(&component_mux);
+    return id;
+}
+
+void SimpleLogger::setComponentLevel(const char* component, LogLevel level) {
+    component_levels[internComponent(component)] = (uint8_t)level + 1;
+}
+
+void SimpleLogger::clearComponentLevel(const char* component) {
+    component_levels[internComponent(component)] = 0;
+}
+
 const char* SimpleLogger::getLevelString(LogLevel level) {
     switch (level) {
         case LOG_DEBUG: return "DEBUG";
@@ -75,56 +134,133 @@ const char* SimpleLogger::getLevelString(LogLevel level) {
     }
 }
 
+// UTC once the clock is set, milliseconds since boot before
+static void format_stamp(uint32_t ms, char *buf, size_t len) {
+    if (!time_valid() || !time_format_iso(time_from_millis(ms), buf, len)) {
+        snprintf(buf, len, "%lu", (unsigned long)ms);
+    }
+}
+
 void SimpleLogger::writeToSerial(const char* level_str, const char* component, const char* message) {
-    if (!serial_enabled) return;
+    if (!serial_enabled || serial_sink) return;
     
-    uint32_t timestamp = millis();
-    Serial.printf("[%lu] [%s] %s: %s\n", timestamp, level_str, component, message);
+    char stamp[32];
+    format_stamp(millis(), stamp, sizeof(stamp));
+    Serial.printf("[%s] [%s] %s: %s\n", stamp, level_str, component, message);
 }
 
 void SimpleLogger::writeToSD(const char* level_str, const char* component, const char* message) {
-    if (!sd_enabled) return;
+    if (!sd_enabled || sd_binary) return;
     
+    SpiBusHold bus(SPI_CLIENT_SD);
     File logFile = SD.open(log_filename.c_str(), FILE_APPEND);
     if (logFile) {
-        uint32_t timestamp = millis();
-        logFile.printf("[%lu] [%s] %s: %s\n", timestamp, level_str, component, message);
+        char stamp[32];
+        format_stamp(millis(), stamp, sizeof(stamp));
+        logFile.printf("[%s] [%s] %s: %s\n", stamp, level_str, component, message);
         logFile.close();
     }
 }
 
+void SimpleLogger::writeBinary(uint8_t level, uint32_t format_id, const SLogPacker& packer) {
+    uint32_t timestamp = millis();
+    
+    binary_buffer[0] = SLOG_SYNC;
+    binary_buffer[1] = packer.size();
+    binary_buffer[2] = level | (packer.isTruncated() ? SLOG_FLAG_TRUNCATED : 0);
+    memcpy(binary_buffer + 3, &timestamp, sizeof(timestamp));
+    memcpy(binary_buffer + 7, &format_id, sizeof(format_id));
+    
+    slog_sink_fn sink = serial_sink;
+    if (sink && serial_enabled) {
+        sink(binary_buffer, packer.size());
+    }
+    if (!isBinaryLogging()) {
+        return;
+    }
+    SpiBusHold bus(SPI_CLIENT_SD);
+    File logFile = SD.open(binary_filename.c_str(), FILE_APPEND);
+    if (logFile) {
+        logFile.write(binary_buffer, packer.size());
+        logFile.close();
+    }
+}
+
+void SLogPacker::put(const char* value) {
+    size_t len = value ? strlen(value) : 0;
+    if (len > 255) {
+        len = 255;
+    }
+    // Long strings are cut to what is left rather than dropped
+    if (!truncated && length + 2 + len > SLOG_RECORD_MAX) {
+        len = (length + 2 < SLOG_RECORD_MAX) ? SLOG_RECORD_MAX - length - 2 : 0;
+    }
+    if (reserve(SLOG_ARG_STRING, 1 + len)) {
+        buffer[length++] = (uint8_t)len;
+        memcpy(buffer + length, value, len);
+        length += len;
+    }
+}
+
+// The non-macro calls: no format ID, so the record carries the text
+void SimpleLogger::writeText(LogLevel level, const char* component, const char* message) {
+    if (needsRecord()) {
+        SLogPacker packer(binary_buffer);
+        packer.putAll(component, message);
+        writeBinary(level, SLOG_FORMAT_TEXT, packer);
+    }
+    const char* level_str = getLevelString(level);
+    writeToSerial(level_str, component, message);
+    writeToSD(level_str, component, message);
+}
+
+void SimpleLogger::logMessage(LogLevel level, uint32_t format_id, const char* component, const char* message) {
+    if (needsRecord()) {
+        SLogPacker packer(binary_buffer);
+        writeBinary(level, format_id, packer);
+    }
+    
+    const char* level_str = getLevelString(level);
+    writeToSerial(level_str, component, message);
+    writeToSD(level_str, component, message);
+    log_count++;
+}
+
+void SimpleLogger::logText(LogLevel level, const char* component, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    vsnprintf(format_buffer, sizeof(format_buffer), format, args);
+    va_end(args);
+    
+    const char* level_str = getLevelString(level);
+    writeToSerial(level_str, component, format_buffer);
+    writeToSD(level_str, component, format_buffer);
+}
+
 void SimpleLogger::debug(const char* component, const char* message) {
     if (current_level <= LOG_DEBUG) {
-        const char* level_str = getLevelString(LOG_DEBUG);
-        writeToSerial(level_str, component, message);
-        writeToSD(level_str, component, message);
+        writeText(LOG_DEBUG, component, message);
         log_count++;
     }
 }
 
 void SimpleLogger::info(const char* component, const char* message) {
     if (current_level <= LOG_INFO) {
-        const char* level_str = getLevelString(LOG_INFO);
-        writeToSerial(level_str, component, message);
-        writeToSD(level_str, component, message);
+        writeText(LOG_INFO, component, message);
         log_count++;
     }
 }
 
 void SimpleLogger::warn(const char* component, const char* message) {
     if (current_level <= LOG_WARN) {
-        const char* level_str = getLevelString(LOG_WARN);
-        writeToSerial(level_str, component, message);
-        writeToSD(level_str, component, message);
+        writeText(LOG_WARN, component, message);
         log_count++;
     }
 }
 
 void SimpleLogger::error(const char* component, const char* message) {
     if (current_level <= LOG_ERROR) {
-        const char* level_str = getLevelString(LOG_ERROR);
-        writeToSerial(level_str, component, message);
-        writeToSD(level_str, component, message);
+        writeText(LOG_ERROR, component, message);
         log_count++;
     }
 }
@@ -13,6 +13,7 @@
 #include <Arduino.h>
 #include <SD.h>
 #include <FS.h>
+#include <type_traits>
 
 enum LogLevel {
     LOG_DEBUG = 0,
@@ -21,6 +22,116 @@ enum LogLevel {
     LOG_ERROR = 3
 };
 
+// Levels below this are compiled out of the LOG_* macros, arguments and
+// strings included: 0 DEBUG, 1 INFO, 2 WARN, 3 ERROR
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL       0
+#endif
+
+// Per-component runtime thresholds, indexed by interned component ID
+#define SLOG_COMPONENT_MAX      32      // ID 0 collects names past the table
+#define SLOG_COMPONENT_NAME_LEN 24
+
+// Binary SD records, decoded on the host by script/log_decode.py:
+//   sync, length, level, millis (u32), format ID (u32), tagged arguments
+#define SLOG_SYNC               0xA5
+#define SLOG_HEADER_SIZE        11
+#define SLOG_RECORD_MAX         255     // Arguments past this are cut, see SLOG_FLAG_TRUNCATED
+#define SLOG_FLAG_TRUNCATED     0x80    // Or'ed into the level byte
+#define SLOG_LEVEL_SESSION      0x7F    // Format ID 0, written when binary logging starts
+#define SLOG_FORMAT_TEXT        0       // With a real level: component and message as string arguments,
+                                        // for the calls that are not LOG_* macros
+
+// Argument tags; integers are little-endian, strings are length-prefixed
+#define SLOG_ARG_INT            'i'     // 4 bytes
+#define SLOG_ARG_UINT           'u'     // 4 bytes
+#define SLOG_ARG_INT64          'q'     // 8 bytes
+#define SLOG_ARG_UINT64         'Q'     // 8 bytes
+#define SLOG_ARG_DOUBLE         'd'     // 8 bytes
+#define SLOG_ARG_STRING         's'     // 1 length byte, then the characters
+#define SLOG_ARG_POINTER        'p'     // 4 bytes
+
+// FNV-1a over component, NUL and format; the decoder repeats it over the
+// LOG_* call sites it finds in src/. C++11 constexpr, hence the recursion.
+constexpr uint32_t slog_fnv1a(const char* s, uint32_t h = 2166136261UL) {
+    return *s ? slog_fnv1a(s + 1, (h ^ (uint8_t)*s) * 16777619UL) : h;
+}
+
+constexpr uint32_t slog_id(const char* component, const char* format) {
+    return slog_fnv1a(format, slog_fnv1a(component) * 16777619UL);
+}
+
+// Evaluated by the compiler: component and format must be string literals
+#define SLOG_ID(component, format) (std::integral_constant<uint32_t, slog_id(component, format)>::value)
+
+/**
+ * @brief Takes each binary record in place of the serial text, e.g. the USB
+ *        console's log channel. Called from the logging task, must not block
+ */
+typedef void (*slog_sink_fn)(const uint8_t* record, size_t len);
+
+/**
+ * @brief Appends tagged arguments to a binary record
+ */
+class SLogPacker {
+private:
+    uint8_t* buffer;
+    uint8_t length;
+    bool truncated;
+    
+    bool reserve(uint8_t tag, size_t size) {
+        if (truncated || length + 1 + size > SLOG_RECORD_MAX) {
+            truncated = true;
+            return false;
+        }
+        buffer[length++] = tag;
+        return true;
+    }
+    
+    void putRaw(uint8_t tag, const void* data, size_t size) {
+        if (reserve(tag, size)) {
+            memcpy(buffer + length, data, size);
+            length += size;
+        }
+    }
+
+public:
+    SLogPacker(uint8_t* buf) : buffer(buf), length(SLOG_HEADER_SIZE), truncated(false) {}
+    
+    template<typename T>
+    typename std::enable_if<std::is_integral<T>::value>::type put(T value) {
+        if (sizeof(T) > 4) {
+            int64_t v = (int64_t)value;
+            putRaw(std::is_signed<T>::value ? SLOG_ARG_INT64 : SLOG_ARG_UINT64, &v, sizeof(v));
+        } else {
+            int32_t v = (int32_t)value;
+            putRaw(std::is_signed<T>::value ? SLOG_ARG_INT : SLOG_ARG_UINT, &v, sizeof(v));
+        }
+    }
+    
+    template<typename T>
+    typename std::enable_if<std::is_enum<T>::value>::type put(T value) {
+        put((int)value);
+    }
+    
+    void put(double value) { putRaw(SLOG_ARG_DOUBLE, &value, sizeof(value)); }
+    void put(const char* value);
+    void put(const void* value) {
+        uint32_t v = (uint32_t)(uintptr_t)value;
+        putRaw(SLOG_ARG_POINTER, &v, sizeof(v));
+    }
+    
+    void putAll() {}
+    template<typename T, typename... Rest>
+    void putAll(T first, Rest... rest) {
+        put(first);
+        putAll(rest...);
+    }
+    
+    uint8_t size() const { return length; }
+    bool isTruncated() const { return truncated; }
+};
+
 class SimpleLogger {
 private:
     static SimpleLogger* instance;
@@ -28,13 +139,18 @@ private:
     bool serial_enabled;
     bool sd_enabled;
     String log_filename;
+    bool sd_binary;                 // SD gets packed records instead of text
+    String binary_filename;
+    volatile slog_sink_fn serial_sink;  // Serial gets packed records instead of text
     
     // Private constructor for singleton
     SimpleLogger();
     
     void writeToSerial(const char* level_str, const char* component, const char* message);
     void writeToSD(const char* level_str, const char* component, const char* message);
+    void writeText(LogLevel level, const char* component, const char* message);
     const char* getLevelString(LogLevel level);
+    void writeBinary(uint8_t level, uint32_t format_id, const SLogPacker& packer);
 
 public:
     // Singleton access
@@ -44,7 +160,11 @@ public:
     bool init(LogLevel level = LOG_INFO);
     void enableSerial(bool enabled = true);
     void enableSD(bool enabled = true, const char* filename = "/logs/system.log");
+    void enableBinarySD(bool enabled = true, const char* filename = "/logs/system.blog");
+    void setSerialSink(slog_sink_fn sink);
     void setLogLevel(LogLevel level);
+    bool isBinaryLogging() { return sd_enabled && sd_binary; }
+    bool needsRecord() { return isBinaryLogging() || serial_sink; }
     
     // Logging methods
     void debug(const char* component, const char* message);
@@ -58,6 +178,25 @@ public:
     void warnf(const char* component, const char* format, ...);
     void errorf(const char* component, const char* format, ...);
     
+    // Macro entry points: pack for binary SD or the serial sink, then the
+    // text path for serial.
+    // Arguments are evaluated once and handed to both. No level check here,
+    // the macros have already filtered by component.
+    void logMessage(LogLevel level, uint32_t format_id, const char* component, const char* message);
+    template<typename... Args>
+    void logFormat(LogLevel level, uint32_t format_id, const char* component, const char* format, Args... args) {
+        if (needsRecord()) {
+            SLogPacker packer(binary_buffer);
+            packer.putAll(args...);
+            writeBinary(level, format_id, packer);
+        }
+        if ((serial_enabled && !serial_sink) || (sd_enabled && !sd_binary)) {
+            logText(level, component, format, args...);
+        }
+        log_count++;
+    }
+    void logText(LogLevel level, const char* component, const char* format, ...);
+    
     // Utility
     void flush();
     uint32_t getLogCount() { return log_count; }
@@ -65,20 +204,49 @@ public:
 private:
     uint32_t log_count;
     char format_buffer[512];
+    uint8_t binary_buffer[SLOG_RECORD_MAX];
+    
+    // Component table; a level of 0 follows current_level, otherwise level + 1
+    static char component_names[SLOG_COMPONENT_MAX][SLOG_COMPONENT_NAME_LEN];
+    static uint8_t component_levels[SLOG_COMPONENT_MAX];
+    static uint8_t component_count;
+    static portMUX_TYPE component_mux;
+
+public:
+    // Component filter. The LOG_* macros intern their component once per call
+    // site and test isEnabled() before any argument is evaluated
+    static uint8_t internComponent(const char* component);
+    void setComponentLevel(const char* component, LogLevel level);
+    void clearComponentLevel(const char* component);
+    bool isEnabled(LogLevel level, uint8_t component_id) const {
+        uint8_t threshold = component_levels[component_id < SLOG_COMPONENT_MAX ? component_id : 0];
+        return level >= (threshold ? (LogLevel)(threshold - 1) : current_level);
+    }
 };
 
 // Global logger instance
 extern SimpleLogger* Logger;
 
+// Compile-time level test, then the component threshold, then the call
+#define SLOG_CALL(level, component, call) \
+    do { \
+        if (LOG_COMPILE_LEVEL <= (level) && Logger) { \
+            static const uint8_t slog_component = SimpleLogger::internComponent(component); \
+            if (Logger->isEnabled(level, slog_component)) { \
+                Logger->call; \
+            } \
+        } \
+    } while (0)
+
 // Convenience macros
-#define LOG_DEBUG(component, message) Logger->debug(component, message)
-#define LOG_INFO(component, message) Logger->info(component, message)
-#define LOG_WARN(component, message) Logger->warn(component, message)
-#define LOG_ERROR(component, message) Logger->error(component, message)
-
-#define LOG_DEBUGF(component, format, ...) Logger->debugf(component, format, ##__VA_ARGS__)
-#define LOG_INFOF(component, format, ...) Logger->infof(component, format, ##__VA_ARGS__)
-#define LOG_WARNF(component, format, ...) Logger->warnf(component, format, ##__VA_ARGS__)
-#define LOG_ERRORF(component, format, ...) Logger->errorf(component, format, ##__VA_ARGS__)
+#define LOG_DEBUG(component, message) SLOG_CALL(LOG_DEBUG, component, logMessage(LOG_DEBUG, SLOG_ID(component, message), component, message))
+#define LOG_INFO(component, message) SLOG_CALL(LOG_INFO, component, logMessage(LOG_INFO, SLOG_ID(component, message), component, message))
+#define LOG_WARN(component, message) SLOG_CALL(LOG_WARN, component, logMessage(LOG_WARN, SLOG_ID(component, message), component, message))
+#define LOG_ERROR(component, message) SLOG_CALL(LOG_ERROR, component, logMessage(LOG_ERROR, SLOG_ID(component, message), component, message))
+
+#define LOG_DEBUGF(component, format, ...) SLOG_CALL(LOG_DEBUG, component, logFormat(LOG_DEBUG, SLOG_ID(component, format), component, format, ##__VA_ARGS__))
+#define LOG_INFOF(component, format, ...) SLOG_CALL(LOG_INFO, component, logFormat(LOG_INFO, SLOG_ID(component, format), component, format, ##__VA_ARGS__))
+#define LOG_WARNF(component, format, ...) SLOG_CALL(LOG_WARN, component, logFormat(LOG_WARN, SLOG_ID(component, format), component, format, ##__VA_ARGS__))
+#define LOG_ERRORF(component, format, ...) SLOG_CALL(LOG_ERROR, component, logFormat(LOG_ERROR, SLOG_ID(component, format), component, format, ##__VA_ARGS__))
 
 #endif // SIMPLE_LOGGER_H
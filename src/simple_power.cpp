@@ -9,7 +9,17 @@
 
 #include "simple_power.h"
 #include "simple_logger.h"
+#include "power_governor.h"
+#include "resume_state.h"
+#include "tsdb.h"
+#include "wake_monitor.h"
+#include "status_glance.h"
+#include "timer_wheel.h"
+#include "batt_forecast.h"
 #include <WiFi.h>
+#ifdef INTEGRATION_LAYER_ENABLED
+#include "integration/service_manager.h"
+#endif
 
 // Static instance
 SimplePower* SimplePower::instance = nullptr;
@@ -50,6 +60,13 @@ void SimplePower::update() {
         return;
     }
     
+    // A more saving mode while the forecast falls short of the runtime target
+    int wanted = batt_forecast_policy_mode(current_mode);
+    if (wanted != current_mode) {
+        setPowerMode((PowerMode)wanted);
+        return;
+    }
+    
     uint32_t idle_time = getIdleTime();
     
     // Auto power management based on idle time
@@ -93,7 +110,17 @@ const char* SimplePower::getPowerModeString() {
     }
 }
 
+// Ahead of the clock change, so services quiesce at the faster clock
+static void apply_service_policy(PowerMode mode) {
+#ifdef INTEGRATION_LAYER_ENABLED
+    if (GlobalServiceManager) {
+        GlobalServiceManager->setPowerMode(mode);
+    }
+#endif
+}
+
 bool SimplePower::setHighPerformanceMode() {
+    apply_service_policy(POWER_HIGH_PERFORMANCE);
     current_mode = POWER_HIGH_PERFORMANCE;
     
     // Set CPU to maximum frequency
@@ -107,6 +134,7 @@ bool SimplePower::setHighPerformanceMode() {
 }
 
 bool SimplePower::setBalancedMode() {
+    apply_service_policy(POWER_BALANCED);
     current_mode = POWER_BALANCED;
     
     // Set CPU to balanced frequency
@@ -120,6 +148,7 @@ bool SimplePower::setBalancedMode() {
 }
 
 bool SimplePower::setPowerSaveMode() {
+    apply_service_policy(POWER_POWER_SAVE);
     current_mode = POWER_POWER_SAVE;
     
     // Set CPU to lower frequency
@@ -133,6 +162,7 @@ bool SimplePower::setPowerSaveMode() {
 }
 
 bool SimplePower::setUltraLowPowerMode() {
+    apply_service_policy(POWER_ULTRA_LOW_POWER);
     current_mode = POWER_ULTRA_LOW_POWER;
     
     // Set CPU to minimum frequency
@@ -146,6 +176,13 @@ bool SimplePower::setUltraLowPowerMode() {
 }
 
 bool SimplePower::setCPUFrequency(uint32_t frequency_mhz) {
+    // The governor scales the clock with load; the mode only caps it
+    if (power_governor_running()) {
+        power_governor_set_ceiling(frequency_mhz);
+        LOG_INFOF("Power", "CPU frequency capped at %lu MHz", frequency_mhz);
+        return true;
+    }
+    
     // Note: setCpuFrequencyMhz may not be available in all ESP32 versions
     // This is a simplified implementation
     try {
@@ -171,6 +208,14 @@ void SimplePower::configureWiFiPowerSave(bool enabled) {
 }
 
 bool SimplePower::enterLightSleep(uint32_t duration_ms) {
+    // Up in time for the next wheel timer
+    uint32_t next_timer_ms = timer_wheel_next_ms();
+    if (next_timer_ms < duration_ms) {
+        duration_ms = next_timer_ms;
+    }
+    if (duration_ms == 0) {
+        return false;
+    }
     LOG_INFOF("Power", "Entering light sleep for %lu ms", duration_ms);
     
     // Configure timer wakeup
@@ -190,8 +235,13 @@ bool SimplePower::enterLightSleep(uint32_t duration_ms) {
 bool SimplePower::enterDeepSleep(uint32_t duration_ms) {
     LOG_INFOF("Power", "Entering deep sleep for %lu ms", duration_ms);
     
-    // Configure timer wakeup
-    esp_sleep_enable_timer_wakeup(duration_ms * 1000); // Convert to microseconds
+    // Timer, keypad and touch wakeup; the status strip's timer if it comes first
+    status_glance_prepare();
+    wake_monitor_arm(duration_ms);
+    
+    // The wake boot picks up from here instead of starting cold
+    tsdb_flush();
+    resume_state_save();
     
     // Enter deep sleep (this will reset the system)
     esp_deep_sleep_start();
@@ -200,6 +250,21 @@ bool SimplePower::enterDeepSleep(uint32_t duration_ms) {
     return false;
 }
 
+bool SimplePower::enterHibernation() {
+    LOG_INFO("Power", "Entering hibernation until a key or touch");
+    
+    // No timer of our own: input, the battery check finding it low, or
+    // the status strip's refresh
+    status_glance_prepare();
+    wake_monitor_arm();
+    
+    tsdb_flush();
+    resume_state_save();
+    esp_deep_sleep_start();
+    
+    return false;
+}
+
 bool SimplePower::enableTimerWakeup(uint32_t duration_ms) {
     esp_sleep_enable_timer_wakeup(duration_ms * 1000);
     LOG_INFOF("Power", "Timer wakeup enabled for %lu ms", duration_ms);
@@ -13,13 +13,7 @@
 #include <Arduino.h>
 #include <esp_sleep.h>
 // #include <esp_pm.h> // May not be available in all ESP32 versions
-
-enum PowerMode {
-    POWER_HIGH_PERFORMANCE,
-    POWER_BALANCED,
-    POWER_POWER_SAVE,
-    POWER_ULTRA_LOW_POWER
-};
+#include "power_mode.h"
 
 enum SleepMode {
     SLEEP_LIGHT,
@@ -95,7 +89,9 @@ public:
     void resetIdleTimer();
     uint32_t getIdleTime();
     void setIdleTimeout(uint32_t timeout_ms);
+    uint32_t getIdleTimeout() { return idle_timeout_ms; }
     void enableAutoPowerManagement(bool enabled);
+    bool isAutoPowerManagement() { return auto_power_management; }
     
     // Battery management (stubbed for Phase 1)
     float getBatteryVoltage();
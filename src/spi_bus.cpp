@@ -0,0 +1,283 @@
+/**
+ * @file      spi_bus.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Arbitration of the SPI bus shared by the SX1262, the SD card and the e-paper panel
+ */
+
+#include "spi_bus.h"
+#include "simple_logger.h"
+#include <esp32-hal-spi.h>
+#include <esp_timer.h>
+#include <string.h>
+
+static const char *const spi_client_names[SPI_CLIENT_NUM] = {
+    "lora", "sd", "epd",
+};
+
+static uint32_t spi_client_hz[SPI_CLIENT_NUM] = {
+    SPI_BUS_LORA_HZ, SPI_BUS_SD_HZ, SPI_BUS_EPD_HZ,
+};
+
+typedef struct {
+    SemaphoreHandle_t sem;
+    uint32_t seq;
+    uint8_t client;
+    bool used;
+    bool granted;               // Handed the bus by a release
+} spi_waiter_t;
+
+// Everything below is guarded by spi_mux
+static portMUX_TYPE spi_mux = portMUX_INITIALIZER_UNLOCKED;
+static bool spi_running = false;
+static bool spi_busy = false;
+static TaskHandle_t spi_owner = NULL;
+static uint8_t spi_depth = 0;           // Nested holds by the owner, e.g. an SD log line under a LoRa hold
+static int spi_clock_client = -1;       // Whose divider is programmed
+static int64_t spi_since = 0;
+static uint32_t spi_seq = 0;
+static uint32_t spi_div[SPI_CLIENT_NUM];
+static spi_waiter_t spi_waiters[SPI_BUS_WAITERS];
+static spi_bus_stats_t spi_stats[SPI_CLIENT_NUM];
+
+SPISettings spi_bus_settings(int client) {
+    uint32_t hz = client >= 0 && client < SPI_CLIENT_NUM ? spi_client_hz[client] : SPI_BUS_SD_HZ;
+    return SPISettings(hz, MSBFIRST, SPI_MODE0);
+}
+
+// Runs with the bus held, before the client's driver opens a transaction
+static void install_clock(int client) {
+    if (spi_clock_client >= 0 && spi_client_hz[spi_clock_client] == spi_client_hz[client]) {
+        spi_clock_client = client;
+        return;
+    }
+    spi_clock_client = client;
+    if (spi_div[client]) {
+        SPI.setClockDivider(spi_div[client]);
+    }
+}
+
+static void note_hold(int client, int64_t asked, bool contended) {
+    int64_t now = esp_timer_get_time();
+    uint32_t waited = (uint32_t)(now - asked);
+    portENTER_CRITICAL(&spi_mux);
+    spi_owner = xTaskGetCurrentTaskHandle();
+    spi_since = now;
+    spi_stats[client].holds++;
+    spi_stats[client].wait_us += waited;
+    if (waited > spi_stats[client].wait_max_us) {
+        spi_stats[client].wait_max_us = waited;
+    }
+    if (contended) {
+        spi_stats[client].contended++;
+    }
+    portEXIT_CRITICAL(&spi_mux);
+    install_clock(client);
+}
+
+bool spi_bus_acquire(int client, uint32_t timeout_ms) {
+    if (client < 0 || client >= SPI_CLIENT_NUM) {
+        return false;
+    }
+    int64_t asked = esp_timer_get_time();
+    TickType_t start = xTaskGetTickCount();
+    TickType_t ticks = timeout_ms == portMAX_DELAY ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms);
+
+    while (true) {
+        spi_waiter_t *w = NULL;
+        portENTER_CRITICAL(&spi_mux);
+        if (spi_busy && spi_owner == xTaskGetCurrentTaskHandle()) {
+            spi_depth++;
+            portEXIT_CRITICAL(&spi_mux);
+            return true;
+        }
+        bool idle = !spi_busy || !spi_running;      // Nothing to arbitrate before begin
+        if (idle) {
+            spi_busy = true;
+        } else {
+            for (int i = 0; i < SPI_BUS_WAITERS; i++) {
+                if (!spi_waiters[i].used) {
+                    w = &spi_waiters[i];
+                    w->used = true;
+                    w->granted = false;
+                    w->client = client;
+                    w->seq = spi_seq++;
+                    break;
+                }
+            }
+        }
+        portEXIT_CRITICAL(&spi_mux);
+
+        if (idle) {
+            note_hold(client, asked, false);
+            return true;
+        }
+
+        TickType_t elapsed = xTaskGetTickCount() - start;
+        TickType_t left = ticks == portMAX_DELAY ? portMAX_DELAY : (elapsed < ticks ? ticks - elapsed : 0);
+        if (!w) {
+            if (left == 0) {
+                break;
+            }
+            vTaskDelay(1);
+            continue;
+        }
+
+        bool got = xSemaphoreTake(w->sem, left) == pdTRUE;
+        portENTER_CRITICAL(&spi_mux);
+        if (!got && w->granted) {
+            got = true;         // Handed over between the timeout and here
+            xSemaphoreTake(w->sem, 0);
+        }
+        w->used = false;
+        portEXIT_CRITICAL(&spi_mux);
+
+        if (got) {
+            note_hold(client, asked, true);
+            return true;
+        }
+        break;
+    }
+
+    portENTER_CRITICAL(&spi_mux);
+    spi_stats[client].timeouts++;
+    portEXIT_CRITICAL(&spi_mux);
+    return false;
+}
+
+void spi_bus_release(int client) {
+    if (client < 0 || client >= SPI_CLIENT_NUM) {
+        return;
+    }
+    spi_waiter_t *next = NULL;
+
+    portENTER_CRITICAL(&spi_mux);
+    if (spi_running && spi_owner != xTaskGetCurrentTaskHandle()) {
+        portEXIT_CRITICAL(&spi_mux);
+        return;
+    }
+    if (spi_depth) {
+        spi_depth--;
+        portEXIT_CRITICAL(&spi_mux);
+        return;
+    }
+    spi_owner = NULL;
+    uint32_t held = (uint32_t)(esp_timer_get_time() - spi_since);
+    if (held > spi_stats[client].hold_max_us) {
+        spi_stats[client].hold_max_us = held;
+    }
+    for (int i = 0; i < SPI_BUS_WAITERS; i++) {
+        spi_waiter_t *w = &spi_waiters[i];
+        if (w->used && !w->granted && (!next || w->client < next->client ||
+                                       (w->client == next->client && (int32_t)(w->seq - next->seq) < 0))) {
+            next = w;
+        }
+    }
+    if (next) {
+        next->granted = true;   // The bus stays busy, it changes hands here
+    } else {
+        spi_busy = false;
+    }
+    portEXIT_CRITICAL(&spi_mux);
+
+    if (next) {
+        xSemaphoreGive(next->sem);
+    }
+}
+
+bool spi_bus_held() {
+    portENTER_CRITICAL(&spi_mux);
+    bool held = spi_busy && spi_owner == xTaskGetCurrentTaskHandle();
+    portEXIT_CRITICAL(&spi_mux);
+    return held;
+}
+
+bool spi_bus_yield(int client) {
+    bool urgent = false;
+    portENTER_CRITICAL(&spi_mux);
+    // Only the outermost hold can step aside
+    for (int i = 0; i < SPI_BUS_WAITERS && !urgent && !spi_depth; i++) {
+        urgent = spi_waiters[i].used && !spi_waiters[i].granted && spi_waiters[i].client < client;
+    }
+    if (urgent) {
+        spi_stats[client].yields++;
+    }
+    portEXIT_CRITICAL(&spi_mux);
+
+    if (!urgent) {
+        return false;
+    }
+    // The waiter outranks us, so it is handed the bus and we queue behind it
+    spi_bus_release(client);
+    spi_bus_acquire(client);
+    return true;
+}
+
+bool spi_bus_begin() {
+    if (spi_running) {
+        return true;
+    }
+    for (int i = 0; i < SPI_BUS_WAITERS; i++) {
+        if (!spi_waiters[i].sem) {
+            spi_waiters[i].sem = xSemaphoreCreateBinary();
+        }
+        if (!spi_waiters[i].sem) {
+            LOG_ERROR("SPI", "Failed to create bus waiter semaphores");
+            return false;
+        }
+    }
+    for (int i = 0; i < SPI_CLIENT_NUM; i++) {
+        spi_div[i] = spiFrequencyToClockDiv(spi_client_hz[i]);
+    }
+    portENTER_CRITICAL(&spi_mux);
+    spi_running = true;
+    portEXIT_CRITICAL(&spi_mux);
+    LOG_INFO("SPI", "Bus arbitration running: LoRa before SD before EPD");
+    return true;
+}
+
+void spi_bus_set_clock(int client, uint32_t hz) {
+    if (client < 0 || client >= SPI_CLIENT_NUM || !hz) {
+        return;
+    }
+    uint32_t div = spiFrequencyToClockDiv(hz);
+    portENTER_CRITICAL(&spi_mux);
+    spi_client_hz[client] = hz;
+    spi_div[client] = spi_running ? div : 0;
+    if (spi_clock_client == client) {
+        spi_clock_client = -1;      // Reinstall at the next hold
+    }
+    portEXIT_CRITICAL(&spi_mux);
+}
+
+uint32_t spi_bus_clock(int client) {
+    return client >= 0 && client < SPI_CLIENT_NUM ? spi_client_hz[client] : 0;
+}
+
+void spi_bus_get_stats(int client, spi_bus_stats_t *stats) {
+    if (client < 0 || client >= SPI_CLIENT_NUM) {
+        memset(stats, 0, sizeof(*stats));
+        return;
+    }
+    portENTER_CRITICAL(&spi_mux);
+    *stats = spi_stats[client];
+    portEXIT_CRITICAL(&spi_mux);
+}
+
+void spi_bus_log_stats() {
+    for (int client = 0; client < SPI_CLIENT_NUM; client++) {
+        spi_bus_stats_t s;
+        spi_bus_get_stats(client, &s);
+        if (!s.holds) {
+            continue;
+        }
+        LOG_INFOF("SPI", "%s: %lu holds, %lu contended, %lu yields, %lu timeouts, "
+                  "wait avg %lu max %lu us, hold max %lu us",
+                  spi_client_names[client], (unsigned long)s.holds, (unsigned long)s.contended,
+                  (unsigned long)s.yields, (unsigned long)s.timeouts,
+                  (unsigned long)(s.wait_us / s.holds), (unsigned long)s.wait_max_us,
+                  (unsigned long)s.hold_max_us);
+    }
+}
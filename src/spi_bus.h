@@ -0,0 +1,98 @@
+/**
+ * @file      spi_bus.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Arbitration of the SPI bus shared by the SX1262, the SD card and the e-paper panel
+ */
+
+#ifndef SPI_BUS_H
+#define SPI_BUS_H
+
+#include <Arduino.h>
+#include <SPI.h>
+
+#define SPI_BUS_WAITERS             8       // Tasks that can queue for the bus at once
+
+// Clocks are whole divisors of the 80 MHz APB so a cached divider reads
+// back as the same frequency and SPIClass skips its divider search
+#define SPI_BUS_LORA_HZ             2000000 // RadioLib's default
+#define SPI_BUS_SD_HZ               4000000 // SD.begin()'s default, until sd_manager probes the card
+#define SPI_BUS_EPD_HZ              4000000 // GxEPD2's default
+
+// Lower goes first. Holders give the bus up at transaction boundaries only,
+// so a waiter gets in at the next one
+enum {
+    SPI_CLIENT_LORA = 0,        // Radio IRQ service, TX start, RX read
+    SPI_CLIENT_SD,              // File writes and reads
+    SPI_CLIENT_EPD,             // Panel image writes, in chunks
+    SPI_CLIENT_NUM,
+};
+
+typedef struct {
+    uint32_t holds;
+    uint32_t contended;         // Holds that had to wait
+    uint32_t yields;            // Times it stepped aside mid-job for a more urgent client
+    uint32_t timeouts;
+    uint64_t wait_us;
+    uint32_t wait_max_us;
+    uint32_t hold_max_us;       // Longest single hold
+} spi_bus_stats_t;
+
+/**
+ * @brief Set up the waiter queue. Call once SPI is up; safe to call again.
+ *        Until then acquire and release only keep statistics
+ */
+bool spi_bus_begin();
+
+/**
+ * @brief SPI settings for a client, for handing to its driver at init
+ */
+SPISettings spi_bus_settings(int client);
+
+/**
+ * @brief Change a client's clock, e.g. the SD card after probing. Takes
+ *        effect at its next hold; the driver must be set to the same rate
+ */
+void spi_bus_set_clock(int client, uint32_t hz);
+uint32_t spi_bus_clock(int client);
+
+/**
+ * @brief Hold the bus for a run of driver calls. Waiters get it by client
+ *        priority, then in order. Installs the client's cached clock divider
+ *        when the previous holder ran at a different clock
+ * @return false if it did not come free within timeout_ms
+ */
+bool spi_bus_acquire(int client, uint32_t timeout_ms = portMAX_DELAY);
+void spi_bus_release(int client);
+
+/**
+ * @brief True if the calling task holds the bus
+ */
+bool spi_bus_held();
+
+/**
+ * @brief Between chunks of a long job: if a more urgent client is waiting,
+ *        let it through and take the bus back. Chip select must be high
+ * @return true if the bus changed hands
+ */
+bool spi_bus_yield(int client);
+
+/**
+ * @brief Holds the bus for the enclosing scope
+ */
+class SpiBusHold {
+public:
+    explicit SpiBusHold(int client) : client(client) { spi_bus_acquire(client); }
+    ~SpiBusHold() { spi_bus_release(client); }
+    SpiBusHold(const SpiBusHold&) = delete;
+    SpiBusHold& operator=(const SpiBusHold&) = delete;
+private:
+    int client;
+};
+
+void spi_bus_get_stats(int client, spi_bus_stats_t *stats);
+void spi_bus_log_stats();
+
+#endif // SPI_BUS_H
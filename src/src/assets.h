@@ -23,8 +23,32 @@ LV_IMG_DECLARE(img_PCM5102)
 LV_IMG_DECLARE(img_touch)
 LV_IMG_DECLARE(img_start)
 
+// 1bpp copies generated by script/img_1bpp.py, drawn by img_1bpp_decoder.
+// Icons are cells of one atlas, indexed by the ICON_* values in icon_atlas.h
+#include "icon_atlas.h"
+#define IMG_1BPP_CF LV_IMG_CF_USER_ENCODED_0
+#ifdef ASSETS_PARTITION
+// Filled in from the asset pack at boot (asset_store.cpp)
+extern lv_img_dsc_t img_icon_atlas_1bpp;
+extern lv_img_dsc_t img_icons_1bpp[ICON_ATLAS_COUNT];
+extern lv_img_dsc_t img_start_1bpp;
+#else
+LV_IMG_DECLARE(img_icon_atlas_1bpp)
+extern const lv_img_dsc_t img_icons_1bpp[ICON_ATLAS_COUNT];
+LV_IMG_DECLARE(img_start_1bpp)
+#endif
+
 
 // font
+#ifdef ASSETS_PARTITION
+extern lv_font_t Font_Mono_Bold_14;
+extern lv_font_t Font_Mono_Bold_15;
+extern lv_font_t Font_Mono_Bold_16;
+extern lv_font_t Font_Mono_Bold_17;
+extern lv_font_t Font_Mono_Bold_18;
+extern lv_font_t Font_Mono_Bold_19;
+extern lv_font_t Font_Mono_Bold_20;
+#else
 LV_FONT_DECLARE(Font_Mono_Bold_14)
 LV_FONT_DECLARE(Font_Mono_Bold_15)
 LV_FONT_DECLARE(Font_Mono_Bold_16)
@@ -32,6 +56,7 @@ LV_FONT_DECLARE(Font_Mono_Bold_17)
 LV_FONT_DECLARE(Font_Mono_Bold_18)
 LV_FONT_DECLARE(Font_Mono_Bold_19)
 LV_FONT_DECLARE(Font_Mono_Bold_20)
+#endif
 
 #ifdef __cplusplus
 } /*extern "C"*/
@@ -0,0 +1,22 @@
+/* Generated by script/img_1bpp.py from src/src/img_*.c, do not edit */
+
+#ifndef ICON_ATLAS_H
+#define ICON_ATLAS_H
+
+#define ICON_ATLAS_SIZE 64
+#define ICON_ATLAS_COUNT 10
+
+enum {
+    ICON_A7682E = 0,
+    ICON_GPS = 1,
+    ICON_PCM5102 = 2,
+    ICON_SD = 3,
+    ICON_BATT = 4,
+    ICON_LORA = 5,
+    ICON_SETTING = 6,
+    ICON_TEST = 7,
+    ICON_TOUCH = 8,
+    ICON_WIFI = 9,
+};
+
+#endif /* ICON_ATLAS_H */
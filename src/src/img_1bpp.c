@@ -0,0 +1,1000 @@
+/* Generated by script/img_1bpp.py from src/src/img_*.c, do not edit */
+
+#include "lvgl.h"
+#include "assets.h"
+
+static const uint8_t img_icon_atlas_map[] = {
+  /* ICON_A7682E */
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xc0, 0x00, 0x00, 0x03, 0xff, 0xff,
+  0xff, 0xfe, 0x00, 0x00, 0x00, 0x00, 0x7f, 0xff,
+  0xff, 0xfc, 0x1f, 0xff, 0xff, 0xfc, 0x1f, 0xff,
+  0xff, 0xf0, 0xff, 0xff, 0xff, 0xff, 0x0f, 0xff,
+  0xff, 0xe3, 0xff, 0xff, 0xff, 0xff, 0xc7, 0xff,
+  0xff, 0xc7, 0xff, 0xff, 0xff, 0xff, 0xe3, 0xff,
+  0xff, 0x87, 0xff, 0xff, 0xff, 0xff, 0xf3, 0xff,
+  0xff, 0x9f, 0xff, 0xff, 0xff, 0xff, 0xf9, 0xff,
+  0xff, 0x1f, 0xff, 0xff, 0xff, 0xff, 0xf8, 0xff,
+  0xff, 0x3f, 0xff, 0xff, 0xff, 0xff, 0xfc, 0xff,
+  0xff, 0x3f, 0xff, 0xff, 0xff, 0xff, 0xfc, 0xff,
+  0xfe, 0x7f, 0xff, 0xff, 0xfc, 0x1f, 0xfc, 0x7f,
+  0xfe, 0x7f, 0xff, 0xff, 0xf8, 0x0f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xf8, 0xff, 0xf0, 0x07, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xf0, 0x7f, 0xe0, 0x03, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xe0, 0x3f, 0xe0, 0x03, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xe0, 0x1f, 0xe0, 0x03, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xc0, 0x0f, 0xe0, 0x07, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xc0, 0x07, 0xf0, 0x07, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xc0, 0x07, 0xf0, 0x0f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xc0, 0x07, 0xe0, 0x3f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xc0, 0x0f, 0xff, 0xff, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xe0, 0x1f, 0xff, 0xff, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xe0, 0x1f, 0xff, 0xff, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xe0, 0x0f, 0xff, 0xff, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xf0, 0x0f, 0xff, 0xff, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xf0, 0x07, 0xff, 0xff, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xf8, 0x03, 0xff, 0xff, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xfc, 0x01, 0xf1, 0xff, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xfe, 0x00, 0xc0, 0xff, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xfe, 0x00, 0x00, 0x7f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xff, 0x00, 0x00, 0x3f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xff, 0x80, 0x00, 0x1f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xff, 0xc0, 0x00, 0x0f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xff, 0xf0, 0x00, 0x0f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xff, 0xf8, 0x00, 0x0f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xff, 0xfe, 0x00, 0x1f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xff, 0xff, 0x80, 0x3f, 0xfe, 0x7f,
+  0xfe, 0x3f, 0xff, 0xff, 0xe0, 0x7f, 0xfe, 0x7f,
+  0xff, 0x3f, 0xff, 0xff, 0xff, 0xff, 0xfc, 0xff,
+  0xff, 0x3f, 0xff, 0xff, 0xff, 0xff, 0xfc, 0xff,
+  0xff, 0x1f, 0xff, 0xff, 0xff, 0xff, 0xfc, 0xff,
+  0xff, 0x9f, 0xff, 0xff, 0xff, 0xff, 0xf9, 0xff,
+  0xff, 0xcf, 0xff, 0xff, 0xff, 0xff, 0xf1, 0xff,
+  0xff, 0xc7, 0xff, 0xff, 0xff, 0xff, 0xe3, 0xff,
+  0xff, 0xe3, 0xff, 0xff, 0xff, 0xff, 0xc7, 0xff,
+  0xff, 0xf1, 0xff, 0xff, 0xff, 0xff, 0x0f, 0xff,
+  0xff, 0xf8, 0x3f, 0xff, 0xff, 0xf8, 0x3f, 0xff,
+  0xff, 0xfe, 0x00, 0x00, 0x00, 0x00, 0x7f, 0xff,
+  0xff, 0xff, 0xc0, 0x00, 0x00, 0x03, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  /* ICON_GPS */
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xc0, 0x00, 0x00, 0x03, 0xff, 0xff,
+  0xff, 0xfe, 0x00, 0x00, 0x00, 0x00, 0x7f, 0xff,
+  0xff, 0xfc, 0x1f, 0xff, 0xff, 0xfc, 0x1f, 0xff,
+  0xff, 0xf0, 0xff, 0xff, 0xff, 0xff, 0x8f, 0xff,
+  0xff, 0xe3, 0xff, 0xff, 0xff, 0xff, 0xc7, 0xff,
+  0xff, 0xc7, 0xff, 0xff, 0xff, 0xff, 0xe3, 0xff,
+  0xff, 0x8f, 0xff, 0xff, 0xff, 0xff, 0xf3, 0xff,
+  0xff, 0x9f, 0xff, 0xff, 0xff, 0xff, 0xf9, 0xff,
+  0xff, 0x3f, 0xff, 0xff, 0xff, 0xff, 0xf8, 0xff,
+  0xff, 0x3f, 0xff, 0xff, 0xff, 0xff, 0xfc, 0xff,
+  0xff, 0x3f, 0xff, 0xe0, 0x0f, 0xff, 0xfc, 0xff,
+  0xfe, 0x7f, 0xff, 0xc0, 0x03, 0xff, 0xfc, 0x7f,
+  0xfe, 0x7f, 0xff, 0x80, 0x00, 0xff, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xfe, 0x00, 0x00, 0x7f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xfe, 0x00, 0x00, 0x7f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xfc, 0x00, 0x00, 0x3f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xfc, 0x00, 0x80, 0x3f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xf8, 0x07, 0xe0, 0x1f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xf8, 0x0f, 0xf0, 0x1f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xf8, 0x0f, 0xf0, 0x1f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xf8, 0x0f, 0xf0, 0x1f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xf8, 0x0f, 0xf0, 0x1f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xf8, 0x0f, 0xf0, 0x1f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xf8, 0x07, 0xe0, 0x1f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xf8, 0x03, 0x80, 0x1f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xfc, 0x00, 0x00, 0x3f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xfc, 0x00, 0x00, 0x3f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xfe, 0x00, 0x00, 0x7f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xfe, 0x00, 0x00, 0x7f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xff, 0x00, 0x00, 0xff, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xff, 0x00, 0x00, 0xff, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xff, 0x80, 0x01, 0xff, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xff, 0xc0, 0x03, 0xff, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xff, 0xc0, 0x07, 0xff, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xff, 0xe0, 0x07, 0xff, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xff, 0xf0, 0x0f, 0xff, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xff, 0xf8, 0x1f, 0xff, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xff, 0xfc, 0x3f, 0xff, 0xfe, 0x7f,
+  0xfe, 0x3f, 0xff, 0xfe, 0x7f, 0xff, 0xfe, 0x7f,
+  0xff, 0x3f, 0xff, 0xff, 0xff, 0xff, 0xfc, 0xff,
+  0xff, 0x3f, 0xff, 0xff, 0xff, 0xff, 0xfc, 0xff,
+  0xff, 0x1f, 0xff, 0xff, 0xff, 0xff, 0xfc, 0xff,
+  0xff, 0x9f, 0xff, 0xff, 0xff, 0xff, 0xf9, 0xff,
+  0xff, 0xcf, 0xff, 0xff, 0xff, 0xff, 0xf1, 0xff,
+  0xff, 0xc7, 0xff, 0xff, 0xff, 0xff, 0xe3, 0xff,
+  0xff, 0xe3, 0xff, 0xff, 0xff, 0xff, 0xc7, 0xff,
+  0xff, 0xf1, 0xff, 0xff, 0xff, 0xff, 0x0f, 0xff,
+  0xff, 0xf8, 0x3f, 0xff, 0xff, 0xf8, 0x3f, 0xff,
+  0xff, 0xfe, 0x00, 0x00, 0x00, 0x00, 0x7f, 0xff,
+  0xff, 0xff, 0xc0, 0x00, 0x00, 0x03, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  /* ICON_PCM5102 */
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xc0, 0x00, 0x00, 0x03, 0xff, 0xff,
+  0xff, 0xfe, 0x00, 0x00, 0x00, 0x00, 0x7f, 0xff,
+  0xff, 0xfc, 0x1f, 0xff, 0xff, 0xfc, 0x1f, 0xff,
+  0xff, 0xf0, 0xff, 0xff, 0xff, 0xff, 0x0f, 0xff,
+  0xff, 0xe3, 0xff, 0xff, 0xff, 0xff, 0xc7, 0xff,
+  0xff, 0xc7, 0xff, 0xff, 0xff, 0xff, 0xe3, 0xff,
+  0xff, 0x87, 0xff, 0xff, 0xff, 0xff, 0xf3, 0xff,
+  0xff, 0x9f, 0xff, 0xff, 0xff, 0xff, 0xf9, 0xff,
+  0xff, 0x1f, 0xff, 0xff, 0xff, 0xff, 0xf8, 0xff,
+  0xff, 0x3f, 0xff, 0xff, 0xff, 0xff, 0xfc, 0xff,
+  0xff, 0x3f, 0xff, 0xff, 0x1f, 0xff, 0xfc, 0xff,
+  0xfe, 0x7f, 0xff, 0xfc, 0x0f, 0xff, 0xfc, 0x7f,
+  0xfe, 0x7f, 0xff, 0xf8, 0x03, 0xff, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xff, 0xf8, 0x03, 0xff, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xff, 0xf8, 0x00, 0xff, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xff, 0xf9, 0x80, 0x7f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xff, 0xf8, 0x80, 0x1f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xff, 0xf8, 0xc0, 0x07, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xff, 0xf8, 0xe0, 0x03, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xff, 0xf8, 0xf0, 0x0f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xff, 0xf8, 0xfc, 0x3f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xff, 0xf8, 0xff, 0xff, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xff, 0xf8, 0xff, 0xff, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xff, 0xf8, 0xff, 0xff, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xff, 0xf8, 0xff, 0xff, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xff, 0xf8, 0xff, 0xff, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xff, 0xf8, 0xff, 0xff, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xff, 0x38, 0xff, 0xff, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xfe, 0x18, 0xff, 0xff, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xfe, 0x08, 0xff, 0xff, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xfc, 0x00, 0xff, 0xff, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xfc, 0x00, 0xff, 0xff, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xfc, 0x00, 0xff, 0xff, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xfc, 0x00, 0xff, 0xff, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xfc, 0x00, 0xff, 0xff, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xfc, 0x00, 0xff, 0xff, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xfe, 0x00, 0xff, 0xff, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xff, 0x01, 0xff, 0xff, 0xfe, 0x7f,
+  0xfe, 0x3f, 0xff, 0x03, 0xff, 0xff, 0xfe, 0x7f,
+  0xff, 0x3f, 0xff, 0xcf, 0xff, 0xff, 0xfc, 0xff,
+  0xff, 0x3f, 0xff, 0xff, 0xff, 0xff, 0xfc, 0xff,
+  0xff, 0x1f, 0xff, 0xff, 0xff, 0xff, 0xfc, 0xff,
+  0xff, 0x9f, 0xff, 0xff, 0xff, 0xff, 0xf9, 0xff,
+  0xff, 0xcf, 0xff, 0xff, 0xff, 0xff, 0xf1, 0xff,
+  0xff, 0xc7, 0xff, 0xff, 0xff, 0xff, 0xe3, 0xff,
+  0xff, 0xe3, 0xff, 0xff, 0xff, 0xff, 0xc7, 0xff,
+  0xff, 0xf1, 0xff, 0xff, 0xff, 0xff, 0x0f, 0xff,
+  0xff, 0xf8, 0x3f, 0xff, 0xff, 0xf8, 0x3f, 0xff,
+  0xff, 0xfe, 0x00, 0x00, 0x00, 0x00, 0x7f, 0xff,
+  0xff, 0xff, 0xc0, 0x00, 0x00, 0x03, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  /* ICON_SD */
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xc0, 0x00, 0x00, 0x03, 0xff, 0xff,
+  0xff, 0xfe, 0x00, 0x00, 0x00, 0x00, 0x7f, 0xff,
+  0xff, 0xfc, 0x1f, 0xff, 0xff, 0xfc, 0x1f, 0xff,
+  0xff, 0xf0, 0xff, 0xff, 0xff, 0xff, 0x0f, 0xff,
+  0xff, 0xe3, 0xff, 0xff, 0xff, 0xff, 0xc7, 0xff,
+  0xff, 0xc7, 0xff, 0xff, 0xff, 0xff, 0xe3, 0xff,
+  0xff, 0x8f, 0xff, 0xff, 0xff, 0xff, 0xf3, 0xff,
+  0xff, 0x9f, 0xff, 0xff, 0xff, 0xff, 0xf9, 0xff,
+  0xff, 0x1f, 0xff, 0xff, 0xff, 0xff, 0xf8, 0xff,
+  0xff, 0x3f, 0xf0, 0x00, 0x03, 0xff, 0xfc, 0xff,
+  0xff, 0x3f, 0xf0, 0x00, 0x00, 0xff, 0xfc, 0xff,
+  0xfe, 0x7f, 0xe0, 0x00, 0x00, 0x7f, 0xfc, 0x7f,
+  0xfe, 0x7f, 0xe3, 0xff, 0xfc, 0x3f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xe3, 0xff, 0xfe, 0x1f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xe3, 0xff, 0xff, 0x0f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xe3, 0xbf, 0xff, 0x87, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xe3, 0x19, 0x9f, 0xc7, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xe3, 0x11, 0x9f, 0xc7, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xe3, 0x11, 0x9f, 0xc7, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xe3, 0x11, 0x9f, 0xc7, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xe3, 0x19, 0x9f, 0xc7, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xe3, 0xbb, 0xdf, 0xc7, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xe3, 0xff, 0xff, 0xc7, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xe3, 0xff, 0xff, 0xc7, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xe3, 0xff, 0xff, 0xc7, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xe3, 0x80, 0x01, 0xc7, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xe3, 0x00, 0x00, 0xc7, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xe3, 0x00, 0x00, 0xc7, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xe3, 0x1f, 0xf8, 0xc7, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xe3, 0x1f, 0xf8, 0xc7, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xe3, 0x1f, 0xf8, 0xc7, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xe3, 0x1f, 0xf8, 0xc7, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xe3, 0x00, 0x00, 0xc7, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xe3, 0x00, 0x00, 0xc7, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xe3, 0x80, 0x01, 0xc7, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xe3, 0xff, 0xff, 0xc7, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xe3, 0xff, 0xff, 0xc7, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xe3, 0xff, 0xff, 0xc7, 0xfe, 0x7f,
+  0xfe, 0x3f, 0xe0, 0x00, 0x00, 0x07, 0xfe, 0x7f,
+  0xff, 0x3f, 0xe0, 0x00, 0x00, 0x0f, 0xfc, 0xff,
+  0xff, 0x3f, 0xf8, 0x00, 0x00, 0x0f, 0xfc, 0xff,
+  0xff, 0x1f, 0xff, 0xff, 0xff, 0xff, 0xf8, 0xff,
+  0xff, 0x9f, 0xff, 0xff, 0xff, 0xff, 0xf9, 0xff,
+  0xff, 0xcf, 0xff, 0xff, 0xff, 0xff, 0xf1, 0xff,
+  0xff, 0xc7, 0xff, 0xff, 0xff, 0xff, 0xe3, 0xff,
+  0xff, 0xe3, 0xff, 0xff, 0xff, 0xff, 0xc7, 0xff,
+  0xff, 0xf0, 0xff, 0xff, 0xff, 0xff, 0x0f, 0xff,
+  0xff, 0xf8, 0x3f, 0xff, 0xff, 0xf8, 0x3f, 0xff,
+  0xff, 0xfe, 0x00, 0x00, 0x00, 0x00, 0x7f, 0xff,
+  0xff, 0xff, 0xc0, 0x00, 0x00, 0x03, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  /* ICON_BATT */
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xc0, 0x00, 0x00, 0x03, 0xff, 0xff,
+  0xff, 0xfe, 0x00, 0x00, 0x00, 0x00, 0x7f, 0xff,
+  0xff, 0xfc, 0x1f, 0xff, 0xff, 0xfc, 0x1f, 0xff,
+  0xff, 0xf0, 0xff, 0xff, 0xff, 0xff, 0x8f, 0xff,
+  0xff, 0xe3, 0xff, 0xff, 0xff, 0xff, 0xc7, 0xff,
+  0xff, 0xc7, 0xff, 0xff, 0xff, 0xff, 0xe3, 0xff,
+  0xff, 0x8f, 0xff, 0xff, 0xff, 0xff, 0xf3, 0xff,
+  0xff, 0x9f, 0xff, 0xff, 0xff, 0xff, 0xf9, 0xff,
+  0xff, 0x3f, 0xff, 0xff, 0xff, 0xff, 0xf8, 0xff,
+  0xff, 0x3f, 0xff, 0xff, 0xff, 0xff, 0xfc, 0xff,
+  0xff, 0x3f, 0xff, 0xf0, 0x0f, 0xff, 0xfc, 0xff,
+  0xfe, 0x7f, 0xff, 0xf0, 0x0f, 0xff, 0xfc, 0x7f,
+  0xfe, 0x7f, 0xfe, 0x00, 0x00, 0x7f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xfc, 0x00, 0x00, 0x3f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xfc, 0x00, 0x00, 0x1f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xf8, 0x00, 0x00, 0x1f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xf8, 0x00, 0x00, 0x1f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xf8, 0x3f, 0xfc, 0x1f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xf8, 0x20, 0x04, 0x1f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xf8, 0x20, 0x04, 0x1f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xf8, 0x20, 0x04, 0x1f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xf8, 0x20, 0x04, 0x1f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xf8, 0x20, 0x04, 0x1f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xf8, 0x3f, 0xfc, 0x1f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xf8, 0x3f, 0xfc, 0x1f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xf8, 0x20, 0x04, 0x1f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xf8, 0x20, 0x04, 0x1f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xf8, 0x20, 0x04, 0x1f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xf8, 0x20, 0x04, 0x1f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xf8, 0x30, 0x0c, 0x1f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xf8, 0x3f, 0xfc, 0x1f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xf8, 0x20, 0x04, 0x1f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xf8, 0x20, 0x04, 0x1f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xf8, 0x20, 0x04, 0x1f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xf8, 0x20, 0x04, 0x1f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xf8, 0x20, 0x04, 0x1f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xf8, 0x3f, 0xfc, 0x1f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xf8, 0x00, 0x00, 0x1f, 0xfe, 0x7f,
+  0xfe, 0x3f, 0xf8, 0x00, 0x00, 0x1f, 0xfe, 0x7f,
+  0xff, 0x3f, 0xf8, 0x00, 0x00, 0x1f, 0xfc, 0xff,
+  0xff, 0x3f, 0xfc, 0x00, 0x00, 0x3f, 0xfc, 0xff,
+  0xff, 0x1f, 0xfe, 0x00, 0x00, 0x7f, 0xfc, 0xff,
+  0xff, 0x9f, 0xff, 0xff, 0xff, 0xff, 0xf9, 0xff,
+  0xff, 0xcf, 0xff, 0xff, 0xff, 0xff, 0xf1, 0xff,
+  0xff, 0xc7, 0xff, 0xff, 0xff, 0xff, 0xe3, 0xff,
+  0xff, 0xe3, 0xff, 0xff, 0xff, 0xff, 0xc7, 0xff,
+  0xff, 0xf1, 0xff, 0xff, 0xff, 0xff, 0x0f, 0xff,
+  0xff, 0xf8, 0x3f, 0xff, 0xff, 0xf8, 0x3f, 0xff,
+  0xff, 0xfe, 0x00, 0x00, 0x00, 0x00, 0x7f, 0xff,
+  0xff, 0xff, 0xc0, 0x00, 0x00, 0x03, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  /* ICON_LORA */
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xc0, 0x00, 0x00, 0x03, 0xff, 0xff,
+  0xff, 0xfe, 0x00, 0x00, 0x00, 0x00, 0x7f, 0xff,
+  0xff, 0xfc, 0x1f, 0xff, 0xff, 0xfc, 0x1f, 0xff,
+  0xff, 0xf0, 0xff, 0xff, 0xff, 0xff, 0x8f, 0xff,
+  0xff, 0xe3, 0xff, 0xff, 0xff, 0xff, 0xc7, 0xff,
+  0xff, 0xc7, 0xff, 0xff, 0xff, 0xff, 0xe3, 0xff,
+  0xff, 0x8f, 0xff, 0xff, 0xff, 0xff, 0xf3, 0xff,
+  0xff, 0x9f, 0xff, 0xff, 0xff, 0xff, 0xf9, 0xff,
+  0xff, 0x3f, 0xff, 0xff, 0xff, 0xff, 0xf8, 0xff,
+  0xff, 0x3f, 0xff, 0xff, 0x7f, 0xff, 0xfc, 0xff,
+  0xff, 0x3f, 0xff, 0xe0, 0x03, 0xff, 0xfc, 0xff,
+  0xfe, 0x7f, 0xff, 0x80, 0x00, 0xff, 0xfc, 0x7f,
+  0xfe, 0x7f, 0xfe, 0x07, 0xc0, 0x7f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xfc, 0x3f, 0xf8, 0x3f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xf8, 0x7f, 0xfe, 0x1f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xf1, 0xfc, 0x3f, 0x8f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xe3, 0xe0, 0x07, 0xc7, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xc3, 0xc0, 0x03, 0xc7, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xc7, 0x87, 0xc1, 0xe3, 0xfe, 0x7f,
+  0xfe, 0x7f, 0x87, 0x1f, 0xf0, 0xf3, 0xfe, 0x7f,
+  0xfe, 0x7f, 0x8e, 0x1f, 0xfc, 0x71, 0xfe, 0x7f,
+  0xfe, 0x7f, 0x8e, 0x3c, 0x3c, 0x71, 0xfe, 0x7f,
+  0xfe, 0x7f, 0x8e, 0x38, 0x1e, 0x79, 0xfe, 0x7f,
+  0xfe, 0x7f, 0x9c, 0x70, 0x0e, 0x39, 0xfe, 0x7f,
+  0xfe, 0x7f, 0x1c, 0x71, 0x8e, 0x39, 0xfe, 0x7f,
+  0xfe, 0x7f, 0x9c, 0x71, 0x8e, 0x38, 0xfe, 0x7f,
+  0xfe, 0x7f, 0x9c, 0x70, 0x0e, 0x39, 0xfe, 0x7f,
+  0xfe, 0x7f, 0x9e, 0x78, 0x1c, 0x71, 0xfe, 0x7f,
+  0xfe, 0x7f, 0x8e, 0x3c, 0x3c, 0x71, 0xfe, 0x7f,
+  0xfe, 0x7f, 0x8e, 0x3e, 0x78, 0x71, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xcf, 0x1e, 0x78, 0xe1, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xc7, 0x9e, 0x79, 0xe3, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xe3, 0xfe, 0x7f, 0xc3, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xe3, 0xfe, 0x7f, 0xc7, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xf1, 0xfe, 0x7f, 0x8f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xf9, 0xfe, 0x7f, 0x9f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xff, 0xfe, 0x7f, 0xff, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xff, 0xfc, 0x7f, 0xff, 0xfe, 0x7f,
+  0xfe, 0x3f, 0xff, 0xf0, 0x0f, 0xff, 0xfe, 0x7f,
+  0xff, 0x3f, 0xff, 0xf0, 0x0f, 0xff, 0xfc, 0xff,
+  0xff, 0x3f, 0xff, 0xf8, 0x1f, 0xff, 0xfc, 0xff,
+  0xff, 0x1f, 0xff, 0xff, 0xff, 0xff, 0xfc, 0xff,
+  0xff, 0x9f, 0xff, 0xff, 0xff, 0xff, 0xf9, 0xff,
+  0xff, 0xcf, 0xff, 0xff, 0xff, 0xff, 0xf1, 0xff,
+  0xff, 0xc7, 0xff, 0xff, 0xff, 0xff, 0xe3, 0xff,
+  0xff, 0xe3, 0xff, 0xff, 0xff, 0xff, 0xc7, 0xff,
+  0xff, 0xf1, 0xff, 0xff, 0xff, 0xff, 0x0f, 0xff,
+  0xff, 0xf8, 0x3f, 0xff, 0xff, 0xf8, 0x3f, 0xff,
+  0xff, 0xfe, 0x00, 0x00, 0x00, 0x00, 0x7f, 0xff,
+  0xff, 0xff, 0xc0, 0x00, 0x00, 0x03, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  /* ICON_SETTING */
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xc0, 0x00, 0x00, 0x03, 0xff, 0xff,
+  0xff, 0xfe, 0x00, 0x00, 0x00, 0x00, 0x7f, 0xff,
+  0xff, 0xfc, 0x1f, 0xff, 0xff, 0xfc, 0x1f, 0xff,
+  0xff, 0xf0, 0xff, 0xff, 0xff, 0xff, 0x8f, 0xff,
+  0xff, 0xe3, 0xff, 0xff, 0xff, 0xff, 0xc7, 0xff,
+  0xff, 0xc7, 0xff, 0xff, 0xff, 0xff, 0xe3, 0xff,
+  0xff, 0x8f, 0xff, 0xff, 0xff, 0xff, 0xf3, 0xff,
+  0xff, 0x9f, 0xff, 0xff, 0xff, 0xff, 0xf9, 0xff,
+  0xff, 0x3f, 0xff, 0xff, 0xff, 0xff, 0xf8, 0xff,
+  0xff, 0x3f, 0xff, 0xff, 0xff, 0xff, 0xfc, 0xff,
+  0xff, 0x3f, 0xff, 0xc7, 0xe7, 0xff, 0xfc, 0xff,
+  0xfe, 0x7f, 0xff, 0x03, 0xc1, 0xff, 0xfc, 0x7f,
+  0xfe, 0x7f, 0xfe, 0x00, 0x00, 0x7f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xfc, 0x10, 0x0c, 0x3f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xf8, 0x7c, 0x3e, 0x1f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xf8, 0xff, 0xff, 0x1f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xf8, 0xff, 0xff, 0x1f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xf8, 0xff, 0xff, 0x1f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xf8, 0xff, 0xff, 0x1f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xc1, 0xf8, 0x1f, 0x83, 0xfe, 0x7f,
+  0xfe, 0x7f, 0x83, 0xf0, 0x0f, 0xc1, 0xfe, 0x7f,
+  0xfe, 0x7f, 0x87, 0xe0, 0x87, 0xe1, 0xfe, 0x7f,
+  0xfe, 0x7f, 0x8f, 0xc7, 0xe3, 0xf1, 0xfe, 0x7f,
+  0xfe, 0x7f, 0x9f, 0xc7, 0xe3, 0xf1, 0xfe, 0x7f,
+  0xfe, 0x7f, 0x9f, 0xcf, 0xe3, 0xf8, 0xfe, 0x7f,
+  0xfe, 0x7f, 0x1f, 0xc7, 0xf3, 0xf9, 0xfe, 0x7f,
+  0xfe, 0x7f, 0x8f, 0xc7, 0xe3, 0xf1, 0xfe, 0x7f,
+  0xfe, 0x7f, 0x87, 0xc7, 0xe3, 0xc1, 0xfe, 0x7f,
+  0xfe, 0x7f, 0x81, 0xe1, 0x07, 0x81, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xf1, 0xf0, 0x0f, 0x87, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xf8, 0xf8, 0x1f, 0x1f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xf8, 0xff, 0xff, 0x1f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xf8, 0xff, 0xff, 0x1f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xf8, 0xff, 0xff, 0x1f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xf8, 0xfc, 0x3f, 0x0f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xf8, 0x70, 0x0e, 0x1f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xfc, 0x20, 0x00, 0x3f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xfe, 0x01, 0xc0, 0x7f, 0xfe, 0x7f,
+  0xfe, 0x3f, 0xff, 0x87, 0xc0, 0xff, 0xfe, 0x7f,
+  0xff, 0x3f, 0xff, 0xe7, 0xe3, 0xff, 0xfc, 0xff,
+  0xff, 0x3f, 0xff, 0xff, 0xff, 0xff, 0xfc, 0xff,
+  0xff, 0x1f, 0xff, 0xff, 0xff, 0xff, 0xfc, 0xff,
+  0xff, 0x9f, 0xff, 0xff, 0xff, 0xff, 0xf9, 0xff,
+  0xff, 0xcf, 0xff, 0xff, 0xff, 0xff, 0xf1, 0xff,
+  0xff, 0xc7, 0xff, 0xff, 0xff, 0xff, 0xe3, 0xff,
+  0xff, 0xe3, 0xff, 0xff, 0xff, 0xff, 0xc7, 0xff,
+  0xff, 0xf1, 0xff, 0xff, 0xff, 0xff, 0x0f, 0xff,
+  0xff, 0xf8, 0x3f, 0xff, 0xff, 0xf8, 0x3f, 0xff,
+  0xff, 0xfe, 0x00, 0x00, 0x00, 0x00, 0x7f, 0xff,
+  0xff, 0xff, 0xc0, 0x00, 0x00, 0x03, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  /* ICON_TEST */
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xc0, 0x00, 0x00, 0x03, 0xff, 0xff,
+  0xff, 0xfe, 0x00, 0x00, 0x00, 0x00, 0x7f, 0xff,
+  0xff, 0xfc, 0x1f, 0xff, 0xff, 0xfc, 0x1f, 0xff,
+  0xff, 0xf0, 0xff, 0xff, 0xff, 0xff, 0x0f, 0xff,
+  0xff, 0xe3, 0xff, 0xff, 0xff, 0xff, 0xc7, 0xff,
+  0xff, 0xc7, 0xff, 0xff, 0xff, 0xff, 0xe3, 0xff,
+  0xff, 0x8f, 0xff, 0xff, 0xff, 0xff, 0xf3, 0xff,
+  0xff, 0x9f, 0xff, 0xff, 0xff, 0xff, 0xf9, 0xff,
+  0xff, 0x1f, 0xff, 0xff, 0xff, 0xff, 0xf8, 0xff,
+  0xff, 0x3f, 0xff, 0xff, 0xff, 0xff, 0xfc, 0xff,
+  0xff, 0x3f, 0xf0, 0x00, 0x00, 0xff, 0xfc, 0xff,
+  0xfe, 0x7f, 0xe0, 0x00, 0x00, 0x3f, 0xfc, 0x7f,
+  0xfe, 0x7f, 0xe0, 0x00, 0x00, 0x3f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xc0, 0x00, 0x00, 0xbf, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xc3, 0xff, 0xfe, 0xff, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xc3, 0xff, 0xff, 0xcf, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xc3, 0xff, 0xff, 0x83, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xc3, 0x00, 0x7f, 0x01, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xc3, 0xc0, 0xfe, 0x01, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xc3, 0xc0, 0x78, 0x63, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xc3, 0xff, 0xf0, 0xc3, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xc3, 0xff, 0xe1, 0x87, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xc3, 0x03, 0xc3, 0x0f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xc3, 0x03, 0x8e, 0x3f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xc3, 0xc3, 0x1c, 0x7f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xc3, 0xfc, 0x30, 0xff, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xc3, 0xf8, 0x60, 0xff, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xc3, 0xf0, 0xc2, 0x3f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xc3, 0xe1, 0x86, 0x3f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xc3, 0xe3, 0x0e, 0x3f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xc3, 0xc2, 0x3e, 0x3f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xc3, 0xc0, 0x60, 0x1f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xc3, 0xc0, 0xc0, 0x1f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xc3, 0xff, 0xc0, 0x1f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xc3, 0xff, 0xc0, 0x7f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xc3, 0xff, 0xc0, 0xff, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xc0, 0x00, 0x01, 0xff, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xc0, 0x00, 0x03, 0xff, 0xfe, 0x7f,
+  0xfe, 0x3f, 0xe0, 0x00, 0x07, 0xff, 0xfe, 0x7f,
+  0xff, 0x3f, 0xf8, 0x00, 0x0f, 0xff, 0xfc, 0xff,
+  0xff, 0x3f, 0xff, 0xff, 0xff, 0xff, 0xfc, 0xff,
+  0xff, 0x1f, 0xff, 0xff, 0xff, 0xff, 0xf8, 0xff,
+  0xff, 0x9f, 0xff, 0xff, 0xff, 0xff, 0xf9, 0xff,
+  0xff, 0xcf, 0xff, 0xff, 0xff, 0xff, 0xf1, 0xff,
+  0xff, 0xc7, 0xff, 0xff, 0xff, 0xff, 0xe3, 0xff,
+  0xff, 0xe3, 0xff, 0xff, 0xff, 0xff, 0xc7, 0xff,
+  0xff, 0xf0, 0xff, 0xff, 0xff, 0xff, 0x0f, 0xff,
+  0xff, 0xf8, 0x3f, 0xff, 0xff, 0xf8, 0x3f, 0xff,
+  0xff, 0xfe, 0x00, 0x00, 0x00, 0x00, 0x7f, 0xff,
+  0xff, 0xff, 0xc0, 0x00, 0x00, 0x03, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  /* ICON_TOUCH */
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xc0, 0x00, 0x00, 0x03, 0xff, 0xff,
+  0xff, 0xfe, 0x00, 0x00, 0x00, 0x00, 0x7f, 0xff,
+  0xff, 0xfc, 0x1f, 0xff, 0xff, 0xfc, 0x1f, 0xff,
+  0xff, 0xf0, 0xff, 0xff, 0xff, 0xff, 0x8f, 0xff,
+  0xff, 0xe3, 0xff, 0xff, 0xff, 0xff, 0xc7, 0xff,
+  0xff, 0xc7, 0xff, 0xff, 0xff, 0xff, 0xe3, 0xff,
+  0xff, 0x8f, 0xff, 0xff, 0xff, 0xff, 0xf3, 0xff,
+  0xff, 0x9f, 0xff, 0xff, 0xff, 0xff, 0xf9, 0xff,
+  0xff, 0x3f, 0xff, 0xff, 0xff, 0xff, 0xf8, 0xff,
+  0xff, 0x3f, 0xff, 0xff, 0xff, 0xff, 0xfc, 0xff,
+  0xff, 0x3f, 0xff, 0xff, 0xff, 0xff, 0xfc, 0xff,
+  0xfe, 0x7f, 0xff, 0xe0, 0x3f, 0xff, 0xfc, 0x7f,
+  0xfe, 0x7f, 0xff, 0x80, 0x0f, 0xff, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xff, 0x8f, 0x87, 0xff, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xff, 0x1d, 0xe7, 0xff, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xfe, 0x30, 0x63, 0xff, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xfe, 0x60, 0x33, 0xff, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xfe, 0x62, 0x33, 0xff, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xfe, 0x62, 0x33, 0xff, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xfe, 0x22, 0x23, 0xff, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xfe, 0x22, 0x23, 0xff, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xff, 0x02, 0x07, 0xff, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xff, 0x82, 0x07, 0xff, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xff, 0xc2, 0x01, 0xff, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xff, 0xe3, 0xe0, 0x7f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xff, 0xe3, 0xfc, 0x3f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xfc, 0x23, 0xff, 0x1f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xf8, 0x03, 0xff, 0x9f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xf8, 0x03, 0xff, 0x9f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xf9, 0xf3, 0xff, 0x9f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xf8, 0xff, 0xff, 0x9f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xf8, 0x3f, 0xff, 0x9f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xfe, 0x0f, 0xff, 0x9f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xff, 0x83, 0xff, 0x9f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xff, 0xe1, 0xff, 0x9f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xff, 0xf1, 0xff, 0x9f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xff, 0xf8, 0xff, 0x9f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xff, 0xfc, 0x00, 0x1f, 0xfe, 0x7f,
+  0xfe, 0x3f, 0xff, 0xfc, 0x00, 0x3f, 0xfe, 0x7f,
+  0xff, 0x3f, 0xff, 0xff, 0x00, 0x7f, 0xfc, 0xff,
+  0xff, 0x3f, 0xff, 0xff, 0xff, 0xff, 0xfc, 0xff,
+  0xff, 0x1f, 0xff, 0xff, 0xff, 0xff, 0xfc, 0xff,
+  0xff, 0x9f, 0xff, 0xff, 0xff, 0xff, 0xf9, 0xff,
+  0xff, 0xcf, 0xff, 0xff, 0xff, 0xff, 0xf1, 0xff,
+  0xff, 0xc7, 0xff, 0xff, 0xff, 0xff, 0xe3, 0xff,
+  0xff, 0xe3, 0xff, 0xff, 0xff, 0xff, 0xc7, 0xff,
+  0xff, 0xf1, 0xff, 0xff, 0xff, 0xff, 0x0f, 0xff,
+  0xff, 0xf8, 0x3f, 0xff, 0xff, 0xf8, 0x3f, 0xff,
+  0xff, 0xfe, 0x00, 0x00, 0x00, 0x00, 0x7f, 0xff,
+  0xff, 0xff, 0xc0, 0x00, 0x00, 0x03, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  /* ICON_WIFI */
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xc0, 0x00, 0x00, 0x03, 0xff, 0xff,
+  0xff, 0xfe, 0x00, 0x00, 0x00, 0x00, 0x7f, 0xff,
+  0xff, 0xfc, 0x1f, 0xff, 0xff, 0xfc, 0x1f, 0xff,
+  0xff, 0xf0, 0xff, 0xff, 0xff, 0xff, 0x8f, 0xff,
+  0xff, 0xe3, 0xff, 0xff, 0xff, 0xff, 0xc7, 0xff,
+  0xff, 0xc7, 0xff, 0xff, 0xff, 0xff, 0xe3, 0xff,
+  0xff, 0x8f, 0xff, 0xff, 0xff, 0xff, 0xf3, 0xff,
+  0xff, 0x9f, 0xff, 0xff, 0xff, 0xff, 0xf9, 0xff,
+  0xff, 0x3f, 0xff, 0xff, 0xff, 0xff, 0xf8, 0xff,
+  0xff, 0x3f, 0xff, 0xff, 0xff, 0xff, 0xfc, 0xff,
+  0xff, 0x3f, 0xff, 0xff, 0xff, 0xff, 0xfc, 0xff,
+  0xfe, 0x7f, 0xff, 0xff, 0xff, 0xff, 0xfc, 0x7f,
+  0xfe, 0x7f, 0xff, 0xff, 0xff, 0xff, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xff, 0xff, 0xff, 0xff, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xff, 0xfe, 0x7f, 0xff, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xff, 0x80, 0x03, 0xff, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xfe, 0x00, 0x00, 0x7f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xf8, 0x07, 0xf0, 0x1f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xe0, 0x7f, 0xfe, 0x07, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xc1, 0xff, 0xff, 0x83, 0xfe, 0x7f,
+  0xfe, 0x7f, 0x87, 0xff, 0xff, 0xe1, 0xfe, 0x7f,
+  0xfe, 0x7f, 0x8f, 0xe0, 0x0f, 0xf1, 0xfe, 0x7f,
+  0xfe, 0x7f, 0x9f, 0x80, 0x01, 0xfd, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xfe, 0x00, 0x00, 0xff, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xfc, 0x0f, 0xf8, 0x3f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xf8, 0x7f, 0xfe, 0x1f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xf8, 0xff, 0xff, 0x1f, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xfd, 0xfc, 0x7f, 0xdf, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xff, 0xe0, 0x0f, 0xff, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xff, 0xc0, 0x03, 0xff, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xff, 0x83, 0xe1, 0xff, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xff, 0x8f, 0xf1, 0xff, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xff, 0xff, 0xff, 0xff, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xff, 0xfc, 0x3f, 0xff, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xff, 0xf8, 0x1f, 0xff, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xff, 0xf8, 0x1f, 0xff, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xff, 0xf8, 0x1f, 0xff, 0xfe, 0x7f,
+  0xfe, 0x7f, 0xff, 0xf8, 0x3f, 0xff, 0xfe, 0x7f,
+  0xfe, 0x3f, 0xff, 0xfe, 0x7f, 0xff, 0xfe, 0x7f,
+  0xff, 0x3f, 0xff, 0xff, 0xff, 0xff, 0xfc, 0xff,
+  0xff, 0x3f, 0xff, 0xff, 0xff, 0xff, 0xfc, 0xff,
+  0xff, 0x1f, 0xff, 0xff, 0xff, 0xff, 0xfc, 0xff,
+  0xff, 0x9f, 0xff, 0xff, 0xff, 0xff, 0xf9, 0xff,
+  0xff, 0xcf, 0xff, 0xff, 0xff, 0xff, 0xf1, 0xff,
+  0xff, 0xc7, 0xff, 0xff, 0xff, 0xff, 0xe3, 0xff,
+  0xff, 0xe3, 0xff, 0xff, 0xff, 0xff, 0xc7, 0xff,
+  0xff, 0xf1, 0xff, 0xff, 0xff, 0xff, 0x0f, 0xff,
+  0xff, 0xf8, 0x3f, 0xff, 0xff, 0xf8, 0x3f, 0xff,
+  0xff, 0xfe, 0x00, 0x00, 0x00, 0x00, 0x7f, 0xff,
+  0xff, 0xff, 0xc0, 0x00, 0x00, 0x03, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+};
+
+const lv_img_dsc_t img_icon_atlas_1bpp = {
+  .header.cf = IMG_1BPP_CF,
+  .header.always_zero = 0,
+  .header.reserved = 0,
+  .header.w = 64,
+  .header.h = 640,
+  .data_size = 5120,
+  .data = img_icon_atlas_map,
+};
+
+const lv_img_dsc_t img_icons_1bpp[ICON_ATLAS_COUNT] = {
+  { .header.cf = IMG_1BPP_CF, .header.w = 64, .header.h = 64, .data_size = 512, .data = img_icon_atlas_map + 0 },  /* ICON_A7682E */
+  { .header.cf = IMG_1BPP_CF, .header.w = 64, .header.h = 64, .data_size = 512, .data = img_icon_atlas_map + 512 },  /* ICON_GPS */
+  { .header.cf = IMG_1BPP_CF, .header.w = 64, .header.h = 64, .data_size = 512, .data = img_icon_atlas_map + 1024 },  /* ICON_PCM5102 */
+  { .header.cf = IMG_1BPP_CF, .header.w = 64, .header.h = 64, .data_size = 512, .data = img_icon_atlas_map + 1536 },  /* ICON_SD */
+  { .header.cf = IMG_1BPP_CF, .header.w = 64, .header.h = 64, .data_size = 512, .data = img_icon_atlas_map + 2048 },  /* ICON_BATT */
+  { .header.cf = IMG_1BPP_CF, .header.w = 64, .header.h = 64, .data_size = 512, .data = img_icon_atlas_map + 2560 },  /* ICON_LORA */
+  { .header.cf = IMG_1BPP_CF, .header.w = 64, .header.h = 64, .data_size = 512, .data = img_icon_atlas_map + 3072 },  /* ICON_SETTING */
+  { .header.cf = IMG_1BPP_CF, .header.w = 64, .header.h = 64, .data_size = 512, .data = img_icon_atlas_map + 3584 },  /* ICON_TEST */
+  { .header.cf = IMG_1BPP_CF, .header.w = 64, .header.h = 64, .data_size = 512, .data = img_icon_atlas_map + 4096 },  /* ICON_TOUCH */
+  { .header.cf = IMG_1BPP_CF, .header.w = 64, .header.h = 64, .data_size = 512, .data = img_icon_atlas_map + 4608 },  /* ICON_WIFI */
+};
+
+static const uint8_t img_start_1bpp_map[] = {
+  0xff, 0xfc, 0x44, 0x44, 0x44, 0x44, 0x44, 0x44, 0x44, 0x44, 0x44, 0x44, 0x44, 0x46, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0xf0,
+  0xff, 0xf8, 0x88, 0x88, 0x88, 0x88, 0x88, 0x88, 0x88, 0x88, 0x88, 0x88, 0x88, 0x8c, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0xf0,
+  0xff, 0xf1, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x18, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xf0,
+  0xff, 0xe2, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x30, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x70,
+  0xff, 0xc4, 0x44, 0x44, 0x44, 0x44, 0x44, 0x44, 0x44, 0x44, 0x44, 0x44, 0x44, 0x60, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x30,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xc0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10,
+  0xf8, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10,
+  0xf3, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xe0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10,
+  0xe6, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x07, 0xf0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10,
+  0xcf, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0xf8, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10,
+  0x9f, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0c, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10,
+  0xbf, 0xfe, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0e, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10,
+  0x38, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1f, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10,
+  0x38, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x9f, 0x9f, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x87, 0x1f, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x80, 0x1f, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf9, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x80, 0x1f, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xe6, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xc0, 0x1f, 0xd0,
+  0x1f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf3, 0xf1, 0x8f, 0x0f, 0x1c, 0x0f, 0x80, 0xe1, 0x7f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf0, 0x7f, 0xd0,
+  0x2f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xe1, 0xf1, 0x8f, 0x0e, 0x18, 0x07, 0x00, 0x41, 0x7f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xfd, 0xff, 0xd0,
+  0x37, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xe1, 0xf1, 0x8f, 0x84, 0x30, 0x06, 0x1c, 0x21, 0x7f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x8f, 0x9f, 0xd0,
+  0x3b, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xe1, 0xf1, 0x8f, 0xc0, 0x61, 0xf6, 0x3e, 0x2e, 0x7f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x86, 0x1f, 0xd0,
+  0x3d, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xe1, 0xf1, 0x8f, 0xe0, 0xe3, 0xfe, 0x3e, 0x30, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x80, 0x1f, 0xd0,
+  0x1e, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xe1, 0xf1, 0x8f, 0xe1, 0xe3, 0x06, 0x3f, 0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x80, 0x1f, 0xd0,
+  0x0f, 0x7f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xe1, 0xf1, 0x8f, 0xf1, 0xe3, 0x02, 0x3e, 0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xc0, 0x3f, 0xd0,
+  0x07, 0xbf, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xe1, 0xf1, 0x8f, 0xf1, 0xe1, 0x02, 0x3e, 0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf0, 0x7f, 0xd0,
+  0x03, 0xdf, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xe1, 0xf1, 0x8f, 0xf1, 0xe1, 0xe2, 0x3e, 0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xbd, 0xff, 0xd0,
+  0x01, 0xef, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xe0, 0x11, 0x80, 0x71, 0xf0, 0x03, 0x0c, 0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x8f, 0x9f, 0xd0,
+  0x00, 0xf7, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xe0, 0x11, 0x80, 0x71, 0xf8, 0x07, 0x00, 0x7f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x82, 0x1f, 0xd0,
+  0x20, 0x7b, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf0, 0x33, 0xc0, 0xf3, 0xfc, 0x0f, 0xc1, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x80, 0x1f, 0xd0,
+  0x30, 0x3d, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x80, 0x1f, 0xd0,
+  0x38, 0x1e, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xe0, 0x3f, 0xd0,
+  0x3c, 0x0f, 0x7f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf0, 0xff, 0xd0,
+  0x3e, 0x07, 0xbf, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0x03, 0xdf, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0x81, 0xef, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xc0, 0xf7, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xe0, 0x7b, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xf0, 0x3d, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xf8, 0x1e, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xfc, 0x0e, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xfe, 0x06, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x80, 0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0x06, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x80, 0x01, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0x86, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x80, 0x00, 0x1f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xc6, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x80, 0x00, 0x03, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xc6, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x80, 0x00, 0x00, 0x00, 0x7f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xc6, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf0, 0x00, 0x7f, 0xe0, 0x00, 0x0f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xc6, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x00, 0x00, 0x7f, 0xff, 0x00, 0x03, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xc6, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf8, 0x00, 0x00, 0x7f, 0xff, 0xe0, 0x00, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xc6, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xc0, 0x00, 0x00, 0x7f, 0xff, 0xfc, 0x00, 0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xc6, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xfe, 0x00, 0x00, 0x7f, 0xff, 0xff, 0xff, 0x80, 0x1f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xc6, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf8, 0x00, 0x1f, 0xff, 0xff, 0xff, 0xff, 0xe0, 0x07, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xc6, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xe0, 0x00, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf8, 0x03, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xc6, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xc0, 0x07, 0xff, 0xff, 0xff, 0xff, 0xff, 0xfe, 0x00, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xc6, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x00, 0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x80, 0x7f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xc6, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xfc, 0x00, 0xff, 0xff, 0xf0, 0x03, 0xff, 0xff, 0xff, 0xc0, 0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xc6, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf8, 0x03, 0xff, 0xfc, 0x00, 0x00, 0x0f, 0xff, 0xff, 0xf0, 0x0f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xc6, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf0, 0x07, 0xff, 0xc0, 0x1f, 0xfe, 0x00, 0xff, 0xff, 0xf8, 0x07, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xc6, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xc0, 0x1f, 0xfe, 0x07, 0xff, 0xff, 0xf8, 0x1f, 0xff, 0xfc, 0x03, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xc6, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x80, 0x7f, 0xf0, 0x3f, 0xff, 0xff, 0xff, 0x03, 0xff, 0xff, 0x01, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xc6, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x00, 0xff, 0xc1, 0xff, 0xff, 0xff, 0xff, 0xe0, 0xff, 0xff, 0x80, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xc6, 0xff, 0xff, 0xff, 0xff, 0xff, 0xfe, 0x03, 0xff, 0x07, 0xff, 0xff, 0xff, 0xff, 0xf8, 0x3f, 0xff, 0xc0, 0x7f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xc6, 0xff, 0xff, 0xff, 0xff, 0xff, 0xcc, 0x07, 0xfc, 0x3f, 0xff, 0xff, 0xff, 0xff, 0xfe, 0x1f, 0xff, 0xe0, 0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xc6, 0xff, 0xff, 0xff, 0xff, 0xff, 0x80, 0x0f, 0xf8, 0x7f, 0xff, 0xff, 0xff, 0xff, 0xff, 0x87, 0xff, 0xf0, 0x1f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xc6, 0xff, 0xff, 0xff, 0xff, 0xff, 0x00, 0x1f, 0xe1, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xe1, 0xff, 0xf0, 0x0f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xc6, 0xff, 0xff, 0xff, 0xff, 0xfe, 0x00, 0x3f, 0xc7, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf8, 0xff, 0xf0, 0x07, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0x86, 0xff, 0xff, 0xff, 0xff, 0xfc, 0x00, 0x7f, 0x8f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xfc, 0x7f, 0xf8, 0x07, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0x06, 0xff, 0xff, 0xff, 0xff, 0xfc, 0x00, 0xfe, 0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x1f, 0xfc, 0x03, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0x0e, 0xff, 0xff, 0xff, 0xff, 0xf8, 0x01, 0xfc, 0x7f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x8f, 0xfe, 0x01, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0x1e, 0xff, 0xff, 0xff, 0xff, 0xf0, 0x03, 0xf8, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xc7, 0xff, 0x00, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0x3d, 0xff, 0xff, 0xff, 0xff, 0xe0, 0x07, 0xf1, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xe3, 0xff, 0x80, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0x7b, 0xff, 0xff, 0xff, 0xff, 0xe0, 0x0f, 0xe3, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf1, 0xff, 0x80, 0x7f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xf7, 0xff, 0xff, 0xff, 0xff, 0xc0, 0x1f, 0xc7, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf8, 0xff, 0xc0, 0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xef, 0xff, 0xff, 0xff, 0xff, 0x80, 0x1f, 0x8f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xfc, 0x7f, 0xe0, 0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xdf, 0xff, 0xff, 0xff, 0xff, 0x80, 0x3f, 0x9f, 0xff, 0xff, 0xff, 0xe7, 0x38, 0xff, 0xff, 0xff, 0xfe, 0x7f, 0xe0, 0x1f, 0xff, 0xfe, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xbf, 0xff, 0xff, 0xff, 0xff, 0x00, 0x7f, 0x3f, 0xff, 0xff, 0xff, 0xff, 0xfd, 0xef, 0xff, 0xff, 0xff, 0x3f, 0xf0, 0x1f, 0xff, 0xff, 0x7f, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0x7f, 0xff, 0xff, 0xff, 0xff, 0x00, 0x7e, 0x7f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xe7, 0xff, 0xff, 0xff, 0x9f, 0xf8, 0x0f, 0xff, 0xff, 0xbf, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xfe, 0x7f, 0xff, 0xff, 0xff, 0xfe, 0x00, 0xfc, 0x7f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xfe, 0x7f, 0xff, 0xff, 0xbf, 0xf8, 0x0f, 0xff, 0xff, 0xdf, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xfe, 0x7f, 0xff, 0xff, 0xff, 0xfe, 0x01, 0xfc, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xfe, 0x7f, 0xff, 0xff, 0xff, 0xfc, 0x07, 0xff, 0xff, 0xef, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xfe, 0x7f, 0xff, 0xff, 0xff, 0xfc, 0x01, 0xf9, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xfc, 0x07, 0xff, 0xff, 0xf7, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xfe, 0x7f, 0xff, 0xff, 0xff, 0xfc, 0x03, 0xf1, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf3, 0xff, 0xff, 0xff, 0xfe, 0x03, 0xff, 0xff, 0xfb, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xfe, 0x7f, 0xff, 0xff, 0xff, 0xf8, 0x03, 0xf3, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf3, 0xff, 0xff, 0xff, 0xfe, 0x03, 0xff, 0xff, 0xfd, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xfe, 0x7f, 0xff, 0xff, 0xff, 0xf8, 0x07, 0xe7, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x01, 0xff, 0xff, 0xfe, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xfe, 0x7f, 0xff, 0xff, 0xff, 0xf0, 0x07, 0xe7, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x7f, 0xff, 0xff, 0xff, 0x01, 0xff, 0xff, 0xff, 0x7f, 0xff, 0xff, 0xd0,
+  0x3f, 0xfe, 0x7f, 0xff, 0xff, 0xff, 0xf0, 0x0f, 0xcf, 0xff, 0xff, 0xff, 0xff, 0xff, 0x7f, 0xf7, 0xff, 0x3f, 0xff, 0xff, 0xff, 0x81, 0xff, 0xff, 0xff, 0xbf, 0xff, 0xff, 0xd0,
+  0x3f, 0xfe, 0x7f, 0xff, 0xff, 0xff, 0xf0, 0x0f, 0xcf, 0xff, 0xff, 0xff, 0xff, 0xc0, 0x01, 0xe7, 0xff, 0xff, 0xff, 0xff, 0xff, 0x80, 0xff, 0xff, 0xff, 0xdf, 0xff, 0xff, 0xd0,
+  0x3f, 0xfe, 0x7f, 0xff, 0xff, 0xff, 0xe0, 0x1f, 0x9f, 0xff, 0xff, 0xff, 0xfe, 0x00, 0x01, 0xcf, 0xff, 0xff, 0xff, 0xff, 0xff, 0xc0, 0xff, 0xff, 0xff, 0xef, 0xff, 0xff, 0xd0,
+  0x3f, 0xfe, 0x7f, 0xff, 0xff, 0xff, 0xe0, 0x1f, 0x9f, 0xff, 0xff, 0xff, 0xf8, 0x1f, 0xff, 0x8f, 0xff, 0xef, 0xff, 0xff, 0xff, 0xc0, 0xff, 0xff, 0xff, 0xf7, 0xff, 0xff, 0xd0,
+  0x3f, 0xfe, 0x7f, 0xff, 0xff, 0xff, 0xe0, 0x1f, 0x3f, 0xff, 0xff, 0xff, 0xf0, 0xff, 0xff, 0x1f, 0xff, 0xe7, 0xff, 0xff, 0xff, 0xc0, 0x7f, 0xff, 0xff, 0xfb, 0xff, 0xff, 0xd0,
+  0x3f, 0xfe, 0x7f, 0xff, 0xff, 0xff, 0xc0, 0x3f, 0x3f, 0xff, 0xff, 0xff, 0xc3, 0xe0, 0x06, 0x11, 0xff, 0xff, 0xff, 0xff, 0xff, 0xe0, 0x7f, 0xff, 0xff, 0xfd, 0xff, 0xff, 0xd0,
+  0x3f, 0xfe, 0x7f, 0xff, 0xff, 0xff, 0xc0, 0x3f, 0x3f, 0xff, 0xff, 0xff, 0x87, 0x80, 0x00, 0x38, 0xff, 0xff, 0xff, 0xff, 0xff, 0xe0, 0x7f, 0xff, 0xff, 0xfe, 0xff, 0xff, 0xd0,
+  0x3f, 0xfe, 0x7f, 0xff, 0xff, 0xff, 0xc0, 0x3e, 0x7f, 0xff, 0xe7, 0xff, 0x1e, 0x1f, 0xf8, 0x3c, 0x7f, 0xff, 0xff, 0xff, 0xff, 0xe0, 0x3f, 0xff, 0xff, 0xff, 0x7f, 0xff, 0xd0,
+  0x3f, 0xff, 0x7f, 0xff, 0xff, 0xff, 0xc0, 0x7e, 0x7f, 0xff, 0xe7, 0xfe, 0x38, 0x7f, 0xf0, 0x4e, 0x3f, 0xfd, 0xff, 0xff, 0xff, 0xe0, 0x3f, 0xff, 0xff, 0xff, 0xbf, 0xff, 0xd0,
+  0x3f, 0xff, 0x3f, 0xff, 0xff, 0xff, 0x80, 0x7e, 0x7f, 0xff, 0xff, 0xfe, 0x71, 0xff, 0xe0, 0xc7, 0x3f, 0xfd, 0xff, 0xff, 0xff, 0xf0, 0x3f, 0xff, 0xff, 0xff, 0xdf, 0xff, 0xd0,
+  0x3f, 0xff, 0x9f, 0xff, 0xff, 0xff, 0x80, 0x7e, 0xff, 0xff, 0xff, 0xfc, 0x63, 0xff, 0xc0, 0xe3, 0x1f, 0xff, 0xff, 0xff, 0xff, 0xf0, 0x3f, 0xff, 0xff, 0xff, 0xef, 0xff, 0xd0,
+  0x3f, 0xff, 0xcf, 0xff, 0xff, 0xff, 0x80, 0x7c, 0xff, 0xff, 0xff, 0xf8, 0xc7, 0xff, 0x81, 0xf1, 0x8f, 0xff, 0xff, 0xff, 0xff, 0xf0, 0x3f, 0xff, 0xff, 0xff, 0xef, 0xff, 0xd0,
+  0x3f, 0xff, 0xe7, 0xff, 0xff, 0xff, 0x80, 0x7c, 0xff, 0xff, 0x9f, 0xf9, 0xcf, 0xff, 0x01, 0xf9, 0xcf, 0xff, 0x7f, 0xff, 0xff, 0xf0, 0x1f, 0xff, 0xff, 0xff, 0xef, 0xff, 0xd0,
+  0x3f, 0xff, 0xf3, 0xff, 0xff, 0xff, 0x80, 0xfc, 0xff, 0xff, 0xbf, 0xf1, 0x9f, 0xfe, 0x03, 0xfc, 0xc7, 0xff, 0x7f, 0xff, 0xff, 0xf0, 0x1f, 0xff, 0xff, 0xff, 0xef, 0xff, 0xd0,
+  0x3f, 0xff, 0xf9, 0xff, 0xff, 0xff, 0x80, 0xfc, 0xff, 0xff, 0xff, 0xf3, 0x1f, 0xfc, 0x03, 0xfe, 0x67, 0xff, 0x7f, 0xff, 0xff, 0xf8, 0x1f, 0xff, 0xff, 0xff, 0xef, 0xff, 0xd0,
+  0x3f, 0xff, 0xfc, 0xff, 0xff, 0xff, 0x00, 0xf9, 0xff, 0xff, 0xff, 0xf3, 0x3f, 0xf8, 0x03, 0xfe, 0x67, 0xff, 0xff, 0xff, 0xff, 0xf8, 0x1f, 0xff, 0xff, 0xff, 0xef, 0xff, 0xd0,
+  0x3f, 0xff, 0xfe, 0x7f, 0xff, 0xff, 0x00, 0xf9, 0xff, 0xff, 0xff, 0xe7, 0x3f, 0xf0, 0x07, 0xff, 0x73, 0xff, 0xff, 0xff, 0xff, 0xf8, 0x1f, 0xff, 0xff, 0xff, 0xef, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0x3f, 0xff, 0xff, 0x00, 0xf9, 0xff, 0xff, 0x7f, 0xe6, 0x7f, 0xe0, 0x07, 0xff, 0x33, 0xff, 0xbf, 0xff, 0xff, 0xf8, 0x1f, 0xff, 0xff, 0xff, 0xef, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0x9f, 0xff, 0xff, 0x00, 0xf9, 0xff, 0xff, 0x7f, 0xe6, 0x7f, 0xc0, 0x0f, 0xff, 0x33, 0xff, 0xbf, 0xff, 0xff, 0xf8, 0x1f, 0xff, 0xff, 0xff, 0xef, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xcf, 0xff, 0xff, 0x00, 0xf9, 0xff, 0xff, 0xff, 0xc6, 0x7f, 0x80, 0x0f, 0xff, 0x31, 0xff, 0xbf, 0xff, 0xff, 0xf8, 0x1f, 0xff, 0xff, 0xff, 0xef, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xe7, 0xff, 0xff, 0x00, 0xf9, 0xff, 0xff, 0xff, 0xc6, 0xff, 0x00, 0x00, 0x07, 0x91, 0xff, 0xff, 0xff, 0xff, 0xf8, 0x1f, 0xff, 0xff, 0xff, 0xef, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xf3, 0xff, 0xff, 0x00, 0xf9, 0xff, 0xff, 0xff, 0xcc, 0xfe, 0x00, 0x00, 0x0f, 0x99, 0xff, 0xff, 0xff, 0xff, 0xf8, 0x1f, 0xff, 0xff, 0xff, 0xef, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xf9, 0xff, 0xff, 0x00, 0xf9, 0xff, 0xfe, 0x7f, 0xcc, 0xfc, 0x00, 0x00, 0x1f, 0x99, 0xff, 0xff, 0xff, 0xff, 0xf8, 0x1f, 0xff, 0xff, 0xff, 0xef, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xfc, 0xff, 0xfe, 0x01, 0xfb, 0xff, 0xfe, 0x7f, 0xcc, 0xf8, 0x00, 0x00, 0x3f, 0x99, 0xff, 0x9f, 0xff, 0xe7, 0xe0, 0x1f, 0xff, 0xff, 0xff, 0xef, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xfe, 0x7f, 0xfe, 0x07, 0xff, 0xff, 0xff, 0xff, 0xc4, 0xf0, 0x00, 0x00, 0x7f, 0x99, 0xff, 0x9f, 0xff, 0xe7, 0xc0, 0x3f, 0xff, 0xff, 0xff, 0xef, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0x3f, 0xfe, 0x07, 0xff, 0xff, 0xff, 0xff, 0xc6, 0xff, 0xfc, 0x00, 0xff, 0xb1, 0xff, 0xff, 0xff, 0xe7, 0xc0, 0x3f, 0xff, 0xff, 0xff, 0xcf, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0x9f, 0xfe, 0x07, 0xff, 0xff, 0xff, 0xff, 0xe6, 0x7f, 0xf8, 0x01, 0xff, 0x33, 0xff, 0xff, 0xff, 0xe7, 0xc0, 0x3f, 0xff, 0xff, 0xff, 0x9f, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xcf, 0xfe, 0x07, 0xff, 0xff, 0xff, 0x7f, 0xe6, 0x7f, 0xf8, 0x03, 0xff, 0x33, 0xff, 0xff, 0xff, 0xe7, 0xc0, 0x3f, 0xff, 0xff, 0xff, 0x3f, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xfe, 0x07, 0xff, 0xff, 0xff, 0x7f, 0xe6, 0x7f, 0xf0, 0x07, 0xff, 0x33, 0xff, 0xbf, 0xff, 0xe7, 0xc0, 0x3f, 0xff, 0xff, 0xfe, 0x7f, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xfe, 0x07, 0xff, 0xff, 0xff, 0xff, 0xe3, 0x3f, 0xf0, 0x0f, 0xfe, 0x63, 0xff, 0xbf, 0xff, 0xe7, 0xc0, 0x3f, 0xff, 0xff, 0xfc, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xfe, 0x07, 0xff, 0xff, 0xff, 0xff, 0xf3, 0x3f, 0xe0, 0x3f, 0xfe, 0x67, 0xff, 0xff, 0xff, 0xe7, 0xc0, 0x3f, 0xff, 0xff, 0xf9, 0xef, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xfe, 0x07, 0xff, 0xff, 0xff, 0xff, 0xf3, 0x9f, 0xc0, 0x7f, 0xfc, 0xe7, 0xff, 0xff, 0xff, 0xef, 0xc0, 0x3f, 0xff, 0xff, 0xf3, 0xcf, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xfe, 0x07, 0xff, 0xff, 0xff, 0xbf, 0xf1, 0x9f, 0xc0, 0xff, 0xfc, 0xc7, 0xff, 0xff, 0xff, 0xcf, 0xc0, 0x7f, 0xff, 0xff, 0xe7, 0x8f, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xfe, 0x03, 0xff, 0xff, 0xff, 0xbf, 0xf8, 0xcf, 0x81, 0xff, 0xf9, 0x8f, 0xfe, 0x7f, 0xff, 0xcf, 0xc0, 0x7f, 0xff, 0xff, 0xef, 0x0f, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xfe, 0x03, 0xff, 0xff, 0xff, 0xff, 0xfc, 0xe7, 0x83, 0xff, 0xf3, 0x9f, 0xfe, 0x7f, 0xff, 0xcf, 0x80, 0x7f, 0xff, 0xff, 0xee, 0x1f, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0x03, 0xff, 0xff, 0xff, 0xff, 0xfc, 0x73, 0x07, 0xff, 0xe7, 0x1f, 0xff, 0xff, 0xff, 0xcf, 0x80, 0x7f, 0xff, 0xff, 0xec, 0x1f, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0x03, 0xff, 0xff, 0xff, 0xff, 0xfe, 0x38, 0x0f, 0xff, 0x8e, 0x3f, 0xff, 0xff, 0xff, 0x9f, 0x80, 0x7f, 0xff, 0xff, 0xec, 0x3f, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0x03, 0xff, 0xff, 0xff, 0xef, 0xff, 0x1e, 0x1f, 0xfe, 0x1c, 0x7f, 0xff, 0xff, 0xff, 0x9f, 0x80, 0x7f, 0xff, 0xff, 0xec, 0x7f, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0x01, 0xff, 0xff, 0xff, 0xef, 0xff, 0x8c, 0x2f, 0xf8, 0x38, 0xff, 0xff, 0xff, 0xff, 0x9f, 0x00, 0xff, 0xff, 0xff, 0xec, 0x7f, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0x81, 0xff, 0xff, 0xff, 0xff, 0xff, 0xcc, 0x60, 0x01, 0xf1, 0xff, 0xff, 0xff, 0xff, 0xbf, 0x00, 0xff, 0xff, 0xff, 0xec, 0x7f, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0x81, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf8, 0xf8, 0x0f, 0xc3, 0xff, 0xff, 0xff, 0xff, 0x3f, 0x00, 0xff, 0xff, 0xff, 0xec, 0x7f, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0x80, 0xff, 0xff, 0xff, 0xfb, 0xff, 0xf1, 0xff, 0xff, 0x07, 0xff, 0xff, 0xff, 0xff, 0x3f, 0x01, 0xff, 0xff, 0xff, 0xec, 0x7f, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0x80, 0xff, 0xff, 0xff, 0xf9, 0xff, 0xf3, 0x07, 0xf0, 0x1f, 0xff, 0xff, 0xff, 0xfe, 0x7e, 0x01, 0xff, 0xff, 0xff, 0xec, 0x7f, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xc0, 0xff, 0xff, 0xff, 0xff, 0xff, 0xe7, 0x80, 0x00, 0x7f, 0xff, 0xff, 0xff, 0xfe, 0x7e, 0x01, 0xff, 0xff, 0xff, 0xec, 0x7f, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xc0, 0x7f, 0xff, 0xff, 0xff, 0xff, 0xef, 0xf0, 0x07, 0xff, 0xff, 0xff, 0xff, 0xfc, 0x7c, 0x01, 0xff, 0xff, 0xff, 0xec, 0x7f, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xc0, 0x7f, 0xff, 0xff, 0xff, 0xbf, 0xdf, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xfc, 0xfc, 0x03, 0xff, 0xff, 0xff, 0xec, 0x7f, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xe0, 0x7f, 0xff, 0xff, 0xff, 0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf8, 0xfc, 0x03, 0xff, 0xff, 0xff, 0xec, 0x7f, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xe0, 0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf9, 0xf8, 0x07, 0xff, 0xff, 0xff, 0xec, 0x7f, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf0, 0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf1, 0xf8, 0x07, 0xff, 0xff, 0xff, 0xec, 0x7f, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf0, 0x1f, 0xff, 0xff, 0xff, 0xf3, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf3, 0xf0, 0x07, 0xff, 0xff, 0xff, 0xec, 0x7f, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf0, 0x1f, 0xff, 0xff, 0xff, 0xfb, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xe7, 0xf0, 0x0f, 0xff, 0xff, 0xff, 0xec, 0x7f, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf8, 0x0f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xe7, 0xe0, 0x0f, 0xff, 0xff, 0xff, 0xec, 0x7f, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf8, 0x0f, 0xff, 0xff, 0xff, 0xff, 0x9f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xcf, 0xc0, 0x1f, 0xff, 0xff, 0xff, 0xec, 0x7f, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xfc, 0x07, 0xfe, 0x7f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x9f, 0xc0, 0x1f, 0xff, 0xff, 0xff, 0xec, 0x7f, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xfc, 0x07, 0xfe, 0x3f, 0xff, 0xff, 0xf8, 0xff, 0xff, 0xcf, 0xff, 0xff, 0xff, 0x1f, 0x80, 0x3f, 0xff, 0xff, 0xff, 0xec, 0x7f, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xfe, 0x03, 0xff, 0x3f, 0xff, 0xff, 0xff, 0xcf, 0xf9, 0xdf, 0xff, 0xff, 0xff, 0x3f, 0x80, 0x3f, 0xff, 0xff, 0xff, 0xec, 0x7f, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xfe, 0x01, 0xff, 0x9f, 0xff, 0xff, 0xff, 0xee, 0x39, 0xff, 0xff, 0xff, 0xfe, 0x7f, 0x00, 0x7f, 0xff, 0xff, 0xff, 0xec, 0x7f, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x01, 0xff, 0xcf, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xfc, 0xfe, 0x00, 0xff, 0xff, 0xff, 0xff, 0xec, 0x7f, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x80, 0xff, 0xe7, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf9, 0xfc, 0x00, 0xff, 0xff, 0xff, 0xff, 0xec, 0x7f, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x80, 0x7f, 0xf3, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf3, 0xfc, 0x01, 0xff, 0xff, 0xff, 0xff, 0xec, 0x3f, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xc0, 0x3f, 0xf9, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xe7, 0xf8, 0x03, 0xff, 0xff, 0xff, 0xff, 0xec, 0x1f, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xe0, 0x3f, 0xfc, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xcf, 0xf0, 0x03, 0xff, 0xff, 0xff, 0xff, 0xee, 0x0f, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xe0, 0x1f, 0xfe, 0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x1f, 0xe0, 0x07, 0xff, 0xff, 0xff, 0xff, 0xef, 0x07, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf0, 0x0f, 0xff, 0x1f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xfe, 0x3f, 0xc0, 0x0f, 0xff, 0xff, 0xff, 0xff, 0xe7, 0x83, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf8, 0x07, 0xff, 0x8f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xfc, 0x7f, 0x80, 0x1f, 0xff, 0xff, 0xff, 0xff, 0xf3, 0xc1, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xfc, 0x03, 0xff, 0xc3, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf0, 0xff, 0x00, 0x1f, 0xff, 0xff, 0xff, 0xff, 0xf9, 0xe0, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xfe, 0x03, 0xff, 0xf1, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xe3, 0xfe, 0x00, 0x3f, 0xff, 0xff, 0xff, 0xff, 0xfc, 0xf0, 0x7f, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xfe, 0x03, 0xff, 0xf8, 0x7f, 0xff, 0xff, 0xff, 0xff, 0xff, 0x87, 0xfc, 0x00, 0x7f, 0xff, 0xff, 0xff, 0xff, 0xfe, 0x78, 0x3f, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x01, 0xff, 0xfe, 0x1f, 0xff, 0xff, 0xff, 0xff, 0xfe, 0x1f, 0xf0, 0x0c, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x3c, 0x1f, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x80, 0xff, 0xff, 0x87, 0xff, 0xff, 0xff, 0xff, 0xf8, 0x7f, 0xe0, 0x1f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x9e, 0x0f, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xc0, 0x7f, 0xff, 0xe0, 0xff, 0xff, 0xff, 0xff, 0xc1, 0xff, 0xc0, 0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xcf, 0x07, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xe0, 0x1f, 0xff, 0xf8, 0x1f, 0xff, 0xff, 0xfe, 0x07, 0xff, 0x00, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xe7, 0x83, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf0, 0x0f, 0xff, 0xff, 0x01, 0xff, 0xff, 0xe0, 0x3f, 0xfe, 0x01, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf3, 0xc1, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xfc, 0x07, 0xff, 0xff, 0xe0, 0x00, 0x00, 0x01, 0xff, 0xf8, 0x03, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf9, 0xe0, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xfe, 0x01, 0xff, 0xff, 0xfe, 0x00, 0x00, 0x1f, 0xff, 0xe0, 0x0f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xfc, 0xf0, 0x50,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x00, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x80, 0x1f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xfe, 0x78, 0x10,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x80, 0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xfe, 0x00, 0x7f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x3c, 0x10,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xe0, 0x0f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf0, 0x00, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x9e, 0x10,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf0, 0x03, 0xff, 0xff, 0xff, 0xff, 0xff, 0x80, 0x03, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xcf, 0x10,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xfc, 0x00, 0xff, 0xff, 0xff, 0xff, 0xf8, 0x00, 0x0f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xe7, 0x90,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xfe, 0x00, 0x3f, 0xff, 0xff, 0xfc, 0x00, 0x00, 0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf3, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x80, 0x07, 0xff, 0xff, 0x80, 0x00, 0x01, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf9, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xe0, 0x00, 0xff, 0xff, 0x80, 0x00, 0x0f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xfc, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf8, 0x00, 0x0f, 0xff, 0x80, 0x00, 0x7f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xfe, 0x50,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xfe, 0x00, 0x00, 0x3f, 0x80, 0x07, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x10,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xc0, 0x00, 0x00, 0x07, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x90,
+  0x3f, 0xe3, 0xe7, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf8, 0x00, 0x00, 0x7f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xe1, 0x87, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x00, 0x00, 0x7f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xe0, 0x07, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf0, 0x00, 0x7f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xe0, 0x07, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xe0, 0x7f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xf0, 0x0f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xfc, 0x1f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xef, 0x7f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xe3, 0xe7, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xe0, 0x87, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xe0, 0x07, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xe0, 0x07, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xf8, 0x0f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xfc, 0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xef, 0xf7, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xe3, 0xe7, 0xff, 0xff, 0xff, 0xff, 0xff, 0xfe, 0x01, 0xfe, 0x03, 0xff, 0xff, 0xe7, 0xfe, 0x03, 0x80, 0xe0, 0x1f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xe0, 0x87, 0xff, 0xff, 0xff, 0xff, 0xff, 0xfe, 0x01, 0xfe, 0x01, 0xff, 0xff, 0xe7, 0xfe, 0x01, 0x80, 0x60, 0x1f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xe0, 0x07, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xcf, 0xfe, 0x78, 0xff, 0xff, 0xe7, 0xfe, 0x79, 0x9e, 0x67, 0x9f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xe0, 0x07, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xcf, 0xfe, 0x78, 0xc1, 0xc0, 0xe4, 0x7e, 0x79, 0x9e, 0x67, 0x9f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xf8, 0x0f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xcf, 0xfe, 0x78, 0x8c, 0xcc, 0x60, 0xfe, 0x71, 0x9c, 0x67, 0x9f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xfe, 0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xcf, 0x86, 0x78, 0x88, 0xcf, 0xe0, 0xfe, 0x01, 0x80, 0xe7, 0x9f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xcf, 0x86, 0x78, 0x80, 0xcf, 0xe0, 0xfe, 0x03, 0x98, 0xe7, 0x9f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xcf, 0xfe, 0x78, 0x8f, 0xcf, 0xe0, 0xfe, 0x7f, 0x9c, 0xe7, 0x9f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xcf, 0xfe, 0x01, 0x80, 0xc0, 0x64, 0x7e, 0x7f, 0x9c, 0x60, 0x1f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xcf, 0xfe, 0x03, 0xc0, 0xe0, 0x66, 0x3e, 0x7f, 0x9e, 0x60, 0x1f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xc0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xc0, 0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xfe, 0x07, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xdf, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xc0, 0x27, 0xff, 0xff, 0x7f, 0xff, 0xff, 0xff, 0xff, 0xfc, 0x03, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xfb, 0xcf, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xcf, 0xe7, 0xff, 0xff, 0x7f, 0xff, 0xff, 0xff, 0xff, 0xf9, 0xfb, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xe7, 0xfb, 0xcf, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xcf, 0xff, 0xff, 0xff, 0x7f, 0xff, 0xff, 0xff, 0xff, 0xf9, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xe7, 0xf3, 0xcf, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xcf, 0xe7, 0x46, 0x06, 0x1f, 0x9e, 0x70, 0x38, 0x1c, 0xf9, 0xff, 0x81, 0xc8, 0x38, 0x0f, 0x83, 0xc0, 0xc1, 0xe0, 0xc0, 0x78, 0x1f, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xc0, 0x67, 0x04, 0xfe, 0x7f, 0x9e, 0x67, 0xf3, 0xcc, 0xf9, 0xff, 0x1c, 0xc3, 0x18, 0xe7, 0x39, 0x8e, 0x67, 0xf3, 0xc7, 0x33, 0x8f, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xc0, 0x67, 0x3c, 0xfe, 0x7f, 0x9e, 0x67, 0xf3, 0xcf, 0xf9, 0xff, 0x3c, 0xc7, 0x99, 0xe6, 0x79, 0x9e, 0x67, 0xf3, 0xcf, 0x33, 0xcf, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xcf, 0xe7, 0x7c, 0x0e, 0x7f, 0x9e, 0x60, 0x70, 0x0f, 0xf9, 0xff, 0x3c, 0xcf, 0x99, 0xe6, 0x01, 0x9f, 0xe7, 0xf3, 0xcf, 0x30, 0x0f, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xcf, 0xe7, 0x7e, 0x06, 0x7f, 0x9e, 0x70, 0x30, 0x0f, 0xf9, 0xff, 0x3c, 0xcf, 0x99, 0xe6, 0x01, 0x9f, 0xe7, 0xf3, 0xcf, 0x30, 0x0f, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xcf, 0xe7, 0x7f, 0xf2, 0x7f, 0x9e, 0x7f, 0x33, 0xff, 0xf9, 0xff, 0x3c, 0xcf, 0x99, 0xe6, 0x7f, 0x9f, 0xe7, 0xf3, 0xcf, 0x33, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xcf, 0xe7, 0x7f, 0xf2, 0x7f, 0x9c, 0x7f, 0xb3, 0xfd, 0xf9, 0xf9, 0x3c, 0xcf, 0x99, 0xe6, 0x7f, 0x9f, 0xe7, 0xf3, 0xcf, 0x33, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xcf, 0xe7, 0x7c, 0x07, 0x1f, 0x80, 0x60, 0x38, 0x0c, 0xfc, 0x03, 0x80, 0xcf, 0x99, 0xe7, 0x01, 0xc0, 0x61, 0xf8, 0xcf, 0x38, 0x0f, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xdf, 0xf7, 0x7c, 0x0f, 0x9f, 0xc2, 0x60, 0x7c, 0x0d, 0xfe, 0x07, 0xc1, 0xef, 0x99, 0xf7, 0x81, 0xe0, 0x71, 0xfc, 0xdf, 0x3c, 0x0f, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0x7f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xe7, 0xef, 0x01, 0xc0, 0x7f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0x3f, 0xff, 0xfe, 0x7f, 0xff, 0xff, 0xef, 0xff, 0xff, 0xff, 0xe7, 0xe6, 0x01, 0xc0, 0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0x3f, 0xff, 0xfe, 0x7f, 0xff, 0xff, 0xef, 0xff, 0xff, 0xff, 0xe7, 0xe4, 0x7f, 0xcf, 0x1f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0x3f, 0xff, 0xff, 0x7f, 0xff, 0xff, 0xcf, 0xff, 0xff, 0xff, 0xe7, 0xe4, 0xff, 0xcf, 0x9f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xe1, 0x38, 0x39, 0xf2, 0x70, 0x3c, 0x1f, 0x83, 0x81, 0xfc, 0x0f, 0xe7, 0xe4, 0xff, 0xcf, 0x9f, 0x80, 0xf0, 0x33, 0xcf, 0x30, 0x78, 0x3f, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xcc, 0x33, 0x99, 0xe6, 0x63, 0x99, 0xcf, 0xcf, 0x38, 0xff, 0xc7, 0xe7, 0xe6, 0x03, 0xc0, 0x3f, 0x8e, 0x63, 0x93, 0xcf, 0x67, 0x38, 0x3f, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0x9e, 0x33, 0xc9, 0xe6, 0x67, 0x99, 0xe7, 0xcf, 0x3c, 0xff, 0xe7, 0xe7, 0xe7, 0x01, 0xc0, 0x3f, 0x9e, 0x67, 0x99, 0x86, 0x67, 0x99, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0x9f, 0x30, 0x0c, 0xe6, 0x67, 0xf8, 0x07, 0xcf, 0x3c, 0xfc, 0x07, 0xe7, 0xe7, 0xf8, 0xcf, 0x9f, 0x9e, 0x67, 0x99, 0x86, 0x60, 0x19, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0x9f, 0x30, 0x0c, 0xce, 0x67, 0xf8, 0x07, 0xcf, 0x3c, 0xf8, 0x07, 0xe7, 0xe7, 0xfc, 0xcf, 0x9f, 0x9e, 0x67, 0x99, 0xa6, 0xe0, 0x19, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0x9f, 0x33, 0xfe, 0x4e, 0x67, 0xf9, 0xff, 0xcf, 0x3c, 0xf9, 0xe7, 0xe7, 0xe7, 0xfc, 0xcf, 0x9f, 0x9e, 0x67, 0x9d, 0x34, 0xe7, 0xf9, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0x9e, 0x33, 0xfe, 0x5e, 0x67, 0xf9, 0xff, 0xcf, 0x3c, 0xf9, 0xc7, 0xe7, 0xe7, 0xfc, 0xcf, 0x9f, 0x8e, 0x67, 0x9c, 0x30, 0xe7, 0xf9, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xc0, 0x30, 0x1f, 0x1e, 0x70, 0x38, 0x0f, 0xe3, 0x01, 0xf8, 0x07, 0xe0, 0x0e, 0x01, 0xc0, 0x1f, 0x80, 0x70, 0x1c, 0x31, 0xe0, 0x39, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xe1, 0x38, 0x0f, 0x3e, 0x78, 0x1c, 0x0f, 0xf1, 0x83, 0xfc, 0x27, 0xf0, 0x1e, 0x03, 0xc0, 0x3f, 0x90, 0xf8, 0x3e, 0x79, 0xf0, 0x39, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x9f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x9f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x9f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf9, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf9, 0xff, 0xff, 0x3f, 0xff, 0xff, 0xff, 0xf9, 0xdf, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf9, 0xff, 0xff, 0x3f, 0xff, 0xff, 0xff, 0xff, 0xdf, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xc0, 0xf0, 0x79, 0xe6, 0x46, 0x0f, 0x03, 0xf0, 0x60, 0x7e, 0x0c, 0xf3, 0x22, 0x03, 0xf9, 0x87, 0xf0, 0x78, 0x0f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0x80, 0xe0, 0x39, 0xe6, 0x04, 0x06, 0x01, 0xf0, 0xc0, 0x3f, 0x1c, 0xf3, 0x02, 0x01, 0xf9, 0x87, 0xe0, 0x38, 0x07, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0x9f, 0xe7, 0x99, 0xe6, 0x3c, 0xe6, 0x79, 0xf9, 0xcf, 0x3f, 0x3c, 0xf3, 0x1e, 0x39, 0xf9, 0xdf, 0xe7, 0x99, 0xe7, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0x8f, 0xe7, 0x99, 0xe6, 0x7c, 0xfe, 0x79, 0xf9, 0xcf, 0x3f, 0x3c, 0xf3, 0x3e, 0x79, 0xf9, 0xdf, 0xe7, 0x99, 0xe7, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xc0, 0xe7, 0x99, 0xe6, 0x7c, 0xfe, 0x01, 0xf9, 0xcf, 0x3f, 0x3c, 0xf3, 0x3e, 0x79, 0xf9, 0xdf, 0xe7, 0x99, 0xe7, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xfe, 0x67, 0x99, 0xe6, 0x7c, 0xfe, 0x7f, 0xf9, 0xcf, 0x3f, 0x3c, 0xf3, 0x3e, 0x79, 0xf9, 0xdf, 0xe7, 0x99, 0xe7, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xfe, 0x67, 0x99, 0xc6, 0x7c, 0xfe, 0x7f, 0xf9, 0xcf, 0x3f, 0x3c, 0xe3, 0x3e, 0x79, 0xf9, 0xdf, 0xe7, 0x99, 0xe7, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xc0, 0x60, 0x38, 0x06, 0x7c, 0x06, 0x03, 0xf8, 0x40, 0x3f, 0x0c, 0x03, 0x3e, 0x79, 0xf9, 0xc7, 0xe0, 0x39, 0xe6, 0x7f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xc0, 0xf0, 0x7c, 0x06, 0x7e, 0x07, 0x01, 0xfc, 0x60, 0x7f, 0x8e, 0x13, 0x3e, 0x79, 0xf9, 0xe3, 0xf0, 0x79, 0xe6, 0x7f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xf8, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x7f, 0xd0,
+  0x3f, 0xfb, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x7f, 0xd0,
+  0x3f, 0xfb, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x7f, 0xd0,
+  0x3f, 0xfb, 0x0c, 0x21, 0x84, 0x30, 0x86, 0x10, 0xc2, 0x18, 0x43, 0x08, 0x61, 0x0c, 0x21, 0x84, 0x30, 0x86, 0x10, 0xc2, 0x08, 0x41, 0x0c, 0x21, 0x84, 0x30, 0x87, 0x7f, 0xd0,
+  0x3f, 0xfb, 0x0c, 0x21, 0x84, 0x30, 0x86, 0x10, 0xc2, 0x18, 0x43, 0x08, 0x61, 0x0c, 0x21, 0x84, 0x30, 0x86, 0x10, 0xc2, 0x08, 0x41, 0x0c, 0x21, 0x84, 0x30, 0x87, 0x7f, 0xd0,
+  0x3f, 0xfb, 0x0c, 0x21, 0x84, 0x30, 0x86, 0x10, 0xc2, 0x18, 0x43, 0x08, 0x61, 0x0c, 0x21, 0x84, 0x30, 0x86, 0x10, 0xc2, 0x08, 0x41, 0x0c, 0x21, 0x84, 0x30, 0x87, 0x7f, 0xd0,
+  0x3f, 0xfb, 0x0c, 0x21, 0x84, 0x30, 0x86, 0x10, 0xc2, 0x18, 0x43, 0x08, 0x61, 0x0c, 0x21, 0x84, 0x30, 0x86, 0x10, 0xc2, 0x08, 0x41, 0x0c, 0x21, 0x84, 0x30, 0x87, 0x7f, 0xd0,
+  0x3f, 0xfb, 0x8c, 0x71, 0x8e, 0x31, 0xc6, 0x38, 0xc7, 0x18, 0xe3, 0x1c, 0x63, 0x8c, 0x71, 0x8e, 0x31, 0xc6, 0x38, 0xc7, 0x18, 0x63, 0x8c, 0x71, 0x8e, 0x31, 0xc7, 0x7f, 0xd0,
+  0x3f, 0xfb, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x7f, 0xd0,
+  0x3f, 0xf8, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x7f, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xd0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xb0,
+  0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x70,
+  0xbf, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xfe, 0xf0,
+  0x9f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0xf0,
+  0xcf, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0xf0,
+  0xe7, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xfe, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0xff, 0xff, 0xf0,
+  0xf3, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xfc, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0xff, 0xff, 0xf0,
+  0xf8, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0xff, 0xff, 0xf0,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf0,
+};
+
+const lv_img_dsc_t img_start_1bpp = {
+  .header.cf = IMG_1BPP_CF,
+  .header.always_zero = 0,
+  .header.reserved = 0,
+  .header.w = 228,
+  .header.h = 307,
+  .data_size = 8903,
+  .data = img_start_1bpp_map,
+};
@@ -0,0 +1,348 @@
+/**
+ * @file      status_glance.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Clock, unread and battery strip redrawn from deep sleep timer wakes without booting
+ */
+
+#include "status_glance.h"
+#include <SPI.h>
+#include <GxEPD2_BW.h>
+#include <esp_attr.h>
+#include <esp_sleep.h>
+#include <sys/time.h>
+#include <time.h>
+#include "utilities.h"
+#include "spi_bus.h"
+#include "time_service.h"
+#include "lvgl_integration.h"
+#include "usb_console.h"
+#include "simple_logger.h"
+#ifdef INTEGRATION_LAYER_ENABLED
+#include "integration/config_manager.h"
+#endif
+
+#define GLANCE_TEXT_Y               5       // Top of the doubled glyphs
+#define GLANCE_SMALL_Y              12      // Small glyphs share their baseline
+#define GLANCE_TIME_X               2
+#define GLANCE_MAIL_X               78
+#define GLANCE_RIGHT                134
+
+// In RTC memory; the strip survives deep sleep with the panel image
+struct GlanceRecord {
+    uint32_t magic;
+    uint32_t period_s;              // 0: no strip captured, no timer armed
+    uint64_t next_at_us;
+    uint8_t shown[GLANCE_STRIDE * GLANCE_H];   // On the glass, LVGL row order, 1 = white
+    uint8_t unread;
+    uint8_t soc;
+    uint32_t glances;
+    uint32_t unchanged;
+    uint32_t awake_ms_last;
+    uint32_t awake_ms_max;
+    uint32_t refresh_ms_last;
+};
+
+RTC_NOINIT_ATTR static GlanceRecord rtc_glance;
+
+static bool glance_enabled = false;
+static uint32_t glance_period_s = GLANCE_PERIOD_S;
+
+static portMUX_TYPE unread_mux = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t unread_at[GLANCE_UNREAD_RING];     // millis(), 0 for an empty slot
+static uint8_t unread_head = 0;
+
+// ===== Font =====
+
+// 5x7, one byte per row, bit 4 leftmost
+enum {
+    GLYPH_COLON = 10,
+    GLYPH_PERCENT,
+    GLYPH_PLUS,
+    GLYPH_MINUS,
+    GLYPH_MAIL,
+    GLYPH_A,
+    GLYPH_M,
+    GLYPH_P,
+    GLYPH_COUNT,
+};
+
+static const uint8_t glyphs[GLYPH_COUNT][7] = {
+    {0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E},     // 0
+    {0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E},     // 1
+    {0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F},     // 2
+    {0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E},     // 3
+    {0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02},     // 4
+    {0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E},     // 5
+    {0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E},     // 6
+    {0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08},     // 7
+    {0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E},     // 8
+    {0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C},     // 9
+    {0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x0C, 0x00},     // :
+    {0x18, 0x19, 0x02, 0x04, 0x08, 0x13, 0x03},     // %
+    {0x00, 0x04, 0x04, 0x1F, 0x04, 0x04, 0x00},     // +
+    {0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00},     // -
+    {0x00, 0x1F, 0x1B, 0x15, 0x11, 0x1F, 0x00},     // Envelope
+    {0x00, 0x00, 0x0E, 0x01, 0x0F, 0x11, 0x0F},     // a
+    {0x00, 0x00, 0x1A, 0x15, 0x15, 0x11, 0x11},     // m
+    {0x00, 0x00, 0x1E, 0x11, 0x1E, 0x10, 0x10},     // p
+};
+
+static int glyph_index(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    switch (c) {
+        case ':': return GLYPH_COLON;
+        case '%': return GLYPH_PERCENT;
+        case '+': return GLYPH_PLUS;
+        case '-': return GLYPH_MINUS;
+        case 'a': return GLYPH_A;
+        case 'm': return GLYPH_M;
+        case 'p': return GLYPH_P;
+        default:  return -1;        // Space
+    }
+}
+
+static void put_glyph(uint8_t *strip, int x, int y, int glyph, int scale) {
+    for (int r = 0; r < 7 * scale; r++) {
+        uint8_t bits = glyphs[glyph][r / scale];
+        uint8_t *row = strip + (y + r) * GLANCE_STRIDE;
+        for (int c = 0; c < 5 * scale; c++) {
+            int px = x + c;
+            if ((bits & (0x10 >> (c / scale))) && px >= 0 && px < GLANCE_W) {
+                row[px >> 3] &= ~(0x80 >> (px & 7));
+            }
+        }
+    }
+}
+
+// Returns x after the text
+static int put_text(uint8_t *strip, int x, int y, const char *s, int scale) {
+    for (; *s; s++) {
+        int glyph = glyph_index(*s);
+        if (glyph >= 0) {
+            put_glyph(strip, x, y, glyph, scale);
+        }
+        x += 6 * scale;
+    }
+    return x;
+}
+
+// ===== Strip =====
+
+static uint64_t now_us() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (uint64_t)tv.tv_sec * 1000000ULL + tv.tv_usec;
+}
+
+// On the wall clock's boundaries when the period divides an hour, so the
+// minute turns over on the glass as it does on a watch
+static uint64_t next_due(uint64_t now, uint32_t period_s) {
+    uint64_t period_us = (uint64_t)period_s * 1000000ULL;
+    if (3600 % period_s == 0 && now / 1000000ULL >= TIME_VALID_S) {
+        return (now / period_us + 1) * period_us;
+    }
+    return now + period_us;
+}
+
+static void render(uint8_t *strip, uint8_t soc, bool charging) {
+    memset(strip, 0xFF, GLANCE_STRIDE * (GLANCE_H - 1));
+    // The taskbar's bottom edge stays as the UI drew it
+    memcpy(strip + (GLANCE_H - 1) * GLANCE_STRIDE, rtc_glance.shown + (GLANCE_H - 1) * GLANCE_STRIDE, GLANCE_STRIDE);
+
+    char text[8];
+    time_t now = time(NULL);
+    if (now >= TIME_VALID_S) {
+        // No zone is set, so this is UTC like the UI's clock
+        struct tm tm;
+        gmtime_r(&now, &tm);
+        int hour = tm.tm_hour % 12;
+        snprintf(text, sizeof(text), "%2d:%02d", hour ? hour : 12, tm.tm_min);
+        int x = put_text(strip, GLANCE_TIME_X, GLANCE_TEXT_Y, text, 2);
+        put_text(strip, x, GLANCE_SMALL_Y, tm.tm_hour < 12 ? "am" : "pm", 1);
+    } else {
+        put_text(strip, GLANCE_TIME_X, GLANCE_TEXT_Y, "--:--", 2);
+    }
+
+    if (rtc_glance.unread) {
+        put_glyph(strip, GLANCE_MAIL_X, GLANCE_TEXT_Y, GLYPH_MAIL, 2);
+        text[0] = '0' + min(rtc_glance.unread, (uint8_t)9);
+        text[1] = '\0';
+        put_text(strip, GLANCE_MAIL_X + 12, GLANCE_TEXT_Y, text, 2);
+    }
+
+    int len = snprintf(text, sizeof(text), "%u%c", soc, charging ? '+' : '%');
+    put_text(strip, GLANCE_RIGHT + 1 - (len * 6 - 1), GLANCE_SMALL_Y, text, 1);
+}
+
+// GxEPD2 calls this while BUSY is low; light sleep until the waveform ends
+static void busy_sleep_cb(const void *param) {
+    esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_ALL);
+    gpio_wakeup_enable((gpio_num_t)BOARD_EPD_BUSY, GPIO_INTR_HIGH_LEVEL);
+    esp_sleep_enable_gpio_wakeup();
+    esp_sleep_enable_timer_wakeup((uint64_t)GLANCE_BUSY_TIMEOUT_MS * 1000ULL);
+    esp_light_sleep_start();
+    gpio_wakeup_disable((gpio_num_t)BOARD_EPD_BUSY);
+}
+
+// Nothing else has touched the bus this boot. The other clients' selects
+// float through deep sleep, so they are driven high first
+static void push_strip(const uint8_t *strip) {
+    pinMode(BOARD_SD_CS, OUTPUT);
+    digitalWrite(BOARD_SD_CS, HIGH);
+    pinMode(BOARD_LORA_CS, OUTPUT);
+    digitalWrite(BOARD_LORA_CS, HIGH);
+    SPI.begin(BOARD_SPI_SCK, BOARD_SPI_MISO, BOARD_SPI_MOSI);
+
+    GxEPD2_310_GDEQ031T10 epd(BOARD_EPD_CS, BOARD_EPD_DC, BOARD_EPD_RST, BOARD_EPD_BUSY);
+    epd.selectSPI(SPI, spi_bus_settings(SPI_CLIENT_EPD));
+    // Not initial: no screen clear and no full refresh, the glass is known
+    epd.init(0, false);
+    epd.setBusyCallback(busy_sleep_cb);
+    epd.setUpdateClass(GxEPD2_310_GDEQ031T10::UPDATE_TEXT);
+
+    // Panel RAM is vertically flipped relative to LVGL (see LVGL_FB_MIRROR_Y)
+    int16_t y = LVGL_DISPLAY_HEIGHT - GLANCE_H;
+    epd.writeImageAgain(rtc_glance.shown, GLANCE_X, y, GLANCE_W, GLANCE_H, false, LVGL_FB_MIRROR_Y);
+    epd.writeImage(strip, GLANCE_X, y, GLANCE_W, GLANCE_H, false, LVGL_FB_MIRROR_Y);
+    uint32_t start = millis();
+    epd.refresh(GLANCE_X, y, GLANCE_W, GLANCE_H);
+    rtc_glance.refresh_ms_last = millis() - start;
+    epd.writeImageAgain(strip, GLANCE_X, y, GLANCE_W, GLANCE_H, false, LVGL_FB_MIRROR_Y);
+    epd.powerOff();
+}
+
+// ===== Console =====
+
+static void rpc_glance(Print &out, const char *args) {
+    if (args[0]) {
+        out.println("usage: glance");
+        return;
+    }
+    StatusGlanceStats s;
+    status_glance_get_stats(&s);
+    if (!glance_enabled) {
+        out.println("disabled");
+    } else {
+        out.printf("every %lu s while asleep%s, %u unread at the last sleep\n", (unsigned long)glance_period_s,
+                   s.armed ? " (armed)" : "", s.unread);
+    }
+    out.printf("%lu glances, %lu unchanged, awake %lu ms last (worst %lu), waveform %lu ms\n",
+               (unsigned long)s.glances, (unsigned long)s.unchanged, (unsigned long)s.awake_ms_last,
+               (unsigned long)s.awake_ms_max, (unsigned long)s.refresh_ms_last);
+}
+
+// ===== API =====
+
+bool status_glance_begin() {
+    if (rtc_glance.magic != GLANCE_MAGIC) {
+        memset(&rtc_glance, 0, sizeof(rtc_glance));
+        rtc_glance.magic = GLANCE_MAGIC;
+    }
+    // Awake, the UI owns the strip again until the next sleep captures it
+    rtc_glance.period_s = 0;
+
+#ifdef INTEGRATION_LAYER_ENABLED
+    if (!GET_CONFIG_BOOL("glance", "enabled", true)) {
+        LOG_INFO("Glance", "Sleep status strip disabled in config");
+        return false;
+    }
+    glance_period_s = max((int)GLANCE_PERIOD_MIN_S, GET_CONFIG_INT("glance", "period_s", GLANCE_PERIOD_S));
+#endif
+    glance_enabled = true;
+    usb_console_rpc("glance", rpc_glance);
+    LOG_INFOF("Glance", "Status strip every %lu s while asleep", (unsigned long)glance_period_s);
+    return true;
+}
+
+void status_glance_prepare() {
+    if (rtc_glance.magic != GLANCE_MAGIC) {
+        return;
+    }
+    rtc_glance.period_s = 0;
+    LVGLIntegration *lvgl = LVGL;
+    if (!glance_enabled || !lvgl || !lvgl->isInitialized() || lvgl->isBlanked() ||
+        lvgl->getRotation() != LV_DISP_ROT_NONE) {
+        return;
+    }
+    if (!lvgl->waitFlushIdle()) {
+        LOG_WARN("Glance", "Display still flushing, no status strip this sleep");
+        return;
+    }
+
+    const uint8_t *frame = lvgl->getPanelFrame();
+    for (int row = 0; row < GLANCE_H; row++) {
+        memcpy(rtc_glance.shown + row * GLANCE_STRIDE, frame + row * LVGL_FB_STRIDE + GLANCE_X / 8, GLANCE_STRIDE);
+    }
+
+    // Unread: came in after the last touch or key
+    uint32_t now = millis();
+    uint32_t idle = lv_disp_get_inactive_time(NULL);
+    uint8_t unread = 0;
+    portENTER_CRITICAL(&unread_mux);
+    for (int i = 0; i < GLANCE_UNREAD_RING; i++) {
+        if (unread_at[i] && now - unread_at[i] < idle) {
+            unread++;
+        }
+    }
+    portEXIT_CRITICAL(&unread_mux);
+    rtc_glance.unread = unread;
+
+    rtc_glance.next_at_us = next_due(now_us(), glance_period_s);
+    rtc_glance.period_s = glance_period_s;
+}
+
+uint64_t status_glance_due_us() {
+    return rtc_glance.magic == GLANCE_MAGIC && rtc_glance.period_s ? rtc_glance.next_at_us : 0;
+}
+
+bool status_glance_refresh(uint8_t soc, bool charging) {
+    if (!status_glance_due_us()) {
+        return false;
+    }
+    rtc_glance.next_at_us = next_due(now_us(), rtc_glance.period_s);
+
+    uint8_t strip[GLANCE_STRIDE * GLANCE_H];
+    render(strip, soc, charging);
+    rtc_glance.soc = soc;
+    if (memcmp(strip, rtc_glance.shown, sizeof(strip)) == 0) {
+        rtc_glance.unchanged++;
+    } else {
+        push_strip(strip);
+        memcpy(rtc_glance.shown, strip, sizeof(strip));
+        rtc_glance.glances++;
+    }
+
+    // From reset, which is as far back as the firmware can see
+    rtc_glance.awake_ms_last = millis();
+    rtc_glance.awake_ms_max = max(rtc_glance.awake_ms_max, rtc_glance.awake_ms_last);
+    return true;
+}
+
+void status_glance_note_message() {
+    uint32_t now = millis();
+    portENTER_CRITICAL(&unread_mux);
+    unread_at[unread_head] = now ? now : 1;
+    unread_head = (unread_head + 1) % GLANCE_UNREAD_RING;
+    portEXIT_CRITICAL(&unread_mux);
+}
+
+void status_glance_get_stats(StatusGlanceStats *out) {
+    memset(out, 0, sizeof(*out));
+    if (rtc_glance.magic != GLANCE_MAGIC) {
+        return;
+    }
+    out->armed = rtc_glance.period_s != 0;
+    out->period_s = glance_period_s;
+    out->glances = rtc_glance.glances;
+    out->unchanged = rtc_glance.unchanged;
+    out->awake_ms_last = rtc_glance.awake_ms_last;
+    out->awake_ms_max = rtc_glance.awake_ms_max;
+    out->refresh_ms_last = rtc_glance.refresh_ms_last;
+    out->unread = rtc_glance.unread;
+    out->soc = rtc_glance.soc;
+}
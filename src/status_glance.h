@@ -0,0 +1,97 @@
+/**
+ * @file      status_glance.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Clock, unread and battery strip redrawn from deep sleep timer wakes without booting
+ */
+
+#ifndef STATUS_GLANCE_H
+#define STATUS_GLANCE_H
+
+#include <Arduino.h>
+
+/**
+ * While the device sleeps, the right-hand part of the taskbar becomes a
+ * status strip: the time, an envelope with the count of messages that came
+ * in since the last input, and the battery charge. Every period_s (on the
+ * minute for the default 60) the RTC timer wakes the chip, and the early
+ * wake check in wake_monitor.cpp reads the gauge, draws the strip and
+ * sends it to the panel with one partial refresh. It then sleeps again.
+ * LVGL, the file systems, the radios and the rest of setup() never run.
+ *
+ * The strip is drawn with a built-in 5x7 font, doubled for the time, into
+ * a 17 x 25 byte bitmap. What the glass shows there lives in RTC memory:
+ * status_glance_prepare() copies it from the last frame LVGL sent when the
+ * device goes to sleep, and each glance keeps it current. The panel's
+ * previous-image RAM is loaded from it before the new strip goes out, so
+ * the differential waveform is right even if the controller lost power.
+ * Only the rows of the strip are clocked over SPI.
+ *
+ * While the panel runs its waveform the chip light-sleeps on the BUSY
+ * line. "glance" on the console gives the time each wake was awake for,
+ * from the first instruction of setup() to sleeping again.
+ *
+ * Not in landscape, and not while the display is blanked: the strip would
+ * land on the wrong part of the glass or wake a dark panel.
+ *
+ * Console: "glance" for the strip state and wake counters.
+ * Config section "glance": enabled (true), period_s (60).
+ */
+
+#define GLANCE_MAGIC                0x434E4C47UL  // "GLNC"
+#define GLANCE_PERIOD_S             60      // Aligned to the wall clock when it divides an hour
+#define GLANCE_PERIOD_MIN_S         10
+#define GLANCE_X                    104     // Right of the breadcrumb; a multiple of 8
+#define GLANCE_W                    136     // To the right edge
+#define GLANCE_H                    25      // UI_TASKBAR_HEIGHT
+#define GLANCE_STRIDE               (GLANCE_W / 8)
+#define GLANCE_UNREAD_RING          16      // Incoming message times kept
+#define GLANCE_BUSY_TIMEOUT_MS      2000    // Light sleep cap per BUSY wait
+
+struct StatusGlanceStats {
+    bool armed;                     // Strip captured for this sleep
+    uint32_t period_s;
+    uint32_t glances;               // Refreshes from timer wakes since the last cold boot
+    uint32_t unchanged;             // Timer wakes that found nothing new to draw
+    uint32_t awake_ms_last;         // setup() to deep sleep, last glance
+    uint32_t awake_ms_max;
+    uint32_t refresh_ms_last;       // Panel waveform, last glance
+    uint8_t unread;
+    uint8_t soc;                    // Last drawn
+};
+
+/**
+ * @brief Read the config and add the console command
+ */
+bool status_glance_begin();
+
+/**
+ * @brief Before deep sleep, ahead of wake_monitor_arm(): capture the strip
+ *        from the last frame sent and count the unread messages
+ */
+void status_glance_prepare();
+
+/**
+ * @brief When the next glance is due, gettimeofday() in us; 0 when none is armed
+ */
+uint64_t status_glance_due_us();
+
+/**
+ * @brief Draw the strip and refresh that part of the panel. From the early
+ *        wake check, before the rest of setup()
+ * @param soc      Gauge charge, 0-100
+ * @param charging Draws "+" in place of "%"
+ * @return false when no strip is armed or the panel write failed
+ */
+bool status_glance_refresh(uint8_t soc, bool charging);
+
+/**
+ * @brief An incoming message was stored; counted as unread until the next input
+ */
+void status_glance_note_message();
+
+void status_glance_get_stats(StatusGlanceStats *out);
+
+#endif // STATUS_GLANCE_H
@@ -0,0 +1,234 @@
+/**
+ * @file      task_arena.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Per-task bump arenas for scratch memory that lives for one frame or one message
+ */
+
+#include "task_arena.h"
+#include "simple_logger.h"
+#include <esp_heap_caps.h>
+
+struct TaskArena {
+    TaskHandle_t volatile task;     // nullptr for a free slot
+    uint8_t* base[ARENA_REGION_COUNT];
+    uint32_t size[ARENA_REGION_COUNT];
+    uint32_t used[ARENA_REGION_COUNT];
+    uint32_t high_water[ARENA_REGION_COUNT];
+    uint32_t allocs;
+    uint32_t overflows;
+    uint32_t resets;
+};
+
+static TaskArena arenas[TASK_ARENA_MAX];
+static portMUX_TYPE arena_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// Only the owner touches its slot after creation, so the lookup needs no lock
+static TaskArena* current_arena() {
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    for (int i = 0; i < TASK_ARENA_MAX; i++) {
+        if (arenas[i].task == self) {
+            return &arenas[i];
+        }
+    }
+    return nullptr;
+}
+
+static void note_used(TaskArena* a, int region) {
+    if (a->used[region] > a->high_water[region]) {
+        a->high_water[region] = a->used[region];
+    }
+}
+
+bool task_arena_create(size_t internal_size, size_t psram_size) {
+    if (current_arena()) {
+        return true;
+    }
+
+    internal_size = (internal_size + TASK_ARENA_ALIGN - 1) & ~(TASK_ARENA_ALIGN - 1);
+    psram_size = (psram_size + TASK_ARENA_ALIGN - 1) & ~(TASK_ARENA_ALIGN - 1);
+    uint8_t* internal = (uint8_t*)heap_caps_malloc(internal_size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    uint8_t* psram = NULL;
+    if (psram_size > 0) {
+        psram = (uint8_t*)heap_caps_malloc(psram_size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (!psram) {
+            psram = (uint8_t*)heap_caps_malloc(psram_size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        }
+    }
+    if (!internal || (psram_size > 0 && !psram)) {
+        LOG_ERRORF("Arena", "No memory for a %u + %u byte arena", (unsigned)internal_size, (unsigned)psram_size);
+        heap_caps_free(internal);
+        heap_caps_free(psram);
+        return false;
+    }
+
+    TaskArena* slot = NULL;
+    portENTER_CRITICAL(&arena_mux);
+    for (int i = 0; i < TASK_ARENA_MAX; i++) {
+        if (arenas[i].task == NULL) {
+            slot = &arenas[i];
+            memset(slot, 0, sizeof(*slot));
+            slot->base[ARENA_INTERNAL] = internal;
+            slot->size[ARENA_INTERNAL] = internal_size;
+            slot->base[ARENA_PSRAM] = psram;
+            slot->size[ARENA_PSRAM] = psram ? psram_size : 0;
+            slot->task = xTaskGetCurrentTaskHandle();
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&arena_mux);
+
+    if (!slot) {
+        LOG_ERROR("Arena", "Arena table full");
+        heap_caps_free(internal);
+        heap_caps_free(psram);
+        return false;
+    }
+    LOG_INFOF("Arena", "%s: %u B internal, %u B scratch", pcTaskGetName(NULL),
+              (unsigned)internal_size, (unsigned)psram_size);
+    return true;
+}
+
+void task_arena_destroy() {
+    TaskArena* a = current_arena();
+    if (!a) {
+        return;
+    }
+    heap_caps_free(a->base[ARENA_INTERNAL]);
+    heap_caps_free(a->base[ARENA_PSRAM]);
+
+    portENTER_CRITICAL(&arena_mux);
+    a->task = NULL;
+    portEXIT_CRITICAL(&arena_mux);
+}
+
+void* task_arena_alloc(size_t size, ArenaRegion region) {
+    TaskArena* a = current_arena();
+    if (!a) {
+        return nullptr;
+    }
+    if (region == ARENA_PSRAM && a->size[ARENA_PSRAM] == 0) {
+        region = ARENA_INTERNAL;
+    }
+
+    size = (size + TASK_ARENA_ALIGN - 1) & ~(TASK_ARENA_ALIGN - 1);
+    if (size > a->size[region] - a->used[region]) {
+        a->overflows++;
+        return nullptr;
+    }
+    void* p = a->base[region] + a->used[region];
+    a->used[region] += size;
+    a->allocs++;
+    note_used(a, region);
+    return p;
+}
+
+char* task_arena_vprintf(const char* format, va_list args) {
+    TaskArena* a = current_arena();
+    if (!a) {
+        return nullptr;
+    }
+
+    // Formatted straight into the free space, committed only if it fit
+    uint32_t room = a->size[ARENA_INTERNAL] - a->used[ARENA_INTERNAL];
+    char* p = (char*)a->base[ARENA_INTERNAL] + a->used[ARENA_INTERNAL];
+    int n = vsnprintf(p, room, format, args);
+    if (n < 0 || (uint32_t)n >= room) {
+        a->overflows++;
+        return nullptr;
+    }
+    a->used[ARENA_INTERNAL] += (n + 1 + TASK_ARENA_ALIGN - 1) & ~(TASK_ARENA_ALIGN - 1);
+    if (a->used[ARENA_INTERNAL] > a->size[ARENA_INTERNAL]) {
+        a->used[ARENA_INTERNAL] = a->size[ARENA_INTERNAL];
+    }
+    a->allocs++;
+    note_used(a, ARENA_INTERNAL);
+    return p;
+}
+
+char* task_arena_printf(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    char* p = task_arena_vprintf(format, args);
+    va_end(args);
+    return p;
+}
+
+task_arena_mark_t task_arena_mark() {
+    task_arena_mark_t mark = {};
+    TaskArena* a = current_arena();
+    if (a) {
+        mark.used[ARENA_INTERNAL] = a->used[ARENA_INTERNAL];
+        mark.used[ARENA_PSRAM] = a->used[ARENA_PSRAM];
+    }
+    return mark;
+}
+
+void task_arena_release(const task_arena_mark_t& mark) {
+    TaskArena* a = current_arena();
+    if (!a) {
+        return;
+    }
+    for (int r = 0; r < ARENA_REGION_COUNT; r++) {
+        if (mark.used[r] < a->used[r]) {
+            a->used[r] = mark.used[r];
+        }
+    }
+}
+
+void task_arena_reset() {
+    TaskArena* a = current_arena();
+    if (!a) {
+        return;
+    }
+    if (a->used[ARENA_INTERNAL] || a->used[ARENA_PSRAM]) {
+        a->used[ARENA_INTERNAL] = 0;
+        a->used[ARENA_PSRAM] = 0;
+        a->resets++;
+    }
+}
+
+int task_arena_count() {
+    int n = 0;
+    for (int i = 0; i < TASK_ARENA_MAX; i++) {
+        if (arenas[i].task) {
+            n++;
+        }
+    }
+    return n;
+}
+
+bool task_arena_get_stats(int index, task_arena_stats_t* stats) {
+    for (int i = 0; i < TASK_ARENA_MAX; i++) {
+        TaskHandle_t task = arenas[i].task;
+        if (!task || index-- > 0) {
+            continue;
+        }
+        const TaskArena* a = &arenas[i];
+        strncpy(stats->task, pcTaskGetName(task), sizeof(stats->task) - 1);
+        stats->task[sizeof(stats->task) - 1] = 0;
+        for (int r = 0; r < ARENA_REGION_COUNT; r++) {
+            stats->size[r] = a->size[r];
+            stats->used[r] = a->used[r];
+            stats->high_water[r] = a->high_water[r];
+        }
+        stats->allocs = a->allocs;
+        stats->overflows = a->overflows;
+        stats->resets = a->resets;
+        return true;
+    }
+    return false;
+}
+
+void task_arena_print(Print& out) {
+    out.printf("%-16s %13s %13s %8s %6s %8s\n", "task", "internal", "psram", "allocs", "full", "resets");
+    task_arena_stats_t s;
+    for (int i = 0; task_arena_get_stats(i, &s); i++) {
+        out.printf("%-16s %6lu/%-6lu %6lu/%-6lu %8lu %6lu %8lu\n", s.task,
+                   (unsigned long)s.high_water[ARENA_INTERNAL], (unsigned long)s.size[ARENA_INTERNAL],
+                   (unsigned long)s.high_water[ARENA_PSRAM], (unsigned long)s.size[ARENA_PSRAM],
+                   (unsigned long)s.allocs, (unsigned long)s.overflows, (unsigned long)s.resets);
+    }
+}
@@ -0,0 +1,98 @@
+/**
+ * @file      task_arena.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Per-task bump arenas for scratch memory that lives for one frame or one message
+ */
+
+#ifndef TASK_ARENA_H
+#define TASK_ARENA_H
+
+#include <Arduino.h>
+
+/**
+ * A task that owns an arena gets scratch memory by bumping a pointer, and
+ * gives all of it back at once with task_arena_reset() at the end of its
+ * cycle: the LVGL task after each lv_timer_handler() pass, an event worker
+ * after each delivery. Nothing is freed one block at a time, so formatted
+ * text and decode buffers never reach the general heap.
+ *
+ * Each arena has an internal-RAM region for small, hot buffers and a PSRAM
+ * region for large ones; without PSRAM the second region is internal too.
+ * Allocations are only valid until the owning task resets, and only that
+ * task may use them. A full region returns nullptr instead of falling back
+ * to malloc, so callers keep a small fixed fallback.
+ */
+
+#define TASK_ARENA_MAX              6       // Tasks with an arena
+#define TASK_ARENA_ALIGN            4
+
+// LVGL task: label text and other per-frame formatting
+#define TASK_ARENA_FRAME_INTERNAL   2048
+#define TASK_ARENA_FRAME_PSRAM      (16 * 1024)
+
+// Event workers: per-message decode and formatting
+#define TASK_ARENA_MESSAGE_INTERNAL 1024
+#define TASK_ARENA_MESSAGE_PSRAM    (4 * 1024)
+
+enum ArenaRegion {
+    ARENA_INTERNAL = 0,
+    ARENA_PSRAM,
+    ARENA_REGION_COUNT,
+};
+
+typedef struct {
+    uint32_t used[ARENA_REGION_COUNT];
+} task_arena_mark_t;
+
+typedef struct {
+    char task[configMAX_TASK_NAME_LEN];
+    uint32_t size[ARENA_REGION_COUNT];
+    uint32_t used[ARENA_REGION_COUNT];
+    uint32_t high_water[ARENA_REGION_COUNT];
+    uint32_t allocs;
+    uint32_t overflows;             // Requests that did not fit
+    uint32_t resets;
+} task_arena_stats_t;
+
+/**
+ * @brief Give the calling task an arena; true if it already has one
+ */
+bool task_arena_create(size_t internal_size, size_t psram_size);
+
+/**
+ * @brief Free the calling task's arena, before the task deletes itself
+ */
+void task_arena_destroy();
+
+/**
+ * @brief Scratch memory from the calling task's arena, nullptr if the task
+ *        has none or the region is full
+ */
+void* task_arena_alloc(size_t size, ArenaRegion region = ARENA_INTERNAL);
+
+/**
+ * @brief Format into the calling task's internal region
+ */
+char* task_arena_printf(const char* format, ...) __attribute__((format(printf, 1, 2)));
+char* task_arena_vprintf(const char* format, va_list args);
+
+/**
+ * @brief Nested scope inside a cycle: release() drops what was allocated
+ *        since mark()
+ */
+task_arena_mark_t task_arena_mark();
+void task_arena_release(const task_arena_mark_t& mark);
+
+/**
+ * @brief End of the calling task's frame or message: everything goes back
+ */
+void task_arena_reset();
+
+int task_arena_count();
+bool task_arena_get_stats(int index, task_arena_stats_t* stats);
+void task_arena_print(Print& out);
+
+#endif // TASK_ARENA_H
@@ -0,0 +1,275 @@
+/**
+ * @file      task_stack.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Task creation with stacks in PSRAM for tasks that declare they may have one
+ */
+
+#include "task_stack.h"
+#include <esp_heap_caps.h>
+#include <esp_flash.h>
+#include <soc/soc_memory_layout.h>
+#include "metrics.h"
+#include "timer_wheel.h"
+#include "usb_console.h"
+#include "simple_logger.h"
+#ifdef INTEGRATION_LAYER_ENABLED
+#include "integration/config_manager.h"
+#endif
+
+struct TaskStackSlot {
+    TaskHandle_t handle;            // NULL when free
+    StaticTask_t *tcb;              // Internal RAM
+    uint8_t *stack;                 // PSRAM
+    uint32_t size;
+    volatile bool exiting;          // Suspended itself in task_exit()
+};
+
+static portMUX_TYPE stack_mux = portMUX_INITIALIZER_UNLOCKED;
+static TaskStackSlot stack_slots[TASK_STACK_SLOTS];
+static TaskStackStats stack_stats;
+static bool stack_psram = true;
+static bool stack_running = false;
+static WheelTimer stack_reap_timer;
+static WheelTimer stack_report_timer;
+static volatile uint32_t stack_refused_reported = 0;
+
+static const esp_flash_os_functions_t *flash_os = NULL;
+static esp_flash_os_functions_t flash_os_guarded;
+
+// ===== Flash guard =====
+
+// Runs before the cache goes off; refusing here fails the operation cleanly
+static IRAM_ATTR esp_err_t guarded_start(void *arg) {
+    if (esp_ptr_external_ram(__builtin_frame_address(0))) {
+        portENTER_CRITICAL_SAFE(&stack_mux);
+        stack_stats.flash_refused++;
+        portEXIT_CRITICAL_SAFE(&stack_mux);
+        if (stack_running) {
+            timer_wheel_arm(&stack_report_timer, 1);
+        }
+        return ESP_ERR_INVALID_STATE;
+    }
+    return flash_os->start(arg);
+}
+
+// Logged from the wheel, away from the flash path that was refused
+static void report_refused(WheelTimer *timer) {
+    uint32_t refused = stack_stats.flash_refused;
+    if (refused == stack_refused_reported) {
+        return;
+    }
+    stack_refused_reported = refused;
+    LOG_ERRORF("TaskStack", "Flash access refused from a PSRAM stack (%lu so far); a task declared PSRAM_OK is not",
+               (unsigned long)refused);
+}
+
+// ===== Slots =====
+
+static void free_slot(TaskStackSlot *s) {
+    heap_caps_free(s->stack);
+    heap_caps_free(s->tcb);
+    portENTER_CRITICAL(&stack_mux);
+    stack_stats.psram_tasks--;
+    stack_stats.psram_bytes -= s->size;
+    stack_stats.exits++;
+    s->handle = NULL;
+    s->stack = NULL;
+    s->tcb = NULL;
+    s->exiting = false;
+    portEXIT_CRITICAL(&stack_mux);
+    metrics_gauge(METRIC_TASKS_PSRAM_STACK, stack_stats.psram_bytes);
+}
+
+// Deletes the tasks that suspended themselves in task_exit(). A task not
+// running is deleted at once, so its memory is free when vTaskDelete returns
+static void reap() {
+    bool waiting = false;
+    for (int i = 0; i < TASK_STACK_SLOTS; i++) {
+        TaskStackSlot *s = &stack_slots[i];
+        if (!s->exiting) {
+            continue;
+        }
+        if (!s->handle || eTaskGetState(s->handle) != eSuspended) {
+            waiting = true;         // Not quite there yet
+            continue;
+        }
+        vTaskDelete(s->handle);
+        free_slot(s);
+    }
+    if (waiting && stack_running) {
+        timer_wheel_arm(&stack_reap_timer, TASK_STACK_REAP_MS);
+    }
+}
+
+static void reap_timer(WheelTimer *timer) {
+    reap();
+}
+
+// By stack rather than handle: a task on the other core can exit before
+// task_spawn() has stored its handle
+static TaskStackSlot *slot_of(TaskHandle_t task) {
+    uint8_t *stack = (uint8_t *)pxTaskGetStackStart(task);
+    for (int i = 0; i < TASK_STACK_SLOTS; i++) {
+        if (stack_slots[i].tcb && stack_slots[i].stack == stack) {
+            return &stack_slots[i];
+        }
+    }
+    return NULL;
+}
+
+static BaseType_t spawn_psram(TaskFunction_t fn, const char *name, uint32_t stack_size, void *arg,
+                              UBaseType_t priority, TaskHandle_t *out, BaseType_t core) {
+    TaskStackSlot *s = NULL;
+    portENTER_CRITICAL(&stack_mux);
+    for (int i = 0; i < TASK_STACK_SLOTS; i++) {
+        if (!stack_slots[i].handle && !stack_slots[i].stack) {
+            s = &stack_slots[i];
+            s->stack = (uint8_t *)1;    // Taken while we allocate
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&stack_mux);
+    if (!s) {
+        return pdFAIL;
+    }
+    s->stack = (uint8_t *)heap_caps_malloc(stack_size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    s->tcb = (StaticTask_t *)heap_caps_malloc(sizeof(StaticTask_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    TaskHandle_t handle = NULL;
+    if (s->stack && s->tcb) {
+        s->size = stack_size;
+        s->exiting = false;
+        portENTER_CRITICAL(&stack_mux);
+        stack_stats.psram_tasks++;
+        stack_stats.psram_bytes += stack_size;
+        stack_stats.psram_peak = max(stack_stats.psram_peak, stack_stats.psram_bytes);
+        stack_stats.spawned++;
+        portEXIT_CRITICAL(&stack_mux);
+        handle = xTaskCreateStaticPinnedToCore(fn, name, stack_size, arg, priority, (StackType_t *)s->stack,
+                                               s->tcb, core);
+        s->handle = handle;
+    }
+    if (!handle) {
+        if (s->stack && s->tcb) {
+            portENTER_CRITICAL(&stack_mux);
+            stack_stats.psram_tasks--;
+            stack_stats.psram_bytes -= stack_size;
+            stack_stats.spawned--;
+            portEXIT_CRITICAL(&stack_mux);
+        }
+        heap_caps_free(s->stack);
+        heap_caps_free(s->tcb);
+        s->tcb = NULL;
+        s->stack = NULL;
+        return pdFAIL;
+    }
+    metrics_gauge(METRIC_TASKS_PSRAM_STACK, stack_stats.psram_bytes);
+    if (out) {
+        *out = handle;
+    }
+    return pdPASS;
+}
+
+// ===== Console =====
+
+static void rpc_stacks(Print &out, const char *args) {
+    TaskStackStats s;
+    task_stack_get_stats(&s);
+    out.printf("PSRAM stacks %s: %lu tasks, %lu bytes of internal RAM reclaimed (peak %lu)\n",
+               stack_psram ? "on" : "off", (unsigned long)s.psram_tasks, (unsigned long)s.psram_bytes,
+               (unsigned long)s.psram_peak);
+    out.printf("%lu spawned, %lu fell back to internal, %lu exited, %lu flash operations refused\n",
+               (unsigned long)s.spawned, (unsigned long)s.fallbacks, (unsigned long)s.exits,
+               (unsigned long)s.flash_refused);
+    TaskStackInfo list[TASK_STACK_SLOTS];
+    size_t n = task_stack_list(list, TASK_STACK_SLOTS);
+    for (size_t i = 0; i < n; i++) {
+        out.printf("  %-16s %6lu B, %6lu B never used\n", list[i].name, (unsigned long)list[i].size,
+                   (unsigned long)list[i].free_min);
+    }
+}
+
+// ===== API =====
+
+bool task_stack_begin() {
+    if (stack_running) {
+        return true;
+    }
+#ifdef INTEGRATION_LAYER_ENABLED
+    stack_psram = GET_CONFIG_BOOL("tasks", "psram_stacks", true);
+#endif
+    if (esp_flash_default_chip && esp_flash_default_chip->os_func && esp_flash_default_chip->os_func->start) {
+        flash_os = esp_flash_default_chip->os_func;
+        flash_os_guarded = *flash_os;
+        flash_os_guarded.start = guarded_start;
+        esp_flash_default_chip->os_func = &flash_os_guarded;
+    } else {
+        LOG_WARN("TaskStack", "No flash hook to guard; PSRAM stacks stay off");
+        stack_psram = false;
+    }
+    timer_wheel_init(&stack_reap_timer, "stack_reap", reap_timer);
+    timer_wheel_init(&stack_report_timer, "stack_guard", report_refused);
+    usb_console_rpc("stacks", rpc_stacks);
+    stack_running = true;
+    reap();
+    return true;
+}
+
+BaseType_t task_spawn(TaskFunction_t fn, const char *name, uint32_t stack_size, void *arg, UBaseType_t priority,
+                      TaskHandle_t *out, BaseType_t core, uint8_t policy) {
+    if (policy == TASK_STACK_PSRAM_OK && stack_psram && flash_os && priority <= TASK_STACK_PSRAM_PRIO_MAX &&
+        stack_size >= TASK_STACK_PSRAM_MIN) {
+        reap();
+        if (spawn_psram(fn, name, stack_size, arg, priority, out, core) == pdPASS) {
+            return pdPASS;
+        }
+        portENTER_CRITICAL(&stack_mux);
+        stack_stats.fallbacks++;
+        portEXIT_CRITICAL(&stack_mux);
+    }
+    return xTaskCreatePinnedToCore(fn, name, stack_size, arg, priority, out, core);
+}
+
+void task_exit() {
+    TaskStackSlot *s = slot_of(xTaskGetCurrentTaskHandle());
+    if (!s) {
+        vTaskDelete(NULL);
+    } else {
+        s->exiting = true;
+        if (stack_running) {
+            timer_wheel_arm(&stack_reap_timer, TASK_STACK_REAP_MS);
+        }
+        vTaskSuspend(NULL);
+    }
+    for (;;) {
+        // Never resumed
+    }
+}
+
+bool task_stack_in_psram(TaskHandle_t task) {
+    return esp_ptr_external_ram(pxTaskGetStackStart(task ? task : xTaskGetCurrentTaskHandle()));
+}
+
+void task_stack_get_stats(TaskStackStats *out) {
+    portENTER_CRITICAL(&stack_mux);
+    *out = stack_stats;
+    portEXIT_CRITICAL(&stack_mux);
+}
+
+size_t task_stack_list(TaskStackInfo *out, size_t max) {
+    size_t n = 0;
+    for (int i = 0; i < TASK_STACK_SLOTS && n < max; i++) {
+        TaskStackSlot *s = &stack_slots[i];
+        TaskHandle_t handle = s->handle;
+        if (!handle || s->exiting) {
+            continue;
+        }
+        strlcpy(out[n].name, pcTaskGetTaskName(handle), sizeof(out[n].name));
+        out[n].size = s->size;
+        out[n].free_min = uxTaskGetStackHighWaterMark(handle);
+        n++;
+    }
+    return n;
+}
@@ -0,0 +1,104 @@
+/**
+ * @file      task_stack.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Task creation with stacks in PSRAM for tasks that declare they may have one
+ */
+
+#ifndef TASK_STACK_H
+#define TASK_STACK_H
+
+#include <Arduino.h>
+
+/**
+ * task_spawn() is xTaskCreatePinnedToCore() with a placement policy. A
+ * task started with TASK_STACK_PSRAM_OK gets its stack from PSRAM and its
+ * TCB from internal RAM (xTaskCreateStaticPinnedToCore). That needs all
+ * of these: PSRAM free for the stack, a priority no higher than
+ * TASK_STACK_PSRAM_PRIO_MAX, a stack of at least TASK_STACK_PSRAM_MIN,
+ * and tasks.psram_stacks on. Otherwise the stack is internal as before.
+ *
+ * The policy is the caller's declaration that the task:
+ * - never touches the internal flash: LittleFS, NVS, the OTA API.
+ *   Reads count too: they all run with the cache off, and a PSRAM stack
+ *   is behind that cache. The SD card is on SPI and fine;
+ * - runs no ISR-side or IRAM-only code on its stack;
+ * - can stand the slower stack when PSRAM is contended.
+ *
+ * The flash guard backs the first point. task_stack_begin() wraps the
+ * default flash chip's start hook. A flash operation started from a task
+ * whose stack is in PSRAM is refused with ESP_ERR_INVALID_STATE, logged
+ * and counted, instead of faulting once the cache goes off.
+ *
+ * A task started this way ends with task_exit(), not vTaskDelete(NULL).
+ * It suspends itself and the timer wheel deletes it and frees the stack.
+ * The kernel never frees a static task's memory, and freeing it while
+ * the idle task still cleans up the TCB would be a use after free.
+ *
+ * The internal RAM reclaimed is the live total of PSRAM stacks; it goes
+ * to the tasks.psram_stack gauge.
+ *
+ * Console: "stacks" for the tasks placed and what was saved.
+ * Config section "tasks": psram_stacks (true).
+ */
+
+#define TASK_STACK_SLOTS            16
+#define TASK_STACK_PSRAM_PRIO_MAX   (tskIDLE_PRIORITY + 2)
+#define TASK_STACK_PSRAM_MIN        2048    // Smaller ones are not worth a slot
+#define TASK_STACK_REAP_MS          20
+
+enum TaskStackPolicy {
+    TASK_STACK_INTERNAL = 0,        // Flash access, ISR hand-offs or tight latency
+    TASK_STACK_PSRAM_OK,            // Declared clear of all three, see above
+};
+
+struct TaskStackStats {
+    uint32_t psram_tasks;           // Live
+    uint32_t psram_bytes;           // Live; internal RAM reclaimed
+    uint32_t psram_peak;
+    uint32_t spawned;               // With a PSRAM stack, ever
+    uint32_t fallbacks;             // Asked for PSRAM, got an internal stack
+    uint32_t exits;
+    uint32_t flash_refused;         // Flash operations stopped by the guard
+};
+
+struct TaskStackInfo {
+    char name[configMAX_TASK_NAME_LEN];
+    uint32_t size;
+    uint32_t free_min;              // Stack high-water mark, bytes
+};
+
+/**
+ * @brief Install the flash guard and read the config. Tasks may be
+ *        spawned before; the guard covers them from here on
+ */
+bool task_stack_begin();
+
+/**
+ * @brief xTaskCreatePinnedToCore() with a stack placed per policy
+ * @param policy TaskStackPolicy
+ * @return pdPASS or errCOULD_NOT_ALLOCATE_REQUIRED_MEMORY
+ */
+BaseType_t task_spawn(TaskFunction_t fn, const char *name, uint32_t stack_size, void *arg, UBaseType_t priority,
+                      TaskHandle_t *out, BaseType_t core = tskNO_AFFINITY, uint8_t policy = TASK_STACK_INTERNAL);
+
+/**
+ * @brief End the calling task. Needed by task_spawn() tasks, fine for any
+ */
+void task_exit() __attribute__((noreturn));
+
+/**
+ * @brief Whether the task's stack is in PSRAM; NULL for the calling task
+ */
+bool task_stack_in_psram(TaskHandle_t task = NULL);
+
+void task_stack_get_stats(TaskStackStats *out);
+
+/**
+ * @brief Live tasks with a PSRAM stack, at most max
+ */
+size_t task_stack_list(TaskStackInfo *out, size_t max);
+
+#endif // TASK_STACK_H
@@ -0,0 +1,337 @@
+/**
+ * @file      task_watch.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Task supervisor: heartbeat checks, ready-state sampling, stack scans, backtraces
+ */
+
+#include "task_watch.h"
+#include <esp_timer.h>
+#include <esp_debug_helpers.h>
+#include <freertos/task_snapshot.h>
+#include <freertos/xtensa_context.h>
+#include "simple_logger.h"
+#include "timer_wheel.h"
+#include "metrics.h"
+#include "crash_dump.h"
+#ifdef INTEGRATION_LAYER_ENABLED
+#include "integration/config_manager.h"
+#include "integration/event_bridge.h"
+#endif
+
+struct Watched {
+    char name[configMAX_TASK_NAME_LEN];
+    TaskHandle_t task;
+    uint32_t deadline_ms;
+    volatile uint32_t kick_ms;
+    volatile bool paused;
+    bool reported;                  // This overrun, until the next kick
+    uint32_t overruns;
+    uint32_t worst_ms;
+    volatile uint32_t ready_samples;
+    uint32_t ready_ms;
+    uint32_t ready_total_ms;
+    uint32_t stack_free;
+};
+
+struct StackSeen {
+    char name[configMAX_TASK_NAME_LEN];
+    uint32_t reported;              // Bytes left when last reported
+};
+
+static Watched watched[TASK_WATCH_MAX];
+static volatile int watched_count = 0;
+static StackSeen stack_seen[TASK_WATCH_STACK_TRACKED];
+static int stack_seen_count = 0;
+static portMUX_TYPE watch_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static WheelTimer check_timer;
+static esp_timer_handle_t sample_timer = NULL;
+static uint32_t last_stack_ms = 0;
+static uint32_t stack_low = TASK_WATCH_STACK_LOW;
+static bool backtraces = false;
+
+// ===== Heartbeats =====
+
+int task_watch_add(const char *name, uint32_t deadline_ms, TaskHandle_t task) {
+    portENTER_CRITICAL(&watch_mux);
+    int id = watched_count < TASK_WATCH_MAX ? watched_count : -1;
+    if (id >= 0) {
+        Watched *w = &watched[id];
+        memset(w, 0, sizeof(*w));
+        strlcpy(w->name, name, sizeof(w->name));
+        w->task = task ? task : xTaskGetCurrentTaskHandle();
+        w->deadline_ms = deadline_ms;
+        w->paused = true;
+        watched_count = id + 1;
+    }
+    portEXIT_CRITICAL(&watch_mux);
+    if (id < 0) {
+        LOG_WARNF("Watch", "Table full, %s not watched", name);
+    }
+    return id;
+}
+
+void task_watch_kick(int id) {
+    if (id < 0 || id >= watched_count) {
+        return;
+    }
+    Watched *w = &watched[id];
+    uint32_t now = millis();
+    if (!w->paused) {
+        uint32_t gap = now - w->kick_ms;
+        if (gap > w->worst_ms) {
+            w->worst_ms = gap;
+        }
+    }
+    w->kick_ms = now;
+    w->paused = false;
+    w->reported = false;
+}
+
+void task_watch_pause(int id) {
+    if (id < 0 || id >= watched_count) {
+        return;
+    }
+    Watched *w = &watched[id];
+    task_watch_kick(id);            // The work up to here still counts
+    w->paused = true;
+}
+
+// ===== Reports =====
+
+static void publish_alert(const char *task, TaskWatchAlert alert, uint32_t value) {
+    crash_trace(CRASH_TRACE_WATCH, ((uint32_t)alert << 24) | (value & 0xffffff));
+#ifdef INTEGRATION_LAYER_ENABLED
+    if (GlobalEventBridge) {
+        TaskWatchEvent ev = {};
+        strlcpy(ev.task, task, sizeof(ev.task));
+        ev.alert = alert;
+        ev.value = value;
+        GlobalEventBridge->publishTypedEvent(EventType::TASK_WATCH_ALERT, "Watch", ev, EventPriority::EVENT_HIGH);
+    }
+#endif
+}
+
+// Return address to the calling instruction, as addr2line wants it
+static inline uint32_t stack_pc(uint32_t pc) {
+    if (pc & 0x80000000) {
+        pc = (pc & 0x3fffffff) | 0x40000000;
+    }
+    return pc - 3;
+}
+
+// A blocked task's context sits at the top of its stack: a solicited frame
+// from a yield or an interrupt frame from a preemption
+static void log_backtrace(Watched *w) {
+    if (w->task == xTaskGetCurrentTaskHandleForCPU(0) || w->task == xTaskGetCurrentTaskHandleForCPU(1)) {
+        LOG_WARNF("Watch", "%s is running, no backtrace", w->name);
+        return;
+    }
+    TaskSnapshot_t snap = {};
+    vTaskGetSnapshot(w->task, &snap);
+    if (!snap.pxTopOfStack) {
+        return;
+    }
+    esp_backtrace_frame_t frame = {};
+    if (((XtExcFrame *)snap.pxTopOfStack)->exit) {
+        XtExcFrame *exc = (XtExcFrame *)snap.pxTopOfStack;
+        frame.pc = exc->pc;
+        frame.sp = exc->a1;
+        frame.next_pc = exc->a0;
+    } else {
+        XtSolFrame *sol = (XtSolFrame *)snap.pxTopOfStack;
+        frame.pc = sol->pc;
+        frame.sp = sol->a1;
+        frame.next_pc = sol->a0;
+    }
+
+    // On the console as the panel handler prints it, so the monitor decodes it
+    char line[16 + TASK_WATCH_BT_DEPTH * 22];
+    int pos = snprintf(line, sizeof(line), "Backtrace:");
+    int depth = 0;
+    do {
+        pos += snprintf(line + pos, sizeof(line) - pos, " 0x%08lx:0x%08lx",
+                        (unsigned long)stack_pc(frame.pc), (unsigned long)frame.sp);
+    } while (++depth < TASK_WATCH_BT_DEPTH && frame.next_pc && esp_backtrace_get_next_frame(&frame) &&
+             (size_t)pos < sizeof(line));
+    LOG_WARNF("Watch", "%s backtrace on the console", w->name);
+    Serial.println(line);
+}
+
+static void check_heartbeats(uint32_t now, uint32_t window_ms) {
+    for (int i = 0; i < watched_count; i++) {
+        Watched *w = &watched[i];
+
+        uint32_t samples = __atomic_exchange_n(&w->ready_samples, 0, __ATOMIC_RELAXED);
+        w->ready_ms = samples * TASK_WATCH_SAMPLE_MS;
+        w->ready_total_ms += w->ready_ms;
+        if (w->ready_ms > window_ms * TASK_WATCH_STARVE_PERCENT / 100) {
+            LOG_WARNF("Watch", "%s starved: ready but not running %lu of %lu ms", w->name,
+                      (unsigned long)w->ready_ms, (unsigned long)window_ms);
+            metrics_count(METRIC_TASKS_STARVED);
+            publish_alert(w->name, TASK_WATCH_STARVED, w->ready_ms);
+        }
+        if (w->ready_ms) {
+            metrics_observe(METRIC_TASKS_READY_MS, w->ready_ms);
+        }
+
+        if (w->paused || w->reported) {
+            continue;
+        }
+        uint32_t age = now - w->kick_ms;
+        if (age <= w->deadline_ms) {
+            continue;
+        }
+        w->reported = true;
+        w->overruns++;
+        uint32_t late = age - w->deadline_ms;
+        LOG_WARNF("Watch", "%s missed its %lu ms heartbeat by %lu ms", w->name, (unsigned long)w->deadline_ms,
+                  (unsigned long)late);
+        metrics_count(METRIC_TASKS_OVERRUNS);
+        metrics_observe(METRIC_TASKS_LATE_MS, late);
+        publish_alert(w->name, TASK_WATCH_OVERRUN, late);
+        if (backtraces) {
+            log_backtrace(w);
+        }
+    }
+}
+
+// Reported once per task, and again each time it gets worse
+static bool stack_worse(const char *name, uint32_t left) {
+    for (int i = 0; i < stack_seen_count; i++) {
+        if (strncmp(stack_seen[i].name, name, sizeof(stack_seen[i].name)) == 0) {
+            if (left + TASK_WATCH_STACK_WORSE > stack_seen[i].reported) {
+                return false;
+            }
+            stack_seen[i].reported = left;
+            return true;
+        }
+    }
+    if (stack_seen_count < TASK_WATCH_STACK_TRACKED) {
+        strlcpy(stack_seen[stack_seen_count].name, name, sizeof(stack_seen[0].name));
+        stack_seen[stack_seen_count].reported = left;
+        stack_seen_count++;
+    }
+    return true;
+}
+
+static void check_stacks() {
+    UBaseType_t n = uxTaskGetNumberOfTasks();
+    TaskStatus_t *status = (TaskStatus_t *)malloc(n * sizeof(TaskStatus_t));
+    if (!status) {
+        return;
+    }
+    n = uxTaskGetSystemState(status, n, NULL);
+    // High-water marks are in bytes here: the port's stack type is uint8_t
+    uint32_t min_free = UINT32_MAX;
+    for (UBaseType_t i = 0; i < n; i++) {
+        uint32_t left = status[i].usStackHighWaterMark;
+        min_free = left < min_free ? left : min_free;
+        for (int w = 0; w < watched_count; w++) {
+            if (watched[w].task == status[i].xHandle) {
+                watched[w].stack_free = left;
+            }
+        }
+        if (left < stack_low && stack_worse(status[i].pcTaskName, left)) {
+            LOG_WARNF("Watch", "%s stack: %lu bytes left at its deepest", status[i].pcTaskName, (unsigned long)left);
+            metrics_count(METRIC_TASKS_STACK_LOW);
+            publish_alert(status[i].pcTaskName, TASK_WATCH_STACK, left);
+        }
+    }
+    free(status);
+    if (min_free != UINT32_MAX) {
+        metrics_gauge(METRIC_TASKS_STACK_MIN, min_free);
+    }
+}
+
+static void check_tick(WheelTimer *timer) {
+    static uint32_t last_ms = 0;
+    uint32_t now = millis();
+    uint32_t window = last_ms ? now - last_ms : TASK_WATCH_CHECK_MS;
+    last_ms = now;
+    check_heartbeats(now, window);
+    if (now - last_stack_ms >= TASK_WATCH_STACK_MS) {
+        last_stack_ms = now;
+        check_stacks();
+    }
+}
+
+// Ready and on neither core: waiting for a higher-priority task
+static void sample_tick(void *arg) {
+    TaskHandle_t running0 = xTaskGetCurrentTaskHandleForCPU(0);
+    TaskHandle_t running1 = xTaskGetCurrentTaskHandleForCPU(1);
+    for (int i = 0; i < watched_count; i++) {
+        Watched *w = &watched[i];
+        if (w->task != running0 && w->task != running1 && eTaskGetState(w->task) == eReady) {
+            __atomic_fetch_add(&w->ready_samples, 1, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+// ===== API =====
+
+bool task_watch_begin() {
+    bool latency = false;
+#ifdef INTEGRATION_LAYER_ENABLED
+    if (!GET_CONFIG_BOOL("watch", "enabled", true)) {
+        return false;
+    }
+    latency = GET_CONFIG_BOOL("watch", "latency", false);
+    backtraces = GET_CONFIG_BOOL("watch", "backtrace", false);
+    stack_low = GET_CONFIG_INT("watch", "stack_low", TASK_WATCH_STACK_LOW);
+#endif
+    if (timer_wheel_armed(&check_timer)) {
+        return true;
+    }
+    if (latency) {
+        const esp_timer_create_args_t args = {
+            .callback = sample_tick,
+            .arg = NULL,
+            .dispatch_method = ESP_TIMER_TASK,
+            .name = "watch_sample",
+            .skip_unhandled_events = true,
+        };
+        if (esp_timer_create(&args, &sample_timer) != ESP_OK ||
+            esp_timer_start_periodic(sample_timer, TASK_WATCH_SAMPLE_MS * 1000) != ESP_OK) {
+            LOG_WARN("Watch", "No run-queue sampling");
+        }
+    }
+    timer_wheel_init(&check_timer, "watch", check_tick);
+    timer_wheel_arm(&check_timer, TASK_WATCH_CHECK_MS, TASK_WATCH_CHECK_MS);
+    last_stack_ms = millis() - TASK_WATCH_STACK_MS;     // First scan on the first check
+    LOG_INFOF("Watch", "Watching %d tasks%s", watched_count, latency ? ", sampling run-queue latency" : "");
+    return true;
+}
+
+size_t task_watch_stats(TaskWatchStats *out, size_t max) {
+    uint32_t now = millis();
+    size_t count = 0;
+    for (int i = 0; i < watched_count && count < max; i++, count++) {
+        const Watched *w = &watched[i];
+        TaskWatchStats *s = &out[count];
+        memcpy(s->name, w->name, sizeof(s->name));
+        s->deadline_ms = w->deadline_ms;
+        s->since_kick_ms = w->paused ? 0 : now - w->kick_ms;
+        s->overruns = w->overruns;
+        s->worst_ms = w->worst_ms;
+        s->ready_ms = w->ready_ms;
+        s->ready_total_ms = w->ready_total_ms;
+        s->stack_free = w->stack_free;
+    }
+    return count;
+}
+
+void task_watch_print(Print &out) {
+    TaskWatchStats stats[TASK_WATCH_MAX];
+    size_t n = task_watch_stats(stats, TASK_WATCH_MAX);
+    out.printf("%-16s %8s %8s %8s %8s %8s %6s\n", "task", "deadline", "since", "overrun", "worst", "ready", "stack");
+    for (size_t i = 0; i < n; i++) {
+        const TaskWatchStats *s = &stats[i];
+        out.printf("%-16s %8lu %8lu %8lu %8lu %8lu %6lu\n", s->name, (unsigned long)s->deadline_ms,
+                   (unsigned long)s->since_kick_ms, (unsigned long)s->overruns, (unsigned long)s->worst_ms,
+                   (unsigned long)s->ready_total_ms, (unsigned long)s->stack_free);
+    }
+}
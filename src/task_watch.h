@@ -0,0 +1,98 @@
+/**
+ * @file      task_watch.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Task supervisor: heartbeat deadlines, run-queue latency and stack high-water reports
+ */
+
+#ifndef TASK_WATCH_H
+#define TASK_WATCH_H
+
+#include <Arduino.h>
+
+/**
+ * A watched task kicks its heartbeat every time round its loop; if a kick
+ * is later than the task's deadline the supervisor reports an overrun
+ * while the task is still stuck, so a loop caught behind a slow panel
+ * refresh or a blocking scan shows up with its name. A task that sleeps
+ * until it has work pauses its heartbeat before it blocks and kicks when
+ * it wakes, so only time spent working counts.
+ *
+ * With watch.latency on, a sampler looks at every watched task each
+ * TASK_WATCH_SAMPLE_MS and counts the samples where it was ready but
+ * neither core was running it; that estimates its run-queue latency,
+ * the time lost to higher-priority work. It keeps the chip awake, so it
+ * is off by default. A task that spends over TASK_WATCH_STARVE_PERCENT
+ * of a check window ready is reported as starved.
+ *
+ * Every TASK_WATCH_STACK_MS all tasks, not only watched ones, are checked
+ * against the stack low-water mark, and each one closer to overflow than
+ * watch.stack_low bytes is reported once, and again if it gets worse.
+ *
+ * Reports go to the log, the metrics registry and the EventBridge as
+ * TASK_WATCH_ALERT. With watch.backtrace, an overrun also prints the stuck
+ * task's backtrace on the console, in the panel handler's format, when it
+ * is blocked rather than running.
+ */
+
+#define TASK_WATCH_MAX              16
+#define TASK_WATCH_CHECK_MS         1000
+#define TASK_WATCH_SAMPLE_MS        5
+#define TASK_WATCH_STARVE_PERCENT   50
+#define TASK_WATCH_STACK_MS         30000
+#define TASK_WATCH_STACK_LOW        512     // Bytes left
+#define TASK_WATCH_STACK_WORSE      128     // Drop that reports a task again
+#define TASK_WATCH_STACK_TRACKED    24
+#define TASK_WATCH_BT_DEPTH         16
+
+enum TaskWatchAlert {
+    TASK_WATCH_OVERRUN = 0,         // value: ms past the deadline
+    TASK_WATCH_STARVED,             // value: ms ready in the last window
+    TASK_WATCH_STACK,               // value: bytes left at the high-water mark
+};
+
+// EventBridge payload for TASK_WATCH_ALERT
+struct TaskWatchEvent {
+    char task[configMAX_TASK_NAME_LEN];
+    uint8_t alert;                  // TaskWatchAlert
+    uint32_t value;
+};
+
+struct TaskWatchStats {
+    char name[configMAX_TASK_NAME_LEN];
+    uint32_t deadline_ms;
+    uint32_t since_kick_ms;         // 0 while paused
+    uint32_t overruns;
+    uint32_t worst_ms;              // Longest time between kicks
+    uint32_t ready_ms;              // Estimated run-queue time, last window
+    uint32_t ready_total_ms;
+    uint32_t stack_free;            // Bytes at the high-water mark
+};
+
+/**
+ * @brief Start the checks. Reads watch.enabled, latency, backtrace, stack_low
+ */
+bool task_watch_begin();
+
+/**
+ * @brief Watch a task, the calling one if task is NULL. The heartbeat starts paused
+ * @return Id for the kicks, -1 when the table is full
+ */
+int task_watch_add(const char *name, uint32_t deadline_ms, TaskHandle_t task = NULL);
+
+/**
+ * @brief Heartbeat; cheap enough for every loop pass. Ignores -1
+ */
+void task_watch_kick(int id);
+
+/**
+ * @brief No deadline until the next kick, for a task about to wait for work
+ */
+void task_watch_pause(int id);
+
+size_t task_watch_stats(TaskWatchStats *out, size_t max);
+void task_watch_print(Print &out);
+
+#endif // TASK_WATCH_H
@@ -0,0 +1,252 @@
+/**
+ * @file      telemetry_codec.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     CBOR writer and schema encoding
+ */
+
+#include "telemetry_codec.h"
+#include "placement.h"
+#include <math.h>
+
+// CBOR major types
+#define CBOR_UINT       0x00
+#define CBOR_NINT       0x20
+#define CBOR_BYTES      0x40
+#define CBOR_TEXT       0x60
+#define CBOR_ARRAY      0x80
+#define CBOR_MAP        0xA0
+#define CBOR_FALSE      0xF4
+#define CBOR_TRUE       0xF5
+#define CBOR_HALF       0xF9
+#define CBOR_SINGLE     0xFA
+
+static const int32_t PLACE_HOT_DATA pow10_table[] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000};
+
+void cbor_init(CborWriter *w, uint8_t *buf, size_t max) {
+    w->buf = buf;
+    w->max = max;
+    w->len = 0;
+    w->overflow = false;
+}
+
+static uint8_t *reserve(CborWriter *w, size_t n) {
+    if (w->overflow || w->len + n > w->max) {
+        w->overflow = true;
+        return NULL;
+    }
+    uint8_t *p = w->buf + w->len;
+    w->len += n;
+    return p;
+}
+
+// Major type with its argument in the shortest form, big-endian
+static void put_head(CborWriter *w, uint8_t major, uint64_t v) {
+    size_t extra = v < 24 ? 0 : v <= 0xFF ? 1 : v <= 0xFFFF ? 2 : v <= 0xFFFFFFFF ? 4 : 8;
+    uint8_t *p = reserve(w, 1 + extra);
+    if (!p) {
+        return;
+    }
+    if (extra == 0) {
+        *p = major | (uint8_t)v;
+        return;
+    }
+    *p++ = major | (extra == 1 ? 24 : extra == 2 ? 25 : extra == 4 ? 26 : 27);
+    for (int i = extra - 1; i >= 0; i--) {
+        *p++ = (uint8_t)(v >> (8 * i));
+    }
+}
+
+void cbor_uint(CborWriter *w, uint64_t v) {
+    put_head(w, CBOR_UINT, v);
+}
+
+void cbor_int(CborWriter *w, int64_t v) {
+    if (v >= 0) {
+        put_head(w, CBOR_UINT, (uint64_t)v);
+    } else {
+        put_head(w, CBOR_NINT, (uint64_t)(-1 - v));
+    }
+}
+
+void cbor_bool(CborWriter *w, bool v) {
+    uint8_t *p = reserve(w, 1);
+    if (p) {
+        *p = v ? CBOR_TRUE : CBOR_FALSE;
+    }
+}
+
+// Exact half-precision bits for v, or -1 when it would lose precision
+static int32_t to_half(float v) {
+    uint32_t f;
+    memcpy(&f, &v, 4);
+    uint32_t sign = (f >> 16) & 0x8000;
+    int32_t exp = ((f >> 23) & 0xFF) - 127 + 15;
+    uint32_t mant = f & 0x7FFFFF;
+    if (v == 0.0f) {
+        return sign;
+    }
+    if (exp <= 0 || exp >= 31 || (mant & 0x1FFF)) {
+        return -1;                  // Subnormal, out of range or more than 10 mantissa bits
+    }
+    return sign | (exp << 10) | (mant >> 13);
+}
+
+void cbor_float(CborWriter *w, float v) {
+    int32_t half = to_half(v);
+    if (half >= 0) {
+        uint8_t *p = reserve(w, 3);
+        if (p) {
+            p[0] = CBOR_HALF;
+            p[1] = half >> 8;
+            p[2] = half & 0xFF;
+        }
+        return;
+    }
+    uint32_t f;
+    memcpy(&f, &v, 4);
+    uint8_t *p = reserve(w, 5);
+    if (p) {
+        p[0] = CBOR_SINGLE;
+        p[1] = f >> 24;
+        p[2] = f >> 16;
+        p[3] = f >> 8;
+        p[4] = f;
+    }
+}
+
+void cbor_text(CborWriter *w, const char *s, size_t len) {
+    put_head(w, CBOR_TEXT, len);
+    uint8_t *p = reserve(w, len);
+    if (p) {
+        memcpy(p, s, len);
+    }
+}
+
+void cbor_bytes(CborWriter *w, const uint8_t *data, size_t len) {
+    put_head(w, CBOR_BYTES, len);
+    uint8_t *p = reserve(w, len);
+    if (p) {
+        memcpy(p, data, len);
+    }
+}
+
+void cbor_array(CborWriter *w, size_t count) {
+    put_head(w, CBOR_ARRAY, count);
+}
+
+void cbor_map(CborWriter *w, size_t pairs) {
+    put_head(w, CBOR_MAP, pairs);
+}
+
+// Every field as a signed integer, floats fixed-point
+static int64_t field_value(const TelemetryField *f, const void *sample) {
+    const uint8_t *p = (const uint8_t *)sample + f->offset;
+    switch (f->type) {
+        case TLM_BOOL:  return *(const bool *)p ? 1 : 0;
+        case TLM_U8:    return *(const uint8_t *)p;
+        case TLM_U16:   { uint16_t v; memcpy(&v, p, 2); return v; }
+        case TLM_U32:   { uint32_t v; memcpy(&v, p, 4); return v; }
+        case TLM_I8:    return *(const int8_t *)p;
+        case TLM_I16:   { int16_t v; memcpy(&v, p, 2); return v; }
+        case TLM_I32:   { int32_t v; memcpy(&v, p, 4); return v; }
+        case TLM_FLOAT: {
+            float v;
+            memcpy(&v, p, 4);
+            return isfinite(v) ? llroundf(v * pow10_table[f->decimals & 7]) : 0;
+        }
+        case TLM_DOUBLE: {
+            double v;
+            memcpy(&v, p, 8);
+            return isfinite(v) ? llround(v * pow10_table[f->decimals & 7]) : 0;
+        }
+        default:        return 0;
+    }
+}
+
+static size_t encode_cbor(const TelemetrySchema *schema, const void *sample, uint8_t *buf, size_t max) {
+    int64_t values[TELEMETRY_FIELD_MAX];
+    size_t present = 0;
+    for (uint8_t i = 0; i < schema->count; i++) {
+        values[i] = field_value(&schema->fields[i], sample);
+        present += values[i] != 0;
+    }
+    
+    CborWriter w;
+    cbor_init(&w, buf, max);
+    cbor_map(&w, present + 1);
+    cbor_uint(&w, 0);
+    cbor_uint(&w, schema->id);
+    for (uint8_t i = 0; i < schema->count; i++) {
+        if (values[i] == 0) {
+            continue;
+        }
+        cbor_uint(&w, schema->fields[i].key);
+        if (schema->fields[i].type == TLM_BOOL) {
+            cbor_bool(&w, true);
+        } else {
+            cbor_int(&w, values[i]);
+        }
+    }
+    return w.overflow ? 0 : w.len;
+}
+
+static size_t put_varint(uint8_t *p, uint64_t v) {
+    size_t n = 0;
+    do {
+        uint8_t b = v & 0x7F;
+        v >>= 7;
+        p[n++] = b | (v ? 0x80 : 0);
+    } while (v);
+    return n;
+}
+
+static size_t encode_compact(const TelemetrySchema *schema, const void *sample, uint8_t *buf, size_t max) {
+    if (max < 2) {
+        return 0;
+    }
+    size_t len = 0;
+    buf[len++] = TELEMETRY_COMPACT_MAGIC;
+    buf[len++] = schema->id;
+    for (uint8_t i = 0; i < schema->count; i++) {
+        const TelemetryField *f = &schema->fields[i];
+        int64_t v = field_value(f, sample);
+        if (v == 0) {
+            continue;
+        }
+        // Bools are the bare key; everything else a zigzag varint after it
+        if (f->type == TLM_BOOL) {
+            if (len + 1 > max) {
+                return 0;
+            }
+            buf[len++] = f->key;
+            continue;
+        }
+        uint8_t tmp[10];
+        size_t n = put_varint(tmp, ((uint64_t)v << 1) ^ (uint64_t)(v >> 63));
+        if (len + 1 + n > max) {
+            return 0;
+        }
+        buf[len++] = f->key;
+        memcpy(buf + len, tmp, n);
+        len += n;
+    }
+    return len;
+}
+
+size_t telemetry_encode(const TelemetrySchema *schema, const void *sample, TelemetryFormat format,
+                        uint8_t *buf, size_t max) {
+    if (!schema || !sample || !buf || schema->count > TELEMETRY_FIELD_MAX) {
+        return 0;
+    }
+    return format == TELEMETRY_COMPACT ? encode_compact(schema, sample, buf, max)
+                                       : encode_cbor(schema, sample, buf, max);
+}
+
+size_t telemetry_max_size(const TelemetrySchema *schema, TelemetryFormat format) {
+    // Key byte plus a 64-bit value: 9 bytes CBOR, 10 as a varint
+    size_t per_field = format == TELEMETRY_COMPACT ? 11 : 10;
+    return 3 + schema->count * per_field;
+}
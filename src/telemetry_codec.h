@@ -0,0 +1,90 @@
+/**
+ * @file      telemetry_codec.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Schema-driven telemetry encoder: CBOR for MQTT, tag/varint for LoRa
+ */
+
+#ifndef TELEMETRY_CODEC_H
+#define TELEMETRY_CODEC_H
+
+#include <Arduino.h>
+#include <stddef.h>
+
+// Compact frames start with the magic, then the schema id; CBOR never starts with 0xF7
+#define TELEMETRY_COMPACT_MAGIC     0xF7
+#define TELEMETRY_FIELD_MAX         31    // Keys fit one byte in both formats
+
+enum TelemetryFormat : uint8_t {
+    TELEMETRY_CBOR = 0,             // Map, integer keys, key 0 is the schema id
+    TELEMETRY_COMPACT,              // Magic, schema id, then key byte + zigzag varint per field
+};
+
+enum TelemetryType : uint8_t {
+    TLM_BOOL = 0,
+    TLM_U8,
+    TLM_U16,
+    TLM_U32,
+    TLM_I8,
+    TLM_I16,
+    TLM_I32,
+    TLM_FLOAT,                      // Sent as an integer of value * 10^decimals
+    TLM_DOUBLE,
+};
+
+struct TelemetryField {
+    uint8_t key;                    // 1..TELEMETRY_FIELD_MAX, stable across versions
+    uint8_t type;                   // TelemetryType
+    uint8_t decimals;               // Floats only
+    uint16_t offset;                // Into the sample struct
+};
+
+struct TelemetrySchema {
+    uint8_t id;
+    const char *name;               // MQTT topic suffix
+    const TelemetryField *fields;
+    uint8_t count;
+};
+
+#define TLM_FIELD(key, type, sample, member) \
+    {key, type, 0, (uint16_t)offsetof(sample, member)}
+#define TLM_FIXED(key, type, decimals, sample, member) \
+    {key, type, decimals, (uint16_t)offsetof(sample, member)}
+
+/**
+ * @brief Bounded CBOR writer over a caller's buffer; no allocation. A write
+ *        that does not fit sets overflow and leaves len where it was
+ */
+struct CborWriter {
+    uint8_t *buf;
+    size_t max;
+    size_t len;
+    bool overflow;
+};
+
+void cbor_init(CborWriter *w, uint8_t *buf, size_t max);
+void cbor_uint(CborWriter *w, uint64_t v);
+void cbor_int(CborWriter *w, int64_t v);
+void cbor_bool(CborWriter *w, bool v);
+void cbor_float(CborWriter *w, float v);     // Half precision when exact, else single
+void cbor_text(CborWriter *w, const char *s, size_t len);
+void cbor_bytes(CborWriter *w, const uint8_t *data, size_t len);
+void cbor_array(CborWriter *w, size_t count);
+void cbor_map(CborWriter *w, size_t pairs);
+
+/**
+ * @brief Encode one sample. Zero-valued fields are left out, a decoder
+ *        defaults missing keys to 0
+ * @return Bytes written, 0 when the buffer is too small
+ */
+size_t telemetry_encode(const TelemetrySchema *schema, const void *sample, TelemetryFormat format,
+                        uint8_t *buf, size_t max);
+
+/**
+ * @brief Upper bound for a buffer, every field at its widest
+ */
+size_t telemetry_max_size(const TelemetrySchema *schema, TelemetryFormat format);
+
+#endif // TELEMETRY_CODEC_H
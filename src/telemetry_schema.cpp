@@ -0,0 +1,240 @@
+/**
+ * @file      telemetry_schema.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Schema tables, samplers and the two uplinks
+ */
+
+#include "telemetry_schema.h"
+#include "peripheral.h"
+#include "lora_stats.h"
+#include "lora_link.h"
+#include "net_manager.h"
+#include "mqtt_client.h"
+#include "simple_power.h"
+#include "energy_profiler.h"
+#ifdef INTEGRATION_LAYER_ENABLED
+#include "integration/service_manager.h"
+#endif
+
+static const TelemetryField battery_fields[] = {
+    TLM_FIELD(1, TLM_U32, TelemetryBattery, uptime_s),
+    TLM_FIXED(2, TLM_FLOAT, 3, TelemetryBattery, voltage),
+    TLM_FIELD(3, TLM_U8, TelemetryBattery, percent),
+    TLM_FIELD(4, TLM_BOOL, TelemetryBattery, charging),
+    TLM_FIELD(5, TLM_U8, TelemetryBattery, power_mode),
+    TLM_FIELD(6, TLM_U16, TelemetryBattery, cpu_mhz),
+    TLM_FIELD(7, TLM_U32, TelemetryBattery, sleep_count),
+};
+
+static const TelemetryField gps_fields[] = {
+    TLM_FIELD(1, TLM_BOOL, TelemetryGps, valid),
+    TLM_FIELD(2, TLM_U8, TelemetryGps, fix_type),
+    TLM_FIELD(3, TLM_U8, TelemetryGps, satellites),
+    TLM_FIXED(4, TLM_DOUBLE, 7, TelemetryGps, lat),
+    TLM_FIXED(5, TLM_DOUBLE, 7, TelemetryGps, lng),
+    TLM_FIXED(6, TLM_FLOAT, 1, TelemetryGps, altitude),
+    TLM_FIXED(7, TLM_FLOAT, 1, TelemetryGps, speed),
+    TLM_FIXED(8, TLM_FLOAT, 0, TelemetryGps, heading),
+    TLM_FIXED(9, TLM_FLOAT, 1, TelemetryGps, h_acc),
+    TLM_FIELD(10, TLM_U32, TelemetryGps, age_s),
+};
+
+static const TelemetryField lora_fields[] = {
+    TLM_FIELD(1, TLM_U32, TelemetryLora, rx_packets),
+    TLM_FIELD(2, TLM_U32, TelemetryLora, rx_errors),
+    TLM_FIELD(3, TLM_U32, TelemetryLora, tx_sent),
+    TLM_FIELD(4, TLM_U32, TelemetryLora, tx_failed),
+    TLM_FIELD(5, TLM_U32, TelemetryLora, lbt_busy),
+    TLM_FIXED(6, TLM_FLOAT, 1, TelemetryLora, rssi_avg),
+    TLM_FIXED(7, TLM_FLOAT, 1, TelemetryLora, snr_avg),
+    TLM_FIELD(8, TLM_U16, TelemetryLora, per_permille),
+    TLM_FIELD(9, TLM_U16, TelemetryLora, airtime_permille),
+    TLM_FIELD(10, TLM_U8, TelemetryLora, peers),
+    TLM_FIELD(11, TLM_U8, TelemetryLora, sf),
+    TLM_FIELD(12, TLM_I8, TelemetryLora, power),
+};
+
+static const TelemetryField health_fields[] = {
+    TLM_FIELD(1, TLM_U32, TelemetryHealth, uptime_s),
+    TLM_FIELD(2, TLM_U32, TelemetryHealth, free_heap_kb),
+    TLM_FIELD(3, TLM_U32, TelemetryHealth, min_free_heap_kb),
+    TLM_FIELD(4, TLM_U32, TelemetryHealth, free_psram_kb),
+    TLM_FIELD(5, TLM_U8, TelemetryHealth, reset_reason),
+    TLM_FIELD(6, TLM_U8, TelemetryHealth, services_running),
+    TLM_FIELD(7, TLM_U8, TelemetryHealth, services_failed),
+    TLM_FIELD(8, TLM_I8, TelemetryHealth, net_route),
+    TLM_FIELD(9, TLM_U16, TelemetryHealth, mqtt_inflight),
+    TLM_FIELD(10, TLM_U32, TelemetryHealth, mqtt_disconnects),
+};
+
+static const TelemetryField energy_fields[] = {
+    TLM_FIELD(1, TLM_U32, TelemetryEnergy, window_s),
+    TLM_FIELD(2, TLM_I16, TelemetryEnergy, avg_ma),
+    TLM_FIXED(3, TLM_FLOAT, 2, TelemetryEnergy, base_mah),
+    TLM_FIXED(4, TLM_FLOAT, 2, TelemetryEnergy, display_mah),
+    TLM_FIXED(5, TLM_FLOAT, 2, TelemetryEnergy, lora_tx_mah),
+    TLM_FIXED(6, TLM_FLOAT, 2, TelemetryEnergy, gps_mah),
+    TLM_FIXED(7, TLM_FLOAT, 2, TelemetryEnergy, wifi_mah),
+    TLM_FIXED(8, TLM_FLOAT, 2, TelemetryEnergy, cell_mah),
+    TLM_FIXED(9, TLM_FLOAT, 2, TelemetryEnergy, charged_mah),
+    TLM_FIELD(10, TLM_U16, TelemetryEnergy, base_ma),
+    TLM_FIELD(11, TLM_U16, TelemetryEnergy, display_ma),
+    TLM_FIELD(12, TLM_U16, TelemetryEnergy, lora_tx_ma),
+    TLM_FIELD(13, TLM_U16, TelemetryEnergy, gps_ma),
+    TLM_FIELD(14, TLM_U16, TelemetryEnergy, wifi_ma),
+    TLM_FIELD(15, TLM_U16, TelemetryEnergy, cell_ma),
+};
+
+#define SCHEMA(id, name, fields) {id, name, fields, sizeof(fields) / sizeof(fields[0])}
+
+const TelemetrySchema telemetry_battery_schema = SCHEMA(TELEMETRY_SCHEMA_BATTERY, "battery", battery_fields);
+const TelemetrySchema telemetry_gps_schema = SCHEMA(TELEMETRY_SCHEMA_GPS, "gps", gps_fields);
+const TelemetrySchema telemetry_lora_schema = SCHEMA(TELEMETRY_SCHEMA_LORA, "lora", lora_fields);
+const TelemetrySchema telemetry_health_schema = SCHEMA(TELEMETRY_SCHEMA_HEALTH, "health", health_fields);
+const TelemetrySchema telemetry_energy_schema = SCHEMA(TELEMETRY_SCHEMA_ENERGY, "energy", energy_fields);
+
+static const TelemetrySchema *const telemetry_schemas[] = {
+    &telemetry_battery_schema,
+    &telemetry_gps_schema,
+    &telemetry_lora_schema,
+    &telemetry_health_schema,
+    &telemetry_energy_schema,
+};
+
+const TelemetrySchema *telemetry_schema_find(uint8_t id) {
+    for (size_t i = 0; i < sizeof(telemetry_schemas) / sizeof(telemetry_schemas[0]); i++) {
+        if (telemetry_schemas[i]->id == id) {
+            return telemetry_schemas[i];
+        }
+    }
+    return NULL;
+}
+
+void telemetry_sample_battery(TelemetryBattery *out) {
+    memset(out, 0, sizeof(*out));
+    out->uptime_s = millis() / 1000;
+    out->cpu_mhz = getCpuFrequencyMhz();
+    if (Power) {
+        PowerStats stats = Power->getPowerStats();
+        out->voltage = stats.battery_voltage;
+        out->percent = stats.battery_percentage < 0 ? 0 : stats.battery_percentage;
+        out->charging = stats.charging;
+        out->power_mode = (uint8_t)stats.current_mode;
+        out->sleep_count = stats.sleep_count;
+    }
+}
+
+void telemetry_sample_gps(TelemetryGps *out) {
+    memset(out, 0, sizeof(*out));
+    gps_fix_t fix;
+    if (!gps_get_fix(&fix)) {
+        return;
+    }
+    out->valid = fix.valid;
+    out->fix_type = fix.fix_type;
+    out->satellites = fix.vsat > UINT8_MAX ? UINT8_MAX : fix.vsat;
+    out->lat = fix.lat;
+    out->lng = fix.lng;
+    out->altitude = fix.altitude;
+    out->speed = fix.speed;
+    out->heading = fix.heading;
+    out->h_acc = fix.h_acc;
+    out->age_s = (millis() - fix.time_ms) / 1000;
+}
+
+void telemetry_sample_lora(TelemetryLora *out) {
+    memset(out, 0, sizeof(*out));
+    LoraStatsSummary s;
+    lora_stats_summary(&s);
+    out->rx_packets = s.radio.rx_packets;
+    out->rx_errors = s.radio.rx_errors;
+    out->tx_sent = s.radio.tx_sent;
+    out->tx_failed = s.radio.tx_failed;
+    out->lbt_busy = s.radio.lbt_busy;
+    out->rssi_avg = s.rssi_avg;
+    out->snr_avg = s.snr_avg;
+    out->per_permille = s.per_permille;
+    out->airtime_permille = s.airtime_permille;
+    LoraStatsPeer peers[LORA_STATS_PEERS];
+    out->peers = lora_stats_peers(peers, LORA_STATS_PEERS);
+    const lora_profile_t *profile = lora_get_profile();
+    if (profile) {
+        out->sf = profile->sf;
+        out->power = (int8_t)profile->power;
+    }
+}
+
+void telemetry_sample_health(TelemetryHealth *out) {
+    memset(out, 0, sizeof(*out));
+    out->uptime_s = millis() / 1000;
+    out->free_heap_kb = ESP.getFreeHeap() / 1024;
+    out->min_free_heap_kb = ESP.getMinFreeHeap() / 1024;
+    out->free_psram_kb = ESP.getFreePsram() / 1024;
+    out->reset_reason = (uint8_t)esp_reset_reason();
+    out->net_route = (int8_t)net_manager_route();
+    const MqttStats *mqtt = mqtt_stats();
+    out->mqtt_inflight = mqtt->inflight;
+    out->mqtt_disconnects = mqtt->disconnects;
+#ifdef INTEGRATION_LAYER_ENABLED
+    if (GlobalServiceManager) {
+        out->services_running = GlobalServiceManager->getRunningServices().size();
+        out->services_failed = GlobalServiceManager->getFailedServices().size();
+    }
+#endif
+}
+
+void telemetry_sample_energy(TelemetryEnergy *out) {
+    memset(out, 0, sizeof(*out));
+    EnergyStats s;
+    if (!energy_profiler_stats(&s)) {
+        return;
+    }
+    out->window_s = (millis() - s.since_ms) / 1000;
+    out->avg_ma = s.avg_current_ma;
+    out->charged_mah = s.charged_mah;
+    
+    float *mah[ENERGY_BUCKETS] = {&out->display_mah, &out->lora_tx_mah, &out->gps_mah,
+                                  &out->wifi_mah, &out->cell_mah, &out->base_mah};
+    uint16_t *ma[ENERGY_BUCKETS] = {&out->display_ma, &out->lora_tx_ma, &out->gps_ma,
+                                    &out->wifi_ma, &out->cell_ma, &out->base_ma};
+    for (int i = 0; i < ENERGY_BUCKETS; i++) {
+        *mah[i] = s.bucket[i].mah;
+        *ma[i] = s.bucket[i].ma > UINT16_MAX ? UINT16_MAX : (uint16_t)s.bucket[i].ma;
+    }
+}
+
+bool telemetry_publish_mqtt(const TelemetrySchema *schema, const void *sample, uint8_t qos) {
+    if (!schema || !mqtt_connected()) {
+        return false;
+    }
+    char topic[MQTT_TOPIC_MAX];
+    int n = snprintf(topic, sizeof(topic), MQTT_TOPIC_TELEMETRY "/%s", mqtt_device_id(), schema->name);
+    if (n <= 0 || (size_t)n >= sizeof(topic)) {
+        return false;
+    }
+    
+    MqttBuffer *buf = mqtt_buffer_acquire(topic, qos);
+    size_t capacity;
+    uint8_t *payload = mqtt_buffer_payload(buf, &capacity);
+    if (!payload) {
+        return false;
+    }
+    size_t len = telemetry_encode(schema, sample, TELEMETRY_CBOR, payload, capacity);
+    if (!len) {
+        mqtt_buffer_release(buf);
+        return false;
+    }
+    return mqtt_publish_buffer(buf, len);
+}
+
+int telemetry_send_lora(const TelemetrySchema *schema, const void *sample) {
+    uint8_t frame[LORA_PACKET_MAX];
+    size_t len = schema ? telemetry_encode(schema, sample, TELEMETRY_COMPACT, frame, sizeof(frame)) : 0;
+    if (!len) {
+        return LORA_LINK_ERR_ARG;
+    }
+    return lora_link_send(frame, len);
+}
@@ -0,0 +1,118 @@
+/**
+ * @file      telemetry_schema.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Telemetry schemas shared by the MQTT and LoRa uplinks
+ */
+
+#ifndef TELEMETRY_SCHEMA_H
+#define TELEMETRY_SCHEMA_H
+
+#include "telemetry_codec.h"
+
+// Schema ids are on the wire; never renumber, add new ones at the end.
+// Field keys follow the same rule within a schema
+#define TELEMETRY_SCHEMA_BATTERY    1
+#define TELEMETRY_SCHEMA_GPS        2
+#define TELEMETRY_SCHEMA_LORA       3
+#define TELEMETRY_SCHEMA_HEALTH     4
+#define TELEMETRY_SCHEMA_ENERGY     5
+
+struct TelemetryBattery {
+    uint32_t uptime_s;
+    float voltage;                  // V, sent in mV
+    uint8_t percent;
+    bool charging;
+    uint8_t power_mode;
+    uint16_t cpu_mhz;
+    uint32_t sleep_count;
+};
+
+struct TelemetryGps {
+    bool valid;
+    uint8_t fix_type;
+    uint8_t satellites;
+    double lat;                     // Sent in 1e-7 deg
+    double lng;
+    float altitude;                 // m, sent in dm
+    float speed;                    // km/h, sent in 0.1
+    float heading;                  // deg
+    float h_acc;                    // m, sent in dm
+    uint32_t age_s;                 // Since the fix was published
+};
+
+struct TelemetryLora {
+    uint32_t rx_packets;
+    uint32_t rx_errors;
+    uint32_t tx_sent;
+    uint32_t tx_failed;
+    uint32_t lbt_busy;
+    float rssi_avg;                 // dBm, sent in 0.1
+    float snr_avg;                  // dB, sent in 0.1
+    uint16_t per_permille;
+    uint16_t airtime_permille;
+    uint8_t peers;
+    uint8_t sf;
+    int8_t power;
+};
+
+struct TelemetryHealth {
+    uint32_t uptime_s;
+    uint32_t free_heap_kb;
+    uint32_t min_free_heap_kb;
+    uint32_t free_psram_kb;
+    uint8_t reset_reason;           // esp_reset_reason_t
+    uint8_t services_running;
+    uint8_t services_failed;
+    int8_t net_route;               // NetBearer
+    uint16_t mqtt_inflight;
+    uint32_t mqtt_disconnects;
+};
+
+struct TelemetryEnergy {
+    uint32_t window_s;              // Since the profiler started or was reset
+    int16_t avg_ma;                 // Gauge AverageCurrent(), positive charging
+    float base_mah;                 // mAh, sent in 0.01
+    float display_mah;
+    float lora_tx_mah;
+    float gps_mah;
+    float wifi_mah;
+    float cell_mah;
+    float charged_mah;
+    uint16_t base_ma;               // Fitted draw while on
+    uint16_t display_ma;
+    uint16_t lora_tx_ma;
+    uint16_t gps_ma;
+    uint16_t wifi_ma;
+    uint16_t cell_ma;
+};
+
+extern const TelemetrySchema telemetry_battery_schema;
+extern const TelemetrySchema telemetry_gps_schema;
+extern const TelemetrySchema telemetry_lora_schema;
+extern const TelemetrySchema telemetry_health_schema;
+extern const TelemetrySchema telemetry_energy_schema;
+
+const TelemetrySchema *telemetry_schema_find(uint8_t id);
+
+// Current values from the owning modules
+void telemetry_sample_battery(TelemetryBattery *out);
+void telemetry_sample_gps(TelemetryGps *out);
+void telemetry_sample_lora(TelemetryLora *out);
+void telemetry_sample_health(TelemetryHealth *out);
+void telemetry_sample_energy(TelemetryEnergy *out);
+
+/**
+ * @brief CBOR straight into an MQTT pool buffer, on MQTT_TOPIC_TELEMETRY/<schema name>
+ */
+bool telemetry_publish_mqtt(const TelemetrySchema *schema, const void *sample, uint8_t qos = 0);
+
+/**
+ * @brief Compact frame over the LoRa link. Blocks like lora_link_send()
+ * @return A LORA_LINK_* code
+ */
+int telemetry_send_lora(const TelemetrySchema *schema, const void *sample);
+
+#endif // TELEMETRY_SCHEMA_H
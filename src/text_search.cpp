@@ -0,0 +1,1010 @@
+/**
+ * @file      text_search.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Full-text search: per-unit inverted index files, term filters
+ *            in RAM and an index task following the message store and log
+ */
+
+#include "text_search.h"
+#include <SD.h>
+#include <esp_heap_caps.h>
+#include "simple_logger.h"
+#include "spi_bus.h"
+#include "fs_service.h"
+#include "sd_manager.h"
+#include "task_stack.h"
+#ifdef INTEGRATION_LAYER_ENABLED
+#include "integration/config_manager.h"
+#endif
+
+static_assert(sizeof(SearchIndexHeader) == 20, "Index header is part of the file format");
+static_assert(sizeof(SearchTermEntry) == 12, "Term entry is part of the file format");
+static_assert(SEARCH_UNIT_SIZE <= 65536, "Doc offsets are 16 bits");
+
+#define SEARCH_FILTER_BITS      (SEARCH_FILTER_BYTES * 8)
+#define SEARCH_UNITS            (MSG_STORE_MAX_SEGMENTS + SEARCH_LOG_UNITS)
+#define SEARCH_PATH_MAX         32
+#define SEARCH_LOG_STEPS        16      // Log reads per task pass
+#define SEARCH_LINE_MAX         512     // Log bytes checked against a query
+
+static_assert((SEARCH_FILTER_BITS & (SEARCH_FILTER_BITS - 1)) == 0, "Filter size is a power of two");
+
+enum SearchUnitState {
+    UNIT_NONE = 0,
+    UNIT_PENDING,                   // Postings in RAM only
+    UNIT_INDEXED,                   // Index file on the card, filter in RAM
+    UNIT_STALE,                     // Source changed under the file: rebuild
+};
+
+struct SearchUnitInfo {
+    uint16_t id;
+    uint8_t state;
+    uint32_t docs;
+};
+
+// A word of a doc not yet in an index file
+struct SearchPosting {
+    uint32_t hash;
+    uint16_t unit;
+    uint16_t doc;
+    uint8_t source;
+};
+
+struct SearchCandidate {
+    uint8_t source;
+    uint8_t mask;                   // Query terms seen, for RAM postings
+    uint16_t unit;
+    uint16_t doc;
+};
+
+struct QueryTerm {
+    uint32_t hash;
+    const char *word;
+    uint8_t len;
+};
+
+static SemaphoreHandle_t search_lock = NULL;  // Pending postings, unit table, filters
+static TaskHandle_t search_task_handle = NULL;
+static SearchStats search_stats;
+static volatile bool search_on_sd = false;
+static volatile bool search_rescan = false;
+static char search_log_path[64] = SEARCH_LOG_PATH;
+
+// Messages by segment id, then log chunks
+static SearchUnitInfo unit_table[SEARCH_UNITS];
+static uint8_t *unit_filters = nullptr;        // PSRAM, SEARCH_FILTER_BYTES per unit
+static SearchPosting *pending = nullptr;       // PSRAM
+static size_t pending_count = 0;
+
+// Index task only
+static uint32_t log_covered = 0;               // Log lines before this are indexed
+static int32_t msg_live_scanned = -1;          // Segment being appended to, read in once
+static int32_t msg_first_seen = -1;            // Oldest segment at the last pass
+static uint8_t *log_buf = nullptr;
+
+static uint8_t *put_varint(uint8_t *p, uint32_t v) {
+    while (v >= 0x80) {
+        *p++ = (uint8_t)v | 0x80;
+        v >>= 7;
+    }
+    *p++ = (uint8_t)v;
+    return p;
+}
+
+static const uint8_t *get_varint(const uint8_t *p, const uint8_t *end, uint32_t *v) {
+    uint32_t result = 0;
+    for (int shift = 0; shift < 35 && p < end; shift += 7) {
+        uint8_t b = *p++;
+        result |= (uint32_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) {
+            *v = result;
+            return p;
+        }
+    }
+    return nullptr;
+}
+
+static void *search_alloc(size_t size) {
+    void *p = heap_caps_malloc(size, MALLOC_CAP_SPIRAM);
+    return p ? p : heap_caps_malloc(size, MALLOC_CAP_8BIT);
+}
+
+// UTF-8 bytes count as letters, so non-Latin words index whole
+static inline bool is_word_char(uint8_t c) {
+    return isalnum(c) || c >= 0x80;
+}
+
+static inline uint8_t fold(uint8_t c) {
+    return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+}
+
+static size_t unit_slot(uint8_t source, uint16_t unit) {
+    return source == SEARCH_SRC_MSG ? unit % MSG_STORE_MAX_SEGMENTS
+                                    : MSG_STORE_MAX_SEGMENTS + unit % SEARCH_LOG_UNITS;
+}
+
+static void unit_path(char *path, uint8_t source, uint16_t unit, const char *ext) {
+    snprintf(path, SEARCH_PATH_MAX, SEARCH_DIR "/%c%05u.%s", source == SEARCH_SRC_MSG ? 'm' : 'l',
+             (unsigned)unit, ext);
+}
+
+// ===== Term filters =====
+
+static void filter_bits(uint32_t hash, uint32_t bits[3]) {
+    bits[0] = hash & (SEARCH_FILTER_BITS - 1);
+    bits[1] = (hash >> 13) & (SEARCH_FILTER_BITS - 1);
+    bits[2] = (hash * 0x9E3779B1UL) >> 19 & (SEARCH_FILTER_BITS - 1);
+}
+
+static void filter_add(uint8_t *filter, uint32_t hash) {
+    uint32_t bits[3];
+    filter_bits(hash, bits);
+    for (int i = 0; i < 3; i++) {
+        filter[bits[i] >> 3] |= 1 << (bits[i] & 7);
+    }
+}
+
+static bool filter_has(const uint8_t *filter, uint32_t hash) {
+    uint32_t bits[3];
+    filter_bits(hash, bits);
+    for (int i = 0; i < 3; i++) {
+        if (!(filter[bits[i] >> 3] & (1 << (bits[i] & 7)))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// ===== Pending postings, search_lock held =====
+
+static void pending_add_text(uint8_t source, uint16_t unit, uint16_t doc, const char *text, size_t len) {
+    uint32_t h = 2166136261UL;      // FNV-1a over the folded word
+    size_t n = 0;
+    for (size_t i = 0; i <= len; i++) {
+        uint8_t c = i < len ? text[i] : ' ';
+        if (is_word_char(c)) {
+            h = (h ^ fold(c)) * 16777619UL;
+            n++;
+            continue;
+        }
+        if (n >= SEARCH_TERM_MIN) {
+            if (pending_count < SEARCH_PENDING_MAX) {
+                pending[pending_count++] = {h, unit, doc, source};
+            } else {
+                search_stats.dropped++;
+            }
+        }
+        h = 2166136261UL;
+        n = 0;
+    }
+
+    SearchUnitInfo &info = unit_table[unit_slot(source, unit)];
+    if (info.id != unit || info.state == UNIT_NONE) {
+        info = {unit, UNIT_PENDING, 0};
+    }
+}
+
+static void pending_drop(uint8_t source, uint16_t unit) {
+    size_t kept = 0;
+    for (size_t i = 0; i < pending_count; i++) {
+        if (pending[i].source != source || pending[i].unit != unit) {
+            pending[kept++] = pending[i];
+        }
+    }
+    pending_count = kept;
+}
+
+// ===== Message store listener, on the store task =====
+
+static void search_msg_add(uint16_t seg, uint16_t off, const MsgStoreRecord *head, const char *body, void *ctx) {
+    // Peer names are searchable too
+    xSemaphoreTake(search_lock, portMAX_DELAY);
+    pending_add_text(SEARCH_SRC_MSG, seg, off, body, head->peer_len + head->text_len);
+    xSemaphoreGive(search_lock);
+}
+
+static void search_msg_changed(uint16_t seg, void *ctx) {
+    xSemaphoreTake(search_lock, portMAX_DELAY);
+    SearchUnitInfo &info = unit_table[unit_slot(SEARCH_SRC_MSG, seg)];
+    if (info.id == seg && info.state != UNIT_NONE) {
+        info.state = UNIT_STALE;
+    }
+    pending_drop(SEARCH_SRC_MSG, seg);
+    xSemaphoreGive(search_lock);
+}
+
+static const MsgStoreListener search_listener = {search_msg_add, search_msg_changed, nullptr};
+
+// ===== Index files, index task =====
+
+static int posting_cmp(const void *pa, const void *pb) {
+    const SearchPosting *a = (const SearchPosting *)pa;
+    const SearchPosting *b = (const SearchPosting *)pb;
+    if (a->hash != b->hash) return a->hash < b->hash ? -1 : 1;
+    return (int)a->doc - (int)b->doc;
+}
+
+static void unit_remove(uint8_t source, uint16_t unit) {
+    char path[SEARCH_PATH_MAX];
+    unit_path(path, source, unit, "idx");
+    SpiBusHold bus(SPI_CLIENT_SD);
+    SD.remove(path);
+}
+
+static bool unit_write(uint8_t source, uint16_t unit, SearchPosting *posts, size_t n,
+                       uint8_t *filter, uint32_t *docs_out) {
+    // Sorted by term then doc, each pair once
+    qsort(posts, n, sizeof(SearchPosting), posting_cmp);
+    size_t m = 0;
+    uint32_t terms = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (m && posts[i].hash == posts[m - 1].hash && posts[i].doc == posts[m - 1].doc) {
+            continue;
+        }
+        if (!m || posts[i].hash != posts[m - 1].hash) {
+            terms++;
+        }
+        posts[m++] = posts[i];
+    }
+
+    SearchTermEntry *table = (SearchTermEntry *)search_alloc(terms * sizeof(SearchTermEntry) + 1);
+    uint8_t *postings = (uint8_t *)search_alloc(m * 3 + 1);   // Deltas below 64K: 3 bytes at most
+    uint8_t *seen = (uint8_t *)search_alloc(SEARCH_UNIT_SIZE / 8);
+    bool ok = table && postings && seen;
+    if (ok) {
+        memset(filter, 0, SEARCH_FILTER_BYTES);
+        memset(seen, 0, SEARCH_UNIT_SIZE / 8);
+        uint8_t *p = postings;
+        uint32_t t = 0;
+        uint32_t docs = 0;
+        uint16_t prev = 0;
+        for (size_t i = 0; i < m; i++) {
+            if (!i || posts[i].hash != posts[i - 1].hash) {
+                table[t++] = {posts[i].hash, (uint32_t)(p - postings), 0};
+                filter_add(filter, posts[i].hash);
+                prev = 0;
+            }
+            table[t - 1].count++;
+            p = put_varint(p, posts[i].doc - prev);
+            prev = posts[i].doc;
+            if (!(seen[posts[i].doc >> 3] & (1 << (posts[i].doc & 7)))) {
+                seen[posts[i].doc >> 3] |= 1 << (posts[i].doc & 7);
+                docs++;
+            }
+        }
+        *docs_out = docs;
+
+        SearchIndexHeader header = {SEARCH_MAGIC, SEARCH_VERSION, source, unit, terms, docs,
+                                    (uint32_t)(p - postings)};
+        char tmp[SEARCH_PATH_MAX];
+        char path[SEARCH_PATH_MAX];
+        unit_path(tmp, source, unit, "tmp");
+        unit_path(path, source, unit, "idx");
+
+        // Whole or not at all: a file is only ever seen under its final name
+        SpiBusHold bus(SPI_CLIENT_SD);
+        File f = SD.open(tmp, FILE_WRITE);
+        size_t table_bytes = terms * sizeof(SearchTermEntry);
+        ok = f && f.write((const uint8_t *)&header, sizeof(header)) == sizeof(header) &&
+             f.write(filter, SEARCH_FILTER_BYTES) == SEARCH_FILTER_BYTES &&
+             f.write((const uint8_t *)table, table_bytes) == table_bytes &&
+             f.write(postings, header.postings_bytes) == header.postings_bytes;
+        if (f) {
+            f.close();
+        }
+        SD.remove(path);
+        ok = ok && SD.rename(tmp, path);
+        if (!ok) {
+            SD.remove(tmp);
+        }
+        fs_invalidate_usage();
+    }
+    free(seen);
+    free(postings);
+    free(table);
+    return ok;
+}
+
+/**
+ * Moves a unit's postings from RAM into its index file. Without a card
+ * they stay where they are
+ */
+static bool unit_flush(uint8_t source, uint16_t unit) {
+    if (!search_on_sd) {
+        return false;
+    }
+
+    xSemaphoreTake(search_lock, portMAX_DELAY);
+    size_t n = 0;
+    for (size_t i = 0; i < pending_count; i++) {
+        n += pending[i].source == source && pending[i].unit == unit;
+    }
+    SearchPosting *posts = (SearchPosting *)search_alloc(n * sizeof(SearchPosting) + 1);
+    if (!posts) {
+        xSemaphoreGive(search_lock);
+        return false;
+    }
+    size_t taken = 0;
+    size_t kept = 0;
+    for (size_t i = 0; i < pending_count; i++) {
+        if (pending[i].source == source && pending[i].unit == unit) {
+            posts[taken++] = pending[i];
+        } else {
+            pending[kept++] = pending[i];
+        }
+    }
+    pending_count = kept;
+    xSemaphoreGive(search_lock);
+
+    uint8_t *filter = (uint8_t *)search_alloc(SEARCH_FILTER_BYTES);
+    uint32_t docs = 0;
+    bool ok = filter && unit_write(source, unit, posts, n, filter, &docs);
+
+    xSemaphoreTake(search_lock, portMAX_DELAY);
+    SearchUnitInfo &info = unit_table[unit_slot(source, unit)];
+    if (ok) {
+        search_stats.built++;
+        // Compacted while it was being written: the task rebuilds it
+        if (!(info.id == unit && info.state == UNIT_STALE)) {
+            memcpy(unit_filters + unit_slot(source, unit) * SEARCH_FILTER_BYTES, filter, SEARCH_FILTER_BYTES);
+            info = {unit, UNIT_INDEXED, docs};
+        }
+    } else {
+        search_stats.write_errors++;
+        // A message segment can be read again later; a log chunk is lost
+        info = {unit, (uint8_t)(source == SEARCH_SRC_MSG ? UNIT_STALE : UNIT_NONE), 0};
+    }
+    xSemaphoreGive(search_lock);
+
+    free(filter);
+    free(posts);
+    return ok;
+}
+
+// Filters of the index files already on the card; damaged ones go
+static void search_load() {
+    xSemaphoreTake(search_lock, portMAX_DELAY);
+    for (size_t i = 0; i < SEARCH_UNITS; i++) {
+        if (unit_table[i].state == UNIT_INDEXED) {
+            unit_table[i].state = UNIT_NONE;
+        }
+    }
+    xSemaphoreGive(search_lock);
+    if (!search_on_sd) {
+        return;
+    }
+
+    int32_t log_last = -1;
+    uint32_t loaded = 0;
+    uint8_t *filter = (uint8_t *)search_alloc(SEARCH_FILTER_BYTES);
+    if (!filter) {
+        return;
+    }
+    SpiBusHold bus(SPI_CLIENT_SD);
+    if (!SD.exists(SEARCH_DIR) && !SD.mkdir(SEARCH_DIR)) {
+        LOG_ERROR("Search", "Cannot create " SEARCH_DIR);
+        free(filter);
+        return;
+    }
+    File dir = SD.open(SEARCH_DIR);
+    for (File f = dir.openNextFile(); f; f = dir.openNextFile()) {
+        const char *name = strrchr(f.name(), '/');
+        name = name ? name + 1 : f.name();
+        char *ext = nullptr;
+        uint32_t unit = strtoul(name + 1, &ext, 10);
+        uint8_t source = name[0] == 'm' ? SEARCH_SRC_MSG : SEARCH_SRC_LOG;
+        bool named = (name[0] == 'm' || name[0] == 'l') && ext != name + 1 && unit <= 0xFFFF;
+
+        SearchIndexHeader header;
+        bool ok = named && !strcmp(ext, ".idx") &&
+                  f.read((uint8_t *)&header, sizeof(header)) == sizeof(header) &&
+                  header.magic == SEARCH_MAGIC && header.version == SEARCH_VERSION &&
+                  header.source == source && header.unit == unit &&
+                  f.size() == sizeof(header) + SEARCH_FILTER_BYTES + header.terms * sizeof(SearchTermEntry) +
+                              header.postings_bytes &&
+                  f.read(filter, SEARCH_FILTER_BYTES) == SEARCH_FILTER_BYTES;
+        if (!ok) {
+            char path[SEARCH_PATH_MAX];
+            snprintf(path, sizeof(path), SEARCH_DIR "/%s", name);
+            f.close();
+            SD.remove(path);
+            continue;
+        }
+        f.close();
+
+        size_t slot = unit_slot(source, unit);
+        xSemaphoreTake(search_lock, portMAX_DELAY);
+        memcpy(unit_filters + slot * SEARCH_FILTER_BYTES, filter, SEARCH_FILTER_BYTES);
+        unit_table[slot] = {(uint16_t)unit, UNIT_INDEXED, header.docs};
+        xSemaphoreGive(search_lock);
+        loaded++;
+        if (source == SEARCH_SRC_LOG && (int32_t)unit > log_last) {
+            log_last = unit;
+        }
+    }
+    dir.close();
+    free(filter);
+
+    // Sealed chunks are done; the one after them is read again from its start
+    log_covered = (uint32_t)(log_last + 1) * SEARCH_UNIT_SIZE;
+    LOG_INFOF("Search", "%lu index files loaded", (unsigned long)loaded);
+}
+
+// ===== Sources, index task =====
+
+static void search_msg_scan(uint16_t seg, uint16_t off, const MsgStoreRecord *head, const char *body, void *ctx) {
+    search_msg_add(seg, off, head, body, ctx);
+}
+
+/**
+ * Messages: sealed segments without an index are read in and written out,
+ * the one being appended to is read in once and then follows the listener
+ */
+static bool search_follow_msgs() {
+    uint16_t first;
+    uint16_t last;
+    if (!msg_store_segments(&first, &last)) {
+        return false;
+    }
+    bool worked = false;
+
+    // Files of dropped segments: their slots may already belong to new ones
+    if (search_on_sd && msg_first_seen >= 0) {
+        for (uint16_t seg = msg_first_seen; seg != first && (uint16_t)(first - seg) <= MSG_STORE_MAX_SEGMENTS; seg++) {
+            unit_remove(SEARCH_SRC_MSG, seg);
+        }
+    }
+    msg_first_seen = first;
+    for (size_t i = 0; i < MSG_STORE_MAX_SEGMENTS; i++) {
+        xSemaphoreTake(search_lock, portMAX_DELAY);
+        SearchUnitInfo info = unit_table[i];
+        bool gone = info.state != UNIT_NONE && (uint16_t)(info.id - first) > (uint16_t)(last - first);
+        if (gone) {
+            pending_drop(SEARCH_SRC_MSG, info.id);
+            unit_table[i] = {0, UNIT_NONE, 0};
+        }
+        xSemaphoreGive(search_lock);
+        if (gone && search_on_sd) {
+            unit_remove(SEARCH_SRC_MSG, info.id);
+        }
+    }
+
+    for (uint16_t seg = first; (uint16_t)(seg - first) <= (uint16_t)(last - first); seg++) {
+        xSemaphoreTake(search_lock, portMAX_DELAY);
+        SearchUnitInfo info = unit_table[unit_slot(SEARCH_SRC_MSG, seg)];
+        xSemaphoreGive(search_lock);
+        bool known = info.id == seg;
+        if (seg == last) {
+            if (msg_live_scanned != last) {
+                msg_store_scan_segment(seg, search_msg_scan, nullptr);
+                msg_live_scanned = last;
+                worked = true;
+            }
+            break;
+        }
+
+        if (known && info.state == UNIT_PENDING) {
+            // Sealed since it was read in
+            worked |= unit_flush(SEARCH_SRC_MSG, seg);
+            continue;
+        }
+        if (known && info.state == UNIT_INDEXED) {
+            continue;
+        }
+        if (known && info.state == UNIT_STALE && search_on_sd) {
+            unit_remove(SEARCH_SRC_MSG, seg);
+        }
+        xSemaphoreTake(search_lock, portMAX_DELAY);
+        pending_drop(SEARCH_SRC_MSG, seg);
+        unit_table[unit_slot(SEARCH_SRC_MSG, seg)] = {seg, UNIT_NONE, 0};
+        xSemaphoreGive(search_lock);
+        if (msg_store_scan_segment(seg, search_msg_scan, nullptr)) {
+            unit_flush(SEARCH_SRC_MSG, seg);
+            worked = true;
+        }
+        // One segment per pass: a rebuild never hogs the card
+        break;
+    }
+    return worked;
+}
+
+// Indexes the lines starting in [from, to); returns where the next one starts
+static uint32_t log_scan(File &f, uint32_t from, uint32_t to) {
+    uint32_t pos = from;
+    while (pos < to) {
+        if (!f.seek(pos)) {
+            break;
+        }
+        size_t n = f.read(log_buf, SEARCH_LOG_READ);
+        if (!n) {
+            break;
+        }
+        size_t start = 0;
+        xSemaphoreTake(search_lock, portMAX_DELAY);
+        for (size_t i = 0; i < n && pos + start < to; i++) {
+            if (log_buf[i] == '\n') {
+                uint32_t line = pos + start;
+                pending_add_text(SEARCH_SRC_LOG, line / SEARCH_UNIT_SIZE, line % SEARCH_UNIT_SIZE,
+                                 (const char *)log_buf + start, i - start);
+                start = i + 1;
+            }
+        }
+        if (!start && n == SEARCH_LOG_READ) {
+            // A line longer than a read is indexed in pieces
+            pending_add_text(SEARCH_SRC_LOG, pos / SEARCH_UNIT_SIZE, pos % SEARCH_UNIT_SIZE,
+                             (const char *)log_buf, n);
+            start = n;
+        }
+        xSemaphoreGive(search_lock);
+        if (!start) {
+            break;                  // Last line still being written
+        }
+        pos += start;
+    }
+    return pos;
+}
+
+static bool search_follow_log() {
+    if (!search_on_sd || !log_buf) {
+        return false;
+    }
+    uint32_t size;
+    uint32_t from;
+    uint32_t to;
+    {
+        SpiBusHold bus(SPI_CLIENT_SD);
+        File f = SD.open(search_log_path, FILE_READ);
+        if (!f) {
+            return false;
+        }
+        size = f.size();
+        if (size < log_covered) {
+            // Log started over: every chunk is something else now
+            LOG_INFO("Search", "Log truncated, reindexing");
+            for (size_t i = MSG_STORE_MAX_SEGMENTS; i < SEARCH_UNITS; i++) {
+                if (unit_table[i].state == UNIT_NONE) {
+                    continue;
+                }
+                char path[SEARCH_PATH_MAX];
+                unit_path(path, SEARCH_SRC_LOG, unit_table[i].id, "idx");
+                SD.remove(path);
+            }
+            xSemaphoreTake(search_lock, portMAX_DELAY);
+            for (size_t i = MSG_STORE_MAX_SEGMENTS; i < SEARCH_UNITS; i++) {
+                pending_drop(SEARCH_SRC_LOG, unit_table[i].id);
+                unit_table[i] = {0, UNIT_NONE, 0};
+            }
+            xSemaphoreGive(search_lock);
+            log_covered = 0;
+        }
+        // Chunks too old to be kept are not worth reading
+        uint32_t floor = size / SEARCH_UNIT_SIZE >= SEARCH_LOG_UNITS
+                         ? (size / SEARCH_UNIT_SIZE - SEARCH_LOG_UNITS + 1) * SEARCH_UNIT_SIZE : 0;
+        from = max(log_covered, floor);
+        to = min(size, from + SEARCH_LOG_READ * SEARCH_LOG_STEPS);
+        if (from < to) {
+            log_covered = log_scan(f, from, to);
+        }
+        f.close();
+    }
+
+    // Chunks behind the read position are sealed
+    uint32_t live = log_covered / SEARCH_UNIT_SIZE;
+    for (size_t i = MSG_STORE_MAX_SEGMENTS; i < SEARCH_UNITS; i++) {
+        xSemaphoreTake(search_lock, portMAX_DELAY);
+        SearchUnitInfo info = unit_table[i];
+        xSemaphoreGive(search_lock);
+        if (info.state == UNIT_PENDING && info.id < live) {
+            // Its slot last held the chunk SEARCH_LOG_UNITS before it
+            if (info.id >= SEARCH_LOG_UNITS) {
+                unit_remove(SEARCH_SRC_LOG, info.id - SEARCH_LOG_UNITS);
+            }
+            unit_flush(SEARCH_SRC_LOG, info.id);
+        }
+    }
+    return from < to;
+}
+
+static void search_task(void *param) {
+    search_load();
+    while (true) {
+        if (search_rescan) {
+            search_rescan = false;
+            search_load();
+        }
+        bool worked = search_follow_msgs();
+        worked |= search_follow_log();
+        vTaskDelay(worked ? 1 : pdMS_TO_TICKS(SEARCH_IDLE_MS));
+    }
+}
+
+static void search_sd_detach() {
+    search_on_sd = false;
+    xSemaphoreTake(search_lock, portMAX_DELAY);
+    for (size_t i = 0; i < SEARCH_UNITS; i++) {
+        if (unit_table[i].state == UNIT_INDEXED) {
+            unit_table[i].state = UNIT_NONE;
+        }
+    }
+    xSemaphoreGive(search_lock);
+}
+
+static void search_sd_attach() {
+    search_on_sd = true;
+    search_rescan = true;
+}
+
+// ===== Searching, caller's task =====
+
+static size_t query_parse(const char *query, QueryTerm *terms) {
+    size_t n = 0;
+    const char *p = query;
+    while (*p && n < SEARCH_QUERY_TERMS) {
+        while (*p && !is_word_char(*p)) {
+            p++;
+        }
+        const char *word = p;
+        uint32_t h = 2166136261UL;
+        while (is_word_char(*p)) {
+            h = (h ^ fold(*p)) * 16777619UL;
+            p++;
+        }
+        size_t len = p - word;
+        if (len < SEARCH_TERM_MIN || len > 255) {
+            continue;
+        }
+        bool dup = false;
+        for (size_t i = 0; i < n; i++) {
+            dup |= terms[i].hash == h;
+        }
+        if (!dup) {
+            terms[n++] = {h, word, (uint8_t)len};
+        }
+    }
+    return n;
+}
+
+// Whole-word, case-folded
+static bool text_has_word(const char *text, size_t len, const QueryTerm &term) {
+    for (size_t i = 0; i + term.len <= len; i++) {
+        if (i && is_word_char(text[i - 1])) {
+            continue;
+        }
+        size_t j = 0;
+        while (j < term.len && fold(text[i + j]) == fold(term.word[j])) {
+            j++;
+        }
+        if (j == term.len && (i + j == len || !is_word_char(text[i + j]))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static int candidate_cmp(const void *pa, const void *pb) {
+    const SearchCandidate *a = (const SearchCandidate *)pa;
+    const SearchCandidate *b = (const SearchCandidate *)pb;
+    if (a->source != b->source) return (int)a->source - (int)b->source;
+    if (a->unit != b->unit) return (int)b->unit - (int)a->unit;
+    return (int)b->doc - (int)a->doc;
+}
+
+static SearchCandidate *candidate_find(SearchCandidate *c, size_t n, const SearchPosting &p) {
+    SearchCandidate key = {p.source, 0, p.unit, p.doc};
+    return (SearchCandidate *)bsearch(&key, c, n, sizeof(SearchCandidate), candidate_cmp);
+}
+
+// Docs in RAM postings holding every term
+static size_t pending_match(const QueryTerm *terms, size_t nterms, SearchCandidate *out, size_t max) {
+    size_t n = 0;
+    xSemaphoreTake(search_lock, portMAX_DELAY);
+    // Newest first, in case there are more than fit
+    for (size_t i = pending_count; i > 0 && n < max; i--) {
+        if (pending[i - 1].hash == terms[0].hash) {
+            out[n++] = {pending[i - 1].source, 1, pending[i - 1].unit, pending[i - 1].doc};
+        }
+    }
+    qsort(out, n, sizeof(SearchCandidate), candidate_cmp);
+    for (size_t t = 1; t < nterms && n; t++) {
+        for (size_t i = 0; i < pending_count; i++) {
+            if (pending[i].hash == terms[t].hash) {
+                SearchCandidate *c = candidate_find(out, n, pending[i]);
+                if (c) {
+                    c->mask |= 1 << t;
+                }
+            }
+        }
+    }
+    xSemaphoreGive(search_lock);
+
+    uint8_t all = (1 << nterms) - 1;
+    size_t kept = 0;
+    for (size_t i = 0; i < n; i++) {
+        if ((out[i].mask & all) == all) {
+            out[kept++] = out[i];
+        }
+    }
+    return kept;
+}
+
+// A term's postings in an open index file, ascending; count 0 when it is not there
+static uint16_t *file_postings(File &f, const SearchIndexHeader &header, uint32_t hash, uint32_t *count) {
+    size_t table = sizeof(SearchIndexHeader) + SEARCH_FILTER_BYTES;
+    size_t lo = 0;
+    size_t hi = header.terms;
+    SearchTermEntry e;
+    *count = 0;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (!f.seek(table + mid * sizeof(e)) || f.read((uint8_t *)&e, sizeof(e)) != sizeof(e)) {
+            return nullptr;
+        }
+        if (e.hash == hash) {
+            break;
+        }
+        if (e.hash < hash) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo >= hi || e.hash != hash || e.offset >= header.postings_bytes) {
+        return nullptr;
+    }
+
+    size_t bytes = min((size_t)e.count * 3, (size_t)(header.postings_bytes - e.offset));
+    uint8_t *raw = (uint8_t *)search_alloc(bytes);
+    uint16_t *docs = (uint16_t *)search_alloc(e.count * sizeof(uint16_t));
+    size_t base = table + header.terms * sizeof(SearchTermEntry);
+    if (!raw || !docs || !f.seek(base + e.offset) || f.read(raw, bytes) != bytes) {
+        free(raw);
+        free(docs);
+        return nullptr;
+    }
+    const uint8_t *p = raw;
+    uint32_t doc = 0;
+    uint32_t n = 0;
+    while (n < e.count && p) {
+        uint32_t delta;
+        p = get_varint(p, raw + bytes, &delta);
+        if (p) {
+            doc += delta;
+            docs[n++] = doc;
+        }
+    }
+    free(raw);
+    *count = n;
+    return docs;
+}
+
+// Docs of one indexed unit holding every term
+static size_t file_match(uint8_t source, uint16_t unit, const QueryTerm *terms, size_t nterms,
+                         SearchCandidate *out, size_t max) {
+    char path[SEARCH_PATH_MAX];
+    unit_path(path, source, unit, "idx");
+    SpiBusHold bus(SPI_CLIENT_SD);
+    File f = SD.open(path, FILE_READ);
+    SearchIndexHeader header;
+    if (!f || f.read((uint8_t *)&header, sizeof(header)) != sizeof(header) || header.magic != SEARCH_MAGIC) {
+        return 0;
+    }
+
+    uint32_t n = 0;
+    uint16_t *docs = file_postings(f, header, terms[0].hash, &n);
+    for (size_t t = 1; t < nterms && n; t++) {
+        uint32_t m = 0;
+        uint16_t *other = file_postings(f, header, terms[t].hash, &m);
+        uint32_t kept = 0;
+        uint32_t j = 0;
+        for (uint32_t i = 0; i < n && j < m; i++) {
+            while (j < m && other[j] < docs[i]) {
+                j++;
+            }
+            if (j < m && other[j] == docs[i]) {
+                docs[kept++] = docs[i];
+            }
+        }
+        n = kept;
+        free(other);
+    }
+    f.close();
+
+    // Newest first, as many as fit
+    size_t written = 0;
+    for (uint32_t i = n; i > 0 && written < max; i--) {
+        out[written++] = {source, 0, unit, docs[i - 1]};
+    }
+    free(docs);
+    return written;
+}
+
+static bool hit_from_msg(const SearchCandidate &c, const QueryTerm *terms, size_t nterms,
+                         MsgStoreMessage *msg, SearchHit *hit) {
+    if (!msg_store_read(c.unit, c.doc, msg)) {
+        return false;
+    }
+    size_t peer_len = strlen(msg->peer);
+    size_t text_len = strlen(msg->text);
+    for (size_t t = 0; t < nterms; t++) {
+        if (!text_has_word(msg->text, text_len, terms[t]) && !text_has_word(msg->peer, peer_len, terms[t])) {
+            return false;
+        }
+    }
+    hit->source = SEARCH_SRC_MSG;
+    hit->channel = msg->channel;
+    hit->out = msg->flags & MSG_FLAG_OUT;
+    hit->time = msg->time;
+    strlcpy(hit->peer, msg->peer, sizeof(hit->peer));
+    strlcpy(hit->text, msg->text, sizeof(hit->text));
+    return true;
+}
+
+// SPI bus held
+static bool hit_from_log(File &f, const SearchCandidate &c, const QueryTerm *terms, size_t nterms,
+                         char *line, SearchHit *hit) {
+    uint32_t pos = (uint32_t)c.unit * SEARCH_UNIT_SIZE + c.doc;
+    if (!f.seek(pos)) {
+        return false;
+    }
+    size_t n = f.read((uint8_t *)line, SEARCH_LINE_MAX);
+    char *end = (char *)memchr(line, '\n', n);
+    if (end) {
+        n = end - line;
+    }
+    for (size_t t = 0; t < nterms; t++) {
+        if (!text_has_word(line, n, terms[t])) {
+            return false;
+        }
+    }
+    hit->source = SEARCH_SRC_LOG;
+    hit->channel = 0;
+    hit->out = false;
+    hit->time = 0;
+    hit->peer[0] = '\0';
+    n = min(n, sizeof(hit->text) - 1);
+    memcpy(hit->text, line, n);
+    hit->text[n] = '\0';
+    return true;
+}
+
+size_t text_search(const char *query, SearchHit *out, size_t max) {
+    uint32_t start = micros();
+    QueryTerm terms[SEARCH_QUERY_TERMS];
+    size_t nterms = query && search_lock ? query_parse(query, terms) : 0;
+    if (!nterms || !max) {
+        return 0;
+    }
+
+    SearchCandidate *cands = (SearchCandidate *)search_alloc(SEARCH_CANDIDATES_MAX * sizeof(SearchCandidate));
+    SearchCandidate *units = (SearchCandidate *)search_alloc(SEARCH_UNITS * sizeof(SearchCandidate));
+    MsgStoreMessage *msg = (MsgStoreMessage *)search_alloc(sizeof(MsgStoreMessage));
+    char *line = (char *)search_alloc(SEARCH_LINE_MAX);
+    size_t hits = 0;
+    if (!cands || !units || !msg || !line) {
+        goto done;
+    }
+    {
+        size_t nc = pending_match(terms, nterms, cands, SEARCH_CANDIDATES_MAX);
+
+        // Units whose filter has every term; the rest are never opened
+        size_t nu = 0;
+        xSemaphoreTake(search_lock, portMAX_DELAY);
+        for (size_t i = 0; search_on_sd && i < SEARCH_UNITS; i++) {
+            if (unit_table[i].state != UNIT_INDEXED) {
+                continue;
+            }
+            const uint8_t *filter = unit_filters + i * SEARCH_FILTER_BYTES;
+            bool maybe = true;
+            for (size_t t = 0; t < nterms && maybe; t++) {
+                maybe = filter_has(filter, terms[t].hash);
+            }
+            if (maybe) {
+                uint8_t source = i < MSG_STORE_MAX_SEGMENTS ? SEARCH_SRC_MSG : SEARCH_SRC_LOG;
+                units[nu++] = {source, 0, unit_table[i].id, 0};
+            }
+        }
+        xSemaphoreGive(search_lock);
+        qsort(units, nu, sizeof(SearchCandidate), candidate_cmp);
+        for (size_t i = 0; i < nu && nc < SEARCH_CANDIDATES_MAX; i++) {
+            nc += file_match(units[i].source, units[i].unit, terms, nterms, cands + nc, SEARCH_CANDIDATES_MAX - nc);
+        }
+
+        // A unit being rebuilt can be in RAM and on the card at once
+        qsort(cands, nc, sizeof(SearchCandidate), candidate_cmp);
+        size_t i = 0;
+        for (; i < nc && hits < max && cands[i].source == SEARCH_SRC_MSG; i++) {
+            if (i && !candidate_cmp(&cands[i], &cands[i - 1])) {
+                continue;
+            }
+            hits += hit_from_msg(cands[i], terms, nterms, msg, &out[hits]);
+        }
+        // Message reads take the store's lock and then the bus; lines only the bus
+        if (i < nc && hits < max) {
+            SpiBusHold bus(SPI_CLIENT_SD);
+            File f = SD.open(search_log_path, FILE_READ);
+            for (; f && i < nc && hits < max; i++) {
+                if (i && !candidate_cmp(&cands[i], &cands[i - 1])) {
+                    continue;
+                }
+                hits += hit_from_log(f, cands[i], terms, nterms, line, &out[hits]);
+            }
+            if (f) {
+                f.close();
+            }
+        }
+    }
+
+done:
+    free(line);
+    free(msg);
+    free(units);
+    free(cands);
+    if (search_lock) {
+        xSemaphoreTake(search_lock, portMAX_DELAY);
+        search_stats.searches++;
+        search_stats.last_search_us = micros() - start;
+        xSemaphoreGive(search_lock);
+    }
+    return hits;
+}
+
+// ===== API =====
+
+bool text_search_begin() {
+    if (search_task_handle) {
+        return true;
+    }
+#ifdef INTEGRATION_LAYER_ENABLED
+    if (!GET_CONFIG_BOOL("search", "enabled", true)) {
+        LOG_INFO("Search", "Search disabled by config");
+        return false;
+    }
+    String path = GET_CONFIG_STRING("search", "log_path", String(SEARCH_LOG_PATH));
+    strlcpy(search_log_path, path.c_str(), sizeof(search_log_path));
+#endif
+
+    unit_filters = (uint8_t *)search_alloc(SEARCH_UNITS * SEARCH_FILTER_BYTES);
+    pending = (SearchPosting *)search_alloc(SEARCH_PENDING_MAX * sizeof(SearchPosting));
+    log_buf = (uint8_t *)search_alloc(SEARCH_LOG_READ);
+    search_lock = xSemaphoreCreateMutex();
+    if (!unit_filters || !pending || !log_buf || !search_lock) {
+        LOG_ERROR("Search", "Out of memory");
+        return false;
+    }
+    search_on_sd = sd_manager_mounted();
+    sd_manager_add_client("Search", search_sd_attach, search_sd_detach);
+    msg_store_set_listener(&search_listener);
+
+    // The index lives on the SD card, but the messages are read from
+    // wherever the store is: LittleFS without a card, which a PSRAM stack
+    // may not touch. The store picks its file system once, in
+    // msg_store_begin(), so this holds for the task's life
+    MsgStoreStats store;
+    msg_store_get_stats(&store);
+    uint8_t policy = store.on_sd ? TASK_STACK_PSRAM_OK : TASK_STACK_INTERNAL;
+    if (task_spawn(search_task, "search_idx", SEARCH_TASK_STACK, NULL, SEARCH_TASK_PRIORITY,
+                   &search_task_handle, tskNO_AFFINITY, policy) != pdPASS) {
+        LOG_ERROR("Search", "Failed to start the index task");
+        return false;
+    }
+    return true;
+}
+
+void text_search_get_stats(SearchStats *out) {
+    if (!search_lock) {
+        memset(out, 0, sizeof(*out));
+        return;
+    }
+    xSemaphoreTake(search_lock, portMAX_DELAY);
+    *out = search_stats;
+    out->ready = search_on_sd;
+    out->units = 0;
+    for (size_t i = 0; i < SEARCH_UNITS; i++) {
+        out->units += unit_table[i].state == UNIT_INDEXED;
+    }
+    out->pending = pending_count;
+    xSemaphoreGive(search_lock);
+}
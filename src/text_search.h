@@ -0,0 +1,113 @@
+/**
+ * @file      text_search.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Full-text search over stored messages and the text log
+ */
+
+#ifndef TEXT_SEARCH_H
+#define TEXT_SEARCH_H
+
+#include <Arduino.h>
+#include "msg_store.h"
+
+/**
+ * An inverted index per unit: a message store segment, or a 64 KB chunk of
+ * the text log. Terms are lowercase ASCII words, kept as 32-bit hashes.
+ * Each sealed unit has one file under /search on the card: a term filter,
+ * the term table sorted by hash, then each term's postings, the offsets
+ * of the messages or lines that hold it, delta and varint coded.
+ *
+ * RAM holds the term filters of every unit, which rule out most units
+ * without touching the card, and the postings of the units still being
+ * written. New messages are added as the store writes them; the log is
+ * followed by the index task, which also builds the files for sealed
+ * units and rebuilds those the store compacted.
+ *
+ * A search wants every word of the query. Hits are checked against the
+ * text itself, so hash collisions and deleted messages never show.
+ * Without a card the postings stay in RAM, up to SEARCH_PENDING_MAX.
+ *
+ * Config section "search": enabled (true), log_path (SEARCH_LOG_PATH).
+ */
+
+#define SEARCH_DIR                  "/search"
+#define SEARCH_LOG_PATH             "/logs/system.log"
+#define SEARCH_MAGIC                0x58495354  // "TSIX"
+#define SEARCH_VERSION              1
+#define SEARCH_UNIT_SIZE            (64 * 1024) // Log chunk, as big as a store segment
+#define SEARCH_LOG_UNITS            64      // Newest log chunks kept searchable
+#define SEARCH_FILTER_BYTES         1024    // Per unit; ~5% false positives at 2k terms
+#define SEARCH_TERM_MIN             2
+#define SEARCH_QUERY_TERMS          8
+#define SEARCH_PENDING_MAX          32768   // Postings not yet in a file (PSRAM)
+#define SEARCH_CANDIDATES_MAX       512     // Per search, before the text is checked
+#define SEARCH_SNIPPET              96
+#define SEARCH_LOG_READ             4096    // Log bytes read per step
+#define SEARCH_IDLE_MS              2000
+#define SEARCH_TASK_STACK           (1024 * 4)
+#define SEARCH_TASK_PRIORITY        (tskIDLE_PRIORITY + 1)
+
+enum SearchSource {
+    SEARCH_SRC_MSG = 0,
+    SEARCH_SRC_LOG,
+};
+
+/**
+ * Index file: this header, the term filter, terms x SearchTermEntry,
+ * then the postings
+ */
+struct SearchIndexHeader {
+    uint32_t magic;
+    uint8_t version;
+    uint8_t source;
+    uint16_t unit;
+    uint32_t terms;
+    uint32_t docs;
+    uint32_t postings_bytes;
+};
+
+struct SearchTermEntry {
+    uint32_t hash;
+    uint32_t offset;                // Into the postings
+    uint32_t count;
+};
+
+struct SearchHit {
+    uint8_t source;
+    uint8_t channel;                // Messages
+    bool out;                       // Messages: sent from this device
+    uint32_t time;                  // Messages: UTC seconds
+    char peer[MSG_STORE_PEER_MAX + 1];
+    char text[SEARCH_SNIPPET];
+};
+
+struct SearchStats {
+    bool ready;                     // Index files loaded
+    uint32_t units;                 // With an index file
+    uint32_t pending;               // Postings in RAM
+    uint32_t dropped;               // Postings lost to a full pending buffer
+    uint32_t built;                 // Index files written
+    uint32_t write_errors;
+    uint32_t searches;
+    uint32_t last_search_us;
+};
+
+/**
+ * @brief Start the index task and follow the message store. After
+ *        msg_store_begin()
+ */
+bool text_search_begin();
+
+/**
+ * @brief Messages and log lines holding every word of query, newest first
+ *        (messages before log lines). Runs on the calling task
+ * @return Hits written
+ */
+size_t text_search(const char *query, SearchHit *out, size_t max);
+
+void text_search_get_stats(SearchStats *out);
+
+#endif // TEXT_SEARCH_H
@@ -0,0 +1,613 @@
+/**
+ * @file      time_service.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Unified timebase: clock model over esp_timer, source arbitration,
+ *            SNTP client, NITZ via AT+CCLK, RTC hand-over across deep sleep
+ */
+
+#include "time_service.h"
+#include <WiFi.h>
+#include <WiFiUdp.h>
+#include <esp_attr.h>
+#include <esp_timer.h>
+#include <esp_system.h>
+#include <esp_random.h>
+#include <esp_rom_crc.h>
+#include <sys/time.h>
+#include "simple_logger.h"
+#include "net_manager.h"
+#include "modem_at.h"
+#include "timer_wheel.h"
+#ifdef INTEGRATION_LAYER_ENABLED
+#include "integration/config_manager.h"
+#endif
+
+#define TIME_MAGIC              0x454D4954  // "TIME"
+#define NTP_PORT                123
+#define NTP_PACKET_SIZE         48
+#define NTP_UNIX_OFFSET         2208988800LL    // 1900 to 1970
+#define NTP_ERA_SPLIT           0x80000000UL    // Earlier seconds are past 2036
+
+// Survives deep sleep and resets, not a power cut
+struct TimeRecord {
+    uint32_t magic;
+    int32_t freq_ppb;
+    int32_t rtc_ppb;
+    uint8_t freq_trained;
+    uint8_t rtc_trained;
+    uint8_t asleep;                 // The sleep fields are set
+    uint8_t reserved;
+    int64_t sleep_utc_us;           // Model at the moment of sleep
+    int64_t sleep_sys_us;           // System clock at the same moment
+    uint32_t sleep_acc_us;
+    uint32_t crc;
+};
+
+RTC_NOINIT_ATTR static TimeRecord rtc_time;
+
+// The clock: utc = anchor_utc + dt + dt * freq + the part of slew run off by dt
+struct ClockModel {
+    int64_t anchor_mono;
+    int64_t anchor_utc;
+    int64_t slew_us;                // Still to be run off, at 2^-TIME_SLEW_SHIFT
+    int32_t freq_ppb;
+    uint32_t acc_us;                // At the anchor
+    bool freq_trained;
+    bool valid;
+};
+
+static ClockModel clock_model;
+static volatile uint32_t clock_seq = 0;
+static portMUX_TYPE time_mux = portMUX_INITIALIZER_UNLOCKED;
+static TimeStats time_stats;
+
+// Last good sample, the far end of a frequency measurement; writer only
+static int64_t ref_mono = 0, ref_utc = 0;
+static uint32_t ref_acc = 0;
+static bool ref_valid = false;
+
+// Deep sleep wake, until a sample good enough to train the RTC comes in
+static bool wake_pending = false;
+static int64_t wake_mono = 0;
+static int64_t wake_sys_elapsed = 0;    // Slept per the RTC, microseconds
+
+static int32_t rtc_ppb = 0;
+static bool rtc_trained = false;
+
+static String ntp_server = TIME_NTP_SERVER;
+static uint32_t ntp_interval_ms = TIME_NTP_INTERVAL_MIN * 60 * 1000UL;
+static bool ntp_busy = false;
+static bool ntp_ok = false;
+static uint32_t ntp_last = 0;
+static bool ntp_tried = false;
+static bool nitz_on = true;
+static bool nitz_asking = false;
+static bool sync_started = false;
+static WheelTimer time_timer;
+
+// ===== Model =====
+
+static int64_t model_eval(const ClockModel *m, int64_t mono) {
+    int64_t dt = mono - m->anchor_mono;
+    int64_t run = dt > 0 ? dt >> TIME_SLEW_SHIFT : 0;
+    int64_t slew = m->slew_us >= 0 ? min(run, m->slew_us) : max(-run, m->slew_us);
+    return m->anchor_utc + dt + dt * m->freq_ppb / 1000000000LL + slew;
+}
+
+static uint32_t model_unc(const ClockModel *m, int64_t mono) {
+    if (!m->valid) {
+        return UINT32_MAX;
+    }
+    int64_t dt = mono - m->anchor_mono;
+    dt = dt < 0 ? -dt : dt;
+    int64_t run = dt >> TIME_SLEW_SHIFT;
+    int64_t left = m->slew_us >= 0 ? m->slew_us - min(run, m->slew_us) : -m->slew_us - min(run, -m->slew_us);
+    int64_t unc = (int64_t)m->acc_us + left +
+                  dt * (m->freq_trained ? TIME_FREQ_TRAINED_PPB : TIME_FREQ_UNC_PPB) / 1000000000LL;
+    return unc < UINT32_MAX ? (uint32_t)unc : UINT32_MAX;
+}
+
+// Consistent copy from any task or core, lock-free
+static void model_read(ClockModel *out) {
+    uint32_t seq;
+    do {
+        seq = clock_seq;
+        __sync_synchronize();
+        *out = clock_model;
+        __sync_synchronize();
+    } while ((seq & 1) || seq != clock_seq);
+}
+
+// Caller holds time_mux
+static void model_write(const ClockModel *m) {
+    clock_seq++;
+    __sync_synchronize();
+    clock_model = *m;
+    __sync_synchronize();
+    clock_seq++;
+}
+
+static void record_seal() {
+    rtc_time.magic = TIME_MAGIC;
+    rtc_time.crc = esp_rom_crc32_le(0, (const uint8_t *)&rtc_time, offsetof(TimeRecord, crc));
+}
+
+static bool record_valid() {
+    return rtc_time.magic == TIME_MAGIC &&
+           rtc_time.crc == esp_rom_crc32_le(0, (const uint8_t *)&rtc_time, offsetof(TimeRecord, crc));
+}
+
+static void record_drift(int32_t freq, bool freq_ok) {
+    if (!record_valid()) {
+        memset(&rtc_time, 0, sizeof(rtc_time));
+    }
+    rtc_time.freq_ppb = freq;
+    rtc_time.freq_trained = freq_ok;
+    rtc_time.rtc_ppb = rtc_ppb;
+    rtc_time.rtc_trained = rtc_trained;
+    rtc_time.asleep = 0;
+    record_seal();
+}
+
+static int64_t sys_now_us() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (int64_t)tv.tv_sec * 1000000LL + tv.tv_usec;
+}
+
+static void sys_sync(int64_t utc) {
+    int64_t off = sys_now_us() - utc;
+    if (off > TIME_SYS_TOLERANCE_US || off < -TIME_SYS_TOLERANCE_US) {
+        struct timeval tv = { (time_t)(utc / 1000000), (suseconds_t)(utc % 1000000) };
+        settimeofday(&tv, NULL);
+    }
+}
+
+static int32_t clamp_ppb(int64_t ppb, int32_t limit) {
+    return ppb > limit ? limit : ppb < -limit ? -limit : (int32_t)ppb;
+}
+
+// Spans run to days, so the ratio in double rather than overflow 64 bits
+static int64_t ratio_ppb(int64_t part, int64_t span) {
+    double r = (double)part * 1e9 / (double)span;
+    return r > INT32_MAX ? INT32_MAX : r < -INT32_MAX ? -INT32_MAX : (int64_t)r;
+}
+
+// A sample far enough from the last good one: the crystal's rate error
+static bool train_freq(ClockModel *m, int64_t utc, int64_t mono, uint32_t acc) {
+    bool trained = false;
+    if (ref_valid) {
+        int64_t span = mono - ref_mono;
+        if (span > 0 && ratio_ppb((int64_t)acc + ref_acc, span) < TIME_FREQ_GOOD_PPB) {
+            int64_t ppb = ratio_ppb((utc - ref_utc) - span, span);
+            int32_t f = m->freq_trained ? m->freq_ppb + (int32_t)((ppb - m->freq_ppb) / (1 << TIME_FREQ_GAIN_SHIFT))
+                                        : (int32_t)ppb;
+            m->freq_ppb = clamp_ppb(f, TIME_FREQ_MAX_PPB);
+            m->freq_trained = true;
+            trained = true;
+        }
+    }
+    // The far end stays put until it is used or a much better one comes,
+    // so a steady stream of equal samples builds up the span
+    if (!ref_valid || trained || acc < ref_acc / 2) {
+        ref_mono = mono;
+        ref_utc = utc;
+        ref_acc = acc;
+        ref_valid = true;
+    }
+    return trained;
+}
+
+// The first good sample after a deep sleep: the slow clock's rate error
+static bool train_rtc(int64_t utc, int64_t mono, uint32_t acc, int32_t freq) {
+    if (!wake_pending || wake_sys_elapsed <= 0) {
+        return false;
+    }
+    if (ratio_ppb((int64_t)acc + rtc_time.sleep_acc_us, wake_sys_elapsed) >= TIME_RTC_GOOD_PPB) {
+        return false;
+    }
+    // Back to the wake along the crystal, then the sleep as it really was
+    int64_t back = mono - wake_mono;
+    int64_t wake_utc = utc - back - back * freq / 1000000000LL;
+    int64_t slept = wake_utc - rtc_time.sleep_utc_us;
+    int64_t ppb = ratio_ppb(slept - wake_sys_elapsed, wake_sys_elapsed);
+    rtc_ppb = clamp_ppb(rtc_trained ? rtc_ppb + (ppb - rtc_ppb) / (1 << TIME_FREQ_GAIN_SHIFT) : ppb,
+                        TIME_RTC_UNC_PPB);
+    rtc_trained = true;
+    wake_pending = false;
+    return true;
+}
+
+bool time_feed(TimeSource source, int64_t utc_us, int64_t mono_us, uint32_t acc_us) {
+    if (source <= TIME_SRC_NONE || source >= TIME_SRC_COUNT || utc_us < (int64_t)TIME_VALID_S * 1000000LL) {
+        return false;
+    }
+    portENTER_CRITICAL(&time_mux);
+    ClockModel m = clock_model;
+    int64_t now = esp_timer_get_time();
+    if (mono_us > now) {
+        mono_us = now;
+    }
+    if (m.valid && acc_us >= model_unc(&m, mono_us)) {
+        time_stats.rejected++;
+        portEXIT_CRITICAL(&time_mux);
+        return false;
+    }
+
+    int64_t offset = m.valid ? utc_us - model_eval(&m, mono_us) : 0;
+    bool freq_was = m.freq_trained;
+    bool freq_new = train_freq(&m, utc_us, mono_us, acc_us);
+    bool rtc_new = source != TIME_SRC_RTC && train_rtc(utc_us, mono_us, acc_us, m.freq_ppb);
+
+    // Re-anchored at the reading now, so a slew never shows as a jump
+    int64_t reading = model_eval(&clock_model, now);
+    int64_t since = now - mono_us;
+    bool step = !m.valid || offset > TIME_SLEW_MAX_US || offset < -TIME_STEP_BACK_US;
+    m.anchor_mono = now;
+    if (step) {
+        m.anchor_utc = utc_us + since + since * m.freq_ppb / 1000000000LL;
+        m.slew_us = 0;
+        if (m.valid) {
+            time_stats.steps++;
+            if (offset < 0) {
+                time_stats.back_steps++;
+            }
+        }
+    } else {
+        m.anchor_utc = reading;
+        m.slew_us = offset;
+    }
+    m.acc_us = acc_us + (uint32_t)(since * (freq_was ? TIME_FREQ_TRAINED_PPB : TIME_FREQ_UNC_PPB) / 1000000000LL);
+    m.valid = true;
+    model_write(&m);
+
+    time_stats.samples[source]++;
+    time_stats.source = source;
+    time_stats.last_offset_us = clamp_ppb(offset, INT32_MAX);
+    time_stats.freq_ppb = m.freq_ppb;
+    time_stats.rtc_ppb = rtc_ppb;
+    time_stats.freq_trained += freq_new;
+    time_stats.rtc_trained += rtc_new;
+    portEXIT_CRITICAL(&time_mux);
+
+    sys_sync(model_eval(&m, esp_timer_get_time()));
+    if (freq_new || rtc_new) {
+        record_drift(m.freq_ppb, m.freq_trained);
+    }
+    // GPS comes every second; only its steps are news
+    if (step || (source != TIME_SRC_PPS && source != TIME_SRC_GPS)) {
+        LOG_INFOF("Time", "%s: offset %lld us, accuracy %lu us", time_source_name(source), (long long)offset,
+                  (unsigned long)acc_us);
+    }
+    return true;
+}
+
+// ===== Reading =====
+
+int64_t time_at_mono_us(int64_t mono_us) {
+    ClockModel m;
+    model_read(&m);
+    return m.valid ? model_eval(&m, mono_us) : mono_us;
+}
+
+int64_t time_now_us() {
+    return time_at_mono_us(esp_timer_get_time());
+}
+
+uint32_t time_now_s() {
+    return (uint32_t)(time_now_us() / 1000000);
+}
+
+bool time_valid() {
+    return clock_model.valid;
+}
+
+uint32_t time_accuracy_us() {
+    ClockModel m;
+    model_read(&m);
+    return model_unc(&m, esp_timer_get_time());
+}
+
+int64_t time_from_millis(uint32_t ms) {
+    int64_t mono = esp_timer_get_time();
+    uint32_t age = (uint32_t)(mono / 1000) - ms;
+    return time_at_mono_us(mono - (int64_t)age * 1000);
+}
+
+static int64_t days_from_civil(int y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    int64_t era = (y >= 0 ? y : y - 399) / 400;
+    unsigned yoe = (unsigned)(y - era * 400);
+    unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + (int64_t)doe - 719468;
+}
+
+int64_t time_make_utc(int year, int month, int day, int hour, int minute, int second) {
+    return days_from_civil(year, month, day) * 86400 + hour * 3600 + minute * 60 + second;
+}
+
+size_t time_format_iso(int64_t utc_us, char *buf, size_t len) {
+    time_t t = (time_t)(utc_us / 1000000);
+    struct tm tm;
+    gmtime_r(&t, &tm);
+    int n = snprintf(buf, len, "%04d-%02d-%02dT%02d:%02d:%02d.%03dZ", tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday,
+                     tm.tm_hour, tm.tm_min, tm.tm_sec, (int)(utc_us % 1000000 / 1000));
+    return n > 0 && (size_t)n < len ? n : 0;
+}
+
+const char *time_source_name(uint8_t source) {
+    static const char *names[TIME_SRC_COUNT] = {"none", "RTC", "HTTP", "NITZ", "NTP", "GPS", "PPS"};
+    return source < TIME_SRC_COUNT ? names[source] : "?";
+}
+
+void time_get_stats(TimeStats *stats) {
+    portENTER_CRITICAL(&time_mux);
+    *stats = time_stats;
+    portEXIT_CRITICAL(&time_mux);
+}
+
+// ===== SNTP =====
+
+static int64_t ntp_read_us(const uint8_t *p) {
+    uint32_t sec = (uint32_t)p[0] << 24 | p[1] << 16 | p[2] << 8 | p[3];
+    uint32_t frac = (uint32_t)p[4] << 24 | p[5] << 16 | p[6] << 8 | p[7];
+    int64_t unix_s = (int64_t)sec - NTP_UNIX_OFFSET + (sec < NTP_ERA_SPLIT ? 0x100000000LL : 0);
+    return unix_s * 1000000LL + (int64_t)(((uint64_t)frac * 1000000ULL) >> 32);
+}
+
+static uint32_t ntp_short_us(const uint8_t *p) {
+    uint32_t v = (uint32_t)p[0] << 24 | p[1] << 16 | p[2] << 8 | p[3];
+    return (uint32_t)(((uint64_t)v * 1000000ULL) >> 16);
+}
+
+// One exchange; the server's time at the midpoint of the round trip
+static bool ntp_query(WiFiUDP *udp, IPAddress ip, int64_t *utc, int64_t *mono, uint32_t *acc, int64_t *rtt) {
+    uint8_t pkt[NTP_PACKET_SIZE] = {0};
+    pkt[0] = 0x23;                  // LI 0, version 4, client
+    // A random transmit time, echoed back as the originate: no stale or forged replies
+    uint32_t nonce[2] = {esp_random(), esp_random()};
+    memcpy(pkt + 40, nonce, sizeof(nonce));
+
+    while (udp->parsePacket() > 0) {
+        udp->flush();
+    }
+    if (!udp->beginPacket(ip, NTP_PORT) || udp->write(pkt, sizeof(pkt)) != sizeof(pkt)) {
+        return false;
+    }
+    int64_t t1 = esp_timer_get_time();
+    if (!udp->endPacket()) {
+        return false;
+    }
+    uint32_t start = millis();
+    while (millis() - start < TIME_NTP_TIMEOUT_MS) {
+        if (udp->parsePacket() < NTP_PACKET_SIZE) {
+            delay(5);
+            continue;
+        }
+        int64_t t4 = esp_timer_get_time();
+        uint8_t rx[NTP_PACKET_SIZE];
+        if (udp->read(rx, sizeof(rx)) != sizeof(rx) || memcmp(rx + 24, nonce, sizeof(nonce)) ||
+            (rx[0] & 0x07) != 4 || (rx[0] >> 6) == 3 || rx[1] == 0 || rx[1] > 15) {
+            continue;
+        }
+        int64_t t2 = ntp_read_us(rx + 32);
+        int64_t t3 = ntp_read_us(rx + 40);
+        *rtt = (t4 - t1) - (t3 - t2);
+        if (*rtt < 0) {
+            *rtt = 0;
+        }
+        *utc = t2 + (t3 - t2) / 2;
+        *mono = t1 + (t4 - t1) / 2;
+        int64_t a = *rtt / 2 + ntp_short_us(rx + 4) / 2 + ntp_short_us(rx + 8);
+        *acc = a < UINT32_MAX ? (uint32_t)a : UINT32_MAX;
+        return true;
+    }
+    return false;
+}
+
+static bool ntp_run() {
+    IPAddress ip;
+    if (!WiFi.hostByName(ntp_server.c_str(), ip)) {
+        LOG_WARNF("Time", "Cannot resolve %s", ntp_server.c_str());
+        return false;
+    }
+    WiFiUDP udp;
+    if (!udp.begin(0)) {
+        return false;
+    }
+    bool got = false;
+    int64_t best_utc = 0, best_mono = 0, best_rtt = 0;
+    uint32_t best_acc = UINT32_MAX;
+    for (int i = 0; i < TIME_NTP_TRIES; i++) {
+        int64_t utc, mono, rtt;
+        uint32_t acc;
+        if (ntp_query(&udp, ip, &utc, &mono, &acc, &rtt) && acc < best_acc) {
+            best_utc = utc;
+            best_mono = mono;
+            best_acc = acc;
+            best_rtt = rtt;
+            got = true;
+        }
+    }
+    udp.stop();
+    if (!got) {
+        LOG_WARNF("Time", "No reply from %s", ntp_server.c_str());
+        return false;
+    }
+    LOG_DEBUGF("Time", "NTP round trip %lld us", (long long)best_rtt);
+    time_feed(TIME_SRC_NTP, best_utc, best_mono, best_acc);
+    return true;
+}
+
+static void ntp_task(void *arg) {
+    bool ok = ntp_run();
+    ntp_ok = ntp_ok || ok;
+    ntp_last = millis();
+    ntp_tried = true;
+    ntp_busy = false;
+    vTaskDelete(NULL);
+}
+
+static bool ntp_start(bool force) {
+    int route = net_manager_route();
+    if (!ntp_server.length() || (route != NET_BEARER_WIFI && route != NET_BEARER_CELL)) {
+        return false;
+    }
+    if (!force) {
+        // Until NTP answers once, every check; after that at the interval, and only if it helps
+        uint32_t due = ntp_ok ? ntp_interval_ms : TIME_CHECK_MS;
+        if (time_accuracy_us() <= TIME_NTP_WANT_US || (ntp_tried && millis() - ntp_last < due)) {
+            return false;
+        }
+    }
+    portENTER_CRITICAL(&time_mux);
+    bool busy = ntp_busy;
+    ntp_busy = true;
+    portEXIT_CRITICAL(&time_mux);
+    if (busy) {
+        return false;
+    }
+    if (xTaskCreate(ntp_task, "sntp", TIME_TASK_STACK, NULL, TIME_TASK_PRIORITY, NULL) != pdPASS) {
+        LOG_ERROR("Time", "Failed to start the SNTP task");
+        ntp_busy = false;
+        return false;
+    }
+    return true;
+}
+
+// ===== NITZ =====
+
+// +CCLK: "yy/MM/dd,hh:mm:ss+zz", local time with the zone in quarter hours
+static void nitz_reply(uint32_t ticket, int result, const char *response, void *ctx) {
+    int64_t mono = esp_timer_get_time();
+    nitz_asking = false;
+    const char *p = response ? strstr(response, "+CCLK:") : NULL;
+    int yy, mo, dd, hh, mi, ss, tz = 0;
+    char sign = '+';
+    if (result != MODEM_AT_OK || !p ||
+        sscanf(p, "+CCLK: \"%d/%d/%d,%d:%d:%d%c%d", &yy, &mo, &dd, &hh, &mi, &ss, &sign, &tz) < 6) {
+        return;
+    }
+    // Before the network has sent its time the modem counts from its own epoch
+    if (yy < 25 || mo < 1 || mo > 12 || dd < 1 || dd > 31 || hh > 23 || mi > 59 || ss > 60) {
+        return;
+    }
+    int64_t local = time_make_utc(2000 + yy, mo, dd, hh, mi, ss);
+    int64_t utc = local - (sign == '-' ? -tz : tz) * 15 * 60;
+    // Whole seconds: the middle of the second is the best guess
+    time_feed(TIME_SRC_NITZ, utc * 1000000LL + 500000, mono, TIME_NITZ_ACC_US);
+}
+
+static void nitz_ask() {
+    if (!nitz_on || nitz_asking || time_accuracy_us() <= TIME_NITZ_WANT_US) {
+        return;
+    }
+    nitz_asking = modem_at_send("+CCLK?", MODEM_AT_TIMEOUT_MS, NULL, nitz_reply) != 0;
+}
+
+static void nitz_urc(const char *line, void *ctx) {
+    nitz_ask();
+}
+
+// ===== Triggers =====
+
+static void check_timer(WheelTimer *timer) {
+    ntp_start(false);
+    nitz_ask();
+}
+
+static void route_changed(int from, int to, void *ctx) {
+    if (to == NET_BEARER_WIFI || to == NET_BEARER_CELL) {
+        ntp_start(false);
+    }
+    if (to == NET_BEARER_CELL && nitz_on) {
+        // Has the modem keep its clock from the network's time zone updates
+        modem_at_send("+CTZU=1");
+        nitz_ask();
+    }
+}
+
+// ===== API =====
+
+bool time_service_begin() {
+    esp_reset_reason_t reason = esp_reset_reason();
+    int64_t mono = esp_timer_get_time();
+    int64_t sys = sys_now_us();
+    bool kept = record_valid() && reason != ESP_RST_POWERON && reason != ESP_RST_BROWNOUT;
+    if (!kept) {
+        memset(&rtc_time, 0, sizeof(rtc_time));
+        record_seal();
+    }
+
+    portENTER_CRITICAL(&time_mux);
+    clock_model.freq_ppb = rtc_time.freq_ppb;
+    clock_model.freq_trained = rtc_time.freq_trained;
+    rtc_ppb = rtc_time.rtc_ppb;
+    rtc_trained = rtc_time.rtc_trained;
+    time_stats.freq_ppb = clock_model.freq_ppb;
+    time_stats.rtc_ppb = rtc_ppb;
+    portEXIT_CRITICAL(&time_mux);
+
+    if (kept && rtc_time.asleep && reason == ESP_RST_DEEPSLEEP && sys > rtc_time.sleep_sys_us) {
+        // The system clock ran on the slow clock while asleep; take out its known error
+        int64_t elapsed = sys - rtc_time.sleep_sys_us;
+        int64_t utc = rtc_time.sleep_utc_us + elapsed + (int64_t)((double)elapsed * rtc_ppb / 1e9);
+        int64_t acc = rtc_time.sleep_acc_us +
+                      (int64_t)((double)elapsed * (rtc_trained ? TIME_RTC_TRAINED_PPB : TIME_RTC_UNC_PPB) / 1e9);
+        wake_pending = true;
+        wake_mono = mono;
+        wake_sys_elapsed = elapsed;
+        time_feed(TIME_SRC_RTC, utc, mono, acc < UINT32_MAX ? (uint32_t)acc : UINT32_MAX);
+    } else if (reason != ESP_RST_POWERON && sys >= (int64_t)TIME_VALID_S * 1000000LL) {
+        time_feed(TIME_SRC_RTC, sys, mono, TIME_RTC_BOOT_ACC_US);
+    }
+    rtc_time.asleep = 0;
+    record_seal();
+    return true;
+}
+
+bool time_service_start_sync() {
+    if (sync_started) {
+        return true;
+    }
+    sync_started = true;
+#ifdef INTEGRATION_LAYER_ENABLED
+    ntp_server = GET_CONFIG_STRING("time", "ntp", String(TIME_NTP_SERVER));
+    ntp_interval_ms = GET_CONFIG_INT("time", "ntp_interval_min", TIME_NTP_INTERVAL_MIN) * 60 * 1000UL;
+    nitz_on = GET_CONFIG_BOOL("time", "nitz", true);
+#endif
+    if (nitz_on) {
+        // Network time zone updates on the A7682E and its kin; any of them means a new clock
+        modem_at_on_urc("+CTZV", nitz_urc);
+        modem_at_on_urc("+CTZE", nitz_urc);
+        modem_at_on_urc("*PSUTTZ", nitz_urc);
+    }
+    net_manager_on_route(route_changed);
+    timer_wheel_init(&time_timer, "time", check_timer);
+    timer_wheel_arm(&time_timer, TIME_CHECK_MS, TIME_CHECK_MS);
+    route_changed(NET_BEARER_NONE, net_manager_route(), NULL);
+    LOG_INFOF("Time", "Clock %s, NTP %s, NITZ %s", time_valid() ? "set" : "unset",
+              ntp_server.length() ? ntp_server.c_str() : "off", nitz_on ? "on" : "off");
+    return true;
+}
+
+void time_service_prepare_sleep() {
+    ClockModel m;
+    model_read(&m);
+    int64_t mono = esp_timer_get_time();
+    record_drift(m.freq_ppb, m.freq_trained);
+    if (!m.valid) {
+        return;
+    }
+    int64_t utc = model_eval(&m, mono);
+    sys_sync(utc);
+    rtc_time.sleep_utc_us = utc;
+    rtc_time.sleep_sys_us = sys_now_us();
+    rtc_time.sleep_acc_us = model_unc(&m, mono);
+    rtc_time.asleep = 1;
+    record_seal();
+}
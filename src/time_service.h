@@ -0,0 +1,158 @@
+/**
+ * @file      time_service.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Unified timebase: a 64-bit microsecond UTC clock disciplined from
+ *            GPS (and PPS), NITZ, SNTP, HTTP and the RTC
+ */
+
+#ifndef TIME_SERVICE_H
+#define TIME_SERVICE_H
+
+#include <Arduino.h>
+
+/**
+ * One clock for every subsystem: time_now_us() is UTC in microseconds,
+ * read lock-free from esp_timer (the 40 MHz crystal) through a linear
+ * model, so it costs a timer read and a multiply.
+ *
+ * Sources hand in samples, "at esp_timer m it was UTC u, give or take a".
+ * A sample is taken only if it beats what the model already knows, its
+ * accuracy at the anchor grown by TIME_FREQ_UNC_PPB (TIME_FREQ_TRAINED_PPB
+ * once the crystal's error is learned) since. By accuracy that is:
+ *   GPS PPS edge, paired with the time message that follows it    ~10 us
+ *   SNTP, half the round trip plus the server's dispersion         ~10 ms
+ *   GPS time message, UBX or NMEA, on its arrival                  ~250 ms
+ *   NITZ through the modem's clock (AT+CCLK)                       ~1 s
+ *   HTTP Date headers (gps_assist)                                 ~1 s
+ *   RTC after deep sleep, from the sleep-time UTC and its drift    ~ms per min
+ *
+ * The clock never runs backwards for small errors: an offset under
+ * TIME_STEP_BACK_US is slewed out at 1/2048 (about 490 ppm), forward
+ * offsets over TIME_SLEW_MAX_US are stepped. Samples spaced far enough
+ * apart for their accuracy train the crystal's frequency error; samples
+ * after a deep sleep train the RTC slow clock's. Both persist in RTC
+ * memory. The system clock (time(), gettimeofday(), getLocalTime()) is
+ * set from the model on every accepted sample.
+ *
+ * Existing millis() stamps (Event, log records, LoRa packets) convert
+ * with time_from_millis() for as long as they are under 49 days old.
+ *
+ * Config section "time": ntp (server, empty for none), ntp_interval_min,
+ * nitz, pps.
+ */
+
+#define TIME_VALID_S                1735689600  // 2025-01-01; the clock reads below this until set
+#define TIME_SLEW_SHIFT             11          // Slew rate 2^-11
+#define TIME_SLEW_MAX_US            100000      // Later than this is stepped forward
+#define TIME_STEP_BACK_US           2000000     // Earlier than this is stepped back
+#define TIME_FREQ_MAX_PPB           200000
+#define TIME_FREQ_UNC_PPB           40000       // Crystal before training
+#define TIME_FREQ_TRAINED_PPB       2000
+#define TIME_FREQ_GOOD_PPB          1000        // Pair accuracy over spacing to train on
+#define TIME_FREQ_GAIN_SHIFT        2           // Each training sample moves a quarter of the way
+#define TIME_RTC_UNC_PPB            1000000     // RC slow clock before training
+#define TIME_RTC_TRAINED_PPB        100000
+#define TIME_RTC_BOOT_ACC_US        1000000     // System clock kept through a reset
+#define TIME_RTC_GOOD_PPB           10000       // Pair accuracy over the sleep to train on
+#define TIME_SYS_TOLERANCE_US       1000        // System clock left alone within this of the model
+#define TIME_PPS_ACC_US             5           // Edge interrupt latency, on top of the receiver's tAcc
+#define TIME_PPS_JITTER_US          1000        // Edges further than this from 1 s apart are not trusted
+#define TIME_GPS_LATENCY_US         250000      // A time message arrives this long after its second, give or take
+#define TIME_GPS_ACC_US             250000
+#define TIME_NITZ_ACC_US            1000000
+#define TIME_HTTP_ACC_US            1000000
+#define TIME_NTP_SERVER             "pool.ntp.org"
+#define TIME_NTP_INTERVAL_MIN       60
+#define TIME_NTP_WANT_US            50000       // Not worth asking NTP when better than this
+#define TIME_NTP_TIMEOUT_MS         2000
+#define TIME_NTP_TRIES              3           // The one with the shortest round trip is used
+#define TIME_NITZ_WANT_US           2000000
+#define TIME_CHECK_MS               (5 * 60 * 1000)
+#define TIME_TASK_STACK             (1024 * 4)
+#define TIME_TASK_PRIORITY          (tskIDLE_PRIORITY + 1)
+
+enum TimeSource : uint8_t {
+    TIME_SRC_NONE = 0,
+    TIME_SRC_RTC,
+    TIME_SRC_HTTP,
+    TIME_SRC_NITZ,
+    TIME_SRC_NTP,
+    TIME_SRC_GPS,
+    TIME_SRC_PPS,
+    TIME_SRC_COUNT,
+};
+
+struct TimeStats {
+    uint32_t samples[TIME_SRC_COUNT];   // Accepted, per source
+    uint32_t rejected;                  // No better than the model
+    uint32_t steps;
+    uint32_t back_steps;
+    uint32_t freq_trained;              // Training samples, crystal
+    uint32_t rtc_trained;               // Training samples, slow clock
+    int32_t freq_ppb;                   // Crystal error being corrected
+    int32_t rtc_ppb;                    // Slow clock error being corrected
+    int32_t last_offset_us;             // Of the last accepted sample, saturated
+    uint8_t source;                     // Of the last accepted sample
+};
+
+/**
+ * @brief Pick up the clock kept through deep sleep or a reset. Early in
+ *        setup(), before anything stamps time
+ */
+bool time_service_begin();
+
+/**
+ * @brief Start SNTP and NITZ; after the network manager
+ */
+bool time_service_start_sync();
+
+/**
+ * @brief Save the clock and its drift for the wake; before deep sleep
+ */
+void time_service_prepare_sleep();
+
+/**
+ * @brief Offer a sample
+ * @param utc_us  UTC at mono_us, microseconds since 1970
+ * @param mono_us esp_timer_get_time() at that instant
+ * @return true if the clock took it
+ */
+bool time_feed(TimeSource source, int64_t utc_us, int64_t mono_us, uint32_t acc_us);
+
+/**
+ * @brief UTC in microseconds; microseconds since boot until a source is in,
+ *        which time_valid() tells apart
+ */
+int64_t time_now_us();
+uint32_t time_now_s();
+bool time_valid();
+
+/**
+ * @brief Current accuracy, UINT32_MAX while unset
+ */
+uint32_t time_accuracy_us();
+
+/**
+ * @brief UTC of an esp_timer reading, or of a millis() stamp
+ */
+int64_t time_at_mono_us(int64_t mono_us);
+int64_t time_from_millis(uint32_t ms);
+
+/**
+ * @brief Seconds since 1970 of a UTC calendar time
+ */
+int64_t time_make_utc(int year, int month, int day, int hour, int minute, int second);
+
+/**
+ * @brief "2025-01-11T12:34:56.789Z"; returns the length, 0 if len is short
+ */
+size_t time_format_iso(int64_t utc_us, char *buf, size_t len);
+
+const char *time_source_name(uint8_t source);
+
+void time_get_stats(TimeStats *stats);
+
+#endif // TIME_SERVICE_H
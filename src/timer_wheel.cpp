@@ -0,0 +1,236 @@
+/**
+ * @file      timer_wheel.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Hierarchical timer wheel: slot lists, occupancy bitmaps, cascading on the timer task
+ */
+
+#include "timer_wheel.h"
+#include <esp_timer.h>
+#include "simple_logger.h"
+
+#define WHEEL_MASK          (TIMER_WHEEL_SLOTS - 1)
+// Level 3 must never wrap onto its current slot
+#define WHEEL_MAX_TICKS     ((1UL << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS)) - \
+                             (1UL << (TIMER_WHEEL_BITS * (TIMER_WHEEL_LEVELS - 1))) - 1)
+
+static WheelTimer *wheel_slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+static uint64_t wheel_occupied[TIMER_WHEEL_LEVELS];
+static uint32_t wheel_now = 0;              // Tick the wheel has turned to
+static uint32_t wheel_count = 0;
+static TaskHandle_t wheel_task_handle = NULL;
+static portMUX_TYPE wheel_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static inline uint32_t now_tick() {
+    return (uint32_t)(esp_timer_get_time() / (TIMER_WHEEL_TICK_MS * 1000ULL));
+}
+
+static inline uint32_t ms_to_ticks(uint32_t ms) {
+    return (ms + TIMER_WHEEL_TICK_MS - 1) / TIMER_WHEEL_TICK_MS;
+}
+
+// ===== Slots, under wheel_mux =====
+
+// Into the lowest level whose span reaches the expiry
+static void place(WheelTimer *t) {
+    uint32_t delta = t->expires - wheel_now;
+    if (delta > WHEEL_MAX_TICKS) {
+        t->expires = wheel_now + WHEEL_MAX_TICKS;
+    }
+    uint8_t level = 0;
+    while (level < TIMER_WHEEL_LEVELS - 1 &&
+           (t->expires >> (TIMER_WHEEL_BITS * level)) - (wheel_now >> (TIMER_WHEEL_BITS * level)) >= TIMER_WHEEL_SLOTS) {
+        level++;
+    }
+    uint8_t slot = (t->expires >> (TIMER_WHEEL_BITS * level)) & WHEEL_MASK;
+    t->level = level;
+    t->slot = slot;
+    t->prev = NULL;
+    t->next = wheel_slots[level][slot];
+    if (t->next) {
+        t->next->prev = t;
+    }
+    wheel_slots[level][slot] = t;
+    wheel_occupied[level] |= 1ULL << slot;
+}
+
+static void unlink(WheelTimer *t) {
+    if (t->prev) {
+        t->prev->next = t->next;
+    } else {
+        wheel_slots[t->level][t->slot] = t->next;
+    }
+    if (t->next) {
+        t->next->prev = t->prev;
+    }
+    if (!wheel_slots[t->level][t->slot]) {
+        wheel_occupied[t->level] &= ~(1ULL << t->slot);
+    }
+    t->next = t->prev = NULL;
+}
+
+// First tick something happens: a level 0 expiry or a higher slot moving down
+static bool next_event(uint32_t *tick) {
+    bool any = false;
+    uint32_t best = 0;
+    for (uint8_t level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+        uint64_t bits = wheel_occupied[level];
+        if (!bits) {
+            continue;
+        }
+        uint8_t shift = TIMER_WHEEL_BITS * level;
+        uint8_t cur = (wheel_now >> shift) & WHEEL_MASK;
+        uint64_t rotated = cur ? (bits >> cur) | (bits << (64 - cur)) : bits;
+        uint32_t ahead = __builtin_ctzll(rotated);
+        uint32_t at = level ? ((wheel_now >> shift) + ahead) << shift : wheel_now + ahead;
+        if (!any || (int32_t)(at - best) < 0) {
+            best = at;
+            any = true;
+        }
+    }
+    *tick = best;
+    return any;
+}
+
+// Turn to tick: slots reaching it move down a level, highest first
+static void turn_to(uint32_t tick) {
+    wheel_now = tick;
+    for (uint8_t level = TIMER_WHEEL_LEVELS - 1; level > 0; level--) {
+        uint8_t shift = TIMER_WHEEL_BITS * level;
+        if (tick & ((1UL << shift) - 1)) {
+            continue;
+        }
+        uint8_t slot = (tick >> shift) & WHEEL_MASK;
+        WheelTimer *t = wheel_slots[level][slot];
+        wheel_slots[level][slot] = NULL;
+        wheel_occupied[level] &= ~(1ULL << slot);
+        while (t) {
+            WheelTimer *next = t->next;
+            place(t);
+            t = next;
+        }
+    }
+}
+
+// ===== Task =====
+
+static void wheel_task(void *param) {
+    while (1) {
+        uint32_t now = now_tick();
+        uint32_t next;
+        portENTER_CRITICAL(&wheel_mux);
+        while (next_event(&next) && (int32_t)(next - now) <= 0) {
+            turn_to(next);
+            WheelTimer *t;
+            // One at a time: a callback may cancel or re-arm any timer
+            while ((t = wheel_slots[0][next & WHEEL_MASK]) != NULL) {
+                unlink(t);
+                t->fired++;
+                if (t->period_ms) {
+                    uint32_t period = ms_to_ticks(t->period_ms);
+                    t->expires += period;
+                    if ((int32_t)(t->expires - now) <= 0) {
+                        t->expires = now + period;      // Fell behind: no catch-up burst
+                    }
+                    place(t);
+                } else {
+                    t->armed = false;
+                    wheel_count--;
+                }
+                wheel_timer_fn fn = t->fn;
+                portEXIT_CRITICAL(&wheel_mux);
+                fn(t);
+                portENTER_CRITICAL(&wheel_mux);
+            }
+        }
+        // Nothing is due before next, so skipping the empty ticks is safe
+        if ((int32_t)(now - wheel_now) > 0) {
+            wheel_now = now;
+        }
+        bool any = next_event(&next);
+        portEXIT_CRITICAL(&wheel_mux);
+
+        TickType_t wait = any ? pdMS_TO_TICKS((next - now) * TIMER_WHEEL_TICK_MS) : portMAX_DELAY;
+        ulTaskNotifyTake(pdTRUE, wait ? wait : 1);
+    }
+}
+
+// ===== API =====
+
+bool timer_wheel_begin() {
+    if (wheel_task_handle) {
+        return true;
+    }
+    portENTER_CRITICAL(&wheel_mux);
+    wheel_now = now_tick();
+    portEXIT_CRITICAL(&wheel_mux);
+    if (xTaskCreate(wheel_task, "timers", TIMER_WHEEL_TASK_STACK, NULL, TIMER_WHEEL_TASK_PRIORITY,
+                    &wheel_task_handle) != pdPASS) {
+        LOG_ERROR("Timers", "Failed to start the timer task");
+        return false;
+    }
+    return true;
+}
+
+void timer_wheel_init(WheelTimer *timer, const char *name, wheel_timer_fn fn, void *ctx) {
+    memset(timer, 0, sizeof(*timer));
+    timer->name = name;
+    timer->fn = fn;
+    timer->ctx = ctx;
+}
+
+void timer_wheel_arm(WheelTimer *timer, uint32_t delay_ms, uint32_t period_ms) {
+    if (!wheel_task_handle && !timer_wheel_begin()) {
+        return;
+    }
+    uint32_t now = now_tick();
+    portENTER_CRITICAL(&wheel_mux);
+    if (timer->armed) {
+        unlink(timer);
+    } else {
+        wheel_count++;
+    }
+    timer->period_ms = period_ms;
+    timer->expires = now + ms_to_ticks(delay_ms);
+    // The slot the wheel stands on has already run
+    if ((int32_t)(timer->expires - wheel_now) <= 0) {
+        timer->expires = wheel_now + 1;
+    }
+    place(timer);
+    timer->armed = true;
+    portEXIT_CRITICAL(&wheel_mux);
+    xTaskNotifyGive(wheel_task_handle);
+}
+
+void timer_wheel_cancel(WheelTimer *timer) {
+    portENTER_CRITICAL(&wheel_mux);
+    if (timer->armed) {
+        unlink(timer);
+        timer->armed = false;
+        wheel_count--;
+    }
+    portEXIT_CRITICAL(&wheel_mux);
+}
+
+bool timer_wheel_armed(const WheelTimer *timer) {
+    return timer->armed;
+}
+
+uint32_t timer_wheel_next_ms() {
+    uint32_t now = now_tick();
+    uint32_t next;
+    portENTER_CRITICAL(&wheel_mux);
+    bool any = next_event(&next);
+    portEXIT_CRITICAL(&wheel_mux);
+    if (!any) {
+        return UINT32_MAX;
+    }
+    int32_t ticks = (int32_t)(next - now);
+    return ticks > 0 ? ticks * TIMER_WHEEL_TICK_MS : 0;
+}
+
+uint32_t timer_wheel_count() {
+    return wheel_count;
+}
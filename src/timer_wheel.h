@@ -0,0 +1,86 @@
+/**
+ * @file      timer_wheel.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Hierarchical timer wheel: O(1) arm and cancel, one tickless timer task
+ */
+
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <Arduino.h>
+
+/**
+ * Periodic and one-shot work shares one task instead of each module
+ * keeping a last_*_time and checking it against millis(). Timers live in
+ * TIMER_WHEEL_LEVELS wheels of 64 slots; level n slot covers 64^n ticks.
+ * A timer goes into the lowest level its expiry fits, and moves down a
+ * level when the wheel turns to its slot, so arming and cancelling are a
+ * list insert and unlink however many timers there are.
+ *
+ * Tickless: the task works out the next occupied slot from each level's
+ * occupancy bitmap and sleeps until then, jumping over empty ticks. The
+ * same figure is timer_wheel_next_ms(), which light sleep decisions use
+ * so they do not oversleep a deadline.
+ *
+ * Callbacks run on the timer task one after another: keep them short or
+ * hand the work to the owning task. A timer may re-arm or cancel itself,
+ * or any other timer, from its callback. Timers are intrusive and owned
+ * by the caller; they must stay valid while armed. Ticks are
+ * TIMER_WHEEL_TICK_MS, so a deadline fires up to one tick late, and
+ * delays are capped at about 46 hours.
+ *
+ * LVGL's lv_timer stays with the LVGL task, which it has to run on.
+ */
+
+#define TIMER_WHEEL_TICK_MS         10
+#define TIMER_WHEEL_BITS            6       // 64 slots per level
+#define TIMER_WHEEL_SLOTS           (1 << TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_LEVELS          4       // 2^24 ticks
+#define TIMER_WHEEL_TASK_STACK      (1024 * 4)
+#define TIMER_WHEEL_TASK_PRIORITY   (tskIDLE_PRIORITY + 3)
+
+struct WheelTimer;
+typedef void (*wheel_timer_fn)(WheelTimer *timer);
+
+struct WheelTimer {
+    const char *name;
+    wheel_timer_fn fn;
+    void *ctx;
+    uint32_t period_ms;             // 0: one-shot
+
+    // Wheel state
+    WheelTimer *next;
+    WheelTimer *prev;
+    uint32_t expires;               // Tick
+    uint8_t level;
+    uint8_t slot;
+    bool armed;
+    uint32_t fired;
+};
+
+bool timer_wheel_begin();
+
+/**
+ * @brief Set up a timer; does not arm it
+ */
+void timer_wheel_init(WheelTimer *timer, const char *name, wheel_timer_fn fn, void *ctx = NULL);
+
+/**
+ * @brief Fire after delay_ms, then every period_ms if that is not 0.
+ *        Re-arming an armed timer moves it. Safe from any task
+ */
+void timer_wheel_arm(WheelTimer *timer, uint32_t delay_ms, uint32_t period_ms = 0);
+void timer_wheel_cancel(WheelTimer *timer);
+bool timer_wheel_armed(const WheelTimer *timer);
+
+/**
+ * @brief Time to the earliest deadline, UINT32_MAX with nothing armed
+ */
+uint32_t timer_wheel_next_ms();
+
+uint32_t timer_wheel_count();
+
+#endif // TIMER_WHEEL_H
@@ -0,0 +1,496 @@
+/**
+ * @file      tls_client.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     mbedTLS over a lwIP socket, session cache in RAM, RTC and NVS
+ */
+
+#include "tls_client.h"
+#include <LittleFS.h>
+#include <Preferences.h>
+#include <esp_attr.h>
+#include <esp_heap_caps.h>
+#include <esp_rom_crc.h>
+#include <mbedtls/net_sockets.h>
+#include <mbedtls/error.h>
+#include "simple_logger.h"
+
+RTC_NOINIT_ATTR static TlsSessionRecord rtc_session;
+
+struct TlsCacheSlot {
+    uint32_t host_key;
+    uint32_t used;                  // millis() of the last store, for eviction
+    uint16_t len;
+    uint8_t *data;                  // TLS_SESSION_MAX, PSRAM
+};
+
+// Hardware AES-GCM and P-256 first; anything else the build has after that
+static const int tls_suites[] = {
+    MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256,
+    MBEDTLS_TLS_ECDHE_RSA_WITH_AES_128_GCM_SHA256,
+    MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_256_GCM_SHA384,
+    MBEDTLS_TLS_ECDHE_RSA_WITH_AES_256_GCM_SHA384,
+    MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_CBC_SHA256,
+    MBEDTLS_TLS_ECDHE_RSA_WITH_AES_128_CBC_SHA256,
+    MBEDTLS_TLS_RSA_WITH_AES_128_GCM_SHA256,
+    MBEDTLS_TLS_RSA_WITH_AES_128_CBC_SHA256,
+    0
+};
+
+static const mbedtls_ecp_group_id tls_curves[] = {
+    MBEDTLS_ECP_DP_SECP256R1,
+    MBEDTLS_ECP_DP_SECP384R1,
+    MBEDTLS_ECP_DP_NONE
+};
+
+static portMUX_TYPE tls_mux = portMUX_INITIALIZER_UNLOCKED;
+static TlsCacheSlot tls_cache[TLS_SESSION_SLOTS];
+static TlsStats tls_stats;
+
+static uint32_t host_key_of(const char *host, uint16_t port) {
+    char key[80];
+    int n = snprintf(key, sizeof(key), "%s:%u", host, port);
+    return esp_rom_crc32_le(0, (const uint8_t *)key, min(n, (int)sizeof(key) - 1));
+}
+
+static uint32_t record_crc(const TlsSessionRecord *r) {
+    uint32_t crc = esp_rom_crc32_le(0, (const uint8_t *)r, offsetof(TlsSessionRecord, data));
+    return esp_rom_crc32_le(crc, r->data, min(r->len, (uint16_t)TLS_SESSION_MAX));
+}
+
+static bool record_valid(const TlsSessionRecord *r) {
+    return r->magic == TLS_SESSION_MAGIC && r->len <= TLS_SESSION_MAX && r->crc == record_crc(r);
+}
+
+// ===== Session cache =====
+
+// RAM first, then RTC (deep sleep), then NVS (cold boot)
+static size_t cache_load(uint32_t key, bool persistent, uint8_t *out) {
+    size_t len = 0;
+    portENTER_CRITICAL(&tls_mux);
+    for (int i = 0; i < TLS_SESSION_SLOTS; i++) {
+        if (tls_cache[i].data && tls_cache[i].len && tls_cache[i].host_key == key) {
+            len = tls_cache[i].len;
+            memcpy(out, tls_cache[i].data, len);
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&tls_mux);
+    if (len || !persistent) {
+        return len;
+    }
+
+    if (record_valid(&rtc_session) && rtc_session.host_key == key) {
+        memcpy(out, rtc_session.data, rtc_session.len);
+        return rtc_session.len;
+    }
+    Preferences prefs;
+    if (!prefs.begin(TLS_NVS_NAMESPACE, true)) {
+        return 0;
+    }
+    if (prefs.getBytes("session", &rtc_session, sizeof(rtc_session)) == sizeof(rtc_session) &&
+        record_valid(&rtc_session) && rtc_session.host_key == key) {
+        len = rtc_session.len;
+        memcpy(out, rtc_session.data, len);
+    }
+    prefs.end();
+    return len;
+}
+
+static void cache_store(uint32_t key, const uint8_t *data, size_t len, bool persistent, bool full) {
+    int slot = 0;
+    portENTER_CRITICAL(&tls_mux);
+    for (int i = 0; i < TLS_SESSION_SLOTS; i++) {
+        if (tls_cache[i].host_key == key) {
+            slot = i;
+            break;
+        }
+        if (tls_cache[i].used < tls_cache[slot].used) {
+            slot = i;
+        }
+    }
+    portEXIT_CRITICAL(&tls_mux);
+
+    TlsCacheSlot &s = tls_cache[slot];
+    if (!s.data) {
+        uint8_t *buf = (uint8_t *)heap_caps_malloc(TLS_SESSION_MAX, MALLOC_CAP_SPIRAM);
+        if (!buf) {
+            buf = (uint8_t *)malloc(TLS_SESSION_MAX);
+        }
+        if (!buf) {
+            return;
+        }
+        s.data = buf;
+    }
+    portENTER_CRITICAL(&tls_mux);
+    s.host_key = key;
+    s.used = millis() | 1;
+    s.len = len;
+    memcpy(s.data, data, len);
+    portEXIT_CRITICAL(&tls_mux);
+
+    if (!persistent) {
+        return;
+    }
+    rtc_session.magic = TLS_SESSION_MAGIC;
+    rtc_session.host_key = key;
+    rtc_session.len = len;
+    memcpy(rtc_session.data, data, len);
+    rtc_session.crc = record_crc(&rtc_session);
+
+    // Flash is only written after a full handshake, not per resume
+    if (full) {
+        Preferences prefs;
+        if (prefs.begin(TLS_NVS_NAMESPACE, false)) {
+            prefs.putBytes("session", &rtc_session, sizeof(rtc_session));
+            prefs.end();
+        }
+    }
+}
+
+static void cache_forget(uint32_t key) {
+    portENTER_CRITICAL(&tls_mux);
+    for (int i = 0; i < TLS_SESSION_SLOTS; i++) {
+        if (tls_cache[i].host_key == key) {
+            tls_cache[i].len = 0;
+        }
+    }
+    if (rtc_session.host_key == key) {
+        rtc_session.magic = 0;
+    }
+    portEXIT_CRITICAL(&tls_mux);
+}
+
+// ===== Socket glue =====
+
+static int bio_send(void *ctx, const unsigned char *buf, size_t len) {
+    WiFiClient *sock = (WiFiClient *)ctx;
+    size_t n = sock->write(buf, len);
+    if (n > 0) {
+        return n;
+    }
+    return sock->connected() ? MBEDTLS_ERR_SSL_WANT_WRITE : MBEDTLS_ERR_NET_SEND_FAILED;
+}
+
+static int bio_recv(void *ctx, unsigned char *buf, size_t len) {
+    WiFiClient *sock = (WiFiClient *)ctx;
+    int avail = sock->available();
+    if (avail <= 0) {
+        return sock->connected() ? MBEDTLS_ERR_SSL_WANT_READ : MBEDTLS_ERR_NET_CONN_RESET;
+    }
+    int n = sock->read(buf, min(len, (size_t)avail));
+    return n > 0 ? n : MBEDTLS_ERR_SSL_WANT_READ;
+}
+
+// ===== TlsClient =====
+
+TlsClient::TlsClient() {
+    mbedtls_ssl_init(&ssl);
+    mbedtls_ssl_config_init(&conf);
+    mbedtls_ctr_drbg_init(&drbg);
+    mbedtls_entropy_init(&entropy);
+    mbedtls_x509_crt_init(&ca);
+}
+
+TlsClient::~TlsClient() {
+    stop();
+    mbedtls_ssl_free(&ssl);
+    mbedtls_ssl_config_free(&conf);
+    mbedtls_ctr_drbg_free(&drbg);
+    mbedtls_entropy_free(&entropy);
+    mbedtls_x509_crt_free(&ca);
+    free(ca_pem);
+}
+
+void TlsClient::setCACert(const char *pem) {
+    free(ca_pem);
+    ca_pem = pem ? strdup(pem) : nullptr;
+    configured = false;
+}
+
+bool TlsClient::setCACertFile(const char *path) {
+    File f = LittleFS.open(path, FILE_READ);
+    if (!f || f.size() == 0 || f.size() > TLS_CA_MAX) {
+        LOG_WARNF("TLS", "Cannot read CA bundle %s", path);
+        return false;
+    }
+    char *pem = (char *)malloc(f.size() + 1);
+    if (!pem) {
+        return false;
+    }
+    pem[f.read((uint8_t *)pem, f.size())] = '\0';
+    f.close();
+    free(ca_pem);
+    ca_pem = pem;
+    configured = false;
+    return true;
+}
+
+void TlsClient::setInsecure() {
+    setCACert(nullptr);
+}
+
+// Everything that does not change between connections is set up once
+bool TlsClient::configure() {
+    if (configured) {
+        return true;
+    }
+    if (ssl_ready) {
+        mbedtls_ssl_free(&ssl);
+        mbedtls_ssl_init(&ssl);
+        ssl_ready = false;
+    }
+    mbedtls_ssl_config_free(&conf);
+    mbedtls_ssl_config_init(&conf);
+    mbedtls_x509_crt_free(&ca);
+    mbedtls_x509_crt_init(&ca);
+
+    static const char pers[] = "tdeckpro-tls";
+    int r = 0;
+    if (!seeded) {
+        r = mbedtls_ctr_drbg_seed(&drbg, mbedtls_entropy_func, &entropy, (const uint8_t *)pers, sizeof(pers) - 1);
+        seeded = r == 0;
+    }
+    if (r == 0) {
+        r = mbedtls_ssl_config_defaults(&conf, MBEDTLS_SSL_IS_CLIENT, MBEDTLS_SSL_TRANSPORT_STREAM,
+                                        MBEDTLS_SSL_PRESET_DEFAULT);
+    }
+    if (r != 0) {
+        return fail("setup", r);
+    }
+    if (ca_pem) {
+        r = mbedtls_x509_crt_parse(&ca, (const uint8_t *)ca_pem, strlen(ca_pem) + 1);
+        if (r != 0) {
+            return fail("CA bundle", r);
+        }
+        mbedtls_ssl_conf_ca_chain(&conf, &ca, nullptr);
+        mbedtls_ssl_conf_authmode(&conf, MBEDTLS_SSL_VERIFY_REQUIRED);
+    } else {
+        mbedtls_ssl_conf_authmode(&conf, MBEDTLS_SSL_VERIFY_NONE);
+    }
+    mbedtls_ssl_conf_rng(&conf, mbedtls_ctr_drbg_random, &drbg);
+    mbedtls_ssl_conf_ciphersuites(&conf, tls_suites);
+    mbedtls_ssl_conf_curves(&conf, tls_curves);
+    mbedtls_ssl_conf_session_tickets(&conf, MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+    configured = true;
+    return true;
+}
+
+bool TlsClient::fail(const char *what, int err) {
+    char msg[96];
+    mbedtls_strerror(err, msg, sizeof(msg));
+    LOG_WARNF("TLS", "%s: %s (-0x%04x)", what, msg, -err);
+    return false;
+}
+
+int TlsClient::connect(IPAddress ip, uint16_t port) {
+    return connect(ip.toString().c_str(), port, TLS_HANDSHAKE_TIMEOUT_MS);
+}
+
+int TlsClient::connect(IPAddress ip, uint16_t port, int32_t timeout_ms) {
+    return connect(ip.toString().c_str(), port, timeout_ms);
+}
+
+int TlsClient::connect(const char *host, uint16_t port) {
+    return connect(host, port, TLS_HANDSHAKE_TIMEOUT_MS);
+}
+
+int TlsClient::connect(const char *host, uint16_t port, int32_t timeout_ms) {
+    stop();
+    uint32_t start = millis();
+    if (!configure() || !sock.connect(host, port, timeout_ms)) {
+        return 0;
+    }
+    int r = ssl_ready ? mbedtls_ssl_session_reset(&ssl) : mbedtls_ssl_setup(&ssl, &conf);
+    ssl_ready = ssl_ready || r == 0;
+    if (r == 0) {
+        r = mbedtls_ssl_set_hostname(&ssl, host);
+    }
+    if (r != 0) {
+        sock.stop();
+        return fail("setup", r);
+    }
+    mbedtls_ssl_set_bio(&ssl, &sock, bio_send, bio_recv, nullptr);
+
+    // Offer the last session with this host
+    host_key = host_key_of(host, port);
+    mbedtls_ssl_session offered;
+    mbedtls_ssl_session_init(&offered);
+    bool offering = false;
+    uint8_t *buf = (uint8_t *)malloc(TLS_SESSION_MAX);
+    if (buf) {
+        size_t len = cache_load(host_key, persistent, buf);
+        offering = len && mbedtls_ssl_session_load(&offered, buf, len) == 0 &&
+                   mbedtls_ssl_set_session(&ssl, &offered) == 0;
+    }
+
+    while ((r = mbedtls_ssl_handshake(&ssl)) != 0) {
+        if ((r != MBEDTLS_ERR_SSL_WANT_READ && r != MBEDTLS_ERR_SSL_WANT_WRITE) ||
+            (int32_t)(millis() - start) > timeout_ms) {
+            break;
+        }
+        vTaskDelay(pdMS_TO_TICKS(2));
+    }
+    handshake_ms = millis() - start;
+    if (r != 0) {
+        // A session the server chokes on is not offered again
+        if (offering) {
+            cache_forget(host_key);
+        }
+        mbedtls_ssl_session_free(&offered);
+        free(buf);
+        sock.stop();
+        portENTER_CRITICAL(&tls_mux);
+        tls_stats.failures++;
+        portEXIT_CRITICAL(&tls_mux);
+        return fail(host, r);
+    }
+
+    // Resumed: same master secret as the session offered
+    was_resumed = offering && !memcmp(ssl.session->master, offered.master, sizeof(offered.master));
+    mbedtls_ssl_session_free(&offered);
+    if (buf) {
+        mbedtls_ssl_session session;
+        mbedtls_ssl_session_init(&session);
+        size_t len = 0;
+        if (mbedtls_ssl_get_session(&ssl, &session) == 0 &&
+            mbedtls_ssl_session_save(&session, buf, TLS_SESSION_MAX, &len) == 0) {
+            cache_store(host_key, buf, len, persistent, !was_resumed);
+        }
+        mbedtls_ssl_session_free(&session);
+        free(buf);
+    }
+
+    portENTER_CRITICAL(&tls_mux);
+    tls_stats.handshakes++;
+    tls_stats.last_handshake_ms = handshake_ms;
+    if (was_resumed) {
+        tls_stats.resumed++;
+        tls_stats.resumed_ms = handshake_ms;
+    } else {
+        tls_stats.full_ms = handshake_ms;
+    }
+    portEXIT_CRITICAL(&tls_mux);
+    LOG_DEBUGF("TLS", "%s:%u %s handshake in %lums, %s", host, port, was_resumed ? "resumed" : "full",
+               (unsigned long)handshake_ms, mbedtls_ssl_get_ciphersuite(&ssl));
+    up = true;
+    peeked = -1;
+    return 1;
+}
+
+size_t TlsClient::write(uint8_t b) {
+    return write(&b, 1);
+}
+
+size_t TlsClient::write(const uint8_t *buf, size_t size) {
+    size_t done = 0;
+    uint32_t start = millis();
+    while (up && done < size) {
+        int r = mbedtls_ssl_write(&ssl, buf + done, size - done);
+        if (r > 0) {
+            done += r;
+        } else if ((r == MBEDTLS_ERR_SSL_WANT_WRITE || r == MBEDTLS_ERR_SSL_WANT_READ) &&
+                   millis() - start < TLS_HANDSHAKE_TIMEOUT_MS) {
+            vTaskDelay(1);
+        } else {
+            stop();
+        }
+    }
+    return done;
+}
+
+int TlsClient::available() {
+    if (!up) {
+        return 0;
+    }
+    // A zero-length read pulls in the next record, if one arrived
+    int r = mbedtls_ssl_read(&ssl, nullptr, 0);
+    if (r < 0 && r != MBEDTLS_ERR_SSL_WANT_READ && r != MBEDTLS_ERR_SSL_WANT_WRITE) {
+        stop();
+        return peeked >= 0 ? 1 : 0;
+    }
+    return mbedtls_ssl_get_bytes_avail(&ssl) + (peeked >= 0 ? 1 : 0);
+}
+
+int TlsClient::read() {
+    uint8_t b;
+    return read(&b, 1) == 1 ? b : -1;
+}
+
+int TlsClient::read(uint8_t *buf, size_t size) {
+    if (!size) {
+        return 0;
+    }
+    int got = 0;
+    if (peeked >= 0) {
+        buf[got++] = peeked;
+        peeked = -1;
+        if (got == (int)size) {
+            return got;
+        }
+    }
+    if (!up) {
+        return got ? got : -1;
+    }
+    int r = mbedtls_ssl_read(&ssl, buf + got, size - got);
+    if (r > 0) {
+        return got + r;
+    }
+    if (r != MBEDTLS_ERR_SSL_WANT_READ && r != MBEDTLS_ERR_SSL_WANT_WRITE) {
+        stop();                     // Close notify, EOF or an error
+    }
+    return got ? got : -1;
+}
+
+int TlsClient::peek() {
+    if (peeked < 0) {
+        uint8_t b;
+        if (read(&b, 1) == 1) {
+            peeked = b;
+        }
+    }
+    return peeked;
+}
+
+void TlsClient::flush() {
+    sock.flush();
+}
+
+void TlsClient::stop() {
+    if (up) {
+        mbedtls_ssl_close_notify(&ssl);
+        up = false;
+    }
+    sock.stop();
+}
+
+uint8_t TlsClient::connected() {
+    if (up && !sock.connected() && !mbedtls_ssl_get_bytes_avail(&ssl)) {
+        up = false;
+    }
+    return up || peeked >= 0;
+}
+
+// ===== API =====
+
+void tls_get_stats(TlsStats *out) {
+    portENTER_CRITICAL(&tls_mux);
+    *out = tls_stats;
+    portEXIT_CRITICAL(&tls_mux);
+}
+
+void tls_forget_sessions() {
+    portENTER_CRITICAL(&tls_mux);
+    for (int i = 0; i < TLS_SESSION_SLOTS; i++) {
+        tls_cache[i].len = 0;
+    }
+    rtc_session.magic = 0;
+    portEXIT_CRITICAL(&tls_mux);
+    Preferences prefs;
+    if (prefs.begin(TLS_NVS_NAMESPACE, false)) {
+        prefs.remove("session");
+        prefs.end();
+    }
+}
@@ -0,0 +1,127 @@
+/**
+ * @file      tls_client.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     TLS client socket with session resumption that outlives sleep
+ */
+
+#ifndef TLS_CLIENT_H
+#define TLS_CLIENT_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <mbedtls/ssl.h>
+#include <mbedtls/ctr_drbg.h>
+#include <mbedtls/entropy.h>
+#include <mbedtls/x509_crt.h>
+
+/**
+ * A WiFiClient, so HTTPClient and the MQTT task take it as is, over any
+ * link lwIP routes (WiFi, or 4G through PPP). mbedTLS runs on the
+ * ESP32-S3 AES, SHA and bignum units through the IDF port; the suite list
+ * puts the AES-GCM and P-256 ones those speed up first.
+ *
+ * After each handshake the session (ticket or ID) is kept per host and
+ * offered on the next connect, so a reconnect is one round trip instead
+ * of a full handshake. Sessions of persistent clients (the MQTT broker)
+ * also go to RTC memory, which survives deep sleep, and after a full
+ * handshake to NVS for cold boots.
+ */
+
+#define TLS_SESSION_MAX             2048    // Serialized session, peer certificate included
+#define TLS_SESSION_SLOTS           4       // Hosts remembered in RAM
+#define TLS_SESSION_MAGIC           0x53534C54UL  // "TLSS"
+#define TLS_NVS_NAMESPACE           "tls"
+#define TLS_HANDSHAKE_TIMEOUT_MS    15000
+#define TLS_CA_MAX                  8192    // PEM bundle read from a file
+
+// RTC (and NVS) copy of the persistent host's session
+struct TlsSessionRecord {
+    uint32_t magic;
+    uint32_t host_key;              // CRC of "host:port"
+    uint16_t len;
+    uint8_t data[TLS_SESSION_MAX];
+    uint32_t crc;
+};
+
+struct TlsStats {
+    uint32_t handshakes;
+    uint32_t resumed;               // Of those, abbreviated
+    uint32_t failures;
+    uint32_t last_handshake_ms;
+    uint32_t full_ms;               // Last full handshake
+    uint32_t resumed_ms;            // Last resumed one
+};
+
+class TlsClient : public WiFiClient {
+public:
+    TlsClient();
+    ~TlsClient();
+    TlsClient(const TlsClient&) = delete;
+    TlsClient& operator=(const TlsClient&) = delete;
+
+    /**
+     * @brief Verify the server against a PEM bundle (copied). Without one
+     *        nothing is verified, for payloads authenticated on their own
+     */
+    void setCACert(const char *pem);
+    bool setCACertFile(const char *path);   // LittleFS
+    void setInsecure();
+
+    /**
+     * @brief Keep this client's session through deep sleep and power-off
+     */
+    void setPersistent(bool on) { persistent = on; }
+
+    int connect(IPAddress ip, uint16_t port) override;
+    int connect(IPAddress ip, uint16_t port, int32_t timeout_ms) override;
+    int connect(const char *host, uint16_t port) override;
+    int connect(const char *host, uint16_t port, int32_t timeout_ms) override;
+    size_t write(uint8_t b) override;
+    size_t write(const uint8_t *buf, size_t size) override;
+    int available() override;
+    int read() override;
+    int read(uint8_t *buf, size_t size) override;
+    int peek() override;
+    void flush() override;
+    void stop() override;
+    uint8_t connected() override;
+
+    int setNoDelay(bool nodelay) { return sock.setNoDelay(nodelay); }
+
+    // Last connect
+    bool resumed() const { return was_resumed; }
+    uint32_t handshakeMs() const { return handshake_ms; }
+
+private:
+    bool configure();
+    bool fail(const char *what, int err);
+
+    WiFiClient sock;
+    mbedtls_ssl_context ssl;
+    mbedtls_ssl_config conf;
+    mbedtls_ctr_drbg_context drbg;
+    mbedtls_entropy_context entropy;
+    mbedtls_x509_crt ca;
+    char *ca_pem = nullptr;
+    bool seeded = false;
+    bool configured = false;        // conf and ca set up
+    bool ssl_ready = false;         // ssl set up on conf
+    bool up = false;
+    bool persistent = false;
+    bool was_resumed = false;
+    int peeked = -1;
+    uint32_t host_key = 0;
+    uint32_t handshake_ms = 0;
+};
+
+void tls_get_stats(TlsStats *out);
+
+/**
+ * @brief Drop every remembered session, e.g. after the broker's key changed
+ */
+void tls_forget_sessions();
+
+#endif // TLS_CLIENT_H
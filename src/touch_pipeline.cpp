@@ -0,0 +1,142 @@
+/**
+ * @file      touch_pipeline.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Touch sample ring, filter and gesture detector implementation
+ */
+
+#include "touch_pipeline.h"
+
+static_assert((TOUCH_RING_SIZE & (TOUCH_RING_SIZE - 1)) == 0, "TOUCH_RING_SIZE must be a power of two");
+
+TouchPipeline::TouchPipeline() : head(0), tail(0) {
+    pressed = false;
+    point.x = 0;
+    point.y = 0;
+    last_sample_time = 0;
+    release_pending = false;
+    release_time = 0;
+    down_point = point;
+    down_time = 0;
+    moved = false;
+    gesture = TOUCH_GESTURE_NONE;
+    samples = 0;
+    samples_dropped = 0;
+    jitter_suppressed = 0;
+}
+
+bool TouchPipeline::pushSample(int16_t x, int16_t y, bool is_pressed, uint32_t time_ms) {
+    uint16_t h = head.load(std::memory_order_relaxed);
+    uint16_t next = (h + 1) & (TOUCH_RING_SIZE - 1);
+    
+    // Full: drop the new sample, the stale-press poll recovers a lost lift
+    if (next == tail.load(std::memory_order_acquire)) {
+        samples_dropped++;
+        return false;
+    }
+    
+    ring[h].x = x;
+    ring[h].y = y;
+    ring[h].time_ms = time_ms;
+    ring[h].pressed = is_pressed;
+    head.store(next, std::memory_order_release);
+    samples++;
+    return true;
+}
+
+void TouchPipeline::process(uint32_t now) {
+    uint16_t t = tail.load(std::memory_order_relaxed);
+    
+    while (t != head.load(std::memory_order_acquire)) {
+        TouchSample sample = ring[t];
+        t = (t + 1) & (TOUCH_RING_SIZE - 1);
+        tail.store(t, std::memory_order_release);
+        applySample(sample);
+    }
+    
+    if (release_pending && now - release_time >= TOUCH_RELEASE_DEBOUNCE_MS) {
+        finishContact();
+    }
+}
+
+void TouchPipeline::applySample(const TouchSample& sample) {
+    last_sample_time = sample.time_ms;
+    
+    // A lift only counts once no press follows within the debounce window
+    if (!sample.pressed) {
+        if (pressed && !release_pending) {
+            release_pending = true;
+            release_time = sample.time_ms;
+        }
+        return;
+    }
+    
+    // The controller reports 0,0 while it wakes up
+    if (sample.x <= 1 && sample.y <= 1) {
+        return;
+    }
+    
+    release_pending = false;
+    lv_point_t p = {sample.x, sample.y};
+    
+    if (!pressed) {
+        pressed = true;
+        point = p;
+        down_point = p;
+        down_time = sample.time_ms;
+        moved = false;
+        return;
+    }
+    
+    // Dead-band around the reported point keeps a resting finger still
+    if (LV_ABS(p.x - point.x) < TOUCH_JITTER_PX && LV_ABS(p.y - point.y) < TOUCH_JITTER_PX) {
+        jitter_suppressed++;
+        return;
+    }
+    
+    point = p;
+    if (LV_ABS(p.x - down_point.x) > TOUCH_TAP_SLOP_PX || LV_ABS(p.y - down_point.y) > TOUCH_TAP_SLOP_PX) {
+        moved = true;
+    }
+    detectSwipe(p);
+}
+
+void TouchPipeline::detectSwipe(const lv_point_t& p) {
+    lv_coord_t diff_x = down_point.x - p.x;
+    lv_coord_t diff_y = down_point.y - p.y;
+    TouchGesture swipe = TOUCH_GESTURE_NONE;
+    
+    // Vertical travel wins, as in the menu gesture handler this replaces
+    if (diff_y > TOUCH_SWIPE_MIN_PX) {
+        swipe = TOUCH_GESTURE_SWIPE_UP;
+    } else if (diff_y < -TOUCH_SWIPE_MIN_PX) {
+        swipe = TOUCH_GESTURE_SWIPE_DOWN;
+    } else if (diff_x > TOUCH_SWIPE_MIN_PX) {
+        swipe = TOUCH_GESTURE_SWIPE_LEFT;
+    } else if (diff_x < -TOUCH_SWIPE_MIN_PX) {
+        swipe = TOUCH_GESTURE_SWIPE_RIGHT;
+    }
+    
+    // Re-anchor so a long drag can report further swipes
+    if (swipe != TOUCH_GESTURE_NONE) {
+        gesture = swipe;
+        down_point = p;
+    }
+}
+
+void TouchPipeline::finishContact() {
+    pressed = false;
+    release_pending = false;
+    
+    if (!moved && release_time - down_time <= TOUCH_TAP_MAX_MS) {
+        gesture = TOUCH_GESTURE_TAP;
+    }
+}
+
+TouchGesture TouchPipeline::takeGesture() {
+    TouchGesture g = gesture;
+    gesture = TOUCH_GESTURE_NONE;
+    return g;
+}
@@ -0,0 +1,103 @@
+/**
+ * @file      touch_pipeline.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Interrupt-fed touch sample ring, filter and gesture detector
+ */
+
+#ifndef TOUCH_PIPELINE_H
+#define TOUCH_PIPELINE_H
+
+#include <Arduino.h>
+#include <lvgl.h>
+#include <atomic>
+
+// Sample ring between the INT-driven reader and the LVGL read callback
+#define TOUCH_RING_SIZE             16    // Power of two
+
+// Filter
+#define TOUCH_JITTER_PX             3     // Moves below this are held at the last point
+#define TOUCH_RELEASE_DEBOUNCE_MS   20    // Lift must last this long to count
+#define TOUCH_STALE_MS              100   // Poll the chip if a press sees no INT for this long
+
+// Gestures
+#define TOUCH_TAP_SLOP_PX           8     // Largest travel that still counts as a tap
+#define TOUCH_TAP_MAX_MS            300
+#define TOUCH_SWIPE_MIN_PX          15    // Travel that makes a swipe, matches UI_GESTURE_DISTANCE
+
+enum TouchGesture {
+    TOUCH_GESTURE_NONE,
+    TOUCH_GESTURE_TAP,
+    TOUCH_GESTURE_SWIPE_UP,
+    TOUCH_GESTURE_SWIPE_DOWN,
+    TOUCH_GESTURE_SWIPE_LEFT,
+    TOUCH_GESTURE_SWIPE_RIGHT
+};
+
+struct TouchSample {
+    int16_t x;
+    int16_t y;
+    uint32_t time_ms;
+    bool pressed;
+};
+
+/**
+ * @brief Touch Pipeline Class
+ *
+ * The touch INT handler side pushes raw samples; the LVGL read callback
+ * drains them through a release debounce and a jitter dead-band and reads
+ * back one stable pointer state. Taps and swipes are detected on the way.
+ * The ring is single-producer/single-consumer and needs no lock.
+ */
+class TouchPipeline {
+private:
+    TouchSample ring[TOUCH_RING_SIZE];
+    std::atomic<uint16_t> head;     // Next slot the producer writes
+    std::atomic<uint16_t> tail;     // Next slot the consumer reads
+    
+    // Filtered state handed to LVGL
+    bool pressed;
+    lv_point_t point;
+    uint32_t last_sample_time;
+    bool release_pending;           // Raw lift seen, waiting out the debounce
+    uint32_t release_time;
+    
+    // Gesture tracking for the current contact
+    lv_point_t down_point;
+    uint32_t down_time;
+    bool moved;                     // Travel exceeded the tap slop
+    volatile TouchGesture gesture;
+    
+    // Statistics
+    uint32_t samples;
+    uint32_t samples_dropped;
+    uint32_t jitter_suppressed;
+    
+    void applySample(const TouchSample& sample);
+    void detectSwipe(const lv_point_t& p);
+    void finishContact();
+
+public:
+    TouchPipeline();
+    
+    // Producer side
+    bool pushSample(int16_t x, int16_t y, bool pressed, uint32_t time_ms);
+    
+    // Consumer side
+    void process(uint32_t now);
+    bool hasSamples() { return head.load(std::memory_order_acquire) != tail.load(std::memory_order_relaxed); }
+    bool isPressed() { return pressed; }
+    bool isSettled() { return !pressed && !release_pending && !hasSamples(); }
+    bool isStale(uint32_t now) { return pressed && now - last_sample_time >= TOUCH_STALE_MS; }
+    lv_point_t getPoint() { return point; }
+    TouchGesture takeGesture();
+    
+    // Status
+    uint32_t getSamples() { return samples; }
+    uint32_t getSamplesDropped() { return samples_dropped; }
+    uint32_t getJitterSuppressed() { return jitter_suppressed; }
+};
+
+#endif // TOUCH_PIPELINE_H
@@ -0,0 +1,836 @@
+/**
+ * @file      tsdb.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Time-series store: delta-of-delta and XOR coding, PSRAM block
+ *            rings, sector-sized spill to SD, queries and rollups
+ */
+
+#include "tsdb.h"
+#include <SD.h>
+#include <esp_heap_caps.h>
+#include <esp_rom_crc.h>
+#include <esp_timer.h>
+#include <math.h>
+#include "simple_logger.h"
+#include "spi_bus.h"
+#include "fs_service.h"
+#include "sd_manager.h"
+#include "coro_sched.h"
+#include "i2c_bus.h"
+#include "net_manager.h"
+#include "peripheral.h"
+#include "sensor_sampler.h"
+#include "time_service.h"
+#include "factory.h"
+#ifdef INTEGRATION_LAYER_ENABLED
+#include "integration/config_manager.h"
+#endif
+
+static_assert(sizeof(TsdbBlockHeader) == 44, "Block header is part of the file format");
+static_assert(sizeof(TsdbIndexEntry) == 8, "Index entry is part of the file format");
+
+#define TSDB_PATH_MAX           32
+#define TSDB_NO_WINDOW          0xFF
+#define TSDB_WRITTEN            0x01    // Final contents on the card
+#define TSDB_INDEXED            0x02    // Has its index entry
+#define LTR553_ALS_DATA_CH1_0   0x88    // CH1 low, high, then CH0 low, high
+
+#define TSDB_SERIES_NAME(id, name)  name,
+static const char *const tsdb_names[TSDB_SERIES_COUNT] = { TSDB_SERIES(TSDB_SERIES_NAME) };
+
+struct SeriesState {
+    uint8_t *open;                  // PSRAM, one block
+    uint8_t *ring;                  // PSRAM, TSDB_RAM_BLOCKS closed blocks
+    uint32_t ring_gen[TSDB_RAM_BLOCKS];
+    uint8_t ring_flags[TSDB_RAM_BLOCKS];
+    uint8_t ring_head;              // Next slot to fill
+    uint8_t ring_count;
+    uint32_t open_gen;              // Blocks opened this session, names a block across close
+    uint8_t open_flags;
+    bool open_dirty;
+    int32_t sd_next;                // Next free slot in the file, -1 until looked up
+
+    // Encoder, for the open block
+    uint32_t prev_t;
+    int32_t prev_delta;
+    uint32_t prev_v;
+    uint8_t lead;
+    uint8_t trail;
+};
+
+static SeriesState tsdb_series[TSDB_SERIES_COUNT];
+static SemaphoreHandle_t tsdb_lock = nullptr;   // Blocks and encoders; never held over SD I/O
+static SemaphoreHandle_t tsdb_io = nullptr;     // The files, one writer at a time
+static TsdbStats tsdb_stats;
+static Coro tsdb_coro;
+static uint32_t tsdb_sample_ms = TSDB_SAMPLE_S * 1000UL;
+static uint32_t tsdb_next_sample = 0;
+static uint32_t tsdb_flush_time = 0;
+static uint32_t tsdb_last_steps = 0;
+
+static inline TsdbBlockHeader *head_of(uint8_t *block) {
+    return (TsdbBlockHeader *)block;
+}
+
+static inline uint8_t *ring_slot(SeriesState *st, int slot) {
+    return st->ring + slot * TSDB_BLOCK_SIZE;
+}
+
+// ===== Bit stream =====
+
+static void put_bits(uint8_t *buf, uint16_t *pos, uint32_t value, uint8_t n) {
+    while (n) {
+        uint8_t room = 8 - (*pos & 7);
+        uint8_t take = n < room ? n : room;
+        uint8_t part = (uint8_t)((value >> (n - take)) & ((1u << take) - 1));
+        buf[*pos >> 3] |= part << (room - take);
+        *pos += take;
+        n -= take;
+    }
+}
+
+struct BitReader {
+    const uint8_t *buf;
+    uint16_t pos;
+    uint16_t end;
+};
+
+static bool get_bits(BitReader *r, uint8_t n, uint32_t *out) {
+    if (r->pos + n > r->end) {
+        return false;
+    }
+    uint32_t v = 0;
+    while (n) {
+        uint8_t room = 8 - (r->pos & 7);
+        uint8_t take = n < room ? n : room;
+        uint8_t byte = r->buf[r->pos >> 3];
+        v = (v << take) | ((byte >> (room - take)) & ((1u << take) - 1));
+        r->pos += take;
+        n -= take;
+    }
+    *out = v;
+    return true;
+}
+
+// ===== Coding =====
+
+// Delta-of-delta buckets: control bits, control length, value bits
+static const struct { uint8_t ctrl, ctrl_len, bits; } dod_class[] = {
+    { 0x2, 2, 7 },
+    { 0x6, 3, 9 },
+    { 0xE, 4, 12 },
+    { 0xF, 4, 32 },
+};
+
+static void encode_time(uint8_t *payload, uint16_t *pos, int64_t dod) {
+    if (dod == 0) {
+        put_bits(payload, pos, 0, 1);
+        return;
+    }
+    for (const auto &c : dod_class) {
+        int64_t bias = ((int64_t)1 << (c.bits - 1)) - 1;
+        if (c.bits == 32 || (dod >= -bias && dod <= bias + 1)) {
+            put_bits(payload, pos, c.ctrl, c.ctrl_len);
+            put_bits(payload, pos, c.bits == 32 ? (uint32_t)dod : (uint32_t)(dod + bias), c.bits);
+            return;
+        }
+    }
+}
+
+static bool decode_time(BitReader *r, int64_t *dod) {
+    uint32_t bit;
+    if (!get_bits(r, 1, &bit)) {
+        return false;
+    }
+    if (!bit) {
+        *dod = 0;
+        return true;
+    }
+    uint32_t ctrl = 1;
+    for (const auto &c : dod_class) {
+        if (c.ctrl_len > 1 && ctrl != c.ctrl) {
+            // One more control bit: 1 goes on to the next class, 0 ends here
+            if (!get_bits(r, 1, &bit)) {
+                return false;
+            }
+            ctrl = (ctrl << 1) | bit;
+        }
+        if (ctrl == c.ctrl) {
+            uint32_t v;
+            if (!get_bits(r, c.bits, &v)) {
+                return false;
+            }
+            *dod = c.bits == 32 ? (int64_t)(int32_t)v : (int64_t)v - (((int64_t)1 << (c.bits - 1)) - 1);
+            return true;
+        }
+    }
+    return false;
+}
+
+static void encode_value(SeriesState *st, uint8_t *payload, uint16_t *pos, uint32_t v) {
+    uint32_t x = v ^ st->prev_v;
+    st->prev_v = v;
+    if (!x) {
+        put_bits(payload, pos, 0, 1);
+        return;
+    }
+    uint8_t lead = __builtin_clz(x);
+    uint8_t trail = __builtin_ctz(x);
+    lead = lead > 31 ? 31 : lead;
+    if (st->lead != TSDB_NO_WINDOW && lead >= st->lead && trail >= st->trail) {
+        put_bits(payload, pos, 0x2, 2);
+        put_bits(payload, pos, x >> st->trail, 32 - st->lead - st->trail);
+        return;
+    }
+    uint8_t len = 32 - lead - trail;
+    put_bits(payload, pos, 0x3, 2);
+    put_bits(payload, pos, lead, 5);
+    put_bits(payload, pos, len - 1, 5);
+    put_bits(payload, pos, x >> trail, len);
+    st->lead = lead;
+    st->trail = trail;
+}
+
+struct ValueDecoder {
+    uint32_t prev;
+    uint8_t lead;
+    uint8_t trail;
+};
+
+static bool decode_value(BitReader *r, ValueDecoder *d) {
+    uint32_t bit, x;
+    if (!get_bits(r, 1, &bit)) {
+        return false;
+    }
+    if (!bit) {
+        return true;
+    }
+    if (!get_bits(r, 1, &bit)) {
+        return false;
+    }
+    if (bit) {
+        uint32_t lead, len;
+        if (!get_bits(r, 5, &lead) || !get_bits(r, 5, &len) || lead + len + 1 > 32) {
+            return false;
+        }
+        d->lead = lead;
+        d->trail = 32 - lead - (len + 1);
+    } else if (d->lead == TSDB_NO_WINDOW) {
+        return false;
+    }
+    if (!get_bits(r, 32 - d->lead - d->trail, &x)) {
+        return false;
+    }
+    d->prev ^= x << d->trail;
+    return true;
+}
+
+static uint32_t float_bits(float v) {
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    return bits;
+}
+
+static float bits_float(uint32_t bits) {
+    float v;
+    memcpy(&v, &bits, sizeof(v));
+    return v;
+}
+
+// ===== Append =====
+
+static void block_start(SeriesState *st, int series, uint32_t t, float v) {
+    memset(st->open, 0, TSDB_BLOCK_SIZE);
+    TsdbBlockHeader *h = head_of(st->open);
+    h->magic = TSDB_MAGIC;
+    h->series = series;
+    h->count = 1;
+    h->block = UINT32_MAX;
+    h->t_first = h->t_last = t;
+    h->v_first = h->v_min = h->v_max = h->v_sum = v;
+    st->open_gen++;
+    st->open_flags = 0;
+    st->prev_t = t;
+    st->prev_delta = 0;
+    st->prev_v = float_bits(v);
+    st->lead = TSDB_NO_WINDOW;
+    st->trail = 0;
+}
+
+// Caller holds tsdb_lock
+static void block_close(SeriesState *st) {
+    memcpy(ring_slot(st, st->ring_head), st->open, TSDB_BLOCK_SIZE);
+    st->ring_gen[st->ring_head] = st->open_gen;
+    // An open block already on the card keeps its slot and index entry
+    st->ring_flags[st->ring_head] = st->open_flags & TSDB_INDEXED;
+    st->ring_head = (st->ring_head + 1) % TSDB_RAM_BLOCKS;
+    if (st->ring_count < TSDB_RAM_BLOCKS) {
+        st->ring_count++;
+    }
+    head_of(st->open)->count = 0;
+    st->open_dirty = false;
+    tsdb_stats.blocks_closed++;
+}
+
+bool tsdb_record_at(TsdbSeries series, uint32_t t, float value) {
+    if (!tsdb_lock || series >= TSDB_SERIES_COUNT || isnan(value)) {
+        return false;
+    }
+    SeriesState *st = &tsdb_series[series];
+    xSemaphoreTake(tsdb_lock, portMAX_DELAY);
+    TsdbBlockHeader *h = head_of(st->open);
+    if (h->count && t < st->prev_t) {
+        t = st->prev_t;
+    }
+    if (h->count && (h->bits + TSDB_POINT_BITS_MAX > TSDB_PAYLOAD_SIZE * 8 || h->count == UINT16_MAX)) {
+        block_close(st);
+    }
+    if (!h->count) {
+        block_start(st, series, t, value);
+    } else {
+        uint8_t *payload = st->open + sizeof(TsdbBlockHeader);
+        uint16_t pos = h->bits;
+        int64_t delta = (int64_t)t - st->prev_t;
+        encode_time(payload, &pos, delta - st->prev_delta);
+        encode_value(st, payload, &pos, float_bits(value));
+        tsdb_stats.coded_bytes += (pos >> 3) - (h->bits >> 3);
+        h->bits = pos;
+        h->count++;
+        h->t_last = t;
+        h->v_min = min(h->v_min, value);
+        h->v_max = max(h->v_max, value);
+        h->v_sum += value;
+        st->prev_t = t;
+        st->prev_delta = (int32_t)delta;
+    }
+    st->open_dirty = true;
+    tsdb_stats.points++;
+    xSemaphoreGive(tsdb_lock);
+    return true;
+}
+
+bool tsdb_record(TsdbSeries series, float value) {
+    return time_valid() && tsdb_record_at(series, time_now_s(), value);
+}
+
+// ===== Card =====
+
+static void series_path(char *buf, int series, const char *ext) {
+    snprintf(buf, TSDB_PATH_MAX, TSDB_DIR "/%s.%s", tsdb_names[series], ext);
+}
+
+// Caller holds the bus
+static int32_t file_blocks(int series) {
+    char path[TSDB_PATH_MAX];
+    series_path(path, series, "bin");
+    if (!SD.exists(path)) {
+        // "r+" needs the file to exist
+        File f = SD.open(path, FILE_WRITE);
+        if (!f) {
+            return -1;
+        }
+        f.close();
+        return 0;
+    }
+    File f = SD.open(path, FILE_READ);
+    int32_t blocks = f ? (f.size() + TSDB_BLOCK_SIZE - 1) / TSDB_BLOCK_SIZE : -1;
+    if (f) {
+        f.close();
+    }
+    return blocks;
+}
+
+// Writes the block to its slot and indexes it the first time
+static bool block_write(int series, uint8_t *block, bool indexed) {
+    TsdbBlockHeader *h = head_of(block);
+    h->crc = 0;
+    h->crc = esp_rom_crc32_le(0, block, TSDB_BLOCK_SIZE);
+
+    char path[TSDB_PATH_MAX];
+    SpiBusHold bus(SPI_CLIENT_SD);
+    series_path(path, series, "bin");
+    File f = SD.open(path, "r+");
+    bool ok = f && f.seek(h->block * TSDB_BLOCK_SIZE) && f.write(block, TSDB_BLOCK_SIZE) == TSDB_BLOCK_SIZE;
+    if (f) {
+        f.close();
+    }
+    if (ok && !indexed) {
+        TsdbIndexEntry entry = {h->block, h->t_first};
+        series_path(path, series, "idx");
+        File idx = SD.open(path, FILE_APPEND);
+        ok = idx && idx.write((const uint8_t *)&entry, sizeof(entry)) == sizeof(entry);
+        if (idx) {
+            idx.close();
+        }
+    }
+    fs_invalidate_usage();
+    return ok;
+}
+
+// The block named gen, wherever it is now; caller holds tsdb_lock
+static uint8_t *find_gen(SeriesState *st, uint32_t gen, uint8_t **flags) {
+    if (gen == st->open_gen && head_of(st->open)->count) {
+        *flags = &st->open_flags;
+        return st->open;
+    }
+    for (int i = 0; i < st->ring_count; i++) {
+        if (st->ring_gen[i] == gen) {
+            *flags = &st->ring_flags[i];
+            return ring_slot(st, i);
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * Closed blocks not on the card yet, oldest first so slots stay in time
+ * order, then the open block if asked. Each is copied out under the lock
+ * and written without it: the LoRa task records while holding the SPI bus
+ */
+static void spill(bool open_too) {
+    if (!sd_manager_mounted()) {
+        return;
+    }
+    static uint8_t buf[TSDB_BLOCK_SIZE];
+    xSemaphoreTake(tsdb_io, portMAX_DELAY);
+    for (int s = 0; s < TSDB_SERIES_COUNT; s++) {
+        SeriesState *st = &tsdb_series[s];
+        if (st->sd_next < 0) {
+            SpiBusHold bus(SPI_CLIENT_SD);
+            if (!SD.exists(TSDB_DIR) && !SD.mkdir(TSDB_DIR)) {
+                break;
+            }
+            st->sd_next = file_blocks(s);
+            if (st->sd_next < 0) {
+                continue;
+            }
+        }
+        for (int n = 0; n <= TSDB_RAM_BLOCKS; n++) {
+            xSemaphoreTake(tsdb_lock, portMAX_DELAY);
+            uint8_t *block = nullptr;
+            uint8_t *flags = nullptr;
+            uint32_t gen = 0;
+            if (n < st->ring_count) {
+                int slot = (st->ring_head + TSDB_RAM_BLOCKS - st->ring_count + n) % TSDB_RAM_BLOCKS;
+                if (!(st->ring_flags[slot] & TSDB_WRITTEN)) {
+                    block = ring_slot(st, slot);
+                    gen = st->ring_gen[slot];
+                    flags = &st->ring_flags[slot];
+                }
+            } else if (n == TSDB_RAM_BLOCKS && open_too && st->open_dirty) {
+                block = st->open;
+                gen = st->open_gen;
+                flags = &st->open_flags;
+                st->open_dirty = false;
+            }
+            if (block && head_of(block)->block == UINT32_MAX) {
+                head_of(block)->block = st->sd_next++;
+            }
+            if (block) {
+                memcpy(buf, block, TSDB_BLOCK_SIZE);
+            }
+            bool indexed = flags && (*flags & TSDB_INDEXED);
+            xSemaphoreGive(tsdb_lock);
+            if (!block) {
+                continue;
+            }
+
+            bool ok = block_write(s, buf, indexed);
+            xSemaphoreTake(tsdb_lock, portMAX_DELAY);
+            uint8_t *now = find_gen(st, gen, &flags);
+            if (ok) {
+                tsdb_stats.blocks_spilled++;
+                if (now) {
+                    // The open block is never final: it is written again once closed
+                    *flags |= TSDB_INDEXED | (now == st->open ? 0 : TSDB_WRITTEN);
+                }
+            } else {
+                tsdb_stats.spill_errors++;
+                if (now == st->open) {
+                    st->open_dirty = true;
+                }
+            }
+            xSemaphoreGive(tsdb_lock);
+            if (!ok) {
+                break;
+            }
+        }
+    }
+    xSemaphoreGive(tsdb_io);
+}
+
+void tsdb_flush() {
+    if (tsdb_lock) {
+        spill(true);
+        tsdb_flush_time = millis();
+    }
+}
+
+// A new card may hold other files
+static void sd_attach() {
+    for (int s = 0; s < TSDB_SERIES_COUNT; s++) {
+        tsdb_series[s].sd_next = -1;
+    }
+}
+
+static void sd_detach() {
+    tsdb_flush();
+}
+
+// ===== Queries =====
+
+struct Visitor {
+    uint32_t from;
+    uint32_t to;
+    bool (*block)(Visitor *v, const TsdbBlockHeader *h);   // True if taken whole
+    void (*point)(Visitor *v, uint32_t t, float value);
+    bool full;
+    void *ctx;
+};
+
+static void block_visit(const uint8_t *block, Visitor *vis) {
+    TsdbBlockHeader h;
+    memcpy(&h, block, sizeof(h));
+    if (!h.count || h.t_last < vis->from || h.t_first > vis->to || (vis->block && vis->block(vis, &h))) {
+        return;
+    }
+    BitReader r = { block + sizeof(h), 0, h.bits };
+    ValueDecoder d = { float_bits(h.v_first), TSDB_NO_WINDOW, 0 };
+    uint32_t t = h.t_first;
+    int64_t delta = 0;
+    for (uint16_t i = 0; i < h.count && !vis->full; i++) {
+        if (i) {
+            int64_t dod;
+            if (!decode_time(&r, &dod) || !decode_value(&r, &d)) {
+                break;
+            }
+            delta += dod;
+            t += (uint32_t)delta;
+        }
+        if (t > vis->to) {
+            break;
+        }
+        if (t >= vis->from) {
+            vis->point(vis, t, bits_float(d.prev));
+        }
+    }
+}
+
+// A copy of the RAM blocks, oldest first, so decoding runs without the lock
+static uint8_t *ram_snapshot(SeriesState *st, int *n) {
+    uint8_t *copy = (uint8_t *)heap_caps_malloc((TSDB_RAM_BLOCKS + 1) * TSDB_BLOCK_SIZE,
+                                                MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    *n = 0;
+    if (!copy) {
+        return nullptr;
+    }
+    xSemaphoreTake(tsdb_lock, portMAX_DELAY);
+    for (int i = 0; i < st->ring_count; i++) {
+        int slot = (st->ring_head + TSDB_RAM_BLOCKS - st->ring_count + i) % TSDB_RAM_BLOCKS;
+        memcpy(copy + (*n)++ * TSDB_BLOCK_SIZE, ring_slot(st, slot), TSDB_BLOCK_SIZE);
+    }
+    if (head_of(st->open)->count) {
+        memcpy(copy + (*n)++ * TSDB_BLOCK_SIZE, st->open, TSDB_BLOCK_SIZE);
+    }
+    xSemaphoreGive(tsdb_lock);
+    return copy;
+}
+
+// Blocks on the card from the one holding from, up to before; binary search over the index
+static void card_visit(int series, uint32_t before, Visitor *vis) {
+    if (!sd_manager_mounted()) {
+        return;
+    }
+    char path[TSDB_PATH_MAX];
+    uint8_t buf[TSDB_BLOCK_SIZE];
+    SpiBusHold bus(SPI_CLIENT_SD);
+    series_path(path, series, "idx");
+    File idx = SD.open(path, FILE_READ);
+    series_path(path, series, "bin");
+    File bin = SD.open(path, FILE_READ);
+    if (!idx || !bin) {
+        if (idx) {
+            idx.close();
+        }
+        if (bin) {
+            bin.close();
+        }
+        return;
+    }
+
+    TsdbIndexEntry entry;
+    int32_t entries = idx.size() / sizeof(entry);
+    int32_t lo = 0, hi = entries - 1, start = 0;
+    while (lo <= hi) {
+        int32_t mid = (lo + hi) / 2;
+        if (!idx.seek(mid * sizeof(entry)) || idx.read((uint8_t *)&entry, sizeof(entry)) != sizeof(entry)) {
+            break;
+        }
+        if (entry.t_first <= vis->from) {
+            start = mid;
+            lo = mid + 1;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    idx.seek(start * sizeof(entry));
+    for (int32_t i = start; i < entries && !vis->full; i++) {
+        if (idx.read((uint8_t *)&entry, sizeof(entry)) != sizeof(entry) || entry.t_first > vis->to ||
+            entry.t_first >= before) {
+            break;
+        }
+        if (!bin.seek(entry.block * TSDB_BLOCK_SIZE) || bin.read(buf, sizeof(buf)) != sizeof(buf)) {
+            break;
+        }
+        TsdbBlockHeader h;
+        memcpy(&h, buf, sizeof(h));
+        uint32_t crc = h.crc;
+        memset(buf + offsetof(TsdbBlockHeader, crc), 0, sizeof(h.crc));
+        if (h.magic != TSDB_MAGIC || h.series != series || h.block != entry.block || h.bits > TSDB_PAYLOAD_SIZE * 8 ||
+            esp_rom_crc32_le(0, buf, sizeof(buf)) != crc) {
+            continue;
+        }
+        block_visit(buf, vis);
+    }
+    idx.close();
+    bin.close();
+}
+
+static void series_visit(TsdbSeries series, Visitor *vis) {
+    int64_t start = esp_timer_get_time();
+    int n;
+    uint8_t *ram = ram_snapshot(&tsdb_series[series], &n);
+    // The card holds what came before the oldest block still in RAM
+    uint32_t ram_from = n ? head_of(ram)->t_first : UINT32_MAX;
+    if (vis->from < ram_from) {
+        card_visit(series, ram_from, vis);
+    }
+    for (int i = 0; i < n && !vis->full; i++) {
+        block_visit(ram + i * TSDB_BLOCK_SIZE, vis);
+    }
+    free(ram);
+
+    uint32_t us = (uint32_t)(esp_timer_get_time() - start);
+    xSemaphoreTake(tsdb_lock, portMAX_DELAY);
+    tsdb_stats.query_us_max = max(tsdb_stats.query_us_max, us);
+    xSemaphoreGive(tsdb_lock);
+}
+
+struct QueryCtx {
+    TsdbPoint *out;
+    size_t max;
+    size_t n;
+};
+
+static void query_point(Visitor *vis, uint32_t t, float value) {
+    QueryCtx *q = (QueryCtx *)vis->ctx;
+    q->out[q->n++] = {t, value};
+    vis->full = q->n >= q->max;
+}
+
+size_t tsdb_query(TsdbSeries series, uint32_t from, uint32_t to, TsdbPoint *out, size_t max) {
+    if (!tsdb_lock || series >= TSDB_SERIES_COUNT || !max || from > to) {
+        return 0;
+    }
+    QueryCtx q = {out, max, 0};
+    Visitor vis = {from, to, nullptr, query_point, false, &q};
+    series_visit(series, &vis);
+    return q.n;
+}
+
+struct RollupCtx {
+    TsdbBucket *out;
+    uint32_t step;
+    size_t count;
+};
+
+static void bucket_add(TsdbBucket *b, uint32_t n, float lo, float hi, float sum) {
+    if (!b->count) {
+        b->min = lo;
+        b->max = hi;
+        b->avg = 0;
+    }
+    b->count += n;
+    b->min = min(b->min, lo);
+    b->max = max(b->max, hi);
+    b->avg += sum;                  // A sum until the end
+}
+
+static bool rollup_block(Visitor *vis, const TsdbBlockHeader *h) {
+    RollupCtx *r = (RollupCtx *)vis->ctx;
+    if (h->t_first < vis->from || h->t_last > vis->to) {
+        return false;
+    }
+    uint32_t b = (h->t_first - vis->from) / r->step;
+    if (b != (h->t_last - vis->from) / r->step) {
+        return false;
+    }
+    bucket_add(&r->out[b], h->count, h->v_min, h->v_max, h->v_sum);
+    return true;
+}
+
+static void rollup_point(Visitor *vis, uint32_t t, float value) {
+    RollupCtx *r = (RollupCtx *)vis->ctx;
+    bucket_add(&r->out[(t - vis->from) / r->step], 1, value, value, value);
+}
+
+size_t tsdb_rollup(TsdbSeries series, uint32_t from, uint32_t step, TsdbBucket *out, size_t count) {
+    if (!tsdb_lock || series >= TSDB_SERIES_COUNT || !step || !count) {
+        return 0;
+    }
+    uint64_t end = (uint64_t)from + (uint64_t)step * count - 1;
+    for (size_t i = 0; i < count; i++) {
+        out[i] = {from + (uint32_t)(i * step), 0, 0, 0, 0};
+    }
+    RollupCtx r = {out, step, count};
+    Visitor vis = {from, end > UINT32_MAX ? UINT32_MAX : (uint32_t)end, rollup_block, rollup_point, false, &r};
+    series_visit(series, &vis);
+
+    size_t filled = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (out[i].count) {
+            out[i].avg /= out[i].count;
+            filled++;
+        }
+    }
+    return filled;
+}
+
+// ===== Sampling =====
+
+// From the sampler's snapshot, at most a gauge period old
+static void sample_battery() {
+    SensorGauge g;
+    if (!sensor_get_gauge(&g) || !g.mv) {
+        return;
+    }
+    tsdb_record(TSDB_BATTERY_MV, g.mv);
+    tsdb_record(TSDB_BATTERY_MA, g.ma);
+    tsdb_record(TSDB_BATTERY_PCT, g.soc);
+    // 0.1 K, to whole tenths of a degree so the XOR coding sees repeats
+    tsdb_record(TSDB_BATTERY_TEMP_C, (g.temp_dk - 2732) / 10.0f);
+}
+
+static void sample_light() {
+    if (!peri_init_ready(E_PERI_LTR_553ALS)) {
+        return;
+    }
+    uint8_t data[4] = {0};
+    const i2c_bus_op_t ops[] = { { LTR553_ALS_DATA_CH1_0, 4, data } };
+    if (i2c_bus_read(I2C_DEV_LTR553, ops, 1)) {
+        tsdb_record(TSDB_LIGHT, data[2] | (data[3] << 8));
+    }
+}
+
+static void sample_steps() {
+    if (!peri_init_ready(E_PERI_BHI260AP)) {
+        return;
+    }
+    bhi260_stats_t s;
+    BHI260AP_get_stats(&s);
+    // Steps per interval; the hub's counter restarts with it
+    uint32_t steps = s.steps >= tsdb_last_steps ? s.steps - tsdb_last_steps : s.steps;
+    tsdb_last_steps = s.steps;
+    tsdb_record(TSDB_STEPS, steps);
+}
+
+static void sample_links() {
+    NetLinkStatus link;
+    if (net_manager_link(NET_BEARER_WIFI, &link) && link.up && link.signal_dbm) {
+        tsdb_record(TSDB_WIFI_RSSI, link.signal_dbm);
+    }
+    if (net_manager_link(NET_BEARER_CELL, &link) && link.up && link.signal_dbm) {
+        tsdb_record(TSDB_CELL_RSSI, link.signal_dbm);
+    }
+}
+
+static bool lora_rssi_tap(const lora_packet_t *pkt) {
+    tsdb_record(TSDB_LORA_RSSI, roundf(pkt->rssi));
+    return false;
+}
+
+static uint32_t sample_wait() {
+    int32_t wait = (int32_t)(tsdb_next_sample - millis());
+    return wait > 0 ? wait : 0;
+}
+
+static CoroStatus tsdb_coro_fn(Coro *co) {
+    CORO_BEGIN(co);
+    while (true) {
+        CORO_SLEEP(co, sample_wait());
+        if ((int32_t)(millis() - tsdb_next_sample) >= 0) {
+            tsdb_next_sample += tsdb_sample_ms;
+            if (time_valid()) {
+                sample_battery();
+                sample_light();
+                sample_steps();
+                sample_links();
+            }
+        }
+        // Closed blocks go out as they close, open ones at the flush interval
+        bool due = millis() - tsdb_flush_time >= TSDB_FLUSH_S * 1000UL;
+        spill(due);
+        if (due) {
+            tsdb_flush_time = millis();
+        }
+    }
+    CORO_END(co);
+}
+
+// ===== API =====
+
+bool tsdb_begin() {
+    if (tsdb_lock) {
+        return true;
+    }
+#ifdef INTEGRATION_LAYER_ENABLED
+    if (!GET_CONFIG_BOOL("tsdb", "enabled", true)) {
+        return false;
+    }
+    tsdb_sample_ms = max(5, GET_CONFIG_INT("tsdb", "sample_s", TSDB_SAMPLE_S)) * 1000UL;
+#endif
+    size_t per_series = (TSDB_RAM_BLOCKS + 1) * TSDB_BLOCK_SIZE;
+    uint8_t *mem = (uint8_t *)heap_caps_calloc(TSDB_SERIES_COUNT, per_series, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    tsdb_lock = xSemaphoreCreateMutex();
+    tsdb_io = xSemaphoreCreateMutex();
+    if (!mem || !tsdb_lock || !tsdb_io) {
+        LOG_ERROR("TSDB", "Out of memory");
+        free(mem);
+        return false;
+    }
+    for (int s = 0; s < TSDB_SERIES_COUNT; s++) {
+        tsdb_series[s].open = mem + s * per_series;
+        tsdb_series[s].ring = tsdb_series[s].open + TSDB_BLOCK_SIZE;
+        tsdb_series[s].sd_next = -1;
+    }
+    tsdb_stats.ram_bytes = TSDB_SERIES_COUNT * per_series;
+
+    sd_manager_add_client("TSDB", sd_attach, sd_detach);
+    lora_add_rx_hook(lora_rssi_tap);
+    tsdb_next_sample = millis() + tsdb_sample_ms;
+    tsdb_flush_time = millis();
+    if (!coro_spawn(&tsdb_coro, "tsdb", tsdb_coro_fn)) {
+        LOG_ERROR("TSDB", "Failed to start the sampler");
+        return false;
+    }
+    LOG_INFOF("TSDB", "%d series, %lu KB PSRAM, a sample every %lu s", TSDB_SERIES_COUNT,
+              (unsigned long)(tsdb_stats.ram_bytes / 1024), (unsigned long)(tsdb_sample_ms / 1000));
+    return true;
+}
+
+const char *tsdb_series_name(TsdbSeries series) {
+    return series < TSDB_SERIES_COUNT ? tsdb_names[series] : "?";
+}
+
+void tsdb_get_stats(TsdbStats *stats) {
+    if (!tsdb_lock) {
+        memset(stats, 0, sizeof(*stats));
+        return;
+    }
+    xSemaphoreTake(tsdb_lock, portMAX_DELAY);
+    *stats = tsdb_stats;
+    xSemaphoreGive(tsdb_lock);
+}
@@ -0,0 +1,160 @@
+/**
+ * @file      tsdb.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Time-series store: Gorilla-coded blocks in PSRAM, spilled to SD,
+ *            with range queries and rollups for history graphs
+ */
+
+#ifndef TSDB_H
+#define TSDB_H
+
+#include <Arduino.h>
+
+/**
+ * Each series is a stream of (UTC second, float) points coded into
+ * TSDB_BLOCK_SIZE blocks the way Gorilla does it:
+ *
+ *   time   delta of delta: '0' for the same interval, else '10' + 7 bits,
+ *          '110' + 9, '1110' + 12 or '1111' + 32
+ *   value  XOR with the previous value: '0' when equal, else '10' and the
+ *          meaningful bits inside the last window, or '11' + 5 bits of
+ *          leading zeros + 5 bits of length - 1 + the bits
+ *
+ * A battery reading a minute that barely moves costs 2-10 bits, so a day
+ * of one series is about 1 KB. The first point sits in the block header,
+ * along with the block's time span and min, max and sum, so any block
+ * decodes on its own and a rollup skips decoding blocks that fall inside
+ * one bucket.
+ *
+ * The open block and the last TSDB_RAM_BLOCKS closed ones of each series
+ * live in PSRAM. Closed blocks are appended to TSDB_DIR/<series>.bin,
+ * one block per sector, with a TSDB_DIR/<series>.idx entry each; the
+ * open one is rewritten in place every TSDB_FLUSH_S. Without a card the
+ * RAM ring is all there is, and it is gone at power off.
+ *
+ * A coroutine samples battery, light, step count and link signal every
+ * tsdb.sample_s once the clock is set (points are keyed by UTC); LoRa
+ * RSSI goes in per received packet, the power mode per battery forecast
+ * tick. Anything else can record into its own series by adding it to
+ * TSDB_SERIES.
+ *
+ * Config section "tsdb": enabled, sample_s.
+ */
+
+#define TSDB_DIR                    "/tsdb"
+#define TSDB_MAGIC                  0x42445354UL  // "TSDB"
+#define TSDB_BLOCK_SIZE             512
+#define TSDB_RAM_BLOCKS             8       // Closed blocks kept in PSRAM per series
+#define TSDB_SAMPLE_S               60
+#define TSDB_FLUSH_S                600     // Open blocks go to the card this often
+#define TSDB_POINT_BITS_MAX         80      // 4 + 32 for time, 2 + 10 + 32 for value
+
+// X(id, name): the name is the file name on the card, keep it short and stable
+#define TSDB_SERIES(X)                                      \
+    X(BATTERY_PCT,          "batt_pct")                     \
+    X(BATTERY_MV,           "batt_mv")                      \
+    X(BATTERY_MA,           "batt_ma")                      \
+    X(BATTERY_TEMP_C,       "batt_tc")                      \
+    X(LIGHT,                "light")                        \
+    X(STEPS,                "steps")                        \
+    X(WIFI_RSSI,            "wifi_dbm")                     \
+    X(CELL_RSSI,            "cell_dbm")                     \
+    X(LORA_RSSI,            "lora_dbm")                     \
+    X(POWER_MODE,           "pwr_mode")
+
+#define TSDB_ENUM(id, name)     TSDB_##id,
+
+enum TsdbSeries { TSDB_SERIES(TSDB_ENUM) TSDB_SERIES_COUNT };
+
+/**
+ * Block layout, little-endian: this header, then the points after the
+ * first as a big-endian bit stream of header.bits bits
+ */
+struct TsdbBlockHeader {
+    uint32_t magic;
+    uint16_t series;
+    uint16_t count;                 // Points, the first included
+    uint32_t block;                 // Position in the file, UINT32_MAX until written
+    uint32_t t_first;               // UTC seconds
+    uint32_t t_last;
+    float v_first;
+    float v_min;
+    float v_max;
+    float v_sum;
+    uint16_t bits;                  // Coded bits after the header
+    uint16_t reserved;
+    uint32_t crc;                   // Over the whole block with this field 0
+};
+
+#define TSDB_PAYLOAD_SIZE           (TSDB_BLOCK_SIZE - sizeof(TsdbBlockHeader))
+
+// One per block in the index file, in write order
+struct TsdbIndexEntry {
+    uint32_t block;
+    uint32_t t_first;
+};
+
+struct TsdbPoint {
+    uint32_t t;
+    float v;
+};
+
+struct TsdbBucket {
+    uint32_t t;                     // Start of the bucket
+    uint32_t count;                 // 0: no data, the rest is undefined
+    float min;
+    float max;
+    float avg;
+};
+
+struct TsdbStats {
+    uint32_t points;
+    uint32_t coded_bytes;           // Points after the first of each block
+    uint32_t blocks_closed;
+    uint32_t blocks_spilled;
+    uint32_t spill_errors;
+    uint32_t ram_bytes;
+    uint32_t query_us_max;
+};
+
+/**
+ * @brief Allocate the PSRAM rings, find the files on the card and start
+ *        sampling; off when tsdb.enabled is false
+ */
+bool tsdb_begin();
+
+/**
+ * @brief Add a point now, or at UTC second t; false before the clock is set
+ *        or when off. Times earlier than the series' last point are taken
+ *        as that point's time. Any task
+ */
+bool tsdb_record(TsdbSeries series, float value);
+bool tsdb_record_at(TsdbSeries series, uint32_t t, float value);
+
+/**
+ * @brief Points with from <= t <= to, oldest first, card then RAM
+ * @return Points written to out
+ */
+size_t tsdb_query(TsdbSeries series, uint32_t from, uint32_t to, TsdbPoint *out, size_t max);
+
+/**
+ * @brief count buckets of step seconds from from: min, max and mean of the
+ *        points in each. For graphs: a week in 1 h buckets reads a few
+ *        sectors and decodes only the blocks that straddle a bucket edge
+ * @return Buckets with data
+ */
+size_t tsdb_rollup(TsdbSeries series, uint32_t from, uint32_t step, TsdbBucket *out, size_t count);
+
+/**
+ * @brief Write every open block out, e.g. before deep sleep or an eject
+ */
+void tsdb_flush();
+
+const char *tsdb_series_name(TsdbSeries series);
+
+void tsdb_get_stats(TsdbStats *stats);
+
+#endif // TSDB_H
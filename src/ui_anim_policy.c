@@ -0,0 +1,68 @@
+
+#include "ui_anim_policy.h"
+#include "src/misc/lv_gc.h"
+
+static ui_anim_policy_t anim_policy = UI_ANIM_FULL;
+static lv_timer_cb_t anim_timer_cb = NULL;  /* LVGL's own, called after the policy */
+static uint32_t anim_collapsed = 0;
+
+/*********************************************************************************
+ *                              STATIC FUNCTION
+ *********************************************************************************/
+// Longest run that still fits the policy: 0 ends on the first step, two
+// timer periods leave one frame halfway
+static uint32_t ui_anim_policy_time(void)
+{
+    if(anim_policy == UI_ANIM_ONE_STEP)
+        return 2 * lv_anim_get_timer()->period;
+    return 0;
+}
+
+static void ui_anim_policy_timer(lv_timer_t *t)
+{
+    uint32_t max_time = ui_anim_policy_time();
+    lv_anim_t *a = _lv_ll_get_head(&LV_GC_ROOT(_lv_anim_ll));
+
+    // Not yet started (act_time still at -delay) and not already short
+    while(a != NULL){
+        // lv_anim_t keeps time signed but playback_time unsigned; compare both as uint32_t
+        uint32_t time = a->time < 0 ? 0 : (uint32_t)a->time;
+        if(a->repeat_cnt != LV_ANIM_REPEAT_INFINITE && !a->start_cb_called &&
+           (time > max_time || a->playback_time > max_time)){
+            a->time = (int32_t)LV_MIN(time, max_time);
+            a->playback_time = LV_MIN(a->playback_time, max_time);
+            anim_collapsed++;
+        }
+        a = _lv_ll_get_next(&LV_GC_ROOT(_lv_anim_ll), a);
+    }
+    anim_timer_cb(t);
+}
+
+/*********************************************************************************
+ *                              GLOBAL FUNCTION
+ *********************************************************************************/
+void ui_anim_policy_set(ui_anim_policy_t policy)
+{
+    lv_timer_t *t = lv_anim_get_timer();
+    if(t == NULL)
+        return;
+    if(anim_timer_cb == NULL){
+        anim_timer_cb = t->timer_cb;
+        t->timer_cb = ui_anim_policy_timer;
+    }
+    anim_policy = policy;
+    if(policy == UI_ANIM_FULL){
+        t->timer_cb = anim_timer_cb;
+        anim_timer_cb = NULL;
+    }
+}
+
+ui_anim_policy_t ui_anim_policy_get(void)
+{
+    return anim_policy;
+}
+
+uint32_t ui_anim_policy_collapsed(void)
+{
+    return anim_collapsed;
+}
@@ -0,0 +1,43 @@
+#ifndef __UI_ANIM_POLICY_H__
+#define __UI_ANIM_POLICY_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "lvgl.h"
+
+/*
+ * How much of an animation a slow panel gets to see. Every lv_anim step
+ * is a render and, on e-paper, a panel update that takes longer than the
+ * step itself, so a 300 ms slide is several refreshes of frames nobody
+ * sees settle. The policy is applied where every animation runs: the
+ * LVGL anim timer's callback is wrapped, and each finite animation is
+ * shortened before its first step.
+ *
+ * UI_ANIM_FINAL jumps to the end value on the first step, UI_ANIM_ONE_STEP
+ * leaves one frame halfway, UI_ANIM_FULL leaves LVGL alone for a panel
+ * that keeps up. Delays are kept, as is anything that repeats forever (a
+ * spinner has no final keyframe). scr_mgr loads screens without an
+ * animation at all unless the policy is UI_ANIM_FULL, so the snapshot
+ * cache can show them.
+ */
+typedef enum {
+    UI_ANIM_FULL = 0,
+    UI_ANIM_ONE_STEP,
+    UI_ANIM_FINAL,
+} ui_anim_policy_t;
+
+/*********************************************************************************
+ *                              GLOBAL PROTOTYPES
+ * *******************************************************************************/
+// The display backend calls this once it knows the panel; after lv_init()
+void ui_anim_policy_set(ui_anim_policy_t policy);
+ui_anim_policy_t ui_anim_policy_get(void);
+uint32_t ui_anim_policy_collapsed(void);    // Animations shortened so far
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*__UI_ANIM_POLICY_H__*/
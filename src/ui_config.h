@@ -33,6 +33,7 @@ extern "C" {
 // Update intervals (in seconds)
 #define UI_STATUS_UPDATE_INTERVAL  5       // Status widget update frequency
 #define UI_BATTERY_UPDATE_INTERVAL 10      // Battery status check frequency
+#define UI_STATUS_BATTERY_STEP     5       // Battery percent is shown in steps of this size
 #define UI_TOUCH_POLL_RATE         30      // Touch polling rate (ms)
 #define UI_GESTURE_DISTANCE        15      // Touch gesture sensitivity (px)
 
@@ -59,10 +60,11 @@ extern "C" {
  *                              FONT CONFIGURATION
  * *******************************************************************************/
 // Font assignments for different UI elements
-#define UI_FONT_BUTTON             &Font_Mono_Bold_16
-#define UI_FONT_STATUS_WIDGET      &Font_Mono_Bold_14
-#define UI_FONT_TASKBAR            &Font_Mono_Bold_14
-#define UI_FONT_BREADCRUMB         &Font_Mono_Bold_14
+#define UI_FONT_BUTTON             &Font_Mono_Bold_16_cached
+#define UI_FONT_STATUS_WIDGET      &Font_Mono_Bold_14_cached
+#define UI_FONT_TASKBAR            &Font_Mono_Bold_14_cached
+#define UI_FONT_BREADCRUMB         &Font_Mono_Bold_14_cached
+#define UI_FONT_LAUNCHER           &Font_Mono_Bold_14_cached    // Names under the launcher icons
 
 /*********************************************************************************
  *                              FEATURE CONFIGURATION
@@ -2,31 +2,44 @@
 #include "ui_deckpro.h"
 #include "ui_config.h"
 #include "src/assets.h"
+#include "glyph_cache.h"
+#include "ui_vlist.h"
+#include "ui_reader.h"
+#include "ui_launcher.h"
+#include "app_index.h"
+#include "plugin_runtime.h"
+#include "lvgl_integration.h"
+#include "resume_state.h"
+#include "ui_label.h"
+#include "ui_theme.h"
+#include "ui_term.h"
+#include "ui_map.h"
+#include "lvgl_layers.h"
+#include "simple_logger.h"
 #include "stdio.h"
 #include "ui_deckpro_port.h"
 #include "WiFi.h"
 #include "time.h"
 #include "Arduino.h"
+#include <esp_heap_caps.h>
+#include <ctype.h>
 
 #define SETTING_PAGE_MAX_ITEM 7
 #define GET_BUFF_LEN(a) sizeof(a)/sizeof(a[0])
 
-#define FONT_BOLD_SIZE_14 &Font_Mono_Bold_14
-#define FONT_BOLD_SIZE_15 &Font_Mono_Bold_15
-#define FONT_BOLD_SIZE_16 &Font_Mono_Bold_16
-#define FONT_BOLD_SIZE_17 &Font_Mono_Bold_17
-#define FONT_BOLD_SIZE_18 &Font_Mono_Bold_18
-#define FONT_BOLD_SIZE_19 &Font_Mono_Bold_19
+#define FONT_BOLD_SIZE_14 &Font_Mono_Bold_14_cached
+#define FONT_BOLD_SIZE_15 &Font_Mono_Bold_15_cached
+#define FONT_BOLD_SIZE_16 &Font_Mono_Bold_16_cached
+#define FONT_BOLD_SIZE_17 &Font_Mono_Bold_17_cached
+#define FONT_BOLD_SIZE_18 &Font_Mono_Bold_18_cached
+#define FONT_BOLD_SIZE_19 &Font_Mono_Bold_19_cached
 
-#define FONT_BOLD_MONO_SIZE_14 &Font_Mono_Bold_14
-#define FONT_BOLD_MONO_SIZE_15 &Font_Mono_Bold_15
-#define FONT_BOLD_MONO_SIZE_16 &Font_Mono_Bold_16
-#define FONT_BOLD_MONO_SIZE_17 &Font_Mono_Bold_17
-#define FONT_BOLD_MONO_SIZE_18 &Font_Mono_Bold_18
-#define FONT_BOLD_MONO_SIZE_19 &Font_Mono_Bold_19
-
-#define GLOBAL_BUF_LEN 30
-static char global_buf[GLOBAL_BUF_LEN];
+#define FONT_BOLD_MONO_SIZE_14 &Font_Mono_Bold_14_cached
+#define FONT_BOLD_MONO_SIZE_15 &Font_Mono_Bold_15_cached
+#define FONT_BOLD_MONO_SIZE_16 &Font_Mono_Bold_16_cached
+#define FONT_BOLD_MONO_SIZE_17 &Font_Mono_Bold_17_cached
+#define FONT_BOLD_MONO_SIZE_18 &Font_Mono_Bold_18_cached
+#define FONT_BOLD_MONO_SIZE_19 &Font_Mono_Bold_19_cached
 
 static lv_timer_t *touch_chk_timer = NULL;
 static lv_timer_t *taskbar_update_timer = NULL;
@@ -39,53 +52,28 @@ static lv_obj_t *scr_back_btn_create(lv_obj_t *parent, const char *text, lv_even
 {
     lv_obj_t * btn = lv_btn_create(parent);
     lv_obj_remove_style_all(btn);
-    lv_obj_set_style_pad_all(btn, 0, 0);
+    UI_STYLE(btn, ui_style_back_btn, LV_PART_MAIN);
     lv_obj_set_height(btn, 30);
     lv_obj_align(btn, LV_ALIGN_TOP_LEFT, 3, 3);
-    lv_obj_set_style_border_width(btn, 0, LV_PART_MAIN);
-    lv_obj_set_style_shadow_width(btn, 0, LV_PART_MAIN);
-    lv_obj_set_style_border_color(btn, DECKPRO_COLOR_FG, LV_PART_MAIN);
-    lv_obj_set_style_bg_color(btn, DECKPRO_COLOR_BG, LV_PART_MAIN);
     lv_obj_add_event_cb(btn, cb, LV_EVENT_CLICKED, NULL);
 
     lv_obj_t *label2 = lv_label_create(btn);
     lv_obj_align(label2, LV_ALIGN_LEFT_MID, 0, 0);
-    lv_obj_set_style_text_color(label2, DECKPRO_COLOR_FG, LV_PART_MAIN);
     lv_label_set_text(label2, LV_SYMBOL_LEFT);
 
     lv_obj_t *label = lv_label_create(parent);
     lv_obj_align_to(label, label2, LV_ALIGN_OUT_RIGHT_MID, 5, -1);
-    lv_obj_set_style_text_font(label, FONT_BOLD_MONO_SIZE_15, LV_PART_MAIN);
-    lv_obj_set_style_text_color(label, DECKPRO_COLOR_FG, LV_PART_MAIN);
+    UI_STYLE(label, ui_style_title, LV_PART_MAIN);
     lv_label_set_text(label, text);
     lv_obj_add_flag(label, LV_OBJ_FLAG_CLICKABLE);
     lv_obj_add_event_cb(label, cb, LV_EVENT_CLICKED, NULL);
     lv_obj_set_ext_click_area(label, 20);
 
-    return label;
-}
-
-static const char *line_full_format(int max_c, const char *str1, const char *str2)
-{
-    int len1 = 0, len2 = 0;
-    int j;
-
-    len1 = strlen(str1);
-
-    strncpy(global_buf, str1, len1);
-
-    len2 = strlen(str2);
-    for(j = len1; j < max_c -1 - len2; j++){
-        global_buf[j] = ' ';
-    }
-    strncpy(global_buf + j, str2, len2);
-    j = j + len2;
-    
-    global_buf[j] = '\0'; 
-
-    printf("[%d] buf: %s\n", __LINE__, global_buf);
+    // Drawn once per screen; the content below no longer repaints it
+    lvgl_layers_add_static(btn);
+    lvgl_layers_add_static(label);
 
-    return (const char *)global_buf;
+    return label;
 }
 
 #endif
@@ -95,7 +83,7 @@ static const char *line_full_format(int max_c, const char *str1, const char *str
 
 static ui_indev_read_cb ui_get_gesture_dir = NULL;
 
-// Menu container for 2-column layout
+// Menu container: status widget and launcher grid
 static lv_obj_t *menu_list = NULL;
 
 static lv_obj_t *menu_screen1;
@@ -117,62 +105,77 @@ static lv_obj_t * status_widget_network_label = NULL; // 4G status (top right)
 static lv_obj_t * status_widget_time_label = NULL;
 static lv_obj_t * status_widget_wifi_label = NULL; // WiFi status (bottom right)
 
+// Status widget data model, values are quantised before comparison
+typedef struct {
+    int8_t battery;     // percent in UI_STATUS_BATTERY_STEP steps
+    int8_t charging;
+    int8_t network;     // 4G state
+    int8_t wifi_bars;   // 0..4, -1 when disconnected
+    int16_t minute;     // minutes since midnight, -1 when the clock is not set
+} ui_status_model_t;
+static ui_status_model_t status_shown;
+
 static int page_num = 0;
 static int page_curr = 0;
 
-// Hierarchical menu structure with folder support
-#define MENU_TYPE_SCREEN 0
-#define MENU_TYPE_FOLDER 1
-#define MENU_TYPE_STATUS_WIDGET 2
+// Hierarchical menu: the launcher grid shows the app index entries of the
+// current folder, these built-in ones first and installed plugins after them
 #define SETTINGS_FOLDER_ID UI_SETTINGS_FOLDER_ID
-#define STATUS_WIDGET_ID UI_STATUS_WIDGET_ID
-
-static struct menu_item {
-    int id;
-    int type; // MENU_TYPE_SCREEN, MENU_TYPE_FOLDER, or MENU_TYPE_STATUS_WIDGET
-    const char *name;
-    int parent_folder; // 0 = main menu, SETTINGS_FOLDER_ID = settings folder
-} menu_items[] = {
-    // Main menu items - order matters for layout (status widget first, then 2-column buttons)
-    {STATUS_WIDGET_ID,  MENU_TYPE_STATUS_WIDGET, "Status", 0},
-    {SCREEN1_ID,        MENU_TYPE_SCREEN, "Meshtastic", 0},
-    {SETTINGS_FOLDER_ID, MENU_TYPE_FOLDER, "Settings",   0},
+
+static app_entry_t menu_items[] = {
+    // kind, icon, folder, target, name
+    {APP_KIND_SCREEN, ICON_LORA,    0, SCREEN1_ID,         "Meshtastic"},
+    {APP_KIND_SCREEN, ICON_SD,      0, SCREEN11_ID,        "Search"},
+    {APP_KIND_SCREEN, ICON_SD,      0, SCREEN12_ID,        "Files"},
+    {APP_KIND_FOLDER, ICON_SETTING, 0, SETTINGS_FOLDER_ID, "Settings"},
 
     // Settings folder items (renamed current "Settings" to "About")
-    {SCREEN2_ID,  MENU_TYPE_SCREEN, "About",     SETTINGS_FOLDER_ID},
-    {SCREEN3_ID,  MENU_TYPE_SCREEN, "GPS",       SETTINGS_FOLDER_ID},
-    {SCREEN4_ID,  MENU_TYPE_SCREEN, "WiFi",      SETTINGS_FOLDER_ID},
-    {SCREEN5_ID,  MENU_TYPE_SCREEN, "Test",      SETTINGS_FOLDER_ID},
-    {SCREEN6_ID,  MENU_TYPE_SCREEN, "Battery",   SETTINGS_FOLDER_ID},
-    {SCREEN7_ID,  MENU_TYPE_SCREEN, "Input",     SETTINGS_FOLDER_ID},
-    {SCREEN8_ID,  MENU_TYPE_SCREEN, "A7682E",    SETTINGS_FOLDER_ID},
-    {SCREEN9_ID,  MENU_TYPE_SCREEN, "Shutdown",  SETTINGS_FOLDER_ID},
-    {SCREEN10_ID, MENU_TYPE_SCREEN, "PCM5102",   SETTINGS_FOLDER_ID}
+    {APP_KIND_SCREEN, ICON_SD,      SETTINGS_FOLDER_ID, SCREEN2_ID,  "About"},
+    {APP_KIND_SCREEN, ICON_GPS,     SETTINGS_FOLDER_ID, SCREEN3_ID,  "GPS"},
+    {APP_KIND_SCREEN, ICON_WIFI,    SETTINGS_FOLDER_ID, SCREEN4_ID,  "WiFi"},
+    {APP_KIND_SCREEN, ICON_TEST,    SETTINGS_FOLDER_ID, SCREEN5_ID,  "Test"},
+    {APP_KIND_SCREEN, ICON_BATT,    SETTINGS_FOLDER_ID, SCREEN6_ID,  "Battery"},
+    {APP_KIND_SCREEN, ICON_TOUCH,   SETTINGS_FOLDER_ID, SCREEN7_ID,  "Input"},
+    {APP_KIND_SCREEN, ICON_A7682E,  SETTINGS_FOLDER_ID, SCREEN8_ID,  "A7682E"},
+    {APP_KIND_SCREEN, ICON_BATT,    SETTINGS_FOLDER_ID, SCREEN9_ID,  "Shutdown"},
+    {APP_KIND_SCREEN, ICON_PCM5102, SETTINGS_FOLDER_ID, SCREEN10_ID, "PCM5102"}
 };
 
 // Current folder state
 static int current_folder = 0; // 0 = main menu
 
+// Entries of current_folder, a slice of the app index
+static lv_obj_t *menu_grid = NULL;
+static const app_entry_t *menu_entries = NULL;
+static int menu_entry_cnt = 0;
+
 // Forward declaration
-static void create_menu_items();
+static void show_menu_folder();
 static void update_taskbar_breadcrumb();
+static void status_model_invalidate(void);
 
-static void menu_item_event_cb(lv_event_t *e)
-{
-    struct menu_item *item = (struct menu_item *)lv_event_get_user_data(e);
-    if(item) {
-        if(item->type == MENU_TYPE_FOLDER) {
-            // Navigate into folder
-            current_folder = item->id;
-            create_menu_items(); // Refresh menu to show folder contents
-            update_taskbar_breadcrumb(); // Update breadcrumb in taskbar
-        } else if(item->type == MENU_TYPE_STATUS_WIDGET) {
-            // Status widget does nothing when clicked - just a display widget
-            return;
-        } else {
-            // Navigate to screen
-            scr_mgr_push(item->id, false);
+static void menu_grid_item_cb(uint32_t index, const char **name, const lv_img_dsc_t **icon, void *user_data)
+{
+    const app_entry_t *item = &menu_entries[index];
+    *name = item->name;
+    *icon = &img_icons_1bpp[(item->icon < ICON_ATLAS_COUNT) ? (uint32_t)item->icon : (uint32_t)APP_INDEX_PLUGIN_ICON];
+}
+
+static void menu_grid_open_cb(uint32_t index, void *user_data)
+{
+    const app_entry_t *item = &menu_entries[index];
+    if(item->kind == APP_KIND_FOLDER) {
+        // Navigate into folder
+        current_folder = item->target;
+        show_menu_folder();
+        update_taskbar_breadcrumb(); // Update breadcrumb in taskbar
+    } else if(item->kind == APP_KIND_PLUGIN) {
+        if(!plugin_launch(item->name)) {
+            LOG_WARNF("UI", "Plugin %s not started", item->name);
         }
+    } else {
+        // Navigate to screen
+        scr_mgr_push(item->target, false);
     }
 }
 
@@ -180,123 +183,164 @@ static void back_button_event_cb(lv_event_t *e)
 {
     // Navigate back to main menu
     current_folder = 0;
-    create_menu_items(); // Refresh menu to show main menu
+    show_menu_folder(); // Refresh menu to show main menu
     update_taskbar_breadcrumb(); // Update breadcrumb in taskbar
 }
 
-// Forward declaration
-static void create_menu_items();
+static void menu_gesture_cb(int dir)
+{
+    if(!menu_grid) return;
 
-// No pagination needed - single 2-column layout shows all items
+    if(dir == LV_DIR_LEFT) {
+        ui_launcher_page(menu_grid, 1);
+    } else if(dir == LV_DIR_RIGHT) {
+        ui_launcher_page(menu_grid, -1);
+    }
+}
+
+static void create_status_widget(lv_obj_t *parent)
+{
+    lv_obj_t *btn = lv_btn_create(parent);
+
+    // Status widget gets special styling and layout - full width, compact 2x2 grid
+    lv_obj_set_size(btn, lv_pct(100), UI_STATUS_WIDGET_HEIGHT); // Full width, compact height
+    lv_obj_set_style_text_font(btn, UI_FONT_STATUS_WIDGET, LV_PART_MAIN);
+    lv_obj_set_style_bg_color(btn, lv_color_hex(UI_COLOR_STATUS_WIDGET_BG), LV_PART_MAIN); // Light gray background
+    lv_obj_set_style_bg_color(btn, lv_color_hex(UI_COLOR_BG_PRESSED), LV_PART_MAIN | LV_STATE_PRESSED);
+    lv_obj_set_style_text_color(btn, lv_color_hex(UI_COLOR_STATUS_WIDGET_FG), LV_PART_MAIN);
+    lv_obj_set_style_text_color(btn, lv_color_hex(UI_COLOR_FG_PRESSED), LV_PART_MAIN | LV_STATE_PRESSED);
+    lv_obj_set_style_border_width(btn, UI_STATUS_WIDGET_BORDER, LV_PART_MAIN);
+    lv_obj_set_style_border_color(btn, lv_color_hex(UI_COLOR_STATUS_BORDER), LV_PART_MAIN);
+    lv_obj_set_style_radius(btn, UI_STATUS_WIDGET_RADIUS, LV_PART_MAIN);
+    lv_obj_set_style_pad_all(btn, UI_STATUS_WIDGET_PADDING, LV_PART_MAIN);
+
+    // Create 2x2 grid layout: [BATTERY] [4G]
+    //                        [TIME]    [WiFi]
+
+    // Battery status label (top left)
+    status_widget_battery_label = lv_label_create(btn);
+    lv_obj_set_style_text_font(status_widget_battery_label, UI_FONT_STATUS_WIDGET, LV_PART_MAIN);
+    lv_label_set_text(status_widget_battery_label, "Batt 100%+");
+    lv_obj_align(status_widget_battery_label, LV_ALIGN_TOP_LEFT, UI_STATUS_WIDGET_PADDING, 2);
+
+    // 4G status label (top right)
+    status_widget_network_label = lv_label_create(btn);
+    lv_obj_set_style_text_font(status_widget_network_label, UI_FONT_STATUS_WIDGET, LV_PART_MAIN);
+    lv_label_set_text(status_widget_network_label, "4G x");
+    lv_obj_align(status_widget_network_label, LV_ALIGN_TOP_RIGHT, -UI_STATUS_WIDGET_PADDING, 2);
+
+    // Time label (bottom left)
+    status_widget_time_label = lv_label_create(btn);
+    lv_obj_set_style_text_font(status_widget_time_label, UI_FONT_STATUS_WIDGET, LV_PART_MAIN);
+    lv_label_set_text(status_widget_time_label, "10:19am");
+    lv_obj_align(status_widget_time_label, LV_ALIGN_BOTTOM_LEFT, UI_STATUS_WIDGET_PADDING, -2);
+
+    // WiFi status label (bottom right)
+    status_widget_wifi_label = lv_label_create(btn);
+    lv_obj_set_style_text_font(status_widget_wifi_label, UI_FONT_STATUS_WIDGET, LV_PART_MAIN);
+    lv_label_set_text(status_widget_wifi_label, "WiFi ^");
+    lv_obj_align(status_widget_wifi_label, LV_ALIGN_BOTTOM_RIGHT, -UI_STATUS_WIDGET_PADDING, -2);
+
+    status_widget_btn = btn; // Store reference for updates
+    status_model_invalidate();
+}
 
 static void create_main_menu_list(lv_obj_t *parent)
 {
-    // Create flex container for 2-column layout
+    // Status widget on top, the launcher grid takes the rest
     menu_list = lv_obj_create(parent);
     lv_obj_set_size(menu_list, lv_pct(100), LV_VER_RES - UI_TASKBAR_HEIGHT); // Full width, minus taskbar height
     lv_obj_align(menu_list, LV_ALIGN_BOTTOM_MID, 0, 0);
     lv_obj_set_style_pad_all(menu_list, UI_MENU_PADDING, LV_PART_MAIN);
     lv_obj_set_style_border_width(menu_list, 0, LV_PART_MAIN);
+    lv_obj_set_scrollbar_mode(menu_list, LV_SCROLLBAR_MODE_OFF);
+    lv_obj_clear_flag(menu_list, LV_OBJ_FLAG_SCROLLABLE);
+    lv_obj_set_flex_flow(menu_list, LV_FLEX_FLOW_COLUMN);
+    lv_obj_set_style_pad_row(menu_list, UI_MENU_PADDING, LV_PART_MAIN);
+
+    create_status_widget(menu_list);
 
-    // Set up flex layout for 2 columns
-    lv_obj_set_flex_flow(menu_list, LV_FLEX_FLOW_ROW_WRAP);
-    lv_obj_set_flex_align(menu_list, LV_FLEX_ALIGN_SPACE_EVENLY, LV_FLEX_ALIGN_START, LV_FLEX_ALIGN_START);
-    lv_obj_set_style_pad_row(menu_list, UI_MENU_PADDING, LV_PART_MAIN); // Vertical spacing between rows
-    lv_obj_set_style_pad_column(menu_list, UI_BUTTON_SPACING, LV_PART_MAIN); // Horizontal spacing between columns
+    menu_grid = ui_launcher_create(menu_list, APP_GRID_COLS, APP_GRID_ROWS, ICON_ATLAS_SIZE,
+                                   menu_grid_item_cb, menu_grid_open_cb, NULL);
+    lv_obj_set_width(menu_grid, lv_pct(100));
+    lv_obj_set_flex_grow(menu_grid, 1);
+    lv_obj_set_style_pad_all(menu_grid, 0, LV_PART_MAIN);
+    lv_obj_set_style_border_width(menu_grid, 0, LV_PART_MAIN);
+    lv_obj_set_style_text_font(menu_grid, UI_FONT_LAUNCHER, LV_PART_MAIN);
 
-    // Create all menu items in 2-column layout
-    create_menu_items();
+    show_menu_folder();
 }
 
-static void create_menu_items()
+static void show_menu_folder()
 {
-    // Critical safety check: Early exit if menu list doesn't exist
-    if(!menu_list) return;
+    // Critical safety check: Early exit if the grid doesn't exist
+    if(!menu_grid || !lv_obj_is_valid(menu_grid)) return;
 
-    // Critical safety check: Verify menu_list is still valid before cleaning
-    if(!lv_obj_is_valid(menu_list)) {
-        return;
+    menu_entry_cnt = app_index_folder(current_folder, &menu_entries);
+
+    // Screens reachable from this folder are the candidates for idle pre-instantiation
+    int hint_ids[APP_INDEX_MAX_ENTRIES];
+    int hint_cnt = 0;
+    for(int i = 0; i < menu_entry_cnt; i++) {
+        if(menu_entries[i].kind == APP_KIND_SCREEN) {
+            hint_ids[hint_cnt++] = menu_entries[i].target;
+        }
     }
+    scr_mgr_set_next_hint(hint_ids, hint_cnt);
 
-    // Clear existing items
-    lv_obj_clean(menu_list);
-
-    // Breadcrumb navigation is now handled in the taskbar
-
-    // Create menu items for current folder
-    for(int i = 0; i < MENU_ITEM_COUNT; i++) {
-        // Only show items that belong to the current folder
-        if(menu_items[i].parent_folder != current_folder) continue;
-
-        lv_obj_t *btn = lv_btn_create(menu_list);
-
-        // Special handling for status widget
-        if(menu_items[i].type == MENU_TYPE_STATUS_WIDGET) {
-            // Status widget gets special styling and layout - full width, compact 2x2 grid
-            lv_obj_set_size(btn, lv_pct(100), UI_STATUS_WIDGET_HEIGHT); // Full width, compact height
-            lv_obj_set_style_text_font(btn, UI_FONT_STATUS_WIDGET, LV_PART_MAIN);
-            lv_obj_set_style_bg_color(btn, lv_color_hex(UI_COLOR_STATUS_WIDGET_BG), LV_PART_MAIN); // Light gray background
-            lv_obj_set_style_bg_color(btn, lv_color_hex(UI_COLOR_BG_PRESSED), LV_PART_MAIN | LV_STATE_PRESSED);
-            lv_obj_set_style_text_color(btn, lv_color_hex(UI_COLOR_STATUS_WIDGET_FG), LV_PART_MAIN);
-            lv_obj_set_style_text_color(btn, lv_color_hex(UI_COLOR_FG_PRESSED), LV_PART_MAIN | LV_STATE_PRESSED);
-            lv_obj_set_style_border_width(btn, UI_STATUS_WIDGET_BORDER, LV_PART_MAIN);
-            lv_obj_set_style_border_color(btn, lv_color_hex(UI_COLOR_STATUS_BORDER), LV_PART_MAIN);
-            lv_obj_set_style_radius(btn, UI_STATUS_WIDGET_RADIUS, LV_PART_MAIN);
-            lv_obj_set_style_pad_all(btn, UI_STATUS_WIDGET_PADDING, LV_PART_MAIN);
-
-            // Create 2x2 grid layout: [BATTERY] [4G]
-            //                        [TIME]    [WiFi]
-
-            // Battery status label (top left)
-            status_widget_battery_label = lv_label_create(btn);
-            lv_obj_set_style_text_font(status_widget_battery_label, UI_FONT_STATUS_WIDGET, LV_PART_MAIN);
-            lv_label_set_text(status_widget_battery_label, "Batt 100%+");
-            lv_obj_align(status_widget_battery_label, LV_ALIGN_TOP_LEFT, UI_STATUS_WIDGET_PADDING, 2);
-
-            // 4G status label (top right)
-            status_widget_network_label = lv_label_create(btn);
-            lv_obj_set_style_text_font(status_widget_network_label, UI_FONT_STATUS_WIDGET, LV_PART_MAIN);
-            lv_label_set_text(status_widget_network_label, "4G x");
-            lv_obj_align(status_widget_network_label, LV_ALIGN_TOP_RIGHT, -UI_STATUS_WIDGET_PADDING, 2);
-
-            // Time label (bottom left)
-            status_widget_time_label = lv_label_create(btn);
-            lv_obj_set_style_text_font(status_widget_time_label, UI_FONT_STATUS_WIDGET, LV_PART_MAIN);
-            lv_label_set_text(status_widget_time_label, "10:19am");
-            lv_obj_align(status_widget_time_label, LV_ALIGN_BOTTOM_LEFT, UI_STATUS_WIDGET_PADDING, -2);
-
-            // WiFi status label (bottom right)
-            status_widget_wifi_label = lv_label_create(btn);
-            lv_obj_set_style_text_font(status_widget_wifi_label, UI_FONT_STATUS_WIDGET, LV_PART_MAIN);
-            lv_label_set_text(status_widget_wifi_label, "WiFi ^");
-            lv_obj_align(status_widget_wifi_label, LV_ALIGN_BOTTOM_RIGHT, -UI_STATUS_WIDGET_PADDING, -2);
-
-            status_widget_btn = btn; // Store reference for updates
+    // The status widget belongs to the main menu; hidden, it leaves the grid more rows
+    if(status_widget_btn) {
+        if(current_folder == 0) {
+            lv_obj_clear_flag(status_widget_btn, LV_OBJ_FLAG_HIDDEN);
         } else {
-            // Regular menu items
-            lv_obj_set_size(btn, lv_pct(UI_BUTTON_WIDTH_PERCENT), UI_BUTTON_HEIGHT); // Configurable width for 2 columns
-            lv_obj_set_style_text_font(btn, UI_FONT_BUTTON, LV_PART_MAIN);
-            lv_obj_set_style_bg_color(btn, lv_color_hex(UI_COLOR_BG_PRESSED), LV_PART_MAIN | LV_STATE_PRESSED);
-            lv_obj_set_style_text_color(btn, lv_color_hex(UI_COLOR_FG_PRESSED), LV_PART_MAIN | LV_STATE_PRESSED);
-            lv_obj_set_style_border_width(btn, 1, LV_PART_MAIN);
-            lv_obj_set_style_border_color(btn, lv_color_hex(UI_COLOR_FG_NORMAL), LV_PART_MAIN);
-            lv_obj_set_style_radius(btn, 5, LV_PART_MAIN);
-
-            // Add folder indicator for folder items
-            lv_obj_t *label = lv_label_create(btn);
-            if(menu_items[i].type == MENU_TYPE_FOLDER) {
-                lv_label_set_text_fmt(label, "%s >", menu_items[i].name);
-            } else {
-                lv_label_set_text(label, menu_items[i].name);
-            }
-            lv_obj_center(label);
+            lv_obj_add_flag(status_widget_btn, LV_OBJ_FLAG_HIDDEN);
         }
+    }
+
+    // Back to the first page, redrawn as one area
+    ui_launcher_set_count(menu_grid, menu_entry_cnt);
+}
+
+static int status_quantise_battery(int percent)
+{
+    // Round to the nearest step so gauge jitter does not repaint the label
+    int q = ((percent + UI_STATUS_BATTERY_STEP / 2) / UI_STATUS_BATTERY_STEP) * UI_STATUS_BATTERY_STEP;
+    return (q > 100) ? 100 : (q < 0 ? 0 : q);
+}
+
+static int status_rssi_to_bars(int rssi)
+{
+    if(rssi >= -55) return 4;
+    if(rssi >= -67) return 3;
+    if(rssi >= -78) return 2;
+    if(rssi >= -89) return 1;
+    return 0;
+}
+
+static void status_model_sample(ui_status_model_t *m)
+{
+    // Batch read hardware values to reduce I2C calls
+    m->battery = status_quantise_battery(ui_battery_27220_get_percent());
+    m->charging = ui_battery_27220_get_input();
+    m->network = 0; // 4G status is static for now
+
+    bool wifi_connected = (WiFi.status() == WL_CONNECTED);
+    m->wifi_bars = wifi_connected ? status_rssi_to_bars(WiFi.RSSI()) : -1;
 
-        // Add event callback
-        lv_obj_add_event_cb(btn, menu_item_event_cb, LV_EVENT_CLICKED, (void *)&menu_items[i]);
+    struct tm timeinfo;
+    if(getLocalTime(&timeinfo, 0)) {
+        m->minute = timeinfo.tm_hour * 60 + timeinfo.tm_min;
+    } else {
+        m->minute = -1;
     }
 }
 
+static void status_model_invalidate(void)
+{
+    // New labels were created, so every field has to be written once
+    memset(&status_shown, 0x80, sizeof(status_shown));
+}
+
 static void update_status_widget()
 {
     // Performance optimization: Fast exit if widgets don't exist
@@ -305,74 +349,52 @@ static void update_status_widget()
         return;
     }
 
-    // Static variables to track previous values and avoid unnecessary updates
-    static int prev_percent = -1;
-    static bool prev_charging = false;
-    static bool prev_wifi = false;
-    static int prev_hour = -1;
-    static int prev_min = -1;
-    static bool network_set = false;
-    static bool fallback_set = false;
     static char battery_text[16]; // Pre-allocated buffer to avoid malloc
-    static char time_text[12];    // Pre-allocated buffer to avoid malloc
+    static char wifi_text[12];
+    static char time_text[12];
+    ui_status_model_t now;
+
+    status_model_sample(&now);
 
-    // Performance optimization: Batch read hardware values to reduce I2C calls
-    int percent = ui_battery_27220_get_percent();
-    bool charging = ui_battery_27220_get_input();
+    // Only labels whose quantised value changed are touched, and all of them in
+    // this one call, so LVGL invalidates just those areas and the display
+    // scheduler sends them to the panel as a single partial refresh
+    if(now.battery != status_shown.battery || now.charging != status_shown.charging) {
+        snprintf(battery_text, sizeof(battery_text), "Batt %d%%%c", now.battery, now.charging ? '+' : '-');
+        lv_label_set_text_static(status_widget_battery_label, battery_text);
+    }
 
-    // Update battery status (top left) - only if changed
-    if(percent != prev_percent || charging != prev_charging) {
-        // Performance optimization: Use pre-allocated buffer and avoid format string
-        if(charging) {
-            snprintf(battery_text, sizeof(battery_text), "Batt %d%%+", percent);
+    if(now.network != status_shown.network) {
+        lv_label_set_text_static(status_widget_network_label, "4G x");
+    }
+
+    if(now.wifi_bars != status_shown.wifi_bars) {
+        if(now.wifi_bars < 0) {
+            lv_label_set_text_static(status_widget_wifi_label, "WiFi x");
         } else {
-            snprintf(battery_text, sizeof(battery_text), "Batt %d%%-", percent);
-        }
-        lv_label_set_text(status_widget_battery_label, battery_text);
-        prev_percent = percent;
-        prev_charging = charging;
-    }
-
-    // Update 4G status (top right) - static for now, set only once
-    if(!network_set) {
-        lv_label_set_text(status_widget_network_label, "4G x");
-        network_set = true;
-    }
-
-    // Performance optimization: Check WiFi less frequently to reduce overhead
-    static uint8_t wifi_check_counter = 0;
-    wifi_check_counter++;
-    if(wifi_check_counter >= 3) { // Check WiFi every 3rd call (every 15 seconds)
-        wifi_check_counter = 0;
-        bool wifi_connected = (WiFi.status() == WL_CONNECTED);
-        if(wifi_connected != prev_wifi) {
-            lv_label_set_text(status_widget_wifi_label, wifi_connected ? "WiFi ^" : "WiFi x");
-            prev_wifi = wifi_connected;
+            snprintf(wifi_text, sizeof(wifi_text), "WiFi ^%d", now.wifi_bars);
+            lv_label_set_text_static(status_widget_wifi_label, wifi_text);
         }
     }
 
-    // Update time with AM/PM (bottom left) - only if minute changed
-    struct tm timeinfo;
-    if(getLocalTime(&timeinfo)) {
-        if(timeinfo.tm_hour != prev_hour || timeinfo.tm_min != prev_min) {
-            // Performance optimization: Use pre-allocated buffer
-            int hour12 = timeinfo.tm_hour;
+    if(now.minute != status_shown.minute) {
+        if(now.minute >= 0) {
+            int hour12 = now.minute / 60;
             const char* ampm = "am";
             if(hour12 >= 12) {
                 ampm = "pm";
                 if(hour12 > 12) hour12 -= 12;
             }
             if(hour12 == 0) hour12 = 12; // 12am/12pm
-            snprintf(time_text, sizeof(time_text), "%02d:%02d%s", hour12, timeinfo.tm_min, ampm);
-            lv_label_set_text(status_widget_time_label, time_text);
-            prev_hour = timeinfo.tm_hour;
-            prev_min = timeinfo.tm_min;
+            snprintf(time_text, sizeof(time_text), "%02d:%02d%s", hour12, now.minute % 60, ampm);
+            lv_label_set_text_static(status_widget_time_label, time_text);
+        } else {
+            // Fallback until the clock is set
+            lv_label_set_text_static(status_widget_time_label, "10:19am");
         }
-    } else if(!fallback_set) {
-        // Fallback - only set once
-        lv_label_set_text(status_widget_time_label, "10:19am");
-        fallback_set = true;
     }
+
+    status_shown = now;
 }
 
 static void update_taskbar_breadcrumb()
@@ -404,23 +426,17 @@ static void create0(lv_obj_t *parent)
 {
     menu_taskbar = lv_obj_create(parent);
     lv_obj_set_size(menu_taskbar, LV_HOR_RES, UI_TASKBAR_HEIGHT);
-    lv_obj_set_style_pad_all(menu_taskbar, 0, LV_PART_MAIN);
-    lv_obj_set_style_border_width(menu_taskbar, 0, LV_PART_MAIN);
+    UI_STYLE(menu_taskbar, ui_style_taskbar, LV_PART_MAIN);
     lv_obj_set_scrollbar_mode(menu_taskbar, LV_SCROLLBAR_MODE_OFF);
     lv_obj_clear_flag(menu_taskbar, LV_OBJ_FLAG_SCROLLABLE);
+    lvgl_layers_add_static(menu_taskbar);
 
     // Create breadcrumb button (initially hidden)
     menu_taskbar_breadcrumb = lv_btn_create(menu_taskbar);
     lv_obj_set_size(menu_taskbar_breadcrumb, 100, UI_TASKBAR_HEIGHT - 4); // Wider for full text
     lv_obj_align(menu_taskbar_breadcrumb, LV_ALIGN_LEFT_MID, 2, 0);
-    lv_obj_set_style_text_font(menu_taskbar_breadcrumb, UI_FONT_BREADCRUMB, LV_PART_MAIN);
-    lv_obj_set_style_bg_color(menu_taskbar_breadcrumb, lv_color_hex(UI_COLOR_BREADCRUMB_BG), LV_PART_MAIN);
-    lv_obj_set_style_bg_color(menu_taskbar_breadcrumb, lv_color_hex(UI_COLOR_BG_PRESSED), LV_PART_MAIN | LV_STATE_PRESSED);
-    lv_obj_set_style_text_color(menu_taskbar_breadcrumb, lv_color_hex(UI_COLOR_FG_NORMAL), LV_PART_MAIN);
-    lv_obj_set_style_text_color(menu_taskbar_breadcrumb, lv_color_hex(UI_COLOR_FG_PRESSED), LV_PART_MAIN | LV_STATE_PRESSED);
-    lv_obj_set_style_border_width(menu_taskbar_breadcrumb, 1, LV_PART_MAIN);
-    lv_obj_set_style_border_color(menu_taskbar_breadcrumb, lv_color_hex(UI_COLOR_BREADCRUMB_BORDER), LV_PART_MAIN);
-    lv_obj_set_style_radius(menu_taskbar_breadcrumb, 3, LV_PART_MAIN);
+    UI_STYLE(menu_taskbar_breadcrumb, ui_style_breadcrumb, LV_PART_MAIN);
+    UI_STYLE(menu_taskbar_breadcrumb, ui_style_breadcrumb_pr, LV_PART_MAIN | LV_STATE_PRESSED);
     lv_obj_add_flag(menu_taskbar_breadcrumb, LV_OBJ_FLAG_HIDDEN); // Initially hidden
     lv_obj_add_event_cb(menu_taskbar_breadcrumb, back_button_event_cb, LV_EVENT_CLICKED, NULL);
 
@@ -433,16 +449,9 @@ static void create0(lv_obj_t *parent)
 
     lv_obj_t *status_parent = lv_obj_create(menu_taskbar);
     lv_obj_set_size(status_parent, 100, UI_TASKBAR_HEIGHT-2); // Fixed width for status icons
-    lv_obj_set_style_pad_all(status_parent, 0, LV_PART_MAIN);
-    lv_obj_set_style_border_width(status_parent, 0, LV_PART_MAIN);
+    UI_STYLE(status_parent, ui_style_taskbar_status, LV_PART_MAIN);
     lv_obj_set_flex_flow(status_parent, LV_FLEX_FLOW_ROW);
     lv_obj_set_flex_align(status_parent, LV_FLEX_ALIGN_END, LV_FLEX_ALIGN_CENTER, LV_FLEX_ALIGN_CENTER);
-    lv_obj_set_style_pad_left(status_parent, 0, LV_PART_MAIN | LV_STATE_DEFAULT);
-    lv_obj_set_style_pad_right(status_parent, 5, LV_PART_MAIN | LV_STATE_DEFAULT);
-    lv_obj_set_style_pad_top(status_parent, 0, LV_PART_MAIN | LV_STATE_DEFAULT);
-    lv_obj_set_style_pad_bottom(status_parent, 0, LV_PART_MAIN | LV_STATE_DEFAULT);
-    lv_obj_set_style_pad_row(status_parent, 0, LV_PART_MAIN | LV_STATE_DEFAULT);
-    lv_obj_set_style_pad_column(status_parent, 5, LV_PART_MAIN | LV_STATE_DEFAULT);
     lv_obj_set_scrollbar_mode(status_parent, LV_SCROLLBAR_MODE_OFF);
     lv_obj_clear_flag(status_parent, LV_OBJ_FLAG_SCROLLABLE);
     lv_obj_align(status_parent, LV_ALIGN_RIGHT_MID, 0, 0);
@@ -486,15 +495,19 @@ static void create0(lv_obj_t *parent)
         // Update menu item for PCM5102 when A7682E is not available
         for(int i = 0; i < MENU_ITEM_COUNT; i++)
         {
-            if(menu_items[i].id == SCREEN8_ID)
+            if(menu_items[i].target == SCREEN8_ID)
             {
-                menu_items[i].id = SCREEN10_ID;
-                menu_items[i].name = "PCM5102";
+                menu_items[i].target = SCREEN10_ID;
+                menu_items[i].icon = ICON_PCM5102;
+                strncpy(menu_items[i].name, "PCM5102", sizeof(menu_items[i].name));
             }
         }
     }
 
-    // Create the text-only vertical scrolling menu
+    // Stored index unless the table above or the installed plugins changed
+    app_index_begin(menu_items, MENU_ITEM_COUNT);
+
+    // Status widget and launcher grid
     create_main_menu_list(menu_screen1);
 
     // Initialize taskbar layout
@@ -538,7 +551,12 @@ static void create0(lv_obj_t *parent)
 }
 
 static void entry0(void) {
-    ui_get_gesture_dir = NULL; // No pagination needed - single 2-column layout
+    ui_get_gesture_dir = menu_gesture_cb; // Swipe left and right to turn launcher pages
+
+    // Plugins installed while another screen was up
+    if(app_index_refresh()) {
+        show_menu_folder();
+    }
 
     // Critical safety check: Only resume timers if they exist
     if(touch_chk_timer) {
@@ -550,7 +568,7 @@ static void entry0(void) {
 
     // Critical safety check: Only update battery percentage if label exists
     if(menu_taskbar_battery_percent) {
-        lv_label_set_text_fmt(menu_taskbar_battery_percent, "%d%%", ui_battery_27220_get_percent());
+        ui_label_set_fmt(menu_taskbar_battery_percent, "%d%%", ui_battery_27220_get_percent());
     }
 }
 static void exit0(void) {
@@ -596,7 +614,7 @@ static void scr1_list_event(lv_event_t *e)
             {
                 scr_mgr_push(SCREEN1_2_ID, false);
             }
-            printf("%s\n", str);
+            LOG_DEBUGF("UI", "Picked %s", str);
         }
     }
 }
@@ -613,13 +631,8 @@ static void scr1_item_create(const char *name, lv_event_cb_t cb)
     lv_obj_align(label, LV_ALIGN_LEFT_MID, 10, 0);
 
     lv_obj_set_height(obj, LV_VER_RES / 6);
-    lv_obj_set_style_text_font(obj, FONT_BOLD_SIZE_15, LV_PART_MAIN);
-    // lv_obj_set_style_bg_color(obj, lv_color_hex(EPD_COLOR_BG), LV_PART_MAIN);
-    // lv_obj_set_style_text_color(obj, lv_color_hex(EPD_COLOR_FG), LV_PART_MAIN);
-    lv_obj_set_style_border_width(obj, 1, LV_PART_MAIN | LV_STATE_DEFAULT);
-    lv_obj_set_style_border_width(obj, 1, LV_PART_MAIN | LV_STATE_PRESSED);
-    lv_obj_set_style_outline_width(obj, 1, LV_PART_MAIN | LV_STATE_PRESSED);
-    lv_obj_set_style_radius(obj, 10, LV_PART_MAIN | LV_STATE_DEFAULT);
+    UI_STYLE(obj, ui_style_list_item, LV_PART_MAIN | LV_STATE_DEFAULT);
+    UI_STYLE(obj, ui_style_list_item_pr, LV_PART_MAIN | LV_STATE_PRESSED);
 
     lv_obj_add_event_cb(obj, cb, LV_EVENT_CLICKED, NULL); 
 }
@@ -637,14 +650,7 @@ static void create1(lv_obj_t *parent)
     scr1_list = lv_list_create(parent);
     lv_obj_set_size(scr1_list, lv_pct(93), lv_pct(91));
     lv_obj_align(scr1_list, LV_ALIGN_BOTTOM_MID, 0, 0);
-    // lv_obj_set_style_bg_color(scr1_list, lv_color_hex(EPD_COLOR_BG), LV_PART_MAIN);
-    lv_obj_set_style_pad_top(scr1_list, 10, LV_PART_MAIN);
-    lv_obj_set_style_pad_row(scr1_list, 15, LV_PART_MAIN);
-    lv_obj_set_style_radius(scr1_list, 0, LV_PART_MAIN);
-    // lv_obj_set_style_outline_pad(scr1_list, 1, LV_PART_MAIN);
-    lv_obj_set_style_border_width(scr1_list, 0, LV_PART_MAIN);
-    // lv_obj_set_style_border_color(scr1_list, lv_color_hex(EPD_COLOR_FG), LV_PART_MAIN);
-    lv_obj_set_style_shadow_width(scr1_list, 0, LV_PART_MAIN);
+    UI_STYLE(scr1_list, ui_style_list, LV_PART_MAIN);
 
     scr1_item_create("- Auto Test", scr1_list_event);
     // scr1_item_create("-Manual Test", scr1_list_event);
@@ -669,15 +675,24 @@ static scr_lifecycle_t screen1 = {
     .destroy = destroy1,
 };
 #endif
-// --------------------- screen 1.1 --------------------- Auto Send
+// --------------------- screen 1.1 --------------------- Send / Recv
 #if 1
 static lv_obj_t *scr1_1_cont;
-static lv_obj_t *lora_lab_buf[11] = {0};
+static lv_obj_t *lora_list;
+static lv_obj_t *lora_compose_ta;
+static lv_obj_t *lora_predict_lab;  // One line of completions above the compose line
+static char lora_predict_words[UI_PREDICT_MAX][UI_PREDICT_WORD_LEN];
+static int lora_predict_cnt = 0;
+static int lora_predict_sel = 0;
+static int lora_predict_prefix = 0; // Letters of the word being completed
+static lv_timer_t *lora_key_timer = NULL;
+static char (*lora_history)[UI_LORA_HISTORY_LEN] = NULL; // ring buffer in PSRAM
+static int lora_history_head = 0;   // next slot to write
+static int lora_history_cnt = 0;
 static lv_obj_t *lora_sw_btn;
 static lv_obj_t *lora_sw_btn_info;
+static lv_obj_t *lora_stats_lab;
 static lv_timer_t *lora_RT_timer = NULL;
-static lv_timer_t *lora_recv_timer = NULL;
-static int lora_cnt = 0;
 
 static void scr1_1_btn_event_cb(lv_event_t * e)
 {
@@ -686,74 +701,183 @@ static void scr1_1_btn_event_cb(lv_event_t * e)
     }
 }
 
+static void lora_history_clear(void)
+{
+    lora_history_head = 0;
+    lora_history_cnt = 0;
+    ui_vlist_set_count(lora_list, 0);
+}
+
+static void lora_history_add(const char *fmt, ...)
+{
+    va_list args;
+
+    if(lora_history == NULL)
+        return;
+
+    va_start(args, fmt);
+    lv_vsnprintf(lora_history[lora_history_head], UI_LORA_HISTORY_LEN, fmt, args);
+    va_end(args);
+
+    lora_history_head = (lora_history_head + 1) % UI_LORA_HISTORY_MAX;
+    if(lora_history_cnt < UI_LORA_HISTORY_MAX)
+        lora_history_cnt++;
+
+    // Newest entry is row 0, set_count rebinds every visible row
+    ui_vlist_set_count(lora_list, lora_history_cnt);
+}
+
+static void lora_history_bind(lv_obj_t *row, uint32_t index, void *user_data)
+{
+    int slot = (lora_history_head - 1 - (int)index + UI_LORA_HISTORY_MAX) % UI_LORA_HISTORY_MAX;
+    lv_label_set_text_static(row, lora_history[slot]);
+}
+
+static void lora_history_load_cb(const char *text, int rssi, bool sent)
+{
+    if(sent)
+        lora_history_add("send-> %s", text);
+    else
+        lora_history_add("recv-> %s [%d]", text, rssi);
+}
+
 static void lora_mode_sw_event(lv_event_t * e)
 {
     if(e->code == LV_EVENT_CLICKED){
         if(ui_lora_get_mode() == LORA_MODE_SEND) {
             ui_lora_set_mode(LORA_MODE_RECV);
             lv_label_set_text(lora_sw_btn_info, "Recv");
-            for(int i = 0; i < GET_BUFF_LEN(lora_lab_buf); i++){
-                lv_label_set_text_fmt(lora_lab_buf[i], " ", i);
-            }
-            lora_cnt = 0;
+            lv_obj_add_flag(lora_compose_ta, LV_OBJ_FLAG_HIDDEN);
+            lv_obj_add_flag(lora_predict_lab, LV_OBJ_FLAG_HIDDEN);
+            lora_history_clear();
+            // Pick up the conversation where it left off, from the message store
+            ui_lora_history(UI_LORA_HISTORY_MAX, lora_history_load_cb);
         } else if(ui_lora_get_mode() == LORA_MODE_RECV) {
             ui_lora_set_mode(LORA_MODE_SEND);
             lv_label_set_text(lora_sw_btn_info, "Send");
-            for(int i = 0; i < GET_BUFF_LEN(lora_lab_buf); i++){
-                lv_label_set_text_fmt(lora_lab_buf[i], " ", i);
-            }
-            lora_cnt = 0;
+            lv_obj_clear_flag(lora_compose_ta, LV_OBJ_FLAG_HIDDEN);
+            lv_obj_clear_flag(lora_predict_lab, LV_OBJ_FLAG_HIDDEN);
+            lora_history_clear();
         }
     }
 }
 
-static void lora_recv_loop_event(lv_timer_t *t)
+// The strip is only set when its text changes: on e-paper every set is a
+// partial refresh of that line
+static void lora_predict_update(void)
+{
+    const char *text = lv_textarea_get_text(lora_compose_ta);
+    int len = strlen(text);
+    int start = len;
+    char strip[UI_PREDICT_MAX * (UI_PREDICT_WORD_LEN + 3)];
+    int pos = 0;
+
+    while(start > 0 && (isalpha((unsigned char)text[start - 1]) || text[start - 1] == '\''))
+        start--;
+    lora_predict_prefix = len - start;
+    lora_predict_cnt = lora_predict_prefix ? ui_lora_predict(text + start, lora_predict_words, UI_PREDICT_MAX) : 0;
+    if(lora_predict_sel >= lora_predict_cnt)
+        lora_predict_sel = 0;
+
+    strip[0] = '\0';
+    for(int i = 0; i < lora_predict_cnt; i++) {
+        pos += lv_snprintf(strip + pos, sizeof(strip) - pos, i == lora_predict_sel ? "[%s] " : " %s  ",
+                           lora_predict_words[i]);
+    }
+    if(strcmp(lv_label_get_text(lora_predict_lab), strip))
+        lv_label_set_text(lora_predict_lab, strip);
+}
+
+// Replace the letters typed so far with the chosen word and a space
+static void lora_predict_accept(void)
+{
+    if(lora_predict_cnt == 0)
+        return;
+    for(int i = 0; i < lora_predict_prefix; i++)
+        lv_textarea_del_char(lora_compose_ta);
+    lv_textarea_add_text(lora_compose_ta, lora_predict_words[lora_predict_sel]);
+    lv_textarea_add_text(lora_compose_ta, " ");
+    lora_predict_sel = 0;
+}
+
+static void lora_compose_send(void)
+{
+    const char *text = lv_textarea_get_text(lora_compose_ta);
+
+    if(text[0] == '\0')
+        return;
+    lora_history_add("send-> %s", text);
+    ui_lora_send(text);
+    lv_textarea_set_text(lora_compose_ta, "");
+}
+
+// Typed on the keypad in send mode: Enter sends, Tab moves along the
+// candidates and Right takes one. Keys that came in since the last tick
+// are applied together, so the strip is looked up and redrawn once
+static void lora_key_timer_event(lv_timer_t *t)
 {
-    ui_lora_recv_loop();
+    char key;
+    bool changed = false;
+
+    while(ui_input_get_keypay_val(&key) > 0) {
+        ui_input_set_keypay_flag();
+        if(ui_lora_get_mode() != LORA_MODE_SEND)
+            continue;
+        if(key == LV_KEY_ENTER) {
+            lora_compose_send();
+        } else if(key == LV_KEY_BACKSPACE) {
+            lv_textarea_del_char(lora_compose_ta);
+            lora_predict_sel = 0;
+        } else if(key == LV_KEY_NEXT) {
+            if(lora_predict_cnt > 0)
+                lora_predict_sel = (lora_predict_sel + 1) % lora_predict_cnt;
+        } else if(key == LV_KEY_RIGHT) {
+            lora_predict_accept();
+        } else if(key >= ' ' && key <= '~') {
+            char str[2] = {key, '\0'};
+            lv_textarea_add_text(lora_compose_ta, str);
+            lora_predict_sel = 0;
+        } else {
+            continue;
+        }
+        changed = true;
+    }
+    if(changed)
+        lora_predict_update();
 }
 
 static void lora_RT_timer_event(lv_timer_t *t)
 {
-    static int data = 0;
-    char buf[32];
+    char buf[40];
     const char *recv_info = NULL;
     int recv_rssi = 0;
     
-    if(ui_lora_get_mode() == LORA_MODE_SEND) 
-    {
-        lv_snprintf(buf, 32, "DeckPro #%d", data++);
-        lv_label_set_text_fmt(lora_lab_buf[lora_cnt], "send-> %s", buf);
-        ui_lora_send(buf);
-
-        lora_cnt++;
-        if(lora_cnt >= GET_BUFF_LEN(lora_lab_buf)) {
-            lora_cnt = 0;
-        }
-    }
-    else if(ui_lora_get_mode() == LORA_MODE_RECV)
+    if(ui_lora_get_mode() == LORA_MODE_RECV)
     {
-        if(ui_lora_get_recv(&recv_info, &recv_rssi))
+        // drain the queue; the text lives in the rx slot until it is popped
+        while(ui_lora_get_recv(&recv_info, &recv_rssi))
         {
+            lora_history_add("recv-> %s [%d]", recv_info, recv_rssi);
             ui_lora_set_recv_flag();
-            lv_label_set_text_fmt(lora_lab_buf[lora_cnt], "recv-> %s [%d]", recv_info, recv_rssi);
-
-            lora_cnt++;
-            if(lora_cnt >= GET_BUFF_LEN(lora_lab_buf)) {
-                lora_cnt = 0;
-            }
         }
     }
+
+    ui_lora_get_stats(buf, sizeof(buf));
+    lv_label_set_text(lora_stats_lab, buf);
 }
 
 static lv_obj_t * scr2_create_label(lv_obj_t *parent)
 {
     lv_obj_t *label = lv_label_create(parent);
     lv_obj_set_width(label, LV_HOR_RES - 26);
-    lv_obj_set_style_text_font(label, FONT_BOLD_SIZE_15, LV_PART_MAIN);   
-    lv_obj_set_style_border_width(label, 0, LV_PART_MAIN);
+    UI_STYLE(label, ui_style_text, LV_PART_MAIN);
     lv_label_set_long_mode(label, LV_LABEL_LONG_CLIP);
     return label;
 }
+static lv_obj_t * lora_history_row_create(lv_obj_t *list, void *user_data)
+{
+    return scr2_create_label(list);
+}
 static void create1_1(lv_obj_t *parent) 
 {
     scr1_1_cont = lv_obj_create(parent);
@@ -764,15 +888,38 @@ static void create1_1(lv_obj_t *parent)
     lv_obj_set_style_border_width(scr1_1_cont, 0, LV_PART_MAIN);
     lv_obj_set_style_pad_all(scr1_1_cont, 0, LV_PART_MAIN);
     lv_obj_set_style_pad_left(scr1_1_cont, 13, LV_PART_MAIN);
-    lv_obj_set_flex_flow(scr1_1_cont, LV_FLEX_FLOW_COLUMN);
-    lv_obj_set_style_pad_row(scr1_1_cont, 5, LV_PART_MAIN);
-    lv_obj_set_style_pad_column(scr1_1_cont, 5, LV_PART_MAIN);
     lv_obj_set_align(scr1_1_cont, LV_ALIGN_BOTTOM_MID);
 
-    for(int i = 0; i < GET_BUFF_LEN(lora_lab_buf); i++){
-        lora_lab_buf[i] = scr2_create_label(scr1_1_cont);
-        lv_label_set_text_fmt(lora_lab_buf[i], " ", i);
-    }
+    if(lora_history == NULL) {
+        size_t size = UI_LORA_HISTORY_MAX * UI_LORA_HISTORY_LEN;
+        lora_history = (char (*)[UI_LORA_HISTORY_LEN])heap_caps_malloc(size, MALLOC_CAP_SPIRAM);
+        if(lora_history == NULL)
+            lora_history = (char (*)[UI_LORA_HISTORY_LEN])heap_caps_malloc(size, MALLOC_CAP_8BIT);
+    }
+
+    lora_list = ui_vlist_create(scr1_1_cont, LV_HOR_RES - 13, lv_pct(100), UI_LORA_ROW_HEIGHT,
+                                lora_history_row_create, lora_history_bind, NULL);
+    lv_obj_set_style_bg_color(lora_list, DECKPRO_COLOR_BG, LV_PART_MAIN);
+    lv_obj_set_style_border_width(lora_list, 0, LV_PART_MAIN);
+    lv_obj_set_style_pad_all(lora_list, 0, LV_PART_MAIN);
+    lv_obj_update_layout(scr1_1_cont);
+    lv_obj_set_height(lora_list, lv_obj_get_height(scr1_1_cont) - UI_LORA_COMPOSE_HEIGHT);
+
+    lora_compose_ta = lv_textarea_create(scr1_1_cont);
+    lv_textarea_set_one_line(lora_compose_ta, true);
+    lv_textarea_set_max_length(lora_compose_ta, UI_LORA_COMPOSE_MAX);
+    lv_textarea_set_placeholder_text(lora_compose_ta, "Type, then Enter");
+    lv_obj_set_width(lora_compose_ta, LV_HOR_RES - 26);
+    lv_obj_set_style_text_font(lora_compose_ta, FONT_BOLD_SIZE_15, LV_PART_MAIN);
+    lv_obj_clear_flag(lora_compose_ta, LV_OBJ_FLAG_CLICKABLE);
+    lv_obj_align(lora_compose_ta, LV_ALIGN_BOTTOM_LEFT, 0, -2);
+
+    lora_predict_lab = lv_label_create(scr1_1_cont);
+    lv_obj_set_width(lora_predict_lab, LV_HOR_RES - 26);
+    lv_obj_set_style_text_font(lora_predict_lab, FONT_BOLD_SIZE_14, LV_PART_MAIN);
+    lv_label_set_long_mode(lora_predict_lab, LV_LABEL_LONG_CLIP);
+    lv_label_set_text(lora_predict_lab, "");
+    lv_obj_align_to(lora_predict_lab, lora_compose_ta, LV_ALIGN_OUT_TOP_LEFT, 0, -2);
 
     lora_sw_btn = lv_btn_create(parent);
     lv_obj_set_size(lora_sw_btn, 70, 25);
@@ -791,8 +938,13 @@ static void create1_1(lv_obj_t *parent)
     lv_label_set_text_fmt(lab, "%.1fM", ui_lora_get_freq());
     lv_obj_align(lab, LV_ALIGN_TOP_RIGHT, -10, 10);
 
+    lora_stats_lab = lv_label_create(parent);
+    lv_obj_set_style_text_font(lora_stats_lab, FONT_BOLD_SIZE_14, LV_PART_MAIN);
+    lv_label_set_text(lora_stats_lab, "");
+    lv_obj_align(lora_stats_lab, LV_ALIGN_TOP_MID, 0, 32);
+
     ui_lora_set_mode(LORA_MODE_SEND);
-    lora_cnt = 0;
+    lora_history_clear();
 
     // back
     scr_back_btn_create(parent, ("Meshtastic"), scr1_1_btn_event_cb);
@@ -801,7 +953,7 @@ static void entry1_1(void)
 {
     ui_disp_full_refr();
     lora_RT_timer = lv_timer_create(lora_RT_timer_event, 2000, NULL);
-    lora_recv_timer = lv_timer_create(lora_recv_loop_event, 400, NULL);
+    lora_key_timer = lv_timer_create(lora_key_timer_event, 100, NULL);
 }
 static void exit1_1(void) {
     ui_disp_full_refr();
@@ -809,9 +961,9 @@ static void exit1_1(void) {
         lv_timer_del(lora_RT_timer);
         lora_RT_timer = NULL;
     }
-    if(lora_recv_timer) {
-        lv_timer_del(lora_recv_timer);
-        lora_recv_timer = NULL;
+    if(lora_key_timer) {
+        lv_timer_del(lora_key_timer);
+        lora_key_timer = NULL;
     }
 }
 static void destroy1_1(void) { }
@@ -827,56 +979,81 @@ static scr_lifecycle_t screen1_1 = {
 // --------------------- screen 2.1 --------------------- About System
 #if 1
 static lv_obj_t *scr2_1_cont;
+static lv_obj_t *scr2_1_info;
+static lv_timer_t *scr2_1_sd_timer = NULL;
 
-static void scr2_1_btn_event_cb(lv_event_t * e)
+// The SD figures come from the file service; until its first scan is in they read "..."
+static bool scr2_1_info_update(void)
 {
-    if(e->code == LV_EVENT_CLICKED){
-        scr_mgr_pop(false);
-    }
-}
-
-static void create2_1(lv_obj_t *parent) 
-{
-    lv_obj_t *info = lv_label_create(parent);
-    lv_obj_set_width(info, LV_HOR_RES * 0.9);
-    lv_obj_set_style_text_color(info, DECKPRO_COLOR_FG, LV_PART_MAIN);
-    lv_obj_set_style_text_font(info, &Font_Mono_Bold_14, LV_PART_MAIN);
-    lv_obj_set_style_text_align(info, LV_TEXT_ALIGN_CENTER, 0);
-    lv_label_set_long_mode(info, LV_LABEL_LONG_WRAP);
-
     String str = "";
+    char line[30];
 
     str += "                           \n";
-    str += line_full_format(28, "SF Version:", ui_setting_get_sf_ver());
+    str += ui_label_pad(line, sizeof(line), 27, "SF Version:", ui_setting_get_sf_ver());
     str += "\n                           \n";
 
-    str += line_full_format(28, "HD Version:", ui_setting_get_hd_ver());
+    str += ui_label_pad(line, sizeof(line), 27, "HD Version:", ui_setting_get_hd_ver());
     str += "\n                           \n";
 
     char buf[30];
     uint64_t total=0, used=0;
-    ui_setting_get_sd_capacity(&total, &used);
-    lv_snprintf(buf, 30, "%lluMB", total);
-    str += line_full_format(28, "SD total:", (const char *)buf);
+    bool ready = ui_setting_get_sd_capacity(&total, &used);
+    bool pending = !ready && ui_test_sd_card();
+    if(pending) lv_snprintf(buf, 30, "...");
+    else lv_snprintf(buf, 30, "%lluMB", (unsigned long long)total);
+    str += ui_label_pad(line, sizeof(line), 27, "SD total:", buf);
     str += "\n                           \n";
 
-    lv_snprintf(buf, 30, "%lluMB", used);
-    str += line_full_format(28, "SD used:", (const char *)buf);
+    if(!pending) lv_snprintf(buf, 30, "%lluMB", (unsigned long long)used);
+    str += ui_label_pad(line, sizeof(line), 27, "SD used:", buf);
     str += "\n                           \n";
 
+    ui_label_set_text(scr2_1_info, str.c_str());
+    return !pending;
+}
+
+static void scr2_1_sd_timer_event(lv_timer_t *t)
+{
+    if(scr2_1_info_update()) {
+        lv_timer_del(scr2_1_sd_timer);
+        scr2_1_sd_timer = NULL;
+    }
+}
 
-    lv_label_set_text_fmt(info, "%s", str.c_str());
+static void scr2_1_btn_event_cb(lv_event_t * e)
+{
+    if(e->code == LV_EVENT_CLICKED){
+        scr_mgr_pop(false);
+    }
+}
+
+static void create2_1(lv_obj_t *parent) 
+{
+    scr2_1_info = lv_label_create(parent);
+    lv_obj_set_width(scr2_1_info, LV_HOR_RES * 0.9);
+    lv_obj_set_style_text_color(scr2_1_info, DECKPRO_COLOR_FG, LV_PART_MAIN);
+    lv_obj_set_style_text_font(scr2_1_info, &Font_Mono_Bold_14_cached, LV_PART_MAIN);
+    lv_obj_set_style_text_align(scr2_1_info, LV_TEXT_ALIGN_CENTER, 0);
+    lv_label_set_long_mode(scr2_1_info, LV_LABEL_LONG_WRAP);
+
+    scr2_1_info_update();
     
-    lv_obj_align(info, LV_ALIGN_TOP_MID, 0, 35);
+    lv_obj_align(scr2_1_info, LV_ALIGN_TOP_MID, 0, 35);
     
     lv_obj_t *back2_1_label = scr_back_btn_create(parent, ("About System"), scr2_1_btn_event_cb);
 }
 static void entry2_1(void) 
 {
     ui_disp_full_refr();
+    if(!scr2_1_info_update())
+        scr2_1_sd_timer = lv_timer_create(scr2_1_sd_timer_event, 500, NULL);
 }
 static void exit2_1(void) {
     ui_disp_full_refr();
+    if(scr2_1_sd_timer) {
+        lv_timer_del(scr2_1_sd_timer);
+        scr2_1_sd_timer = NULL;
+    }
 }
 static void destroy2_1(void) { }
 
@@ -887,13 +1064,98 @@ static scr_lifecycle_t screen2_1 = {
     .destroy = destroy2_1,
 };
 #endif
+// --------------------- screen 2.2 --------------------- CPU Profile
+#if 1
+#define CPU_PROF_LINE_MAX 28
+#define CPU_PROF_TASK_ROWS 8
+#define CPU_PROF_PC_ROWS 4
+static lv_obj_t *scr2_2_info;
+static lv_timer_t *scr2_2_timer = NULL;
+
+// Busiest tasks with their share of each core, then the hottest PCs; resolve
+// those with script/cpu_prof.py against the build's firmware.elf
+static void scr2_2_info_update(void)
+{
+    static char text[(CPU_PROF_TASK_ROWS + CPU_PROF_PC_ROWS + 3) * (CPU_PROF_LINE_MAX + 1)];
+    int count = ui_cpu_prof_task_count();
+    int len = 0;
+
+    if(count == 0) {
+        lv_label_set_text(scr2_2_info, "\nProfiler off\n\nSet profiler.enabled\nin the config");
+        return;
+    }
+
+    len += lv_snprintf(text + len, sizeof(text) - len, "%-14s %6s %6s\n", "task", "cpu0", "cpu1");
+    for(int i = 0; i < count && i < CPU_PROF_TASK_ROWS; i++) {
+        const char *name;
+        float core0, core1;
+        if(!ui_cpu_prof_task_get(i, &name, &core0, &core1)) break;
+        len += lv_snprintf(text + len, sizeof(text) - len, "%-14.14s %5.1f%% %5.1f%%\n", name, core0, core1);
+    }
+
+    len += lv_snprintf(text + len, sizeof(text) - len, "\n%-14s %13s\n", "pc", "share");
+    for(int i = 0; i < CPU_PROF_PC_ROWS; i++) {
+        uint32_t pc;
+        float percent;
+        if(!ui_cpu_prof_pc_get(i, &pc, &percent)) break;
+        len += lv_snprintf(text + len, sizeof(text) - len, "0x%08lx %17.1f%%\n", (unsigned long)pc, percent);
+    }
+    lv_label_set_text(scr2_2_info, text);
+}
+
+static void scr2_2_timer_event(lv_timer_t *t)
+{
+    scr2_2_info_update();
+}
+
+static void scr2_2_btn_event_cb(lv_event_t * e)
+{
+    if(e->code == LV_EVENT_CLICKED){
+        scr_mgr_pop(false);
+    }
+}
+
+static void create2_2(lv_obj_t *parent) 
+{
+    scr2_2_info = lv_label_create(parent);
+    lv_obj_set_width(scr2_2_info, LV_HOR_RES * 0.95);
+    lv_obj_set_style_text_color(scr2_2_info, DECKPRO_COLOR_FG, LV_PART_MAIN);
+    lv_obj_set_style_text_font(scr2_2_info, FONT_BOLD_MONO_SIZE_14, LV_PART_MAIN);
+    lv_label_set_long_mode(scr2_2_info, LV_LABEL_LONG_CLIP);
+    lv_obj_align(scr2_2_info, LV_ALIGN_TOP_MID, 0, 35);
+
+    scr_back_btn_create(parent, ("CPU Profile"), scr2_2_btn_event_cb);
+}
+static void entry2_2(void) 
+{
+    scr2_2_info_update();
+    ui_disp_full_refr();
+    scr2_2_timer = lv_timer_create(scr2_2_timer_event, 5000, NULL);
+}
+static void exit2_2(void) {
+    ui_disp_full_refr();
+    if(scr2_2_timer) {
+        lv_timer_del(scr2_2_timer);
+        scr2_2_timer = NULL;
+    }
+}
+static void destroy2_2(void) { }
+
+static scr_lifecycle_t screen2_2 = {
+    .create = create2_2,
+    .entry = entry2_2,
+    .exit  = exit2_2,
+    .destroy = destroy2_2,
+};
+#undef CPU_PROF_LINE_MAX
+#undef CPU_PROF_TASK_ROWS
+#undef CPU_PROF_PC_ROWS
+#endif
 // --------------------- screen 2 --------------------- Setting
 #if 1
 static lv_obj_t *setting_list;
 static lv_obj_t *setting_page;
 static int setting_num = 0;
-static int setting_page_num = 0;
-static int setting_curr_page = 0;
 static ui_setting_handle setting_handle_list[] = {
     {.name = "Keypad Backlight", .type=UI_SETTING_TYPE_SW,  .set_cb = ui_setting_set_keypad_light, .get_cb = ui_setting_get_keypad_light},
     {.name = "Motor Status",     .type=UI_SETTING_TYPE_SW,  .set_cb = ui_setting_set_motor_status, .get_cb = ui_setting_get_motor_status},
@@ -902,10 +1164,9 @@ static ui_setting_handle setting_handle_list[] = {
     {.name = "Power Gyro",       .type=UI_SETTING_TYPE_SW,  .set_cb = ui_setting_set_gyro_status,  .get_cb = ui_setting_get_gyro_status},
     {.name = "Power A7682",      .type=UI_SETTING_TYPE_SW,  .set_cb = ui_setting_set_a7682_status, .get_cb = ui_setting_get_a7682_status},
     {.name = "- About System",   .type=UI_SETTING_TYPE_SUB, .sub_id = SCREEN2_1_ID},
+    {.name = "- CPU Profile",    .type=UI_SETTING_TYPE_SUB, .sub_id = SCREEN2_2_ID},
 };
 
-static void setting_item_create(int curr_apge);
-
 static void scr2_btn_event_cb(lv_event_t * e)
 {
     if(e->code == LV_EVENT_CLICKED){
@@ -916,14 +1177,17 @@ static void scr2_btn_event_cb(lv_event_t * e)
 static void setting_scr_event(lv_event_t *e)
 {
     lv_obj_t *tgt = (lv_obj_t *)e->target;
-    ui_setting_handle *h = (ui_setting_handle *)e->user_data;
+    int idx = ui_vlist_get_index(lv_obj_get_parent(tgt));
+
+    if(idx < 0 || idx >= setting_num) return;
+    ui_setting_handle *h = &setting_handle_list[idx];
 
     if(e->code == LV_EVENT_CLICKED) {
         switch (h->type)
         {
         case UI_SETTING_TYPE_SW:
             h->set_cb(!h->get_cb());
-            lv_label_set_text_fmt(h->st, "%s", (h->get_cb() ? "ON" : "OFF"));
+            ui_vlist_refresh(setting_list);
             break;
         case UI_SETTING_TYPE_SUB:
             scr_mgr_push(h->sub_id, false);
@@ -934,94 +1198,94 @@ static void setting_scr_event(lv_event_t *e)
     }
 }
 
-static void setting_page_switch_cb(lv_event_t *e)
+static void setting_page_update(void)
 {
-    char opt = (int)e->user_data;
-    
-    if(setting_num < SETTING_PAGE_MAX_ITEM) return;
+    uint32_t page, pages;
+    ui_vlist_get_page(setting_list, &page, &pages);
+    lv_label_set_text_fmt(setting_page, "%d / %d", (int)page, (int)pages - 1);
+}
 
-    int child_cnt = lv_obj_get_child_cnt(setting_list);
+static void setting_page_switch_cb(lv_event_t *e)
+{
+    char opt = (int)(intptr_t)e->user_data;
     
-    for(int i = 0; i < child_cnt; i++)
-    {
-        lv_obj_t *child = lv_obj_get_child(setting_list, 0);
-        if(child)
-            lv_obj_del(child);
-    }
-
     if(opt == 'p')
     {
-        setting_curr_page = (setting_curr_page < setting_page_num) ? setting_curr_page + 1 : 0;
+        ui_vlist_page(setting_list, 1);
     }
     else if(opt == 'n')
     {
-        setting_curr_page = (setting_curr_page > 0) ? setting_curr_page - 1 : setting_page_num;
+        ui_vlist_page(setting_list, -1);
     }
 
-    setting_item_create(setting_curr_page);
-    lv_label_set_text_fmt(setting_page, "%d / %d", setting_curr_page, setting_page_num);
+    setting_page_update();
 }
 
-static void setting_item_create(int curr_apge)
+static void setting_list_scroll_cb(lv_event_t *e)
 {
-    printf("setting_curr_page = %d\n", setting_curr_page);
-    int start = (curr_apge * SETTING_PAGE_MAX_ITEM);
-    int end = start + SETTING_PAGE_MAX_ITEM;
-    if(end > setting_num) end = setting_num;
+    setting_page_update();
+}
 
-    printf("start=%d, end=%d\n", start, end);
+static lv_obj_t * setting_row_create(lv_obj_t *list, void *user_data)
+{
+    // Transparent row keeps the 3px gap the lv_list version had between items
+    lv_obj_t *row = lv_obj_create(list);
+    lv_obj_remove_style_all(row);
+    lv_obj_clear_flag(row, LV_OBJ_FLAG_CLICKABLE);
 
-    for(int i = start; i < end; i++) {
-        ui_setting_handle *h = &setting_handle_list[i];
-        
+    lv_obj_t *btn = lv_btn_create(row);
+    lv_obj_set_size(btn, lv_pct(100), UI_SETTING_ROW_HEIGHT - 3);
+    lv_obj_set_style_text_font(btn, FONT_BOLD_SIZE_14, LV_PART_MAIN);
+    lv_obj_set_style_bg_color(btn, DECKPRO_COLOR_BG, LV_PART_MAIN);
+    lv_obj_set_style_text_color(btn, DECKPRO_COLOR_FG, LV_PART_MAIN);
+    lv_obj_set_style_shadow_width(btn, 0, LV_PART_MAIN);
+    lv_obj_set_style_border_width(btn, 1, LV_PART_MAIN | LV_STATE_DEFAULT);
+    lv_obj_set_style_border_width(btn, 1, LV_PART_MAIN | LV_STATE_PRESSED);
+    lv_obj_set_style_outline_width(btn, 3, LV_PART_MAIN | LV_STATE_PRESSED);
+    lv_obj_set_style_radius(btn, 5, LV_PART_MAIN | LV_STATE_DEFAULT);
+    lv_obj_add_event_cb(btn, setting_scr_event, LV_EVENT_CLICKED, NULL);
 
-        switch (h->type)
-        {
-        case UI_SETTING_TYPE_SW:
-            h->obj = lv_list_add_btn(setting_list, NULL, h->name);
-            h->st = lv_label_create(h->obj);
-            lv_obj_set_style_text_font(h->st, FONT_BOLD_SIZE_15, LV_PART_MAIN);
-            lv_obj_align(h->st, LV_ALIGN_RIGHT_MID, 0, 0);
-            lv_label_set_text_fmt(h->st, "%s", (h->get_cb() ? "ON" : "OFF"));
-            break;
-        case UI_SETTING_TYPE_SUB:
-            h->obj = lv_list_add_btn(setting_list, NULL, h->name);
-            break;
-        default:
-            break;
-        }
+    lv_obj_t *name = lv_label_create(btn);
+    lv_obj_align(name, LV_ALIGN_LEFT_MID, 0, 0);
 
-        // style
-        lv_obj_set_height(h->obj, 28);
-        lv_obj_set_style_text_font(h->obj, FONT_BOLD_SIZE_14, LV_PART_MAIN);
-        lv_obj_set_style_bg_color(h->obj, DECKPRO_COLOR_BG, LV_PART_MAIN);
-        lv_obj_set_style_text_color(h->obj, DECKPRO_COLOR_FG, LV_PART_MAIN);
-        lv_obj_set_style_border_width(h->obj, 1, LV_PART_MAIN | LV_STATE_DEFAULT);
-        lv_obj_set_style_border_width(h->obj, 1, LV_PART_MAIN | LV_STATE_PRESSED);
-        lv_obj_set_style_outline_width(h->obj, 3, LV_PART_MAIN | LV_STATE_PRESSED);
-        lv_obj_set_style_radius(h->obj, 5, LV_PART_MAIN | LV_STATE_DEFAULT);
-        lv_obj_add_event_cb(h->obj, setting_scr_event, LV_EVENT_CLICKED, (void *)h);
+    lv_obj_t *st = lv_label_create(btn);
+    lv_obj_set_style_text_font(st, FONT_BOLD_SIZE_15, LV_PART_MAIN);
+    lv_obj_align(st, LV_ALIGN_RIGHT_MID, 0, 0);
+    return row;
+}
+
+static void setting_row_bind(lv_obj_t *row, uint32_t index, void *user_data)
+{
+    ui_setting_handle *h = &setting_handle_list[index];
+    lv_obj_t *btn = lv_obj_get_child(row, 0);
+    lv_obj_t *st = lv_obj_get_child(btn, 1);
+
+    lv_label_set_text_static(lv_obj_get_child(btn, 0), h->name);
+    if(h->type == UI_SETTING_TYPE_SW) {
+        lv_label_set_text_static(st, (h->get_cb() ? "ON" : "OFF"));
+        lv_obj_clear_flag(st, LV_OBJ_FLAG_HIDDEN);
+    } else {
+        lv_obj_add_flag(st, LV_OBJ_FLAG_HIDDEN);
     }
 }
 
 static void create2(lv_obj_t *parent) 
 {
-    setting_list = lv_list_create(parent);
-    lv_obj_set_size(setting_list, LV_HOR_RES, lv_pct(88));
-    lv_obj_align(setting_list, LV_ALIGN_BOTTOM_MID, 0, 0);
+    // One page of rows is visible, Back/Next scroll by that much
+    setting_list = ui_vlist_create(parent, LV_HOR_RES, SETTING_PAGE_MAX_ITEM * UI_SETTING_ROW_HEIGHT + 2,
+                                   UI_SETTING_ROW_HEIGHT, setting_row_create, setting_row_bind, NULL);
+    lv_obj_align(setting_list, LV_ALIGN_TOP_MID, 0, lv_pct(12));
     lv_obj_set_style_bg_color(setting_list, DECKPRO_COLOR_BG, LV_PART_MAIN);
+    lv_obj_set_style_pad_all(setting_list, 0, LV_PART_MAIN);
     lv_obj_set_style_pad_top(setting_list, 2, LV_PART_MAIN);
-    lv_obj_set_style_pad_row(setting_list, 3, LV_PART_MAIN);
+    lv_obj_set_style_pad_hor(setting_list, 5, LV_PART_MAIN);
     lv_obj_set_style_radius(setting_list, 0, LV_PART_MAIN);
-    // lv_obj_set_style_outline_pad(setting_list, 2, LV_PART_MAIN);
     lv_obj_set_style_border_width(setting_list, 0, LV_PART_MAIN);
-    lv_obj_set_style_border_color(setting_list, DECKPRO_COLOR_FG, LV_PART_MAIN);
     lv_obj_set_style_shadow_width(setting_list, 0, LV_PART_MAIN);
+    lv_obj_add_event_cb(setting_list, setting_list_scroll_cb, LV_EVENT_SCROLL_END, NULL);
 
     setting_num = sizeof(setting_handle_list) / sizeof(setting_handle_list[0]);
-    setting_page_num = setting_num / SETTING_PAGE_MAX_ITEM;
-
-    setting_item_create(setting_curr_page);
+    ui_vlist_set_count(setting_list, setting_num);
 
     lv_obj_t * ui_Button2 = lv_btn_create(parent);
     lv_obj_set_width(ui_Button2, 71);
@@ -1082,7 +1346,7 @@ static void create2(lv_obj_t *parent)
     lv_obj_set_width(setting_page, LV_SIZE_CONTENT);   /// 1
     lv_obj_set_height(setting_page, LV_SIZE_CONTENT);    /// 1
     lv_obj_align(setting_page, LV_ALIGN_BOTTOM_MID, 0, -23);
-    lv_label_set_text_fmt(setting_page, "%d / %d", setting_curr_page, setting_page_num);
+    setting_page_update();
     lv_obj_set_style_text_color(setting_page, lv_color_hex(0x000000), LV_PART_MAIN | LV_STATE_DEFAULT);
     lv_obj_set_style_text_opa(setting_page, 255, LV_PART_MAIN | LV_STATE_DEFAULT);
 
@@ -1107,24 +1371,22 @@ static scr_lifecycle_t screen2 = {
 #if 1
 #define line_max 23
 static lv_obj_t *scr3_cont;
+// Not the shared label_list: GPS is preloaded and outlives the battery pages that reuse it
+static lv_obj_t *scr3_label_list[10];
 static lv_obj_t *scr3_cnt_lab;
 static lv_timer_t *GPS_loop_timer = NULL;
 
 static void gps_set_line(lv_obj_t *label, const char *str1, const char *str2)
 {
-    int w2 = strlen(str2);
-    int w1 = line_max - w2;
-    lv_label_set_text_fmt(label, "%-*s%-*s", w1, str1, w2, str2);
+    ui_label_set_pair(label, line_max, str1, str2);
 }
 
 static lv_obj_t * scr3_create_label(lv_obj_t *parent)
 {
     lv_obj_t *label = lv_label_create(parent);
     lv_obj_set_width(label, lv_pct(90));
-    lv_obj_set_style_text_font(label, FONT_BOLD_MONO_SIZE_15, LV_PART_MAIN);   
-    lv_obj_set_style_border_width(label, 1, LV_PART_MAIN);
+    UI_STYLE(label, ui_style_info_row, LV_PART_MAIN);
     lv_label_set_long_mode(label, LV_LABEL_LONG_WRAP);
-    lv_obj_set_style_border_side(label, LV_BORDER_SIDE_BOTTOM, LV_PART_MAIN);
     return label;
 }
 
@@ -1146,7 +1408,7 @@ static void scr3_GPS_updata(void)
 
     static int cnt = 0;
 
-    lv_label_set_text_fmt(scr3_cnt_lab, " %05d ", ++cnt);
+    ui_label_set_fmt(scr3_cnt_lab, " %05d ", ++cnt);
 
     ui_gps_get_coord(&lat, &lon);
     ui_gps_get_data(&year, &month, &day);
@@ -1157,34 +1419,45 @@ static void scr3_GPS_updata(void)
     char buf[32];
 
     lv_snprintf(buf, 16, "%0.1f", lat);
-    gps_set_line(label_list[0], "Latitude:", buf);
+    gps_set_line(scr3_label_list[0], "Latitude:", buf);
 
     lv_snprintf(buf, 16, "%0.1f", lon);
-    gps_set_line(label_list[1], "Longitude:", buf);
+    gps_set_line(scr3_label_list[1], "Longitude:", buf);
 
     lv_snprintf(buf, 16, "%0.3fkmph", speed);
-    gps_set_line(label_list[2], "Speed:", buf);
+    gps_set_line(scr3_label_list[2], "Speed:", buf);
 
     lv_snprintf(buf, 16, "%d", vsat);
-    gps_set_line(label_list[3], "vsat:", buf);
+    gps_set_line(scr3_label_list[3], "vsat:", buf);
     
     lv_snprintf(buf, 16, "%d", year);
-    gps_set_line(label_list[4], "year:", buf);
+    gps_set_line(scr3_label_list[4], "year:", buf);
 
     lv_snprintf(buf, 16, "%d", month);
-    gps_set_line(label_list[5], "month:", buf);
+    gps_set_line(scr3_label_list[5], "month:", buf);
 
     lv_snprintf(buf, 16, "%d", day);
-    gps_set_line(label_list[6], "day:", buf);
+    gps_set_line(scr3_label_list[6], "day:", buf);
 
     lv_snprintf(buf, 16, "%02d:%02d:%02d", hour, min, sec);
-    gps_set_line(label_list[7], "time:", buf);
+    gps_set_line(scr3_label_list[7], "time:", buf);
+
+    uint32_t track_pts = 0, track_bytes = 0;
+    if(ui_gps_get_track(&track_pts, &track_bytes)) {
+        // Points cap at 5 digits and KB is at most 7, so the line always fits buf
+        unsigned long pts = (unsigned long)LV_MIN(track_pts, 99999u);
+        unsigned long kb = (unsigned long)(((uint64_t)track_bytes + 1023) / 1024);
+        lv_snprintf(buf, 16, "%lu %luK", pts, kb);
+    } else {
+        lv_snprintf(buf, 16, "off");
+    }
+    gps_set_line(scr3_label_list[8], "track:", buf);
 
     // lv_snprintf(buf, 16, "%0.1f", alt);
-    // gps_set_line(label_list[3], "alt:", buf);
+    // gps_set_line(scr3_label_list[3], "alt:", buf);
 
     // lv_snprintf(buf, 16, "%d", usat);
-    // gps_set_line(label_list[5], "usat:", buf);
+    // gps_set_line(scr3_label_list[5], "usat:", buf);
 
 }
 
@@ -1200,25 +1473,46 @@ static void scr3_btn_event_cb(lv_event_t * e)
     }
 }
 
+static void scr3_map_event_cb(lv_event_t * e)
+{
+    scr_mgr_push(SCREEN3_1_ID, false);
+}
+
+// Small framed button for the header row
+static lv_obj_t * scr3_tool_create(lv_obj_t *parent, const char *text, lv_event_cb_t cb, void *user_data)
+{
+    lv_obj_t *btn = lv_btn_create(parent);
+    lv_obj_remove_style_all(btn);
+    lv_obj_set_size(btn, LV_SIZE_CONTENT, 26);
+    lv_obj_set_style_pad_hor(btn, 6, LV_PART_MAIN);
+    lv_obj_set_style_radius(btn, 5, LV_PART_MAIN);
+    lv_obj_set_style_border_width(btn, 2, LV_PART_MAIN);
+    lv_obj_set_style_border_color(btn, DECKPRO_COLOR_FG, LV_PART_MAIN);
+    lv_obj_set_style_bg_color(btn, DECKPRO_COLOR_BG, LV_PART_MAIN);
+    lv_obj_set_style_bg_opa(btn, LV_OPA_COVER, LV_PART_MAIN);
+    lv_obj_add_event_cb(btn, cb, LV_EVENT_CLICKED, user_data);
+
+    lv_obj_t *label = lv_label_create(btn);
+    UI_STYLE(label, ui_style_title, LV_PART_MAIN);
+    lv_label_set_text(label, text);
+    lv_obj_center(label);
+    return btn;
+}
+
 static void create3(lv_obj_t *parent) 
 {   
     scr3_cont = lv_obj_create(parent);
     lv_obj_set_size(scr3_cont, lv_pct(100), lv_pct(88));
-    lv_obj_set_style_bg_color(scr3_cont, DECKPRO_COLOR_BG, LV_PART_MAIN);
+    UI_STYLE(scr3_cont, ui_style_info_cont, LV_PART_MAIN);
     lv_obj_set_scrollbar_mode(scr3_cont, LV_SCROLLBAR_MODE_OFF);
     lv_obj_clear_flag(scr3_cont, LV_OBJ_FLAG_SCROLLABLE);
-    lv_obj_set_style_border_width(scr3_cont, 0, LV_PART_MAIN);
-    lv_obj_set_style_pad_all(scr3_cont, 0, LV_PART_MAIN);
-    lv_obj_set_style_pad_hor(scr3_cont, 0, LV_PART_MAIN);
-    lv_obj_set_style_pad_row(scr3_cont, 5, LV_PART_MAIN);
-    lv_obj_set_style_pad_column(scr3_cont, 0, LV_PART_MAIN);
     lv_obj_set_align(scr3_cont, LV_ALIGN_BOTTOM_LEFT);
     lv_obj_set_flex_flow(scr3_cont, LV_FLEX_FLOW_COLUMN);
     lv_obj_set_flex_align(scr3_cont, LV_FLEX_ALIGN_START, LV_FLEX_ALIGN_START, LV_FLEX_ALIGN_CENTER);
 
-    for(int i = 0; i < sizeof(label_list) / sizeof(label_list[0]); i++) {
-        label_list[i] = scr3_create_label(scr3_cont);
-        lv_label_set_text(label_list[i], " ");
+    for(int i = 0; i < sizeof(label_list) / sizeof(scr3_label_list[0]); i++) {
+        scr3_label_list[i] = scr3_create_label(scr3_cont);
+        lv_label_set_text(scr3_label_list[i], " ");
     }
 
     scr3_cnt_lab = lv_label_create(parent);
@@ -1230,6 +1524,9 @@ static void create3(lv_obj_t *parent)
     lv_obj_center(scr3_cnt_lab);
     lv_obj_align(scr3_cnt_lab, LV_ALIGN_TOP_RIGHT, -10, 10);
 
+    lv_obj_t *map_btn = scr3_tool_create(parent, "Map", scr3_map_event_cb, NULL);
+    lv_obj_align_to(map_btn, scr3_cnt_lab, LV_ALIGN_OUT_LEFT_MID, -10, 0);
+
     lv_obj_t *back3_label = scr_back_btn_create(parent, ("GPS"), scr3_btn_event_cb);
 }
 static void entry3(void) 
@@ -1260,6 +1557,97 @@ static scr_lifecycle_t screen3 = {
 
 #undef line_max
 
+#endif
+//************************************[ screen 3.1 ]****************************************** GPS map
+#if 1
+static lv_obj_t *scr3_1_map = NULL;
+static lv_timer_t *scr3_1_timer = NULL;
+
+static void scr3_1_update(void)
+{
+    double lat = 0, lng = 0;
+    ui_gps_get_coord(&lat, &lng);
+    // 0, 0 until the first fix
+    ui_map_set_marker(scr3_1_map, lat, lng, lat != 0 || lng != 0);
+}
+
+static void scr3_1_timer_event(lv_timer_t * t)
+{
+    scr3_1_update();
+}
+
+static void scr3_1_btn_event_cb(lv_event_t * e)
+{
+    if(e->code == LV_EVENT_CLICKED){
+        scr_mgr_pop(false);
+    }
+}
+
+// user_data: zoom step, or 0 to centre on the fix again
+static void scr3_1_tool_event_cb(lv_event_t * e)
+{
+    intptr_t op = (intptr_t)lv_event_get_user_data(e);
+    if(op == 0)
+        ui_map_follow(scr3_1_map);
+    else
+        ui_map_zoom(scr3_1_map, op);
+}
+
+static void create3_1(lv_obj_t *parent)
+{
+    uint8_t zoom_min = 0, zoom_max = 0;
+    double lat = 0, lng = 0;
+    bool have_map = ui_map_open(&zoom_min, &zoom_max, &lat, &lng);
+
+    scr3_1_map = ui_map_create(parent, LCD_HOR_SIZE, LCD_VER_SIZE - 36, ui_map_get_tile);
+    lv_obj_align(scr3_1_map, LV_ALIGN_BOTTOM_MID, 0, 0);
+    if(have_map) {
+        ui_map_set_zoom_range(scr3_1_map, zoom_min, zoom_max);
+        ui_map_set_view(scr3_1_map, lat, lng, zoom_max > 0 ? zoom_max - 1 : 0);
+    } else {
+        lv_obj_t *note = lv_label_create(scr3_1_map);
+        lv_obj_set_style_text_font(note, FONT_BOLD_MONO_SIZE_15, LV_PART_MAIN);
+        lv_obj_set_style_text_align(note, LV_TEXT_ALIGN_CENTER, LV_PART_MAIN);
+        lv_label_set_text(note, "No map on SD\n/maps/map.tdm");
+        lv_obj_center(note);
+    }
+
+    lv_obj_t *centre = scr3_tool_create(parent, LV_SYMBOL_GPS, scr3_1_tool_event_cb, (void *)0);
+    lv_obj_align(centre, LV_ALIGN_TOP_RIGHT, -6, 5);
+    lv_obj_t *zoom_out = scr3_tool_create(parent, "-", scr3_1_tool_event_cb, (void *)-1);
+    lv_obj_align_to(zoom_out, centre, LV_ALIGN_OUT_LEFT_MID, -6, 0);
+    lv_obj_t *zoom_in = scr3_tool_create(parent, "+", scr3_1_tool_event_cb, (void *)1);
+    lv_obj_align_to(zoom_in, zoom_out, LV_ALIGN_OUT_LEFT_MID, -6, 0);
+
+    scr_back_btn_create(parent, ("Map"), scr3_1_btn_event_cb);
+}
+static void entry3_1(void)
+{
+    ui_gps_task_resume();
+    scr3_1_update();
+    ui_map_follow(scr3_1_map);
+
+    scr3_1_timer = lv_timer_create(scr3_1_timer_event, 3000, NULL);
+    ui_disp_full_refr();
+}
+static void exit3_1(void) {
+    ui_gps_task_suspend();
+    if(scr3_1_timer) {
+        lv_timer_del(scr3_1_timer);
+        scr3_1_timer = NULL;
+    }
+    ui_disp_full_refr();
+}
+static void destroy3_1(void) {
+    scr3_1_map = NULL;
+}
+
+static scr_lifecycle_t screen3_1 = {
+    .create = create3_1,
+    .entry = entry3_1,
+    .exit  = exit3_1,
+    .destroy = destroy3_1,
+};
 #endif
 //************************************[ screen 4 ]****************************************** Wifi Scan
 // --------------------- screen 4 --------------------- WIFI
@@ -1285,7 +1673,7 @@ static void scr4_list_event(lv_event_t *e)
             {
                 scr_mgr_push(SCREEN4_2_ID, false);
             }
-            printf("%s\n", str);
+            LOG_DEBUGF("UI", "Picked %s", str);
         }
     }
 }
@@ -1302,13 +1690,8 @@ static void scr4_item_create(const char *name, lv_event_cb_t cb)
     lv_obj_align(label, LV_ALIGN_LEFT_MID, 10, 0);
 
     lv_obj_set_height(obj, LV_VER_RES / 6);
-    lv_obj_set_style_text_font(obj, FONT_BOLD_SIZE_15, LV_PART_MAIN);
-    // lv_obj_set_style_bg_color(obj, lv_color_hex(EPD_COLOR_BG), LV_PART_MAIN);
-    // lv_obj_set_style_text_color(obj, lv_color_hex(EPD_COLOR_FG), LV_PART_MAIN);
-    lv_obj_set_style_border_width(obj, 1, LV_PART_MAIN | LV_STATE_DEFAULT);
-    lv_obj_set_style_border_width(obj, 1, LV_PART_MAIN | LV_STATE_PRESSED);
-    lv_obj_set_style_outline_width(obj, 1, LV_PART_MAIN | LV_STATE_PRESSED);
-    lv_obj_set_style_radius(obj, 10, LV_PART_MAIN | LV_STATE_DEFAULT);
+    UI_STYLE(obj, ui_style_list_item, LV_PART_MAIN | LV_STATE_DEFAULT);
+    UI_STYLE(obj, ui_style_list_item_pr, LV_PART_MAIN | LV_STATE_PRESSED);
 
     lv_obj_add_event_cb(obj, cb, LV_EVENT_CLICKED, NULL); 
 }
@@ -1326,14 +1709,7 @@ static void create4(lv_obj_t *parent)
     scr4_list = lv_list_create(parent);
     lv_obj_set_size(scr4_list, lv_pct(93), lv_pct(91));
     lv_obj_align(scr4_list, LV_ALIGN_BOTTOM_MID, 0, 0);
-    // lv_obj_set_style_bg_color(scr4_list, lv_color_hex(EPD_COLOR_BG), LV_PART_MAIN);
-    lv_obj_set_style_pad_top(scr4_list, 10, LV_PART_MAIN);
-    lv_obj_set_style_pad_row(scr4_list, 15, LV_PART_MAIN);
-    lv_obj_set_style_radius(scr4_list, 0, LV_PART_MAIN);
-    // lv_obj_set_style_outline_pad(scr4_list, 1, LV_PART_MAIN);
-    lv_obj_set_style_border_width(scr4_list, 0, LV_PART_MAIN);
-    // lv_obj_set_style_border_color(scr4_list, lv_color_hex(EPD_COLOR_FG), LV_PART_MAIN);
-    lv_obj_set_style_shadow_width(scr4_list, 0, LV_PART_MAIN);
+    UI_STYLE(scr4_list, ui_style_list, LV_PART_MAIN);
 
     scr4_item_create("- WIFI Config", scr4_list_event);
     scr4_item_create("- WIFI Scan", scr4_list_event);
@@ -1397,7 +1773,10 @@ static lv_obj_t *scr4_2_cont;
 static lv_obj_t *wifi_scan_lab;
 static lv_timer_t *wifi_scan_timer = NULL;
 
+static lv_obj_t *wifi_scan_list;
 static ui_wifi_scan_info_t wifi_info_list[UI_WIFI_SCAN_ITEM_MAX];
+static int wifi_scan_cnt = 0;
+static uint32_t wifi_scan_version = 0;
 
 static void scr4_2_btn_event_cb(lv_event_t * e)
 {
@@ -1406,37 +1785,31 @@ static void scr4_2_btn_event_cb(lv_event_t * e)
     }
 }
 
-static void show_wifi_scan(void)
+static void wifi_scan_bind(lv_obj_t *row, uint32_t index, void *user_data)
 {
-#define BUFF_LEN 400
-    char buf[BUFF_LEN];
-    int ret = 0, offs = 0;
-
-    ret = lv_snprintf(buf + offs, BUFF_LEN, "       NAME      | RSSI\n");
-    offs = offs + ret;
-    ret = lv_snprintf(buf + offs, BUFF_LEN, "-----------------------\n");
-    offs = offs + ret;
+    lv_label_set_text_fmt(row, "%-16.16s | %4d", wifi_info_list[index].name, wifi_info_list[index].rssi);
+}
 
-    for(int i = 0; i < UI_WIFI_SCAN_ITEM_MAX; i++) {
-        if(strcmp(wifi_info_list[i].name, "") == 0 && wifi_info_list[i].rssi == 0)
-        {
-            break;
-        }
-        if(i == UI_WIFI_SCAN_ITEM_MAX - 1) {
-            ret = lv_snprintf(buf + offs, BUFF_LEN, "%-16.16s | %4d", wifi_info_list[i].name, wifi_info_list[i].rssi);
-            break;
-        }
+static void show_wifi_scan(void)
+{
+    ui_vlist_set_count(wifi_scan_list, wifi_scan_cnt);
+}
 
-        ret = lv_snprintf(buf + offs, BUFF_LEN, "%-16.16s | %4d\n", wifi_info_list[i].name, wifi_info_list[i].rssi);
-        offs = offs + ret;
-    }
-    lv_label_set_text(wifi_scan_lab, buf);
-#undef BUFF_LEN
+static lv_obj_t * wifi_scan_row_create(lv_obj_t *list, void *user_data)
+{
+    lv_obj_t *label = lv_label_create(list);
+    lv_obj_set_style_pad_all(label, 0, LV_PART_MAIN);
+    lv_obj_set_style_text_font(label, FONT_BOLD_MONO_SIZE_15, LV_PART_MAIN);
+    lv_label_set_long_mode(label, LV_LABEL_LONG_CLIP);
+    return label;
 }
 
 static void wifi_scan_timer_event(lv_timer_t *t)
 {
-    ui_wifi_get_scan_info(wifi_info_list, UI_WIFI_SCAN_ITEM_MAX);
+    // Polls the cache, the list is only rebound (and refreshed) after a new scan
+    int cnt = ui_wifi_get_scan_info(wifi_info_list, UI_WIFI_SCAN_ITEM_MAX, &wifi_scan_version);
+    if(cnt < 0) return;
+    wifi_scan_cnt = cnt;
     show_wifi_scan();
 }
 
@@ -1461,13 +1834,23 @@ static void create4_2(lv_obj_t *parent)
     lv_obj_set_style_text_font(wifi_scan_lab, FONT_BOLD_MONO_SIZE_15, LV_PART_MAIN);   
     lv_obj_set_style_border_width(wifi_scan_lab, 0, LV_PART_MAIN);
     lv_label_set_long_mode(wifi_scan_lab, LV_LABEL_LONG_WRAP);
+    lv_label_set_text(wifi_scan_lab, "       NAME      | RSSI\n"
+                                     "-----------------------");
+
+    wifi_scan_list = ui_vlist_create(scr4_2_cont, lv_pct(95), 0, UI_WIFI_ROW_HEIGHT,
+                                     wifi_scan_row_create, wifi_scan_bind, NULL);
+    lv_obj_set_flex_grow(wifi_scan_list, 1);
+    lv_obj_set_style_bg_color(wifi_scan_list, DECKPRO_COLOR_BG, LV_PART_MAIN);
+    lv_obj_set_style_border_width(wifi_scan_list, 0, LV_PART_MAIN);
+    lv_obj_set_style_pad_all(wifi_scan_list, 0, LV_PART_MAIN);
 
     lv_obj_t *back4_label = scr_back_btn_create(parent, ("Wifi"), scr4_2_btn_event_cb);
 }
 static void entry4_2(void) 
 {
     ui_disp_full_refr();
-    wifi_scan_timer = lv_timer_create(wifi_scan_timer_event, 10000, NULL);
+    wifi_scan_version = 0;
+    wifi_scan_timer = lv_timer_create(wifi_scan_timer_event, 1000, NULL);
     lv_timer_ready(wifi_scan_timer);
 }
 static void exit4_2(void) {
@@ -1521,7 +1904,7 @@ static void scr5_btn_event_cb(lv_event_t * e)
 
 static void test_page_switch_cb(lv_event_t *e)
 {
-    char opt = (int)e->user_data;
+    char opt = (int)(intptr_t)e->user_data;
     
     if(test_num < SETTING_PAGE_MAX_ITEM) return;
 
@@ -1549,12 +1932,12 @@ static void test_page_switch_cb(lv_event_t *e)
 
 static void test_item_create(int curr_apge)
 {
-    printf("test_curr_page = %d\n", test_curr_page);
+    LOG_DEBUGF("UI", "Test page %d", test_curr_page);
     int start = (curr_apge * SETTING_PAGE_MAX_ITEM);
     int end = start + SETTING_PAGE_MAX_ITEM;
     if(end > test_num) end = test_num;
 
-    printf("start=%d, end=%d\n", start, end);
+    LOG_DEBUGF("UI", "Items %d to %d", start, end);
 
     for(int i = start; i < end; i++) {
         ui_test_handle *h = &test_handle_list[i];
@@ -1698,7 +2081,7 @@ static void scr6_list_event(lv_event_t *e)
             {
                 scr_mgr_push(SCREEN6_2_ID, false);
             }
-            printf("%s\n", str);
+            LOG_DEBUGF("UI", "Picked %s", str);
         }
     }
 }
@@ -1715,13 +2098,8 @@ static void scr6_item_create(const char *name, lv_event_cb_t cb)
     lv_obj_align(label, LV_ALIGN_LEFT_MID, 10, 0);
 
     lv_obj_set_height(obj, LV_VER_RES / 6);
-    lv_obj_set_style_text_font(obj, FONT_BOLD_SIZE_15, LV_PART_MAIN);
-    // lv_obj_set_style_bg_color(obj, lv_color_hex(EPD_COLOR_BG), LV_PART_MAIN);
-    // lv_obj_set_style_text_color(obj, lv_color_hex(EPD_COLOR_FG), LV_PART_MAIN);
-    lv_obj_set_style_border_width(obj, 1, LV_PART_MAIN | LV_STATE_DEFAULT);
-    lv_obj_set_style_border_width(obj, 1, LV_PART_MAIN | LV_STATE_PRESSED);
-    lv_obj_set_style_outline_width(obj, 1, LV_PART_MAIN | LV_STATE_PRESSED);
-    lv_obj_set_style_radius(obj, 10, LV_PART_MAIN | LV_STATE_DEFAULT);
+    UI_STYLE(obj, ui_style_list_item, LV_PART_MAIN | LV_STATE_DEFAULT);
+    UI_STYLE(obj, ui_style_list_item_pr, LV_PART_MAIN | LV_STATE_PRESSED);
 
     lv_obj_add_event_cb(obj, cb, LV_EVENT_CLICKED, NULL); 
 }
@@ -1739,14 +2117,7 @@ static void create6(lv_obj_t *parent)
     scr6_list = lv_list_create(parent);
     lv_obj_set_size(scr6_list, lv_pct(93), lv_pct(91));
     lv_obj_align(scr6_list, LV_ALIGN_BOTTOM_MID, 0, 0);
-    // lv_obj_set_style_bg_color(scr6_list, lv_color_hex(EPD_COLOR_BG), LV_PART_MAIN);
-    lv_obj_set_style_pad_top(scr6_list, 10, LV_PART_MAIN);
-    lv_obj_set_style_pad_row(scr6_list, 15, LV_PART_MAIN);
-    lv_obj_set_style_radius(scr6_list, 0, LV_PART_MAIN);
-    // lv_obj_set_style_outline_pad(scr6_list, 1, LV_PART_MAIN);
-    lv_obj_set_style_border_width(scr6_list, 0, LV_PART_MAIN);
-    // lv_obj_set_style_border_color(scr6_list, lv_color_hex(EPD_COLOR_FG), LV_PART_MAIN);
-    lv_obj_set_style_shadow_width(scr6_list, 0, LV_PART_MAIN);
+    UI_STYLE(scr6_list, ui_style_list, LV_PART_MAIN);
 
     scr6_item_create("- BQ25896", scr6_list_event);
     scr6_item_create("- BQ27220", scr6_list_event);
@@ -1779,19 +2150,15 @@ static lv_timer_t *batt_6_1_timer = NULL;
 
 static void battery_set_line(lv_obj_t *label, const char *str1, const char *str2)
 {
-    int w2 = strlen(str2);
-    int w1 = line_max - w2;
-    lv_label_set_text_fmt(label, "%-*s%-*s", w1, str1, w2, str2);
+    ui_label_set_pair(label, line_max, str1, str2);
 }
 
 static lv_obj_t * scr6_1_create_label(lv_obj_t *parent)
 {
     lv_obj_t *label = lv_label_create(parent);
     lv_obj_set_width(label, lv_pct(90));
-    lv_obj_set_style_text_font(label, FONT_BOLD_MONO_SIZE_15, LV_PART_MAIN);   
-    lv_obj_set_style_border_width(label, 1, LV_PART_MAIN);
+    UI_STYLE(label, ui_style_info_row, LV_PART_MAIN);
     lv_label_set_long_mode(label, LV_LABEL_LONG_WRAP);
-    lv_obj_set_style_border_side(label, LV_BORDER_SIDE_BOTTOM, LV_PART_MAIN);
     return label;
 }
 
@@ -1845,14 +2212,9 @@ static void create6_1(lv_obj_t *parent)
 {
     lv_obj_t *scr6_1_cont = lv_obj_create(parent);
     lv_obj_set_size(scr6_1_cont, lv_pct(100), lv_pct(88));
-    lv_obj_set_style_bg_color(scr6_1_cont, DECKPRO_COLOR_BG, LV_PART_MAIN);
+    UI_STYLE(scr6_1_cont, ui_style_info_cont, LV_PART_MAIN);
     lv_obj_set_scrollbar_mode(scr6_1_cont, LV_SCROLLBAR_MODE_OFF);
     lv_obj_clear_flag(scr6_1_cont, LV_OBJ_FLAG_SCROLLABLE);
-    lv_obj_set_style_border_width(scr6_1_cont, 0, LV_PART_MAIN);
-    lv_obj_set_style_pad_all(scr6_1_cont, 0, LV_PART_MAIN);
-    lv_obj_set_style_pad_hor(scr6_1_cont, 0, LV_PART_MAIN);
-    lv_obj_set_style_pad_row(scr6_1_cont, 5, LV_PART_MAIN);
-    lv_obj_set_style_pad_column(scr6_1_cont, 0, LV_PART_MAIN);
     lv_obj_set_align(scr6_1_cont, LV_ALIGN_BOTTOM_LEFT);
     lv_obj_set_flex_flow(scr6_1_cont, LV_FLEX_FLOW_COLUMN);
     lv_obj_set_flex_align(scr6_1_cont, LV_FLEX_ALIGN_START, LV_FLEX_ALIGN_START, LV_FLEX_ALIGN_CENTER);
@@ -1891,17 +2253,21 @@ static scr_lifecycle_t screen6_1 = {
 #if 1
 
 #define line_max 23
+#define energy_line_max 8
+#define history_points 24
 
 static lv_timer_t *batt_6_2_timer = NULL;
+static lv_obj_t *energy_label_list[energy_line_max] = {0};
+static lv_obj_t *runtime_label = NULL;
+static lv_obj_t *history_chart = NULL;
+static lv_chart_series_t *history_ser = NULL;
 
 static lv_obj_t * scr6_2_create_label(lv_obj_t *parent)
 {
     lv_obj_t *label = lv_label_create(parent);
     lv_obj_set_width(label, lv_pct(90));
-    lv_obj_set_style_text_font(label, FONT_BOLD_MONO_SIZE_15, LV_PART_MAIN);   
-    lv_obj_set_style_border_width(label, 1, LV_PART_MAIN);
+    UI_STYLE(label, ui_style_info_row, LV_PART_MAIN);
     lv_label_set_long_mode(label, LV_LABEL_LONG_WRAP);
-    lv_obj_set_style_border_side(label, LV_BORDER_SIDE_BOTTOM, LV_PART_MAIN);
     return label;
 }
 
@@ -1941,6 +2307,42 @@ static void scr6_2_battert_updata(void)
 
     lv_snprintf(buf, line_max, "%d%%", ui_battery_27220_get_health());
     battery_set_line(label_list[9], "CapHealth:", buf);
+
+    // learned from how the device has been used, not the current right now
+    int runtime = ui_battery_runtime_min();
+    if(runtime >= 0) {
+        lv_snprintf(buf, line_max, "%dh%02dm", runtime / 60, runtime % 60);
+    } else {
+        lv_snprintf(buf, line_max, "%s", "--");
+    }
+    battery_set_line(runtime_label, "Runtime:", buf);
+
+    // mAh per subsystem since boot, and the current it draws while on
+    for(int i = 0; i < energy_line_max && energy_label_list[i]; i++) {
+        const char *name = "";
+        float mah, ma;
+        char title[line_max];
+        if(ui_battery_energy_get(i, &name, &mah, &ma)) {
+            lv_snprintf(buf, line_max, "%.1fmAh %dmA", mah, (int)ma);
+        } else {
+            lv_snprintf(buf, line_max, "%s", "--");
+        }
+        lv_snprintf(title, line_max, "%s:", name);
+        battery_set_line(energy_label_list[i], title, buf);
+    }
+}
+
+// Last 24 h of charge, an hour a point, from the time-series store
+static void scr6_2_history_updata(void)
+{
+    int16_t pct[history_points];
+    if(!history_chart) return;
+    int filled = ui_battery_history(pct, history_points, 24 * 3600);
+    for(int i = 0; i < history_points; i++) {
+        lv_chart_set_value_by_id(history_chart, history_ser, i,
+                                 (filled && pct[i] >= 0) ? pct[i] : LV_CHART_POINT_NONE);
+    }
+    lv_chart_refresh(history_chart);
 }
 
 static void batt_6_2_updata_timer_event(lv_timer_t *t) 
@@ -1959,14 +2361,9 @@ static void create6_2(lv_obj_t *parent)
 {   
     lv_obj_t *scr6_2_cont = lv_obj_create(parent);
     lv_obj_set_size(scr6_2_cont, lv_pct(100), lv_pct(88));
-    lv_obj_set_style_bg_color(scr6_2_cont, DECKPRO_COLOR_BG, LV_PART_MAIN);
+    UI_STYLE(scr6_2_cont, ui_style_info_cont, LV_PART_MAIN);
     lv_obj_set_scrollbar_mode(scr6_2_cont, LV_SCROLLBAR_MODE_OFF);
     lv_obj_clear_flag(scr6_2_cont, LV_OBJ_FLAG_SCROLLABLE);
-    lv_obj_set_style_border_width(scr6_2_cont, 0, LV_PART_MAIN);
-    lv_obj_set_style_pad_all(scr6_2_cont, 0, LV_PART_MAIN);
-    lv_obj_set_style_pad_hor(scr6_2_cont, 0, LV_PART_MAIN);
-    lv_obj_set_style_pad_row(scr6_2_cont, 5, LV_PART_MAIN);
-    lv_obj_set_style_pad_column(scr6_2_cont, 0, LV_PART_MAIN);
     lv_obj_set_align(scr6_2_cont, LV_ALIGN_BOTTOM_LEFT);
     lv_obj_set_flex_flow(scr6_2_cont, LV_FLEX_FLOW_COLUMN);
     lv_obj_set_flex_align(scr6_2_cont, LV_FLEX_ALIGN_START, LV_FLEX_ALIGN_START, LV_FLEX_ALIGN_CENTER);
@@ -1974,6 +2371,20 @@ static void create6_2(lv_obj_t *parent)
     for(int i = 0; i < sizeof(label_list) / sizeof(label_list[0]); i++) {
         label_list[i] = scr6_2_create_label(scr6_2_cont);
     }
+    runtime_label = scr6_2_create_label(scr6_2_cont);
+    // energy breakdown below the gauge registers, scrolled into view
+    lv_obj_add_flag(scr6_2_cont, LV_OBJ_FLAG_SCROLLABLE);
+    for(int i = 0; i < ui_battery_energy_count() && i < energy_line_max; i++) {
+        energy_label_list[i] = scr6_2_create_label(scr6_2_cont);
+    }
+    history_chart = lv_chart_create(scr6_2_cont);
+    lv_obj_set_size(history_chart, lv_pct(90), 80);
+    lv_chart_set_type(history_chart, LV_CHART_TYPE_LINE);
+    lv_chart_set_point_count(history_chart, history_points);
+    lv_chart_set_range(history_chart, LV_CHART_AXIS_PRIMARY_Y, 0, 100);
+    lv_chart_set_div_line_count(history_chart, 3, 0);
+    lv_obj_set_style_size(history_chart, 0, LV_PART_INDICATOR);
+    history_ser = lv_chart_add_series(history_chart, lv_color_black(), LV_CHART_AXIS_PRIMARY_Y);
     // back
     scr_back_btn_create(parent, ("BQ27220"), scr6_btn_event_cb);
 }
@@ -1981,6 +2392,7 @@ static void create6_2(lv_obj_t *parent)
 static void entry6_2(void) 
 {
     scr6_2_battert_updata();
+    scr6_2_history_updata();
     ui_disp_full_refr();
     batt_6_2_timer = lv_timer_create(batt_6_2_updata_timer_event, 5000, NULL);
 }
@@ -1992,7 +2404,12 @@ static void exit6_2(void) {
     ui_disp_full_refr();
 }
 
-static void destroy6_2(void) { }
+static void destroy6_2(void) 
+{
+    runtime_label = NULL;
+    history_chart = NULL;
+    history_ser = NULL;
+}
 
 static scr_lifecycle_t screen6_2 = {
     .create = create6_2,
@@ -2001,6 +2418,8 @@ static scr_lifecycle_t screen6_2 = {
     .destroy = destroy6_2,
 };
 #undef line_max
+#undef energy_line_max
+#undef history_points
 #endif
 //************************************[ screen 7 ]****************************************** Other
 #if 1
@@ -2026,7 +2445,7 @@ static void input_timer_event(lv_timer_t *t)
 
     if(ret > 0)
     {
-        lv_label_set_text_fmt(input_touch,  "Touch: x: %03d | y: %03d", touch_x, touch_y);
+        ui_label_set_fmt(input_touch,  "Touch: x: %03d | y: %03d", touch_x, touch_y);
     }
 
     char keypay_v;
@@ -2034,7 +2453,7 @@ static void input_timer_event(lv_timer_t *t)
     if(ret > 0)
     {
         ui_input_set_keypay_flag();
-        lv_label_set_text_fmt(input_keypad, "Keypad: %c", keypay_v);
+        ui_label_set_fmt(input_keypad, "Keypad: %c", keypay_v);
     }
 
     static int sec = 0;
@@ -2046,14 +2465,14 @@ static void input_timer_event(lv_timer_t *t)
     {
         sec = 0;
         ui_other_get_LTR(&ch0, &ch1, &ps);
-        lv_label_set_text_fmt(light_sensor, "   c0: %d\n"
-                                            "   c1: %d\n"
-                                            "   ps: %d", ch0, ch1 ,ps);
+        ui_label_set_fmt(light_sensor, "   c0: %d\n"
+                                       "   c1: %d\n"
+                                       "   ps: %d", ch0, ch1 ,ps);
 
         ui_other_get_gyro(&gyro_x, &gyro_y, &gyro_z);
-        lv_label_set_text_fmt(gyroscope,    "   gyros_x: %.3f\n"
-                                            "   gyros_y: %.3f\n"
-                                            "   gyros_z: %.3f", gyro_x, gyro_y, gyro_z);
+        ui_label_set_fmt(gyroscope,    "   gyros_x: %.3f\n"
+                                       "   gyros_y: %.3f\n"
+                                       "   gyros_z: %.3f", gyro_x, gyro_y, gyro_z);
     }
 }
 
@@ -2187,12 +2606,12 @@ static void a7682_scr_event(lv_event_t *e)
 
 static void a7682_item_create(int curr_apge)
 {
-    printf("a7682_curr_page = %d\n", a7682_curr_page);
+    LOG_DEBUGF("UI", "A7682E page %d", a7682_curr_page);
     int start = (curr_apge * SETTING_PAGE_MAX_ITEM);
     int end = start + SETTING_PAGE_MAX_ITEM;
     if(end > a7682_num) end = a7682_num;
 
-    printf("start=%d, end=%d\n", start, end);
+    LOG_DEBUGF("UI", "Items %d to %d", start, end);
 
     for(int i = start; i < end; i++) {
         ui_a7682_handle *h = &a7682_handle_list[i];
@@ -2216,7 +2635,7 @@ static void a7682_item_create(int curr_apge)
 
 static void a7682_page_switch_cb(lv_event_t *e)
 {
-    char opt = (int)e->user_data;
+    char opt = (int)(intptr_t)e->user_data;
     
     if(a7682_num < SETTING_PAGE_MAX_ITEM) return;
 
@@ -2396,7 +2815,7 @@ static void create8_1(lv_obj_t *parent)
     lv_textarea_set_one_line(ta, true);
     lv_obj_set_width(ta, lv_pct(98));
     lv_obj_align(ta, LV_ALIGN_TOP_MID, 0, lv_pct(20));
-    lv_obj_set_style_text_font(ta, &Font_Mono_Bold_20, LV_PART_MAIN);
+    lv_obj_set_style_text_font(ta, &Font_Mono_Bold_20_cached, LV_PART_MAIN);
     // lv_obj_add_state(ta, LV_STATE_FOCUSED); /*To be sure the cursor is visible*/
     lv_obj_clear_flag(ta, LV_OBJ_FLAG_CLICKABLE);
     lv_obj_set_style_text_letter_space(ta, 1, LV_PART_MAIN | LV_STATE_DEFAULT);
@@ -2441,14 +2860,28 @@ static void scr8_2_btn_event_cb(lv_event_t * e)
     }
 }
 
+static lv_obj_t *at_term = NULL;
+static lv_timer_t *at_term_timer = NULL;
+
+static void at_term_timer_event(lv_timer_t *t)
+{
+    char buf[256];
+    int n;
+    while((n = ui_a7682_console_read(buf, sizeof(buf))) > 0) {
+        ui_term_write(at_term, buf, n);
+    }
+}
+
 static void create8_2(lv_obj_t *parent) 
 {
     lv_obj_t *lab = lv_label_create(parent);
     lv_obj_set_width(lab, lv_pct(95));
-    lv_obj_set_style_text_font(lab, FONT_BOLD_SIZE_17, LV_PART_MAIN);
-    lv_label_set_text(lab, "Open the serial port, set the baud rate to 115200, "
-                            "and send the AT command of A7682E to test the function.");
-    lv_obj_center(lab);
+    lv_obj_set_style_text_font(lab, FONT_BOLD_SIZE_14, LV_PART_MAIN);
+    lv_label_set_text(lab, "Send A7682E AT commands over the serial port at 115200.");
+    lv_obj_align(lab, LV_ALIGN_TOP_MID, 0, 36);
+
+    at_term = ui_term_create(parent, FONT_BOLD_MONO_SIZE_14, LCD_HOR_SIZE - 8, LCD_VER_SIZE - 80);
+    if(at_term) lv_obj_align(at_term, LV_ALIGN_BOTTOM_MID, 0, -4);
     
     lv_obj_t *back8_2_label = scr_back_btn_create(parent, ("AT test"), scr8_2_btn_event_cb);
 }
@@ -2456,12 +2889,18 @@ static void entry8_2(void)
 {
     ui_a7682_loop_resume();
     ui_disp_full_refr();
+    at_term_timer = lv_timer_create(at_term_timer_event, 100, NULL);
 }
 static void exit8_2(void) {
+    if(at_term_timer)
+    {
+        lv_timer_del(at_term_timer);
+        at_term_timer = NULL;
+    }
     ui_a7682_loop_suspend();
     ui_disp_full_refr();
 }
-static void destroy8_2(void) { }
+static void destroy8_2(void) { at_term = NULL; }
 
 static scr_lifecycle_t screen8_2 = {
     .create = create8_2,
@@ -2506,7 +2945,7 @@ static void create9(lv_obj_t *parent)
     else 
     {
         lv_obj_t * img = lv_img_create(parent);
-        lv_img_set_src(img, &img_start);
+        lv_img_set_src(img, &img_start_1bpp);
         lv_obj_center(img);
 
         lv_timer_create(shutdown_timer_event, 2000, (void *)parent);
@@ -2556,12 +2995,12 @@ static void pcm5102_scr_event(lv_event_t *e)
 
 static void pcm5102_item_create(int curr_apge)
 {
-    printf("pcm5102_curr_page = %d\n", pcm5102_curr_page);
+    LOG_DEBUGF("UI", "PCM5102 page %d", pcm5102_curr_page);
     int start = (curr_apge * SETTING_PAGE_MAX_ITEM);
     int end = start + SETTING_PAGE_MAX_ITEM;
     if(end > pcm5102_num) end = pcm5102_num;
 
-    printf("start=%d, end=%d\n", start, end);
+    LOG_DEBUGF("UI", "Items %d to %d", start, end);
 
     for(int i = start; i < end; i++) {
         ui_pcm5102_handle *h = &pcm5102_handle_list[i];
@@ -2585,7 +3024,7 @@ static void pcm5102_item_create(int curr_apge)
 
 static void pcm5102_page_switch_cb(lv_event_t *e)
 {
-    char opt = (int)e->user_data;
+    char opt = (int)(intptr_t)e->user_data;
     
     if(pcm5102_num < SETTING_PAGE_MAX_ITEM) return;
 
@@ -2720,71 +3159,408 @@ static scr_lifecycle_t screen10 = {
     .destroy = destroy10,
 };
 #endif
-//************************************[ UI ENTRY ]******************************************
-static lv_obj_t *menu_keypad;
-static lv_timer_t *menu_timer = NULL;
+//************************************[ screen 11 ]***************************************** Search
+#if 1
+static lv_obj_t *search_ta;
+static lv_obj_t *search_info;
+static lv_obj_t *search_list;
+static char (*search_hits)[UI_SEARCH_HIT_LEN] = NULL; // PSRAM
+static int search_hit_cnt = 0;
+static lv_timer_t *search_key_timer = NULL;
 
-static void indev_get_gesture_dir(lv_timer_t *t)
+static void scr11_btn_event_cb(lv_event_t * e)
 {
-    // Performance optimization: Skip processing if no gesture handler registered
-    if(!ui_get_gesture_dir) {
+    if(e->code == LV_EVENT_CLICKED){
+        scr_mgr_pop(false);
+    }
+}
+
+static void search_hit_add(const char *line)
+{
+    if(search_hits == NULL || search_hit_cnt >= UI_SEARCH_HIT_MAX)
         return;
+    lv_snprintf(search_hits[search_hit_cnt++], UI_SEARCH_HIT_LEN, "%s", line);
+}
+
+static void search_hit_bind(lv_obj_t *row, uint32_t index, void *user_data)
+{
+    lv_label_set_text_static(row, search_hits[index]);
+}
+
+static lv_obj_t * search_hit_row_create(lv_obj_t *list, void *user_data)
+{
+    return scr2_create_label(list);
+}
+
+static void search_run(void)
+{
+    uint32_t elapsed_ms = 0;
+
+    search_hit_cnt = 0;
+    int n = ui_search(lv_textarea_get_text(search_ta), UI_SEARCH_HIT_MAX, search_hit_add, &elapsed_ms);
+    lv_label_set_text_fmt(search_info, "%d found, %lu ms", n, (unsigned long)elapsed_ms);
+    ui_vlist_set_count(search_list, search_hit_cnt);
+}
+
+// The query is typed on the keypad; Enter searches
+static void search_key_timer_event(lv_timer_t *t)
+{
+    char key;
+
+    while(ui_input_get_keypay_val(&key) > 0) {
+        ui_input_set_keypay_flag();
+        if(key == LV_KEY_ENTER) {
+            search_run();
+        } else if(key == LV_KEY_BACKSPACE) {
+            lv_textarea_del_char(search_ta);
+        } else if(key >= ' ' && key <= '~') {
+            char str[2] = {key, '\0'};
+            lv_textarea_add_text(search_ta, str);
+        }
+    }
+}
+
+static void create11(lv_obj_t *parent)
+{
+    if(search_hits == NULL) {
+        size_t size = UI_SEARCH_HIT_MAX * UI_SEARCH_HIT_LEN;
+        search_hits = (char (*)[UI_SEARCH_HIT_LEN])heap_caps_malloc(size, MALLOC_CAP_SPIRAM);
+        if(search_hits == NULL)
+            search_hits = (char (*)[UI_SEARCH_HIT_LEN])heap_caps_malloc(size, MALLOC_CAP_8BIT);
     }
 
-    lv_indev_data_t data;
-    lv_indev_t * indev_pointer = lv_indev_get_next(NULL);
+    search_ta = lv_textarea_create(parent);
+    lv_textarea_set_one_line(search_ta, true);
+    lv_textarea_set_placeholder_text(search_ta, "Type, then Enter");
+    lv_obj_set_width(search_ta, lv_pct(95));
+    lv_obj_set_style_text_font(search_ta, FONT_BOLD_SIZE_15, LV_PART_MAIN);
+    lv_obj_clear_flag(search_ta, LV_OBJ_FLAG_CLICKABLE);
+    lv_obj_align(search_ta, LV_ALIGN_TOP_MID, 0, 35);
 
-    // Performance optimization: Early exit if no input device
-    if(!indev_pointer) {
-        return;
+    search_info = lv_label_create(parent);
+    lv_obj_set_style_text_font(search_info, FONT_BOLD_SIZE_14, LV_PART_MAIN);
+    lv_label_set_text(search_info, "Messages and logs");
+    lv_obj_align_to(search_info, search_ta, LV_ALIGN_OUT_BOTTOM_LEFT, 0, 4);
+
+    search_list = ui_vlist_create(parent, LV_HOR_RES - 13, LV_VER_RES - 120, UI_SEARCH_ROW_HEIGHT,
+                                  search_hit_row_create, search_hit_bind, NULL);
+    lv_obj_set_style_bg_color(search_list, DECKPRO_COLOR_BG, LV_PART_MAIN);
+    lv_obj_set_style_border_width(search_list, 0, LV_PART_MAIN);
+    lv_obj_set_style_pad_all(search_list, 0, LV_PART_MAIN);
+    lv_obj_align(search_list, LV_ALIGN_BOTTOM_RIGHT, 0, 0);
+
+    scr_back_btn_create(parent, ("Search"), scr11_btn_event_cb);
+}
+static void entry11(void)
+{
+    ui_disp_full_refr();
+    search_key_timer = lv_timer_create(search_key_timer_event, 100, NULL);
+}
+static void exit11(void) {
+    ui_disp_full_refr();
+    if(search_key_timer) {
+        lv_timer_del(search_key_timer);
+        search_key_timer = NULL;
     }
+}
+static void destroy11(void) { }
 
-    static lv_point_t last_point;
-    static bool is_press = false;
-    static uint32_t last_process_time = 0;
+static scr_lifecycle_t screen11 = {
+    .create = create11,
+    .entry = entry11,
+    .exit  = exit11,
+    .destroy = destroy11,
+};
+#endif
+//************************************[ screen 12 ]***************************************** Files
+#if 1
+static lv_obj_t *files_path_lab;
+static lv_obj_t *files_info;
+static lv_obj_t *files_list;
+static lv_timer_t *files_timer = NULL;
+static char files_path[64] = "/";
+static int files_sort = 0;
+static int files_cnt = 0;
+static bool files_building = false;
+static const char *files_sort_names[] = {"name", "newest", "largest"};
+static char reader_path[64];
+
+static void scr12_btn_event_cb(lv_event_t * e)
+{
+    if(e->code == LV_EVENT_CLICKED){
+        scr_mgr_pop(false);
+    }
+}
+
+static void files_info_update(bool building)
+{
+    files_building = building;
+    lv_label_set_text_fmt(files_info, "%d by %s%s", files_cnt, files_sort_names[files_sort],
+                          building ? ", indexing" : "");
+}
 
-    // Performance optimization: Throttle processing to reduce CPU load
-    uint32_t now = lv_tick_get();
-    if(now - last_process_time < UI_TOUCH_POLL_RATE) {
+static void files_load(void)
+{
+    bool building = false;
+    files_cnt = ui_files_open(files_path, files_sort, &building);
+    lv_label_set_text(files_path_lab, files_path);
+    if(files_cnt < 0) {
+        files_cnt = 0;
+        lv_label_set_text(files_info, "No card");
+    } else {
+        files_info_update(building);
+    }
+    ui_vlist_set_count(files_list, files_cnt);
+    ui_vlist_scroll_to(files_list, 0);
+}
+
+static void files_up(void)
+{
+    char *slash = strrchr(files_path, '/');
+    if(slash == NULL || files_path[1] == '\0') return;
+    if(slash == files_path) slash++;
+    *slash = '\0';
+    files_load();
+}
+
+static void files_row_event(lv_event_t *e)
+{
+    int idx = ui_vlist_get_index((lv_obj_t *)e->target);
+    char line[UI_FILES_LINE_LEN];
+    char name[UI_FILES_LINE_LEN];
+    bool is_dir;
+
+    if(e->code != LV_EVENT_CLICKED || idx < 0) return;
+    if(!ui_files_get(idx, line, sizeof(line), name, sizeof(name), &is_dir)) return;
+
+    size_t len = strlen(files_path);
+    if(len + strlen(name) + 2 > sizeof(files_path)) return;
+    if(!is_dir) {
+        const char *ext = strrchr(name, '.');
+        if(ext == NULL || (strcasecmp(ext, ".txt") != 0 && strcasecmp(ext, ".md") != 0)) return;
+        int n = lv_snprintf(reader_path, sizeof(reader_path), "%s%s%s", files_path, len > 1 ? "/" : "", name);
+        if(n < 0 || (size_t)n >= sizeof(reader_path)) return;
+        scr_mgr_push(SCREEN12_1_ID, false);
         return;
     }
-    last_process_time = now;
+    lv_snprintf(files_path + len, sizeof(files_path) - len, "%s%s", len > 1 ? "/" : "", name);
+    files_load();
+}
+
+static void files_bind(lv_obj_t *row, uint32_t index, void *user_data)
+{
+    char line[UI_FILES_LINE_LEN];
+    char name[UI_FILES_LINE_LEN];
+    bool is_dir;
 
-    _lv_indev_read(indev_pointer, &data);
+    if(ui_files_get(index, line, sizeof(line), name, sizeof(name), &is_dir))
+        lv_label_set_text(row, line);
+    else
+        lv_label_set_text(row, "");
+}
 
-    if(data.state == LV_INDEV_STATE_PR){
-        // Performance optimization: Filter out invalid coordinates early
-        if(data.point.x <= 1 && data.point.y <= 1) {
-            return; // Skip processing invalid touch coordinates
-        }
+static lv_obj_t * files_row_create(lv_obj_t *list, void *user_data)
+{
+    lv_obj_t *label = scr2_create_label(list);
+    lv_obj_add_flag(label, LV_OBJ_FLAG_CLICKABLE);
+    lv_obj_add_event_cb(label, files_row_event, LV_EVENT_CLICKED, NULL);
+    return label;
+}
 
-        if(is_press == false) {
-            is_press = true;
-            last_point = data.point;
-            return; // Don't process gestures on initial press
+// Backspace goes up, 's' changes the sort, 'r' reindexes; a finished
+// rebuild is picked up here too
+static void files_timer_event(lv_timer_t *t)
+{
+    char key;
+    bool building;
+
+    while(ui_input_get_keypay_val(&key) > 0) {
+        ui_input_set_keypay_flag();
+        if(key == LV_KEY_BACKSPACE) {
+            files_up();
+        } else if(key == 's') {
+            files_sort = (files_sort + 1) % 3;
+            files_load();
+        } else if(key == 'r') {
+            ui_files_rebuild();
         }
+    }
+
+    // Only redraw on a change; the panel is e-paper
+    int n = ui_files_poll(&building);
+    if(n >= 0) {
+        files_cnt = n;
+        ui_vlist_set_count(files_list, files_cnt);
+        ui_vlist_refresh(files_list);
+    }
+    if(n >= 0 || building != files_building)
+        files_info_update(building);
+}
+
+static void create12(lv_obj_t *parent)
+{
+    files_path_lab = lv_label_create(parent);
+    lv_obj_set_width(files_path_lab, lv_pct(95));
+    lv_obj_set_style_text_font(files_path_lab, FONT_BOLD_SIZE_15, LV_PART_MAIN);
+    lv_label_set_long_mode(files_path_lab, LV_LABEL_LONG_DOT);
+    lv_obj_align(files_path_lab, LV_ALIGN_TOP_MID, 0, 35);
+
+    files_info = lv_label_create(parent);
+    lv_obj_set_style_text_font(files_info, FONT_BOLD_SIZE_14, LV_PART_MAIN);
+    lv_label_set_text(files_info, "");
+    lv_obj_align_to(files_info, files_path_lab, LV_ALIGN_OUT_BOTTOM_LEFT, 0, 4);
+
+    files_list = ui_vlist_create(parent, LV_HOR_RES - 13, LV_VER_RES - 100, UI_FILES_ROW_HEIGHT,
+                                 files_row_create, files_bind, NULL);
+    lv_obj_set_style_bg_color(files_list, DECKPRO_COLOR_BG, LV_PART_MAIN);
+    lv_obj_set_style_border_width(files_list, 0, LV_PART_MAIN);
+    lv_obj_set_style_pad_all(files_list, 0, LV_PART_MAIN);
+    lv_obj_align(files_list, LV_ALIGN_BOTTOM_RIGHT, 0, 0);
+
+    scr_back_btn_create(parent, ("Files"), scr12_btn_event_cb);
+}
+static void entry12(void)
+{
+    files_load();
+    ui_disp_full_refr();
+    files_timer = lv_timer_create(files_timer_event, 200, NULL);
+}
+static void exit12(void) {
+    ui_disp_full_refr();
+    if(files_timer) {
+        lv_timer_del(files_timer);
+        files_timer = NULL;
+    }
+    ui_files_close();
+}
+static void destroy12(void) { }
+
+static scr_lifecycle_t screen12 = {
+    .create = create12,
+    .entry = entry12,
+    .exit  = exit12,
+    .destroy = destroy12,
+};
+#endif
+//************************************[ screen 12.1 ]*************************************** Reader
+#if 1
+static lv_obj_t *reader_view;
+static lv_obj_t *reader_page_lab;
+static lv_timer_t *reader_timer = NULL;
+static uint32_t reader_pages = 0;
+static uint32_t reader_shown = UINT32_MAX;
+static bool reader_done = false;
+#define READER_W (LCD_HOR_SIZE - 8)
+#define READER_H (LCD_VER_SIZE - 44)
+
+static void scr12_1_btn_event_cb(lv_event_t * e)
+{
+    if(e->code == LV_EVENT_CLICKED){
+        scr_mgr_pop(false);
+    }
+}
 
-        lv_coord_t diff_x = last_point.x - data.point.x;
-        lv_coord_t diff_y = last_point.y - data.point.y;
-
-        // Performance optimization: Use configurable gesture distance
-        if(diff_y > UI_GESTURE_DISTANCE) { // swipe up
-            ui_get_gesture_dir(LV_DIR_TOP);
-            is_press = false; // Reset to prevent multiple triggers
-        } else if(diff_y < -UI_GESTURE_DISTANCE) { // swipe down
-            ui_get_gesture_dir(LV_DIR_BOTTOM);
-            is_press = false;
-        } else if(diff_x > UI_GESTURE_DISTANCE) { // swipe right
-            ui_get_gesture_dir(LV_DIR_LEFT);
-            is_press = false;
-        } else if(diff_x < -UI_GESTURE_DISTANCE) { // swipe left
-            ui_get_gesture_dir(LV_DIR_RIGHT);
-            is_press = false;
+static void reader_page_update(void)
+{
+    uint32_t page = ui_reader_get_page(reader_view);
+    if(page == reader_shown) return;
+    reader_shown = page;
+    lv_label_set_text_fmt(reader_page_lab, "%lu / %lu%s", (unsigned long)page + 1,
+                          (unsigned long)reader_pages, reader_done ? "" : "+");
+}
+
+// Space, Enter or 'n' turn forward, Backspace or 'p' back; the page
+// count grows here while the document is paginated
+static void reader_timer_event(lv_timer_t *t)
+{
+    char key;
+    bool done;
+
+    while(ui_input_get_keypay_val(&key) > 0) {
+        ui_input_set_keypay_flag();
+        if(key == ' ' || key == LV_KEY_ENTER || key == 'n') {
+            ui_reader_turn(reader_view, 1);
+        } else if(key == LV_KEY_BACKSPACE || key == 'p') {
+            ui_reader_turn(reader_view, -1);
         }
-    }else{
-        is_press = false;
-        last_point.x = 0;
-        last_point.y = 0;
+    }
+
+    uint32_t pages = ui_doc_pages(&done);
+    if(pages != reader_pages || done != reader_done) {
+        reader_pages = pages;
+        reader_done = done;
+        ui_reader_set_pages(reader_view, pages);
+        reader_shown = UINT32_MAX;
+    }
+    reader_page_update();
+}
+
+static void create12_1(lv_obj_t *parent)
+{
+    reader_page_lab = lv_label_create(parent);
+    lv_obj_set_style_text_font(reader_page_lab, FONT_BOLD_SIZE_14, LV_PART_MAIN);
+    lv_label_set_text(reader_page_lab, "");
+    lv_obj_align(reader_page_lab, LV_ALIGN_TOP_RIGHT, -8, 10);
+
+    reader_view = ui_reader_create(parent, READER_W, READER_H, ui_doc_render);
+    lv_obj_align(reader_view, LV_ALIGN_BOTTOM_MID, 0, -4);
+
+    scr_back_btn_create(parent, ("Reader"), scr12_1_btn_event_cb);
+}
+static void entry12_1(void)
+{
+    reader_pages = 0;
+    reader_done = false;
+    reader_shown = UINT32_MAX;
+    ui_reader_reset(reader_view);
+    if(ui_doc_open(reader_path, FONT_BOLD_MONO_SIZE_15, READER_W, READER_H)) {
+        reader_timer = lv_timer_create(reader_timer_event, 100, NULL);
+        reader_timer_event(reader_timer);
+    } else {
+        lv_label_set_text(reader_page_lab, "Cannot open");
+    }
+    ui_disp_full_refr();
+}
+static void exit12_1(void) {
+    ui_disp_full_refr();
+    if(reader_timer) {
+        lv_timer_del(reader_timer);
+        reader_timer = NULL;
+    }
+    ui_doc_close();
+}
+static void destroy12_1(void) {
+    reader_view = NULL;
+}
+
+static scr_lifecycle_t screen12_1 = {
+    .create = create12_1,
+    .entry = entry12_1,
+    .exit  = exit12_1,
+    .destroy = destroy12_1,
+};
+#endif
+//************************************[ UI ENTRY ]******************************************
+static lv_obj_t *menu_keypad;
+static lv_timer_t *menu_timer = NULL;
+
+static void indev_get_gesture_dir(lv_timer_t *t)
+{
+    // Swipes come pre-detected from the touch pipeline. Reading the indev
+    // here would pull samples away from LVGL, so only the result is taken.
+    // Take it even without a handler so a stale swipe never fires later.
+    TouchGesture gesture = LVGL ? LVGL->takeTouchGesture() : TOUCH_GESTURE_NONE;
+
+    if(!ui_get_gesture_dir) {
+        return;
+    }
+
+    switch(gesture) {
+        case TOUCH_GESTURE_SWIPE_UP:    ui_get_gesture_dir(LV_DIR_TOP);    break;
+        case TOUCH_GESTURE_SWIPE_DOWN:  ui_get_gesture_dir(LV_DIR_BOTTOM); break;
+        case TOUCH_GESTURE_SWIPE_LEFT:  ui_get_gesture_dir(LV_DIR_LEFT);   break;
+        case TOUCH_GESTURE_SWIPE_RIGHT: ui_get_gesture_dir(LV_DIR_RIGHT);  break;
+        default: break;
     }
 }
 
@@ -2800,7 +3576,7 @@ static void menu_keypay_get_event(lv_timer_t *t)
         sec = 0;
         press = true;
         ui_input_set_keypay_flag();
-        lv_label_set_text_fmt(menu_keypad, "%c", keypay_v);
+        ui_label_set_fmt(menu_keypad, "%c", keypay_v);
     }
 
     if(press){
@@ -2818,6 +3594,11 @@ static void menu_taskbar_update_timer_cb(lv_timer_t *t)
     static int sec = 0;
     sec++;
 
+    // Plugins installed while the menu is up
+    if(app_index_refresh()) {
+        show_menu_folder();
+    }
+
     // Critical safety check: Early exit if no taskbar widgets exist
     if(!menu_taskbar_battery_percent && !menu_taskbar_wifi && !menu_taskbar_charge) {
         return;
@@ -2831,7 +3612,7 @@ static void menu_taskbar_update_timer_cb(lv_timer_t *t)
     if(sec % UI_BATTERY_UPDATE_INTERVAL == 0)
     {
         finish = ui_battery_27220_get_charge_finish();
-        percent = ui_battery_27220_get_percent();
+        percent = status_quantise_battery(ui_battery_27220_get_percent());
 
         if(taskbar_statue[TASKBAR_ID_CHARGE_FINISH] != finish)
         {
@@ -2850,7 +3631,7 @@ static void menu_taskbar_update_timer_cb(lv_timer_t *t)
         {
             // Critical safety check: Only update if label exists
             if(menu_taskbar_battery_percent) {
-                lv_label_set_text_fmt(menu_taskbar_battery_percent, "%d%%", percent);
+                ui_label_set_fmt(menu_taskbar_battery_percent, "%d%%", percent);
             }
             taskbar_statue[TASKBAR_ID_BATTERY_PERCENT] = percent;
         }
@@ -2896,7 +3677,7 @@ static void menu_taskbar_update_timer_cb(lv_timer_t *t)
 void ui_deckpro_entry(void)
 {
     lv_disp_t *disp = lv_disp_get_default();
-    disp->theme = lv_theme_mono_init(disp, false, LV_FONT_DEFAULT);
+    disp->theme = ui_theme_mono_init(disp);
 
     // Performance optimization: Use configurable touch polling rate
     touch_chk_timer = lv_timer_create(indev_get_gesture_dir, UI_TOUCH_POLL_RATE, NULL);
@@ -2912,7 +3693,9 @@ void ui_deckpro_entry(void)
     scr_mgr_register(SCREEN1_1_ID,  &screen1_1);    // - Auto send
     scr_mgr_register(SCREEN2_ID,    &screen2);      // Setting
     scr_mgr_register(SCREEN2_1_ID,  &screen2_1);    //  - About System
+    scr_mgr_register(SCREEN2_2_ID,  &screen2_2);    //  - CPU Profile
     scr_mgr_register(SCREEN3_ID,    &screen3);      // 
+    scr_mgr_register(SCREEN3_1_ID,  &screen3_1);    //  - Map
     scr_mgr_register(SCREEN4_ID,    &screen4);      // WIFI
     scr_mgr_register(SCREEN4_1_ID,  &screen4_1);    //  - WIFI Config
     scr_mgr_register(SCREEN4_2_ID,  &screen4_2);    //  - WIFI Scan
@@ -2926,8 +3709,23 @@ void ui_deckpro_entry(void)
     scr_mgr_register(SCREEN8_2_ID,  &screen8_2);    //  - AT test
     scr_mgr_register(SCREEN9_ID,    &screen9);      // 
     scr_mgr_register(SCREEN10_ID,   &screen10);     // 
+    scr_mgr_register(SCREEN11_ID,   &screen11);     // Search
+    scr_mgr_register(SCREEN12_ID,   &screen12);     // Files
+    scr_mgr_register(SCREEN12_1_ID, &screen12_1);   //  - Reader
+
+    // Menu screens keep their timers in entry/exit, so they can be built early
+    // and kept after pop. Shutdown (screen9) starts its timer in create.
+    static const int preload_ids[] = {
+        SCREEN1_ID, SCREEN2_ID, SCREEN3_ID, SCREEN4_ID, SCREEN5_ID,
+        SCREEN6_ID, SCREEN7_ID, SCREEN8_ID, SCREEN10_ID,
+    };
+    for(int i = 0; i < GET_BUFF_LEN(preload_ids); i++) {
+        scr_mgr_set_preload(preload_ids[i], true);
+    }
+    scr_mgr_set_preload_policy(SCR_MGR_PRELOAD_IDLE_MS, SCR_MGR_PRELOAD_EXPIRE_MS);
 
     scr_mgr_switch(SCREEN0_ID, false); // set root screen
+    resume_state_restore_ui();         // back to the screens shown before deep sleep
     scr_mgr_set_anim(LV_SCR_LOAD_ANIM_OVER_LEFT, LV_SCR_LOAD_ANIM_OVER_LEFT, LV_SCR_LOAD_ANIM_OVER_LEFT);
 
     // menu_keypad = lv_label_create(lv_layer_top());
@@ -40,7 +40,21 @@ extern "C" {
 #define DECKPRO_COLOR_BG        lv_color_white()
 #define DECKPRO_COLOR_FG        lv_color_black()
 #define UI_SLIDING_DISTANCE     15  // Reduced from 40 for very responsive gestures
-#define UI_WIFI_SCAN_ITEM_MAX   13
+#define UI_WIFI_SCAN_ITEM_MAX   64  // Scan results kept, shown through a recycling list
+#define UI_WIFI_ROW_HEIGHT      18
+#define UI_LORA_HISTORY_MAX     200 // Send/receive lines kept in PSRAM
+#define UI_LORA_HISTORY_LEN     48
+#define UI_LORA_ROW_HEIGHT      22
+#define UI_LORA_COMPOSE_MAX     96  // Characters typed into one message
+#define UI_LORA_COMPOSE_HEIGHT  64  // Candidate strip and compose line under the history
+#define UI_PREDICT_MAX          3   // Candidates in the strip
+#define UI_PREDICT_WORD_LEN     24
+#define UI_SEARCH_HIT_MAX       50  // Search results shown, lines in PSRAM
+#define UI_SEARCH_HIT_LEN       64
+#define UI_SEARCH_ROW_HEIGHT    22
+#define UI_FILES_ROW_HEIGHT     22
+#define UI_FILES_LINE_LEN       64
+#define UI_SETTING_ROW_HEIGHT   40
 
 /*********************************************************************************
  *                                  TYPEDEFS
@@ -66,6 +80,11 @@ enum {
     SCREEN8_2_ID,
     SCREEN9_ID,
     SCREEN10_ID,
+    SCREEN2_2_ID,       // Appended, so stored screen IDs keep their meaning
+    SCREEN11_ID,
+    SCREEN3_1_ID,
+    SCREEN12_ID,
+    SCREEN12_1_ID,
 };
 
 typedef void (*ui_indev_read_cb)(int);
@@ -120,7 +139,7 @@ typedef struct _ui_a7682 {
 
 
 typedef struct {
-    char name[16];
+    char name[33];  // Whole SSID, rows clip it
     int rssi;
 }ui_wifi_scan_info_t;
 
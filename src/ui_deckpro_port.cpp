@@ -9,9 +9,36 @@
 #include "SPI.h"
 #include <TinyGPS++.h>
 #include "peripheral.h"
+#include "lora_stats.h"
+#include "gps_track.h"
+#include "msg_store.h"
+#include "net_manager.h"
+#include "simple_logger.h"
+#include "text_search.h"
+#include "modem_at.h"
+#include "wifi_scan.h"
+#include "energy_profiler.h"
+#include "batt_forecast.h"
+#include "power_domain.h"
+#include "tsdb.h"
+#include "time_service.h"
+#include "cpu_profiler.h"
+#include "audio_service.h"
+#include "fs_service.h"
+#include "font_pager.h"
+#include "map_tiles.h"
+#include "dir_index.h"
+#include "doc_reader.h"
+#include "predict.h"
+#include "sensor_sampler.h"
+#include "nav_fusion.h"
 #include "WiFi.h"
 #include <ctype.h>
+#include <freertos/stream_buffer.h>
 #include <TouchDrvCSTXXX.hpp>
+#ifdef INTEGRATION_LAYER_ENABLED
+#include "integration/config_manager.h"
+#endif
 
 
 // extern 
@@ -27,8 +54,20 @@ volatile bool default_gyro_status = true;
 volatile bool default_a7682_status = true;
 // ----
 
+// With the integration layer the settings are schema keys kept in ConfigManager's
+// NVS tier and read from the flat table; the globals are the fallback without it
+#ifdef INTEGRATION_LAYER_ENABLED
+#define SETTING_SET(id, value) SET_CONFIG(id, value)
+#define SETTING_GET(id, value) GET_CONFIG(id)
+#else
+#define SETTING_SET(id, value)
+#define SETTING_GET(id, value) (value)
+#endif
+
 void ui_disp_full_refr(void)
 {
+    // A cached snapshot of this screen goes to the panel right after entry()
+    if(scr_mgr_restoring()) return;
     disp_full_refr();
 }
 //************************************[ screen 0 ]****************************************** menu
@@ -40,28 +79,58 @@ float ui_lora_get_freq(void)
 }
 int ui_lora_get_mode(void)
 {
+    peri_init_ensure(E_PERI_LORA);
     return lora_get_mode();
 }
 void ui_lora_set_mode(int mode)
 {
+    peri_init_ensure(E_PERI_LORA);
     lora_set_mode(mode);
 }
 void ui_lora_send(const char *str)
 {
-    lora_transmit(str);
+    peri_init_ensure(E_PERI_LORA);
+    // ESP-NOW to neighbours in WiFi range as well, when that link is up
+    size_t len = strlen(str);
+    if(!net_manager_send(NET_PEER_BROADCAST, (const uint8_t *)str, len)) {
+        LOG_WARN("LoRa", "TX queue full, packet dropped");
+        return;
+    }
+    msg_store_append(MSG_CHANNEL_LORA, "lora", str, len, MSG_FLAG_OUT);
+    predict_learn(str);
 }
-void ui_lora_recv_loop(void)
+int ui_lora_predict(const char *word, char (*out)[UI_PREDICT_WORD_LEN], int max)
 {
-    lora_receive_loop();
+    PredictCandidate cands[PREDICT_CANDIDATES_MAX];
+    int n = predict_complete(word, cands, max);
+    for(int i = 0; i < n; i++)
+        lv_snprintf(out[i], UI_PREDICT_WORD_LEN, "%s", cands[i].word);
+    return n;
 }
 bool ui_lora_get_recv(const char **str, int *rssi)
 {
+    peri_init_ensure(E_PERI_LORA);
     return lora_get_recv(str, rssi);
 }
 void ui_lora_set_recv_flag(void)
 {
     lora_set_recv_flag();
 }
+void ui_lora_get_stats(char *buf, size_t len)
+{
+    lora_stats_format(buf, len);
+}
+int ui_lora_history(int max, void (*cb)(const char *text, int rssi, bool sent))
+{
+    MsgStoreMessage *msgs = (MsgStoreMessage *)heap_caps_malloc(max * sizeof(MsgStoreMessage), MALLOC_CAP_SPIRAM);
+    if(msgs == NULL) return 0;
+    int n = msg_store_conversation(MSG_CHANNEL_LORA, "lora", 0, msgs, max);
+    for(int i = 0; i < n; i++) {
+        cb(msgs[i].text, msgs[i].rssi, msgs[i].flags & MSG_FLAG_OUT);
+    }
+    free(msgs);
+    return n;
+}
 //************************************[ screen 2 ]****************************************** setting
 #if 1
 // set function
@@ -69,71 +138,78 @@ void ui_lora_set_recv_flag(void)
 void ui_setting_set_language(int language)
 {
     default_language = language;
+    SETTING_SET(SETTINGS_LANGUAGE, language);
 }
 void ui_setting_set_keypad_light(bool on)
 {
     digitalWrite(BOARD_KEYBOARD_LED, on);
     default_keypad_light = on;
+    SETTING_SET(SETTINGS_KEYPAD_LIGHT, on);
 }
 void ui_setting_set_motor_status(bool on)
 {
     digitalWrite(BOARD_MOTOR_PIN, on);
     default_motor_status = on;
+    SETTING_SET(SETTINGS_MOTOR, on);
 }
 void ui_setting_set_gps_status(bool on)
 {
-    // enable GPS module power
-    digitalWrite(BOARD_GPS_EN, on);
+    // the GPS power manager holds the rail, before and after the GPS is up
+    gps_power_enable(on);
     default_gps_status = on;
+    SETTING_SET(SETTINGS_GPS, on);
 }
 void ui_setting_set_lora_status(bool on)
 {
     // enable LORA module power
-    digitalWrite(BOARD_LORA_EN, on);
+    power_domain_set(power_domain_user(PWR_DOMAIN_LORA, "lora"), on);
     default_lora_status = on;
+    SETTING_SET(SETTINGS_LORA, on);
 }
 void ui_setting_set_gyro_status(bool on)
 {
     // enable gyroscope module power
-    digitalWrite(BOARD_1V8_EN, on);
+    power_domain_set(power_domain_user(PWR_DOMAIN_1V8, "gyro"), on);
     default_gyro_status = on;
+    SETTING_SET(SETTINGS_GYRO, on);
 }
 void ui_setting_set_a7682_status(bool on)
 {
-    // enable 7682 module power
-    digitalWrite(BOARD_6609_EN, on);
+    // enable 7682 module power; the rail stays up while audio holds it too
+    power_domain_set(power_domain_user(PWR_DOMAIN_6609, "a7682e", ENERGY_CELL), on);
     digitalWrite(BOARD_A7682E_PWRKEY, on);
     default_a7682_status = on;
+    SETTING_SET(SETTINGS_A7682, on);
 }
 
 // get function
 int ui_setting_get_language(void)
 {
-    return default_language;
+    return SETTING_GET(SETTINGS_LANGUAGE, default_language);
 }
 bool ui_setting_get_keypad_light(void)
 {
-    return default_keypad_light;
+    return SETTING_GET(SETTINGS_KEYPAD_LIGHT, default_keypad_light);
 }
 bool ui_setting_get_motor_status(void)
 {
-    return default_motor_status;
+    return SETTING_GET(SETTINGS_MOTOR, default_motor_status);
 }
 bool ui_setting_get_gps_status(void)
 {
-    return default_gps_status;
+    return SETTING_GET(SETTINGS_GPS, default_gps_status);
 }
 bool ui_setting_get_lora_status(void)
 {
-    return default_lora_status;
+    return SETTING_GET(SETTINGS_LORA, default_lora_status);
 }
 bool ui_setting_get_gyro_status(void)
 {
-    return default_gyro_status;
+    return SETTING_GET(SETTINGS_GYRO, default_gyro_status);
 }
 bool ui_setting_get_a7682_status(void)
 {
-    return default_a7682_status;
+    return SETTING_GET(SETTINGS_A7682, default_a7682_status);
 }
 
 // About System
@@ -146,183 +222,270 @@ const char *ui_setting_get_hd_ver(void)
     return BOARD_T_DECK_PRO_VERSION;
 }
 
-void ui_setting_get_sd_capacity(uint64_t *total, uint64_t *used)
+bool ui_setting_get_sd_capacity(uint64_t *total, uint64_t *used)
 {
-    if(ui_test_sd_card())
-    {
-        if(total)
-            *total = SD.totalBytes() / (1024 * 1024);
-        if(used)
-            *used = SD.usedBytes() / (1024 * 1024);
-
-        printf("total=%lluMB, used=%lluMB\n", *total, *used);
+    // From the file service's cache; the first call starts the FAT scan on its worker
+    if(!ui_test_sd_card() || !fs_capacity(total, used))
+        return false;
 
-        uint64_t cardSize = SD.cardSize() / (1024 * 1024);
-        Serial.printf("SD Card Size: %lluMB\n", cardSize);
+    if(total)
+        *total = *total / (1024 * 1024);
+    if(used)
+        *used = *used / (1024 * 1024);
+    return true;
+}
 
-        uint64_t totalSize = SD.totalBytes() / (1024 * 1024);
-        Serial.printf("SD Card Total: %lluMB\n", totalSize);
+// Snapshot per refresh of the CPU Profile screen, so the rows agree with each other
+#define UI_CPU_PROF_PCS 6
+static CpuProfTask cpu_prof_tasks[CPU_PROF_TASKS];
+static CpuProfPc cpu_prof_pcs[UI_CPU_PROF_PCS];
+static CpuProfStats cpu_prof_stats;
+static int cpu_prof_task_cnt = 0;
+static int cpu_prof_pc_cnt = 0;
 
-        uint64_t usedSize = SD.usedBytes() / (1024 * 1024);
-        Serial.printf("SD Card Used: %lluMB\n", usedSize);
-    }
+int ui_cpu_prof_task_count(void)
+{
+    cpu_profiler_stats(&cpu_prof_stats);
+    if(!cpu_prof_stats.running) return 0;
+    cpu_prof_task_cnt = cpu_profiler_tasks(cpu_prof_tasks, CPU_PROF_TASKS);
+    cpu_prof_pc_cnt = cpu_profiler_top_pcs(cpu_prof_pcs, UI_CPU_PROF_PCS);
+    return cpu_prof_task_cnt;
+}
+bool ui_cpu_prof_task_get(int idx, const char **name, float *core0, float *core1)
+{
+    if(idx < 0 || idx >= cpu_prof_task_cnt) return false;
+    const CpuProfTask *t = &cpu_prof_tasks[idx];
+    *name = t->name;
+    *core0 = cpu_prof_stats.samples[0] ? t->samples[0] * 100.0f / cpu_prof_stats.samples[0] : 0;
+    *core1 = cpu_prof_stats.samples[1] ? t->samples[1] * 100.0f / cpu_prof_stats.samples[1] : 0;
+    return true;
+}
+bool ui_cpu_prof_pc_get(int idx, uint32_t *pc, float *percent)
+{
+    uint32_t total = cpu_prof_stats.samples[0] + cpu_prof_stats.samples[1];
+    if(idx < 0 || idx >= cpu_prof_pc_cnt || total == 0) return false;
+    *pc = cpu_prof_pcs[idx].pc;
+    *percent = cpu_prof_pcs[idx].samples * 100.0f / total;
+    return true;
 }
 
+
 #endif
 //************************************[ screen 3 ]****************************************** GPS
 void ui_gps_task_suspend(void)
 {
-    gps_task_suspend();
+    // nothing to suspend until the screen has brought the GPS up
+    if(peri_init_st[E_PERI_GPS]) gps_task_suspend();
 }
 void ui_gps_task_resume(void)
 {
-    gps_task_resume();
+    if(peri_init_ensure(E_PERI_GPS)) gps_task_resume();
 }
 void ui_gps_get_coord(double *lat, double *lng)
 {
+    peri_init_ensure(E_PERI_GPS);
+    // Dead reckoning between fixes once it knows its heading, the last fix before
+    NavEstimate nav;
+    if(nav_get(&nav) && nav.calibrated) {
+        *lat = nav.lat;
+        *lng = nav.lng;
+        return;
+    }
     gps_get_coord(lat, lng);
 }
 void ui_gps_get_data(uint16_t *year, uint8_t *month, uint8_t *day)
 {
+    peri_init_ensure(E_PERI_GPS);
     gps_get_data(year, month, day);
 }
 void ui_gps_get_time(uint8_t *hour, uint8_t *minute, uint8_t *second)
 {
+    peri_init_ensure(E_PERI_GPS);
     gps_get_time(hour, minute, second);
 }
 
 void ui_gps_get_satellites(uint32_t *vsat)
 {
+    peri_init_ensure(E_PERI_GPS);
     gps_get_satellites(vsat);
 }
 void ui_gps_get_speed(double *speed)
 {
+    peri_init_ensure(E_PERI_GPS);
     gps_get_speed(speed);
 }
+bool ui_gps_get_track(uint32_t *points, uint32_t *bytes)
+{
+    const GpsTrackStats *st = gps_track_stats();
+    *points = st->points;
+    *bytes = st->blocks * GPS_TRACK_BLOCK_SIZE;
+    return gps_track_running();
+}
+bool ui_map_open(uint8_t *zoom_min, uint8_t *zoom_max, double *lat, double *lng)
+{
+    if(!map_tiles_begin()) return false;
+    map_tiles_get_info(zoom_min, zoom_max, lat, lng);
+    return true;
+}
+const uint8_t *ui_map_get_tile(uint8_t z, uint32_t x, uint32_t y, bool render)
+{
+    return map_tiles_get(z, x, y, render);
+}
 //************************************[ screen 4 ]****************************************** Wifi Scan
 int is_chinese_utf8(const char *str) {
     unsigned char c = (unsigned char)str[0];
     return (c >= 0xE0 && c <= 0xEF);  // 检查第一个字节是否在 UTF-8 的中文字符范围内
 }
 
-void ui_wifi_get_scan_info(ui_wifi_scan_info_t *list, int list_len)
+int ui_wifi_get_scan_info(ui_wifi_scan_info_t *list, int list_len, uint32_t *version)
 {
-    int n = WiFi.scanNetworks();
-    if(n > list_len)
-        n = list_len;
-    
+    static WifiScanEntry entries[UI_WIFI_SCAN_ITEM_MAX];
+    uint32_t latest;
+    int cnt = 0;
+
+    // Rescans in the background once the cache is stale, the UI never waits on the radio
+    wifi_scan_request();
+    int n = wifi_scan_snapshot(entries, UI_WIFI_SCAN_ITEM_MAX, &latest);
+    if(latest == *version) return -1;
+    *version = latest;
+
     memset(list, 0, (sizeof(*list) * list_len));
-    for(int i = 0; i < n; i++)
+    for(int i = 0; i < n && cnt < list_len; i++)
     {
-        const char *str = WiFi.SSID(i).c_str();
-        if(is_chinese_utf8(str))
+        // Shown once the paged CJK font can draw them
+        if(is_chinese_utf8(entries[i].ssid) && !font_pager_covers(entries[i].ssid))
             continue;
-        strncpy(list[i].name, WiFi.SSID(i).c_str(), 16);
-        list[i].rssi = WiFi.RSSI(i);
+        memcpy(list[cnt].name, entries[i].ssid, sizeof(list[cnt].name));
+        list[cnt].rssi = entries[i].rssi;
+        cnt++;
     }
+    return cnt;
 }
 //************************************[ screen 5 ]****************************************** Test
 bool ui_test_get(int peri_id)
 {
-    return peri_init_st[peri_id];
+    return peri_init_ensure(peri_id);
 }
 bool ui_test_sd_card(void) 
 {
-    return peri_init_st[E_PERI_SD];
+    return peri_init_ensure(E_PERI_SD);
 }
 bool ui_test_a7682e(void) 
 {
-    return peri_init_st[E_PERI_A7682E];
+    return peri_init_ensure(E_PERI_A7682E);
 }
 bool ui_test_pcm5102a(void)
 {
-    return peri_init_st[E_PERI_PCM5102A];
+    return peri_init_ensure(E_PERI_PCM5102A);
 }
 
 //************************************[ screen 6 ]****************************************** Battery
 #if 1
 
-// BQ25896
+// BQ25896: from the charger snapshot, no bus traffic on the UI task
+static bq25896_snapshot_t *ui_chg_snap(bool adc)
+{
+    static bq25896_snapshot_t snap;
+    if(adc) BQ25896_request_adc(BQ25896_UI_ADC_MS);
+    BQ25896_get_snapshot(&snap);
+    return &snap;
+}
+
 bool ui_battery_25896_is_vbus_in(void)
 {
-    return PPM.isVbusIn();
+    return ui_chg_snap(false)->vbus_stat != 0;
 }
 
 bool ui_batt_25896_is_chg(void)
 {
-    if(PPM.isCharging() == false) {
-        return false;
-    } else {
-        return true;
-    }
-    // return true;
+    return ui_chg_snap(false)->chrg_stat != 0;
 }
 float ui_batt_25896_get_vbus(void)
 {
-    return (PPM.getVbusVoltage() *1.0 / 1000.0 );
-    // return 4.5;
+    return ui_chg_snap(true)->vbus_mv / 1000.0;
 }
 float ui_batt_25896_get_vsys(void)
 {
-    return (PPM.getSystemVoltage() * 1.0 / 1000.0);
-    // return 4.5;
+    return ui_chg_snap(true)->vsys_mv / 1000.0;
 }
 float ui_batt_25896_get_vbat(void)
 {
-    return (PPM.getBattVoltage() * 1.0 / 1000.0);
-    // return 4.5;
+    return ui_chg_snap(true)->vbat_mv / 1000.0;
 }
 float ui_batt_25896_get_volt_targ(void)
 {
-    return (PPM.getChargeTargetVoltage() * 1.0 / 1000.0);
-    // return 4.5; 
+    return ui_chg_snap(false)->vreg_mv / 1000.0;
 }
 float ui_batt_25896_get_chg_curr(void)
 {
-    return (PPM.getChargeCurrent());
-    // return 4.5;
+    return ui_chg_snap(true)->ichg_ma;
 }
 float ui_batt_25896_get_pre_curr(void)
 {
-    return (PPM.getPrechargeCurr());;
-    // return 4.5;
+    return ui_chg_snap(false)->iprechg_ma;
 }
 const char * ui_batt_25896_get_chg_st(void)
 {
-    return PPM.getChargeStatusString();
-    // return "hello";
+    return BQ25896_chg_str(ui_chg_snap(false)->chrg_stat);
 }
 const char * ui_batt_25896_get_vbus_st(void)
 {
-    return PPM.getBusStatusString();
-    // return "hello";
+    return BQ25896_bus_str(ui_chg_snap(false)->vbus_stat);
 }
 const char * ui_batt_25896_get_ntc_st(void)
 {
-    return PPM.getNTCStatusString();
-    // return "hello";
+    return BQ25896_ntc_str(ui_chg_snap(false)->fault);
 }
 /* 27220 */
+// The sampler's copy; zeros until its first read
+static SensorGauge *ui_gauge_snap(void)
+{
+    static SensorGauge snap;
+    sensor_get_gauge(&snap);
+    return &snap;
+}
+
 bool ui_battery_27220_is_vaild(void) {return peri_init_st[E_PERI_BQ27220]; }
-bool ui_battery_27220_get_input(void) { return bq27220.getIsCharging();}
-bool ui_battery_27220_get_charge_finish(void) { return bq27220.getCharingFinish();}
-uint16_t ui_battery_27220_get_status(void) 
-{
-    BQ27220BatteryStatus batt;
-    bq27220.getBatteryStatus(&batt);
-    return batt.full;
-}
-uint16_t ui_battery_27220_get_voltage(void) { return bq27220.getVoltage(); }
-int16_t ui_battery_27220_get_current(void) { return bq27220.getCurrent(); }
-uint16_t ui_battery_27220_get_temperature(void) { return bq27220.getTemperature(); }
-uint16_t ui_battery_27220_get_full_capacity(void) { return bq27220.getFullChargeCapacity(); }
-uint16_t ui_battery_27220_get_design_capacity(void) { return bq27220.getDesignCapacity(); }
-uint16_t ui_battery_27220_get_remain_capacity(void) { return bq27220.getRemainingCapacity(); }
-uint16_t ui_battery_27220_get_percent(void) { return bq27220.getStateOfCharge(); }
-uint16_t ui_battery_27220_get_health(void) { return bq27220.getStateOfHealth(); }
+bool ui_battery_27220_get_input(void) { return ui_gauge_snap()->charging; }
+bool ui_battery_27220_get_charge_finish(void) { return ui_gauge_snap()->charge_done; }
+uint16_t ui_battery_27220_get_status(void) { return ui_gauge_snap()->status; }
+uint16_t ui_battery_27220_get_voltage(void) { return ui_gauge_snap()->mv; }
+int16_t ui_battery_27220_get_current(void) { return ui_gauge_snap()->ma; }
+uint16_t ui_battery_27220_get_temperature(void) { return ui_gauge_snap()->temp_dk; }
+uint16_t ui_battery_27220_get_full_capacity(void) { return ui_gauge_snap()->full_mah; }
+uint16_t ui_battery_27220_get_design_capacity(void) { return ui_gauge_snap()->design_mah; }
+uint16_t ui_battery_27220_get_remain_capacity(void) { return ui_gauge_snap()->remain_mah; }
+uint16_t ui_battery_27220_get_percent(void) { return ui_gauge_snap()->soc; }
+uint16_t ui_battery_27220_get_health(void) { return ui_gauge_snap()->soh; }
+int ui_battery_energy_count(void) { return ENERGY_BUCKETS; }
+bool ui_battery_energy_get(int idx, const char **name, float *mah, float *ma)
+{
+    EnergyStats stats;
+    if(idx < 0 || idx >= ENERGY_BUCKETS) return false;
+    *name = energy_subsystem_name(idx);
+    if(!energy_profiler_stats(&stats)) return false;
+    *mah = stats.bucket[idx].mah;
+    *ma = stats.bucket[idx].ma;
+    return true;
+}
+// Mean state of charge over count equal steps ending now, -1 where there is none
+int ui_battery_history(int16_t *pct, int count, uint32_t span_s)
+{
+    TsdbBucket bucket[48];
+    if(count <= 0 || count > 48 || !time_valid()) return 0;
+    uint32_t step = span_s / count;
+    uint32_t from = time_now_s() / step * step - step * (count - 1);
+    int filled = tsdb_rollup(TSDB_BATTERY_PCT, from, step, bucket, count);
+    for(int i = 0; i < count; i++) {
+        pct[i] = bucket[i].count ? (int16_t)lroundf(bucket[i].avg) : -1;
+    }
+    return filled;
+}
+// Projected runtime of the recent usage pattern, -1 while unknown or charging
+int ui_battery_runtime_min(void) { return batt_forecast_runtime_min(); }
 const char * ui_battert_27220_get_percent_level(void)
 {
-    int percent = bq27220.getStateOfCharge();
+    int percent = ui_gauge_snap()->soc;
     const char * str = NULL;
     if(percent < 20)      str =  LV_SYMBOL_BATTERY_EMPTY;
     else if(percent < 40) str =  LV_SYMBOL_BATTERY_1;
@@ -359,11 +522,15 @@ int ui_other_get_LTR(int *ch0, int *ch1, int *ps)
     // if(ch1 != NULL) *ch1 = lv_rand(0, LCD_VER_SIZE);
     // if(ps  != NULL) *ps  = lv_rand(0, LCD_VER_SIZE);
 
+    if(!peri_init_ensure(E_PERI_LTR_553ALS)) return 0;
+
     if((ch0 != NULL) && (ch1 != NULL) && (ps != NULL))
     {
-        *ch0 = LTR_553ALS_get_channel(0);
-        *ch1 = LTR_553ALS_get_channel(1);
-        *ps  = LTR_553ALS_get_ps();
+        SensorLight light;
+        sensor_get_light(&light);
+        *ch0 = light.ch0;
+        *ch1 = light.ch1;
+        *ps  = light.ps;
     }
     else
     {
@@ -378,9 +545,15 @@ int ui_other_get_gyro(float *gyro_x, float *gyro_y, float *gyro_z)
     // if(gyro_y != NULL) *gyro_y = lv_rand(0, LCD_VER_SIZE);
     // if(gyro_z != NULL) *gyro_z = lv_rand(0, LCD_VER_SIZE);
 
-    if((gyro_x != NULL) && (gyro_x != NULL) && (gyro_x != NULL))
+    if(!peri_init_ensure(E_PERI_BHI260AP)) return 0;
+
+    if((gyro_x != NULL) && (gyro_y != NULL) && (gyro_z != NULL))
     {
-        BHI260AP_get_val(2, gyro_x, gyro_y, gyro_z);
+        SensorMotion motion;
+        sensor_get_motion(&motion);
+        *gyro_x = motion.gyro[0];
+        *gyro_y = motion.gyro[1];
+        *gyro_z = motion.gyro[2];
     }
     else
     {
@@ -390,15 +563,43 @@ int ui_other_get_gyro(float *gyro_x, float *gyro_y, float *gyro_z)
 }
 
 //************************************[ screen 8 ]****************************************** A7682E
-bool ui_a7682_at_cb(const char *at_cmd)
+#define A7682_CONSOLE_BYTES 2048
+
+static StreamBufferHandle_t a7682_console = NULL;
+
+static bool ui_a7682_ready(void)
 {
-    printf("[A7682E] at cmd: %s\n", at_cmd);
+    return peri_init_ensure(E_PERI_A7682E) && modem_at_begin();
+}
 
-    modem.sendAT("+CTTSPARAM=1,3,0,1,1");
+// Modem task: never blocks, a full console drops the line
+static void ui_a7682_tap(const char *line, bool tx, void *ctx)
+{
+    char buf[MODEM_AT_CMD_MAX + 4];
+    int n = snprintf(buf, sizeof(buf), "%c %s\n", tx ? '>' : '<', line);
+    if(n >= (int)sizeof(buf)) {
+        n = sizeof(buf) - 1;
+        buf[n - 1] = '\n';
+    }
+    if(xStreamBufferSpacesAvailable(a7682_console) >= (size_t)n) {
+        xStreamBufferSend(a7682_console, buf, n, 0);
+    }
+}
 
-    delay(100);
+int ui_a7682_console_read(char *buf, int len)
+{
+    if(a7682_console == NULL || len <= 0) return 0;
+    return xStreamBufferReceive(a7682_console, buf, len, 0);
+}
+
+bool ui_a7682_at_cb(const char *at_cmd)
+{
+    LOG_DEBUGF("A7682E", "AT command %s", at_cmd);
+    if(!ui_a7682_ready()) return false;
 
-    modem.sendAT("+CTTS=2,\"1234567890\"");
+    // Queued back to back, the modem task sends the second after the first's OK
+    modem_at_send("+CTTSPARAM=1,3,0,1,1");
+    modem_at_send("+CTTS=2,\"1234567890\"");
 
     return false;
 }
@@ -407,26 +608,36 @@ void ui_a7682_call(const char *number)
 {
     char buf[32];
     lv_snprintf(buf, 32, "D%s;", number);
-    printf("[A7682E] at cmd: %s\n", buf);
+    LOG_DEBUGF("A7682E", "AT command %s", buf);
+    if(!ui_a7682_ready()) return;
 
-    modem.sendAT(buf);
-    delay(100);
+    modem_at_send(buf, 10000);
 }
 
 void ui_a7682_hang_up(void)
 {
-    modem.sendAT("+CHUP");
-    delay(100);
+    if(!ui_a7682_ready()) return;
+    modem_at_send("+CHUP", 5000);
 }
 
 void ui_a7682_loop_resume(void)
 {
-    vTaskResume(a7682_handle);
+    if(!ui_a7682_ready()) return;
+    if(a7682_console == NULL) {
+        a7682_console = xStreamBufferCreate(A7682_CONSOLE_BYTES, 1);
+    }
+    if(a7682_console != NULL) {
+        xStreamBufferReset(a7682_console);
+        modem_at_set_tap(ui_a7682_tap);
+    }
+    modem_at_set_monitor(true);
 }
 
 void ui_a7682_loop_suspend(void)
 {
-    vTaskSuspend(a7682_handle);
+    if(!peri_init_st[E_PERI_A7682E]) return;
+    modem_at_set_tap(NULL);
+    modem_at_set_monitor(false);
 }
 
 //************************************[ screen 9 ]****************************************** Input
@@ -440,13 +651,14 @@ void ui_shutdown_on(void)
 //************************************[ screen 10 ]****************************************** PCM5102
 bool ui_pcm5102_cb(const char *at_cmd)
 {
-    audio.connecttoFS(SPIFFS, "/iphone_call.mp3");
-    return true;
+    if(!peri_init_ensure(E_PERI_PCM5102A)) return false;
+    return audio_service_play(SPIFFS, "/iphone_call.mp3");
 }
 
 void ui_pcm5102_stop(void)
 {
-    audio.stopSong();
+    if(!peri_init_st[E_PERI_PCM5102A]) return;
+    audio_service_stop();
 }
 
 // optional
@@ -477,3 +689,93 @@ void audio_info(const char *info){
 // void audio_lasthost(const char *info){  //stream URL played
 //     Serial.print("lasthost    ");Serial.println(info);
 // }
+
+//************************************[ screen 11 ]***************************************** search
+int ui_search(const char *query, int max, void (*cb)(const char *line), uint32_t *elapsed_ms)
+{
+    SearchHit *hits = (SearchHit *)heap_caps_malloc(max * sizeof(SearchHit), MALLOC_CAP_SPIRAM);
+    if(hits == NULL) return 0;
+    int n = text_search(query, hits, max);
+
+    char line[SEARCH_SNIPPET + MSG_STORE_PEER_MAX + 8];
+    for(int i = 0; i < n; i++) {
+        if(hits[i].source == SEARCH_SRC_MSG)
+            snprintf(line, sizeof(line), "%s%s: %s", hits[i].out ? "> " : "", hits[i].peer, hits[i].text);
+        else
+            snprintf(line, sizeof(line), "log: %s", hits[i].text);
+        cb(line);
+    }
+    free(hits);
+
+    SearchStats stats;
+    text_search_get_stats(&stats);
+    *elapsed_ms = stats.last_search_us / 1000;
+    return n;
+}
+
+//************************************[ screen 12 ]***************************************** files
+static DirIndexView files_view;
+
+int ui_files_open(const char *path, int sort, bool *building)
+{
+    if(!dir_index_open(&files_view, path, (DirIndexSort)sort)) return -1;
+    *building = files_view.stale;
+    return files_view.header.count;
+}
+
+bool ui_files_get(uint32_t index, char *line, size_t len, char *name, size_t name_len, bool *is_dir)
+{
+    DirIndexEntry e;
+    if(!dir_index_get(&files_view, index, &e)) return false;
+
+    if(e.is_dir)
+        snprintf(line, len, "%s/", e.name);
+    else if(e.size >= 1024 * 1024)
+        snprintf(line, len, "%s  %lu.%luM", e.name, (unsigned long)(e.size >> 20),
+                 (unsigned long)((e.size & 0xfffff) * 10 >> 20));
+    else if(e.size >= 1024)
+        snprintf(line, len, "%s  %luK", e.name, (unsigned long)(e.size >> 10));
+    else
+        snprintf(line, len, "%s  %lu", e.name, (unsigned long)e.size);
+    snprintf(name, name_len, "%s", e.name);
+    *is_dir = e.is_dir;
+    return true;
+}
+
+int ui_files_poll(bool *building)
+{
+    bool changed = dir_index_poll(&files_view);
+    *building = files_view.stale;
+    return changed ? (int)files_view.header.count : -1;
+}
+
+void ui_files_rebuild(void)
+{
+    if(files_view.open) dir_index_rebuild(files_view.path);
+}
+
+void ui_files_close(void)
+{
+    dir_index_close(&files_view);
+}
+
+//************************************[ screen 12.1 ]*************************************** reader
+bool ui_doc_open(const char *path, const lv_font_t *font, lv_coord_t w, lv_coord_t h)
+{
+    return doc_reader_open(path, font, w, h);
+}
+
+uint32_t ui_doc_pages(bool *done)
+{
+    return doc_reader_pages(done);
+}
+
+bool ui_doc_render(uint32_t page, uint8_t *bits)
+{
+    return doc_reader_render(page, bits);
+}
+
+void ui_doc_close(void)
+{
+    doc_reader_close();
+}
@@ -45,9 +45,32 @@ float ui_lora_get_freq(void);
 int ui_lora_get_mode(void);
 void ui_lora_set_mode(int mode);
 void ui_lora_send(const char *str);
-void ui_lora_recv_loop(void);
 bool ui_lora_get_recv(const char **str, int *rssi);
 void ui_lora_set_recv_flag(void);
+void ui_lora_get_stats(char *buf, size_t len);
+// Completions of a partly typed word, best first; returns how many
+int ui_lora_predict(const char *word, char (*out)[UI_PREDICT_WORD_LEN], int max);
+// Stored LoRa text messages, oldest first; returns how many were passed to cb
+int ui_lora_history(int max, void (*cb)(const char *text, int rssi, bool sent));
+
+// [ screen 11 ] --- search
+// Hits of every word in query, newest first, one display line each
+int ui_search(const char *query, int max, void (*cb)(const char *line), uint32_t *elapsed_ms);
+
+// [ screen 12 ] --- files
+// Directory listing from its index; the count, -1 without a card. building
+// is set while a rebuild is on its way and the listing may be behind
+int ui_files_open(const char *path, int sort, bool *building);
+bool ui_files_get(uint32_t index, char *line, size_t len, char *name, size_t name_len, bool *is_dir);
+// The new count once a rebuild landed, else -1
+int ui_files_poll(bool *building);
+void ui_files_rebuild(void);
+void ui_files_close(void);
+// Files - > Reader; a .txt or .md file, paginated for the grid of font in w x h
+bool ui_doc_open(const char *path, const lv_font_t *font, lv_coord_t w, lv_coord_t h);
+uint32_t ui_doc_pages(bool *done);
+bool ui_doc_render(uint32_t page, uint8_t *bits);
+void ui_doc_close(void);
 
 // [ screen 2 ] --- setting
 void ui_setting_set_language(int language);
@@ -69,7 +92,12 @@ bool ui_setting_get_a7682_status(void);
 // setting - > About System
 const char *ui_setting_get_sf_ver(void);
 const char *ui_setting_get_hd_ver(void);
-void ui_setting_get_sd_capacity(uint64_t *total, uint64_t *used);
+bool ui_setting_get_sd_capacity(uint64_t *total, uint64_t *used);
+
+// setting - > CPU Profile; count takes a snapshot, 0 while the profiler is off
+int ui_cpu_prof_task_count(void);
+bool ui_cpu_prof_task_get(int idx, const char **name, float *core0, float *core1);
+bool ui_cpu_prof_pc_get(int idx, uint32_t *pc, float *percent);
 
 // [ screen 3 ] --- GPS
 void ui_gps_task_suspend(void);
@@ -79,9 +107,14 @@ void ui_gps_get_data(uint16_t *year, uint8_t *month, uint8_t *day);
 void ui_gps_get_time(uint8_t *hour, uint8_t *minute, uint8_t *second);
 void ui_gps_get_satellites(uint32_t *vsat);
 void ui_gps_get_speed(double *speed);
+bool ui_gps_get_track(uint32_t *points, uint32_t *bytes);
+// GPS - > Map; open fails without a map pack on SD
+bool ui_map_open(uint8_t *zoom_min, uint8_t *zoom_max, double *lat, double *lng);
+const uint8_t *ui_map_get_tile(uint8_t z, uint32_t x, uint32_t y, bool render);
 
 // [ screen 4 ] --- Wifi Scan
-void ui_wifi_get_scan_info(ui_wifi_scan_info_t *list, int list_len);
+// -1 while the cached scan is still the one *version names
+int ui_wifi_get_scan_info(ui_wifi_scan_info_t *list, int list_len, uint32_t *version);
 
 // [ screen 5 ] --- State
 bool ui_test_get(int peri_id);
@@ -116,6 +149,10 @@ uint16_t ui_battery_27220_get_design_capacity(void);
 uint16_t ui_battery_27220_get_remain_capacity(void);
 uint16_t ui_battery_27220_get_percent(void);
 uint16_t ui_battery_27220_get_health(void);
+int ui_battery_energy_count(void);
+bool ui_battery_energy_get(int idx, const char **name, float *mah, float *ma);
+int ui_battery_history(int16_t *pct, int count, uint32_t span_s);
+int ui_battery_runtime_min(void);
 const char * ui_battert_27220_get_percent_level(void);
 
 // [ screen 7 ] --- Input
@@ -131,6 +168,7 @@ void ui_a7682_call(const char *number);
 void ui_a7682_hang_up(void);
 void ui_a7682_loop_resume(void);
 void ui_a7682_loop_suspend(void);
+int ui_a7682_console_read(char *buf, int len);    // Modem traffic since the last read, while resumed
 
 // shutdown
 void ui_shutdown_on(void);
@@ -0,0 +1,133 @@
+
+#include "ui_label.h"
+#include <string.h>
+#include <stdarg.h>
+
+typedef struct {
+    lv_obj_t *label;                        /* NULL when free */
+    char text[UI_LABEL_TEXT_MAX];
+} ui_label_slot_t;
+
+static ui_label_slot_t slots[UI_LABEL_SLOTS];
+static ui_font_metrics_t fonts[UI_LABEL_FONTS];
+
+/*********************************************************************************
+ *                              STATIC FUNCTION
+ *********************************************************************************/
+static void ui_label_delete_cb(lv_event_t *e)
+{
+    ui_label_slot_t *slot = (ui_label_slot_t *)lv_event_get_user_data(e);
+    slot->label = NULL;
+}
+
+// Open addressing on the object pointer; the table is small and lives for the whole run
+static ui_label_slot_t *ui_label_slot(lv_obj_t *label, bool take)
+{
+    uint32_t start = ((uintptr_t)label >> 3) % UI_LABEL_SLOTS;
+    ui_label_slot_t *free_slot = NULL;
+
+    for(uint32_t i = 0; i < UI_LABEL_SLOTS; i++){
+        ui_label_slot_t *slot = &slots[(start + i) % UI_LABEL_SLOTS];
+        if(slot->label == label)
+            return slot;
+        if(slot->label == NULL && free_slot == NULL)
+            free_slot = slot;
+    }
+    if(!take || free_slot == NULL)
+        return NULL;
+
+    free_slot->label = label;
+    free_slot->text[0] = '\0';
+    lv_obj_add_event_cb(label, ui_label_delete_cb, LV_EVENT_DELETE, free_slot);
+    return free_slot;
+}
+
+/*********************************************************************************
+ *                              GLOBAL FUNCTION
+ *********************************************************************************/
+void ui_label_set_text(lv_obj_t *label, const char *text)
+{
+    // Against what is shown, so a plain lv_label_set_text elsewhere is no problem
+    if(strcmp(lv_label_get_text(label), text) == 0)
+        return;
+
+    size_t len = strlen(text);
+    ui_label_slot_t *slot = (len < UI_LABEL_TEXT_MAX) ? ui_label_slot(label, true) : NULL;
+    if(slot == NULL){
+        lv_label_set_text(label, text);
+        return;
+    }
+    memcpy(slot->text, text, len + 1);
+    lv_label_set_text_static(label, slot->text);
+}
+
+void ui_label_set_fmt(lv_obj_t *label, const char *fmt, ...)
+{
+    char text[UI_LABEL_FMT_MAX];
+    va_list args;
+    va_start(args, fmt);
+    lv_vsnprintf(text, sizeof(text), fmt, args);
+    va_end(args);
+    ui_label_set_text(label, text);
+}
+
+char *ui_label_pad(char *buf, size_t len, int cols, const char *left, const char *right)
+{
+    size_t l = strlen(left);
+    size_t r = strlen(right);
+    size_t width = (cols > 0) ? (size_t)cols : 0;
+
+    if(len == 0)
+        return buf;
+    if(width > len - 1)
+        width = len - 1;
+    if(l + r > width)
+        width = (l + r < len - 1) ? l + r : len - 1;
+
+    // A right part that does not fit wins over the left one
+    if(r > width)
+        r = width;
+    if(l > width - r)
+        l = width - r;
+
+    memcpy(buf, left, l);
+    memset(buf + l, ' ', width - l - r);
+    memcpy(buf + width - r, right, r);
+    buf[width] = '\0';
+    return buf;
+}
+
+void ui_label_set_pair(lv_obj_t *label, int cols, const char *left, const char *right)
+{
+    char text[UI_LABEL_TEXT_MAX];
+    int fit = ui_label_columns(label);
+    if(fit > 0 && (cols <= 0 || fit < cols))
+        cols = fit;
+    ui_label_set_text(label, ui_label_pad(text, sizeof(text), cols, left, right));
+}
+
+const ui_font_metrics_t *ui_font_metrics(const lv_font_t *font)
+{
+    uint32_t i;
+    for(i = 0; i < UI_LABEL_FONTS && fonts[i].font != NULL; i++){
+        if(fonts[i].font == font)
+            return &fonts[i];
+    }
+
+    // Full: the last entry is measured again for every other font
+    if(i == UI_LABEL_FONTS)
+        i = UI_LABEL_FONTS - 1;
+    fonts[i].font = font;
+    fonts[i].advance = lv_font_get_glyph_width(font, '0', '0');
+    fonts[i].line_h = lv_font_get_line_height(font);
+    return &fonts[i];
+}
+
+int ui_label_columns(lv_obj_t *label)
+{
+    const ui_font_metrics_t *m = ui_font_metrics(lv_obj_get_style_text_font(label, LV_PART_MAIN));
+    lv_coord_t w = lv_obj_get_content_width(label);
+    if(m->advance <= 0 || w <= 0)
+        return 0;
+    return w / m->advance;
+}
@@ -0,0 +1,52 @@
+#ifndef __UI_LABEL_H__
+#define __UI_LABEL_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "lvgl.h"
+
+/*
+ * Label binding for screens that refresh readings on a timer. Text is
+ * formatted on the stack and compared with what the label shows; the same
+ * text is dropped before LVGL sees it, so a steady reading costs no
+ * invalidation, relayout or panel refresh. Changed text goes into a fixed
+ * per-label buffer shown with lv_label_set_text_static, so no heap either.
+ * A slot is taken on first use and given back when the label is deleted;
+ * longer text or a full table falls back to lv_label_set_text.
+ *
+ * Column counts for padded "name    value" lines come from per-font
+ * metrics, measured once per font: the Mono fonts have one advance for
+ * every glyph, so a line's width is its length times that.
+ */
+#define UI_LABEL_SLOTS      48   /* Bound labels at once */
+#define UI_LABEL_TEXT_MAX   48   /* Per-label buffer, including the terminator */
+#define UI_LABEL_FMT_MAX    160  /* Longest formatted text */
+#define UI_LABEL_FONTS      8    /* Fonts with cached metrics */
+
+typedef struct {
+    const lv_font_t *font;
+    lv_coord_t advance;          /* Width of '0'; every glyph in a Mono font */
+    lv_coord_t line_h;
+} ui_font_metrics_t;
+
+/*********************************************************************************
+ *                              GLOBAL PROTOTYPES
+ * *******************************************************************************/
+void ui_label_set_text(lv_obj_t *label, const char *text);
+void ui_label_set_fmt(lv_obj_t *label, const char *fmt, ...) LV_FORMAT_ATTRIBUTE(2, 3);
+
+// left, then right flush with column cols, or the label's width if narrower (cols 0: the width)
+void ui_label_set_pair(lv_obj_t *label, int cols, const char *left, const char *right);
+// The same line into buf, for labels built from several; returns buf
+char *ui_label_pad(char *buf, size_t len, int cols, const char *left, const char *right);
+
+const ui_font_metrics_t *ui_font_metrics(const lv_font_t *font);
+int ui_label_columns(lv_obj_t *label);  /* 0 before the first layout */
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*__UI_LABEL_H__*/
@@ -0,0 +1,265 @@
+
+#include "ui_launcher.h"
+
+typedef struct ui_launcher {
+    lv_area_t cell[UI_LAUNCHER_CELL_MAX];   /* Relative to the object, from the last layout */
+    uint8_t cols;
+    uint8_t rows;                           /* Asked for */
+    uint8_t cells;                          /* That fit, per page */
+    lv_coord_t icon_size;
+    uint32_t count;
+    uint32_t page;
+    int8_t pressed;                         /* Cell drawn pressed, -1 when none */
+    int8_t hit;                             /* Cell the press started in */
+    ui_launcher_item_cb_t item;
+    ui_launcher_open_cb_t open;
+    void *user_data;
+} ui_launcher_t;
+
+/*********************************************************************************
+ *                              STATIC FUNCTION
+ *********************************************************************************/
+static ui_launcher_t *ui_launcher_get(lv_obj_t *grid)
+{
+    return (grid != NULL) ? (ui_launcher_t *)lv_obj_get_user_data(grid) : NULL;
+}
+
+static uint32_t ui_launcher_pages(ui_launcher_t *lc)
+{
+    return (lc->count > 0 && lc->cells > 0) ? (lc->count + lc->cells - 1) / lc->cells : 1;
+}
+
+static void ui_launcher_layout(lv_obj_t *grid) // 格子位置只在尺寸变化时计算
+{
+    ui_launcher_t *lc = ui_launcher_get(grid);
+    const lv_font_t *font = lv_obj_get_style_text_font(grid, LV_PART_MAIN);
+    lv_coord_t left = lv_obj_get_style_pad_left(grid, LV_PART_MAIN);
+    lv_coord_t top = lv_obj_get_style_pad_top(grid, LV_PART_MAIN);
+    lv_coord_t w = lv_obj_get_content_width(grid);
+    lv_coord_t h = lv_obj_get_content_height(grid);
+    lv_coord_t cell_h = lc->icon_size + UI_LAUNCHER_LABEL_GAP + lv_font_get_line_height(font);
+
+    uint8_t rows = (cell_h > 0 && h > 0) ? (uint8_t)LV_MIN(lc->rows, h / cell_h) : 0;
+    if(rows == 0)
+        rows = 1;
+    lc->cells = LV_MIN(lc->cols * rows, UI_LAUNCHER_CELL_MAX);
+
+    // Spare height goes between the rows, spare width is split by the columns
+    lv_coord_t pitch_x = w / lc->cols;
+    lv_coord_t pitch_y = (rows > 1) ? (h - cell_h) / (rows - 1) : 0;
+    for(uint8_t i = 0; i < lc->cells; i++){
+        lv_area_t *a = &lc->cell[i];
+        a->x1 = left + (i % lc->cols) * pitch_x;
+        a->y1 = top + (i / lc->cols) * pitch_y;
+        a->x2 = a->x1 + pitch_x - 1;
+        a->y2 = a->y1 + cell_h - 1;
+    }
+
+    if(lc->page >= ui_launcher_pages(lc))
+        lc->page = 0;
+}
+
+static void ui_launcher_cell_area(lv_obj_t *grid, uint8_t cell, lv_area_t *area)
+{
+    ui_launcher_t *lc = ui_launcher_get(grid);
+    *area = lc->cell[cell];
+    lv_area_move(area, grid->coords.x1, grid->coords.y1);
+}
+
+static int8_t ui_launcher_hit_test(lv_obj_t *grid)
+{
+    ui_launcher_t *lc = ui_launcher_get(grid);
+    lv_indev_t *indev = lv_indev_get_act();
+    lv_point_t p;
+    if(indev == NULL || lv_indev_get_type(indev) != LV_INDEV_TYPE_POINTER)
+        return -1;
+
+    lv_indev_get_point(indev, &p);
+    p.x -= grid->coords.x1;
+    p.y -= grid->coords.y1;
+    uint32_t first = lc->page * lc->cells;
+    for(uint8_t i = 0; i < lc->cells && first + i < lc->count; i++){
+        if(_lv_area_is_point_on(&lc->cell[i], &p, 0))
+            return (int8_t)i;
+    }
+    return -1;
+}
+
+static void ui_launcher_set_pressed(lv_obj_t *grid, int8_t cell)
+{
+    ui_launcher_t *lc = ui_launcher_get(grid);
+    lv_area_t area;
+    if(lc->pressed == cell)
+        return;
+
+    // Only the cells whose frame changes are redrawn
+    if(lc->pressed >= 0){
+        ui_launcher_cell_area(grid, lc->pressed, &area);
+        lv_obj_invalidate_area(grid, &area);
+    }
+    lc->pressed = cell;
+    if(cell >= 0){
+        ui_launcher_cell_area(grid, cell, &area);
+        lv_obj_invalidate_area(grid, &area);
+    }
+}
+
+static void ui_launcher_draw(lv_obj_t *grid, lv_draw_ctx_t *draw_ctx)
+{
+    ui_launcher_t *lc = ui_launcher_get(grid);
+    lv_draw_img_dsc_t img_dsc;
+    lv_draw_label_dsc_t label_dsc;
+    lv_draw_rect_dsc_t frame_dsc;
+
+    lv_draw_img_dsc_init(&img_dsc);
+    lv_draw_label_dsc_init(&label_dsc);
+    lv_obj_init_draw_label_dsc(grid, LV_PART_MAIN, &label_dsc);
+    label_dsc.align = LV_TEXT_ALIGN_CENTER;
+    label_dsc.flag |= LV_TEXT_FLAG_EXPAND;     // Clip a long name instead of wrapping it out of sight
+    lv_draw_rect_dsc_init(&frame_dsc);
+    frame_dsc.bg_opa = LV_OPA_TRANSP;
+    frame_dsc.border_width = 2;
+    frame_dsc.border_color = lv_obj_get_style_text_color(grid, LV_PART_MAIN);
+    frame_dsc.radius = 5;
+
+    uint32_t first = lc->page * lc->cells;
+    for(uint8_t i = 0; i < lc->cells && first + i < lc->count; i++){
+        lv_area_t cell;
+        ui_launcher_cell_area(grid, i, &cell);
+        if(!_lv_area_is_on(&cell, draw_ctx->clip_area))
+            continue;
+
+        const char *name = "";
+        const lv_img_dsc_t *icon = NULL;
+        lc->item(first + i, &name, &icon, lc->user_data);
+
+        if(icon != NULL){
+            lv_area_t a;
+            a.x1 = cell.x1 + (lv_area_get_width(&cell) - icon->header.w) / 2;
+            a.y1 = cell.y1;
+            a.x2 = a.x1 + icon->header.w - 1;
+            a.y2 = a.y1 + icon->header.h - 1;
+            lv_draw_img(draw_ctx, &img_dsc, &a, icon);
+        }
+
+        lv_area_t label = cell;
+        label.y1 = cell.y1 + lc->icon_size + UI_LAUNCHER_LABEL_GAP;
+        lv_draw_label(draw_ctx, &label_dsc, &label, name, NULL);
+
+        if(i == lc->pressed)
+            lv_draw_rect(draw_ctx, &frame_dsc, &cell);
+    }
+}
+
+static void ui_launcher_event_cb(lv_event_t *e)
+{
+    lv_obj_t *grid = lv_event_get_target(e);
+    ui_launcher_t *lc = ui_launcher_get(grid);
+    if(lc == NULL)
+        return;
+
+    switch(e->code){
+    case LV_EVENT_DRAW_MAIN:
+        ui_launcher_draw(grid, lv_event_get_draw_ctx(e));
+        break;
+    case LV_EVENT_SIZE_CHANGED:
+    case LV_EVENT_STYLE_CHANGED:
+        ui_launcher_layout(grid);
+        break;
+    case LV_EVENT_PRESSED:
+        lc->hit = ui_launcher_hit_test(grid);
+        ui_launcher_set_pressed(grid, lc->hit);
+        break;
+    case LV_EVENT_RELEASED:
+    case LV_EVENT_PRESS_LOST:
+        ui_launcher_set_pressed(grid, -1);
+        if(e->code == LV_EVENT_PRESS_LOST)
+            lc->hit = -1;
+        break;
+    case LV_EVENT_CLICKED:
+        // A swipe that started on one cell and ended on another is not a tap
+        if(lc->hit >= 0 && ui_launcher_hit_test(grid) == lc->hit && lc->open != NULL)
+            lc->open(lc->page * lc->cells + lc->hit, lc->user_data);
+        lc->hit = -1;
+        break;
+    case LV_EVENT_DELETE:
+        lv_mem_free(lc);
+        lv_obj_set_user_data(grid, NULL);
+        break;
+    default:
+        break;
+    }
+}
+
+/*********************************************************************************
+ *                              GLOBAL FUNCTION
+ *********************************************************************************/
+lv_obj_t *ui_launcher_create(lv_obj_t *parent, uint8_t cols, uint8_t rows, lv_coord_t icon_size,
+                             ui_launcher_item_cb_t item, ui_launcher_open_cb_t open, void *user_data)
+{
+    ui_launcher_t *lc = lv_mem_alloc(sizeof(ui_launcher_t));
+    if(lc == NULL)
+        return NULL;
+    lv_memset_00(lc, sizeof(ui_launcher_t));
+
+    lc->cols = (cols > 0) ? LV_MIN(cols, UI_LAUNCHER_CELL_MAX) : 1;
+    lc->rows = (rows > 0) ? LV_MIN(rows, UI_LAUNCHER_CELL_MAX / lc->cols) : 1;
+    lc->icon_size = icon_size;
+    lc->pressed = -1;
+    lc->hit = -1;
+    lc->item = item;
+    lc->open = open;
+    lc->user_data = user_data;
+
+    lv_obj_t *grid = lv_obj_create(parent);
+    lv_obj_set_scrollbar_mode(grid, LV_SCROLLBAR_MODE_OFF);
+    lv_obj_clear_flag(grid, LV_OBJ_FLAG_SCROLLABLE);
+    lv_obj_add_flag(grid, LV_OBJ_FLAG_CLICKABLE);
+    lv_obj_set_user_data(grid, lc);
+
+    // The cells are laid out once the layout gives the grid its size
+    lv_obj_add_event_cb(grid, ui_launcher_event_cb, LV_EVENT_ALL, NULL);
+    return grid;
+}
+
+void ui_launcher_set_count(lv_obj_t *grid, uint32_t count)
+{
+    ui_launcher_t *lc = ui_launcher_get(grid);
+    if(lc == NULL)
+        return;
+
+    lc->count = count;
+    lc->page = 0;
+    lc->pressed = -1;
+    lc->hit = -1;
+    lv_obj_invalidate(grid);
+}
+
+void ui_launcher_page(lv_obj_t *grid, int dir)
+{
+    ui_launcher_t *lc = ui_launcher_get(grid);
+    if(lc == NULL)
+        return;
+
+    uint32_t pages = ui_launcher_pages(lc);
+    if(pages <= 1 || dir == 0)
+        return;
+    if(dir > 0)
+        lc->page = (lc->page + 1 < pages) ? lc->page + 1 : 0;
+    else
+        lc->page = (lc->page > 0) ? lc->page - 1 : pages - 1;
+
+    lc->pressed = -1;
+    lc->hit = -1;
+    lv_obj_invalidate(grid);
+}
+
+void ui_launcher_get_page(lv_obj_t *grid, uint32_t *page, uint32_t *pages)
+{
+    ui_launcher_t *lc = ui_launcher_get(grid);
+
+    if(page != NULL)
+        *page = (lc != NULL) ? lc->page : 0;
+    if(pages != NULL)
+        *pages = (lc != NULL) ? ui_launcher_pages(lc) : 1;
+}
@@ -0,0 +1,38 @@
+#ifndef __UI_LAUNCHER_H__
+#define __UI_LAUNCHER_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "lvgl.h"
+
+/*
+ * Paged grid of icons with their names, drawn by one object. The cell
+ * rectangles are worked out once per size, a page is drawn with one image
+ * blit and one label per cell, and turning a page or changing the items
+ * invalidates the object once, so the panel gets one partial refresh.
+ * A press only redraws the cell under it.
+ */
+#define UI_LAUNCHER_CELL_MAX    16   /* cols * rows */
+#define UI_LAUNCHER_LABEL_GAP   2    /* Between an icon and its name */
+
+// name and icon must stay valid until the items change
+typedef void (*ui_launcher_item_cb_t)(uint32_t index, const char **name, const lv_img_dsc_t **icon, void *user_data);
+typedef void (*ui_launcher_open_cb_t)(uint32_t index, void *user_data);
+
+/*********************************************************************************
+ *                              GLOBAL PROTOTYPES
+ * *******************************************************************************/
+// Fewer rows are used if cols x rows cells of icon_size do not fit the object
+lv_obj_t *ui_launcher_create(lv_obj_t *parent, uint8_t cols, uint8_t rows, lv_coord_t icon_size,
+                             ui_launcher_item_cb_t item, ui_launcher_open_cb_t open, void *user_data);
+void ui_launcher_set_count(lv_obj_t *grid, uint32_t count);   // back to the first page
+void ui_launcher_page(lv_obj_t *grid, int dir);               // dir > 0 next page, < 0 previous, wraps
+void ui_launcher_get_page(lv_obj_t *grid, uint32_t *page, uint32_t *pages);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*__UI_LAUNCHER_H__*/
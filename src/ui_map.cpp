@@ -0,0 +1,374 @@
+
+#include "ui_map.h"
+#include "lvgl_draw_1bpp.h"
+#include <math.h>
+
+#define UI_MAP_VISIBLE_MAX  32  /* Tiles in view, partly shown ones included */
+
+typedef struct ui_map {
+    ui_map_tile_cb tile_cb;
+    lv_timer_t *fill_timer;
+    uint8_t zoom;
+    uint8_t zoom_min;
+    uint8_t zoom_max;
+    double cx;                              /* Centre, web mercator 0..1 */
+    double cy;
+    double mx;                              /* Marker */
+    double my;
+    bool marker;
+    bool follow;                            /* Keep the marker in view */
+    lv_point_t press;
+} ui_map_t;
+
+/*********************************************************************************
+ *                              STATIC FUNCTION
+ *********************************************************************************/
+static ui_map_t *ui_map_get(lv_obj_t *map)
+{
+    return (map != NULL) ? (ui_map_t *)lv_obj_get_user_data(map) : NULL;
+}
+
+static void ui_map_project(double lat, double lng, double *x, double *y)
+{
+    lat = LV_CLAMP(-85.0511, lat, 85.0511);
+    double s = sin(lat * M_PI / 180.0);
+    *x = (lng + 180.0) / 360.0;
+    *y = 0.5 - log((1.0 + s) / (1.0 - s)) / (4.0 * M_PI);
+}
+
+static int32_t ui_map_world(const ui_map_t *m)
+{
+    return (int32_t)UI_MAP_TILE_PX << m->zoom;
+}
+
+// World pixel at the content's top left corner
+static void ui_map_origin(lv_obj_t *obj, int32_t *ox, int32_t *oy)
+{
+    ui_map_t *m = ui_map_get(obj);
+    int32_t world = ui_map_world(m);
+    *ox = (int32_t)lround(m->cx * world) - lv_obj_get_content_width(obj) / 2;
+    *oy = (int32_t)lround(m->cy * world) - lv_obj_get_content_height(obj) / 2;
+}
+
+static int32_t ui_map_floor_div(int32_t a, int32_t b)
+{
+    return (a >= 0) ? a / b : -((-a + b - 1) / b);
+}
+
+typedef struct {
+    int32_t tx;
+    int32_t ty;
+    uint32_t dist;
+} ui_map_slot_t;
+
+// Tiles in view, nearest the centre first; rows off the world are left out
+static uint8_t ui_map_visible(lv_obj_t *obj, ui_map_slot_t *out)
+{
+    ui_map_t *m = ui_map_get(obj);
+    int32_t ox, oy;
+    ui_map_origin(obj, &ox, &oy);
+    lv_coord_t w = lv_obj_get_content_width(obj);
+    lv_coord_t h = lv_obj_get_content_height(obj);
+    int32_t tiles = 1L << m->zoom;
+    int32_t mid_x = ox + w / 2 - UI_MAP_TILE_PX / 2;
+    int32_t mid_y = oy + h / 2 - UI_MAP_TILE_PX / 2;
+
+    uint8_t n = 0;
+    for(int32_t ty = ui_map_floor_div(oy, UI_MAP_TILE_PX); ty * UI_MAP_TILE_PX < oy + h; ty++){
+        for(int32_t tx = ui_map_floor_div(ox, UI_MAP_TILE_PX); tx * UI_MAP_TILE_PX < ox + w; tx++){
+            if(ty < 0 || ty >= tiles || n >= UI_MAP_VISIBLE_MAX)
+                continue;
+            uint32_t dist = LV_ABS(tx * UI_MAP_TILE_PX - mid_x) + LV_ABS(ty * UI_MAP_TILE_PX - mid_y);
+            uint8_t k = n++;
+            for(; k > 0 && out[k - 1].dist > dist; k--)
+                out[k] = out[k - 1];
+            out[k].tx = tx;
+            out[k].ty = ty;
+            out[k].dist = dist;
+        }
+    }
+    return n;
+}
+
+static void ui_map_tile_area(lv_obj_t *obj, const ui_map_slot_t *s, lv_area_t *area)
+{
+    int32_t ox, oy;
+    lv_area_t content;
+    ui_map_origin(obj, &ox, &oy);
+    lv_obj_get_content_coords(obj, &content);
+    area->x1 = content.x1 + s->tx * UI_MAP_TILE_PX - ox;
+    area->y1 = content.y1 + s->ty * UI_MAP_TILE_PX - oy;
+    area->x2 = area->x1 + UI_MAP_TILE_PX - 1;
+    area->y2 = area->y1 + UI_MAP_TILE_PX - 1;
+}
+
+static const uint8_t *ui_map_tile(ui_map_t *m, const ui_map_slot_t *s, bool render)
+{
+    int32_t tiles = 1L << m->zoom;
+    uint32_t x = (uint32_t)(((s->tx % tiles) + tiles) % tiles);    /* Wraps east-west */
+    return m->tile_cb(m->zoom, x, (uint32_t)s->ty, render);
+}
+
+static bool ui_map_marker_area(lv_obj_t *obj, lv_area_t *area)
+{
+    ui_map_t *m = ui_map_get(obj);
+    if(!m->marker)
+        return false;
+    int32_t ox, oy;
+    lv_area_t content;
+    int32_t world = ui_map_world(m);
+    ui_map_origin(obj, &ox, &oy);
+    lv_obj_get_content_coords(obj, &content);
+    lv_coord_t x = content.x1 + (int32_t)lround(m->mx * world) - ox;
+    lv_coord_t y = content.y1 + (int32_t)lround(m->my * world) - oy;
+    area->x1 = x - UI_MAP_MARKER_R;
+    area->y1 = y - UI_MAP_MARKER_R;
+    area->x2 = x + UI_MAP_MARKER_R;
+    area->y2 = y + UI_MAP_MARKER_R;
+    return true;
+}
+
+static void ui_map_changed(lv_obj_t *obj)
+{
+    ui_map_t *m = ui_map_get(obj);
+    lv_obj_invalidate(obj);
+    lv_timer_resume(m->fill_timer);
+}
+
+static void ui_map_fill(lv_timer_t *timer)
+{
+    lv_obj_t *obj = (lv_obj_t *)timer->user_data;
+    ui_map_t *m = ui_map_get(obj);
+    ui_map_slot_t slots[UI_MAP_VISIBLE_MAX];
+    uint8_t n = ui_map_visible(obj, slots);
+
+    for(uint8_t i = 0; i < n; i++){
+        if(ui_map_tile(m, &slots[i], false) != NULL)
+            continue;
+        lv_area_t area;
+        if(ui_map_tile(m, &slots[i], true) == NULL)
+            break;      /* Nothing to render from */
+        ui_map_tile_area(obj, &slots[i], &area);
+        lv_obj_invalidate_area(obj, &area);
+        return;
+    }
+    lv_timer_pause(timer);
+}
+
+static void ui_map_draw(lv_event_t *e)
+{
+    lv_obj_t *obj = lv_event_get_target(e);
+    ui_map_t *m = ui_map_get(obj);
+    lv_draw_ctx_t *draw_ctx = lv_event_get_draw_ctx(e);
+    ui_map_slot_t slots[UI_MAP_VISIBLE_MAX];
+    uint8_t n = ui_map_visible(obj, slots);
+
+    lv_area_t content;
+    lv_obj_get_content_coords(obj, &content);
+    const lv_area_t *clip_prev = draw_ctx->clip_area;
+    lv_area_t clip;
+    if(!_lv_area_intersect(&clip, clip_prev, &content))
+        return;
+    draw_ctx->clip_area = &clip;
+
+    lv_draw_img_dsc_t img_dsc;
+    lv_draw_img_dsc_init(&img_dsc);
+    img_dsc.recolor = lv_color_black();
+
+    for(uint8_t i = 0; i < n; i++){
+        lv_area_t area, shown;
+        ui_map_tile_area(obj, &slots[i], &area);
+        if(!_lv_area_intersect(&shown, &area, &clip))
+            continue;
+        const uint8_t *bits = ui_map_tile(m, &slots[i], false);
+        if(bits == NULL){
+            lv_timer_resume(m->fill_timer);
+            continue;
+        }
+        if(lvgl_draw_1bpp_blit(draw_ctx, bits, area.x1, area.y1, UI_MAP_TILE_PX, UI_MAP_TILE_PX,
+                               lv_color_black()))
+            continue;
+        // Any other display: the same bits as a 1-bit alpha image
+        lv_img_dsc_t tile = {};
+        tile.header.cf = LV_IMG_CF_ALPHA_1BIT;
+        tile.header.w = UI_MAP_TILE_PX;
+        tile.header.h = UI_MAP_TILE_PX;
+        tile.data_size = UI_MAP_TILE_PX * UI_MAP_TILE_PX / 8;
+        tile.data = bits;
+        lv_draw_img(draw_ctx, &img_dsc, &area, &tile);
+    }
+
+    lv_area_t marker;
+    if(ui_map_marker_area(obj, &marker)){
+        lv_draw_rect_dsc_t rect_dsc;
+        lv_draw_rect_dsc_init(&rect_dsc);
+        rect_dsc.radius = LV_RADIUS_CIRCLE;
+        rect_dsc.bg_color = lv_color_black();
+        rect_dsc.border_color = lv_color_white();
+        rect_dsc.border_width = 2;
+        lv_draw_rect(draw_ctx, &rect_dsc, &marker);
+    }
+    draw_ctx->clip_area = clip_prev;
+}
+
+static void ui_map_input(lv_event_t *e)
+{
+    lv_obj_t *obj = lv_event_get_target(e);
+    ui_map_t *m = ui_map_get(obj);
+    lv_indev_t *indev = lv_indev_get_act();
+    lv_point_t p;
+    if(indev == NULL)
+        return;
+    lv_indev_get_point(indev, &p);
+
+    if(lv_event_get_code(e) == LV_EVENT_PRESSED){
+        m->press = p;
+        return;
+    }
+    lv_coord_t dx = p.x - m->press.x;
+    lv_coord_t dy = p.y - m->press.y;
+    if(LV_ABS(dx) + LV_ABS(dy) >= UI_MAP_DRAG_MIN){
+        m->follow = false;
+        ui_map_pan(obj, -dx, -dy);
+    }
+}
+
+static void ui_map_delete(lv_event_t *e)
+{
+    lv_obj_t *obj = lv_event_get_target(e);
+    ui_map_t *m = ui_map_get(obj);
+    lv_timer_del(m->fill_timer);
+    lv_mem_free(m);
+    lv_obj_set_user_data(obj, NULL);
+}
+
+/*********************************************************************************
+ *                              GLOBAL FUNCTION
+ *********************************************************************************/
+lv_obj_t *ui_map_create(lv_obj_t *parent, lv_coord_t w, lv_coord_t h, ui_map_tile_cb tile_cb)
+{
+    ui_map_t *m = (ui_map_t *)lv_mem_alloc(sizeof(ui_map_t));
+    if(m == NULL)
+        return NULL;
+    memset(m, 0, sizeof(ui_map_t));
+    m->tile_cb = tile_cb;
+    m->zoom_max = 16;
+    m->cx = 0.5;
+    m->cy = 0.5;
+    m->follow = true;
+
+    lv_obj_t *obj = lv_obj_create(parent);
+    lv_obj_remove_style_all(obj);
+    lv_obj_set_size(obj, w, h);
+    lv_obj_set_style_bg_color(obj, lv_color_white(), LV_PART_MAIN);
+    lv_obj_set_style_bg_opa(obj, LV_OPA_COVER, LV_PART_MAIN);
+    lv_obj_clear_flag(obj, LV_OBJ_FLAG_SCROLLABLE | LV_OBJ_FLAG_SCROLL_CHAIN | LV_OBJ_FLAG_GESTURE_BUBBLE);
+    lv_obj_add_flag(obj, LV_OBJ_FLAG_CLICKABLE);
+    lv_obj_set_user_data(obj, m);
+    lv_obj_add_event_cb(obj, ui_map_draw, LV_EVENT_DRAW_MAIN, NULL);
+    lv_obj_add_event_cb(obj, ui_map_input, LV_EVENT_PRESSED, NULL);
+    lv_obj_add_event_cb(obj, ui_map_input, LV_EVENT_RELEASED, NULL);
+    lv_obj_add_event_cb(obj, ui_map_delete, LV_EVENT_DELETE, NULL);
+
+    m->fill_timer = lv_timer_create(ui_map_fill, UI_MAP_FILL_MS, obj);
+    lv_timer_pause(m->fill_timer);
+    return obj;
+}
+
+void ui_map_set_zoom_range(lv_obj_t *map, uint8_t zoom_min, uint8_t zoom_max)
+{
+    ui_map_t *m = ui_map_get(map);
+    if(m == NULL)
+        return;
+    m->zoom_min = zoom_min;
+    m->zoom_max = LV_MAX(zoom_min, zoom_max);
+    m->zoom = LV_CLAMP(m->zoom_min, m->zoom, m->zoom_max);
+    ui_map_changed(map);
+}
+
+void ui_map_set_view(lv_obj_t *map, double lat, double lng, uint8_t zoom)
+{
+    ui_map_t *m = ui_map_get(map);
+    if(m == NULL)
+        return;
+    ui_map_project(lat, lng, &m->cx, &m->cy);
+    m->zoom = LV_CLAMP(m->zoom_min, zoom, m->zoom_max);
+    ui_map_changed(map);
+}
+
+void ui_map_zoom(lv_obj_t *map, int dir)
+{
+    ui_map_t *m = ui_map_get(map);
+    if(m == NULL)
+        return;
+    int zoom = LV_CLAMP(m->zoom_min, m->zoom + (dir > 0 ? 1 : -1), m->zoom_max);
+    if(dir == 0 || zoom == m->zoom)
+        return;
+    m->zoom = zoom;
+    ui_map_changed(map);
+}
+
+void ui_map_pan(lv_obj_t *map, lv_coord_t dx, lv_coord_t dy)
+{
+    ui_map_t *m = ui_map_get(map);
+    if(m == NULL || (dx == 0 && dy == 0))
+        return;
+    double world = ui_map_world(m);
+    m->cx = fmod(m->cx + dx / world + 1.0, 1.0);
+    m->cy = LV_CLAMP(0.0, m->cy + dy / world, 1.0);
+    ui_map_changed(map);
+}
+
+void ui_map_set_marker(lv_obj_t *map, double lat, double lng, bool valid)
+{
+    ui_map_t *m = ui_map_get(map);
+    lv_area_t area;
+    if(m == NULL)
+        return;
+    double mx = 0, my = 0;
+    if(valid)
+        ui_map_project(lat, lng, &mx, &my);
+    if(valid == m->marker && mx == m->mx && my == m->my)
+        return;
+
+    if(ui_map_marker_area(map, &area))
+        lv_obj_invalidate_area(map, &area);
+    m->marker = valid;
+    m->mx = mx;
+    m->my = my;
+    if(!valid)
+        return;
+
+    // Recentre only once the marker nears the edge: a move is a whole-view refresh
+    double world = ui_map_world(m);
+    double off_x = (m->mx - m->cx) * world;
+    double off_y = (m->my - m->cy) * world;
+    if(m->follow && (fabs(off_x) > lv_obj_get_content_width(map) / 4 ||
+                     fabs(off_y) > lv_obj_get_content_height(map) / 4)){
+        m->cx = m->mx;
+        m->cy = m->my;
+        ui_map_changed(map);
+        return;
+    }
+    if(ui_map_marker_area(map, &area))
+        lv_obj_invalidate_area(map, &area);
+}
+
+void ui_map_follow(lv_obj_t *map)
+{
+    ui_map_t *m = ui_map_get(map);
+    if(m == NULL)
+        return;
+    m->follow = true;
+    if(!m->marker)
+        return;
+    m->cx = m->mx;
+    m->cy = m->my;
+    ui_map_changed(map);
+}
+
+uint8_t ui_map_get_zoom(lv_obj_t *map)
+{
+    ui_map_t *m = ui_map_get(map);
+    return (m != NULL) ? m->zoom : 0;
+}
@@ -0,0 +1,47 @@
+#ifndef __UI_MAP_H__
+#define __UI_MAP_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "lvgl.h"
+
+/*
+ * Slippy map view over square 1bpp tiles of UI_MAP_TILE_PX, rows packed
+ * MSB first, 1 = ink. Tiles come from a callback, which is asked for
+ * cached tiles only while drawing; a missing tile is left white and
+ * rendered afterwards from a timer, one per tick nearest the centre
+ * first, and only its own rectangle is invalidated. Panning therefore
+ * renders just the newly exposed tiles, and each reaches the panel as a
+ * partial refresh of its own.
+ *
+ * A drag pans by the distance dragged, once it is released: e-paper
+ * cannot follow the finger. The marker (the GPS fix) keeps the view
+ * centred on it until the user pans away; ui_map_follow() goes back.
+ */
+#define UI_MAP_TILE_PX      128
+#define UI_MAP_FILL_MS      30   /* Between tile renders */
+#define UI_MAP_DRAG_MIN     8    /* Shorter drags are taps */
+#define UI_MAP_MARKER_R     6
+
+// A tile, or NULL when render is false and it is not cached yet
+typedef const uint8_t *(*ui_map_tile_cb)(uint8_t z, uint32_t x, uint32_t y, bool render);
+
+/*********************************************************************************
+ *                              GLOBAL PROTOTYPES
+ * *******************************************************************************/
+lv_obj_t *ui_map_create(lv_obj_t *parent, lv_coord_t w, lv_coord_t h, ui_map_tile_cb tile_cb);
+void ui_map_set_zoom_range(lv_obj_t *map, uint8_t zoom_min, uint8_t zoom_max);
+void ui_map_set_view(lv_obj_t *map, double lat, double lng, uint8_t zoom);
+void ui_map_zoom(lv_obj_t *map, int dir);       // dir < 0 out, > 0 in, about the centre
+void ui_map_pan(lv_obj_t *map, lv_coord_t dx, lv_coord_t dy);
+void ui_map_set_marker(lv_obj_t *map, double lat, double lng, bool valid);
+void ui_map_follow(lv_obj_t *map);              // Centre on the marker and keep it there
+uint8_t ui_map_get_zoom(lv_obj_t *map);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*__UI_MAP_H__*/
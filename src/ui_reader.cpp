@@ -0,0 +1,216 @@
+
+#include "ui_reader.h"
+#include "lvgl_draw_1bpp.h"
+#include <esp_heap_caps.h>
+
+typedef struct ui_reader {
+    ui_reader_render_cb render_cb;
+    lv_timer_t *fill_timer;
+    lv_coord_t w;
+    lv_coord_t h;
+    uint32_t pages;
+    uint32_t page;                          /* Shown */
+    uint8_t *bits[UI_READER_BUFS];          /* PSRAM */
+    uint32_t bits_page[UI_READER_BUFS];     /* UINT32_MAX for none */
+} ui_reader_t;
+
+/*********************************************************************************
+ *                              STATIC FUNCTION
+ *********************************************************************************/
+static ui_reader_t *ui_reader_get(lv_obj_t *reader)
+{
+    return (reader != NULL) ? (ui_reader_t *)lv_obj_get_user_data(reader) : NULL;
+}
+
+static int ui_reader_slot(const ui_reader_t *r, uint32_t page)
+{
+    for(int i = 0; i < UI_READER_BUFS; i++){
+        if(r->bits_page[i] == page)
+            return i;
+    }
+    return -1;
+}
+
+static bool ui_reader_wanted(const ui_reader_t *r, uint32_t page)
+{
+    return page == r->page || page == r->page + 1 || (r->page > 0 && page == r->page - 1);
+}
+
+// Into a buffer holding none of the pages around the shown one
+static bool ui_reader_render(ui_reader_t *r, uint32_t page)
+{
+    int slot = 0;
+    for(int i = 0; i < UI_READER_BUFS; i++){
+        if(r->bits_page[i] == UINT32_MAX || !ui_reader_wanted(r, r->bits_page[i])){
+            slot = i;
+            break;
+        }
+    }
+    r->bits_page[slot] = UINT32_MAX;
+    if(!r->render_cb(page, r->bits[slot]))
+        return false;
+    r->bits_page[slot] = page;
+    return true;
+}
+
+// The shown page first, then the next, then the previous; one per tick
+static void ui_reader_fill(lv_timer_t *timer)
+{
+    lv_obj_t *obj = (lv_obj_t *)timer->user_data;
+    ui_reader_t *r = ui_reader_get(obj);
+    uint32_t order[3] = { r->page, r->page + 1, r->page > 0 ? r->page - 1 : UINT32_MAX };
+
+    for(int i = 0; i < 3; i++){
+        if(order[i] >= r->pages || ui_reader_slot(r, order[i]) >= 0)
+            continue;
+        if(ui_reader_render(r, order[i]) && order[i] == r->page)
+            lv_obj_invalidate(obj);
+        return;
+    }
+    lv_timer_pause(timer);
+}
+
+static void ui_reader_draw(lv_event_t *e)
+{
+    lv_obj_t *obj = lv_event_get_target(e);
+    ui_reader_t *r = ui_reader_get(obj);
+    lv_draw_ctx_t *draw_ctx = lv_event_get_draw_ctx(e);
+    int slot = ui_reader_slot(r, r->page);
+    if(slot < 0)
+        return;
+
+    lv_area_t area;
+    lv_obj_get_content_coords(obj, &area);
+    if(lvgl_draw_1bpp_blit(draw_ctx, r->bits[slot], area.x1, area.y1, r->w, r->h, lv_color_black()))
+        return;
+    // Any other display: the same bits as a 1-bit alpha image
+    lv_draw_img_dsc_t img_dsc;
+    lv_draw_img_dsc_init(&img_dsc);
+    img_dsc.recolor = lv_color_black();
+    lv_img_dsc_t page = {};
+    page.header.cf = LV_IMG_CF_ALPHA_1BIT;
+    page.header.w = r->w;
+    page.header.h = r->h;
+    page.data_size = r->w / 8 * r->h;
+    page.data = r->bits[slot];
+    area.x2 = area.x1 + r->w - 1;
+    area.y2 = area.y1 + r->h - 1;
+    lv_draw_img(draw_ctx, &img_dsc, &area, &page);
+}
+
+static void ui_reader_input(lv_event_t *e)
+{
+    lv_obj_t *obj = lv_event_get_target(e);
+    lv_indev_t *indev = lv_indev_get_act();
+    lv_point_t p;
+    if(indev == NULL)
+        return;
+    lv_indev_get_point(indev, &p);
+    ui_reader_turn(obj, (p.x - obj->coords.x1 < lv_obj_get_width(obj) / 3) ? -1 : 1);
+}
+
+static void ui_reader_delete(lv_event_t *e)
+{
+    lv_obj_t *obj = lv_event_get_target(e);
+    ui_reader_t *r = ui_reader_get(obj);
+    lv_timer_del(r->fill_timer);
+    for(int i = 0; i < UI_READER_BUFS; i++)
+        heap_caps_free(r->bits[i]);
+    lv_mem_free(r);
+    lv_obj_set_user_data(obj, NULL);
+}
+
+/*********************************************************************************
+ *                              GLOBAL FUNCTION
+ *********************************************************************************/
+lv_obj_t *ui_reader_create(lv_obj_t *parent, lv_coord_t w, lv_coord_t h, ui_reader_render_cb render_cb)
+{
+    ui_reader_t *r = (ui_reader_t *)lv_mem_alloc(sizeof(ui_reader_t));
+    if(r == NULL)
+        return NULL;
+    memset(r, 0, sizeof(ui_reader_t));
+    r->render_cb = render_cb;
+    r->w = w & ~7;
+    r->h = h;
+    for(int i = 0; i < UI_READER_BUFS; i++){
+        size_t size = r->w / 8 * r->h;
+        r->bits[i] = (uint8_t *)heap_caps_malloc(size, MALLOC_CAP_SPIRAM);
+        if(r->bits[i] == NULL)
+            r->bits[i] = (uint8_t *)heap_caps_malloc(size, MALLOC_CAP_8BIT);
+        r->bits_page[i] = UINT32_MAX;
+        if(r->bits[i] == NULL){
+            for(int k = 0; k < i; k++)
+                heap_caps_free(r->bits[k]);
+            lv_mem_free(r);
+            return NULL;
+        }
+    }
+
+    lv_obj_t *obj = lv_obj_create(parent);
+    lv_obj_remove_style_all(obj);
+    lv_obj_set_size(obj, r->w, h);
+    lv_obj_set_style_bg_color(obj, lv_color_white(), LV_PART_MAIN);
+    lv_obj_set_style_bg_opa(obj, LV_OPA_COVER, LV_PART_MAIN);
+    lv_obj_clear_flag(obj, LV_OBJ_FLAG_SCROLLABLE | LV_OBJ_FLAG_SCROLL_CHAIN);
+    lv_obj_add_flag(obj, LV_OBJ_FLAG_CLICKABLE);
+    lv_obj_set_user_data(obj, r);
+    lv_obj_add_event_cb(obj, ui_reader_draw, LV_EVENT_DRAW_MAIN, NULL);
+    lv_obj_add_event_cb(obj, ui_reader_input, LV_EVENT_CLICKED, NULL);
+    lv_obj_add_event_cb(obj, ui_reader_delete, LV_EVENT_DELETE, NULL);
+
+    r->fill_timer = lv_timer_create(ui_reader_fill, UI_READER_PREFETCH_MS, obj);
+    lv_timer_pause(r->fill_timer);
+    return obj;
+}
+
+void ui_reader_set_pages(lv_obj_t *reader, uint32_t pages)
+{
+    ui_reader_t *r = ui_reader_get(reader);
+    if(r == NULL || pages == r->pages)
+        return;
+    r->pages = pages;
+    lv_timer_resume(r->fill_timer);
+}
+
+void ui_reader_reset(lv_obj_t *reader)
+{
+    ui_reader_t *r = ui_reader_get(reader);
+    if(r == NULL)
+        return;
+    for(int i = 0; i < UI_READER_BUFS; i++)
+        r->bits_page[i] = UINT32_MAX;
+    r->pages = 0;
+    r->page = 0;
+    lv_obj_invalidate(reader);
+}
+
+void ui_reader_goto(lv_obj_t *reader, uint32_t page)
+{
+    ui_reader_t *r = ui_reader_get(reader);
+    if(r == NULL || page >= r->pages || page == r->page)
+        return;
+    r->page = page;
+    // Only a jump past the prefetched pages renders here
+    if(ui_reader_slot(r, page) < 0)
+        ui_reader_render(r, page);
+    lv_obj_invalidate(reader);
+    lv_timer_reset(r->fill_timer);
+    lv_timer_resume(r->fill_timer);
+}
+
+void ui_reader_turn(lv_obj_t *reader, int dir)
+{
+    ui_reader_t *r = ui_reader_get(reader);
+    if(r == NULL || dir == 0)
+        return;
+    if(dir < 0)
+        ui_reader_goto(reader, (r->page > 0) ? r->page - 1 : 0);
+    else
+        ui_reader_goto(reader, r->page + 1);
+}
+
+uint32_t ui_reader_get_page(lv_obj_t *reader)
+{
+    ui_reader_t *r = ui_reader_get(reader);
+    return (r != NULL) ? r->page : 0;
+}
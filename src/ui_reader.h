@@ -0,0 +1,42 @@
+#ifndef __UI_READER_H__
+#define __UI_READER_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "lvgl.h"
+
+/*
+ * Page view for documents rendered to 1bpp, rows packed MSB first,
+ * 1 = ink. The object keeps UI_READER_BUFS page bitmaps: the page shown
+ * and, rendered from a timer once the panel is idle, the page after it
+ * and the one before. A page turn onto a rendered page is a pointer swap
+ * and one invalidate of the object, so it reaches the panel as a single
+ * partial refresh with no layout in between.
+ *
+ * A tap on the left third turns back, anywhere else forward. Pages come
+ * from a callback; the count may grow while the document is paginated.
+ */
+#define UI_READER_BUFS          3
+#define UI_READER_PREFETCH_MS   60   /* After a turn, before the next render */
+
+// Draw page into bits, (w / 8) * h bytes; false if it cannot yet
+typedef bool (*ui_reader_render_cb)(uint32_t page, uint8_t *bits);
+
+/*********************************************************************************
+ *                              GLOBAL PROTOTYPES
+ * *******************************************************************************/
+// w is rounded down to a multiple of 8
+lv_obj_t *ui_reader_create(lv_obj_t *parent, lv_coord_t w, lv_coord_t h, ui_reader_render_cb render_cb);
+void ui_reader_set_pages(lv_obj_t *reader, uint32_t pages);
+void ui_reader_reset(lv_obj_t *reader);                 // Drop the rendered pages, back to page 0
+void ui_reader_goto(lv_obj_t *reader, uint32_t page);
+void ui_reader_turn(lv_obj_t *reader, int dir);         // dir < 0 back, > 0 forward
+uint32_t ui_reader_get_page(lv_obj_t *reader);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*__UI_READER_H__*/
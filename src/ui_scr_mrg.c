@@ -1,5 +1,9 @@
 ﻿
 #include "ui_scr_mrg.h"
+#include "ui_anim_policy.h"
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+#include <string.h>
 
 /* 记录所有的屏幕卡片 */ 
 scr_card_t *scr_mgr_head;
@@ -15,11 +19,62 @@ lv_scr_load_anim_t scr_anim_push = SCR_MGR_SCR_PUSH_ANIM;
 lv_scr_load_anim_t scr_anim_pop = SCR_MGR_SCR_POP_ANIM;
 
 uint32_t default_bg_color = 0xFF0000;
+
+/* 屏幕快照缓存 */
+static const scr_snapshot_ops_t *scr_snapshot_ops = NULL;
+static bool scr_snapshot_restoring = false;
+
+/* 屏幕预加载 */
+static lv_timer_t *scr_preload_timer = NULL;
+static uint32_t scr_preload_idle_ms = SCR_MGR_PRELOAD_IDLE_MS;
+static uint32_t scr_preload_expire_ms = SCR_MGR_PRELOAD_EXPIRE_MS;
+static int scr_hint_ids[SCR_MGR_HINT_MAX];
+static int scr_hint_cnt = 0;
+
+/* 屏幕统计 */
+static uint32_t (*scr_mem_probe)(void) = NULL;
+static scr_card_t *scr_stats_front = NULL;  /* Registered card in front */
+static uint32_t scr_stats_since = 0;        /* lv_tick it came to the front */
+static int64_t scr_stats_nav_us = 0;        /* Navigation start, 0 once its first frame is out */
 /*********************************************************************************
  *                              STATIC FUNCTION
  *********************************************************************************/
+static scr_card_t *scr_mgr_find_by_id(int id);
+
+static uint16_t scr_mgr_count_objs(lv_obj_t *obj) // 统计对象树中的对象数量
+{
+    uint16_t n = 1;
+    uint32_t cnt = lv_obj_get_child_cnt(obj);
+    for(uint32_t i = 0; i < cnt; i++)
+        n += scr_mgr_count_objs(lv_obj_get_child(obj, i));
+    return n;
+}
+
+static void scr_mgr_stats_nav(void) // 记录导航开始时间，首帧时间从这里算起
+{
+    scr_stats_nav_us = esp_timer_get_time();
+}
+
+static void scr_mgr_stats_front(int id) // 屏幕来到前台
+{
+    scr_card_t *card = scr_mgr_find_by_id(id);
+    uint32_t now = lv_tick_get();
+
+    if(scr_stats_front != NULL)
+        scr_stats_front->stats.active_ms += now - scr_stats_since;
+    scr_stats_front = card;
+    scr_stats_since = now;
+    if(card != NULL)
+        card->stats.visits++;
+}
+
 static lv_obj_t *scr_mgr_default_style(scr_card_t *card)
 {
+    // Stack entries are copies; the numbers go on the registered card
+    scr_card_t *reg = scr_mgr_find_by_id(card->id);
+    uint32_t mem_before = scr_mem_probe ? scr_mem_probe() : 0;
+    int64_t start = esp_timer_get_time();
+
     lv_obj_t *obj = lv_obj_create(NULL);
     lv_obj_set_size(obj, lv_pct(100), lv_pct(100));
     lv_obj_set_style_bg_color(obj, lv_color_hex(default_bg_color), LV_PART_MAIN);
@@ -30,6 +85,15 @@ static lv_obj_t *scr_mgr_default_style(scr_card_t *card)
     // lv_obj_set_style_bg_opa(obj, LV_OPA_0, 0);
     lv_obj_clear_flag(obj, LV_OBJ_FLAG_SCROLLABLE);
     card->life->create(obj);
+
+    if(reg != NULL){
+        reg->stats.creates++;
+        reg->stats.create_us = (uint32_t)(esp_timer_get_time() - start);
+        if(reg->stats.create_us > reg->stats.create_max_us)
+            reg->stats.create_max_us = reg->stats.create_us;
+        if(scr_mem_probe)
+            reg->stats.mem_delta = (int32_t)(scr_mem_probe() - mem_before);
+    }
     return obj;
 }
 
@@ -44,6 +108,17 @@ static scr_card_t *scr_mgr_find_by_id(int id) // 检查链表中没有没此 id
     return NULL;
 }
 
+static bool scr_mgr_on_stack(int id) // 检查屏幕是否在栈中
+{
+    scr_card_t *p = scr_stack_top;
+    while(p != NULL){
+        if(id == p->id)
+            return true;
+        p = p->prev;
+    }
+    return false;
+}
+
 static scr_card_t *scr_mgr_get_top(scr_card_t *head) // 获取链表最前面的节点 
 {
     scr_card_t *p = head;
@@ -54,16 +129,62 @@ static scr_card_t *scr_mgr_get_top(scr_card_t *head) // 获取链表最前面的
     return p;
 }
 
+static void scr_mgr_snapshot_save(int id) // 离开屏幕前保存当前画面
+{
+    scr_card_t *card = scr_mgr_find_by_id(id);
+
+    if(scr_snapshot_ops == NULL || card == NULL)
+        return;
+
+    if(card->snapshot == NULL){
+        card->snapshot = heap_caps_malloc(scr_snapshot_ops->size, MALLOC_CAP_SPIRAM);
+        if(card->snapshot == NULL)
+            return;
+    }
+    scr_snapshot_ops->save(card->snapshot);
+}
+
+static uint8_t *scr_mgr_snapshot_get(int id, bool anim)
+{
+    scr_card_t *card = scr_mgr_find_by_id(id);
+
+    // An animated load would show other frames first
+    if(scr_snapshot_ops == NULL || card == NULL || anim)
+        return NULL;
+    return card->snapshot;
+}
+
+static void scr_mgr_snapshot_show(uint8_t *snapshot)
+{
+    if(snapshot != NULL)
+        scr_snapshot_ops->show(snapshot);
+    scr_snapshot_restoring = false;
+}
+
+static void scr_mgr_entry(scr_card_t *card) // 调用 entry() 并记录耗时和对象数量
+{
+    scr_card_t *reg = scr_mgr_find_by_id(card->id);
+    int64_t start = esp_timer_get_time();
+
+    card->life->entry();
+    card->st = SCR_MGR_STATE_ACTIVE;
+
+    if(reg != NULL){
+        reg->stats.entry_us = (uint32_t)(esp_timer_get_time() - start);
+        if(reg->stats.entry_us > reg->stats.entry_max_us)
+            reg->stats.entry_max_us = reg->stats.entry_us;
+        reg->stats.objects = scr_mgr_count_objs(card->obj);
+    }
+}
+
 static void scr_mgr_active(scr_card_t *card)  // 设置屏幕卡片为活跃状态 
 {
     if(card->st == SCR_MGR_STATE_DESTROYED){
         // card->obj = card->life->create(NULL);
         card->obj = scr_mgr_default_style(card);
-        card->life->entry();
-        card->st = SCR_MGR_STATE_ACTIVE;
+        scr_mgr_entry(card);
     } else if(card->st == SCR_MGR_STATE_CREATED || card->st == SCR_MGR_STATE_INACTIVE){
-        card->life->entry();
-        card->st = SCR_MGR_STATE_ACTIVE;
+        scr_mgr_entry(card);
     }
 }
 
@@ -87,6 +208,75 @@ static void scr_mgr_remove(scr_card_t *card)
     }
 }
 
+static lv_obj_t *scr_mgr_take_obj(scr_card_t *card) // 取出预先创建的对象，没有则现在创建
+{
+    lv_obj_t *obj = card->obj;
+
+    card->hits++;
+    if(obj == NULL)
+        return scr_mgr_default_style(card);
+
+    card->obj = NULL;
+    card->st = SCR_MGR_STATE_IDLE;
+    return obj;
+}
+
+static lv_obj_t *scr_mgr_release(scr_card_t *card) // 出栈：可缓存的屏幕保留对象，返回需要删除的对象
+{
+    scr_card_t *reg = scr_mgr_find_by_id(card->id);
+
+    if(reg != NULL && reg->preload && reg->obj == NULL && scr_preload_timer != NULL){
+        scr_mgr_inactive(card);
+        reg->obj = card->obj;
+        reg->st = SCR_MGR_STATE_CREATED;
+        reg->last_used = lv_tick_get();
+        return NULL;
+    }
+    scr_mgr_remove(card);
+    return card->obj;
+}
+
+static void scr_mgr_evict(scr_card_t *card) // 销毁缓存的屏幕对象
+{
+    if(card->obj == NULL || card->obj == lv_scr_act())
+        return;
+
+    card->life->destroy();
+    lv_obj_del(card->obj);
+    card->obj = NULL;
+    card->st = SCR_MGR_STATE_IDLE;
+}
+
+static void scr_mgr_preload_timer_cb(lv_timer_t *t)
+{
+    scr_card_t *p = scr_mgr_head->next;
+    scr_card_t *best = NULL;
+
+    // Reclaim cached screens nobody has come back to
+    while(p != NULL){
+        if(p->obj != NULL && lv_tick_elaps(p->last_used) > scr_preload_expire_ms)
+            scr_mgr_evict(p);
+        p = p->next;
+    }
+
+    if(lv_disp_get_inactive_time(NULL) < scr_preload_idle_ms)
+        return;
+
+    // Build the most visited screen reachable from the current menu, one per tick
+    for(int i = 0; i < scr_hint_cnt; i++){
+        scr_card_t *card = scr_mgr_find_by_id(scr_hint_ids[i]);
+        if(card == NULL || !card->preload || card->obj != NULL || scr_mgr_on_stack(card->id))
+            continue;
+        if(best == NULL || card->hits > best->hits)
+            best = card;
+    }
+    if(best != NULL){
+        best->obj = scr_mgr_default_style(best);
+        best->st = SCR_MGR_STATE_CREATED;
+        best->last_used = lv_tick_get();
+    }
+}
+
 /*********************************************************************************
  *                              GLOBAL FUNCTION
  *********************************************************************************/
@@ -97,6 +287,11 @@ void scr_mgr_init(void)
     scr_mgr_head->obj = NULL;
     scr_mgr_head->st = -1;
     scr_mgr_head->life = NULL;
+    scr_mgr_head->snapshot = NULL;
+    scr_mgr_head->preload = false;
+    scr_mgr_head->hits = 0;
+    scr_mgr_head->last_used = 0;
+    memset(&scr_mgr_head->stats, 0, sizeof(scr_stats_t));
     scr_mgr_head->next = NULL;
     scr_mgr_head->prev = NULL;
     
@@ -118,6 +313,11 @@ bool scr_mgr_register(int id, scr_lifecycle_t *card_life) // 注册一个屏幕
     new_card->obj = NULL;
     new_card->st = SCR_MGR_STATE_IDLE;
     new_card->life = card_life;
+    new_card->snapshot = NULL;
+    new_card->preload = false;
+    new_card->hits = 0;
+    new_card->last_used = 0;
+    memset(&new_card->stats, 0, sizeof(scr_stats_t));
     new_card->next = NULL;
     new_card->prev = scr_mgr_top;
 
@@ -132,21 +332,29 @@ bool scr_mgr_switch(int id, bool anim)  // 清空栈，然后切换到指定 id
     scr_card_t *tgt_card = scr_mgr_find_by_id(id);
     scr_card_t *stack_scr = NULL;
     lv_obj_t *curr_obj = NULL;
+    lv_obj_t *obj = NULL;
+    bool retained = false;
 
     if(tgt_card == NULL) // 没有找到该屏幕
         return false;
 
+    scr_mgr_stats_nav();
+    bool use_anim = (scr_anim_sw != LV_SCR_LOAD_ANIM_NONE && anim && ui_anim_policy_get() == UI_ANIM_FULL);
+    uint8_t *snapshot = scr_mgr_snapshot_get(id, use_anim);
+
     if(scr_stack_top != NULL) { // 如果有多张屏幕卡片叠在一起，就先记录顶层卡片
-        curr_obj = scr_stack_top->obj;
+        scr_mgr_snapshot_save(scr_stack_top->id);
         stack_scr = scr_stack_top->prev;
-        scr_mgr_remove(scr_stack_top);
+        curr_obj = scr_mgr_release(scr_stack_top);
+        retained = (curr_obj == NULL);
         lv_mem_free((void *)scr_stack_top);
         scr_stack_top = stack_scr;
     }
-    while(scr_stack_top != NULL) { // 然后清除所有卡片
+    while(scr_stack_top != NULL) { // 然后清除所有卡片，下层屏幕不在显示中，可以直接删除
         stack_scr = scr_stack_top->prev;
-        curr_obj = scr_stack_top->obj;
-        scr_mgr_remove(scr_stack_top);
+        obj = scr_mgr_release(scr_stack_top);
+        if(obj)
+            lv_obj_del(obj);
         lv_mem_free((void *)scr_stack_top);
         scr_stack_top = stack_scr;
     }
@@ -154,23 +362,30 @@ bool scr_mgr_switch(int id, bool anim)  // 清空栈，然后切换到指定 id
     stack_scr = lv_mem_alloc(sizeof(scr_card_t));
     stack_scr->id = tgt_card->id;
     // stack_scr->obj = tgt_card->life->create(NULL);
-    stack_scr->obj = scr_mgr_default_style(tgt_card);
+    stack_scr->obj = scr_mgr_take_obj(tgt_card);
     stack_scr->st = SCR_MGR_STATE_CREATED;
     stack_scr->life = tgt_card->life;
+    stack_scr->snapshot = NULL;
+    stack_scr->preload = false;
+    stack_scr->hits = 0;
+    stack_scr->last_used = 0;
     stack_scr->prev = NULL;
     stack_scr->next = NULL;
     scr_stack_root = stack_scr;
     scr_stack_top = stack_scr;
 
+    scr_snapshot_restoring = (snapshot != NULL);
     scr_mgr_active(stack_scr); // 设置屏幕卡片为活跃状态
 
-    if(scr_anim_sw != LV_SCR_LOAD_ANIM_NONE && anim){
-        lv_scr_load_anim(stack_scr->obj, scr_anim_sw, scr_anim_time, 0, true);
+    if(use_anim){
+        lv_scr_load_anim(stack_scr->obj, scr_anim_sw, scr_anim_time, 0, !retained);
     } else{
         lv_scr_load(stack_scr->obj);
         if(curr_obj)
             lv_obj_del(curr_obj);
     }
+    scr_mgr_snapshot_show(snapshot);
+    scr_mgr_stats_front(id);
     return true;
 }
 
@@ -187,12 +402,23 @@ bool scr_mgr_push(int id, bool anim)
         return false;
     }
 
+    scr_mgr_stats_nav();
+    bool use_anim = (scr_anim_push != LV_SCR_LOAD_ANIM_NONE && anim && ui_anim_policy_get() == UI_ANIM_FULL);
+    uint8_t *snapshot = scr_mgr_snapshot_get(id, use_anim);
+    if(scr_stack_top != NULL){
+        scr_mgr_snapshot_save(scr_stack_top->id);
+    }
+
     stack_scr = lv_mem_alloc(sizeof(scr_card_t));
     stack_scr->id = tgt_card->id;
     // stack_scr->obj = tgt_card->life->create(NULL);
-    stack_scr->obj = scr_mgr_default_style(tgt_card);
+    stack_scr->obj = scr_mgr_take_obj(tgt_card);
     stack_scr->st = SCR_MGR_STATE_CREATED;
     stack_scr->life = tgt_card->life;
+    stack_scr->snapshot = NULL;
+    stack_scr->preload = false;
+    stack_scr->hits = 0;
+    stack_scr->last_used = 0;
     if(scr_stack_top == NULL){
         stack_scr->prev = NULL;
         stack_scr->next = NULL;
@@ -206,13 +432,16 @@ bool scr_mgr_push(int id, bool anim)
         scr_stack_top = stack_scr;
     }
 
+    scr_snapshot_restoring = (snapshot != NULL);
     scr_mgr_active(stack_scr);
 
-    if(scr_anim_push != LV_SCR_LOAD_ANIM_NONE && anim){
+    if(use_anim){
         lv_scr_load_anim(stack_scr->obj, scr_anim_push, scr_anim_time, 0, false);
     } else{
         lv_scr_load(stack_scr->obj);
     }
+    scr_mgr_snapshot_show(snapshot);
+    scr_mgr_stats_front(id);
     return true;
 }
 
@@ -225,25 +454,47 @@ bool scr_mgr_pop(bool anim)
         return false;
     }
 
-    cur_obj = scr_stack_top->obj;
+    scr_mgr_stats_nav();
+    bool use_anim = (scr_anim_pop != LV_SCR_LOAD_ANIM_NONE && anim && ui_anim_policy_get() == UI_ANIM_FULL);
+    uint8_t *snapshot = scr_mgr_snapshot_get(scr_stack_top->prev->id, use_anim);
+    scr_mgr_snapshot_save(scr_stack_top->id);
+
     dst_item = scr_stack_top->prev;
-    scr_mgr_remove(scr_stack_top);
+    cur_obj = scr_mgr_release(scr_stack_top);
     lv_mem_free((void *)scr_stack_top);
     scr_stack_top = dst_item;
 
+    scr_snapshot_restoring = (snapshot != NULL);
     scr_mgr_active(dst_item);
 
-    if(scr_anim_pop != LV_SCR_LOAD_ANIM_NONE && anim){
-        lv_scr_load_anim(dst_item->obj, scr_anim_pop, scr_anim_time, 0, true);
+    if(use_anim){
+        lv_scr_load_anim(dst_item->obj, scr_anim_pop, scr_anim_time, 0, cur_obj != NULL);
     } else{
         lv_scr_load(dst_item->obj);
         if (cur_obj) {
             lv_obj_del(cur_obj);
         }
     }
+    scr_mgr_snapshot_show(snapshot);
+    scr_mgr_stats_front(dst_item->id);
     return false;
 }
 
+int scr_mgr_get_stack(int *ids, int max) // 当前栈中的屏幕 id，根在前
+{
+    int depth = 0;
+    for(scr_card_t *p = scr_stack_top; p != NULL; p = p->prev)
+        depth++;
+    if(depth > max)
+        depth = max;
+
+    // pop 不清 next，按深度计数而不是走到 NULL
+    int n = 0;
+    for(scr_card_t *p = scr_stack_root; p != NULL && n < depth; p = p->next)
+        ids[n++] = p->id;
+    return n;
+}
+
 // set anim
 void scr_mgr_set_anim(lv_scr_load_anim_t sw, lv_scr_load_anim_t push, lv_scr_load_anim_t pop)
 {
@@ -264,4 +515,132 @@ void scr_mgr_set_bg_color(uint32_t c)
     default_bg_color = c;
 }
 
+// snapshot cache
+void scr_mgr_set_snapshot_ops(const scr_snapshot_ops_t *ops)
+{
+    scr_snapshot_ops = ops;
+}
+
+void scr_mgr_drop_snapshot(int id) // 屏幕内容失效时丢弃快照
+{
+    scr_card_t *card = scr_mgr_find_by_id(id);
+
+    if(card != NULL && card->snapshot != NULL){
+        heap_caps_free(card->snapshot);
+        card->snapshot = NULL;
+    }
+}
+
+void scr_mgr_drop_snapshots(void) // 显示方向改变后快照全部失效
+{
+    if(scr_mgr_head == NULL)
+        return;
+
+    scr_card_t *p = scr_mgr_head->next;
+    while(p != NULL){
+        if(p->snapshot != NULL){
+            heap_caps_free(p->snapshot);
+            p->snapshot = NULL;
+        }
+        p = p->next;
+    }
+}
+
+bool scr_mgr_restoring(void) // entry() 中判断是否即将显示缓存画面
+{
+    return scr_snapshot_restoring;
+}
+
+// lazy create / idle pre-instantiation
+void scr_mgr_set_preload(int id, bool enable) // 允许该屏幕预先创建并在退出后保留
+{
+    scr_card_t *card = scr_mgr_find_by_id(id);
+
+    if(card == NULL)
+        return;
+    card->preload = enable;
+    if(!enable)
+        scr_mgr_evict(card);
+}
+
+void scr_mgr_set_next_hint(const int *ids, int count) // 当前菜单可以直接进入的屏幕
+{
+    if(count > SCR_MGR_HINT_MAX)
+        count = SCR_MGR_HINT_MAX;
+    for(int i = 0; i < count; i++)
+        scr_hint_ids[i] = ids[i];
+    scr_hint_cnt = count;
+}
+
+void scr_mgr_set_preload_policy(uint32_t idle_ms, uint32_t expire_ms) // expire_ms 为 0 时关闭并释放缓存
+{
+    scr_preload_idle_ms = idle_ms;
+    scr_preload_expire_ms = expire_ms;
+
+    if(expire_ms == 0){
+        if(scr_preload_timer != NULL){
+            lv_timer_del(scr_preload_timer);
+            scr_preload_timer = NULL;
+        }
+        scr_mgr_trim();
+    } else if(scr_preload_timer == NULL){
+        scr_preload_timer = lv_timer_create(scr_mgr_preload_timer_cb, SCR_MGR_PRELOAD_PERIOD_MS, NULL);
+    }
+}
+
+void scr_mgr_trim(void) // 释放所有缓存的屏幕对象
+{
+    scr_card_t *p = scr_mgr_head->next;
+    while(p != NULL){
+        scr_mgr_evict(p);
+        p = p->next;
+    }
+}
+
+// per-screen accounting
+void scr_mgr_set_mem_probe(uint32_t (*used)(void))
+{
+    scr_mem_probe = used;
+}
+
+void scr_mgr_note_flush(void) // 显示驱动每送出一帧调用一次
+{
+    if(scr_stats_front == NULL)
+        return;
+
+    scr_stats_front->stats.refreshes++;
+    if(scr_stats_nav_us != 0){
+        scr_stats_t *st = &scr_stats_front->stats;
+        st->first_flush_ms = (uint32_t)((esp_timer_get_time() - scr_stats_nav_us) / 1000);
+        if(st->first_flush_ms > st->first_flush_max_ms)
+            st->first_flush_max_ms = st->first_flush_ms;
+        scr_stats_nav_us = 0;
+    }
+}
+
+int scr_mgr_get_stats(int *ids, scr_stats_t *stats, int max) // 按注册顺序复制统计，前台屏幕的在前台时间算到现在
+{
+    int n = 0;
+
+    if(scr_mgr_head == NULL)
+        return 0;
+
+    for(scr_card_t *p = scr_mgr_head->next; p != NULL && n < max; p = p->next){
+        ids[n] = p->id;
+        stats[n] = p->stats;
+        if(p == scr_stats_front)
+            stats[n].active_ms += lv_tick_elaps(scr_stats_since);
+        n++;
+    }
+    return n;
+}
+
+void scr_mgr_reset_stats(void)
+{
+    if(scr_mgr_head == NULL)
+        return;
 
+    for(scr_card_t *p = scr_mgr_head->next; p != NULL; p = p->next)
+        memset(&p->stats, 0, sizeof(scr_stats_t));
+    scr_stats_since = lv_tick_get();
+}
@@ -11,6 +11,10 @@ extern "C" {
 #define SCR_MGR_SCR_SWITCH_ANIM    LV_SCR_LOAD_ANIM_NONE
 #define SCR_MGR_SCR_PUSH_ANIM      LV_SCR_LOAD_ANIM_MOVE_LEFT
 #define SCR_MGR_SCR_POP_ANIM       LV_SCR_LOAD_ANIM_MOVE_RIGHT
+#define SCR_MGR_PRELOAD_IDLE_MS    3000           /* Input idle time before building the likely next screen */
+#define SCR_MGR_PRELOAD_EXPIRE_MS  (5 * 60 * 1000)/* Cached screens unused this long are destroyed */
+#define SCR_MGR_PRELOAD_PERIOD_MS  1000
+#define SCR_MGR_HINT_MAX           16
 typedef enum scr_mgr_state {
     SCR_MGR_STATE_IDLE = 0,  /* Not in use */
     SCR_MGR_STATE_DESTROYED, /* Not active and having been destroyed */
@@ -27,15 +31,43 @@ typedef struct scr_lifecycle {
     void (*destroy)(void);
 } scr_lifecycle_t;
 
+/* Per-screen accounting, kept on the registered card */
+typedef struct scr_stats {
+    uint32_t visits;         /* Times brought to the front by switch/push/pop */
+    uint32_t creates;        /* Objects built, preloads included */
+    uint32_t create_us;      /* Last create() */
+    uint32_t create_max_us;
+    uint32_t entry_us;       /* Last entry() */
+    uint32_t entry_max_us;
+    int32_t  mem_delta;      /* LVGL heap taken by the last create(), see scr_mgr_set_mem_probe() */
+    uint16_t objects;        /* Objects under the screen after the last entry() */
+    uint32_t refreshes;      /* Frames flushed while in front, all visits */
+    uint32_t first_flush_ms; /* Navigation to its first flushed frame, last visit */
+    uint32_t first_flush_max_ms;
+    uint32_t active_ms;      /* In front, all visits before the current one */
+} scr_stats_t;
+
 typedef struct scr_card {
     int id;
     lv_obj_t        *obj;
     scr_mgr_state_e  st;
     scr_lifecycle_t *life;
+    uint8_t         *snapshot; /* Last frame shown for this card, registered cards only */
+    bool             preload;  /* Object may be built ahead of time and kept after pop */
+    uint16_t         hits;     /* Times navigated to, ranks preload candidates */
+    uint32_t         last_used;/* lv_tick of last use of the cached object */
+    scr_stats_t      stats;    /* Registered cards only */
     struct scr_card *next;
     struct scr_card *prev;
 } scr_card_t;
 
+/* Display hooks for the snapshot cache */
+typedef struct scr_snapshot_ops {
+    uint32_t size;                      /* Bytes per snapshot */
+    void (*save)(uint8_t *buf);         /* Copy the current frame */
+    void (*show)(const uint8_t *buf);   /* Put a saved frame on the panel now */
+} scr_snapshot_ops_t;
+
 /*********************************************************************************
  *                              GLOBAL PROTOTYPES
  * *******************************************************************************/
@@ -44,12 +76,31 @@ bool scr_mgr_register(int id, scr_lifecycle_t *card_life);
 bool scr_mgr_switch(int id, bool anim);
 bool scr_mgr_push(int id, bool anim);
 bool scr_mgr_pop(bool anim);
+int scr_mgr_get_stack(int *ids, int max); /* Root first, returns the depth copied */
 
 // set anim
 void scr_mgr_set_anim(lv_scr_load_anim_t sw, lv_scr_load_anim_t push, lv_scr_load_anim_t pop);
 // set bg color
 void scr_mgr_set_bg_color(uint32_t c);
 
+// snapshot cache
+void scr_mgr_set_snapshot_ops(const scr_snapshot_ops_t *ops);
+void scr_mgr_drop_snapshot(int id);
+void scr_mgr_drop_snapshots(void); /* All of them, e.g. after the frame layout changes */
+bool scr_mgr_restoring(void);
+
+// lazy create / idle pre-instantiation
+void scr_mgr_set_preload(int id, bool enable);
+void scr_mgr_set_next_hint(const int *ids, int count);
+void scr_mgr_set_preload_policy(uint32_t idle_ms, uint32_t expire_ms);
+void scr_mgr_trim(void);
+
+// per-screen accounting
+void scr_mgr_set_mem_probe(uint32_t (*used)(void)); /* LVGL heap in use, bytes; mem_delta stays 0 without it */
+void scr_mgr_note_flush(void);                      /* Display driver: a frame went out */
+int scr_mgr_get_stats(int *ids, scr_stats_t *stats, int max); /* Registration order, returns the count copied */
+void scr_mgr_reset_stats(void);
+
 #ifdef __cplusplus
 } /*extern "C"*/
 #endif
@@ -0,0 +1,232 @@
+
+#include "ui_term.h"
+#include "lvgl_draw_1bpp.h"
+
+typedef struct ui_term {
+    const lv_font_t *font;
+    lv_coord_t cell_w;
+    lv_coord_t cell_h;
+    uint8_t cols;
+    uint8_t rows;
+    bool live;                              /* Following the newest line */
+    uint32_t newest;                        /* Line being written, free running */
+    uint32_t view_top;                      /* First line shown while paging */
+    uint32_t first;                         /* Nothing before it since the last clear */
+    uint8_t len[UI_TERM_LINES];
+    char text[UI_TERM_LINES][UI_TERM_COLS_MAX];
+} ui_term_t;
+
+/*********************************************************************************
+ *                              STATIC FUNCTION
+ *********************************************************************************/
+static ui_term_t *ui_term_get(lv_obj_t *term)
+{
+    return (term != NULL) ? (ui_term_t *)lv_obj_get_user_data(term) : NULL;
+}
+
+static uint32_t ui_term_oldest(const ui_term_t *t)
+{
+    uint32_t oldest = (t->newest >= UI_TERM_LINES) ? t->newest - UI_TERM_LINES + 1 : 0;
+    return LV_MAX(oldest, t->first);
+}
+
+// Line shown in grid row r, false for a blank row
+static bool ui_term_row_line(const ui_term_t *t, uint8_t r, uint32_t *line)
+{
+    uint32_t n;
+    if(t->live){
+        uint32_t back = (t->newest % t->rows + t->rows - r) % t->rows;
+        if(back == (uint32_t)t->rows - 1 || back > t->newest)   /* The gap after the newest, or not written yet */
+            return false;
+        n = t->newest - back;
+    } else {
+        n = t->view_top + r;
+        if(n > t->newest)
+            return false;
+    }
+    if(n < ui_term_oldest(t))
+        return false;
+    *line = n;
+    return true;
+}
+
+static void ui_term_invalidate_row(lv_obj_t *obj, uint8_t r)
+{
+    ui_term_t *t = ui_term_get(obj);
+    lv_area_t area;
+    lv_obj_get_content_coords(obj, &area);
+    area.y1 += r * t->cell_h;
+    area.y2 = area.y1 + t->cell_h - 1;
+    lv_obj_invalidate_area(obj, &area);
+}
+
+static void ui_term_draw(lv_event_t *e)
+{
+    lv_obj_t *obj = lv_event_get_target(e);
+    ui_term_t *t = ui_term_get(obj);
+    lv_draw_ctx_t *draw_ctx = lv_event_get_draw_ctx(e);
+    lv_area_t content;
+    lv_obj_get_content_coords(obj, &content);
+
+    lv_draw_label_dsc_t label_dsc;
+    lv_draw_label_dsc_init(&label_dsc);
+    lv_obj_init_draw_label_dsc(obj, LV_PART_MAIN, &label_dsc);
+    label_dsc.font = t->font;
+
+    lv_coord_t top = t->font->line_height - t->font->base_line;
+    for(uint8_t r = 0; r < t->rows; r++){
+        lv_coord_t y = content.y1 + r * t->cell_h;
+        uint32_t n;
+        if(y > draw_ctx->clip_area->y2 || y + t->cell_h <= draw_ctx->clip_area->y1)
+            continue;
+        if(!ui_term_row_line(t, r, &n))
+            continue;
+
+        const char *text = t->text[n % UI_TERM_LINES];
+        uint8_t len = t->len[n % UI_TERM_LINES];
+        for(uint8_t c = 0; c < len; c++){
+            uint32_t letter = (uint8_t)text[c];
+            lv_coord_t x = content.x1 + c * t->cell_w;
+            lv_font_glyph_dsc_t g;
+            if(letter == ' ' || !lv_font_get_glyph_dsc(t->font, &g, letter, 0))
+                continue;
+
+            // Cached Mono glyphs come back 1bpp: set the bits, no blending
+            const uint8_t *bitmap = (g.bpp == 1) ? lv_font_get_glyph_bitmap(g.resolved_font, letter) : NULL;
+            if(bitmap != NULL &&
+               lvgl_draw_1bpp_blit(draw_ctx, bitmap, x + g.ofs_x, y + top - g.box_h - g.ofs_y,
+                                   g.box_w, g.box_h, label_dsc.color))
+                continue;
+            lv_point_t pos = { x, y };
+            lv_draw_letter(draw_ctx, &label_dsc, &pos, letter);
+        }
+    }
+}
+
+static void ui_term_delete(lv_event_t *e)
+{
+    lv_obj_t *obj = lv_event_get_target(e);
+    lv_mem_free(ui_term_get(obj));
+    lv_obj_set_user_data(obj, NULL);
+}
+
+static void ui_term_newline(ui_term_t *t)
+{
+    t->newest++;
+    t->len[t->newest % UI_TERM_LINES] = 0;
+}
+
+/*********************************************************************************
+ *                              GLOBAL FUNCTION
+ *********************************************************************************/
+lv_obj_t *ui_term_create(lv_obj_t *parent, const lv_font_t *font, lv_coord_t w, lv_coord_t h)
+{
+    ui_term_t *t = (ui_term_t *)lv_mem_alloc(sizeof(ui_term_t));
+    if(t == NULL)
+        return NULL;
+    memset(t, 0, sizeof(ui_term_t));
+    t->font = font;
+    t->cell_w = lv_font_get_glyph_width(font, '0', '0');
+    t->cell_h = lv_font_get_line_height(font);
+    t->cols = LV_MIN(w / LV_MAX(t->cell_w, 1), UI_TERM_COLS_MAX);
+    t->rows = LV_MAX(h / LV_MAX(t->cell_h, 1), 2);
+    t->live = true;
+
+    lv_obj_t *obj = lv_obj_create(parent);
+    lv_obj_remove_style_all(obj);
+    lv_obj_set_size(obj, w, h);
+    lv_obj_clear_flag(obj, LV_OBJ_FLAG_SCROLLABLE);
+    lv_obj_set_style_text_font(obj, font, LV_PART_MAIN);
+    lv_obj_set_user_data(obj, t);
+    lv_obj_add_event_cb(obj, ui_term_draw, LV_EVENT_DRAW_MAIN, NULL);
+    lv_obj_add_event_cb(obj, ui_term_delete, LV_EVENT_DELETE, NULL);
+    return obj;
+}
+
+void ui_term_write(lv_obj_t *term, const char *text, size_t len)
+{
+    ui_term_t *t = ui_term_get(term);
+    if(t == NULL || len == 0)
+        return;
+
+    uint32_t first = t->newest;
+    for(size_t i = 0; i < len; i++){
+        char c = text[i];
+        if(c == '\r')
+            continue;
+        if(c == '\n'){
+            ui_term_newline(t);
+            continue;
+        }
+        if(t->len[t->newest % UI_TERM_LINES] >= t->cols)
+            ui_term_newline(t);
+        uint32_t slot = t->newest % UI_TERM_LINES;
+        t->text[slot][t->len[slot]++] = (c >= 0x20 && c < 0x7f) ? c : '.';
+    }
+
+    // Paging shows old lines; they only change when the ring wraps under them
+    if(!t->live)
+        return;
+    if(t->newest - first + 2 >= t->rows){
+        lv_obj_invalidate(term);
+        return;
+    }
+    for(uint32_t n = first; n <= t->newest + 1; n++)
+        ui_term_invalidate_row(term, n % t->rows);
+}
+
+void ui_term_puts(lv_obj_t *term, const char *line)
+{
+    ui_term_t *t = ui_term_get(term);
+    if(t == NULL)
+        return;
+    // Starts on a fresh line whatever was left open
+    if(t->len[t->newest % UI_TERM_LINES] > 0)
+        ui_term_write(term, "\n", 1);
+    ui_term_write(term, line, strlen(line));
+    ui_term_write(term, "\n", 1);
+}
+
+void ui_term_clear(lv_obj_t *term)
+{
+    ui_term_t *t = ui_term_get(term);
+    if(t == NULL)
+        return;
+    // Starts the next line on the top row
+    ui_term_newline(t);
+    while(t->newest % t->rows)
+        ui_term_newline(t);
+    t->first = t->newest;
+    t->live = true;
+    lv_obj_invalidate(term);
+}
+
+void ui_term_page(lv_obj_t *term, int dir)
+{
+    ui_term_t *t = ui_term_get(term);
+    if(t == NULL || dir == 0)
+        return;
+
+    uint32_t oldest = ui_term_oldest(t);
+    uint32_t live_top = (t->newest + 2 > t->rows) ? t->newest + 2 - t->rows : 0;
+    uint32_t top = t->live ? live_top : t->view_top;
+
+    if(dir < 0){
+        if(top <= oldest)
+            return;
+        t->view_top = (top >= oldest + t->rows) ? top - t->rows : oldest;
+        t->live = false;
+    } else {
+        if(t->live)
+            return;
+        t->view_top = top + t->rows;
+        t->live = t->view_top >= live_top;
+    }
+    lv_obj_invalidate(term);
+}
+
+bool ui_term_is_live(lv_obj_t *term)
+{
+    ui_term_t *t = ui_term_get(term);
+    return t != NULL && t->live;
+}
@@ -0,0 +1,43 @@
+#ifndef __UI_TERM_H__
+#define __UI_TERM_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "lvgl.h"
+
+/*
+ * Character-cell terminal for consoles that append all the time. The
+ * object is a fixed grid of cols x rows cells of a Mono font over a ring
+ * of UI_TERM_LINES lines; there is no label and no text layout.
+ *
+ * While live, line n is shown in grid row n % rows and the row after the
+ * newest is kept blank to mark it, so an appended line invalidates its
+ * own row and the blank one: two row strips of partial refresh, whatever
+ * the scrollback holds. ui_term_page() steps back through the scrollback
+ * as ordinary pages and returns to live past the end.
+ *
+ * Cells are drawn from the glyph cache's 1bpp bitmaps straight into the
+ * packed framebuffer when the display draws into one, lv_draw_letter
+ * otherwise. Write from the LVGL task only.
+ */
+#define UI_TERM_LINES       128  /* Scrollback, lines */
+#define UI_TERM_COLS_MAX    64
+
+/*********************************************************************************
+ *                              GLOBAL PROTOTYPES
+ * *******************************************************************************/
+// font must be a Mono font; the grid is as many cells as fit w x h
+lv_obj_t *ui_term_create(lv_obj_t *parent, const lv_font_t *font, lv_coord_t w, lv_coord_t h);
+void ui_term_write(lv_obj_t *term, const char *text, size_t len);   // '\n' ends a line, long lines wrap
+void ui_term_puts(lv_obj_t *term, const char *line);                // One whole line
+void ui_term_clear(lv_obj_t *term);
+void ui_term_page(lv_obj_t *term, int dir);     // dir < 0 back a page, > 0 forward
+bool ui_term_is_live(lv_obj_t *term);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*__UI_TERM_H__*/
@@ -0,0 +1,528 @@
+
+#include "ui_theme.h"
+#include "ui_config.h"
+
+/* glyph_cache.h pulls in Arduino; these two are all the styles need from it */
+extern lv_font_t Font_Mono_Bold_14_cached;
+extern lv_font_t Font_Mono_Bold_15_cached;
+
+#define COLOR_FG            LV_COLOR_MAKE(0x00, 0x00, 0x00)
+#define COLOR_BG            LV_COLOR_MAKE(0xFF, 0xFF, 0xFF)
+#define COLOR_HEX(c)        LV_COLOR_MAKE(((c) >> 16) & 0xFF, ((c) >> 8) & 0xFF, (c) & 0xFF)
+
+#define BORDER_W_NORMAL     1
+#define BORDER_W_PR         3
+#define BORDER_W_DIS        0
+#define BORDER_W_FOCUS      1
+#define BORDER_W_EDIT       2
+#define PAD_DEF             4
+
+#define CONST_PAD_ALL(v)    LV_STYLE_CONST_PAD_TOP(v), LV_STYLE_CONST_PAD_BOTTOM(v), \
+                            LV_STYLE_CONST_PAD_LEFT(v), LV_STYLE_CONST_PAD_RIGHT(v)
+#define CONST_PAD_GAP(v)    LV_STYLE_CONST_PAD_ROW(v), LV_STYLE_CONST_PAD_COLUMN(v)
+
+/*********************************************************************************
+ *                              THEME STYLES
+ * lv_theme_mono's, light background, font LV_FONT_DEFAULT
+ *********************************************************************************/
+static const lv_style_const_prop_t scrollbar_props[] = {
+    LV_STYLE_CONST_BG_OPA(LV_OPA_COVER),
+    LV_STYLE_CONST_BG_COLOR(COLOR_FG),
+    LV_STYLE_CONST_WIDTH(PAD_DEF),
+};
+static LV_STYLE_CONST_INIT(th_scrollbar, scrollbar_props);
+
+static const lv_style_const_prop_t scr_props[] = {
+    LV_STYLE_CONST_BG_OPA(LV_OPA_COVER),
+    LV_STYLE_CONST_BG_COLOR(COLOR_BG),
+    LV_STYLE_CONST_TEXT_COLOR(COLOR_FG),
+    CONST_PAD_GAP(PAD_DEF),
+    LV_STYLE_CONST_TEXT_FONT(LV_FONT_DEFAULT),
+};
+static LV_STYLE_CONST_INIT(th_scr, scr_props);
+
+static const lv_style_const_prop_t card_props[] = {
+    LV_STYLE_CONST_BG_OPA(LV_OPA_COVER),
+    LV_STYLE_CONST_BG_COLOR(COLOR_BG),
+    LV_STYLE_CONST_BORDER_COLOR(COLOR_FG),
+    LV_STYLE_CONST_RADIUS(2),
+    LV_STYLE_CONST_BORDER_WIDTH(BORDER_W_NORMAL),
+    CONST_PAD_ALL(PAD_DEF),
+    CONST_PAD_GAP(PAD_DEF),
+    LV_STYLE_CONST_TEXT_COLOR(COLOR_FG),
+    LV_STYLE_CONST_LINE_WIDTH(2),
+    LV_STYLE_CONST_LINE_COLOR(COLOR_FG),
+    LV_STYLE_CONST_ARC_WIDTH(2),
+    LV_STYLE_CONST_ARC_COLOR(COLOR_FG),
+    LV_STYLE_CONST_OUTLINE_COLOR(COLOR_FG),
+    LV_STYLE_CONST_ANIM_TIME(300),
+};
+static LV_STYLE_CONST_INIT(th_card, card_props);
+
+static const lv_style_const_prop_t pr_props[] = {
+    LV_STYLE_CONST_BORDER_WIDTH(BORDER_W_PR),
+};
+static LV_STYLE_CONST_INIT(th_pr, pr_props);
+
+static const lv_style_const_prop_t inv_props[] = {
+    LV_STYLE_CONST_BG_OPA(LV_OPA_COVER),
+    LV_STYLE_CONST_BG_COLOR(COLOR_FG),
+    LV_STYLE_CONST_BORDER_COLOR(COLOR_BG),
+    LV_STYLE_CONST_LINE_COLOR(COLOR_BG),
+    LV_STYLE_CONST_ARC_COLOR(COLOR_BG),
+    LV_STYLE_CONST_TEXT_COLOR(COLOR_BG),
+    LV_STYLE_CONST_OUTLINE_COLOR(COLOR_BG),
+};
+static LV_STYLE_CONST_INIT(th_inv, inv_props);
+
+static const lv_style_const_prop_t disabled_props[] = {
+    LV_STYLE_CONST_BORDER_WIDTH(BORDER_W_DIS),
+};
+static LV_STYLE_CONST_INIT(th_disabled, disabled_props);
+
+static const lv_style_const_prop_t focus_props[] = {
+    LV_STYLE_CONST_OUTLINE_WIDTH(1),
+    LV_STYLE_CONST_OUTLINE_PAD(BORDER_W_FOCUS),
+};
+static LV_STYLE_CONST_INIT(th_focus, focus_props);
+
+static const lv_style_const_prop_t edit_props[] = {
+    LV_STYLE_CONST_OUTLINE_WIDTH(BORDER_W_EDIT),
+};
+static LV_STYLE_CONST_INIT(th_edit, edit_props);
+
+static const lv_style_const_prop_t large_border_props[] = {
+    LV_STYLE_CONST_BORDER_WIDTH(BORDER_W_EDIT),
+};
+static LV_STYLE_CONST_INIT(th_large_border, large_border_props);
+
+static const lv_style_const_prop_t pad_gap_props[] = {
+    CONST_PAD_GAP(PAD_DEF),
+};
+static LV_STYLE_CONST_INIT(th_pad_gap, pad_gap_props);
+
+static const lv_style_const_prop_t pad_zero_props[] = {
+    CONST_PAD_ALL(0),
+    CONST_PAD_GAP(0),
+};
+static LV_STYLE_CONST_INIT(th_pad_zero, pad_zero_props);
+
+static const lv_style_const_prop_t no_radius_props[] = {
+    LV_STYLE_CONST_RADIUS(0),
+};
+static LV_STYLE_CONST_INIT(th_no_radius, no_radius_props);
+
+static const lv_style_const_prop_t radius_circle_props[] = {
+    LV_STYLE_CONST_RADIUS(LV_RADIUS_CIRCLE),
+};
+static LV_STYLE_CONST_INIT(th_radius_circle, radius_circle_props);
+
+static const lv_style_const_prop_t large_line_space_props[] = {
+    LV_STYLE_CONST_TEXT_LINE_SPACE(6),
+};
+static LV_STYLE_CONST_INIT(th_large_line_space, large_line_space_props);
+
+static const lv_style_const_prop_t underline_props[] = {
+    LV_STYLE_CONST_TEXT_DECOR(LV_TEXT_DECOR_UNDERLINE),
+};
+static LV_STYLE_CONST_INIT(th_underline, underline_props);
+
+#if LV_USE_TEXTAREA
+static const lv_style_const_prop_t ta_cursor_props[] = {
+    LV_STYLE_CONST_BORDER_SIDE(LV_BORDER_SIDE_LEFT),
+    LV_STYLE_CONST_BORDER_COLOR(COLOR_FG),
+    LV_STYLE_CONST_BORDER_WIDTH(2),
+    LV_STYLE_CONST_BG_OPA(LV_OPA_TRANSP),
+    LV_STYLE_CONST_ANIM_TIME(500),
+};
+static LV_STYLE_CONST_INIT(th_ta_cursor, ta_cursor_props);
+#endif
+
+/*********************************************************************************
+ *                              APP STYLES
+ *********************************************************************************/
+static const lv_style_const_prop_t back_btn_props[] = {
+    CONST_PAD_ALL(0),
+    LV_STYLE_CONST_BORDER_WIDTH(0),
+    LV_STYLE_CONST_SHADOW_WIDTH(0),
+    LV_STYLE_CONST_BORDER_COLOR(COLOR_FG),
+    LV_STYLE_CONST_BG_COLOR(COLOR_BG),
+    LV_STYLE_CONST_TEXT_COLOR(COLOR_FG),
+};
+LV_STYLE_CONST_INIT(ui_style_back_btn, back_btn_props);
+
+static const lv_style_const_prop_t title_props[] = {
+    LV_STYLE_CONST_TEXT_FONT(&Font_Mono_Bold_15_cached),
+    LV_STYLE_CONST_TEXT_COLOR(COLOR_FG),
+};
+LV_STYLE_CONST_INIT(ui_style_title, title_props);
+
+static const lv_style_const_prop_t list_props[] = {
+    LV_STYLE_CONST_PAD_TOP(10),
+    LV_STYLE_CONST_PAD_ROW(15),
+    LV_STYLE_CONST_RADIUS(0),
+    LV_STYLE_CONST_BORDER_WIDTH(0),
+    LV_STYLE_CONST_SHADOW_WIDTH(0),
+};
+LV_STYLE_CONST_INIT(ui_style_list, list_props);
+
+static const lv_style_const_prop_t list_item_props[] = {
+    LV_STYLE_CONST_TEXT_FONT(&Font_Mono_Bold_15_cached),
+    LV_STYLE_CONST_BORDER_WIDTH(1),
+    LV_STYLE_CONST_RADIUS(10),
+};
+LV_STYLE_CONST_INIT(ui_style_list_item, list_item_props);
+
+static const lv_style_const_prop_t list_item_pr_props[] = {
+    LV_STYLE_CONST_BORDER_WIDTH(1),
+    LV_STYLE_CONST_OUTLINE_WIDTH(1),
+};
+LV_STYLE_CONST_INIT(ui_style_list_item_pr, list_item_pr_props);
+
+static const lv_style_const_prop_t info_cont_props[] = {
+    LV_STYLE_CONST_BG_COLOR(COLOR_BG),
+    LV_STYLE_CONST_BORDER_WIDTH(0),
+    CONST_PAD_ALL(0),
+    LV_STYLE_CONST_PAD_ROW(5),
+    LV_STYLE_CONST_PAD_COLUMN(0),
+};
+LV_STYLE_CONST_INIT(ui_style_info_cont, info_cont_props);
+
+static const lv_style_const_prop_t info_row_props[] = {
+    LV_STYLE_CONST_TEXT_FONT(&Font_Mono_Bold_15_cached),
+    LV_STYLE_CONST_BORDER_WIDTH(1),
+    LV_STYLE_CONST_BORDER_SIDE(LV_BORDER_SIDE_BOTTOM),
+};
+LV_STYLE_CONST_INIT(ui_style_info_row, info_row_props);
+
+static const lv_style_const_prop_t text_props[] = {
+    LV_STYLE_CONST_TEXT_FONT(&Font_Mono_Bold_15_cached),
+    LV_STYLE_CONST_BORDER_WIDTH(0),
+};
+LV_STYLE_CONST_INIT(ui_style_text, text_props);
+
+static const lv_style_const_prop_t taskbar_props[] = {
+    CONST_PAD_ALL(0),
+    LV_STYLE_CONST_BORDER_WIDTH(0),
+};
+LV_STYLE_CONST_INIT(ui_style_taskbar, taskbar_props);
+
+static const lv_style_const_prop_t taskbar_status_props[] = {
+    LV_STYLE_CONST_PAD_TOP(0),
+    LV_STYLE_CONST_PAD_BOTTOM(0),
+    LV_STYLE_CONST_PAD_LEFT(0),
+    LV_STYLE_CONST_PAD_RIGHT(5),
+    LV_STYLE_CONST_PAD_ROW(0),
+    LV_STYLE_CONST_PAD_COLUMN(5),
+    LV_STYLE_CONST_BORDER_WIDTH(0),
+};
+LV_STYLE_CONST_INIT(ui_style_taskbar_status, taskbar_status_props);
+
+static const lv_style_const_prop_t breadcrumb_props[] = {
+    LV_STYLE_CONST_TEXT_FONT(&Font_Mono_Bold_14_cached),
+    LV_STYLE_CONST_BG_COLOR(COLOR_HEX(UI_COLOR_BREADCRUMB_BG)),
+    LV_STYLE_CONST_TEXT_COLOR(COLOR_HEX(UI_COLOR_FG_NORMAL)),
+    LV_STYLE_CONST_BORDER_WIDTH(1),
+    LV_STYLE_CONST_BORDER_COLOR(COLOR_HEX(UI_COLOR_BREADCRUMB_BORDER)),
+    LV_STYLE_CONST_RADIUS(3),
+};
+LV_STYLE_CONST_INIT(ui_style_breadcrumb, breadcrumb_props);
+
+static const lv_style_const_prop_t breadcrumb_pr_props[] = {
+    LV_STYLE_CONST_BG_COLOR(COLOR_HEX(UI_COLOR_BG_PRESSED)),
+    LV_STYLE_CONST_TEXT_COLOR(COLOR_HEX(UI_COLOR_FG_PRESSED)),
+};
+LV_STYLE_CONST_INIT(ui_style_breadcrumb_pr, breadcrumb_pr_props);
+
+static lv_theme_t theme;
+
+/*********************************************************************************
+ *                              STATIC FUNCTION
+ *********************************************************************************/
+#define ADD(obj, style, selector)   UI_STYLE(obj, th_##style, selector)
+
+// lv_theme_mono's theme_apply, class for class
+static void theme_apply(lv_theme_t *th, lv_obj_t *obj)
+{
+    LV_UNUSED(th);
+
+    if(lv_obj_get_parent(obj) == NULL) {
+        ADD(obj, scr, 0);
+        ADD(obj, scrollbar, LV_PART_SCROLLBAR);
+        return;
+    }
+
+    if(lv_obj_check_type(obj, &lv_obj_class)) {
+#if LV_USE_TABVIEW
+        lv_obj_t *parent = lv_obj_get_parent(obj);
+        if(lv_obj_check_type(parent, &lv_tabview_class)) {
+            return;
+        }
+        else if(lv_obj_check_type(lv_obj_get_parent(parent), &lv_tabview_class)) {
+            ADD(obj, card, 0);
+            ADD(obj, no_radius, 0);
+            ADD(obj, scrollbar, LV_PART_SCROLLBAR);
+            return;
+        }
+#endif
+#if LV_USE_WIN
+        if(lv_obj_get_index(obj) == 0 && lv_obj_check_type(lv_obj_get_parent(obj), &lv_win_class)) {
+            ADD(obj, card, 0);
+            ADD(obj, no_radius, 0);
+            return;
+        }
+        else if(lv_obj_get_index(obj) == 1 && lv_obj_check_type(lv_obj_get_parent(obj), &lv_win_class)) {
+            ADD(obj, card, 0);
+            ADD(obj, no_radius, 0);
+            ADD(obj, scrollbar, LV_PART_SCROLLBAR);
+            return;
+        }
+#endif
+        ADD(obj, card, 0);
+        ADD(obj, scrollbar, LV_PART_SCROLLBAR);
+    }
+#if LV_USE_BTN
+    else if(lv_obj_check_type(obj, &lv_btn_class)) {
+        ADD(obj, card, 0);
+        ADD(obj, pr, LV_STATE_PRESSED);
+        ADD(obj, inv, LV_STATE_CHECKED);
+        ADD(obj, disabled, LV_STATE_DISABLED);
+        ADD(obj, focus, LV_STATE_FOCUS_KEY);
+        ADD(obj, edit, LV_STATE_EDITED);
+    }
+#endif
+#if LV_USE_BTNMATRIX
+    else if(lv_obj_check_type(obj, &lv_btnmatrix_class)) {
+#if LV_USE_MSGBOX
+        if(lv_obj_check_type(lv_obj_get_parent(obj), &lv_msgbox_class)) {
+            ADD(obj, pad_gap, 0);
+            ADD(obj, card, LV_PART_ITEMS);
+            ADD(obj, pr, LV_PART_ITEMS | LV_STATE_PRESSED);
+            ADD(obj, disabled, LV_PART_ITEMS | LV_STATE_DISABLED);
+            ADD(obj, underline, LV_PART_ITEMS | LV_STATE_FOCUS_KEY);
+            ADD(obj, large_border, LV_PART_ITEMS | LV_STATE_FOCUS_KEY);
+            return;
+        }
+#endif
+#if LV_USE_TABVIEW
+        if(lv_obj_check_type(lv_obj_get_parent(obj), &lv_tabview_class)) {
+            ADD(obj, pad_gap, 0);
+            ADD(obj, card, LV_PART_ITEMS);
+            ADD(obj, pr, LV_PART_ITEMS | LV_STATE_PRESSED);
+            ADD(obj, inv, LV_PART_ITEMS | LV_STATE_CHECKED);
+            ADD(obj, disabled, LV_PART_ITEMS | LV_STATE_DISABLED);
+            ADD(obj, focus, LV_STATE_FOCUS_KEY);
+            ADD(obj, underline, LV_PART_ITEMS | LV_STATE_FOCUS_KEY);
+            ADD(obj, large_border, LV_PART_ITEMS | LV_STATE_FOCUS_KEY);
+            return;
+        }
+#endif
+        ADD(obj, card, 0);
+        ADD(obj, focus, LV_STATE_FOCUS_KEY);
+        ADD(obj, card, LV_PART_ITEMS);
+        ADD(obj, pr, LV_PART_ITEMS | LV_STATE_PRESSED);
+        ADD(obj, inv, LV_PART_ITEMS | LV_STATE_CHECKED);
+        ADD(obj, disabled, LV_PART_ITEMS | LV_STATE_DISABLED);
+        ADD(obj, underline, LV_PART_ITEMS | LV_STATE_FOCUS_KEY);
+        ADD(obj, large_border, LV_PART_ITEMS | LV_STATE_FOCUS_KEY);
+    }
+#endif
+#if LV_USE_BAR
+    else if(lv_obj_check_type(obj, &lv_bar_class)) {
+        ADD(obj, card, 0);
+        ADD(obj, pad_zero, 0);
+        ADD(obj, inv, LV_PART_INDICATOR);
+        ADD(obj, focus, LV_STATE_FOCUS_KEY);
+    }
+#endif
+#if LV_USE_SLIDER
+    else if(lv_obj_check_type(obj, &lv_slider_class)) {
+        ADD(obj, card, 0);
+        ADD(obj, pad_zero, 0);
+        ADD(obj, inv, LV_PART_INDICATOR);
+        ADD(obj, card, LV_PART_KNOB);
+        ADD(obj, radius_circle, LV_PART_KNOB);
+        ADD(obj, focus, LV_STATE_FOCUS_KEY);
+        ADD(obj, edit, LV_STATE_EDITED);
+    }
+#endif
+#if LV_USE_TABLE
+    else if(lv_obj_check_type(obj, &lv_table_class)) {
+        ADD(obj, scrollbar, LV_PART_SCROLLBAR);
+        ADD(obj, card, LV_PART_ITEMS);
+        ADD(obj, no_radius, LV_PART_ITEMS);
+        ADD(obj, pr, LV_PART_ITEMS | LV_STATE_PRESSED);
+        ADD(obj, focus, LV_STATE_FOCUS_KEY);
+        ADD(obj, inv, LV_PART_ITEMS | LV_STATE_FOCUS_KEY);
+        ADD(obj, edit, LV_STATE_EDITED);
+    }
+#endif
+#if LV_USE_CHECKBOX
+    else if(lv_obj_check_type(obj, &lv_checkbox_class)) {
+        ADD(obj, pad_gap, LV_PART_MAIN);
+        ADD(obj, card, LV_PART_INDICATOR);
+        ADD(obj, disabled, LV_PART_INDICATOR | LV_STATE_DISABLED);
+        ADD(obj, inv, LV_PART_INDICATOR | LV_STATE_CHECKED);
+        ADD(obj, pr, LV_PART_INDICATOR | LV_STATE_PRESSED);
+        ADD(obj, focus, LV_STATE_FOCUS_KEY);
+        ADD(obj, edit, LV_STATE_EDITED);
+    }
+#endif
+#if LV_USE_SWITCH
+    else if(lv_obj_check_type(obj, &lv_switch_class)) {
+        ADD(obj, card, 0);
+        ADD(obj, radius_circle, 0);
+        ADD(obj, pad_zero, 0);
+        ADD(obj, inv, LV_PART_INDICATOR);
+        ADD(obj, radius_circle, LV_PART_INDICATOR);
+        ADD(obj, card, LV_PART_KNOB);
+        ADD(obj, radius_circle, LV_PART_KNOB);
+        ADD(obj, pad_zero, LV_PART_KNOB);
+        ADD(obj, focus, LV_STATE_FOCUS_KEY);
+        ADD(obj, edit, LV_STATE_EDITED);
+    }
+#endif
+#if LV_USE_CHART
+    else if(lv_obj_check_type(obj, &lv_chart_class)) {
+        ADD(obj, card, 0);
+        ADD(obj, scrollbar, LV_PART_SCROLLBAR);
+        ADD(obj, card, LV_PART_ITEMS);
+        ADD(obj, card, LV_PART_TICKS);
+        ADD(obj, card, LV_PART_CURSOR);
+        ADD(obj, focus, LV_STATE_FOCUS_KEY);
+    }
+#endif
+#if LV_USE_ROLLER
+    else if(lv_obj_check_type(obj, &lv_roller_class)) {
+        ADD(obj, card, 0);
+        ADD(obj, large_line_space, 0);
+        ADD(obj, inv, LV_PART_SELECTED);
+        ADD(obj, focus, LV_STATE_FOCUS_KEY);
+        ADD(obj, edit, LV_STATE_EDITED);
+    }
+#endif
+#if LV_USE_DROPDOWN
+    else if(lv_obj_check_type(obj, &lv_dropdown_class)) {
+        ADD(obj, card, 0);
+        ADD(obj, pr, LV_STATE_PRESSED);
+        ADD(obj, focus, LV_STATE_FOCUS_KEY);
+        ADD(obj, edit, LV_STATE_EDITED);
+    }
+    else if(lv_obj_check_type(obj, &lv_dropdownlist_class)) {
+        ADD(obj, card, 0);
+        ADD(obj, large_line_space, 0);
+        ADD(obj, scrollbar, LV_PART_SCROLLBAR);
+        ADD(obj, inv, LV_PART_SELECTED | LV_STATE_CHECKED);
+        ADD(obj, pr, LV_PART_SELECTED | LV_STATE_PRESSED);
+        ADD(obj, focus, LV_STATE_FOCUS_KEY);
+        ADD(obj, edit, LV_STATE_EDITED);
+    }
+#endif
+#if LV_USE_ARC
+    else if(lv_obj_check_type(obj, &lv_arc_class)) {
+        ADD(obj, card, 0);
+        ADD(obj, inv, LV_PART_INDICATOR);
+        ADD(obj, pad_zero, LV_PART_INDICATOR);
+        ADD(obj, card, LV_PART_KNOB);
+        ADD(obj, radius_circle, LV_PART_KNOB);
+        ADD(obj, focus, LV_STATE_FOCUS_KEY);
+        ADD(obj, edit, LV_STATE_EDITED);
+    }
+#endif
+#if LV_USE_METER
+    else if(lv_obj_check_type(obj, &lv_meter_class)) {
+        ADD(obj, card, 0);
+    }
+#endif
+#if LV_USE_TEXTAREA
+    else if(lv_obj_check_type(obj, &lv_textarea_class)) {
+        ADD(obj, card, 0);
+        ADD(obj, scrollbar, LV_PART_SCROLLBAR);
+        ADD(obj, ta_cursor, LV_PART_CURSOR | LV_STATE_FOCUSED);
+        ADD(obj, focus, LV_STATE_FOCUSED);
+        ADD(obj, edit, LV_STATE_EDITED);
+    }
+#endif
+#if LV_USE_CALENDAR
+    else if(lv_obj_check_type(obj, &lv_calendar_class)) {
+        ADD(obj, card, 0);
+        ADD(obj, no_radius, 0);
+        ADD(obj, pr, LV_PART_ITEMS | LV_STATE_PRESSED);
+        ADD(obj, disabled, LV_PART_ITEMS | LV_STATE_DISABLED);
+        ADD(obj, focus, LV_STATE_FOCUS_KEY);
+        ADD(obj, edit, LV_STATE_EDITED);
+        ADD(obj, large_border, LV_PART_ITEMS | LV_STATE_FOCUS_KEY);
+    }
+#endif
+#if LV_USE_KEYBOARD
+    else if(lv_obj_check_type(obj, &lv_keyboard_class)) {
+        ADD(obj, card, 0);
+        ADD(obj, card, LV_PART_ITEMS);
+        ADD(obj, pr, LV_PART_ITEMS | LV_STATE_PRESSED);
+        ADD(obj, inv, LV_PART_ITEMS | LV_STATE_CHECKED);
+        ADD(obj, focus, LV_STATE_FOCUS_KEY);
+        ADD(obj, edit, LV_STATE_EDITED);
+        ADD(obj, large_border, LV_PART_ITEMS | LV_STATE_EDITED);
+    }
+#endif
+#if LV_USE_LIST
+    else if(lv_obj_check_type(obj, &lv_list_class)) {
+        ADD(obj, card, 0);
+        ADD(obj, scrollbar, LV_PART_SCROLLBAR);
+        return;
+    }
+    else if(lv_obj_check_type(obj, &lv_list_text_class)) {
+    }
+    else if(lv_obj_check_type(obj, &lv_list_btn_class)) {
+        ADD(obj, card, 0);
+        ADD(obj, pr, LV_STATE_PRESSED);
+        ADD(obj, focus, LV_STATE_FOCUS_KEY);
+        ADD(obj, large_border, LV_STATE_EDITED);
+    }
+#endif
+#if LV_USE_MSGBOX
+    else if(lv_obj_check_type(obj, &lv_msgbox_class)) {
+        ADD(obj, card, 0);
+        return;
+    }
+#endif
+#if LV_USE_SPINBOX
+    else if(lv_obj_check_type(obj, &lv_spinbox_class)) {
+        ADD(obj, card, 0);
+        ADD(obj, inv, LV_PART_CURSOR);
+        ADD(obj, focus, LV_STATE_FOCUS_KEY);
+        ADD(obj, edit, LV_STATE_EDITED);
+    }
+#endif
+#if LV_USE_TILEVIEW
+    else if(lv_obj_check_type(obj, &lv_tileview_class)) {
+        ADD(obj, scr, 0);
+        ADD(obj, scrollbar, LV_PART_SCROLLBAR);
+    }
+    else if(lv_obj_check_type(obj, &lv_tileview_tile_class)) {
+        ADD(obj, scrollbar, LV_PART_SCROLLBAR);
+    }
+#endif
+#if LV_USE_LED
+    else if(lv_obj_check_type(obj, &lv_led_class)) {
+        ADD(obj, card, 0);
+    }
+#endif
+}
+
+/*********************************************************************************
+ *                              GLOBAL FUNCTION
+ *********************************************************************************/
+lv_theme_t *ui_theme_mono_init(lv_disp_t *disp)
+{
+    theme.disp = disp;
+    theme.font_small = LV_FONT_DEFAULT;
+    theme.font_normal = LV_FONT_DEFAULT;
+    theme.font_large = LV_FONT_DEFAULT;
+    theme.apply_cb = theme_apply;
+
+    if(disp == NULL || lv_disp_get_theme(disp) == &theme)
+        lv_obj_report_style_change(NULL);
+
+    return &theme;
+}
@@ -0,0 +1,49 @@
+#ifndef __UI_THEME_H__
+#define __UI_THEME_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "lvgl.h"
+
+/*
+ * Monochrome theme and the screens' shared styles as constant styles.
+ * Every style here is an LV_STYLE_CONST_INIT table in .rodata: nothing is
+ * built at boot, nothing lives in the LVGL heap, and an object holds one
+ * pointer per style instead of a local style of its own. A property is
+ * found by a linear walk of a few const entries, where the local styles
+ * these replace were allocated per object and searched before the theme's.
+ *
+ * The theme is lv_theme_mono on a light background with the same styles
+ * per widget class. The app styles are added after the theme's, so they
+ * win over it; an object's local styles still win over both.
+ *
+ * Apply with UI_STYLE(obj, ui_style_x, selector). The cast drops the
+ * const: LVGL only reads a const style and never writes to it.
+ */
+#define UI_STYLE(obj, style, selector)  lv_obj_add_style((obj), (lv_style_t *)&(style), (selector))
+
+/*********************************************************************************
+ *                              GLOBAL PROTOTYPES
+ * *******************************************************************************/
+lv_theme_t *ui_theme_mono_init(lv_disp_t *disp);
+
+extern const lv_style_t ui_style_back_btn;      /* Borderless back arrow */
+extern const lv_style_t ui_style_title;         /* Mono 15, next to the back arrow */
+extern const lv_style_t ui_style_list;          /* Settings lists: no frame, rows 15 apart */
+extern const lv_style_t ui_style_list_item;     /* Their rounded buttons */
+extern const lv_style_t ui_style_list_item_pr;  /* ... while pressed */
+extern const lv_style_t ui_style_info_cont;     /* Reading pages: rows 5 apart, no frame */
+extern const lv_style_t ui_style_info_row;      /* Their Mono 15 lines, underlined */
+extern const lv_style_t ui_style_text;          /* Plain Mono 15 lines */
+extern const lv_style_t ui_style_taskbar;
+extern const lv_style_t ui_style_taskbar_status;
+extern const lv_style_t ui_style_breadcrumb;
+extern const lv_style_t ui_style_breadcrumb_pr;
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*__UI_THEME_H__*/
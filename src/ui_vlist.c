@@ -0,0 +1,222 @@
+
+#include "ui_vlist.h"
+
+typedef struct ui_vlist {
+    lv_obj_t *spacer;                       /* Sized to count * row_h so the list scrolls the full range */
+    lv_obj_t *rows[UI_VLIST_ROW_MAX];
+    int32_t bound[UI_VLIST_ROW_MAX];        /* Data index bound to each row, -1 when unused */
+    uint8_t row_cnt;
+    lv_coord_t row_h;
+    uint32_t count;
+    ui_vlist_row_cb_t create_row;
+    ui_vlist_bind_cb_t bind;
+    void *user_data;
+} ui_vlist_t;
+
+/*********************************************************************************
+ *                              STATIC FUNCTION
+ *********************************************************************************/
+static ui_vlist_t *ui_vlist_get(lv_obj_t *list)
+{
+    return (list != NULL) ? (ui_vlist_t *)lv_obj_get_user_data(list) : NULL;
+}
+
+static lv_obj_t *ui_vlist_default_row(lv_obj_t *list, void *user_data)
+{
+    lv_obj_t *label = lv_label_create(list);
+    lv_label_set_long_mode(label, LV_LABEL_LONG_CLIP);
+    return label;
+}
+
+static lv_coord_t ui_vlist_visible_h(lv_obj_t *list)
+{
+    lv_obj_update_layout(list);
+    return lv_obj_get_content_height(list);
+}
+
+static bool ui_vlist_grow_pool(lv_obj_t *list) // 行对象按可见高度按需创建
+{
+    ui_vlist_t *vl = ui_vlist_get(list);
+    uint32_t need = (lv_obj_get_content_height(list) + vl->row_h - 1) / vl->row_h + 1;
+
+    if(need > UI_VLIST_ROW_MAX)
+        need = UI_VLIST_ROW_MAX;
+    if(need <= vl->row_cnt)
+        return false;
+
+    for(uint8_t i = vl->row_cnt; i < need; i++){
+        vl->rows[i] = vl->create_row(list, vl->user_data);
+        lv_obj_set_size(vl->rows[i], lv_pct(100), vl->row_h);
+        lv_obj_add_flag(vl->rows[i], LV_OBJ_FLAG_HIDDEN);
+    }
+    vl->row_cnt = need;
+    return true;
+}
+
+static void ui_vlist_bind_rows(lv_obj_t *list, bool force) // 按滚动位置把行对象绑定到数据
+{
+    ui_vlist_t *vl = ui_vlist_get(list);
+    lv_coord_t scroll_y = lv_obj_get_scroll_y(list);
+    uint32_t first = (scroll_y > 0) ? (uint32_t)(scroll_y / vl->row_h) : 0;
+
+    // A bigger pool changes the slot mapping, so every row is rebound
+    if(ui_vlist_grow_pool(list)){
+        for(uint8_t i = 0; i < vl->row_cnt; i++)
+            vl->bound[i] = -1;
+    }
+
+    // Index i always lands in slot i % row_cnt, so scrolling one row rebinds one object
+    for(uint32_t i = first; i < first + vl->row_cnt; i++){
+        uint8_t slot = i % vl->row_cnt;
+        lv_obj_t *row = vl->rows[slot];
+
+        if(i >= vl->count){
+            lv_obj_add_flag(row, LV_OBJ_FLAG_HIDDEN);
+            vl->bound[slot] = -1;
+            continue;
+        }
+        if(force || vl->bound[slot] != (int32_t)i){
+            lv_obj_set_y(row, (lv_coord_t)(i * vl->row_h));
+            vl->bind(row, i, vl->user_data);
+            vl->bound[slot] = i;
+        }
+        lv_obj_clear_flag(row, LV_OBJ_FLAG_HIDDEN);
+    }
+}
+
+static void ui_vlist_event_cb(lv_event_t *e)
+{
+    lv_obj_t *list = lv_event_get_target(e);
+
+    if(e->code == LV_EVENT_SCROLL || e->code == LV_EVENT_SIZE_CHANGED){
+        ui_vlist_bind_rows(list, false);
+    } else if(e->code == LV_EVENT_DELETE){
+        lv_mem_free(ui_vlist_get(list));
+        lv_obj_set_user_data(list, NULL);
+    }
+}
+
+/*********************************************************************************
+ *                              GLOBAL FUNCTION
+ *********************************************************************************/
+lv_obj_t *ui_vlist_create(lv_obj_t *parent, lv_coord_t w, lv_coord_t h, lv_coord_t row_h,
+                          ui_vlist_row_cb_t create_row, ui_vlist_bind_cb_t bind, void *user_data)
+{
+    ui_vlist_t *vl = lv_mem_alloc(sizeof(ui_vlist_t));
+    if(vl == NULL)
+        return NULL;
+    lv_memset_00(vl, sizeof(ui_vlist_t));
+
+    lv_obj_t *list = lv_obj_create(parent);
+    lv_obj_set_size(list, w, h);
+    lv_obj_set_scrollbar_mode(list, LV_SCROLLBAR_MODE_OFF);
+    lv_obj_set_scroll_dir(list, LV_DIR_VER);
+    // Kinetic scrolling would mean a panel refresh per animation step
+    lv_obj_clear_flag(list, LV_OBJ_FLAG_SCROLL_ELASTIC | LV_OBJ_FLAG_SCROLL_MOMENTUM);
+    lv_obj_set_user_data(list, vl);
+
+    vl->row_h = (row_h > 0) ? row_h : 1;
+    vl->create_row = (create_row != NULL) ? create_row : ui_vlist_default_row;
+    vl->bind = bind;
+    vl->user_data = user_data;
+
+    vl->spacer = lv_obj_create(list);
+    lv_obj_remove_style_all(vl->spacer);
+    lv_obj_clear_flag(vl->spacer, LV_OBJ_FLAG_CLICKABLE);
+    lv_obj_set_size(vl->spacer, 1, 0);
+
+    // Rows are created once the layout gives the list its height
+    lv_obj_add_event_cb(list, ui_vlist_event_cb, LV_EVENT_SCROLL, NULL);
+    lv_obj_add_event_cb(list, ui_vlist_event_cb, LV_EVENT_SIZE_CHANGED, NULL);
+    lv_obj_add_event_cb(list, ui_vlist_event_cb, LV_EVENT_DELETE, NULL);
+    return list;
+}
+
+void ui_vlist_set_count(lv_obj_t *list, uint32_t count)
+{
+    ui_vlist_t *vl = ui_vlist_get(list);
+    if(vl == NULL)
+        return;
+
+    // The spacer height is an lv_coord_t
+    uint32_t max = LV_COORD_MAX / vl->row_h;
+    vl->count = (count > max) ? max : count;
+    lv_obj_set_height(vl->spacer, (lv_coord_t)(vl->count * vl->row_h));
+
+    // Keep the scroll position inside the new range
+    lv_obj_scroll_by_bounded(list, 0, 0, LV_ANIM_OFF);
+    ui_vlist_bind_rows(list, true);
+}
+
+uint32_t ui_vlist_get_count(lv_obj_t *list)
+{
+    ui_vlist_t *vl = ui_vlist_get(list);
+    return (vl != NULL) ? vl->count : 0;
+}
+
+void ui_vlist_refresh(lv_obj_t *list)
+{
+    if(ui_vlist_get(list) != NULL)
+        ui_vlist_bind_rows(list, true);
+}
+
+void ui_vlist_scroll_to(lv_obj_t *list, uint32_t index)
+{
+    ui_vlist_t *vl = ui_vlist_get(list);
+    if(vl == NULL)
+        return;
+
+    lv_obj_scroll_to_y(list, (lv_coord_t)(index * vl->row_h), LV_ANIM_OFF);
+    ui_vlist_bind_rows(list, false);
+}
+
+void ui_vlist_page(lv_obj_t *list, int dir)
+{
+    ui_vlist_t *vl = ui_vlist_get(list);
+    uint32_t page, pages;
+    if(vl == NULL)
+        return;
+
+    ui_vlist_get_page(list, &page, &pages);
+    if(dir > 0)
+        page = (page + 1 < pages) ? page + 1 : 0;
+    else if(dir < 0)
+        page = (page > 0) ? page - 1 : pages - 1;
+
+    uint32_t per_page = ui_vlist_visible_h(list) / vl->row_h;
+    ui_vlist_scroll_to(list, page * (per_page > 0 ? per_page : 1));
+}
+
+int32_t ui_vlist_get_index(lv_obj_t *row)
+{
+    ui_vlist_t *vl = ui_vlist_get(lv_obj_get_parent(row));
+    if(vl == NULL)
+        return -1;
+
+    for(uint8_t i = 0; i < vl->row_cnt; i++){
+        if(vl->rows[i] == row)
+            return vl->bound[i];
+    }
+    return -1;
+}
+
+void ui_vlist_get_page(lv_obj_t *list, uint32_t *page, uint32_t *pages)
+{
+    ui_vlist_t *vl = ui_vlist_get(list);
+    uint32_t per_page = 1;
+    uint32_t first = 0;
+
+    if(vl != NULL){
+        lv_coord_t scroll_y = lv_obj_get_scroll_y(list);
+        per_page = ui_vlist_visible_h(list) / vl->row_h;
+        if(per_page == 0)
+            per_page = 1;
+        first = (scroll_y > 0) ? (uint32_t)(scroll_y + vl->row_h - 1) / vl->row_h : 0;
+    }
+
+    uint32_t count = (vl != NULL) ? vl->count : 0;
+    if(page != NULL)
+        *page = (first + per_page - 1) / per_page;
+    if(pages != NULL)
+        *pages = (count > 0) ? (count + per_page - 1) / per_page : 1;
+}
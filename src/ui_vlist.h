@@ -0,0 +1,38 @@
+#ifndef __UI_VLIST_H__
+#define __UI_VLIST_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "lvgl.h"
+
+/*
+ * Recycling list: only the rows that fit on screen exist as LVGL objects.
+ * Scrolling or paging rebinds those rows to new data indexes through the
+ * bind callback, so the list can show hundreds of entries.
+ */
+#define UI_VLIST_ROW_MAX    24   /* Row objects per list, ceil(height / row_h) + 1 are created */
+
+typedef lv_obj_t *(*ui_vlist_row_cb_t)(lv_obj_t *list, void *user_data);
+typedef void (*ui_vlist_bind_cb_t)(lv_obj_t *row, uint32_t index, void *user_data);
+
+/*********************************************************************************
+ *                              GLOBAL PROTOTYPES
+ * *******************************************************************************/
+// create_row may be NULL for plain single-line label rows
+lv_obj_t *ui_vlist_create(lv_obj_t *parent, lv_coord_t w, lv_coord_t h, lv_coord_t row_h,
+                          ui_vlist_row_cb_t create_row, ui_vlist_bind_cb_t bind, void *user_data);
+void ui_vlist_set_count(lv_obj_t *list, uint32_t count);
+uint32_t ui_vlist_get_count(lv_obj_t *list);
+void ui_vlist_refresh(lv_obj_t *list);                  // rebind visible rows after the data changed
+void ui_vlist_scroll_to(lv_obj_t *list, uint32_t index);
+void ui_vlist_page(lv_obj_t *list, int dir);            // dir > 0 next page, < 0 previous, wraps
+int32_t ui_vlist_get_index(lv_obj_t *row);              // data index bound to a row, -1 if none
+void ui_vlist_get_page(lv_obj_t *list, uint32_t *page, uint32_t *pages);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*__UI_VLIST_H__*/
@@ -0,0 +1,457 @@
+/**
+ * @file      usb_console.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Framed binary console on the USB serial port: logs, metrics, RPC and passthrough channels
+ */
+
+#include "usb_console.h"
+#include <esp_rom_crc.h>
+#include "simple_logger.h"
+#include "metrics.h"
+#include "task_watch.h"
+#include "job_pool.h"
+#include "coro_sched.h"
+#include "boot_trace.h"
+#include "task_arena.h"
+#include "cpu_profiler.h"
+#include "mem_trace.h"
+
+#ifdef INTEGRATION_LAYER_ENABLED
+#include "integration/config_manager.h"
+#endif
+
+#define CONSOLE_RING_MASK   (USB_CONSOLE_TX_RING - 1)
+#define CONSOLE_RX_MAX      (1 + USB_CONSOLE_FRAME_MAX + 2 + (USB_CONSOLE_FRAME_MAX + 3) / 254 + 1)
+#define CONSOLE_ALWAYS_OPEN ((1 << USB_CONSOLE_CH_CTRL) | (1 << USB_CONSOLE_CH_RPC))
+
+static_assert((USB_CONSOLE_TX_RING & CONSOLE_RING_MASK) == 0, "ring size must be a power of two");
+
+struct ConsoleRpc {
+    const char *name;
+    usb_console_rpc_fn fn;
+};
+
+// Producers write past tx_head under tx_lock; only the task moves tx_tail
+static SemaphoreHandle_t tx_lock = NULL;
+static uint8_t tx_ring[USB_CONSOLE_TX_RING];
+static volatile uint32_t tx_head = 0;
+static volatile uint32_t tx_tail = 0;
+
+static TaskHandle_t console_task = NULL;
+static volatile bool console_host = false;
+static volatile uint16_t console_open = 0;
+static uint32_t console_hello_at = 0;
+static UsbConsoleStats console_stats;
+
+static uint8_t rx_buf[CONSOLE_RX_MAX];
+static size_t rx_len = 0;
+static bool rx_overrun = false;
+
+static usb_console_handler handlers[USB_CONSOLE_CHANNELS];
+static void *handler_ctx[USB_CONSOLE_CHANNELS];
+static ConsoleRpc rpcs[USB_CONSOLE_RPC_MAX];
+static uint8_t rpc_count = 0;
+
+// ===== Transmit =====
+
+struct CobsOut {
+    uint32_t pos;
+    uint32_t code_at;
+    uint8_t code;
+};
+
+static inline void ring_put(uint32_t at, uint8_t b) {
+    tx_ring[at & CONSOLE_RING_MASK] = b;
+}
+
+// COBS: each code byte counts the bytes up to the next zero
+static void cobs_put(CobsOut *c, uint8_t b) {
+    if (b) {
+        ring_put(c->pos++, b);
+        c->code++;
+    }
+    if (!b || c->code == 0xFF) {
+        ring_put(c->code_at, c->code);
+        c->code_at = c->pos++;
+        c->code = 1;
+    }
+}
+
+static void cobs_put(CobsOut *c, const uint8_t *p, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        cobs_put(c, p[i]);
+    }
+}
+
+// Hands the ring to the driver as it lies, in at most two runs. Console task
+static bool flush_tx() {
+    bool moved = false;
+    while (true) {
+        uint32_t tail = tx_tail;
+        uint32_t pending = tx_head - tail;
+        if (!pending) {
+            break;
+        }
+        uint32_t off = tail & CONSOLE_RING_MASK;
+        uint32_t run = min(pending, (uint32_t)USB_CONSOLE_TX_RING - off);
+        size_t n = Serial.write(tx_ring + off, run);
+        if (!n) {
+            break;          // Host not reading; the next poll tries again
+        }
+        tx_tail = tail + n;
+        console_stats.bytes_out += n;
+        moved = true;
+    }
+    return moved;
+}
+
+// ===== Logger and metrics sinks =====
+
+static void log_sink(const uint8_t *record, size_t len) {
+    usb_console_send(USB_CONSOLE_CH_LOG, record, len);
+}
+
+// Text log while nobody reads frames, packed records to the host once it does
+static void set_open(uint16_t mask) {
+    uint16_t was = console_open;
+    console_open = mask;
+    console_stats.open = mask;
+    bool log = mask & (1 << USB_CONSOLE_CH_LOG);
+    if (Logger && log != (bool)(was & (1 << USB_CONSOLE_CH_LOG))) {
+        Logger->setSerialSink(log ? log_sink : NULL);
+    }
+}
+
+static void close_all() {
+    console_host = false;
+    console_stats.host = false;
+    set_open(0);
+}
+
+// ===== RPC =====
+
+// An answer split into frames as it is written
+class RpcOut : public Print {
+public:
+    RpcOut(uint8_t id) : id(id), len(0) {}
+
+    size_t write(uint8_t c) override {
+        if (len == sizeof(buf)) {
+            send(USB_CONSOLE_RPC_MORE);
+        }
+        buf[len++] = c;
+        return 1;
+    }
+
+    size_t write(const uint8_t *p, size_t n) override {
+        for (size_t i = 0; i < n; i++) {
+            write(p[i]);
+        }
+        return n;
+    }
+
+    // Waits for room by draining the ring itself: it runs on the task
+    void send(uint8_t status) {
+        uint8_t head[2] = { id, status };
+        while (!usb_console_send(USB_CONSOLE_CH_RPC, head, sizeof(head), buf, len) && console_host) {
+            if (!flush_tx()) {
+                vTaskDelay(pdMS_TO_TICKS(USB_CONSOLE_POLL_MS));
+            }
+        }
+        len = 0;
+    }
+
+private:
+    uint8_t id;
+    size_t len;
+    uint8_t buf[USB_CONSOLE_FRAME_MAX - 2];
+};
+
+static void rpc_help(Print &out, const char *args) {
+    for (uint8_t i = 0; i < rpc_count; i++) {
+        out.println(rpcs[i].name);
+    }
+}
+
+static void rpc_stats(Print &out, const char *args) {
+    out.printf("frames out %lu (%lu bytes, %lu dropped), in %lu (%lu rejected), rpc %lu, ring peak %u\n",
+               (unsigned long)console_stats.frames_out, (unsigned long)console_stats.bytes_out,
+               (unsigned long)console_stats.dropped, (unsigned long)console_stats.frames_in,
+               (unsigned long)console_stats.rejected, (unsigned long)console_stats.rpc_calls,
+               console_stats.ring_peak);
+}
+
+// "log <level>" or "log <component> <level>", levels 0 DEBUG to 3 ERROR
+static void rpc_log(Print &out, const char *args) {
+    char component[SLOG_COMPONENT_NAME_LEN];
+    int level;
+    if (sscanf(args, "%23s %d", component, &level) == 2 && level >= LOG_DEBUG && level <= LOG_ERROR) {
+        Logger->setComponentLevel(component, (LogLevel)level);
+    } else if (sscanf(args, "%d", &level) == 1 && level >= LOG_DEBUG && level <= LOG_ERROR) {
+        Logger->setLogLevel((LogLevel)level);
+    } else {
+        out.println("usage: log [component] 0-3");
+        return;
+    }
+    out.println("ok");
+}
+
+static void rpc_boot(Print &out, const char *args) { boot_trace_print(out, !strcmp(args, "previous")); }
+static void rpc_mem(Print &out, const char *args) { mem_trace_print(out, !strcmp(args, "ring")); }
+static void rpc_metrics(Print &out, const char *args) { metrics_print(out); }
+static void rpc_tasks(Print &out, const char *args) { task_watch_print(out); }
+static void rpc_jobs(Print &out, const char *args) { job_pool_print(out); }
+static void rpc_coro(Print &out, const char *args) { coro_print(out); }
+static void rpc_arena(Print &out, const char *args) { task_arena_print(out); }
+static void rpc_cpu(Print &out, const char *args) { cpu_profiler_print(out); }
+
+static void run_rpc(const uint8_t *data, size_t len) {
+    if (len < 2) {
+        console_stats.rejected++;
+        return;
+    }
+    char line[USB_CONSOLE_FRAME_MAX];
+    size_t n = min(len - 1, sizeof(line) - 1);
+    memcpy(line, data + 1, n);
+    line[n] = '\0';
+    char *args = strchr(line, ' ');
+    if (args) {
+        *args++ = '\0';
+    } else {
+        args = line + n;
+    }
+
+    RpcOut out(data[0]);
+    console_stats.rpc_calls++;
+    for (uint8_t i = 0; i < rpc_count; i++) {
+        if (!strcmp(rpcs[i].name, line)) {
+            rpcs[i].fn(out, args);
+            out.send(USB_CONSOLE_RPC_OK);
+            return;
+        }
+    }
+    out.send(USB_CONSOLE_RPC_UNKNOWN);
+}
+
+// ===== Receive =====
+
+static void handle_ctrl(const uint8_t *data, size_t len) {
+    if (len >= 3 && data[0] == 'H') {
+        bool fresh = !console_host;
+        console_host = true;
+        console_stats.host = true;
+        console_hello_at = millis();
+        set_open((data[1] | data[2] << 8) | CONSOLE_ALWAYS_OPEN);
+        if (fresh) {
+            uint8_t reply[] = { 'H', USB_CONSOLE_VERSION, USB_CONSOLE_CHANNELS,
+                                USB_CONSOLE_FRAME_MAX & 0xFF, USB_CONSOLE_FRAME_MAX >> 8 };
+            usb_console_send(USB_CONSOLE_CH_CTRL, reply, sizeof(reply));
+        }
+    } else if (len >= 1 && data[0] == 'B') {
+        close_all();
+    } else {
+        console_stats.rejected++;
+    }
+}
+
+// One frame, without its delimiter: undo COBS in place, check, dispatch
+static void handle_frame(uint8_t *buf, size_t len) {
+    size_t o = 0;
+    for (size_t i = 0; i < len;) {
+        uint8_t code = buf[i++];
+        if (!code || i + code - 1 > len) {
+            console_stats.rejected++;
+            return;
+        }
+        for (uint8_t k = 1; k < code; k++) {
+            buf[o++] = buf[i++];
+        }
+        if (code < 0xFF && i < len) {
+            buf[o++] = 0;
+        }
+    }
+    if (o < 3) {
+        console_stats.rejected++;
+        return;
+    }
+    o -= 2;
+    if (esp_rom_crc16_le(0, buf, o) != (buf[o] | buf[o + 1] << 8) || buf[0] >= USB_CONSOLE_CHANNELS) {
+        console_stats.rejected++;
+        return;
+    }
+    console_stats.frames_in++;
+
+    uint8_t channel = buf[0];
+    if (channel == USB_CONSOLE_CH_CTRL) {
+        handle_ctrl(buf + 1, o - 1);
+    } else if (!console_host) {
+        console_stats.rejected++;   // Hello first
+    } else if (channel == USB_CONSOLE_CH_RPC) {
+        run_rpc(buf + 1, o - 1);
+    } else if (handlers[channel]) {
+        handlers[channel](buf + 1, o - 1, handler_ctx[channel]);
+    }
+}
+
+static void poll_rx() {
+    uint8_t chunk[64];
+    int avail;
+    while ((avail = Serial.available()) > 0) {
+        size_t n = Serial.read(chunk, min((size_t)avail, sizeof(chunk)));
+        for (size_t i = 0; i < n; i++) {
+            uint8_t b = chunk[i];
+            if (b) {
+                if (rx_len < sizeof(rx_buf)) {
+                    rx_buf[rx_len++] = b;
+                } else {
+                    rx_overrun = true;
+                }
+                continue;
+            }
+            if (rx_len && !rx_overrun) {
+                handle_frame(rx_buf, rx_len);
+            } else if (rx_overrun) {
+                console_stats.rejected++;
+            }
+            rx_len = 0;
+            rx_overrun = false;
+        }
+    }
+}
+
+// ===== Task =====
+
+static void console_task_fn(void *param) {
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(USB_CONSOLE_POLL_MS));
+        poll_rx();
+        if (console_host && millis() - console_hello_at > USB_CONSOLE_IDLE_MS) {
+            close_all();
+            LOG_INFO("Console", "Host gone, back to the text log");
+        }
+        flush_tx();
+    }
+}
+
+// ===== API =====
+
+bool usb_console_begin() {
+    if (console_task) {
+        return true;
+    }
+#ifdef INTEGRATION_LAYER_ENABLED
+    if (!GET_CONFIG_BOOL("console", "enabled", true)) {
+        return false;
+    }
+#endif
+    tx_lock = xSemaphoreCreateMutex();
+    if (!tx_lock) {
+        LOG_ERROR("Console", "Failed to create the ring lock");
+        return false;
+    }
+    usb_console_rpc("help", rpc_help);
+    usb_console_rpc("stats", rpc_stats);
+    usb_console_rpc("log", rpc_log);
+    usb_console_rpc("metrics", rpc_metrics);
+    usb_console_rpc("tasks", rpc_tasks);
+    usb_console_rpc("jobs", rpc_jobs);
+    usb_console_rpc("coro", rpc_coro);
+    usb_console_rpc("boot", rpc_boot);
+    usb_console_rpc("arena", rpc_arena);
+    usb_console_rpc("cpu", rpc_cpu);
+    usb_console_rpc("mem", rpc_mem);
+    if (xTaskCreate(console_task_fn, "console", USB_CONSOLE_TASK_STACK, NULL, USB_CONSOLE_TASK_PRIORITY,
+                    &console_task) != pdPASS) {
+        LOG_ERROR("Console", "Failed to start the task");
+        return false;
+    }
+    LOG_INFO("Console", "Framed console on USB, waiting for a host");
+    return true;
+}
+
+bool usb_console_wants(uint8_t channel) {
+    return console_host && channel < USB_CONSOLE_CHANNELS && (console_open & (1 << channel));
+}
+
+bool usb_console_send(uint8_t channel, const void *a, size_t alen, const void *b, size_t blen) {
+    size_t len = 1 + alen + blen;
+    if (!usb_console_wants(channel) || len > 1 + USB_CONSOLE_FRAME_MAX) {
+        return false;
+    }
+    // Delimiter, codes, the CRC and the delimiter after
+    uint32_t need = 1 + len + 2 + (len + 2) / 254 + 1 + 1;
+
+    xSemaphoreTake(tx_lock, portMAX_DELAY);
+    uint32_t used = tx_head - tx_tail;
+    if (USB_CONSOLE_TX_RING - used < need) {
+        console_stats.dropped++;
+        xSemaphoreGive(tx_lock);
+        return false;
+    }
+    uint8_t ch = channel;
+    uint16_t crc = esp_rom_crc16_le(0, &ch, 1);
+    crc = esp_rom_crc16_le(crc, (const uint8_t *)a, alen);
+    crc = esp_rom_crc16_le(crc, (const uint8_t *)b, blen);
+    uint8_t tail[2] = { (uint8_t)(crc & 0xFF), (uint8_t)(crc >> 8) };
+
+    // The leading zero ends any text written to the port since the last frame
+    ring_put(tx_head, 0);
+    CobsOut c = { tx_head + 2, tx_head + 1, 1 };
+    cobs_put(&c, ch);
+    cobs_put(&c, (const uint8_t *)a, alen);
+    cobs_put(&c, (const uint8_t *)b, blen);
+    cobs_put(&c, tail, sizeof(tail));
+    ring_put(c.code_at, c.code);
+    ring_put(c.pos++, 0);
+    tx_head = c.pos;
+
+    used = tx_head - tx_tail;
+    if (used > console_stats.ring_peak) {
+        console_stats.ring_peak = used;
+    }
+    console_stats.frames_out++;
+    xSemaphoreGive(tx_lock);
+
+    if (console_task && xTaskGetCurrentTaskHandle() != console_task) {
+        xTaskNotifyGive(console_task);
+    }
+    return true;
+}
+
+bool usb_console_on(uint8_t channel, usb_console_handler handler, void *ctx) {
+    if (channel <= USB_CONSOLE_CH_RPC || channel >= USB_CONSOLE_CHANNELS) {
+        return false;
+    }
+    handlers[channel] = NULL;
+    handler_ctx[channel] = ctx;
+    handlers[channel] = handler;
+    return true;
+}
+
+bool usb_console_rpc(const char *name, usb_console_rpc_fn fn) {
+    for (uint8_t i = 0; i < rpc_count; i++) {
+        if (!strcmp(rpcs[i].name, name)) {
+            rpcs[i].fn = fn;
+            return true;
+        }
+    }
+    if (rpc_count >= USB_CONSOLE_RPC_MAX) {
+        LOG_WARNF("Console", "No room for RPC %s", name);
+        return false;
+    }
+    rpcs[rpc_count].name = name;
+    rpcs[rpc_count].fn = fn;
+    rpc_count++;
+    return true;
+}
+
+bool usb_console_running() {
+    return console_task != NULL;
+}
+
+void usb_console_get_stats(UsbConsoleStats *stats) {
+    *stats = console_stats;
+}
@@ -0,0 +1,115 @@
+/**
+ * @file      usb_console.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Framed binary console on the USB serial port: logs, metrics, RPC and passthrough channels
+ */
+
+#ifndef USB_CONSOLE_H
+#define USB_CONSOLE_H
+
+#include <Arduino.h>
+
+/**
+ * One port, several streams. Every message is a frame: channel byte,
+ * payload, CRC-16/X-25 of both (little-endian), COBS coded and ended by a
+ * 0x00, so a frame never holds a zero and a reader joins mid-stream at the
+ * next one. Text that still reaches the port between frames fails its CRC
+ * and is dropped by the host (script/console.py).
+ *
+ * The port stays a plain text log until the host says hello. After that
+ * the host opens the channels it wants, and the firmware sends only those:
+ * logs go out as the packed binary records of simple_logger.h rather than
+ * formatted text, metrics as the MetricsSnapshot struct. The host repeats
+ * its hello at least every USB_CONSOLE_IDLE_MS; when it stops, the
+ * channels close and the text log comes back.
+ *
+ * Senders encode straight into the transmit ring under its lock; the task
+ * hands contiguous runs of the ring to the USB driver, so a payload is
+ * copied once. A frame that does not fit is dropped and counted: nothing
+ * that logs ever waits on the host. Handlers for received frames run on
+ * the console task.
+ *
+ * Control frames (channel 0), first byte the type:
+ *   'H' (in)  hello, channel mask u16: open those channels
+ *   'H' (out) version, channel count, frame max u16
+ *   'B' (in)  bye: close everything now
+ * RPC frames (channel 1): id, then the command line ("tasks", "log GPS 0");
+ * answered with id, status, text. A long answer comes in several frames,
+ * all but the last with status USB_CONSOLE_RPC_MORE.
+ */
+
+#define USB_CONSOLE_TX_RING         8192    // Power of two
+#define USB_CONSOLE_FRAME_MAX       500     // Payload, either way
+#define USB_CONSOLE_POLL_MS         20      // Receive poll; USB CDC has no event to wait on
+#define USB_CONSOLE_IDLE_MS         5000    // No hello this long: back to text
+#define USB_CONSOLE_RPC_MAX         32
+#define USB_CONSOLE_TASK_STACK      (1024 * 4)
+#define USB_CONSOLE_TASK_PRIORITY   (tskIDLE_PRIORITY + 1)
+#define USB_CONSOLE_VERSION         1
+
+enum UsbConsoleChannel {
+    USB_CONSOLE_CH_CTRL = 0,
+    USB_CONSOLE_CH_RPC,
+    USB_CONSOLE_CH_LOG,             // simple_logger records
+    USB_CONSOLE_CH_METRICS,         // MetricsSnapshot, at metrics.export_ms
+    USB_CONSOLE_CH_GPS,             // Raw receiver bytes, both ways
+    USB_CONSOLE_CH_MODEM,           // AT lines: commands in, every line off the modem out
+    USB_CONSOLE_CH_MIRROR,          // screen_mirror messages
+    USB_CONSOLE_CHANNELS,
+};
+
+enum UsbConsoleRpcStatus {
+    USB_CONSOLE_RPC_OK = 0,
+    USB_CONSOLE_RPC_MORE,
+    USB_CONSOLE_RPC_UNKNOWN,
+};
+
+struct UsbConsoleStats {
+    bool host;                      // Hello seen, not timed out
+    uint16_t open;                  // Channel mask
+    uint32_t frames_out;
+    uint32_t bytes_out;             // On the wire
+    uint32_t dropped;               // Frames the ring had no room for
+    uint32_t frames_in;
+    uint32_t rejected;              // Bad CRC, bad COBS, or too long
+    uint32_t rpc_calls;
+    uint16_t ring_peak;             // Most bytes waiting at once
+};
+
+typedef void (*usb_console_handler)(const uint8_t *data, size_t len, void *ctx);
+typedef void (*usb_console_rpc_fn)(Print &out, const char *args);
+
+/**
+ * @brief Take over the USB serial port's input and start the task. Safe to
+ *        call again
+ */
+bool usb_console_begin();
+
+/**
+ * @brief The host has this channel open. Cheap: test before building a payload
+ */
+bool usb_console_wants(uint8_t channel);
+
+/**
+ * @brief Frame a and b (either may be empty) as one message on channel
+ * @return false when the channel is closed or the ring is full
+ */
+bool usb_console_send(uint8_t channel, const void *a, size_t alen, const void *b = NULL, size_t blen = 0);
+
+/**
+ * @brief Frames received on channel; one handler per channel
+ */
+bool usb_console_on(uint8_t channel, usb_console_handler handler, void *ctx = NULL);
+
+/**
+ * @brief An RPC command; the function writes its answer to out
+ */
+bool usb_console_rpc(const char *name, usb_console_rpc_fn fn);
+
+bool usb_console_running();
+void usb_console_get_stats(UsbConsoleStats *stats);
+
+#endif // USB_CONSOLE_H
@@ -0,0 +1,379 @@
+/**
+ * @file      usb_msc.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     USB mass storage: the SD card as a drive on the host, with read-ahead
+ */
+
+#include "usb_msc.h"
+#include "simple_logger.h"
+#include "sd_manager.h"
+
+#if defined(ARDUINO_USB_MODE) && !ARDUINO_USB_MODE
+#define USB_MSC_TINYUSB
+#include <USB.h>
+#include <USBMSC.h>
+#include <esp_heap_caps.h>
+#include <freertos/event_groups.h>
+#endif
+
+#ifdef INTEGRATION_LAYER_ENABLED
+#include "integration/config_manager.h"
+#endif
+
+#define MSC_SECTOR          512
+#define MSC_CHUNKS          2
+#define MSC_CHUNKS_SETTLED  ((1 << MSC_CHUNKS) - 1)
+
+// Task notification bits: one per buffer to fill, then the mode changes
+#define MSC_SIG_START       (1 << MSC_CHUNKS)
+#define MSC_SIG_STOP        (1 << (MSC_CHUNKS + 1))
+
+static UsbMscStats msc_stats;
+
+#ifdef USB_MSC_TINYUSB
+
+enum {
+    CHUNK_EMPTY = 0,
+    CHUNK_FILLING,
+    CHUNK_READY,
+};
+
+typedef struct {
+    uint8_t *buf;
+    uint32_t lba;
+    uint32_t count;
+    volatile uint8_t state;
+} msc_chunk_t;
+
+// Constructed before the USB stack starts, so the interface is in the
+// configuration from enumeration on; no media until a card is lent
+static USBMSC msc;
+
+static TaskHandle_t msc_task_handle = NULL;
+static SemaphoreHandle_t msc_mode_lock = NULL;  // Start and stop
+static SemaphoreHandle_t msc_lock = NULL;       // Chunk bookkeeping
+static EventGroupHandle_t msc_settled = NULL;   // A bit per chunk that is not filling
+static msc_chunk_t msc_chunks[MSC_CHUNKS];
+static volatile bool msc_active = false;
+static uint32_t msc_sectors = 0;
+static int msc_last = 0;                        // The chunk the last read came from
+static bool msc_auto = false;
+
+// ===== Read-ahead =====
+
+// Under msc_lock
+static void claim(int i, uint32_t lba) {
+    msc_chunk_t *c = &msc_chunks[i];
+    c->lba = lba;
+    c->count = min((uint32_t)USB_MSC_CHUNK_SECTORS, msc_sectors - lba);
+    c->state = CHUNK_FILLING;
+    xEventGroupClearBits(msc_settled, 1 << i);
+}
+
+// Claimed by the caller
+static void fill(int i) {
+    msc_chunk_t *c = &msc_chunks[i];
+    uint32_t start = micros();
+    bool ok = sd_manager_read_sectors(c->buf, c->lba, c->count);
+    xSemaphoreTake(msc_lock, portMAX_DELAY);
+    msc_stats.read_us += micros() - start;
+    c->state = ok ? CHUNK_READY : CHUNK_EMPTY;
+    if (!ok) {
+        msc_stats.errors++;
+    }
+    xSemaphoreGive(msc_lock);
+    xEventGroupSetBits(msc_settled, 1 << i);
+}
+
+// The chunk holding sector, filled here if no chunk has it coming
+static int chunk_for(uint32_t sector, bool *waited) {
+    for (int attempt = 0; attempt < 3; attempt++) {
+        xSemaphoreTake(msc_lock, portMAX_DELAY);
+        int hit = -1;
+        int spare = -1;
+        for (int n = 0; n < MSC_CHUNKS; n++) {
+            // The chunk read last is the one kept when both are free
+            int i = (msc_last + 1 + n) % MSC_CHUNKS;
+            msc_chunk_t *c = &msc_chunks[i];
+            if (c->state != CHUNK_EMPTY && sector - c->lba < c->count) {
+                hit = i;
+            } else if (c->state != CHUNK_FILLING && spare < 0) {
+                spare = i;
+            }
+        }
+        if (hit >= 0 && msc_chunks[hit].state == CHUNK_READY) {
+            xSemaphoreGive(msc_lock);
+            return hit;
+        }
+        if (hit < 0 && spare >= 0) {
+            claim(spare, sector);
+            xSemaphoreGive(msc_lock);
+            *waited = true;
+            fill(spare);
+            continue;
+        }
+        xSemaphoreGive(msc_lock);
+        xEventGroupWaitBits(msc_settled, hit >= 0 ? 1 << hit : MSC_CHUNKS_SETTLED, pdFALSE, pdTRUE,
+                            portMAX_DELAY);
+    }
+    return -1;
+}
+
+// Past half way through a chunk: have the task read what follows into the
+// other one, unless it already has it
+static void prefetch(int i, uint32_t sector) {
+    msc_chunk_t *c = &msc_chunks[i];
+    uint32_t next = c->lba + c->count;
+    if (sector - c->lba < c->count / 2 || next >= msc_sectors) {
+        return;
+    }
+    int other = (i + 1) % MSC_CHUNKS;
+    msc_chunk_t *o = &msc_chunks[other];
+    // Notified under the lock, so a stop that has taken it sees the bit
+    xSemaphoreTake(msc_lock, portMAX_DELAY);
+    if (msc_active && o->state != CHUNK_FILLING && !(o->state == CHUNK_READY && o->lba == next)) {
+        claim(other, next);
+        msc_stats.prefetches++;
+        xTaskNotify(msc_task_handle, 1 << other, eSetBits);
+    }
+    xSemaphoreGive(msc_lock);
+}
+
+static void run_fills(uint32_t bits) {
+    for (int i = 0; i < MSC_CHUNKS; i++) {
+        if (bits & (1 << i)) {
+            fill(i);
+        }
+    }
+}
+
+// ===== TinyUSB callbacks, in the USB task =====
+
+static int32_t msc_read(uint32_t lba, uint32_t offset, void *buffer, uint32_t bufsize) {
+    if (!msc_active) {
+        return -1;
+    }
+    uint8_t *out = (uint8_t *)buffer;
+    uint64_t pos = (uint64_t)lba * MSC_SECTOR + offset;
+    uint32_t done = 0;
+    bool waited = false;
+    while (done < bufsize) {
+        uint32_t sector = (pos + done) / MSC_SECTOR;
+        if (sector >= msc_sectors) {
+            break;
+        }
+        int i = chunk_for(sector, &waited);
+        if (i < 0) {
+            break;
+        }
+        msc_chunk_t *c = &msc_chunks[i];
+        uint32_t from = (sector - c->lba) * MSC_SECTOR + (pos + done) % MSC_SECTOR;
+        uint32_t n = min(bufsize - done, c->count * MSC_SECTOR - from);
+        memcpy(out + done, c->buf + from, n);
+        done += n;
+        msc_last = i;
+        prefetch(i, sector);
+    }
+    if (waited) {
+        msc_stats.misses++;
+    } else if (done) {
+        msc_stats.hits++;
+    }
+    msc_stats.read_sectors += done / MSC_SECTOR;
+    return done ? (int32_t)done : -1;
+}
+
+static int32_t msc_write(uint32_t lba, uint32_t offset, uint8_t *buffer, uint32_t bufsize) {
+    // The endpoint buffer is whole sectors, so writes are too
+    if (!msc_active || offset || bufsize % MSC_SECTOR) {
+        msc_stats.errors++;
+        return -1;
+    }
+    uint32_t count = bufsize / MSC_SECTOR;
+    // A prefetch may be reading the old sectors; let it land, then drop any
+    // chunk the write overlaps. Only this task claims chunks, so none
+    // starts in between
+    xEventGroupWaitBits(msc_settled, MSC_CHUNKS_SETTLED, pdFALSE, pdTRUE, portMAX_DELAY);
+    xSemaphoreTake(msc_lock, portMAX_DELAY);
+    for (int i = 0; i < MSC_CHUNKS; i++) {
+        msc_chunk_t *c = &msc_chunks[i];
+        if (c->state != CHUNK_EMPTY && lba < c->lba + c->count && c->lba < lba + count) {
+            c->state = CHUNK_EMPTY;
+        }
+    }
+    xSemaphoreGive(msc_lock);
+    if (!sd_manager_write_sectors(buffer, lba, count)) {
+        msc_stats.errors++;
+        return -1;
+    }
+    msc_stats.write_sectors += count;
+    return bufsize;
+}
+
+static bool msc_start_stop(uint8_t power_condition, bool start, bool load_eject) {
+    if (load_eject && !start) {
+        xTaskNotify(msc_task_handle, MSC_SIG_STOP, eSetBits);
+    }
+    return true;
+}
+
+// Arduino USB event loop
+static void on_usb_event(void *arg, esp_event_base_t base, int32_t id, void *data) {
+    if (id == ARDUINO_USB_STARTED_EVENT && msc_auto) {
+        xTaskNotify(msc_task_handle, MSC_SIG_START, eSetBits);
+    } else if (id == ARDUINO_USB_STOPPED_EVENT) {
+        xTaskNotify(msc_task_handle, MSC_SIG_STOP, eSetBits);
+    }
+}
+
+// ===== Task =====
+
+static void msc_task(void *param) {
+    while (1) {
+        uint32_t bits = 0;
+        xTaskNotifyWait(0, UINT32_MAX, &bits, portMAX_DELAY);
+        // Fills first: a stop waits for them to land
+        run_fills(bits);
+        if (bits & MSC_SIG_STOP) {
+            usb_msc_stop();
+        } else if (bits & MSC_SIG_START) {
+            usb_msc_start();
+        }
+    }
+}
+
+#endif // USB_MSC_TINYUSB
+
+// ===== API =====
+
+bool usb_msc_begin() {
+#ifdef USB_MSC_TINYUSB
+    if (msc_task_handle) {
+        return true;
+    }
+    for (int i = 0; i < MSC_CHUNKS; i++) {
+        msc_chunks[i].buf = (uint8_t *)heap_caps_malloc(USB_MSC_CHUNK_SECTORS * MSC_SECTOR,
+                                                        MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (!msc_chunks[i].buf) {
+            LOG_ERROR("MSC", "No memory for the read buffers");
+            return false;
+        }
+    }
+    msc_mode_lock = xSemaphoreCreateMutex();
+    msc_lock = xSemaphoreCreateMutex();
+    msc_settled = xEventGroupCreate();
+    if (!msc_mode_lock || !msc_lock || !msc_settled) {
+        LOG_ERROR("MSC", "Failed to create the locks");
+        return false;
+    }
+    xEventGroupSetBits(msc_settled, MSC_CHUNKS_SETTLED);
+    if (xTaskCreate(msc_task, "msc", USB_MSC_TASK_STACK, NULL, USB_MSC_TASK_PRIORITY,
+                    &msc_task_handle) != pdPASS) {
+        LOG_ERROR("MSC", "Failed to start the read-ahead task");
+        return false;
+    }
+
+    msc.vendorID(USB_MSC_VENDOR);
+    msc.productID(USB_MSC_PRODUCT);
+    msc.productRevision("1.0");
+    msc.onRead(msc_read);
+    msc.onWrite(msc_write);
+    msc.onStartStop(msc_start_stop);
+    msc.mediaPresent(false);
+    USB.onEvent(on_usb_event);
+
+#ifdef INTEGRATION_LAYER_ENABLED
+    msc_auto = GET_CONFIG_BOOL("usb_msc", "auto", false);
+#endif
+    LOG_INFOF("MSC", "Drive ready%s", msc_auto ? ", the card goes to the host on connect" : "");
+    // Enumerated before we got here
+    if (msc_auto && USB) {
+        xTaskNotify(msc_task_handle, MSC_SIG_START, eSetBits);
+    }
+    return true;
+#else
+    LOG_WARN("MSC", "Needs the TinyUSB stack (ARDUINO_USB_MODE=0)");
+    return false;
+#endif
+}
+
+bool usb_msc_start() {
+#ifdef USB_MSC_TINYUSB
+    if (!msc_task_handle) {
+        return false;
+    }
+    xSemaphoreTake(msc_mode_lock, portMAX_DELAY);
+    if (!msc_active) {
+        uint32_t sectors = sd_manager_lend();
+        if (sectors) {
+            for (int i = 0; i < MSC_CHUNKS; i++) {
+                msc_chunks[i].state = CHUNK_EMPTY;
+            }
+            msc_sectors = sectors;
+            msc_active = true;
+            msc_stats.sessions++;
+            msc.begin(sectors, MSC_SECTOR);
+            LOG_INFOF("MSC", "Card on the host, %lu MB", (unsigned long)(sectors / 2048));
+        } else {
+            LOG_WARN("MSC", "No card to offer");
+        }
+    }
+    bool ok = msc_active;
+    xSemaphoreGive(msc_mode_lock);
+    return ok;
+#else
+    return false;
+#endif
+}
+
+bool usb_msc_stop() {
+#ifdef USB_MSC_TINYUSB
+    if (!msc_task_handle) {
+        return false;
+    }
+    xSemaphoreTake(msc_mode_lock, portMAX_DELAY);
+    bool was = msc_active;
+    if (was) {
+        // The host is told first so it stops asking, then what is in flight lands
+        msc.mediaPresent(false);
+        xSemaphoreTake(msc_lock, portMAX_DELAY);
+        msc_active = false;
+        xSemaphoreGive(msc_lock);
+        // On the task itself, a prefetch claimed before that is still queued here
+        if (xTaskGetCurrentTaskHandle() == msc_task_handle) {
+            uint32_t bits = 0;
+            xTaskNotifyWait(0, MSC_CHUNKS_SETTLED, &bits, 0);
+            run_fills(bits);
+        }
+        xEventGroupWaitBits(msc_settled, MSC_CHUNKS_SETTLED, pdFALSE, pdTRUE, portMAX_DELAY);
+        sd_manager_sync();
+        LOG_INFOF("MSC", "Card back: %lu sectors read, %lu written, %lu errors",
+                  (unsigned long)msc_stats.read_sectors, (unsigned long)msc_stats.write_sectors,
+                  (unsigned long)msc_stats.errors);
+        sd_manager_reclaim();
+    }
+    xSemaphoreGive(msc_mode_lock);
+    return was;
+#else
+    return false;
+#endif
+}
+
+bool usb_msc_active() {
+#ifdef USB_MSC_TINYUSB
+    return msc_active;
+#else
+    return false;
+#endif
+}
+
+void usb_msc_get_stats(UsbMscStats *stats) {
+    *stats = msc_stats;
+#ifdef USB_MSC_TINYUSB
+    stats->active = msc_active;
+    stats->sectors = msc_sectors;
+#endif
+}
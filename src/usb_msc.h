@@ -0,0 +1,72 @@
+/**
+ * @file      usb_msc.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     USB mass storage: the SD card as a drive on the host, with read-ahead
+ */
+
+#ifndef USB_MSC_H
+#define USB_MSC_H
+
+#include <Arduino.h>
+
+/**
+ * The drive is part of the USB device from power-up, empty, like a card
+ * reader with no card in it. Starting the mode lends the card out
+ * (sd_manager_lend): the writers flush and let go, and the host sees the
+ * card appear. It comes back when the host ejects it, the cable goes, or
+ * usb_msc_stop(), and is mounted afresh for the writers.
+ *
+ * The card is on SPI, so the host's reads are served from two buffers:
+ * while USB drains one, a task fills the other with the sectors that
+ * follow, in one multi-block command, so a sequential copy keeps the card
+ * busy. Writes go straight through as multi-block writes; buffers they
+ * overlap are dropped. The card runs at the clock sd_manager found for it.
+ *
+ * Needs the TinyUSB stack (ARDUINO_USB_MODE=0, env T-Deck-Pro-MSC); with
+ * the hardware CDC/JTAG port usb_msc_begin() returns false.
+ *
+ * Config section "usb_msc": auto (off) lends the card whenever a host
+ * enumerates the device.
+ */
+
+#define USB_MSC_CHUNK_SECTORS       32      // Per buffer: 16 KB, one SD command
+#define USB_MSC_TASK_STACK          (1024 * 3)
+#define USB_MSC_TASK_PRIORITY       (tskIDLE_PRIORITY + 2)  // Ahead of the SD writers it replaces
+#define USB_MSC_VENDOR              "LILYGO"
+#define USB_MSC_PRODUCT             "T-Deck-Pro SD"
+
+struct UsbMscStats {
+    bool active;
+    uint32_t sectors;               // Card size
+    uint32_t read_sectors;
+    uint32_t write_sectors;
+    uint32_t hits;                  // Reads served from a buffer already filled or filling
+    uint32_t misses;                // Reads that waited on the card
+    uint32_t prefetches;
+    uint32_t errors;
+    uint32_t read_us;               // Time on the card for reads, prefetches included
+    uint32_t sessions;
+};
+
+/**
+ * @brief Set up the drive and the read-ahead task; false without TinyUSB
+ */
+bool usb_msc_begin();
+
+/**
+ * @brief Lend the card to the host
+ */
+bool usb_msc_start();
+
+/**
+ * @brief Take the card back and mount it for the writers again
+ */
+bool usb_msc_stop();
+
+bool usb_msc_active();
+void usb_msc_get_stats(UsbMscStats *stats);
+
+#endif // USB_MSC_H
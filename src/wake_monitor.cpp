@@ -0,0 +1,229 @@
+/**
+ * @file      wake_monitor.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Deep sleep wake sources and the early wake check
+ */
+
+#include "wake_monitor.h"
+#include "simple_logger.h"
+#include "utilities.h"
+#include "factory.h"
+#include "status_glance.h"
+#include <Wire.h>
+#include <esp_attr.h>
+#include <esp_sleep.h>
+#include <driver/rtc_io.h>
+#include <sys/time.h>
+#ifdef INTEGRATION_LAYER_ENABLED
+#include "integration/config_manager.h"
+#endif
+
+// TCA8418 registers, read before the keypad driver exists
+#define TCA8418_INT_STAT            0x02
+#define TCA8418_KEY_LCK_EC          0x03    // Low nibble: events in the FIFO
+#define TCA8418_KEY_EVENT_A         0x04    // Reading pops the oldest event
+#define TCA8418_INT_ALL             0x1F
+
+RTC_NOINIT_ATTR static WakeMonitorStats rtc_wake;
+
+static uint8_t pending_key = 0;
+
+static bool tca_read(uint8_t reg, uint8_t *val) {
+    Wire.beginTransmission(BOARD_I2C_ADDR_KEYBOARD);
+    Wire.write(reg);
+    if (Wire.endTransmission(false) != 0 || Wire.requestFrom((uint8_t)BOARD_I2C_ADDR_KEYBOARD, (uint8_t)1) != 1) {
+        return false;
+    }
+    *val = Wire.read();
+    return true;
+}
+
+static void tca_write(uint8_t reg, uint8_t val) {
+    Wire.beginTransmission(BOARD_I2C_ADDR_KEYBOARD);
+    Wire.write(reg);
+    Wire.write(val);
+    Wire.endTransmission();
+}
+
+static uint64_t now_us() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (uint64_t)tv.tv_sec * 1000000ULL + tv.tv_usec;
+}
+
+static void i2c_ensure() {
+    if (!i2cIsInit(0)) {
+        Wire.begin(BOARD_I2C_SDA, BOARD_I2C_SCL);
+    }
+}
+
+static void arm_pin(gpio_num_t pin) {
+    rtc_gpio_pullup_en(pin);
+    rtc_gpio_pulldown_dis(pin);
+}
+
+// Both lines are active low. ext0 takes one pin at any level, ext1 on the S3
+// only wakes on all-low for several pins, so each line gets its own source
+static void arm_sources() {
+    esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_ALL);
+
+    arm_pin((gpio_num_t)BOARD_KEYBOARD_INT);
+    esp_sleep_enable_ext0_wakeup((gpio_num_t)BOARD_KEYBOARD_INT, 0);
+
+    arm_pin((gpio_num_t)BOARD_TOUCH_INT);
+    esp_sleep_enable_ext1_wakeup(1ULL << BOARD_TOUCH_INT, ESP_EXT1_WAKEUP_ALL_LOW);
+
+    // A caller's timer stands in for the battery check; the status glance
+    // comes first when it is due sooner. After an early wake only what is
+    // left of the nearest is armed
+    uint64_t at = rtc_wake.timer_at_us ? rtc_wake.timer_at_us : rtc_wake.battery_at_us;
+    uint64_t glance_at = status_glance_due_us();
+    if (glance_at && (!at || glance_at < at)) {
+        at = glance_at;
+    }
+    if (at) {
+        uint64_t now = now_us();
+        esp_sleep_enable_timer_wakeup(at > now ? at - now : 1000);
+    }
+}
+
+static void stats_reset() {
+    memset(&rtc_wake, 0, sizeof(rtc_wake));
+    rtc_wake.magic = WAKE_MON_MAGIC;
+    rtc_wake.battery_check_s = WAKE_MON_BATTERY_CHECK_S;
+    rtc_wake.battery_percent = WAKE_MON_BATTERY_PERCENT;
+}
+
+bool wake_monitor_arm(uint32_t timer_ms) {
+    if (rtc_wake.magic != WAKE_MON_MAGIC) {
+        stats_reset();
+    }
+#ifdef INTEGRATION_LAYER_ENABLED
+    rtc_wake.battery_check_s = GET_CONFIG_INT("wake", "battery_check_s", WAKE_MON_BATTERY_CHECK_S);
+    rtc_wake.battery_percent = GET_CONFIG_INT("wake", "battery_percent", WAKE_MON_BATTERY_PERCENT);
+#endif
+    uint64_t now = now_us();
+    rtc_wake.timer_at_us = timer_ms ? now + (uint64_t)timer_ms * 1000ULL : 0;
+    rtc_wake.battery_at_us = rtc_wake.battery_check_s ? now + (uint64_t)rtc_wake.battery_check_s * 1000000ULL : 0;
+
+    // Keys pressed since the last read would hold INT low and wake it at once
+    i2c_ensure();
+    uint8_t count;
+    while (tca_read(TCA8418_KEY_LCK_EC, &count) && (count & 0x0F)) {
+        uint8_t event;
+        tca_read(TCA8418_KEY_EVENT_A, &event);
+    }
+    tca_write(TCA8418_INT_STAT, TCA8418_INT_ALL);
+
+    arm_sources();
+    if (timer_ms) {
+        LOG_INFOF("Wake", "Keypad, touch and timer wake armed (%lu ms)", timer_ms);
+    } else {
+        LOG_INFOF("Wake", "Keypad and touch wake armed, battery check every %lu s", rtc_wake.battery_check_s);
+    }
+    return true;
+}
+
+static void sleep_again() {
+    arm_sources();
+    esp_deep_sleep_start();
+}
+
+// The keypad latches events in its FIFO, so a real key is still there. An
+// empty FIFO means a glitch on the line
+static WakeInput check_keypad() {
+    i2c_ensure();
+    uint8_t count = 0;
+    if (!tca_read(TCA8418_KEY_LCK_EC, &count)) {
+        return WAKE_INPUT_KEYPAD;   // Cannot tell, let the boot decide
+    }
+    if ((count & 0x0F) == 0) {
+        tca_write(TCA8418_INT_STAT, TCA8418_INT_ALL);
+        rtc_wake.spurious++;
+        sleep_again();
+    }
+
+    uint8_t event = 0;
+    if (tca_read(TCA8418_KEY_EVENT_A, &event)) {
+        rtc_wake.first_key = event;
+        pending_key = event;
+    }
+    return WAKE_INPUT_KEYPAD;
+}
+
+// One timer serves the caller, the battery check and the status glance.
+// The gauge is read for either of the last two; a low charge boots to warn
+static WakeInput check_timer() {
+    uint64_t now = now_us() + WAKE_MON_TIMER_SLACK_MS * 1000ULL;
+    if (rtc_wake.timer_at_us && now >= rtc_wake.timer_at_us) {
+        return WAKE_INPUT_TIMER;
+    }
+    uint64_t glance_at = status_glance_due_us();
+    bool battery_due = rtc_wake.battery_at_us && now >= rtc_wake.battery_at_us;
+    bool glance_due = glance_at && now >= glance_at;
+    if (!battery_due && !glance_due) {
+        if (!rtc_wake.timer_at_us && !rtc_wake.battery_at_us && !glance_at) {
+            return WAKE_INPUT_TIMER;    // Nothing of ours was armed
+        }
+        sleep_again();              // Woke early
+    }
+
+    i2c_ensure();
+    uint16_t soc = bq27220.getStateOfCharge();
+    rtc_wake.last_soc = soc > 100 ? 100 : soc;
+    if ((battery_due && soc > 100) || (rtc_wake.battery_check_s && soc <= rtc_wake.battery_percent)) {
+        return WAKE_INPUT_BATTERY;
+    }
+    if (battery_due) {
+        rtc_wake.battery_checks++;
+        rtc_wake.battery_at_us = now_us() + (uint64_t)rtc_wake.battery_check_s * 1000000ULL;
+    }
+    if (glance_due) {
+        status_glance_refresh(rtc_wake.last_soc, bq27220.getIsCharging());
+    }
+    sleep_again();
+    return WAKE_INPUT_TIMER;
+}
+
+WakeInput wake_monitor_begin() {
+    esp_sleep_wakeup_cause_t cause = esp_sleep_get_wakeup_cause();
+    if (cause == ESP_SLEEP_WAKEUP_UNDEFINED || rtc_wake.magic != WAKE_MON_MAGIC) {
+        stats_reset();
+        return WAKE_INPUT_NONE;
+    }
+
+    WakeInput input;
+    rtc_wake.first_key = 0;
+    switch (cause) {
+        case ESP_SLEEP_WAKEUP_EXT0:
+            input = check_keypad();
+            break;
+        case ESP_SLEEP_WAKEUP_EXT1:
+            input = WAKE_INPUT_TOUCH;
+            break;
+        case ESP_SLEEP_WAKEUP_TIMER:
+            input = check_timer();
+            break;
+        default:
+            input = WAKE_INPUT_OTHER;
+            break;
+    }
+
+    rtc_wake.wakes++;
+    rtc_wake.last_input = input;
+    rtc_wake.timer_at_us = 0;
+    return input;
+}
+
+uint8_t wake_monitor_take_key() {
+    uint8_t key = pending_key;
+    pending_key = 0;
+    return key;
+}
+
+const WakeMonitorStats *wake_monitor_stats() {
+    return rtc_wake.magic == WAKE_MON_MAGIC ? &rtc_wake : nullptr;
+}
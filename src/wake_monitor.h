@@ -0,0 +1,68 @@
+/**
+ * @file      wake_monitor.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Deep sleep wake on keypad and touch, with spurious wakes sent back to sleep
+ */
+
+#ifndef WAKE_MONITOR_H
+#define WAKE_MONITOR_H
+
+#include <Arduino.h>
+
+#define WAKE_MON_MAGIC              0x4E4F4D57UL  // "WMON"
+#define WAKE_MON_BATTERY_CHECK_S    900     // Timer wake to read the gauge, wake.battery_check_s (0 off)
+#define WAKE_MON_BATTERY_PERCENT    10      // A timer wake below this boots to warn, wake.battery_percent
+#define WAKE_MON_TIMER_SLACK_MS     50      // A timer wake this early counts as due
+
+enum WakeInput {
+    WAKE_INPUT_NONE,                // Cold boot or reset
+    WAKE_INPUT_KEYPAD,              // TCA8418 INT, GPIO 15
+    WAKE_INPUT_TOUCH,               // CST328 INT, GPIO 12
+    WAKE_INPUT_BATTERY,             // Gauge check found the charge below the threshold
+    WAKE_INPUT_TIMER,               // A caller's timer, not the battery check
+    WAKE_INPUT_OTHER,
+};
+
+// In RTC memory, counts since the last cold boot
+struct WakeMonitorStats {
+    uint32_t magic;
+    uint32_t wakes;                 // Boots that went on to run the application
+    uint32_t spurious;              // Keypad wakes with an empty FIFO, slept again
+    uint32_t battery_checks;        // Gauge checks that slept again
+    uint32_t battery_check_s;       // Armed period, kept for re-arming from the early check
+    uint64_t timer_at_us;           // Caller's timer wake, gettimeofday(); 0 for none
+    uint64_t battery_at_us;         // Next gauge check, gettimeofday(); 0 for none
+    uint8_t battery_percent;
+    uint8_t last_input;             // WakeInput
+    uint8_t first_key;              // TCA8418 event that woke it, 0 if none
+    uint8_t last_soc;               // Gauge reading of the last check
+};
+
+/**
+ * @brief Arm keypad and touch wake for deep sleep, plus timer_ms when non-zero
+ *        or else the battery check, and the status glance (status_glance.h)
+ *        when it is due first. Clears the keypad interrupt so a stale INT
+ *        does not wake it at once. Reads the "wake" section
+ */
+bool wake_monitor_arm(uint32_t timer_ms = 0);
+
+/**
+ * @brief First thing in setup(). Checks why the chip woke; a keypad wake with
+ *        nothing in the FIFO, a battery check above the threshold, or a
+ *        status glance goes straight back to deep sleep and never returns
+ * @return What woke it, WAKE_INPUT_NONE on a cold boot
+ */
+WakeInput wake_monitor_begin();
+
+/**
+ * @brief The key event read during the wake check, for the keypad driver.
+ *        0 when there is none; returns it once
+ */
+uint8_t wake_monitor_take_key();
+
+const WakeMonitorStats *wake_monitor_stats();
+
+#endif // WAKE_MONITOR_H
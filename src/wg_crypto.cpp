@@ -0,0 +1,687 @@
+/**
+ * @file      wg_crypto.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     WireGuard primitives, portable C with 32-bit word paths for the data plane
+ */
+
+#include "wg_crypto.h"
+#include "placement.h"
+#include <string.h>
+
+// ===== Helpers =====
+
+static inline uint32_t load32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline void store32(uint8_t *p, uint32_t v) {
+    p[0] = v;
+    p[1] = v >> 8;
+    p[2] = v >> 16;
+    p[3] = v >> 24;
+}
+
+static inline void store64(uint8_t *p, uint64_t v) {
+    store32(p, (uint32_t)v);
+    store32(p + 4, (uint32_t)(v >> 32));
+}
+
+static inline uint32_t rotl32(uint32_t v, int n) {
+    return (v << n) | (v >> (32 - n));
+}
+
+static inline uint32_t rotr32(uint32_t v, int n) {
+    return (v >> n) | (v << (32 - n));
+}
+
+void wg_wipe(void *p, size_t len) {
+    volatile uint8_t *v = (volatile uint8_t *)p;
+    while (len--) {
+        *v++ = 0;
+    }
+}
+
+// ===== ChaCha20, RFC 8439 =====
+
+#define CHACHA_QR(a, b, c, d) \
+    a += b; d ^= a; d = rotl32(d, 16); \
+    c += d; b ^= c; b = rotl32(b, 12); \
+    a += b; d ^= a; d = rotl32(d, 8); \
+    c += d; b ^= c; b = rotl32(b, 7);
+
+static void PLACE_HOT chacha_rounds(uint32_t x[16]) {
+    for (int i = 0; i < 10; i++) {
+        CHACHA_QR(x[0], x[4], x[8], x[12]);
+        CHACHA_QR(x[1], x[5], x[9], x[13]);
+        CHACHA_QR(x[2], x[6], x[10], x[14]);
+        CHACHA_QR(x[3], x[7], x[11], x[15]);
+        CHACHA_QR(x[0], x[5], x[10], x[15]);
+        CHACHA_QR(x[1], x[6], x[11], x[12]);
+        CHACHA_QR(x[2], x[7], x[8], x[13]);
+        CHACHA_QR(x[3], x[4], x[9], x[14]);
+    }
+}
+
+static void chacha_init(uint32_t st[16], const uint8_t key[WG_KEY_LEN], const uint8_t nonce[12], uint32_t counter) {
+    st[0] = 0x61707865;
+    st[1] = 0x3320646e;
+    st[2] = 0x79622d32;
+    st[3] = 0x6b206574;
+    for (int i = 0; i < 8; i++) {
+        st[4 + i] = load32(key + 4 * i);
+    }
+    st[12] = counter;
+    st[13] = load32(nonce);
+    st[14] = load32(nonce + 4);
+    st[15] = load32(nonce + 8);
+}
+
+// Whole blocks go a word at a time; the tail byte-wise
+static void PLACE_HOT chacha_xor(uint32_t st[16], uint8_t *data, size_t len) {
+    uint32_t ks[16];
+    while (len) {
+        memcpy(ks, st, sizeof(ks));
+        chacha_rounds(ks);
+        for (int i = 0; i < 16; i++) {
+            ks[i] += st[i];
+        }
+        st[12]++;
+
+        if (len >= 64) {
+            for (int i = 0; i < 16; i++) {
+                uint32_t w;
+                memcpy(&w, data + 4 * i, 4);
+                w ^= ks[i];
+                memcpy(data + 4 * i, &w, 4);
+            }
+            data += 64;
+            len -= 64;
+            continue;
+        }
+        uint8_t tail[64];
+        for (int i = 0; i < 16; i++) {
+            store32(tail + 4 * i, ks[i]);
+        }
+        for (size_t i = 0; i < len; i++) {
+            data[i] ^= tail[i];
+        }
+        wg_wipe(tail, sizeof(tail));
+        len = 0;
+    }
+    wg_wipe(ks, sizeof(ks));
+}
+
+void wg_chacha20(uint8_t *data, size_t len, const uint8_t key[WG_KEY_LEN], const uint8_t nonce[12], uint32_t counter) {
+    uint32_t st[16];
+    chacha_init(st, key, nonce, counter);
+    chacha_xor(st, data, len);
+    wg_wipe(st, sizeof(st));
+}
+
+static void hchacha20(uint8_t out[WG_KEY_LEN], const uint8_t key[WG_KEY_LEN], const uint8_t nonce[16]) {
+    uint32_t x[16];
+    chacha_init(x, key, nonce + 4, load32(nonce));
+    chacha_rounds(x);
+    for (int i = 0; i < 4; i++) {
+        store32(out + 4 * i, x[i]);
+        store32(out + 16 + 4 * i, x[12 + i]);
+    }
+    wg_wipe(x, sizeof(x));
+}
+
+// ===== Poly1305, 26-bit limbs =====
+
+struct Poly1305 {
+    uint32_t r[5];
+    uint32_t h[5];
+    uint32_t pad[4];
+    uint8_t buf[16];
+    size_t buf_len;
+};
+
+static void poly_init(Poly1305 *p, const uint8_t key[32]) {
+    p->r[0] = load32(key) & 0x3ffffff;
+    p->r[1] = (load32(key + 3) >> 2) & 0x3ffff03;
+    p->r[2] = (load32(key + 6) >> 4) & 0x3ffc0ff;
+    p->r[3] = (load32(key + 9) >> 6) & 0x3f03fff;
+    p->r[4] = (load32(key + 12) >> 8) & 0x00fffff;
+    for (int i = 0; i < 5; i++) {
+        p->h[i] = 0;
+    }
+    for (int i = 0; i < 4; i++) {
+        p->pad[i] = load32(key + 16 + 4 * i);
+    }
+    p->buf_len = 0;
+}
+
+static void PLACE_HOT poly_blocks(Poly1305 *p, const uint8_t *m, size_t len, uint32_t hibit) {
+    const uint32_t r0 = p->r[0], r1 = p->r[1], r2 = p->r[2], r3 = p->r[3], r4 = p->r[4];
+    const uint32_t s1 = r1 * 5, s2 = r2 * 5, s3 = r3 * 5, s4 = r4 * 5;
+    uint32_t h0 = p->h[0], h1 = p->h[1], h2 = p->h[2], h3 = p->h[3], h4 = p->h[4];
+
+    while (len >= 16) {
+        h0 += load32(m) & 0x3ffffff;
+        h1 += (load32(m + 3) >> 2) & 0x3ffffff;
+        h2 += (load32(m + 6) >> 4) & 0x3ffffff;
+        h3 += (load32(m + 9) >> 6) & 0x3ffffff;
+        h4 += (load32(m + 12) >> 8) | hibit;
+
+        uint64_t d0 = (uint64_t)h0 * r0 + (uint64_t)h1 * s4 + (uint64_t)h2 * s3 + (uint64_t)h3 * s2 + (uint64_t)h4 * s1;
+        uint64_t d1 = (uint64_t)h0 * r1 + (uint64_t)h1 * r0 + (uint64_t)h2 * s4 + (uint64_t)h3 * s3 + (uint64_t)h4 * s2;
+        uint64_t d2 = (uint64_t)h0 * r2 + (uint64_t)h1 * r1 + (uint64_t)h2 * r0 + (uint64_t)h3 * s4 + (uint64_t)h4 * s3;
+        uint64_t d3 = (uint64_t)h0 * r3 + (uint64_t)h1 * r2 + (uint64_t)h2 * r1 + (uint64_t)h3 * r0 + (uint64_t)h4 * s4;
+        uint64_t d4 = (uint64_t)h0 * r4 + (uint64_t)h1 * r3 + (uint64_t)h2 * r2 + (uint64_t)h3 * r1 + (uint64_t)h4 * r0;
+
+        uint32_t c = (uint32_t)(d0 >> 26); h0 = (uint32_t)d0 & 0x3ffffff;
+        d1 += c; c = (uint32_t)(d1 >> 26); h1 = (uint32_t)d1 & 0x3ffffff;
+        d2 += c; c = (uint32_t)(d2 >> 26); h2 = (uint32_t)d2 & 0x3ffffff;
+        d3 += c; c = (uint32_t)(d3 >> 26); h3 = (uint32_t)d3 & 0x3ffffff;
+        d4 += c; c = (uint32_t)(d4 >> 26); h4 = (uint32_t)d4 & 0x3ffffff;
+        h0 += c * 5; c = h0 >> 26; h0 &= 0x3ffffff;
+        h1 += c;
+
+        m += 16;
+        len -= 16;
+    }
+    p->h[0] = h0;
+    p->h[1] = h1;
+    p->h[2] = h2;
+    p->h[3] = h3;
+    p->h[4] = h4;
+}
+
+static void poly_update(Poly1305 *p, const uint8_t *m, size_t len) {
+    if (p->buf_len) {
+        size_t n = 16 - p->buf_len < len ? 16 - p->buf_len : len;
+        memcpy(p->buf + p->buf_len, m, n);
+        p->buf_len += n;
+        m += n;
+        len -= n;
+        if (p->buf_len < 16) {
+            return;
+        }
+        poly_blocks(p, p->buf, 16, 1 << 24);
+        p->buf_len = 0;
+    }
+    size_t whole = len & ~(size_t)15;
+    if (whole) {
+        poly_blocks(p, m, whole, 1 << 24);
+        m += whole;
+        len -= whole;
+    }
+    if (len) {
+        memcpy(p->buf, m, len);
+        p->buf_len = len;
+    }
+}
+
+// Zero padding to the next 16-byte boundary, as the AEAD construction wants it
+static void poly_pad(Poly1305 *p) {
+    static const uint8_t zero[16] = {0};
+    if (p->buf_len) {
+        poly_update(p, zero, 16 - p->buf_len);
+    }
+}
+
+static void poly_finish(Poly1305 *p, uint8_t mac[16]) {
+    if (p->buf_len) {
+        p->buf[p->buf_len++] = 1;
+        memset(p->buf + p->buf_len, 0, 16 - p->buf_len);
+        poly_blocks(p, p->buf, 16, 0);
+    }
+
+    uint32_t h0 = p->h[0], h1 = p->h[1], h2 = p->h[2], h3 = p->h[3], h4 = p->h[4];
+    uint32_t c;
+    c = h1 >> 26; h1 &= 0x3ffffff;
+    h2 += c; c = h2 >> 26; h2 &= 0x3ffffff;
+    h3 += c; c = h3 >> 26; h3 &= 0x3ffffff;
+    h4 += c; c = h4 >> 26; h4 &= 0x3ffffff;
+    h0 += c * 5; c = h0 >> 26; h0 &= 0x3ffffff;
+    h1 += c;
+
+    // h - p, kept when it did not go negative
+    uint32_t g0 = h0 + 5; c = g0 >> 26; g0 &= 0x3ffffff;
+    uint32_t g1 = h1 + c; c = g1 >> 26; g1 &= 0x3ffffff;
+    uint32_t g2 = h2 + c; c = g2 >> 26; g2 &= 0x3ffffff;
+    uint32_t g3 = h3 + c; c = g3 >> 26; g3 &= 0x3ffffff;
+    uint32_t g4 = h4 + c - (1UL << 26);
+    uint32_t mask = (g4 >> 31) - 1;
+    h0 = (h0 & ~mask) | (g0 & mask);
+    h1 = (h1 & ~mask) | (g1 & mask);
+    h2 = (h2 & ~mask) | (g2 & mask);
+    h3 = (h3 & ~mask) | (g3 & mask);
+    h4 = (h4 & ~mask) | (g4 & mask);
+
+    h0 = h0 | (h1 << 26);
+    h1 = (h1 >> 6) | (h2 << 20);
+    h2 = (h2 >> 12) | (h3 << 14);
+    h3 = (h3 >> 18) | (h4 << 8);
+
+    uint64_t f;
+    f = (uint64_t)h0 + p->pad[0]; store32(mac, (uint32_t)f);
+    f = (uint64_t)h1 + p->pad[1] + (f >> 32); store32(mac + 4, (uint32_t)f);
+    f = (uint64_t)h2 + p->pad[2] + (f >> 32); store32(mac + 8, (uint32_t)f);
+    f = (uint64_t)h3 + p->pad[3] + (f >> 32); store32(mac + 12, (uint32_t)f);
+    wg_wipe(p, sizeof(*p));
+}
+
+// ===== AEAD =====
+
+static void aead_tag(uint8_t tag[WG_TAG_LEN], uint32_t st[16], const uint8_t *ad, size_t ad_len,
+                     const uint8_t *ct, size_t len) {
+    // Block 0 keys Poly1305, the data starts at block 1
+    uint8_t otk[64] = {0};
+    chacha_xor(st, otk, sizeof(otk));
+    Poly1305 p;
+    poly_init(&p, otk);
+    wg_wipe(otk, sizeof(otk));
+
+    uint8_t lens[16];
+    store64(lens, ad_len);
+    store64(lens + 8, len);
+    poly_update(&p, ad, ad_len);
+    poly_pad(&p);
+    poly_update(&p, ct, len);
+    poly_pad(&p);
+    poly_update(&p, lens, sizeof(lens));
+    poly_finish(&p, tag);
+}
+
+static bool tag_equal(const uint8_t *a, const uint8_t *b) {
+    uint8_t diff = 0;
+    for (int i = 0; i < WG_TAG_LEN; i++) {
+        diff |= a[i] ^ b[i];
+    }
+    return diff == 0;
+}
+
+static void aead_seal96(uint8_t *data, size_t len, uint8_t tag[WG_TAG_LEN], const uint8_t *ad, size_t ad_len,
+                        const uint8_t nonce[12], const uint8_t key[WG_KEY_LEN]) {
+    uint32_t st[16];
+    chacha_init(st, key, nonce, 0);
+    uint32_t data_st[16];
+    memcpy(data_st, st, sizeof(st));
+    data_st[12] = 1;
+    chacha_xor(data_st, data, len);
+    aead_tag(tag, st, ad, ad_len, data, len);
+    wg_wipe(st, sizeof(st));
+    wg_wipe(data_st, sizeof(data_st));
+}
+
+static bool aead_open96(uint8_t *data, size_t len, const uint8_t tag[WG_TAG_LEN], const uint8_t *ad, size_t ad_len,
+                        const uint8_t nonce[12], const uint8_t key[WG_KEY_LEN]) {
+    uint32_t st[16];
+    uint8_t expect[WG_TAG_LEN];
+    chacha_init(st, key, nonce, 0);
+    aead_tag(expect, st, ad, ad_len, data, len);
+    bool ok = tag_equal(expect, tag);
+    if (ok) {
+        st[12] = 1;
+        chacha_xor(st, data, len);
+    }
+    wg_wipe(st, sizeof(st));
+    return ok;
+}
+
+static void counter_nonce(uint8_t nonce[12], uint64_t counter) {
+    memset(nonce, 0, 4);
+    store64(nonce + 4, counter);
+}
+
+void wg_aead_seal(uint8_t *data, size_t len, uint8_t tag[WG_TAG_LEN], const uint8_t *ad, size_t ad_len,
+                  uint64_t nonce, const uint8_t key[WG_KEY_LEN]) {
+    uint8_t n[12];
+    counter_nonce(n, nonce);
+    aead_seal96(data, len, tag, ad, ad_len, n, key);
+}
+
+bool wg_aead_open(uint8_t *data, size_t len, const uint8_t tag[WG_TAG_LEN], const uint8_t *ad, size_t ad_len,
+                  uint64_t nonce, const uint8_t key[WG_KEY_LEN]) {
+    uint8_t n[12];
+    counter_nonce(n, nonce);
+    return aead_open96(data, len, tag, ad, ad_len, n, key);
+}
+
+bool wg_xaead_open(uint8_t *data, size_t len, const uint8_t tag[WG_TAG_LEN], const uint8_t *ad, size_t ad_len,
+                   const uint8_t nonce[WG_XNONCE_LEN], const uint8_t key[WG_KEY_LEN]) {
+    uint8_t subkey[WG_KEY_LEN];
+    uint8_t n[12] = {0};
+    hchacha20(subkey, key, nonce);
+    memcpy(n + 4, nonce + 16, 8);
+    bool ok = aead_open96(data, len, tag, ad, ad_len, n, subkey);
+    wg_wipe(subkey, sizeof(subkey));
+    return ok;
+}
+
+// ===== BLAKE2s, RFC 7693 =====
+
+static const uint32_t PLACE_HOT_DATA blake2s_iv[8] = {
+    0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A, 0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19,
+};
+
+static const uint8_t PLACE_HOT_DATA blake2s_sigma[10][16] = {
+    {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15},
+    {14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3},
+    {11, 8, 12, 0, 5, 2, 15, 13, 10, 14, 3, 6, 7, 1, 9, 4},
+    {7, 9, 3, 1, 13, 12, 11, 14, 2, 6, 5, 10, 4, 0, 15, 8},
+    {9, 0, 5, 7, 2, 4, 10, 15, 14, 1, 11, 12, 6, 8, 3, 13},
+    {2, 12, 6, 10, 0, 11, 8, 3, 4, 13, 7, 5, 15, 14, 1, 9},
+    {12, 5, 1, 15, 14, 13, 4, 10, 0, 7, 6, 3, 9, 2, 8, 11},
+    {13, 11, 7, 14, 12, 1, 3, 9, 5, 0, 15, 4, 8, 6, 2, 10},
+    {6, 15, 14, 9, 11, 3, 0, 8, 12, 2, 13, 7, 1, 4, 10, 5},
+    {10, 2, 8, 4, 7, 6, 1, 5, 15, 11, 9, 14, 3, 12, 13, 0},
+};
+
+#define BLAKE2S_G(a, b, c, d, x, y) \
+    a = a + b + (x); d = rotr32(d ^ a, 16); \
+    c = c + d; b = rotr32(b ^ c, 12); \
+    a = a + b + (y); d = rotr32(d ^ a, 8); \
+    c = c + d; b = rotr32(b ^ c, 7);
+
+static void blake2s_compress(WgBlake2s *s, const uint8_t block[64], bool last) {
+    uint32_t m[16];
+    uint32_t v[16];
+    for (int i = 0; i < 16; i++) {
+        m[i] = load32(block + 4 * i);
+    }
+    for (int i = 0; i < 8; i++) {
+        v[i] = s->h[i];
+        v[i + 8] = blake2s_iv[i];
+    }
+    v[12] ^= s->t[0];
+    v[13] ^= s->t[1];
+    if (last) {
+        v[14] = ~v[14];
+    }
+    for (int r = 0; r < 10; r++) {
+        const uint8_t *sg = blake2s_sigma[r];
+        BLAKE2S_G(v[0], v[4], v[8], v[12], m[sg[0]], m[sg[1]]);
+        BLAKE2S_G(v[1], v[5], v[9], v[13], m[sg[2]], m[sg[3]]);
+        BLAKE2S_G(v[2], v[6], v[10], v[14], m[sg[4]], m[sg[5]]);
+        BLAKE2S_G(v[3], v[7], v[11], v[15], m[sg[6]], m[sg[7]]);
+        BLAKE2S_G(v[0], v[5], v[10], v[15], m[sg[8]], m[sg[9]]);
+        BLAKE2S_G(v[1], v[6], v[11], v[12], m[sg[10]], m[sg[11]]);
+        BLAKE2S_G(v[2], v[7], v[8], v[13], m[sg[12]], m[sg[13]]);
+        BLAKE2S_G(v[3], v[4], v[9], v[14], m[sg[14]], m[sg[15]]);
+    }
+    for (int i = 0; i < 8; i++) {
+        s->h[i] ^= v[i] ^ v[i + 8];
+    }
+}
+
+static void blake2s_count(WgBlake2s *s, uint32_t n) {
+    s->t[0] += n;
+    if (s->t[0] < n) {
+        s->t[1]++;
+    }
+}
+
+void wg_blake2s_init(WgBlake2s *s, size_t out_len, const uint8_t *key, size_t key_len) {
+    memcpy(s->h, blake2s_iv, sizeof(s->h));
+    s->h[0] ^= 0x01010000 ^ ((uint32_t)key_len << 8) ^ (uint32_t)out_len;
+    s->t[0] = 0;
+    s->t[1] = 0;
+    s->buf_len = 0;
+    s->out_len = out_len;
+    if (key_len) {
+        memset(s->buf, 0, sizeof(s->buf));
+        memcpy(s->buf, key, key_len);
+        s->buf_len = 64;
+    }
+}
+
+void wg_blake2s_update(WgBlake2s *s, const uint8_t *in, size_t len) {
+    // The last block is compressed with the final flag, so a full buffer waits for more input
+    while (len) {
+        if (s->buf_len == 64) {
+            blake2s_count(s, 64);
+            blake2s_compress(s, s->buf, false);
+            s->buf_len = 0;
+        }
+        size_t n = 64 - s->buf_len < len ? 64 - s->buf_len : len;
+        memcpy(s->buf + s->buf_len, in, n);
+        s->buf_len += n;
+        in += n;
+        len -= n;
+    }
+}
+
+void wg_blake2s_final(WgBlake2s *s, uint8_t *out) {
+    blake2s_count(s, s->buf_len);
+    memset(s->buf + s->buf_len, 0, 64 - s->buf_len);
+    blake2s_compress(s, s->buf, true);
+    uint8_t full[32];
+    for (int i = 0; i < 8; i++) {
+        store32(full + 4 * i, s->h[i]);
+    }
+    memcpy(out, full, s->out_len);
+    wg_wipe(full, sizeof(full));
+    wg_wipe(s, sizeof(*s));
+}
+
+void wg_hash(uint8_t out[WG_HASH_LEN], const uint8_t *a, size_t a_len, const uint8_t *b, size_t b_len) {
+    WgBlake2s s;
+    wg_blake2s_init(&s, WG_HASH_LEN);
+    wg_blake2s_update(&s, a, a_len);
+    if (b_len) {
+        wg_blake2s_update(&s, b, b_len);
+    }
+    wg_blake2s_final(&s, out);
+}
+
+void wg_mac(uint8_t out[WG_MAC_LEN], const uint8_t *key, size_t key_len, const uint8_t *in, size_t len) {
+    WgBlake2s s;
+    wg_blake2s_init(&s, WG_MAC_LEN, key, key_len);
+    wg_blake2s_update(&s, in, len);
+    wg_blake2s_final(&s, out);
+}
+
+void wg_hmac(uint8_t out[WG_HASH_LEN], const uint8_t key[WG_HASH_LEN], const uint8_t *in, size_t len) {
+    uint8_t pad[64];
+    uint8_t inner[WG_HASH_LEN];
+    WgBlake2s s;
+
+    memset(pad, 0x36, sizeof(pad));
+    for (int i = 0; i < WG_HASH_LEN; i++) {
+        pad[i] ^= key[i];
+    }
+    wg_blake2s_init(&s, WG_HASH_LEN);
+    wg_blake2s_update(&s, pad, sizeof(pad));
+    wg_blake2s_update(&s, in, len);
+    wg_blake2s_final(&s, inner);
+
+    memset(pad, 0x5c, sizeof(pad));
+    for (int i = 0; i < WG_HASH_LEN; i++) {
+        pad[i] ^= key[i];
+    }
+    wg_blake2s_init(&s, WG_HASH_LEN);
+    wg_blake2s_update(&s, pad, sizeof(pad));
+    wg_blake2s_update(&s, inner, sizeof(inner));
+    wg_blake2s_final(&s, out);
+    wg_wipe(pad, sizeof(pad));
+    wg_wipe(inner, sizeof(inner));
+}
+
+void wg_kdf(uint8_t *t1, uint8_t *t2, uint8_t *t3, const uint8_t key[WG_HASH_LEN], const uint8_t *in, size_t len) {
+    uint8_t prk[WG_HASH_LEN];
+    uint8_t t[WG_HASH_LEN + 1];
+    wg_hmac(prk, key, in, len);
+
+    t[0] = 1;
+    wg_hmac(t, prk, t, 1);
+    if (t1) {
+        memcpy(t1, t, WG_HASH_LEN);
+    }
+    if (t2 || t3) {
+        t[WG_HASH_LEN] = 2;
+        wg_hmac(t, prk, t, WG_HASH_LEN + 1);
+        if (t2) {
+            memcpy(t2, t, WG_HASH_LEN);
+        }
+    }
+    if (t3) {
+        t[WG_HASH_LEN] = 3;
+        wg_hmac(t, prk, t, WG_HASH_LEN + 1);
+        memcpy(t3, t, WG_HASH_LEN);
+    }
+    wg_wipe(prk, sizeof(prk));
+    wg_wipe(t, sizeof(t));
+}
+
+// ===== X25519, 16-bit limbs in 64-bit words =====
+
+typedef int64_t gf[16];
+
+static const gf gf_121665 = {0xDB41, 1};
+
+static void gf_carry(gf o) {
+    for (int i = 0; i < 16; i++) {
+        o[i] += (int64_t)1 << 16;
+        int64_t c = o[i] >> 16;
+        o[(i + 1) * (i < 15)] += c - 1 + 37 * (c - 1) * (i == 15);
+        o[i] -= c << 16;
+    }
+}
+
+static void gf_swap(gf p, gf q, int b) {
+    int64_t c = ~(int64_t)(b - 1);
+    for (int i = 0; i < 16; i++) {
+        int64_t t = c & (p[i] ^ q[i]);
+        p[i] ^= t;
+        q[i] ^= t;
+    }
+}
+
+static void gf_pack(uint8_t o[32], const gf n) {
+    gf m, t;
+    memcpy(t, n, sizeof(gf));
+    gf_carry(t);
+    gf_carry(t);
+    gf_carry(t);
+    for (int j = 0; j < 2; j++) {
+        m[0] = t[0] - 0xffed;
+        for (int i = 1; i < 15; i++) {
+            m[i] = t[i] - 0xffff - ((m[i - 1] >> 16) & 1);
+            m[i - 1] &= 0xffff;
+        }
+        m[15] = t[15] - 0x7fff - ((m[14] >> 16) & 1);
+        int b = (m[15] >> 16) & 1;
+        m[14] &= 0xffff;
+        gf_swap(t, m, 1 - b);
+    }
+    for (int i = 0; i < 16; i++) {
+        o[2 * i] = t[i] & 0xff;
+        o[2 * i + 1] = t[i] >> 8;
+    }
+}
+
+static void gf_unpack(gf o, const uint8_t n[32]) {
+    for (int i = 0; i < 16; i++) {
+        o[i] = n[2 * i] + ((int64_t)n[2 * i + 1] << 8);
+    }
+    o[15] &= 0x7fff;
+}
+
+static void gf_add(gf o, const gf a, const gf b) {
+    for (int i = 0; i < 16; i++) {
+        o[i] = a[i] + b[i];
+    }
+}
+
+static void gf_sub(gf o, const gf a, const gf b) {
+    for (int i = 0; i < 16; i++) {
+        o[i] = a[i] - b[i];
+    }
+}
+
+static void gf_mul(gf o, const gf a, const gf b) {
+    int64_t t[31] = {0};
+    for (int i = 0; i < 16; i++) {
+        for (int j = 0; j < 16; j++) {
+            t[i + j] += a[i] * b[j];
+        }
+    }
+    for (int i = 0; i < 15; i++) {
+        t[i] += 38 * t[i + 16];
+    }
+    memcpy(o, t, sizeof(gf));
+    gf_carry(o);
+    gf_carry(o);
+}
+
+static void gf_inv(gf o, const gf in) {
+    gf c;
+    memcpy(c, in, sizeof(gf));
+    for (int a = 253; a >= 0; a--) {
+        gf_mul(c, c, c);
+        if (a != 2 && a != 4) {
+            gf_mul(c, c, in);
+        }
+    }
+    memcpy(o, c, sizeof(gf));
+}
+
+void wg_x25519_clamp(uint8_t key[WG_KEY_LEN]) {
+    key[0] &= 248;
+    key[31] = (key[31] & 127) | 64;
+}
+
+void wg_x25519(uint8_t out[WG_KEY_LEN], const uint8_t scalar[WG_KEY_LEN], const uint8_t point[WG_KEY_LEN]) {
+    uint8_t z[32];
+    gf x, a, b, c, d, e, f;
+    memcpy(z, scalar, sizeof(z));
+    wg_x25519_clamp(z);
+    gf_unpack(x, point);
+
+    memcpy(b, x, sizeof(gf));
+    memset(a, 0, sizeof(gf));
+    memset(c, 0, sizeof(gf));
+    memset(d, 0, sizeof(gf));
+    a[0] = d[0] = 1;
+
+    // Montgomery ladder, constant time
+    for (int i = 254; i >= 0; i--) {
+        int r = (z[i >> 3] >> (i & 7)) & 1;
+        gf_swap(a, b, r);
+        gf_swap(c, d, r);
+        gf_add(e, a, c);
+        gf_sub(a, a, c);
+        gf_add(c, b, d);
+        gf_sub(b, b, d);
+        gf_mul(d, e, e);
+        gf_mul(f, a, a);
+        gf_mul(a, c, a);
+        gf_mul(c, b, e);
+        gf_add(e, a, c);
+        gf_sub(a, a, c);
+        gf_mul(b, a, a);
+        gf_sub(c, d, f);
+        gf_mul(a, c, gf_121665);
+        gf_add(a, a, d);
+        gf_mul(c, c, a);
+        gf_mul(a, d, f);
+        gf_mul(d, b, x);
+        gf_mul(b, e, e);
+        gf_swap(a, b, r);
+        gf_swap(c, d, r);
+    }
+    gf_inv(c, c);
+    gf_mul(a, a, c);
+    gf_pack(out, a);
+
+    wg_wipe(z, sizeof(z));
+    wg_wipe(a, sizeof(gf));
+    wg_wipe(b, sizeof(gf));
+    wg_wipe(c, sizeof(gf));
+    wg_wipe(d, sizeof(gf));
+    wg_wipe(e, sizeof(gf));
+    wg_wipe(f, sizeof(gf));
+}
+
+void wg_x25519_public(uint8_t pub[WG_KEY_LEN], const uint8_t priv[WG_KEY_LEN]) {
+    static const uint8_t base[32] = {9};
+    wg_x25519(pub, priv, base);
+}
@@ -0,0 +1,74 @@
+/**
+ * @file      wg_crypto.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     WireGuard primitives: X25519, ChaCha20-Poly1305, XChaCha20-Poly1305, BLAKE2s
+ */
+
+#ifndef WG_CRYPTO_H
+#define WG_CRYPTO_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define WG_KEY_LEN          32
+#define WG_HASH_LEN         32
+#define WG_TAG_LEN          16
+#define WG_MAC_LEN          16
+#define WG_XNONCE_LEN       24
+
+// X25519, RFC 7748. Constant time; a few tens of ms on the S3, so worker task only
+void wg_x25519(uint8_t out[WG_KEY_LEN], const uint8_t scalar[WG_KEY_LEN], const uint8_t point[WG_KEY_LEN]);
+void wg_x25519_public(uint8_t pub[WG_KEY_LEN], const uint8_t priv[WG_KEY_LEN]);
+void wg_x25519_clamp(uint8_t key[WG_KEY_LEN]);
+
+/**
+ * @brief ChaCha20 keystream XORed into data in place, RFC 8439 block counter
+ */
+void wg_chacha20(uint8_t *data, size_t len, const uint8_t key[WG_KEY_LEN], const uint8_t nonce[12], uint32_t counter);
+
+/**
+ * @brief ChaCha20-Poly1305 in place; the 64-bit counter is the nonce, as WireGuard uses it
+ */
+void wg_aead_seal(uint8_t *data, size_t len, uint8_t tag[WG_TAG_LEN], const uint8_t *ad, size_t ad_len,
+                  uint64_t nonce, const uint8_t key[WG_KEY_LEN]);
+bool wg_aead_open(uint8_t *data, size_t len, const uint8_t tag[WG_TAG_LEN], const uint8_t *ad, size_t ad_len,
+                  uint64_t nonce, const uint8_t key[WG_KEY_LEN]);
+
+/**
+ * @brief XChaCha20-Poly1305 open, for cookie replies
+ */
+bool wg_xaead_open(uint8_t *data, size_t len, const uint8_t tag[WG_TAG_LEN], const uint8_t *ad, size_t ad_len,
+                   const uint8_t nonce[WG_XNONCE_LEN], const uint8_t key[WG_KEY_LEN]);
+
+// BLAKE2s, RFC 7693
+struct WgBlake2s {
+    uint32_t h[8];
+    uint32_t t[2];
+    uint8_t buf[64];
+    size_t buf_len;
+    size_t out_len;
+};
+
+void wg_blake2s_init(WgBlake2s *s, size_t out_len, const uint8_t *key = NULL, size_t key_len = 0);
+void wg_blake2s_update(WgBlake2s *s, const uint8_t *in, size_t len);
+void wg_blake2s_final(WgBlake2s *s, uint8_t *out);
+
+// Noise helpers as the WireGuard paper names them
+void wg_hash(uint8_t out[WG_HASH_LEN], const uint8_t *a, size_t a_len, const uint8_t *b = NULL, size_t b_len = 0);
+void wg_mac(uint8_t out[WG_MAC_LEN], const uint8_t *key, size_t key_len, const uint8_t *in, size_t len);
+void wg_hmac(uint8_t out[WG_HASH_LEN], const uint8_t key[WG_HASH_LEN], const uint8_t *in, size_t len);
+
+/**
+ * @brief KDF1..3 over HMAC-BLAKE2s; pass NULL for outputs not wanted
+ */
+void wg_kdf(uint8_t *t1, uint8_t *t2, uint8_t *t3, const uint8_t key[WG_HASH_LEN], const uint8_t *in, size_t len);
+
+/**
+ * @brief Zero key material the compiler may not drop
+ */
+void wg_wipe(void *p, size_t len);
+
+#endif // WG_CRYPTO_H
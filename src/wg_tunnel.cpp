@@ -0,0 +1,949 @@
+/**
+ * @file      wg_tunnel.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     WireGuard initiator: Noise_IKpsk2 handshakes on a worker task,
+ *            transport sealed and opened in place in the lwIP thread
+ */
+
+#include "wg_tunnel.h"
+#include "wg_crypto.h"
+#include "net_manager.h"
+#include "simple_logger.h"
+#include <WiFi.h>
+#include <Preferences.h>
+#include <sys/time.h>
+#include <esp_netif.h>
+#include <esp_netif_net_stack.h>
+#include <mbedtls/base64.h>
+#include "lwip/netif.h"
+#include "lwip/udp.h"
+#include "lwip/pbuf.h"
+#include "lwip/ip4.h"
+#include "lwip/priv/tcpip_priv.h"
+#ifdef INTEGRATION_LAYER_ENABLED
+#include "integration/config_manager.h"
+#endif
+
+#define WG_MSG_INITIATION       1
+#define WG_MSG_RESPONSE         2
+#define WG_MSG_COOKIE           3
+#define WG_MSG_TRANSPORT        4
+#define WG_TRANSPORT_HEADER     16
+#define WG_TRANSPORT_MIN        (WG_TRANSPORT_HEADER + WG_TAG_LEN)
+#define WG_NVS_NAMESPACE        "wg"
+#define WG_TAI_RESERVE_S        3600    // Persisted ahead of use so flash sees one write an hour
+#define WG_WALL_CLOCK_VALID     1700000000
+#define WG_RESOLVE_EVERY        3       // Handshake timeouts before the endpoint is looked up again
+
+static const char WG_CONSTRUCTION[] = "Noise_IKpsk2_25519_ChaChaPoly_BLAKE2s";
+static const char WG_IDENTIFIER[] = "WireGuard v1 zx2c4 Jason@zx2c4.com";
+static const char WG_LABEL_MAC1[] = "mac1----";
+static const char WG_LABEL_COOKIE[] = "cookie--";
+
+struct __attribute__((packed)) WgInitiation {
+    uint8_t type;
+    uint8_t reserved[3];
+    uint32_t sender;
+    uint8_t ephemeral[WG_KEY_LEN];
+    uint8_t enc_static[WG_KEY_LEN + WG_TAG_LEN];
+    uint8_t enc_timestamp[12 + WG_TAG_LEN];
+    uint8_t mac1[WG_MAC_LEN];
+    uint8_t mac2[WG_MAC_LEN];
+};
+
+struct __attribute__((packed)) WgResponse {
+    uint8_t type;
+    uint8_t reserved[3];
+    uint32_t sender;
+    uint32_t receiver;
+    uint8_t ephemeral[WG_KEY_LEN];
+    uint8_t enc_empty[WG_TAG_LEN];
+    uint8_t mac1[WG_MAC_LEN];
+    uint8_t mac2[WG_MAC_LEN];
+};
+
+struct __attribute__((packed)) WgCookieReply {
+    uint8_t type;
+    uint8_t reserved[3];
+    uint32_t receiver;
+    uint8_t nonce[WG_XNONCE_LEN];
+    uint8_t enc_cookie[WG_MAC_LEN + WG_TAG_LEN];
+};
+
+// Handshake messages handed from the lwIP thread to the worker
+struct WgRxMessage {
+    uint8_t len;
+    uint8_t data[sizeof(WgResponse)];
+};
+
+// Kernel-style sliding window; one word is always being recycled
+#define WG_REPLAY_WORDS         32
+struct WgReplay {
+    uint64_t greatest;
+    uint32_t bits[WG_REPLAY_WORDS];
+};
+
+// Owned by the lwIP thread; the worker only stages new ones
+struct WgKeypair {
+    bool valid;
+    uint32_t local_index;
+    uint32_t remote_index;
+    uint8_t send_key[WG_KEY_LEN];
+    uint8_t recv_key[WG_KEY_LEN];
+    uint64_t send_counter;
+    WgReplay replay;
+    uint32_t birth_ms;
+};
+
+// Initiator state of the handshake in flight, worker task only
+struct WgHandshake {
+    bool pending;
+    uint32_t local_index;
+    uint8_t e_priv[WG_KEY_LEN];
+    uint8_t chain[WG_HASH_LEN];
+    uint8_t hash[WG_HASH_LEN];
+    uint8_t last_mac1[WG_MAC_LEN];
+    uint32_t sent_ms;
+    uint32_t first_ms;
+    uint8_t timeouts;
+};
+
+enum {
+    WG_OP_SETUP,
+    WG_OP_TEARDOWN,
+    WG_OP_BIND,
+    WG_OP_ENDPOINT,
+    WG_OP_INSTALL,
+    WG_OP_EXPIRE,
+    WG_OP_SEND,
+    WG_OP_KEEPALIVE,
+};
+
+struct WgCall {
+    struct tcpip_api_call_data call;
+    uint8_t op;
+    const void *data;
+    size_t len;
+};
+
+// Static keys and the parts of the handshake that only depend on them
+static uint8_t wg_priv[WG_KEY_LEN];
+static uint8_t wg_pub[WG_KEY_LEN];
+static uint8_t wg_peer[WG_KEY_LEN];
+static uint8_t wg_psk[WG_KEY_LEN];
+static uint8_t wg_ss[WG_KEY_LEN];           // DH(static, peer static)
+static uint8_t wg_chain0[WG_HASH_LEN];
+static uint8_t wg_hash0[WG_HASH_LEN];
+static uint8_t wg_mac1_key[WG_HASH_LEN];     // Sending mac1
+static uint8_t wg_mac1_own[WG_HASH_LEN];     // Checking mac1 on responses
+static uint8_t wg_cookie_key[WG_HASH_LEN];
+static uint8_t wg_cookie[WG_MAC_LEN];
+static uint32_t wg_cookie_ms;
+static bool wg_have_cookie;
+
+static WgTunnelConfig wg_cfg;
+static ip4_addr_t wg_allowed;
+static ip4_addr_t wg_allowed_mask;
+static WgHandshake wg_hs;
+static WgKeypair wg_staged;
+
+// lwIP thread state
+static struct netif wg_netif;
+static struct udp_pcb *wg_pcb;
+static struct netif *wg_outer;
+static ip_addr_t wg_endpoint;
+static uint16_t wg_endpoint_port;
+static bool wg_have_endpoint;
+static WgKeypair wg_current;
+static WgKeypair wg_previous;
+
+static WgTunnelStats wg_stat;
+static QueueHandle_t wg_rx;
+static TaskHandle_t wg_task_handle;
+static volatile bool wg_running;
+static volatile bool wg_session;
+static volatile bool wg_want_handshake;
+static volatile uint32_t wg_session_birth;
+static volatile uint32_t wg_last_tx_ms;
+static volatile uint32_t wg_last_tx_data_ms;
+static volatile uint32_t wg_last_rx_ms;
+static volatile uint32_t wg_last_rx_data_ms;
+static uint64_t wg_tai_last;
+static uint64_t wg_tai_reserved;
+
+static inline uint32_t le32(const uint8_t *p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline void put_le32(uint8_t *p, uint32_t v) {
+    p[0] = v;
+    p[1] = v >> 8;
+    p[2] = v >> 16;
+    p[3] = v >> 24;
+}
+
+static inline uint64_t le64(const uint8_t *p) {
+    return le32(p) | ((uint64_t)le32(p + 4) << 32);
+}
+
+static inline void put_le64(uint8_t *p, uint64_t v) {
+    put_le32(p, (uint32_t)v);
+    put_le32(p + 4, (uint32_t)(v >> 32));
+}
+
+static bool replay_check(WgReplay *r, uint64_t counter) {
+    if (counter >= WG_REJECT_AFTER_MESSAGES) {
+        return false;
+    }
+    uint64_t index = counter >> 5;
+    if (counter > r->greatest) {
+        uint64_t current = r->greatest >> 5;
+        uint64_t top = index - current;
+        if (top > WG_REPLAY_WORDS) {
+            top = WG_REPLAY_WORDS;
+        }
+        for (uint64_t i = 1; i <= top; i++) {
+            r->bits[(current + i) & (WG_REPLAY_WORDS - 1)] = 0;
+        }
+        r->greatest = counter;
+    } else if (r->greatest - counter >= (WG_REPLAY_WORDS - 1) * 32) {
+        return false;
+    }
+    uint32_t bit = 1u << (counter & 31);
+    uint32_t *word = &r->bits[index & (WG_REPLAY_WORDS - 1)];
+    if (*word & bit) {
+        return false;
+    }
+    *word |= bit;
+    return true;
+}
+
+static bool key_usable(const WgKeypair *kp) {
+    return kp->valid && millis() - kp->birth_ms < WG_REJECT_AFTER_MS &&
+           kp->send_counter < WG_REJECT_AFTER_MESSAGES;
+}
+
+// ---------------------------------------------------------------------------
+// Data plane, lwIP thread
+// ---------------------------------------------------------------------------
+
+static void kick_worker() {
+    if (wg_task_handle) {
+        xTaskNotifyGive(wg_task_handle);
+    }
+}
+
+// Never through our own netif, or the tunnel would carry itself
+static err_t send_outer(struct pbuf *p) {
+    if (!wg_pcb || !wg_outer || !wg_have_endpoint || !netif_is_up(wg_outer)) {
+        return ERR_RTE;
+    }
+    return udp_sendto_if(wg_pcb, p, &wg_endpoint, wg_endpoint_port, wg_outer);
+}
+
+// p NULL sends a keepalive
+static err_t send_transport(WgKeypair *kp, struct pbuf *p) {
+    size_t len = p ? p->tot_len : 0;
+    size_t padded = (len + 15) & ~(size_t)15;
+    if (padded > WG_TUNNEL_MTU) {
+        padded = len > WG_TUNNEL_MTU ? len : WG_TUNNEL_MTU;
+    }
+    
+    struct pbuf *q = pbuf_alloc(PBUF_TRANSPORT, WG_TRANSPORT_MIN + padded, PBUF_RAM);
+    if (!q) {
+        return ERR_MEM;
+    }
+    uint8_t *d = (uint8_t *)q->payload;
+    uint64_t counter = kp->send_counter++;
+    put_le32(d, WG_MSG_TRANSPORT);
+    put_le32(d + 4, kp->remote_index);
+    put_le64(d + 8, counter);
+    if (len) {
+        pbuf_copy_partial(p, d + WG_TRANSPORT_HEADER, len, 0);
+    }
+    memset(d + WG_TRANSPORT_HEADER + len, 0, padded - len);
+    wg_aead_seal(d + WG_TRANSPORT_HEADER, padded, d + WG_TRANSPORT_HEADER + padded, NULL, 0, counter, kp->send_key);
+    
+    err_t err = send_outer(q);
+    pbuf_free(q);
+    if (err == ERR_OK) {
+        wg_last_tx_ms = millis();
+        if (len) {
+            wg_last_tx_data_ms = wg_last_tx_ms;
+        }
+        wg_stat.tx_packets++;
+        wg_stat.tx_bytes += len;
+    }
+    return err;
+}
+
+static err_t wg_output(struct netif *netif, struct pbuf *p, const ip4_addr_t *dest) {
+    if (!key_usable(&wg_current)) {
+        wg_stat.tx_no_session++;
+        wg_want_handshake = true;
+        kick_worker();
+        return ERR_CONN;
+    }
+    return send_transport(&wg_current, p);
+}
+
+static WgKeypair *keypair_for(uint32_t index) {
+    if (wg_current.valid && wg_current.local_index == index) {
+        return &wg_current;
+    }
+    if (wg_previous.valid && wg_previous.local_index == index) {
+        return &wg_previous;
+    }
+    return NULL;
+}
+
+// Takes ownership of p
+static void handle_transport(struct pbuf *p, const ip_addr_t *addr, u16_t port) {
+    if (p->next) {
+        struct pbuf *flat = pbuf_coalesce(p, PBUF_RAW);
+        if (flat == p) {
+            pbuf_free(p);
+            return;
+        }
+        p = flat;
+    }
+    
+    uint8_t *d = (uint8_t *)p->payload;
+    WgKeypair *kp = keypair_for(le32(d + 4));
+    if (!kp || millis() - kp->birth_ms >= WG_REJECT_AFTER_MS) {
+        pbuf_free(p);
+        return;
+    }
+    uint64_t counter = le64(d + 8);
+    size_t len = p->tot_len - WG_TRANSPORT_MIN;
+    if (!wg_aead_open(d + WG_TRANSPORT_HEADER, len, d + WG_TRANSPORT_HEADER + len, NULL, 0, counter, kp->recv_key)) {
+        wg_stat.rx_auth_failed++;
+        pbuf_free(p);
+        return;
+    }
+    if (!replay_check(&kp->replay, counter)) {
+        wg_stat.rx_replayed++;
+        pbuf_free(p);
+        return;
+    }
+    
+    // Authenticated, so the peer may have roamed
+    ip_addr_copy(wg_endpoint, *addr);
+    wg_endpoint_port = port;
+    wg_last_rx_ms = millis();
+    if (!len) {
+        pbuf_free(p);
+        return;
+    }
+    
+    uint8_t *ip = d + WG_TRANSPORT_HEADER;
+    size_t ip_len = len >= 20 ? ((size_t)ip[2] << 8) | ip[3] : 0;
+    ip4_addr_t src;
+    memcpy(&src.addr, ip + 12, 4);
+    if ((ip[0] >> 4) != 4 || ip_len < 20 || ip_len > len || !ip4_addr_netcmp(&src, &wg_allowed, &wg_allowed_mask)) {
+        wg_stat.rx_not_allowed++;
+        pbuf_free(p);
+        return;
+    }
+    pbuf_remove_header(p, WG_TRANSPORT_HEADER);
+    pbuf_realloc(p, ip_len);
+    wg_last_rx_data_ms = wg_last_rx_ms;
+    wg_stat.rx_packets++;
+    wg_stat.rx_bytes += ip_len;
+    if (wg_netif.input(p, &wg_netif) != ERR_OK) {
+        pbuf_free(p);
+    }
+}
+
+static void wg_udp_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *addr, u16_t port) {
+    uint8_t type = p->tot_len >= 4 ? pbuf_get_at(p, 0) : 0;
+    if (type == WG_MSG_TRANSPORT && p->tot_len >= WG_TRANSPORT_MIN) {
+        handle_transport(p, addr, port);
+        return;
+    }
+    if ((type == WG_MSG_RESPONSE && p->tot_len == sizeof(WgResponse)) ||
+        (type == WG_MSG_COOKIE && p->tot_len == sizeof(WgCookieReply))) {
+        WgRxMessage msg;
+        msg.len = pbuf_copy_partial(p, msg.data, p->tot_len, 0);
+        if (xQueueSend(wg_rx, &msg, 0) == pdTRUE) {
+            kick_worker();
+        }
+    }
+    pbuf_free(p);
+}
+
+static err_t wg_netif_init(struct netif *netif) {
+    netif->name[0] = 'w';
+    netif->name[1] = 'g';
+    netif->output = wg_output;
+    netif->mtu = WG_TUNNEL_MTU;
+    netif->flags = NETIF_FLAG_LINK_UP;
+    return ERR_OK;
+}
+
+static err_t do_setup() {
+    ip4_addr_t addr, mask, gw;
+    if (!ip4addr_aton(wg_cfg.address.c_str(), &addr) || !ip4addr_aton(wg_cfg.netmask.c_str(), &mask)) {
+        return ERR_ARG;
+    }
+    ip4_addr_copy(gw, addr);
+    if (!netif_add(&wg_netif, &addr, &mask, &gw, NULL, wg_netif_init, ip_input)) {
+        return ERR_IF;
+    }
+    wg_pcb = udp_new();
+    if (!wg_pcb || udp_bind(wg_pcb, IP4_ADDR_ANY, wg_cfg.listen_port) != ERR_OK) {
+        if (wg_pcb) {
+            udp_remove(wg_pcb);
+            wg_pcb = NULL;
+        }
+        netif_remove(&wg_netif);
+        return ERR_USE;
+    }
+    udp_recv(wg_pcb, wg_udp_recv, NULL);
+    netif_set_up(&wg_netif);
+    return ERR_OK;
+}
+
+static void do_teardown() {
+    if (netif_default == &wg_netif) {
+        netif_set_default(wg_outer);
+    }
+    netif_set_down(&wg_netif);
+    netif_remove(&wg_netif);
+    if (wg_pcb) {
+        udp_remove(wg_pcb);
+        wg_pcb = NULL;
+    }
+    wg_outer = NULL;
+    wg_wipe(&wg_current, sizeof(wg_current));
+    wg_wipe(&wg_previous, sizeof(wg_previous));
+}
+
+static err_t wg_dispatch(struct tcpip_api_call_data *c) {
+    WgCall *call = (WgCall *)c;
+    switch (call->op) {
+        case WG_OP_SETUP:
+            return do_setup();
+        case WG_OP_TEARDOWN:
+            do_teardown();
+            return ERR_OK;
+        case WG_OP_BIND: {
+            struct netif *outer = (struct netif *)call->data;
+            bool moved = outer != wg_outer;
+            wg_outer = outer;
+            // Not before the endpoint is known: an off-link DNS server would be routed into the tunnel
+            if (wg_cfg.required && outer && wg_have_endpoint && netif_default != &wg_netif) {
+                netif_set_default(&wg_netif);
+            }
+            return moved ? ERR_OK : ERR_ALREADY;
+        }
+        case WG_OP_ENDPOINT:
+            ip_addr_copy(wg_endpoint, *(const ip_addr_t *)call->data);
+            wg_endpoint_port = wg_cfg.endpoint_port;
+            wg_have_endpoint = true;
+            return ERR_OK;
+        case WG_OP_INSTALL:
+            wg_previous = wg_current;
+            wg_current = wg_staged;
+            return ERR_OK;
+        case WG_OP_EXPIRE:
+            wg_wipe(&wg_current, sizeof(wg_current));
+            wg_wipe(&wg_previous, sizeof(wg_previous));
+            return ERR_OK;
+        case WG_OP_SEND: {
+            struct pbuf *p = pbuf_alloc(PBUF_TRANSPORT, call->len, PBUF_RAM);
+            if (!p) {
+                return ERR_MEM;
+            }
+            memcpy(p->payload, call->data, call->len);
+            err_t err = send_outer(p);
+            pbuf_free(p);
+            return err;
+        }
+        case WG_OP_KEEPALIVE:
+            return key_usable(&wg_current) ? send_transport(&wg_current, NULL) : ERR_CONN;
+    }
+    return ERR_ARG;
+}
+
+static err_t wg_call(uint8_t op, const void *data = NULL, size_t len = 0) {
+    WgCall call;
+    call.op = op;
+    call.data = data;
+    call.len = len;
+    return tcpip_api_call(wg_dispatch, &call.call);
+}
+
+// ---------------------------------------------------------------------------
+// Handshake, worker task
+// ---------------------------------------------------------------------------
+
+// TAI64N that never repeats: the responder drops initiations not newer than the last one.
+// Without a wall clock we continue past everything a previous boot could have sent
+static void tai64n(uint8_t out[12]) {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    uint64_t secs = tv.tv_sec;
+    uint32_t nsec = tv.tv_usec * 1000;
+    if (secs < WG_WALL_CLOCK_VALID || secs <= wg_tai_last) {
+        secs = (wg_tai_last > wg_tai_reserved ? wg_tai_last : wg_tai_reserved) + 1;
+        nsec = 0;
+    }
+    wg_tai_last = secs;
+    
+    if (secs >= wg_tai_reserved) {
+        wg_tai_reserved = secs + WG_TAI_RESERVE_S;
+        Preferences prefs;
+        if (prefs.begin(WG_NVS_NAMESPACE, false)) {
+            prefs.putULong64("tai", wg_tai_reserved);
+            prefs.end();
+        }
+    }
+    
+    uint64_t label = 0x400000000000000aULL + secs;
+    for (int i = 0; i < 8; i++) {
+        out[i] = label >> (56 - 8 * i);
+    }
+    for (int i = 0; i < 4; i++) {
+        out[8 + i] = nsec >> (24 - 8 * i);
+    }
+}
+
+static bool cookie_fresh() {
+    return wg_have_cookie && millis() - wg_cookie_ms < WG_COOKIE_MS - WG_REKEY_TIMEOUT_MS;
+}
+
+static void send_initiation() {
+    WgInitiation m;
+    memset(&m, 0, sizeof(m));
+    m.type = WG_MSG_INITIATION;
+    wg_hs.local_index = esp_random();
+    put_le32((uint8_t *)&m.sender, wg_hs.local_index);
+    
+    uint8_t c[WG_HASH_LEN], h[WG_HASH_LEN], k[WG_KEY_LEN], dh[WG_KEY_LEN];
+    memcpy(c, wg_chain0, sizeof(c));
+    memcpy(h, wg_hash0, sizeof(h));
+    
+    esp_fill_random(wg_hs.e_priv, sizeof(wg_hs.e_priv));
+    wg_x25519_clamp(wg_hs.e_priv);
+    wg_x25519_public(m.ephemeral, wg_hs.e_priv);
+    wg_kdf(c, NULL, NULL, c, m.ephemeral, WG_KEY_LEN);
+    wg_hash(h, h, sizeof(h), m.ephemeral, WG_KEY_LEN);
+    
+    wg_x25519(dh, wg_hs.e_priv, wg_peer);
+    wg_kdf(c, k, NULL, c, dh, sizeof(dh));
+    memcpy(m.enc_static, wg_pub, WG_KEY_LEN);
+    wg_aead_seal(m.enc_static, WG_KEY_LEN, m.enc_static + WG_KEY_LEN, h, sizeof(h), 0, k);
+    wg_hash(h, h, sizeof(h), m.enc_static, sizeof(m.enc_static));
+    
+    wg_kdf(c, k, NULL, c, wg_ss, sizeof(wg_ss));
+    tai64n(m.enc_timestamp);
+    wg_aead_seal(m.enc_timestamp, 12, m.enc_timestamp + 12, h, sizeof(h), 0, k);
+    wg_hash(h, h, sizeof(h), m.enc_timestamp, sizeof(m.enc_timestamp));
+    
+    wg_mac(m.mac1, wg_mac1_key, sizeof(wg_mac1_key), (const uint8_t *)&m, offsetof(WgInitiation, mac1));
+    if (cookie_fresh()) {
+        wg_mac(m.mac2, wg_cookie, sizeof(wg_cookie), (const uint8_t *)&m, offsetof(WgInitiation, mac2));
+    }
+    memcpy(wg_hs.last_mac1, m.mac1, sizeof(m.mac1));
+    memcpy(wg_hs.chain, c, sizeof(c));
+    memcpy(wg_hs.hash, h, sizeof(h));
+    wg_wipe(k, sizeof(k));
+    wg_wipe(dh, sizeof(dh));
+    
+    uint32_t now = millis();
+    if (!wg_hs.pending) {
+        wg_hs.first_ms = now;
+    }
+    wg_hs.pending = true;
+    wg_hs.sent_ms = now;
+    wg_stat.handshake_attempts++;
+    wg_call(WG_OP_SEND, &m, sizeof(m));
+}
+
+static bool consume_response(const WgResponse *r) {
+    if (!wg_hs.pending || le32((const uint8_t *)&r->receiver) != wg_hs.local_index) {
+        return false;
+    }
+    uint8_t mac1[WG_MAC_LEN];
+    wg_mac(mac1, wg_mac1_own, sizeof(wg_mac1_own), (const uint8_t *)r, offsetof(WgResponse, mac1));
+    if (memcmp(mac1, r->mac1, sizeof(mac1)) != 0) {
+        return false;
+    }
+    
+    uint8_t c[WG_HASH_LEN], h[WG_HASH_LEN], k[WG_KEY_LEN], tau[WG_HASH_LEN], dh[WG_KEY_LEN];
+    memcpy(c, wg_hs.chain, sizeof(c));
+    memcpy(h, wg_hs.hash, sizeof(h));
+    wg_kdf(c, NULL, NULL, c, r->ephemeral, WG_KEY_LEN);
+    wg_hash(h, h, sizeof(h), r->ephemeral, WG_KEY_LEN);
+    wg_x25519(dh, wg_hs.e_priv, r->ephemeral);
+    wg_kdf(c, NULL, NULL, c, dh, sizeof(dh));
+    wg_x25519(dh, wg_priv, r->ephemeral);
+    wg_kdf(c, NULL, NULL, c, dh, sizeof(dh));
+    wg_kdf(c, tau, k, c, wg_psk, sizeof(wg_psk));
+    wg_hash(h, h, sizeof(h), tau, sizeof(tau));
+    bool ok = wg_aead_open(NULL, 0, r->enc_empty, h, sizeof(h), 0, k);
+    
+    if (ok) {
+        memset(&wg_staged, 0, sizeof(wg_staged));
+        wg_kdf(wg_staged.send_key, wg_staged.recv_key, NULL, c, NULL, 0);
+        wg_staged.valid = true;
+        wg_staged.local_index = wg_hs.local_index;
+        wg_staged.remote_index = le32((const uint8_t *)&r->sender);
+        wg_staged.birth_ms = millis();
+    }
+    wg_wipe(c, sizeof(c));
+    wg_wipe(k, sizeof(k));
+    wg_wipe(tau, sizeof(tau));
+    wg_wipe(dh, sizeof(dh));
+    return ok;
+}
+
+static void consume_cookie(const WgCookieReply *r) {
+    if (!wg_hs.pending || le32((const uint8_t *)&r->receiver) != wg_hs.local_index) {
+        return;
+    }
+    uint8_t cookie[WG_MAC_LEN];
+    memcpy(cookie, r->enc_cookie, sizeof(cookie));
+    if (wg_xaead_open(cookie, sizeof(cookie), r->enc_cookie + WG_MAC_LEN, wg_hs.last_mac1, WG_MAC_LEN,
+                      r->nonce, wg_cookie_key)) {
+        memcpy(wg_cookie, cookie, sizeof(cookie));
+        wg_cookie_ms = millis();
+        wg_have_cookie = true;
+        wg_stat.cookies++;
+        // Under load the responder wants mac2 before it spends a DH on us
+        wg_hs.sent_ms = millis() - WG_REKEY_TIMEOUT_MS;
+    }
+}
+
+static void handle_message(const WgRxMessage *msg) {
+    if (msg->data[0] == WG_MSG_COOKIE) {
+        consume_cookie((const WgCookieReply *)msg->data);
+        return;
+    }
+    if (!consume_response((const WgResponse *)msg->data)) {
+        return;
+    }
+    
+    wg_call(WG_OP_INSTALL);
+    wg_wipe(&wg_staged, sizeof(wg_staged));
+    wg_wipe(wg_hs.e_priv, sizeof(wg_hs.e_priv));
+    uint32_t now = millis();
+    wg_stat.handshakes++;
+    wg_stat.last_handshake_ms = now - wg_hs.sent_ms;
+    wg_hs.pending = false;
+    wg_hs.timeouts = 0;
+    wg_want_handshake = false;
+    wg_session_birth = now;
+    wg_last_rx_ms = now;
+    wg_session = true;
+    
+    // The responder may not send until it has seen a transport message from us
+    wg_call(WG_OP_KEEPALIVE);
+    LOG_INFOF("WireGuard", "Handshake complete in %lums", (unsigned long)wg_stat.last_handshake_ms);
+}
+
+static bool resolve_endpoint() {
+    IPAddress ip;
+    if (!WiFi.hostByName(wg_cfg.endpoint.c_str(), ip)) {
+        return false;
+    }
+    ip_addr_t addr;
+    IP_ADDR4(&addr, ip[0], ip[1], ip[2], ip[3]);
+    wg_call(WG_OP_ENDPOINT, &addr, sizeof(addr));
+    return true;
+}
+
+// Sends follow the bearer net_manager routes on; LoRa carries no IP
+static struct netif *outer_netif() {
+    const char *key = net_manager_route() == NET_BEARER_CELL ? "PPP_DEF" : "WIFI_STA_DEF";
+    esp_netif_t *handle = esp_netif_get_handle_from_ifkey(key);
+    if (!handle || !esp_netif_is_netif_up(handle)) {
+        handle = esp_netif_get_handle_from_ifkey("WIFI_STA_DEF");
+    }
+    if (!handle || !esp_netif_is_netif_up(handle)) {
+        return NULL;
+    }
+    return (struct netif *)esp_netif_get_netif_impl(handle);
+}
+
+static void timers(uint32_t now) {
+    // Keys past REJECT_AFTER are unusable; drop them in the data plane too
+    if (wg_session && now - wg_session_birth >= WG_REJECT_AFTER_MS) {
+        wg_session = false;
+        wg_call(WG_OP_EXPIRE);
+        LOG_WARN("WireGuard", "Session expired");
+    }
+    
+    // Data sent without hearing back for too long: the peer is gone or our keys are stale.
+    // Keepalives don't count, the peer never answers those
+    bool persistent = wg_cfg.keepalive_s || wg_cfg.required;
+    bool dead = wg_session && (int32_t)(wg_last_tx_data_ms - wg_last_rx_ms) > 0 &&
+                now - wg_last_rx_ms >= WG_KEEPALIVE_TIMEOUT_MS + WG_REKEY_TIMEOUT_MS;
+    bool rekey = wg_session && now - wg_session_birth >= WG_REKEY_AFTER_MS &&
+                 (persistent || now - wg_last_tx_data_ms < WG_KEEPALIVE_TIMEOUT_MS);
+    bool need = (!wg_session && (persistent || wg_want_handshake)) || dead || rekey;
+    
+    if (wg_hs.pending && now - wg_hs.sent_ms >= WG_REKEY_TIMEOUT_MS + (esp_random() % 334)) {
+        if (!need || (!persistent && now - wg_hs.first_ms >= WG_REKEY_ATTEMPT_MS)) {
+            // On-demand only: give up until the next packet asks for a session
+            wg_hs.pending = false;
+            wg_want_handshake = false;
+        } else {
+            if (++wg_hs.timeouts % WG_RESOLVE_EVERY == 0) {
+                resolve_endpoint();
+            }
+            send_initiation();
+        }
+    } else if (need && !wg_hs.pending) {
+        send_initiation();
+    }
+    
+    if (!wg_session) {
+        return;
+    }
+    if (wg_cfg.keepalive_s && now - wg_last_tx_ms >= wg_cfg.keepalive_s * 1000UL) {
+        wg_call(WG_OP_KEEPALIVE);
+    } else if ((int32_t)(wg_last_rx_data_ms - wg_last_tx_ms) > 0 && now - wg_last_rx_data_ms >= WG_KEEPALIVE_TIMEOUT_MS) {
+        // Passive keepalive: confirm receipt when we have nothing to send
+        wg_call(WG_OP_KEEPALIVE);
+    }
+}
+
+static void wg_task(void *param) {
+    resolve_endpoint();
+    while (wg_running) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(WG_TICK_MS));
+        if (!wg_running) {
+            break;
+        }
+    
+        WgRxMessage msg;
+        while (xQueueReceive(wg_rx, &msg, 0) == pdTRUE) {
+            handle_message(&msg);
+        }
+    
+        // A new outer route keeps the session; one keepalive tells the peer our new address
+        struct netif *outer = outer_netif();
+        if (wg_call(WG_OP_BIND, outer) == ERR_OK && outer && wg_session) {
+            wg_call(WG_OP_KEEPALIVE);
+        }
+        if (!outer) {
+            continue;
+        }
+        if (!wg_hs.timeouts && !wg_have_endpoint) {
+            resolve_endpoint();
+        }
+        timers(millis());
+    }
+    wg_task_handle = NULL;
+    vTaskDelete(NULL);
+}
+
+static bool decode_key(const String &text, uint8_t out[WG_KEY_LEN]) {
+    size_t len = 0;
+    return mbedtls_base64_decode(out, WG_KEY_LEN, &len, (const unsigned char *)text.c_str(), text.length()) == 0 &&
+           len == WG_KEY_LEN;
+}
+
+static void load_config(WgTunnelConfig *cfg) {
+    cfg->endpoint_port = WG_DEFAULT_PORT;
+    cfg->netmask = "255.255.255.255";
+    cfg->allowed_ip = "0.0.0.0";
+    cfg->allowed_mask = "0.0.0.0";
+    cfg->keepalive_s = WG_DEFAULT_KEEPALIVE_S;
+    cfg->listen_port = 0;
+    cfg->required = false;
+#ifdef INTEGRATION_LAYER_ENABLED
+    cfg->private_key = GET_CONFIG_STRING("wireguard", "private_key", String(""));
+    cfg->peer_public_key = GET_CONFIG_STRING("wireguard", "peer_public_key", String(""));
+    cfg->preshared_key = GET_CONFIG_STRING("wireguard", "preshared_key", String(""));
+    cfg->endpoint = GET_CONFIG_STRING("wireguard", "endpoint", String(""));
+    cfg->endpoint_port = GET_CONFIG_INT("wireguard", "port", cfg->endpoint_port);
+    cfg->address = GET_CONFIG_STRING("wireguard", "address", String(""));
+    cfg->netmask = GET_CONFIG_STRING("wireguard", "netmask", cfg->netmask);
+    cfg->allowed_ip = GET_CONFIG_STRING("wireguard", "allowed_ip", cfg->allowed_ip);
+    cfg->allowed_mask = GET_CONFIG_STRING("wireguard", "allowed_mask", cfg->allowed_mask);
+    cfg->keepalive_s = GET_CONFIG_INT("wireguard", "keepalive", cfg->keepalive_s);
+    cfg->listen_port = GET_CONFIG_INT("wireguard", "listen_port", cfg->listen_port);
+    cfg->required = GET_CONFIG_BOOL("wireguard", "required", cfg->required);
+#endif
+}
+
+bool wg_tunnel_begin(const WgTunnelConfig *cfg) {
+    if (wg_running) {
+        return true;
+    }
+    
+    if (cfg) {
+        wg_cfg = *cfg;
+    } else {
+        load_config(&wg_cfg);
+    }
+    if (!wg_cfg.private_key.length() || !wg_cfg.endpoint.length() || !wg_cfg.address.length()) {
+        LOG_INFO("WireGuard", "No tunnel configured");
+        return false;
+    }
+    memset(wg_psk, 0, sizeof(wg_psk));
+    if (!decode_key(wg_cfg.private_key, wg_priv) || !decode_key(wg_cfg.peer_public_key, wg_peer) ||
+        (wg_cfg.preshared_key.length() && !decode_key(wg_cfg.preshared_key, wg_psk))) {
+        LOG_ERROR("WireGuard", "Keys are not 32-byte base64");
+        return false;
+    }
+    if (!ip4addr_aton(wg_cfg.allowed_ip.c_str(), &wg_allowed) ||
+        !ip4addr_aton(wg_cfg.allowed_mask.c_str(), &wg_allowed_mask)) {
+        LOG_ERROR("WireGuard", "Bad allowed range");
+        return false;
+    }
+    
+    // Everything that depends only on the static keys, computed once
+    wg_x25519_clamp(wg_priv);
+    wg_x25519_public(wg_pub, wg_priv);
+    wg_x25519(wg_ss, wg_priv, wg_peer);
+    wg_hash(wg_chain0, (const uint8_t *)WG_CONSTRUCTION, strlen(WG_CONSTRUCTION));
+    wg_hash(wg_hash0, wg_chain0, sizeof(wg_chain0), (const uint8_t *)WG_IDENTIFIER, strlen(WG_IDENTIFIER));
+    wg_hash(wg_hash0, wg_hash0, sizeof(wg_hash0), wg_peer, sizeof(wg_peer));
+    wg_hash(wg_mac1_key, (const uint8_t *)WG_LABEL_MAC1, strlen(WG_LABEL_MAC1), wg_peer, sizeof(wg_peer));
+    wg_hash(wg_mac1_own, (const uint8_t *)WG_LABEL_MAC1, strlen(WG_LABEL_MAC1), wg_pub, sizeof(wg_pub));
+    wg_hash(wg_cookie_key, (const uint8_t *)WG_LABEL_COOKIE, strlen(WG_LABEL_COOKIE), wg_peer, sizeof(wg_peer));
+    
+    Preferences prefs;
+    if (prefs.begin(WG_NVS_NAMESPACE, true)) {
+        wg_tai_reserved = prefs.getULong64("tai", 0);
+        prefs.end();
+    }
+    
+    if (!wg_rx) {
+        wg_rx = xQueueCreate(WG_RX_QUEUE_DEPTH, sizeof(WgRxMessage));
+        if (!wg_rx) {
+            LOG_ERROR("WireGuard", "Out of memory for the handshake queue");
+            return false;
+        }
+    }
+    memset(&wg_hs, 0, sizeof(wg_hs));
+    wg_have_cookie = false;
+    wg_have_endpoint = false;
+    wg_session = false;
+    wg_want_handshake = false;
+    if (wg_call(WG_OP_SETUP) != ERR_OK) {
+        LOG_ERRORF("WireGuard", "Cannot add the tunnel netif for %s", wg_cfg.address.c_str());
+        return false;
+    }
+    
+    wg_running = true;
+    if (xTaskCreate(wg_task, "wireguard", WG_TASK_STACK, NULL, WG_TASK_PRIORITY, &wg_task_handle) != pdPASS) {
+        LOG_ERROR("WireGuard", "Failed to start the WireGuard task");
+        wg_running = false;
+        wg_call(WG_OP_TEARDOWN);
+        return false;
+    }
+    LOG_INFOF("WireGuard", "Tunnel %s to %s:%u%s", wg_cfg.address.c_str(), wg_cfg.endpoint.c_str(),
+              wg_cfg.endpoint_port, wg_cfg.required ? ", VPN only" : "");
+    return true;
+}
+
+void wg_tunnel_end() {
+    if (!wg_running) {
+        return;
+    }
+    wg_running = false;
+    xTaskNotifyGive(wg_task_handle);
+    while (wg_task_handle) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    wg_call(WG_OP_TEARDOWN);
+    wg_session = false;
+    wg_wipe(&wg_hs, sizeof(wg_hs));
+    wg_wipe(wg_priv, sizeof(wg_priv));
+    wg_wipe(wg_psk, sizeof(wg_psk));
+    wg_wipe(wg_ss, sizeof(wg_ss));
+}
+
+bool wg_tunnel_up() {
+    return wg_session && millis() - wg_session_birth < WG_REJECT_AFTER_MS;
+}
+
+bool wg_tunnel_uplink_allowed() {
+    return !wg_running || !wg_cfg.required || wg_tunnel_up();
+}
+
+const WgTunnelStats *wg_tunnel_stats() {
+    return &wg_stat;
+}
+
+bool wg_tunnel_bench_crypto(size_t len, uint32_t count, WgBenchResult *out) {
+    if (!out || !len || !count) {
+        return false;
+    }
+    uint8_t *buf = (uint8_t *)malloc(len + WG_TAG_LEN);
+    if (!buf) {
+        return false;
+    }
+    uint8_t key[WG_KEY_LEN];
+    esp_fill_random(key, sizeof(key));
+    esp_fill_random(buf, len);
+    
+    memset(out, 0, sizeof(*out));
+    out->len = len;
+    out->packets = count;
+    uint32_t seal = 0, open = 0;
+    bool ok = true;
+    for (uint32_t i = 0; i < count && ok; i++) {
+        uint32_t t0 = micros();
+        wg_aead_seal(buf, len, buf + len, NULL, 0, i, key);
+        uint32_t t1 = micros();
+        ok = wg_aead_open(buf, len, buf + len, NULL, 0, i, key);
+        seal += t1 - t0;
+        open += micros() - t1;
+    }
+    free(buf);
+    wg_wipe(key, sizeof(key));
+    
+    out->seal_us = seal / count;
+    out->open_us = open / count;
+    out->seal_kbps = seal ? (uint64_t)len * count * 8000 / seal : 0;
+    out->open_kbps = open ? (uint64_t)len * count * 8000 / open : 0;
+    LOG_INFOF("WireGuard", "Crypto %u B: seal %luus (%lu kbit/s), open %luus (%lu kbit/s)%s", (unsigned)len,
+              (unsigned long)out->seal_us, (unsigned long)out->seal_kbps, (unsigned long)out->open_us,
+              (unsigned long)out->open_kbps, ok ? "" : ", verify FAILED");
+    return ok;
+}
+
+bool wg_tunnel_bench(const char *host, uint16_t port, size_t bytes, WgBenchResult *out) {
+    if (!wg_tunnel_bench_crypto(WG_TUNNEL_MTU - 40, 200, out)) {
+        return false;
+    }
+    if (!host || !wg_tunnel_up()) {
+        return true;
+    }
+    
+    // Through the routing table: the peer's side of the tunnel, or anything when VPN-only
+    WiFiClient client;
+    if (!client.connect(host, port, 5000)) {
+        LOG_WARNF("WireGuard", "Bench cannot reach %s:%u", host, port);
+        return false;
+    }
+    uint8_t chunk[1024];
+    memset(chunk, 0xA5, sizeof(chunk));
+    size_t sent = 0;
+    uint32_t start = millis();
+    while (sent < bytes && client.connected()) {
+        size_t n = bytes - sent < sizeof(chunk) ? bytes - sent : sizeof(chunk);
+        size_t w = client.write(chunk, n);
+        if (!w) {
+            break;
+        }
+        sent += w;
+    }
+    client.flush();
+    uint32_t ms = millis() - start;
+    client.stop();
+    
+    out->tunnel_kbps = ms ? (uint64_t)sent * 8 / ms : 0;
+    LOG_INFOF("WireGuard", "Bench %u B through the tunnel in %lums: %lu kbit/s", (unsigned)sent,
+              (unsigned long)ms, (unsigned long)out->tunnel_kbps);
+    return sent == bytes;
+}
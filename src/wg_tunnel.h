@@ -0,0 +1,103 @@
+/**
+ * @file      wg_tunnel.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     WireGuard tunnel: an lwIP netif over whichever bearer carries IP
+ */
+
+#ifndef WG_TUNNEL_H
+#define WG_TUNNEL_H
+
+#include <Arduino.h>
+
+#define WG_TUNNEL_MTU               1420
+#define WG_DEFAULT_PORT             51820
+#define WG_DEFAULT_KEEPALIVE_S      25    // Holds carrier NAT mappings open
+
+// Protocol timers, as in the WireGuard paper
+#define WG_REKEY_AFTER_MS           120000
+#define WG_REJECT_AFTER_MS          180000
+#define WG_REKEY_ATTEMPT_MS         90000
+#define WG_REKEY_TIMEOUT_MS         5000
+#define WG_KEEPALIVE_TIMEOUT_MS     10000
+#define WG_COOKIE_MS                120000
+#define WG_REJECT_AFTER_MESSAGES    (UINT64_MAX - (1ULL << 13))
+
+// Handshakes run here; the data plane runs in the lwIP thread
+#define WG_TASK_PRIORITY            (tskIDLE_PRIORITY + 3)
+#define WG_TASK_STACK               (1024 * 6)
+#define WG_TICK_MS                  1000
+#define WG_RX_QUEUE_DEPTH           4
+
+struct WgTunnelConfig {
+    String private_key;             // Base64, as wg(8) prints them
+    String peer_public_key;
+    String preshared_key;           // Empty for none
+    String endpoint;                // Host name or address
+    uint16_t endpoint_port;
+    String address;                 // Our tunnel address
+    String netmask;
+    String allowed_ip;              // Inner sources accepted from the peer
+    String allowed_mask;
+    uint16_t keepalive_s;           // 0 turns persistent keepalive off
+    uint16_t listen_port;           // 0 for an ephemeral port
+    bool required;                  // VPN-only: the tunnel is the default route, uplinks wait for it
+};
+
+struct WgTunnelStats {
+    uint32_t handshakes;
+    uint32_t handshake_attempts;
+    uint32_t cookies;
+    uint32_t tx_packets;
+    uint32_t rx_packets;
+    uint64_t tx_bytes;
+    uint64_t rx_bytes;
+    uint32_t tx_no_session;         // Dropped while no session was up
+    uint32_t rx_auth_failed;
+    uint32_t rx_replayed;
+    uint32_t rx_not_allowed;        // Inner source outside the allowed range
+    uint32_t last_handshake_ms;     // Duration of the last completed one
+};
+
+struct WgBenchResult {
+    size_t len;
+    uint32_t packets;
+    uint32_t seal_us;               // Per packet
+    uint32_t open_us;
+    uint32_t seal_kbps;
+    uint32_t open_kbps;
+    uint32_t tunnel_kbps;           // TCP through the tunnel, 0 when not measured
+};
+
+/**
+ * @brief Bring up the netif and the handshake task
+ * @param cfg  NULL reads the "wireguard" config section
+ */
+bool wg_tunnel_begin(const WgTunnelConfig *cfg = NULL);
+void wg_tunnel_end();
+
+/**
+ * @brief A session is established and not yet expired
+ */
+bool wg_tunnel_up();
+
+/**
+ * @brief Uplinks may use the network: the tunnel is up, or not required
+ */
+bool wg_tunnel_uplink_allowed();
+
+const WgTunnelStats *wg_tunnel_stats();
+
+/**
+ * @brief Seal and open count packets of len bytes in place
+ */
+bool wg_tunnel_bench_crypto(size_t len, uint32_t count, WgBenchResult *out);
+
+/**
+ * @brief Crypto figures plus a TCP stream of bytes to host:port through the tunnel
+ */
+bool wg_tunnel_bench(const char *host, uint16_t port, size_t bytes, WgBenchResult *out);
+
+#endif // WG_TUNNEL_H
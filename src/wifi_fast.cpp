@@ -0,0 +1,165 @@
+/**
+ * @file      wifi_fast.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Fast WiFi reconnect: RTC/NVS access point record and static-IP fast path
+ */
+
+#include "wifi_fast.h"
+#include "simple_logger.h"
+#include <WiFi.h>
+#include <Preferences.h>
+#include <esp_attr.h>
+#include <esp_rom_crc.h>
+#include <time.h>
+#ifdef INTEGRATION_LAYER_ENABLED
+#include "integration/config_manager.h"
+#endif
+
+RTC_NOINIT_ATTR static WifiFastRecord rtc_record;
+
+static bool fast_event_registered = false;
+static bool fast_static = false;    // Address set by the fast path, DHCP off
+
+static uint32_t ssid_hash(const char *ssid) {
+    return esp_rom_crc32_le(0, (const uint8_t *)ssid, strlen(ssid));
+}
+
+static uint32_t record_crc(const WifiFastRecord *r) {
+    return esp_rom_crc32_le(0, (const uint8_t *)r, offsetof(WifiFastRecord, crc));
+}
+
+static bool record_valid(const WifiFastRecord *r) {
+    return r->magic == WIFI_FAST_MAGIC && r->crc == record_crc(r);
+}
+
+// Flash is only written when the access point changes, not per connect
+static void store_nvs(const WifiFastRecord *r) {
+    Preferences prefs;
+    if (!prefs.begin(WIFI_FAST_NVS_NAMESPACE, false)) {
+        return;
+    }
+    WifiFastRecord stored;
+    if (prefs.getBytes("ap", &stored, sizeof(stored)) != sizeof(stored) || stored.ssid_hash != r->ssid_hash ||
+        memcmp(stored.bssid, r->bssid, sizeof(r->bssid)) != 0 || stored.channel != r->channel) {
+        WifiFastRecord ap = *r;
+        ap.has_lease = 0;
+        ap.crc = record_crc(&ap);
+        prefs.putBytes("ap", &ap, sizeof(ap));
+    }
+    prefs.end();
+}
+
+static bool load_nvs(WifiFastRecord *r) {
+    Preferences prefs;
+    if (!prefs.begin(WIFI_FAST_NVS_NAMESPACE, true)) {
+        return false;
+    }
+    bool ok = prefs.getBytes("ap", r, sizeof(*r)) == sizeof(*r) && record_valid(r);
+    prefs.end();
+    return ok;
+}
+
+// On the WiFi event task
+static void got_ip(WiFiEvent_t event, WiFiEventInfo_t info) {
+    WifiFastRecord r;
+    memset(&r, 0, sizeof(r));
+    r.magic = WIFI_FAST_MAGIC;
+    r.ssid_hash = ssid_hash(WiFi.SSID().c_str());
+    memcpy(r.bssid, WiFi.BSSID(), sizeof(r.bssid));
+    r.channel = WiFi.channel();
+    r.ip = WiFi.localIP();
+    r.gateway = WiFi.gatewayIP();
+    r.netmask = WiFi.subnetMask();
+    r.dns = WiFi.dnsIP();
+    
+    // A reused lease keeps the time it was first handed out
+    bool same_lease = record_valid(&rtc_record) && rtc_record.has_lease && rtc_record.ip == r.ip &&
+                      rtc_record.ssid_hash == r.ssid_hash;
+    r.has_lease = !fast_static || same_lease;
+    r.lease_time = same_lease && fast_static ? rtc_record.lease_time : (uint32_t)time(NULL);
+    r.crc = record_crc(&r);
+    rtc_record = r;
+    store_nvs(&r);
+}
+
+static bool static_profile(IPAddress *ip, IPAddress *gateway, IPAddress *netmask, IPAddress *dns) {
+#ifdef INTEGRATION_LAYER_ENABLED
+    String addr = GET_CONFIG_STRING("wifi", "static_ip", "");
+    if (addr.length() && ip->fromString(addr) &&
+        gateway->fromString(GET_CONFIG_STRING("wifi", "gateway", "")) &&
+        netmask->fromString(GET_CONFIG_STRING("wifi", "netmask", "255.255.255.0"))) {
+        if (!dns->fromString(GET_CONFIG_STRING("wifi", "dns", ""))) {
+            *dns = *gateway;
+        }
+        return true;
+    }
+#endif
+    return false;
+}
+
+void wifi_fast_begin() {
+    if (!fast_event_registered) {
+        WiFi.onEvent(got_ip, ARDUINO_EVENT_WIFI_STA_GOT_IP);
+        fast_event_registered = true;
+    }
+}
+
+bool wifi_fast_connect(const char *ssid, const char *password, uint32_t timeout_ms) {
+    wifi_fast_begin();
+    
+    WifiFastRecord r = rtc_record;
+    uint32_t hash = ssid_hash(ssid);
+    bool from_rtc = record_valid(&r) && r.ssid_hash == hash;
+    if (!from_rtc && !(load_nvs(&r) && r.ssid_hash == hash)) {
+        return false;
+    }
+    
+    IPAddress ip, gateway, netmask, dns;
+    uint32_t now = time(NULL);
+    if (static_profile(&ip, &gateway, &netmask, &dns)) {
+        fast_static = true;
+    } else if (from_rtc && r.has_lease && now >= r.lease_time && now - r.lease_time < WIFI_FAST_LEASE_REUSE_S) {
+        ip = r.ip;
+        gateway = r.gateway;
+        netmask = r.netmask;
+        dns = r.dns;
+        fast_static = true;
+    } else {
+        fast_static = false;
+    }
+    if (fast_static) {
+        WiFi.config(ip, gateway, netmask, dns);
+    }
+    
+    uint32_t start = millis();
+    WiFi.begin(ssid, password, r.channel, r.bssid);
+    while (WiFi.status() != WL_CONNECTED && millis() - start < timeout_ms) {
+        delay(10);
+    }
+    if (WiFi.status() == WL_CONNECTED) {
+        LOG_INFOF("WiFiFast", "Connected in %lu ms%s", millis() - start, fast_static ? ", static address" : "");
+        return true;
+    }
+    
+    // The access point moved or the lease is gone: forget both, back to scan and DHCP
+    LOG_WARN("WiFiFast", "Fast reconnect failed, falling back to a full connect");
+    WiFi.disconnect();
+    if (fast_static) {
+        WiFi.config(INADDR_NONE, INADDR_NONE, INADDR_NONE);
+        fast_static = false;
+    }
+    wifi_fast_forget();
+    return false;
+}
+
+void wifi_fast_forget() {
+    rtc_record.magic = 0;
+    Preferences prefs;
+    if (prefs.begin(WIFI_FAST_NVS_NAMESPACE, false)) {
+        prefs.remove("ap");
+        prefs.end();
+    }
+}
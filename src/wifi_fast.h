@@ -0,0 +1,50 @@
+/**
+ * @file      wifi_fast.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Fast WiFi reconnect from a remembered BSSID, channel and address
+ */
+
+#ifndef WIFI_FAST_H
+#define WIFI_FAST_H
+
+#include <Arduino.h>
+
+#define WIFI_FAST_MAGIC             0x54534146UL  // "FAST"
+#define WIFI_FAST_TIMEOUT_MS        2000  // Fast path gives up and leaves a full connect to the caller
+#define WIFI_FAST_LEASE_REUSE_S     1800  // A DHCP lease is taken as static for this long
+#define WIFI_FAST_NVS_NAMESPACE     "wififast"
+
+/**
+ * Kept in RTC memory, so it survives light and deep sleep and resets. The
+ * access point (not the lease) is also in NVS for cold boots
+ */
+struct WifiFastRecord {
+    uint32_t magic;
+    uint32_t ssid_hash;
+    uint8_t bssid[6];
+    uint8_t channel;
+    uint8_t has_lease;
+    uint32_t ip, gateway, netmask, dns;
+    uint32_t lease_time;            // time() when the lease was taken
+    uint32_t crc;
+};
+
+/**
+ * @brief Join ssid on the remembered BSSID and channel, skipping the scan, and
+ *        with a static address (the wifi.static_ip profile, else a recent
+ *        lease) skipping DHCP too. Blocks up to timeout_ms
+ * @return false with nothing remembered, or when the fast path failed; the
+ *         record is then dropped and the caller does a normal connect
+ */
+bool wifi_fast_connect(const char *ssid, const char *password, uint32_t timeout_ms = WIFI_FAST_TIMEOUT_MS);
+
+/**
+ * @brief Start remembering: each GOT_IP updates the record
+ */
+void wifi_fast_begin();
+void wifi_fast_forget();
+
+#endif // WIFI_FAST_H
@@ -0,0 +1,164 @@
+/**
+ * @file      wifi_scan.cpp
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     WiFi scan service: completion on the scan-done event, cached snapshot
+ */
+
+#include "wifi_scan.h"
+#include "simple_logger.h"
+#include <WiFi.h>
+#ifdef INTEGRATION_LAYER_ENABLED
+#include "integration/config_manager.h"
+#endif
+
+static portMUX_TYPE scan_mux = portMUX_INITIALIZER_UNLOCKED;
+static WifiScanEntry scan_cache[WIFI_SCAN_MAX];
+static size_t scan_count = 0;
+static uint32_t scan_time = 0;
+static uint32_t scan_version = 0;
+static volatile bool scan_active = false;
+static bool scan_event_registered = false;
+
+// Filled outside the lock, then copied in one go
+static WifiScanEntry scan_work[WIFI_SCAN_MAX];
+
+// On the WiFi event task
+static void scan_done(WiFiEvent_t event, WiFiEventInfo_t info) {
+    int16_t n = WiFi.scanComplete();
+    size_t count = 0;
+    for (int16_t i = 0; i < n; i++) {
+        String ssid;
+        uint8_t auth;
+        int32_t rssi, channel;
+        uint8_t *bssid;
+        if (!WiFi.getNetworkInfo(i, ssid, auth, rssi, bssid, channel)) {
+            continue;
+        }
+        WifiScanEntry e;
+        strlcpy(e.ssid, ssid.c_str(), sizeof(e.ssid));
+        e.rssi = rssi;
+        e.channel = channel;
+        e.auth = auth;
+        memcpy(e.bssid, bssid, sizeof(e.bssid));
+    
+        // Insertion keeps the table sorted, strongest first; weakest fall off the end
+        size_t pos = count;
+        while (pos > 0 && scan_work[pos - 1].rssi < e.rssi) {
+            pos--;
+        }
+        if (pos >= WIFI_SCAN_MAX) {
+            continue;
+        }
+        size_t last = count < WIFI_SCAN_MAX ? count : WIFI_SCAN_MAX - 1;
+        memmove(&scan_work[pos + 1], &scan_work[pos], (last - pos) * sizeof(WifiScanEntry));
+        scan_work[pos] = e;
+        if (count < WIFI_SCAN_MAX) {
+            count++;
+        }
+    }
+    WiFi.scanDelete();
+    
+    portENTER_CRITICAL(&scan_mux);
+    if (n >= 0) {
+        memcpy(scan_cache, scan_work, count * sizeof(WifiScanEntry));
+        scan_count = count;
+        scan_time = millis();
+        scan_version++;
+    }
+    scan_active = false;
+    portEXIT_CRITICAL(&scan_mux);
+    
+    if (n < 0) {
+        LOG_WARN("WiFiScan", "Scan failed");
+    }
+}
+
+bool wifi_scan_start(const WifiScanOptions *options) {
+    if (scan_active) {
+        return false;
+    }
+    if (!scan_event_registered) {
+        WiFi.onEvent(scan_done, ARDUINO_EVENT_WIFI_SCAN_DONE);
+        scan_event_registered = true;
+    }
+    
+    WifiScanOptions opt = {false, 0, 0};
+#ifdef INTEGRATION_LAYER_ENABLED
+    opt.passive = GET_CONFIG_BOOL("wifi", "scan_passive", false);
+    opt.channel = GET_CONFIG_INT("wifi", "scan_channel", 0);
+#endif
+    if (options) {
+        opt = *options;
+    }
+    if (!opt.dwell_ms) {
+        opt.dwell_ms = opt.passive ? WIFI_SCAN_PASSIVE_DWELL_MS : WIFI_SCAN_DWELL_MS;
+    }
+    
+    scan_active = true;
+    int16_t r = WiFi.scanNetworks(true, false, opt.passive, opt.dwell_ms, opt.channel);
+    if (r != WIFI_SCAN_RUNNING) {
+        scan_active = false;
+        LOG_WARNF("WiFiScan", "Scan did not start (%d)", r);
+        return false;
+    }
+    return true;
+}
+
+bool wifi_scan_request(uint32_t max_age_ms) {
+    uint32_t version, age;
+    wifi_scan_snapshot(NULL, 0, &version, &age);
+    if (version && age < max_age_ms) {
+        return false;
+    }
+    return wifi_scan_start();
+}
+
+bool wifi_scan_running() {
+    return scan_active;
+}
+
+size_t wifi_scan_snapshot(WifiScanEntry *out, size_t max, uint32_t *version, uint32_t *age_ms) {
+    portENTER_CRITICAL(&scan_mux);
+    size_t n = scan_count < max ? scan_count : max;
+    if (n) {
+        memcpy(out, scan_cache, n * sizeof(WifiScanEntry));
+    }
+    if (version) {
+        *version = scan_version;
+    }
+    if (age_ms) {
+        *age_ms = scan_version ? millis() - scan_time : UINT32_MAX;
+    }
+    portEXIT_CRITICAL(&scan_mux);
+    return n;
+}
+
+bool wifi_scan_find(const char *ssid, WifiScanEntry *out, uint32_t max_age_ms) {
+    bool found = false;
+    portENTER_CRITICAL(&scan_mux);
+    if (scan_version && millis() - scan_time < max_age_ms) {
+        // Sorted, so the first match is the strongest
+        for (size_t i = 0; i < scan_count; i++) {
+            if (strcmp(scan_cache[i].ssid, ssid) == 0) {
+                *out = scan_cache[i];
+                found = true;
+                break;
+            }
+        }
+    }
+    portEXIT_CRITICAL(&scan_mux);
+    return found;
+}
+
+void wifi_scan_connect(const char *ssid, const char *password) {
+    WifiScanEntry ap;
+    if (wifi_scan_find(ssid, &ap)) {
+        LOG_INFOF("WiFiScan", "Joining %s on channel %u from the scan cache", ssid, ap.channel);
+        WiFi.begin(ssid, password, ap.channel, ap.bssid);
+    } else {
+        WiFi.begin(ssid, password);
+    }
+}
@@ -0,0 +1,65 @@
+/**
+ * @file      wifi_scan.h
+ * @author    T-Deck-Pro OS Team
+ * @license   MIT
+ * @copyright Copyright (c) 2025
+ * @date      2025-01-11
+ * @brief     Asynchronous WiFi scans into a timestamped result cache
+ */
+
+#ifndef WIFI_SCAN_H
+#define WIFI_SCAN_H
+
+#include <Arduino.h>
+
+#define WIFI_SCAN_MAX               64
+#define WIFI_SCAN_TTL_MS            30000 // Older results make wifi_scan_request() rescan
+#define WIFI_SCAN_DWELL_MS          300   // Per channel, active scans
+#define WIFI_SCAN_PASSIVE_DWELL_MS  360   // Per channel, must cover a 100 TU beacon interval thrice
+
+struct WifiScanEntry {
+    char ssid[33];
+    int8_t rssi;
+    uint8_t channel;
+    uint8_t auth;                   // wifi_auth_mode_t
+    uint8_t bssid[6];
+};
+
+struct WifiScanOptions {
+    bool passive;                   // Listen for beacons only, no probe requests
+    uint8_t channel;                // 0 for all channels
+    uint32_t dwell_ms;              // Per channel, 0 for the default
+};
+
+/**
+ * @brief Start a scan in the background and return at once. Defaults come from
+ *        the wifi.scan_passive and wifi.scan_channel config keys
+ * @return false if one is already running or it could not start
+ */
+bool wifi_scan_start(const WifiScanOptions *options = NULL);
+
+/**
+ * @brief Start a scan only when the cache is older than max_age_ms
+ */
+bool wifi_scan_request(uint32_t max_age_ms = WIFI_SCAN_TTL_MS);
+bool wifi_scan_running();
+
+/**
+ * @brief Copy the last results, strongest first; never blocks on the radio
+ * @param version   Bumped per completed scan, for change detection (may be NULL)
+ * @param age_ms    Time since that scan completed (may be NULL)
+ */
+size_t wifi_scan_snapshot(WifiScanEntry *out, size_t max, uint32_t *version = NULL, uint32_t *age_ms = NULL);
+
+/**
+ * @brief Strongest cached access point for ssid no older than max_age_ms
+ */
+bool wifi_scan_find(const char *ssid, WifiScanEntry *out, uint32_t max_age_ms = WIFI_SCAN_TTL_MS);
+
+/**
+ * @brief WiFi.begin(), pinned to the cached channel and BSSID when there is a
+ *        fresh entry, which skips the driver's own scan
+ */
+void wifi_scan_connect(const char *ssid, const char *password);
+
+#endif // WIFI_SCAN_H